@@ -0,0 +1,277 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#ifdef WIN32
+  #define _USE_MATH_DEFINES // Needed to get M_PI
+#endif
+#include "Benchmark.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#ifdef OPENMM_BENCHMARK_CPU
+#include "CpuPlatform.h"
+#endif
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+
+using namespace OpenMM;
+using namespace OpenMMBenchmarks;
+using namespace std;
+
+#if defined(OPENMM_BENCHMARK_CPU) && defined(OPENMM_BENCHMARK_PME)
+extern "C" void registerCpuPmeKernelFactories();
+#endif
+
+namespace {
+
+struct BenchmarkInfo {
+    string name;
+    BenchmarkFunction function;
+    vector<int> sizes;
+    bool perPlatform;
+};
+
+struct BenchmarkRun {
+    string name, platform;
+    const BenchmarkInfo* info;
+    int size;
+};
+
+vector<BenchmarkInfo>& getRegisteredBenchmarks() {
+    static vector<BenchmarkInfo> benchmarks;
+    return benchmarks;
+}
+
+int addBenchmark(const string& name, BenchmarkFunction function, const vector<int>& sizes, bool perPlatform) {
+    BenchmarkInfo info = {name, function, sizes, perPlatform};
+    getRegisteredBenchmarks().push_back(info);
+    return getRegisteredBenchmarks().size();
+}
+
+}
+
+BenchmarkState::BenchmarkState(int size, const string& platformName, double minTime) : size(size), platformName(platformName),
+        minTime(minTime), elapsedTime(0.0), iterations(0), batchEnd(0), started(false), skipped(false) {
+}
+
+bool BenchmarkState::finishBatch() {
+    if (skipped)
+        return false;
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (!started) {
+        started = true;
+        startTime = now;
+        batchEnd = 1;
+        iterations = 1;
+        return true;
+    }
+    elapsedTime = chrono::duration<double>(now-startTime).count();
+    if (elapsedTime >= minTime)
+        return false;
+    batchEnd = 2*iterations;
+    iterations++;
+    return true;
+}
+
+void BenchmarkState::skip(const string& reason) {
+    skipped = true;
+    skipReason = reason;
+}
+
+int OpenMMBenchmarks::registerBenchmark(const string& name, BenchmarkFunction function, const vector<int>& sizes) {
+    return addBenchmark(name, function, sizes, false);
+}
+
+int OpenMMBenchmarks::registerPlatformBenchmark(const string& name, BenchmarkFunction function, const vector<int>& sizes) {
+    return addBenchmark(name, function, sizes, true);
+}
+
+System* OpenMMBenchmarks::createWaterBox(int numMolecules, NonbondedForce::NonbondedMethod method, vector<Vec3>& positions) {
+    // Place the oxygens on a cubic lattice with the spacing of liquid water.
+
+    const double spacing = 0.31;
+    const double ohDistance = 0.09572;
+    const double hhDistance = 0.15139;
+    const double angle = 104.52*M_PI/180.0;
+    int gridSize = (int) ceil(cbrt((double) numMolecules));
+    double boxSize = gridSize*spacing;
+    System* system = new System();
+    system->setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(0.8);
+    system->addForce(nonbonded);
+    positions.clear();
+    for (int i = 0; i < numMolecules; i++) {
+        int oxygen = system->addParticle(15.999);
+        system->addParticle(1.008);
+        system->addParticle(1.008);
+        nonbonded->addParticle(-0.834, 0.315061, 0.636386);
+        nonbonded->addParticle(0.417, 1, 0);
+        nonbonded->addParticle(0.417, 1, 0);
+        for (int j = 0; j < 3; j++)
+            for (int k = j+1; k < 3; k++)
+                nonbonded->addException(oxygen+j, oxygen+k, 0, 1, 0);
+        system->addConstraint(oxygen, oxygen+1, ohDistance);
+        system->addConstraint(oxygen, oxygen+2, ohDistance);
+        system->addConstraint(oxygen+1, oxygen+2, hhDistance);
+        Vec3 pos(spacing*(i%gridSize), spacing*((i/gridSize)%gridSize), spacing*(i/(gridSize*gridSize)));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(ohDistance, 0, 0));
+        positions.push_back(pos+Vec3(ohDistance*cos(angle), ohDistance*sin(angle), 0));
+    }
+    return system;
+}
+
+static void registerPlatforms(const string& pluginDir) {
+    if (!pluginDir.empty()) {
+        Platform::loadPluginsFromDirectory(pluginDir);
+        for (const string& failure : Platform::getPluginLoadFailures())
+            cerr << "Failed to load plugin: " << failure << endl;
+    }
+#ifdef OPENMM_BENCHMARK_CPU
+    // Register the CPU platform we were linked against, unless one was loaded as a plugin.
+
+    bool hasCpu = false;
+    for (int i = 0; i < Platform::getNumPlatforms(); i++)
+        if (Platform::getPlatform(i).getName() == "CPU")
+            hasCpu = true;
+    if (!hasCpu && CpuPlatform::isProcessorSupported()) {
+        Platform::registerPlatform(new CpuPlatform());
+#ifdef OPENMM_BENCHMARK_PME
+        registerCpuPmeKernelFactories();
+#endif
+    }
+#endif
+}
+
+static void printUsage() {
+    cout << "Usage: OpenMMBenchmarks [options]" << endl;
+    cout << "  --filter=REGEX     only run benchmarks whose full name matches the regular expression" << endl;
+    cout << "  --min-time=SECONDS minimum time to spend timing each benchmark (default 0.5)" << endl;
+    cout << "  --plugin-dir=DIR   load platform plugins from a directory" << endl;
+    cout << "  --csv              print results as comma separated values" << endl;
+    cout << "  --list             list the benchmarks without running them" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string filter, pluginDir;
+    double minTime = 0.5;
+    bool csv = false, listOnly = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0)
+            filter = arg.substr(9);
+        else if (arg.rfind("--min-time=", 0) == 0)
+            minTime = atof(arg.substr(11).c_str());
+        else if (arg.rfind("--plugin-dir=", 0) == 0)
+            pluginDir = arg.substr(13);
+        else if (arg == "--csv")
+            csv = true;
+        else if (arg == "--list")
+            listOnly = true;
+        else {
+            printUsage();
+            return (arg == "--help" ? 0 : 1);
+        }
+    }
+    try {
+        registerPlatforms(pluginDir);
+    }
+    catch(const exception& e) {
+        cerr << "Failed to load plugins: " << e.what() << endl;
+        return 1;
+    }
+    regex filterRegex(filter);
+
+    // Expand each benchmark into the list of runs it represents.
+
+    vector<BenchmarkRun> runs;
+    for (const BenchmarkInfo& info : getRegisteredBenchmarks()) {
+        vector<string> platforms(1, "");
+        if (info.perPlatform) {
+            platforms.clear();
+            for (int i = 0; i < Platform::getNumPlatforms(); i++)
+                platforms.push_back(Platform::getPlatform(i).getName());
+        }
+        for (const string& platform : platforms)
+            for (int size : info.sizes) {
+                string name = info.name+"/"+(platform.empty() ? "" : platform+"/")+to_string(size);
+                if (regex_search(name, filterRegex)) {
+                    BenchmarkRun run = {name, platform, &info, size};
+                    runs.push_back(run);
+                }
+            }
+    }
+    if (listOnly) {
+        for (const BenchmarkRun& run : runs)
+            cout << run.name << endl;
+        return 0;
+    }
+
+    // Run them.
+
+    int failures = 0;
+    if (csv)
+        cout << "name,iterations,seconds_per_iteration" << endl;
+    else
+        printf("%-50s %12s %16s\n", "Benchmark", "Iterations", "Time (us)");
+    for (const BenchmarkRun& run : runs) {
+        BenchmarkState state(run.size, run.platform, minTime);
+        string error;
+        try {
+            run.info->function(state);
+        }
+        catch(const exception& e) {
+            error = e.what();
+        }
+        double timePerIteration = (state.getIterations() == 0 ? 0.0 : state.getElapsedTime()/state.getIterations());
+        if (!error.empty()) {
+            failures++;
+            if (csv)
+                cout << run.name << ",0,nan" << endl;
+            else
+                printf("%-50s failed: %s\n", run.name.c_str(), error.c_str());
+        }
+        else if (state.isSkipped()) {
+            if (!csv)
+                printf("%-50s skipped: %s\n", run.name.c_str(), state.getSkipReason().c_str());
+        }
+        else if (csv)
+            cout << run.name << "," << state.getIterations() << "," << timePerIteration << endl;
+        else
+            printf("%-50s %12lld %16.3f\n", run.name.c_str(), state.getIterations(), 1e6*timePerIteration);
+        fflush(stdout);
+    }
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,156 @@
+#ifndef OPENMM_BENCHMARK_H_
+#define OPENMM_BENCHMARK_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This file defines the minimal harness used by the OpenMMBenchmarks executable.  Each benchmark
+ * is a function that performs its setup, then repeats the operation being measured while
+ * keepRunning() returns true:
+ *
+ *     static void benchmarkSomething(BenchmarkState& state) {
+ *         ... setup based on state.getSize() ...
+ *         while (state.keepRunning())
+ *             ... operation to time ...
+ *     }
+ *
+ * Benchmarks are registered with registerBenchmark() or registerPlatformBenchmark() from a static
+ * initializer in the file that defines them.  Only the time spent inside the loop is measured.
+ */
+
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/Vec3.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace OpenMMBenchmarks {
+
+class BenchmarkState {
+public:
+    BenchmarkState(int size, const std::string& platformName, double minTime);
+    /**
+     * Get the size parameter for this run.  Its meaning depends on the benchmark (number of
+     * molecules, atoms, evaluations, etc.).
+     */
+    int getSize() const {
+        return size;
+    }
+    /**
+     * Get the name of the Platform to run on.  This is empty for benchmarks that are not
+     * run once for each Platform.
+     */
+    const std::string& getPlatformName() const {
+        return platformName;
+    }
+    /**
+     * Returns true if the timed operation should be executed again.  The first call starts the timer.
+     * The number of iterations is increased geometrically, and the clock is only checked when a
+     * batch of iterations is complete, so the overhead of calling this is negligible.
+     */
+    bool keepRunning() {
+        if (iterations < batchEnd) {
+            iterations++;
+            return true;
+        }
+        return finishBatch();
+    }
+    /**
+     * Mark this benchmark as not applicable (for example, because the processor does not support
+     * the instruction set it measures).  Call this instead of entering the timing loop.
+     */
+    void skip(const std::string& reason);
+    /**
+     * Get the number of times the operation was executed.
+     */
+    long long getIterations() const {
+        return iterations;
+    }
+    /**
+     * Get the total time in seconds spent executing the operation.
+     */
+    double getElapsedTime() const {
+        return elapsedTime;
+    }
+    bool isSkipped() const {
+        return skipped;
+    }
+    const std::string& getSkipReason() const {
+        return skipReason;
+    }
+private:
+    bool finishBatch();
+    int size;
+    std::string platformName, skipReason;
+    double minTime, elapsedTime;
+    long long iterations, batchEnd;
+    bool started, skipped;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState& state);
+
+/**
+ * Register a benchmark to be run once for each size.  The full name of each run is "name/size".
+ */
+int registerBenchmark(const std::string& name, BenchmarkFunction function, const std::vector<int>& sizes);
+
+/**
+ * Register a benchmark to be run once for each size on every available Platform.  The full name
+ * of each run is "name/platform/size".
+ */
+int registerPlatformBenchmark(const std::string& name, BenchmarkFunction function, const std::vector<int>& sizes);
+
+/**
+ * Prevent the compiler from optimizing away a value computed inside a timing loop.
+ */
+template <class T>
+inline void doNotOptimize(const T& value) {
+#ifdef _MSC_VER
+    static const void* volatile sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(&value) : "memory");
+#endif
+}
+
+/**
+ * Create a cubic box of rigid TIP3P water molecules on a lattice at roughly the density of
+ * liquid water, with a NonbondedForce using the specified method and a 0.8 nm cutoff.
+ * The positions are returned in the last argument.
+ */
+OpenMM::System* createWaterBox(int numMolecules, OpenMM::NonbondedForce::NonbondedMethod method, std::vector<OpenMM::Vec3>& positions);
+
+} // namespace OpenMMBenchmarks
+
+#endif /*OPENMM_BENCHMARK_H_*/
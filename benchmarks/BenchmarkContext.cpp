@@ -0,0 +1,159 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Benchmarks that go through the public API, and so run on every available Platform.  On GPU
+ * platforms these measure the full sequence of kernel launches for each operation, including
+ * the synchronization needed to retrieve the results.
+ */
+
+#include "Benchmark.h"
+#include "openmm/Context.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/Platform.h"
+#include "openmm/State.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+#include <memory>
+
+using namespace OpenMM;
+using namespace OpenMMBenchmarks;
+using namespace std;
+
+namespace {
+
+/**
+ * Take ten time steps, then retrieve the positions.
+ */
+void benchmarkSteps(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+    Context context(*system, integrator, Platform::getPlatformByName(state.getPlatformName()));
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0);
+    integrator.step(10);
+    while (state.keepRunning()) {
+        integrator.step(10);
+        context.getState(State::Positions);
+    }
+}
+
+/**
+ * Compute the forces and energy with PME.
+ */
+void benchmarkForces(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, Platform::getPlatformByName(state.getPlatformName()));
+    context.setPositions(positions);
+    context.setForceCachingEnabled(false);
+    while (state.keepRunning())
+        context.getState(State::Forces | State::Energy);
+}
+
+/**
+ * Compute only the reciprocal space part of PME, by placing it in its own force group.
+ */
+void benchmarkPmeReciprocal(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    dynamic_cast<NonbondedForce&>(system->getForce(0)).setReciprocalSpaceForceGroup(1);
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, Platform::getPlatformByName(state.getPlatformName()));
+    context.setPositions(positions);
+    context.setForceCachingEnabled(false);
+    while (state.keepRunning())
+        context.getState(State::Forces | State::Energy, false, 1<<1);
+}
+
+/**
+ * Randomly displace the atoms of a System, then time applying constraints to the displaced positions.
+ */
+void benchmarkConstraints(BenchmarkState& state, const System& system, const vector<Vec3>& positions) {
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> displaced(positions.size());
+    for (int i = 0; i < positions.size(); i++)
+        displaced[i] = positions[i]+Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.01;
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName(state.getPlatformName()));
+    while (state.keepRunning()) {
+        context.setPositions(displaced);
+        context.applyConstraints(1e-5);
+    }
+}
+
+/**
+ * Constrain a box of rigid water molecules, which uses SETTLE.
+ */
+void benchmarkSettle(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::NoCutoff, positions));
+    system->removeForce(0);
+    benchmarkConstraints(state, *system, positions);
+}
+
+/**
+ * Constrain a set of unbranched chains, each containing ten atoms, which uses CCMA.
+ */
+void benchmarkCCMA(BenchmarkState& state) {
+    const int chainLength = 10;
+    const double bondLength = 0.15;
+    int numChains = state.getSize()/chainLength;
+    int gridSize = (int) ceil(sqrt((double) numChains));
+    System system;
+    vector<Vec3> positions;
+    for (int i = 0; i < numChains; i++) {
+        Vec3 origin(0.0, 0.5*(i%gridSize), 0.5*(i/gridSize));
+        for (int j = 0; j < chainLength; j++) {
+            int atom = system.addParticle(12.0);
+            positions.push_back(origin+Vec3(0.125*j, (j%2 == 0 ? 0.0 : 0.0866), 0.0));
+            if (j > 0)
+                system.addConstraint(atom-1, atom, bondLength);
+        }
+    }
+    benchmarkConstraints(state, system, positions);
+}
+
+const vector<int> sizes = {512, 4096};
+
+int registered[] = {
+    registerPlatformBenchmark("Step10", benchmarkSteps, sizes),
+    registerPlatformBenchmark("Forces", benchmarkForces, sizes),
+    registerPlatformBenchmark("PmeReciprocal", benchmarkPmeReciprocal, sizes),
+    registerPlatformBenchmark("Settle", benchmarkSettle, sizes),
+    registerPlatformBenchmark("CCMA", benchmarkCCMA, {1000, 10000})
+};
+
+}
@@ -0,0 +1,251 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Benchmarks for the internal building blocks of the CPU platform: neighbor list construction for
+ * each block size, and the direct space nonbonded kernels for each vector width.  These call the
+ * classes directly rather than going through a Context, so the timings do not include any other
+ * per-step work.
+ */
+
+#include "Benchmark.h"
+#include "AlignedArray.h"
+#include "CpuExclusionList.h"
+#include "CpuNeighborList.h"
+#include "CpuNonbondedForce.h"
+#include "openmm/internal/hardware.h"
+#include "openmm/internal/ThreadPool.h"
+#include <cmath>
+#include <memory>
+
+using namespace OpenMM;
+using namespace OpenMMBenchmarks;
+using namespace std;
+
+// These are defined in the CPU platform's source files for each instruction set.
+
+CpuNonbondedForce* createCpuNonbondedForceVec4(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceAvx(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceAvx2(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceAvx512(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceNeon(const CpuNeighborList& neighbors);
+
+bool isAvx2Supported();
+bool isAvx512Supported();
+bool isNeonVec8Supported();
+
+namespace {
+
+const float cutoff = 0.8f;
+const float padding = 0.1f;
+
+/**
+ * A water box converted to the data structures the CPU platform works with.
+ */
+struct CpuSystemData {
+    CpuSystemData(int numMolecules) {
+        unique_ptr<System> system(createWaterBox(numMolecules, NonbondedForce::PME, positions));
+        numAtoms = system->getNumParticles();
+        system->getDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+        const NonbondedForce& force = dynamic_cast<const NonbondedForce&>(system->getForce(0));
+        posq.resize(4*numAtoms);
+        vector<pair<int, int> > excludedPairs;
+        for (int i = 0; i < numAtoms; i++) {
+            double charge, sigma, epsilon;
+            force.getParticleParameters(i, charge, sigma, epsilon);
+            for (int j = 0; j < 3; j++)
+                posq[4*i+j] = (float) positions[i][j];
+            posq[4*i+3] = (float) charge;
+            particleParams.push_back(make_pair((float) (0.5*sigma), (float) (2.0*sqrt(epsilon))));
+        }
+        for (int i = 0; i < force.getNumExceptions(); i++) {
+            int particle1, particle2;
+            double chargeProd, sigma, epsilon;
+            force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
+            excludedPairs.push_back(make_pair(particle1, particle2));
+        }
+        exclusions = CpuExclusionList(numAtoms, excludedPairs);
+        C6params.resize(numAtoms, 0.0f);
+        threadForce.resize(threads.getNumThreads());
+        for (AlignedArray<float>& f : threadForce)
+            f.resize(4*numAtoms);
+    }
+    int numAtoms;
+    vector<Vec3> positions;
+    Vec3 boxVectors[3];
+    AlignedArray<float> posq;
+    vector<pair<float, float> > particleParams;
+    vector<float> C6params;
+    CpuExclusionList exclusions;
+    ThreadPool threads;
+    vector<AlignedArray<float> > threadForce;
+};
+
+void benchmarkNeighborList(BenchmarkState& state, int blockSize) {
+    CpuSystemData data(state.getSize());
+    CpuNeighborList neighbors(blockSize);
+    while (state.keepRunning())
+        neighbors.computeNeighborList(data.numAtoms, data.posq, data.exclusions, data.boxVectors, true, cutoff+padding, data.threads);
+}
+
+void benchmarkNeighborList4(BenchmarkState& state) {
+    benchmarkNeighborList(state, 4);
+}
+
+void benchmarkNeighborList8(BenchmarkState& state) {
+    benchmarkNeighborList(state, 8);
+}
+
+void benchmarkNeighborList16(BenchmarkState& state) {
+    benchmarkNeighborList(state, 16);
+}
+
+/**
+ * Time the direct space calculation with one of the vectorized kernels.  If ewald is true it
+ * computes the real space part of PME.  Otherwise it uses reaction field.
+ */
+void benchmarkNonbonded(BenchmarkState& state, const string& width, bool ewald) {
+    CpuNonbondedForce* (*factory)(const CpuNeighborList&);
+    int blockSize;
+    if (width == "Vec4") {
+        factory = createCpuNonbondedForceVec4;
+        blockSize = 4;
+    }
+    else if (width == "Avx") {
+        if (!isAvxSupported()) {
+            state.skip("AVX is not supported");
+            return;
+        }
+        factory = createCpuNonbondedForceAvx;
+        blockSize = 8;
+    }
+    else if (width == "Avx2") {
+        if (!isAvx2Supported()) {
+            state.skip("AVX2 is not supported");
+            return;
+        }
+        factory = createCpuNonbondedForceAvx2;
+        blockSize = 8;
+    }
+    else if (width == "Avx512") {
+        if (!isAvx512Supported()) {
+            state.skip("AVX-512 is not supported");
+            return;
+        }
+        factory = createCpuNonbondedForceAvx512;
+        blockSize = 16;
+    }
+    else {
+        if (!isNeonVec8Supported()) {
+            state.skip("8 wide NEON is not supported");
+            return;
+        }
+        factory = createCpuNonbondedForceNeon;
+        blockSize = 8;
+    }
+    CpuSystemData data(state.getSize());
+    CpuNeighborList neighbors(blockSize);
+    neighbors.computeNeighborList(data.numAtoms, data.posq, data.exclusions, data.boxVectors, true, cutoff+padding, data.threads);
+    unique_ptr<CpuNonbondedForce> nonbonded(factory(neighbors));
+    nonbonded->setUseCutoff(cutoff, 78.3f);
+    nonbonded->setPeriodic(data.boxVectors);
+    if (ewald) {
+        int gridSize[3] = {32, 32, 32};
+        nonbonded->setUsePME((float) (sqrt(-log(2*5e-4))/cutoff), gridSize);
+    }
+    double energy;
+    while (state.keepRunning()) {
+        energy = 0.0;
+        nonbonded->calculateDirectIxn(data.numAtoms, &data.posq[0], data.positions, data.particleParams, data.C6params,
+                data.exclusions, data.threadForce, &energy, data.threads);
+        doNotOptimize(energy);
+    }
+}
+
+void benchmarkNonbondedVec4(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Vec4", false);
+}
+
+void benchmarkNonbondedAvx(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Avx", false);
+}
+
+void benchmarkNonbondedAvx2(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Avx2", false);
+}
+
+void benchmarkNonbondedAvx512(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Avx512", false);
+}
+
+void benchmarkNonbondedNeon(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Neon", false);
+}
+
+void benchmarkEwaldVec4(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Vec4", true);
+}
+
+void benchmarkEwaldAvx(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Avx", true);
+}
+
+void benchmarkEwaldAvx2(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Avx2", true);
+}
+
+void benchmarkEwaldAvx512(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Avx512", true);
+}
+
+void benchmarkEwaldNeon(BenchmarkState& state) {
+    benchmarkNonbonded(state, "Neon", true);
+}
+
+const vector<int> sizes = {512, 4096};
+
+int registered[] = {
+    registerBenchmark("CpuNeighborList/Block4", benchmarkNeighborList4, sizes),
+    registerBenchmark("CpuNeighborList/Block8", benchmarkNeighborList8, sizes),
+    registerBenchmark("CpuNeighborList/Block16", benchmarkNeighborList16, sizes),
+    registerBenchmark("CpuNonbondedDirect/Vec4", benchmarkNonbondedVec4, sizes),
+    registerBenchmark("CpuNonbondedDirect/Avx", benchmarkNonbondedAvx, sizes),
+    registerBenchmark("CpuNonbondedDirect/Avx2", benchmarkNonbondedAvx2, sizes),
+    registerBenchmark("CpuNonbondedDirect/Avx512", benchmarkNonbondedAvx512, sizes),
+    registerBenchmark("CpuNonbondedDirect/Neon", benchmarkNonbondedNeon, sizes),
+    registerBenchmark("CpuNonbondedEwald/Vec4", benchmarkEwaldVec4, sizes),
+    registerBenchmark("CpuNonbondedEwald/Avx", benchmarkEwaldAvx, sizes),
+    registerBenchmark("CpuNonbondedEwald/Avx2", benchmarkEwaldAvx2, sizes),
+    registerBenchmark("CpuNonbondedEwald/Avx512", benchmarkEwaldAvx512, sizes),
+    registerBenchmark("CpuNonbondedEwald/Neon", benchmarkEwaldNeon, sizes)
+};
+
+}
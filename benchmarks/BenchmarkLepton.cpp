@@ -0,0 +1,117 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Benchmarks comparing the scalar and vectorized ways of evaluating Lepton expressions.  The size
+ * is the number of times the expression is evaluated in each iteration.
+ */
+
+#include "Benchmark.h"
+#include "lepton/CompiledExpression.h"
+#include "lepton/CompiledVectorExpression.h"
+#include "lepton/ParsedExpression.h"
+#include "lepton/Parser.h"
+#include <algorithm>
+
+using namespace Lepton;
+using namespace OpenMMBenchmarks;
+using namespace std;
+
+namespace {
+
+// A typical CustomNonbondedForce energy expression: Lennard-Jones plus a shifted Coulomb interaction.
+
+const string expression = "4*eps*((sig/r)^12-(sig/r)^6) + 138.935456*q*(1/r-1/1.2)";
+
+void benchmarkCompiledExpression(BenchmarkState& state) {
+    CompiledExpression compiled = Parser::parse(expression).optimize().createCompiledExpression();
+    double& r = compiled.getVariableReference("r");
+    compiled.getVariableReference("eps") = 0.5;
+    compiled.getVariableReference("sig") = 0.3;
+    compiled.getVariableReference("q") = -0.2;
+    int numEvaluations = state.getSize();
+    while (state.keepRunning()) {
+        double sum = 0.0;
+        for (int i = 0; i < numEvaluations; i++) {
+            r = 0.3+i*(0.9/numEvaluations);
+            sum += compiled.evaluate();
+        }
+        doNotOptimize(sum);
+    }
+}
+
+void benchmarkCompiledVectorExpression(BenchmarkState& state, int width) {
+    const vector<int>& widths = CompiledVectorExpression::getAllowedWidths();
+    if (find(widths.begin(), widths.end(), width) == widths.end()) {
+        state.skip("width "+to_string(width)+" is not supported");
+        return;
+    }
+    CompiledVectorExpression compiled = Parser::parse(expression).optimize().createCompiledVectorExpression(width);
+    float* r = compiled.getVariablePointer("r");
+    float* eps = compiled.getVariablePointer("eps");
+    float* sig = compiled.getVariablePointer("sig");
+    float* q = compiled.getVariablePointer("q");
+    for (int i = 0; i < width; i++) {
+        eps[i] = 0.5f;
+        sig[i] = 0.3f;
+        q[i] = -0.2f;
+    }
+    int numEvaluations = state.getSize();
+    while (state.keepRunning()) {
+        float sum = 0.0f;
+        for (int i = 0; i < numEvaluations; i += width) {
+            for (int j = 0; j < width; j++)
+                r[j] = 0.3f+(i+j)*(0.9f/numEvaluations);
+            const float* result = compiled.evaluate();
+            for (int j = 0; j < width; j++)
+                sum += result[j];
+        }
+        doNotOptimize(sum);
+    }
+}
+
+void benchmarkCompiledVectorExpression4(BenchmarkState& state) {
+    benchmarkCompiledVectorExpression(state, 4);
+}
+
+void benchmarkCompiledVectorExpression8(BenchmarkState& state) {
+    benchmarkCompiledVectorExpression(state, 8);
+}
+
+const vector<int> sizes = {1024, 65536};
+
+int registered[] = {
+    registerBenchmark("CompiledExpression", benchmarkCompiledExpression, sizes),
+    registerBenchmark("CompiledVectorExpression/Width4", benchmarkCompiledVectorExpression4, sizes),
+    registerBenchmark("CompiledVectorExpression/Width8", benchmarkCompiledVectorExpression8, sizes)
+};
+
+}
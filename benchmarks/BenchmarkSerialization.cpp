@@ -0,0 +1,99 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Benchmarks for serializing and deserializing a System.  The size is the number of water molecules.
+ */
+
+#include "Benchmark.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include <memory>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace OpenMMBenchmarks;
+using namespace std;
+
+namespace {
+
+void benchmarkXmlSerialize(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    while (state.keepRunning()) {
+        stringstream buffer;
+        XmlSerializer::serialize<System>(system.get(), "System", buffer);
+    }
+}
+
+void benchmarkXmlDeserialize(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    stringstream buffer;
+    XmlSerializer::serialize<System>(system.get(), "System", buffer);
+    string xml = buffer.str();
+    while (state.keepRunning()) {
+        stringstream input(xml);
+        delete XmlSerializer::deserialize<System>(input);
+    }
+}
+
+void benchmarkBinarySerialize(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    while (state.keepRunning()) {
+        stringstream buffer;
+        BinarySerializer::serialize<System>(system.get(), "System", buffer);
+    }
+}
+
+void benchmarkBinaryDeserialize(BenchmarkState& state) {
+    vector<Vec3> positions;
+    unique_ptr<System> system(createWaterBox(state.getSize(), NonbondedForce::PME, positions));
+    stringstream buffer;
+    BinarySerializer::serialize<System>(system.get(), "System", buffer);
+    string data = buffer.str();
+    while (state.keepRunning()) {
+        stringstream input(data);
+        delete BinarySerializer::deserialize<System>(input);
+    }
+}
+
+const vector<int> sizes = {512, 4096};
+
+int registered[] = {
+    registerBenchmark("XmlSerializer/Serialize", benchmarkXmlSerialize, sizes),
+    registerBenchmark("XmlSerializer/Deserialize", benchmarkXmlDeserialize, sizes),
+    registerBenchmark("BinarySerializer/Serialize", benchmarkBinarySerialize, sizes),
+    registerBenchmark("BinarySerializer/Deserialize", benchmarkBinaryDeserialize, sizes)
+};
+
+}
@@ -5,6 +5,11 @@ import openmm.unit as unit
 from datetime import datetime
 import argparse
 import os
+import time
+
+# The version of the format in which results are written by --outfile.  Increment it whenever the
+# meaning of an existing field changes.  compareBenchmarks.py checks it before comparing two files.
+SCHEMA_VERSION = 1
 
 def cpuinfo():
     """Return CPU info"""
@@ -42,7 +47,7 @@ def appendTestResult(filename=None, test_result=None, system_info=None):
     if filename is None:
         return
 
-    all_results = { 'benchmarks' : list() }
+    all_results = { 'schema_version' : SCHEMA_VERSION, 'benchmarks' : list() }
     if system_info is not None:
         all_results['system'] = system_info
 
@@ -96,6 +101,25 @@ def printTestResult(test_result, options):
     else:
         raise ValueError(f"style '{style}' must be one of ['simple', 'table']")
 
+class PhaseTimer(object):
+    """Record how long each phase of a benchmark takes.
+
+    Use it as a context manager around each phase, for example `with timer('context_creation'):`.
+    The times are stored in seconds in the `times` dict.
+    """
+    def __init__(self):
+        self.times = dict()
+
+    def __call__(self, phase):
+        self.phase = phase
+        return self
+
+    def __enter__(self):
+        self.start = time.perf_counter()
+
+    def __exit__(self, *args):
+        self.times[self.phase] = self.times.get(self.phase, 0.0) + time.perf_counter()-self.start
+
 def timeIntegration(context, steps, initialSteps):
     """Integrate a Context for a specified number of steps, then return how many seconds it took."""
     context.getIntegrator().step(initialSteps) # Make sure everything is fully initialized
@@ -298,7 +322,9 @@ def serializeTest(directory=None, system=None, integrator=None, state=None, core
 def runOneTest(testName, options):
     """Perform a single benchmarking simulation."""
 
-    system, positions, test_parameters = retrieveTestSystem(testName, pme_cutoff=options.pme_cutoff, bond_constraints=options.bond_constraints, polarization=options.polarization, epsilon=options.epsilon)
+    timer = PhaseTimer()
+    with timer('system_creation'):
+        system, positions, test_parameters = retrieveTestSystem(testName, pme_cutoff=options.pme_cutoff, bond_constraints=options.bond_constraints, polarization=options.polarization, epsilon=options.epsilon)
 
     # Create a copy of the basic test_parameters dict (which may be cached) to report the test results
     test_result = test_parameters.copy()
@@ -363,10 +389,11 @@ def runOneTest(testName, options):
 
     # Create the Context
     integ.setConstraintTolerance(1e-5)
-    if len(properties) > 0:
-        context = mm.Context(system, integ, platform, properties)
-    else:
-        context = mm.Context(system, integ, platform)
+    with timer('context_creation'):
+        if len(properties) > 0:
+            context = mm.Context(system, integ, platform, properties)
+        else:
+            context = mm.Context(system, integ, platform)
 
     # Store information about the Platform used by the Context
     platform = context.getPlatform()
@@ -376,9 +403,16 @@ def runOneTest(testName, options):
     # Prepare the simulation
     context.setPositions(positions)
     if amber:
-        mm.LocalEnergyMinimizer.minimize(context, 100*unit.kilojoules_per_mole/unit.nanometer)
+        with timer('minimization'):
+            mm.LocalEnergyMinimizer.minimize(context, 100*unit.kilojoules_per_mole/unit.nanometer)
     context.setVelocitiesToTemperature(temperature)
 
+    # The first steps include compiling any kernels that were not compiled when the Context was created,
+    # and building data structures such as the neighbor list.
+    with timer('initial_steps'):
+        integ.step(initialSteps)
+        context.getState(getEnergy=True)
+
     if options.serialize:
         # Apply constraints on positions and velocities if needing to serialize for Folding@home
         tol = 1.0e-8
@@ -398,6 +432,9 @@ def runOneTest(testName, options):
             steps = int(steps*options.seconds/elapsed_time)
     test_result['steps'] = steps
     test_result['elapsed_time'] = elapsed_time
+    timer.times['steady_state_steps'] = elapsed_time
+    test_result['phase_times'] = timer.times
+    test_result['seconds_per_step'] = elapsed_time/steps
     time_per_step = elapsed_time * unit.seconds / steps 
     ns_per_day = (integ.getStepSize() / time_per_step) / (unit.nanoseconds/unit.day)
     test_result['ns_per_day'] = ns_per_day
@@ -469,7 +506,12 @@ Example: run the apoa1pme benchmark for the CPU platform with a reduced cutoff d
 
 Example: run the full suite in mixed precision mode, saving the results to a YAML file
 
-    python benchmark.py --platform=CUDA --precision=mixed --outfile=benchmark.yaml""")
+    python benchmark.py --platform=CUDA --precision=mixed --outfile=benchmark.yaml
+
+Example: save the results to a JSON file, then compare them to an earlier run to find regressions
+
+    python benchmark.py --platform=CUDA --outfile=current.json
+    python compareBenchmarks.py baseline.json current.json""")
 parser.add_argument('--platform', dest='platform', choices=PLATFORMS, help='name of the platform to benchmark')
 parser.add_argument('--test', default=','.join(TESTS), dest='test', help=f'the test to perform, or comma-separated list: {TESTS} [default: all]')
 parser.add_argument('--ensemble', default='NVT', dest='ensemble', help=f'the thermodynamic ensemble to simulate: {ENSEMBLES} [default: NVT]')
@@ -498,7 +540,8 @@ system_info['openmm_version'] = mm.version.version
 system_info['cpuinfo'] = cpuinfo()
 system_info['cpuarch'] = platform.processor()
 system_info['system'] = platform.system()
-# TODO: Capture information on how many CPU threads will be used
+system_info['python_version'] = platform.python_version()
+system_info['cpu_count'] = os.cpu_count()
 
 # Attempt to get GPU info
 try:
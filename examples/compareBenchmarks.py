@@ -0,0 +1,122 @@
+from __future__ import print_function
+import argparse
+import sys
+
+# The fields that identify which benchmark a result is for.  Two results are compared only if all
+# of these are the same.
+KEY_FIELDS = ('test', 'platform', 'precision', 'constraints', 'hydrogen_mass', 'timestep_in_fs', 'ensemble', 'cutoff', 'epsilon')
+
+def loadResults(filename):
+    """Load a file written by benchmark.py with the --outfile option.
+
+    Parameters
+    ----------
+    filename : str
+        The file to load, ending either in .yaml or .json
+
+    Returns
+    -------
+    results : dict
+        The contents of the file
+    """
+    with open(filename, 'rt') as infile:
+        if filename.endswith('.yaml'):
+            import yaml
+            results = yaml.safe_load(infile)
+        elif filename.endswith('.json'):
+            import json
+            results = json.load(infile)
+        else:
+            raise ValueError('filename must end with .json or .yaml')
+    if 'schema_version' not in results:
+        raise ValueError(f'{filename} was written by a version of benchmark.py that does not record the schema version')
+    return results
+
+def benchmarkKey(result):
+    """Get a tuple identifying which benchmark a result is for."""
+    return tuple(str(result.get(field)) for field in KEY_FIELDS)
+
+def describeKey(key):
+    """Get a short human readable description of a benchmark key."""
+    return ' '.join(str(value) for field, value in zip(KEY_FIELDS, key) if value != 'None')
+
+def compareResults(baseline, current, threshold, phaseThreshold):
+    """Compare two sets of results.
+
+    Parameters
+    ----------
+    baseline : dict
+        The results to compare against
+    current : dict
+        The new results
+    threshold : float
+        The fractional decrease in ns/day that counts as a regression
+    phaseThreshold : float
+        The fractional increase in the time for a phase that counts as a regression
+
+    Returns
+    -------
+    rows : list of tuple
+        One row for each comparison made: (benchmark, quantity, baseline value, current value, relative change, is regression)
+    missing : list of str
+        Benchmarks that are in the baseline but not in the current results
+    """
+    if baseline['schema_version'] != current['schema_version']:
+        raise ValueError(f"The files have different schema versions ({baseline['schema_version']} and {current['schema_version']})")
+    currentResults = {benchmarkKey(result): result for result in current['benchmarks']}
+    rows = []
+    missing = []
+    for old in baseline['benchmarks']:
+        key = benchmarkKey(old)
+        if key not in currentResults:
+            missing.append(describeKey(key))
+            continue
+        new = currentResults[key]
+        name = describeKey(key)
+        change = new['ns_per_day']/old['ns_per_day']-1
+        rows.append((name, 'ns_per_day', old['ns_per_day'], new['ns_per_day'], change, change < -threshold))
+        oldPhases = old.get('phase_times', {})
+        newPhases = new.get('phase_times', {})
+        for phase in sorted(set(oldPhases) & set(newPhases)):
+            if phase == 'steady_state_steps' or oldPhases[phase] <= 0:
+                # The steady state time depends on how many steps were run, and is already reflected in ns/day.
+                continue
+            change = newPhases[phase]/oldPhases[phase]-1
+            rows.append((name, phase, oldPhases[phase], newPhases[phase], change, change > phaseThreshold))
+    return rows, missing
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(formatter_class=argparse.RawDescriptionHelpFormatter,
+                                     description="Compare two result files written by benchmark.py and report regressions",
+                                     epilog="""
+The exit status is 1 if any regression was found, and 0 otherwise.
+
+Example: fail if any benchmark is more than 3% slower than the baseline
+
+    python compareBenchmarks.py baseline.json current.json --threshold=0.03""")
+    parser.add_argument('baseline', help='the result file to compare against (.json or .yaml)')
+    parser.add_argument('current', help='the new result file (.json or .yaml)')
+    parser.add_argument('--threshold', default=0.05, type=float, help='fractional decrease in ns/day that counts as a regression [default: 0.05]')
+    parser.add_argument('--phase-threshold', default=0.25, dest='phase_threshold', type=float, help='fractional increase in the time for context creation, minimization, etc. that counts as a regression [default: 0.25]')
+    parser.add_argument('--ignore-phases', default=False, action='store_true', dest='ignore_phases', help='only compare ns/day, not the time for each phase')
+    args = parser.parse_args()
+
+    baseline = loadResults(args.baseline)
+    current = loadResults(args.current)
+    for field in ('hostname', 'gpu', 'cpuinfo', 'openmm_version'):
+        old = baseline.get('system', {}).get(field)
+        new = current.get('system', {}).get(field)
+        if old != new:
+            print(f'Note: {field} differs: {old} -> {new}')
+    rows, missing = compareResults(baseline, current, args.threshold, args.phase_threshold)
+    if args.ignore_phases:
+        rows = [row for row in rows if row[1] == 'ns_per_day']
+    print('%-60s %-20s %14s %14s %9s' % ('Benchmark', 'Quantity', 'Baseline', 'Current', 'Change'))
+    for name, quantity, old, new, change, regression in rows:
+        print('%-60s %-20s %14.6g %14.6g %+8.1f%%%s' % (name, quantity, old, new, 100*change, '  REGRESSION' if regression else ''))
+    for name in missing:
+        print(f'Missing from current results: {name}')
+    regressions = [row for row in rows if row[5]]
+    print()
+    print(f'{len(regressions)} regression(s) found in {len(rows)} comparison(s)')
+    sys.exit(1 if len(regressions) > 0 else 0)
@@ -67,6 +67,13 @@ class LEPTON_EXPORT CompiledExpression {
 public:
     CompiledExpression();
     CompiledExpression(const CompiledExpression& expression);
+    /**
+     * Create a CompiledExpression that computes several outputs at once, such as an energy and its
+     * derivatives.  All outputs are compiled into a single sequence of operations, so subexpressions
+     * they have in common are only evaluated once.  evaluate() returns the first output, and the
+     * others can then be retrieved by calling getOutput().
+     */
+    CompiledExpression(const std::vector<ParsedExpression>& expressions);
     ~CompiledExpression();
     CompiledExpression& operator=(const CompiledExpression& expression);
     /**
@@ -88,15 +95,23 @@ public:
      * Evaluate the expression.  The values of all variables should have been set before calling this.
      */
     double evaluate() const;
+    /**
+     * Get the number of outputs computed by this expression.
+     */
+    int getNumOutputs() const;
+    /**
+     * Get the value of one output, as computed by the most recent call to evaluate().
+     */
+    double getOutput(int index) const;
 private:
     friend class ParsedExpression;
     CompiledExpression(const ParsedExpression& expression);
-    void compileExpression(const ExpressionTreeNode& node, std::vector<std::pair<ExpressionTreeNode, int> >& temps);
-    int findTempIndex(const ExpressionTreeNode& node, std::vector<std::pair<ExpressionTreeNode, int> >& temps);
+    void compileExpression(const ExpressionTreeNode& node, const ExpressionTreeNode::TagMap& tags, std::vector<int>& tempIndex);
     std::map<std::string, double*> variablePointers;
     std::vector<std::pair<double*, double*> > variablesToCopy;
     std::vector<std::vector<int> > arguments;
     std::vector<int> target;
+    std::vector<int> outputIndex;
     std::vector<Operation*> operation;
     std::map<std::string, int> variableIndices;
     std::set<std::string> variableNames;
@@ -113,6 +128,8 @@ private:
 #else
     void generateSingleArgCall(asmjit::x86::Compiler& c, asmjit::x86::Xmm& dest, asmjit::x86::Xmm& arg, double (*function)(double));
     void generateTwoArgCall(asmjit::x86::Compiler& c, asmjit::x86::Xmm& dest, asmjit::x86::Xmm& arg1, asmjit::x86::Xmm& arg2, double (*function)(double, double));
+    void generateSplineEvaluation(asmjit::x86::Compiler& c, asmjit::x86::Xmm& dest, asmjit::x86::Xmm& arg, const std::vector<double>& table, bool periodic);
+    std::vector<std::vector<double> > splineTables;
 #endif
     std::vector<double> constants;
     asmjit::JitRuntime runtime;
@@ -73,6 +73,16 @@ class LEPTON_EXPORT CompiledVectorExpression {
 public:
     CompiledVectorExpression();
     CompiledVectorExpression(const CompiledVectorExpression& expression);
+    /**
+     * Create a CompiledVectorExpression that computes several outputs at once, such as an energy and its
+     * derivatives.  All outputs are compiled into a single sequence of operations, so subexpressions
+     * they have in common are only evaluated once.  evaluate() returns the first output, and the
+     * others can then be retrieved by calling getOutput().
+     *
+     * @param expressions    the expressions to compute
+     * @param width          the width of the vectors on which to compute them
+     */
+    CompiledVectorExpression(const std::vector<ParsedExpression>& expressions, int width);
     ~CompiledVectorExpression();
     CompiledVectorExpression& operator=(const CompiledVectorExpression& expression);
     /**
@@ -104,6 +114,17 @@ public:
      * @return a pointer to N floating point values, where N is the vector width
      */
     const float* evaluate() const;
+    /**
+     * Get the number of outputs computed by this expression.
+     */
+    int getNumOutputs() const;
+    /**
+     * Get the values of one output, as computed by the most recent call to evaluate().
+     *
+     * @param index    the index of the output to get
+     * @return a pointer to N floating point values, where N is the vector width
+     */
+    const float* getOutput(int index) const;
     /**
      * Get the list of vector widths that are supported on the current processor.
      */
@@ -111,13 +132,13 @@ public:
 private:
     friend class ParsedExpression;
     CompiledVectorExpression(const ParsedExpression& expression, int width);
-    void compileExpression(const ExpressionTreeNode& node, std::vector<std::pair<ExpressionTreeNode, int> >& temps, int& workspaceSize);
-    int findTempIndex(const ExpressionTreeNode& node, std::vector<std::pair<ExpressionTreeNode, int> >& temps);
+    void compileExpression(const ExpressionTreeNode& node, const ExpressionTreeNode::TagMap& tags, std::vector<int>& tempIndex, int& workspaceSize);
     int width;
     std::map<std::string, float*> variablePointers;
     std::vector<std::pair<float*, float*> > variablesToCopy;
     std::vector<std::vector<int> > arguments;
     std::vector<int> target;
+    std::vector<int> outputIndex;
     std::vector<Operation*> operation;
     std::map<std::string, int> variableIndices;
     std::set<std::string> variableNames;
@@ -134,6 +155,9 @@ private:
 #else
     void generateSingleArgCall(asmjit::x86::Compiler& c, asmjit::x86::Ymm& dest, asmjit::x86::Ymm& arg, float (*function)(float));
     void generateTwoArgCall(asmjit::x86::Compiler& c, asmjit::x86::Ymm& dest, asmjit::x86::Ymm& arg1, asmjit::x86::Ymm& arg2, float (*function)(float, float));
+    void generateSplineEvaluation(asmjit::x86::Compiler& c, asmjit::x86::Ymm& dest, asmjit::x86::Ymm& arg, const std::vector<float>& table, bool periodic);
+    void generateExpEvaluation(asmjit::x86::Compiler& c, asmjit::x86::Ymm& dest, asmjit::x86::Ymm& arg);
+    std::vector<std::vector<float> > splineTables;
 #endif
     std::vector<float> constants;
     asmjit::JitRuntime runtime;
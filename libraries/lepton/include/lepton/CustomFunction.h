@@ -33,6 +33,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "windowsIncludes.h"
+#include <vector>
 
 namespace Lepton {
 
@@ -70,6 +71,24 @@ public:
      * Create a new duplicate of this object on the heap using the "new" operator.
      */
     virtual CustomFunction* clone() const = 0;
+    /**
+     * Get whether this function is a cubic spline of one argument with evenly spaced knots, and if so,
+     * get the polynomial describing each interval.  CompiledExpression and CompiledVectorExpression
+     * use this to evaluate the function and its first derivative directly in generated code instead
+     * of calling evaluate().  The default implementation returns false.
+     *
+     * @param min           on exit, the start of the range over which the spline is defined
+     * @param max           on exit, the end of the range over which the spline is defined
+     * @param periodic      on exit, true if the function is periodic with period max-min.  Otherwise
+     *                      the function is zero outside the range.
+     * @param coefficients  on exit, four coefficients for each interval.  In interval i, the function equals
+     *                      c[4*i] + c[4*i+1]*u + c[4*i+2]*u^2 + c[4*i+3]*u^3, where u goes from
+     *                      0 to 1 across the interval.
+     * @return true if the function is a spline, in which case the other arguments have been set
+     */
+    virtual bool getSplineCoefficients(double& min, double& max, bool& periodic, std::vector<double>& coefficients) const {
+        return false;
+    }
 };
 
 /**
@@ -33,7 +33,9 @@
  * -------------------------------------------------------------------------- */
 
 #include "windowsIncludes.h"
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Lepton {
@@ -46,6 +48,10 @@ class ParsedExpression;
  * Each node is defined by an Operation and a set of children.  When the expression is
  * evaluated, each child is first evaluated in order, then the resulting values are passed
  * as the arguments to the Operation's evaluate() method.
+ *
+ * A node is never modified after it is created, so copies of a node share its Operation
+ * and children rather than duplicating the whole subtree.  This makes copying a node
+ * a constant time operation, even for very large expressions.
  */
 
 class LEPTON_EXPORT ExpressionTreeNode {
@@ -54,7 +60,7 @@ public:
      * Create a new ExpressionTreeNode.
      *
      * @param operation    the operation for this node.  The ExpressionTreeNode takes over ownership
-     *                     of this object, and deletes it when the node is itself deleted.
+     *                     of this object, and deletes it once the node and all copies of it have been deleted.
      * @param children     the children of this node
      */
     ExpressionTreeNode(Operation* operation, const std::vector<ExpressionTreeNode>& children);
@@ -62,7 +68,7 @@ public:
      * Create a new ExpressionTreeNode with two children.
      *
      * @param operation    the operation for this node.  The ExpressionTreeNode takes over ownership
-     *                     of this object, and deletes it when the node is itself deleted.
+     *                     of this object, and deletes it once the node and all copies of it have been deleted.
      * @param child1       the first child of this node
      * @param child2       the second child of this node
      */
@@ -71,7 +77,7 @@ public:
      * Create a new ExpressionTreeNode with one child.
      *
      * @param operation    the operation for this node.  The ExpressionTreeNode takes over ownership
-     *                     of this object, and deletes it when the node is itself deleted.
+     *                     of this object, and deletes it once the node and all copies of it have been deleted.
      * @param child        the child of this node
      */
     ExpressionTreeNode(Operation* operation, const ExpressionTreeNode& child);
@@ -79,7 +85,7 @@ public:
      * Create a new ExpressionTreeNode with no children.
      *
      * @param operation    the operation for this node.  The ExpressionTreeNode takes over ownership
-     *                     of this object, and deletes it when the node is itself deleted.
+     *                     of this object, and deletes it once the node and all copies of it have been deleted.
      */
     ExpressionTreeNode(Operation* operation);
     ExpressionTreeNode(const ExpressionTreeNode& node);
@@ -100,10 +106,14 @@ public:
     const std::vector<ExpressionTreeNode>& getChildren() const;
 private:
     friend class ParsedExpression;
-    void assignTags(std::vector<const ExpressionTreeNode*>& examples) const;
-    Operation* operation;
-    std::vector<ExpressionTreeNode> children;
-    mutable int tag;
+    friend class CompiledExpression;
+    friend class CompiledVectorExpression;
+    typedef std::unordered_map<const ExpressionTreeNode*, int> TagMap;
+    struct NodeData;
+    void assignTags(std::vector<const ExpressionTreeNode*>& examples, TagMap& tags) const;
+    void assignTags(std::vector<const ExpressionTreeNode*>& examples, TagMap& tags, std::unordered_multimap<size_t, int>& exampleIndex) const;
+    size_t getTagHash(const TagMap& tags) const;
+    std::shared_ptr<const NodeData> data;
 };
 
 } // namespace Lepton
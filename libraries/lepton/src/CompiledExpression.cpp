@@ -45,8 +45,41 @@ CompiledExpression::CompiledExpression() : jitCode(NULL) {
 
 CompiledExpression::CompiledExpression(const ParsedExpression& expression) : jitCode(NULL) {
     ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
-    vector<pair<ExpressionTreeNode, int> > temps;
-    compileExpression(expr.getRootNode(), temps);
+    vector<const ExpressionTreeNode*> examples;
+    ExpressionTreeNode::TagMap tags;
+    expr.getRootNode().assignTags(examples, tags);
+    vector<int> tempIndex(examples.size(), -1);
+    compileExpression(expr.getRootNode(), tags, tempIndex);
+    outputIndex.push_back(tempIndex[tags[&expr.getRootNode()]]);
+    int maxArguments = 1;
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i]->getNumArguments() > maxArguments)
+            maxArguments = operation[i]->getNumArguments();
+    argValues.resize(maxArguments);
+#ifdef LEPTON_USE_JIT
+    generateJitCode();
+#endif
+}
+
+CompiledExpression::CompiledExpression(const vector<ParsedExpression>& expressions) : jitCode(NULL) {
+    if (expressions.size() == 0)
+        throw Exception("CompiledExpression: At least one expression must be specified");
+
+    // Compile all the expressions into a single sequence of operations, so any subexpression
+    // they have in common is only evaluated once.
+
+    vector<ParsedExpression> optimized;
+    vector<const ExpressionTreeNode*> examples;
+    ExpressionTreeNode::TagMap tags;
+    for (int i = 0; i < (int) expressions.size(); i++)
+        optimized.push_back(expressions[i].optimize());
+    for (int i = 0; i < (int) optimized.size(); i++)
+        optimized[i].getRootNode().assignTags(examples, tags);
+    vector<int> tempIndex(examples.size(), -1);
+    for (int i = 0; i < (int) optimized.size(); i++) {
+        compileExpression(optimized[i].getRootNode(), tags, tempIndex);
+        outputIndex.push_back(tempIndex[tags[&optimized[i].getRootNode()]]);
+    }
     int maxArguments = 1;
     for (int i = 0; i < (int) operation.size(); i++)
         if (operation[i]->getNumArguments() > maxArguments)
@@ -70,6 +103,7 @@ CompiledExpression::CompiledExpression(const CompiledExpression& expression) : j
 CompiledExpression& CompiledExpression::operator=(const CompiledExpression& expression) {
     arguments = expression.arguments;
     target = expression.target;
+    outputIndex = expression.outputIndex;
     variableIndices = expression.variableIndices;
     variableNames = expression.variableNames;
     workspace.resize(expression.workspace.size());
@@ -81,16 +115,17 @@ CompiledExpression& CompiledExpression::operator=(const CompiledExpression& expr
     return *this;
 }
 
-void CompiledExpression::compileExpression(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps) {
-    if (findTempIndex(node, temps) != -1)
+void CompiledExpression::compileExpression(const ExpressionTreeNode& node, const ExpressionTreeNode::TagMap& tags, vector<int>& tempIndex) {
+    int tag = tags.at(&node);
+    if (tempIndex[tag] != -1)
         return; // We have already processed a node identical to this one.
     
     // Process the child nodes.
     
     vector<int> args;
     for (int i = 0; i < node.getChildren().size(); i++) {
-        compileExpression(node.getChildren()[i], temps);
-        args.push_back(findTempIndex(node.getChildren()[i], temps));
+        compileExpression(node.getChildren()[i], tags, tempIndex);
+        args.push_back(tempIndex[tags.at(&node.getChildren()[i])]);
     }
     
     // Process this node.
@@ -119,17 +154,10 @@ void CompiledExpression::compileExpression(const ExpressionTreeNode& node, vecto
                 arguments[stepIndex] = args;
         }
     }
-    temps.push_back(make_pair(node, (int) workspace.size()));
+    tempIndex[tag] = (int) workspace.size();
     workspace.push_back(0.0);
 }
 
-int CompiledExpression::findTempIndex(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps) {
-    for (int i = 0; i < (int) temps.size(); i++)
-        if (temps[i].first == node)
-            return i;
-    return -1;
-}
-
 const set<string>& CompiledExpression::getVariables() const {
     return variableNames;
 }
@@ -162,6 +190,14 @@ void CompiledExpression::setVariableLocations(map<string, double*>& variableLoca
     }
 }
 
+int CompiledExpression::getNumOutputs() const {
+    return outputIndex.size();
+}
+
+double CompiledExpression::getOutput(int index) const {
+    return workspace[outputIndex[index]];
+}
+
 double CompiledExpression::evaluate() const {
     if (jitCode)
         return jitCode();
@@ -180,7 +216,7 @@ double CompiledExpression::evaluate() const {
             workspace[target[step]] = operation[step]->evaluate(&argValues[0], dummyVariables);
         }
     }
-    return workspace[workspace.size()-1];
+    return workspace[outputIndex[0]];
 }
 
 #ifdef LEPTON_USE_JIT
@@ -488,7 +524,16 @@ void CompiledExpression::generateJitCode() {
                 invoke->setRet(0, workspaceVar[target[step]]);
         }
     }
-    c.ret(workspaceVar[workspace.size()-1]);
+    if (outputIndex.size() > 1) {
+        // Store every output so getOutput() can retrieve them.
+
+        arm::Gp outputPointer = c.newIntPtr();
+        for (int i = 0; i < (int) outputIndex.size(); i++) {
+            c.mov(outputPointer, imm(&workspace[outputIndex[i]]));
+            c.str(workspaceVar[outputIndex[i]], arm::ptr(outputPointer, 0));
+        }
+    }
+    c.ret(workspaceVar[outputIndex[0]]);
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
@@ -513,10 +558,51 @@ void CompiledExpression::generateTwoArgCall(a64::Compiler& c, arm::Vec& dest, ar
     invoke->setRet(0, dest);
 }
 #else
+/**
+ * If an operation is a tabulated spline of one argument (or its first derivative), build the
+ * table used to evaluate it inline.  The first eight elements hold the minimum, the inverse
+ * spacing, the number of intervals, its inverse, and the index of the last interval.  They are
+ * followed by four polynomial coefficients for each interval.
+ */
+static bool createSplineTable(const Operation& op, vector<double>& table, bool& periodic) {
+    if (op.getId() != Operation::CUSTOM || op.getNumArguments() != 1)
+        return false;
+    const Operation::Custom& custom = dynamic_cast<const Operation::Custom&>(op);
+    int order = custom.getDerivOrder()[0];
+    if (order > 1)
+        return false;
+    double min, max;
+    vector<double> coeff;
+    if (!custom.getFunction().getSplineCoefficients(min, max, periodic, coeff))
+        return false;
+    int numIntervals = coeff.size()/4;
+    double invDx = numIntervals/(max-min);
+    table.resize(8+coeff.size(), 0.0);
+    table[0] = min;
+    table[1] = invDx;
+    table[2] = numIntervals;
+    table[3] = 1.0/numIntervals;
+    table[4] = numIntervals-1;
+    for (int i = 0; i < numIntervals; i++) {
+        double* c = &table[8+4*i];
+        if (order == 0) {
+            for (int j = 0; j < 4; j++)
+                c[j] = coeff[4*i+j];
+        }
+        else {
+            c[0] = coeff[4*i+1]*invDx;
+            c[1] = 2*coeff[4*i+2]*invDx;
+            c[2] = 3*coeff[4*i+3]*invDx;
+        }
+    }
+    return true;
+}
+
 void CompiledExpression::generateJitCode() {
     const CpuInfo& cpu = CpuInfo::host();
     if (!cpu.hasFeature(CpuFeatures::X86::kAVX))
         return;
+    splineTables.clear();
     CodeHolder code;
     code.init(runtime.environment());
     x86::Compiler c(&code);
@@ -654,6 +740,16 @@ void CompiledExpression::generateJitCode() {
                 args.push_back(args[0]+i);
         }
         
+        // Tabulated splines are evaluated inline rather than by calling the function.
+
+        vector<double> table;
+        bool periodic;
+        if (createSplineTable(op, table, periodic)) {
+            splineTables.push_back(table);
+            generateSplineEvaluation(c, workspaceVar[target[step]], workspaceVar[args[0]], splineTables.back(), periodic);
+            continue;
+        }
+
         // Generate instructions to execute this operation.
         
         switch (op.getId()) {
@@ -784,7 +880,16 @@ void CompiledExpression::generateJitCode() {
                 invoke->setRet(0, workspaceVar[target[step]]);
         }
     }
-    c.ret(workspaceVar[workspace.size()-1]);
+    if (outputIndex.size() > 1) {
+        // Store every output so getOutput() can retrieve them.
+
+        x86::Gp outputPointer = c.newIntPtr();
+        for (int i = 0; i < (int) outputIndex.size(); i++) {
+            c.mov(outputPointer, imm(&workspace[outputIndex[i]]));
+            c.vmovsd(x86::ptr(outputPointer, 0, 0), workspaceVar[outputIndex[i]]);
+        }
+    }
+    c.ret(workspaceVar[outputIndex[0]]);
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
@@ -808,5 +913,59 @@ void CompiledExpression::generateTwoArgCall(x86::Compiler& c, x86::Xmm& dest, x8
     invoke->setArg(1, arg2);
     invoke->setRet(0, dest);
 }
+
+void CompiledExpression::generateSplineEvaluation(x86::Compiler& c, x86::Xmm& dest, x86::Xmm& arg, const vector<double>& table, bool periodic) {
+    x86::Gp tablePointer = c.newIntPtr();
+    c.mov(tablePointer, imm(&table[0]));
+    x86::Xmm s = c.newXmmSd();
+    x86::Xmm floorS = c.newXmmSd();
+    x86::Xmm zero = c.newXmmSd();
+    x86::Xmm result = c.newXmmSd();
+    c.vxorps(zero, zero, zero);
+
+    // Find the position in units of the grid spacing, wrapping it into the range if periodic.
+
+    c.vsubsd(s, arg, x86::ptr(tablePointer, 0, 0));
+    c.vmulsd(s, s, x86::ptr(tablePointer, 8, 0));
+    if (periodic) {
+        c.vmulsd(floorS, s, x86::ptr(tablePointer, 24, 0));
+        c.vroundsd(floorS, floorS, floorS, imm(1));
+        c.vmulsd(floorS, floorS, x86::ptr(tablePointer, 16, 0));
+        c.vsubsd(s, s, floorS);
+    }
+
+    // Select the interval.  Clamping it also guards against NaN, since vmaxsd returns the
+    // second operand when the first is NaN.
+
+    c.vroundsd(floorS, s, s, imm(1));
+    c.vmaxsd(floorS, floorS, zero);
+    c.vminsd(floorS, floorS, x86::ptr(tablePointer, 32, 0));
+    c.vsubsd(s, s, floorS);
+    x86::Gp index = c.newIntPtr();
+    c.vcvttsd2si(index, floorS);
+    c.shl(index, imm(5));
+    c.add(index, tablePointer);
+
+    // Evaluate the polynomial.
+
+    c.vmovsd(result, x86::ptr(index, 88, 0));
+    for (int i = 2; i >= 0; i--) {
+        c.vmulsd(result, result, s);
+        c.vaddsd(result, result, x86::ptr(index, 64+8*i, 0));
+    }
+
+    // Outside the range, a non-periodic function is zero.
+
+    if (!periodic) {
+        x86::Xmm mask = c.newXmmSd();
+        x86::Xmm upper = c.newXmmSd();
+        c.vaddsd(s, s, floorS);
+        c.vcmpsd(mask, s, zero, imm(13)); // Comparison mode is _CMP_GE_OS = 13
+        c.vcmpsd(upper, s, x86::ptr(tablePointer, 16, 0), imm(2)); // Comparison mode is _CMP_LE_OS = 2
+        c.vandpd(mask, mask, upper);
+        c.vandpd(result, result, mask);
+    }
+    c.vmovsd(dest, result, result);
+}
 #endif
 #endif
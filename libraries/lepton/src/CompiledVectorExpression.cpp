@@ -33,6 +33,7 @@
 #include "lepton/Operation.h"
 #include "lepton/ParsedExpression.h"
 #include <algorithm>
+#include <limits>
 #include <utility>
 
 using namespace Lepton;
@@ -49,9 +50,47 @@ CompiledVectorExpression::CompiledVectorExpression(const ParsedExpression& expre
     if (find(allowedWidths.begin(), allowedWidths.end(), width) == allowedWidths.end())
         throw Exception("Unsupported width for vector expression: "+to_string(width));
     ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
-    vector<pair<ExpressionTreeNode, int> > temps;
+    vector<const ExpressionTreeNode*> examples;
+    ExpressionTreeNode::TagMap tags;
+    expr.getRootNode().assignTags(examples, tags);
+    vector<int> tempIndex(examples.size(), -1);
     int workspaceSize = 0;
-    compileExpression(expr.getRootNode(), temps, workspaceSize);
+    compileExpression(expr.getRootNode(), tags, tempIndex, workspaceSize);
+    outputIndex.push_back(tempIndex[tags[&expr.getRootNode()]]);
+    workspace.resize(workspaceSize*width);
+    int maxArguments = 1;
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i]->getNumArguments() > maxArguments)
+            maxArguments = operation[i]->getNumArguments();
+    argValues.resize(maxArguments);
+#ifdef LEPTON_USE_JIT
+    generateJitCode();
+#endif
+}
+
+CompiledVectorExpression::CompiledVectorExpression(const vector<ParsedExpression>& expressions, int width) : jitCode(NULL), width(width) {
+    const vector<int> allowedWidths = getAllowedWidths();
+    if (find(allowedWidths.begin(), allowedWidths.end(), width) == allowedWidths.end())
+        throw Exception("Unsupported width for vector expression: "+to_string(width));
+    if (expressions.size() == 0)
+        throw Exception("CompiledVectorExpression: At least one expression must be specified");
+
+    // Compile all the expressions into a single sequence of operations, so any subexpression
+    // they have in common is only evaluated once.
+
+    vector<ParsedExpression> optimized;
+    vector<const ExpressionTreeNode*> examples;
+    ExpressionTreeNode::TagMap tags;
+    for (int i = 0; i < (int) expressions.size(); i++)
+        optimized.push_back(expressions[i].optimize());
+    for (int i = 0; i < (int) optimized.size(); i++)
+        optimized[i].getRootNode().assignTags(examples, tags);
+    vector<int> tempIndex(examples.size(), -1);
+    int workspaceSize = 0;
+    for (int i = 0; i < (int) optimized.size(); i++) {
+        compileExpression(optimized[i].getRootNode(), tags, tempIndex, workspaceSize);
+        outputIndex.push_back(tempIndex[tags[&optimized[i].getRootNode()]]);
+    }
     workspace.resize(workspaceSize*width);
     int maxArguments = 1;
     for (int i = 0; i < (int) operation.size(); i++)
@@ -77,6 +116,7 @@ CompiledVectorExpression& CompiledVectorExpression::operator=(const CompiledVect
     arguments = expression.arguments;
     width = expression.width;
     target = expression.target;
+    outputIndex = expression.outputIndex;
     variableIndices = expression.variableIndices;
     variableNames = expression.variableNames;
     workspace.resize(expression.workspace.size());
@@ -101,16 +141,17 @@ const vector<int>& CompiledVectorExpression::getAllowedWidths() {
     return widths;
 }
 
-void CompiledVectorExpression::compileExpression(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps, int& workspaceSize) {
-    if (findTempIndex(node, temps) != -1)
+void CompiledVectorExpression::compileExpression(const ExpressionTreeNode& node, const ExpressionTreeNode::TagMap& tags, vector<int>& tempIndex, int& workspaceSize) {
+    int tag = tags.at(&node);
+    if (tempIndex[tag] != -1)
         return; // We have already processed a node identical to this one.
 
     // Process the child nodes.
 
     vector<int> args;
     for (int i = 0; i < node.getChildren().size(); i++) {
-        compileExpression(node.getChildren()[i], temps, workspaceSize);
-        args.push_back(findTempIndex(node.getChildren()[i], temps));
+        compileExpression(node.getChildren()[i], tags, tempIndex, workspaceSize);
+        args.push_back(tempIndex[tags.at(&node.getChildren()[i])]);
     }
 
     // Process this node.
@@ -139,17 +180,10 @@ void CompiledVectorExpression::compileExpression(const ExpressionTreeNode& node,
                 arguments[stepIndex] = args;
         }
     }
-    temps.push_back(make_pair(node, workspaceSize));
+    tempIndex[tag] = workspaceSize;
     workspaceSize++;
 }
 
-int CompiledVectorExpression::findTempIndex(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps) {
-    for (int i = 0; i < (int) temps.size(); i++)
-        if (temps[i].first == node)
-            return i;
-    return -1;
-}
-
 int CompiledVectorExpression::getWidth() const {
     return width;
 }
@@ -186,10 +220,18 @@ void CompiledVectorExpression::setVariableLocations(map<string, float*>& variabl
     }
 }
 
+int CompiledVectorExpression::getNumOutputs() const {
+    return outputIndex.size();
+}
+
+const float* CompiledVectorExpression::getOutput(int index) const {
+    return &workspace[outputIndex[index]*width];
+}
+
 const float* CompiledVectorExpression::evaluate() const {
     if (jitCode) {
         jitCode();
-        return &workspace[workspace.size()-width];
+        return &workspace[outputIndex[0]*width];
     }
     for (int i = 0; i < variablesToCopy.size(); i++)
         for (int j = 0; j < width; j++)
@@ -213,7 +255,7 @@ const float* CompiledVectorExpression::evaluate() const {
             }
         }
     }
-    return &workspace[workspace.size()-width];
+    return &workspace[outputIndex[0]*width];
 }
 
 #ifdef LEPTON_USE_JIT
@@ -532,8 +574,10 @@ void CompiledVectorExpression::generateJitCode() {
         }
     }
     arm::Gp resultPointer = c.newIntPtr();
-    c.mov(resultPointer, imm(&workspace[workspace.size()-width]));
-    c.str(workspaceVar.back().s4(), arm::ptr(resultPointer, 0));
+    for (int i = 0; i < (int) outputIndex.size(); i++) {
+        c.mov(resultPointer, imm(&workspace[outputIndex[i]*width]));
+        c.str(workspaceVar[outputIndex[i]].s4(), arm::ptr(resultPointer, 0));
+    }
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
@@ -573,10 +617,52 @@ void CompiledVectorExpression::generateTwoArgCall(a64::Compiler& c, arm::Vec& de
 }
 #else
 
+/**
+ * If an operation is a tabulated spline of one argument (or its first derivative), build the
+ * table used to evaluate it inline.  The first eight elements hold the minimum, the inverse
+ * spacing, the number of intervals, its inverse, and the index of the last interval.  They are
+ * followed by four polynomial coefficients for each interval.
+ */
+static bool createSplineTable(const Operation& op, vector<float>& table, bool& periodic) {
+    if (op.getId() != Operation::CUSTOM || op.getNumArguments() != 1)
+        return false;
+    const Operation::Custom& custom = dynamic_cast<const Operation::Custom&>(op);
+    int order = custom.getDerivOrder()[0];
+    if (order > 1)
+        return false;
+    double min, max;
+    vector<double> coeff;
+    if (!custom.getFunction().getSplineCoefficients(min, max, periodic, coeff))
+        return false;
+    int numIntervals = coeff.size()/4;
+    double invDx = numIntervals/(max-min);
+    table.resize(8+coeff.size(), 0.0f);
+    table[0] = (float) min;
+    table[1] = (float) invDx;
+    table[2] = (float) numIntervals;
+    table[3] = (float) (1.0/numIntervals);
+    table[4] = (float) (numIntervals-1);
+    for (int i = 0; i < numIntervals; i++) {
+        float* c = &table[8+4*i];
+        if (order == 0) {
+            for (int j = 0; j < 4; j++)
+                c[j] = (float) coeff[4*i+j];
+        }
+        else {
+            c[0] = (float) (coeff[4*i+1]*invDx);
+            c[1] = (float) (2*coeff[4*i+2]*invDx);
+            c[2] = (float) (3*coeff[4*i+3]*invDx);
+        }
+    }
+    return true;
+}
+
 void CompiledVectorExpression::generateJitCode() {
     const CpuInfo& cpu = CpuInfo::host();
     if (!cpu.hasFeature(CpuFeatures::X86::kAVX))
         return;
+    bool hasGather = cpu.hasFeature(CpuFeatures::X86::kAVX2);
+    splineTables.clear();
     CodeHolder code;
     code.init(runtime.environment());
     x86::Compiler c(&code);
@@ -719,6 +805,17 @@ void CompiledVectorExpression::generateJitCode() {
                 args.push_back(args[0] + i);
         }
 
+        // Tabulated splines are evaluated inline rather than by calling the function.  This
+        // requires the gather instructions added in AVX2.
+
+        vector<float> table;
+        bool periodic;
+        if (hasGather && createSplineTable(op, table, periodic)) {
+            splineTables.push_back(table);
+            generateSplineEvaluation(c, workspaceVar[target[step]], workspaceVar[args[0]], splineTables.back(), periodic);
+            continue;
+        }
+
         // Generate instructions to execute this operation.
 
         switch (op.getId()) {
@@ -748,7 +845,10 @@ void CompiledVectorExpression::generateJitCode() {
                 c.vsqrtps(workspaceVar[target[step]], workspaceVar[args[0]]);
                 break;
             case Operation::EXP:
-                generateSingleArgCall(c, workspaceVar[target[step]], workspaceVar[args[0]], expf);
+                if (hasGather)
+                    generateExpEvaluation(c, workspaceVar[target[step]], workspaceVar[args[0]]);
+                else
+                    generateSingleArgCall(c, workspaceVar[target[step]], workspaceVar[args[0]], expf);
                 break;
             case Operation::LOG:
                 generateSingleArgCall(c, workspaceVar[target[step]], workspaceVar[args[0]], logf);
@@ -866,11 +966,13 @@ void CompiledVectorExpression::generateJitCode() {
         }
     }
     x86::Gp resultPointer = c.newIntPtr();
-    c.mov(resultPointer, imm(&workspace[workspace.size()-width]));
-    if (width == 4)
-        c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar.back().xmm());
-    else
-        c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar.back());
+    for (int i = 0; i < (int) outputIndex.size(); i++) {
+        c.mov(resultPointer, imm(&workspace[outputIndex[i]*width]));
+        if (width == 4)
+            c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar[outputIndex[i]].xmm());
+        else
+            c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar[outputIndex[i]]);
+    }
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
@@ -929,5 +1031,143 @@ void CompiledVectorExpression::generateTwoArgCall(x86::Compiler& c, x86::Ymm& de
         c.vblendps(dest, dest, d, 1<<element);
     }
 }
+
+void CompiledVectorExpression::generateExpEvaluation(x86::Compiler& c, x86::Ymm& dest, x86::Ymm& arg) {
+    // This evaluates exp() inline for all elements at once, rather than calling expf() on each
+    // element in turn.  It uses the same range reduction and polynomial as Cephes, which is accurate
+    // to about 1 ulp.  Building the power of two requires the integer instructions added in AVX2.
+
+    static const float table[] = {88.3762626647949f, -88.3762626647949f, 1.44269504088896341f, 0.5f,
+            0.693359375f, -2.12194440e-4f, 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+            4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f, 1.0f, 88.7228391116729996f,
+            std::numeric_limits<float>::infinity()};
+    static const int exponentBias = 127;
+    x86::Gp tablePointer = c.newIntPtr();
+    c.mov(tablePointer, imm(&table[0]));
+    x86::Ymm x = c.newYmmPs();
+    x86::Ymm fx = c.newYmmPs();
+    x86::Ymm y = c.newYmmPs();
+    x86::Ymm param = c.newYmmPs();
+    x86::Ymm power = c.newYmm();
+
+    // Clamp the argument to the range where the result is finite.  The operands are ordered
+    // so that NaN is passed through.
+
+    c.vbroadcastss(param, x86::ptr(tablePointer, 0, 0));
+    c.vminps(x, param, arg);
+    c.vbroadcastss(param, x86::ptr(tablePointer, 4, 0));
+    c.vmaxps(x, param, x);
+
+    // Write exp(x) = 2^n * exp(r), where n = floor(x*log2(e)+0.5).
+
+    c.vbroadcastss(param, x86::ptr(tablePointer, 8, 0));
+    c.vmulps(fx, x, param);
+    c.vbroadcastss(param, x86::ptr(tablePointer, 12, 0));
+    c.vaddps(fx, fx, param);
+    c.vroundps(fx, fx, imm(1));
+    c.vbroadcastss(param, x86::ptr(tablePointer, 16, 0));
+    c.vmulps(y, fx, param);
+    c.vsubps(x, x, y);
+    c.vbroadcastss(param, x86::ptr(tablePointer, 20, 0));
+    c.vmulps(y, fx, param);
+    c.vsubps(x, x, y);
+
+    // Evaluate the polynomial approximation to exp(r).
+
+    c.vbroadcastss(y, x86::ptr(tablePointer, 24, 0));
+    for (int i = 7; i < 12; i++) {
+        c.vmulps(y, y, x);
+        c.vbroadcastss(param, x86::ptr(tablePointer, 4*i, 0));
+        c.vaddps(y, y, param);
+    }
+    c.vmulps(param, x, x);
+    c.vmulps(y, y, param);
+    c.vaddps(y, y, x);
+    c.vbroadcastss(param, x86::ptr(tablePointer, 48, 0));
+    c.vaddps(y, y, param);
+
+    // Build 2^n by placing n directly in the exponent bits, and multiply by it.
+
+    c.vcvttps2dq(power, fx);
+    c.mov(tablePointer, imm(&exponentBias));
+    c.vpbroadcastd(param, x86::ptr(tablePointer, 0, 0));
+    c.vpaddd(power, power, param);
+    c.vpslld(power, power, imm(23));
+    c.vmulps(y, y, power);
+
+    // Arguments above the clamped range overflow to infinity.
+
+    c.mov(tablePointer, imm(&table[0]));
+    c.vbroadcastss(param, x86::ptr(tablePointer, 52, 0));
+    c.vcmpps(x, arg, param, imm(14));
+    c.vbroadcastss(param, x86::ptr(tablePointer, 56, 0));
+    c.vblendvps(dest, y, param, x);
+}
+
+void CompiledVectorExpression::generateSplineEvaluation(x86::Compiler& c, x86::Ymm& dest, x86::Ymm& arg, const vector<float>& table, bool periodic) {
+    x86::Gp tablePointer = c.newIntPtr();
+    c.mov(tablePointer, imm(&table[0]));
+    x86::Ymm s = c.newYmmPs();
+    x86::Ymm floorS = c.newYmmPs();
+    x86::Ymm param = c.newYmmPs();
+    x86::Ymm zero = c.newYmmPs();
+    x86::Ymm result = c.newYmmPs();
+    x86::Ymm coeff = c.newYmmPs();
+    x86::Ymm index = c.newYmm();
+    x86::Ymm gatherMask = c.newYmm();
+    c.vxorps(zero, zero, zero);
+
+    // Find the position in units of the grid spacing, wrapping it into the range if periodic.
+
+    c.vbroadcastss(param, x86::ptr(tablePointer, 0, 0));
+    c.vsubps(s, arg, param);
+    c.vbroadcastss(param, x86::ptr(tablePointer, 4, 0));
+    c.vmulps(s, s, param);
+    if (periodic) {
+        c.vbroadcastss(param, x86::ptr(tablePointer, 12, 0));
+        c.vmulps(floorS, s, param);
+        c.vroundps(floorS, floorS, imm(1));
+        c.vbroadcastss(param, x86::ptr(tablePointer, 8, 0));
+        c.vmulps(floorS, floorS, param);
+        c.vsubps(s, s, floorS);
+    }
+
+    // Select the interval.  Clamping it also guards against NaN, since vmaxps returns the
+    // second operand when the first is NaN.
+
+    c.vroundps(floorS, s, imm(1));
+    c.vmaxps(floorS, floorS, zero);
+    c.vbroadcastss(param, x86::ptr(tablePointer, 16, 0));
+    c.vminps(floorS, floorS, param);
+    c.vsubps(s, s, floorS);
+    c.vcvttps2dq(index, floorS);
+    c.vpslld(index, index, imm(2));
+
+    // Evaluate the polynomial.  Each gather clears its mask, so it must be reset every time.
+
+    for (int i = 3; i >= 0; i--) {
+        c.vpcmpeqd(gatherMask, gatherMask, gatherMask);
+        if (i == 3)
+            c.vgatherdps(result, x86::ptr(tablePointer, index, 2, 32+4*i), gatherMask);
+        else {
+            c.vgatherdps(coeff, x86::ptr(tablePointer, index, 2, 32+4*i), gatherMask);
+            c.vmulps(result, result, s);
+            c.vaddps(result, result, coeff);
+        }
+    }
+
+    // Outside the range, a non-periodic function is zero.
+
+    if (!periodic) {
+        x86::Ymm mask = c.newYmmPs();
+        c.vaddps(s, s, floorS);
+        c.vcmpps(mask, s, zero, imm(13)); // Comparison mode is _CMP_GE_OS = 13
+        c.vbroadcastss(param, x86::ptr(tablePointer, 8, 0));
+        c.vcmpps(param, s, param, imm(2)); // Comparison mode is _CMP_LE_OS = 2
+        c.vandps(mask, mask, param);
+        c.vandps(result, result, mask);
+    }
+    c.vmovaps(dest, result);
+}
 #endif
 #endif
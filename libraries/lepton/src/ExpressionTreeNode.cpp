@@ -32,51 +32,68 @@
 #include "lepton/ExpressionTreeNode.h"
 #include "lepton/Exception.h"
 #include "lepton/Operation.h"
+#include <functional>
 #include <utility>
 
 using namespace Lepton;
 using namespace std;
 
-ExpressionTreeNode::ExpressionTreeNode(Operation* operation, const vector<ExpressionTreeNode>& children) : operation(operation), children(children) {
+struct ExpressionTreeNode::NodeData {
+    NodeData(Operation* operation) : operation(operation) {
+    }
+    ~NodeData() {
+        delete operation;
+    }
+    Operation* operation;
+    vector<ExpressionTreeNode> children;
+};
+
+ExpressionTreeNode::ExpressionTreeNode(Operation* operation, const vector<ExpressionTreeNode>& children) {
     if (operation->getNumArguments() != children.size())
         throw Exception("wrong number of arguments to function: "+operation->getName());
+    NodeData* nodeData = new NodeData(operation);
+    nodeData->children = children;
+    data.reset(nodeData);
 }
 
-ExpressionTreeNode::ExpressionTreeNode(Operation* operation, const ExpressionTreeNode& child1, const ExpressionTreeNode& child2) : operation(operation) {
-    children.push_back(child1);
-    children.push_back(child2);
-    if (operation->getNumArguments() != children.size())
+ExpressionTreeNode::ExpressionTreeNode(Operation* operation, const ExpressionTreeNode& child1, const ExpressionTreeNode& child2) {
+    if (operation->getNumArguments() != 2)
         throw Exception("wrong number of arguments to function: "+operation->getName());
+    NodeData* nodeData = new NodeData(operation);
+    nodeData->children.push_back(child1);
+    nodeData->children.push_back(child2);
+    data.reset(nodeData);
 }
 
-ExpressionTreeNode::ExpressionTreeNode(Operation* operation, const ExpressionTreeNode& child) : operation(operation) {
-    children.push_back(child);
-    if (operation->getNumArguments() != children.size())
+ExpressionTreeNode::ExpressionTreeNode(Operation* operation, const ExpressionTreeNode& child) {
+    if (operation->getNumArguments() != 1)
         throw Exception("wrong number of arguments to function: "+operation->getName());
+    NodeData* nodeData = new NodeData(operation);
+    nodeData->children.push_back(child);
+    data.reset(nodeData);
 }
 
-ExpressionTreeNode::ExpressionTreeNode(Operation* operation) : operation(operation) {
-    if (operation->getNumArguments() != children.size())
+ExpressionTreeNode::ExpressionTreeNode(Operation* operation) {
+    if (operation->getNumArguments() != 0)
         throw Exception("wrong number of arguments to function: "+operation->getName());
+    data.reset(new NodeData(operation));
 }
 
-ExpressionTreeNode::ExpressionTreeNode(const ExpressionTreeNode& node) : operation(node.operation == NULL ? NULL : node.operation->clone()), children(node.getChildren()) {
+ExpressionTreeNode::ExpressionTreeNode(const ExpressionTreeNode& node) : data(node.data) {
 }
 
-ExpressionTreeNode::ExpressionTreeNode(ExpressionTreeNode&& node) : operation(node.operation), children(move(node.children)) {
-    node.operation = NULL;
-    node.children.clear();
+ExpressionTreeNode::ExpressionTreeNode(ExpressionTreeNode&& node) : data(move(node.data)) {
 }
 
-ExpressionTreeNode::ExpressionTreeNode() : operation(NULL) {
+ExpressionTreeNode::ExpressionTreeNode() {
 }
 
 ExpressionTreeNode::~ExpressionTreeNode() {
-    if (operation != NULL)
-        delete operation;
 }
 
 bool ExpressionTreeNode::operator!=(const ExpressionTreeNode& node) const {
+    if (data == node.data)
+        return false;
     if (node.getOperation() != getOperation())
         return true;
     if (getOperation().isSymmetric() && getChildren().size() == 2) {
@@ -97,50 +114,56 @@ bool ExpressionTreeNode::operator==(const ExpressionTreeNode& node) const {
 }
 
 ExpressionTreeNode& ExpressionTreeNode::operator=(const ExpressionTreeNode& node) {
-    if (operation != NULL)
-        delete operation;
-    operation = node.getOperation().clone();
-    children = node.getChildren();
+    data = node.data;
     return *this;
 }
 
 ExpressionTreeNode& ExpressionTreeNode::operator=(ExpressionTreeNode&& node) {
-    if (operation != NULL)
-        delete operation;
-    operation = node.operation;
-    children = move(node.children);
-    node.operation = NULL;
-    node.children.clear();
+    data = move(node.data);
     return *this;
 }
 
 const Operation& ExpressionTreeNode::getOperation() const {
-    return *operation;
+    return *data->operation;
 }
 
 const vector<ExpressionTreeNode>& ExpressionTreeNode::getChildren() const {
-    return children;
+    return data->children;
 }
 
-void ExpressionTreeNode::assignTags(vector<const ExpressionTreeNode*>& examples) const {
+void ExpressionTreeNode::assignTags(vector<const ExpressionTreeNode*>& examples, TagMap& tags) const {
     // Assign tag values to all nodes in a tree, such that two nodes have the same
     // tag if and only if they (and all their children) are equal.  This is used to
-    // optimize other operations.
+    // optimize other operations.  The tags are stored in a separate map rather than
+    // in the nodes, since the nodes may be shared with other expressions.  Existing
+    // examples are indexed by a hash of their operation and child tags, so each node
+    // only needs to be compared to the few examples with the same hash.
+
+    unordered_multimap<size_t, int> exampleIndex;
+    for (int i = 0; i < examples.size(); i++)
+        exampleIndex.insert(make_pair(examples[i]->getTagHash(tags), i));
+    assignTags(examples, tags, exampleIndex);
+}
 
+void ExpressionTreeNode::assignTags(vector<const ExpressionTreeNode*>& examples, TagMap& tags, unordered_multimap<size_t, int>& exampleIndex) const {
+    if (tags.find(this) != tags.end())
+        return; // This node is shared with a part of the tree that was already processed.
     int numTags = examples.size();
     for (const ExpressionTreeNode& child : getChildren())
-        child.assignTags(examples);
+        child.assignTags(examples, tags, exampleIndex);
+    size_t hash = getTagHash(tags);
     if (numTags == examples.size()) {
         // All the children matched existing tags, so possibly this node does too.
-        
-        for (int i = 0; i < examples.size(); i++) {
-            const ExpressionTreeNode& example = *examples[i];
+
+        auto range = exampleIndex.equal_range(hash);
+        for (auto iter = range.first; iter != range.second; ++iter) {
+            const ExpressionTreeNode& example = *examples[iter->second];
             bool matches = (getChildren().size() == example.getChildren().size() && getOperation() == example.getOperation());
             for (int j = 0; matches && j < getChildren().size(); j++)
-                if (getChildren()[j].tag != example.getChildren()[j].tag)
+                if (tags[&getChildren()[j]] != tags[&example.getChildren()[j]])
                     matches = false;
             if (matches) {
-                tag = i;
+                tags[this] = iter->second;
                 return;
             }
         }
@@ -148,6 +171,18 @@ void ExpressionTreeNode::assignTags(vector<const ExpressionTreeNode*>& examples)
     
     // This node does not match any previous node, so assign a new tag.
     
-    tag = examples.size();
+    int tag = examples.size();
+    tags[this] = tag;
     examples.push_back(this);
+    exampleIndex.insert(make_pair(hash, tag));
+}
+
+size_t ExpressionTreeNode::getTagHash(const TagMap& tags) const {
+    // Equal nodes have the same operation name and ID, and children with the same tags,
+    // so they always produce the same hash.
+
+    size_t hash = std::hash<string>()(getOperation().getName())*31+getOperation().getId();
+    for (const ExpressionTreeNode& child : getChildren())
+        hash = hash*1000003+tags.at(&child);
+    return hash;
 }
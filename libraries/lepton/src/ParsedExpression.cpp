@@ -47,7 +47,7 @@ ParsedExpression::ParsedExpression(const ExpressionTreeNode& rootNode) : rootNod
 }
 
 const ExpressionTreeNode& ParsedExpression::getRootNode() const {
-    if (&rootNode.getOperation() == NULL)
+    if (rootNode.data == NULL)
         throw Exception("Illegal call to an initialized ParsedExpression");
     return rootNode;
 }
@@ -71,14 +71,16 @@ double ParsedExpression::evaluate(const ExpressionTreeNode& node, const map<stri
 ParsedExpression ParsedExpression::optimize() const {
     ExpressionTreeNode result = getRootNode();
     vector<const ExpressionTreeNode*> examples;
-    result.assignTags(examples);
+    ExpressionTreeNode::TagMap tags;
+    result.assignTags(examples, tags);
     map<int, ExpressionTreeNode> nodeCache;
-    result = precalculateConstantSubexpressions(result, nodeCache);
+    result = precalculateConstantSubexpressions(result, tags, nodeCache);
     while (true) {
         examples.clear();
-        result.assignTags(examples);
+        tags.clear();
+        result.assignTags(examples, tags);
         nodeCache.clear();
-        ExpressionTreeNode simplified = substituteSimplerExpression(result, nodeCache);
+        ExpressionTreeNode simplified = substituteSimplerExpression(result, tags, nodeCache);
         if (simplified == result)
             break;
         result = simplified;
@@ -89,14 +91,16 @@ ParsedExpression ParsedExpression::optimize() const {
 ParsedExpression ParsedExpression::optimize(const map<string, double>& variables) const {
     ExpressionTreeNode result = preevaluateVariables(getRootNode(), variables);
     vector<const ExpressionTreeNode*> examples;
-    result.assignTags(examples);
+    ExpressionTreeNode::TagMap tags;
+    result.assignTags(examples, tags);
     map<int, ExpressionTreeNode> nodeCache;
-    result = precalculateConstantSubexpressions(result, nodeCache);
+    result = precalculateConstantSubexpressions(result, tags, nodeCache);
     while (true) {
         examples.clear();
-        result.assignTags(examples);
+        tags.clear();
+        result.assignTags(examples, tags);
         nodeCache.clear();
-        ExpressionTreeNode simplified = substituteSimplerExpression(result, nodeCache);
+        ExpressionTreeNode simplified = substituteSimplerExpression(result, tags, nodeCache);
         if (simplified == result)
             break;
         result = simplified;
@@ -118,36 +122,38 @@ ExpressionTreeNode ParsedExpression::preevaluateVariables(const ExpressionTreeNo
     return ExpressionTreeNode(node.getOperation().clone(), children);
 }
 
-ExpressionTreeNode ParsedExpression::precalculateConstantSubexpressions(const ExpressionTreeNode& node, map<int, ExpressionTreeNode>& nodeCache) {
-    auto cached = nodeCache.find(node.tag);
+ExpressionTreeNode ParsedExpression::precalculateConstantSubexpressions(const ExpressionTreeNode& node, const ExpressionTreeNode::TagMap& tags, map<int, ExpressionTreeNode>& nodeCache) {
+    int tag = tags.at(&node);
+    auto cached = nodeCache.find(tag);
     if (cached != nodeCache.end())
         return cached->second;
     vector<ExpressionTreeNode> children(node.getChildren().size());
     for (int i = 0; i < (int) children.size(); i++)
-        children[i] = precalculateConstantSubexpressions(node.getChildren()[i], nodeCache);
+        children[i] = precalculateConstantSubexpressions(node.getChildren()[i], tags, nodeCache);
     ExpressionTreeNode result = ExpressionTreeNode(node.getOperation().clone(), children);
     if (node.getOperation().getId() == Operation::VARIABLE || node.getOperation().getId() == Operation::CUSTOM) {
-        nodeCache[node.tag] = result;
+        nodeCache[tag] = result;
         return result;
     }
     for (int i = 0; i < (int) children.size(); i++)
         if (children[i].getOperation().getId() != Operation::CONSTANT) {
-            nodeCache[node.tag] = result;
+            nodeCache[tag] = result;
             return result;
         }
     result = ExpressionTreeNode(new Operation::Constant(evaluate(result, map<string, double>())));
-    nodeCache[node.tag] = result;
+    nodeCache[tag] = result;
     return result;
 }
 
-ExpressionTreeNode ParsedExpression::substituteSimplerExpression(const ExpressionTreeNode& node, map<int, ExpressionTreeNode>& nodeCache) {
+ExpressionTreeNode ParsedExpression::substituteSimplerExpression(const ExpressionTreeNode& node, const ExpressionTreeNode::TagMap& tags, map<int, ExpressionTreeNode>& nodeCache) {
     vector<ExpressionTreeNode> children(node.getChildren().size());
     for (int i = 0; i < (int) children.size(); i++) {
         const ExpressionTreeNode& child = node.getChildren()[i];
-        auto cached = nodeCache.find(child.tag);
+        int childTag = tags.at(&child);
+        auto cached = nodeCache.find(childTag);
         if (cached == nodeCache.end()) {
-            children[i] = substituteSimplerExpression(child, nodeCache);
-            nodeCache[child.tag] = children[i];
+            children[i] = substituteSimplerExpression(child, tags, nodeCache);
+            nodeCache[childTag] = children[i];
         }
         else
             children[i] = cached->second;
@@ -346,20 +352,22 @@ ExpressionTreeNode ParsedExpression::substituteSimplerExpression(const Expressio
 
 ParsedExpression ParsedExpression::differentiate(const string& variable) const {
     vector<const ExpressionTreeNode*> examples;
-    getRootNode().assignTags(examples);
+    ExpressionTreeNode::TagMap tags;
+    getRootNode().assignTags(examples, tags);
     map<int, ExpressionTreeNode> nodeCache;
-    return differentiate(getRootNode(), variable, nodeCache);
+    return differentiate(getRootNode(), variable, tags, nodeCache);
 }
 
-ExpressionTreeNode ParsedExpression::differentiate(const ExpressionTreeNode& node, const string& variable, map<int, ExpressionTreeNode>& nodeCache) {
-    auto cached = nodeCache.find(node.tag);
+ExpressionTreeNode ParsedExpression::differentiate(const ExpressionTreeNode& node, const string& variable, const ExpressionTreeNode::TagMap& tags, map<int, ExpressionTreeNode>& nodeCache) {
+    int tag = tags.at(&node);
+    auto cached = nodeCache.find(tag);
     if (cached != nodeCache.end())
         return cached->second;
     vector<ExpressionTreeNode> childDerivs(node.getChildren().size());
     for (int i = 0; i < (int) childDerivs.size(); i++)
-        childDerivs[i] = differentiate(node.getChildren()[i], variable, nodeCache);
+        childDerivs[i] = differentiate(node.getChildren()[i], variable, tags, nodeCache);
     ExpressionTreeNode result = node.getOperation().differentiate(node.getChildren(), childDerivs, variable);
-    nodeCache[node.tag] = result;
+    nodeCache[tag] = result;
     return result;
 }
 
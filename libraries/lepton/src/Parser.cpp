@@ -153,17 +153,18 @@ ParsedExpression Parser::parse(const string& expression, const map<string, Custo
     try {
         // First split the expression into subexpressions.
 
-        string primaryExpression = expression;
+        string::size_type end = expression.size();
         vector<string> subexpressions;
-        while (true) {
-            string::size_type pos = primaryExpression.find_last_of(';');
+        while (end > 0) {
+            string::size_type pos = expression.find_last_of(';', end-1);
             if (pos == string::npos)
                 break;
-            string sub = trim(primaryExpression.substr(pos+1));
+            string sub = trim(expression.substr(pos+1, end-pos-1));
             if (sub.size() > 0)
                 subexpressions.push_back(sub);
-            primaryExpression = primaryExpression.substr(0, pos);
+            end = pos;
         }
+        string primaryExpression = expression.substr(0, end);
 
         // Parse the subexpressions.
 
@@ -108,6 +108,19 @@ struct XDRFILE
 #ifndef _XDRFILE_H_
 #define _XDRFILE_H_
 
+/* OpenMM builds this code into its own library, and other modules link to it. */
+#ifdef _MSC_VER
+	#if defined(XDRFILE_BUILDING_SHARED_LIBRARY)
+		#define XDRFILE_EXPORT __declspec(dllexport)
+	#elif defined(XDRFILE_BUILDING_STATIC_LIBRARY) || defined(XDRFILE_USE_STATIC_LIBRARIES)
+		#define XDRFILE_EXPORT
+	#else
+		#define XDRFILE_EXPORT __declspec(dllimport)
+	#endif
+#else
+	#define XDRFILE_EXPORT
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -132,7 +145,7 @@ extern "C"
 		   exdrINT, exdrFLOAT, exdrUINT, exdr3DX, exdrCLOSE, exdrMAGIC,
 		   exdrNOMEM, exdrENDOFFILE, exdrFILENOTFOUND, exdrDUFF, exdrNR };
 
-	extern const char *exdr_message[exdrNR];
+	extern XDRFILE_EXPORT const char *exdr_message[exdrNR];
 
 #define DIM 3
 	typedef float matrix[DIM][DIM];
@@ -152,11 +165,22 @@ extern "C"
 	 *  \return Pointer to abstract xdr file datatype, or NULL if an error occurs.
 	 *
 	 */
-	XDRFILE *
+	XDRFILE_EXPORT XDRFILE *
 	xdrfile_open    (const char *    path,
 					 const char *    mode);
 
 
+	/*! \brief Open a temporary portable binary file for writing, just like tmpfile()
+	 *
+	 *  The file is deleted when it is closed.  Its contents can be read back
+	 *  through the fp member of the returned structure.
+	 *
+	 *  \return Pointer to abstract xdr file datatype, or NULL if an error occurs.
+	 */
+	XDRFILE_EXPORT XDRFILE *
+	xdrfile_tmpfile (void);
+
+
 	/*! \brief Close a previously opened portable binary file, just like fclose()
 	 *
 	 *  Use this routine much like calls to the standard library function
@@ -167,7 +191,7 @@ extern "C"
 	 *
 	 *  \return     0 on success, non-zero on error.
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_close   (XDRFILE *       xfp);
 
 
@@ -181,7 +205,7 @@ extern "C"
 	 *
 	 *  \return       Number of characters read
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_char(char *      ptr,
 					  int         ndata,
 					  XDRFILE *   xfp);
@@ -196,7 +220,7 @@ extern "C"
 	 *
 	 *  \return       Number of characters written
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_char(char *      ptr,
 					   int         ndata,
 					   XDRFILE *   xfp);
@@ -211,7 +235,7 @@ extern "C"
 	 *
 	 *  \return       Number of unsigned characters read
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_uchar(unsigned char *    ptr,
 					   int		          ndata,
 					   XDRFILE *          xfp);
@@ -226,7 +250,7 @@ extern "C"
 	 *
 	 *  \return       Number of unsigned characters written
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_uchar(unsigned char *   ptr,
 						int               ndata,
 						XDRFILE *         xfp);
@@ -241,7 +265,7 @@ extern "C"
 	 *
 	 *  \return       Number of shorts read
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_short(short *             ptr,
 					   int                 ndata,
 					   XDRFILE *           xfp);
@@ -256,7 +280,7 @@ extern "C"
 	 *
 	 *  \return       Number of shorts written
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_short(short *            ptr,
 						int                ndata,
 						XDRFILE *          xfp);
@@ -271,7 +295,7 @@ extern "C"
 	 *
 	 *  \return       Number of unsigned shorts read
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_ushort(unsigned short *   ptr,
 						int                ndata,
 						XDRFILE *          xfp);
@@ -286,7 +310,7 @@ extern "C"
 	 *
 	 *  \return       Number of unsigned shorts written
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_ushort(unsigned short *     ptr,
 						 int                  ndata,
 						 XDRFILE *            xfp);
@@ -308,7 +332,7 @@ extern "C"
 	 *
 	 *  Split your 64-bit data into two 32-bit integers for portability!
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_int(int *         ptr,
 					 int           ndata,
 					 XDRFILE *     xfp);
@@ -331,7 +355,7 @@ extern "C"
 	 *
 	 *  Split your 64-bit data into two 32-bit integers for portability!
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_int(int *        ptr,
 					  int          ndata,
 					  XDRFILE *    xfp);
@@ -352,7 +376,7 @@ extern "C"
 	 *
 	 *  Split your 64-bit data into two 32-bit integers for portability!
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_uint(unsigned int *    ptr,
 					  int               ndata,
 					  XDRFILE *         xfp);
@@ -375,7 +399,7 @@ extern "C"
 	 *
 	 *  Split your 64-bit data into two 32-bit integers for portability!
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_uint(unsigned int *    ptr,
 					   int               ndata,
 					   XDRFILE *         xfp);
@@ -390,7 +414,7 @@ extern "C"
 	 *
 	 *  \return       Number of floats read
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_float(float *           ptr,
 					   int               ndata,
 					   XDRFILE *         xfp);
@@ -405,7 +429,7 @@ extern "C"
 	 *
 	 *  \return       Number of floats written
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_float(float *          ptr,
 						int              ndata,
 						XDRFILE *        xfp);
@@ -420,7 +444,7 @@ extern "C"
 	 *
 	 *  \return       Number of doubles read
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_double(double *          ptr,
 						int               ndata,
 						XDRFILE *         xfp);
@@ -435,7 +459,7 @@ extern "C"
 	 *
 	 *  \return       Number of doubles written
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_double(double *        ptr,
 						 int             ndata,
 						 XDRFILE *       xfp);
@@ -451,7 +475,7 @@ extern "C"
 	 *
 	 *  \return        Number of characters read, including end-of-string
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_string(char *          ptr,
 						int             maxlen,
 						XDRFILE *       xfp);
@@ -465,7 +489,7 @@ extern "C"
 	 *
 	 *  \return        Number of characters written, including end-of-string
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_string(char *          ptr,
 						 XDRFILE *       xfp);
 
@@ -479,7 +503,7 @@ extern "C"
 	 *
 	 *  \return        Number of bytes read from file
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_read_opaque(char *             ptr,
 						int                nbytes,
 						XDRFILE *          xfp);
@@ -495,7 +519,7 @@ extern "C"
 	 *
 	 *  \return        Number of bytes written to file
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_write_opaque(char *            ptr,
 						 int               nbytes,
 						 XDRFILE *         xfp);
@@ -533,7 +557,7 @@ extern "C"
 	 *                    and very complicated, so you will need this xdrfile module
 	 *                    to read it later.
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_compress_coord_float(float *     ptr,
 								 int         ncoord,
 								 float       precision,
@@ -571,7 +595,7 @@ extern "C"
 	 *                    just before the compressed coordinate data, so you can
 	 *                    read it first and allocated enough memory.
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_decompress_coord_float(float *     ptr,
 								   int *	   ncoord,
 								   float *     precision,
@@ -610,7 +634,7 @@ extern "C"
 	 *                    and very complicated, so you will need this xdrfile module
 	 *                    to read it later.
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_compress_coord_double(double *     ptr,
 								  int          ncoord,
 								  double       precision,
@@ -650,7 +674,7 @@ extern "C"
 	 *                    just before the compressed coordinate data, so you can
 	 *                    read it first and allocated enough memory.
 	 */
-	int
+	XDRFILE_EXPORT int
 	xdrfile_decompress_coord_double(double *     ptr,
 									int *	     ncoord,
 									double *     precision,
@@ -25,14 +25,14 @@ extern "C" {
    */  
    
   /* This function returns the number of atoms in the xtc file in *natoms */
-  extern int read_xtc_natoms(char *fn,int *natoms);
+  extern XDRFILE_EXPORT int read_xtc_natoms(char *fn,int *natoms);
   
   /* Read one frame of an open xtc file */
-  extern int read_xtc(XDRFILE *xd,int natoms,int *step,float *time,
+  extern XDRFILE_EXPORT int read_xtc(XDRFILE *xd,int natoms,int *step,float *time,
 		      matrix box,rvec *x,float *prec);
   
   /* Write a frame to xtc file */
-  extern int write_xtc(XDRFILE *xd,
+  extern XDRFILE_EXPORT int write_xtc(XDRFILE *xd,
 		       int natoms,int step,float time,
 		       matrix box,rvec *x,float prec);
   
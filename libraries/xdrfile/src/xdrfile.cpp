@@ -50,7 +50,7 @@ static void * condfree( void*p) {
 #  include <rpc/xdr.h>
 #endif
 
-#include "xdrfile.h"
+#include "xdrfile/xdrfile.h"
 
 /* Default FORTRAN name mangling is: lower case name, append underscore */
 #ifndef F77_FUNC
@@ -190,6 +190,31 @@ xdrfile_open(const char *path, const char *mode)
 	return xfp;
 }
 
+XDRFILE *
+xdrfile_tmpfile(void)
+{
+	XDRFILE *xfp;
+
+	if((xfp=(XDRFILE *)malloc(sizeof(XDRFILE)))==NULL)
+		return NULL;
+	if((xfp->fp=tmpfile())==NULL)
+    {
+		xfp=(XDRFILE *)condfree(xfp);
+		return NULL;
+	}
+	if((xfp->xdr=(XDR *)malloc(sizeof(XDR)))==NULL)
+    {
+		fclose(xfp->fp);
+		xfp=(XDRFILE *)condfree(xfp);
+		return NULL;
+	}
+	xfp->mode='w';
+	xdrstdio_create((XDR *)(xfp->xdr),xfp->fp,XDR_ENCODE);
+	xfp->buf1 = xfp->buf2 = NULL;
+	xfp->buf1size = xfp->buf2size = 0;
+	return xfp;
+}
+
 int
 xdrfile_close(XDRFILE *xfp)
 {
@@ -2293,7 +2318,12 @@ static int
 xdr_opaque (XDR *xdrs, char *cp, unsigned int cnt)
 {
 	unsigned int rndup;
-	static char crud[BYTES_PER_XDR_UNIT];
+	/* Frames may be decoded on several threads at once, so the scratch space must not be shared. */
+#ifdef __APPLE__
+	static __thread char crud[BYTES_PER_XDR_UNIT];
+#else
+	thread_local char crud[BYTES_PER_XDR_UNIT];
+#endif
 
 	/*
 	 * if no data we are done
@@ -12,8 +12,8 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include "xdrfile.h"
-#include "xdrfile_xtc.h"
+#include "xdrfile/xdrfile.h"
+#include "xdrfile/xdrfile_xtc.h"
 
 #define MAGIC 1995
 enum { FALSE, TRUE };
@@ -43,6 +43,7 @@ class Context;
 class ContextImpl;
 class Kernel;
 class KernelFactory;
+class System;
 
 /**
  * A Platform defines an implementation of all the kernels needed to perform some calculation.
@@ -106,6 +107,33 @@ public:
      * @param value       the value to set for the property
      */
     virtual void setPropertyValue(Context& context, const std::string& property, const std::string& value) const;
+    /**
+     * Get the amount of device memory (in bytes) a Context is using, broken down by what it is used for.
+     * Platforms that run on a GPU report the memory used by arrays in the categories "Context" (positions,
+     * velocities, forces, and energies), "Integration", "Nonbonded", "Neighbor List", "PME" (including
+     * FFT work areas), and "Forces" (everything else, mostly parameters for individual Forces).  The
+     * element "Total" is the sum over all categories, and "Peak" is the largest total there has been since
+     * the Context was created.  If the Context uses multiple devices, the values are summed over them.
+     * The CUDA platform allocates arrays from a memory pool when the device supports it, and also reports
+     * "Memory Pool": the memory the pool currently holds, including freed memory kept for reuse.  It is
+     * shared with other Contexts on the same device and is not included in "Total".
+     * Platforms that keep all their data in host memory return an empty map.
+     *
+     * @param context     the Context to get the memory usage of
+     */
+    virtual std::map<std::string, double> getMemoryUsage(const Context& context) const;
+    /**
+     * Estimate how much device memory (in bytes) a Context for a System will use, without creating it.
+     * The result has the same categories as getMemoryUsage() (except "Peak"), and is useful for deciding
+     * how many Contexts can share a device.  It covers the large data structures whose size depends on the
+     * System, and assumes a stochastic integrator; small per-Force arrays are not included.  Platforms that
+     * keep all their data in host memory return an empty map.
+     *
+     * @param system      the System to estimate the memory for
+     * @param properties  values for Platform specific properties that will be used when creating the Context.
+     *                    Properties that are not specified take their default values.
+     */
+    virtual std::map<std::string, double> estimateMemoryUsage(const System& system, const std::map<std::string, std::string>& properties=std::map<std::string, std::string>()) const;
     /**
      * Get the default value of a Platform-specific property.  This is the value that will be used for
      * newly created Contexts.
@@ -226,6 +254,10 @@ public:
      * for each one.  If an error occurs while trying to load a particular file, that file is simply
      * ignored. You can retrieve a list of all such errors by calling getPluginLoadFailures().
      *
+     * If the environment variable OPENMM_PLUGIN_EXCLUDE is set to a comma separated list of strings, any file
+     * whose name contains one of them (ignoring case) is skipped.  For example, setting it to "CUDA,OpenCL"
+     * avoids loading the GPU platforms and the plugins that depend on them, along with their runtime libraries.
+     *
      * @param directory    a ':' (unix) or ';' (windows) deliminated list of paths containing libraries to load
      * @return the names of all files which were successfully loaded as libraries
      */
@@ -49,6 +49,7 @@
 #include "openmm/CustomNonbondedForce.h"
 #include "openmm/CustomManyParticleForce.h"
 #include "openmm/CustomTorsionForce.h"
+#include "openmm/ExternalForce.h"
 #include "openmm/GayBerneForce.h"
 #include "openmm/GBSAOBCForce.h"
 #include "openmm/HarmonicAngleForce.h"
@@ -56,6 +57,7 @@
 #include "openmm/KernelImpl.h"
 #include "openmm/LangevinIntegrator.h"
 #include "openmm/MonteCarloBarostat.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/PeriodicTorsionForce.h"
 #include "openmm/RBTorsionForce.h"
 #include "openmm/RMSDForce.h"
@@ -67,6 +69,7 @@
 #include "openmm/NoseHooverIntegrator.h"
 #include "openmm/NoseHooverChain.h"
 #include <iosfwd>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -116,6 +119,23 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     virtual double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid) = 0;
+    /**
+     * Wait until all calculations that have been queued for this context have completed.  This is used
+     * when profiling, so the time spent in each part of the computation can be measured.  Platforms that
+     * do all their work synchronously can simply return.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    virtual void synchronize(ContextImpl& context) = 0;
+    /**
+     * Get statistics describing the neighbor list used for nonbonded interactions.  See
+     * Context::getNeighborListStatistics() for the values that may be reported.  Platforms
+     * that do not use a neighbor list can leave the map empty.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    virtual void getNeighborListStatistics(ContextImpl& context, std::map<std::string, double>& statistics) = 0;
 };
 
 /**
@@ -166,6 +186,14 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     virtual void getPositions(ContextImpl& context, std::vector<Vec3>& positions) = 0;
+    /**
+     * Get the positions of a subset of the particles.  Only the requested particles need to be retrieved,
+     * which can be much faster than getPositions() when the subset is small.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, this contains the positions of the requested particles in the same order as particles
+     */
+    virtual void getPositionSubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions) = 0;
     /**
      * Set the positions of all particles.
      *
@@ -178,6 +206,14 @@ public:
      * @param velocities  on exit, this contains the particle velocities
      */
     virtual void getVelocities(ContextImpl& context, std::vector<Vec3>& velocities) = 0;
+    /**
+     * Get the velocities of a subset of the particles.  Only the requested particles need to be retrieved,
+     * which can be much faster than getVelocities() when the subset is small.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, this contains the velocities of the requested particles in the same order as particles
+     */
+    virtual void getVelocitySubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities) = 0;
     /**
      * Set the velocities of all particles.
      *
@@ -324,6 +360,18 @@ public:
      * @param force      the HarmonicBondForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const HarmonicBondForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context for a contiguous range of bonds.  The default
+     * implementation copies the parameters of all bonds.
+     *
+     * @param context     the context to copy parameters to
+     * @param force       the HarmonicBondForce to copy the parameters from
+     * @param firstBond   the index of the first bond whose parameters have changed
+     * @param numChanged  the number of consecutive bonds whose parameters have changed
+     */
+    virtual void copySomeParametersToContext(ContextImpl& context, const HarmonicBondForce& force, int firstBond, int numChanged) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
@@ -359,6 +407,18 @@ public:
      * @param force      the CustomBondForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const CustomBondForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context for a contiguous range of bonds.  The default
+     * implementation copies the parameters of all bonds.
+     *
+     * @param context     the context to copy parameters to
+     * @param force       the CustomBondForce to copy the parameters from
+     * @param firstBond   the index of the first bond whose parameters have changed
+     * @param numChanged  the number of consecutive bonds whose parameters have changed
+     */
+    virtual void copySomeParametersToContext(ContextImpl& context, const CustomBondForce& force, int firstBond, int numChanged) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
@@ -394,6 +454,18 @@ public:
      * @param force      the HarmonicAngleForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const HarmonicAngleForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context for a contiguous range of angles.  The default
+     * implementation copies the parameters of all angles.
+     *
+     * @param context     the context to copy parameters to
+     * @param force       the HarmonicAngleForce to copy the parameters from
+     * @param firstAngle  the index of the first angle whose parameters have changed
+     * @param numChanged  the number of consecutive angles whose parameters have changed
+     */
+    virtual void copySomeParametersToContext(ContextImpl& context, const HarmonicAngleForce& force, int firstAngle, int numChanged) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
@@ -464,6 +536,18 @@ public:
      * @param force      the PeriodicTorsionForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const PeriodicTorsionForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context for a contiguous range of torsions.  The default
+     * implementation copies the parameters of all torsions.
+     *
+     * @param context       the context to copy parameters to
+     * @param force         the PeriodicTorsionForce to copy the parameters from
+     * @param firstTorsion  the index of the first torsion whose parameters have changed
+     * @param numChanged    the number of consecutive torsions whose parameters have changed
+     */
+    virtual void copySomeParametersToContext(ContextImpl& context, const PeriodicTorsionForce& force, int firstTorsion, int numChanged) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
@@ -672,6 +756,18 @@ public:
      * @param force      the CustomNonbondedForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const CustomNonbondedForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context for a contiguous range of particles.  The default
+     * implementation copies the parameters of all particles.
+     *
+     * @param context        the context to copy parameters to
+     * @param force          the CustomNonbondedForce to copy the parameters from
+     * @param firstParticle  the index of the first particle whose parameters have changed
+     * @param numChanged     the number of consecutive particles whose parameters have changed
+     */
+    virtual void copySomeParametersToContext(ContextImpl& context, const CustomNonbondedForce& force, int firstParticle, int numChanged) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
@@ -782,6 +878,18 @@ public:
      * @param force      the CustomExternalForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const CustomExternalForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context for a contiguous range of particles.  The default
+     * implementation copies the parameters of all particles.
+     *
+     * @param context        the context to copy parameters to
+     * @param force          the CustomExternalForce to copy the parameters from
+     * @param firstParticle  the index of the first particle whose parameters have changed
+     * @param numChanged     the number of consecutive particles whose parameters have changed
+     */
+    virtual void copySomeParametersToContext(ContextImpl& context, const CustomExternalForce& force, int firstParticle, int numChanged) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
@@ -1048,6 +1156,34 @@ public:
     virtual void copyParametersToContext(ContextImpl& context, const RMSDForce& force) = 0;
 };
 
+/**
+ * This kernel is invoked by ExternalForce to calculate the forces acting on the system and the energy of the system.
+ */
+class CalcExternalForceKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "CalcExternalForce";
+    }
+    CalcExternalForceKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param force      the ExternalForce this kernel will be used for
+     */
+    virtual void initialize(const System& system, const ExternalForce& force) = 0;
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    virtual double execute(ContextImpl& context, bool includeForces, bool includeEnergy) = 0;
+};
+
 /**
  * This kernel is invoked by VerletIntegrator to take one time step.
  */
@@ -1241,6 +1377,58 @@ public:
     virtual double computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) = 0;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.  Each step is made up of
+ * velocity updates using the forces from particular groups, and position updates over the innermost
+ * substep.  The integrator computes the forces before each velocity update.
+ */
+class IntegrateMTSLangevinStepKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "IntegrateMTSLangevinStep";
+    }
+    IntegrateMTSLangevinStepKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    virtual void initialize(const System& system, const MTSLangevinIntegrator& integrator) = 0;
+    /**
+     * Update the velocities based on the most recently computed forces.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the time interval over which to apply the forces
+     */
+    virtual void updateVelocities(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) = 0;
+    /**
+     * Advance the positions by half a substep, interact with the heat bath, advance them by another half
+     * substep, and then apply constraints to the positions and velocities.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the size of the substep
+     */
+    virtual void updatePositions(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) = 0;
+    /**
+     * Apply constraints to the velocities at the end of a time step, and advance the time and step count.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    virtual void finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator) = 0;
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    virtual double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) = 0;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -1292,14 +1480,17 @@ public:
      */
     virtual void initialize(const System& system, const VariableLangevinIntegrator& integrator) = 0;
     /**
-     * Execute the kernel.
+     * Execute the kernel.  This advances the simulation by up to maxSteps time steps, stopping early once
+     * maxTime is reached.  The kernel is responsible for computing forces before each step, which allows
+     * a platform to take many steps without synchronizing with the host after each one.
      *
      * @param context    the context in which to execute this kernel
      * @param integrator the VariableLangevinIntegrator this kernel is being used for
      * @param maxTime    the maximum time beyond which the simulation should not be advanced
-     * @return the size of the step that was taken
+     * @param maxSteps   the maximum number of steps to take
+     * @return the size of the last step that was taken
      */
-    virtual double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) = 0;
+    virtual double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime, int maxSteps) = 0;
     /**
      * Compute the kinetic energy.
      * 
@@ -1327,14 +1518,17 @@ public:
      */
     virtual void initialize(const System& system, const VariableVerletIntegrator& integrator) = 0;
     /**
-     * Execute the kernel.
+     * Execute the kernel.  This advances the simulation by up to maxSteps time steps, stopping early once
+     * maxTime is reached.  The kernel is responsible for computing forces before each step, which allows
+     * a platform to take many steps without synchronizing with the host after each one.
      *
      * @param context    the context in which to execute this kernel
      * @param integrator the VariableVerletIntegrator this kernel is being used for
      * @param maxTime    the maximum time beyond which the simulation should not be advanced
-     * @return the size of the step that was taken
+     * @param maxSteps   the maximum number of steps to take
+     * @return the size of the last step that was taken
      */
-    virtual double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime) = 0;
+    virtual double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime, int maxSteps) = 0;
     /**
      * Compute the kinetic energy.
      * 
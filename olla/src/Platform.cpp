@@ -47,6 +47,7 @@
 #include <sstream>
 #include <set>
 #include <algorithm>
+#include <cctype>
 
 #include "ReferencePlatform.h"
 
@@ -89,6 +90,14 @@ void Platform::setPropertyValue(Context& context, const string& property, const
     throw OpenMMException("setPropertyValue: Illegal property name");
 }
 
+map<string, double> Platform::getMemoryUsage(const Context& context) const {
+    return map<string, double>();
+}
+
+map<string, double> Platform::estimateMemoryUsage(const System& system, const map<string, string>& properties) const {
+    return map<string, double>();
+}
+
 const string& Platform::getPropertyDefaultValue(const string& property) const {
     string propertyName = property;
     if (deprecatedPropertyReplacements.find(property) != deprecatedPropertyReplacements.end())
@@ -307,6 +316,31 @@ vector<string> Platform::loadPluginsFromDirectory(const string& directory) {
     pluginLoadFailures.resize(0);
     std::sort (files.begin(), files.end(), stringLengthComparator);
 
+    // Skip any plugins excluded by OPENMM_PLUGIN_EXCLUDE.  This avoids loading GPU runtimes (and initializing
+    // their drivers) in processes that never use them.
+
+    char* excludeVariable = getenv("OPENMM_PLUGIN_EXCLUDE");
+    if (excludeVariable != NULL) {
+        vector<string> excluded;
+        stringstream excludeList(excludeVariable);
+        for (string name; std::getline(excludeList, name, ',');)
+            if (!name.empty()) {
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                excluded.push_back(name);
+            }
+        vector<string> included;
+        for (string& file : files) {
+            string name = file.substr(file.find_last_of(dirSeparator)+1);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            bool skip = false;
+            for (string& pattern : excluded)
+                skip |= (name.find(pattern) != string::npos);
+            if (!skip)
+                included.push_back(file);
+        }
+        files = included;
+    }
+
     for (unsigned int i = 0; i < files.size(); ++i) {
         try {
             plugins.push_back(loadOneLibrary(files[i]));
@@ -33,8 +33,10 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/AndersenThermostat.h"
+#include "openmm/Autotuner.h"
 #include "openmm/BrownianIntegrator.h"
 #include "openmm/CMAPTorsionForce.h"
+#include "openmm/CheckpointCompressor.h"
 #include "openmm/CMMotionRemover.h"
 #include "openmm/CompoundIntegrator.h"
 #include "openmm/CustomBondForce.h"
@@ -49,7 +51,11 @@
 #include "openmm/CustomIntegrator.h"
 #include "openmm/CustomManyParticleForce.h"
 #include "openmm/CustomNonbondedForce.h"
+#include "openmm/ExternalForce.h"
+#include "openmm/FIREMinimizer.h"
 #include "openmm/Force.h"
+#include "openmm/ForceValidator.h"
+#include "openmm/GridPotentialBuilder.h"
 #include "openmm/GayBerneForce.h"
 #include "openmm/GBSAOBCForce.h"
 #include "openmm/HarmonicAngleForce.h"
@@ -62,15 +68,20 @@
 #include "openmm/MonteCarloBarostat.h"
 #include "openmm/MonteCarloFlexibleBarostat.h"
 #include "openmm/MonteCarloMembraneBarostat.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
+#include "openmm/ParticleActivator.h"
 #include "openmm/PeriodicTorsionForce.h"
 #include "openmm/RBTorsionForce.h"
 #include "openmm/RMSDForce.h"
 #include "openmm/State.h"
+#include "openmm/StatePublisher.h"
 #include "openmm/System.h"
 #include "openmm/TabulatedFunction.h"
+#include "openmm/TelemetryCallback.h"
+#include "openmm/TrajectoryWriter.h"
 #include "openmm/Units.h"
 #include "openmm/VariableLangevinIntegrator.h"
 #include "openmm/VariableVerletIntegrator.h"
@@ -80,6 +91,7 @@
 #include "openmm/NoseHooverChain.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/Platform.h"
+#include "openmm/serialization/BinarySerializer.h"
 #include "openmm/serialization/XmlSerializer.h"
 
 #endif /*OPENMM_H_*/
@@ -0,0 +1,163 @@
+#ifndef OPENMM_AUTOTUNER_H_
+#define OPENMM_AUTOTUNER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "Integrator.h"
+#include "openmm/Platform.h"
+#include "System.h"
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * An Autotuner chooses values for Platform-specific properties by trying them out.  For each
+ * property you want it to tune, call addCandidates() with the values to consider.  Then call
+ * createContext() in place of creating a Context directly.  It creates a series of trial Contexts
+ * for the System, each using a copy of the Integrator, and times how long each one takes to run
+ * a fixed number of steps.  It then creates and returns a Context that uses the fastest
+ * configuration.
+ *
+ * Properties are tuned one at a time, in the order they were added.  Each one starts out at the
+ * first candidate value, which should be the most accurate one (for example, "mixed" before
+ * "single" for the Precision property of the CUDA platform).  The forces computed with that
+ * initial configuration serve as the reference for the accuracy constraint: a configuration is
+ * only accepted if the RMS difference between its forces and the reference forces, divided by
+ * the RMS of the reference forces, is no larger than the force tolerance.  Configurations that
+ * cannot be created or that fail while running are skipped.
+ *
+ * Tuning takes time, so the choice is saved in a cache file and reused the next time the same
+ * System and Integrator are simulated with the same candidates on the same hardware.  The cache
+ * key is a hash of the serialized System and Integrator, the candidate values, the fixed
+ * properties, and the values of all the Platform's other properties in the initial trial Context.
+ * The last of these identify the hardware, for example through the CUDA platform's DeviceName
+ * property or the CPU platform's default number of threads.  Cache files are stored in the
+ * directory given by the OPENMM_CACHE_DIR environment variable, or the temporary directory if it
+ * is not set.
+ *
+ * After createContext() returns, getSelectedProperties() tells which values were chosen, and
+ * getReport() describes every configuration that was tried.
+ */
+
+class OPENMM_EXPORT Autotuner {
+public:
+    /**
+     * Create an Autotuner.
+     *
+     * @param platform    the Platform to create Contexts for
+     * @param properties  Platform-specific properties that should always be used and are not tuned
+     */
+    Autotuner(Platform& platform, const std::map<std::string, std::string>& properties=std::map<std::string, std::string>());
+    /**
+     * Get the Platform Contexts are created for.
+     */
+    Platform& getPlatform();
+    /**
+     * Add a property to tune, along with the values to consider for it.
+     *
+     * @param property    the name of the Platform-specific property
+     * @param values      the values to try.  The first one is used when tuning the properties that were
+     *                    added before this one, and as the reference for the accuracy constraint.
+     */
+    void addCandidates(const std::string& property, const std::vector<std::string>& values);
+    /**
+     * Get the number of steps to time for each configuration.  The default is 200.
+     */
+    int getNumSteps() const;
+    /**
+     * Set the number of steps to time for each configuration.  A few additional steps are taken before
+     * timing starts, so the time to compile kernels and build data structures is not included.
+     */
+    void setNumSteps(int steps);
+    /**
+     * Get the largest relative RMS force error compared to the reference configuration that is allowed.
+     * The default is 1e-4.
+     */
+    double getForceTolerance() const;
+    /**
+     * Set the largest relative RMS force error compared to the reference configuration that is allowed.
+     */
+    void setForceTolerance(double tolerance);
+    /**
+     * Get whether results are saved to and loaded from the cache.  The default is true.
+     */
+    bool getUseCache() const;
+    /**
+     * Set whether results are saved to and loaded from the cache.
+     */
+    void setUseCache(bool use);
+    /**
+     * Select the values of the properties being tuned, and create a Context that uses them.
+     * The caller is responsible for deleting the Context.
+     *
+     * @param system      the System to simulate
+     * @param integrator  the Integrator to use for the Context.  A copy of it is used for each trial.
+     * @param positions   the initial positions of the particles (measured in nm).  They are used
+     *                    for the trials, and the returned Context has them set.
+     */
+    Context* createContext(const System& system, Integrator& integrator, const std::vector<Vec3>& positions);
+    /**
+     * Get the values of all Platform-specific properties that were passed to the most recent Context
+     * created by createContext().  This includes both the fixed properties and the tuned ones.
+     */
+    const std::map<std::string, std::string>& getSelectedProperties() const;
+    /**
+     * Get a human readable description of how the most recent configuration was chosen.  It lists the
+     * time per step and force error of each configuration that was tried, or states that the choice was
+     * loaded from the cache.
+     */
+    const std::string& getReport() const;
+    /**
+     * Get whether the configuration chosen by the most recent call to createContext() was loaded from
+     * the cache.
+     */
+    bool getLoadedFromCache() const;
+private:
+    struct Trial;
+    Trial runTrial(Context& context, Integrator& integrator, const std::vector<Vec3>& positions, const std::vector<Vec3>* referenceForces);
+    std::string getCacheFile(const std::string& key) const;
+    Platform& platform;
+    std::map<std::string, std::string> fixedProperties, selectedProperties;
+    std::vector<std::pair<std::string, std::vector<std::string> > > candidates;
+    int numSteps;
+    double forceTolerance;
+    bool useCache, loadedFromCache;
+    std::string report;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_AUTOTUNER_H_*/
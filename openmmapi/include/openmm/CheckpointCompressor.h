@@ -0,0 +1,89 @@
+#ifndef OPENMM_CHECKPOINTCOMPRESSOR_H_
+#define OPENMM_CHECKPOINTCOMPRESSOR_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "internal/windowsExport.h"
+#include <string>
+
+namespace OpenMM {
+
+/**
+ * This class losslessly compresses checkpoints created by Context::createCheckpoint().
+ * A checkpoint consists mostly of arrays of floating point numbers, so the bytes are
+ * first regrouped by their position within each 8 byte word.  This puts the sign and
+ * exponent bytes, which vary slowly, next to each other where they can be encoded
+ * compactly.
+ *
+ * A checkpoint can optionally be stored as a delta relative to an earlier checkpoint
+ * from the same Context.  When checkpoints are written frequently, most of the data
+ * changes little between them, and the delta is much smaller than the full checkpoint.
+ * To restore a delta you must provide the same previous checkpoint it was created from.
+ *
+ * Compression is a pure function of its inputs, so it is safe to call it from a
+ * background thread.  To write checkpoints without stalling the simulation, call
+ * createCheckpoint() into a std::stringstream, which is quick, then compress and write
+ * the resulting string on a separate thread while the simulation continues.
+ *
+ * A compressed checkpoint that is not a delta can be passed directly to
+ * Context::loadCheckpoint(), which recognizes it and decompresses it automatically.
+ */
+
+class OPENMM_EXPORT CheckpointCompressor {
+public:
+    /**
+     * Compress a checkpoint.
+     *
+     * @param checkpoint   the checkpoint data, as written by Context::createCheckpoint()
+     * @param previous     an earlier checkpoint to encode the new one relative to.  If this
+     *                     is empty, a self contained compressed checkpoint is created.
+     * @return the compressed data
+     */
+    static std::string compress(const std::string& checkpoint, const std::string& previous="");
+    /**
+     * Decompress a checkpoint that was created by compress().
+     *
+     * @param data         the compressed data
+     * @param previous     if the data was compressed as a delta, this must be the same
+     *                     previous checkpoint that was passed to compress()
+     * @return the original checkpoint data
+     */
+    static std::string decompress(const std::string& data, const std::string& previous="");
+    /**
+     * Get whether a block of data is a compressed checkpoint created by compress().
+     */
+    static bool isCompressed(const std::string& data);
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CHECKPOINTCOMPRESSOR_H_*/
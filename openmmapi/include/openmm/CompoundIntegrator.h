@@ -82,6 +82,14 @@ namespace OpenMM {
  * integrator, you must first adjust the velocities to avoid introducing error.  This is also
  * true when switching between two leapfrog integrators that use different step sizes,
  * since they will interpret the velocities as corresponding to different times.
+ *
+ * Switching integrators is inexpensive.  setCurrentIntegrator() only records which one is
+ * active, and nothing is copied to or from the Context.  Each Integrator keeps its own
+ * state, such as the global and per-DOF variables of a CustomIntegrator, unchanged while
+ * other Integrators are in use.  The only state that is shared is the state of the Context
+ * itself.  When an Integrator takes a step after a different one was used, it is told that
+ * the positions and velocities have changed.  Any forces it cached are then recomputed,
+ * but nothing else is invalidated.
  */
 
 class OPENMM_EXPORT CompoundIntegrator : public Integrator {
@@ -122,7 +130,8 @@ public:
      */
     int getCurrentIntegrator() const;
     /**
-     * Set the current Integrator.
+     * Set the current Integrator.  This does not modify the state of the Context or of any
+     * Integrator, so it is inexpensive to switch often.
      * 
      * @param index    the index of the Integrator to use
      */
@@ -227,7 +236,7 @@ protected:
      */
     void deserializeParameters(const SerializationNode& node);
 private:
-    int currentIntegrator;
+    int currentIntegrator, lastStepIntegrator;
     std::vector<Integrator*> integrators;
 };
 
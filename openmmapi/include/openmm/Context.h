@@ -47,6 +47,7 @@ namespace OpenMM {
 class ContextImpl;
 class Vec3;
 class Platform;
+class TelemetryCallback;
 
 /**
  * A Context stores the complete state of a simulation.  More specifically, it includes:
@@ -125,6 +126,148 @@ public:
      * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
      */
     State getState(int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Get a State object recording the current state information for a subset of the particles.  Positions,
+     * velocities, and forces are only stored for the requested particles, in the order they are listed.  Only
+     * those particles are retrieved from the Platform, so this is much faster than the other form of getState()
+     * when you only need information about a small part of a large System.
+     *
+     * @param types the set of data types which should be stored in the State object.  This
+     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).
+     * @param particles the indices of the particles whose positions, velocities, and forces should be stored
+     * @param enforcePeriodicBox if false, the position of each particle will be whatever position
+     * is stored in the Context, regardless of periodic boundary conditions.  If true, particle
+     * positions will be translated so the center of every molecule lies in the same periodic box.
+     * The center is computed over the whole molecule, even if only some of its particles are requested.
+     * @param groups a set of bit flags for which force groups to include when computing forces
+     * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+     */
+    State getState(int types, const std::vector<int>& particles, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Compute the potential energy of many configurations.  This is equivalent to calling setPositions()
+     * and getState(State::Energy) for each one, but it is faster because forces are not computed and no
+     * State objects are created.  When it returns, the positions are restored to the values they had
+     * before it was called.
+     *
+     * @param frames  the configurations to evaluate.  Each element contains the positions of all particles
+     *                in the System (measured in nm).
+     * @param groups  a set of bit flags for which force groups to include.  Group i will be included if
+     *                (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return the potential energy of each configuration (measured in kJ/mol)
+     */
+    std::vector<double> computeEnergies(const std::vector<std::vector<Vec3> >& frames, int groups=0xFFFFFFFF);
+    /**
+     * Compute the potential energy of many configurations, each evaluated with several sets of values
+     * for adjustable parameters.  This is useful for reweighting methods such as MBAR.  Each configuration
+     * is only set once, and then evaluated with every parameter set.  Force groups that contain no Force
+     * depending on any of the parameters are evaluated only once per configuration.  When it returns, the
+     * positions and parameters are restored to the values they had before it was called.
+     *
+     * @param frames         the configurations to evaluate.  Each element contains the positions of all
+     *                       particles in the System (measured in nm).
+     * @param parameterSets  the parameter values to evaluate each configuration with.  Each element maps
+     *                       parameter names to values.  Parameters not included in a set keep their current values.
+     * @param groups         a set of bit flags for which force groups to include.  Group i will be included if
+     *                       (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return the potential energies (measured in kJ/mol).  Element [i][j] is the energy of configuration i
+     * with parameter set j.
+     */
+    std::vector<std::vector<double> > computeEnergies(const std::vector<std::vector<Vec3> >& frames,
+            const std::vector<std::map<std::string, double> >& parameterSets, int groups=0xFFFFFFFF);
+    /**
+     * Compute the potential energy of each force group for the current positions.  This gives the same
+     * results as calling getState(State::Energy, false, 1<<i) for each group i, but on platforms where every
+     * Force reports its own energy (such as Reference and CPU), all the groups are evaluated in a single pass.
+     *
+     * @param groups   a set of bit flags for which force groups to include.  Group i will be included if
+     *                 (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return a vector of length 32.  Element i is the potential energy of force group i (measured in kJ/mol),
+     * or 0 if that group was not included.
+     */
+    std::vector<double> computeEnergiesByGroup(int groups=0xFFFFFFFF);
+    /**
+     * Set whether to measure how much time is spent on each part of the force computation.  While this
+     * is enabled, every force and energy computation records the time spent in each Force, which can be
+     * retrieved with getProfile().  On platforms that compute asynchronously, such as CUDA and OpenCL,
+     * the Context waits for each Force to finish before starting the next one.  This makes the times
+     * meaningful, but it also slows down the simulation, so profiling should only be enabled while tuning.
+     */
+    void setProfilingEnabled(bool enabled);
+    /**
+     * Get whether the time spent on each part of the force computation is being measured.
+     */
+    bool getProfilingEnabled() const;
+    /**
+     * Set whether getState() may reuse forces and energies computed earlier.  When this is enabled (the
+     * default), the Context remembers the most recent force computation.  If positions, parameters, box
+     * vectors, and the step count are all unchanged since then, and the same force groups are requested,
+     * the previous results are returned instead of being computed again.  Results are never reused if
+     * they include an ExternalForce, since its Computation may depend on state outside the Context.
+     * Disable caching when timing force computations, or if a plugin modifies the Context's state in a
+     * way the Context cannot detect.
+     */
+    void setForceCachingEnabled(bool enabled);
+    /**
+     * Get whether getState() may reuse forces and energies computed earlier.
+     */
+    bool getForceCachingEnabled() const;
+    /**
+     * Get the total time (in seconds) spent on each part of the force computation since profiling was
+     * enabled, or since resetProfile() was last called.  Each Force is listed under its name (see
+     * Force::getName()), so Forces with the same name are reported together.  Work the platform does
+     * before and after evaluating the individual Forces, such as clearing and summing force buffers, is
+     * listed under "Begin Computation" and "Finish Computation".
+     */
+    std::map<std::string, double> getProfile() const;
+    /**
+     * Discard all times recorded so far by profiling.
+     */
+    void resetProfile();
+    /**
+     * Get statistics describing the neighbor list the Platform uses for nonbonded interactions.  These
+     * are meant for choosing the cutoff and neighbor list padding for a particular system.  Counts are
+     * accumulated from when the Context was created, while the sizes describe the neighbor list as it
+     * currently is.  Each Platform reports the values that apply to it, which may include the following.
+     *
+     * <ul>
+     * <li>"Neighbor List Checks": the number of times the Platform checked whether the neighbor list needed to be rebuilt</li>
+     * <li>"Neighbor List Builds": the number of times the neighbor list was rebuilt</li>
+     * <li>"Neighbor List Build Frequency": the fraction of checks that led to the neighbor list being rebuilt</li>
+     * <li>"Neighbor List Patches": the number of times the neighbor list was updated in place to account for a few atoms that moved</li>
+     * <li>"Neighbor List Reallocations": the number of times the neighbor list overflowed and had to be reallocated with a larger size</li>
+     * <li>"Atom Reorders": the number of times atoms were reordered to keep nearby atoms together in memory</li>
+     * <li>"Interacting Tiles" or "Interacting Blocks": the number of tiles or blocks of atoms in the neighbor list</li>
+     * <li>"Single Pairs": the number of interactions computed individually rather than as part of a tile</li>
+     * <li>"Neighbor List Pairs": the number of atom pairs the tiles or blocks contain</li>
+     * <li>"Pairs Within Cutoff": how many of those pairs are currently closer than the cutoff distance</li>
+     * <li>"Useful Pair Fraction": the fraction of pairs in the neighbor list that are within the cutoff</li>
+     * </ul>
+     *
+     * The Reference platform does not report any statistics.  On GPU platforms this downloads the neighbor
+     * list from the device, so it should not be called on every step.
+     */
+    std::map<std::string, double> getNeighborListStatistics() const;
+    /**
+     * Register a callback to receive periodic reports on the progress of the simulation.  It is
+     * invoked each time the specified number of steps have been taken.  Reporting never synchronizes
+     * with the computation, so it does not slow down the simulation.  See TelemetryCallback for details.
+     *
+     * The Context does not take ownership of the callback.  It must remain valid until it is replaced
+     * by another call to this method or the Context is deleted.
+     *
+     * @param callback   the callback to invoke.  Pass NULL to stop reporting.
+     * @param interval   the number of steps between reports
+     */
+    void setTelemetryCallback(TelemetryCallback* callback, int interval);
+    /**
+     * Get the callback that receives periodic reports on the progress of the simulation, or NULL if
+     * none has been registered.
+     */
+    TelemetryCallback* getTelemetryCallback() const;
+    /**
+     * Get the number of steps between calls to the TelemetryCallback.
+     */
+    int getTelemetryInterval() const;
     /**
      * Copy information from a State object into this Context.  This restores the Context to
      * approximately the same state it was in when the State was created.  If the State does not include
@@ -169,6 +312,98 @@ public:
      * contains the velocity of the i'th particle.
      */
     void setVelocities(const std::vector<Vec3>& velocities);
+    /**
+     * Copy the positions of all particles (measured in nm) into an array owned by the caller.  This is equivalent
+     * to calling getState(State::Positions).getPositions(), but it writes the values directly into the array
+     * without creating a State.  This makes it more efficient when positions need to be exchanged with other
+     * code on every time step.
+     *
+     * @param positions   an array of length 3*N, where N is the number of particles in the System.  On exit,
+     *                    elements 3*i, 3*i+1, and 3*i+2 contain the x, y, and z coordinates of the i'th particle.
+     */
+    void getPositionArray(double* positions) const;
+    /**
+     * Copy the positions of all particles (measured in nm) into an array owned by the caller.  This is equivalent
+     * to calling getState(State::Positions).getPositions(), but it writes the values directly into the array
+     * without creating a State.  This makes it more efficient when positions need to be exchanged with other
+     * code on every time step.
+     *
+     * @param positions   an array of length 3*N, where N is the number of particles in the System.  On exit,
+     *                    elements 3*i, 3*i+1, and 3*i+2 contain the x, y, and z coordinates of the i'th particle.
+     */
+    void getPositionArray(float* positions) const;
+    /**
+     * Set the positions of all particles (measured in nm) from an array owned by the caller.  This is equivalent
+     * to setPositions(), but it does not require the caller to create a vector of Vec3 objects.
+     *
+     * @param positions   an array of length 3*N, where N is the number of particles in the System.  Elements
+     *                    3*i, 3*i+1, and 3*i+2 contain the x, y, and z coordinates of the i'th particle.
+     */
+    void setPositionArray(const double* positions);
+    /**
+     * Set the positions of all particles (measured in nm) from an array owned by the caller.  This is equivalent
+     * to setPositions(), but it does not require the caller to create a vector of Vec3 objects.
+     *
+     * @param positions   an array of length 3*N, where N is the number of particles in the System.  Elements
+     *                    3*i, 3*i+1, and 3*i+2 contain the x, y, and z coordinates of the i'th particle.
+     */
+    void setPositionArray(const float* positions);
+    /**
+     * Copy the velocities of all particles (measured in nm/picosecond) into an array owned by the caller.  This
+     * is equivalent to calling getState(State::Velocities).getVelocities(), but it writes the values directly
+     * into the array without creating a State.
+     *
+     * @param velocities  an array of length 3*N, where N is the number of particles in the System.  On exit,
+     *                    elements 3*i, 3*i+1, and 3*i+2 contain the x, y, and z components of the i'th particle's velocity.
+     */
+    void getVelocityArray(double* velocities) const;
+    /**
+     * Copy the velocities of all particles (measured in nm/picosecond) into an array owned by the caller.  This
+     * is equivalent to calling getState(State::Velocities).getVelocities(), but it writes the values directly
+     * into the array without creating a State.
+     *
+     * @param velocities  an array of length 3*N, where N is the number of particles in the System.  On exit,
+     *                    elements 3*i, 3*i+1, and 3*i+2 contain the x, y, and z components of the i'th particle's velocity.
+     */
+    void getVelocityArray(float* velocities) const;
+    /**
+     * Set the velocities of all particles (measured in nm/picosecond) from an array owned by the caller.  This is
+     * equivalent to setVelocities(), but it does not require the caller to create a vector of Vec3 objects.
+     *
+     * @param velocities  an array of length 3*N, where N is the number of particles in the System.  Elements
+     *                    3*i, 3*i+1, and 3*i+2 contain the x, y, and z components of the i'th particle's velocity.
+     */
+    void setVelocityArray(const double* velocities);
+    /**
+     * Set the velocities of all particles (measured in nm/picosecond) from an array owned by the caller.  This is
+     * equivalent to setVelocities(), but it does not require the caller to create a vector of Vec3 objects.
+     *
+     * @param velocities  an array of length 3*N, where N is the number of particles in the System.  Elements
+     *                    3*i, 3*i+1, and 3*i+2 contain the x, y, and z components of the i'th particle's velocity.
+     */
+    void setVelocityArray(const float* velocities);
+    /**
+     * Compute the forces on all particles (measured in kJ/mol/nm) and copy them into an array owned by the caller.
+     * This is equivalent to calling getState(State::Forces, false, groups).getForces(), but it writes the values
+     * directly into the array without creating a State.
+     *
+     * @param forces   an array of length 3*N, where N is the number of particles in the System.  On exit,
+     *                 elements 3*i, 3*i+1, and 3*i+2 contain the x, y, and z components of the force on the i'th particle.
+     * @param groups   a set of bit flags for which force groups to include.  Group i will be included
+     *                 if (groups&(1<<i)) != 0.  The default value includes all groups.
+     */
+    void getForceArray(double* forces, int groups=0xFFFFFFFF) const;
+    /**
+     * Compute the forces on all particles (measured in kJ/mol/nm) and copy them into an array owned by the caller.
+     * This is equivalent to calling getState(State::Forces, false, groups).getForces(), but it writes the values
+     * directly into the array without creating a State.
+     *
+     * @param forces   an array of length 3*N, where N is the number of particles in the System.  On exit,
+     *                 elements 3*i, 3*i+1, and 3*i+2 contain the x, y, and z components of the force on the i'th particle.
+     * @param groups   a set of bit flags for which force groups to include.  Group i will be included
+     *                 if (groups&(1<<i)) != 0.  The default value includes all groups.
+     */
+    void getForceArray(float* forces, int groups=0xFFFFFFFF) const;
     /**
      * Set the velocities of all particles in the System to random values chosen from a Boltzmann
      * distribution at a given temperature.
@@ -272,6 +507,9 @@ public:
      * with different versions of OpenMM are also often incompatible.  If a checkpoint cannot be loaded,
      * that is signaled by throwing an exception.
      * 
+     * The stream may also contain a checkpoint that was compressed with CheckpointCompressor::compress(),
+     * provided it was not compressed as a delta relative to an earlier checkpoint.
+     * 
      * @param stream    an input stream the checkpoint data should be read from
      */
     void loadCheckpoint(std::istream& stream);
@@ -223,6 +223,18 @@ public:
      * the Context.  Also, this method cannot be used to add new particles, only to change the parameters of existing ones.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Update the per-particle parameters in a Context for a contiguous range of particles.  This is identical to
+     * updateParametersInContext(Context&), except that only the particles with indices firstParticle through
+     * firstParticle+numParticles-1 are copied to the Context.  When only a few particles in a large System have changed,
+     * this is much faster than updating all of them.  Particles are identified by the index that was passed to
+     * setParticleParameters(), not by their index within the System.
+     *
+     * @param context        the Context in which to update the parameters
+     * @param firstParticle  the index of the first particle to update
+     * @param numParticles   the number of consecutive particles to update
+     */
+    void updateParametersInContext(Context& context, int firstParticle, int numParticles);
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
@@ -558,6 +558,17 @@ public:
      * the data range) must not be changed.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Update the per-particle parameters in a Context for a contiguous range of particles.  This is identical to
+     * updateParametersInContext(Context&), except that only the particles with indices firstParticle through
+     * firstParticle+numParticles-1 are copied to the Context.  When only a few particles in a large System have changed,
+     * this is much faster than updating all of them.
+     *
+     * @param context        the Context in which to update the parameters
+     * @param firstParticle  the index of the first particle to update
+     * @param numParticles   the number of consecutive particles to update
+     */
+    void updateParametersInContext(Context& context, int firstParticle, int numParticles);
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
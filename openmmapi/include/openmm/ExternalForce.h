@@ -0,0 +1,173 @@
+#ifndef OPENMM_EXTERNALFORCE_H_
+#define OPENMM_EXTERNALFORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Force.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+
+namespace OpenMM {
+
+/**
+ * This class lets forces be computed by external code, such as a machine learning potential, that
+ * works directly with the platform's internal data.  To use it, create a subclass of
+ * ExternalForce::Computation and pass it to the constructor.  Every time forces or energy are needed,
+ * the Computation's compute() method is called.  It receives pointers to the array containing the
+ * current positions and to an array where it should store the forces.  Neither array is copied, so on
+ * a GPU the data never needs to leave the device.
+ *
+ * The layout of the arrays depends on the platform.  The ComputeData passed to compute() describes it.
+ *
+ * <ul>
+ * <li>On the Reference and CPU platforms, they are host arrays of doubles.  Each particle has 3
+ * elements (x, y, z), and particles appear in the same order as in the System.</li>
+ * <li>On the CUDA and OpenCL platforms, they are device arrays (a CUdeviceptr or a cl_mem).  Each
+ * particle has 4 elements, of which only the first 3 are meaningful.  They are double precision if
+ * the platform is in double precision mode, and single precision otherwise.  Atoms are stored in
+ * the platform's internal order, which can change as the simulation runs.  ComputeData::atomIndex
+ * gives the index within the System of the particle stored at each position.</li>
+ * </ul>
+ *
+ * The force array has been cleared to zero before compute() is called.  Any work the Computation
+ * does in a separate stream or queue must be complete before compute() returns.
+ *
+ * The result may depend on state outside the Context, so the Context never reuses forces or energies
+ * that include an ExternalForce (see Context::setForceCachingEnabled()).  compute() is called again
+ * every time they are requested.
+ *
+ * Because the Computation is arbitrary code, this class cannot be serialized and is only available
+ * from C++.
+ */
+
+class OPENMM_EXPORT ExternalForce : public Force {
+public:
+    class Computation;
+    struct ComputeData;
+    /**
+     * Create an ExternalForce.
+     *
+     * @param computation    the object that computes the forces and energy.  The ExternalForce takes
+     *                       ownership of it, and deletes it when the ExternalForce is deleted.
+     */
+    explicit ExternalForce(Computation* computation);
+    ~ExternalForce();
+    /**
+     * Get the Computation that computes the forces and energy.
+     */
+    Computation& getComputation() const;
+    /**
+     * Set whether this force makes use of periodic boundary conditions.  This determines whether the
+     * periodic box vectors passed to the Computation are meaningful.
+     */
+    void setUsesPeriodicBoundaryConditions(bool periodic);
+    /**
+     * Returns whether or not this force makes use of periodic boundary
+     * conditions.
+     *
+     * @returns true if force uses PBC and false otherwise
+     */
+    bool usesPeriodicBoundaryConditions() const;
+protected:
+    ForceImpl* createImpl() const;
+private:
+    Computation* computation;
+    bool usePeriodic;
+};
+
+/**
+ * This structure describes the data passed to ExternalForce::Computation::compute().
+ */
+struct ExternalForce::ComputeData {
+    /**
+     * The number of particles in the System.
+     */
+    int numParticles;
+    /**
+     * True if positions and forces point to device memory, false if they point to host memory.
+     */
+    bool isDeviceMemory;
+    /**
+     * True if the elements of positions and forces are doubles, false if they are floats.
+     */
+    bool isDoublePrecision;
+    /**
+     * The number of elements each particle occupies in positions and forces.
+     */
+    int stride;
+    /**
+     * The array containing the positions (measured in nm).
+     */
+    const void* positions;
+    /**
+     * The array in which to store the forces (measured in kJ/mol/nm).
+     */
+    void* forces;
+    /**
+     * A host array whose i'th element is the index within the System of the particle stored at
+     * position i of the arrays.  This is NULL if particles are stored in the same order as in the
+     * System.
+     */
+    const int* atomIndex;
+    /**
+     * The periodic box vectors (measured in nm).
+     */
+    Vec3 periodicBoxVectors[3];
+    /**
+     * Whether forces should be computed.  If this is false, the force array may be left unchanged.
+     */
+    bool includeForces;
+    /**
+     * Whether the energy should be computed.  If this is false, the return value of compute() is ignored.
+     */
+    bool includeEnergy;
+};
+
+/**
+ * This is the abstract base class for objects that compute the forces for an ExternalForce.
+ */
+class OPENMM_EXPORT ExternalForce::Computation {
+public:
+    virtual ~Computation() {
+    }
+    /**
+     * Compute the forces and energy.
+     *
+     * @param data    describes the arrays containing the positions, and the array in which to store the forces
+     * @return the potential energy (measured in kJ/mol)
+     */
+    virtual double compute(const ComputeData& data) = 0;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_EXTERNALFORCE_H_*/
@@ -0,0 +1,148 @@
+#ifndef OPENMM_FORCEVALIDATOR_H_
+#define OPENMM_FORCEVALIDATOR_H_
+
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "System.h"
+#include "internal/windowsExport.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * A ForceValidator measures how accurately a Context computes forces, by comparing them to forces
+ * computed in double precision with the Reference platform.  This is useful for deciding whether a
+ * faster configuration, such as single precision or a looser Ewald error tolerance, is accurate
+ * enough for a particular System.
+ *
+ * Call validate() with the Context to test.  It creates a Reference platform Context for the same
+ * System, copies the positions, periodic box vectors, and parameters from the Context being tested,
+ * and computes the forces and energy with both of them.  This is done once for all forces together,
+ * and then separately for each force group that is used by the System.  For each one it reports
+ * the force error and how long it took to evaluate on each platform.
+ *
+ * Two measures of the force error are reported.  The RMS error is the RMS difference between the
+ * tested and reference forces, divided by the RMS of the reference forces.  The max error is the
+ * largest difference for any single particle, divided by the same RMS reference force.  Normalizing
+ * by the RMS force rather than each particle's own force keeps particles that happen to feel very
+ * little force from dominating the result.
+ *
+ * You also can provide a different System to compute the reference forces with.  It must have
+ * the same particles and force groups.  This lets you compare against a more accurate calculation
+ * than the tested System specifies, for example the same System with a tighter Ewald error tolerance.
+ */
+
+class OPENMM_EXPORT ForceValidator {
+public:
+    /**
+     * This is the result of comparing the forces computed by one set of force groups.
+     */
+    struct GroupResult {
+        /**
+         * The force group that was evaluated, or -1 for the result with all force groups included
+         */
+        int group;
+        /**
+         * The RMS difference between the tested and reference forces, divided by the RMS reference force
+         */
+        double rmsError;
+        /**
+         * The largest difference between the tested and reference forces on any particle, divided by the RMS reference force
+         */
+        double maxError;
+        /**
+         * The potential energy computed by the tested Context (measured in kJ/mol)
+         */
+        double energy;
+        /**
+         * The potential energy computed by the Reference platform (measured in kJ/mol)
+         */
+        double referenceEnergy;
+        /**
+         * The average time taken to compute the forces and energy with the tested Context (measured in seconds)
+         */
+        double time;
+        /**
+         * The average time taken to compute the forces and energy with the Reference platform (measured in seconds)
+         */
+        double referenceTime;
+    };
+    ForceValidator();
+    /**
+     * Get the number of times the forces are evaluated on each platform to measure the time they take.
+     * The default is 10.
+     */
+    int getNumRepetitions() const;
+    /**
+     * Set the number of times the forces are evaluated on each platform to measure the time they take.
+     * The evaluation used to compare the forces is done before timing starts, so the time to compile
+     * kernels and build data structures is not included.  If this is 0, timing is skipped.
+     */
+    void setNumRepetitions(int repetitions);
+    /**
+     * Compare the forces computed by a Context to ones computed with the Reference platform for the
+     * same System.  The first element of the returned vector is for all force groups, followed by one
+     * element for each force group the System uses, in increasing order.
+     *
+     * @param context    the Context to test
+     */
+    const std::vector<GroupResult>& validate(Context& context);
+    /**
+     * Compare the forces computed by a Context to ones computed with the Reference platform for a
+     * different System.  The first element of the returned vector is for all force groups, followed
+     * by one element for each force group the tested Context's System uses, in increasing order.
+     *
+     * @param context          the Context to test
+     * @param referenceSystem  the System to compute the reference forces for.  It must have the same
+     *                         number of particles as the Context's System.
+     */
+    const std::vector<GroupResult>& validate(Context& context, const System& referenceSystem);
+    /**
+     * Get the results from the most recent call to validate().
+     */
+    const std::vector<GroupResult>& getResults() const;
+    /**
+     * Get a human readable table of the results from the most recent call to validate().
+     */
+    std::string getReport() const;
+private:
+    int numRepetitions;
+    std::string platformName;
+    std::vector<GroupResult> results;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_FORCEVALIDATOR_H_*/
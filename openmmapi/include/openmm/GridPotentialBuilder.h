@@ -0,0 +1,127 @@
+#ifndef OPENMM_GRIDPOTENTIALBUILDER_H_
+#define OPENMM_GRIDPOTENTIALBUILDER_H_
+
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CustomCompoundBondForce.h"
+#include "System.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * A GridPotentialBuilder replaces the nonbonded interactions between a rigid environment and the particles
+ * moving inside it with a precomputed grid.  This is useful for simulations such as docking refinement, where
+ * a small ligand moves inside a large protein whose atoms are held fixed.  Rather than computing the
+ * interactions with every fixed particle on every step, the potential they create is tabulated once on a grid,
+ * and the mobile particles are evaluated by interpolating it.  The cost of each step then depends only on the
+ * number of mobile particles.
+ *
+ * Create a GridPotentialBuilder for a System and the list of particles that are frozen, then call createForce()
+ * with the positions of the frozen particles and the region the grid should cover.  It returns a
+ * CustomCompoundBondForce that applies the electrostatic and Lennard-Jones interactions of the frozen particles,
+ * as defined by the System's NonbondedForce, to the mobile particles.  The potentials are tabulated with
+ * Continuous3DFunctions, so they are interpolated with tricubic splines and are zero outside the grid.
+ *
+ * The Lennard-Jones interaction uses the Lorentz-Berthelot combining rule, which cannot be factored into a single
+ * grid.  One grid is created for each distinct sigma among the mobile particles, in addition to one for the
+ * electrostatic potential.
+ *
+ * The NonbondedForce must use the NoCutoff or CutoffNonPeriodic method.  With CutoffNonPeriodic, the cutoff,
+ * reaction field, and switching function are applied just as the NonbondedForce applies them.  There may not be
+ * any exceptions between frozen and mobile particles, since a grid cannot represent interactions that are
+ * specific to particular pairs.
+ *
+ * Values close to a frozen particle are very large and cannot be interpolated accurately, so every grid value
+ * is clipped to the range set by setMaximumValue().  Mobile particles should never get close enough to a frozen
+ * particle for this to matter.
+ */
+
+class OPENMM_EXPORT GridPotentialBuilder {
+public:
+    /**
+     * Create a GridPotentialBuilder.
+     *
+     * @param system            the System containing the frozen and mobile particles.  It must contain a single
+     *                          NonbondedForce.
+     * @param frozenParticles   the indices of the particles whose potential should be tabulated
+     */
+    GridPotentialBuilder(const System& system, const std::vector<int>& frozenParticles);
+    /**
+     * Get the approximate spacing between grid points (in nm).  The default is 0.04 nm.
+     */
+    double getGridSpacing() const;
+    /**
+     * Set the approximate spacing between grid points (in nm).  The actual spacing along each axis is adjusted
+     * so the grid exactly covers the requested region.
+     */
+    void setGridSpacing(double spacing);
+    /**
+     * Get the largest absolute value allowed for any grid point.  The default is 1000.
+     */
+    double getMaximumValue() const;
+    /**
+     * Set the largest absolute value allowed for any grid point.  The electrostatic grid holds the potential
+     * (in kJ/mol/e) and the Lennard-Jones grids hold energies divided by the square root of the mobile particle's
+     * epsilon (in (kJ/mol)^(1/2)).
+     */
+    void setMaximumValue(double value);
+    /**
+     * Create a Force that applies the interactions of the frozen particles to a set of mobile particles.
+     *
+     * The i'th term of the returned force acts on particle i of the System it is added to, and uses the
+     * nonbonded parameters of mobileParticles[i] in the System passed to the constructor.  To simulate only
+     * the mobile particles, create a System containing them in that order and add the force to it.  If
+     * mobileParticles lists particles by their original indices starting from 0, the force can instead be added
+     * to the original System.
+     *
+     * @param positions        the positions of all particles in the System.  Only those of the frozen particles are used.
+     * @param gridMin          the lower corner of the region to cover with the grid
+     * @param gridMax          the upper corner of the region to cover with the grid
+     * @param mobileParticles  the particles the force should act on
+     * @return a newly created CustomCompoundBondForce.  The caller takes ownership of it.
+     */
+    CustomCompoundBondForce* createForce(const std::vector<Vec3>& positions, const Vec3& gridMin, const Vec3& gridMax,
+                                         const std::vector<int>& mobileParticles) const;
+private:
+    const System& system;
+    std::vector<int> frozen;
+    std::vector<bool> isFrozen;
+    double spacing, maxValue;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_GRIDPOTENTIALBUILDER_H_*/
@@ -102,6 +102,17 @@ public:
      * in a angle cannot be changed, nor can new angles be added.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Update the per-angle parameters in a Context for a contiguous range of angles.  This is identical to
+     * updateParametersInContext(Context&), except that only the angles with indices firstAngle through
+     * firstAngle+numAngles-1 are copied to the Context.  When only a few angles in a large System have changed,
+     * this is much faster than updating all of them.
+     *
+     * @param context     the Context in which to update the parameters
+     * @param firstAngle  the index of the first angle to update
+     * @param numAngles   the number of consecutive angles to update
+     */
+    void updateParametersInContext(Context& context, int firstAngle, int numAngles);
     /**
      * Set whether this force should apply periodic boundary conditions when calculating displacements.
      * Usually this is not appropriate for bonded forces, but there are situations when it can be useful.
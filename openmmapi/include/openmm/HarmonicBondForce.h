@@ -99,6 +99,17 @@ public:
      * in a bond cannot be changed, nor can new bonds be added.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Update the per-bond parameters in a Context for a contiguous range of bonds.  This is identical to
+     * updateParametersInContext(Context&), except that only the bonds with indices firstBond through
+     * firstBond+numBonds-1 are copied to the Context.  When only a few bonds in a large System have changed,
+     * this is much faster than updating all of them.
+     *
+     * @param context    the Context in which to update the parameters
+     * @param firstBond  the index of the first bond to update
+     * @param numBonds   the number of consecutive bonds to update
+     */
+    void updateParametersInContext(Context& context, int firstBond, int numBonds);
     /**
      * Set whether this force should apply periodic boundary conditions when calculating displacements.
      * Usually this is not appropriate for bonded forces, but there are situations when it can be useful.
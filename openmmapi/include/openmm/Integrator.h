@@ -35,6 +35,7 @@
 #include "State.h"
 #include "Vec3.h"
 #include "openmm/serialization/SerializationNode.h"
+#include <future>
 #include <iosfwd>
 #include <map>
 #include <vector>
@@ -86,6 +87,21 @@ public:
      * @param steps   the number of time steps to take
      */
     virtual void step(int steps) = 0;
+    /**
+     * Advance a simulation through time by taking a series of time steps, without waiting for them
+     * to finish.  The steps are taken on a separate thread, so a single thread can keep many Contexts
+     * running at once, for example to drive the replicas of a replica exchange simulation.
+     * The threads come from a pool shared by all Integrators and are reused between calls, so calling
+     * this repeatedly does not create a new thread each time.
+     *
+     * No other methods may be called on this Integrator or its Context until the returned future is
+     * ready.  Calling get() on it waits for the steps to finish, and rethrows any exception thrown
+     * by step().  Unlike a future returned by std::async(), destroying it does not wait for the steps.
+     *
+     * @param steps   the number of time steps to take
+     * @return a future that becomes ready once all the steps have been taken
+     */
+    std::future<void> stepAsync(int steps);
     /**
      * Get which force groups to use for integration.  By default, all force groups
      * are included.  This is interpreted as a set of bit flags: the forces from group i
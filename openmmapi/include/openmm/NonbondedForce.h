@@ -316,6 +316,46 @@ public:
      * @param[out] nz      the number of grid points along the Z axis
      */
     void getLJPMEParametersInContext(const Context& context, double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Get the order of the B-spline interpolation used to spread charges onto the PME grid.  The same order
+     * is used for the electrostatic and (with LJPME) dispersion grids.  The default is 5.
+     */
+    int getPMEOrder() const;
+    /**
+     * Set the order of the B-spline interpolation used to spread charges onto the PME grid.  The same order
+     * is used for the electrostatic and (with LJPME) dispersion grids.  Allowed values are 4, 5, and 6.
+     * Higher orders give smaller reciprocal space errors for a given grid size, at the cost of more work
+     * per particle.  When the grid is chosen from the Ewald error tolerance, its size accounts for the order.
+     *
+     * Only the Reference platform currently supports orders other than 5.
+     */
+    void setPMEOrder(int order);
+    /**
+     * Estimate the relative errors in the direct and reciprocal space parts of PME for a System.  The
+     * estimate is for the parameters that will be used: those specified with setPMEParameters(), or
+     * the standard values chosen from the Ewald error tolerance, the PME order, and the System's default
+     * periodic box vectors.  It uses the same error model that is used to choose parameters from the
+     * error tolerance, so it shows how accurate an explicitly specified set of parameters is expected to be.
+     * This may only be called when the nonbonded method is PME or LJPME.
+     *
+     * @param system                 the System this force is part of
+     * @param[out] directError       the estimated relative error in the direct space forces
+     * @param[out] reciprocalError   the estimated relative error in the reciprocal space forces.  This is
+     *                               the largest value for any of the three axes.
+     */
+    void estimatePMEError(const System& system, double& directError, double& reciprocalError) const;
+    /**
+     * Estimate the relative errors in the direct and reciprocal space parts of the dispersion term for LJPME.
+     * The estimate is for the parameters that will be used: those specified with setLJPMEParameters(), or
+     * the standard values chosen from the Ewald error tolerance, the PME order, and the System's default
+     * periodic box vectors.  This may only be called when the nonbonded method is LJPME.
+     *
+     * @param system                 the System this force is part of
+     * @param[out] directError       the estimated relative error in the direct space forces
+     * @param[out] reciprocalError   the estimated relative error in the reciprocal space forces.  This is
+     *                               the largest value for any of the three axes.
+     */
+    void estimateLJPMEError(const System& system, double& directError, double& reciprocalError) const;
     /**
      * Add the nonbonded force parameters for a particle.  This should be called once for each particle
      * in the System.  When it is called for the i'th time, it specifies the parameters for the i'th particle.
@@ -628,15 +668,18 @@ private:
     NonbondedMethod nonbondedMethod;
     double cutoffDistance, switchingDistance, rfDielectric, ewaldErrorTol, alpha, dalpha;
     bool useSwitchingFunction, useDispersionCorrection, exceptionsUsePeriodic, includeDirectSpace;
-    int recipForceGroup, nx, ny, nz, dnx, dny, dnz;
-    void addExclusionsToSet(const std::vector<std::set<int> >& bonded12, std::set<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const;
+    int recipForceGroup, nx, ny, nz, dnx, dny, dnz, pmeOrder;
     int getGlobalParameterIndex(const std::string& parameter) const;
+    int findException(int particle1, int particle2) const;
+    void addExceptionToTable(int index);
+    void removeExceptionFromTable(int index);
+    void rebuildExceptionTable();
     std::vector<ParticleInfo> particles;
     std::vector<ExceptionInfo> exceptions;
     std::vector<GlobalParameterInfo> globalParameters;
     std::vector<ParticleOffsetInfo> particleOffsets;
     std::vector<ExceptionOffsetInfo> exceptionOffsets;
-    std::map<std::pair<int, int>, int> exceptionMap;
+    std::vector<int> exceptionTable;
 };
 
 /**
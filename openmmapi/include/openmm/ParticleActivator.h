@@ -0,0 +1,123 @@
+#ifndef OPENMM_PARTICLEACTIVATOR_H_
+#define OPENMM_PARTICLEACTIVATOR_H_
+
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "System.h"
+#include "internal/windowsExport.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * A ParticleActivator turns particles on and off in an existing Context by changing force field
+ * parameters, without adding or removing anything from the System.  This is useful for methods
+ * that insert and delete molecules, such as grand canonical Monte Carlo.  Create the System with
+ * enough particles for the largest number of molecules that may exist at once, create a Context
+ * for it, and then deactivate the particles that should not exist yet.  Inserting or deleting a
+ * molecule then only requires updating parameters in the Context, instead of calling reinitialize().
+ *
+ * An inactive particle does not interact with anything.  The following forces are modified:
+ *
+ * <ul>
+ * <li>NonbondedForce: the charge and epsilon of an inactive particle are set to zero, as are the
+ * parameters of every exception involving it.  Exceptions that only exclude an interaction are left
+ * unchanged.</li>
+ * <li>HarmonicBondForce, HarmonicAngleForce, and PeriodicTorsionForce: the force constant of every
+ * term involving an inactive particle is set to zero.</li>
+ * </ul>
+ *
+ * All other forces are left unchanged, so a System containing other forces that act on the particles
+ * being deactivated needs to handle them separately.  Constraints and virtual sites are not affected,
+ * and inactive particles are still integrated, so they move as an ideal gas.
+ *
+ * The ParticleActivator modifies the Force objects in the System it was created for, then copies the
+ * new parameters to the Context.  The Context must have been created for that System, and the
+ * parameters of active particles should not be changed while the ParticleActivator is in use.  When a
+ * particle is reactivated, it gets back the parameters it had when the ParticleActivator was created.
+ *
+ * This class is a convenience built on updateParametersInContext().  The work it does is proportional
+ * to the number of parameters the forces copy to the Context, which for bonded forces is only the range
+ * of terms involving the affected particles.  Inactive particles still occupy space in the
+ * neighbor list and are included in the nonbonded calculation.
+ */
+
+class OPENMM_EXPORT ParticleActivator {
+public:
+    /**
+     * Create a ParticleActivator.  The current parameters of the System's forces are recorded as the
+     * parameters of active particles.  All particles start out active.
+     *
+     * @param system    the System whose particles should be activated and deactivated
+     */
+    explicit ParticleActivator(System& system);
+    ~ParticleActivator();
+    /**
+     * Get whether a particle is currently active.
+     *
+     * @param particle   the index of the particle
+     */
+    bool isParticleActive(int particle) const;
+    /**
+     * Activate or deactivate a particle.
+     *
+     * @param context    the Context in which to update the parameters
+     * @param particle   the index of the particle
+     * @param active     true to activate the particle, false to deactivate it
+     */
+    void setParticleActive(Context& context, int particle, bool active);
+    /**
+     * Activate or deactivate a set of particles, such as all the atoms of a molecule.  This is more
+     * efficient than calling setParticleActive() for each one, since the parameters are only copied to
+     * the Context once.
+     *
+     * @param context    the Context in which to update the parameters
+     * @param particles  the indices of the particles
+     * @param active     true to activate the particles, false to deactivate them
+     */
+    void setParticlesActive(Context& context, const std::vector<int>& particles, bool active);
+private:
+    class ManagedForce;
+    class NonbondedTerms;
+    class BondedTerms;
+    ParticleActivator(const ParticleActivator&);
+    ParticleActivator& operator=(const ParticleActivator&);
+    System& system;
+    std::vector<bool> active;
+    std::vector<ManagedForce*> forces;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_PARTICLEACTIVATOR_H_*/
@@ -108,6 +108,17 @@ public:
      * in a torsion cannot be changed, nor can new torsions be added.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Update the per-torsion parameters in a Context for a contiguous range of torsions.  This is identical to
+     * updateParametersInContext(Context&), except that only the torsions with indices firstTorsion through
+     * firstTorsion+numTorsions-1 are copied to the Context.  When only a few torsions in a large System have changed,
+     * this is much faster than updating all of them.
+     *
+     * @param context       the Context in which to update the parameters
+     * @param firstTorsion  the index of the first torsion to update
+     * @param numTorsions   the number of consecutive torsions to update
+     */
+    void updateParametersInContext(Context& context, int firstTorsion, int numTorsions);
     /**
      * Set whether this force should apply periodic boundary conditions when calculating displacements.
      * Usually this is not appropriate for bonded forces, but there are situations when it can be useful.
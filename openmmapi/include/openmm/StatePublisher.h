@@ -0,0 +1,253 @@
+#ifndef OPENMM_STATEPUBLISHER_H_
+#define OPENMM_STATEPUBLISHER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * A StatePublisher advances a simulation and publishes snapshots of its state into a
+ * POSIX shared memory object at regular intervals.  Analysis programs running in other
+ * processes on the same computer can map the shared memory and read the snapshots directly,
+ * without any files being written.  Use StateSubscriber to read them from C++.
+ *
+ * To use it, create a StatePublisher for a Context, then call step() on it instead of
+ * calling step() on the Integrator.  It runs the Integrator in blocks and publishes a frame
+ * every time the step count reaches a multiple of the interval.  You also can call
+ * publishFrame() at any time to publish the current state.
+ *
+ * The shared memory holds a ring buffer with a fixed number of slots.  Frame i is written
+ * to slot i%numSlots, so a reader that falls more than numSlots frames behind misses frames.
+ * The publisher never waits for readers.  Each slot carries a sequence number that is odd
+ * while the slot is being written and even once it is complete.  A reader records the
+ * sequence number, copies the frame, and then checks that the sequence number has not
+ * changed.  If it has, the frame was overwritten while being read.
+ *
+ * The layout of the shared memory is as follows.  All values use the native byte order.
+ * The header occupies the first 64 bytes:
+ *
+ * <ul>
+ * <li>bytes 0-7: the characters "OMMSTATE"</li>
+ * <li>bytes 8-11: the layout version (int32, currently 1)</li>
+ * <li>bytes 12-15: the number of particles (int32)</li>
+ * <li>bytes 16-19: the number of slots (int32)</li>
+ * <li>bytes 20-23: 1 if the System uses periodic boundary conditions, 0 otherwise (int32)</li>
+ * <li>bytes 24-31: the size of each slot in bytes (int64)</li>
+ * <li>bytes 32-39: the number of frames published so far (int64)</li>
+ * </ul>
+ *
+ * The slots follow, each starting at offset 64+i*slotSize:
+ *
+ * <ul>
+ * <li>bytes 0-7: the sequence number (uint64)</li>
+ * <li>bytes 8-15: the index of the frame stored in the slot (int64)</li>
+ * <li>bytes 16-23: the step count (int64)</li>
+ * <li>bytes 24-31: the simulation time in ps (float64)</li>
+ * <li>bytes 32-39: the potential energy in kJ/mol, or NaN if energies are not published (float64)</li>
+ * <li>bytes 40-47: the kinetic energy in kJ/mol, or NaN if energies are not published (float64)</li>
+ * <li>bytes 48-119: the three periodic box vectors in nm (9 float64)</li>
+ * <li>bytes 120-: the positions of all particles in nm (3*numParticles float64)</li>
+ * </ul>
+ *
+ * The Context must remain valid for as long as the StatePublisher exists.  Deleting the
+ * StatePublisher removes the shared memory object's name.  Processes that already mapped
+ * it can keep reading the frames that were published.
+ */
+
+class OPENMM_EXPORT StatePublisher {
+public:
+    /**
+     * Create a StatePublisher.  If a shared memory object with the same name already exists,
+     * its name is removed and a new object is created.  Processes that already mapped the old
+     * object are not affected.
+     *
+     * @param context      the Context whose state should be published
+     * @param name         the name of the shared memory object.  It should begin with "/", and
+     *                     contain no other "/" characters.  If the leading "/" is omitted, it is
+     *                     added automatically.
+     * @param interval     the interval (in time steps) at which to publish frames
+     * @param numSlots     the number of frames the ring buffer can hold
+     */
+    StatePublisher(Context& context, const std::string& name, int interval, int numSlots=4);
+    ~StatePublisher();
+    /**
+     * Get the name of the shared memory object.
+     */
+    const std::string& getName() const;
+    /**
+     * Get the interval (in time steps) at which frames are published.
+     */
+    int getInterval() const;
+    /**
+     * Get the number of frames the ring buffer can hold.
+     */
+    int getNumSlots() const;
+    /**
+     * Get whether particles are wrapped into the periodic box before positions are published.
+     */
+    bool getEnforcePeriodicBox() const;
+    /**
+     * Set whether particles are wrapped into the periodic box before positions are published.
+     * If true, molecules are translated so their centers lie in the same periodic box.
+     * The default is false.
+     */
+    void setEnforcePeriodicBox(bool enforce);
+    /**
+     * Get whether the potential and kinetic energies are published with each frame.
+     */
+    bool getIncludeEnergy() const;
+    /**
+     * Set whether the potential and kinetic energies are published with each frame.  Computing
+     * the energy usually requires an extra force evaluation, so the default is false.
+     */
+    void setIncludeEnergy(bool include);
+    /**
+     * Get the number of frames that have been published so far.
+     */
+    long long getNumFrames() const;
+    /**
+     * Advance the simulation by taking a series of time steps, publishing a frame every time the
+     * step count of the Context is a multiple of the interval.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Publish a frame containing the current state of the Context.
+     */
+    void publishFrame();
+private:
+    Context& context;
+    std::string name;
+    int interval, numSlots, numParticles;
+    bool enforcePeriodicBox, includeEnergy;
+    long long numFrames;
+    size_t slotSize, memorySize;
+    int fileDescriptor;
+    char* memory;
+};
+
+/**
+ * A StateSubscriber reads the frames published by a StatePublisher, which may be running in
+ * a different process.  See StatePublisher for a description of the shared memory layout.
+ */
+
+class OPENMM_EXPORT StateSubscriber {
+public:
+    /**
+     * This struct holds the data for one published frame.
+     */
+    struct Frame {
+        /**
+         * The index of the frame.  Frames are numbered in the order they were published, starting from 0.
+         */
+        long long index;
+        /**
+         * The step count at which the frame was recorded.
+         */
+        long long step;
+        /**
+         * The simulation time in ps.
+         */
+        double time;
+        /**
+         * The potential energy in kJ/mol, or NaN if energies are not published.
+         */
+        double potentialEnergy;
+        /**
+         * The kinetic energy in kJ/mol, or NaN if energies are not published.
+         */
+        double kineticEnergy;
+        /**
+         * The periodic box vectors in nm.
+         */
+        Vec3 box[3];
+        /**
+         * The positions of all particles in nm.
+         */
+        std::vector<Vec3> positions;
+    };
+    /**
+     * Create a StateSubscriber.  The shared memory object must already have been created by a
+     * StatePublisher.
+     *
+     * @param name     the name of the shared memory object, as passed to the StatePublisher
+     */
+    StateSubscriber(const std::string& name);
+    ~StateSubscriber();
+    /**
+     * Get the number of particles in each frame.
+     */
+    int getNumParticles() const;
+    /**
+     * Get the number of frames the ring buffer can hold.
+     */
+    int getNumSlots() const;
+    /**
+     * Get the number of frames that have been published so far.
+     */
+    long long getNumFrames() const;
+    /**
+     * Read a frame.  This fails if the frame has not been published yet, if it has
+     * already been overwritten by a later frame, or if the publisher does not finish writing
+     * it within one second, for example because it was killed while writing.
+     *
+     * @param index    the index of the frame to read
+     * @param frame    on exit, this contains the frame
+     * @return true if the frame was read successfully, false if it is not available
+     */
+    bool readFrame(long long index, Frame& frame) const;
+    /**
+     * Read the most recently published frame.
+     *
+     * @param frame    on exit, this contains the frame
+     * @return true if a frame was read successfully, false if no frame has been published yet or
+     *         the latest frame could not be read
+     */
+    bool readLatestFrame(Frame& frame) const;
+private:
+    std::string name;
+    int numParticles, numSlots;
+    size_t slotSize, memorySize;
+    int fileDescriptor;
+    char* memory;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_STATEPUBLISHER_H_*/
@@ -33,6 +33,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "Vec3.h"
+#include <utility>
 #include <vector>
 #include "internal/windowsExport.h"
 
@@ -108,6 +109,18 @@ public:
      * @param mass   the mass of the particle
      */
     void setParticleMass(int index, double mass);
+    /**
+     * Move mass from heavy atoms to the hydrogens bonded to them, which allows larger time steps
+     * to be used.  Each hydrogen is given the specified mass, and the mass it gains is subtracted
+     * from the atom it is bonded to, so the total mass of the molecule is unchanged.  Any particle whose
+     * mass is greater than 0 and less than 2.5 amu is treated as a hydrogen, so deuterium is included.
+     * Bonds between two hydrogens or to a massless particle are ignored.  To leave particular hydrogens
+     * unchanged, such as those in rigid water molecules, omit their bonds from the list.
+     *
+     * @param hydrogenMass   the mass (in atomic mass units) to give each hydrogen
+     * @param bonds          the pairs of particles that are bonded to each other
+     */
+    void repartitionHydrogenMass(double hydrogenMass, const std::vector<std::pair<int, int> >& bonds);
     /**
      * Set a particle to be a virtual site.  The VirtualSite object should have
      * been created on the heap with the "new" operator.  The System takes over
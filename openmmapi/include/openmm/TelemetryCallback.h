@@ -0,0 +1,124 @@
+#ifndef OPENMM_TELEMETRYCALLBACK_H_
+#define OPENMM_TELEMETRYCALLBACK_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+
+namespace OpenMM {
+
+class Context;
+
+/**
+ * A TelemetryCallback receives periodic reports on the progress of a simulation.  Register it
+ * with Context::setTelemetryCallback(), specifying how often it should be called.  It is then
+ * invoked every time that many steps have been taken, with information about how fast the
+ * simulation is running.
+ *
+ * Everything reported is information the Context already has on the host, so calling the
+ * callback never downloads data from a GPU or waits for queued work to finish.  This means
+ * it is cheap enough to leave enabled for entire simulations.  It also means that on platforms
+ * that compute asynchronously, such as CUDA and OpenCL, the times reflect when steps were
+ * launched, not when they finished.  Because only a limited amount of work can be queued, the
+ * two agree when averaged over many steps, and a stall in the computation still appears as a
+ * long step.
+ *
+ * The callback is invoked from inside Integrator::step(), at the start of a time step, by the
+ * same thread that called step().  A report therefore covers the steps completed before that
+ * one, and the report for the last steps of a call to step() is delivered when the next step
+ * begins.  If it calls methods on the Context that retrieve data, such
+ * as getState(), they will synchronize with the computation just as they would anywhere else.
+ * Exceptions thrown by the callback propagate out of step().
+ *
+ * All built in integrators support reporting, except that a CustomIntegrator only reports
+ * while executing an updateContextState step.
+ */
+
+class OPENMM_EXPORT TelemetryCallback {
+public:
+    /**
+     * The information passed to report().
+     */
+    struct Sample {
+        /**
+         * The number of steps that have been taken, as returned by State::getStepCount().
+         */
+        long long stepCount;
+        /**
+         * The number of steps that have been taken since the previous report.
+         */
+        int steps;
+        /**
+         * The simulation time (in ps).
+         */
+        double simulationTime;
+        /**
+         * The wall clock time (in seconds) since the callback was registered.
+         */
+        double elapsedTime;
+        /**
+         * The wall clock time (in seconds) since the previous report.
+         */
+        double intervalTime;
+        /**
+         * The simulation speed since the previous report, in ns of simulation time per day of
+         * wall clock time.
+         */
+        double nsPerDay;
+        /**
+         * The longest wall clock time (in seconds) between the start of one step and the start of
+         * the next since the previous report.  A value much larger than intervalTime/steps indicates
+         * the simulation stalled.
+         */
+        double maxStepTime;
+        /**
+         * If profiling is enabled for the Context (see Context::setProfilingEnabled()), this points
+         * to the times recorded so far, as returned by Context::getProfile().  Otherwise it is NULL.
+         */
+        const std::map<std::string, double>* profile;
+    };
+    virtual ~TelemetryCallback() {
+    }
+    /**
+     * This is called periodically while the simulation runs.
+     *
+     * @param context    the Context being simulated
+     * @param sample     information about the progress of the simulation
+     */
+    virtual void report(Context& context, const Sample& sample) = 0;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_TELEMETRYCALLBACK_H_*/
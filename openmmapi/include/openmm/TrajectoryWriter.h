@@ -0,0 +1,151 @@
+#ifndef OPENMM_TRAJECTORYWRITER_H_
+#define OPENMM_TRAJECTORYWRITER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "internal/windowsExport.h"
+#include <string>
+
+namespace OpenMM {
+
+/**
+ * A TrajectoryWriter advances a simulation and saves snapshots of the particle positions
+ * to a trajectory file at regular intervals.  It supports the DCD format (the CHARMM
+ * variant, with little-endian byte ordering and positions in Angstroms) and the compressed
+ * XTC format used by GROMACS.  The files it creates are identical in layout to the ones
+ * created by the DCDReporter and XTCReporter classes in the Python application layer.
+ *
+ * To use it, create a TrajectoryWriter for a Context, then call step() on it instead of
+ * calling step() on the Integrator.  It runs the Integrator in blocks and records a frame
+ * every time the step count reaches a multiple of the reporting interval.  You also can
+ * call writeFrame() at any time to record the current state.
+ *
+ * Formatting, compressing, and writing each frame happens on a background thread, so the
+ * simulation can continue while earlier frames are still being written.  Only a small number
+ * of frames are allowed to be pending at once.  If the simulation produces frames faster than
+ * they can be written, step() waits for the writer to catch up.  If an error occurs while
+ * writing, it is reported by throwing an exception from the next call to step(), writeFrame(),
+ * or flush().
+ *
+ * Like DCDReporter, the header of a new DCD file records the step count of the Context at the
+ * time the TrajectoryWriter was created as the first step of the trajectory.  When appending,
+ * the values already in the header are kept.
+ *
+ * The Context must remain valid for as long as the TrajectoryWriter exists.  Deleting the
+ * TrajectoryWriter waits for all pending frames to be written and closes the file.
+ */
+
+class OPENMM_EXPORT TrajectoryWriter {
+public:
+    /**
+     * This is an enumeration of the file formats that can be written.
+     */
+    enum Format {
+        /**
+         * The DCD format.
+         */
+        DCD = 0,
+        /**
+         * The XTC format.  Positions are stored with a precision of 0.001 nm.
+         */
+        XTC = 1
+    };
+    /**
+     * Create a TrajectoryWriter.
+     *
+     * @param context      the Context whose positions should be saved
+     * @param filename     the path of the file to write
+     * @param format       the file format to write
+     * @param interval     the interval (in time steps) at which to write frames
+     * @param append       if true, append frames to an existing file.  If false, any existing
+     *                     file is replaced.
+     */
+    TrajectoryWriter(Context& context, const std::string& filename, Format format, int interval, bool append=false);
+    ~TrajectoryWriter();
+    /**
+     * Get the path of the file being written.
+     */
+    const std::string& getFilename() const;
+    /**
+     * Get the file format being written.
+     */
+    Format getFormat() const;
+    /**
+     * Get the interval (in time steps) at which frames are written.
+     */
+    int getInterval() const;
+    /**
+     * Get whether particles are wrapped into the periodic box before positions are written.
+     */
+    bool getEnforcePeriodicBox() const;
+    /**
+     * Set whether particles are wrapped into the periodic box before positions are written.
+     * If true, molecules are translated so their centers lie in the same periodic box.
+     * The default is false.
+     */
+    void setEnforcePeriodicBox(bool enforce);
+    /**
+     * Get the number of frames that have been recorded so far, including any that are still
+     * waiting to be written.  If the file was opened for appending, this includes the frames
+     * it already contained.
+     */
+    int getNumFrames() const;
+    /**
+     * Advance the simulation by taking a series of time steps, writing a frame every time the
+     * step count of the Context is a multiple of the interval.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Record a frame containing the current positions of the Context.
+     */
+    void writeFrame();
+    /**
+     * Block until all pending frames have been written to the file.
+     */
+    void flush();
+private:
+    class FrameQueue;
+    Context& context;
+    std::string filename;
+    Format format;
+    int interval;
+    bool enforcePeriodicBox;
+    int numFrames;
+    FrameQueue* queue;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_TRAJECTORYWRITER_H_*/
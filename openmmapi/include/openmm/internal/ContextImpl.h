@@ -35,6 +35,7 @@
 #include "openmm/Kernel.h"
 #include "openmm/Platform.h"
 #include "openmm/Vec3.h"
+#include <chrono>
 #include <iosfwd>
 #include <map>
 #include <vector>
@@ -45,6 +46,7 @@ class ForceImpl;
 class Integrator;
 class Context;
 class System;
+class TelemetryCallback;
 
 /**
  * This is the internal implementation of a Context.
@@ -106,6 +108,13 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     void getPositions(std::vector<Vec3>& positions);
+    /**
+     * Get the positions of a subset of the particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, this contains the positions of the requested particles in the same order as particles
+     */
+    void getPositionSubset(const std::vector<int>& particles, std::vector<Vec3>& positions);
     /**
      * Set the positions of all particles.
      *
@@ -118,6 +127,13 @@ public:
      * @param velocities  on exit, this contains the particle velocities
      */
     void getVelocities(std::vector<Vec3>& velocities);
+    /**
+     * Get the velocities of a subset of the particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, this contains the velocities of the requested particles in the same order as particles
+     */
+    void getVelocitySubset(const std::vector<int>& particles, std::vector<Vec3>& velocities);
     /**
      * Set the velocities of all particles.
      *
@@ -206,6 +222,47 @@ public:
      * @return the potential energy of the system, or 0 if includeEnergy is false
      */
     double calcForcesAndEnergy(bool includeForces, bool includeEnergy, int groups=0xFFFFFFFF);
+    /**
+     * This is identical to calcForcesAndEnergy(), except that if nothing affecting the forces has changed since
+     * the most recent computation, and it was for the same force groups and included everything being asked
+     * for now, the previous results are reused instead of being computed again.  Use this for queries from
+     * outside an integration step, such as Context::getState().  It never reuses results when called from
+     * ForceImpl::updateContextState(), since that happens partway through a step.
+     *
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @param groups         a set of bit flags for which force groups to include.  Group i will be included
+     *                       if (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return the potential energy of the system, or 0 if includeEnergy is false
+     */
+    double calcForcesAndEnergyCached(bool includeForces, bool includeEnergy, int groups=0xFFFFFFFF);
+    /**
+     * Compute the potential energy of each force group.  If every ForceImpl returns its energy directly and each
+     * Force belongs to a single group, this is done with one evaluation.  Otherwise each group is evaluated
+     * separately.
+     *
+     * @param groups    a set of bit flags for which force groups to include
+     * @param energies  on exit, a vector of length 32 whose i'th element is the energy of group i
+     */
+    void calcEnergiesByGroup(int groups, std::vector<double>& energies);
+    /**
+     * Discard the cached results used by calcForcesAndEnergyCached().  The cache is discarded automatically
+     * when positions, parameters, or box vectors are set through this object, when forces update their
+     * parameters or the context state, and when the step count changes.  Code that modifies any of these
+     * directly in the platform's data structures, for example by copying new positions into the context with
+     * a kernel, must call this.
+     */
+    void invalidateCachedForces();
+    /**
+     * Set whether calcForcesAndEnergyCached() may reuse the results of previous computations.
+     */
+    void setForceCachingEnabled(bool enabled);
+    /**
+     * Get whether calcForcesAndEnergyCached() may reuse the results of previous computations.
+     */
+    bool getForceCachingEnabled() const {
+        return forceCachingEnabled;
+    }
     /**
      * Get the set of force group flags that were passed to the most recent call to calcForcesAndEnergy().
      * 
@@ -258,6 +315,57 @@ public:
      * same molecule if they are connected by constraints or bonds.
      */
     const std::vector<std::vector<int> >& getMolecules() const;
+    /**
+     * Get the index of the molecule each particle belongs to.  Element i is the index within the list returned
+     * by getMolecules() of the molecule containing particle i.
+     */
+    const std::vector<int>& getMoleculeIndex() const;
+    /**
+     * Set whether to measure the time spent on each part of the force computation.
+     */
+    void setProfilingEnabled(bool enabled);
+    /**
+     * Get whether the time spent on each part of the force computation is being measured.
+     */
+    bool getProfilingEnabled() const {
+        return profilingEnabled;
+    }
+    /**
+     * Add time (in seconds) to the total recorded for one part of the computation.  This has no effect
+     * unless profiling is enabled.
+     */
+    void addProfileTime(const std::string& name, double time);
+    /**
+     * Get the total time (in seconds) recorded for each part of the computation.
+     */
+    const std::map<std::string, double>& getProfile() const {
+        return profile;
+    }
+    /**
+     * Discard all recorded times.
+     */
+    void resetProfile();
+    /**
+     * Get statistics describing the neighbor list the Platform uses for nonbonded interactions.
+     * See Context::getNeighborListStatistics() for details.
+     */
+    std::map<std::string, double> getNeighborListStatistics();
+    /**
+     * Register a callback to receive periodic reports on the progress of the simulation.
+     */
+    void setTelemetryCallback(TelemetryCallback* callback, int interval);
+    /**
+     * Get the callback that receives periodic reports on the progress of the simulation.
+     */
+    TelemetryCallback* getTelemetryCallback() const {
+        return telemetryCallback;
+    }
+    /**
+     * Get the number of steps between calls to the TelemetryCallback.
+     */
+    int getTelemetryInterval() const {
+        return telemetryInterval;
+    }
     /**
      * Create a checkpoint recording the current state of the Context.
      * 
@@ -286,6 +394,11 @@ public:
      * you should never call it.  It is exposed here because the same logic is useful to other classes too.
      */
     static std::vector<std::vector<int> > findMolecules(int numParticles, std::vector<std::vector<int> >& particleBonds);
+    /**
+     * This is identical to the other form of findMolecules(), but takes a list of bonded pairs instead of
+     * a list of the particles bonded to each particle.
+     */
+    static std::vector<std::vector<int> > findMolecules(int numParticles, const std::vector<std::pair<int, int> >& bonds);
     /**
      * Create a new Context based on this one.  The new context will use the same Platform, device, and property
      * values as this one.  With the CUDA and OpenCL platforms, it also shares the same GPU context, allowing data
@@ -298,14 +411,33 @@ public:
 private:
     friend class Context;
     void initialize();
+    void updateTelemetry();
+    void recordCachedForces(bool includeForces, bool includeEnergy, int groups, double energy, long long startVersion);
     Context& owner;
     const System& system;
     Integrator& integrator;
     std::vector<ForceImpl*> forceImpls;
     std::map<std::string, double> parameters;
     mutable std::vector<std::vector<int> > molecules;
-    bool hasInitializedForces, hasSetPositions, integratorIsDeleted;
+    mutable std::vector<int> moleculeIndex;
+    std::vector<Vec3> arrayBuffer;
+    bool hasInitializedForces, hasSetPositions, integratorIsDeleted, profilingEnabled, forceCachingEnabled, updatingContextState;
+    // Set once a force computation shows that the platform accumulates energies internally, so they cannot
+    // be attributed to individual groups by calcEnergiesByGroup().
+    bool energiesNeedSeparateGroups;
+    std::map<std::string, double> profile;
+    TelemetryCallback* telemetryCallback;
+    int telemetryInterval;
+    long long telemetryStep, telemetryLastStep;
+    double telemetryTime, telemetryMaxStepTime;
+    std::chrono::steady_clock::time_point telemetryStartTime, telemetrySampleTime, telemetryStepTime;
     int lastForceGroups;
+    // The state version counts changes that could affect the forces.  The cached values describe the most
+    // recent force computation, and are valid only while cachedVersion and cachedStepCount are current.
+    long long stateVersion, cachedVersion, cachedStepCount;
+    int cachedGroups;
+    bool cachedForces, cachedEnergy;
+    double cachedEnergyValue;
     Platform* platform;
     Kernel initializeForcesKernel, updateStateDataKernel, applyConstraintsKernel, virtualSitesKernel;
     void* platformData;
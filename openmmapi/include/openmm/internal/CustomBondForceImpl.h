@@ -61,6 +61,7 @@ public:
     std::vector<std::string> getKernelNames();
     std::vector<std::pair<int, int> > getBondedParticles() const;
     void updateParametersInContext(ContextImpl& context);
+    void updateParametersInContext(ContextImpl& context, int firstBond, int numBonds);
 private:
     const CustomBondForce& owner;
     Kernel kernel;
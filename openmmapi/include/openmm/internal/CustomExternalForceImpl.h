@@ -60,6 +60,7 @@ public:
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context);
+    void updateParametersInContext(ContextImpl& context, int firstParticle, int numParticles);
 private:
     const CustomExternalForce& owner;
     Kernel kernel;
@@ -64,6 +64,7 @@ public:
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context);
+    void updateParametersInContext(ContextImpl& context, int firstParticle, int numParticles);
     /**
      * Prepare for computing the long range correction.  This function pre-computes anything
      * that depends only on the Force (such as particle parameters) but not on information in
@@ -74,7 +75,9 @@ public:
     /**
      * Compute the coefficient which, when divided by the periodic box volume, gives the
      * long range correction to the energy.  If the Force computes parameter derivatives,
-     * also compute the corresponding derivatives of the correction.
+     * also compute the corresponding derivatives of the correction.  The integral for each
+     * pair of particle classes is stored in the LongRangeCorrectionData, and only the ones
+     * affected by changes to global parameters are recomputed on later calls.
      */
     static void calcLongRangeCorrection(const CustomNonbondedForce& force, LongRangeCorrectionData& data, const Context& context, double& coefficient, std::vector<double>& derivatives, ThreadPool& threads);
 private:
@@ -94,6 +97,10 @@ public:
     std::vector<Lepton::CompiledVectorExpression> energyExpression;
     std::vector<std::vector<Lepton::CompiledVectorExpression> > derivExpressions;
     std::vector<Lepton::CompiledExpression> computedValueExpressions;
+    std::vector<double> cachedGlobalValues;
+    std::vector<std::vector<double> > cachedComputedValues;
+    std::vector<double> integrals;
+    std::vector<char> hasIntegral;
 };
 
 } // namespace OpenMM
@@ -0,0 +1,79 @@
+#ifndef OPENMM_EXPRESSIONCACHE_H_
+#define OPENMM_EXPRESSIONCACHE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "lepton/ParsedExpression.h"
+#include "windowsExport.h"
+#include <string>
+
+namespace OpenMM {
+
+/**
+ * ExpressionCache keeps a process-wide record of expressions that have already been parsed,
+ * optimized, and differentiated.  When many Contexts are created for Systems that use the same
+ * custom expressions, this lets them skip repeating that work.  It only handles expressions that
+ * do not use custom functions, since the meaning of those depends on the function objects, not
+ * just the text.  At most 1000 expressions and 1000 derivatives are kept.  Once that many have
+ * been cached, the oldest ones are discarded.  All methods are thread safe.
+ */
+
+class OPENMM_EXPORT ExpressionCache {
+public:
+    /**
+     * Parse an expression and optimize it.
+     *
+     * @param expression   the expression to parse
+     * @return the optimized expression
+     */
+    static Lepton::ParsedExpression getExpression(const std::string& expression);
+    /**
+     * Get the optimized derivative of an expression with respect to a variable.
+     *
+     * @param expression   the expression to differentiate
+     * @param variable     the variable with respect to which to take the derivative
+     * @return the optimized derivative
+     */
+    static Lepton::ParsedExpression getDerivative(const std::string& expression, const std::string& variable);
+    /**
+     * Get the total number of expressions and derivatives that are currently cached.
+     */
+    static int getCacheSize();
+    /**
+     * Discard all cached expressions and derivatives.
+     */
+    static void clearCache();
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_EXPRESSIONCACHE_H_*/
@@ -62,6 +62,7 @@ public:
     }
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context);
+    void updateParametersInContext(ContextImpl& context, int firstAngle, int numAngles);
 private:
     const HarmonicAngleForce& owner;
     Kernel kernel;
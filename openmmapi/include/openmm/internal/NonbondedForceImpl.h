@@ -74,6 +74,13 @@ public:
      * Particle Mesh Ewald.
      */
     static void calcPMEParameters(const System& system, const NonbondedForce& force, double& alpha, int& xsize, int& ysize, int& zsize, bool lj);
+    /**
+     * This is a utility routine that estimates the relative errors in the direct and reciprocal space
+     * parts of Particle Mesh Ewald.  It uses the same error model that calcPMEParameters() uses to select
+     * parameters from the error tolerance, so it can be used to see how accurate a set of explicitly
+     * specified parameters is expected to be.  The reciprocal space error is the largest one for any axis.
+     */
+    static void estimatePMEError(const System& system, const NonbondedForce& force, double& directError, double& reciprocalError, bool lj);
     /**
      * Compute the coefficient which, when divided by the periodic box volume, gives the
      * long range dispersion correction to the energy.
@@ -33,10 +33,13 @@
  * -------------------------------------------------------------------------- */
 
 #include "windowsExport.h"
+#include <cstddef>
 #include <vector>
 
 namespace OpenMM {
 
+class ThreadPool;
+
 /**
  * SplineFitter provides routines for performing cubic spline interpolation.
  */
@@ -167,8 +170,10 @@ public:
      *                 and ysize is the length of y.
      * @param periodic whether the interpolated function is periodic
      * @param c        on exit, this contains the spline coefficients at each of the data points
+     * @param threads  the ThreadPool to use for parallelizing the calculation.  If this is NULL, a new
+     *                 ThreadPool is created.
      */
-    static void create3DSpline(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& values, bool periodic, std::vector<std::vector<double> >& c);
+    static void create3DSpline(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& values, bool periodic, std::vector<std::vector<double> >& c, ThreadPool* threads=NULL);
     /**
      * Fit a natural cubic spline surface f(x,y,z) to a 3D set of data points.  The resulting spline interpolates all the
      * data points, has a continuous second derivative everywhere, and has a second derivative of 0 at the boundary.
@@ -215,7 +220,60 @@ public:
      * @param dz     on exit, the z derivative of the spline at the specified point
      */
     static void evaluate3DSplineDerivatives(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& values, const std::vector<std::vector<double> >& c, double u, double v, double w, double& dx, double& dy, double &dz);
+    /**
+     * Fit the same spline as create3DSpline(), but instead of computing 64 coefficients for every patch, record
+     * the value and derivatives of the spline at every data point.  Within each patch the spline is the tricubic
+     * Hermite interpolant of the values at its eight corners, so this is all that is needed to evaluate it, and
+     * it takes one eighth as much memory.
+     *
+     * @param x        the values of the first independent variable at the data points to interpolate.  They must
+     *                 be strictly increasing: x[i] > x[i-1].
+     * @param y        the values of the second independent variable at the data points to interpolate.  They must
+     *                 be strictly increasing: y[i] > y[i-1].
+     * @param z        the values of the third independent variable at the data points to interpolate.  They must
+     *                 be strictly increasing: z[i] > z[i-1].
+     * @param values   the values of the dependent variable at the data points to interpolate.  They must be ordered
+     *                 so that values[i+xsize*j+xsize*ysize*k] = f(x[i],y[j],z[k]), where xsize is the length of x
+     *                 and ysize is the length of y.
+     * @param periodic whether the interpolated function is periodic
+     * @param d        on exit, this contains 8 values for each data point, in the same order as values: f, df/dx,
+     *                 df/dy, df/dz, d2f/dxdy, d2f/dxdz, d2f/dydz, and d3f/dxdydz
+     * @param threads  the ThreadPool to use for parallelizing the calculation.  If this is NULL, a new
+     *                 ThreadPool is created.
+     */
+    static void create3DHermiteSpline(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& values, bool periodic, std::vector<double>& d, ThreadPool* threads=NULL);
+    /**
+     * Evaluate a 3D spline generated by create3DHermiteSpline().
+     *
+     * @param x      the values of the first independent variable at the data points to interpolate
+     * @param y      the values of the second independent variable at the data points to interpolate
+     * @param z      the values of the third independent variable at the data points to interpolate
+     * @param d      the values and derivatives at the data points that were calculated by create3DHermiteSpline()
+     * @param u      the value of the first independent variable at which to evaluate the spline
+     * @param v      the value of the second independent variable at which to evaluate the spline
+     * @param w      the value of the third independent variable at which to evaluate the spline
+     * @return the value of the spline at the specified point
+     */
+    static double evaluate3DHermiteSpline(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& d, double u, double v, double w);
+    /**
+     * Evaluate the derivatives of a 3D spline generated by create3DHermiteSpline().
+     *
+     * @param x      the values of the first independent variable at the data points to interpolate
+     * @param y      the values of the second independent variable at the data points to interpolate
+     * @param z      the values of the third independent variable at the data points to interpolate
+     * @param d      the values and derivatives at the data points that were calculated by create3DHermiteSpline()
+     * @param u      the value of the first independent variable at which to evaluate the spline
+     * @param v      the value of the second independent variable at which to evaluate the spline
+     * @param w      the value of the third independent variable at which to evaluate the spline
+     * @param dx     on exit, the x derivative of the spline at the specified point
+     * @param dy     on exit, the y derivative of the spline at the specified point
+     * @param dz     on exit, the z derivative of the spline at the specified point
+     */
+    static void evaluate3DHermiteSplineDerivatives(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& d, double u, double v, double w, double& dx, double& dy, double &dz);
 private:
+    static void find3DSplinePatch(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, double u, double v, double w, int& lowerx, int& lowery, int& lowerz);
+    static double evaluate3DHermitePatch(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z, const std::vector<double>& d,
+                                         double u, double v, double w, int derivAxis);
     static void solveTridiagonalMatrix(const std::vector<double>& a, const std::vector<double>& b, const std::vector<double>& c, const std::vector<double>& rhs, std::vector<double>& sol);
 };
 
@@ -34,6 +34,7 @@
 
 #define NOMINMAX
 #include "windowsExport.h"
+#include <atomic>
 #include <functional>
 #include <pthread.h>
 #include <vector>
@@ -49,6 +50,17 @@ namespace OpenMM {
  * next syncThreads(), and the final call waits until they exit from the Task's execute() method.
  * After calling waitForThreads() to block at a synchronization point, the parent thread should
  * call resumeThreads() to instruct the worker threads to resume.
+ *
+ * Threads that are waiting, either in syncThreads() or waitForThreads(), first spin for a short
+ * time before blocking on a condition variable.  When the work between synchronization points is
+ * short, this avoids the cost of putting threads to sleep and waking them up again.  Spinning is
+ * enabled by default only when there are at least as many logical cores as worker threads, since
+ * otherwise spinning threads would compete with the ones doing useful work.
+ *
+ * A pool can be shared by several independent callers, such as multiple Contexts that are stepped
+ * from different threads.  Call setShared() to enable this.  Each Task then has exclusive use of the
+ * worker threads from the call to execute() until the final waitForThreads(), and other callers
+ * block in execute() until it has completed.
  */
 class OPENMM_EXPORT ThreadPool {
 public:
@@ -88,13 +100,38 @@ public:
      * Instruct the threads to resume running after blocking at a synchronization point.
      */
     void resumeThreads();
+    /**
+     * Get the number of times a waiting thread checks for the condition it is waiting on before
+     * it blocks.  A value of 0 means threads block immediately.
+     */
+    int getSpinCount() const;
+    /**
+     * Set the number of times a waiting thread checks for the condition it is waiting on before
+     * it blocks.  A value of 0 means threads block immediately.  This should only be called while
+     * no Task is running.
+     */
+    void setSpinCount(int count);
+    /**
+     * Get whether this pool may be shared by multiple callers.
+     */
+    bool getShared() const;
+    /**
+     * Set whether this pool may be shared by multiple callers.  When this is true, execute() blocks
+     * until any Task started by another caller has completed.  This should only be called while no
+     * Task is running.
+     */
+    void setShared(bool shared);
 private:
-    bool isDeleted;
-    int numThreads, waitCount;
+    void beginTask();
+    void endTask();
+    bool isDeleted, isShared, taskActive;
+    int numThreads, spinCount;
+    std::atomic<int> waitCount, completedCount;
+    std::atomic<long long> generation;
     std::vector<pthread_t> thread;
     std::vector<ThreadData*> threadData;
     pthread_cond_t startCondition, endCondition;
-    pthread_mutex_t lock;
+    pthread_mutex_t lock, taskLock;
     Task* currentTask;
     std::function<void (ThreadPool& pool, int)> currentFunction;
 };
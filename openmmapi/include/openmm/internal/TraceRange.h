@@ -0,0 +1,76 @@
+#ifndef OPENMM_TRACE_RANGE_H_
+#define OPENMM_TRACE_RANGE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "windowsExport.h"
+#include <string>
+
+/**
+ * Annotations that mark named ranges of host code, so they appear on the timeline of external
+ * profilers: Nsight Systems through NVTX, and VTune through the ITT API.  Mark a range with
+ *
+ *     OPENMM_TRACE_RANGE("name");
+ *
+ * which lasts until the end of the enclosing scope.  Annotations are only compiled in when OpenMM is
+ * built with OPENMM_ENABLE_TRACE_ANNOTATIONS.  Otherwise the macro expands to nothing, so neither the
+ * range nor the expression for its name costs anything.
+ */
+
+#ifdef OPENMM_TRACE_ANNOTATIONS
+
+namespace OpenMM {
+
+/**
+ * A TraceRange begins a range when it is created and ends it when it is destroyed.  Ranges on a
+ * thread must be strictly nested.  Use OPENMM_TRACE_RANGE rather than creating these directly.
+ */
+class OPENMM_EXPORT TraceRange {
+public:
+    explicit TraceRange(const char* name);
+    explicit TraceRange(const std::string& name);
+    ~TraceRange();
+};
+
+} // namespace OpenMM
+
+#define OPENMM_TRACE_RANGE_NAME2(line) openmmTraceRange##line
+#define OPENMM_TRACE_RANGE_NAME(line) OPENMM_TRACE_RANGE_NAME2(line)
+#define OPENMM_TRACE_RANGE(name) OpenMM::TraceRange OPENMM_TRACE_RANGE_NAME(__LINE__)(name)
+
+#else
+
+#define OPENMM_TRACE_RANGE(name)
+
+#endif
+
+#endif /*OPENMM_TRACE_RANGE_H_*/
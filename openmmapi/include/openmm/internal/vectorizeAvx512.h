@@ -0,0 +1,415 @@
+#ifndef OPENMM_VECTORIZE_AVX512_H_
+#define OPENMM_VECTORIZE_AVX512_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "vectorize.h"
+#include "hardware.h"
+#include <immintrin.h>
+
+// This file defines classes and functions to simplify vectorizing code with AVX-512.
+
+bool isAvx512Supported() {
+
+    // As in isAvx2Supported(), use a CPUID that sets the CX register so leaf 7 is reported correctly.
+#if !(defined(_WIN32) || defined(WIN32))
+    auto cpuid = [](int output[4], int functionnumber) {
+        int a, b, c, d;
+        __asm("cpuid" : "=a"(a),"=b"(b),"=c"(c),"=d"(d) : "a"(functionnumber), "c"(0) : );
+        output[0] = a;
+        output[1] = b;
+        output[2] = c;
+        output[3] = d;
+    };
+#endif
+
+    int cpuInfo[4];
+    cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7)
+        return false;
+
+    // The OS must have enabled XSAVE, and must save the opmask and full ZMM registers on
+    // context switches, or the instructions cannot be used even if the CPU has them.
+
+    cpuid(cpuInfo, 1);
+    if ((cpuInfo[2] & ((int) 1 << 27)) == 0)
+        return false;
+#if defined(_WIN32) || defined(WIN32)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low, xcr0High;
+    __asm("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0) : );
+    unsigned long long xcr0 = xcr0Low | ((unsigned long long) xcr0High << 32);
+#endif
+    if ((xcr0 & 0xE6) != 0xE6)
+        return false;
+    cpuid(cpuInfo, 7);
+    return ((cpuInfo[1] & ((int) 1 << 16)) != 0);
+}
+
+class ivec16;
+
+/**
+ * A sixteen element vector of floats.  Only AVX-512F instructions are used, so this works on every
+ * processor that supports AVX-512.
+ *
+ * Comparisons produce full vectors with all bits set in the elements where they are true, exactly
+ * like fvec4 and fvec8, so code written for those types works unchanged.  The blend functions
+ * convert them to a hardware mask register using the sign bit of each element.
+ */
+class fvec16 {
+public:
+    __m512 val;
+
+    fvec16() = default;
+    fvec16(float v) : val(_mm512_set1_ps(v)) {}
+    fvec16(__m512 v) : val(v) {}
+    fvec16(const float* v) : val(_mm512_loadu_ps(v)) {}
+
+    /** Create a vector by gathering individual indexes of data from a table. Element i of the vector will
+     * be loaded from table[idx[i]].
+     * @param table The table from which to do a lookup.
+     * @param indexes The indexes to gather.
+     */
+    fvec16(const float* table, const int32_t idx[16])
+        : val(_mm512_i32gather_ps(_mm512_loadu_si512(idx), table, 4)) {}
+
+    operator __m512() const {
+        return val;
+    }
+    void store(float* v) const {
+        _mm512_storeu_ps(v, val);
+    }
+    fvec16 operator+(fvec16 other) const {
+        return _mm512_add_ps(val, other);
+    }
+    fvec16 operator-(fvec16 other) const {
+        return _mm512_sub_ps(val, other);
+    }
+    fvec16 operator*(fvec16 other) const {
+        return _mm512_mul_ps(val, other);
+    }
+    fvec16 operator/(fvec16 other) const {
+        return _mm512_div_ps(val, other);
+    }
+    void operator+=(fvec16 other) {
+        val = _mm512_add_ps(val, other);
+    }
+    void operator-=(fvec16 other) {
+        val = _mm512_sub_ps(val, other);
+    }
+    void operator*=(fvec16 other) {
+        val = _mm512_mul_ps(val, other);
+    }
+    void operator/=(fvec16 other) {
+        val = _mm512_div_ps(val, other);
+    }
+    fvec16 operator-() const {
+        return _mm512_sub_ps(_mm512_setzero_ps(), val);
+    }
+    fvec16 operator&(fvec16 other) const {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(val), _mm512_castps_si512(other.val)));
+    }
+    fvec16 operator|(fvec16 other) const {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(val), _mm512_castps_si512(other.val)));
+    }
+    fvec16 operator==(fvec16 other) const {
+        return fromMask(_mm512_cmp_ps_mask(val, other, _CMP_EQ_OQ));
+    }
+    fvec16 operator!=(fvec16 other) const {
+        return fromMask(_mm512_cmp_ps_mask(val, other, _CMP_NEQ_OQ));
+    }
+    fvec16 operator>(fvec16 other) const {
+        return fromMask(_mm512_cmp_ps_mask(val, other, _CMP_GT_OQ));
+    }
+    fvec16 operator<(fvec16 other) const {
+        return fromMask(_mm512_cmp_ps_mask(val, other, _CMP_LT_OQ));
+    }
+    fvec16 operator>=(fvec16 other) const {
+        return fromMask(_mm512_cmp_ps_mask(val, other, _CMP_GE_OQ));
+    }
+    fvec16 operator<=(fvec16 other) const {
+        return fromMask(_mm512_cmp_ps_mask(val, other, _CMP_LE_OQ));
+    }
+    operator ivec16() const;
+
+    /**
+     * Convert a hardware mask register into a full vector of elements.
+     */
+    static fvec16 fromMask(__mmask16 mask) {
+        return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(mask, -1));
+    }
+
+    /**
+     * Convert a full vector of elements into a hardware mask register.  Only the sign bit
+     * of each element is used.
+     */
+    __mmask16 toMask() const {
+        return _mm512_cmplt_epi32_mask(_mm512_castps_si512(val), _mm512_setzero_si512());
+    }
+
+    /**
+     * Convert an integer bitmask into a full vector of elements which can be used
+     * by the blend function.
+     */
+    static fvec16 expandBitsToMask(int bitmask);
+};
+
+/**
+ * A sixteen element vector of ints.
+ */
+class ivec16 {
+public:
+    __m512i val;
+
+    ivec16() {}
+    ivec16(int v) : val(_mm512_set1_epi32(v)) {}
+    ivec16(__m512i v) : val(v) {}
+    ivec16(const int* v) : val(_mm512_loadu_si512(v)) {}
+    operator __m512i() const {
+        return val;
+    }
+    void store(int* v) const {
+        _mm512_storeu_si512(v, val);
+    }
+    ivec16 operator&(ivec16 other) const {
+        return _mm512_and_si512(val, other.val);
+    }
+    ivec16 operator|(ivec16 other) const {
+        return _mm512_or_si512(val, other.val);
+    }
+    operator fvec16() const;
+};
+
+// Conversion operators.
+
+inline fvec16::operator ivec16() const {
+    return _mm512_cvttps_epi32(val);
+}
+
+inline ivec16::operator fvec16() const {
+    return _mm512_cvtepi32_ps(val);
+}
+
+inline fvec16 fvec16::expandBitsToMask(int bitmask) {
+    // Each bit of the mask directly selects one element, so no shuffling is needed.
+    return fromMask((__mmask16) bitmask);
+}
+
+// Functions that operate on fvec16s.
+
+static inline fvec16 floor(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 ceil(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 round(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 min(fvec16 v1, fvec16 v2) {
+    return fvec16(_mm512_min_ps(v1.val, v2.val));
+}
+
+static inline fvec16 max(fvec16 v1, fvec16 v2) {
+    return fvec16(_mm512_max_ps(v1.val, v2.val));
+}
+
+static inline fvec16 abs(fvec16 v) {
+    return fvec16(_mm512_abs_ps(v.val));
+}
+
+static inline fvec16 sqrt(fvec16 v) {
+    return fvec16(_mm512_sqrt_ps(v.val));
+}
+
+static inline fvec16 rsqrt(fvec16 v) {
+    // Initial estimate of rsqrt().  This is accurate to 14 bits, more than the 12 bits
+    // given by the SSE and AVX versions.
+
+    fvec16 y(_mm512_rsqrt14_ps(v.val));
+
+    // Perform an iteration of Newton refinement.
+
+    fvec16 x2 = v*0.5f;
+    y *= fvec16(1.5f)-x2*y*y;
+    return y;
+}
+
+static inline float reduceAdd(fvec16 v) {
+    return _mm512_reduce_add_ps(v.val);
+}
+
+/**
+ * Sum the four 128 bit lanes of a vector to produce a single fvec4.
+ */
+static inline fvec4 reduceLanes(fvec16 v) {
+    const __m256 lower = _mm512_castps512_ps256(v.val);
+    const __m256 upper = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v.val), 1));
+    const __m256 sum = _mm256_add_ps(lower, upper);
+    return fvec4(_mm256_castps256_ps128(sum))+fvec4(_mm256_extractf128_ps(sum, 1));
+}
+
+/**
+ * Transpose one 128 bit lane of four vectors into four fvec4s.
+ */
+template <int LANE>
+static inline void transposeLane(fvec16 in1, fvec16 in2, fvec16 in3, fvec16 in4, fvec4 out[16]) {
+    fvec4 o1 = _mm512_extractf32x4_ps(in1.val, LANE);
+    fvec4 o2 = _mm512_extractf32x4_ps(in2.val, LANE);
+    fvec4 o3 = _mm512_extractf32x4_ps(in3.val, LANE);
+    fvec4 o4 = _mm512_extractf32x4_ps(in4.val, LANE);
+    _MM_TRANSPOSE4_PS(o1, o2, o3, o4);
+    out[4*LANE] = o1;
+    out[4*LANE+1] = o2;
+    out[4*LANE+2] = o3;
+    out[4*LANE+3] = o4;
+}
+
+/**
+ * Given 4 input vectors of 16 elements, transpose them to form 16 output vectors of 4 elements.
+ */
+static inline void transpose(fvec16 in1, fvec16 in2, fvec16 in3, fvec16 in4, fvec4 out[16]) {
+    transposeLane<0>(in1, in2, in3, in4, out);
+    transposeLane<1>(in1, in2, in3, in4, out);
+    transposeLane<2>(in1, in2, in3, in4, out);
+    transposeLane<3>(in1, in2, in3, in4, out);
+}
+
+/**
+ * Combine four fvec4s into the four 128 bit lanes of an fvec16.
+ */
+static inline fvec16 combineLanes(fvec4 v1, fvec4 v2, fvec4 v3, fvec4 v4) {
+    __m512 v = _mm512_castps128_ps512(v1);
+    v = _mm512_insertf32x4(v, v2, 1);
+    v = _mm512_insertf32x4(v, v3, 2);
+    return _mm512_insertf32x4(v, v4, 3);
+}
+
+/** Given a vec4[16] input array, generate 4 vec16 outputs. The first output contains all the first elements
+ * the second output the second elements, and so on. Note that the prototype is essentially differing only
+ * in output type so it can be overloaded in other SIMD fvec types.
+ */
+static inline void transpose(const fvec4 in[16], fvec16& out1, fvec16& out2, fvec16& out3, fvec16& out4) {
+    fvec4 a1 = in[0], a2 = in[1], a3 = in[2], a4 = in[3];
+    fvec4 b1 = in[4], b2 = in[5], b3 = in[6], b4 = in[7];
+    fvec4 c1 = in[8], c2 = in[9], c3 = in[10], c4 = in[11];
+    fvec4 d1 = in[12], d2 = in[13], d3 = in[14], d4 = in[15];
+    _MM_TRANSPOSE4_PS(a1, a2, a3, a4);
+    _MM_TRANSPOSE4_PS(b1, b2, b3, b4);
+    _MM_TRANSPOSE4_PS(c1, c2, c3, c4);
+    _MM_TRANSPOSE4_PS(d1, d2, d3, d4);
+    out1 = combineLanes(a1, b1, c1, d1);
+    out2 = combineLanes(a2, b2, c2, d2);
+    out3 = combineLanes(a3, b3, c3, d3);
+    out4 = combineLanes(a4, b4, c4, d4);
+}
+
+// Functions that operate on ivec16s.
+
+static inline bool any(ivec16 v) {
+    return _mm512_test_epi32_mask(v, v) != 0;
+}
+
+static inline bool any(fvec16 v) {
+    return v.toMask() != 0;
+}
+
+// Mathematical operators involving a scalar and a vector.
+
+static inline fvec16 operator+(float v1, fvec16 v2) {
+    return fvec16(v1)+v2;
+}
+
+static inline fvec16 operator-(float v1, fvec16 v2) {
+    return fvec16(v1)-v2;
+}
+
+static inline fvec16 operator*(float v1, fvec16 v2) {
+    return fvec16(v1)*v2;
+}
+
+static inline fvec16 operator/(float v1, fvec16 v2) {
+    return fvec16(v1)/v2;
+}
+
+// Operation for blending fvec16 from a full bitmask.
+static inline fvec16 blend(fvec16 v1, fvec16 v2, fvec16 mask) {
+    return fvec16(_mm512_mask_blend_ps(mask.toMask(), v1.val, v2.val));
+}
+
+static inline fvec16 blendZero(fvec16 v, fvec16 mask) {
+    return fvec16(_mm512_maskz_mov_ps(mask.toMask(), v.val));
+}
+
+/**
+ * Given a table of floating-point values and a set of indexes, perform a gather read into a pair
+ * of vectors. The first result vector contains the values at the given indexes, and the second
+ * result vector contains the values from each respective index+1.
+ */
+static inline void gatherVecPair(const float* table, ivec16 index, fvec16& out0, fvec16& out1) {
+    // Load each pair of values as a single 64 bit element.  This takes two gathers of eight
+    // elements each, giving the interleaved pairs for the lower and upper halves of the indexes.
+
+    const __m256i lowerIdx = _mm512_castsi512_si256(index);
+    const __m256i upperIdx = _mm512_extracti64x4_epi64(index, 1);
+    const __m512 lower = _mm512_castpd_ps(_mm512_i32gather_pd(lowerIdx, table, 4));
+    const __m512 upper = _mm512_castpd_ps(_mm512_i32gather_pd(upperIdx, table, 4));
+
+    // Separate the even and odd elements.
+
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    out0 = _mm512_permutex2var_ps(lower, even, upper);
+    out1 = _mm512_permutex2var_ps(lower, odd, upper);
+}
+
+/**
+ * Given 3 vectors of floating-point data, reduce them to a single 3-element position
+ * value by adding all the elements in each vector.  The fourth element of the result
+ * is undefined.
+ */
+static inline fvec4 reduceToVec3(fvec16 x, fvec16 y, fvec16 z) {
+    // Reduce each input to four elements, then transpose so each column can be summed at once.
+
+    fvec4 rx = reduceLanes(x);
+    fvec4 ry = reduceLanes(y);
+    fvec4 rz = reduceLanes(z);
+    fvec4 rw = 0.0f;
+    _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+    return rx+ry+rz+rw;
+}
+
+#endif /*OPENMM_VECTORIZE_AVX512_H_*/
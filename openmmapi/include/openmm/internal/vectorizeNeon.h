@@ -0,0 +1,309 @@
+#ifndef OPENMM_VECTORIZE_NEON8_H_
+#define OPENMM_VECTORIZE_NEON8_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "vectorize_neon.h"
+
+// This file defines classes and functions to simplify vectorizing code with eight element
+// vectors on ARM.  NEON registers hold only four floats, so each vector is a pair of them.
+// That still gives the nonbonded kernels eight atom blocks, and the two halves are independent
+// so they can be issued in parallel.
+
+class ivec8;
+
+/**
+ * An eight element vector of floats.
+ */
+class fvec8 {
+public:
+    fvec4 lower, upper;
+
+    fvec8() = default;
+    fvec8(float v) : lower(v), upper(v) {}
+    fvec8(float v1, float v2, float v3, float v4, float v5, float v6, float v7, float v8) : lower(v1, v2, v3, v4), upper(v5, v6, v7, v8) {}
+    fvec8(fvec4 lower, fvec4 upper) : lower(lower), upper(upper) {}
+    fvec8(const float* v) : lower(v), upper(v+4) {}
+
+    /** Create a vector by gathering individual indexes of data from a table. Element i of the vector will
+     * be loaded from table[idx[i]].
+     * @param table The table from which to do a lookup.
+     * @param indexes The indexes to gather.
+     */
+    fvec8(const float* table, const int32_t idx[8]) : lower(table, idx), upper(table, idx+4) {}
+
+    fvec4 lowerVec() const {
+        return lower;
+    }
+    fvec4 upperVec() const {
+        return upper;
+    }
+    void store(float* v) const {
+        lower.store(v);
+        upper.store(v+4);
+    }
+    fvec8 operator+(fvec8 other) const {
+        return fvec8(lower+other.lower, upper+other.upper);
+    }
+    fvec8 operator-(fvec8 other) const {
+        return fvec8(lower-other.lower, upper-other.upper);
+    }
+    fvec8 operator*(fvec8 other) const {
+        return fvec8(lower*other.lower, upper*other.upper);
+    }
+    fvec8 operator/(fvec8 other) const {
+        return fvec8(lower/other.lower, upper/other.upper);
+    }
+    void operator+=(fvec8 other) {
+        lower += other.lower;
+        upper += other.upper;
+    }
+    void operator-=(fvec8 other) {
+        lower -= other.lower;
+        upper -= other.upper;
+    }
+    void operator*=(fvec8 other) {
+        lower *= other.lower;
+        upper *= other.upper;
+    }
+    void operator/=(fvec8 other) {
+        lower /= other.lower;
+        upper /= other.upper;
+    }
+    fvec8 operator-() const {
+        return fvec8(-lower, -upper);
+    }
+    fvec8 operator&(fvec8 other) const {
+        return fvec8(lower&other.lower, upper&other.upper);
+    }
+    fvec8 operator|(fvec8 other) const {
+        return fvec8(lower|other.lower, upper|other.upper);
+    }
+    ivec8 operator==(fvec8 other) const;
+    ivec8 operator!=(fvec8 other) const;
+    ivec8 operator>(fvec8 other) const;
+    ivec8 operator<(fvec8 other) const;
+    ivec8 operator>=(fvec8 other) const;
+    ivec8 operator<=(fvec8 other) const;
+    operator ivec8() const;
+
+    /**
+     * Convert an integer bitmask into a full vector of elements which can be used
+     * by the blend function.
+     */
+    static ivec8 expandBitsToMask(int bitmask);
+};
+
+/**
+ * An eight element vector of ints.
+ */
+class ivec8 {
+public:
+    ivec4 lower, upper;
+
+    ivec8() {}
+    ivec8(int v) : lower(v), upper(v) {}
+    ivec8(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8) : lower(v1, v2, v3, v4), upper(v5, v6, v7, v8) {}
+    ivec8(ivec4 lower, ivec4 upper) : lower(lower), upper(upper) {}
+    ivec8(const int* v) : lower(v), upper(v+4) {}
+    ivec4 lowerVec() const {
+        return lower;
+    }
+    ivec4 upperVec() const {
+        return upper;
+    }
+    void store(int* v) const {
+        lower.store(v);
+        upper.store(v+4);
+    }
+    ivec8 operator&(ivec8 other) const {
+        return ivec8(lower&other.lower, upper&other.upper);
+    }
+    ivec8 operator|(ivec8 other) const {
+        return ivec8(lower|other.lower, upper|other.upper);
+    }
+    operator fvec8() const;
+};
+
+// Conversion operators.
+
+inline fvec8::operator ivec8() const {
+    return ivec8(ivec4(lower), ivec4(upper));
+}
+
+inline ivec8::operator fvec8() const {
+    return fvec8(fvec4(lower), fvec4(upper));
+}
+
+inline ivec8 fvec8::expandBitsToMask(int bitmask) {
+    return ivec8(fvec4::expandBitsToMask(bitmask), fvec4::expandBitsToMask(bitmask>>4));
+}
+
+// Comparison operators
+
+inline ivec8 fvec8::operator==(fvec8 other) const {
+    return ivec8(lower == other.lower, upper == other.upper);
+}
+
+inline ivec8 fvec8::operator!=(fvec8 other) const {
+    return ivec8(lower != other.lower, upper != other.upper);
+}
+
+inline ivec8 fvec8::operator>(fvec8 other) const {
+    return ivec8(lower > other.lower, upper > other.upper);
+}
+
+inline ivec8 fvec8::operator<(fvec8 other) const {
+    return ivec8(lower < other.lower, upper < other.upper);
+}
+
+inline ivec8 fvec8::operator>=(fvec8 other) const {
+    return ivec8(lower >= other.lower, upper >= other.upper);
+}
+
+inline ivec8 fvec8::operator<=(fvec8 other) const {
+    return ivec8(lower <= other.lower, upper <= other.upper);
+}
+
+// Functions that operate on fvec8s.
+
+static inline fvec8 floor(fvec8 v) {
+    return fvec8(floor(v.lower), floor(v.upper));
+}
+
+static inline fvec8 ceil(fvec8 v) {
+    return fvec8(ceil(v.lower), ceil(v.upper));
+}
+
+static inline fvec8 round(fvec8 v) {
+    return fvec8(round(v.lower), round(v.upper));
+}
+
+static inline fvec8 min(fvec8 v1, fvec8 v2) {
+    return fvec8(min(v1.lower, v2.lower), min(v1.upper, v2.upper));
+}
+
+static inline fvec8 max(fvec8 v1, fvec8 v2) {
+    return fvec8(max(v1.lower, v2.lower), max(v1.upper, v2.upper));
+}
+
+static inline fvec8 abs(fvec8 v) {
+    return fvec8(abs(v.lower), abs(v.upper));
+}
+
+static inline fvec8 sqrt(fvec8 v) {
+    return fvec8(sqrt(v.lower), sqrt(v.upper));
+}
+
+static inline fvec8 rsqrt(fvec8 v) {
+    return fvec8(rsqrt(v.lower), rsqrt(v.upper));
+}
+
+static inline float reduceAdd(fvec8 v) {
+    return reduceAdd(v.lower+v.upper);
+}
+
+/** Given a vec4[8] input array, generate 4 vec8 outputs. The first output contains all the first elements
+ * the second output the second elements, and so on. Note that the prototype is essentially differing only
+ * in output type so it can be overloaded in other SIMD fvec types.
+ */
+static inline void transpose(const fvec4 in[8], fvec8& out1, fvec8& out2, fvec8& out3, fvec8& out4) {
+    transpose(in, out1.lower, out2.lower, out3.lower, out4.lower);
+    transpose(in+4, out1.upper, out2.upper, out3.upper, out4.upper);
+}
+
+/**
+ * Given 4 input vectors of 8 elements, transpose them to form 8 output vectors of 4 elements.
+ */
+static inline void transpose(fvec8 in1, fvec8 in2, fvec8 in3, fvec8 in4, fvec4 out[8]) {
+    transpose(in1.lower, in2.lower, in3.lower, in4.lower, out);
+    transpose(in1.upper, in2.upper, in3.upper, in4.upper, out+4);
+}
+
+// Functions that operate on ivec8s.
+
+static inline bool any(ivec8 v) {
+    return any(v.lower | v.upper);
+}
+
+// Mathematical operators involving a scalar and a vector.
+
+static inline fvec8 operator+(float v1, fvec8 v2) {
+    return fvec8(v1)+v2;
+}
+
+static inline fvec8 operator-(float v1, fvec8 v2) {
+    return fvec8(v1)-v2;
+}
+
+static inline fvec8 operator*(float v1, fvec8 v2) {
+    return fvec8(v1)*v2;
+}
+
+static inline fvec8 operator/(float v1, fvec8 v2) {
+    return fvec8(v1)/v2;
+}
+
+// Operations for blending fvec8s based on an ivec8.
+
+static inline fvec8 blend(fvec8 v1, fvec8 v2, ivec8 mask) {
+    return fvec8(blend(v1.lower, v2.lower, mask.lower), blend(v1.upper, v2.upper, mask.upper));
+}
+
+static inline fvec8 blendZero(fvec8 v, ivec8 mask) {
+    return fvec8(blendZero(v.lower, mask.lower), blendZero(v.upper, mask.upper));
+}
+
+static inline ivec8 blendZero(ivec8 v, ivec8 mask) {
+    return v & mask;
+}
+
+/**
+ * Given a table of floating-point values and a set of indexes, perform a gather read into a pair
+ * of vectors. The first result vector contains the values at the given indexes, and the second
+ * result vector contains the values from each respective index+1.
+ */
+static inline void gatherVecPair(const float* table, ivec8 index, fvec8& out0, fvec8& out1) {
+    gatherVecPair(table, index.lower, out0.lower, out1.lower);
+    gatherVecPair(table, index.upper, out0.upper, out1.upper);
+}
+
+/**
+ * Given 3 vectors of floating-point data, reduce them to a single 3-element position
+ * value by adding all the elements in each vector.  The fourth element of the result
+ * is undefined.
+ */
+static inline fvec4 reduceToVec3(fvec8 x, fvec8 y, fvec8 z) {
+    return reduceToVec3(x.lower+x.upper, y.lower+y.upper, z.lower+z.upper);
+}
+
+#endif /*OPENMM_VECTORIZE_NEON8_H_*/
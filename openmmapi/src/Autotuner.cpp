@@ -0,0 +1,311 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/Autotuner.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include "SHA1.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+struct Autotuner::Trial {
+    bool succeeded;
+    string error;
+    double timePerStep, forceError;
+    vector<Vec3> forces;
+};
+
+static string describe(const string& property, const string& value) {
+    return property+"="+value;
+}
+
+Autotuner::Autotuner(Platform& platform, const map<string, string>& properties) : platform(platform), fixedProperties(properties),
+        numSteps(200), forceTolerance(1e-4), useCache(true), loadedFromCache(false) {
+}
+
+Platform& Autotuner::getPlatform() {
+    return platform;
+}
+
+void Autotuner::addCandidates(const string& property, const vector<string>& values) {
+    if (values.empty())
+        throw OpenMMException("Autotuner: no candidate values were specified for "+property);
+    for (auto& c : candidates)
+        if (c.first == property)
+            throw OpenMMException("Autotuner: candidates for "+property+" were already specified");
+    if (fixedProperties.find(property) != fixedProperties.end())
+        throw OpenMMException("Autotuner: "+property+" is a fixed property and cannot also be tuned");
+    candidates.push_back(make_pair(property, values));
+}
+
+int Autotuner::getNumSteps() const {
+    return numSteps;
+}
+
+void Autotuner::setNumSteps(int steps) {
+    if (steps < 1)
+        throw OpenMMException("Autotuner: the number of steps must be positive");
+    numSteps = steps;
+}
+
+double Autotuner::getForceTolerance() const {
+    return forceTolerance;
+}
+
+void Autotuner::setForceTolerance(double tolerance) {
+    forceTolerance = tolerance;
+}
+
+bool Autotuner::getUseCache() const {
+    return useCache;
+}
+
+void Autotuner::setUseCache(bool use) {
+    useCache = use;
+}
+
+const map<string, string>& Autotuner::getSelectedProperties() const {
+    return selectedProperties;
+}
+
+const string& Autotuner::getReport() const {
+    return report;
+}
+
+bool Autotuner::getLoadedFromCache() const {
+    return loadedFromCache;
+}
+
+Context* Autotuner::createContext(const System& system, Integrator& integrator, const vector<Vec3>& positions) {
+    if (positions.size() != system.getNumParticles())
+        throw OpenMMException("Autotuner: the number of positions does not match the number of particles in the System");
+    report.clear();
+    loadedFromCache = false;
+    stringstream out;
+
+    // Start with the first candidate for every property.  The initial Context also tells us
+    // the values of the Platform's other properties, which identify the hardware.
+
+    map<string, string> current = fixedProperties;
+    for (auto& c : candidates)
+        current[c.first] = c.second[0];
+    unique_ptr<Integrator> initialIntegrator(XmlSerializer::clone<Integrator>(integrator));
+    unique_ptr<Context> initialContext;
+    try {
+        initialContext.reset(new Context(system, *initialIntegrator, platform, current));
+    }
+    catch (const exception& e) {
+        throw OpenMMException(string("Autotuner: failed to create a Context with the initial configuration: ")+e.what());
+    }
+    stringstream key;
+    XmlSerializer::serialize<System>(&system, "System", key);
+    XmlSerializer::serialize<Integrator>(&integrator, "Integrator", key);
+    key << platform.getName() << '\n';
+    for (auto& c : candidates) {
+        key << c.first;
+        for (const string& value : c.second)
+            key << '\t' << value;
+        key << '\n';
+    }
+    for (const string& name : platform.getPropertyNames())
+        key << name << '=' << platform.getPropertyValue(*initialContext, name) << '\n';
+    string cacheFile = getCacheFile(key.str());
+
+    // See whether we already have a result for this combination.
+
+    bool found = false;
+    if (useCache) {
+        ifstream in(cacheFile.c_str());
+        if (in.is_open()) {
+            map<string, string> cached = fixedProperties;
+            string line;
+            while (getline(in, line)) {
+                size_t separator = line.find('=');
+                if (separator != string::npos)
+                    cached[line.substr(0, separator)] = line.substr(separator+1);
+            }
+            found = true;
+            for (auto& c : candidates)
+                if (cached.find(c.first) == cached.end())
+                    found = false;
+            if (found) {
+                current = cached;
+                loadedFromCache = true;
+                out << "Loaded configuration from " << cacheFile << endl;
+            }
+        }
+    }
+    if (!found) {
+        // Time the initial configuration, which is also the reference for the accuracy constraint.
+
+        Trial reference = runTrial(*initialContext, *initialIntegrator, positions, NULL);
+        if (!reference.succeeded)
+            throw OpenMMException("Autotuner: the initial configuration failed: "+reference.error);
+        double bestTime = reference.timePerStep;
+        out << "Initial configuration: " << 1000*bestTime << " ms/step" << endl;
+        initialContext.reset();
+
+        // Tune each property in turn, keeping the best values found so far for the others.
+
+        for (auto& c : candidates) {
+            const string& property = c.first;
+            out << "Tuning " << property << endl;
+            out << "  " << describe(property, current[property]) << ": " << 1000*bestTime << " ms/step" << endl;
+            string bestValue = current[property];
+            for (int i = 1; i < c.second.size(); i++) {
+                map<string, string> properties = current;
+                properties[property] = c.second[i];
+                out << "  " << describe(property, c.second[i]) << ": ";
+                unique_ptr<Integrator> trialIntegrator(XmlSerializer::clone<Integrator>(integrator));
+                unique_ptr<Context> trialContext;
+                Trial trial;
+                try {
+                    trialContext.reset(new Context(system, *trialIntegrator, platform, properties));
+                    trial = runTrial(*trialContext, *trialIntegrator, positions, &reference.forces);
+                }
+                catch (const exception& e) {
+                    trial.succeeded = false;
+                    trial.error = e.what();
+                }
+                if (!trial.succeeded)
+                    out << "failed: " << trial.error << endl;
+                else if (!(trial.forceError <= forceTolerance))
+                    out << "rejected, relative force error " << trial.forceError << " exceeds the tolerance" << endl;
+                else {
+                    out << 1000*trial.timePerStep << " ms/step, relative force error " << trial.forceError << endl;
+                    if (trial.timePerStep < bestTime) {
+                        bestTime = trial.timePerStep;
+                        bestValue = c.second[i];
+                    }
+                }
+            }
+            current[property] = bestValue;
+        }
+
+        // Save the result to the cache.  Write it to a temporary file and then rename it, so another
+        // process never sees a partial file.
+
+        if (useCache) {
+            string tempFile = cacheFile+"."+to_string(chrono::steady_clock::now().time_since_epoch().count());
+            {
+                ofstream cacheOut(tempFile.c_str());
+                for (auto& c : candidates)
+                    cacheOut << c.first << '=' << current[c.first] << endl;
+            }
+            if (rename(tempFile.c_str(), cacheFile.c_str()) != 0)
+                remove(tempFile.c_str());
+        }
+    }
+    initialContext.reset();
+    if (!candidates.empty()) {
+        out << "Selected:";
+        for (auto& c : candidates)
+            out << " " << describe(c.first, current[c.first]);
+        out << endl;
+    }
+    report = out.str();
+    selectedProperties = current;
+    Context* context = new Context(system, integrator, platform, current);
+    context->setPositions(positions);
+    return context;
+}
+
+Autotuner::Trial Autotuner::runTrial(Context& context, Integrator& integrator, const vector<Vec3>& positions, const vector<Vec3>* referenceForces) {
+    Trial trial;
+    trial.succeeded = false;
+    trial.timePerStep = 0.0;
+    trial.forceError = 0.0;
+    try {
+        context.setPositions(positions);
+        trial.forces = context.getState(State::Forces).getForces();
+        if (referenceForces != NULL) {
+            double diff2 = 0.0, norm2 = 0.0;
+            for (int i = 0; i < trial.forces.size(); i++) {
+                Vec3 delta = trial.forces[i]-(*referenceForces)[i];
+                diff2 += delta.dot(delta);
+                norm2 += (*referenceForces)[i].dot((*referenceForces)[i]);
+            }
+            trial.forceError = (norm2 == 0.0 ? sqrt(diff2) : sqrt(diff2/norm2));
+        }
+
+        // Take a few steps before timing, so kernel compilation and other one time setup is excluded.
+        // Retrieving the positions at the end waits for all work to finish.
+
+        integrator.step(10);
+        context.getState(State::Positions);
+        auto start = chrono::steady_clock::now();
+        integrator.step(numSteps);
+        State state = context.getState(State::Positions);
+        trial.timePerStep = chrono::duration<double>(chrono::steady_clock::now()-start).count()/numSteps;
+        for (const Vec3& pos : state.getPositions())
+            if (!(std::isfinite(pos[0]) && std::isfinite(pos[1]) && std::isfinite(pos[2])))
+                throw OpenMMException("simulation produced invalid positions");
+        trial.succeeded = true;
+    }
+    catch (const exception& e) {
+        trial.error = e.what();
+    }
+    return trial;
+}
+
+string Autotuner::getCacheFile(const string& key) const {
+    CSHA1 sha1;
+    sha1.Update((const UINT_8*) key.c_str(), key.size());
+    sha1.Final();
+    UINT_8 hash[20];
+    sha1.GetHash(hash);
+    stringstream file;
+    char* cacheVariable = getenv("OPENMM_CACHE_DIR");
+#ifdef WIN32
+    char* tempVariable = getenv("TEMP");
+    file << (cacheVariable != NULL ? string(cacheVariable) : tempVariable != NULL ? string(tempVariable) : string(".")) << "\\";
+#else
+    char* tempVariable = getenv("TMPDIR");
+    file << (cacheVariable != NULL ? string(cacheVariable) : tempVariable != NULL ? string(tempVariable) : string("/tmp")) << "/";
+#endif
+    file << "openmmAutotune_";
+    file.flags(ios::hex);
+    for (int i = 0; i < 20; i++)
+        file << setw(2) << setfill('0') << (int) hash[i];
+    file << ".txt";
+    return file.str();
+}
@@ -0,0 +1,216 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/CheckpointCompressor.h"
+#include "openmm/OpenMMException.h"
+#include <cstdint>
+#include <cstring>
+
+using namespace OpenMM;
+using namespace std;
+
+// This must be the same length as the magic bytes at the start of an uncompressed checkpoint,
+// so loadCheckpoint() can tell them apart by reading a fixed size header.
+static const char PACKED_MAGIC_BYTES[] = "OpenMM Packed Checkpoint\n";
+static const int PACKED_MAGIC_LENGTH = sizeof(PACKED_MAGIC_BYTES)/sizeof(PACKED_MAGIC_BYTES[0]);
+static const int PACKED_VERSION = 1;
+static const int WORD_SIZE = 8;
+static const int MIN_RUN_LENGTH = 4;
+
+static uint64_t computeHash(const string& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : data) {
+        hash ^= (unsigned char) c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void writeVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char) ((value&0x7F)|0x80));
+        value >>= 7;
+    }
+    out.push_back((char) value);
+}
+
+static uint64_t readVarint(const string& in, size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size())
+            throw OpenMMException("CheckpointCompressor: Unexpected end of data");
+        unsigned char c = in[pos++];
+        value |= ((uint64_t) (c&0x7F)) << shift;
+        if ((c&0x80) == 0)
+            return value;
+    }
+    throw OpenMMException("CheckpointCompressor: Invalid data");
+}
+
+static void writeFixed(string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++)
+        out.push_back((char) ((value >> (8*i))&0xFF));
+}
+
+static uint64_t readFixed(const string& in, size_t& pos) {
+    if (pos+8 > in.size())
+        throw OpenMMException("CheckpointCompressor: Unexpected end of data");
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= ((uint64_t) (unsigned char) in[pos++]) << (8*i);
+    return value;
+}
+
+/**
+ * Compute the location in the original data of each byte in the shuffled data.  Shuffling
+ * stores all bytes with offset 0 modulo the word size, followed by all with offset 1, etc.
+ */
+static size_t shuffledStart(size_t size, int plane) {
+    size_t fullWords = size/WORD_SIZE;
+    size_t remainder = size%WORD_SIZE;
+    return plane*fullWords + min((size_t) plane, remainder);
+}
+
+bool CheckpointCompressor::isCompressed(const string& data) {
+    return (data.size() >= PACKED_MAGIC_LENGTH && memcmp(data.data(), PACKED_MAGIC_BYTES, PACKED_MAGIC_LENGTH) == 0);
+}
+
+string CheckpointCompressor::compress(const string& checkpoint, const string& previous) {
+    // XOR the data against the previous checkpoint, and regroup the bytes by their offset
+    // within each word.
+
+    size_t size = checkpoint.size();
+    size_t overlap = min(size, previous.size());
+    string shuffled(size, '\0');
+    for (int plane = 0; plane < WORD_SIZE; plane++) {
+        size_t j = shuffledStart(size, plane);
+        for (size_t i = plane; i < size; i += WORD_SIZE) {
+            char c = checkpoint[i];
+            if (i < overlap)
+                c ^= previous[i];
+            shuffled[j++] = c;
+        }
+    }
+
+    // Write the header.
+
+    string out(PACKED_MAGIC_BYTES, PACKED_MAGIC_LENGTH);
+    writeVarint(out, PACKED_VERSION);
+    writeVarint(out, previous.size() > 0 ? 1 : 0);
+    writeVarint(out, size);
+    writeFixed(out, computeHash(previous));
+    writeFixed(out, computeHash(checkpoint));
+
+    // Encode the data as a series of tokens, each of which is either a run of identical bytes
+    // or a block of literal bytes.
+
+    size_t literalStart = 0;
+    size_t i = 0;
+    while (i < size) {
+        size_t runEnd = i+1;
+        while (runEnd < size && shuffled[runEnd] == shuffled[i])
+            runEnd++;
+        if (runEnd-i >= MIN_RUN_LENGTH) {
+            if (i > literalStart) {
+                writeVarint(out, (i-literalStart)<<1);
+                out.append(shuffled, literalStart, i-literalStart);
+            }
+            writeVarint(out, ((runEnd-i)<<1)|1);
+            out.push_back(shuffled[i]);
+            literalStart = runEnd;
+        }
+        i = runEnd;
+    }
+    if (size > literalStart) {
+        writeVarint(out, (size-literalStart)<<1);
+        out.append(shuffled, literalStart, size-literalStart);
+    }
+    return out;
+}
+
+string CheckpointCompressor::decompress(const string& data, const string& previous) {
+    if (!isCompressed(data))
+        throw OpenMMException("CheckpointCompressor: Data is not a compressed checkpoint");
+    size_t pos = PACKED_MAGIC_LENGTH;
+    int version = readVarint(data, pos);
+    if (version != PACKED_VERSION)
+        throw OpenMMException("CheckpointCompressor: Unsupported version");
+    bool isDelta = (readVarint(data, pos) != 0);
+    uint64_t size = readVarint(data, pos);
+    uint64_t previousHash = readFixed(data, pos);
+    uint64_t checkpointHash = readFixed(data, pos);
+    if (isDelta && previous.size() == 0)
+        throw OpenMMException("CheckpointCompressor: The checkpoint is a delta, and no previous checkpoint was specified");
+    if (isDelta && computeHash(previous) != previousHash)
+        throw OpenMMException("CheckpointCompressor: The previous checkpoint does not match the one the delta was created from");
+
+    // Decode the tokens.
+
+    string shuffled;
+    shuffled.reserve(min(size, (uint64_t) 64*data.size()));
+    while (pos < data.size()) {
+        uint64_t token = readVarint(data, pos);
+        uint64_t length = token>>1;
+        if (length > size-shuffled.size())
+            throw OpenMMException("CheckpointCompressor: Invalid data");
+        if (token&1) {
+            if (pos >= data.size())
+                throw OpenMMException("CheckpointCompressor: Unexpected end of data");
+            shuffled.append(length, data[pos++]);
+        }
+        else {
+            if (length > data.size()-pos)
+                throw OpenMMException("CheckpointCompressor: Unexpected end of data");
+            shuffled.append(data, pos, length);
+            pos += length;
+        }
+    }
+    if (shuffled.size() != size)
+        throw OpenMMException("CheckpointCompressor: Unexpected end of data");
+
+    // Undo the shuffling and the delta.
+
+    size_t overlap = (isDelta ? min((size_t) size, previous.size()) : 0);
+    string checkpoint(size, '\0');
+    for (int plane = 0; plane < WORD_SIZE; plane++) {
+        size_t j = shuffledStart(size, plane);
+        for (size_t i = plane; i < size; i += WORD_SIZE) {
+            char c = shuffled[j++];
+            if (i < overlap)
+                c ^= previous[i];
+            checkpoint[i] = c;
+        }
+    }
+    if (computeHash(checkpoint) != checkpointHash)
+        throw OpenMMException("CheckpointCompressor: The decompressed checkpoint is corrupted");
+    return checkpoint;
+}
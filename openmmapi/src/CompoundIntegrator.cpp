@@ -40,7 +40,7 @@
 using namespace OpenMM;
 using namespace std;
 
-CompoundIntegrator::CompoundIntegrator() : currentIntegrator(0) {
+CompoundIntegrator::CompoundIntegrator() : currentIntegrator(0), lastStepIntegrator(-1) {
 }
 
 CompoundIntegrator::~CompoundIntegrator() {
@@ -96,12 +96,21 @@ void CompoundIntegrator::setConstraintTolerance(double tol) {
 }
 
 void CompoundIntegrator::step(int steps) {
+    if (lastStepIntegrator != -1 && lastStepIntegrator != currentIntegrator) {
+        // Another Integrator has moved the particles since this one last took a step, so
+        // anything it cached about the old positions is no longer valid.
+
+        integrators[currentIntegrator]->stateChanged(State::Positions);
+        integrators[currentIntegrator]->stateChanged(State::Velocities);
+    }
+    lastStepIntegrator = currentIntegrator;
     integrators[currentIntegrator]->step(steps);
 }
 
 void CompoundIntegrator::initialize(ContextImpl& context) {
     if (integrators.size() == 0)
         throw OpenMMException("CompoundIntegrator must contain at least one Integrator");
+    lastStepIntegrator = -1;
     for (int i = 0; i < integrators.size(); i++)
         integrators[i]->initialize(context);
 }
@@ -31,8 +31,11 @@
 
 #include "openmm/Context.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/NonbondedForce.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/ForceImpl.h"
+#include "openmm/internal/ThreadPool.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <sstream>
@@ -40,6 +43,43 @@
 using namespace OpenMM;
 using namespace std;
 
+/**
+ * Find the displacement that moves a point into the first periodic box.
+ */
+static Vec3 findPeriodicShift(const Vec3& center, const Vec3* periodicBoxSize) {
+    Vec3 diff;
+    diff += periodicBoxSize[2]*floor(center[2]/periodicBoxSize[2][2]);
+    diff += periodicBoxSize[1]*floor((center[1]-diff[1])/periodicBoxSize[1][1]);
+    diff += periodicBoxSize[0]*floor((center[0]-diff[0])/periodicBoxSize[0][0]);
+    return diff;
+}
+
+/**
+ * Copy a vector of Vec3 into a flat array of length 3*N.
+ */
+template <class T>
+static void copyToArray(const vector<Vec3>& values, T* array) {
+    if (array == NULL)
+        throw OpenMMException("Context: The array is NULL");
+    for (int i = 0; i < (int) values.size(); i++) {
+        array[3*i] = (T) values[i][0];
+        array[3*i+1] = (T) values[i][1];
+        array[3*i+2] = (T) values[i][2];
+    }
+}
+
+/**
+ * Copy a flat array of length 3*N into a vector of Vec3.
+ */
+template <class T>
+static void copyFromArray(const T* array, int numParticles, vector<Vec3>& values) {
+    if (array == NULL)
+        throw OpenMMException("Context: The array is NULL");
+    values.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        values[i] = Vec3(array[3*i], array[3*i+1], array[3*i+2]);
+}
+
 Context::Context(const System& system, Integrator& integrator, ContextImpl& linked) : properties(linked.getOwner().properties) {
     // This is used by ContextImpl::createLinkedContext().
     impl = new ContextImpl(*this, system, integrator, &linked.getPlatform(), properties, &linked);
@@ -96,7 +136,7 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
     bool includeParameterDerivs = types&State::ParameterDerivatives;
     bool needForcesForEnergy = (includeEnergy && getIntegrator().kineticEnergyRequiresForce());
     if (includeForces || includeEnergy || includeParameterDerivs) {
-        double energy = impl->calcForcesAndEnergy(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
+        double energy = impl->calcForcesAndEnergyCached(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
         if (includeEnergy)
             builder.setEnergy(impl->calcKineticEnergy(), energy);
         if (includeForces) {
@@ -121,30 +161,134 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
         impl->getPositions(positions);
         if (enforcePeriodicBox) {
             const vector<vector<int> >& molecules = impl->getMolecules();
-            for (auto& mol : molecules) {
-                // Find the molecule center.
+            auto wrapMolecules = [&] (int start, int end) {
+                for (int i = start; i < end; i++) {
+                    const vector<int>& mol = molecules[i];
+
+                    // Find the molecule center.
+
+                    Vec3 center;
+                    for (int j : mol)
+                        center += positions[j];
+                    center *= 1.0/mol.size();
+
+                    // Find the displacement to move it into the first periodic box.
+                    Vec3 diff = findPeriodicShift(center, periodicBoxSize);
+
+                    // Translate all the particles in the molecule.
+                    for (int j : mol)
+                        positions[j] -= diff;
+                }
+            };
+            int numMolecules = molecules.size();
+            if (positions.size() < 100000)
+                wrapMolecules(0, numMolecules);
+            else {
+                // Molecules do not share particles, so they can be processed in parallel.
+
+                ThreadPool threads;
+                threads.execute([&] (ThreadPool& threads, int threadIndex) {
+                    int numThreads = threads.getNumThreads();
+                    wrapMolecules((int) ((long long) numMolecules*threadIndex/numThreads), (int) ((long long) numMolecules*(threadIndex+1)/numThreads));
+                });
+                threads.waitForThreads();
+            }
+        }
+        builder.setPositions(positions);
+    }
+    if (types&State::Velocities) {
+        vector<Vec3> velocities;
+        impl->getVelocities(velocities);
+        builder.setVelocities(velocities);
+    }
+    if (types&State::IntegratorParameters) {
+        getIntegrator().serializeParameters(builder.updateIntegratorParameters());
+    }
+    return builder.getState();
+}
 
+State Context::getState(int types, const vector<int>& particles, bool enforcePeriodicBox, int groups) const {
+    int numParticles = impl->getSystem().getNumParticles();
+    for (int i : particles)
+        if (i < 0 || i >= numParticles)
+            throw OpenMMException("getState: Illegal particle index");
+    State::StateBuilder builder(impl->getTime(), impl->getStepCount());
+    Vec3 periodicBoxSize[3];
+    impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+    builder.setPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+    bool includeForces = types&State::Forces;
+    bool includeEnergy = types&State::Energy;
+    bool includeParameterDerivs = types&State::ParameterDerivatives;
+    bool needForcesForEnergy = (includeEnergy && getIntegrator().kineticEnergyRequiresForce());
+    if (includeForces || includeEnergy || includeParameterDerivs) {
+        double energy = impl->calcForcesAndEnergyCached(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
+        if (includeEnergy)
+            builder.setEnergy(impl->calcKineticEnergy(), energy);
+        if (includeForces) {
+            vector<Vec3> allForces, forces(particles.size());
+            impl->getForces(allForces);
+            for (int i = 0; i < particles.size(); i++)
+                forces[i] = allForces[particles[i]];
+            builder.setForces(forces);
+        }
+    }
+    if (types&State::Parameters) {
+        map<string, double> params;
+        for (auto& param : impl->parameters)
+            params[param.first] = param.second;
+        builder.setParameters(params);
+    }
+    if (types&State::ParameterDerivatives) {
+        map<string, double> derivs;
+        impl->getEnergyParameterDerivatives(derivs);
+        builder.setEnergyParameterDerivatives(derivs);
+    }
+    if (types&State::Positions) {
+        vector<Vec3> positions;
+        if (!enforcePeriodicBox)
+            impl->getPositionSubset(particles, positions);
+        else {
+            // Finding the center of a molecule requires all its particles, so retrieve every molecule
+            // that contains a requested particle.
+
+            const vector<vector<int> >& molecules = impl->getMolecules();
+            const vector<int>& moleculeIndex = impl->getMoleculeIndex();
+            map<int, int> moleculeStart;
+            vector<int> moleculeParticles;
+            for (int i : particles) {
+                int mol = moleculeIndex[i];
+                if (moleculeStart.find(mol) == moleculeStart.end()) {
+                    moleculeStart[mol] = moleculeParticles.size();
+                    moleculeParticles.insert(moleculeParticles.end(), molecules[mol].begin(), molecules[mol].end());
+                }
+            }
+            vector<Vec3> moleculePositions;
+            impl->getPositionSubset(moleculeParticles, moleculePositions);
+            map<int, Vec3> shifts;
+            for (auto& mol : moleculeStart) {
                 Vec3 center;
-                for (int j : mol)
-                    center += positions[j];
-                center *= 1.0/mol.size();
-
-                // Find the displacement to move it into the first periodic box.
-                Vec3 diff;
-                diff += periodicBoxSize[2]*floor(center[2]/periodicBoxSize[2][2]);
-                diff += periodicBoxSize[1]*floor((center[1]-diff[1])/periodicBoxSize[1][1]);
-                diff += periodicBoxSize[0]*floor((center[0]-diff[0])/periodicBoxSize[0][0]);
-
-                // Translate all the particles in the molecule.
-                for (int j : mol)
-                    positions[j] -= diff;
+                int size = molecules[mol.first].size();
+                for (int j = 0; j < size; j++)
+                    center += moleculePositions[mol.second+j];
+                center *= 1.0/size;
+                shifts[mol.first] = findPeriodicShift(center, periodicBoxSize);
+            }
+
+            // Molecules list their particles in increasing order, so we can find each one with a binary search.
+
+            positions.resize(particles.size());
+            for (int i = 0; i < particles.size(); i++) {
+                int mol = moleculeIndex[particles[i]];
+                const vector<int>& members = molecules[mol];
+                int offset = lower_bound(members.begin(), members.end(), particles[i])-members.begin();
+                positions[i] = moleculePositions[moleculeStart[mol]+offset]-shifts[mol];
             }
         }
         builder.setPositions(positions);
     }
     if (types&State::Velocities) {
         vector<Vec3> velocities;
-        impl->getVelocities(velocities);
+        impl->getVelocitySubset(particles, velocities);
         builder.setVelocities(velocities);
     }
     if (types&State::IntegratorParameters) {
@@ -153,6 +297,46 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
     return builder.getState();
 }
 
+void Context::setProfilingEnabled(bool enabled) {
+    impl->setProfilingEnabled(enabled);
+}
+
+bool Context::getProfilingEnabled() const {
+    return impl->getProfilingEnabled();
+}
+
+void Context::setForceCachingEnabled(bool enabled) {
+    impl->setForceCachingEnabled(enabled);
+}
+
+bool Context::getForceCachingEnabled() const {
+    return impl->getForceCachingEnabled();
+}
+
+map<string, double> Context::getProfile() const {
+    return impl->getProfile();
+}
+
+void Context::resetProfile() {
+    impl->resetProfile();
+}
+
+map<string, double> Context::getNeighborListStatistics() const {
+    return impl->getNeighborListStatistics();
+}
+
+void Context::setTelemetryCallback(TelemetryCallback* callback, int interval) {
+    impl->setTelemetryCallback(callback, interval);
+}
+
+TelemetryCallback* Context::getTelemetryCallback() const {
+    return impl->getTelemetryCallback();
+}
+
+int Context::getTelemetryInterval() const {
+    return impl->getTelemetryInterval();
+}
+
 void Context::setState(const State& state) {
     setTime(state.getTime());
     setStepCount(state.getStepCount());
@@ -186,6 +370,93 @@ void Context::setStepCount(long long count) {
     impl->setStepCount(count);
 }
 
+vector<double> Context::computeEnergies(const vector<vector<Vec3> >& frames, int groups) {
+    vector<vector<double> > energies = computeEnergies(frames, vector<map<string, double> >(1), groups);
+    vector<double> result(energies.size());
+    for (int i = 0; i < (int) energies.size(); i++)
+        result[i] = energies[i][0];
+    return result;
+}
+
+vector<double> Context::computeEnergiesByGroup(int groups) {
+    vector<double> energies;
+    impl->calcEnergiesByGroup(groups, energies);
+    return energies;
+}
+
+vector<vector<double> > Context::computeEnergies(const vector<vector<Vec3> >& frames, const vector<map<string, double> >& parameterSets, int groups) {
+    int numParticles = impl->getSystem().getNumParticles();
+    for (auto& frame : frames)
+        if ((int) frame.size() != numParticles)
+            throw OpenMMException("Called computeEnergies() with a frame containing the wrong number of positions");
+    for (auto& parameters : parameterSets)
+        for (auto& param : parameters)
+            impl->getParameter(param.first); // Throws an exception if the parameter does not exist.
+
+    // Record the current positions and parameters so they can be restored afterward.
+
+    vector<Vec3> originalPositions;
+    impl->getPositions(originalPositions);
+    map<string, double> originalParameters;
+    for (auto& parameters : parameterSets)
+        for (auto& param : parameters)
+            originalParameters[param.first] = impl->getParameter(param.first);
+
+    // Find which force groups contain a Force that depends on one of the parameters being varied.
+    // The other groups give the same energy for every parameter set, so they only need to be
+    // evaluated once per configuration.
+
+    int dependentGroups = 0;
+    for (auto force : impl->getForceImpls()) {
+        map<string, double> forceParameters = force->getDefaultParameters();
+        bool dependent = false;
+        for (auto& param : originalParameters)
+            if (forceParameters.find(param.first) != forceParameters.end())
+                dependent = true;
+        if (!dependent)
+            continue;
+        const Force& owner = force->getOwner();
+        dependentGroups |= 1<<owner.getForceGroup();
+        const NonbondedForce* nonbonded = dynamic_cast<const NonbondedForce*>(&owner);
+        if (nonbonded != NULL && nonbonded->getReciprocalSpaceForceGroup() >= 0)
+            dependentGroups |= 1<<nonbonded->getReciprocalSpaceForceGroup();
+    }
+    int independentGroups = groups & ~dependentGroups;
+    dependentGroups &= groups;
+
+    // Evaluate the energies.  Only set parameters when they differ from the previous set, since
+    // some platforms need to do extra work every time a parameter changes.
+
+    vector<vector<double> > energies(frames.size(), vector<double>(parameterSets.size()));
+    try {
+        for (int i = 0; i < (int) frames.size(); i++) {
+            impl->setPositions(frames[i]);
+            double independentEnergy = 0.0;
+            if (independentGroups != 0 && parameterSets.size() > 0)
+                independentEnergy = impl->calcForcesAndEnergy(false, true, independentGroups);
+            for (int j = 0; j < (int) parameterSets.size(); j++) {
+                for (auto& param : parameterSets[j])
+                    if (impl->getParameter(param.first) != param.second)
+                        impl->setParameter(param.first, param.second);
+                energies[i][j] = independentEnergy;
+                if (dependentGroups != 0)
+                    energies[i][j] += impl->calcForcesAndEnergy(false, true, dependentGroups);
+            }
+        }
+    }
+    catch (...) {
+        impl->setPositions(originalPositions);
+        for (auto& param : originalParameters)
+            impl->setParameter(param.first, param.second);
+        throw;
+    }
+    impl->setPositions(originalPositions);
+    for (auto& param : originalParameters)
+        if (impl->getParameter(param.first) != param.second)
+            impl->setParameter(param.first, param.second);
+    return energies;
+}
+
 void Context::setPositions(const vector<Vec3>& positions) {
     if ((int) positions.size() != impl->getSystem().getNumParticles())
         throw OpenMMException("Called setPositions() on a Context with the wrong number of positions");
@@ -198,6 +469,58 @@ void Context::setVelocities(const vector<Vec3>& velocities) {
     impl->setVelocities(velocities);
 }
 
+void Context::getPositionArray(double* positions) const {
+    impl->getPositions(impl->arrayBuffer);
+    copyToArray(impl->arrayBuffer, positions);
+}
+
+void Context::getPositionArray(float* positions) const {
+    impl->getPositions(impl->arrayBuffer);
+    copyToArray(impl->arrayBuffer, positions);
+}
+
+void Context::setPositionArray(const double* positions) {
+    copyFromArray(positions, impl->getSystem().getNumParticles(), impl->arrayBuffer);
+    impl->setPositions(impl->arrayBuffer);
+}
+
+void Context::setPositionArray(const float* positions) {
+    copyFromArray(positions, impl->getSystem().getNumParticles(), impl->arrayBuffer);
+    impl->setPositions(impl->arrayBuffer);
+}
+
+void Context::getVelocityArray(double* velocities) const {
+    impl->getVelocities(impl->arrayBuffer);
+    copyToArray(impl->arrayBuffer, velocities);
+}
+
+void Context::getVelocityArray(float* velocities) const {
+    impl->getVelocities(impl->arrayBuffer);
+    copyToArray(impl->arrayBuffer, velocities);
+}
+
+void Context::setVelocityArray(const double* velocities) {
+    copyFromArray(velocities, impl->getSystem().getNumParticles(), impl->arrayBuffer);
+    impl->setVelocities(impl->arrayBuffer);
+}
+
+void Context::setVelocityArray(const float* velocities) {
+    copyFromArray(velocities, impl->getSystem().getNumParticles(), impl->arrayBuffer);
+    impl->setVelocities(impl->arrayBuffer);
+}
+
+void Context::getForceArray(double* forces, int groups) const {
+    impl->calcForcesAndEnergyCached(true, false, groups);
+    impl->getForces(impl->arrayBuffer);
+    copyToArray(impl->arrayBuffer, forces);
+}
+
+void Context::getForceArray(float* forces, int groups) const {
+    impl->calcForcesAndEnergyCached(true, false, groups);
+    impl->getForces(impl->arrayBuffer);
+    copyToArray(impl->arrayBuffer, forces);
+}
+
 void Context::setVelocitiesToTemperature(double temperature, int randomSeed) {
     const Integrator& integrator = impl->getIntegrator();
     const System& system = impl->getSystem();
@@ -31,19 +31,25 @@
 
 #include "openmm/Force.h"
 #include "openmm/Integrator.h"
+#include "openmm/NonbondedForce.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/System.h"
+#include "openmm/CheckpointCompressor.h"
 #include "openmm/kernels.h"
 #include "openmm/internal/ForceImpl.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/State.h"
+#include "openmm/TelemetryCallback.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/Context.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <sstream>
 #include <utility>
 #include <vector>
 #include <string.h>
@@ -54,8 +60,9 @@ const static char CHECKPOINT_MAGIC_BYTES[] = "OpenMM Binary Checkpoint\n";
 
 
 ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const map<string, string>& properties, ContextImpl* originalContext) :
-        owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false),
-        lastForceGroups(-1), platform(platform), platformData(NULL) {
+        owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false), profilingEnabled(false),
+        forceCachingEnabled(true), updatingContextState(false), energiesNeedSeparateGroups(false), telemetryCallback(NULL), telemetryInterval(0), lastForceGroups(-1), stateVersion(0), cachedVersion(-1),
+        cachedStepCount(-1), cachedGroups(0), cachedForces(false), cachedEnergy(false), cachedEnergyValue(0.0), platform(platform), platformData(NULL) {
     int numParticles = system.getNumParticles();
     if (numParticles == 0)
         throw OpenMMException("Cannot create a Context for a System with no particles");
@@ -229,6 +236,7 @@ long long ContextImpl::getStepCount() const {
 }
 
 void ContextImpl::setStepCount(long long count) {
+    stateVersion++;
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setStepCount(*this, count);
 }
 
@@ -236,8 +244,13 @@ void ContextImpl::getPositions(std::vector<Vec3>& positions) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().getPositions(*this, positions);
 }
 
+void ContextImpl::getPositionSubset(const std::vector<int>& particles, std::vector<Vec3>& positions) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().getPositionSubset(*this, particles, positions);
+}
+
 void ContextImpl::setPositions(const std::vector<Vec3>& positions) {
     hasSetPositions = true;
+    stateVersion++;
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPositions(*this, positions);
     integrator.stateChanged(State::Positions);
 }
@@ -246,6 +259,10 @@ void ContextImpl::getVelocities(std::vector<Vec3>& velocities) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().getVelocities(*this, velocities);
 }
 
+void ContextImpl::getVelocitySubset(const std::vector<int>& particles, std::vector<Vec3>& velocities) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().getVelocitySubset(*this, particles, velocities);
+}
+
 void ContextImpl::setVelocities(const std::vector<Vec3>& velocities) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setVelocities(*this, velocities);
     integrator.stateChanged(State::Velocities);
@@ -269,6 +286,7 @@ void ContextImpl::setParameter(std::string name, double value) {
     if (parameters.find(name) == parameters.end())
         throw OpenMMException("Called setParameter() with invalid parameter name: "+name);
     parameters[name] = value;
+    stateVersion++;
     integrator.stateChanged(State::Parameters);
 }
 
@@ -287,12 +305,14 @@ void ContextImpl::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3
         throw OpenMMException("Second periodic box vector must be in the x-y plane.");
     if (a[0] <= 0.0 || b[1] <= 0.0 || c[2] <= 0.0 || a[0] < 2*fabs(b[0]) || a[0] < 2*fabs(c[0]) || b[1] < 2*fabs(c[1]))
         throw OpenMMException("Periodic box vectors must be in reduced form.");
+    stateVersion++;
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPeriodicBoxVectors(*this, a, b, c);
 }
 
 void ContextImpl::applyConstraints(double tol) {
     if (!hasSetPositions)
         throw OpenMMException("Particle positions have not been set");
+    stateVersion++;
     applyConstraintsKernel.getAs<ApplyConstraintsKernel>().apply(*this, tol);
 }
 
@@ -303,6 +323,7 @@ void ContextImpl::applyVelocityConstraints(double tol) {
 }
 
 void ContextImpl::computeVirtualSites() {
+    stateVersion++;
     virtualSitesKernel.getAs<VirtualSitesKernel>().computePositions(*this);
 }
 
@@ -310,7 +331,37 @@ double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy,
     if (!hasSetPositions)
         throw OpenMMException("Particle positions have not been set");
     lastForceGroups = groups;
+    cachedVersion = -1;
+    long long startVersion = stateVersion;
     CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
+    if (profilingEnabled) {
+        // Wait for the platform after each stage, so the time is charged to the stage that actually did the work.
+
+        kernel.synchronize(*this);
+        while (true) {
+            double energy = 0.0;
+            auto start = chrono::steady_clock::now();
+            auto recordTime = [&] (const string& name) {
+                kernel.synchronize(*this);
+                auto end = chrono::steady_clock::now();
+                addProfileTime(name, chrono::duration<double>(end-start).count());
+                start = end;
+            };
+            kernel.beginComputation(*this, includeForces, includeEnergy, groups);
+            recordTime("Begin Computation");
+            for (auto force : forceImpls) {
+                energy += force->calcForcesAndEnergy(*this, includeForces, includeEnergy, groups);
+                recordTime(force->getOwner().getName());
+            }
+            bool valid = true;
+            energy += kernel.finishComputation(*this, includeForces, includeEnergy, groups, valid);
+            recordTime("Finish Computation");
+            if (valid) {
+                recordCachedForces(includeForces, includeEnergy, groups, energy, startVersion);
+                return energy;
+            }
+        }
+    }
     while (true) {
         double energy = 0.0;
         kernel.beginComputation(*this, includeForces, includeEnergy, groups);
@@ -318,9 +369,169 @@ double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy,
             energy += force->calcForcesAndEnergy(*this, includeForces, includeEnergy, groups);
         bool valid = true;
         energy += kernel.finishComputation(*this, includeForces, includeEnergy, groups, valid);
-        if (valid)
+        if (valid) {
+            recordCachedForces(includeForces, includeEnergy, groups, energy, startVersion);
             return energy;
+        }
+    }
+}
+
+double ContextImpl::calcForcesAndEnergyCached(bool includeForces, bool includeEnergy, int groups) {
+    // The cached forces are only still in the platform's force buffer if nothing has computed
+    // forces for different groups since then, which lastForceGroups tells us.  Forces updating the
+    // context state are called in the middle of a step, after the integrator may have moved particles
+    // without telling us, so they always get a fresh computation.
+
+    if (forceCachingEnabled && !updatingContextState && cachedVersion == stateVersion && cachedGroups == groups && lastForceGroups == groups &&
+            (cachedForces || !includeForces) && (cachedEnergy || !includeEnergy) && cachedStepCount == getStepCount())
+        return (includeEnergy ? cachedEnergyValue : 0.0);
+    return calcForcesAndEnergy(includeForces, includeEnergy, groups);
+}
+
+void ContextImpl::calcEnergiesByGroup(int groups, vector<double>& energies) {
+    if (!hasSetPositions)
+        throw OpenMMException("Particle positions have not been set");
+    energies.assign(32, 0.0);
+
+    // Find which groups contain forces, and whether any Force contributes to more than one group.
+
+    int usedGroups = 0;
+    bool hasSplitForce = false;
+    for (auto force : forceImpls) {
+        const Force& owner = force->getOwner();
+        usedGroups |= 1<<owner.getForceGroup();
+        const NonbondedForce* nonbonded = dynamic_cast<const NonbondedForce*>(&owner);
+        if (nonbonded != NULL && nonbonded->getReciprocalSpaceForceGroup() >= 0 && nonbonded->getReciprocalSpaceForceGroup() != owner.getForceGroup()) {
+            usedGroups |= 1<<nonbonded->getReciprocalSpaceForceGroup();
+            hasSplitForce = true;
+        }
+    }
+    groups &= usedGroups;
+    if (groups == 0)
+        return;
+    if (!hasSplitForce && !energiesNeedSeparateGroups) {
+        // Evaluate all the groups at once and attribute the energy returned by each ForceImpl to its group.
+        // This only works if no kernel adds its energy to a buffer that is summed by finishComputation().
+
+        lastForceGroups = groups;
+        cachedVersion = -1;
+        CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
+        while (true) {
+            vector<double> groupEnergies(32, 0.0);
+            kernel.beginComputation(*this, false, true, groups);
+            for (auto force : forceImpls)
+                groupEnergies[force->getOwner().getForceGroup()] += force->calcForcesAndEnergy(*this, false, true, groups);
+            bool valid = true;
+            double bufferedEnergy = kernel.finishComputation(*this, false, true, groups, valid);
+            if (!valid)
+                continue;
+            if (bufferedEnergy == 0.0) {
+                energies = groupEnergies;
+                return;
+            }
+            energiesNeedSeparateGroups = true;
+            break;
+        }
+    }
+    for (int i = 0; i < 32; i++)
+        if ((groups&(1<<i)) != 0)
+            energies[i] = calcForcesAndEnergy(false, true, 1<<i);
+}
+
+void ContextImpl::recordCachedForces(bool includeForces, bool includeEnergy, int groups, double energy, long long startVersion) {
+    // Only record the results if nothing that affects the forces changed while they were being computed.
+
+    if (!forceCachingEnabled || updatingContextState || stateVersion != startVersion)
+        return;
+    cachedVersion = stateVersion;
+    cachedStepCount = getStepCount();
+    cachedGroups = groups;
+    cachedForces = includeForces;
+    cachedEnergy = includeEnergy;
+    cachedEnergyValue = energy;
+}
+
+void ContextImpl::invalidateCachedForces() {
+    stateVersion++;
+}
+
+void ContextImpl::setForceCachingEnabled(bool enabled) {
+    forceCachingEnabled = enabled;
+    stateVersion++;
+}
+
+void ContextImpl::setProfilingEnabled(bool enabled) {
+    profilingEnabled = enabled;
+}
+
+void ContextImpl::addProfileTime(const string& name, double time) {
+    if (profilingEnabled)
+        profile[name] += time;
+}
+
+void ContextImpl::resetProfile() {
+    profile.clear();
+}
+
+map<string, double> ContextImpl::getNeighborListStatistics() {
+    map<string, double> statistics;
+    initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>().getNeighborListStatistics(*this, statistics);
+    if (statistics.find("Neighbor List Checks") != statistics.end() && statistics["Neighbor List Checks"] > 0)
+        statistics["Neighbor List Build Frequency"] = statistics["Neighbor List Builds"]/statistics["Neighbor List Checks"];
+    if (statistics.find("Neighbor List Pairs") != statistics.end() && statistics["Neighbor List Pairs"] > 0)
+        statistics["Useful Pair Fraction"] = statistics["Pairs Within Cutoff"]/statistics["Neighbor List Pairs"];
+    return statistics;
+}
+
+void ContextImpl::setTelemetryCallback(TelemetryCallback* callback, int interval) {
+    if (callback != NULL && interval < 1)
+        throw OpenMMException("setTelemetryCallback: the interval must be positive");
+    telemetryCallback = callback;
+    telemetryInterval = (callback == NULL ? 0 : interval);
+    telemetryStep = telemetryLastStep = getStepCount();
+    telemetryTime = getTime();
+    telemetryMaxStepTime = 0.0;
+    telemetryStartTime = telemetrySampleTime = telemetryStepTime = chrono::steady_clock::now();
+}
+
+void ContextImpl::updateTelemetry() {
+    // This is called at the start of every step, and possibly more than once per step by a
+    // CustomIntegrator.  The step count and time are stored on the host, so querying them
+    // does not synchronize.
+
+    long long step = getStepCount();
+    if (step == telemetryStep)
+        return;
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (step < telemetryStep) {
+        // The step count was reset, so start a new interval.
+
+        telemetryLastStep = step;
+        telemetryTime = getTime();
+        telemetryMaxStepTime = 0.0;
+        telemetrySampleTime = now;
     }
+    else
+        telemetryMaxStepTime = max(telemetryMaxStepTime, chrono::duration<double>(now-telemetryStepTime).count()/(step-telemetryStep));
+    telemetryStep = step;
+    telemetryStepTime = now;
+    if (step-telemetryLastStep < telemetryInterval)
+        return;
+    double time = getTime();
+    TelemetryCallback::Sample sample;
+    sample.stepCount = step;
+    sample.steps = (int) (step-telemetryLastStep);
+    sample.simulationTime = time;
+    sample.elapsedTime = chrono::duration<double>(now-telemetryStartTime).count();
+    sample.intervalTime = chrono::duration<double>(now-telemetrySampleTime).count();
+    sample.nsPerDay = (sample.intervalTime > 0.0 ? 1e-3*(time-telemetryTime)*86400.0/sample.intervalTime : 0.0);
+    sample.maxStepTime = telemetryMaxStepTime;
+    sample.profile = (profilingEnabled ? &profile : NULL);
+    telemetryLastStep = step;
+    telemetryTime = time;
+    telemetryMaxStepTime = 0.0;
+    telemetrySampleTime = now;
+    telemetryCallback->report(owner, sample);
 }
 
 int& ContextImpl::getLastForceGroups() {
@@ -336,9 +547,28 @@ void ContextImpl::computeShiftedVelocities(double timeShift, std::vector<Vec3>&
 }
 
 bool ContextImpl::updateContextState() {
+    if (telemetryCallback != NULL)
+        updateTelemetry();
+    // A Force may modify the positions or parameters, for example by a Monte Carlo move, and may compute
+    // forces for a trial state that is never reported to us.  Those results are not cached.
+
     bool forcesInvalid = false;
-    for (auto force : forceImpls)
-        force->updateContextState(*this, forcesInvalid);
+    updatingContextState = true;
+    try {
+        for (auto force : forceImpls) {
+            bool invalid = false;
+            force->updateContextState(*this, invalid);
+            if (invalid) {
+                forcesInvalid = true;
+                stateVersion++;
+            }
+        }
+    }
+    catch (...) {
+        updatingContextState = false;
+        throw;
+    }
+    updatingContextState = false;
     return forcesInvalid;
 }
 
@@ -362,6 +592,17 @@ void ContextImpl::setPlatformData(void* data) {
     platformData = data;
 }
 
+const vector<int>& ContextImpl::getMoleculeIndex() const {
+    if (moleculeIndex.size() == system.getNumParticles())
+        return moleculeIndex;
+    const vector<vector<int> >& mols = getMolecules();
+    moleculeIndex.resize(system.getNumParticles());
+    for (int i = 0; i < mols.size(); i++)
+        for (int j : mols[i])
+            moleculeIndex[j] = i;
+    return moleculeIndex;
+}
+
 const vector<vector<int> >& ContextImpl::getMolecules() const {
     if (!hasInitializedForces)
         throw OpenMMException("ContextImpl: getMolecules() cannot be called until all ForceImpls have been initialized");
@@ -389,65 +630,81 @@ const vector<vector<int> >& ContextImpl::getMolecules() const {
         }
     }
 
-    // Make a list of every other particle to which each particle is connected
-
-    int numParticles = system.getNumParticles();
-    vector<vector<int> > particleBonds(numParticles);
-    for (auto& bond : bonds) {
-        particleBonds[bond.first].push_back(bond.second);
-        particleBonds[bond.second].push_back(bond.first);
-    }
-
     // Now identify particles by which molecule they belong to.
 
-    molecules = findMolecules(numParticles, particleBonds);
+    molecules = findMolecules(system.getNumParticles(), bonds);
     return molecules;
 }
 
-vector<vector<int> > ContextImpl::findMolecules(int numParticles, vector<vector<int> >& particleBonds) {
-    // This is essentially a recursive algorithm, but it is reformulated as a loop to avoid
-    // stack overflows.  It selects a particle, marks it as a new molecule, then recursively
-    // marks every particle bonded to it as also being in that molecule.
-    
-    vector<int> particleMolecule(numParticles, -1);
+/**
+ * Find the root of the set containing a particle, compressing the path as it goes.
+ */
+static int findRoot(vector<int>& parent, int particle) {
+    while (parent[particle] != particle) {
+        parent[particle] = parent[parent[particle]];
+        particle = parent[particle];
+    }
+    return particle;
+}
+
+/**
+ * Merge the sets containing two particles.  The smaller index always becomes the root, so every
+ * root is the lowest numbered particle in its molecule.
+ */
+static void joinParticles(vector<int>& parent, int particle1, int particle2) {
+    int root1 = findRoot(parent, particle1);
+    int root2 = findRoot(parent, particle2);
+    if (root1 < root2)
+        parent[root2] = root1;
+    else if (root2 < root1)
+        parent[root1] = root2;
+}
+
+/**
+ * Build the list of molecules from the merged sets.  Molecules are numbered in order of their
+ * lowest particle index, and the particles in each one are sorted.
+ */
+static vector<vector<int> > buildMolecules(vector<int>& parent) {
+    int numParticles = parent.size();
+    vector<int> particleMolecule(numParticles);
     int numMolecules = 0;
+    for (int i = 0; i < numParticles; i++) {
+        int root = findRoot(parent, i);
+        particleMolecule[i] = (root == i ? numMolecules++ : particleMolecule[root]);
+    }
+    vector<int> moleculeSize(numMolecules, 0);
     for (int i = 0; i < numParticles; i++)
-        if (particleMolecule[i] == -1) {
-            // Start a new molecule.
-            
-            vector<int> particleStack;
-            vector<int> neighborStack;
-            particleStack.push_back(i);
-            neighborStack.push_back(0);
-            int molecule = numMolecules++;
-            
-            // Recursively tag all the bonded particles.
-            
-            while (particleStack.size() > 0) {
-                int particle = particleStack.back();
-                particleMolecule[particle] = molecule;
-                int& neighbor = neighborStack.back();
-                while (neighbor < particleBonds[particle].size() && particleMolecule[particleBonds[particle][neighbor]] != -1)
-                    neighbor++;
-                if (neighbor < particleBonds[particle].size()) {
-                    particleStack.push_back(particleBonds[particle][neighbor]);
-                    neighborStack.push_back(0);
-                }
-                else {
-                    particleStack.pop_back();
-                    neighborStack.pop_back();
-                }
-            }
-        }
-    
-    // Build the final output vector.
-    
+        moleculeSize[particleMolecule[i]]++;
     vector<vector<int> > molecules(numMolecules);
+    for (int i = 0; i < numMolecules; i++)
+        molecules[i].reserve(moleculeSize[i]);
     for (int i = 0; i < numParticles; i++)
         molecules[particleMolecule[i]].push_back(i);
     return molecules;
 }
 
+vector<vector<int> > ContextImpl::findMolecules(int numParticles, vector<vector<int> >& particleBonds) {
+    // Use a union-find over the bonds.  Unlike a graph traversal, this needs no stack and touches
+    // each bond only once, which matters for very large systems.
+
+    vector<int> parent(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        parent[i] = i;
+    for (int i = 0; i < numParticles; i++)
+        for (int j : particleBonds[i])
+            joinParticles(parent, i, j);
+    return buildMolecules(parent);
+}
+
+vector<vector<int> > ContextImpl::findMolecules(int numParticles, const vector<pair<int, int> >& bonds) {
+    vector<int> parent(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        parent[i] = i;
+    for (auto& bond : bonds)
+        joinParticles(parent, bond.first, bond.second);
+    return buildMolecules(parent);
+}
+
 static void writeString(ostream& stream, string str) {
     int length = str.size();
     stream.write((char*) &length, sizeof(int));
@@ -482,8 +739,20 @@ void ContextImpl::loadCheckpoint(istream& stream) {
     static const int magiclength = sizeof(CHECKPOINT_MAGIC_BYTES)/sizeof(CHECKPOINT_MAGIC_BYTES[0]);
     char magicbytes[magiclength];
     stream.read(magicbytes, magiclength);
-    if (memcmp(magicbytes, CHECKPOINT_MAGIC_BYTES, magiclength) != 0)
+    if (memcmp(magicbytes, CHECKPOINT_MAGIC_BYTES, magiclength) != 0) {
+        // See if this is a compressed checkpoint.
+
+        if (stream.gcount() == magiclength) {
+            string data(magicbytes, magiclength);
+            data.append(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+            if (CheckpointCompressor::isCompressed(data)) {
+                stringstream decompressed(CheckpointCompressor::decompress(data));
+                loadCheckpoint(decompressed);
+                return;
+            }
+        }
         throw OpenMMException("loadCheckpoint: Checkpoint header was not correct");
+    }
 
     string platformName = readString(stream);
     if (platformName != getPlatform().getName())
@@ -503,6 +772,7 @@ void ContextImpl::loadCheckpoint(istream& stream) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().loadCheckpoint(*this, stream);
     integrator.loadCheckpoint(stream);
     hasSetPositions = true;
+    stateVersion++;
     integrator.stateChanged(State::Positions);
     integrator.stateChanged(State::Velocities);
     integrator.stateChanged(State::Parameters);
@@ -510,6 +780,7 @@ void ContextImpl::loadCheckpoint(istream& stream) {
 }
 
 void ContextImpl::systemChanged() {
+    stateVersion++;
     integrator.stateChanged(State::Energy);
 }
 
@@ -136,6 +136,10 @@ void CustomBondForce::updateParametersInContext(Context& context) {
     dynamic_cast<CustomBondForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
 
+void CustomBondForce::updateParametersInContext(Context& context, int firstBond, int numBonds) {
+    dynamic_cast<CustomBondForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstBond, numBonds);
+}
+
 void CustomBondForce::setUsesPeriodicBoundaryConditions(bool periodic) {
     usePeriodic = periodic;
 }
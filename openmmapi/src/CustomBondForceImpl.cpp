@@ -112,3 +112,10 @@ void CustomBondForceImpl::updateParametersInContext(ContextImpl& context) {
     kernel.getAs<CalcCustomBondForceKernel>().copyParametersToContext(context, owner);
     context.systemChanged();
 }
+
+void CustomBondForceImpl::updateParametersInContext(ContextImpl& context, int firstBond, int numBonds) {
+    if (firstBond < 0 || numBonds < 0 || firstBond+numBonds > owner.getNumBonds())
+        throw OpenMMException("updateParametersInContext: Illegal range of bonds");
+    kernel.getAs<CalcCustomBondForceKernel>().copySomeParametersToContext(context, owner, firstBond, numBonds);
+    context.systemChanged();
+}
@@ -112,6 +112,7 @@ map<string, double> CustomCVForceImpl::getDefaultParameters() {
 
 void CustomCVForceImpl::getCollectiveVariableValues(ContextImpl& context, vector<double>& values) {
     kernel.getAs<CalcCustomCVForceKernel>().copyState(context, getContextImpl(*innerContext));
+    getContextImpl(*innerContext).invalidateCachedForces();
     values.clear();
     for (int i = 0; i < innerSystem.getNumForces(); i++) {
         double value = innerContext->getState(State::Energy, false, 1<<i).getPotentialEnergy();
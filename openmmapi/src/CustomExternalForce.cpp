@@ -120,6 +120,10 @@ void CustomExternalForce::updateParametersInContext(Context& context) {
     dynamic_cast<CustomExternalForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
 
+void CustomExternalForce::updateParametersInContext(Context& context, int firstParticle, int numParticles) {
+    dynamic_cast<CustomExternalForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstParticle, numParticles);
+}
+
 bool CustomExternalForce::usesPeriodicBoundaryConditions() const {
     return (energyExpression.find("periodicdistance") != string::npos);
 }
@@ -100,3 +100,10 @@ void CustomExternalForceImpl::updateParametersInContext(ContextImpl& context) {
     kernel.getAs<CalcCustomExternalForceKernel>().copyParametersToContext(context, owner);
     context.systemChanged();
 }
+
+void CustomExternalForceImpl::updateParametersInContext(ContextImpl& context, int firstParticle, int numParticles) {
+    if (firstParticle < 0 || numParticles < 0 || firstParticle+numParticles > owner.getNumParticles())
+        throw OpenMMException("updateParametersInContext: Illegal range of particles");
+    kernel.getAs<CalcCustomExternalForceKernel>().copySomeParametersToContext(context, owner, firstParticle, numParticles);
+    context.systemChanged();
+}
@@ -332,3 +332,7 @@ ForceImpl* CustomNonbondedForce::createImpl() const {
 void CustomNonbondedForce::updateParametersInContext(Context& context) {
     dynamic_cast<CustomNonbondedForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
+
+void CustomNonbondedForce::updateParametersInContext(Context& context, int firstParticle, int numParticles) {
+    dynamic_cast<CustomNonbondedForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstParticle, numParticles);
+}
@@ -163,6 +163,13 @@ void CustomNonbondedForceImpl::updateParametersInContext(ContextImpl& context) {
     context.systemChanged();
 }
 
+void CustomNonbondedForceImpl::updateParametersInContext(ContextImpl& context, int firstParticle, int numParticles) {
+    if (firstParticle < 0 || numParticles < 0 || firstParticle+numParticles > owner.getNumParticles())
+        throw OpenMMException("updateParametersInContext: Illegal range of particles");
+    kernel.getAs<CalcCustomNonbondedForceKernel>().copySomeParametersToContext(context, owner, firstParticle, numParticles);
+    context.systemChanged();
+}
+
 CustomNonbondedForceImpl::LongRangeCorrectionData CustomNonbondedForceImpl::prepareLongRangeCorrection(const CustomNonbondedForce& force, int numThreads) {
     LongRangeCorrectionData data;
     data.method = force.getNonbondedMethod();
@@ -284,11 +291,38 @@ void CustomNonbondedForceImpl::calcLongRangeCorrection(const CustomNonbondedForc
         }
     }
 
-    // Compute the coefficient.  Use multiple threads to compute the integrals in parallel.
+    // The integral for each pair of classes depends only on the two classes' parameters and computed values,
+    // and on the global parameters used by the energy expression.  Integrals computed the last time this was
+    // called are kept, and only the ones whose inputs have changed are recomputed.  This makes it much
+    // cheaper to change a global parameter that only affects some classes.
+
+    int numDerivs = data.derivExpressions[0].size();
+    vector<double> globalValues;
+    for (int i = 0; i < force.getNumGlobalParameters(); i++) {
+        const string& name = force.getGlobalParameterName(i);
+        bool used = (data.energyExpression[0].getVariables().count(name) > 0);
+        for (int k = 0; k < numDerivs; k++)
+            used |= (data.derivExpressions[0][k].getVariables().count(name) > 0);
+        if (used)
+            globalValues.push_back(context.getParameter(name));
+    }
+    if (data.integrals.size() == 0 || globalValues != data.cachedGlobalValues) {
+        data.integrals.resize((numDerivs+1)*numClasses*numClasses);
+        data.hasIntegral.assign(numClasses*numClasses, 0);
+        data.cachedGlobalValues = globalValues;
+        data.cachedComputedValues = computedValues;
+    }
+    for (int i = 0; i < numClasses; i++)
+        if (computedValues[i] != data.cachedComputedValues[i]) {
+            for (int j = 0; j < numClasses; j++) {
+                data.hasIntegral[i*numClasses+j] = 0;
+                data.hasIntegral[j*numClasses+i] = 0;
+            }
+            data.cachedComputedValues[i] = computedValues[i];
+        }
+
+    // Compute any integrals that are needed.  Use multiple threads to compute them in parallel.
 
-    double nPart = (double) context.getSystem().getNumParticles();
-    double numInteractions = (nPart*(nPart+1))/2;
-    vector<double> threadSum(threads.getNumThreads(), 0.0);
     atomic<int> atomicCounter(0);
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
         Lepton::CompiledVectorExpression& expression = data.energyExpression[threadIndex];
@@ -296,42 +330,39 @@ void CustomNonbondedForceImpl::calcLongRangeCorrection(const CustomNonbondedForc
             int i = atomicCounter++;
             if (i >= numClasses)
                 break;
-            for (int j = i; j < numClasses; j++)
-                threadSum[threadIndex] += data.interactionCount.at(make_pair(i, j))*integrateInteraction(expression, data.classes[i], data.classes[j],
+            for (int j = i; j < numClasses; j++) {
+                int index = i*numClasses+j;
+                if (data.hasIntegral[index] || data.interactionCount.at(make_pair(i, j)) == 0)
+                    continue;
+                data.integrals[index] = integrateInteraction(expression, data.classes[i], data.classes[j],
                         computedValues[i], computedValues[j], force, context, data.paramNames, data.computedValueNames);
+                for (int k = 0; k < numDerivs; k++)
+                    data.integrals[(k+1)*numClasses*numClasses+index] = integrateInteraction(data.derivExpressions[threadIndex][k], data.classes[i], data.classes[j],
+                            computedValues[i], computedValues[j], force, context, data.paramNames, data.computedValueNames);
+                data.hasIntegral[index] = 1;
+            }
         }
     });
     threads.waitForThreads();
-    double sum = 0;
-    for (int i = 0; i < threadSum.size(); i++)
-        sum += threadSum[i];
-    sum /= numInteractions;
-    coefficient = 2*M_PI*nPart*nPart*sum;
-    
-    // Now do the same for parameter derivatives.
-    
-    int numDerivs = data.derivExpressions[0].size();
+
+    // Compute the coefficient and its derivatives.
+
+    double nPart = (double) context.getSystem().getNumParticles();
+    double numInteractions = (nPart*(nPart+1))/2;
     derivatives.resize(numDerivs);
-    for (int k = 0; k < numDerivs; k++) {
-        atomicCounter = 0;
-        threads.execute([&] (ThreadPool& threads, int threadIndex) {
-            threadSum[threadIndex] = 0;
-            Lepton::CompiledVectorExpression& expression = data.derivExpressions[threadIndex][k];
-            while (true) {
-                int i = atomicCounter++;
-                if (i >= numClasses)
-                    break;
-                for (int j = i; j < numClasses; j++)
-                    threadSum[threadIndex] += data.interactionCount.at(make_pair(i, j))*integrateInteraction(expression, data.classes[i], data.classes[j],
-                            computedValues[i], computedValues[j], force, context, data.paramNames, data.computedValueNames);
+    for (int k = 0; k <= numDerivs; k++) {
+        double sum = 0;
+        for (int i = 0; i < numClasses; i++)
+            for (int j = i; j < numClasses; j++) {
+                int index = i*numClasses+j;
+                if (data.hasIntegral[index])
+                    sum += data.interactionCount.at(make_pair(i, j))*data.integrals[k*numClasses*numClasses+index];
             }
-        });
-        threads.waitForThreads();
-        sum = 0;
-        for (int i = 0; i < threadSum.size(); i++)
-            sum += threadSum[i];
         sum /= numInteractions;
-        derivatives[k] = 2*M_PI*nPart*nPart*sum;
+        if (k == 0)
+            coefficient = 2*M_PI*nPart*nPart*sum;
+        else
+            derivatives[k-1] = 2*M_PI*nPart*nPart*sum;
     }
 }
 
@@ -0,0 +1,107 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/ExpressionCache.h"
+#include "lepton/Parser.h"
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+
+using namespace OpenMM;
+using namespace Lepton;
+using namespace std;
+
+static const int MaxCachedExpressions = 1000;
+static mutex cacheLock;
+static map<string, ParsedExpression> expressionCache;
+static map<pair<string, string>, ParsedExpression> derivativeCache;
+static list<string> expressionCacheOrder;
+static list<pair<string, string> > derivativeCacheOrder;
+
+/**
+ * Add an entry to one of the caches.  Once it is full, the oldest entry is discarded.
+ * The cache lock must be held when this is called.
+ */
+template <class K>
+static void addToCache(map<K, ParsedExpression>& cache, list<K>& order, const K& key, const ParsedExpression& value) {
+    if (!cache.insert(make_pair(key, value)).second)
+        return;
+    order.push_back(key);
+    if (order.size() > MaxCachedExpressions) {
+        cache.erase(order.front());
+        order.pop_front();
+    }
+}
+
+ParsedExpression ExpressionCache::getExpression(const string& expression) {
+    {
+        lock_guard<mutex> lock(cacheLock);
+        map<string, ParsedExpression>::const_iterator cached = expressionCache.find(expression);
+        if (cached != expressionCache.end())
+            return cached->second;
+    }
+
+    // Parse it without holding the lock, so other threads are not blocked.  If the expression
+    // is invalid, this throws an exception and nothing gets cached.
+
+    ParsedExpression result = Parser::parse(expression).optimize();
+    lock_guard<mutex> lock(cacheLock);
+    addToCache(expressionCache, expressionCacheOrder, expression, result);
+    return result;
+}
+
+ParsedExpression ExpressionCache::getDerivative(const string& expression, const string& variable) {
+    pair<string, string> key = make_pair(expression, variable);
+    {
+        lock_guard<mutex> lock(cacheLock);
+        map<pair<string, string>, ParsedExpression>::const_iterator cached = derivativeCache.find(key);
+        if (cached != derivativeCache.end())
+            return cached->second;
+    }
+    ParsedExpression result = getExpression(expression).differentiate(variable).optimize();
+    lock_guard<mutex> lock(cacheLock);
+    addToCache(derivativeCache, derivativeCacheOrder, key, result);
+    return result;
+}
+
+int ExpressionCache::getCacheSize() {
+    lock_guard<mutex> lock(cacheLock);
+    return expressionCache.size()+derivativeCache.size();
+}
+
+void ExpressionCache::clearCache() {
+    lock_guard<mutex> lock(cacheLock);
+    expressionCache.clear();
+    derivativeCache.clear();
+    expressionCacheOrder.clear();
+    derivativeCacheOrder.clear();
+}
@@ -0,0 +1,163 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/FIREMinimizer.h"
+#include "openmm/OpenMMException.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void FIREMinimizer::minimize(Context& context, double tolerance, int maxIterations, double maxDisplacement) {
+    if (maxDisplacement <= 0)
+        throw OpenMMException("FIREMinimizer: maxDisplacement must be positive");
+    const System& system = context.getSystem();
+    int numParticles = system.getNumParticles();
+    int groups = context.getIntegrator().getIntegrationForceGroups();
+    double constraintTol = context.getIntegrator().getConstraintTolerance();
+    bool hasConstraints = (system.getNumConstraints() > 0);
+
+    // Parameters of the algorithm, from Bitzek et al., Phys. Rev. Lett. 97, 170201 (2006).
+
+    const int minStepsBeforeIncrease = 5;
+    const double increaseFactor = 1.1;
+    const double decreaseFactor = 0.5;
+    const double alphaStart = 0.1;
+    const double alphaFactor = 0.99;
+    const double maxTimeStep = 0.01;
+    double dt = 0.001;
+    double alpha = alphaStart;
+    int stepsSinceNegativePower = 0;
+
+    // Massless particles (including virtual sites) are never moved by the minimizer.
+
+    vector<double> invMass(numParticles);
+    int numMoving = 0;
+    for (int i = 0; i < numParticles; i++) {
+        double mass = system.getParticleMass(i);
+        invMass[i] = (mass == 0 ? 0.0 : 1.0/mass);
+        if (mass != 0)
+            numMoving++;
+    }
+    if (numMoving == 0)
+        return;
+
+    // Velocities are used as scratch space for projecting out constrained components of the forces,
+    // so save them to restore at the end.
+
+    vector<Vec3> savedVelocities;
+    if (hasConstraints)
+        savedVelocities = context.getState(State::Velocities).getVelocities();
+    context.applyConstraints(constraintTol);
+    context.computeVirtualSites();
+    vector<Vec3> velocities(numParticles), accelerations(numParticles), newPositions(numParticles), prevPositions;
+    double lastStep = 0.0;
+    for (int iteration = 0; maxIterations == 0 || iteration < maxIterations; iteration++) {
+        State state = context.getState(State::Positions | State::Forces, false, groups);
+        const vector<Vec3>& positions = state.getPositions();
+        const vector<Vec3>& forces = state.getForces();
+        if (hasConstraints && iteration > 0) {
+            // The constraints may have altered the step, so make the velocities consistent with it.
+
+            for (int i = 0; i < numParticles; i++)
+                if (invMass[i] != 0)
+                    velocities[i] = (positions[i]-prevPositions[i])*(1.0/lastStep);
+        }
+        for (int i = 0; i < numParticles; i++)
+            accelerations[i] = forces[i]*invMass[i];
+        if (hasConstraints) {
+            context.setVelocities(accelerations);
+            context.applyVelocityConstraints(constraintTol);
+            accelerations = context.getState(State::Velocities).getVelocities();
+        }
+
+        // Check for convergence.
+
+        double forceNorm = 0.0, power = 0.0, velocityNorm = 0.0, accelerationNorm = 0.0;
+        for (int i = 0; i < numParticles; i++) {
+            if (invMass[i] == 0)
+                continue;
+            Vec3 f = accelerations[i]*(1.0/invMass[i]);
+            forceNorm += f.dot(f);
+            power += f.dot(velocities[i]);
+            velocityNorm += velocities[i].dot(velocities[i]);
+            accelerationNorm += accelerations[i].dot(accelerations[i]);
+        }
+        if (sqrt(forceNorm/(3*numMoving)) <= tolerance)
+            break;
+
+        // Adjust the velocities and time step.
+
+        if (power >= 0) {
+            double scale = (accelerationNorm > 0 ? alpha*sqrt(velocityNorm/accelerationNorm) : 0.0);
+            for (int i = 0; i < numParticles; i++)
+                velocities[i] = velocities[i]*(1.0-alpha) + accelerations[i]*scale;
+            if (++stepsSinceNegativePower > minStepsBeforeIncrease) {
+                dt = min(dt*increaseFactor, maxTimeStep);
+                alpha *= alphaFactor;
+            }
+        }
+        else {
+            stepsSinceNegativePower = 0;
+            dt *= decreaseFactor;
+            alpha = alphaStart;
+            for (int i = 0; i < numParticles; i++)
+                velocities[i] = Vec3();
+        }
+
+        // Take a step, limiting how far each particle can move.
+
+        for (int i = 0; i < numParticles; i++) {
+            newPositions[i] = positions[i];
+            if (invMass[i] == 0)
+                continue;
+            velocities[i] += accelerations[i]*dt;
+            Vec3 delta = velocities[i]*dt;
+            double distance2 = delta.dot(delta);
+            if (distance2 > maxDisplacement*maxDisplacement) {
+                double scale = maxDisplacement/sqrt(distance2);
+                delta *= scale;
+                velocities[i] *= scale;
+            }
+            newPositions[i] += delta;
+        }
+        prevPositions = positions;
+        lastStep = dt;
+        context.setPositions(newPositions);
+        if (hasConstraints)
+            context.applyConstraints(constraintTol);
+        context.computeVirtualSites();
+    }
+    if (hasConstraints)
+        context.setVelocities(savedVelocities);
+}
@@ -77,6 +77,9 @@ bool Force::usesPeriodicBoundaryConditions() const {
 }
 
 ForceImpl& Force::getImplInContext(Context& context) const {
+    // The caller may use the ForceImpl to change parameters, so discard any cached forces.
+
+    context.getImpl().invalidateCachedForces();
     for (auto impl : context.getImpl().getForceImpls())
         if (&impl->getOwner() == this)
             return *impl;
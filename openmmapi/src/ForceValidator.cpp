@@ -0,0 +1,168 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/ForceValidator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/State.h"
+#include "openmm/VerletIntegrator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <set>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Compute the forces and energy for a set of force groups.  Return the average time per evaluation.
+ */
+static double evaluate(Context& context, int groups, int repetitions, vector<Vec3>& forces, double& energy) {
+    State state = context.getState(State::Forces | State::Energy, false, groups);
+    forces = state.getForces();
+    energy = state.getPotentialEnergy();
+    if (repetitions == 0)
+        return 0.0;
+    bool caching = context.getForceCachingEnabled();
+    context.setForceCachingEnabled(false);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++)
+        context.getState(State::Forces, false, groups);
+    double time = chrono::duration<double>(chrono::steady_clock::now()-start).count()/repetitions;
+    context.setForceCachingEnabled(caching);
+    return time;
+}
+
+ForceValidator::ForceValidator() : numRepetitions(10) {
+}
+
+int ForceValidator::getNumRepetitions() const {
+    return numRepetitions;
+}
+
+void ForceValidator::setNumRepetitions(int repetitions) {
+    if (repetitions < 0)
+        throw OpenMMException("ForceValidator: the number of repetitions cannot be negative");
+    numRepetitions = repetitions;
+}
+
+const vector<ForceValidator::GroupResult>& ForceValidator::validate(Context& context) {
+    return validate(context, context.getSystem());
+}
+
+const vector<ForceValidator::GroupResult>& ForceValidator::validate(Context& context, const System& referenceSystem) {
+    const System& system = context.getSystem();
+    if (referenceSystem.getNumParticles() != system.getNumParticles())
+        throw OpenMMException("ForceValidator: the reference System has a different number of particles");
+
+    // Find which force groups are used.
+
+    set<int> groups;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const Force& force = system.getForce(i);
+        groups.insert(force.getForceGroup());
+        const NonbondedForce* nonbonded = dynamic_cast<const NonbondedForce*>(&force);
+        if (nonbonded != NULL && nonbonded->getReciprocalSpaceForceGroup() >= 0)
+            groups.insert(nonbonded->getReciprocalSpaceForceGroup());
+    }
+
+    // Create the reference Context and copy the state to it.
+
+    VerletIntegrator integrator(0.001);
+    Context referenceContext(referenceSystem, integrator, Platform::getPlatformByName("Reference"));
+    State state = context.getState(State::Positions | State::Parameters);
+    Vec3 a, b, c;
+    state.getPeriodicBoxVectors(a, b, c);
+    referenceContext.setPeriodicBoxVectors(a, b, c);
+    referenceContext.setPositions(state.getPositions());
+    const map<string, double>& referenceParameters = referenceContext.getParameters();
+    for (auto& param : state.getParameters())
+        if (referenceParameters.find(param.first) != referenceParameters.end())
+            referenceContext.setParameter(param.first, param.second);
+
+    // Compare the forces for all groups together, then for each group separately.
+
+    platformName = context.getPlatform().getName();
+    results.clear();
+    vector<int> groupList(1, -1);
+    groupList.insert(groupList.end(), groups.begin(), groups.end());
+    vector<Vec3> forces, referenceForces;
+    for (int group : groupList) {
+        int mask = (group == -1 ? 0xFFFFFFFF : 1<<group);
+        GroupResult result;
+        result.group = group;
+        result.time = evaluate(context, mask, numRepetitions, forces, result.energy);
+        result.referenceTime = evaluate(referenceContext, mask, numRepetitions, referenceForces, result.referenceEnergy);
+        double diff2 = 0.0, norm2 = 0.0, maxDiff2 = 0.0;
+        for (int i = 0; i < forces.size(); i++) {
+            Vec3 delta = forces[i]-referenceForces[i];
+            diff2 += delta.dot(delta);
+            norm2 += referenceForces[i].dot(referenceForces[i]);
+            maxDiff2 = max(maxDiff2, delta.dot(delta));
+        }
+        double rmsForce = sqrt(norm2/max((int) forces.size(), 1));
+        double rmsDiff = sqrt(diff2/max((int) forces.size(), 1));
+        if (rmsForce == 0.0) {
+            // There is nothing to normalize by, so report the absolute error.
+
+            result.rmsError = rmsDiff;
+            result.maxError = sqrt(maxDiff2);
+        }
+        else {
+            result.rmsError = rmsDiff/rmsForce;
+            result.maxError = sqrt(maxDiff2)/rmsForce;
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+const vector<ForceValidator::GroupResult>& ForceValidator::getResults() const {
+    return results;
+}
+
+string ForceValidator::getReport() const {
+    string report = "Forces computed with "+platformName+" compared to Reference\n";
+    char line[200];
+    snprintf(line, sizeof(line), "%-6s %12s %12s %16s %16s %14s %14s\n", "Group", "RMS Error", "Max Error", "Energy",
+            "Ref Energy", "Time (ms)", "Ref Time (ms)");
+    report += line;
+    for (const GroupResult& result : results) {
+        string group = (result.group == -1 ? "All" : to_string(result.group));
+        snprintf(line, sizeof(line), "%-6s %12.4g %12.4g %16.8g %16.8g %14.4f %14.4f\n", group.c_str(), result.rmsError, result.maxError,
+                result.energy, result.referenceEnergy, 1000*result.time, 1000*result.referenceTime);
+        report += line;
+    }
+    return report;
+}
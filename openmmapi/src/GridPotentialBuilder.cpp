@@ -0,0 +1,276 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/GridPotentialBuilder.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/TabulatedFunction.h"
+#include "openmm/internal/ThreadPool.h"
+#include "SimTKOpenMMRealType.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Find the NonbondedForce in a System.
+ */
+static const NonbondedForce& findNonbondedForce(const System& system) {
+    const NonbondedForce* nonbonded = NULL;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const NonbondedForce* force = dynamic_cast<const NonbondedForce*>(&system.getForce(i));
+        if (force != NULL) {
+            if (nonbonded != NULL)
+                throw OpenMMException("GridPotentialBuilder: the System contains more than one NonbondedForce");
+            nonbonded = force;
+        }
+    }
+    if (nonbonded == NULL)
+        throw OpenMMException("GridPotentialBuilder: the System does not contain a NonbondedForce");
+    return *nonbonded;
+}
+
+GridPotentialBuilder::GridPotentialBuilder(const System& system, const vector<int>& frozenParticles) : system(system), spacing(0.04), maxValue(1000.0) {
+    const NonbondedForce& nonbonded = findNonbondedForce(system);
+    NonbondedForce::NonbondedMethod method = nonbonded.getNonbondedMethod();
+    if (method != NonbondedForce::NoCutoff && method != NonbondedForce::CutoffNonPeriodic)
+        throw OpenMMException("GridPotentialBuilder: the NonbondedForce must use the NoCutoff or CutoffNonPeriodic method");
+    isFrozen.resize(system.getNumParticles(), false);
+    for (int particle : frozenParticles) {
+        if (particle < 0 || particle >= system.getNumParticles())
+            throw OpenMMException("GridPotentialBuilder: illegal particle index: "+to_string(particle));
+        if (!isFrozen[particle]) {
+            isFrozen[particle] = true;
+            frozen.push_back(particle);
+        }
+    }
+}
+
+double GridPotentialBuilder::getGridSpacing() const {
+    return spacing;
+}
+
+void GridPotentialBuilder::setGridSpacing(double spacing) {
+    if (spacing <= 0)
+        throw OpenMMException("GridPotentialBuilder: the grid spacing must be positive");
+    this->spacing = spacing;
+}
+
+double GridPotentialBuilder::getMaximumValue() const {
+    return maxValue;
+}
+
+void GridPotentialBuilder::setMaximumValue(double value) {
+    if (value <= 0)
+        throw OpenMMException("GridPotentialBuilder: the maximum value must be positive");
+    maxValue = value;
+}
+
+CustomCompoundBondForce* GridPotentialBuilder::createForce(const vector<Vec3>& positions, const Vec3& gridMin, const Vec3& gridMax,
+                                                          const vector<int>& mobileParticles) const {
+    const NonbondedForce& nonbonded = findNonbondedForce(system);
+    if (positions.size() != system.getNumParticles())
+        throw OpenMMException("GridPotentialBuilder: the number of positions does not match the number of particles");
+    for (int i = 0; i < 3; i++)
+        if (gridMax[i] <= gridMin[i])
+            throw OpenMMException("GridPotentialBuilder: gridMax must be greater than gridMin along every axis");
+    set<int> mobile;
+    for (int particle : mobileParticles) {
+        if (particle < 0 || particle >= system.getNumParticles())
+            throw OpenMMException("GridPotentialBuilder: illegal particle index: "+to_string(particle));
+        if (isFrozen[particle])
+            throw OpenMMException("GridPotentialBuilder: particle "+to_string(particle)+" is frozen and cannot also be mobile");
+        mobile.insert(particle);
+    }
+    for (int i = 0; i < nonbonded.getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        nonbonded.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        if ((isFrozen[p1] && mobile.find(p2) != mobile.end()) || (isFrozen[p2] && mobile.find(p1) != mobile.end()))
+            throw OpenMMException("GridPotentialBuilder: there is an exception between frozen and mobile particles "+to_string(p1)+" and "+to_string(p2));
+    }
+
+    // Find the distinct values of sigma for the mobile particles.  Each one needs its own Lennard-Jones grid.
+
+    map<double, int> sigmaIndex;
+    vector<double> sigmas;
+    for (int particle : mobileParticles) {
+        double charge, sigma, epsilon;
+        nonbonded.getParticleParameters(particle, charge, sigma, epsilon);
+        if (epsilon != 0.0 && sigmaIndex.find(sigma) == sigmaIndex.end()) {
+            sigmaIndex[sigma] = sigmas.size();
+            sigmas.push_back(sigma);
+        }
+    }
+    int numSigmas = sigmas.size();
+
+    // Record the parameters of the frozen particles that interact with anything.
+
+    vector<Vec3> frozenPos;
+    vector<double> frozenCharge, frozenSigma, frozenSqrtEps;
+    for (int particle : frozen) {
+        double charge, sigma, epsilon;
+        nonbonded.getParticleParameters(particle, charge, sigma, epsilon);
+        if (charge == 0.0 && epsilon == 0.0)
+            continue;
+        frozenPos.push_back(positions[particle]);
+        frozenCharge.push_back(charge);
+        frozenSigma.push_back(sigma);
+        frozenSqrtEps.push_back(sqrt(epsilon));
+    }
+    int numFrozen = frozenPos.size();
+
+    // Describe the interaction.
+
+    bool cutoff = (nonbonded.getNonbondedMethod() == NonbondedForce::CutoffNonPeriodic);
+    double cutoffDistance = nonbonded.getCutoffDistance();
+    double cutoff2 = cutoffDistance*cutoffDistance;
+    double krf = 0.0, crf = 0.0;
+    if (cutoff) {
+        double eps = nonbonded.getReactionFieldDielectric();
+        krf = (1.0/(cutoff2*cutoffDistance))*(eps-1.0)/(2.0*eps+1.0);
+        crf = (1.0/cutoffDistance)*(3.0*eps)/(2.0*eps+1.0);
+    }
+    bool useSwitch = (cutoff && nonbonded.getUseSwitchingFunction());
+    double switchDistance = nonbonded.getSwitchingDistance();
+
+    // When there is a cutoff, sort the frozen particles into cells so each grid point only needs to look at
+    // nearby ones.
+
+    Vec3 cellOrigin = gridMin-Vec3(cutoffDistance, cutoffDistance, cutoffDistance);
+    int numCells[3] = {1, 1, 1};
+    if (cutoff)
+        for (int i = 0; i < 3; i++)
+            numCells[i] = max(1, (int) ceil((gridMax[i]-gridMin[i])/cutoffDistance)+2);
+    vector<vector<int> > cells(numCells[0]*numCells[1]*numCells[2]);
+    for (int i = 0; i < numFrozen; i++) {
+        if (!cutoff) {
+            cells[0].push_back(i);
+            continue;
+        }
+        int cell[3];
+        bool inside = true;
+        for (int j = 0; j < 3; j++) {
+            cell[j] = (int) floor((frozenPos[i][j]-cellOrigin[j])/cutoffDistance);
+            inside &= (cell[j] >= 0 && cell[j] < numCells[j]);
+        }
+        if (inside)
+            cells[cell[0]+numCells[0]*(cell[1]+numCells[1]*cell[2])].push_back(i);
+    }
+
+    // Compute the grids.
+
+    int size[3];
+    double delta[3];
+    for (int i = 0; i < 3; i++) {
+        size[i] = max(2, (int) round((gridMax[i]-gridMin[i])/spacing)+1);
+        delta[i] = (gridMax[i]-gridMin[i])/(size[i]-1);
+    }
+    int numPoints = size[0]*size[1]*size[2];
+    vector<double> elec(numPoints);
+    vector<vector<double> > lj(numSigmas, vector<double>(numPoints));
+    ThreadPool threads;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<double> ljSum(numSigmas);
+        for (int k = threadIndex; k < size[2]; k += threads.getNumThreads())
+            for (int j = 0; j < size[1]; j++)
+                for (int i = 0; i < size[0]; i++) {
+                    Vec3 point(gridMin[0]+i*delta[0], gridMin[1]+j*delta[1], gridMin[2]+k*delta[2]);
+                    double elecSum = 0.0;
+                    fill(ljSum.begin(), ljSum.end(), 0.0);
+                    int cell[3], minCell[3], maxCell[3];
+                    for (int m = 0; m < 3; m++) {
+                        cell[m] = (cutoff ? (int) floor((point[m]-cellOrigin[m])/cutoffDistance) : 0);
+                        minCell[m] = max(0, cell[m]-1);
+                        maxCell[m] = min(numCells[m]-1, cell[m]+1);
+                    }
+                    for (int cz = minCell[2]; cz <= maxCell[2]; cz++)
+                        for (int cy = minCell[1]; cy <= maxCell[1]; cy++)
+                            for (int cx = minCell[0]; cx <= maxCell[0]; cx++)
+                                for (int atom : cells[cx+numCells[0]*(cy+numCells[1]*cz)]) {
+                                    Vec3 diff = frozenPos[atom]-point;
+                                    double r2 = max(diff.dot(diff), 1e-12);
+                                    if (cutoff && r2 >= cutoff2)
+                                        continue;
+                                    double r = sqrt(r2);
+                                    if (cutoff)
+                                        elecSum += frozenCharge[atom]*(1.0/r+krf*r2-crf);
+                                    else
+                                        elecSum += frozenCharge[atom]/r;
+                                    if (frozenSqrtEps[atom] == 0.0)
+                                        continue;
+                                    double switchValue = 1.0;
+                                    if (useSwitch && r > switchDistance) {
+                                        double t = (r-switchDistance)/(cutoffDistance-switchDistance);
+                                        switchValue = 1+t*t*t*(-10+t*(15-t*6));
+                                    }
+                                    for (int s = 0; s < numSigmas; s++) {
+                                        double sig = 0.5*(sigmas[s]+frozenSigma[atom]);
+                                        double sig2 = sig*sig/r2;
+                                        double sig6 = sig2*sig2*sig2;
+                                        ljSum[s] += switchValue*4.0*frozenSqrtEps[atom]*(sig6-1.0)*sig6;
+                                    }
+                                }
+                    int index = i+size[0]*(j+size[1]*k);
+                    elec[index] = max(-maxValue, min(maxValue, ONE_4PI_EPS0*elecSum));
+                    for (int s = 0; s < numSigmas; s++)
+                        lj[s][index] = max(-maxValue, min(maxValue, ljSum[s]));
+                }
+    });
+    threads.waitForThreads();
+
+    // Create the force.
+
+    string expression = "charge*elec(x1,y1,z1)";
+    for (int s = 0; s < numSigmas; s++)
+        expression += "+sqrteps"+to_string(s)+"*lj"+to_string(s)+"(x1,y1,z1)";
+    CustomCompoundBondForce* force = new CustomCompoundBondForce(1, expression);
+    force->addPerBondParameter("charge");
+    for (int s = 0; s < numSigmas; s++)
+        force->addPerBondParameter("sqrteps"+to_string(s));
+    force->addTabulatedFunction("elec", new Continuous3DFunction(size[0], size[1], size[2], elec, gridMin[0], gridMax[0], gridMin[1], gridMax[1], gridMin[2], gridMax[2]));
+    for (int s = 0; s < numSigmas; s++)
+        force->addTabulatedFunction("lj"+to_string(s), new Continuous3DFunction(size[0], size[1], size[2], lj[s], gridMin[0], gridMax[0], gridMin[1], gridMax[1], gridMin[2], gridMax[2]));
+    for (int i = 0; i < mobileParticles.size(); i++) {
+        double charge, sigma, epsilon;
+        nonbonded.getParticleParameters(mobileParticles[i], charge, sigma, epsilon);
+        vector<double> params(numSigmas+1, 0.0);
+        params[0] = charge;
+        if (epsilon != 0.0)
+            params[1+sigmaIndex[sigma]] = sqrt(epsilon);
+        force->addBond({i}, params);
+    }
+    return force;
+}
@@ -71,6 +71,10 @@ void HarmonicAngleForce::updateParametersInContext(Context& context) {
     dynamic_cast<HarmonicAngleForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
 
+void HarmonicAngleForce::updateParametersInContext(Context& context, int firstAngle, int numAngles) {
+    dynamic_cast<HarmonicAngleForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstAngle, numAngles);
+}
+
 void HarmonicAngleForce::setUsesPeriodicBoundaryConditions(bool periodic) {
     usePeriodic = periodic;
 }
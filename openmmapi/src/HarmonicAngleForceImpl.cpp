@@ -86,3 +86,10 @@ void HarmonicAngleForceImpl::updateParametersInContext(ContextImpl& context) {
     kernel.getAs<CalcHarmonicAngleForceKernel>().copyParametersToContext(context, owner);
     context.systemChanged();
 }
+
+void HarmonicAngleForceImpl::updateParametersInContext(ContextImpl& context, int firstAngle, int numAngles) {
+    if (firstAngle < 0 || numAngles < 0 || firstAngle+numAngles > owner.getNumAngles())
+        throw OpenMMException("updateParametersInContext: Illegal range of angles");
+    kernel.getAs<CalcHarmonicAngleForceKernel>().copySomeParametersToContext(context, owner, firstAngle, numAngles);
+    context.systemChanged();
+}
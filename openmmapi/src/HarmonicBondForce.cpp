@@ -69,6 +69,10 @@ void HarmonicBondForce::updateParametersInContext(Context& context) {
     dynamic_cast<HarmonicBondForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
 
+void HarmonicBondForce::updateParametersInContext(Context& context, int firstBond, int numBonds) {
+    dynamic_cast<HarmonicBondForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstBond, numBonds);
+}
+
 void HarmonicBondForce::setUsesPeriodicBoundaryConditions(bool periodic) {
     usePeriodic = periodic;
 }
@@ -92,3 +92,10 @@ void HarmonicBondForceImpl::updateParametersInContext(ContextImpl& context) {
     kernel.getAs<CalcHarmonicBondForceKernel>().copyParametersToContext(context, owner);
     context.systemChanged();
 }
+
+void HarmonicBondForceImpl::updateParametersInContext(ContextImpl& context, int firstBond, int numBonds) {
+    if (firstBond < 0 || numBonds < 0 || firstBond+numBonds > owner.getNumBonds())
+        throw OpenMMException("updateParametersInContext: Illegal range of bonds");
+    kernel.getAs<CalcHarmonicBondForceKernel>().copySomeParametersToContext(context, owner, firstBond, numBonds);
+    context.systemChanged();
+}
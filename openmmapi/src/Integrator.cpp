@@ -37,9 +37,62 @@
 #include "openmm/internal/ContextImpl.h"
 
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace OpenMM;
 
+namespace {
+
+/**
+ * The threads that stepAsync() runs steps on.  A thread is reused once it finishes, and a new one is
+ * started only when every existing thread is busy, so there is never more than one thread for each
+ * Context being stepped at once.  The pool is never deleted and its threads are detached, so idle
+ * threads do not keep the process from exiting.
+ */
+class AsyncStepPool {
+public:
+    AsyncStepPool() : numIdle(0) {
+    }
+    std::future<void> submit(std::packaged_task<void()> task) {
+        std::future<void> result = task.get_future();
+        std::unique_lock<std::mutex> lock(queueLock);
+        tasks.push_back(std::move(task));
+        if (tasks.size() > numIdle)
+            std::thread(&AsyncStepPool::run, this).detach();
+        else
+            queueCondition.notify_one();
+        return result;
+    }
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(queueLock);
+        while (true) {
+            numIdle++;
+            queueCondition.wait(lock, [this] () { return !tasks.empty(); });
+            numIdle--;
+            std::packaged_task<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+    std::mutex queueLock;
+    std::condition_variable queueCondition;
+    std::deque<std::packaged_task<void()> > tasks;
+    size_t numIdle;
+};
+
+AsyncStepPool& getAsyncStepPool() {
+    static AsyncStepPool* pool = new AsyncStepPool();
+    return *pool;
+}
+
+}
+
 Integrator::Integrator() : owner(NULL), context(NULL), forceGroups(0xFFFFFFFF) {
 }
 
@@ -82,6 +135,12 @@ void Integrator::setIntegrationForceGroups(int groups) {
     forceGroups = groups;
 }
 
+std::future<void> Integrator::stepAsync(int steps) {
+    if (context == NULL)
+        throw OpenMMException("This Integrator is not bound to a context!");
+    return getAsyncStepPool().submit(std::packaged_task<void()>([this, steps] () { step(steps); }));
+}
+
 std::vector<Vec3> Integrator::getVelocitiesForTemperature(const System &system, double temperature, int randomSeed) const {
     // Generate the list of Gaussian random numbers.
     OpenMM_SFMT::SFMT sfmt;
@@ -49,9 +49,29 @@ struct MinimizerData {
     bool checkLargeForces;
     VerletIntegrator cpuIntegrator;
     Context* cpuContext;
+    vector<Vec3> positions;
+    vector<char> massless;
+    vector<int> constraintParticle1, constraintParticle2;
+    vector<double> constraintDistance;
     MinimizerData(Context& context, double k) : context(context), k(k), cpuIntegrator(1.0), cpuContext(NULL) {
         string platformName = context.getPlatform().getName();
         checkLargeForces = (platformName == "CUDA" || platformName == "OpenCL" || platformName == "HIP" || platformName == "Metal");
+
+        // Record information about the System that is needed on every evaluation, so we don't
+        // need to look it up or reallocate storage each time.
+
+        const System& system = context.getSystem();
+        int numParticles = system.getNumParticles();
+        positions.resize(numParticles);
+        massless.resize(numParticles);
+        for (int i = 0; i < numParticles; i++)
+            massless[i] = (system.getParticleMass(i) == 0);
+        int numConstraints = system.getNumConstraints();
+        constraintParticle1.resize(numConstraints);
+        constraintParticle2.resize(numConstraints);
+        constraintDistance.resize(numConstraints);
+        for (int i = 0; i < numConstraints; i++)
+            system.getConstraintParameters(i, constraintParticle1[i], constraintParticle2[i], constraintDistance[i]);
     }
     ~MinimizerData() {
         if (cpuContext != NULL)
@@ -76,14 +96,13 @@ struct MinimizerData {
     }
 };
 
-static double computeForcesAndEnergy(Context& context, const vector<Vec3>& positions, lbfgsfloatval_t *g) {
+static double computeForcesAndEnergy(Context& context, const vector<Vec3>& positions, const vector<char>& massless, lbfgsfloatval_t *g) {
     context.setPositions(positions);
     context.computeVirtualSites();
     State state = context.getState(State::Forces | State::Energy, false, context.getIntegrator().getIntegrationForceGroups());
     const vector<Vec3>& forces = state.getForces();
-    const System& system = context.getSystem();
     for (int i = 0; i < forces.size(); i++) {
-        if (system.getParticleMass(i) == 0) {
+        if (massless[i]) {
             g[3*i] = 0.0;
             g[3*i+1] = 0.0;
             g[3*i+2] = 0.0;
@@ -100,15 +119,15 @@ static double computeForcesAndEnergy(Context& context, const vector<Vec3>& posit
 static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsfloatval_t *g, const int n, const lbfgsfloatval_t step) {
     MinimizerData* data = reinterpret_cast<MinimizerData*>(instance);
     Context& context = data->context;
-    const System& system = context.getSystem();
-    int numParticles = system.getNumParticles();
+    const vector<char>& massless = data->massless;
+    int numParticles = massless.size();
 
     // Compute the force and energy for this configuration.
 
-    vector<Vec3> positions(numParticles);
+    vector<Vec3>& positions = data->positions;
     for (int i = 0; i < numParticles; i++)
         positions[i] = Vec3(x[3*i], x[3*i+1], x[3*i+2]);
-    double energy = computeForcesAndEnergy(context, positions, g);
+    double energy = computeForcesAndEnergy(context, positions, massless, g);
     if (data->checkLargeForces) {
         // The CUDA, OpenCL and HIP platforms accumulate forces in fixed point, so they
         // can't handle very large forces.  Check for problematic forces (very large,
@@ -116,7 +135,7 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
 
         for (int i = 0; i < 3*numParticles; i++) {
             if (!(fabs(g[i]) < 2e9)) {
-                energy = computeForcesAndEnergy(data->getCpuContext(), positions, g);
+                energy = computeForcesAndEnergy(data->getCpuContext(), positions, massless, g);
                 break;
             }
         }
@@ -124,12 +143,12 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
 
     // Add harmonic forces for any constraints.
 
-    int numConstraints = system.getNumConstraints();
+    int numConstraints = data->constraintDistance.size();
     double k = data->k;
     for (int i = 0; i < numConstraints; i++) {
-        int particle1, particle2;
-        double distance;
-        system.getConstraintParameters(i, particle1, particle2, distance);
+        int particle1 = data->constraintParticle1[i];
+        int particle2 = data->constraintParticle2[i];
+        double distance = data->constraintDistance[i];
         Vec3 delta = positions[particle2]-positions[particle1];
         double r2 = delta.dot(delta);
         double r = sqrt(r2);
@@ -137,12 +156,12 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
         double dr = r-distance;
         double kdr = k*dr;
         energy += 0.5*kdr*dr;
-        if (system.getParticleMass(particle1) != 0) {
+        if (!massless[particle1]) {
             g[3*particle1] -= kdr*delta[0];
             g[3*particle1+1] -= kdr*delta[1];
             g[3*particle1+2] -= kdr*delta[2];
         }
-        if (system.getParticleMass(particle2) != 0) {
+        if (!massless[particle2]) {
             g[3*particle2] += kdr*delta[0];
             g[3*particle2+1] += kdr*delta[1];
             g[3*particle2+2] += kdr*delta[2];
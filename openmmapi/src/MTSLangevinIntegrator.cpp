@@ -0,0 +1,156 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/MTSLangevinIntegrator.h"
+#include "openmm/Context.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/kernels.h"
+#include <algorithm>
+#include <map>
+#include <string>
+
+using namespace OpenMM;
+using namespace std;
+
+static bool compareSubsteps(const pair<int, int>& a, const pair<int, int>& b) {
+    return a.second < b.second;
+}
+
+MTSLangevinIntegrator::MTSLangevinIntegrator(double temperature, double frictionCoeff, double stepSize, const vector<pair<int, int> >& groups) : groups(groups) {
+    setTemperature(temperature);
+    setFriction(frictionCoeff);
+    setStepSize(stepSize);
+    setConstraintTolerance(1e-5);
+    setRandomNumberSeed(0);
+    if (groups.size() == 0)
+        throw OpenMMException("MTSLangevinIntegrator: No force groups specified");
+    stable_sort(this->groups.begin(), this->groups.end(), compareSubsteps);
+    for (auto& g : this->groups)
+        if (g.first < 0 || g.first > 31)
+            throw OpenMMException("MTSLangevinIntegrator: Force group must be between 0 and 31");
+    vector<pair<int, double> > ops;
+    createSubsteps(1, 0, ops);
+
+    // Velocity updates that happen one after another all use forces computed at the same positions.
+    // Combine the updates for each group into one, then combine groups whose updates cover the same
+    // interval so their forces can be computed together.
+
+    map<int, double> pending;
+    for (int i = 0; i <= ops.size(); i++) {
+        if (i < ops.size() && ops[i].first != 0) {
+            for (int j = 0; j < 32; j++)
+                if ((ops[i].first & (1<<j)) != 0)
+                    pending[j] += ops[i].second;
+            continue;
+        }
+        map<double, int> combined;
+        for (auto& p : pending)
+            combined[p.second] |= 1<<p.first;
+        for (auto& c : combined)
+            operations.push_back(make_pair(c.second, c.first));
+        pending.clear();
+        if (i < ops.size())
+            operations.push_back(ops[i]);
+    }
+}
+
+void MTSLangevinIntegrator::createSubsteps(int parentSubsteps, int level, vector<pair<int, double> >& ops) {
+    int group = groups[level].first;
+    int substeps = groups[level].second;
+    if (substeps < parentSubsteps || substeps%parentSubsteps != 0)
+        throw OpenMMException("MTSLangevinIntegrator: The number for substeps for each group must be a multiple of the number for the previous group");
+    for (int i = 0; i < substeps/parentSubsteps; i++) {
+        ops.push_back(make_pair(1<<group, 0.5/substeps));
+        if (level == groups.size()-1)
+            ops.push_back(make_pair(0, 1.0/substeps));
+        else
+            createSubsteps(substeps, level+1, ops);
+        ops.push_back(make_pair(1<<group, 0.5/substeps));
+    }
+}
+
+void MTSLangevinIntegrator::initialize(ContextImpl& contextRef) {
+    if (owner != NULL && &contextRef.getOwner() != owner)
+        throw OpenMMException("This Integrator is already bound to a context");
+    context = &contextRef;
+    owner = &contextRef.getOwner();
+    kernel = context->getPlatform().createKernel(IntegrateMTSLangevinStepKernel::Name(), contextRef);
+    kernel.getAs<IntegrateMTSLangevinStepKernel>().initialize(contextRef.getSystem(), *this);
+}
+
+void MTSLangevinIntegrator::setTemperature(double temp) {
+    if (temp < 0)
+        throw OpenMMException("Temperature cannot be negative");
+    temperature = temp;
+}
+
+void MTSLangevinIntegrator::setFriction(double coeff) {
+    if (coeff < 0)
+        throw OpenMMException("Friction cannot be negative");
+    friction = coeff;
+}
+
+void MTSLangevinIntegrator::cleanup() {
+    kernel = Kernel();
+}
+
+vector<string> MTSLangevinIntegrator::getKernelNames() {
+    std::vector<std::string> names;
+    names.push_back(IntegrateMTSLangevinStepKernel::Name());
+    return names;
+}
+
+double MTSLangevinIntegrator::computeKineticEnergy() {
+    return kernel.getAs<IntegrateMTSLangevinStepKernel>().computeKineticEnergy(*context, *this);
+}
+
+bool MTSLangevinIntegrator::kineticEnergyRequiresForce() const {
+    return false;
+}
+
+void MTSLangevinIntegrator::step(int steps) {
+    if (context == NULL)
+        throw OpenMMException("This Integrator is not bound to a context!");  
+    IntegrateMTSLangevinStepKernel& stepKernel = kernel.getAs<IntegrateMTSLangevinStepKernel>();
+    for (int i = 0; i < steps; ++i) {
+        context->updateContextState();
+        for (auto& op : operations) {
+            if (op.first == 0)
+                stepKernel.updatePositions(*context, *this, op.second*getStepSize());
+            else {
+                context->calcForcesAndEnergy(true, false, op.first);
+                stepKernel.updateVelocities(*context, *this, op.second*getStepSize());
+            }
+        }
+        stepKernel.finishStep(*context, *this);
+    }
+}
@@ -69,10 +69,11 @@ void MonteCarloAnisotropicBarostatImpl::updateContextState(ContextImpl& context,
         return;
     step = 0;
     
-    // Compute the current potential energy.
+    // Compute the current potential energy.  Only the energy is needed, so skip computing forces
+    // and the kinetic energy.
     
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure;
     
     // Choose which axis to modify at random.
@@ -114,7 +115,7 @@ void MonteCarloAnisotropicBarostatImpl::updateContextState(ContextImpl& context,
 
     // Compute the energy of the modified system.
     
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double kT = BOLTZ*context.getParameter(MonteCarloAnisotropicBarostat::Temperature());
     double w = finalEnergy-initialEnergy + pressure*deltaVolume - context.getMolecules().size()*kT*log(newVolume/volume);
     if (w > 0 && SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber() > exp(-w/kT)) {
@@ -122,6 +123,11 @@ void MonteCarloAnisotropicBarostatImpl::updateContextState(ContextImpl& context,
         
         context.getOwner().setPeriodicBoxVectors(box[0], box[1], box[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().restoreCoordinates(context);
+
+        // Computing energies without forces may have overwritten the force buffer on
+        // some platforms, so the forces need to be recomputed.
+
+        forcesInvalid = true;
     }
     else {
         numAccepted[axis]++;
@@ -65,10 +65,11 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
         return;
     step = 0;
 
-    // Compute the current potential energy.
+    // Compute the current potential energy.  Only the energy is needed, so skip computing forces
+    // and the kinetic energy.
 
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
 
     // Modify the periodic box size.
 
@@ -83,7 +84,7 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
 
     // Compute the energy of the modified system.
     
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure = context.getParameter(MonteCarloBarostat::Pressure())*(AVOGADRO*1e-25);
     double kT = BOLTZ*context.getParameter(MonteCarloBarostat::Temperature());
     double w = finalEnergy-initialEnergy + pressure*deltaVolume - context.getMolecules().size()*kT*log(newVolume/volume);
@@ -92,6 +93,11 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
 
         context.getOwner().setPeriodicBoxVectors(box[0], box[1], box[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().restoreCoordinates(context);
+
+        // Computing energies without forces may have overwritten the force buffer on
+        // some platforms, so the forces need to be recomputed.
+
+        forcesInvalid = true;
     }
     else {
         numAccepted++;
@@ -65,10 +65,11 @@ void MonteCarloFlexibleBarostatImpl::updateContextState(ContextImpl& context, bo
         return;
     step = 0;
 
-    // Compute the current potential energy.
+    // Compute the current potential energy.  Only the energy is needed, so skip computing forces
+    // and the kinetic energy.
 
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure = context.getParameter(MonteCarloFlexibleBarostat::Pressure())*(AVOGADRO*1e-25);
 
     // Generate trial box vectors
@@ -105,7 +106,7 @@ void MonteCarloFlexibleBarostatImpl::updateContextState(ContextImpl& context, bo
         numberOfScaledParticles = context.getMolecules().size();
     else
         numberOfScaledParticles = context.getSystem().getNumParticles();
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double kT = BOLTZ*context.getParameter(MonteCarloFlexibleBarostat::Temperature());
     double w0 = finalEnergy-initialEnergy;
     double w1 = pressure*(newVolume-volume);
@@ -117,6 +118,11 @@ void MonteCarloFlexibleBarostatImpl::updateContextState(ContextImpl& context, bo
 
         context.getOwner().setPeriodicBoxVectors(box[0], box[1], box[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().restoreCoordinates(context);
+
+        // Computing energies without forces may have overwritten the force buffer on
+        // some platforms, so the forces need to be recomputed.
+
+        forcesInvalid = true;
     }
     else {
         numAccepted++;
@@ -34,13 +34,12 @@
 #include "openmm/NonbondedForce.h"
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include <algorithm>
 #include <cmath>
-#include <map>
 #include <sstream>
 #include <utility>
 
 using namespace OpenMM;
-using std::map;
 using std::pair;
 using std::set;
 using std::string;
@@ -49,7 +48,7 @@ using std::vector;
 
 NonbondedForce::NonbondedForce() : nonbondedMethod(NoCutoff), cutoffDistance(1.0), switchingDistance(-1.0), rfDielectric(78.3),
         ewaldErrorTol(5e-4), alpha(0.0), dalpha(0.0), useSwitchingFunction(false), useDispersionCorrection(true), exceptionsUsePeriodic(false), recipForceGroup(-1),
-        includeDirectSpace(true), nx(0), ny(0), nz(0), dnx(0), dny(0), dnz(0) {
+        includeDirectSpace(true), nx(0), ny(0), nz(0), dnx(0), dny(0), dnz(0), pmeOrder(5) {
 }
 
 NonbondedForce::NonbondedMethod NonbondedForce::getNonbondedMethod() const {
@@ -138,6 +137,28 @@ void NonbondedForce::getLJPMEParametersInContext(const Context& context, double&
     dynamic_cast<const NonbondedForceImpl&>(getImplInContext(context)).getLJPMEParameters(alpha, nx, ny, nz);
 }
 
+int NonbondedForce::getPMEOrder() const {
+    return pmeOrder;
+}
+
+void NonbondedForce::setPMEOrder(int order) {
+    if (order < 4 || order > 6)
+        throw OpenMMException("NonbondedForce: PME order must be 4, 5, or 6");
+    pmeOrder = order;
+}
+
+void NonbondedForce::estimatePMEError(const System& system, double& directError, double& reciprocalError) const {
+    if (nonbondedMethod != PME && nonbondedMethod != LJPME)
+        throw OpenMMException("NonbondedForce: estimatePMEError() requires the nonbonded method to be PME or LJPME");
+    NonbondedForceImpl::estimatePMEError(system, *this, directError, reciprocalError, false);
+}
+
+void NonbondedForce::estimateLJPMEError(const System& system, double& directError, double& reciprocalError) const {
+    if (nonbondedMethod != LJPME)
+        throw OpenMMException("NonbondedForce: estimateLJPMEError() requires the nonbonded method to be LJPME");
+    NonbondedForceImpl::estimatePMEError(system, *this, directError, reciprocalError, true);
+}
+
 int NonbondedForce::addParticle(double charge, double sigma, double epsilon) {
     particles.push_back(ParticleInfo(charge, sigma, epsilon));
     return particles.size()-1;
@@ -158,11 +179,8 @@ void NonbondedForce::setParticleParameters(int index, double charge, double sigm
 }
 
 int NonbondedForce::addException(int particle1, int particle2, double chargeProd, double sigma, double epsilon, bool replace) {
-    map<pair<int, int>, int>::iterator iter = exceptionMap.find(pair<int, int>(particle1, particle2));
-    int newIndex;
-    if (iter == exceptionMap.end())
-        iter = exceptionMap.find(pair<int, int>(particle2, particle1));
-    if (iter != exceptionMap.end()) {
+    int index = findException(particle1, particle2);
+    if (index != -1) {
         if (!replace) {
             stringstream msg;
             msg << "NonbondedForce: There is already an exception for particles ";
@@ -171,16 +189,13 @@ int NonbondedForce::addException(int particle1, int particle2, double chargeProd
             msg << particle2;
             throw OpenMMException(msg.str());
         }
-        exceptions[iter->second] = ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon);
-        newIndex = iter->second;
-        exceptionMap.erase(iter->first);
-    }
-    else {
-        exceptions.push_back(ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon));
-        newIndex = exceptions.size()-1;
+        exceptions[index] = ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon);
+        return index;
     }
-    exceptionMap[pair<int, int>(particle1, particle2)] = newIndex;
-    return newIndex;
+    exceptions.push_back(ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon));
+    index = exceptions.size()-1;
+    addExceptionToTable(index);
+    return index;
 }
 void NonbondedForce::getExceptionParameters(int index, int& particle1, int& particle2, double& chargeProd, double& sigma, double& epsilon) const {
     ASSERT_VALID_INDEX(index, exceptions);
@@ -193,11 +208,98 @@ void NonbondedForce::getExceptionParameters(int index, int& particle1, int& part
 
 void NonbondedForce::setExceptionParameters(int index, int particle1, int particle2, double chargeProd, double sigma, double epsilon) {
     ASSERT_VALID_INDEX(index, exceptions);
-    exceptions[index].particle1 = particle1;
-    exceptions[index].particle2 = particle2;
-    exceptions[index].chargeProd = chargeProd;
-    exceptions[index].sigma = sigma;
-    exceptions[index].epsilon = epsilon;
+    ExceptionInfo& exception = exceptions[index];
+    bool samePair = ((exception.particle1 == particle1 && exception.particle2 == particle2) ||
+                     (exception.particle1 == particle2 && exception.particle2 == particle1));
+    if (!samePair)
+        removeExceptionFromTable(index);
+    exception.particle1 = particle1;
+    exception.particle2 = particle2;
+    exception.chargeProd = chargeProd;
+    exception.sigma = sigma;
+    exception.epsilon = epsilon;
+    if (!samePair)
+        addExceptionToTable(index);
+}
+
+/**
+ * Compute the position in the exception table where the search for a pair of particles begins.
+ * The order of the particles does not matter.
+ */
+static size_t hashExceptionPair(int particle1, int particle2, size_t mask) {
+    unsigned long long a = (unsigned int) std::min(particle1, particle2);
+    unsigned long long b = (unsigned int) std::max(particle1, particle2);
+    unsigned long long key = a*0x9E3779B97F4A7C15ULL ^ b*0xC2B2AE3D27D4EB4FULL;
+    key ^= key>>32;
+    return (size_t) key & mask;
+}
+
+// The exceptions are indexed by an open addressing hash table with linear probing.  Each slot holds
+// the index of an exception, or -1 if it is empty.  It takes far less memory than a std::map, which
+// matters for Systems with tens of millions of exceptions.
+
+int NonbondedForce::findException(int particle1, int particle2) const {
+    if (exceptionTable.empty())
+        return -1;
+    size_t mask = exceptionTable.size()-1;
+    for (size_t slot = hashExceptionPair(particle1, particle2, mask); exceptionTable[slot] != -1; slot = (slot+1)&mask) {
+        const ExceptionInfo& exception = exceptions[exceptionTable[slot]];
+        if ((exception.particle1 == particle1 && exception.particle2 == particle2) ||
+                (exception.particle1 == particle2 && exception.particle2 == particle1))
+            return exceptionTable[slot];
+    }
+    return -1;
+}
+
+void NonbondedForce::addExceptionToTable(int index) {
+    // Keep the table at most half full so searches stay short.
+
+    if (2*exceptions.size() > exceptionTable.size()) {
+        rebuildExceptionTable();
+        return;
+    }
+    size_t mask = exceptionTable.size()-1;
+    size_t slot = hashExceptionPair(exceptions[index].particle1, exceptions[index].particle2, mask);
+    while (exceptionTable[slot] != -1)
+        slot = (slot+1)&mask;
+    exceptionTable[slot] = index;
+}
+
+void NonbondedForce::removeExceptionFromTable(int index) {
+    size_t mask = exceptionTable.size()-1;
+    size_t slot = hashExceptionPair(exceptions[index].particle1, exceptions[index].particle2, mask);
+    while (exceptionTable[slot] != index)
+        slot = (slot+1)&mask;
+
+    // Shift later entries back so no search passes through an empty slot before reaching them.
+
+    size_t next = slot;
+    while (true) {
+        next = (next+1)&mask;
+        int entry = exceptionTable[next];
+        if (entry == -1)
+            break;
+        size_t home = hashExceptionPair(exceptions[entry].particle1, exceptions[entry].particle2, mask);
+        if (((next-home)&mask) >= ((next-slot)&mask)) {
+            exceptionTable[slot] = entry;
+            slot = next;
+        }
+    }
+    exceptionTable[slot] = -1;
+}
+
+void NonbondedForce::rebuildExceptionTable() {
+    size_t size = 16;
+    while (size < 4*exceptions.size())
+        size *= 2;
+    exceptionTable.assign(size, -1);
+    size_t mask = size-1;
+    for (int i = 0; i < (int) exceptions.size(); i++) {
+        size_t slot = hashExceptionPair(exceptions[i].particle1, exceptions[i].particle2, mask);
+        while (exceptionTable[slot] != -1)
+            slot = (slot+1)&mask;
+        exceptionTable[slot] = i;
+    }
 }
 
 ForceImpl* NonbondedForce::createImpl() const {
@@ -209,50 +311,55 @@ void NonbondedForce::createExceptionsFromBonds(const vector<pair<int, int> >& bo
         if (bond.first < 0 || bond.second < 0 || bond.first >= particles.size() || bond.second >= particles.size())
             throw OpenMMException("createExceptionsFromBonds: Illegal particle index in list of bonds");
 
-    // Find particles separated by 1, 2, or 3 bonds.
+    // Build sorted lists of bonded neighbors.
 
-    vector<set<int> > exclusions(particles.size());
-    vector<set<int> > bonded12(exclusions.size());
+    vector<vector<int> > bonded12(particles.size());
     for (auto& bond : bonds) {
-        bonded12[bond.first].insert(bond.second);
-        bonded12[bond.second].insert(bond.first);
+        bonded12[bond.first].push_back(bond.second);
+        bonded12[bond.second].push_back(bond.first);
     }
-    for (int i = 0; i < (int) exclusions.size(); ++i)
-        addExclusionsToSet(bonded12, exclusions[i], i, i, 2);
-
-    // Find particles separated by 1 or 2 bonds and create the exceptions.
-
-    for (int i = 0; i < (int) exclusions.size(); ++i) {
-        set<int> bonded13;
-        addExclusionsToSet(bonded12, bonded13, i, i, 1);
-        for (int j : exclusions[i]) {
-            if (j < i) {
-                if (bonded13.find(j) == bonded13.end()) {
-                    // This is a 1-4 interaction.
-
-                    const ParticleInfo& particle1 = particles[j];
-                    const ParticleInfo& particle2 = particles[i];
-                    const double chargeProd = coulomb14Scale*particle1.charge*particle2.charge;
-                    const double sigma = 0.5*(particle1.sigma+particle2.sigma);
-                    const double epsilon = lj14Scale*std::sqrt(particle1.epsilon*particle2.epsilon);
-                    addException(j, i, chargeProd, sigma, epsilon);
-                }
-                else {
-                    // This interaction should be completely excluded.
-
-                    addException(j, i, 0.0, 1.0, 0.0);
-                }
-            }
-        }
+    for (vector<int>& neighbors : bonded12) {
+        sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
     }
-}
 
-void NonbondedForce::addExclusionsToSet(const vector<set<int> >& bonded12, set<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const {
-    for (int i : bonded12[fromParticle]) {
-        if (i != baseParticle)
-            exclusions.insert(i);
-        if (currentLevel > 0)
-            addExclusionsToSet(bonded12, exclusions, baseParticle, i, currentLevel-1);
+    // For each particle, find the ones separated from it by 1 or 2 bonds, and by up to 3 bonds, then create
+    // exceptions for the ones with lower indices.  These lists are small, so sorted vectors are much faster
+    // than sets, and only one particle's lists are stored at a time.
+
+    vector<int> bonded13, bonded14;
+    for (int i = 0; i < (int) bonded12.size(); ++i) {
+        bonded13.clear();
+        for (int j : bonded12[i]) {
+            bonded13.push_back(j);
+            bonded13.insert(bonded13.end(), bonded12[j].begin(), bonded12[j].end());
+        }
+        sort(bonded13.begin(), bonded13.end());
+        bonded13.erase(unique(bonded13.begin(), bonded13.end()), bonded13.end());
+        bonded14 = bonded13;
+        for (int j : bonded13)
+            bonded14.insert(bonded14.end(), bonded12[j].begin(), bonded12[j].end());
+        sort(bonded14.begin(), bonded14.end());
+        bonded14.erase(unique(bonded14.begin(), bonded14.end()), bonded14.end());
+        for (int j : bonded14) {
+            if (j >= i)
+                break;
+            if (!binary_search(bonded13.begin(), bonded13.end(), j)) {
+                // This is a 1-4 interaction.
+
+                const ParticleInfo& particle1 = particles[j];
+                const ParticleInfo& particle2 = particles[i];
+                const double chargeProd = coulomb14Scale*particle1.charge*particle2.charge;
+                const double sigma = 0.5*(particle1.sigma+particle2.sigma);
+                const double epsilon = lj14Scale*std::sqrt(particle1.epsilon*particle2.epsilon);
+                addException(j, i, chargeProd, sigma, epsilon);
+            }
+            else {
+                // This interaction should be completely excluded.
+
+                addException(j, i, 0.0, 1.0, 0.0);
+            }
+        }
     }
 }
 
@@ -202,15 +202,16 @@ void NonbondedForceImpl::calcPMEParameters(const System& system, const Nonbonded
         system.getDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
         double tol = force.getEwaldErrorTolerance();
         alpha = (1.0/force.getCutoffDistance())*std::sqrt(-log(2.0*tol));
+        double exponent = 1.0/force.getPMEOrder();
         if (lj) {
-            xsize = (int) ceil(alpha*boxVectors[0][0]/(3*pow(tol, 0.2)));
-            ysize = (int) ceil(alpha*boxVectors[1][1]/(3*pow(tol, 0.2)));
-            zsize = (int) ceil(alpha*boxVectors[2][2]/(3*pow(tol, 0.2)));
+            xsize = (int) ceil(alpha*boxVectors[0][0]/(3*pow(tol, exponent)));
+            ysize = (int) ceil(alpha*boxVectors[1][1]/(3*pow(tol, exponent)));
+            zsize = (int) ceil(alpha*boxVectors[2][2]/(3*pow(tol, exponent)));
         }
         else {
-            xsize = (int) ceil(2*alpha*boxVectors[0][0]/(3*pow(tol, 0.2)));
-            ysize = (int) ceil(2*alpha*boxVectors[1][1]/(3*pow(tol, 0.2)));
-            zsize = (int) ceil(2*alpha*boxVectors[2][2]/(3*pow(tol, 0.2)));
+            xsize = (int) ceil(2*alpha*boxVectors[0][0]/(3*pow(tol, exponent)));
+            ysize = (int) ceil(2*alpha*boxVectors[1][1]/(3*pow(tol, exponent)));
+            zsize = (int) ceil(2*alpha*boxVectors[2][2]/(3*pow(tol, exponent)));
         }
         xsize = max(xsize, 6);
         ysize = max(ysize, 6);
@@ -218,6 +219,20 @@ void NonbondedForceImpl::calcPMEParameters(const System& system, const Nonbonded
     }
 }
 
+void NonbondedForceImpl::estimatePMEError(const System& system, const NonbondedForce& force, double& directError, double& reciprocalError, bool lj) {
+    double alpha;
+    int size[3];
+    calcPMEParameters(system, force, alpha, size[0], size[1], size[2], lj);
+    Vec3 boxVectors[3];
+    system.getDefaultPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    double cutoff = force.getCutoffDistance();
+    directError = 0.5*exp(-alpha*alpha*cutoff*cutoff);
+    double scale = (lj ? 1.0 : 2.0);
+    reciprocalError = 0.0;
+    for (int i = 0; i < 3; i++)
+        reciprocalError = max(reciprocalError, pow(scale*alpha*boxVectors[i][i]/(3*size[i]), (double) force.getPMEOrder()));
+}
+
 int NonbondedForceImpl::findZero(const NonbondedForceImpl::ErrorFunction& f, int initialGuess) {
     int arg = initialGuess;
     double value = f.getValue(arg);
@@ -0,0 +1,257 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/ParticleActivator.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * This is the interface for the objects that update the parameters of one Force.
+ */
+class ParticleActivator::ManagedForce {
+public:
+    virtual ~ManagedForce() {
+    }
+    /**
+     * Update the parameters of every term involving a set of particles to reflect whether they are
+     * active, and copy them to a Context.
+     */
+    virtual void update(Context& context, const vector<int>& particles, const vector<bool>& active) = 0;
+};
+
+/**
+ * This manages a NonbondedForce.
+ */
+class ParticleActivator::NonbondedTerms : public ParticleActivator::ManagedForce {
+public:
+    NonbondedTerms(NonbondedForce& force) : force(force) {
+        int numParticles = force.getNumParticles();
+        charge.resize(numParticles);
+        epsilon.resize(numParticles);
+        for (int i = 0; i < numParticles; i++) {
+            double sigma;
+            force.getParticleParameters(i, charge[i], sigma, epsilon[i]);
+        }
+        particleExceptions.resize(numParticles);
+        for (int i = 0; i < force.getNumExceptions(); i++) {
+            int p1, p2;
+            double chargeProd, sigma, eps;
+            force.getExceptionParameters(i, p1, p2, chargeProd, sigma, eps);
+            if (chargeProd == 0.0 && eps == 0.0)
+                continue;
+            exceptionIndex.push_back(i);
+            exceptionChargeProd.push_back(chargeProd);
+            exceptionSigma.push_back(sigma);
+            exceptionEpsilon.push_back(eps);
+            particleExceptions[p1].push_back(exceptionIndex.size()-1);
+            particleExceptions[p2].push_back(exceptionIndex.size()-1);
+        }
+    }
+    void update(Context& context, const vector<int>& particles, const vector<bool>& active) {
+        bool changed = false;
+        for (int particle : particles) {
+            if (particle >= force.getNumParticles())
+                continue;
+            double q, sigma, eps;
+            force.getParticleParameters(particle, q, sigma, eps);
+            if (active[particle])
+                force.setParticleParameters(particle, charge[particle], sigma, epsilon[particle]);
+            else
+                force.setParticleParameters(particle, 0.0, sigma, 0.0);
+            for (int i : particleExceptions[particle]) {
+                int p1, p2;
+                double chargeProd;
+                force.getExceptionParameters(exceptionIndex[i], p1, p2, chargeProd, sigma, eps);
+
+                // Setting both chargeProd and epsilon to zero would turn the exception into an exclusion,
+                // which cannot be changed in an existing Context.  Instead keep epsilon nonzero and set
+                // sigma to zero, which makes the Lennard-Jones term vanish.
+
+                if (active[p1] && active[p2])
+                    force.setExceptionParameters(exceptionIndex[i], p1, p2, exceptionChargeProd[i], exceptionSigma[i], exceptionEpsilon[i]);
+                else
+                    force.setExceptionParameters(exceptionIndex[i], p1, p2, 0.0, 0.0, 1.0);
+            }
+            changed = true;
+        }
+        if (changed)
+            force.updateParametersInContext(context);
+    }
+private:
+    NonbondedForce& force;
+    vector<double> charge, epsilon;
+    vector<int> exceptionIndex;
+    vector<double> exceptionChargeProd, exceptionSigma, exceptionEpsilon;
+    vector<vector<int> > particleExceptions;
+};
+
+/**
+ * This manages a bonded force, in which each term is turned off if any of its particles is inactive.
+ */
+class ParticleActivator::BondedTerms : public ParticleActivator::ManagedForce {
+public:
+    /**
+     * Create a BondedTerms object.
+     *
+     * @param numParticles   the number of particles in the System
+     * @param termParticles  the particles involved in each term
+     * @param setActive      a function that sets whether a term is active
+     * @param copyRange      a function that copies a range of terms to a Context
+     */
+    BondedTerms(int numParticles, const vector<vector<int> >& termParticles, function<void (int, bool)> setActive,
+                function<void (Context&, int, int)> copyRange) : termParticles(termParticles), setActive(setActive), copyRange(copyRange) {
+        particleTerms.resize(numParticles);
+        for (int i = 0; i < termParticles.size(); i++)
+            for (int p : termParticles[i])
+                particleTerms[p].push_back(i);
+    }
+    void update(Context& context, const vector<int>& particles, const vector<bool>& active) {
+        int first = INT_MAX, last = -1;
+        for (int particle : particles)
+            for (int term : particleTerms[particle]) {
+                bool termActive = true;
+                for (int p : termParticles[term])
+                    termActive &= active[p];
+                setActive(term, termActive);
+                first = min(first, term);
+                last = max(last, term);
+            }
+        if (last >= first)
+            copyRange(context, first, last-first+1);
+    }
+private:
+    vector<vector<int> > termParticles, particleTerms;
+    function<void (int, bool)> setActive;
+    function<void (Context&, int, int)> copyRange;
+};
+
+ParticleActivator::ParticleActivator(System& system) : system(system), active(system.getNumParticles(), true) {
+    int numParticles = system.getNumParticles();
+    for (int i = 0; i < system.getNumForces(); i++) {
+        Force& force = system.getForce(i);
+        if (dynamic_cast<NonbondedForce*>(&force) != NULL)
+            forces.push_back(new NonbondedTerms(dynamic_cast<NonbondedForce&>(force)));
+        else if (dynamic_cast<HarmonicBondForce*>(&force) != NULL) {
+            HarmonicBondForce& f = dynamic_cast<HarmonicBondForce&>(force);
+            vector<vector<int> > particles(f.getNumBonds(), vector<int>(2));
+            vector<double> k(f.getNumBonds());
+            for (int j = 0; j < f.getNumBonds(); j++) {
+                double length;
+                f.getBondParameters(j, particles[j][0], particles[j][1], length, k[j]);
+            }
+            forces.push_back(new BondedTerms(numParticles, particles, [&f, k] (int term, bool termActive) {
+                int p1, p2;
+                double length, oldK;
+                f.getBondParameters(term, p1, p2, length, oldK);
+                f.setBondParameters(term, p1, p2, length, termActive ? k[term] : 0.0);
+            }, [&f] (Context& context, int first, int count) {
+                f.updateParametersInContext(context, first, count);
+            }));
+        }
+        else if (dynamic_cast<HarmonicAngleForce*>(&force) != NULL) {
+            HarmonicAngleForce& f = dynamic_cast<HarmonicAngleForce&>(force);
+            vector<vector<int> > particles(f.getNumAngles(), vector<int>(3));
+            vector<double> k(f.getNumAngles());
+            for (int j = 0; j < f.getNumAngles(); j++) {
+                double angle;
+                f.getAngleParameters(j, particles[j][0], particles[j][1], particles[j][2], angle, k[j]);
+            }
+            forces.push_back(new BondedTerms(numParticles, particles, [&f, k] (int term, bool termActive) {
+                int p1, p2, p3;
+                double angle, oldK;
+                f.getAngleParameters(term, p1, p2, p3, angle, oldK);
+                f.setAngleParameters(term, p1, p2, p3, angle, termActive ? k[term] : 0.0);
+            }, [&f] (Context& context, int first, int count) {
+                f.updateParametersInContext(context, first, count);
+            }));
+        }
+        else if (dynamic_cast<PeriodicTorsionForce*>(&force) != NULL) {
+            PeriodicTorsionForce& f = dynamic_cast<PeriodicTorsionForce&>(force);
+            vector<vector<int> > particles(f.getNumTorsions(), vector<int>(4));
+            vector<double> k(f.getNumTorsions());
+            for (int j = 0; j < f.getNumTorsions(); j++) {
+                int periodicity;
+                double phase;
+                f.getTorsionParameters(j, particles[j][0], particles[j][1], particles[j][2], particles[j][3], periodicity, phase, k[j]);
+            }
+            forces.push_back(new BondedTerms(numParticles, particles, [&f, k] (int term, bool termActive) {
+                int p1, p2, p3, p4, periodicity;
+                double phase, oldK;
+                f.getTorsionParameters(term, p1, p2, p3, p4, periodicity, phase, oldK);
+                f.setTorsionParameters(term, p1, p2, p3, p4, periodicity, phase, termActive ? k[term] : 0.0);
+            }, [&f] (Context& context, int first, int count) {
+                f.updateParametersInContext(context, first, count);
+            }));
+        }
+    }
+}
+
+ParticleActivator::~ParticleActivator() {
+    for (ManagedForce* force : forces)
+        delete force;
+}
+
+bool ParticleActivator::isParticleActive(int particle) const {
+    if (particle < 0 || particle >= active.size())
+        throw OpenMMException("ParticleActivator: Illegal particle index");
+    return active[particle];
+}
+
+void ParticleActivator::setParticleActive(Context& context, int particle, bool active) {
+    setParticlesActive(context, vector<int>(1, particle), active);
+}
+
+void ParticleActivator::setParticlesActive(Context& context, const vector<int>& particles, bool active) {
+    if (&context.getSystem() != &system)
+        throw OpenMMException("ParticleActivator: The Context was not created for this System");
+    vector<int> changed;
+    for (int particle : particles) {
+        if (particle < 0 || particle >= this->active.size())
+            throw OpenMMException("ParticleActivator: Illegal particle index");
+        if (this->active[particle] != active) {
+            this->active[particle] = active;
+            changed.push_back(particle);
+        }
+    }
+    if (changed.size() == 0)
+        return;
+    for (ManagedForce* force : forces)
+        force->update(context, changed, this->active);
+}
@@ -75,6 +75,10 @@ void PeriodicTorsionForce::updateParametersInContext(Context& context) {
     dynamic_cast<PeriodicTorsionForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
 
+void PeriodicTorsionForce::updateParametersInContext(Context& context, int firstTorsion, int numTorsions) {
+    dynamic_cast<PeriodicTorsionForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstTorsion, numTorsions);
+}
+
 void PeriodicTorsionForce::setUsesPeriodicBoundaryConditions(bool periodic) {
     usePeriodic = periodic;
 }
@@ -82,3 +82,10 @@ void PeriodicTorsionForceImpl::updateParametersInContext(ContextImpl& context) {
     kernel.getAs<CalcPeriodicTorsionForceKernel>().copyParametersToContext(context, owner);
     context.systemChanged();
 }
+
+void PeriodicTorsionForceImpl::updateParametersInContext(ContextImpl& context, int firstTorsion, int numTorsions) {
+    if (firstTorsion < 0 || numTorsions < 0 || firstTorsion+numTorsions > owner.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: Illegal range of torsions");
+    kernel.getAs<CalcPeriodicTorsionForceKernel>().copySomeParametersToContext(context, owner, firstTorsion, numTorsions);
+    context.systemChanged();
+}
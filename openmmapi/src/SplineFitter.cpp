@@ -33,6 +33,7 @@
 #include "openmm/internal/ThreadPool.h"
 #include "openmm/OpenMMException.h"
 #include <atomic>
+#include <memory>
 #include <vector>
 #include <cmath>
 
@@ -213,41 +214,48 @@ void SplineFitter::create2DSpline(const vector<double>& x, const vector<double>&
     if (values.size() != xsize*ysize)
         throw OpenMMException("create2DNaturalSpline: incorrect number of values");
     vector<double> d1(xsize*ysize), d2(xsize*ysize), d12(xsize*ysize);
-    vector<double> t(xsize), deriv(xsize);
+    ThreadPool threads;
 
-    // Compute derivatives with respect to x.
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Compute derivatives with respect to x.
 
-    for (int i = 0; i < ysize; i++) {
-        for (int j = 0; j < xsize; j++)
-            t[j] = values[j+xsize*i];
-        SplineFitter::createSpline(x, t, periodic, deriv);
-        for (int j = 0; j < xsize; j++)
-            d1[j+xsize*i] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[j]);
-    }
+        vector<double> t(xsize), deriv(xsize);
+        for (int i = threadIndex; i < ysize; i += threads.getNumThreads()) {
+            for (int j = 0; j < xsize; j++)
+                t[j] = values[j+xsize*i];
+            SplineFitter::createSpline(x, t, periodic, deriv);
+            for (int j = 0; j < xsize; j++)
+                d1[j+xsize*i] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[j]);
+        }
 
-    // Compute derivatives with respect to y.
+        // Compute derivatives with respect to y.
 
-    t.resize(ysize);
-    deriv.resize(ysize);
-    for (int i = 0; i < xsize; i++) {
-        for (int j = 0; j < ysize; j++)
-            t[j] = values[i+xsize*j];
-        SplineFitter::createSpline(y, t, periodic, deriv);
-        for (int j = 0; j < ysize; j++)
-            d2[i+xsize*j] = SplineFitter::evaluateSplineDerivative(y, t, deriv, y[j]);
-    }
+        t.resize(ysize);
+        deriv.resize(ysize);
+        for (int i = threadIndex; i < xsize; i += threads.getNumThreads()) {
+            for (int j = 0; j < ysize; j++)
+                t[j] = values[i+xsize*j];
+            SplineFitter::createSpline(y, t, periodic, deriv);
+            for (int j = 0; j < ysize; j++)
+                d2[i+xsize*j] = SplineFitter::evaluateSplineDerivative(y, t, deriv, y[j]);
+        }
 
-    // Compute cross derivatives.
+        // Compute cross derivatives.
 
-    t.resize(xsize);
-    deriv.resize(xsize);
-    for (int i = 0; i < ysize; i++) {
-        for (int j = 0; j < xsize; j++)
-            t[j] = d2[j+xsize*i];
-        SplineFitter::createSpline(x, t, periodic, deriv);
-        for (int j = 0; j < xsize; j++)
-            d12[j+xsize*i] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[j]);
-    }
+        t.resize(xsize);
+        deriv.resize(xsize);
+        threads.syncThreads();
+        for (int i = threadIndex; i < ysize; i += threads.getNumThreads()) {
+            for (int j = 0; j < xsize; j++)
+                t[j] = d2[j+xsize*i];
+            SplineFitter::createSpline(x, t, periodic, deriv);
+            for (int j = 0; j < xsize; j++)
+                d12[j+xsize*i] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[j]);
+        }
+    });
+    threads.waitForThreads();
+    threads.resumeThreads();
+    threads.waitForThreads();
 
     // Now compute the coefficients.
 
@@ -269,37 +277,44 @@ void SplineFitter::create2DSpline(const vector<double>& x, const vector<double>&
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, -1, 1,
         0, 0, 0, 0, 0, 0, -1, 1, 0, 0, 2, -2, 0, 0, -1, 1
     };
-    vector<double> rhs(16);
     c.resize((xsize-1)*(ysize-1));
-    for (int i = 0; i < xsize-1; i++) {
-        for (int j = 0; j < ysize-1; j++) {
-            // Compute the 16 coefficients for patch (i, j).
-
-            int nexti = i+1;
-            int nextj = j+1;
-            double deltax = x[nexti]-x[i];
-            double deltay = y[nextj]-y[j];
-            double e[] = {values[i+j*xsize], values[nexti+j*xsize], values[nexti+nextj*xsize], values[i+nextj*xsize]};
-            double e1[] = {d1[i+j*xsize], d1[nexti+j*xsize], d1[nexti+nextj*xsize], d1[i+nextj*xsize]};
-            double e2[] = {d2[i+j*xsize], d2[nexti+j*xsize], d2[nexti+nextj*xsize], d2[i+nextj*xsize]};
-            double e12[] = {d12[i+j*xsize], d12[nexti+j*xsize], d12[nexti+nextj*xsize], d12[i+nextj*xsize]};
-
-            for (int k = 0; k < 4; k++) {
-                rhs[k] = e[k];
-                rhs[k+4] = e1[k]*deltax;
-                rhs[k+8] = e2[k]*deltay;
-                rhs[k+12] = e12[k]*deltax*deltay;
-            }
-            vector<double>& coeff = c[i+j*(xsize-1)];
-            coeff.resize(16);
-            for (int k = 0; k < 16; k++) {
-                double sum = 0.0;
-                for (int m = 0; m < 16; m++)
-                    sum += wt[k+16*m]*rhs[m];
-                coeff[k] = sum;
+    atomic<int> atomicCounter(0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<double> rhs(16);
+        while (true) {
+            int i = atomicCounter++;
+            if (i >= xsize-1)
+                break;
+            for (int j = 0; j < ysize-1; j++) {
+                // Compute the 16 coefficients for patch (i, j).
+
+                int nexti = i+1;
+                int nextj = j+1;
+                double deltax = x[nexti]-x[i];
+                double deltay = y[nextj]-y[j];
+                double e[] = {values[i+j*xsize], values[nexti+j*xsize], values[nexti+nextj*xsize], values[i+nextj*xsize]};
+                double e1[] = {d1[i+j*xsize], d1[nexti+j*xsize], d1[nexti+nextj*xsize], d1[i+nextj*xsize]};
+                double e2[] = {d2[i+j*xsize], d2[nexti+j*xsize], d2[nexti+nextj*xsize], d2[i+nextj*xsize]};
+                double e12[] = {d12[i+j*xsize], d12[nexti+j*xsize], d12[nexti+nextj*xsize], d12[i+nextj*xsize]};
+
+                for (int k = 0; k < 4; k++) {
+                    rhs[k] = e[k];
+                    rhs[k+4] = e1[k]*deltax;
+                    rhs[k+8] = e2[k]*deltay;
+                    rhs[k+12] = e12[k]*deltax*deltay;
+                }
+                vector<double>& coeff = c[i+j*(xsize-1)];
+                coeff.resize(16);
+                for (int k = 0; k < 16; k++) {
+                    double sum = 0.0;
+                    for (int m = 0; m < 16; m++)
+                        sum += wt[k+16*m]*rhs[m];
+                    coeff[k] = sum;
+                }
             }
         }
-    }
+    });
+    threads.waitForThreads();
 }
 
 void SplineFitter::create2DNaturalSpline(const vector<double>& x, const vector<double>& y, const vector<double>& values, vector<vector<double> >& c) {
@@ -390,7 +405,7 @@ void SplineFitter::evaluate2DSplineDerivatives(const vector<double>& x, const ve
     dy /= deltay;
 }
 
-void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>& y, const vector<double>& z, const vector<double>& values, bool periodic, vector<vector<double> >& c) {
+void SplineFitter::create3DHermiteSpline(const vector<double>& x, const vector<double>& y, const vector<double>& z, const vector<double>& values, bool periodic, vector<double>& d, ThreadPool* threadPool) {
     const int xsize = x.size(), ysize = y.size(), zsize = z.size();
     const int xysize = xsize*ysize;
     if (periodic) {
@@ -403,7 +418,12 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
         throw OpenMMException("create2DNaturalSpline: incorrect number of values");
     vector<double> d1(xsize*ysize*zsize), d2(xsize*ysize*zsize), d3(xsize*ysize*zsize);
     vector<double> d12(xsize*ysize*zsize), d13(xsize*ysize*zsize), d23(xsize*ysize*zsize), d123(xsize*ysize*zsize);
-    ThreadPool threads;
+    unique_ptr<ThreadPool> ownThreads;
+    if (threadPool == NULL) {
+        ownThreads.reset(new ThreadPool());
+        threadPool = ownThreads.get();
+    }
+    ThreadPool& threads = *threadPool;
 
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
         // Compute derivatives with respect to x.
@@ -511,6 +531,34 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
     threads.resumeThreads();
     threads.waitForThreads();
 
+    // Record the values and derivatives together, so everything needed for one point is contiguous.
+
+    int numPoints = xsize*ysize*zsize;
+    d.resize(8*numPoints);
+    for (int i = 0; i < numPoints; i++) {
+        d[8*i] = values[i];
+        d[8*i+1] = d1[i];
+        d[8*i+2] = d2[i];
+        d[8*i+3] = d3[i];
+        d[8*i+4] = d12[i];
+        d[8*i+5] = d13[i];
+        d[8*i+6] = d23[i];
+        d[8*i+7] = d123[i];
+    }
+}
+
+void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>& y, const vector<double>& z, const vector<double>& values, bool periodic, vector<vector<double> >& c, ThreadPool* threadPool) {
+    const int xsize = x.size(), ysize = y.size(), zsize = z.size();
+    const int xysize = xsize*ysize;
+    unique_ptr<ThreadPool> ownThreads;
+    if (threadPool == NULL) {
+        ownThreads.reset(new ThreadPool());
+        threadPool = ownThreads.get();
+    }
+    ThreadPool& threads = *threadPool;
+    vector<double> d;
+    create3DHermiteSpline(x, y, z, values, periodic, d, &threads);
+
     // Now compute the coefficients.  This involves multiplying by a sparse 64x64 matrix, given
     // here in packed form.
 
@@ -607,14 +655,14 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     double deltax = x[nexti]-x[i];
                     double deltay = y[nextj]-y[j];
                     double deltaz = z[nextk]-z[k];
-                    double e[] = {values[i+j*xsize+k*xysize], values[nexti+j*xsize+k*xysize], values[i+nextj*xsize+k*xysize], values[nexti+nextj*xsize+k*xysize], values[i+j*xsize+nextk*xysize], values[nexti+j*xsize+nextk*xysize], values[i+nextj*xsize+nextk*xysize], values[nexti+nextj*xsize+nextk*xysize]};
-                    double e1[] = {d1[i+j*xsize+k*xysize], d1[nexti+j*xsize+k*xysize], d1[i+nextj*xsize+k*xysize], d1[nexti+nextj*xsize+k*xysize], d1[i+j*xsize+nextk*xysize], d1[nexti+j*xsize+nextk*xysize], d1[i+nextj*xsize+nextk*xysize], d1[nexti+nextj*xsize+nextk*xysize]};
-                    double e2[] = {d2[i+j*xsize+k*xysize], d2[nexti+j*xsize+k*xysize], d2[i+nextj*xsize+k*xysize], d2[nexti+nextj*xsize+k*xysize], d2[i+j*xsize+nextk*xysize], d2[nexti+j*xsize+nextk*xysize], d2[i+nextj*xsize+nextk*xysize], d2[nexti+nextj*xsize+nextk*xysize]};
-                    double e3[] = {d3[i+j*xsize+k*xysize], d3[nexti+j*xsize+k*xysize], d3[i+nextj*xsize+k*xysize], d3[nexti+nextj*xsize+k*xysize], d3[i+j*xsize+nextk*xysize], d3[nexti+j*xsize+nextk*xysize], d3[i+nextj*xsize+nextk*xysize], d3[nexti+nextj*xsize+nextk*xysize]};
-                    double e12[] = {d12[i+j*xsize+k*xysize], d12[nexti+j*xsize+k*xysize], d12[i+nextj*xsize+k*xysize], d12[nexti+nextj*xsize+k*xysize], d12[i+j*xsize+nextk*xysize], d12[nexti+j*xsize+nextk*xysize], d12[i+nextj*xsize+nextk*xysize], d12[nexti+nextj*xsize+nextk*xysize]};
-                    double e13[] = {d13[i+j*xsize+k*xysize], d13[nexti+j*xsize+k*xysize], d13[i+nextj*xsize+k*xysize], d13[nexti+nextj*xsize+k*xysize], d13[i+j*xsize+nextk*xysize], d13[nexti+j*xsize+nextk*xysize], d13[i+nextj*xsize+nextk*xysize], d13[nexti+nextj*xsize+nextk*xysize]};
-                    double e23[] = {d23[i+j*xsize+k*xysize], d23[nexti+j*xsize+k*xysize], d23[i+nextj*xsize+k*xysize], d23[nexti+nextj*xsize+k*xysize], d23[i+j*xsize+nextk*xysize], d23[nexti+j*xsize+nextk*xysize], d23[i+nextj*xsize+nextk*xysize], d23[nexti+nextj*xsize+nextk*xysize]};
-                    double e123[] = {d123[i+j*xsize+k*xysize], d123[nexti+j*xsize+k*xysize], d123[i+nextj*xsize+k*xysize], d123[nexti+nextj*xsize+k*xysize], d123[i+j*xsize+nextk*xysize], d123[nexti+j*xsize+nextk*xysize], d123[i+nextj*xsize+nextk*xysize], d123[nexti+nextj*xsize+nextk*xysize]};
+                    double e[] = {d[8*(i+j*xsize+k*xysize)+0], d[8*(nexti+j*xsize+k*xysize)+0], d[8*(i+nextj*xsize+k*xysize)+0], d[8*(nexti+nextj*xsize+k*xysize)+0], d[8*(i+j*xsize+nextk*xysize)+0], d[8*(nexti+j*xsize+nextk*xysize)+0], d[8*(i+nextj*xsize+nextk*xysize)+0], d[8*(nexti+nextj*xsize+nextk*xysize)+0]};
+                    double e1[] = {d[8*(i+j*xsize+k*xysize)+1], d[8*(nexti+j*xsize+k*xysize)+1], d[8*(i+nextj*xsize+k*xysize)+1], d[8*(nexti+nextj*xsize+k*xysize)+1], d[8*(i+j*xsize+nextk*xysize)+1], d[8*(nexti+j*xsize+nextk*xysize)+1], d[8*(i+nextj*xsize+nextk*xysize)+1], d[8*(nexti+nextj*xsize+nextk*xysize)+1]};
+                    double e2[] = {d[8*(i+j*xsize+k*xysize)+2], d[8*(nexti+j*xsize+k*xysize)+2], d[8*(i+nextj*xsize+k*xysize)+2], d[8*(nexti+nextj*xsize+k*xysize)+2], d[8*(i+j*xsize+nextk*xysize)+2], d[8*(nexti+j*xsize+nextk*xysize)+2], d[8*(i+nextj*xsize+nextk*xysize)+2], d[8*(nexti+nextj*xsize+nextk*xysize)+2]};
+                    double e3[] = {d[8*(i+j*xsize+k*xysize)+3], d[8*(nexti+j*xsize+k*xysize)+3], d[8*(i+nextj*xsize+k*xysize)+3], d[8*(nexti+nextj*xsize+k*xysize)+3], d[8*(i+j*xsize+nextk*xysize)+3], d[8*(nexti+j*xsize+nextk*xysize)+3], d[8*(i+nextj*xsize+nextk*xysize)+3], d[8*(nexti+nextj*xsize+nextk*xysize)+3]};
+                    double e12[] = {d[8*(i+j*xsize+k*xysize)+4], d[8*(nexti+j*xsize+k*xysize)+4], d[8*(i+nextj*xsize+k*xysize)+4], d[8*(nexti+nextj*xsize+k*xysize)+4], d[8*(i+j*xsize+nextk*xysize)+4], d[8*(nexti+j*xsize+nextk*xysize)+4], d[8*(i+nextj*xsize+nextk*xysize)+4], d[8*(nexti+nextj*xsize+nextk*xysize)+4]};
+                    double e13[] = {d[8*(i+j*xsize+k*xysize)+5], d[8*(nexti+j*xsize+k*xysize)+5], d[8*(i+nextj*xsize+k*xysize)+5], d[8*(nexti+nextj*xsize+k*xysize)+5], d[8*(i+j*xsize+nextk*xysize)+5], d[8*(nexti+j*xsize+nextk*xysize)+5], d[8*(i+nextj*xsize+nextk*xysize)+5], d[8*(nexti+nextj*xsize+nextk*xysize)+5]};
+                    double e23[] = {d[8*(i+j*xsize+k*xysize)+6], d[8*(nexti+j*xsize+k*xysize)+6], d[8*(i+nextj*xsize+k*xysize)+6], d[8*(nexti+nextj*xsize+k*xysize)+6], d[8*(i+j*xsize+nextk*xysize)+6], d[8*(nexti+j*xsize+nextk*xysize)+6], d[8*(i+nextj*xsize+nextk*xysize)+6], d[8*(nexti+nextj*xsize+nextk*xysize)+6]};
+                    double e123[] = {d[8*(i+j*xsize+k*xysize)+7], d[8*(nexti+j*xsize+k*xysize)+7], d[8*(i+nextj*xsize+k*xysize)+7], d[8*(nexti+nextj*xsize+k*xysize)+7], d[8*(i+j*xsize+nextk*xysize)+7], d[8*(nexti+j*xsize+nextk*xysize)+7], d[8*(i+nextj*xsize+nextk*xysize)+7], d[8*(nexti+nextj*xsize+nextk*xysize)+7]};
                     for (int m = 0; m < 8; m++) {
                         rhs[m] = e[m];
                         rhs[m+8] = e1[m]*deltax;
@@ -766,3 +814,96 @@ void SplineFitter::evaluate3DSplineDerivatives(const vector<double>& x, const ve
     dy /= deltay;
     dz /= deltaz;
 }
+
+void SplineFitter::find3DSplinePatch(const vector<double>& x, const vector<double>& y, const vector<double>& z, double u, double v, double w, int& lowerx, int& lowery, int& lowerz) {
+    int xsize = x.size();
+    int ysize = y.size();
+    int zsize = z.size();
+    if (u < x[0] || u > x[xsize-1] || v < y[0] || v > y[ysize-1] || w < z[0] || w > z[zsize-1])
+        throw OpenMMException("evaluate3DSpline: specified point is outside the range defined by the spline");
+
+    // Perform a binary search to identify the interval containing the point to evaluate.
+
+    lowerx = 0;
+    int upperx = xsize-1;
+    while (upperx-lowerx > 1) {
+        int middle = (upperx+lowerx)/2;
+        if (x[middle] > u)
+            upperx = middle;
+        else
+            lowerx = middle;
+    }
+    lowery = 0;
+    int uppery = ysize-1;
+    while (uppery-lowery > 1) {
+        int middle = (uppery+lowery)/2;
+        if (y[middle] > v)
+            uppery = middle;
+        else
+            lowery = middle;
+    }
+    lowerz = 0;
+    int upperz = zsize-1;
+    while (upperz-lowerz > 1) {
+        int middle = (upperz+lowerz)/2;
+        if (z[middle] > w)
+            upperz = middle;
+        else
+            lowerz = middle;
+    }
+}
+
+/**
+ * Compute the cubic Hermite basis functions (or their derivatives) for one axis.  The first two elements
+ * multiply the values at the two ends of the interval, and the last two multiply the derivatives.
+ */
+static void computeHermiteBasis(double t, double delta, bool derivative, double basis[4]) {
+    if (derivative) {
+        basis[0] = 6*t*(t-1)/delta;
+        basis[1] = -basis[0];
+        basis[2] = (1-t)*(1-3*t);
+        basis[3] = t*(3*t-2);
+    }
+    else {
+        basis[0] = 1-t*t*(3-2*t);
+        basis[1] = 1-basis[0];
+        basis[2] = t*(1-t)*(1-t)*delta;
+        basis[3] = t*t*(t-1)*delta;
+    }
+}
+
+double SplineFitter::evaluate3DHermitePatch(const vector<double>& x, const vector<double>& y, const vector<double>& z, const vector<double>& d,
+                                            double u, double v, double w, int derivAxis) {
+    int xsize = x.size();
+    int ysize = y.size();
+    int lowerx, lowery, lowerz;
+    find3DSplinePatch(x, y, z, u, v, w, lowerx, lowery, lowerz);
+    double deltax = x[lowerx+1]-x[lowerx];
+    double deltay = y[lowery+1]-y[lowery];
+    double deltaz = z[lowerz+1]-z[lowerz];
+    double bx[4], by[4], bz[4];
+    computeHermiteBasis((u-x[lowerx])/deltax, deltax, derivAxis == 0, bx);
+    computeHermiteBasis((v-y[lowery])/deltay, deltay, derivAxis == 1, by);
+    computeHermiteBasis((w-z[lowerz])/deltaz, deltaz, derivAxis == 2, bz);
+
+    // Sum the contributions from the eight corners of the patch.
+
+    double sum = 0.0;
+    for (int corner = 0; corner < 8; corner++) {
+        int cx = corner&1, cy = (corner>>1)&1, cz = corner>>2;
+        const double* p = &d[8*(lowerx+cx+xsize*(lowery+cy+ysize*(lowerz+cz)))];
+        sum += bz[cz]*(by[cy]*(bx[cx]*p[0] + bx[cx+2]*p[1]) + by[cy+2]*(bx[cx]*p[2] + bx[cx+2]*p[4])) +
+               bz[cz+2]*(by[cy]*(bx[cx]*p[3] + bx[cx+2]*p[5]) + by[cy+2]*(bx[cx]*p[6] + bx[cx+2]*p[7]));
+    }
+    return sum;
+}
+
+double SplineFitter::evaluate3DHermiteSpline(const vector<double>& x, const vector<double>& y, const vector<double>& z, const vector<double>& d, double u, double v, double w) {
+    return evaluate3DHermitePatch(x, y, z, d, u, v, w, -1);
+}
+
+void SplineFitter::evaluate3DHermiteSplineDerivatives(const vector<double>& x, const vector<double>& y, const vector<double>& z, const vector<double>& d, double u, double v, double w, double& dx, double& dy, double& dz) {
+    dx = evaluate3DHermitePatch(x, y, z, d, u, v, w, 0);
+    dy = evaluate3DHermitePatch(x, y, z, d, u, v, w, 1);
+    dz = evaluate3DHermitePatch(x, y, z, d, u, v, w, 2);
+}
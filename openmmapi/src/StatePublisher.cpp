@@ -0,0 +1,359 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/StatePublisher.h"
+#include "openmm/Integrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+static const char magic[8] = {'O', 'M', 'M', 'S', 'T', 'A', 'T', 'E'};
+static const int layoutVersion = 1;
+static const size_t headerSize = 64;
+static const double readTimeout = 1.0; // seconds
+
+/**
+ * The header at the start of the shared memory.
+ */
+struct SharedHeader {
+    char magic[8];
+    int32_t version;
+    int32_t numParticles;
+    int32_t numSlots;
+    int32_t periodic;
+    int64_t slotSize;
+    atomic<int64_t> numFrames;
+};
+
+/**
+ * The header at the start of each slot.  The positions follow immediately after it.
+ */
+struct SlotHeader {
+    atomic<uint64_t> sequence;
+    int64_t frameIndex;
+    int64_t step;
+    double time;
+    double potentialEnergy;
+    double kineticEnergy;
+    double box[9];
+};
+
+static_assert(sizeof(SharedHeader) <= headerSize, "Unexpected size for SharedHeader");
+static_assert(sizeof(SlotHeader) == 120, "Unexpected size for SlotHeader");
+
+static string getSharedMemoryName(const string& name) {
+    if (name.size() > 0 && name[0] == '/')
+        return name;
+    return "/"+name;
+}
+
+StatePublisher::StatePublisher(Context& context, const string& name, int interval, int numSlots) :
+        context(context), name(getSharedMemoryName(name)), interval(interval), numSlots(numSlots), enforcePeriodicBox(false),
+        includeEnergy(false), numFrames(0), fileDescriptor(-1), memory(NULL) {
+    if (interval < 1)
+        throw OpenMMException("StatePublisher: The interval must be positive");
+    if (numSlots < 1)
+        throw OpenMMException("StatePublisher: The number of slots must be positive");
+#ifdef _WIN32
+    throw OpenMMException("StatePublisher: Shared memory is not supported on this platform");
+#else
+    const System& system = context.getSystem();
+    numParticles = system.getNumParticles();
+    slotSize = sizeof(SlotHeader)+3*numParticles*sizeof(double);
+    slotSize = 64*((slotSize+63)/64);
+    memorySize = headerSize+numSlots*slotSize;
+
+    // Create the shared memory object.  If an object with the same name was left behind by an earlier
+    // run, remove its name and create a new one, rather than resizing memory another process may still
+    // have mapped.  The object is only sized when we are the one that created it.
+
+    fileDescriptor = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fileDescriptor == -1 && errno == EEXIST) {
+        shm_unlink(this->name.c_str());
+        fileDescriptor = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fileDescriptor == -1)
+        throw OpenMMException("StatePublisher: Failed to create shared memory object "+this->name+": "+strerror(errno));
+    if (ftruncate(fileDescriptor, memorySize) != 0) {
+        close(fileDescriptor);
+        shm_unlink(this->name.c_str());
+        throw OpenMMException("StatePublisher: Failed to allocate shared memory: "+string(strerror(errno)));
+    }
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0 || info.st_size != (off_t) memorySize) {
+        close(fileDescriptor);
+        shm_unlink(this->name.c_str());
+        throw OpenMMException("StatePublisher: The shared memory object "+this->name+" does not have the expected size");
+    }
+    void* address = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        close(fileDescriptor);
+        shm_unlink(this->name.c_str());
+        throw OpenMMException("StatePublisher: Failed to map shared memory: "+string(strerror(errno)));
+    }
+    memory = (char*) address;
+
+    // Fill in the header.  The magic string is written last, so readers never see a partially
+    // initialized header.
+
+    SharedHeader* header = (SharedHeader*) memory;
+    header->version = layoutVersion;
+    header->numParticles = numParticles;
+    header->numSlots = numSlots;
+    header->periodic = (system.usesPeriodicBoundaryConditions() ? 1 : 0);
+    header->slotSize = slotSize;
+    header->numFrames.store(0, memory_order_relaxed);
+    for (int i = 0; i < numSlots; i++) {
+        SlotHeader* slot = (SlotHeader*) (memory+headerSize+i*slotSize);
+        slot->sequence.store(0, memory_order_relaxed);
+        slot->frameIndex = -1;
+    }
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, magic, sizeof(magic));
+#endif
+}
+
+StatePublisher::~StatePublisher() {
+#ifndef _WIN32
+    if (memory != NULL) {
+        munmap(memory, memorySize);
+        close(fileDescriptor);
+        shm_unlink(name.c_str());
+    }
+#endif
+}
+
+const string& StatePublisher::getName() const {
+    return name;
+}
+
+int StatePublisher::getInterval() const {
+    return interval;
+}
+
+int StatePublisher::getNumSlots() const {
+    return numSlots;
+}
+
+bool StatePublisher::getEnforcePeriodicBox() const {
+    return enforcePeriodicBox;
+}
+
+void StatePublisher::setEnforcePeriodicBox(bool enforce) {
+    enforcePeriodicBox = enforce;
+}
+
+bool StatePublisher::getIncludeEnergy() const {
+    return includeEnergy;
+}
+
+void StatePublisher::setIncludeEnergy(bool include) {
+    includeEnergy = include;
+}
+
+long long StatePublisher::getNumFrames() const {
+    return numFrames;
+}
+
+void StatePublisher::step(int steps) {
+    Integrator& integrator = context.getIntegrator();
+    while (steps > 0) {
+        int stepsToNextFrame = interval-(int) (context.getStepCount()%interval);
+        int stepsToTake = min(steps, stepsToNextFrame);
+        integrator.step(stepsToTake);
+        steps -= stepsToTake;
+        if (context.getStepCount()%interval == 0)
+            publishFrame();
+    }
+}
+
+void StatePublisher::publishFrame() {
+    State state = context.getState(State::Positions | (includeEnergy ? State::Energy : 0), enforcePeriodicBox);
+    SlotHeader* slot = (SlotHeader*) (memory+headerSize+(numFrames%numSlots)*slotSize);
+    double* positions = (double*) (slot+1);
+
+    // Mark the slot as being written, fill it in, then mark it as complete.
+
+    uint64_t sequence = slot->sequence.load(memory_order_relaxed);
+    slot->sequence.store(sequence+1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->frameIndex = numFrames;
+    slot->step = state.getStepCount();
+    slot->time = state.getTime();
+    slot->potentialEnergy = (includeEnergy ? state.getPotentialEnergy() : numeric_limits<double>::quiet_NaN());
+    slot->kineticEnergy = (includeEnergy ? state.getKineticEnergy() : numeric_limits<double>::quiet_NaN());
+    Vec3 box[3];
+    state.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            slot->box[3*i+j] = box[i][j];
+    const vector<Vec3>& statePositions = state.getPositions();
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < 3; j++)
+            positions[3*i+j] = statePositions[i][j];
+    slot->sequence.store(sequence+2, memory_order_release);
+    numFrames++;
+    ((SharedHeader*) memory)->numFrames.store(numFrames, memory_order_release);
+}
+
+StateSubscriber::StateSubscriber(const string& name) : name(getSharedMemoryName(name)), fileDescriptor(-1), memory(NULL) {
+#ifdef _WIN32
+    throw OpenMMException("StateSubscriber: Shared memory is not supported on this platform");
+#else
+    fileDescriptor = shm_open(this->name.c_str(), O_RDONLY, 0);
+    if (fileDescriptor == -1)
+        throw OpenMMException("StateSubscriber: Failed to open shared memory object "+this->name+": "+strerror(errno));
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0 || info.st_size < (off_t) headerSize) {
+        close(fileDescriptor);
+        throw OpenMMException("StateSubscriber: The shared memory object has not been initialized by a StatePublisher");
+    }
+    memorySize = info.st_size;
+    void* address = mmap(NULL, memorySize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        close(fileDescriptor);
+        throw OpenMMException("StateSubscriber: Failed to map shared memory: "+string(strerror(errno)));
+    }
+    memory = (char*) address;
+    const SharedHeader* header = (const SharedHeader*) memory;
+    bool valid = (memcmp(header->magic, magic, sizeof(magic)) == 0);
+    atomic_thread_fence(memory_order_acquire);
+    if (valid && header->version != layoutVersion) {
+        munmap(memory, memorySize);
+        close(fileDescriptor);
+        throw OpenMMException("StateSubscriber: Unsupported shared memory layout version");
+    }
+    if (valid) {
+        numParticles = header->numParticles;
+        numSlots = header->numSlots;
+        slotSize = header->slotSize;
+        valid = (numParticles >= 0 && numSlots > 0 && slotSize >= sizeof(SlotHeader)+3*numParticles*sizeof(double) &&
+                 slotSize <= (memorySize-headerSize)/numSlots);
+    }
+    if (!valid) {
+        munmap(memory, memorySize);
+        close(fileDescriptor);
+        throw OpenMMException("StateSubscriber: The shared memory object has not been initialized by a StatePublisher");
+    }
+#endif
+}
+
+StateSubscriber::~StateSubscriber() {
+#ifndef _WIN32
+    if (memory != NULL) {
+        munmap(memory, memorySize);
+        close(fileDescriptor);
+    }
+#endif
+}
+
+int StateSubscriber::getNumParticles() const {
+    return numParticles;
+}
+
+int StateSubscriber::getNumSlots() const {
+    return numSlots;
+}
+
+long long StateSubscriber::getNumFrames() const {
+    return ((const SharedHeader*) memory)->numFrames.load(memory_order_acquire);
+}
+
+bool StateSubscriber::readFrame(long long index, Frame& frame) const {
+    if (index < 0 || index >= getNumFrames())
+        return false;
+    const SlotHeader* slot = (const SlotHeader*) (memory+headerSize+(index%numSlots)*slotSize);
+    const double* positions = (const double*) (slot+1);
+    frame.positions.resize(numParticles);
+
+    // Give up if the slot does not become readable within the timeout, for example because the
+    // publisher was killed while writing to it.
+
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+    while (chrono::duration<double>(chrono::steady_clock::now()-startTime).count() < readTimeout) {
+        uint64_t sequence = slot->sequence.load(memory_order_acquire);
+        if (sequence%2 == 1) {
+            this_thread::yield(); // The publisher is writing to this slot.
+            continue;
+        }
+        if (slot->frameIndex != index)
+            return false; // The frame has been overwritten.
+        frame.index = index;
+        frame.step = slot->step;
+        frame.time = slot->time;
+        frame.potentialEnergy = slot->potentialEnergy;
+        frame.kineticEnergy = slot->kineticEnergy;
+        for (int i = 0; i < 3; i++)
+            frame.box[i] = Vec3(slot->box[3*i], slot->box[3*i+1], slot->box[3*i+2]);
+        for (int i = 0; i < numParticles; i++)
+            frame.positions[i] = Vec3(positions[3*i], positions[3*i+1], positions[3*i+2]);
+
+        // If the sequence number has not changed, nothing was written while we were copying.
+
+        atomic_thread_fence(memory_order_acquire);
+        if (slot->sequence.load(memory_order_relaxed) == sequence)
+            return true;
+    }
+    return false;
+}
+
+bool StateSubscriber::readLatestFrame(Frame& frame) const {
+    while (true) {
+        long long numFrames = getNumFrames();
+        if (numFrames == 0)
+            return false;
+        if (readFrame(numFrames-1, frame))
+            return true;
+
+        // Try again only if a newer frame has been published in the meantime.
+
+        if (getNumFrames() == numFrames)
+            return false;
+    }
+}
@@ -61,6 +61,26 @@ void System::setParticleMass(int index, double mass) {
     masses[index] = mass;
 }
 
+void System::repartitionHydrogenMass(double hydrogenMass, const std::vector<std::pair<int, int> >& bonds) {
+    const double maxHydrogenMass = 2.5;
+    std::vector<double> newMasses = masses;
+    for (auto& bond : bonds) {
+        ASSERT_VALID_INDEX(bond.first, masses);
+        ASSERT_VALID_INDEX(bond.second, masses);
+        int hydrogen = bond.first, heavy = bond.second;
+        if (masses[heavy] > 0 && masses[heavy] < maxHydrogenMass)
+            std::swap(hydrogen, heavy);
+        if (masses[hydrogen] <= 0 || masses[hydrogen] >= maxHydrogenMass || masses[heavy] < maxHydrogenMass)
+            continue;
+        newMasses[heavy] -= hydrogenMass-newMasses[hydrogen];
+        newMasses[hydrogen] = hydrogenMass;
+    }
+    for (int i = 0; i < masses.size(); i++)
+        if (masses[i] > 0 && newMasses[i] <= 0)
+            throw OpenMMException("repartitionHydrogenMass: Not enough mass to give each hydrogen the requested mass");
+    masses = newMasses;
+}
+
 void System::setVirtualSite(int index, VirtualSite* virtualSite) {
     if (index >= (int) virtualSites.size())
         virtualSites.resize(getNumParticles(), NULL);
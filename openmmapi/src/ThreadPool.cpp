@@ -30,7 +30,9 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/internal/ThreadPool.h"
+#include "openmm/internal/TraceRange.h"
 #include "openmm/internal/hardware.h"
+#include <thread>
 
 using namespace std;
 
@@ -41,10 +43,12 @@ public:
     ThreadData(ThreadPool& owner, int index) : owner(owner), index(index), isDeleted(false) {
     }
     void executeTask() {
+        OPENMM_TRACE_RANGE("ThreadPool task");
         if (owner.currentTask != NULL)
             owner.currentTask->execute(owner, index);
         else
             owner.currentFunction(owner, index);
+        owner.completedCount++;
     }
     ThreadPool& owner;
     int index;
@@ -67,13 +71,22 @@ static void* threadBody(void* args) {
     return 0;
 }
 
-ThreadPool::ThreadPool(int numThreads) : currentTask(NULL) {
+/**
+ * The default number of times to check a condition before blocking, when spinning is enabled.
+ */
+static const int DEFAULT_SPIN_COUNT = 2000;
+
+ThreadPool::ThreadPool(int numThreads) : isShared(false), taskActive(false), currentTask(NULL), generation(0) {
+    int numProcessors = getNumProcessors();
     if (numThreads <= 0)
-        numThreads = getNumProcessors();
+        numThreads = numProcessors;
     this->numThreads = numThreads;
+    spinCount = (numThreads <= numProcessors ? DEFAULT_SPIN_COUNT : 0);
     pthread_cond_init(&startCondition, NULL);
     pthread_cond_init(&endCondition, NULL);
     pthread_mutex_init(&lock, NULL);
+    pthread_mutex_init(&taskLock, NULL);
+    completedCount = 0;
     thread.resize(numThreads);
     pthread_mutex_lock(&lock);
     waitCount = 0;
@@ -91,12 +104,11 @@ ThreadPool::ThreadPool(int numThreads) : currentTask(NULL) {
 ThreadPool::~ThreadPool() {
     for (auto data : threadData)
         data->isDeleted = true;
-    pthread_mutex_lock(&lock);
-    pthread_cond_broadcast(&startCondition);
-    pthread_mutex_unlock(&lock);
+    resumeThreads();
     for (auto t : thread)
         pthread_join(t, NULL);
     pthread_mutex_destroy(&lock);
+    pthread_mutex_destroy(&taskLock);
     pthread_cond_destroy(&startCondition);
     pthread_cond_destroy(&endCondition);
 }
@@ -106,36 +118,98 @@ int ThreadPool::getNumThreads() const {
 }
 
 void ThreadPool::execute(Task& task) {
+    beginTask();
     currentTask = &task;
     resumeThreads();
 }
 
 void ThreadPool::execute(function<void (ThreadPool&, int)> task) {
+    beginTask();
     currentTask = NULL;
     currentFunction = task;
     resumeThreads();
 }
 
 void ThreadPool::syncThreads() {
+    // The generation counter is incremented every time the threads are resumed, so we are
+    // done waiting as soon as it differs from the value it had when we arrived.
+
+    long long startGeneration = generation;
+    pthread_mutex_lock(&lock);
+    if (++waitCount == numThreads)
+        pthread_cond_signal(&endCondition);
+    pthread_mutex_unlock(&lock);
+    for (int i = 0; i < spinCount; i++) {
+        if (generation != startGeneration)
+            return;
+        std::this_thread::yield();
+    }
     pthread_mutex_lock(&lock);
-    waitCount++;
-    pthread_cond_signal(&endCondition);
-    pthread_cond_wait(&startCondition, &lock);
+    while (generation == startGeneration)
+        pthread_cond_wait(&startCondition, &lock);
     pthread_mutex_unlock(&lock);
 }
 
 void ThreadPool::waitForThreads() {
-    pthread_mutex_lock(&lock);
-    while (waitCount < numThreads)
-        pthread_cond_wait(&endCondition, &lock);
-    pthread_mutex_unlock(&lock);
+    OPENMM_TRACE_RANGE("ThreadPool wait");
+    bool done = false;
+    for (int i = 0; i < spinCount && !done; i++) {
+        if (waitCount == numThreads)
+            done = true;
+        else
+            std::this_thread::yield();
+    }
+    if (!done) {
+        pthread_mutex_lock(&lock);
+        while (waitCount < numThreads)
+            pthread_cond_wait(&endCondition, &lock);
+        pthread_mutex_unlock(&lock);
+    }
+    endTask();
+}
+
+void ThreadPool::beginTask() {
+    // If the pool is shared, wait until any other caller's Task has completed.
+
+    if (isShared) {
+        pthread_mutex_lock(&taskLock);
+        taskActive = true;
+    }
+    completedCount = 0;
+}
+
+void ThreadPool::endTask() {
+    // Every thread increments completedCount before it waits for the next Task, so once they are
+    // all waiting we can tell whether they stopped at the end of the Task or at a syncThreads().
+
+    if (taskActive && completedCount == numThreads) {
+        taskActive = false;
+        pthread_mutex_unlock(&taskLock);
+    }
 }
 
 void ThreadPool::resumeThreads() {
     pthread_mutex_lock(&lock);
     waitCount = 0;
+    generation++;
     pthread_cond_broadcast(&startCondition);
     pthread_mutex_unlock(&lock);
 }
 
+int ThreadPool::getSpinCount() const {
+    return spinCount;
+}
+
+void ThreadPool::setSpinCount(int count) {
+    spinCount = count;
+}
+
+bool ThreadPool::getShared() const {
+    return isShared;
+}
+
+void ThreadPool::setShared(bool shared) {
+    isShared = shared;
+}
+
 } // namespace OpenMM
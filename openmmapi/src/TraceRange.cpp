@@ -0,0 +1,88 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/TraceRange.h"
+
+#ifdef OPENMM_TRACE_ANNOTATIONS
+
+#ifdef OPENMM_USE_NVTX
+#include <nvtx3/nvToolsExt.h>
+#endif
+#ifdef OPENMM_USE_ITT
+#include <ittnotify.h>
+#include <map>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+#ifdef OPENMM_USE_ITT
+static __itt_domain* getDomain() {
+    static __itt_domain* domain = __itt_domain_create("OpenMM");
+    return domain;
+}
+
+static __itt_string_handle* getStringHandle(const char* name) {
+    // Creating a handle looks the name up in a global table under a lock, so each thread caches
+    // the ones it has used.
+
+    thread_local map<string, __itt_string_handle*> handles;
+    auto handle = handles.find(name);
+    if (handle != handles.end())
+        return handle->second;
+    __itt_string_handle* result = __itt_string_handle_create(name);
+    handles[name] = result;
+    return result;
+}
+#endif
+
+TraceRange::TraceRange(const char* name) {
+#ifdef OPENMM_USE_NVTX
+    nvtxRangePushA(name);
+#endif
+#ifdef OPENMM_USE_ITT
+    __itt_task_begin(getDomain(), __itt_null, __itt_null, getStringHandle(name));
+#endif
+}
+
+TraceRange::TraceRange(const string& name) : TraceRange(name.c_str()) {
+}
+
+TraceRange::~TraceRange() {
+#ifdef OPENMM_USE_ITT
+    __itt_task_end(getDomain());
+#endif
+#ifdef OPENMM_USE_NVTX
+    nvtxRangePop();
+#endif
+}
+
+#endif
@@ -0,0 +1,427 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/TrajectoryWriter.h"
+#include "openmm/Integrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include "xdrfile/xdrfile.h"
+#include "xdrfile/xdrfile_xtc.h"
+#include <pthread.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <queue>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * The data for one frame that is waiting to be written.
+ */
+struct Frame {
+    long long step;
+    double time;
+    Vec3 box[3];
+    vector<Vec3> positions;
+};
+
+/**
+ * This class owns the output file and the background thread that writes frames to it.
+ */
+class TrajectoryWriter::FrameQueue {
+public:
+    FrameQueue(const string& filename, Format format, int numParticles, bool periodic, double stepSize, int interval, long long firstStep, bool append);
+    ~FrameQueue();
+    int getInitialFrames() const {
+        return initialFrames;
+    }
+    void addFrame(Frame* frame);
+    void flush();
+private:
+    static void* threadBody(void* args);
+    void run();
+    void throwStashedException();
+    void writeFrame(const Frame& frame);
+    void writeDcdHeader();
+    void writeDcdFrame(const Frame& frame);
+    void writeXtcFrame(const Frame& frame);
+    static const int MaxPendingFrames = 2;
+    Format format;
+    int numParticles;
+    bool periodic;
+    FILE* dcdFile;
+    XDRFILE* xtcFile;
+    int initialFrames, dcdFrames, dcdFirstStep, dcdInterval;
+    float dcdStepSize;
+    vector<float> buffer;
+    std::queue<Frame*> frames;
+    bool writing, finished, threwException;
+    OpenMMException stashedException;
+    pthread_t thread;
+    pthread_mutex_t queueLock;
+    pthread_cond_t frameAddedCondition, frameWrittenCondition;
+};
+
+void* TrajectoryWriter::FrameQueue::threadBody(void* args) {
+    reinterpret_cast<FrameQueue*>(args)->run();
+    return 0;
+}
+
+TrajectoryWriter::FrameQueue::FrameQueue(const string& filename, Format format, int numParticles, bool periodic, double stepSize, int interval, long long firstStep, bool append) :
+        format(format), numParticles(numParticles), periodic(periodic), dcdFile(NULL), xtcFile(NULL), initialFrames(0), dcdFrames(-1),
+        dcdFirstStep((int) min(firstStep, (long long) 0x7FFFFFFF)), dcdInterval(interval), writing(false), finished(false), threwException(false), stashedException("") {
+    // DCD files store the step size in AKMA time units.
+
+    dcdStepSize = (float) (stepSize/0.04888821);
+    if (format == DCD) {
+        if (append) {
+            dcdFile = fopen(filename.c_str(), "r+b");
+            if (dcdFile == NULL)
+                throw OpenMMException("TrajectoryWriter: Could not open file "+filename);
+            int header[5], fileParticles;
+            bool valid = (fread(header, sizeof(int), 5, dcdFile) == 5 && header[0] == 84 && memcmp(&header[1], "CORD", 4) == 0);
+            valid = valid && fseek(dcdFile, 268, SEEK_SET) == 0 && fread(&fileParticles, sizeof(int), 1, dcdFile) == 1;
+            if (!valid) {
+                fclose(dcdFile);
+                throw OpenMMException("TrajectoryWriter: "+filename+" is not a valid DCD file");
+            }
+            if (fileParticles != numParticles) {
+                fclose(dcdFile);
+                throw OpenMMException("TrajectoryWriter: Cannot append to a DCD file that contains a different number of atoms");
+            }
+            initialFrames = dcdFrames = header[2];
+            dcdFirstStep = header[3];
+            dcdInterval = header[4];
+            if (fseek(dcdFile, 44, SEEK_SET) != 0 || fread(&dcdStepSize, sizeof(float), 1, dcdFile) != 1) {
+                fclose(dcdFile);
+                throw OpenMMException("TrajectoryWriter: "+filename+" is not a valid DCD file");
+            }
+        }
+        else {
+            dcdFile = fopen(filename.c_str(), "wb");
+            if (dcdFile == NULL)
+                throw OpenMMException("TrajectoryWriter: Could not open file "+filename);
+        }
+    }
+    else {
+        if (append) {
+            int fileParticles;
+            if (read_xtc_natoms(const_cast<char*>(filename.c_str()), &fileParticles) != exdrOK)
+                throw OpenMMException("TrajectoryWriter: "+filename+" is not a valid XTC file");
+            if (fileParticles != numParticles)
+                throw OpenMMException("TrajectoryWriter: Cannot append to an XTC file that contains a different number of atoms");
+            XDRFILE* input = xdrfile_open(filename.c_str(), "r");
+            if (input == NULL)
+                throw OpenMMException("TrajectoryWriter: Could not open file "+filename);
+            vector<float> positions(3*numParticles);
+            int step;
+            float time, precision;
+            matrix box;
+            while (read_xtc(input, numParticles, &step, &time, box, (rvec*) positions.data(), &precision) == exdrOK)
+                initialFrames++;
+            xdrfile_close(input);
+        }
+        xtcFile = xdrfile_open(filename.c_str(), append ? "a" : "w");
+        if (xtcFile == NULL)
+            throw OpenMMException("TrajectoryWriter: Could not open file "+filename);
+    }
+    pthread_mutex_init(&queueLock, NULL);
+    pthread_cond_init(&frameAddedCondition, NULL);
+    pthread_cond_init(&frameWrittenCondition, NULL);
+    pthread_create(&thread, NULL, threadBody, this);
+}
+
+TrajectoryWriter::FrameQueue::~FrameQueue() {
+    pthread_mutex_lock(&queueLock);
+    finished = true;
+    pthread_cond_broadcast(&frameAddedCondition);
+    pthread_mutex_unlock(&queueLock);
+    pthread_join(thread, NULL);
+    pthread_mutex_destroy(&queueLock);
+    pthread_cond_destroy(&frameAddedCondition);
+    pthread_cond_destroy(&frameWrittenCondition);
+    while (!frames.empty()) {
+        delete frames.front();
+        frames.pop();
+    }
+    if (dcdFile != NULL)
+        fclose(dcdFile);
+    if (xtcFile != NULL)
+        xdrfile_close(xtcFile);
+}
+
+void TrajectoryWriter::FrameQueue::addFrame(Frame* frame) {
+    pthread_mutex_lock(&queueLock);
+    while (frames.size() >= MaxPendingFrames && !threwException)
+        pthread_cond_wait(&frameWrittenCondition, &queueLock);
+    if (threwException) {
+        delete frame;
+        throwStashedException();
+    }
+    frames.push(frame);
+    pthread_cond_signal(&frameAddedCondition);
+    pthread_mutex_unlock(&queueLock);
+}
+
+void TrajectoryWriter::FrameQueue::flush() {
+    pthread_mutex_lock(&queueLock);
+    while ((writing || !frames.empty()) && !threwException)
+        pthread_cond_wait(&frameWrittenCondition, &queueLock);
+    if (threwException)
+        throwStashedException();
+    pthread_mutex_unlock(&queueLock);
+}
+
+void TrajectoryWriter::FrameQueue::throwStashedException() {
+    // This is called with the queue locked.  Any frames still in the queue have already been
+    // discarded, so the writer can continue with the next frame that gets added.
+
+    OpenMMException exception = stashedException;
+    threwException = false;
+    pthread_mutex_unlock(&queueLock);
+    throw exception;
+}
+
+void TrajectoryWriter::FrameQueue::run() {
+    while (true) {
+        pthread_mutex_lock(&queueLock);
+        while (frames.empty() && !finished)
+            pthread_cond_wait(&frameAddedCondition, &queueLock);
+        if (frames.empty()) {
+            pthread_mutex_unlock(&queueLock);
+            return;
+        }
+        Frame* frame = frames.front();
+        frames.pop();
+        writing = true;
+        pthread_mutex_unlock(&queueLock);
+        bool failed = false;
+        OpenMMException exception("");
+        try {
+            writeFrame(*frame);
+        }
+        catch (const OpenMMException& e) {
+            failed = true;
+            exception = e;
+        }
+        delete frame;
+        pthread_mutex_lock(&queueLock);
+        writing = false;
+        if (failed) {
+            // Discard any remaining frames so the file is not left with a gap in the middle.
+
+            threwException = true;
+            stashedException = exception;
+            while (!frames.empty()) {
+                delete frames.front();
+                frames.pop();
+            }
+        }
+        pthread_cond_broadcast(&frameWrittenCondition);
+        pthread_mutex_unlock(&queueLock);
+    }
+}
+
+void TrajectoryWriter::FrameQueue::writeFrame(const Frame& frame) {
+    for (const Vec3& pos : frame.positions)
+        if (!isfinite(pos[0]) || !isfinite(pos[1]) || !isfinite(pos[2]))
+            throw OpenMMException("TrajectoryWriter: Particle position is NaN or infinite");
+    if (format == DCD)
+        writeDcdFrame(frame);
+    else
+        writeXtcFrame(frame);
+}
+
+void TrajectoryWriter::FrameQueue::writeDcdHeader() {
+    int header1[] = {84, 0, dcdFrames, dcdFirstStep, dcdInterval, 0, 0, 0, 0, 0, 0};
+    memcpy(&header1[1], "CORD", 4);
+    int header2[] = {periodic ? 1 : 0, 0, 0, 0, 0, 0, 0, 0, 0, 21, 84, 164, 2};
+    char title1[80] = "Created by OpenMM";
+    char title2[80];
+    time_t now = time(NULL);
+    strftime(title2, sizeof(title2), "Created %a %b %d %H:%M:%S %Y", localtime(&now));
+    memset(title2+strlen(title2), 0, sizeof(title2)-strlen(title2));
+    int header3[] = {164, 4, numParticles, 4};
+    fwrite(header1, sizeof(int), 11, dcdFile);
+    fwrite(&dcdStepSize, sizeof(float), 1, dcdFile);
+    fwrite(header2, sizeof(int), 13, dcdFile);
+    fwrite(title1, 1, 80, dcdFile);
+    fwrite(title2, 1, 80, dcdFile);
+    fwrite(header3, sizeof(int), 4, dcdFile);
+}
+
+void TrajectoryWriter::FrameQueue::writeDcdFrame(const Frame& frame) {
+    if (dcdFrames == -1) {
+        // This is the first frame of a new file, so write the header.
+
+        dcdFrames = 0;
+        writeDcdHeader();
+    }
+    dcdFrames++;
+    if (dcdInterval > 1 && dcdFirstStep+(long long) dcdFrames*dcdInterval > (1LL<<31)) {
+        // This will exceed the range of a 32 bit integer.  The header is changed to say the
+        // trajectory consisted of a smaller number of larger steps, so the total length of the
+        // trajectory remains correct.
+
+        dcdFirstStep /= dcdInterval;
+        dcdStepSize *= dcdInterval;
+        dcdInterval = 1;
+        int header[] = {dcdFirstStep, dcdInterval};
+        fseek(dcdFile, 12, SEEK_SET);
+        fwrite(header, sizeof(int), 2, dcdFile);
+        fseek(dcdFile, 44, SEEK_SET);
+        fwrite(&dcdStepSize, sizeof(float), 1, dcdFile);
+    }
+
+    // Update the header.
+
+    int lastStep = dcdFirstStep+dcdFrames*dcdInterval;
+    fseek(dcdFile, 8, SEEK_SET);
+    fwrite(&dcdFrames, sizeof(int), 1, dcdFile);
+    fseek(dcdFile, 20, SEEK_SET);
+    fwrite(&lastStep, sizeof(int), 1, dcdFile);
+
+    // Write the data.
+
+    fseek(dcdFile, 0, SEEK_END);
+    if (periodic) {
+        const Vec3* box = frame.box;
+        double a = sqrt(box[0].dot(box[0]));
+        double b = sqrt(box[1].dot(box[1]));
+        double c = sqrt(box[2].dot(box[2]));
+        double cosAlpha = box[1].dot(box[2])/(b*c);
+        double cosBeta = box[0].dot(box[2])/(a*c);
+        double cosGamma = box[0].dot(box[1])/(a*b);
+        double cell[] = {10*a, cosGamma, 10*b, cosBeta, cosAlpha, 10*c};
+        int length = 48;
+        fwrite(&length, sizeof(int), 1, dcdFile);
+        fwrite(cell, sizeof(double), 6, dcdFile);
+        fwrite(&length, sizeof(int), 1, dcdFile);
+    }
+    int length = 4*numParticles;
+    buffer.resize(numParticles);
+    for (int axis = 0; axis < 3; axis++) {
+        for (int i = 0; i < numParticles; i++)
+            buffer[i] = (float) (10*frame.positions[i][axis]);
+        fwrite(&length, sizeof(int), 1, dcdFile);
+        fwrite(buffer.data(), sizeof(float), numParticles, dcdFile);
+        fwrite(&length, sizeof(int), 1, dcdFile);
+    }
+    if (fflush(dcdFile) != 0 || ferror(dcdFile))
+        throw OpenMMException("TrajectoryWriter: Error writing to DCD file");
+}
+
+void TrajectoryWriter::FrameQueue::writeXtcFrame(const Frame& frame) {
+    matrix box;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            box[i][j] = (periodic ? (float) frame.box[i][j] : 0.0f);
+    buffer.resize(3*numParticles);
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < 3; j++)
+            buffer[3*i+j] = (float) frame.positions[i][j];
+    int step = (int) min(frame.step, (long long) 0x7FFFFFFF);
+    if (write_xtc(xtcFile, numParticles, step, (float) frame.time, box, (rvec*) buffer.data(), 1000.0f) != exdrOK)
+        throw OpenMMException("TrajectoryWriter: Error writing to XTC file");
+}
+
+TrajectoryWriter::TrajectoryWriter(Context& context, const string& filename, Format format, int interval, bool append) :
+        context(context), filename(filename), format(format), interval(interval), enforcePeriodicBox(false), numFrames(0), queue(NULL) {
+    if (interval < 1)
+        throw OpenMMException("TrajectoryWriter: The interval must be positive");
+    if (format != DCD && format != XTC)
+        throw OpenMMException("TrajectoryWriter: Unknown file format");
+    const System& system = context.getSystem();
+    queue = new FrameQueue(filename, format, system.getNumParticles(), system.usesPeriodicBoundaryConditions(),
+            context.getIntegrator().getStepSize(), interval, context.getStepCount(), append);
+    numFrames = queue->getInitialFrames();
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    delete queue;
+}
+
+const string& TrajectoryWriter::getFilename() const {
+    return filename;
+}
+
+TrajectoryWriter::Format TrajectoryWriter::getFormat() const {
+    return format;
+}
+
+int TrajectoryWriter::getInterval() const {
+    return interval;
+}
+
+bool TrajectoryWriter::getEnforcePeriodicBox() const {
+    return enforcePeriodicBox;
+}
+
+void TrajectoryWriter::setEnforcePeriodicBox(bool enforce) {
+    enforcePeriodicBox = enforce;
+}
+
+int TrajectoryWriter::getNumFrames() const {
+    return numFrames;
+}
+
+void TrajectoryWriter::step(int steps) {
+    Integrator& integrator = context.getIntegrator();
+    while (steps > 0) {
+        int stepsToNextFrame = interval-(int) (context.getStepCount()%interval);
+        int stepsToTake = min(steps, stepsToNextFrame);
+        integrator.step(stepsToTake);
+        steps -= stepsToTake;
+        if (context.getStepCount()%interval == 0)
+            writeFrame();
+    }
+}
+
+void TrajectoryWriter::writeFrame() {
+    State state = context.getState(State::Positions, enforcePeriodicBox);
+    Frame* frame = new Frame();
+    frame->step = state.getStepCount();
+    frame->time = state.getTime();
+    state.getPeriodicBoxVectors(frame->box[0], frame->box[1], frame->box[2]);
+    frame->positions = state.getPositions();
+    queue->addFrame(frame);
+    numFrames++;
+}
+
+void TrajectoryWriter::flush() {
+    queue->flush();
+}
@@ -102,19 +102,13 @@ double VariableLangevinIntegrator::computeKineticEnergy() {
 void VariableLangevinIntegrator::step(int steps) {
     if (context == NULL)
         throw OpenMMException("This Integrator is not bound to a context!");  
-    for (int i = 0; i < steps; ++i) {
-        context->updateContextState();
-        context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
-        setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, std::numeric_limits<double>::infinity()));
-    }
+    if (steps > 0)
+        setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, std::numeric_limits<double>::infinity(), steps));
 }
 
 void VariableLangevinIntegrator::stepTo(double time) {
     if (context == NULL)
         throw OpenMMException("This Integrator is not bound to a context!");
-    while (time > context->getTime()) {
-        context->updateContextState();
-        context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
-        setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, time));
-    }
+    if (time > context->getTime())
+        setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, time, std::numeric_limits<int>::max()));
 }
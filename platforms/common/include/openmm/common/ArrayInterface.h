@@ -87,6 +87,11 @@ public:
      * Get the context this array belongs to.
      */
     virtual ComputeContext& getContext() = 0;
+    /**
+     * Get the platform-specific handle to the device memory: a CUdeviceptr on CUDA, or
+     * a cl_mem on OpenCL.
+     */
+    virtual void* getDeviceHandle() = 0;
     /**
      * Copy the values in a vector to the device memory.
      * 
@@ -129,6 +129,15 @@ public:
      * @param force      the HarmonicBondForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const HarmonicBondForce& force);
+    /**
+     * Copy changed parameters over to a context for a contiguous range of bonds.
+     *
+     * @param context     the context to copy parameters to
+     * @param force       the HarmonicBondForce to copy the parameters from
+     * @param firstBond   the index of the first bond whose parameters have changed
+     * @param numChanged  the number of consecutive bonds whose parameters have changed
+     */
+    void copySomeParametersToContext(ContextImpl& context, const HarmonicBondForce& force, int firstBond, int numChanged);
 private:
     class ForceInfo;
     int numBonds;
@@ -171,6 +180,15 @@ public:
      * @param force      the CustomBondForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const CustomBondForce& force);
+    /**
+     * Copy changed parameters over to a context for a contiguous range of bonds.
+     *
+     * @param context     the context to copy parameters to
+     * @param force       the CustomBondForce to copy the parameters from
+     * @param firstBond   the index of the first bond whose parameters have changed
+     * @param numChanged  the number of consecutive bonds whose parameters have changed
+     */
+    void copySomeParametersToContext(ContextImpl& context, const CustomBondForce& force, int firstBond, int numChanged);
 private:
     class ForceInfo;
     int numBonds;
@@ -215,6 +233,15 @@ public:
      * @param force      the HarmonicAngleForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const HarmonicAngleForce& force);
+    /**
+     * Copy changed parameters over to a context for a contiguous range of angles.
+     *
+     * @param context     the context to copy parameters to
+     * @param force       the HarmonicAngleForce to copy the parameters from
+     * @param firstAngle  the index of the first angle whose parameters have changed
+     * @param numChanged  the number of consecutive angles whose parameters have changed
+     */
+    void copySomeParametersToContext(ContextImpl& context, const HarmonicAngleForce& force, int firstAngle, int numChanged);
 private:
     class ForceInfo;
     int numAngles;
@@ -301,6 +328,15 @@ public:
      * @param force      the PeriodicTorsionForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const PeriodicTorsionForce& force);
+    /**
+     * Copy changed parameters over to a context for a contiguous range of torsions.
+     *
+     * @param context       the context to copy parameters to
+     * @param force         the PeriodicTorsionForce to copy the parameters from
+     * @param firstTorsion  the index of the first torsion whose parameters have changed
+     * @param numChanged    the number of consecutive torsions whose parameters have changed
+     */
+    void copySomeParametersToContext(ContextImpl& context, const PeriodicTorsionForce& force, int firstTorsion, int numChanged);
 private:
     class ForceInfo;
     int numTorsions;
@@ -474,6 +510,15 @@ public:
      * @param force      the CustomExternalForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const CustomExternalForce& force);
+    /**
+     * Copy changed parameters over to a context for a contiguous range of particles.
+     *
+     * @param context        the context to copy parameters to
+     * @param force          the CustomExternalForce to copy the parameters from
+     * @param firstParticle  the index of the first particle whose parameters have changed
+     * @param numChanged     the number of consecutive particles whose parameters have changed
+     */
+    void copySomeParametersToContext(ContextImpl& context, const CustomExternalForce& force, int firstParticle, int numChanged);
 private:
     class ForceInfo;
     int numParticles;
@@ -569,19 +614,19 @@ public:
 
 private:
     class ForceInfo;
-    int numGroups, numBonds;
+    int numGroups, numSmallGroups, numLargeGroups, numBonds;
     bool needEnergyParamDerivs;
     ComputeContext& cc;
     ForceInfo* info;
     ComputeParameterSet* params;
-    ComputeArray globals, groupParticles, groupWeights, groupOffsets;
+    ComputeArray globals, groupParticles, groupWeights, groupOffsets, smallGroups, largeGroups;
     ComputeArray groupForces, bondGroups, centerPositions;
     std::vector<std::string> globalParamNames;
     std::vector<float> globalParamValues;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
     std::vector<void*> groupForcesArgs;
-    ComputeKernel computeCentersKernel, groupForcesKernel, applyForcesKernel;
+    ComputeKernel computeSmallCentersKernel, computeCentersKernel, groupForcesKernel, applyForcesKernel;
     const System& system;
 };
 
@@ -591,7 +636,7 @@ private:
 class CommonCalcCustomNonbondedForceKernel : public CalcCustomNonbondedForceKernel {
 public:
     CommonCalcCustomNonbondedForceKernel(std::string name, const Platform& platform, ComputeContext& cc, const System& system) : CalcCustomNonbondedForceKernel(name, platform),
-            cc(cc), params(NULL), computedValues(NULL), forceCopy(NULL), system(system), hasInitializedKernel(false) {
+            cc(cc), params(NULL), computedValues(NULL), forceCopy(NULL), system(system), hasInitializedKernel(false), computedValuesValid(false) {
     }
     ~CommonCalcCustomNonbondedForceKernel();
     /**
@@ -617,11 +662,21 @@ public:
      * @param force      the CustomNonbondedForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const CustomNonbondedForce& force);
+    /**
+     * Copy changed parameters over to a context for a contiguous range of particles.
+     *
+     * @param context        the context to copy parameters to
+     * @param force          the CustomNonbondedForce to copy the parameters from
+     * @param firstParticle  the index of the first particle whose parameters have changed
+     * @param numChanged     the number of consecutive particles whose parameters have changed
+     */
+    void copySomeParametersToContext(ContextImpl& context, const CustomNonbondedForce& force, int firstParticle, int numChanged);
 private:
     class ForceInfo;
     class LongRangePostComputation;
     class LongRangeTask;
     void initInteractionGroups(const CustomNonbondedForce& force, const std::string& interactionSource, const std::vector<std::string>& tableTypes);
+    void updateLongRangeCorrectionAndFunctions(ContextImpl& context, const CustomNonbondedForce& force);
     ComputeContext& cc;
     ForceInfo* info;
     ComputeParameterSet* params;
@@ -637,7 +692,7 @@ private:
     std::vector<ComputeParameterInfo> paramBuffers, computedValueBuffers;
     double longRangeCoefficient;
     std::vector<double> longRangeCoefficientDerivs;
-    bool hasInitializedLongRangeCorrection, hasInitializedKernel, hasParamDerivs, useNeighborList;
+    bool hasInitializedLongRangeCorrection, hasInitializedKernel, hasParamDerivs, useNeighborList, computedValuesValid;
     int numGroupThreadBlocks;
     CustomNonbondedForce* forceCopy;
     CustomNonbondedForceImpl::LongRangeCorrectionData longRangeCorrectionData;
@@ -749,7 +804,7 @@ private:
 class CommonCalcCustomHbondForceKernel : public CalcCustomHbondForceKernel {
 public:
     CommonCalcCustomHbondForceKernel(std::string name, const Platform& platform, ComputeContext& cc, const System& system) : CalcCustomHbondForceKernel(name, platform),
-            hasInitializedKernel(false), cc(cc), donorParams(NULL), acceptorParams(NULL), system(system) {
+            hasInitializedKernel(false), cc(cc), donorParams(NULL), acceptorParams(NULL), system(system), useCutoff(false) {
     }
     ~CommonCalcCustomHbondForceKernel();
     /**
@@ -788,12 +843,15 @@ private:
     ComputeArray acceptors;
     ComputeArray donorExclusions;
     ComputeArray acceptorExclusions;
+    ComputeArray blockCenter;
+    ComputeArray blockBoundingBox;
     std::vector<std::string> globalParamNames;
     std::vector<float> globalParamValues;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
     const System& system;
-    ComputeKernel kernel;
+    ComputeKernel kernel, blockBoundsKernel;
+    bool useCutoff;
 };
 
 /**
@@ -1070,6 +1128,61 @@ private:
     double prevTemp, prevFriction, prevStepSize;
     bool hasInitializedKernels;
     ComputeArray params, oldDelta;
+    ComputeKernel kernel1, kernel2, kernel3, noConstraintsKernel;
+};
+
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class CommonIntegrateMTSLangevinStepKernel : public IntegrateMTSLangevinStepKernel {
+public:
+    CommonIntegrateMTSLangevinStepKernel(std::string name, const Platform& platform, ComputeContext& cc) : IntegrateMTSLangevinStepKernel(name, platform), cc(cc),
+            hasInitializedKernels(false) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const MTSLangevinIntegrator& integrator);
+    /**
+     * Update the velocities based on the most recently computed forces.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the time interval over which to apply the forces
+     */
+    void updateVelocities(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt);
+    /**
+     * Advance the positions by half a substep, interact with the heat bath, advance them by another half
+     * substep, and then apply constraints to the positions and velocities.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the size of the substep
+     */
+    void updatePositions(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt);
+    /**
+     * Apply constraints to the velocities at the end of a time step, and advance the time and step count.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    void finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+private:
+    void initializeKernels();
+    ComputeContext& cc;
+    double prevTemp, prevFriction, prevStepSize;
+    bool hasInitializedKernels;
+    ComputeArray oldDelta;
     ComputeKernel kernel1, kernel2, kernel3;
 };
 
@@ -1080,8 +1193,7 @@ class CommonIntegrateNoseHooverStepKernel : public IntegrateNoseHooverStepKernel
 public:
     CommonIntegrateNoseHooverStepKernel(std::string name, const Platform& platform, ComputeContext& cc) :
                                   IntegrateNoseHooverStepKernel(name, platform), cc(cc), hasInitializedKernels(false),
-                                  hasInitializedKineticEnergyKernel(false), hasInitializedHeatBathEnergyKernel(false),
-                                  hasInitializedScaleVelocitiesKernel(false), hasInitializedPropagateKernel(false) {}
+                                  chainsChanged(false), chainParamsChanged(false), blocksPerChain(1) {}
     ~CommonIntegrateNoseHooverStepKernel() {}
     /**
      * Initialize the kernel.
@@ -1166,25 +1278,41 @@ public:
      */
     void setChainStates(ContextImpl& context, const std::vector<std::vector<double> >& positions, const std::vector<std::vector<double> >& velocities);
 private:
+    /**
+     * Get the index of a chain in the arrays that hold all chains, adding it if it has not been seen before.
+     */
+    int getChainIndex(const NoseHooverChain& noseHooverChain);
+    /**
+     * Rebuild the arrays describing the chains if any have been added or their states have been replaced.
+     */
+    void updateChains();
+    /**
+     * Record the current temperature and collision frequency of a chain.  They are uploaded by the next
+     * call to uploadChainParameters().
+     */
+    void setChainParameters(const NoseHooverChain& noseHooverChain, int index);
+    void uploadChainParameters();
+    /**
+     * Get the states of all chains, indexed by 2*chainID for absolute thermostats and 2*chainID+1 for relative ones.
+     */
+    void downloadChainStates(std::map<int, std::vector<mm_double2> >& states) const;
+    /**
+     * Replace the states of all chains.
+     */
+    void uploadChainStates(const std::map<int, std::vector<mm_double2> >& states);
     ComputeContext& cc;
     float prevMaxPairDistance;
     ComputeArray maxPairDistanceBuffer, pairListBuffer, atomListBuffer, pairTemperatureBuffer, oldDelta;
-    std::map<int, ComputeArray> chainState;
     ComputeKernel kernel1, kernel2, kernel3, kernel4, kernelHardWall;
-    bool hasInitializedKernels;
-    ComputeKernel reduceEnergyKernel;
-    ComputeKernel computeHeatBathEnergyKernel;
-    ComputeKernel computeAtomsKineticEnergyKernel;
-    ComputeKernel computePairsKineticEnergyKernel;
-    ComputeKernel scaleAtomsVelocitiesKernel;
-    ComputeKernel scalePairsVelocitiesKernel;
-    ComputeArray energyBuffer, scaleFactorBuffer, kineticEnergyBuffer, chainMasses, chainForces, heatBathEnergy;
-    std::map<int, ComputeArray> atomlists, pairlists;
-    std::map<int, ComputeKernel> propagateKernels;
-    bool hasInitializedPropagateKernel;
-    bool hasInitializedKineticEnergyKernel;
-    bool hasInitializedHeatBathEnergyKernel;
-    bool hasInitializedScaleVelocitiesKernel;
+    bool hasInitializedKernels, chainsChanged, chainParamsChanged;
+    ComputeKernel computeChainKineticEnergiesKernel, propagateChainsKernel, scaleChainVelocitiesKernel, computeHeatBathEnergyKernel;
+    ComputeArray chainStates, chainForces, chainLayout, chainSteps, chainParams, ysWeights, scaleFactors, partialKineticEnergy, heatBathEnergy;
+    ComputeArray chainAtoms, chainAtomStart, chainAtomIndex, chainPairs, chainPairStart, chainPairIndex;
+    std::vector<NoseHooverChain> chains;
+    std::vector<int> atomStart, pairStart;
+    std::vector<mm_double4> hostChainParams;
+    std::map<int, int> chainIndex, stateOffset, stateLength;
+    int blocksPerChain;
 };
 
 /**
@@ -1229,7 +1357,7 @@ private:
 class CommonIntegrateVariableVerletStepKernel : public IntegrateVariableVerletStepKernel {
 public:
     CommonIntegrateVariableVerletStepKernel(std::string name, const Platform& platform, ComputeContext& cc) : IntegrateVariableVerletStepKernel(name, platform), cc(cc),
-            hasInitializedKernels(false) {
+            hasInitializedKernels(false), selectedStepSize(0.0) {
     }
     /**
      * Initialize the kernel.
@@ -1239,14 +1367,16 @@ public:
      */
     void initialize(const System& system, const VariableVerletIntegrator& integrator);
     /**
-     * Execute the kernel.
+     * Execute the kernel.  This advances the simulation by up to maxSteps time steps, stopping early once
+     * maxTime is reached.  The kernel is responsible for computing forces before each step.
      *
      * @param context    the context in which to execute this kernel
      * @param integrator the VariableVerletIntegrator this kernel is being used for
      * @param maxTime    the maximum time beyond which the simulation should not be advanced
-     * @return the size of the step that was taken
+     * @param maxSteps   the maximum number of steps to take
+     * @return the size of the last step that was taken
      */
-    double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime);
+    double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime, int maxSteps);
     /**
      * Compute the kinetic energy.
      * 
@@ -1258,7 +1388,10 @@ private:
     ComputeContext& cc;
     bool hasInitializedKernels;
     int blockSize;
+    double selectedStepSize;
+    ComputeArray stepState;
     ComputeKernel kernel1, kernel2, selectSizeKernel;
+    ComputeEvent event;
 };
 
 /**
@@ -1267,7 +1400,7 @@ private:
 class CommonIntegrateVariableLangevinStepKernel : public IntegrateVariableLangevinStepKernel {
 public:
     CommonIntegrateVariableLangevinStepKernel(std::string name, const Platform& platform, ComputeContext& cc) : IntegrateVariableLangevinStepKernel(name, platform), cc(cc),
-            hasInitializedKernels(false) {
+            hasInitializedKernels(false), selectedStepSize(0.0) {
     }
     /**
      * Initialize the kernel, setting up the particle masses.
@@ -1277,14 +1410,16 @@ public:
      */
     void initialize(const System& system, const VariableLangevinIntegrator& integrator);
     /**
-     * Execute the kernel.
+     * Execute the kernel.  This advances the simulation by up to maxSteps time steps, stopping early once
+     * maxTime is reached.  The kernel is responsible for computing forces before each step.
      *
      * @param context    the context in which to execute this kernel
      * @param integrator the VariableLangevinIntegrator this kernel is being used for
      * @param maxTime    the maximum time beyond which the simulation should not be advanced
-     * @return the size of the step that was taken
+     * @param maxSteps   the maximum number of steps to take
+     * @return the size of the last step that was taken
      */
-    double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime);
+    double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime, int maxSteps);
     /**
      * Compute the kinetic energy.
      * 
@@ -1296,8 +1431,10 @@ private:
     ComputeContext& cc;
     bool hasInitializedKernels;
     int blockSize;
-    ComputeArray params;
+    double selectedStepSize;
+    ComputeArray params, stepState;
     ComputeKernel kernel1, kernel2, selectSizeKernel;
+    ComputeEvent event;
     double prevTemp, prevFriction, prevErrorTol;
 };
 
@@ -1382,6 +1519,9 @@ private:
     void recordGlobalValue(double value, GlobalTarget target, CustomIntegrator& integrator);
     void recordChangedParameters(ContextImpl& context);
     bool evaluateCondition(int step);
+    void downloadGlobalValues(std::vector<double>& values) const;
+    void downloadGlobalsFromDevice();
+    bool stepReadsGlobalsOnDevice(int step) const;
     ComputeContext& cc;
     double energy;
     float energyFloat;
@@ -1402,6 +1542,7 @@ private:
     std::vector<double> localPerDofEnergyParamDerivs;
     std::vector<double> localGlobalValues;
     std::vector<double> initialGlobalVariables;
+    std::map<int, std::string> globalsOnDevice;
     std::vector<std::vector<ComputeKernel> > kernels;
     ComputeKernel randomKernel, kineticEnergyKernel, sumKineticEnergyKernel;
     std::vector<CustomIntegrator::ComputationType> stepType;
@@ -1481,12 +1622,6 @@ public:
      * @return the potential energy due to the force
      */
     double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
-    /**
-     * This is the internal implementation of execute(), templatized on whether we're
-     * using single or double precision.
-     */
-    template <class REAL>
-    double executeImpl(ContextImpl& context);
     /**
      * Copy changed parameters over to a context.
      *
@@ -1504,6 +1639,37 @@ private:
     ComputeKernel kernel1, kernel2;
 };
 
+/**
+ * This kernel is invoked by ExternalForce to calculate the forces acting on the system and the energy of the system.
+ */
+class CommonCalcExternalForceKernel : public CalcExternalForceKernel {
+public:
+    CommonCalcExternalForceKernel(std::string name, const Platform& platform, ComputeContext& cc) : CalcExternalForceKernel(name, platform), cc(cc), computation(NULL) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param force      the ExternalForce this kernel will be used for
+     */
+    void initialize(const System& system, const ExternalForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+private:
+    ComputeContext& cc;
+    ExternalForce::Computation* computation;
+    ComputeArray forceBuffer;
+    ComputeKernel addForcesKernel;
+    ComputeEvent event;
+};
+
 /**
  * This kernel is invoked by AndersenThermostat at the start of each time step to adjust the particle velocities.
  */
@@ -1571,7 +1737,7 @@ private:
     ComputeContext& cc;
     bool hasInitializedKernels, rigidMolecules;
     int numMolecules;
-    ComputeArray savedPositions, savedFloatForces, savedLongForces;
+    ComputeArray savedPositions;
     ComputeArray moleculeAtoms;
     ComputeArray moleculeStartIndex;
     ComputeKernel kernel;
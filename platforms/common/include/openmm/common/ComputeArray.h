@@ -96,6 +96,11 @@ public:
      * Get the context this array belongs to.
      */
     ComputeContext& getContext();
+    /**
+     * Get the platform-specific handle to the device memory: a CUdeviceptr on CUDA, or
+     * a cl_mem on OpenCL.
+     */
+    void* getDeviceHandle();
     /**
      * Copy the values in a vector to the Buffer.
      */
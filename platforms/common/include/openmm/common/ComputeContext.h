@@ -65,6 +65,7 @@ public:
     class ReorderListener;
     class ForcePreComputation;
     class ForcePostComputation;
+    class MemoryCategory;
     static const int ThreadBlockSize;
     static const int TileSize;
     ComputeContext(const System& system);
@@ -245,6 +246,12 @@ public:
     void setAtomsWereReordered(bool wereReordered) {
         atomsWereReordered = wereReordered;
     }
+    /**
+     * Get the number of times the atoms have been reordered since the context was created.
+     */
+    long long getNumAtomReorders() const {
+        return numAtomReorders;
+    }
     /**
      * Reorder the internal arrays of atoms to try to keep spatially contiguous atoms close
      * together in the arrays.
@@ -260,6 +267,60 @@ public:
      * perform reordering.
      */
     void forceReorder();
+    /**
+     * Count the atom pairs in the tiles of the neighbor list, and how many of them are currently closer
+     * than a cutoff distance.  This downloads the neighbor list and positions from the device, so it is
+     * slow and is only meant for collecting statistics.
+     *
+     * @param numTiles          the number of tiles in the neighbor list
+     * @param cutoff            the cutoff distance
+     * @param numPairs          on exit, the number of atom pairs in the tiles
+     * @param numPairsInCutoff  on exit, how many of those pairs are within the cutoff
+     */
+    void countNeighborListPairs(int numTiles, double cutoff, long long& numPairs, long long& numPairsInCutoff);
+    /**
+     * Get the category that device memory allocated for arrays is currently attributed to.  Each
+     * array records the category that was current when it was created, so memory it allocates
+     * later by resizing is attributed to the same category.  Use a MemoryCategory object to
+     * change it for a block of code.
+     */
+    const std::string& getMemoryCategory() const {
+        return memoryCategory;
+    }
+    /**
+     * Set the category that device memory allocated for arrays is attributed to.
+     */
+    void setMemoryCategory(const std::string& category) {
+        memoryCategory = category;
+    }
+    /**
+     * Record that device memory has been allocated or freed.  Arrays call this automatically.
+     * Other code that allocates device memory, such as FFT plans, should also call it.
+     *
+     * @param category   the category to attribute the memory to
+     * @param bytes      the number of bytes that were allocated.  When memory is freed, this
+     *                   should be negative.
+     */
+    void recordMemoryUsage(const std::string& category, long long bytes);
+    /**
+     * Get the amount of device memory (in bytes) currently allocated in each category.  The
+     * element "Total" is the sum over all categories, and "Peak" is the largest total there
+     * has been at any time since the context was created.
+     */
+    std::map<std::string, double> getMemoryUsage() const;
+    /**
+     * Estimate how much device memory (in bytes) a context for a System will use in each category.
+     * The estimate covers the standard data structures: per-atom arrays, constraints, the nonbonded
+     * exclusions and neighbor list, and PME grids and FFTs.  Arrays created for other Forces, which
+     * are usually small, are not included.  The neighbor list grows as needed while a simulation
+     * runs, so its size is estimated from the density of the System.  The elements of the returned
+     * map are the same as for getMemoryUsage(), except that "Peak" is omitted.
+     *
+     * @param system               the System to estimate the memory for
+     * @param useDoublePrecision   whether double precision will be used
+     * @param useMixedPrecision    whether mixed precision will be used
+     */
+    static std::map<std::string, double> estimateMemoryUsage(const System& system, bool useDoublePrecision, bool useMixedPrecision);
     /**
      * Add a listener that should be called whenever atoms get reordered.  The OpenCLContext
      * assumes ownership of the object, and deletes it when the context itself is deleted.
@@ -387,6 +448,12 @@ public:
     const std::vector<int>& getAtomIndex() const {
         return atomIndex;
     }
+    /**
+     * Set the index of each atom, both on the host and on the device, and notify all
+     * ReorderListeners that the order has changed.  The positions, velocities, and cell
+     * offsets must already be stored in the new order.
+     */
+    void setAtomIndex(const std::vector<int>& index);
     /**
      * Get the array which contains the index of each atom.
      */
@@ -504,6 +571,18 @@ public:
      * definitions and order to be revalidated.
      */
     bool invalidateMolecules(ComputeForceInfo* force);
+    /**
+     * Mark that the current molecule definitions from one particular force may be invalid, after the parameters
+     * involving a known set of atoms have changed.  This is equivalent to invalidateMolecules(force), but it only
+     * checks the molecules that contain the specified atoms.  When only a few atoms in a large System are affected,
+     * that is much faster than checking every molecule.
+     *
+     * @param force    the force whose parameters have changed
+     * @param atoms    the indices of every atom whose parameters have changed, or that belongs to a particle group
+     *                 whose parameters have changed
+     * @return true if the atom order was invalid and had to be rebuilt
+     */
+    bool invalidateMolecules(ComputeForceInfo* force, const std::vector<int>& atoms);
     /**
      * Make sure the current atom order is valid, based on the forces.  If not, perform reordering
      * to generate a new valid order.  This method is only needed in very unusual situations.
@@ -522,6 +601,10 @@ protected:
     class VirtualSiteInfo;
     void findMoleculeGroups();
     void resetAtomOrder();
+    /**
+     * Determine whether two instances of a molecule are still identical as far as one force is concerned.
+     */
+    bool areMoleculesIdentical(ComputeForceInfo* force, int forceIndex, const MoleculeGroup& group, int instance1, int instance2);
     /**
      * This is the internal implementation of reorderAtoms(), templatized by the numerical precision in use.
      */
@@ -530,11 +613,14 @@ protected:
     const System& system;
     double time;
     int numAtoms, paddedNumAtoms, computeForceCount, stepsSinceReorder;
-    long long stepCount;
+    long long stepCount, numAtomReorders, totalMemory, peakMemory;
+    std::string memoryCategory;
+    std::map<std::string, long long> memoryUsage;
     bool forceNextReorder, atomsWereReordered, forcesValid;
     std::vector<ComputeForceInfo*> forces;
     std::vector<Molecule> molecules;
     std::vector<MoleculeGroup> moleculeGroups;
+    std::vector<int> atomMolecule;
     std::vector<int> atomIndex;
     std::vector<mm_int4> posCellOffsets;
     std::vector<ReorderListener*> reorderListeners;
@@ -547,6 +633,7 @@ struct ComputeContext::Molecule {
     std::vector<int> atoms;
     std::vector<int> constraints;
     std::vector<std::vector<int> > groups;
+    int group, instance;
 };
 
 struct ComputeContext::MoleculeGroup {
@@ -612,6 +699,24 @@ public:
     }
 };
 
+/**
+ * Creating a MemoryCategory sets the category that device memory allocated for arrays is
+ * attributed to.  When it is deleted, the previous category is restored.  It is typically
+ * created on the stack around the code that creates a group of related arrays.
+ */
+class OPENMM_EXPORT_COMMON ComputeContext::MemoryCategory {
+public:
+    MemoryCategory(ComputeContext& context, const std::string& category) : context(context), previous(context.getMemoryCategory()) {
+        context.setMemoryCategory(category);
+    }
+    ~MemoryCategory() {
+        context.setMemoryCategory(previous);
+    }
+private:
+    ComputeContext& context;
+    std::string previous;
+};
+
 /**
  * This abstract class defines a function to be executed at the very beginning of force and
  * energy evaluation, before any other calculation has been done.  It is useful for operations
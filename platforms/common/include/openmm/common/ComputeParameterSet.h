@@ -82,6 +82,15 @@ public:
      */
     template <class T>
     void setParameterValues(const std::vector<std::vector<T> >& values);
+    /**
+     * Set the values of all parameters for a contiguous range of objects.  Only the corresponding
+     * elements of the arrays are uploaded.
+     *
+     * @param first    the index of the first object to set values for
+     * @param values   values[i][j] contains the value of parameter j for object first+i
+     */
+    template <class T>
+    void setParameterValues(int first, const std::vector<std::vector<T> >& values);
     /**
      * Get a vector of ComputeParameterInfo objects which describe the arrays
      * containing the data.
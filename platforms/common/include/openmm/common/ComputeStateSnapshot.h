@@ -0,0 +1,87 @@
+#ifndef OPENMM_COMPUTESTATESNAPSHOT_H_
+#define OPENMM_COMPUTESTATESNAPSHOT_H_
+
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/common/ComputeArray.h"
+#include "openmm/common/ComputeVectorTypes.h"
+#include "openmm/Vec3.h"
+#include <vector>
+
+namespace OpenMM {
+
+class ComputeContext;
+
+/**
+ * This class records the integration state of a ComputeContext in arrays on the device,
+ * so it can later be restored without transferring anything to or from the host.  This
+ * is useful for algorithms such as replica exchange that repeatedly save and restore
+ * states.  It records the positions, velocities, periodic box vectors, time, step count,
+ * atom ordering, and state of the random number generator.  Like the data saved by
+ * Context::setState(), it does not include state that is internal to a particular
+ * integrator or force.
+ *
+ * A snapshot can only be restored into the context it was created from, and only for
+ * contexts that are not parallelized across multiple devices.
+ */
+
+class OPENMM_EXPORT_COMMON ComputeStateSnapshot {
+public:
+    ComputeStateSnapshot(ComputeContext& context);
+    /**
+     * Record the current state of the context, replacing whatever was recorded before.
+     */
+    void save();
+    /**
+     * Restore the context to the state that was recorded by the most recent call to save().
+     * Because the positions change, any forces the ContextImpl has cached are no longer valid.
+     * The caller should call ContextImpl::invalidateCachedForces() and set
+     * ContextImpl::getLastForceGroups() to -1.
+     */
+    void restore();
+    /**
+     * Get whether save() has been called, so there is a state to restore.
+     */
+    bool getIsSaved() const {
+        return isSaved;
+    }
+private:
+    ComputeContext& context;
+    ComputeArray posq, posqCorrection, velm, random, randomSeed;
+    std::vector<int> atomIndex;
+    std::vector<mm_int4> posCellOffsets;
+    Vec3 boxVectors[3];
+    double time;
+    long long stepCount;
+    int stepsSinceReorder, randomPos;
+    bool isSaved;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_COMPUTESTATESNAPSHOT_H_*/
@@ -89,6 +89,12 @@ public:
      * @param tol             the constraint tolerance
      */
     void applyVelocityConstraints(double tol);
+    /**
+     * Get whether there are any constraints to apply.  If not, applyConstraints() and
+     * applyVelocityConstraints() do nothing, and integrators may combine the work before
+     * and after them into a single kernel.
+     */
+    bool hasConstraints() const;
     /**
      * Initialize the random number generator.  This should be called once when the
      * context is first created.  Subsequent calls will be ignored if the random
@@ -123,6 +129,23 @@ public:
      * @param stream    an input stream the checkpoint data should be read from
      */
     void loadCheckpoint(std::istream& stream);
+    /**
+     * Copy the current state of the random number generator into arrays on the device.
+     * The arrays are initialized or resized as needed.
+     *
+     * @param randomCopy       the random values are copied into this
+     * @param randomSeedCopy   the generator seeds are copied into this
+     * @param position         the current position in the array of random values is stored into this
+     */
+    void createSnapshot(ComputeArray& randomCopy, ComputeArray& randomSeedCopy, int& position);
+    /**
+     * Restore the state of the random number generator from arrays that were filled in by createSnapshot().
+     *
+     * @param randomCopy       the random values to restore
+     * @param randomSeedCopy   the generator seeds to restore
+     * @param position         the position in the array of random values to restore
+     */
+    void loadSnapshot(ComputeArray& randomCopy, ComputeArray& randomSeedCopy, int position);
     /**
      * Compute the kinetic energy of the system, possibly shifting the velocities in time to account
      * for a leapfrog integrator.
@@ -44,10 +44,10 @@
 #include "ReferenceTabulatedFunction.h"
 #include "SimTKOpenMMRealType.h"
 #include "SimTKOpenMMUtilities.h"
-#include "jama_eig.h"
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <limits>
 #include <set>
 
 using namespace OpenMM;
@@ -213,6 +213,37 @@ void CommonCalcHarmonicBondForceKernel::copyParametersToContext(ContextImpl& con
     
     cc.invalidateMolecules(info);
 }
+
+void CommonCalcHarmonicBondForceKernel::copySomeParametersToContext(ContextImpl& context, const HarmonicBondForce& force, int firstBond, int numChanged) {
+    ContextSelector selector(cc);
+    int numContexts = cc.getNumContexts();
+    int startIndex = cc.getContextIndex()*force.getNumBonds()/numContexts;
+    int endIndex = (cc.getContextIndex()+1)*force.getNumBonds()/numContexts;
+    if (numBonds != endIndex-startIndex)
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+    int first = max(firstBond, startIndex);
+    int last = min(firstBond+numChanged, endIndex);
+    if (first >= last)
+        return;
+    
+    // Record the per-bond parameters for the bonds that changed.
+    
+    vector<mm_float2> paramVector(last-first);
+    vector<int> atoms;
+    for (int i = first; i < last; i++) {
+        int atom1, atom2;
+        double length, k;
+        force.getBondParameters(i, atom1, atom2, length, k);
+        paramVector[i-first] = mm_float2((float) length, (float) k);
+        atoms.push_back(atom1);
+        atoms.push_back(atom2);
+    }
+    params.uploadSubArray(paramVector.data(), first-startIndex, last-first);
+    
+    // Mark that the current reordering may be invalid.
+    
+    cc.invalidateMolecules(info, atoms);
+}
 class CommonCalcCustomBondForceKernel::ForceInfo : public ComputeForceInfo {
 public:
     ForceInfo(const CustomBondForce& force) : force(force) {
@@ -367,6 +398,39 @@ void CommonCalcCustomBondForceKernel::copyParametersToContext(ContextImpl& conte
     cc.invalidateMolecules(info);
 }
 
+void CommonCalcCustomBondForceKernel::copySomeParametersToContext(ContextImpl& context, const CustomBondForce& force, int firstBond, int numChanged) {
+    ContextSelector selector(cc);
+    int numContexts = cc.getNumContexts();
+    int startIndex = cc.getContextIndex()*force.getNumBonds()/numContexts;
+    int endIndex = (cc.getContextIndex()+1)*force.getNumBonds()/numContexts;
+    if (numBonds != endIndex-startIndex)
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+    int first = max(firstBond, startIndex);
+    int last = min(firstBond+numChanged, endIndex);
+    if (first >= last)
+        return;
+    
+    // Record the per-bond parameters for the bonds that changed.
+    
+    vector<vector<float> > paramVector(last-first);
+    vector<double> parameters;
+    vector<int> atoms;
+    for (int i = first; i < last; i++) {
+        int atom1, atom2;
+        force.getBondParameters(i, atom1, atom2, parameters);
+        paramVector[i-first].resize(parameters.size());
+        for (int j = 0; j < (int) parameters.size(); j++)
+            paramVector[i-first][j] = (float) parameters[j];
+        atoms.push_back(atom1);
+        atoms.push_back(atom2);
+    }
+    params->setParameterValues(first-startIndex, paramVector);
+    
+    // Mark that the current reordering may be invalid.
+    
+    cc.invalidateMolecules(info, atoms);
+}
+
 class CommonCalcHarmonicAngleForceKernel::ForceInfo : public ComputeForceInfo {
 public:
     ForceInfo(const HarmonicAngleForce& force) : force(force) {
@@ -451,6 +515,38 @@ void CommonCalcHarmonicAngleForceKernel::copyParametersToContext(ContextImpl& co
     cc.invalidateMolecules();
 }
 
+void CommonCalcHarmonicAngleForceKernel::copySomeParametersToContext(ContextImpl& context, const HarmonicAngleForce& force, int firstAngle, int numChanged) {
+    ContextSelector selector(cc);
+    int numContexts = cc.getNumContexts();
+    int startIndex = cc.getContextIndex()*force.getNumAngles()/numContexts;
+    int endIndex = (cc.getContextIndex()+1)*force.getNumAngles()/numContexts;
+    if (numAngles != endIndex-startIndex)
+        throw OpenMMException("updateParametersInContext: The number of angles has changed");
+    int first = max(firstAngle, startIndex);
+    int last = min(firstAngle+numChanged, endIndex);
+    if (first >= last)
+        return;
+    
+    // Record the per-angle parameters for the angles that changed.
+    
+    vector<mm_float2> paramVector(last-first);
+    vector<int> atoms;
+    for (int i = first; i < last; i++) {
+        int atom1, atom2, atom3;
+        double angle, k;
+        force.getAngleParameters(i, atom1, atom2, atom3, angle, k);
+        paramVector[i-first] = mm_float2((float) angle, (float) k);
+        atoms.push_back(atom1);
+        atoms.push_back(atom2);
+        atoms.push_back(atom3);
+    }
+    params.uploadSubArray(paramVector.data(), first-startIndex, last-first);
+    
+    // Mark that the current reordering may be invalid.
+    
+    cc.invalidateMolecules(info, atoms);
+}
+
 class CommonCalcCustomAngleForceKernel::ForceInfo : public ComputeForceInfo {
 public:
     ForceInfo(const CustomAngleForce& force) : force(force) {
@@ -691,6 +787,39 @@ void CommonCalcPeriodicTorsionForceKernel::copyParametersToContext(ContextImpl&
     cc.invalidateMolecules();
 }
 
+void CommonCalcPeriodicTorsionForceKernel::copySomeParametersToContext(ContextImpl& context, const PeriodicTorsionForce& force, int firstTorsion, int numChanged) {
+    ContextSelector selector(cc);
+    int numContexts = cc.getNumContexts();
+    int startIndex = cc.getContextIndex()*force.getNumTorsions()/numContexts;
+    int endIndex = (cc.getContextIndex()+1)*force.getNumTorsions()/numContexts;
+    if (numTorsions != endIndex-startIndex)
+        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
+    int first = max(firstTorsion, startIndex);
+    int last = min(firstTorsion+numChanged, endIndex);
+    if (first >= last)
+        return;
+    
+    // Record the per-torsion parameters for the torsions that changed.
+    
+    vector<mm_float4> paramVector(last-first);
+    vector<int> atoms;
+    for (int i = first; i < last; i++) {
+        int atom1, atom2, atom3, atom4, periodicity;
+        double phase, k;
+        force.getTorsionParameters(i, atom1, atom2, atom3, atom4, periodicity, phase, k);
+        paramVector[i-first] = mm_float4((float) k, (float) phase, (float) periodicity, 0.0f);
+        atoms.push_back(atom1);
+        atoms.push_back(atom2);
+        atoms.push_back(atom3);
+        atoms.push_back(atom4);
+    }
+    params.uploadSubArray(paramVector.data(), first-startIndex, last-first);
+    
+    // Mark that the current reordering may be invalid.
+    
+    cc.invalidateMolecules(info, atoms);
+}
+
 class CommonCalcRBTorsionForceKernel::ForceInfo : public ComputeForceInfo {
 public:
     ForceInfo(const RBTorsionForce& force) : force(force) {
@@ -1221,6 +1350,38 @@ void CommonCalcCustomExternalForceKernel::copyParametersToContext(ContextImpl& c
     cc.invalidateMolecules(info);
 }
 
+void CommonCalcCustomExternalForceKernel::copySomeParametersToContext(ContextImpl& context, const CustomExternalForce& force, int firstParticle, int numChanged) {
+    ContextSelector selector(cc);
+    int numContexts = cc.getNumContexts();
+    int startIndex = cc.getContextIndex()*force.getNumParticles()/numContexts;
+    int endIndex = (cc.getContextIndex()+1)*force.getNumParticles()/numContexts;
+    if (numParticles != endIndex-startIndex)
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+    int first = max(firstParticle, startIndex);
+    int last = min(firstParticle+numChanged, endIndex);
+    if (first >= last)
+        return;
+    
+    // Record the per-particle parameters for the particles that changed.
+    
+    vector<vector<float> > paramVector(last-first);
+    vector<double> parameters;
+    vector<int> atoms;
+    for (int i = first; i < last; i++) {
+        int particle;
+        force.getParticleParameters(i, particle, parameters);
+        paramVector[i-first].resize(parameters.size());
+        for (int j = 0; j < (int) parameters.size(); j++)
+            paramVector[i-first][j] = (float) parameters[j];
+        atoms.push_back(particle);
+    }
+    params->setParameterValues(first-startIndex, paramVector);
+    
+    // Mark that the current reordering may be invalid.
+    
+    cc.invalidateMolecules(info, atoms);
+}
+
 class CommonCalcCustomCompoundBondForceKernel::ForceInfo : public ComputeForceInfo {
 public:
     ForceInfo(const CustomCompoundBondForce& force) : force(force) {
@@ -1477,24 +1638,54 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
     info = new ForceInfo(force);
     cc.addForce(info);
     
-    // Record the groups.
+    // Record the groups.  Groups that contain identical particles and weights are merged, so each
+    // distinct center is only computed once.
     
-    numGroups = force.getNumGroups();
+    vector<vector<double> > normalizedWeights;
+    CustomCentroidBondForceImpl::computeNormalizedWeights(force, system, normalizedWeights);
+    map<pair<vector<int>, vector<double> >, int> uniqueGroups;
+    vector<int> groupIndex(force.getNumGroups());
     vector<int> groupParticleVec;
     vector<double> groupWeightVec;
     vector<int> groupOffsetVec;
     groupOffsetVec.push_back(0);
-    for (int i = 0; i < numGroups; i++) {
+    for (int i = 0; i < force.getNumGroups(); i++) {
         vector<int> particles;
         vector<double> weights;
         force.getGroupParameters(i, particles, weights);
+        auto key = make_pair(particles, normalizedWeights[i]);
+        auto existing = uniqueGroups.find(key);
+        if (existing != uniqueGroups.end()) {
+            groupIndex[i] = existing->second;
+            continue;
+        }
+        groupIndex[i] = uniqueGroups.size();
+        uniqueGroups[key] = groupIndex[i];
         groupParticleVec.insert(groupParticleVec.end(), particles.begin(), particles.end());
+        groupWeightVec.insert(groupWeightVec.end(), normalizedWeights[i].begin(), normalizedWeights[i].end());
         groupOffsetVec.push_back(groupParticleVec.size());
     }
-    vector<vector<double> > normalizedWeights;
-    CustomCentroidBondForceImpl::computeNormalizedWeights(force, system, normalizedWeights);
-    for (int i = 0; i < numGroups; i++)
-        groupWeightVec.insert(groupWeightVec.end(), normalizedWeights[i].begin(), normalizedWeights[i].end());
+    numGroups = uniqueGroups.size();
+
+    // Small groups are summed by a single thread each, and large ones by a whole thread block.
+    // This keeps a few very large groups from being a bottleneck when there are many small ones.
+
+    const int maxSmallGroupSize = 16;
+    vector<int> smallGroupVec, largeGroupVec;
+    for (int i = 0; i < numGroups; i++) {
+        if (groupOffsetVec[i+1]-groupOffsetVec[i] <= maxSmallGroupSize)
+            smallGroupVec.push_back(i);
+        else
+            largeGroupVec.push_back(i);
+    }
+    numSmallGroups = smallGroupVec.size();
+    numLargeGroups = largeGroupVec.size();
+    smallGroups.initialize<int>(cc, max(numSmallGroups, 1), "smallGroups");
+    largeGroups.initialize<int>(cc, max(numLargeGroups, 1), "largeGroups");
+    if (numSmallGroups > 0)
+        smallGroups.upload(smallGroupVec);
+    if (numLargeGroups > 0)
+        largeGroups.upload(largeGroupVec);
     groupParticles.initialize<int>(cc, groupParticleVec.size(), "groupParticles");
     groupParticles.upload(groupParticleVec);
     if (cc.getUseDoublePrecision()) {
@@ -1522,7 +1713,7 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
         vector<double> parameters;
         force.getBondParameters(i, groups, parameters);
         for (int j = 0; j < groups.size(); j++)
-            bondGroupVec[i+j*numBonds] = groups[j];
+            bondGroupVec[i+j*numBonds] = groupIndex[groups[j]];
         paramVector[i].resize(parameters.size());
         for (int j = 0; j < (int) parameters.size(); j++)
             paramVector[i][j] = (float) parameters[j];
@@ -1653,12 +1844,21 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
     replacements["INIT_PARAM_DERIVS"] = initParamDerivs.str();
     replacements["SAVE_PARAM_DERIVS"] = saveParamDerivs.str();
     ComputeProgram program = cc.compileProgram(cc.replaceStrings(CommonKernelSources::pointFunctions+CommonKernelSources::customCentroidBond, replacements));
+    computeSmallCentersKernel = program->createKernel("computeSmallGroupCenters");
+    computeSmallCentersKernel->addArg(numSmallGroups);
+    computeSmallCentersKernel->addArg(cc.getPosq());
+    computeSmallCentersKernel->addArg(groupParticles);
+    computeSmallCentersKernel->addArg(groupWeights);
+    computeSmallCentersKernel->addArg(groupOffsets);
+    computeSmallCentersKernel->addArg(smallGroups);
+    computeSmallCentersKernel->addArg(centerPositions);
     computeCentersKernel = program->createKernel("computeGroupCenters");
-    computeCentersKernel->addArg(numGroups);
+    computeCentersKernel->addArg(numLargeGroups);
     computeCentersKernel->addArg(cc.getPosq());
     computeCentersKernel->addArg(groupParticles);
     computeCentersKernel->addArg(groupWeights);
     computeCentersKernel->addArg(groupOffsets);
+    computeCentersKernel->addArg(largeGroups);
     computeCentersKernel->addArg(centerPositions);
     groupForcesKernel = program->createKernel("computeGroupForces");
     groupForcesKernel->addArg(numGroups);
@@ -1700,7 +1900,10 @@ double CommonCalcCustomCentroidBondForceKernel::execute(ContextImpl& context, bo
         if (changed)
             globals.upload(globalParamValues);
     }
-    computeCentersKernel->execute(32*numGroups);
+    if (numSmallGroups > 0)
+        computeSmallCentersKernel->execute(numSmallGroups);
+    if (numLargeGroups > 0)
+        computeCentersKernel->execute(64*numLargeGroups);
     groupForcesKernel->setArg(2, cc.getEnergyBuffer());
     setPeriodicBoxArgs(cc, groupForcesKernel, 5);
     if (needEnergyParamDerivs)
@@ -2080,11 +2283,65 @@ void CommonCalcCustomNonbondedForceKernel::initInteractionGroups(const CustomNon
     vector<pair<int, int> > tiles;
     vector<int> tileGroup;
     vector<vector<int> > duplicateAtomsForGroup;
+
+    // Groups that share one of their sets can be combined into a single group, as long as this does
+    // not change which pairs are computed or how many times.  That is true when the other sets are
+    // disjoint from each other and from the shared set.  This is common when a small set (such as a
+    // ligand) interacts with many small sets, and combining them gives much fuller tiles.
+
+    vector<pair<set<int>, set<int> > > groups;
+    vector<bool> groupIsDisjoint;
+    map<set<int>, vector<int> > groupsWithFirstSet;
     for (int group = 0; group < force.getNumInteractionGroups(); group++) {
-        // Get the list of atoms in this group and sort them.
-        
         set<int> set1, set2;
         force.getInteractionGroupParameters(group, set1, set2);
+        int merged = -1;
+        for (int swap = 0; swap < 2 && merged == -1; swap++) {
+            const set<int>& shared = (swap == 0 ? set1 : set2);
+            const set<int>& other = (swap == 0 ? set2 : set1);
+            auto candidates = groupsWithFirstSet.find(shared);
+            if (candidates == groupsWithFirstSet.end())
+                continue;
+            for (int candidate : candidates->second) {
+                if (!groupIsDisjoint[candidate])
+                    continue;
+                set<int>& candidateOther = groups[candidate].second;
+                bool disjoint = true;
+                for (int atom : other)
+                    if (shared.find(atom) != shared.end() || candidateOther.find(atom) != candidateOther.end()) {
+                        disjoint = false;
+                        break;
+                    }
+                if (disjoint) {
+                    candidateOther.insert(other.begin(), other.end());
+                    merged = candidate;
+                    break;
+                }
+            }
+        }
+        if (merged != -1)
+            continue;
+        bool disjoint = true;
+        for (int atom : set2)
+            if (set1.find(atom) != set1.end()) {
+                disjoint = false;
+                break;
+            }
+
+        // Put the smaller set first, since that is the one most likely to be shared with other groups.
+
+        if (set2.size() < set1.size())
+            groups.push_back(make_pair(set2, set1));
+        else
+            groups.push_back(make_pair(set1, set2));
+        groupsWithFirstSet[groups.back().first].push_back(groups.size()-1);
+        groupIsDisjoint.push_back(disjoint);
+    }
+    for (int group = 0; group < groups.size(); group++) {
+        // Get the list of atoms in this group and sort them.
+        
+        const set<int>& set1 = groups[group].first;
+        const set<int>& set2 = groups[group].second;
         vector<int> atoms1, atoms2;
         atoms1.insert(atoms1.begin(), set1.begin(), set1.end());
         atoms2.insert(atoms2.begin(), set2.begin(), set2.end());
@@ -2352,6 +2609,7 @@ double CommonCalcCustomNonbondedForceKernel::execute(ContextImpl& context, bool
         }
         if (changed) {
             globals.upload(globalParamValues);
+            computedValuesValid = false;
             if (forceCopy != NULL)
                 recomputeLongRangeCorrection = true;
         }
@@ -2364,8 +2622,15 @@ double CommonCalcCustomNonbondedForceKernel::execute(ContextImpl& context, bool
         else
             hasInitializedLongRangeCorrection = false;
     }
-    if (computedValues != NULL)
+
+    // Computed values depend only on per-particle and global parameters, so they only need to be
+    // recomputed when one of those changes.  Atom reordering only swaps identical molecules, so it
+    // does not invalidate them.
+
+    if (computedValues != NULL && !computedValuesValid) {
         computedValuesKernel->execute(cc.getNumAtoms());
+        computedValuesValid = true;
+    }
     if (interactionGroupData.isInitialized()) {
         if (!hasInitializedKernel) {
             hasInitializedKernel = true;
@@ -2434,7 +2699,41 @@ void CommonCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImpl&
             paramVector[i][j] = (float) parameters[j];
     }
     params->setParameterValues(paramVector);
+    computedValuesValid = false;
+    updateLongRangeCorrectionAndFunctions(context, force);
+
+    // Mark that the current reordering may be invalid.
+
+    cc.invalidateMolecules(info);
+}
+
+void CommonCalcCustomNonbondedForceKernel::copySomeParametersToContext(ContextImpl& context, const CustomNonbondedForce& force, int firstParticle, int numChanged) {
+    ContextSelector selector(cc);
+    if (force.getNumParticles() != cc.getNumAtoms())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // Record the per-particle parameters for the particles that changed.
+
+    vector<vector<float> > paramVector(numChanged);
+    vector<double> parameters;
+    vector<int> atoms(numChanged);
+    for (int i = 0; i < numChanged; i++) {
+        force.getParticleParameters(firstParticle+i, parameters);
+        paramVector[i].resize(parameters.size());
+        for (int j = 0; j < (int) parameters.size(); j++)
+            paramVector[i][j] = (float) parameters[j];
+        atoms[i] = firstParticle+i;
+    }
+    params->setParameterValues(firstParticle, paramVector);
+    computedValuesValid = false;
+    updateLongRangeCorrectionAndFunctions(context, force);
+
+    // Mark that the current reordering may be invalid.
 
+    cc.invalidateMolecules(info, atoms);
+}
+
+void CommonCalcCustomNonbondedForceKernel::updateLongRangeCorrectionAndFunctions(ContextImpl& context, const CustomNonbondedForce& force) {
     // If necessary, recompute the long range correction.
 
     if (forceCopy != NULL) {
@@ -2455,10 +2754,6 @@ void CommonCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImpl&
             tabulatedFunctionArrays[i].upload(f);
         }
     }
-
-    // Mark that the current reordering may be invalid.
-
-    cc.invalidateMolecules(info);
 }
 
 class CommonCalcGBSAOBCForceKernel::ForceInfo : public ComputeForceInfo {
@@ -4075,6 +4370,17 @@ void CommonCalcCustomHbondForceKernel::initialize(const System& system, const Cu
         defines["USE_EXCLUSIONS"] = "1";
     ComputeProgram program = cc.compileProgram(cc.replaceStrings(CommonKernelSources::customHbondForce, replacements), defines);
     kernel = program->createKernel("computeHbondForces");
+
+    // With a cutoff, a bounding box is computed for each block of donors and acceptors so tiles that
+    // are too far apart to interact can be skipped.
+
+    useCutoff = (force.getNonbondedMethod() != CustomHbondForce::NoCutoff);
+    int numBlocks = (numDonors+31)/32 + (numAcceptors+31)/32;
+    int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
+    blockCenter.initialize(cc, numBlocks, 4*elementSize, "customHbondBlockCenter");
+    blockBoundingBox.initialize(cc, numBlocks, 4*elementSize, "customHbondBlockBoundingBox");
+    if (useCutoff)
+        blockBoundsKernel = program->createKernel("findBlockBounds");
 }
 
 double CommonCalcCustomHbondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
@@ -4102,6 +4408,8 @@ double CommonCalcCustomHbondForceKernel::execute(ContextImpl& context, bool incl
         kernel->addArg(acceptors);
         for (int i = 0; i < 5; i++)
             kernel->addArg(); // Periodic box size arguments are set when the kernel is executed.
+        kernel->addArg(blockCenter);
+        kernel->addArg(blockBoundingBox);
         if (globals.isInitialized())
             kernel->addArg(globals);
         for (auto& parameter : donorParams->getParameterInfos())
@@ -4110,10 +4418,23 @@ double CommonCalcCustomHbondForceKernel::execute(ContextImpl& context, bool incl
             kernel->addArg(parameter.getArray());
         for (auto& function : tabulatedFunctionArrays)
             kernel->addArg(function);
+        if (useCutoff) {
+            blockBoundsKernel->addArg(cc.getPosq());
+            blockBoundsKernel->addArg(donors);
+            blockBoundsKernel->addArg(acceptors);
+            for (int i = 0; i < 5; i++)
+                blockBoundsKernel->addArg(); // Periodic box size arguments are set when the kernel is executed.
+            blockBoundsKernel->addArg(blockCenter);
+            blockBoundsKernel->addArg(blockBoundingBox);
+        }
     }
-    setPeriodicBoxArgs(cc, kernel, 6);
     int numDonorBlocks = (numDonors+31)/32;
     int numAcceptorBlocks = (numAcceptors+31)/32;
+    if (useCutoff) {
+        setPeriodicBoxArgs(cc, blockBoundsKernel, 3);
+        blockBoundsKernel->execute(numDonorBlocks+numAcceptorBlocks);
+    }
+    setPeriodicBoxArgs(cc, kernel, 6);
     kernel->execute(numDonorBlocks*numAcceptorBlocks*32, cc.getIsCPU() ? 32 : 64);
     return 0.0;
 }
@@ -4765,9 +5086,10 @@ void CommonCalcGayBerneForceKernel::initialize(const System& system, const GayBe
     scale.initialize<mm_float4>(cc, cc.getPaddedNumAtoms(), "scale");
     axisParticleIndices.initialize<mm_int2>(cc, cc.getPaddedNumAtoms(), "axisParticleIndices");
     sortedParticles.initialize<int>(cc, cc.getPaddedNumAtoms(), "sortedParticles");
-    aMatrix.initialize<float>(cc, 9*cc.getPaddedNumAtoms(), "aMatrix");
-    bMatrix.initialize<float>(cc, 9*cc.getPaddedNumAtoms(), "bMatrix");
-    gMatrix.initialize<float>(cc, 9*cc.getPaddedNumAtoms(), "gMatrix");
+    int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
+    aMatrix.initialize(cc, 9*cc.getPaddedNumAtoms(), elementSize, "aMatrix");
+    bMatrix.initialize(cc, 6*cc.getPaddedNumAtoms(), elementSize, "bMatrix");
+    gMatrix.initialize(cc, 6*cc.getPaddedNumAtoms(), elementSize, "gMatrix");
     vector<mm_float4> sigParamsVector(cc.getPaddedNumAtoms(), mm_float4(0, 0, 0, 0));
     vector<mm_float2> epsParamsVector(cc.getPaddedNumAtoms(), mm_float2(0, 0));
     vector<mm_float4> scaleVector(cc.getPaddedNumAtoms(), mm_float4(0, 0, 0, 0));
@@ -4819,7 +5141,6 @@ void CommonCalcGayBerneForceKernel::initialize(const System& system, const GayBe
     // Create data structures used for the neighbor list.
 
     int numAtomBlocks = (numRealParticles+31)/32;
-    int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
     blockCenter.initialize(cc, numAtomBlocks, 4*elementSize, "blockCenter");
     blockBoundingBox.initialize(cc, numAtomBlocks, 4*elementSize, "blockBoundingBox");
     sortedPos.initialize(cc, numRealParticles, 4*elementSize, "sortedPos");
@@ -5486,6 +5807,7 @@ void CommonIntegrateLangevinMiddleStepKernel::initialize(const System& system, c
     kernel1 = program->createKernel("integrateLangevinMiddlePart1");
     kernel2 = program->createKernel("integrateLangevinMiddlePart2");
     kernel3 = program->createKernel("integrateLangevinMiddlePart3");
+    noConstraintsKernel = program->createKernel("integrateLangevinMiddleNoConstraints");
     if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
         params.initialize<double>(cc, 2, "langevinMiddleParams");
         oldDelta.initialize<mm_double4>(cc, cc.getPaddedNumAtoms(), "oldDelta");
@@ -5525,6 +5847,17 @@ void CommonIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, cons
         kernel3->addArg(integration.getStepSize());
         if (cc.getUseMixedPrecision())
             kernel3->addArg(cc.getPosqCorrection());
+        noConstraintsKernel->addArg(numAtoms);
+        noConstraintsKernel->addArg(paddedNumAtoms);
+        noConstraintsKernel->addArg(cc.getPosq());
+        noConstraintsKernel->addArg(cc.getVelm());
+        noConstraintsKernel->addArg(cc.getLongForceBuffer());
+        noConstraintsKernel->addArg(params);
+        noConstraintsKernel->addArg(integration.getStepSize());
+        noConstraintsKernel->addArg(integration.getRandom());
+        noConstraintsKernel->addArg(); // Random index will be set just before it is executed.
+        if (cc.getUseMixedPrecision())
+            noConstraintsKernel->addArg(cc.getPosqCorrection());
     }
     double temperature = integrator.getTemperature();
     double friction = integrator.getFriction();
@@ -5545,19 +5878,139 @@ void CommonIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, cons
         prevStepSize = stepSize;
     }
 
-    // Perform the integration.
+    // Perform the integration.  If there are no constraints, the whole step can be done in
+    // a single kernel.
 
-    kernel2->setArg(7, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
-    kernel1->execute(numAtoms);
-    integration.applyVelocityConstraints(integrator.getConstraintTolerance());
+    if (integration.hasConstraints()) {
+        kernel2->setArg(7, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
+        kernel1->execute(numAtoms);
+        integration.applyVelocityConstraints(integrator.getConstraintTolerance());
+        kernel2->execute(numAtoms);
+        integration.applyConstraints(integrator.getConstraintTolerance());
+        kernel3->execute(numAtoms);
+    }
+    else {
+        noConstraintsKernel->setArg(8, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
+        noConstraintsKernel->execute(numAtoms);
+    }
+    integration.computeVirtualSites();
+
+    // Update the time and step count.
+
+    cc.setTime(cc.getTime()+stepSize);
+    cc.setStepCount(cc.getStepCount()+1);
+    cc.reorderAtoms();
+    
+    // Reduce UI lag.
+    
+#ifdef WIN32
+    cc.flushQueue();
+#endif
+}
+
+double CommonIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) {
+    return cc.getIntegrationUtilities().computeKineticEnergy(0.0);
+}
+
+void CommonIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    cc.initializeContexts();
+    ContextSelector selector(cc);
+    cc.getIntegrationUtilities().initRandomNumberGenerator(integrator.getRandomNumberSeed());
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::mtsLangevin);
+    kernel1 = program->createKernel("updateMTSLangevinVelocities");
+    kernel2 = program->createKernel("updateMTSLangevinPositions1");
+    kernel3 = program->createKernel("updateMTSLangevinPositions2");
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        oldDelta.initialize<mm_double4>(cc, cc.getPaddedNumAtoms(), "oldDelta");
+    else
+        oldDelta.initialize<mm_float4>(cc, cc.getPaddedNumAtoms(), "oldDelta");
+    prevStepSize = -1.0;
+}
+
+void CommonIntegrateMTSLangevinStepKernel::initializeKernels() {
+    if (hasInitializedKernels)
+        return;
+    hasInitializedKernels = true;
+    IntegrationUtilities& integration = cc.getIntegrationUtilities();
+    int numAtoms = cc.getNumAtoms();
+    kernel1->addArg(numAtoms);
+    kernel1->addArg(cc.getPaddedNumAtoms());
+    kernel1->addArg(); // dt
+    kernel1->addArg(cc.getVelm());
+    kernel1->addArg(cc.getLongForceBuffer());
+    kernel2->addArg(numAtoms);
+    kernel2->addArg(); // halfdt
+    kernel2->addArg(); // vscale
+    kernel2->addArg(); // noisescale
+    kernel2->addArg(cc.getVelm());
+    kernel2->addArg(integration.getPosDelta());
+    kernel2->addArg(oldDelta);
+    kernel2->addArg(integration.getRandom());
+    kernel2->addArg(); // Random index will be set just before it is executed.
+    kernel3->addArg(numAtoms);
+    kernel3->addArg(); // invDt
+    kernel3->addArg(cc.getPosq());
+    kernel3->addArg(cc.getVelm());
+    kernel3->addArg(integration.getPosDelta());
+    kernel3->addArg(oldDelta);
+    if (cc.getUseMixedPrecision())
+        kernel3->addArg(cc.getPosqCorrection());
+}
+
+void CommonIntegrateMTSLangevinStepKernel::updateVelocities(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) {
+    ContextSelector selector(cc);
+    initializeKernels();
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        kernel1->setArg(2, dt);
+    else
+        kernel1->setArg(2, (float) dt);
+    kernel1->execute(cc.getNumAtoms());
+}
+
+void CommonIntegrateMTSLangevinStepKernel::updatePositions(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) {
+    ContextSelector selector(cc);
+    IntegrationUtilities& integration = cc.getIntegrationUtilities();
+    initializeKernels();
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    if (temperature != prevTemp || friction != prevFriction || dt != prevStepSize) {
+        // Calculate the integration parameters.
+
+        double kT = BOLTZ*temperature;
+        double vscale = exp(-dt*friction);
+        double noisescale = sqrt(kT*(1-vscale*vscale));
+        if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+            kernel2->setArg(1, 0.5*dt);
+            kernel2->setArg(2, vscale);
+            kernel2->setArg(3, noisescale);
+            kernel3->setArg(1, 1.0/dt);
+        }
+        else {
+            kernel2->setArg(1, (float) (0.5*dt));
+            kernel2->setArg(2, (float) vscale);
+            kernel2->setArg(3, (float) noisescale);
+            kernel3->setArg(1, (float) (1.0/dt));
+        }
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = dt;
+    }
+    int numAtoms = cc.getNumAtoms();
+    kernel2->setArg(8, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
     kernel2->execute(numAtoms);
     integration.applyConstraints(integrator.getConstraintTolerance());
     kernel3->execute(numAtoms);
+    integration.applyVelocityConstraints(integrator.getConstraintTolerance());
     integration.computeVirtualSites();
+}
+
+void CommonIntegrateMTSLangevinStepKernel::finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    ContextSelector selector(cc);
+    cc.getIntegrationUtilities().applyVelocityConstraints(integrator.getConstraintTolerance());
 
     // Update the time and step count.
 
-    cc.setTime(cc.getTime()+stepSize);
+    cc.setTime(cc.getTime()+integrator.getStepSize());
     cc.setStepCount(cc.getStepCount()+1);
     cc.reorderAtoms();
     
@@ -5568,7 +6021,7 @@ void CommonIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, cons
 #endif
 }
 
-double CommonIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) {
+double CommonIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
     return cc.getIntegrationUtilities().computeKineticEnergy(0.0);
 }
 
@@ -5594,44 +6047,62 @@ void CommonIntegrateNoseHooverStepKernel::initialize(const System& system, const
 
     int workGroupSize = std::min(cc.getMaxThreadBlockSize(), 512);
     defines["WORK_GROUP_SIZE"] = std::to_string(workGroupSize);
-
-    defines["BEGIN_YS_LOOP"] = "const real arr[1] = {1.0};"
-                               "for(int i=0;i<1;++i) {"
-                               "const real ys = arr[i];";
-    defines["END_YS_LOOP"] = "}";
-    program = cc.compileProgram(CommonKernelSources::noseHooverChain, defines);
-    propagateKernels[1] = program->createKernel("propagateNoseHooverChain");
-
-    defines["BEGIN_YS_LOOP"] = "const real arr[3] = {0.828981543588751, -0.657963087177502, 0.828981543588751};"
-                               "for(int i=0;i<3;++i) {"
-                               "const real ys = arr[i];";
     program = cc.compileProgram(CommonKernelSources::noseHooverChain, defines);
-    propagateKernels[3] = program->createKernel("propagateNoseHooverChain");
-
-    defines["BEGIN_YS_LOOP"] = "const real arr[5] = {0.2967324292201065, 0.2967324292201065, -0.186929716880426, 0.2967324292201065, 0.2967324292201065};"
-                               "for(int i=0;i<5;++i) {"
-                               "const real ys = arr[i];";
-    program = cc.compileProgram(CommonKernelSources::noseHooverChain, defines);
-    propagateKernels[5] = program->createKernel("propagateNoseHooverChain");
-
-    defines["BEGIN_YS_LOOP"] = "const real arr[7] = {0.784513610477560, 0.235573213359357, -1.17767998417887, 1.31518632068391,-1.17767998417887, 0.235573213359357, 0.784513610477560};"
-                               "for(int i=0;i<7;++i) {"
-                               "const real ys = arr[i];";
-    program = cc.compileProgram(CommonKernelSources::noseHooverChain, defines);
-    propagateKernels[7] = program->createKernel("propagateNoseHooverChain");
-    program = cc.compileProgram(CommonKernelSources::noseHooverChain, defines);
-    reduceEnergyKernel = program->createKernel("reduceEnergyPair");
-
+    computeChainKineticEnergiesKernel = program->createKernel("computeChainKineticEnergies");
+    propagateChainsKernel = program->createKernel("propagateNoseHooverChains");
+    scaleChainVelocitiesKernel = program->createKernel("scaleChainVelocities");
     computeHeatBathEnergyKernel = program->createKernel("computeHeatBathEnergy");
-    computeAtomsKineticEnergyKernel = program->createKernel("computeAtomsKineticEnergy");
-    computePairsKineticEnergyKernel = program->createKernel("computePairsKineticEnergy");
-    scaleAtomsVelocitiesKernel = program->createKernel("scaleAtomsVelocities");
-    scalePairsVelocitiesKernel = program->createKernel("scalePairsVelocities");
-    int energyBufferSize = cc.getEnergyBuffer().getSize();
-    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
-        energyBuffer.initialize<mm_double2>(cc, energyBufferSize, "energyBuffer");
-    else
-        energyBuffer.initialize<mm_float2>(cc, energyBufferSize, "energyBuffer");
+
+    // The arrays describing the chains are resized by updateChains() once the chains are known.
+
+    int mixedSize = (useDouble ? sizeof(double) : sizeof(float));
+    chainStates.initialize(cc, 1, 2*mixedSize, "chainStates");
+    chainForces.initialize(cc, 1, mixedSize, "chainForces");
+    chainLayout.initialize<mm_int4>(cc, 1, "chainLayout");
+    chainSteps.initialize<mm_int4>(cc, 1, "chainSteps");
+    chainParams.initialize(cc, 1, 4*mixedSize, "chainParams");
+    ysWeights.initialize(cc, 1, mixedSize, "ysWeights");
+    scaleFactors.initialize(cc, 1, 2*mixedSize, "scaleFactors");
+    partialKineticEnergy.initialize(cc, 1, 2*mixedSize, "partialKineticEnergy");
+    heatBathEnergy.initialize(cc, 1, mixedSize, "heatBathEnergy");
+    chainAtoms.initialize<int>(cc, 1, "chainAtoms");
+    chainAtomStart.initialize<int>(cc, 1, "chainAtomStart");
+    chainAtomIndex.initialize<int>(cc, 1, "chainAtomIndex");
+    chainPairs.initialize<mm_int2>(cc, 1, "chainPairs");
+    chainPairStart.initialize<int>(cc, 1, "chainPairStart");
+    chainPairIndex.initialize<int>(cc, 1, "chainPairIndex");
+    for (int i = 0; i < 3; i++)
+        computeChainKineticEnergiesKernel->addArg(); // First chain, last chain, and blocks per chain
+    computeChainKineticEnergiesKernel->addArg(cc.getVelm());
+    computeChainKineticEnergiesKernel->addArg(chainAtoms);
+    computeChainKineticEnergiesKernel->addArg(chainAtomStart);
+    computeChainKineticEnergiesKernel->addArg(chainPairs);
+    computeChainKineticEnergiesKernel->addArg(chainPairStart);
+    computeChainKineticEnergiesKernel->addArg(partialKineticEnergy);
+    for (int i = 0; i < 3; i++)
+        propagateChainsKernel->addArg(); // First chain, last chain, and blocks per chain
+    propagateChainsKernel->addArg(partialKineticEnergy);
+    propagateChainsKernel->addArg(chainStates);
+    propagateChainsKernel->addArg(chainForces);
+    propagateChainsKernel->addArg(chainLayout);
+    propagateChainsKernel->addArg(chainSteps);
+    propagateChainsKernel->addArg(chainParams);
+    propagateChainsKernel->addArg(ysWeights);
+    propagateChainsKernel->addArg(scaleFactors);
+    propagateChainsKernel->addArg(); // Time step
+    for (int i = 0; i < 4; i++)
+        scaleChainVelocitiesKernel->addArg(); // Range of atoms and pairs
+    scaleChainVelocitiesKernel->addArg(scaleFactors);
+    scaleChainVelocitiesKernel->addArg(cc.getVelm());
+    scaleChainVelocitiesKernel->addArg(chainAtoms);
+    scaleChainVelocitiesKernel->addArg(chainAtomIndex);
+    scaleChainVelocitiesKernel->addArg(chainPairs);
+    scaleChainVelocitiesKernel->addArg(chainPairIndex);
+    computeHeatBathEnergyKernel->addArg(heatBathEnergy);
+    for (int i = 0; i < 4; i++)
+        computeHeatBathEnergyKernel->addArg(); // Chain length, numDOFs, kT, and frequency
+    computeHeatBathEnergyKernel->addArg(chainStates);
+    computeHeatBathEnergyKernel->addArg(); // Offset
 }
 
 void CommonIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const NoseHooverIntegrator& integrator, bool &forcesAreValid) {
@@ -5734,11 +6205,32 @@ void CommonIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const No
     kernel2->execute(numParticles);
     // Apply the thermostat
     int numChains = integrator.getNumThermostats();
-    for(int chain = 0; chain < numChains; ++chain) {
+    for (int chain = 0; chain < numChains; ++chain) {
         const auto &thermostatChain = integrator.getThermostat(chain);
-        auto KEs = computeMaskedKineticEnergy(context, thermostatChain, false);
-        auto scaleFactors = propagateChain(context, thermostatChain, KEs, dt);
-        scaleVelocities(context, thermostatChain, scaleFactors);
+        setChainParameters(thermostatChain, getChainIndex(thermostatChain));
+    }
+    updateChains();
+    uploadChainParameters();
+    if (chains.size() > 0) {
+        int workGroupSize = std::min(cc.getMaxThreadBlockSize(), 512);
+        int numAllChains = chains.size();
+        computeChainKineticEnergiesKernel->setArg(0, 0);
+        computeChainKineticEnergiesKernel->setArg(1, numAllChains);
+        computeChainKineticEnergiesKernel->setArg(2, blocksPerChain);
+        computeChainKineticEnergiesKernel->execute(numAllChains*blocksPerChain*workGroupSize, workGroupSize);
+        propagateChainsKernel->setArg(0, 0);
+        propagateChainsKernel->setArg(1, numAllChains);
+        propagateChainsKernel->setArg(2, blocksPerChain);
+        propagateChainsKernel->setArg(11, (float) dt);
+        propagateChainsKernel->execute(numAllChains);
+        int totalAtoms = atomStart[numAllChains], totalPairs = pairStart[numAllChains];
+        if (totalAtoms+totalPairs > 0) {
+            scaleChainVelocitiesKernel->setArg(0, 0);
+            scaleChainVelocitiesKernel->setArg(1, totalAtoms);
+            scaleChainVelocitiesKernel->setArg(2, 0);
+            scaleChainVelocitiesKernel->setArg(3, totalPairs);
+            scaleChainVelocitiesKernel->execute(std::max(totalAtoms, totalPairs));
+        }
     }
     // Position update
     kernel3->execute(numParticles);
@@ -5764,171 +6256,201 @@ double CommonIntegrateNoseHooverStepKernel::computeKineticEnergy(ContextImpl& co
     return cc.getIntegrationUtilities().computeKineticEnergy(0);
 }
 
-
-std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(ContextImpl& context, const NoseHooverChain &nhc, std::pair<double, double> kineticEnergies, double timeStep) {
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
+int CommonIntegrateNoseHooverStepKernel::getChainIndex(const NoseHooverChain& nhc) {
     int chainID = nhc.getChainID();
-    int nAtoms = nhc.getThermostatedAtoms().size();
-    int nPairs = nhc.getThermostatedPairs().size();
-    int chainLength = nhc.getChainLength();
     int numYS = nhc.getNumYoshidaSuzukiTimeSteps();
-    int numMTS = nhc.getNumMultiTimeSteps();
-
     if (numYS != 1 && numYS != 3 && numYS != 5 && numYS != 7) {
         throw OpenMMException("Number of Yoshida Suzuki time steps has to be 1, 3, 5, or 7.");
     }
-
-    if (!scaleFactorBuffer.isInitialized() || scaleFactorBuffer.getSize() == 0) {
-        if (useDouble) {
-            std::vector<mm_double2> zeros{{0,0}};
-            if (scaleFactorBuffer.isInitialized())
-                scaleFactorBuffer.resize(1);
-            else
-                scaleFactorBuffer.initialize<mm_double2>(cc, 1, "scaleFactorBuffer");
-            scaleFactorBuffer.upload(zeros);
-        }
-        else {
-            std::vector<mm_float2> zeros{{0,0}};
-            if (scaleFactorBuffer.isInitialized())
-                scaleFactorBuffer.resize(1);
-            else
-                scaleFactorBuffer.initialize<mm_float2>(cc, 1, "scaleFactorBuffer");
-            scaleFactorBuffer.upload(zeros);
-        }
+    auto existing = chainIndex.find(chainID);
+    if (existing == chainIndex.end()) {
+        int index = chains.size();
+        chains.push_back(nhc);
+        hostChainParams.push_back(mm_double4(0, 0, 0, 0));
+        chainIndex[chainID] = index;
+        chainsChanged = true;
+        return index;
     }
-    if (!chainForces.isInitialized() || !chainMasses.isInitialized()) {
-        if (useDouble) {
-            std::vector<double> zeros(chainLength,0);
-            if (chainForces.isInitialized()) {
-                chainMasses.resize(chainLength);
-                chainForces.resize(chainLength);
-            }
-            else {
-                chainMasses.initialize<double>(cc, chainLength, "chainMasses");
-                chainForces.initialize<double>(cc, chainLength, "chainForces");
-            }
-            chainMasses.upload(zeros);
-            chainForces.upload(zeros);
-        }
-        else {
-            std::vector<float> zeros(chainLength,0);
-            if (chainForces.isInitialized()) {
-                chainMasses.resize(chainLength);
-                chainForces.resize(chainLength);
-            }
-            else {
-                chainMasses.initialize<float>(cc, chainLength, "chainMasses");
-                chainForces.initialize<float>(cc, chainLength, "chainForces");
-            }
-            chainMasses.upload(zeros);
-            chainForces.upload(zeros);
-        }
+    int index = existing->second;
+    const NoseHooverChain& known = chains[index];
+    if (known.getThermostatedAtoms().size() != nhc.getThermostatedAtoms().size()) {
+        throw OpenMMException("Number of atoms changed. Cannot be handled by the same Nose-Hoover thermostat.");
     }
-    if (chainForces.getSize() < chainLength)
-        chainForces.resize(chainLength);
-    if (chainMasses.getSize() < chainLength)
-        chainMasses.resize(chainLength);
+    if (known.getThermostatedPairs().size() != nhc.getThermostatedPairs().size()) {
+        throw OpenMMException("Number of thermostated pairs changed. Cannot be handled by the same Nose-Hoover thermostat.");
+    }
+    if (known.getChainLength() != nhc.getChainLength() || known.getNumMultiTimeSteps() != nhc.getNumMultiTimeSteps() ||
+            known.getNumYoshidaSuzukiTimeSteps() != numYS || known.getNumDegreesOfFreedom() != nhc.getNumDegreesOfFreedom()) {
+        chains[index] = nhc;
+        chainsChanged = true;
+    }
+    return index;
+}
 
+void CommonIntegrateNoseHooverStepKernel::updateChains() {
+    if (!chainsChanged)
+        return;
+    chainsChanged = false;
+    int numChains = chains.size();
+
+    // Make sure every thermostat has a state of the right length, keeping any that were set or loaded from a checkpoint.
+
+    map<int, vector<mm_double2> > states;
+    downloadChainStates(states);
+    for (const NoseHooverChain& nhc : chains) {
+        int chainID = nhc.getChainID();
+        int chainLength = nhc.getChainLength();
+        if (nhc.getThermostatedAtoms().size() > 0 && (int) states[2*chainID].size() != chainLength)
+            states[2*chainID] = vector<mm_double2>(chainLength, mm_double2(0.0, 0.0));
+        if (nhc.getThermostatedPairs().size() > 0 && (int) states[2*chainID+1].size() != chainLength)
+            states[2*chainID+1] = vector<mm_double2>(chainLength, mm_double2(0.0, 0.0));
+    }
+    uploadChainStates(states);
+
+    // Build the concatenated lists of atoms and pairs, and the description of each chain.
+
+    vector<int> atoms, atomIndex, pairIndex;
+    vector<mm_int2> pairs;
+    vector<mm_int4> layout, steps;
+    vector<double> weights;
+    atomStart.clear();
+    pairStart.clear();
+    int maxEntries = 0;
+    for (int i = 0; i < numChains; i++) {
+        const NoseHooverChain& nhc = chains[i];
+        int chainID = nhc.getChainID();
+        atomStart.push_back(atoms.size());
+        pairStart.push_back(pairs.size());
+        for (int atom : nhc.getThermostatedAtoms()) {
+            atoms.push_back(atom);
+            atomIndex.push_back(i);
+        }
+        for (auto& pair : nhc.getThermostatedPairs()) {
+            pairs.push_back(mm_int2(pair.first, pair.second));
+            pairIndex.push_back(i);
+        }
+        int numAtoms = nhc.getThermostatedAtoms().size();
+        int numPairs = nhc.getThermostatedPairs().size();
+        maxEntries = max(maxEntries, max(numAtoms, numPairs));
+        layout.push_back(mm_int4(numAtoms > 0 ? stateOffset[2*chainID] : -1, numPairs > 0 ? stateOffset[2*chainID+1] : -1,
+                nhc.getChainLength(), nhc.getNumMultiTimeSteps()));
+        vector<double> ys = nhc.getYoshidaSuzukiWeights();
+        steps.push_back(mm_int4(nhc.getNumDegreesOfFreedom(), 3*numPairs, weights.size(), ys.size()));
+        weights.insert(weights.end(), ys.begin(), ys.end());
+    }
+    atomStart.push_back(atoms.size());
+    pairStart.push_back(pairs.size());
+    if (atoms.size() == 0) {
+        atoms.push_back(0);
+        atomIndex.push_back(0);
+    }
+    if (pairs.size() == 0) {
+        pairs.push_back(mm_int2(0, 0));
+        pairIndex.push_back(0);
+    }
+    chainAtoms.resize(atoms.size());
+    chainAtoms.upload(atoms);
+    chainAtomIndex.resize(atomIndex.size());
+    chainAtomIndex.upload(atomIndex);
+    chainAtomStart.resize(atomStart.size());
+    chainAtomStart.upload(atomStart);
+    chainPairs.resize(pairs.size());
+    chainPairs.upload(pairs);
+    chainPairIndex.resize(pairIndex.size());
+    chainPairIndex.upload(pairIndex);
+    chainPairStart.resize(pairStart.size());
+    chainPairStart.upload(pairStart);
+    chainLayout.resize(max(numChains, 1));
+    chainSteps.resize(max(numChains, 1));
+    if (numChains > 0) {
+        chainLayout.upload(layout);
+        chainSteps.upload(steps);
+    }
+    if (weights.size() == 0)
+        weights.push_back(1.0);
+    ysWeights.resize(weights.size());
+    ysWeights.upload(weights, true);
+
+    // Large chains are split between several thread blocks when computing the kinetic energy.
 
-    // N.B. We ignore the incoming kineticEnergy and grab it from the device buffer instead
-    if (nAtoms) {
-        if (!chainState.count(2*chainID))
-            chainState[2*chainID] = ComputeArray();
-        if (!chainState.at(2*chainID).isInitialized() || chainState.at(2*chainID).getSize() != chainLength) {
-            // We need to upload the Common array
-            if (useDouble) {
-                if (chainState.at(2*chainID).isInitialized())
-                    chainState.at(2*chainID).resize(chainLength);
-                else
-                    chainState.at(2*chainID).initialize<mm_double2>(cc, chainLength, "chainState" + std::to_string(2*chainID));
-                std::vector<mm_double2> zeros(chainLength, mm_double2(0.0, 0.0));
-                chainState.at(2*chainID).upload(zeros.data());
-            }
-            else {
-                if (chainState.at(2*chainID).isInitialized())
-                    chainState.at(2*chainID).resize(chainLength);
-                else
-                    chainState.at(2*chainID).initialize<mm_float2>(cc, chainLength, "chainState" + std::to_string(2*chainID));
-                std::vector<mm_float2> zeros(chainLength, mm_float2(0.0f, 0.0f));
-                chainState.at(2*chainID).upload(zeros.data());
-            }
-        }
-    }
+    int workGroupSize = std::min(cc.getMaxThreadBlockSize(), 512);
+    blocksPerChain = min(max((maxEntries+4*workGroupSize-1)/(4*workGroupSize), 1), 64);
+    partialKineticEnergy.resize(max(numChains, 1)*blocksPerChain);
+    vector<mm_double2> ones(max(numChains, 1), mm_double2(1.0, 1.0));
+    scaleFactors.resize(ones.size());
+    scaleFactors.upload(ones, true);
+    hostChainParams.resize(numChains);
+    chainParams.resize(max(numChains, 1));
+    chainParamsChanged = true;
+}
+
+void CommonIntegrateNoseHooverStepKernel::setChainParameters(const NoseHooverChain& nhc, int index) {
+    double kT = BOLTZ*nhc.getTemperature();
+    double relativeKT = BOLTZ*nhc.getRelativeTemperature();
+    float frequency = nhc.getCollisionFrequency();
+    float relativeFrequency = nhc.getRelativeCollisionFrequency();
+    mm_double4 params(kT, kT/(frequency*frequency), relativeKT, relativeKT/(relativeFrequency*relativeFrequency));
+    mm_double4& current = hostChainParams[index];
+    if (params.x != current.x || params.y != current.y || params.z != current.z || params.w != current.w) {
+        current = params;
+        chainParamsChanged = true;
+    }
+}
+
+void CommonIntegrateNoseHooverStepKernel::uploadChainParameters() {
+    if (!chainParamsChanged || hostChainParams.size() == 0)
+        return;
+    chainParamsChanged = false;
+    chainParams.upload(hostChainParams, true);
+}
 
-    if (nPairs) {
-        if (!chainState.count(2*chainID+1))
-            chainState[2*chainID+1] = ComputeArray();
-        if (!chainState.at(2*chainID+1).isInitialized() || chainState.at(2*chainID+1).getSize() != chainLength) {
-            // We need to upload the Common array
-            if (useDouble) {
-                if (chainState.at(2*chainID+1).isInitialized())
-                    chainState.at(2*chainID+1).resize(chainLength);
-                else
-                    chainState.at(2*chainID+1).initialize<mm_double2>(cc, chainLength, "chainState" + std::to_string(2*chainID+1));
-                std::vector<mm_double2> zeros(chainLength, mm_double2(0.0, 0.0));
-                chainState.at(2*chainID+1).upload(zeros.data());
-            }
-            else {
-                if (chainState.at(2*chainID+1).isInitialized())
-                    chainState.at(2*chainID+1).resize(chainLength);
-                else
-                    chainState.at(2*chainID+1).initialize<mm_float2>(cc, chainLength, "chainState" + std::to_string(2*chainID+1));
-                std::vector<mm_float2> zeros(chainLength, mm_float2(0.0f, 0.0f));
-                chainState.at(2*chainID+1).upload(zeros.data());
-            }
-        }
+void CommonIntegrateNoseHooverStepKernel::downloadChainStates(map<int, vector<mm_double2> >& states) const {
+    states.clear();
+    if (stateOffset.size() == 0)
+        return;
+    vector<mm_double2> allStates;
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        chainStates.download(allStates);
+    else {
+        vector<mm_float2> floatStates;
+        chainStates.download(floatStates);
+        for (mm_float2 s : floatStates)
+            allStates.push_back(mm_double2(s.x, s.y));
+    }
+    for (auto& offset : stateOffset) {
+        int length = stateLength.at(offset.first);
+        states[offset.first] = vector<mm_double2>(allStates.begin()+offset.second, allStates.begin()+offset.second+length);
     }
+}
 
-    if (!hasInitializedPropagateKernel) {
-        hasInitializedPropagateKernel = true;
-        propagateKernels[numYS]->addArg(); // ChainState
-        propagateKernels[numYS]->addArg(kineticEnergyBuffer);
-        propagateKernels[numYS]->addArg(scaleFactorBuffer);
-        propagateKernels[numYS]->addArg(chainMasses);
-        propagateKernels[numYS]->addArg(chainForces);
-        propagateKernels[numYS]->addArg(); // ChainType
-        propagateKernels[numYS]->addArg(chainLength);
-        propagateKernels[numYS]->addArg(numMTS);
-        propagateKernels[numYS]->addArg(); // numDoFs
-        propagateKernels[numYS]->addArg((float)timeStep);
-        propagateKernels[numYS]->addArg(); // kT
-        propagateKernels[numYS]->addArg(); // frequency
-    }
-
-    if (nAtoms) {
-        int chainType = 0;
-        double temperature = nhc.getTemperature();
-        float frequency = nhc.getCollisionFrequency();
-        double kT = BOLTZ * temperature;
-        int numDOFs = nhc.getNumDegreesOfFreedom();
-        propagateKernels[numYS]->setArg(0, chainState[2*chainID]);
-        propagateKernels[numYS]->setArg(5, chainType);
-        propagateKernels[numYS]->setArg(8, numDOFs);
-        if (useDouble) {
-            propagateKernels[numYS]->setArg(10, kT);
-        } else {
-            propagateKernels[numYS]->setArg(10, (float)kT);
-        }
-        propagateKernels[numYS]->setArg(11, frequency);
-        propagateKernels[numYS]->execute(1, 1);
-    }
-    if (nPairs) {
-        int chainType = 1;
-        double relativeTemperature = nhc.getRelativeTemperature();
-        float relativeFrequency = nhc.getRelativeCollisionFrequency();
-        double kT = BOLTZ * relativeTemperature;
-        int ndf = 3*nPairs;
-        propagateKernels[numYS]->setArg(0, chainState[2*chainID+1]);
-        propagateKernels[numYS]->setArg(5, chainType);
-        propagateKernels[numYS]->setArg(8, ndf);
-        if (useDouble) {
-            propagateKernels[numYS]->setArg(10, kT);
-        } else {
-            propagateKernels[numYS]->setArg(10, (float)kT);
-        }
-        propagateKernels[numYS]->setArg(11, relativeFrequency);
-        propagateKernels[numYS]->execute(1, 1);
+void CommonIntegrateNoseHooverStepKernel::uploadChainStates(const map<int, vector<mm_double2> >& states) {
+    stateOffset.clear();
+    stateLength.clear();
+    vector<mm_double2> allStates;
+    for (auto& state : states) {
+        stateOffset[state.first] = allStates.size();
+        stateLength[state.first] = state.second.size();
+        allStates.insert(allStates.end(), state.second.begin(), state.second.end());
     }
+    if (allStates.size() == 0)
+        allStates.push_back(mm_double2(0.0, 0.0));
+    chainStates.resize(allStates.size());
+    chainForces.resize(allStates.size());
+    chainStates.upload(allStates, true);
+}
+
+std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(ContextImpl& context, const NoseHooverChain &nhc, std::pair<double, double> kineticEnergies, double timeStep) {
+    // N.B. We ignore the incoming kineticEnergy and use the partial sums left on the device by computeMaskedKineticEnergy().
+    ContextSelector selector(cc);
+    int index = getChainIndex(nhc);
+    setChainParameters(nhc, index);
+    updateChains();
+    uploadChainParameters();
+    propagateChainsKernel->setArg(0, index);
+    propagateChainsKernel->setArg(1, index+1);
+    propagateChainsKernel->setArg(2, blocksPerChain);
+    propagateChainsKernel->setArg(11, (float) timeStep);
+    propagateChainsKernel->execute(1, 1);
     return {0, 0};
 }
 
@@ -5937,75 +6459,34 @@ double CommonIntegrateNoseHooverStepKernel::computeHeatBathEnergy(ContextImpl& c
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     int chainID = nhc.getChainID();
     int chainLength = nhc.getChainLength();
-
-    bool absChainIsValid = chainState.count(2*chainID) != 0 &&
-                           chainState[2*chainID].isInitialized() &&
-                           chainState[2*chainID].getSize() == chainLength;
-    bool relChainIsValid = chainState.count(2*chainID+1) != 0 &&
-                           chainState[2*chainID+1].isInitialized() &&
-                           chainState[2*chainID+1].getSize() == chainLength;
-
-    if (!absChainIsValid && !relChainIsValid) return 0.0;
-
-    if (!heatBathEnergy.isInitialized() || heatBathEnergy.getSize() == 0) {
-        if (useDouble) {
-            std::vector<double> one(1);
-            heatBathEnergy.initialize<double>(cc, 1, "heatBathEnergy");
-            heatBathEnergy.upload(one);
-        }
-        else {
-            std::vector<float> one(1);
-            heatBathEnergy.initialize<float>(cc, 1, "heatBathEnergy");
-            heatBathEnergy.upload(one);
-        }
-    }
-
+    bool absChainIsValid = stateLength.count(2*chainID) != 0 && stateLength[2*chainID] == chainLength;
+    bool relChainIsValid = stateLength.count(2*chainID+1) != 0 && stateLength[2*chainID+1] == chainLength;
+    if (!absChainIsValid && !relChainIsValid)
+        return 0.0;
     cc.clearBuffer(heatBathEnergy);
-
-    if(!hasInitializedHeatBathEnergyKernel) {
-        hasInitializedHeatBathEnergyKernel = true;
-        computeHeatBathEnergyKernel->addArg(heatBathEnergy);
-        computeHeatBathEnergyKernel->addArg(chainLength);
-        computeHeatBathEnergyKernel->addArg(); // numDOFs
-        computeHeatBathEnergyKernel->addArg(); // kT
-        computeHeatBathEnergyKernel->addArg(); // frequency
-        computeHeatBathEnergyKernel->addArg(); // chainstate
-    }
-
+    computeHeatBathEnergyKernel->setArg(1, chainLength);
     if (absChainIsValid) {
-        int numDOFs = nhc.getNumDegreesOfFreedom();
-        double temperature = nhc.getTemperature();
-        float frequency = nhc.getCollisionFrequency();
-        double kT = BOLTZ * temperature;
-
-        computeHeatBathEnergyKernel->setArg(2, numDOFs);
-        if (useDouble) {
+        double kT = BOLTZ*nhc.getTemperature();
+        computeHeatBathEnergyKernel->setArg(2, nhc.getNumDegreesOfFreedom());
+        if (useDouble)
             computeHeatBathEnergyKernel->setArg(3, kT);
-        } else {
-            computeHeatBathEnergyKernel->setArg(3, (float)kT);
-        }
-        computeHeatBathEnergyKernel->setArg(4, frequency);
-        computeHeatBathEnergyKernel->setArg(5, chainState[2*chainID]);
+        else
+            computeHeatBathEnergyKernel->setArg(3, (float) kT);
+        computeHeatBathEnergyKernel->setArg(4, (float) nhc.getCollisionFrequency());
+        computeHeatBathEnergyKernel->setArg(6, stateOffset[2*chainID]);
         computeHeatBathEnergyKernel->execute(1, 1);
     }
     if (relChainIsValid) {
-        int numDOFs = 3 * nhc.getThermostatedPairs().size();
-        double temperature = nhc.getRelativeTemperature();
-        float frequency = nhc.getRelativeCollisionFrequency();
-        double kT = BOLTZ * temperature;
-
-        computeHeatBathEnergyKernel->setArg(2, numDOFs);
-        if (useDouble) {
+        double kT = BOLTZ*nhc.getRelativeTemperature();
+        computeHeatBathEnergyKernel->setArg(2, (int) (3*nhc.getThermostatedPairs().size()));
+        if (useDouble)
             computeHeatBathEnergyKernel->setArg(3, kT);
-        } else {
-            computeHeatBathEnergyKernel->setArg(3, (float)kT);
-        }
-        computeHeatBathEnergyKernel->setArg(4, frequency);
-        computeHeatBathEnergyKernel->setArg(5, chainState[2*chainID+1]);
+        else
+            computeHeatBathEnergyKernel->setArg(3, (float) kT);
+        computeHeatBathEnergyKernel->setArg(4, (float) nhc.getRelativeCollisionFrequency());
+        computeHeatBathEnergyKernel->setArg(6, stateOffset[2*chainID+1]);
         computeHeatBathEnergyKernel->execute(1, 1);
     }
-
-
     void * pinnedBuffer = cc.getPinnedBuffer();
     heatBathEnergy.download(pinnedBuffer);
     if (useDouble)
@@ -6016,147 +6497,71 @@ double CommonIntegrateNoseHooverStepKernel::computeHeatBathEnergy(ContextImpl& c
 
 std::pair<double, double> CommonIntegrateNoseHooverStepKernel::computeMaskedKineticEnergy(ContextImpl& context, const NoseHooverChain &nhc, bool downloadValue) {
     ContextSelector selector(cc);
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
-    int chainID = nhc.getChainID();
-    const auto & nhcAtoms = nhc.getThermostatedAtoms();
-    const auto & nhcPairs = nhc.getThermostatedPairs();
-    int nAtoms = nhcAtoms.size();
-    int nPairs = nhcPairs.size();
-    if (nAtoms) {
-        if (!atomlists.count(chainID)) {
-            // We need to upload the Common array
-            atomlists[chainID] = ComputeArray();
-            atomlists[chainID].initialize<int>(cc, nAtoms, "atomlist" + std::to_string(chainID));
-            atomlists[chainID].upload(nhcAtoms);
-        }
-        if (atomlists[chainID].getSize() != nAtoms) {
-            throw OpenMMException("Number of atoms changed. Cannot be handled by the same Nose-Hoover thermostat.");
-        }
-    }
-    if (nPairs) {
-        if (!pairlists.count(chainID)) {
-            // We need to upload the Common array
-            pairlists[chainID] = ComputeArray();
-            pairlists[chainID].initialize<mm_int2>(cc, nPairs, "pairlist" + std::to_string(chainID));
-            std::vector<mm_int2> int2vec;
-            for(const auto &p : nhcPairs) int2vec.push_back(mm_int2(p.first, p.second));
-            pairlists[chainID].upload(int2vec);
-        }
-        if (pairlists[chainID].getSize() != nPairs) {
-            throw OpenMMException("Number of thermostated pairs changed. Cannot be handled by the same Nose-Hoover thermostat.");
-        }
-    }
-    if (!kineticEnergyBuffer.isInitialized() || kineticEnergyBuffer.getSize() == 0) {
-        if (useDouble) {
-            std::vector<mm_double2> zeros{{0,0}};
-            kineticEnergyBuffer.initialize<mm_double2>(cc, 1, "kineticEnergyBuffer");
-            kineticEnergyBuffer.upload(zeros);
-        }
-        else {
-            std::vector<mm_float2> zeros{{0,0}};
-            kineticEnergyBuffer.initialize<mm_float2>(cc, 1, "kineticEnergyBuffer");
-            kineticEnergyBuffer.upload(zeros);
-        }
-    }
-
+    int index = getChainIndex(nhc);
+    setChainParameters(nhc, index);
+    updateChains();
+    uploadChainParameters();
     int workGroupSize = std::min(cc.getMaxThreadBlockSize(), 512);
-    if (!hasInitializedKineticEnergyKernel) {
-        hasInitializedKineticEnergyKernel = true;
-        computeAtomsKineticEnergyKernel->addArg(energyBuffer);
-        computeAtomsKineticEnergyKernel->addArg(); // nAtoms
-        computeAtomsKineticEnergyKernel->addArg(cc.getVelm());
-        computeAtomsKineticEnergyKernel->addArg(); // atom list
-
-        computePairsKineticEnergyKernel->addArg(energyBuffer);
-        computePairsKineticEnergyKernel->addArg(); // nPairs
-        computePairsKineticEnergyKernel->addArg(cc.getVelm());
-        computePairsKineticEnergyKernel->addArg(); // pair list
-
-        reduceEnergyKernel->addArg(energyBuffer);
-        reduceEnergyKernel->addArg(kineticEnergyBuffer);
-        reduceEnergyKernel->addArg((int) energyBuffer.getSize());
-    }
-
-    cc.clearBuffer(energyBuffer);
-    if (nAtoms) {
-        computeAtomsKineticEnergyKernel->setArg(1, nAtoms);
-        computeAtomsKineticEnergyKernel->setArg(3, atomlists[chainID]);
-        computeAtomsKineticEnergyKernel->execute(nAtoms);
-    }
-    if (nPairs) {
-        computePairsKineticEnergyKernel->setArg(1, nPairs);
-        computePairsKineticEnergyKernel->setArg(3, pairlists[chainID]);
-        computePairsKineticEnergyKernel->execute(nPairs);
-    }
-    reduceEnergyKernel->execute(workGroupSize, workGroupSize);
-
+    computeChainKineticEnergiesKernel->setArg(0, index);
+    computeChainKineticEnergiesKernel->setArg(1, index+1);
+    computeChainKineticEnergiesKernel->setArg(2, blocksPerChain);
+    computeChainKineticEnergiesKernel->execute(blocksPerChain*workGroupSize, workGroupSize);
     std::pair<double, double> KEs = {0, 0};
     if (downloadValue) {
-        if (useDouble) {
-            mm_double2 tmp;
-            kineticEnergyBuffer.download(&tmp);
-            KEs.first = tmp.x;
-            KEs.second = tmp.y;
+        if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+            vector<mm_double2> energy;
+            partialKineticEnergy.download(energy);
+            for (int i = 0; i < blocksPerChain; i++) {
+                KEs.first += energy[index*blocksPerChain+i].x;
+                KEs.second += energy[index*blocksPerChain+i].y;
+            }
         }
         else {
-            mm_float2 tmp;
-            kineticEnergyBuffer.download(&tmp);
-            KEs.first = tmp.x;
-            KEs.second = tmp.y;
+            vector<mm_float2> energy;
+            partialKineticEnergy.download(energy);
+            for (int i = 0; i < blocksPerChain; i++) {
+                KEs.first += energy[index*blocksPerChain+i].x;
+                KEs.second += energy[index*blocksPerChain+i].y;
+            }
         }
     }
     return KEs;
 }
 
 void CommonIntegrateNoseHooverStepKernel::scaleVelocities(ContextImpl& context, const NoseHooverChain &nhc, std::pair<double, double> scaleFactor) {
-    // For now we assume that the atoms and pairs info is valid, because compute{Atoms|Pairs}KineticEnergy must have been
-    // called before this kernel.  If that ever ceases to be true, some sanity checks are needed here.
-
-    int chainID = nhc.getChainID();
-    int nAtoms = nhc.getThermostatedAtoms().size();
-    int nPairs = nhc.getThermostatedPairs().size();
-    if (!hasInitializedScaleVelocitiesKernel) {
-        hasInitializedScaleVelocitiesKernel = true;
-        scaleAtomsVelocitiesKernel->addArg(scaleFactorBuffer);
-        scaleAtomsVelocitiesKernel->addArg(); // nAtoms
-        scaleAtomsVelocitiesKernel->addArg(cc.getVelm());
-        scaleAtomsVelocitiesKernel->addArg(); // atom list
-
-        scalePairsVelocitiesKernel->addArg(scaleFactorBuffer);
-        scalePairsVelocitiesKernel->addArg(); // nPairs
-        scalePairsVelocitiesKernel->addArg(cc.getVelm());
-        scalePairsVelocitiesKernel->addArg(); // pair list
-    }
-    if (nAtoms) {
-        scaleAtomsVelocitiesKernel->setArg(1, nAtoms);
-        scaleAtomsVelocitiesKernel->setArg(3, atomlists[chainID]);
-        scaleAtomsVelocitiesKernel->execute(nAtoms);
-    }
-    if (nPairs) {
-        scalePairsVelocitiesKernel->setArg(1, nPairs);
-        scalePairsVelocitiesKernel->setArg(3, pairlists[chainID]);
-        scalePairsVelocitiesKernel->execute(nPairs);
-    }
+    // The scale factors were left on the device by propagateChain(), so the ones passed in are ignored.
+    ContextSelector selector(cc);
+    int index = getChainIndex(nhc);
+    updateChains();
+    int numAtoms = atomStart[index+1]-atomStart[index];
+    int numPairs = pairStart[index+1]-pairStart[index];
+    if (numAtoms+numPairs == 0)
+        return;
+    scaleChainVelocitiesKernel->setArg(0, atomStart[index]);
+    scaleChainVelocitiesKernel->setArg(1, atomStart[index+1]);
+    scaleChainVelocitiesKernel->setArg(2, pairStart[index]);
+    scaleChainVelocitiesKernel->setArg(3, pairStart[index+1]);
+    scaleChainVelocitiesKernel->execute(std::max(numAtoms, numPairs));
 }
 
 void CommonIntegrateNoseHooverStepKernel::createCheckpoint(ContextImpl& context, ostream& stream) const {
     ContextSelector selector(cc);
-    int numChains = chainState.size();
+    map<int, vector<mm_double2> > states;
+    downloadChainStates(states);
+    int numChains = states.size();
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     stream.write((char*) &numChains, sizeof(int));
-    for (auto& state : chainState){
+    for (auto& state : states) {
         int chainID = state.first;
-        int chainLength = state.second.getSize();
+        int chainLength = state.second.size();
         stream.write((char*) &chainID, sizeof(int));
         stream.write((char*) &chainLength, sizeof(int));
-        if (useDouble) {
-            vector<mm_double2> stateVec;
-            state.second.download(stateVec);
-            stream.write((char*) stateVec.data(), sizeof(mm_double2)*chainLength);
-        }
+        if (useDouble)
+            stream.write((char*) state.second.data(), sizeof(mm_double2)*chainLength);
         else {
             vector<mm_float2> stateVec;
-            state.second.download(stateVec);
+            for (mm_double2 s : state.second)
+                stateVec.push_back(mm_float2((float) s.x, (float) s.y));
             stream.write((char*) stateVec.data(), sizeof(mm_float2)*chainLength);
         }
     }
@@ -6167,80 +6572,54 @@ void CommonIntegrateNoseHooverStepKernel::loadCheckpoint(ContextImpl& context, i
     int numChains;
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     stream.read((char*) &numChains, sizeof(int));
-    chainState.clear();
+    map<int, vector<mm_double2> > states;
     for (int i = 0; i < numChains; i++) {
         int chainID, chainLength;
         stream.read((char*) &chainID, sizeof(int));
         stream.read((char*) &chainLength, sizeof(int));
+        vector<mm_double2>& state = states[chainID];
         if (useDouble) {
-            chainState[chainID] = ComputeArray();
-            chainState[chainID].initialize<mm_double2>(cc, chainLength, "chainState" + to_string(chainID));
-            vector<mm_double2> stateVec(chainLength);
-            stream.read((char*) &stateVec[0], sizeof(mm_double2)*chainLength);
-            chainState[chainID].upload(stateVec);
+            state.resize(chainLength);
+            stream.read((char*) state.data(), sizeof(mm_double2)*chainLength);
         }
         else {
-            chainState[chainID] = ComputeArray();
-            chainState[chainID].initialize<mm_float2>(cc, chainLength, "chainState" + to_string(chainID));
             vector<mm_float2> stateVec(chainLength);
-            stream.read((char*) &stateVec[0], sizeof(mm_float2)*chainLength);
-            chainState[chainID].upload(stateVec);
+            stream.read((char*) stateVec.data(), sizeof(mm_float2)*chainLength);
+            for (mm_float2 s : stateVec)
+                state.push_back(mm_double2(s.x, s.y));
         }
     }
+    uploadChainStates(states);
+    chainsChanged = true;
 }
 
 void CommonIntegrateNoseHooverStepKernel::getChainStates(ContextImpl& context, vector<vector<double> >& positions, vector<vector<double> >& velocities) const {
     ContextSelector selector(cc);
-    int numChains = chainState.size();
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
+    map<int, vector<mm_double2> > states;
+    downloadChainStates(states);
+    int numChains = (states.size() == 0 ? 0 : states.rbegin()->first+1);
     positions.clear();
     velocities.clear();
     positions.resize(numChains);
     velocities.resize(numChains);
-    for (int i = 0; i < numChains; i++) {
-        const ComputeArray& state = chainState.at(i);
-        if (useDouble) {
-            vector<mm_double2> stateVec;
-            state.download(stateVec);
-            for (int j = 0; j < stateVec.size(); j++) {
-                positions[i].push_back(stateVec[j].x);
-                velocities[i].push_back(stateVec[j].y);
-            }
-        }
-        else {
-            vector<mm_float2> stateVec;
-            state.download(stateVec);
-            for (int j = 0; j < stateVec.size(); j++) {
-                positions[i].push_back((float) stateVec[j].x);
-                velocities[i].push_back((float) stateVec[j].y);
-            }
+    for (auto& state : states) {
+        for (mm_double2 s : state.second) {
+            positions[state.first].push_back(s.x);
+            velocities[state.first].push_back(s.y);
         }
     }
 }
 
 void CommonIntegrateNoseHooverStepKernel::setChainStates(ContextImpl& context, const vector<vector<double> >& positions, const vector<vector<double> >& velocities) {
     ContextSelector selector(cc);
-    int numChains = positions.size();
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
-    chainState.clear();
-    for (int i = 0; i < numChains; i++) {
-        int chainLength = positions[i].size();
-        chainState[i] = ComputeArray();
-        if (useDouble) {
-            chainState[i].initialize<mm_double2>(cc, chainLength, "chainState"+cc.intToString(i));
-            vector<mm_double2> stateVec;
-            for (int j = 0; j < chainLength; j++)
-                stateVec.push_back(mm_double2(positions[i][j], velocities[i][j]));
-            chainState[i].upload(stateVec);
-        }
-        else {
-            chainState[i].initialize<mm_float2>(cc, chainLength, "chainState"+cc.intToString(i));
-            vector<mm_float2> stateVec;
-            for (int j = 0; j < chainLength; j++)
-                stateVec.push_back(mm_float2((float) positions[i][j], (float) velocities[i][j]));
-            chainState[i].upload(stateVec);
-        }
+    map<int, vector<mm_double2> > states;
+    for (int i = 0; i < positions.size(); i++) {
+        vector<mm_double2>& state = states[i];
+        for (int j = 0; j < positions[i].size(); j++)
+            state.push_back(mm_double2(positions[i][j], velocities[i][j]));
     }
+    uploadChainStates(states);
+    chainsChanged = true;
 }
 
 void CommonIntegrateBrownianStepKernel::initialize(const System& system, const BrownianIntegrator& integrator) {
@@ -6328,6 +6707,50 @@ double CommonIntegrateBrownianStepKernel::computeKineticEnergy(ContextImpl& cont
     return cc.getIntegrationUtilities().computeKineticEnergy(0);
 }
 
+/**
+ * Create the array a variable step size integrator uses to record the step it has taken.  The first element
+ * holds the size of the step, the number of steps taken, and whether the target time has been reached.  The
+ * second holds the size of the last step that was taken, and the step size the error control selected for it
+ * before it was limited to the target time.
+ */
+static void initializeStepState(ComputeContext& cc, ComputeArray& stepState) {
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+        stepState.initialize<mm_double4>(cc, 2, "variableStepState");
+        stepState.upload(vector<mm_double4>(2, mm_double4(0, 0, 0, 0)));
+    }
+    else {
+        stepState.initialize<mm_float4>(cc, 2, "variableStepState");
+        stepState.upload(vector<mm_float4>(2, mm_float4(0, 0, 0, 0)));
+    }
+}
+
+/**
+ * Wait for the asynchronous download of the record a variable step size integrator keeps of the step it took,
+ * and update the time and step count to match.  This returns the size of the step that was taken, and stores
+ * the step size selected by the error control into selectedStepSize.
+ */
+static double finishVariableStep(ComputeContext& cc, ComputeEvent& event, double maxTime, double& selectedStepSize) {
+    event->wait();
+    mm_double4 state[2];
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+        mm_double4* pinned = (mm_double4*) cc.getPinnedBuffer();
+        state[0] = pinned[0];
+        state[1] = pinned[1];
+    }
+    else {
+        mm_float4* pinned = (mm_float4*) cc.getPinnedBuffer();
+        for (int i = 0; i < 2; i++)
+            state[i] = mm_double4(pinned[i].x, pinned[i].y, pinned[i].z, pinned[i].w);
+    }
+    if (state[0].z != 0)
+        cc.setTime(maxTime); // Avoid round-off error
+    else
+        cc.setTime(cc.getTime()+state[0].x);
+    cc.setStepCount(cc.getStepCount()+(int) state[0].y);
+    selectedStepSize = state[1].y;
+    return state[1].x;
+}
+
 void CommonIntegrateVariableVerletStepKernel::initialize(const System& system, const VariableVerletIntegrator& integrator) {
     cc.initializeContexts();
     ContextSelector selector(cc);
@@ -6336,13 +6759,16 @@ void CommonIntegrateVariableVerletStepKernel::initialize(const System& system, c
     kernel2 = program->createKernel("integrateVerletPart2");
     selectSizeKernel = program->createKernel("selectVerletStepSize");
     blockSize = min(256, system.getNumParticles());
+    initializeStepState(cc, stepState);
+    event = cc.createEvent();
 }
 
-double CommonIntegrateVariableVerletStepKernel::execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime) {
+double CommonIntegrateVariableVerletStepKernel::execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime, int maxSteps) {
     ContextSelector selector(cc);
     IntegrationUtilities& integration = cc.getIntegrationUtilities();
     int numAtoms = cc.getNumAtoms();
     int paddedNumAtoms = cc.getPaddedNumAtoms();
+    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     if (!hasInitializedKernels) {
         hasInitializedKernels = true;
         kernel1->addArg(numAtoms);
@@ -6363,65 +6789,66 @@ double CommonIntegrateVariableVerletStepKernel::execute(ContextImpl& context, co
             kernel2->addArg(cc.getPosqCorrection());
         selectSizeKernel->addArg(numAtoms);
         selectSizeKernel->addArg(paddedNumAtoms);
-        selectSizeKernel->addArg();
-        selectSizeKernel->addArg();
-        selectSizeKernel->addArg(cc.getIntegrationUtilities().getStepSize());
+        for (int i = 0; i < 4; i++)
+            selectSizeKernel->addArg();
+        selectSizeKernel->addArg(integration.getStepSize());
+        selectSizeKernel->addArg(stepState);
         selectSizeKernel->addArg(cc.getVelm());
         selectSizeKernel->addArg(cc.getLongForceBuffer());
     }
-
-    // Select the step size to use.
-
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
-    double maxStepSize = maxTime-cc.getTime();
-    if (integrator.getMaximumStepSize() > 0)
-        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
-    float maxStepSizeFloat = (float) maxStepSize;
+    double maxStepSize = (integrator.getMaximumStepSize() > 0 ? integrator.getMaximumStepSize() : numeric_limits<double>::infinity());
+    double lastStepSize = integrator.getStepSize();
     if (useDouble) {
         selectSizeKernel->setArg(2, maxStepSize);
         selectSizeKernel->setArg(3, integrator.getErrorTolerance());
     }
     else {
-        selectSizeKernel->setArg(2, maxStepSizeFloat);
+        selectSizeKernel->setArg(2, (float) maxStepSize);
         selectSizeKernel->setArg(3, (float) integrator.getErrorTolerance());
     }
-    selectSizeKernel->execute(blockSize, blockSize);
+    selectSizeKernel->setArg(5, 1);
+    while (maxSteps > 0 && maxTime > cc.getTime()) {
+        // Forces may depend on the time and step count, so those must be current before each step.  The
+        // step size is selected on the device, which records how far the simulation advanced.  Download
+        // that record asynchronously so the integration kernels can run while we wait for it.
+
+        context.updateContextState();
+        context.calcForcesAndEnergy(true, false, integrator.getIntegrationForceGroups());
+        double remainingTime = maxTime-cc.getTime();
+        if (useDouble)
+            selectSizeKernel->setArg(4, remainingTime);
+        else
+            selectSizeKernel->setArg(4, (float) remainingTime);
+        selectSizeKernel->execute(blockSize, blockSize);
+        stepState.download(cc.getPinnedBuffer(), false);
+        event->enqueue();
 
-    // Call the first integration kernel.
+        // Call the first integration kernel.
 
-    kernel1->execute(numAtoms);
+        kernel1->execute(numAtoms);
 
-    // Apply constraints.
+        // Apply constraints.
 
-    integration.applyConstraints(integrator.getConstraintTolerance());
+        integration.applyConstraints(integrator.getConstraintTolerance());
 
-    // Call the second integration kernel.
+        // Call the second integration kernel.
 
-    kernel2->execute(numAtoms);
-    integration.computeVirtualSites();
-    
-    // Reduce UI lag.
-    
-#ifdef WIN32
-    cc.flushQueue();
-#endif
+        kernel2->execute(numAtoms);
+        integration.computeVirtualSites();
 
-    // Update the time and step count.
+        // Update the time and step count.
 
-    double dt = cc.getIntegrationUtilities().getLastStepSize();
-    double time = cc.getTime()+dt;
-    if (useDouble) {
-        if (dt == maxStepSize)
-            time = maxTime; // Avoid round-off error
-    }
-    else {
-        if (dt == maxStepSizeFloat)
-            time = maxTime; // Avoid round-off error
+        lastStepSize = finishVariableStep(cc, event, maxTime, selectedStepSize);
+        maxSteps--;
+
+        // Reduce UI lag.
+
+#ifdef WIN32
+        cc.flushQueue();
+#endif
+        cc.reorderAtoms();
     }
-    cc.setTime(time);
-    cc.setStepCount(cc.getStepCount()+1);
-    cc.reorderAtoms();
-    return dt;
+    return lastStepSize;
 }
 
 double CommonIntegrateVariableVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VariableVerletIntegrator& integrator) {
@@ -6439,9 +6866,11 @@ void CommonIntegrateVariableLangevinStepKernel::initialize(const System& system,
     params.initialize(cc, 3, cc.getUseDoublePrecision() || cc.getUseMixedPrecision() ? sizeof(double) : sizeof(float), "langevinParams");
     blockSize = min(256, system.getNumParticles());
     blockSize = max(blockSize, (int) params.getSize());
+    initializeStepState(cc, stepState);
+    event = cc.createEvent();
 }
 
-double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) {
+double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime, int maxSteps) {
     ContextSelector selector(cc);
     IntegrationUtilities& integration = cc.getIntegrationUtilities();
     int numAtoms = cc.getNumAtoms();
@@ -6467,20 +6896,16 @@ double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context,
             kernel2->addArg(cc.getPosqCorrection());
         selectSizeKernel->addArg(numAtoms);
         selectSizeKernel->addArg(paddedNumAtoms);
-        for (int i = 0; i < 4; i++)
+        for (int i = 0; i < 6; i++)
             selectSizeKernel->addArg();
         selectSizeKernel->addArg(integration.getStepSize());
+        selectSizeKernel->addArg(stepState);
         selectSizeKernel->addArg(cc.getVelm());
         selectSizeKernel->addArg(cc.getLongForceBuffer());
         selectSizeKernel->addArg(params);
     }
-
-    // Select the step size to use.
-
-    double maxStepSize = maxTime-cc.getTime();
-    if (integrator.getMaximumStepSize() > 0)
-        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
-    float maxStepSizeFloat = (float) maxStepSize;
+    double maxStepSize = (integrator.getMaximumStepSize() > 0 ? integrator.getMaximumStepSize() : numeric_limits<double>::infinity());
+    double lastStepSize = integrator.getStepSize();
     if (useDouble) {
         selectSizeKernel->setArg(2, maxStepSize);
         selectSizeKernel->setArg(3, integrator.getErrorTolerance());
@@ -6488,49 +6913,55 @@ double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context,
         selectSizeKernel->setArg(5, BOLTZ*integrator.getTemperature());
     }
     else {
-        selectSizeKernel->setArg(2, maxStepSizeFloat);
+        selectSizeKernel->setArg(2, (float) maxStepSize);
         selectSizeKernel->setArg(3, (float) integrator.getErrorTolerance());
         selectSizeKernel->setArg(4, (float) integrator.getFriction());
         selectSizeKernel->setArg(5, (float) (BOLTZ*integrator.getTemperature()));
     }
-    selectSizeKernel->execute(blockSize, blockSize);
+    selectSizeKernel->setArg(7, 1);
+    while (maxSteps > 0 && maxTime > cc.getTime()) {
+        // Forces may depend on the time and step count, so those must be current before each step.  The
+        // step size is selected on the device, which records how far the simulation advanced.  Download
+        // that record asynchronously so the integration kernels can run while we wait for it.
+
+        context.updateContextState();
+        context.calcForcesAndEnergy(true, false, integrator.getIntegrationForceGroups());
+        double remainingTime = maxTime-cc.getTime();
+        if (useDouble)
+            selectSizeKernel->setArg(6, remainingTime);
+        else
+            selectSizeKernel->setArg(6, (float) remainingTime);
+        selectSizeKernel->execute(blockSize, blockSize);
+        stepState.download(cc.getPinnedBuffer(), false);
+        event->enqueue();
 
-    // Call the first integration kernel.
+        // Call the first integration kernel.
 
-    kernel1->setArg(8, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
-    kernel1->execute(numAtoms);
+        kernel1->setArg(8, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
+        kernel1->execute(numAtoms);
 
-    // Apply constraints.
+        // Apply constraints.
 
-    integration.applyConstraints(integrator.getConstraintTolerance());
+        integration.applyConstraints(integrator.getConstraintTolerance());
 
-    // Call the second integration kernel.
+        // Call the second integration kernel.
 
-    kernel2->execute(numAtoms);
-    integration.computeVirtualSites();
-    
-    // Reduce UI lag.
-    
-#ifdef WIN32
-    cc.flushQueue();
-#endif
+        kernel2->execute(numAtoms);
+        integration.computeVirtualSites();
 
-    // Update the time and step count.
+        // Update the time and step count.
 
-    double dt = cc.getIntegrationUtilities().getLastStepSize();
-    double time = cc.getTime()+dt;
-    if (useDouble) {
-        if (dt == maxStepSize)
-            time = maxTime; // Avoid round-off error
-    }
-    else {
-        if (dt == maxStepSizeFloat)
-            time = maxTime; // Avoid round-off error
+        lastStepSize = finishVariableStep(cc, event, maxTime, selectedStepSize);
+        maxSteps--;
+
+        // Reduce UI lag.
+
+#ifdef WIN32
+        cc.flushQueue();
+#endif
+        cc.reorderAtoms();
     }
-    cc.setTime(time);
-    cc.setStepCount(cc.getStepCount()+1);
-    cc.reorderAtoms();
-    return dt;
+    return lastStepSize;
 }
 
 double CommonIntegrateVariableLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const VariableLangevinIntegrator& integrator) {
@@ -6861,13 +7292,23 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
             }
         }
         
-        // Identify steps that can be merged into a single kernel.
+        // Identify steps that can be merged into a single kernel.  Any chain of consecutive per-DOF steps
+        // can be merged, as long as every step that uses the forces or energy sees the same values that
+        // were computed before the first step of the chain.
         
-        for (int step = 1; step < numSteps; step++) {
-            if (invalidatesForces[step-1] || forceGroupFlags[step] != forceGroupFlags[step-1])
-                continue;
-            if (stepType[step-1] == CustomIntegrator::ComputePerDof && stepType[step] == CustomIntegrator::ComputePerDof)
-                merged[step] = true;
+        int chainStart = 0;
+        bool chainInvalidatesForces = false;
+        for (int step = 0; step < numSteps; step++) {
+            if (step > 0 && stepType[step-1] == CustomIntegrator::ComputePerDof && stepType[step] == CustomIntegrator::ComputePerDof) {
+                if (!(needsForces[step] || needsEnergy[step]) || (!chainInvalidatesForces && forceGroupFlags[step] == forceGroupFlags[chainStart]))
+                    merged[step] = true;
+            }
+            if (!merged[step]) {
+                chainStart = step;
+                chainInvalidatesForces = false;
+            }
+            if (invalidatesForces[step])
+                chainInvalidatesForces = true;
         }
         for (int step = numSteps-1; step > 0; step--)
             if (merged[step]) {
@@ -6887,6 +7328,9 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
                 for (int i = 0; i < perDofValues.size(); i++)
                     compute << tempType<<" perDof"<<cc.intToString(i)<<" = convertToTempType3(perDofValues"<<cc.intToString(i)<<"[index]);\n";
                 int numGaussian = 0, numUniform = 0;
+                int lastPositionStep = -1;
+                bool storeVelocity = false;
+                set<int> storePerDof;
                 for (int j = step; j < numSteps && (j == step || merged[j]); j++) {
                     numGaussian += numAtoms*usesVariable(expression[j][0], "gaussian");
                     numUniform += numAtoms*usesVariable(expression[j][0], "uniform");
@@ -6896,25 +7340,16 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
                     if (numUniform > 0)
                         compute << "float4 uniform = uniformValues[uniformIndex+index];\n";
                     compute << createPerDofComputation(stepType[j] == CustomIntegrator::ComputePerDof ? variable[j] : "", expression[j][0], integrator, forceName[j], energyName[j], functionList, functionNames);
-                    if (variable[j] == "x") {
-                        if (storePosAsDelta[j]) {
-                            if (cc.getSupportsDoublePrecision())
-                                compute << "posDelta[index] = convertFromDouble4(position-loadPos(posq, posqCorrection, index));\n";
-                            else
-                                compute << "posDelta[index] = position-posq[index];\n";
+                    if (stepType[j] == CustomIntegrator::ComputePerDof) {
+                        if (variable[j] == "x")
+                            lastPositionStep = j;
+                        else if (variable[j] == "v")
+                            storeVelocity = true;
+                        else {
+                            for (int i = 0; i < integrator.getNumPerDofVariables(); i++)
+                                if (variable[j] == integrator.getPerDofVariableName(i))
+                                    storePerDof.insert(i);
                         }
-                        else
-                            compute << "storePos(posq, posqCorrection, index, position);\n";
-                    }
-                    else if (variable[j] == "v") {
-                        if (cc.getSupportsDoublePrecision())
-                            compute << "velm[index] = convertFromDouble4(velocity);\n";
-                        else
-                            compute << "velm[index] = velocity;\n";
-                    }
-                    else {
-                        for (int i = 0; i < perDofValues.size(); i++)
-                            compute << "perDofValues"<<cc.intToString(i)<<"[index] = make_"<<perDofType<<"(perDof"<<cc.intToString(i)<<".x, perDof"<<cc.intToString(i)<<".y, perDof"<<cc.intToString(i)<<".z, 0);\n";
                     }
                     if (numGaussian > 0)
                         compute << "gaussianIndex += NUM_ATOMS;\n";
@@ -6922,6 +7357,28 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
                         compute << "uniformIndex += NUM_ATOMS;\n";
                     compute << "}\n";
                 }
+
+                // The intermediate values stay in registers.  Each variable that was modified only needs to
+                // be written to global memory once, at the end.
+
+                if (lastPositionStep != -1) {
+                    if (storePosAsDelta[lastPositionStep]) {
+                        if (cc.getSupportsDoublePrecision())
+                            compute << "posDelta[index] = convertFromDouble4(position-loadPos(posq, posqCorrection, index));\n";
+                        else
+                            compute << "posDelta[index] = position-posq[index];\n";
+                    }
+                    else
+                        compute << "storePos(posq, posqCorrection, index, position);\n";
+                }
+                if (storeVelocity) {
+                    if (cc.getSupportsDoublePrecision())
+                        compute << "velm[index] = convertFromDouble4(velocity);\n";
+                    else
+                        compute << "velm[index] = velocity;\n";
+                }
+                for (int i : storePerDof)
+                    compute << "perDofValues"<<cc.intToString(i)<<"[index] = make_"<<perDofType<<"(perDof"<<cc.intToString(i)<<".x, perDof"<<cc.intToString(i)<<".y, perDof"<<cc.intToString(i)<<".z, 0);\n";
                 map<string, string> replacements;
                 replacements["COMPUTE_STEP"] = compute.str();
                 stringstream args;
@@ -6968,6 +7425,8 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
                     kernel->addArg(sumBuffer);
                     kernel->addArg(summedValue);
                     kernel->addArg(numAtoms);
+                    kernel->addArg(globalValues);
+                    kernel->addArg(stepTarget[step].type == VARIABLE ? stepTarget[step].variableIndex : -1);
                 }
             }
             else if (stepType[step] == CustomIntegrator::ConstrainPositions) {
@@ -7063,6 +7522,8 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
         sumKineticEnergyKernel->addArg(sumBuffer);
         sumKineticEnergyKernel->addArg(summedValue);
         sumKineticEnergyKernel->addArg(numAtoms);
+        sumKineticEnergyKernel->addArg(globalValues);
+        sumKineticEnergyKernel->addArg(-1);
 
         // Delete the custom functions.
 
@@ -7196,6 +7657,7 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
         if (needsGlobals[step] && !deviceGlobalsAreCurrent) {
             // Upload the global values to the device.
 
+            downloadGlobalsFromDevice();
             globalValues.upload(localGlobalValues, true);
             deviceGlobalsAreCurrent = true;
         }
@@ -7213,6 +7675,8 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
             kernels[step][0]->execute(numAtoms, 128);
         }
         else if (stepType[step] == CustomIntegrator::ComputeGlobal) {
+            if (stepReadsGlobalsOnDevice(step))
+                downloadGlobalsFromDevice();
             expressionSet.setVariable(uniformVariableIndex, SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber());
             expressionSet.setVariable(gaussianVariableIndex, SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
             expressionSet.setVariable(stepEnergyVariableIndex[step], energy);
@@ -7231,7 +7695,16 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
             cc.clearBuffer(sumBuffer);
             kernels[step][0]->execute(numAtoms, 128);
             kernels[step][1]->execute(sumWorkGroupSize, sumWorkGroupSize);
-            if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+            if (stepTarget[step].type == VARIABLE) {
+                // The sum kernel stored the value directly into the global variable on the device.
+                // Only download it if something on the host actually needs it.
+
+                CustomIntegrator::ComputationType type;
+                string variable, expression;
+                integrator.getComputationStep(step, type, variable, expression);
+                globalsOnDevice[stepTarget[step].variableIndex] = variable;
+            }
+            else if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
                 double value;
                 summedValue.download(&value);
                 recordGlobalValue(value, stepTarget[step], integrator);
@@ -7294,6 +7767,8 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
 }
 
 bool CommonIntegrateCustomStepKernel::evaluateCondition(int step) {
+    if (stepReadsGlobalsOnDevice(step))
+        downloadGlobalsFromDevice();
     expressionSet.setVariable(uniformVariableIndex, SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber());
     expressionSet.setVariable(gaussianVariableIndex, SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
     expressionSet.setVariable(stepEnergyVariableIndex[step], energy);
@@ -7348,6 +7823,7 @@ void CommonIntegrateCustomStepKernel::recordGlobalValue(double value, GlobalTarg
             break;
         case VARIABLE:
         case PARAMETER:
+            globalsOnDevice.erase(target.variableIndex);
             expressionSet.setVariable(target.variableIndex, value);
             localGlobalValues[target.variableIndex] = value;
             deviceGlobalsAreCurrent = false;
@@ -7375,6 +7851,16 @@ void CommonIntegrateCustomStepKernel::getGlobalVariables(ContextImpl& context, v
     values.resize(numGlobalVariables);
     for (int i = 0; i < numGlobalVariables; i++)
         values[i] = localGlobalValues[globalVariableIndex[i]];
+    if (globalsOnDevice.size() > 0) {
+        // Some values were computed by sums and have not been downloaded yet.
+
+        ContextSelector selector(cc);
+        vector<double> deviceValues;
+        downloadGlobalValues(deviceValues);
+        for (int i = 0; i < numGlobalVariables; i++)
+            if (globalsOnDevice.find(globalVariableIndex[i]) != globalsOnDevice.end())
+                values[i] = deviceValues[globalVariableIndex[i]];
+    }
 }
 
 void CommonIntegrateCustomStepKernel::setGlobalVariables(ContextImpl& context, const vector<double>& values) {
@@ -7390,9 +7876,40 @@ void CommonIntegrateCustomStepKernel::setGlobalVariables(ContextImpl& context, c
         localGlobalValues[globalVariableIndex[i]] = values[i];
         expressionSet.setVariable(globalVariableIndex[i], values[i]);
     }
+    globalsOnDevice.clear();
     deviceGlobalsAreCurrent = false;
 }
 
+void CommonIntegrateCustomStepKernel::downloadGlobalValues(vector<double>& values) const {
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        globalValues.download(values);
+    else {
+        vector<float> floatValues;
+        globalValues.download(floatValues);
+        values.assign(floatValues.begin(), floatValues.end());
+    }
+}
+
+void CommonIntegrateCustomStepKernel::downloadGlobalsFromDevice() {
+    if (globalsOnDevice.size() == 0)
+        return;
+    vector<double> values;
+    downloadGlobalValues(values);
+    for (auto& global : globalsOnDevice) {
+        localGlobalValues[global.first] = values[global.first];
+        expressionSet.setVariable(global.first, values[global.first]);
+    }
+    globalsOnDevice.clear();
+}
+
+bool CommonIntegrateCustomStepKernel::stepReadsGlobalsOnDevice(int step) const {
+    for (auto& expression : globalExpressions[step])
+        for (auto& global : globalsOnDevice)
+            if (expression.getVariables().find(global.second) != expression.getVariables().end())
+                return true;
+    return false;
+}
+
 void CommonIntegrateCustomStepKernel::getPerDofVariable(ContextImpl& context, int variable, vector<Vec3>& values) const {
     ContextSelector selector(cc);
     values.resize(perDofValues[variable].getSize());
@@ -7513,6 +8030,7 @@ void CommonCalcRMSDForceKernel::initialize(const System& system, const RMSDForce
     kernel1->addArg(referencePos);
     kernel1->addArg(particles);
     kernel1->addArg(buffer);
+    kernel1->addArg();
     kernel2->addArg();
     kernel2->addArg(cc.getPaddedNumAtoms());
     kernel2->addArg(cc.getPosq());
@@ -7520,6 +8038,7 @@ void CommonCalcRMSDForceKernel::initialize(const System& system, const RMSDForce
     kernel2->addArg(particles);
     kernel2->addArg(buffer);
     kernel2->addArg(cc.getLongForceBuffer());
+    kernel2->addArg(cc.getEnergyBuffer());
 }
 
 void CommonCalcRMSDForceKernel::recordParameters(const RMSDForce& force) {
@@ -7555,89 +8074,20 @@ void CommonCalcRMSDForceKernel::recordParameters(const RMSDForce& force) {
 }
 
 double CommonCalcRMSDForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
-    ContextSelector selector(cc);
-    if (cc.getUseDoublePrecision())
-        return executeImpl<double>(context);
-    return executeImpl<float>(context);
-}
-
-template <class REAL>
-double CommonCalcRMSDForceKernel::executeImpl(ContextImpl& context) {
-    // Execute the first kernel.
+    // The whole calculation, including finding the optimal rotation, is done on the device.  The
+    // RMSD is added to the energy buffer, so nothing needs to be downloaded.
 
+    ContextSelector selector(cc);
     int numParticles = particles.getSize();
     kernel1->setArg(0, numParticles);
+    if (cc.getUseDoublePrecision())
+        kernel1->setArg(5, sumNormRef);
+    else
+        kernel1->setArg(5, (float) sumNormRef);
     kernel1->execute(blockSize, blockSize);
-    
-    // Download the results, build the F matrix, and find the maximum eigenvalue
-    // and eigenvector.
-
-    vector<REAL> b;
-    buffer.download(b);
-
-    // JAMA::Eigenvalue may run into an infinite loop if we have any NaN
-    for (int i = 0; i < 9; i++) {
-        if (b[i] != b[i])
-            throw OpenMMException("NaN encountered during RMSD force calculation");
-    }
-    
-    Array2D<double> F(4, 4);
-    F[0][0] =  b[0*3+0] + b[1*3+1] + b[2*3+2];
-    F[1][0] =  b[1*3+2] - b[2*3+1];
-    F[2][0] =  b[2*3+0] - b[0*3+2];
-    F[3][0] =  b[0*3+1] - b[1*3+0];
-    F[0][1] =  b[1*3+2] - b[2*3+1];
-    F[1][1] =  b[0*3+0] - b[1*3+1] - b[2*3+2];
-    F[2][1] =  b[0*3+1] + b[1*3+0];
-    F[3][1] =  b[0*3+2] + b[2*3+0];
-    F[0][2] =  b[2*3+0] - b[0*3+2];
-    F[1][2] =  b[0*3+1] + b[1*3+0];
-    F[2][2] = -b[0*3+0] + b[1*3+1] - b[2*3+2];
-    F[3][2] =  b[1*3+2] + b[2*3+1];
-    F[0][3] =  b[0*3+1] - b[1*3+0];
-    F[1][3] =  b[0*3+2] + b[2*3+0];
-    F[2][3] =  b[1*3+2] + b[2*3+1];
-    F[3][3] = -b[0*3+0] - b[1*3+1] + b[2*3+2];
-    JAMA::Eigenvalue<double> eigen(F);
-    Array1D<double> values;
-    eigen.getRealEigenvalues(values);
-    Array2D<double> vectors;
-    eigen.getV(vectors);
-
-    // Compute the RMSD.
-
-    double msd = (sumNormRef+b[9]-2*values[3])/numParticles;
-    if (msd < 1e-20) {
-        // The particles are perfectly aligned, so all the forces should be zero.
-        // Numerical error can lead to NaNs, so just return 0 now.
-        return 0.0;
-    }
-    double rmsd = sqrt(msd);
-    b[9] = rmsd;
-
-    // Compute the rotation matrix.
-
-    double q[] = {vectors[0][3], vectors[1][3], vectors[2][3], vectors[3][3]};
-    double q00 = q[0]*q[0], q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3];
-    double q11 = q[1]*q[1], q12 = q[1]*q[2], q13 = q[1]*q[3];
-    double q22 = q[2]*q[2], q23 = q[2]*q[3];
-    double q33 = q[3]*q[3];
-    b[0] = q00+q11-q22-q33;
-    b[1] = 2*(q12-q03);
-    b[2] = 2*(q13+q02);
-    b[3] = 2*(q12+q03);
-    b[4] = q00-q11+q22-q33;
-    b[5] = 2*(q23-q01);
-    b[6] = 2*(q13-q02);
-    b[7] = 2*(q23+q01);
-    b[8] = q00-q11-q22+q33;
-
-    // Upload it to the device and invoke the kernel to apply forces.
-    
-    buffer.upload(b);
     kernel2->setArg(0, numParticles);
     kernel2->execute(numParticles);
-    return rmsd;
+    return 0.0;
 }
 
 void CommonCalcRMSDForceKernel::copyParametersToContext(ContextImpl& context, const RMSDForce& force) {
@@ -7657,6 +8107,48 @@ void CommonCalcRMSDForceKernel::copyParametersToContext(ContextImpl& context, co
     cc.invalidateMolecules(info);
 }
 
+void CommonCalcExternalForceKernel::initialize(const System& system, const ExternalForce& force) {
+    ContextSelector selector(cc);
+    computation = &force.getComputation();
+    int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
+    forceBuffer.initialize(cc, cc.getPaddedNumAtoms(), 4*elementSize, "externalForceBuffer");
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::externalForce);
+    addForcesKernel = program->createKernel("addExternalForces");
+    addForcesKernel->addArg(cc.getLongForceBuffer());
+    addForcesKernel->addArg(forceBuffer);
+    addForcesKernel->addArg(cc.getNumAtoms());
+    addForcesKernel->addArg(cc.getPaddedNumAtoms());
+    event = cc.createEvent();
+    cc.addForce(new ComputeForceInfo());
+}
+
+double CommonCalcExternalForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    ContextSelector selector(cc);
+    if (includeForces)
+        cc.clearBuffer(forceBuffer);
+
+    // The Computation may use its own stream or queue, so make sure the positions are up to date
+    // before calling it.
+
+    event->enqueue();
+    event->wait();
+    ExternalForce::ComputeData data;
+    data.numParticles = cc.getNumAtoms();
+    data.isDeviceMemory = true;
+    data.isDoublePrecision = cc.getUseDoublePrecision();
+    data.stride = 4;
+    data.positions = cc.getPosq().getDeviceHandle();
+    data.forces = forceBuffer.getDeviceHandle();
+    data.atomIndex = cc.getAtomIndex().data();
+    cc.getPeriodicBoxVectors(data.periodicBoxVectors[0], data.periodicBoxVectors[1], data.periodicBoxVectors[2]);
+    data.includeForces = includeForces;
+    data.includeEnergy = includeEnergy;
+    double energy = computation->compute(data);
+    if (includeForces)
+        addForcesKernel->execute(cc.getNumAtoms());
+    return (includeEnergy ? energy : 0.0);
+}
+
 void CommonApplyAndersenThermostatKernel::initialize(const System& system, const AndersenThermostat& thermostat) {
     ContextSelector selector(cc);
     randomSeed = thermostat.getRandomNumberSeed();
@@ -7701,14 +8193,6 @@ void CommonApplyMonteCarloBarostatKernel::initialize(const System& system, const
     this->rigidMolecules = rigidMolecules;
     ContextSelector selector(cc);
     savedPositions.initialize(cc, cc.getPaddedNumAtoms(), cc.getUseDoublePrecision() ? sizeof(mm_double4) : sizeof(mm_float4), "savedPositions");
-    savedLongForces.initialize<long long>(cc, cc.getPaddedNumAtoms()*3, "savedLongForces");
-    try {
-        cc.getFloatForceBuffer(); // This will throw an exception on the CUDA platform.
-        savedFloatForces.initialize(cc, cc.getPaddedNumAtoms(), cc.getUseDoublePrecision() ? sizeof(mm_double4) : sizeof(mm_float4), "savedForces");
-    }
-    catch (...) {
-        // The CUDA platform doesn't have a floating point force buffer, so we don't need to copy it.
-    }
     ComputeProgram program = cc.compileProgram(CommonKernelSources::monteCarloBarostat);
     kernel = program->createKernel("scalePositions");
 }
@@ -7755,10 +8239,10 @@ void CommonApplyMonteCarloBarostatKernel::scaleCoordinates(ContextImpl& context,
         kernel->addArg(moleculeAtoms);
         kernel->addArg(moleculeStartIndex);
     }
+    // The barostats always mark the forces as invalid after a trial move, so only the positions need
+    // to be saved.
+
     cc.getPosq().copyTo(savedPositions);
-    cc.getLongForceBuffer().copyTo(savedLongForces);
-    if (savedFloatForces.isInitialized())
-        cc.getFloatForceBuffer().copyTo(savedFloatForces);
     lastPosCellOffsets = cc.getPosCellOffsets();
     kernel->setArg(0, (float) scaleX);
     kernel->setArg(1, (float) scaleY);
@@ -7771,8 +8255,5 @@ void CommonApplyMonteCarloBarostatKernel::scaleCoordinates(ContextImpl& context,
 void CommonApplyMonteCarloBarostatKernel::restoreCoordinates(ContextImpl& context) {
     ContextSelector selector(cc);
     savedPositions.copyTo(cc.getPosq());
-    savedLongForces.copyTo(cc.getLongForceBuffer());
     cc.setPosCellOffsets(lastPosCellOffsets);
-    if (savedFloatForces.isInitialized())
-        savedFloatForces.copyTo(cc.getFloatForceBuffer());
 }
\ No newline at end of file
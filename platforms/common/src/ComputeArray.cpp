@@ -84,6 +84,12 @@ ComputeContext& ComputeArray::getContext() {
     return impl->getContext();
 }
 
+void* ComputeArray::getDeviceHandle() {
+    if (impl == NULL)
+        throw OpenMMException("ComputeArray has not been initialized");
+    return impl->getDeviceHandle();
+}
+
 void ComputeArray::uploadSubArray(const void* data, int offset, int elements, bool blocking) {
     if (impl == NULL)
         throw OpenMMException("ComputeArray has not been initialized");
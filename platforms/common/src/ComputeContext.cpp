@@ -26,10 +26,15 @@
 
 #include "openmm/common/ComputeContext.h"
 #include "openmm/common/ContextSelector.h"
+#include "openmm/CustomNonbondedForce.h"
+#include "openmm/NonbondedForce.h"
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/NonbondedForceImpl.h"
 #include "openmm/internal/ThreadPool.h"
+#include "openmm/internal/TraceRange.h"
+#include "SimTKOpenMMRealType.h"
 #include "hilbert.h"
 #include <algorithm>
 #include <cmath>
@@ -43,8 +48,8 @@ using namespace std;
 const int ComputeContext::ThreadBlockSize = 64;
 const int ComputeContext::TileSize = 32;
 
-ComputeContext::ComputeContext(const System& system) : system(system), time(0.0), stepCount(0), computeForceCount(0), stepsSinceReorder(99999),
-        forceNextReorder(false), atomsWereReordered(false), forcesValid(false), thread(NULL) {
+ComputeContext::ComputeContext(const System& system) : system(system), time(0.0), stepCount(0), numAtomReorders(0), totalMemory(0), peakMemory(0),
+        memoryCategory("Forces"), computeForceCount(0), stepsSinceReorder(99999), forceNextReorder(false), atomsWereReordered(false), forcesValid(false), thread(NULL) {
     thread = new WorkThread();
 }
 
@@ -192,24 +197,22 @@ void ComputeContext::findMoleculeGroups() {
 
         addForce(new VirtualSiteInfo(system));
 
-        // First make a list of every other atom to which each atom is connect by a constraint or force group.
+        // First make a list of pairs of atoms that are connected by a constraint or force group.  Connecting
+        // every atom in a group to the first one is enough to put them all in the same molecule.
 
-        vector<vector<int> > atomBonds(system.getNumParticles());
+        vector<pair<int, int> > atomBonds;
         for (int i = 0; i < system.getNumConstraints(); i++) {
             int particle1, particle2;
             double distance;
             system.getConstraintParameters(i, particle1, particle2, distance);
-            atomBonds[particle1].push_back(particle2);
-            atomBonds[particle2].push_back(particle1);
+            atomBonds.push_back(make_pair(particle1, particle2));
         }
         for (auto force : forces) {
             for (int j = 0; j < force->getNumParticleGroups(); j++) {
                 vector<int> particles;
                 force->getParticlesInGroup(j, particles);
-                for (int k = 0; k < (int) particles.size(); k++)
-                    for (int m = 0; m < (int) particles.size(); m++)
-                        if (k != m)
-                            atomBonds[particles[k]].push_back(particles[m]);
+                for (int k = 1; k < (int) particles.size(); k++)
+                    atomBonds.push_back(make_pair(particles[0], particles[k]));
             }
         }
 
@@ -217,7 +220,7 @@ void ComputeContext::findMoleculeGroups() {
 
         vector<vector<int> > atomIndices = ContextImpl::findMolecules(numAtoms, atomBonds);
         int numMolecules = atomIndices.size();
-        vector<int> atomMolecule(numAtoms);
+        atomMolecule.resize(numAtoms);
         for (int i = 0; i < (int) atomIndices.size(); i++)
             for (int j = 0; j < (int) atomIndices[i].size(); j++)
                 atomMolecule[atomIndices[i][j]] = i;
@@ -320,6 +323,10 @@ void ComputeContext::findMoleculeGroups() {
         moleculeGroups[i].atoms.resize(atoms.size());
         for (int j = 0; j < (int) atoms.size(); j++)
             moleculeGroups[i].atoms[j] = atoms[j]-atoms[0];
+        for (int j = 0; j < (int) moleculeInstances[i].size(); j++) {
+            molecules[moleculeInstances[i][j]].group = i;
+            molecules[moleculeInstances[i][j]].instance = j;
+        }
     }
 }
 
@@ -340,33 +347,13 @@ bool ComputeContext::invalidateMolecules(ComputeForceInfo* force) {
     getThreadPool().execute([&] (ThreadPool& threads, int threadIndex) {
         for (int group = 0; valid && group < (int) moleculeGroups.size(); group++) {
             MoleculeGroup& mol = moleculeGroups[group];
-            vector<int>& instances = mol.instances;
-            vector<int>& offsets = mol.offsets;
-            vector<int>& atoms = mol.atoms;
-            int numMolecules = instances.size();
-            Molecule& m1 = molecules[instances[0]];
-            int offset1 = offsets[0];
+            int numMolecules = mol.instances.size();
             int numThreads = threads.getNumThreads();
             int start = max(1, threadIndex*numMolecules/numThreads);
             int end = (threadIndex+1)*numMolecules/numThreads;
-            for (int j = start; j < end; j++) {
-                // See if the atoms are identical.
-
-                Molecule& m2 = molecules[instances[j]];
-                int offset2 = offsets[j];
-                for (int i = 0; i < (int) atoms.size() && valid; i++) {
-                    if (!force->areParticlesIdentical(atoms[i]+offset1, atoms[i]+offset2))
-                        valid = false;
-                }
-
-                // See if the force groups are identical.
-
-                if (valid && forceIndex > -1) {
-                    for (int k = 0; k < (int) m1.groups[forceIndex].size() && valid; k++)
-                        if (!force->areGroupsIdentical(m1.groups[forceIndex][k], m2.groups[forceIndex][k]))
-                            valid = false;
-                }
-            }
+            for (int j = start; j < end && valid; j++)
+                if (!areMoleculesIdentical(force, forceIndex, mol, 0, j))
+                    valid = false;
         }
     });
     getThreadPool().waitForThreads();
@@ -383,6 +370,71 @@ bool ComputeContext::invalidateMolecules(ComputeForceInfo* force) {
     return true;
 }
 
+bool ComputeContext::invalidateMolecules(ComputeForceInfo* force, const vector<int>& atoms) {
+    if (numAtoms == 0 || !getNonbondedUtilities().getUseCutoff())
+        return false;
+    int forceIndex = -1;
+    for (int i = 0; i < forces.size(); i++)
+        if (forces[i] == force)
+            forceIndex = i;
+
+    // Find which instances of each molecule group contain changed atoms.
+
+    map<int, set<int> > changedInstances;
+    for (int atom : atoms) {
+        Molecule& mol = molecules[atomMolecule[atom]];
+        changedInstances[mol.group].insert(mol.instance);
+    }
+
+    // Before the change, all instances in a group were identical.  That means it is sufficient to compare
+    // each changed instance to a single one that did not change.
+
+    for (auto& changed : changedInstances) {
+        MoleculeGroup& mol = moleculeGroups[changed.first];
+        int numInstances = mol.instances.size();
+        if (numInstances == 1)
+            continue;
+        if ((int) changed.second.size() == numInstances) {
+            // Every instance changed, so we need to check the full system.
+
+            return invalidateMolecules(force);
+        }
+        int reference = 0;
+        while (changed.second.find(reference) != changed.second.end())
+            reference++;
+        for (int instance : changed.second) {
+            if (!areMoleculesIdentical(force, forceIndex, mol, reference, instance)) {
+                resetAtomOrder();
+                findMoleculeGroups();
+                reorderAtoms();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ComputeContext::areMoleculesIdentical(ComputeForceInfo* force, int forceIndex, const MoleculeGroup& group, int instance1, int instance2) {
+    // See if the atoms are identical.
+
+    int offset1 = group.offsets[instance1];
+    int offset2 = group.offsets[instance2];
+    for (int atom : group.atoms)
+        if (!force->areParticlesIdentical(atom+offset1, atom+offset2))
+            return false;
+
+    // See if the force groups are identical.
+
+    if (forceIndex > -1) {
+        Molecule& m1 = molecules[group.instances[instance1]];
+        Molecule& m2 = molecules[group.instances[instance2]];
+        for (int k = 0; k < (int) m1.groups[forceIndex].size(); k++)
+            if (!force->areGroupsIdentical(m1.groups[forceIndex][k], m2.groups[forceIndex][k]))
+                return false;
+    }
+    return true;
+}
+
 void ComputeContext::resetAtomOrder() {
     ContextSelector selector(*this);
     vector<mm_int4> newCellOffsets(numAtoms);
@@ -469,15 +521,196 @@ void ComputeContext::forceReorder() {
     forceNextReorder = true;
 }
 
+void ComputeContext::countNeighborListPairs(int numTiles, double cutoff, long long& numPairs, long long& numPairsInCutoff) {
+    numPairs = 0;
+    numPairsInCutoff = 0;
+    if (numTiles == 0)
+        return;
+    NonbondedUtilities& nb = getNonbondedUtilities();
+    vector<int> tiles, atoms;
+    nb.getInteractingTiles().download(tiles);
+    nb.getInteractingAtoms().download(atoms);
+    vector<Vec3> pos(paddedNumAtoms);
+    if (getUseDoublePrecision()) {
+        vector<mm_double4> posq;
+        getPosq().download(posq);
+        for (int i = 0; i < numAtoms; i++)
+            pos[i] = Vec3(posq[i].x, posq[i].y, posq[i].z);
+    }
+    else {
+        vector<mm_float4> posq;
+        getPosq().download(posq);
+        for (int i = 0; i < numAtoms; i++)
+            pos[i] = Vec3(posq[i].x, posq[i].y, posq[i].z);
+    }
+    Vec3 boxVectors[3];
+    getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    bool periodic = nb.getUsePeriodic();
+    double cutoff2 = cutoff*cutoff;
+    for (int tile = 0; tile < numTiles; tile++) {
+        int firstAtom = tiles[tile]*TileSize;
+        int lastAtom = min(firstAtom+TileSize, numAtoms);
+        for (int j = 0; j < TileSize; j++) {
+            int atom2 = atoms[tile*TileSize+j];
+            if (atom2 >= numAtoms)
+                continue;
+            for (int atom1 = firstAtom; atom1 < lastAtom; atom1++) {
+                numPairs++;
+                Vec3 delta = pos[atom2]-pos[atom1];
+                if (periodic) {
+                    delta -= boxVectors[2]*round(delta[2]/boxVectors[2][2]);
+                    delta -= boxVectors[1]*round(delta[1]/boxVectors[1][1]);
+                    delta -= boxVectors[0]*round(delta[0]/boxVectors[0][0]);
+                }
+                if (delta.dot(delta) < cutoff2)
+                    numPairsInCutoff++;
+            }
+        }
+    }
+}
+
+void ComputeContext::recordMemoryUsage(const string& category, long long bytes) {
+    memoryUsage[category] += bytes;
+    totalMemory += bytes;
+    peakMemory = max(peakMemory, totalMemory);
+}
+
+map<string, double> ComputeContext::getMemoryUsage() const {
+    map<string, double> usage;
+    for (auto& category : memoryUsage)
+        usage[category.first] = (double) category.second;
+    usage["Total"] = (double) totalMemory;
+    usage["Peak"] = (double) peakMemory;
+    return usage;
+}
+
+map<string, double> ComputeContext::estimateMemoryUsage(const System& system, bool useDoublePrecision, bool useMixedPrecision) {
+    // This follows the sizes of the arrays the platforms create.  It does not need to be exact,
+    // but it should be kept roughly in sync with them.
+
+    map<string, double> usage;
+    double numAtoms = system.getNumParticles();
+    int numAtomBlocks = (system.getNumParticles()+TileSize-1)/TileSize;
+    double paddedNumAtoms = numAtomBlocks*TileSize;
+    int realSize = (useDoublePrecision ? sizeof(double) : sizeof(float));
+    int mixedSize = (useDoublePrecision || useMixedPrecision ? sizeof(double) : sizeof(float));
+
+    // Positions, velocities, forces, and the atom index.
+
+    usage["Context"] = paddedNumAtoms*(4*realSize + (useMixedPrecision ? 4*sizeof(float) : 0) + 4*mixedSize + 3*sizeof(long long) + sizeof(int));
+
+    // Integration: the position deltas, random numbers for stochastic integrators, and constraints.
+
+    double constraintSize = 2*sizeof(int) + 7*mixedSize + 8*(sizeof(int)+mixedSize);
+    usage["Integration"] = paddedNumAtoms*(4*mixedSize + 4*4*sizeof(float)) + system.getNumConstraints()*constraintSize;
+
+    // Find the Force that determines the nonbonded interactions.
+
+    const NonbondedForce* nonbonded = NULL;
+    const CustomNonbondedForce* customNonbonded = NULL;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        if (nonbonded == NULL)
+            nonbonded = dynamic_cast<const NonbondedForce*>(&system.getForce(i));
+        if (customNonbonded == NULL)
+            customNonbonded = dynamic_cast<const CustomNonbondedForce*>(&system.getForce(i));
+    }
+    if (nonbonded != NULL || customNonbonded != NULL) {
+        // Count the tiles that contain exclusions.
+
+        set<pair<int, int> > exclusionTiles;
+        for (int i = 0; i < numAtomBlocks; i++)
+            exclusionTiles.insert(make_pair(i, i));
+        if (nonbonded != NULL) {
+            for (int i = 0; i < nonbonded->getNumExceptions(); i++) {
+                int particle1, particle2;
+                double chargeProd, sigma, epsilon;
+                nonbonded->getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
+                exclusionTiles.insert(make_pair(max(particle1, particle2)/TileSize, min(particle1, particle2)/TileSize));
+            }
+        }
+        else {
+            for (int i = 0; i < customNonbonded->getNumExclusions(); i++) {
+                int particle1, particle2;
+                customNonbonded->getExclusionParticles(i, particle1, particle2);
+                exclusionTiles.insert(make_pair(max(particle1, particle2)/TileSize, min(particle1, particle2)/TileSize));
+            }
+        }
+        double numExclusionTiles = exclusionTiles.size();
+        usage["Nonbonded"] = numExclusionTiles*(TileSize*sizeof(int) + 2*sizeof(int) + 2*sizeof(int)) + numAtomBlocks*sizeof(int);
+        bool useCutoff, periodic;
+        double cutoff;
+        if (nonbonded != NULL) {
+            useCutoff = (nonbonded->getNonbondedMethod() != NonbondedForce::NoCutoff);
+            periodic = nonbonded->usesPeriodicBoundaryConditions();
+            cutoff = nonbonded->getCutoffDistance();
+        }
+        else {
+            useCutoff = (customNonbonded->getNonbondedMethod() != CustomNonbondedForce::NoCutoff);
+            periodic = customNonbonded->usesPeriodicBoundaryConditions();
+            cutoff = customNonbonded->getCutoffDistance();
+        }
+        if (useCutoff) {
+            // Bounding boxes and sorting for the atom blocks.
+
+            usage["Nonbonded"] += numAtomBlocks*(18*realSize) + numAtoms*4*realSize;
+
+            // The neighbor list starts with room for 20 tiles per block.  If more are needed,
+            // it grows to 20% more than the number of interacting tiles.  Estimate that number
+            // from the density, assuming two blocks interact if their bounding spheres are within
+            // the padded cutoff.
+
+            double totalTiles = 0.5*numAtomBlocks*(numAtomBlocks+1.0);
+            double maxTiles = 20.0*numAtomBlocks;
+            if (periodic) {
+                Vec3 a, b, c;
+                system.getDefaultPeriodicBoxVectors(a, b, c);
+                double density = numAtoms/(a[0]*b[1]*c[2]);
+                double blockRadius = cbrt(3.0*TileSize/(4.0*M_PI*density));
+                double range = 1.08*cutoff+2*blockRadius;
+                double tilesPerBlock = 0.5*(4.0/3.0)*M_PI*range*range*range*density/TileSize;
+                maxTiles = max(maxTiles, 1.2*tilesPerBlock*numAtomBlocks);
+            }
+            maxTiles = max(1.0, min(maxTiles, totalTiles));
+            usage["Neighbor List"] = maxTiles*(1+TileSize)*sizeof(int) + 5*numAtoms*2*sizeof(int);
+        }
+    }
+
+    // PME grids, including the work areas for the FFTs.
+
+    if (nonbonded != NULL && (nonbonded->getNonbondedMethod() == NonbondedForce::PME || nonbonded->getNonbondedMethod() == NonbondedForce::LJPME)) {
+        const int pmeOrder = 5;
+        double alpha;
+        int nx, ny, nz;
+        NonbondedForceImpl::calcPMEParameters(system, *nonbonded, alpha, nx, ny, nz, false);
+        double gridElements = nx*ny*(double) (pmeOrder*((nz+pmeOrder-1)/pmeOrder));
+        double fftElements = nx*ny*(double) (nz/2+1);
+        int numFFTs = 1;
+        if (nonbonded->getNonbondedMethod() == NonbondedForce::LJPME) {
+            NonbondedForceImpl::calcPMEParameters(system, *nonbonded, alpha, nx, ny, nz, true);
+            gridElements = max(gridElements, nx*ny*(double) (pmeOrder*((nz+pmeOrder-1)/pmeOrder)));
+            fftElements = max(fftElements, nx*ny*(double) (nz/2+1));
+            numFFTs = 2;
+        }
+        usage["PME"] = 2*gridElements*2*realSize + numFFTs*fftElements*2*realSize + numAtoms*2*sizeof(int);
+    }
+    double total = 0.0;
+    for (auto& category : usage)
+        total += category.second;
+    usage["Total"] = total;
+    return usage;
+}
+
 void ComputeContext::reorderAtoms() {
     atomsWereReordered = false;
     if (numAtoms == 0 || !getNonbondedUtilities().getUseCutoff() || (stepsSinceReorder < 250 && !forceNextReorder)) {
         stepsSinceReorder++;
         return;
     }
+    OPENMM_TRACE_RANGE("Reorder atoms");
     forceNextReorder = false;
     atomsWereReordered = true;
     stepsSinceReorder = 0;
+    numAtomReorders++;
     if (getUseDoublePrecision())
         reorderAtomsImpl<double, mm_double4, double, mm_double4>();
     else if (getUseMixedPrecision())
@@ -655,6 +888,16 @@ void ComputeContext::reorderAtomsImpl() {
         listener->execute();
 }
 
+void ComputeContext::setAtomIndex(const vector<int>& index) {
+    if (index.size() != atomIndex.size())
+        throw OpenMMException("setAtomIndex: The number of atoms does not match");
+    ContextSelector selector(*this);
+    atomIndex = index;
+    getAtomIndexArray().upload(atomIndex);
+    for (auto listener : reorderListeners)
+        listener->execute();
+}
+
 void ComputeContext::addReorderListener(ReorderListener* listener) {
     reorderListeners.push_back(listener);
 }
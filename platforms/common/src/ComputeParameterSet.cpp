@@ -117,13 +117,23 @@ void ComputeParameterSet::getParameterValues(vector<vector<T> >& values) {
 
 template <class T>
 void ComputeParameterSet::setParameterValues(const vector<vector<T> >& values) {
+    setParameterValues(0, values);
+}
+
+template <class T>
+void ComputeParameterSet::setParameterValues(int first, const vector<vector<T> >& values) {
     if (sizeof(T) != elementSize)
         throw OpenMMException("Called setParameterValues() with vector of wrong type");
+    int count = values.size();
+    if (first < 0 || first+count > numObjects)
+        throw OpenMMException("Internal error: Illegal range in ComputeParameterSet::setParameterValues()");
+    if (count == 0)
+        return;
     int base = 0;
     for (int i = 0; i < (int) arrays.size(); i++) {
         if (arrays[i]->getElementSize() == 4*elementSize) {
-            vector<T> data(4*numObjects);
-            for (int j = 0; j < numObjects; j++) {
+            vector<T> data(4*count);
+            for (int j = 0; j < count; j++) {
                 data[4*j] = values[j][base];
                 if (base+1 < numParameters)
                     data[4*j+1] = values[j][base+1];
@@ -132,24 +142,24 @@ void ComputeParameterSet::setParameterValues(const vector<vector<T> >& values) {
                 if (base+3 < numParameters)
                     data[4*j+3] = values[j][base+3];
             }
-            arrays[i]->upload(data.data());
+            arrays[i]->uploadSubArray(data.data(), first, count);
             base += 4;
         }
         else if (arrays[i]->getElementSize() == 2*elementSize) {
-            vector<T> data(2*numObjects);
-            for (int j = 0; j < numObjects; j++) {
+            vector<T> data(2*count);
+            for (int j = 0; j < count; j++) {
                 data[2*j] = values[j][base];
                 if (base+1 < numParameters)
                     data[2*j+1] = values[j][base+1];
             }
-            arrays[i]->upload(data.data());
+            arrays[i]->uploadSubArray(data.data(), first, count);
             base += 2;
         }
         else if (arrays[i]->getElementSize() == elementSize) {
-            vector<T> data(numObjects);
-            for (int j = 0; j < numObjects; j++)
+            vector<T> data(count);
+            for (int j = 0; j < count; j++)
                 data[j] = values[j][base];
-            arrays[i]->upload(data.data());
+            arrays[i]->uploadSubArray(data.data(), first, count);
             base++;
         }
         else
@@ -181,6 +191,8 @@ string ComputeParameterSet::getParameterSuffix(int index, const std::string& ext
 namespace OpenMM {
 template void ComputeParameterSet::getParameterValues<float>(vector<vector<float> >& values);
 template void ComputeParameterSet::setParameterValues<float>(const vector<vector<float> >& values);
+template void ComputeParameterSet::setParameterValues<float>(int first, const vector<vector<float> >& values);
 template void ComputeParameterSet::getParameterValues<double>(vector<vector<double> >& values);
 template void ComputeParameterSet::setParameterValues<double>(const vector<vector<double> >& values);
+template void ComputeParameterSet::setParameterValues<double>(int first, const vector<vector<double> >& values);
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/common/ComputeStateSnapshot.h"
+#include "openmm/common/ComputeContext.h"
+#include "openmm/common/ContextSelector.h"
+#include "openmm/OpenMMException.h"
+
+using namespace OpenMM;
+using namespace std;
+
+ComputeStateSnapshot::ComputeStateSnapshot(ComputeContext& context) : context(context), time(0), stepCount(0),
+        stepsSinceReorder(0), randomPos(0), isSaved(false) {
+    if (context.getNumContexts() > 1)
+        throw OpenMMException("ComputeStateSnapshot does not support contexts that are parallelized across multiple devices");
+    ContextSelector selector(context);
+    posq.initialize(context, context.getPosq().getSize(), context.getPosq().getElementSize(), "posqSnapshot");
+    if (context.getUseMixedPrecision())
+        posqCorrection.initialize(context, context.getPosqCorrection().getSize(), context.getPosqCorrection().getElementSize(), "posqCorrectionSnapshot");
+    velm.initialize(context, context.getVelm().getSize(), context.getVelm().getElementSize(), "velmSnapshot");
+}
+
+void ComputeStateSnapshot::save() {
+    ContextSelector selector(context);
+    context.getPosq().copyTo(posq);
+    if (context.getUseMixedPrecision())
+        context.getPosqCorrection().copyTo(posqCorrection);
+    context.getVelm().copyTo(velm);
+    context.getIntegrationUtilities().createSnapshot(random, randomSeed, randomPos);
+    atomIndex = context.getAtomIndex();
+    posCellOffsets = context.getPosCellOffsets();
+    context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    time = context.getTime();
+    stepCount = context.getStepCount();
+    stepsSinceReorder = context.getStepsSinceReorder();
+    isSaved = true;
+}
+
+void ComputeStateSnapshot::restore() {
+    if (!isSaved)
+        throw OpenMMException("ComputeStateSnapshot: restore() was called before save()");
+    ContextSelector selector(context);
+    posq.copyTo(context.getPosq());
+    if (context.getUseMixedPrecision())
+        posqCorrection.copyTo(context.getPosqCorrection());
+    velm.copyTo(context.getVelm());
+    context.getIntegrationUtilities().loadSnapshot(random, randomSeed, randomPos);
+    context.setPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    context.setTime(time);
+    context.setStepCount(stepCount);
+    context.setStepsSinceReorder(stepsSinceReorder);
+    context.setPosCellOffsets(posCellOffsets);
+
+    // The atom order may have changed since the snapshot was saved.  If so, restore it and let
+    // everything that depends on it know.
+
+    if (atomIndex != context.getAtomIndex())
+        context.setAtomIndex(atomIndex);
+}
@@ -438,58 +438,66 @@ void ExpressionUtilities::processExpression(stringstream& out, const ExpressionT
                             out << "int t = min((int) floor(y), " << paramsInt[1] << "-1);\n";
                             out << "int u = min((int) floor(z), " << paramsInt[2] << "-1);\n";
                         }
-                        out << "int coeffIndex = 16*(s+" << paramsInt[0] << "*(t+" << paramsInt[1] << "*u));\n";
+                        int xpoints = (int) functionParams[i][0]+1;
+                        int ypoints = (int) functionParams[i][1]+1;
+                        out << "int pointIndex = 2*(s+" << xpoints << "*(t+" << ypoints << "*u));\n";
                         out << "float4 c[16];\n";
-                        for (int j = 0; j < 16; j++)
-                            out << "c[" << j << "] = " << functionNames[i].second << "[coeffIndex+" << j << "];\n";
+                        for (int j = 0; j < 8; j++) {
+                            int offset = 2*((j&1) + xpoints*(((j>>1)&1) + ypoints*(j>>2)));
+                            out << "c[" << 2*j << "] = " << functionNames[i].second << "[pointIndex+" << offset << "];\n";
+                            out << "c[" << 2*j+1 << "] = " << functionNames[i].second << "[pointIndex+" << offset+1 << "];\n";
+                        }
                         out << "real da = x-s;\n";
                         out << "real db = y-t;\n";
                         out << "real dc = z-u;\n";
+
+                        // Within each patch the spline is the tricubic Hermite interpolant of the values and
+                        // derivatives at the corners.  The first two elements of each basis multiply values
+                        // at the two ends of the cell, and the last two multiply derivatives.
+
+                        const string axisNames[] = {"a", "b", "c"};
+                        for (int axis = 0; axis < 3; axis++) {
+                            string t = "d"+axisNames[axis];
+                            out << "real h" << axisNames[axis] << "[4] = {1-" << t << "*" << t << "*(3-2*" << t << "), " << t << "*" << t << "*(3-2*" << t << "), "
+                                << t << "*(1-" << t << ")*(1-" << t << "), " << t << "*" << t << "*(" << t << "-1)};\n";
+                        }
                         for (int j = 0; j < nodes.size(); j++) {
                             const vector<int>& derivOrder = dynamic_cast<const Operation::Custom*>(&nodes[j]->getOperation())->getDerivOrder();
-                            if (derivOrder[0] == 0 && derivOrder[1] == 0 && derivOrder[2] == 0) {
-                                out << "real value[4] = {0, 0, 0, 0};\n";
-                                for (int k = 3; k >= 0; k--)
-                                    for (int m = 0; m < 4; m++) {
-                                        int base = k + 4*m;
-                                        out << "value[" << m << "] = db*value[" << m << "] + ((c[" << base << "].w*da + c[" << base << "].z)*da + c[" << base << "].y)*da + c[" << base << "].x;\n";
-                                    }
-                                out << nodeNames[j] << suffix << " = value[0] + dc*(value[1] + dc*(value[2] + dc*value[3]));\n";
-                            }
-                            else if (derivOrder[0] == 1 && derivOrder[1] == 0 && derivOrder[2] == 0) {
-                                out << "real derivx[4] = {0, 0, 0, 0};\n";
-                                for (int k = 3; k >= 0; k--)
-                                    for (int m = 0; m < 4; m++) {
-                                        int base = k + 4*m;
-                                        out << "derivx[" << m << "] = db*derivx[" << m << "] + (3*c[" << base << "].w*da + 2*c[" << base << "].z)*da + c[" << base << "].y;\n";
-                                    }
-                                out << nodeNames[j] << suffix << " = derivx[0] + dc*(derivx[1] + dc*(derivx[2] + dc*derivx[3]));\n";
-                                out << nodeNames[j] << suffix << " *= " << paramsFloat[9] << ";\n";
-                            }
-                            else if (derivOrder[0] == 0 && derivOrder[1] == 1 && derivOrder[2] == 0) {
-                                const string suffixes[] = {".x", ".y", ".z", ".w"};
-                                out << "real derivy[4] = {0, 0, 0, 0};\n";
-                                for (int k = 3; k >= 0; k--)
-                                    for (int m = 0; m < 4; m++) {
-                                        int base = 4*m;
-                                        string suffix = suffixes[k];
-                                        out << "derivy[" << m << "] = da*derivy[" << m << "] + (3*c[" << (base+3) << "]" << suffix << "*db + 2*c[" << (base+2) << "]" << suffix << ")*db + c[" << (base+1) << "]" << suffix << ";\n";
-                                    }
-                                out << nodeNames[j] << suffix << " = derivy[0] + dc*(derivy[1] + dc*(derivy[2] + dc*derivy[3]));\n";
-                                out << nodeNames[j] << suffix << " *= " << paramsFloat[10] << ";\n";
-                            }
-                            else if (derivOrder[0] == 0 && derivOrder[1] == 0 && derivOrder[2] == 1) {
-                                out << "real derivz[4] = {0, 0, 0, 0};\n";
-                                for (int k = 3; k >= 0; k--)
-                                    for (int m = 0; m < 4; m++) {
-                                        int base = k + 4*m;
-                                        out << "derivz[" << m << "] = db*derivz[" << m << "] + ((c[" << base << "].w*da + c[" << base << "].z)*da + c[" << base << "].y)*da + c[" << base << "].x;\n";
-                                    }
-                                out << nodeNames[j] << suffix << " = derivz[1] + dc*(2*derivz[2] + dc*3*derivz[3]);\n";
-                                out << nodeNames[j] << suffix << " *= " << paramsFloat[11] << ";\n";
-                            }
+                            int derivAxis;
+                            if (derivOrder[0] == 0 && derivOrder[1] == 0 && derivOrder[2] == 0)
+                                derivAxis = -1;
+                            else if (derivOrder[0] == 1 && derivOrder[1] == 0 && derivOrder[2] == 0)
+                                derivAxis = 0;
+                            else if (derivOrder[0] == 0 && derivOrder[1] == 1 && derivOrder[2] == 0)
+                                derivAxis = 1;
+                            else if (derivOrder[0] == 0 && derivOrder[1] == 0 && derivOrder[2] == 1)
+                                derivAxis = 2;
                             else
                                 throw OpenMMException("Unsupported derivative order for Continuous3DFunction");
+                            string basis[3];
+                            for (int axis = 0; axis < 3; axis++) {
+                                basis[axis] = "h"+axisNames[axis];
+                                if (axis == derivAxis) {
+                                    string t = "d"+axisNames[axis];
+                                    basis[axis] = "g"+axisNames[axis];
+                                    out << "real " << basis[axis] << "[4] = {6*" << t << "*(" << t << "-1), 6*" << t << "*(1-" << t << "), (1-" << t << ")*(1-3*" << t << "), "
+                                        << t << "*(3*" << t << "-2)};\n";
+                                }
+                            }
+                            const string& bx = basis[0];
+                            const string& by = basis[1];
+                            const string& bz = basis[2];
+                            out << nodeNames[j] << suffix << " = 0;\n";
+                            for (int corner = 0; corner < 8; corner++) {
+                                int cx = corner&1, cy = (corner>>1)&1, cz = corner>>2;
+                                string c1 = "c["+to_string(2*corner)+"]", c2 = "c["+to_string(2*corner+1)+"]";
+                                out << nodeNames[j] << suffix << " += " << bz << "[" << cz << "]*(" << by << "[" << cy << "]*(" << bx << "[" << cx << "]*" << c1 << ".x + " << bx << "[" << cx+2 << "]*" << c1 << ".y) + "
+                                    << by << "[" << cy+2 << "]*(" << bx << "[" << cx << "]*" << c1 << ".z + " << bx << "[" << cx+2 << "]*" << c2 << ".x)) + "
+                                    << bz << "[" << cz+2 << "]*(" << by << "[" << cy << "]*(" << bx << "[" << cx << "]*" << c1 << ".w + " << bx << "[" << cx+2 << "]*" << c2 << ".y) + "
+                                    << by << "[" << cy+2 << "]*(" << bx << "[" << cx << "]*" << c2 << ".z + " << bx << "[" << cx+2 << "]*" << c2 << ".w));\n";
+                            }
+                            if (derivAxis >= 0)
+                                out << nodeNames[j] << suffix << " *= " << paramsFloat[9+derivAxis] << ";\n";
                         }
                         if (!periodic)
                             out << "}\n";
@@ -900,7 +908,8 @@ vector<float> ExpressionUtilities::computeFunctionCoefficients(const TabulatedFu
         return f;
     }
     if (dynamic_cast<const Continuous3DFunction*>(&function) != NULL) {
-        // Compute the spline coefficients.
+        // Record the value and derivatives at each grid point.  The kernel builds the spline for each patch
+        // from its corners, which takes one eighth the memory of storing 64 coefficients for every patch.
 
         const Continuous3DFunction& fn = dynamic_cast<const Continuous3DFunction&>(function);
         vector<double> values;
@@ -915,13 +924,16 @@ vector<float> ExpressionUtilities::computeFunctionCoefficients(const TabulatedFu
             y[i] = ymin+i*(ymax-ymin)/(ysize-1);
         for (int i = 0; i < zsize; i++)
             z[i] = zmin+i*(zmax-zmin)/(zsize-1);
-        vector<vector<double> > c;
-        SplineFitter::create3DSpline(x, y, z, values, periodic, c);
-        vector<float> f(64*c.size());
-        for (int i = 0; i < (int) c.size(); i++) {
-            for (int j = 0; j < 64; j++)
-                f[64*i+j] = (float) c[i][j];
-        }
+        vector<double> d;
+        SplineFitter::create3DHermiteSpline(x, y, z, values, periodic, d, &context.getThreadPool());
+
+        // The kernel works in units of grid cells, so scale the derivatives to match.
+
+        double dx = (xmax-xmin)/(xsize-1), dy = (ymax-ymin)/(ysize-1), dz = (zmax-zmin)/(zsize-1);
+        double scale[] = {1.0, dx, dy, dz, dx*dy, dx*dz, dy*dz, dx*dy*dz};
+        vector<float> f(d.size());
+        for (int i = 0; i < (int) d.size(); i++)
+            f[i] = (float) (d[i]*scale[i%8]);
         width = 4;
         return f;
     }
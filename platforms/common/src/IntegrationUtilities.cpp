@@ -29,6 +29,8 @@
 #include "openmm/common/ContextSelector.h"
 #include "CommonKernelSources.h"
 #include "openmm/internal/OSRngSeed.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/internal/TraceRange.h"
 #include "openmm/HarmonicAngleForce.h"
 #include "openmm/VirtualSite.h"
 #include "quern.h"
@@ -37,7 +39,6 @@
 #include <cmath>
 #include <cstdlib>
 #include <map>
-#include <set>
 
 using namespace OpenMM;
 using namespace std;
@@ -92,6 +93,8 @@ struct IntegrationUtilities::ConstraintOrderer : public binary_function<int, int
 
 IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System& system) : context(context),
         randomPos(0), hasOverlappingVsites(false) {
+    ComputeContext::MemoryCategory category(context, "Integration");
+
     // Create workspace arrays.
 
     lastStepSize = mm_double2(0.0, 0.0);
@@ -132,33 +135,53 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
 
     // Identify clusters of three atoms that can be treated with SETTLE.  First, for every
     // atom that might be part of such a cluster, make a list of the two other atoms it is
-    // connected to.
+    // connected to.  Each atom has at most two, so they are stored in flat arrays.
 
     int numAtoms = system.getNumParticles();
-    vector<map<int, float> > settleConstraints(numAtoms);
+    vector<int> numSettlePartners(numAtoms, 0);
+    vector<int> settlePartner(2*numAtoms, -1);
+    vector<float> settleDistance(2*numAtoms);
+    auto addSettlePartner = [&] (int atom, int partner, float dist) {
+        for (int j = 0; j < numSettlePartners[atom]; j++)
+            if (settlePartner[2*atom+j] == partner) {
+                settleDistance[2*atom+j] = dist;
+                return;
+            }
+        int index = 2*atom+numSettlePartners[atom]++;
+        settlePartner[index] = partner;
+        settleDistance[index] = dist;
+    };
     for (int i = 0; i < (int)atom1.size(); i++) {
         if (constraintCount[atom1[i]] == 2 && constraintCount[atom2[i]] == 2) {
-            settleConstraints[atom1[i]][atom2[i]] = (float) distance[i];
-            settleConstraints[atom2[i]][atom1[i]] = (float) distance[i];
+            addSettlePartner(atom1[i], atom2[i], (float) distance[i]);
+            addSettlePartner(atom2[i], atom1[i], (float) distance[i]);
         }
     }
+    auto findSettleDistance = [&] (int atom, int partner) {
+        for (int j = 0; j < numSettlePartners[atom]; j++)
+            if (settlePartner[2*atom+j] == partner)
+                return settleDistance[2*atom+j];
+        return -1.0f;
+    };
 
-    // Now remove the ones that don't actually form closed loops of three atoms.
+    // Now keep only the ones that actually form closed loops of three atoms.  Each atom is checked
+    // independently, so this is done in parallel.
 
-    vector<int> settleClusters;
-    for (int i = 0; i < (int)settleConstraints.size(); i++) {
-        if (settleConstraints[i].size() == 2) {
-            int partner1 = settleConstraints[i].begin()->first;
-            int partner2 = (++settleConstraints[i].begin())->first;
-            if (settleConstraints[partner1].size() != 2 || settleConstraints[partner2].size() != 2 ||
-                    settleConstraints[partner1].find(partner2) == settleConstraints[partner1].end())
-                settleConstraints[i].clear();
-            else if (i < partner1 && i < partner2)
-                settleClusters.push_back(i);
+    vector<char> isSettleAtom(numAtoms, 0);
+    context.getThreadPool().execute([&] (ThreadPool& threads, int threadIndex) {
+        for (int i = threadIndex; i < numAtoms; i += threads.getNumThreads()) {
+            if (numSettlePartners[i] != 2)
+                continue;
+            int partner1 = settlePartner[2*i];
+            int partner2 = settlePartner[2*i+1];
+            isSettleAtom[i] = (numSettlePartners[partner1] == 2 && numSettlePartners[partner2] == 2 && findSettleDistance(partner1, partner2) >= 0);
         }
-        else
-            settleConstraints[i].clear();
-    }
+    });
+    context.getThreadPool().waitForThreads();
+    vector<int> settleClusters;
+    for (int i = 0; i < numAtoms; i++)
+        if (isSettleAtom[i] && i < settlePartner[2*i] && i < settlePartner[2*i+1])
+            settleClusters.push_back(i);
 
     // Record the SETTLE clusters.
 
@@ -168,11 +191,11 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
         vector<mm_float2> params;
         for (int i = 0; i < (int) settleClusters.size(); i++) {
             int atom1 = settleClusters[i];
-            int atom2 = settleConstraints[atom1].begin()->first;
-            int atom3 = (++settleConstraints[atom1].begin())->first;
-            float dist12 = settleConstraints[atom1].find(atom2)->second;
-            float dist13 = settleConstraints[atom1].find(atom3)->second;
-            float dist23 = settleConstraints[atom2].find(atom3)->second;
+            int atom2 = min(settlePartner[2*atom1], settlePartner[2*atom1+1]);
+            int atom3 = max(settlePartner[2*atom1], settlePartner[2*atom1+1]);
+            float dist12 = findSettleDistance(atom1, atom2);
+            float dist13 = findSettleDistance(atom1, atom3);
+            float dist23 = findSettleDistance(atom2, atom3);
             if (dist12 == dist13) {
                 // atom1 is the central atom
                 atoms.push_back(mm_int4(atom1, atom2, atom3, 0));
@@ -359,13 +382,15 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
 
         // Make a list of all atoms that involve a CCMA constraint.
 
-        set<int> ccmaAtomsSet;
+        vector<bool> isCCMAAtom(numAtoms, false);
         for (int i = 0; i < numCCMA; i++) {
-            ccmaAtomsSet.insert(atom1[ccmaConstraints[i]]);
-            ccmaAtomsSet.insert(atom2[ccmaConstraints[i]]);
+            isCCMAAtom[atom1[ccmaConstraints[i]]] = true;
+            isCCMAAtom[atom2[ccmaConstraints[i]]] = true;
         }
-        vector<int> ccmaAtomsVec(ccmaAtomsSet.begin(), ccmaAtomsSet.end());
-        sort(ccmaAtomsVec.begin(), ccmaAtomsVec.end());
+        vector<int> ccmaAtomsVec;
+        for (int i = 0; i < numAtoms; i++)
+            if (isCCMAAtom[i])
+                ccmaAtomsVec.push_back(i);
         numCCMAAtoms = ccmaAtomsVec.size();
 
         // Record the CCMA data structures.
@@ -727,17 +752,25 @@ double IntegrationUtilities::getLastStepSize() {
 }
 
 void IntegrationUtilities::applyConstraints(double tol) {
+    OPENMM_TRACE_RANGE("Apply constraints");
     applyConstraintsImpl(false, tol);
 }
 
 void IntegrationUtilities::applyVelocityConstraints(double tol) {
+    OPENMM_TRACE_RANGE("Apply velocity constraints");
     applyConstraintsImpl(true, tol);
 }
 
+bool IntegrationUtilities::hasConstraints() const {
+    return (settleAtoms.isInitialized() || shakeAtoms.isInitialized() || ccmaConstraintAtoms.isInitialized());
+}
+
 void IntegrationUtilities::computeVirtualSites() {
     ContextSelector selector(context);
-    if (numVsites > 0)
+    if (numVsites > 0) {
+        OPENMM_TRACE_RANGE("Compute virtual sites");
         vsitePositionKernel->execute(numVsites);
+    }
 }
 
 void IntegrationUtilities::initRandomNumberGenerator(unsigned int randomNumberSeed) {
@@ -749,6 +782,7 @@ void IntegrationUtilities::initRandomNumberGenerator(unsigned int randomNumberSe
 
     // Create the random number arrays.
 
+    ComputeContext::MemoryCategory category(context, "Integration");
     lastSeed = randomNumberSeed;
     random.initialize<mm_float4>(context, 4*context.getPaddedNumAtoms(), "random");
     randomSeed.initialize<mm_int4>(context, context.getNumThreadBlocks()*64, "randomSeed");
@@ -811,6 +845,34 @@ void IntegrationUtilities::loadCheckpoint(istream& stream) {
     randomSeed.upload(randomSeedVec);
 }
 
+void IntegrationUtilities::createSnapshot(ComputeArray& randomCopy, ComputeArray& randomSeedCopy, int& position) {
+    if (!random.isInitialized())
+        return;
+    ContextSelector selector(context);
+    if (!randomCopy.isInitialized())
+        randomCopy.initialize(context, random.getSize(), random.getElementSize(), "randomSnapshot");
+    else if (randomCopy.getSize() != random.getSize())
+        randomCopy.resize(random.getSize());
+    if (!randomSeedCopy.isInitialized())
+        randomSeedCopy.initialize(context, randomSeed.getSize(), randomSeed.getElementSize(), "randomSeedSnapshot");
+    random.copyTo(randomCopy);
+    randomSeed.copyTo(randomSeedCopy);
+    position = randomPos;
+}
+
+void IntegrationUtilities::loadSnapshot(ComputeArray& randomCopy, ComputeArray& randomSeedCopy, int position) {
+    if (!random.isInitialized() || !randomCopy.isInitialized())
+        return;
+    ContextSelector selector(context);
+    if (random.getSize() != randomCopy.getSize()) {
+        random.resize(randomCopy.getSize());
+        randomKernel->setArg(0, (int) random.getSize());
+    }
+    randomCopy.copyTo(random);
+    randomSeedCopy.copyTo(randomSeed);
+    randomPos = position;
+}
+
 double IntegrationUtilities::computeKineticEnergy(double timeShift) {
     ContextSelector selector(context);
     int numParticles = context.getNumAtoms();
@@ -1,12 +1,36 @@
 /**
- * Compute the center of each group.
+ * Compute the centers of small groups.  Each thread computes the center of one group.
  */
-KERNEL void computeGroupCenters(int numParticleGroups, GLOBAL const real4* RESTRICT posq, GLOBAL const int* RESTRICT groupParticles,
-        GLOBAL const real* RESTRICT groupWeights, GLOBAL const int* RESTRICT groupOffsets, GLOBAL real4* RESTRICT centerPositions) {
+KERNEL void computeSmallGroupCenters(int numSmallGroups, GLOBAL const real4* RESTRICT posq, GLOBAL const int* RESTRICT groupParticles,
+        GLOBAL const real* RESTRICT groupWeights, GLOBAL const int* RESTRICT groupOffsets, GLOBAL const int* RESTRICT smallGroups,
+        GLOBAL real4* RESTRICT centerPositions) {
+    for (int index = GLOBAL_ID; index < numSmallGroups; index += GLOBAL_SIZE) {
+        int group = smallGroups[index];
+        int firstIndex = groupOffsets[group];
+        int lastIndex = groupOffsets[group+1];
+        real3 center = make_real3(0);
+        for (int i = firstIndex; i < lastIndex; i++) {
+            real weight = groupWeights[i];
+            real4 pos = posq[groupParticles[i]];
+            center.x += weight*pos.x;
+            center.y += weight*pos.y;
+            center.z += weight*pos.z;
+        }
+        centerPositions[group] = make_real4(center.x, center.y, center.z, 0);
+    }
+}
+
+/**
+ * Compute the centers of large groups.  Each thread block computes the center of one group.
+ */
+KERNEL void computeGroupCenters(int numLargeGroups, GLOBAL const real4* RESTRICT posq, GLOBAL const int* RESTRICT groupParticles,
+        GLOBAL const real* RESTRICT groupWeights, GLOBAL const int* RESTRICT groupOffsets, GLOBAL const int* RESTRICT largeGroups,
+        GLOBAL real4* RESTRICT centerPositions) {
     LOCAL volatile real3 temp[64];
-    for (int group = GROUP_ID; group < numParticleGroups; group += NUM_GROUPS) {
+    for (int groupIndex = GROUP_ID; groupIndex < numLargeGroups; groupIndex += NUM_GROUPS) {
         // The threads in this block work together to compute the center one group.
 
+        int group = largeGroups[groupIndex];
         int firstIndex = groupOffsets[group];
         int lastIndex = groupOffsets[group+1];
         real3 center = make_real3(0);
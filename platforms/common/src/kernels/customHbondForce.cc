@@ -60,6 +60,42 @@ typedef struct {
     real3 f1, f2, f3;
 } AcceptorData;
 
+#ifdef USE_CUTOFF
+/**
+ * Find a bounding box for the first atom of each block of 32 donors or acceptors.  The donor blocks
+ * come first, followed by the acceptor blocks.
+ */
+KERNEL void findBlockBounds(GLOBAL const real4* RESTRICT posq, GLOBAL const int4* RESTRICT donorAtoms, GLOBAL const int4* RESTRICT acceptorAtoms,
+        real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
+        GLOBAL real4* RESTRICT blockCenter, GLOBAL real4* RESTRICT blockBoundingBox) {
+    for (int block = GLOBAL_ID; block < NUM_DONOR_BLOCKS+NUM_ACCEPTOR_BLOCKS; block += GLOBAL_SIZE) {
+        bool isDonor = (block < NUM_DONOR_BLOCKS);
+        GLOBAL const int4* atoms = (isDonor ? donorAtoms : acceptorAtoms);
+        int base = 32*(isDonor ? block : block-NUM_DONOR_BLOCKS);
+        int last = min(base+32, isDonor ? NUM_DONORS : NUM_ACCEPTORS);
+        int atom = atoms[base].x;
+        real4 pos = (atom > -1 ? posq[atom] : make_real4(0));
+#ifdef USE_PERIODIC
+        APPLY_PERIODIC_TO_POS(pos)
+#endif
+        real4 minPos = pos;
+        real4 maxPos = pos;
+        for (int i = base+1; i < last; i++) {
+            atom = atoms[i].x;
+            pos = (atom > -1 ? posq[atom] : make_real4(0));
+#ifdef USE_PERIODIC
+            real4 center = 0.5f*(maxPos+minPos);
+            APPLY_PERIODIC_TO_POS_WITH_CENTER(pos, center)
+#endif
+            minPos = make_real4(min(minPos.x,pos.x), min(minPos.y,pos.y), min(minPos.z,pos.z), 0);
+            maxPos = make_real4(max(maxPos.x,pos.x), max(maxPos.y,pos.y), max(maxPos.z,pos.z), 0);
+        }
+        blockBoundingBox[block] = 0.5f*(maxPos-minPos);
+        blockCenter[block] = 0.5f*(maxPos+minPos);
+    }
+}
+#endif
+
 /**
  * Compute forces on donors and acceptors.
  */
@@ -67,7 +103,8 @@ KERNEL void computeHbondForces(
 	GLOBAL mm_ulong* RESTRICT force,
 	GLOBAL mixed* RESTRICT energyBuffer, GLOBAL const real4* RESTRICT posq, GLOBAL const int4* RESTRICT exclusions,
         GLOBAL const int4* RESTRICT donorAtoms, GLOBAL const int4* RESTRICT acceptorAtoms, real4 periodicBoxSize, real4 invPeriodicBoxSize,
-        real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ
+        real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ, GLOBAL const real4* RESTRICT blockCenter,
+        GLOBAL const real4* RESTRICT blockBoundingBox
         PARAMETER_ARGUMENTS) {
     const unsigned int totalWarps = GLOBAL_SIZE/32;
     const unsigned int warp = GLOBAL_ID/32;
@@ -78,6 +115,23 @@ KERNEL void computeHbondForces(
     for (int tile = warp; tile < NUM_DONOR_BLOCKS*NUM_ACCEPTOR_BLOCKS; tile += totalWarps) {
         int donorStart = (tile/NUM_ACCEPTOR_BLOCKS)*32;
         int acceptorStart = (tile%NUM_ACCEPTOR_BLOCKS)*32;
+#ifdef USE_CUTOFF
+        // Skip the tile if the bounding boxes of the donors and acceptors are too far apart for any of them to interact.
+
+        int donorBlock = tile/NUM_ACCEPTOR_BLOCKS;
+        int acceptorBlock = NUM_DONOR_BLOCKS+tile%NUM_ACCEPTOR_BLOCKS;
+        real4 blockDelta = blockCenter[donorBlock]-blockCenter[acceptorBlock];
+#ifdef USE_PERIODIC
+        APPLY_PERIODIC_TO_DELTA(blockDelta)
+#endif
+        real4 donorSize = blockBoundingBox[donorBlock];
+        real4 acceptorSize = blockBoundingBox[acceptorBlock];
+        blockDelta.x = max((real) 0, fabs(blockDelta.x)-donorSize.x-acceptorSize.x);
+        blockDelta.y = max((real) 0, fabs(blockDelta.y)-donorSize.y-acceptorSize.y);
+        blockDelta.z = max((real) 0, fabs(blockDelta.z)-donorSize.z-acceptorSize.z);
+        if (blockDelta.x*blockDelta.x+blockDelta.y*blockDelta.y+blockDelta.z*blockDelta.z >= CUTOFF_SQUARED)
+            continue;
+#endif
 
         // Load information about the donor this thread will compute forces on.
 
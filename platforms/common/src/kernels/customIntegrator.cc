@@ -1,4 +1,4 @@
-KERNEL void computeFloatSum(GLOBAL const float* RESTRICT sumBuffer, GLOBAL float* result, int bufferSize) {
+KERNEL void computeFloatSum(GLOBAL const float* RESTRICT sumBuffer, GLOBAL float* result, int bufferSize, GLOBAL float* RESTRICT globalValues, int globalIndex) {
     LOCAL float tempBuffer[WORK_GROUP_SIZE];
     const unsigned int thread = LOCAL_ID;
     float sum = 0;
@@ -10,12 +10,15 @@ KERNEL void computeFloatSum(GLOBAL const float* RESTRICT sumBuffer, GLOBAL float
         if (thread%(i*2) == 0 && thread+i < WORK_GROUP_SIZE)
             tempBuffer[thread] += tempBuffer[thread+i];
     }
-    if (thread == 0)
+    if (thread == 0) {
         *result = tempBuffer[0];
+        if (globalIndex >= 0)
+            globalValues[globalIndex] = tempBuffer[0];
+    }
 }
 
 #ifdef SUPPORTS_DOUBLE_PRECISION
-KERNEL void computeDoubleSum(GLOBAL const double* RESTRICT sumBuffer, GLOBAL double* result, int bufferSize) {
+KERNEL void computeDoubleSum(GLOBAL const double* RESTRICT sumBuffer, GLOBAL double* result, int bufferSize, GLOBAL double* RESTRICT globalValues, int globalIndex) {
     LOCAL double tempBuffer[WORK_GROUP_SIZE];
     const unsigned int thread = LOCAL_ID;
     double sum = 0;
@@ -27,8 +30,11 @@ KERNEL void computeDoubleSum(GLOBAL const double* RESTRICT sumBuffer, GLOBAL dou
         if (thread%(i*2) == 0 && thread+i < WORK_GROUP_SIZE)
             tempBuffer[thread] += tempBuffer[thread+i];
     }
-    if (thread == 0)
+    if (thread == 0) {
         *result = tempBuffer[0];
+        if (globalIndex >= 0)
+            globalValues[globalIndex] = tempBuffer[0];
+    }
 }
 #endif
 
@@ -0,0 +1,11 @@
+/**
+ * Add the forces computed by an ExternalForce to the force buffer.
+ */
+KERNEL void addExternalForces(GLOBAL mm_long* RESTRICT forceBuffers, GLOBAL const real4* RESTRICT externalForces, int numAtoms, int paddedNumAtoms) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+        real4 f = externalForces[i];
+        forceBuffers[i] += realToFixedPoint(f.x);
+        forceBuffers[i+paddedNumAtoms] += realToFixedPoint(f.y);
+        forceBuffers[i+2*paddedNumAtoms] += realToFixedPoint(f.z);
+    }
+}
@@ -0,0 +1,27 @@
+/**
+ * Copy the positions of a subset of atoms into a compact array, so only those atoms need to be downloaded.
+ */
+KERNEL void gatherPositions(GLOBAL const real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL const real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL const int* RESTRICT atoms, GLOBAL mixed4* RESTRICT output, int numAtoms) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+        int atom = atoms[i];
+        real4 pos1 = posq[atom];
+#ifdef USE_MIXED_PRECISION
+        real4 pos2 = posqCorrection[atom];
+        output[i] = make_mixed4(pos1.x+(mixed)pos2.x, pos1.y+(mixed)pos2.y, pos1.z+(mixed)pos2.z, 0);
+#else
+        output[i] = make_mixed4(pos1.x, pos1.y, pos1.z, 0);
+#endif
+    }
+}
+
+/**
+ * Copy the velocities of a subset of atoms into a compact array, so only those atoms need to be downloaded.
+ */
+KERNEL void gatherVelocities(GLOBAL const mixed4* RESTRICT velm, GLOBAL const int* RESTRICT atoms, GLOBAL mixed4* RESTRICT output, int numAtoms) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE)
+        output[i] = velm[atoms[i]];
+}
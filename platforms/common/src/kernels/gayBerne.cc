@@ -34,11 +34,10 @@ KERNEL void computeEllipsoidFrames(int numParticles, GLOBAL const real4* RESTRIC
         }
         zdir = cross(xdir, ydir);
 
-        // Compute matrices we will need later.
+        // Compute matrices we will need later.  B and G are symmetric, so only their upper triangles
+        // are stored.
 
-        GLOBAL real (*a)[3] = (GLOBAL real (*)[3]) (aMatrix+sortedIndex*9);
-        GLOBAL real (*b)[3] = (GLOBAL real (*)[3]) (bMatrix+sortedIndex*9);
-        GLOBAL real (*g)[3] = (GLOBAL real (*)[3]) (gMatrix+sortedIndex*9);
+        real a[3][3];
         a[0][0] = xdir.x;
         a[0][1] = xdir.y;
         a[0][2] = xdir.z;
@@ -48,13 +47,18 @@ KERNEL void computeEllipsoidFrames(int numParticles, GLOBAL const real4* RESTRIC
         a[2][0] = zdir.x;
         a[2][1] = zdir.y;
         a[2][2] = zdir.z;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                aMatrix[9*sortedIndex+3*i+j] = a[i][j];
         float4 sig = sigParams[originalIndex];
         float3 r2 = make_float3(sig.y, sig.z, sig.w);
         float3 e2 = trimTo3(scale[originalIndex]);
+        int k = 6*sortedIndex;
         for (int i = 0; i < 3; i++)
-            for (int j = 0; j < 3; j++) {
-                b[i][j] = a[0][i]*e2.x*a[0][j] + a[1][i]*e2.y*a[1][j] + a[2][i]*e2.z*a[2][j];
-                g[i][j] = a[0][i]*r2.x*a[0][j] + a[1][i]*r2.y*a[1][j] + a[2][i]*r2.z*a[2][j];
+            for (int j = i; j < 3; j++) {
+                bMatrix[k] = a[0][i]*e2.x*a[0][j] + a[1][i]*e2.y*a[1][j] + a[2][i]*e2.z*a[2][j];
+                gMatrix[k] = a[0][i]*r2.x*a[0][j] + a[1][i]*r2.y*a[1][j] + a[2][i]*r2.z*a[2][j];
+                k++;
             }
     }
 }
@@ -184,11 +188,14 @@ DEVICE void loadAtomData(AtomData* data, int sortedIndex, int originalIndex, GLO
     data->eps = epsParams[originalIndex];
     data->pos = trimTo3(pos[sortedIndex]);
     for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++) {
-            int k = 9*sortedIndex+3*i+j;
-            data->a[i][j] = aMatrix[k];
-            data->b[i][j] = bMatrix[k];
-            data->g[i][j] = gMatrix[k];
+        for (int j = 0; j < 3; j++)
+            data->a[i][j] = aMatrix[9*sortedIndex+3*i+j];
+    int k = 6*sortedIndex;
+    for (int i = 0; i < 3; i++)
+        for (int j = i; j < 3; j++) {
+            data->b[i][j] = data->b[j][i] = bMatrix[k];
+            data->g[i][j] = data->g[j][i] = gMatrix[k];
+            k++;
         }
 }
 
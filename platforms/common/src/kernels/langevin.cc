@@ -10,6 +10,8 @@ KERNEL void integrateLangevinPart1(int numAtoms, int paddedNumAtoms, GLOBAL mixe
     mixed fscale = paramBuffer[ForceScale]/(mixed) 0x100000000;
     mixed noisescale = paramBuffer[NoiseScale];
     mixed stepSize = dt[0].y;
+    if (stepSize == 0)
+        return;
     int index = GLOBAL_ID;
     randomIndex += index;
     while (index < numAtoms) {
@@ -36,6 +38,8 @@ KERNEL void integrateLangevinPart2(int numAtoms, GLOBAL real4* RESTRICT posq, GL
         , GLOBAL real4* RESTRICT posqCorrection
 #endif
         ) {
+    if (dt[0].y == 0)
+        return;
 #ifdef SUPPORTS_DOUBLE_PRECISION
     double invStepSize = 1.0/dt[0].y;
 #else
@@ -82,8 +86,8 @@ KERNEL void integrateLangevinPart2(int numAtoms, GLOBAL real4* RESTRICT posq, GL
  * Select the step size to use for the next step.
  */
 
-KERNEL void selectLangevinStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, mixed friction, mixed kT, GLOBAL mixed2* RESTRICT dt,
-        GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force, GLOBAL mixed* RESTRICT paramBuffer) {
+KERNEL void selectLangevinStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, mixed friction, mixed kT, mixed remainingTime, int resetState,
+        GLOBAL mixed2* RESTRICT dt, GLOBAL mixed4* RESTRICT stepState, GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force, GLOBAL mixed* RESTRICT paramBuffer) {
     // Calculate the error.
 
     LOCAL mixed error[256];
@@ -108,15 +112,36 @@ KERNEL void selectLangevinStepSize(int numAtoms, int paddedNumAtoms, mixed maxSt
     if (GLOBAL_ID == 0) {
         // Select the new step size.
 
+        mixed4 state = stepState[0];
+        mixed4 sizes = stepState[1];
+        if (resetState)
+            state = make_mixed4(0, 0, 0, 0);
         mixed totalError = SQRT(error[0]/(numAtoms*3));
         mixed newStepSize = SQRT(errorTol/totalError);
-        mixed oldStepSize = dt[0].y;
+        mixed oldStepSize = (dt[0].y > 0 ? dt[0].y : sizes.x);
         if (oldStepSize > 0.0f)
             newStepSize = min(newStepSize, oldStepSize*2.0f); // For safety, limit how quickly dt can increase.
         if (newStepSize > oldStepSize && newStepSize < 1.1f*oldStepSize)
             newStepSize = oldStepSize; // Keeping dt constant between steps improves the behavior of the integrator.
         if (newStepSize > maxStepSize)
             newStepSize = maxStepSize;
+
+        // Do not go past the target time.  Once it has been reached, any further steps do nothing.
+
+        if (state.z != 0)
+            newStepSize = 0;
+        else {
+            sizes.y = newStepSize;
+            if (newStepSize >= remainingTime-state.x) {
+                newStepSize = remainingTime-state.x;
+                state.z = 1;
+            }
+            state.x += newStepSize;
+            state.y += 1;
+            sizes.x = newStepSize;
+        }
+        stepState[0] = state;
+        stepState[1] = sizes;
         dt[0].y = newStepSize;
 
         // Recalculate the integration parameters.
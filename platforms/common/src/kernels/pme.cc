@@ -282,6 +282,72 @@ KERNEL void gridEvaluateEnergy(GLOBAL real2* RESTRICT pmeGrid, GLOBAL mixed* RES
 #endif
 }
 
+/**
+ * This combines gridEvaluateEnergy() and reciprocalConvolution() into a single pass over the grid.
+ * It works directly on the half complex grid.  Every element other than the ones with kz=0 (and
+ * kz=GRID_SIZE_Z/2 when GRID_SIZE_Z is even) stands for itself and its complex conjugate, so it
+ * contributes twice to the energy.  This must be executed with the same number of threads as
+ * gridEvaluateEnergy(), since it writes to the same energy buffer.
+ */
+KERNEL void reciprocalConvolutionWithEnergy(GLOBAL real2* RESTRICT pmeGrid, GLOBAL mixed* RESTRICT energyBuffer,
+        GLOBAL const real* RESTRICT pmeBsplineModuliX, GLOBAL const real* RESTRICT pmeBsplineModuliY, GLOBAL const real* RESTRICT pmeBsplineModuliZ,
+        real4 recipBoxVecX, real4 recipBoxVecY, real4 recipBoxVecZ) {
+    const unsigned int gridSize = GRID_SIZE_X*GRID_SIZE_Y*(GRID_SIZE_Z/2+1);
+#ifdef USE_LJPME
+    const real recipScaleFactor = -(2*M_PI/6)*SQRT(M_PI)*recipBoxVecX.x*recipBoxVecY.y*recipBoxVecZ.z;
+    real bfac = M_PI / EWALD_ALPHA;
+    real fac1 = 2*M_PI*M_PI*M_PI*SQRT(M_PI);
+    real fac2 = EWALD_ALPHA*EWALD_ALPHA*EWALD_ALPHA;
+    real fac3 = -2*EWALD_ALPHA*M_PI*M_PI;
+#else
+    const real recipScaleFactor = RECIP(M_PI)*recipBoxVecX.x*recipBoxVecY.y*recipBoxVecZ.z;
+#endif
+
+    mixed energy = 0;
+    for (int index = GLOBAL_ID; index < gridSize; index += GLOBAL_SIZE) {
+        int kx = index/(GRID_SIZE_Y*(GRID_SIZE_Z/2+1));
+        int remainder = index-kx*GRID_SIZE_Y*(GRID_SIZE_Z/2+1);
+        int ky = remainder/(GRID_SIZE_Z/2+1);
+        int kz = remainder-ky*(GRID_SIZE_Z/2+1);
+        int mx = (kx < (GRID_SIZE_X+1)/2) ? kx : (kx-GRID_SIZE_X);
+        int my = (ky < (GRID_SIZE_Y+1)/2) ? ky : (ky-GRID_SIZE_Y);
+        int mz = (kz < (GRID_SIZE_Z+1)/2) ? kz : (kz-GRID_SIZE_Z);
+        real mhx = mx*recipBoxVecX.x;
+        real mhy = mx*recipBoxVecY.x+my*recipBoxVecY.y;
+        real mhz = mx*recipBoxVecZ.x+my*recipBoxVecZ.y+mz*recipBoxVecZ.z;
+        real bx = pmeBsplineModuliX[kx];
+        real by = pmeBsplineModuliY[ky];
+        real bz = pmeBsplineModuliZ[kz];
+        real2 grid = pmeGrid[index];
+        real m2 = mhx*mhx+mhy*mhy+mhz*mhz;
+        real weight = (kz == 0 || 2*kz == GRID_SIZE_Z ? 1 : 2);
+#ifdef USE_LJPME
+        real denom = recipScaleFactor/(bx*by*bz);
+        real m = SQRT(m2);
+        real m3 = m*m2;
+        real b = bfac*m;
+        real expfac = -b*b;
+        real expterm = EXP(expfac);
+        real erfcterm = ERFC(b);
+        real eterm = (fac1*erfcterm*m3 + expterm*(fac2 + fac3*m2)) * denom;
+        energy += weight*eterm*(grid.x*grid.x + grid.y*grid.y);
+        pmeGrid[index] = make_real2(grid.x*eterm, grid.y*eterm);
+#else
+        real denom = m2*bx*by*bz;
+        real eterm = recipScaleFactor*EXP(-RECIP_EXP_FACTOR*m2)/denom;
+        if (kx != 0 || ky != 0 || kz != 0) {
+            energy += weight*eterm*(grid.x*grid.x + grid.y*grid.y);
+            pmeGrid[index] = make_real2(grid.x*eterm, grid.y*eterm);
+        }
+#endif
+    }
+#if defined(USE_PME_STREAM) && !defined(USE_LJPME)
+    energyBuffer[GLOBAL_ID] = 0.5f*energy;
+#else
+    energyBuffer[GLOBAL_ID] += 0.5f*energy;
+#endif
+}
+
 #if defined(USE_HIP) && !defined(AMD_RDNA) && !defined(USE_DOUBLE_PRECISION)
 LAUNCH_BOUNDS_EXACT(128, 1)
 #endif
@@ -22,11 +22,66 @@ DEVICE real reduceValue(real value, LOCAL_ARG volatile real* temp) {
     return temp[0];
 }
 
+#ifdef SUPPORTS_DOUBLE_PRECISION
+typedef double eigenreal;
+#define EIGEN_TOLERANCE 1e-30
+#else
+typedef float eigenreal;
+#define EIGEN_TOLERANCE 1e-12f
+#endif
+
+/**
+ * Find the eigenvalues and eigenvectors of a symmetric 4x4 matrix with the cyclic Jacobi method.
+ * On exit, the diagonal of a contains the eigenvalues and the columns of v contain the eigenvectors.
+ */
+DEVICE void diagonalizeMatrix(eigenreal a[4][4], eigenreal v[4][4]) {
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            v[i][j] = (i == j ? 1 : 0);
+    for (int sweep = 0; sweep < 50; sweep++) {
+        eigenreal offDiagonal = 0, diagonal = 0;
+        for (int p = 0; p < 4; p++) {
+            diagonal += a[p][p]*a[p][p];
+            for (int q = p+1; q < 4; q++)
+                offDiagonal += a[p][q]*a[p][q];
+        }
+        if (offDiagonal <= EIGEN_TOLERANCE*diagonal)
+            return;
+        for (int p = 0; p < 4; p++)
+            for (int q = p+1; q < 4; q++) {
+                if (a[p][q] == 0)
+                    continue;
+                eigenreal theta = (a[q][q]-a[p][p])/(2*a[p][q]);
+                eigenreal t = 1/(fabs(theta)+SQRT(theta*theta+1));
+                if (theta < 0)
+                    t = -t;
+                eigenreal c = 1/SQRT(t*t+1);
+                eigenreal s = t*c;
+                for (int k = 0; k < 4; k++) {
+                    eigenreal akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c*akp - s*akq;
+                    a[k][q] = s*akp + c*akq;
+                }
+                for (int k = 0; k < 4; k++) {
+                    eigenreal apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c*apk - s*aqk;
+                    a[q][k] = s*apk + c*aqk;
+                }
+                for (int k = 0; k < 4; k++) {
+                    eigenreal vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c*vkp - s*vkq;
+                    v[k][q] = s*vkp + c*vkq;
+                }
+            }
+    }
+}
+
 /**
- * Perform the first step of computing the RMSD.  This is executed as a single work group.
+ * Perform the first step of computing the RMSD: find the optimal rotation and the RMSD itself.
+ * This is executed as a single work group.
  */
 KERNEL void computeRMSDPart1(int numParticles, GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT referencePos,
-        GLOBAL const int* RESTRICT particles, GLOBAL real* buffer) {
+        GLOBAL const int* RESTRICT particles, GLOBAL real* buffer, real sumNormRef) {
     LOCAL volatile real temp[THREAD_BLOCK_SIZE];
 
     // Compute the center of the particle positions.
@@ -62,13 +117,54 @@ KERNEL void computeRMSDPart1(int numParticles, GLOBAL const real4* RESTRICT posq
             R[i][j] = reduceValue(R[i][j], temp);
     sum = reduceValue(sum, temp);
 
-    // Copy everything into the output buffer to send back to the host.
+    // Build the F matrix and find its largest eigenvalue and the corresponding eigenvector.
     
     if (LOCAL_ID == 0) {
-        for (int i = 0; i < 3; i++)
-            for (int j = 0; j < 3; j++)
-                buffer[3*i+j] = R[i][j];
-        buffer[9] = sum;
+        eigenreal F[4][4], V[4][4];
+        F[0][0] =  R[0][0] + R[1][1] + R[2][2];
+        F[1][0] =  R[1][2] - R[2][1];
+        F[2][0] =  R[2][0] - R[0][2];
+        F[3][0] =  R[0][1] - R[1][0];
+        F[0][1] =  R[1][2] - R[2][1];
+        F[1][1] =  R[0][0] - R[1][1] - R[2][2];
+        F[2][1] =  R[0][1] + R[1][0];
+        F[3][1] =  R[0][2] + R[2][0];
+        F[0][2] =  R[2][0] - R[0][2];
+        F[1][2] =  R[0][1] + R[1][0];
+        F[2][2] = -R[0][0] + R[1][1] - R[2][2];
+        F[3][2] =  R[1][2] + R[2][1];
+        F[0][3] =  R[0][1] - R[1][0];
+        F[1][3] =  R[0][2] + R[2][0];
+        F[2][3] =  R[1][2] + R[2][1];
+        F[3][3] = -R[0][0] - R[1][1] + R[2][2];
+        diagonalizeMatrix(F, V);
+        int best = 0;
+        for (int i = 1; i < 4; i++)
+            if (F[i][i] > F[best][best])
+                best = i;
+
+        // Compute the RMSD.  If the particles are perfectly aligned, numerical error could lead to
+        // NaNs, so just record an RMSD of 0, which tells the second kernel not to apply forces.
+
+        eigenreal msd = (sumNormRef+sum-2*F[best][best])/numParticles;
+        buffer[9] = (msd < (eigenreal) 1e-20 ? 0 : SQRT(msd));
+
+        // Compute the rotation matrix.
+
+        eigenreal q[] = {V[0][best], V[1][best], V[2][best], V[3][best]};
+        eigenreal q00 = q[0]*q[0], q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3];
+        eigenreal q11 = q[1]*q[1], q12 = q[1]*q[2], q13 = q[1]*q[3];
+        eigenreal q22 = q[2]*q[2], q23 = q[2]*q[3];
+        eigenreal q33 = q[3]*q[3];
+        buffer[0] = q00+q11-q22-q33;
+        buffer[1] = 2*(q12-q03);
+        buffer[2] = 2*(q13+q02);
+        buffer[3] = 2*(q12+q03);
+        buffer[4] = q00-q11+q22-q33;
+        buffer[5] = 2*(q23-q01);
+        buffer[6] = 2*(q13-q02);
+        buffer[7] = 2*(q23+q01);
+        buffer[8] = q00-q11-q22+q33;
         buffer[10] = center.x;
         buffer[11] = center.y;
         buffer[12] = center.z;
@@ -79,7 +175,11 @@ KERNEL void computeRMSDPart1(int numParticles, GLOBAL const real4* RESTRICT posq
  * Apply forces based on the RMSD.
  */
 KERNEL void computeRMSDForces(int numParticles, int paddedNumAtoms, GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT referencePos,
-        GLOBAL const int* RESTRICT particles, GLOBAL const real* buffer, GLOBAL mm_long* RESTRICT forceBuffers) {
+        GLOBAL const int* RESTRICT particles, GLOBAL const real* buffer, GLOBAL mm_long* RESTRICT forceBuffers, GLOBAL mixed* RESTRICT energyBuffer) {
+    if (buffer[9] == 0)
+        return;
+    if (GLOBAL_ID == 0)
+        energyBuffer[0] += buffer[9];
     real3 center = make_real3(buffer[10], buffer[11], buffer[12]);
     real scale = 1 / (real) (buffer[9]*numParticles);
     for (int i = GLOBAL_ID; i < numParticles; i += GLOBAL_SIZE) {
@@ -9,6 +9,8 @@ KERNEL void integrateVerletPart1(int numAtoms, int paddedNumAtoms, GLOBAL const
 #endif
     ) {
     const mixed2 stepSize = dt[0];
+    if (stepSize.y == 0)
+        return;
     const mixed dtPos = stepSize.y;
     const mixed dtVel = 0.5f*(stepSize.x+stepSize.y);
     const mixed scale = dtVel/(mixed) 0x100000000;
@@ -45,6 +47,8 @@ KERNEL void integrateVerletPart2(int numAtoms, GLOBAL mixed2* RESTRICT dt, GLOBA
 #endif
     ) {
     mixed2 stepSize = dt[0];
+    if (stepSize.y == 0)
+        return;
 #ifdef SUPPORTS_DOUBLE_PRECISION
     double oneOverDt = 1.0/stepSize.y;
 #else
@@ -89,7 +93,8 @@ KERNEL void integrateVerletPart2(int numAtoms, GLOBAL mixed2* RESTRICT dt, GLOBA
  * Select the step size to use for the next step.
  */
 
-KERNEL void selectVerletStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, GLOBAL mixed2* RESTRICT dt, GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force) {
+KERNEL void selectVerletStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, mixed remainingTime, int resetState, GLOBAL mixed2* RESTRICT dt,
+        GLOBAL mixed4* RESTRICT stepState, GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force) {
     // Calculate the error.
 
     LOCAL mixed error[256];
@@ -111,15 +116,36 @@ KERNEL void selectVerletStepSize(int numAtoms, int paddedNumAtoms, mixed maxStep
         SYNC_THREADS;
     }
     if (LOCAL_ID == 0) {
+        mixed4 state = stepState[0];
+        mixed4 sizes = stepState[1];
+        if (resetState)
+            state = make_mixed4(0, 0, 0, 0);
         mixed totalError = SQRT(error[0]/(numAtoms*3));
         mixed newStepSize = SQRT(errorTol/totalError);
-        mixed oldStepSize = dt[0].y;
+        mixed oldStepSize = (dt[0].y > 0 ? dt[0].y : sizes.x);
         if (oldStepSize > 0.0f)
             newStepSize = min(newStepSize, oldStepSize*2.0f); // For safety, limit how quickly dt can increase.
         if (newStepSize > oldStepSize && newStepSize < 1.1f*oldStepSize)
             newStepSize = oldStepSize; // Keeping dt constant between steps improves the behavior of the integrator.
         if (newStepSize > maxStepSize)
             newStepSize = maxStepSize;
+
+        // Do not go past the target time.  Once it has been reached, any further steps do nothing.
+
+        if (state.z != 0)
+            newStepSize = 0;
+        else {
+            sizes.y = newStepSize;
+            if (newStepSize >= remainingTime-state.x) {
+                newStepSize = remainingTime-state.x;
+                state.z = 1;
+            }
+            state.x += newStepSize;
+            state.y += 1;
+            sizes.x = newStepSize;
+        }
+        stepState[0] = state;
+        stepState[1] = sizes;
         dt[0].y = newStepSize;
     }
 }
@@ -56,6 +56,17 @@ public:
      */
     void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
             double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+    /**
+     * Compute the forces from all bonds, using a separate ReferenceBondIxn for each thread.  This is needed
+     * for interactions that are not thread safe, such as ones that evaluate compiled expressions.
+     *
+     * @param threadBondIxn         the ReferenceBondIxn to use for each thread
+     * @param numEnergyParamDerivs  the number of energy parameter derivatives computed by the interaction
+     * @param energyParamDerivs     the derivatives of the energy with respect to parameters are added to this.
+     *                              It must have at least numEnergyParamDerivs elements.
+     */
+    void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
+            double* totalEnergy, std::vector<ReferenceBondIxn*>& threadBondIxn, int numEnergyParamDerivs, double* energyParamDerivs);
     /**
      * This routine contains the code executed by each thread.
      */
@@ -0,0 +1,99 @@
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Contributors: agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef OPENMM_CPU_CUSTOM_EXTERNAL_FORCE_H__
+#define OPENMM_CPU_CUSTOM_EXTERNAL_FORCE_H__
+
+#include "AlignedArray.h"
+#include "windowsExportCpu.h"
+#include "openmm/Vec3.h"
+#include "openmm/internal/ThreadPool.h"
+#include "lepton/CompiledVectorExpression.h"
+#include "lepton/ParsedExpression.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes a CustomExternalForce.  The particles are divided between threads, and each
+ * thread evaluates the energy and its gradient for a batch of particles at once using a
+ * CompiledVectorExpression.
+ */
+
+class OPENMM_EXPORT_CPU CpuCustomExternalForce {
+public:
+    class ThreadData;
+    /**
+     * Create a CpuCustomExternalForce.
+     *
+     * @param energyExpression  the expression for the energy of each particle
+     * @param parameterNames    the names of the per-particle parameters
+     * @param threads           the thread pool to use
+     */
+    CpuCustomExternalForce(const Lepton::ParsedExpression& energyExpression, const std::vector<std::string>& parameterNames, ThreadPool& threads);
+    ~CpuCustomExternalForce();
+    /**
+     * Compute the forces and energy.
+     *
+     * @param particles          the index of the particle each term is applied to
+     * @param atomCoordinates    the positions of all particles
+     * @param parameters         the per-particle parameters of each term
+     * @param globalParameters   the values of global parameters
+     * @param threadForce        the force buffers for each thread, to which forces are added
+     * @param includeForces      whether to compute forces
+     * @param includeEnergy      whether to compute the energy
+     * @param totalEnergy        the energy is added to this
+     */
+    void calculateForce(const std::vector<int>& particles, const std::vector<Vec3>& atomCoordinates, const std::vector<std::vector<double> >& parameters,
+            const std::map<std::string, double>& globalParameters, std::vector<AlignedArray<float> >& threadForce, bool includeForces, bool includeEnergy,
+            double& totalEnergy);
+private:
+    void threadComputeForce(ThreadPool& threads, int threadIndex);
+    ThreadPool& threads;
+    int width;
+    std::vector<ThreadData*> threadData;
+    // The following variables are used to make information accessible to the individual threads.
+    const std::vector<int>* particles;
+    const std::vector<Vec3>* atomCoordinates;
+    const std::vector<std::vector<double> >* parameters;
+    const std::map<std::string, double>* globalParameters;
+    std::vector<AlignedArray<float> >* threadForce;
+    bool includeForces, includeEnergy;
+};
+
+class CpuCustomExternalForce::ThreadData {
+public:
+    ThreadData(const Lepton::CompiledVectorExpression& expression, const std::vector<std::string>& parameterNames);
+    Lepton::CompiledVectorExpression expression;
+    float *x, *y, *z;
+    std::vector<float*> params;
+    std::map<std::string, float*> globals;
+    std::vector<float> unused;
+    double energy;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_CPU_CUSTOM_EXTERNAL_FORCE_H__
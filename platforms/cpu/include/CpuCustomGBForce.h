@@ -27,6 +27,7 @@
 
 #include "CpuNeighborList.h"
 #include "lepton/CompiledExpression.h"
+#include "lepton/CompiledVectorExpression.h"
 #include "openmm/CustomGBForce.h"
 #include "openmm/internal/CompiledExpressionSet.h"
 #include "openmm/internal/ThreadPool.h"
@@ -48,7 +49,7 @@ private:
     float periodicBoxSize[3];
     float cutoffDistance, cutoffDistance2;
     int numValues, numParams;
-    const std::vector<std::set<int> > exclusions;
+    const CpuExclusionList exclusions;
     std::vector<CustomGBForce::ComputationType> valueTypes;
     std::vector<CustomGBForce::ComputationType> energyTypes;
     ThreadPool& threads;
@@ -57,6 +58,7 @@ private:
     std::vector<std::vector<std::vector<float> > > dValuedParam;
     // Workspace vectors
     std::vector<std::vector<float> > values, dEdV;
+    std::vector<float> dEdV0;
     // The following variables are used to make information accessible to the individual threads.
     int numberOfAtoms;
     float* posq;
@@ -99,6 +101,31 @@ private:
     void calculateOnePairValue(int index, int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
                                std::vector<float>& valueArray, const fvec4& boxSize, const fvec4& invBoxSize);
 
+    /**
+     * Add a single atom pair to the batch that is evaluated with vectorized expressions.  Pairs beyond
+     * the cutoff are skipped.
+     * 
+     * @param atom1            the index of the first atom in the pair
+     * @param atom2            the index of the second atom in the pair
+     * @param data             workspace for the current thread
+     * @param posq             atom coordinates
+     * @param atomParameters   atomParameters[atomIndex][paramterIndex]
+     * @param includeValues    specifies whether to record the computed values of the two atoms
+     * @return true if the pair was added to the batch
+     */
+
+    bool addPairToBatch(int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
+                        bool includeValues, const fvec4& boxSize, const fvec4& invBoxSize);
+
+    /**
+     * Evaluate the first computed value for all pairs in the current batch, then empty the batch.
+     * 
+     * @param data             workspace for the current thread
+     * @param valueArray       the value for each atom is added to this
+     */
+
+    void flushPairValueBatch(ThreadData& data, std::vector<float>& valueArray);
+
     /**
      * Calculate an energy term of type SingleParticle
      * 
@@ -145,6 +172,17 @@ private:
     void calculateOnePairEnergyTerm(int index, int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
                                float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
+    /**
+     * Evaluate an energy term for all pairs in the current batch, then empty the batch.
+     * 
+     * @param index            the index of the term to compute
+     * @param data             workspace for the current thread
+     * @param forces           forces on atoms are added to this
+     * @param totalEnergy      the energy contribution is added to this
+     */
+
+    void flushPairEnergyBatch(int index, ThreadData& data, float* forces, double& totalEnergy);
+
     /**
      * Apply the chain rule to compute forces on atoms
      * 
@@ -159,19 +197,13 @@ private:
                                     float* forces, const fvec4& boxSize, const fvec4& invBoxSize);
 
     /**
-     * Evaluate a single atom pair as part of applying the chain rule
+     * Apply the chain rule for all pairs in the current batch, then empty the batch.
      * 
-     * @param atom1            the index of the first atom in the pair
-     * @param atom2            the index of the second atom in the pair
      * @param data             workspace for the current thread
-     * @param posq             atom coordinates
-     * @param atomParameters   atomParameters[atomIndex][paramterIndex]
      * @param forces           forces on atoms are added to this
-     * @param isExcluded       specifies whether this is an excluded pair
      */
 
-    void calculateOnePairChainRule(int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
-                               float* forces, bool isExcluded, const fvec4& boxSize, const fvec4& invBoxSize);
+    void flushPairChainRuleBatch(ThreadData& data, float* forces);
 
     /**
      * Compute the displacement and squared distance between two points, optionally using
@@ -183,9 +215,14 @@ public:
 
     /**
      * Construct a new CpuCustomGBForce.
+     *
+     * The vectorized expressions are used to evaluate the pair interactions several pairs at a time.
+     * valueVecExpressions should contain the first computed value and its derivative with respect to r.
+     * energyVecExpressions[i] should contain energy term i followed by the same derivatives found in
+     * energyDerivExpressions[i].  It should be empty for terms of type SingleParticle.
      */
 
-     CpuCustomGBForce(int numAtoms, const std::vector<std::set<int> >& exclusions,
+     CpuCustomGBForce(int numAtoms, const CpuExclusionList& exclusions,
                         const std::vector<Lepton::CompiledExpression>& valueExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueGradientExpressions,
@@ -197,7 +234,9 @@ public:
                         const std::vector<std::vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
                         const std::vector<CustomGBForce::ComputationType>& energyTypes,
-                        const std::vector<std::string>& parameterNames, ThreadPool& threads);
+                        const std::vector<std::string>& parameterNames,
+                        const std::vector<Lepton::CompiledVectorExpression>& valueVecExpressions,
+                        const std::vector<std::vector<Lepton::CompiledVectorExpression> >& energyVecExpressions, ThreadPool& threads);
 
      ~CpuCustomGBForce();
 
@@ -248,7 +287,9 @@ public:
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyDerivExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
-               const std::vector<std::string>& parameterNames);
+               const std::vector<std::string>& parameterNames,
+               const std::vector<Lepton::CompiledVectorExpression>& valueVecExpressions,
+               const std::vector<std::vector<Lepton::CompiledVectorExpression> >& energyVecExpressions);
     CompiledExpressionSet expressionSet;
     std::vector<Lepton::CompiledExpression> valueExpressions;
     std::vector<std::vector<Lepton::CompiledExpression> > valueDerivExpressions;
@@ -265,10 +306,16 @@ public:
     double x, y, z, r;
     int firstAtom, lastAtom;
     // Workspace vectors
-    std::vector<float> value0, dVdR1, dVdR2, dVdX, dVdY, dVdZ;
+    std::vector<float> value0, dVdV0, dVdX, dVdY, dVdZ;
     std::vector<std::vector<float> > dEdV;
     std::vector<std::vector<float> > dValue0dParam;
     std::vector<float> energyParamDerivs;
+    // Vectorized expressions and the batch of pairs they are evaluated for
+    std::vector<Lepton::CompiledVectorExpression> valueVecExpressions;
+    std::vector<std::vector<Lepton::CompiledVectorExpression> > energyVecExpressions;
+    int vecWidth, batchSize;
+    std::vector<float> vecR, vecParticleParam, vecParticleValue, batchDeltaR;
+    std::vector<int> batchAtom1, batchAtom2;
 };
 
 } // namespace OpenMM
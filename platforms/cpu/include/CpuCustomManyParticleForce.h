@@ -55,10 +55,11 @@ private:
     AlignedArray<fvec4> periodicBoxVec4;
     CpuNeighborList* neighborList;
     ThreadPool& threads;
-    std::vector<std::set<int> > exclusions;
+    CpuExclusionList exclusions;
     std::vector<int> particleTypes;
     std::vector<int> orderIndex;
     std::vector<std::vector<int> > particleOrder;
+    std::vector<std::vector<bool> > validTypePrefix;
     std::vector<std::vector<int> > particleNeighbors;
     std::vector<ThreadData*> threadData;
     // The following variables are used to make information accessible to the individual threads.
@@ -74,6 +75,12 @@ private:
      */
     void threadComputeForce(ThreadPool& threads, int threadIndex);
 
+    /**
+     * Determine whether the types of the particles found so far, plus one more particle, could be
+     * completed to a set of particles allowed by the type filters.
+     */
+    bool isValidTypePrefix(const std::vector<int>& particleSet, int loopIndex, int particle) const;
+
     /**
      * This is called recursively to loop over all possible combination of a set of particles and evaluate the
      * interaction for each one.
@@ -51,7 +51,7 @@ public:
        CpuCustomNonbondedForce(ThreadPool& threads, const CpuNeighborList& neighbors);
 
        void initialize(const Lepton::ParsedExpression& energyExpression, const Lepton::ParsedExpression& forceExpression,
-                       const std::vector<std::string>& parameterNames, const std::vector<std::set<int> >& exclusions,
+                       const std::vector<std::string>& parameterNames, const CpuExclusionList& exclusions,
                        const std::vector<Lepton::ParsedExpression> energyParamDerivExpressions,
                        const std::vector<std::string>& computedValueNames, const std::vector<Lepton::ParsedExpression> computedValueExpressions);
 
@@ -106,6 +106,25 @@ public:
 
       void setPeriodic(Vec3* periodicBoxVectors);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set whether to assign work to threads in a fixed way, so the forces and energy are
+         deterministic for a given number of threads.
+
+         --------------------------------------------------------------------------------------- */
+
+      void setDeterministic(bool deterministic);
+
+      /**---------------------------------------------------------------------------------------
+
+         Computed values depend only on per-particle and global parameters, so they are cached
+         between calls and only recomputed when a global parameter changes.  Call this after
+         modifying the per-particle parameters to force them to be recomputed.
+
+         --------------------------------------------------------------------------------------- */
+
+      void invalidateComputedValues();
+
       /**---------------------------------------------------------------------------------------
 
          Calculate custom pair ixn
@@ -132,18 +151,22 @@ protected:
     bool periodic;
     bool triclinic;
     bool useInteractionGroups;
+    bool deterministic;
     const CpuNeighborList* neighborList;
     float recipBoxSize[3];
     Vec3 periodicBoxVectors[3];
     AlignedArray<fvec4> periodicBoxVec4;
     double cutoffDistance, switchingDistance;
     ThreadPool& threads;
-    std::vector<std::set<int> > exclusions;
+    CpuExclusionList exclusions;
     std::vector<ThreadData*> threadData;
     std::vector<std::string> paramNames, computedValueNames;
     std::vector<std::pair<int, int> > groupInteractions;
     std::vector<double> threadEnergy;
+    std::vector<int> blockRanges;
     std::vector<std::vector<double> > atomComputedValues;
+    std::map<std::string, double> computedValueGlobals;
+    bool computedValuesValid, recomputeValues;
     // The following variables are used to make information accessible to the individual threads.
     int numberOfAtoms;
     float* posq;
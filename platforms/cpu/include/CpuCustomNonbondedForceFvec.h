@@ -26,10 +26,12 @@
 #define OPENMM_CPU_CUSTOM_NONBONDED_FORCE_FVEC_H__
 
 #include "CpuCustomNonbondedForce.h"
+#include <algorithm>
+#include <cmath>
 
 namespace OpenMM {
 
-enum PeriodicType {NoCutoff, NoPeriodic, PeriodicPerAtom, PeriodicPerInteraction, PeriodicTriclinic};
+enum PeriodicType {NoCutoff, NoPeriodic, PeriodicPerAtom, PeriodicPerInteraction, PeriodicTriclinic, PeriodicTriclinicPerAtom};
 
 template <typename FVEC, int BLOCK_SIZE>
 class CpuCustomNonbondedForceFvec : public CpuCustomNonbondedForce {
@@ -89,8 +91,16 @@ void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxn(ThreadData
         if (!(minx < cutoffDistance || miny < cutoffDistance || minz < cutoffDistance ||
                 maxx > boxSize[0]-cutoffDistance || maxy > boxSize[1]-cutoffDistance || maxz > boxSize[2]-cutoffDistance))
             periodicType = NoPeriodic;
-        else if (triclinic)
-            periodicType = PeriodicTriclinic;
+        else if (triclinic) {
+            // If every neighbor within the cutoff of any atom in the block is within half a box width of the
+            // block center, a single periodic image of each neighbor is correct for the whole block.
+
+            float blockRadius = 0.5f*sqrtf((maxx-minx)*(maxx-minx) + (maxy-miny)*(maxy-miny) + (maxz-minz)*(maxz-minz));
+            if (blockRadius+cutoffDistance <= 0.5f*std::min(boxSize[0], std::min(boxSize[1], boxSize[2])))
+                periodicType = PeriodicTriclinicPerAtom;
+            else
+                periodicType = PeriodicTriclinic;
+        }
         else if (0.5f*(boxSize[0]-(maxx-minx)) >= cutoffDistance &&
                  0.5f*(boxSize[1]-(maxy-miny)) >= cutoffDistance &&
                  0.5f*(boxSize[2]-(maxz-minz)) >= cutoffDistance)
@@ -111,6 +121,8 @@ void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxn(ThreadData
         calculateBlockIxnImpl<PeriodicPerInteraction>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicTriclinic)
         calculateBlockIxnImpl<PeriodicTriclinic>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else if (periodicType == PeriodicTriclinicPerAtom)
+        calculateBlockIxnImpl<PeriodicTriclinicPerAtom>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
 }
 
 template<typename FVEC, int BLOCK_SIZE>
@@ -158,6 +170,14 @@ void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxnImpl(Thread
         fvec4 atomPos(posq+4*atom);
         if (PERIODIC_TYPE == PeriodicPerAtom)
             atomPos -= floor((atomPos-blockCenter)*invBoxSize+0.5f)*boxSize;
+        else if (PERIODIC_TYPE == PeriodicTriclinicPerAtom) {
+            fvec4 offset = atomPos-blockCenter;
+            atomPos -= periodicBoxVec4[2]*floorf(offset[2]*recipBoxSize[2]+0.5f);
+            offset = atomPos-blockCenter;
+            atomPos -= periodicBoxVec4[1]*floorf(offset[1]*recipBoxSize[1]+0.5f);
+            offset = atomPos-blockCenter;
+            atomPos -= periodicBoxVec4[0]*floorf(offset[0]*recipBoxSize[0]+0.5f);
+        }
         getDeltaR<PERIODIC_TYPE>(atomPos, blockAtomX, blockAtomY, blockAtomZ, dx, dy, dz, r2, boxSize, invBoxSize);
         auto include = FVEC::expandBitsToMask(~neighbors.getExclusions());
         if (PERIODIC_TYPE != NoCutoff)
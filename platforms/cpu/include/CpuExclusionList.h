@@ -0,0 +1,127 @@
+#ifndef OPENMM_CPU_EXCLUSIONLIST_H_
+#define OPENMM_CPU_EXCLUSIONLIST_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "windowsExportCpu.h"
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class stores the exclusions for every atom in compressed sparse row format.  The excluded
+ * atoms for each atom are stored in a single array, sorted in increasing order, so the whole list
+ * occupies two integers per exclusion plus one per atom.  It is built once when a kernel is
+ * initialized and shared by the neighbor list and the kernels that use it.
+ */
+class OPENMM_EXPORT_CPU CpuExclusionList {
+public:
+    class Range;
+    /**
+     * Create an empty list for zero atoms.
+     */
+    CpuExclusionList();
+    /**
+     * Create a list in which no atom has any exclusions.
+     *
+     * @param numAtoms   the number of atoms in the system
+     */
+    explicit CpuExclusionList(int numAtoms);
+    /**
+     * Create a list from pairs of atoms that should not interact.  Each pair excludes the two atoms
+     * from each other.  Duplicate pairs are allowed and ignored.
+     *
+     * @param numAtoms   the number of atoms in the system
+     * @param pairs      the pairs of atoms to exclude
+     */
+    CpuExclusionList(int numAtoms, const std::vector<std::pair<int, int> >& pairs);
+    /**
+     * Create a list from per-atom sets.
+     *
+     * @param exclusions   exclusions[i] contains the indices of all atoms with which atom i should not interact
+     */
+    explicit CpuExclusionList(const std::vector<std::set<int> >& exclusions);
+    /**
+     * Get the number of atoms in the system.
+     */
+    int getNumAtoms() const {
+        return offsets.size()-1;
+    }
+    /**
+     * Get the atoms excluded from interacting with an atom, in increasing order.
+     */
+    Range operator[](int atom) const;
+    /**
+     * Get whether two atoms are excluded from interacting with each other.
+     */
+    bool isExcluded(int atom1, int atom2) const;
+    bool operator==(const CpuExclusionList& other) const {
+        return (offsets == other.offsets && indices == other.indices);
+    }
+    bool operator!=(const CpuExclusionList& other) const {
+        return !(*this == other);
+    }
+private:
+    std::vector<int> offsets, indices;
+};
+
+/**
+ * The sorted exclusions of a single atom.  It can be used in a range based for loop.
+ */
+class CpuExclusionList::Range {
+public:
+    Range(const int* first, const int* last) : first(first), last(last) {
+    }
+    const int* begin() const {
+        return first;
+    }
+    const int* end() const {
+        return last;
+    }
+    int size() const {
+        return last-first;
+    }
+private:
+    const int* first;
+    const int* last;
+};
+
+inline CpuExclusionList::Range CpuExclusionList::operator[](int atom) const {
+    const int* data = indices.data();
+    return Range(data+offsets[atom], data+offsets[atom+1]);
+}
+
+} // namespace OpenMM
+
+#endif // OPENMM_CPU_EXCLUSIONLIST_H_
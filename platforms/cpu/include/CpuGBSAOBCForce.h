@@ -70,6 +70,12 @@ public:
      * Set the surface area energy.
      */
     void setSurfaceAreaEnergy(float energy);
+
+    /**
+     * Set whether to assign work to threads in a fixed way, so the forces and energy are deterministic
+     * for a given number of threads.
+     */
+    void setDeterministic(bool deterministic);
     
     /**
      * Get the per-particle parameters (offset radius, scaled radius).
@@ -100,6 +106,7 @@ public:
 private:
     bool cutoff;
     bool periodic;
+    bool deterministic;
     float periodicBoxSize[3];
     float cutoffDistance, soluteDielectric, solventDielectric, surfaceAreaFactor;
     std::vector<std::pair<float, float> > particleParams;        
@@ -37,6 +37,7 @@
 #include "CpuNeighborList.h"
 #include "CpuPlatform.h"
 #include "openmm/Vec3.h"
+#include "openmm/internal/vectorize.h"
 #include <set>
 #include <utility>
 
@@ -71,7 +72,7 @@ public:
     /**
      * Get the exclusions being used by the force.
      */
-    const std::vector<std::set<int> >& getExclusions() const;
+    const CpuExclusionList& getExclusions() const;
 
 private:
     struct ParticleInfo;
@@ -79,12 +80,15 @@ private:
     std::vector<ParticleInfo> particles;
     std::vector<ExceptionInfo> exceptions;
     std::set<std::pair<int, int> > exclusions;
-    std::vector<std::set<int> > particleExclusions;
+    CpuExclusionList particleExclusions;
     GayBerneForce::NonbondedMethod nonbondedMethod;
     double cutoffDistance, switchingDistance;
     bool useSwitchingFunction;
     std::vector<double> s;
     std::vector<Matrix> A, B, G;
+    // Single precision copies of the per-particle values used by the vectorized kernel, stored in
+    // structure-of-arrays form: component c of particle i is at frames[c*numParticles+i].
+    std::vector<float> frames;
     std::vector<double> threadEnergy;
     std::vector<std::vector<Vec3> > threadTorque;
     // The following variables are used to make information accessible to the individual threads.
@@ -99,6 +103,26 @@ private:
 
     double computeOneInteraction(int particle1, int particle2, double sigma, double epsilon, const Vec3* positions,
             float* forces, std::vector<Vec3>& torques, const Vec3* boxVectors);
+
+    /**
+     * Load the frame components of four particles into vectors, one particle per lane.
+     */
+    void loadFrames(const int* lanes, fvec4* frame) const;
+
+    /**
+     * Compute the interactions between one particle and up to four others at once, using the
+     * standard combining rules for sigma and epsilon.
+     *
+     * @param particle1   the index of the first particle
+     * @param lanes       the indices of the other four particles
+     * @param laneMask    bit i is set if lane i contains an interaction to compute
+     * @param frame2      the frame components of the particles in lanes, as returned by loadFrames()
+     * @param forces      forces on particles are added to this
+     * @param torques     torques on particles are added to this
+     * @return the energy of the interactions
+     */
+    double computeFourInteractions(int particle1, const int* lanes, int laneMask, const fvec4* frame2,
+            float* forces, std::vector<Vec3>& torques);
 };
 
 struct CpuGayBerneForce::ParticleInfo {
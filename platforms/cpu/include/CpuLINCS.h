@@ -0,0 +1,101 @@
+#ifndef OPENMM_CPULINCS_H_
+#define OPENMM_CPULINCS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceCCMAAlgorithm.h"
+#include "windowsExportCpu.h"
+#include "openmm/internal/ThreadPool.h"
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class implements the P-LINCS algorithm (Hess, J. Chem. Theory Comput. 4, pp. 116-122 (2008)).
+ * Instead of iterating to convergence, it inverts the constraint coupling matrix with a fixed number
+ * of terms of a power series expansion, followed by one correction for the rotation of each constraint.
+ * The amount of work per step is therefore fixed and predictable, but the constraints are only
+ * satisfied approximately and the tolerance is ignored.  The expansion only converges when the
+ * coupling between constraints is weak, so it should not be used with constrained angles.
+ *
+ * Each phase is divided between threads.  Position updates are done per-atom, so no two threads ever
+ * write to the same atom.
+ */
+class OPENMM_EXPORT_CPU CpuLINCS : public ReferenceConstraintAlgorithm {
+public:
+    /**
+     * Create a CpuLINCS object.
+     *
+     * @param ccma       the CCMA object whose constraints should be applied
+     * @param threads    the thread pool to use
+     * @param numTerms   the number of terms in the expansion of the coupling matrix inverse
+     */
+    CpuLINCS(const ReferenceCCMAAlgorithm& ccma, ThreadPool& threads, int numTerms=4);
+
+    /**
+     * Apply the constraint algorithm.
+     * 
+     * @param atomCoordinates  the original atom coordinates
+     * @param atomCoordinatesP the new atom coordinates
+     * @param inverseMasses    1/mass
+     * @param tolerance        the constraint tolerance (ignored)
+     */
+    void apply(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& atomCoordinatesP, std::vector<double>& inverseMasses, double tolerance);
+
+    /**
+     * Apply the constraint algorithm to velocities.
+     * 
+     * @param atomCoordinates  the atom coordinates
+     * @param atomCoordinatesP the velocities to modify
+     * @param inverseMasses    1/mass
+     * @param tolerance        the constraint tolerance (ignored)
+     */
+    void applyToVelocities(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<double>& inverseMasses, double tolerance);
+private:
+    void computeDirections(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<double>& inverseMasses);
+    void solveMatrix();
+    void updateAtoms(std::vector<OpenMM::Vec3>& atomCoordinatesP, std::vector<double>& inverseMasses);
+    ThreadPool& threads;
+    int numConstraints, numTerms;
+    std::vector<std::pair<int, int> > atomIndices;
+    std::vector<double> distance, sDiag, rhs1, rhs2, solution;
+    std::vector<OpenMM::Vec3> direction;
+    std::vector<std::vector<int> > couplingConstraint, couplingAtom;
+    std::vector<std::vector<double> > couplingSign, couplingCoeff;
+    std::vector<int> constrainedAtoms;
+    std::vector<std::vector<std::pair<int, double> > > atomConstraints;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CPULINCS_H_*/
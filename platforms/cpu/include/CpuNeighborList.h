@@ -33,11 +33,11 @@
  * -------------------------------------------------------------------------- */
 
 #include "AlignedArray.h"
+#include "CpuExclusionList.h"
 #include "openmm/Vec3.h"
 #include "windowsExportCpu.h"
 #include "openmm/internal/ThreadPool.h"
 #include <atomic>
-#include <set>
 #include <utility>
 #include <vector>
 
@@ -53,27 +53,55 @@ public:
      * 
      * @param numAtoms            the number of atoms in the system
      * @param atomLocations       the positions of the atoms
-     * @param exclusions          exclusions[i] contains the indices of all atoms with which atom i should not interact
+     * @param exclusions          the atoms with which each atom should not interact
      * @param periodicBoxVectors  the current periodic box vectors
      * @param usePeriodic         whether to apply periodic boundary conditions
      * @param maxDistance         the neighbor list will contain all pairs that are within this distance of each other
      * @param threads             used for parallelization
      */
-    void computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const std::vector<std::set<int> >& exclusions,
+    void computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const CpuExclusionList& exclusions,
             const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads);
     /**
      * Build a dense neighbor list, in which every atom interacts with every other (except exclusions), regardless of distance.
      * 
      * @param numAtoms            the number of atoms in the system
-     * @param exclusions          exclusions[i] contains the indices of all atoms with which atom i should not interact
+     * @param exclusions          the atoms with which each atom should not interact
      */
-    void createDenseNeighborList(int numAtoms, const std::vector<std::set<int> >& exclusions);
+    void createDenseNeighborList(int numAtoms, const CpuExclusionList& exclusions);
+    /**
+     * Update the neighbor list after a small number of atoms have moved, without rebuilding it.  Only
+     * the moved atoms are re-binned, and any pairs involving them that are now within searchDistance
+     * are added to the blocks they belong to.  Entries are never removed, so afterward the list contains
+     * every pair within searchDistance, measured from the current positions of the moved atoms and the
+     * positions of all other atoms as of the last time they were built or updated.
+     *
+     * This is only supported for non-periodic systems and rectangular periodic boxes, and only if the box
+     * has not changed since computeNeighborList() was called.
+     *
+     * @param atomLocations       the positions of the atoms
+     * @param movedAtoms          the indices of the atoms whose positions should be updated
+     * @param periodicBoxVectors  the current periodic box vectors
+     * @param searchDistance      the distance within which to add pairs.  This must be at least the
+     *                            maximum distance passed to computeNeighborList().
+     * @return true if the list was updated, or false if computeNeighborList() must be called instead
+     */
+    bool updateNeighborList(const AlignedArray<float>& atomLocations, const std::vector<int>& movedAtoms, const Vec3* periodicBoxVectors, float searchDistance);
     int getNumBlocks() const;
     int getBlockSize() const;
     /**
      * Get an object for iterating over the neighbors of an atom block.
      */
     NeighborIterator getNeighborIterator(int blockIndex) const;
+    /**
+     * Divide the atom blocks into contiguous ranges of roughly equal cost, estimated from the number of
+     * neighbors each block has.  When forces must be deterministic, this is used to always assign the
+     * same blocks to the same thread, rather than letting threads take blocks as they become free.
+     *
+     * @param numRanges   the number of ranges to divide the blocks into
+     * @param ranges      on exit, this contains numRanges+1 elements.  Range i contains the blocks from
+     *                    ranges[i] up to but not including ranges[i+1].
+     */
+    void getBalancedBlockRanges(int numRanges, std::vector<int>& ranges) const;
     const std::vector<int32_t>& getSortedAtoms() const;
     const std::vector<int>& getBlockNeighbors(int blockIndex) const;
 
@@ -91,6 +119,14 @@ public:
     void threadComputeNeighborList(ThreadPool& threads, int threadIndex);
     void runThread(int index);
 private:
+    bool buildAtomCells(float distance);
+    int findAtomCell(const float* pos) const;
+    void addPair(int sortedIndex1, int sortedIndex2);
+    /**
+     * Merge the sorted exclusion lists of the atoms in a block into a single sorted list.  Each entry
+     * gives an excluded atom and a mask of the atoms in the block that exclude it.
+     */
+    void mergeBlockExclusions(const int* blockAtoms, int atomsInBlock, std::vector<std::pair<int, BlockExclusionMask> >& merged) const;
     int blockSize;
     std::vector<int> sortedAtoms;
     std::vector<float> sortedPositions;
@@ -100,13 +136,20 @@ private:
     float minx, maxx, miny, maxy, minz, maxz;
     std::vector<std::pair<int, int> > atomBins;
     Voxels* voxels;
-    const std::vector<std::set<int> >* exclusions;
+    const CpuExclusionList* exclusions;
     const float* atomLocations;
     Vec3 periodicBoxVectors[3];
     int numAtoms;
     bool usePeriodic, dense;
     float maxDistance;
     std::atomic<int> atomicCounter;
+    // The following variables are used by updateNeighborList().  They are built the first time
+    // it is called after the list is computed.
+    bool cellsBuilt;
+    int numCells[3];
+    float cellDistance, cellOrigin[3], cellSize[3];
+    std::vector<std::vector<int> > cells;
+    std::vector<int> atomCell, atomSortedIndex;
 };
 
 class OPENMM_EXPORT_CPU CpuNeighborList::NeighborIterator {
@@ -31,7 +31,6 @@
 #include "openmm/internal/ThreadPool.h"
 #include "openmm/internal/vectorize.h"
 #include <atomic>
-#include <set>
 #include <utility>
 #include <vector>
 // ---------------------------------------------------------------------------------------
@@ -134,6 +133,15 @@ class CpuNonbondedForce {
 
       void setPeriodicExceptions(bool periodic);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set whether to assign work to threads in a fixed way, so the forces and energy are
+         deterministic for a given number of threads.
+
+         --------------------------------------------------------------------------------------- */
+
+      void setDeterministic(bool deterministic);
+
       /**---------------------------------------------------------------------------------------
       
          Calculate Ewald ixn
@@ -147,12 +155,13 @@ class CpuNonbondedForce {
                                  exclusions[atomIndex] contains the list of exclusions for that atom
          @param forces           force array (forces added)
          @param totalEnergy      total energy
+         @param threads          the thread pool to use for Ewald summation
             
          --------------------------------------------------------------------------------------- */
 
       void calculateReciprocalIxn(int numberOfAtoms, float* posq, const std::vector<Vec3>& atomCoordinates,
                                   const std::vector<std::pair<float, float> >& atomParameters, const std::vector<float> &C6params,
-                                  const std::vector<std::set<int> >& exclusions, std::vector<Vec3>& forces, double* totalEnergy) const;
+                                  const CpuExclusionList& exclusions, std::vector<Vec3>& forces, double* totalEnergy, ThreadPool& threads) const;
       
       /**---------------------------------------------------------------------------------------
       
@@ -167,11 +176,13 @@ class CpuNonbondedForce {
          @param forces           force array (forces added)
          @param totalEnergy      total energy
          @param threads          the thread pool to use
+         @param includeForces    whether to compute forces.  If false, only the energy is computed.
       
          --------------------------------------------------------------------------------------- */
           
       void calculateDirectIxn(int numberOfAtoms, float* posq, const std::vector<Vec3>& atomCoordinates, const std::vector<std::pair<float, float> >& atomParameters,
-            const std::vector<float>& C6params, const std::vector<std::set<int> >& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads);
+            const std::vector<float>& C6params, const CpuExclusionList& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads,
+            bool includeForces=true);
 
     /**
      * This routine contains the code executed by each thread.
@@ -185,6 +196,7 @@ protected:
         bool triclinic;
         bool ewald;
         bool ljpme, pme;
+        bool deterministic;
         bool tableIsValid, expTableIsValid;
         const CpuNeighborList* neighborList;
         float recipBoxSize[3];
@@ -199,15 +211,16 @@ protected:
         std::vector<float> exptermsTable, dExptermsTable;
         float ewaldDX, ewaldDXInv, erfcDXInv, exptermsDX, exptermsDXInv;
         std::vector<double> threadEnergy;
+        std::vector<int> blockRanges;
         // The following variables are used to make information accessible to the individual threads.
         int numberOfAtoms;
         float* posq;
         Vec3 const* atomCoordinates;
         std::pair<float, float> const* atomParameters;        
         float const *C6params;
-        std::set<int> const* exclusions;
+        const CpuExclusionList* exclusions;
         std::vector<AlignedArray<float> >* threadForce;
-        bool includeEnergy;
+        bool includeForces, includeEnergy;
         float inverseRcut6;
         float inverseRcut6Expterm;
         std::atomic<int> atomicCounter, atomicCounter2;
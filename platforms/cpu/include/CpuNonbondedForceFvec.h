@@ -31,12 +31,13 @@
 #include "SimTKOpenMMUtilities.h"
 
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace OpenMM {
 
 enum BlockType {EWALD, NON_EWALD}; // :TODO: Better name for non-ewald.
-enum PeriodicType {NoCutoff, NoPeriodic, PeriodicPerAtom, PeriodicPerInteraction, PeriodicTriclinic};
+enum PeriodicType {NoCutoff, NoPeriodic, PeriodicPerAtom, PeriodicPerInteraction, PeriodicTriclinic, PeriodicTriclinicPerAtom};
 
 /**
  * Generic SIMD implementation of CpuNonbondedForce. The templating allows the same
@@ -77,12 +78,19 @@ protected:
     template<BlockType BLOCK_TYPE>
     void calculateBlockIxnHandler(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
+    /**
+     * Call the version of calculateBlockIxnImpl() that either does or does not compute forces.
+     */
+    template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+    void calculateBlockIxnForceVariant(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
+
     /**
     * Templatized implementation of calculateBlockIxn. It can handle both Ewald and non-ewald interactions
     * through a template parameter since the code is so similar for the two cases. Note also that the
-    * floating-point SIMD type is also templated to allow any suitable type to be used.
+    * floating-point SIMD type is also templated to allow any suitable type to be used.  When COMPUTE_FORCES
+    * is false, only the energy is computed.
     */
-    template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+    template <int PERIODIC_TYPE, BlockType BLOCK_TYPE, bool COMPUTE_FORCES>
     void calculateBlockIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
 
     /**
@@ -163,8 +171,16 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnHandler(int blockIndex, float
         if (!(minx < cutoffDistance || miny < cutoffDistance || minz < cutoffDistance ||
                 maxx > boxSize[0]-cutoffDistance || maxy > boxSize[1]-cutoffDistance || maxz > boxSize[2]-cutoffDistance))
             periodicType = NoPeriodic;
-        else if (triclinic)
-            periodicType = PeriodicTriclinic;
+        else if (triclinic) {
+            // If every neighbor within the cutoff of any atom in the block is within half a box width of the
+            // block center, a single periodic image of each neighbor is correct for the whole block.
+
+            float blockRadius = 0.5f*sqrtf((maxx-minx)*(maxx-minx) + (maxy-miny)*(maxy-miny) + (maxz-minz)*(maxz-minz));
+            if (blockRadius+cutoffDistance <= 0.5f*std::min(boxSize[0], std::min(boxSize[1], boxSize[2])))
+                periodicType = PeriodicTriclinicPerAtom;
+            else
+                periodicType = PeriodicTriclinic;
+        }
         else if (0.5f*(boxSize[0]-(maxx-minx)) >= cutoffDistance &&
                  0.5f*(boxSize[1]-(maxy-miny)) >= cutoffDistance &&
                  0.5f*(boxSize[2]-(maxz-minz)) >= cutoffDistance)
@@ -175,19 +191,30 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnHandler(int blockIndex, float
     
     // Call the appropriate version depending on what calculation is required for periodic boundary conditions.
     if (!cutoff)
-        calculateBlockIxnImpl<NoCutoff, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnForceVariant<NoCutoff, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == NoPeriodic)
-        calculateBlockIxnImpl<NoPeriodic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnForceVariant<NoPeriodic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerAtom)
-        calculateBlockIxnImpl<PeriodicPerAtom, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnForceVariant<PeriodicPerAtom, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerInteraction)
-        calculateBlockIxnImpl<PeriodicPerInteraction, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnForceVariant<PeriodicPerInteraction, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicTriclinic)
-        calculateBlockIxnImpl<PeriodicTriclinic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnForceVariant<PeriodicTriclinic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else if (periodicType == PeriodicTriclinicPerAtom)
+        calculateBlockIxnForceVariant<PeriodicTriclinicPerAtom, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
 }
 
 template<typename FVEC>
 template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnForceVariant(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
+    if (includeForces)
+        calculateBlockIxnImpl<PERIODIC_TYPE, BLOCK_TYPE, true>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else
+        calculateBlockIxnImpl<PERIODIC_TYPE, BLOCK_TYPE, false>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+}
+
+template<typename FVEC>
+template <int PERIODIC_TYPE, BlockType BLOCK_TYPE, bool COMPUTE_FORCES>
 void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
     // Load the positions and parameters of the atoms in the block.
 
@@ -233,6 +260,14 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
         fvec4 atomPos(posq+4*atom);
         if (PERIODIC_TYPE == PeriodicPerAtom)
             atomPos -= floor((atomPos-blockCenter)*invBoxSize+0.5f)*boxSize;
+        else if (PERIODIC_TYPE == PeriodicTriclinicPerAtom) {
+            fvec4 offset = atomPos-blockCenter;
+            atomPos -= periodicBoxVec4[2]*floorf(offset[2]*recipBoxSize[2]+0.5f);
+            offset = atomPos-blockCenter;
+            atomPos -= periodicBoxVec4[1]*floorf(offset[1]*recipBoxSize[1]+0.5f);
+            offset = atomPos-blockCenter;
+            atomPos -= periodicBoxVec4[0]*floorf(offset[0]*recipBoxSize[0]+0.5f);
+        }
         getDeltaR<PERIODIC_TYPE>(atomPos, blockAtomX, blockAtomY, blockAtomZ, dx, dy, dz, r2, boxSize, invBoxSize);
         auto include = FVEC::expandBitsToMask(~neighbors.getExclusions());
         if (PERIODIC_TYPE != NoCutoff)
@@ -303,28 +338,32 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
             partialEnergy += energy;
         }
 
-        // Accumulate forces.
-        dEdR = blendZero(dEdR, include);
-        const auto fx = dx*dEdR;
-        const auto fy = dy*dEdR;
-        const auto fz = dz*dEdR;
-        blockAtomForceX += fx;
-        blockAtomForceY += fy;
-        blockAtomForceZ += fz;
-
-        float* const atomForce = forces+4*atom;
-        const fvec4 newAtomForce = fvec4(atomForce) - reduceToVec3(fx, fy, fz);
-        newAtomForce.store(atomForce);
+        // Accumulate forces.  When they are not needed, the compiler removes the calculation of dEdR as well.
+        if (COMPUTE_FORCES) {
+            dEdR = blendZero(dEdR, include);
+            const auto fx = dx*dEdR;
+            const auto fy = dy*dEdR;
+            const auto fz = dz*dEdR;
+            blockAtomForceX += fx;
+            blockAtomForceY += fy;
+            blockAtomForceZ += fz;
+
+            float* const atomForce = forces+4*atom;
+            const fvec4 newAtomForce = fvec4(atomForce) - reduceToVec3(fx, fy, fz);
+            newAtomForce.store(atomForce);
+        }
     }
     
     if (totalEnergy)
         *totalEnergy += reduceAdd(partialEnergy);
 
     // Record the forces on the block atoms.
-    fvec4 f[blockSize];
-    transpose(blockAtomForceX, blockAtomForceY, blockAtomForceZ, 0.0f, f);
-    for (int j = 0; j < blockSize; j++)
-        (fvec4(forces+4*blockAtom[j])+f[j]).store(forces+4*blockAtom[j]);
+    if (COMPUTE_FORCES) {
+        fvec4 f[blockSize];
+        transpose(blockAtomForceX, blockAtomForceY, blockAtomForceZ, 0.0f, f);
+        for (int j = 0; j < blockSize; j++)
+            (fvec4(forces+4*blockAtom[j])+f[j]).store(forces+4*blockAtom[j]);
+    }
 }
 
 template<typename FVEC>
@@ -35,11 +35,13 @@
 #include "AlignedArray.h"
 #include "CpuRandom.h"
 #include "CpuNeighborList.h"
+#include "CpuVirtualSites.h"
 #include "ReferencePlatform.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/ThreadPool.h"
 #include "windowsExportCpu.h"
 #include <map>
+#include <memory>
 
 namespace OpenMM {
     
@@ -69,14 +71,77 @@ public:
         return key;
     }
     /**
-     * This is the name of the parameter for requesting that force computations be deterministic.  Setting
-     * this to "true" DOES NOT GUARANTEE that the forces will actually be fully deterministic, but it does
-     * try to reduce the variation in them at the cost of a small loss in performance.
+     * This is the name of the parameter for requesting that force computations be deterministic.  When it
+     * is "true", work is assigned to threads in a fixed way, so NonbondedForce, CustomNonbondedForce,
+     * GBSAOBCForce, and PME produce identical results every time they are computed with the same positions
+     * and number of threads.  This DOES NOT GUARANTEE that other forces will be fully deterministic.
      */
     static const std::string& CpuDeterministicForces() {
         static const std::string key = "DeterministicForces";
         return key;
     }
+    /**
+     * This is the name of the parameter for requesting that each worker thread be pinned to its own
+     * logical core.  When set to "true", thread i is bound to the i'th core the process is allowed to
+     * run on, so consecutive threads share a socket and NUMA node whenever the operating system numbers
+     * cores that way.  Pinning is currently only supported on Linux, and is ignored elsewhere.
+     */
+    static const std::string& CpuPinThreads() {
+        static const std::string key = "PinThreads";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting the number of threads used to compute the reciprocal
+     * space part of PME.  Reciprocal space runs on its own threads at the same time as direct space, so
+     * setting this and Threads to numbers that add up to the number of cores divides the cores between them.
+     * If it is not specified, it defaults to the value of Threads.
+     */
+    static const std::string& CpuPmeThreads() {
+        static const std::string key = "PmeThreads";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for requesting that the Context use a process-wide thread pool
+     * shared with other Contexts.  When set to "true", all Contexts that request the same number of threads
+     * use the same worker threads, taking turns to run their parallel tasks, instead of each creating its own.
+     * This lets many small Contexts, such as the replicas of a replica exchange simulation, be run from
+     * separate threads without oversubscribing the cores.
+     */
+    static const std::string& CpuSharedThreadPool() {
+        static const std::string key = "SharedThreadPool";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for requesting that custom nonbonded expressions be specialized for
+     * the current values of global parameters.  When set to "true", global parameters are folded into the
+     * expressions as constants before they are compiled, and the expressions are recompiled whenever a
+     * parameter changes.  This is useful when parameters stay fixed for long periods, such as the lambda
+     * values at each window of a free energy calculation, but is slow if they change every step.
+     */
+    static const std::string& CpuSpecializeGlobalParameters() {
+        static const std::string key = "SpecializeGlobalParameters";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for requesting that custom nonbonded energies be tabulated.  When set
+     * to "true", a CustomNonbondedForce whose energy depends only on r (after any global parameters have been
+     * folded in with SpecializeGlobalParameters) is replaced by a cubic spline, provided one can be found that
+     * reproduces the energy and force to within a tight tolerance over the whole range up to the cutoff.
+     */
+    static const std::string& CpuTabulateCustomNonbondedForces() {
+        static const std::string key = "TabulateCustomNonbondedForces";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting the algorithm used for constraints other than rigid
+     * water.  It may be either "CCMA" (the default), which iterates until the constraints are satisfied to
+     * within the integrator's tolerance, or "LINCS", which does a fixed amount of work per step and is only
+     * suitable when angles are not constrained.
+     */
+    static const std::string& CpuConstraintAlgorithm() {
+        static const std::string key = "ConstraintAlgorithm";
+        return key;
+    }
     /**
      * We cannot use the standard mechanism for platform data, because that is already used by the superclass.
      * Instead, we maintain a table of ContextImpls to PlatformDatas.
@@ -89,10 +154,13 @@ private:
 
 class CpuPlatform::PlatformData {
 public:
-    PlatformData(int numParticles, int numThreads, bool deterministicForces);
+    PlatformData(int numParticles, int numThreads, bool deterministicForces, bool pinThreads=false, bool sharedThreads=false, bool specializeGlobals=false, bool tabulateCustomNonbonded=false);
     ~PlatformData();
     /**
-     * Request that a neighbor list be built and maintained.
+     * Request that a neighbor list be built and maintained.  There is a single neighbor list
+     * shared by every Force that requests one.  It uses the largest cutoff and padding that were
+     * requested, and is built once per rebuild no matter how many Forces use it.  All Forces that
+     * use exclusions must therefore specify identical ones.
      * 
      * @param cutoffDistance  the cutoff distance for particle pairs to be included in the neighbor list.
      *                        If this is 0, a dense neighbor list is built that includes all particle pairs
@@ -100,23 +168,38 @@ public:
      * @param padding         a padding distance that should be added to the cutoff so the neighbor list
      *                        does not need to be rebuilt every step
      * @param useExclusions   whether to omit specific excluded interactions
-     * @param exclusionList   if useExclusions is true, exclusionList[i] should contain the indices of all
-     *                        particles with which particle i should not interact
+     * @param exclusionList   if useExclusions is true, the particles with which each particle should not interact
      */
-    void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const std::vector<std::set<int> >& exclusionList);
+    void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const CpuExclusionList& exclusionList);
     int requestPosqIndex();
     AlignedArray<float> posq;
     std::vector<AlignedArray<float> > threadForce;
-    ThreadPool threads;
+    /**
+     * Kernels must set this to true before they add anything to threadForce.  The buffers are only
+     * summed (and then cleared) when it is set, so they always hold zeros between force computations.
+     */
+    bool threadForceModified;
+    std::shared_ptr<ThreadPool> threadPool;
+    ThreadPool& threads;
     bool isPeriodic;
     CpuRandom random;
     std::map<std::string, std::string> propertyValues;
     int numParticles;
     CpuNeighborList* neighborList;
+    /**
+     * This is used to compute virtual site positions and distribute their forces.  It is NULL if the
+     * System has no virtual sites.
+     */
+    CpuVirtualSites* virtualSites;
+    /**
+     * The number of atoms in each block of the neighbor list.  This must match the vector width
+     * used by the kernels that share it.
+     */
+    int neighborBlockSize;
     double cutoff, paddedCutoff;
-    bool anyExclusions, deterministicForces;
+    bool anyExclusions, deterministicForces, pinThreads, sharedThreads, specializeGlobals, tabulateCustomNonbonded;
     int currentPosqIndex, nextPosqIndex;
-    std::vector<std::set<int> > exclusions;
+    CpuExclusionList exclusions;
 };
 
 } // namespace OpenMM
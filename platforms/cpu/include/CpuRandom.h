@@ -46,14 +46,28 @@ public:
     CpuRandom();
     ~CpuRandom();
     void initialize(int seed, int numThreads);
-    float getGaussianRandom(int threadIndex);
+    float getGaussianRandom(int threadIndex) {
+        ThreadData& data = *threadData[threadIndex];
+        if (data.nextGaussian == GaussianBufferSize)
+            fillGaussianBuffer(data);
+        return data.gaussians[data.nextGaussian++];
+    }
     float getUniformRandom(int threadIndex);
 private:
+    static const int GaussianBufferSize = 64;
+    /**
+     * Each thread has its own generator, and generates Gaussian random numbers in batches.  The data for each
+     * thread is allocated separately so different threads never write to the same cache line.
+     */
+    struct ThreadData {
+        OpenMM_SFMT::SFMT sfmt;
+        float gaussians[GaussianBufferSize];
+        int nextGaussian;
+    };
+    void fillGaussianBuffer(ThreadData& data);
     bool hasInitialized;
     int randomSeed;
-    std::vector<OpenMM_SFMT::SFMT*> threadRandom;
-    std::vector<float> nextGaussian;
-    std::vector<int> nextGaussianIsValid;
+    std::vector<ThreadData*> threadData;
 };
 
 } // namespace OpenMM
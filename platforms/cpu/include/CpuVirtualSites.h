@@ -0,0 +1,97 @@
+#ifndef OPENMM_CPUVIRTUALSITES_H_
+#define OPENMM_CPUVIRTUALSITES_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceVirtualSites.h"
+#include "windowsExportCpu.h"
+#include "openmm/System.h"
+#include "openmm/internal/ThreadPool.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the positions of virtual sites and distributes the forces on them, dividing the work
+ * between threads.  The sites are sorted by type when it is created, so each type is processed with a tight
+ * loop over precomputed indices and weights rather than looking up the VirtualSite object for every particle.
+ *
+ * Sites that share a particle are always assigned to the same block, so blocks can distribute forces in
+ * parallel without conflicts.  A site that is based on other virtual sites is placed in a later level than
+ * the sites it depends on.  Positions are computed one level at a time in increasing order, and forces are
+ * distributed in decreasing order.
+ */
+class OPENMM_EXPORT_CPU CpuVirtualSites : public ReferenceVirtualSites {
+public:
+    CpuVirtualSites(const System& system, ThreadPool& threads);
+    /**
+     * Compute the positions of all virtual sites.
+     */
+    void computeSitePositions(const System& system, std::vector<Vec3>& atomCoordinates);
+    /**
+     * Distribute forces from virtual sites to the atoms they are based on.
+     */
+    void distributeSiteForces(const std::vector<Vec3>& atomCoordinates, std::vector<Vec3>& forces);
+private:
+    struct TwoParticleAverageParams {
+        int site, p1, p2;
+        double w1, w2;
+    };
+    struct ThreeParticleAverageParams {
+        int site, p1, p2, p3;
+        double w1, w2, w3;
+    };
+    struct OutOfPlaneParams {
+        int site, p1, p2, p3;
+        double w12, w13, wcross;
+    };
+    struct LocalCoordinatesParams {
+        int site;
+        std::vector<int> particles;
+        std::vector<double> originWeights, xWeights, yWeights;
+        Vec3 localPosition;
+    };
+    struct SiteBlock {
+        std::vector<TwoParticleAverageParams> twoParticle;
+        std::vector<ThreeParticleAverageParams> threeParticle;
+        std::vector<OutOfPlaneParams> outOfPlane;
+        std::vector<LocalCoordinatesParams> localCoordinates;
+    };
+    void computeBlockPositions(const SiteBlock& block, std::vector<Vec3>& atomCoordinates);
+    void distributeBlockForces(const SiteBlock& block, const std::vector<Vec3>& atomCoordinates, std::vector<Vec3>& forces);
+    ThreadPool& threads;
+    std::vector<std::vector<SiteBlock> > levels;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CPUVIRTUALSITES_H_*/
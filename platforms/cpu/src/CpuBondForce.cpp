@@ -189,6 +189,39 @@ void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<d
             *totalEnergy += threadEnergy[i];
 }
 
+void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
+        double* totalEnergy, vector<ReferenceBondIxn*>& threadBondIxn, int numEnergyParamDerivs, double* energyParamDerivs) {
+    // Have the worker threads compute their forces.
+    
+    int numThreads = threads->getNumThreads();
+    vector<double> threadEnergy(numThreads, 0);
+    vector<vector<double> > threadDerivs(numThreads, vector<double>(numEnergyParamDerivs+1, 0.0));
+    threads->execute([&] (ThreadPool& threads, int threadIndex) {
+        double* energy = (totalEnergy == NULL ? NULL : &threadEnergy[threadIndex]);
+        double* derivs = &threadDerivs[threadIndex][0];
+        ReferenceBondIxn& referenceBondIxn = *threadBondIxn[threadIndex];
+        for (int bond : threadBonds[threadIndex])
+            referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, energy, derivs);
+    });
+    threads->waitForThreads();
+    
+    // Compute any "extra" bonds.
+    
+    for (int i = 0; i < extraBonds.size(); i++) {
+        int bond = extraBonds[i];
+        threadBondIxn[0]->calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, energyParamDerivs);
+    }
+
+    // Compute the total energy and parameter derivatives.
+    
+    for (int i = 0; i < numThreads; i++) {
+        if (totalEnergy != NULL)
+            *totalEnergy += threadEnergy[i];
+        for (int j = 0; j < numEnergyParamDerivs; j++)
+            energyParamDerivs[j] += threadDerivs[i][j];
+    }
+}
+
 void CpuBondForce::threadComputeForce(ThreadPool& threads, int threadIndex, vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
             double* totalEnergy, ReferenceBondIxn& referenceBondIxn) {
     vector<int>& bonds = threadBonds[threadIndex];
@@ -0,0 +1,184 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuCCMA.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuCCMA::CpuCCMA(const ReferenceCCMAAlgorithm& ccma, ThreadPool& threads) : threads(threads), hasInitializedMasses(false) {
+    numConstraints = ccma.getNumberOfConstraints();
+    maxIterations = ccma.getMaximumNumberOfIterations();
+    matrix = ccma.getMatrix();
+    atomIndices.resize(numConstraints);
+    distance.resize(numConstraints);
+    for (int i = 0; i < numConstraints; i++)
+        ccma.getConstraintParameters(i, atomIndices[i].first, atomIndices[i].second, distance[i]);
+    reducedMasses.resize(numConstraints);
+    d_ij2.resize(numConstraints);
+    constraintDelta.resize(numConstraints);
+    tempDelta.resize(numConstraints);
+    r_ij.resize(numConstraints);
+    threadConverged.resize(threads.getNumThreads());
+
+    // Record which constraints affect each atom, and the sign with which their deltas are applied.
+
+    vector<int> atomIndex;
+    for (int i = 0; i < numConstraints; i++) {
+        int atoms[] = {atomIndices[i].first, atomIndices[i].second};
+        for (int j = 0; j < 2; j++) {
+            int atom = atoms[j];
+            if (atom >= atomIndex.size())
+                atomIndex.resize(atom+1, -1);
+            if (atomIndex[atom] == -1) {
+                atomIndex[atom] = constrainedAtoms.size();
+                constrainedAtoms.push_back(atom);
+                atomConstraints.push_back(vector<pair<int, double> >());
+            }
+            atomConstraints[atomIndex[atom]].push_back(make_pair(i, j == 0 ? 1.0 : -1.0));
+        }
+    }
+}
+
+void CpuCCMA::apply(vector<Vec3>& atomCoordinates, vector<Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
+    applyConstraints(atomCoordinates, atomCoordinatesP, inverseMasses, false, tolerance);
+}
+
+void CpuCCMA::applyToVelocities(vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
+    applyConstraints(atomCoordinates, velocities, inverseMasses, true, tolerance);
+}
+
+void CpuCCMA::applyConstraints(vector<Vec3>& atomCoordinates, vector<Vec3>& atomCoordinatesP,
+                               vector<double>& inverseMasses, bool constrainingVelocities, double tolerance) {
+    if (numConstraints == 0)
+        return;
+    if (!hasInitializedMasses) {
+        hasInitializedMasses = true;
+        for (int i = 0; i < numConstraints; i++)
+            reducedMasses[i] = 0.5/(inverseMasses[atomIndices[i].first] + inverseMasses[atomIndices[i].second]);
+    }
+
+    // The threads pause after each phase of every iteration.  After computing the deltas, we check
+    // for convergence and tell all threads whether to continue.
+
+    bool hasMatrix = (matrix.size() > 0);
+    converged = false;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        threadApplyConstraints(threads, threadIndex, atomCoordinates, atomCoordinatesP, inverseMasses, constrainingVelocities, tolerance);
+    });
+    int iteration = 0;
+    while (true) {
+        threads.waitForThreads();
+        int numConverged = 0;
+        for (int count : threadConverged)
+            numConverged += count;
+        converged = (numConverged == numConstraints || iteration == maxIterations);
+        iteration++;
+        threads.resumeThreads();
+        if (converged)
+            break;
+        if (hasMatrix) {
+            threads.waitForThreads();
+            threads.resumeThreads();
+        }
+        threads.waitForThreads();
+        threads.resumeThreads();
+    }
+    threads.waitForThreads();
+}
+
+void CpuCCMA::threadApplyConstraints(ThreadPool& threads, int threadIndex, vector<Vec3>& atomCoordinates, vector<Vec3>& atomCoordinatesP,
+                                     vector<double>& inverseMasses, bool constrainingVelocities, double tolerance) {
+    int numThreads = threads.getNumThreads();
+    int startConstraint = threadIndex*numConstraints/numThreads;
+    int endConstraint = (threadIndex+1)*numConstraints/numThreads;
+    int numAtoms = constrainedAtoms.size();
+    int startAtom = threadIndex*numAtoms/numThreads;
+    int endAtom = (threadIndex+1)*numAtoms/numThreads;
+    bool hasMatrix = (matrix.size() > 0);
+    double lowerTol = 1-2*tolerance+tolerance*tolerance;
+    double upperTol = 1+2*tolerance+tolerance*tolerance;
+    for (int i = startConstraint; i < endConstraint; i++) {
+        r_ij[i] = atomCoordinates[atomIndices[i].first] - atomCoordinates[atomIndices[i].second];
+        d_ij2[i] = r_ij[i].dot(r_ij[i]);
+    }
+    while (true) {
+        // Compute the change to each constraint.
+
+        int numConverged = 0;
+        for (int i = startConstraint; i < endConstraint; i++) {
+            Vec3 rp_ij = atomCoordinatesP[atomIndices[i].first] - atomCoordinatesP[atomIndices[i].second];
+            if (constrainingVelocities) {
+                double rrpr = rp_ij.dot(r_ij[i]);
+                constraintDelta[i] = -2*reducedMasses[i]*rrpr/d_ij2[i];
+                if (fabs(constraintDelta[i]) <= tolerance)
+                    numConverged++;
+            }
+            else {
+                double rp2 = rp_ij.dot(rp_ij);
+                double dist2 = distance[i]*distance[i];
+                double rrpr = rp_ij.dot(r_ij[i]);
+                constraintDelta[i] = reducedMasses[i]*(dist2-rp2)/rrpr;
+                if (rp2 >= lowerTol*dist2 && rp2 <= upperTol*dist2)
+                    numConverged++;
+            }
+        }
+        threadConverged[threadIndex] = numConverged;
+        threads.syncThreads();
+        if (converged)
+            break;
+
+        // Multiply by the coupling matrix.
+
+        if (hasMatrix) {
+            for (int i = startConstraint; i < endConstraint; i++) {
+                double sum = 0.0;
+                for (auto& element : matrix[i])
+                    sum += element.second*constraintDelta[element.first];
+                tempDelta[i] = sum;
+            }
+            threads.syncThreads();
+        }
+
+        // Update the atoms.
+
+        const vector<double>& delta = (hasMatrix ? tempDelta : constraintDelta);
+        for (int i = startAtom; i < endAtom; i++) {
+            int atom = constrainedAtoms[i];
+            Vec3 dr;
+            for (auto& c : atomConstraints[i])
+                dr += r_ij[c.first]*(c.second*delta[c.first]);
+            atomCoordinatesP[atom] += dr*inverseMasses[atom];
+        }
+        threads.syncThreads();
+    }
+}
@@ -0,0 +1,125 @@
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: agent
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuCustomDynamics.h"
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+class CpuCustomDynamics::ThreadData {
+public:
+    /**
+     * A thread's private copy of an expression, along with the global variables that must be
+     * copied into it from the original expression before it is evaluated.
+     */
+    struct ThreadExpression {
+        Lepton::CompiledExpression expression;
+        vector<pair<double*, const double*> > globalsToCopy;
+    };
+    double x, v, m, f, gaussian, uniform;
+    vector<double> perDofVariable;
+    map<const Lepton::CompiledExpression*, ThreadExpression> expressions;
+
+    ThreadData(int numPerDofVariables) : perDofVariable(numPerDofVariables) {
+    }
+    ThreadExpression& getExpression(const Lepton::CompiledExpression& original, const vector<string>& perDofVariableNames) {
+        auto existing = expressions.find(&original);
+        if (existing != expressions.end())
+            return existing->second;
+        ThreadExpression& result = expressions[&original];
+        result.expression = original;
+        map<string, double*> variableLocations;
+        variableLocations["x"] = &x;
+        variableLocations["v"] = &v;
+        variableLocations["m"] = &m;
+        variableLocations["f"] = &f;
+        variableLocations["gaussian"] = &gaussian;
+        variableLocations["uniform"] = &uniform;
+        for (int i = 0; i < perDofVariableNames.size(); i++)
+            variableLocations[perDofVariableNames[i]] = &perDofVariable[i];
+        for (int i = 0; i < 32; i++) {
+            stringstream fname;
+            fname << "f" << i;
+            variableLocations[fname.str()] = &f;
+        }
+        result.expression.setVariableLocations(variableLocations);
+        Lepton::CompiledExpression& source = const_cast<Lepton::CompiledExpression&>(original);
+        for (const string& name : original.getVariables())
+            if (variableLocations.find(name) == variableLocations.end())
+                result.globalsToCopy.push_back(make_pair(&result.expression.getVariableReference(name), &source.getVariableReference(name)));
+        return result;
+    }
+};
+
+CpuCustomDynamics::CpuCustomDynamics(int numberOfAtoms, const CustomIntegrator& integrator, ThreadPool& threads, CpuRandom& random) :
+           ReferenceCustomDynamics(numberOfAtoms, integrator), threads(threads), random(random) {
+    for (int i = 0; i < integrator.getNumPerDofVariables(); i++)
+        perDofVariableNames.push_back(integrator.getPerDofVariableName(i));
+    for (int i = 0; i < threads.getNumThreads(); i++)
+        threadData.push_back(new ThreadData(perDofVariableNames.size()));
+}
+
+CpuCustomDynamics::~CpuCustomDynamics() {
+    for (ThreadData* data : threadData)
+        delete data;
+}
+
+void CpuCustomDynamics::computePerDof(int numberOfAtoms, vector<Vec3>& results, const vector<Vec3>& atomCoordinates,
+              const vector<Vec3>& velocities, const vector<Vec3>& forces, const vector<double>& masses,
+              const vector<vector<Vec3> >& perDof, const Lepton::CompiledExpression& expression) {
+    // Look up the per-thread copies of the expression, creating them the first time it is used.
+
+    vector<ThreadData::ThreadExpression*> threadExpression(threadData.size());
+    for (int i = 0; i < threadData.size(); i++)
+        threadExpression[i] = &threadData[i]->getExpression(expression, perDofVariableNames);
+
+    // Evaluate it in parallel.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        ThreadData& thread = *threadData[threadIndex];
+        ThreadData::ThreadExpression& expr = *threadExpression[threadIndex];
+        for (auto& global : expr.globalsToCopy)
+            *global.first = *global.second;
+        int numPerDof = perDof.size();
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            if (masses[i] != 0.0) {
+                thread.m = masses[i];
+                for (int j = 0; j < 3; j++) {
+                    thread.x = atomCoordinates[i][j];
+                    thread.v = velocities[i][j];
+                    thread.f = forces[i][j];
+                    thread.uniform = random.getUniformRandom(threadIndex);
+                    thread.gaussian = random.getGaussianRandom(threadIndex);
+                    for (int k = 0; k < numPerDof; k++)
+                        thread.perDofVariable[k] = perDof[k][i][j];
+                    results[i][j] = expr.expression.evaluate();
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
@@ -0,0 +1,136 @@
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Contributors: agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuCustomExternalForce.h"
+#include "lepton/Operation.h"
+#include <algorithm>
+
+using namespace OpenMM;
+using namespace std;
+
+static float* getVariablePointer(Lepton::CompiledVectorExpression& expression, const string& name, vector<float>& unused) {
+    // Variables the expression does not use are written to a scratch buffer.
+
+    if (expression.getVariables().find(name) == expression.getVariables().end())
+        return &unused[0];
+    return expression.getVariablePointer(name);
+}
+
+CpuCustomExternalForce::ThreadData::ThreadData(const Lepton::CompiledVectorExpression& expression, const vector<string>& parameterNames) :
+        expression(expression), unused(expression.getWidth()) {
+    x = getVariablePointer(this->expression, "x", unused);
+    y = getVariablePointer(this->expression, "y", unused);
+    z = getVariablePointer(this->expression, "z", unused);
+    for (const string& name : parameterNames)
+        params.push_back(getVariablePointer(this->expression, name, unused));
+    for (const string& name : this->expression.getVariables())
+        if (name != "x" && name != "y" && name != "z" && find(parameterNames.begin(), parameterNames.end(), name) == parameterNames.end())
+            globals[name] = this->expression.getVariablePointer(name);
+}
+
+CpuCustomExternalForce::CpuCustomExternalForce(const Lepton::ParsedExpression& energyExpression, const vector<string>& parameterNames, ThreadPool& threads) :
+        threads(threads) {
+    // The energy and its gradient are compiled together so they can share intermediate values.
+
+    vector<Lepton::ParsedExpression> expressions;
+    expressions.push_back(energyExpression);
+    expressions.push_back(energyExpression.differentiate("x"));
+    expressions.push_back(energyExpression.differentiate("y"));
+    expressions.push_back(energyExpression.differentiate("z"));
+    width = Lepton::CompiledVectorExpression::getAllowedWidths().back();
+    Lepton::CompiledVectorExpression expression(expressions, width);
+    for (int i = 0; i < threads.getNumThreads(); i++)
+        threadData.push_back(new ThreadData(expression, parameterNames));
+}
+
+CpuCustomExternalForce::~CpuCustomExternalForce() {
+    for (ThreadData* data : threadData)
+        delete data;
+}
+
+void CpuCustomExternalForce::calculateForce(const vector<int>& particles, const vector<Vec3>& atomCoordinates, const vector<vector<double> >& parameters,
+            const map<string, double>& globalParameters, vector<AlignedArray<float> >& threadForce, bool includeForces, bool includeEnergy,
+            double& totalEnergy) {
+    this->particles = &particles;
+    this->atomCoordinates = &atomCoordinates;
+    this->parameters = &parameters;
+    this->globalParameters = &globalParameters;
+    this->threadForce = &threadForce;
+    this->includeForces = includeForces;
+    this->includeEnergy = includeEnergy;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeForce(threads, threadIndex); });
+    threads.waitForThreads();
+    if (includeEnergy)
+        for (ThreadData* data : threadData)
+            totalEnergy += data->energy;
+}
+
+void CpuCustomExternalForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
+    ThreadData& data = *threadData[threadIndex];
+    data.energy = 0.0;
+    for (auto& global : data.globals) {
+        float value = (float) globalParameters->at(global.first);
+        for (int i = 0; i < width; i++)
+            global.second[i] = value;
+    }
+
+    // Each thread processes a contiguous range of blocks.  The last block may be only partly
+    // filled, in which case the remaining lanes repeat the final particle and are ignored.
+
+    int numTerms = particles->size();
+    int numBlocks = (numTerms+width-1)/width;
+    int numThreads = threads.getNumThreads();
+    int startBlock = threadIndex*numBlocks/numThreads;
+    int endBlock = (threadIndex+1)*numBlocks/numThreads;
+    float* forces = &(*threadForce)[threadIndex][0];
+    int numParams = data.params.size();
+    for (int block = startBlock; block < endBlock; block++) {
+        int start = block*width;
+        int count = min(width, numTerms-start);
+        for (int i = 0; i < width; i++) {
+            int term = start+min(i, count-1);
+            const Vec3& pos = (*atomCoordinates)[(*particles)[term]];
+            data.x[i] = (float) pos[0];
+            data.y[i] = (float) pos[1];
+            data.z[i] = (float) pos[2];
+            const vector<double>& termParams = (*parameters)[term];
+            for (int j = 0; j < numParams; j++)
+                data.params[j][i] = (float) termParams[j];
+        }
+        const float* energy = data.expression.evaluate();
+        if (includeEnergy)
+            for (int i = 0; i < count; i++)
+                data.energy += energy[i];
+        if (includeForces) {
+            const float* dEdX = data.expression.getOutput(1);
+            const float* dEdY = data.expression.getOutput(2);
+            const float* dEdZ = data.expression.getOutput(3);
+            for (int i = 0; i < count; i++) {
+                float* f = &forces[4*(*particles)[start+i]];
+                f[0] -= dEdX[i];
+                f[1] -= dEdY[i];
+                f[2] -= dEdZ[i];
+            }
+        }
+    }
+}
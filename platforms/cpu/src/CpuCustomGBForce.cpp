@@ -28,10 +28,19 @@
 #include "SimTKOpenMMUtilities.h"
 #include "ReferenceForce.h"
 #include "CpuCustomGBForce.h"
+#include "openmm/internal/hardware.h"
 
 using namespace OpenMM;
 using namespace std;
 
+static void setVecVariable(Lepton::CompiledVectorExpression& expression, const string& name, double value) {
+    if (expression.getVariables().find(name) == expression.getVariables().end())
+        return;
+    float* p = expression.getVariablePointer(name);
+    for (int i = 0; i < expression.getWidth(); i++)
+        p[i] = value;
+}
+
 CpuCustomGBForce::ThreadData::ThreadData(int numAtoms, int numThreads, int threadIndex,
                       const vector<Lepton::CompiledExpression>& valueExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& valueDerivExpressions,
@@ -42,10 +51,13 @@ CpuCustomGBForce::ThreadData::ThreadData(int numAtoms, int numThreads, int threa
                       const vector<vector<Lepton::CompiledExpression> >& energyDerivExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
-                      const vector<string>& parameterNames) :
+                      const vector<string>& parameterNames,
+                      const vector<Lepton::CompiledVectorExpression>& valueVecExpressions,
+                      const vector<vector<Lepton::CompiledVectorExpression> >& energyVecExpressions) :
             valueExpressions(valueExpressions), valueDerivExpressions(valueDerivExpressions), valueGradientExpressions(valueGradientExpressions),
             valueParamDerivExpressions(valueParamDerivExpressions), energyExpressions(energyExpressions), energyDerivExpressions(energyDerivExpressions),
-            energyGradientExpressions(energyGradientExpressions), energyParamDerivExpressions(energyParamDerivExpressions) {
+            energyGradientExpressions(energyGradientExpressions), energyParamDerivExpressions(energyParamDerivExpressions),
+            valueVecExpressions(valueVecExpressions), energyVecExpressions(energyVecExpressions), batchSize(0) {
     firstAtom = (threadIndex*(long long) numAtoms)/numThreads;
     lastAtom = ((threadIndex+1)*(long long) numAtoms)/numThreads;
     map<string, double*> variableLocations;
@@ -118,13 +130,37 @@ CpuCustomGBForce::ThreadData::ThreadData(int numAtoms, int numThreads, int threa
     dVdX.resize(valueDerivExpressions.size());
     dVdY.resize(valueDerivExpressions.size());
     dVdZ.resize(valueDerivExpressions.size());
-    dVdR1.resize(valueDerivExpressions.size());
-    dVdR2.resize(valueDerivExpressions.size());
+    dVdV0.resize(valueDerivExpressions.size());
     dValue0dParam.resize(valueParamDerivExpressions[0].size(), vector<float>(numAtoms));
     energyParamDerivs.resize(valueParamDerivExpressions[0].size());
+
+    // Prepare for passing variables to vectorized expressions.
+
+    map<string, float*> vecVariableLocations;
+    vecWidth = getVectorWidth();
+    vecR.resize(vecWidth);
+    vecParticleParam.resize(2*vecWidth*parameterNames.size());
+    vecParticleValue.resize(2*vecWidth*valueNames.size());
+    batchDeltaR.resize(4*vecWidth);
+    batchAtom1.resize(vecWidth);
+    batchAtom2.resize(vecWidth);
+    vecVariableLocations["r"] = vecR.data();
+    for (int i = 0; i < (int) parameterNames.size(); i++) {
+        vecVariableLocations[parameterNames[i]+"1"] = &vecParticleParam[2*i*vecWidth];
+        vecVariableLocations[parameterNames[i]+"2"] = &vecParticleParam[(2*i+1)*vecWidth];
+    }
+    for (int i = 0; i < (int) valueNames.size(); i++) {
+        vecVariableLocations[valueNames[i]+"1"] = &vecParticleValue[2*i*vecWidth];
+        vecVariableLocations[valueNames[i]+"2"] = &vecParticleValue[(2*i+1)*vecWidth];
+    }
+    for (auto& expression : this->valueVecExpressions)
+        expression.setVariableLocations(vecVariableLocations);
+    for (auto& expressions : this->energyVecExpressions)
+        for (auto& expression : expressions)
+            expression.setVariableLocations(vecVariableLocations);
 }
 
-CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const std::vector<std::set<int> >& exclusions,
+CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const CpuExclusionList& exclusions,
                      const vector<Lepton::CompiledExpression>& valueExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueGradientExpressions,
@@ -136,18 +172,22 @@ CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const std::vector<std::set<int>
                      const vector<vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
                      const vector<CustomGBForce::ComputationType>& energyTypes,
-                     const vector<string>& parameterNames, ThreadPool& threads) :
+                     const vector<string>& parameterNames,
+                     const vector<Lepton::CompiledVectorExpression>& valueVecExpressions,
+                     const vector<vector<Lepton::CompiledVectorExpression> >& energyVecExpressions, ThreadPool& threads) :
             exclusions(exclusions), cutoff(false), periodic(false), valueTypes(valueTypes), energyTypes(energyTypes), numValues(valueNames.size()),
             numParams(parameterNames.size()), threads(threads) {
     for (int i = 0; i < threads.getNumThreads(); i++)
         threadData.push_back(new ThreadData(numAtoms, threads.getNumThreads(), i, valueExpressions, valueDerivExpressions, valueGradientExpressions,
-                valueParamDerivExpressions, valueNames, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, parameterNames));
+                valueParamDerivExpressions, valueNames, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, parameterNames,
+                valueVecExpressions, energyVecExpressions));
     values.resize(numValues);
     dEdV.resize(numValues);
     for (int i = 0; i < (int) values.size(); i++) {
         values[i].resize(numAtoms);
         dEdV[i].resize(numAtoms);
     }
+    dEdV0.resize(numAtoms);
     dValuedParam.resize(numValues);
     for (int i = 0; i < numValues; i++)
         dValuedParam[i].resize(valueParamDerivExpressions[0].size(), vector<float>(numAtoms));
@@ -252,8 +292,14 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
     ThreadData& data = *threadData[threadIndex];
     fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
     fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
-    for (auto& param : *globalParameters)
+    for (auto& param : *globalParameters) {
         data.expressionSet.setVariable(data.expressionSet.getVariableIndex(param.first), param.second);
+        for (auto& expression : data.valueVecExpressions)
+            setVecVariable(expression, param.first, param.second);
+        for (auto& expressions : data.energyVecExpressions)
+            for (auto& expression : expressions)
+                setVecVariable(expression, param.first, param.second);
+    }
 
     // Calculate the first computed value.
 
@@ -340,6 +386,26 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
                 sum += data->dEdV[i][atom];
             dEdV[i][atom] = sum;
         }
+
+        // Every later computed value depends on the atom pairs only through the first one, so combine
+        // their derivatives into the total derivative of the energy with respect to the first value.
+
+        data.x = posq[4*atom];
+        data.y = posq[4*atom+1];
+        data.z = posq[4*atom+2];
+        for (int j = 0; j < numParams; j++)
+            data.param[j] = atomParameters[atom][j];
+        for (int i = 0; i < numValues; i++)
+            data.value[i] = values[i][atom];
+        data.dVdV0[0] = 1.0f;
+        float sum = dEdV[0][atom];
+        for (int i = 1; i < numValues; i++) {
+            data.dVdV0[i] = 0.0f;
+            for (int j = 0; j < i; j++)
+                data.dVdV0[i] += (float) data.valueDerivExpressions[i][j].evaluate()*data.dVdV0[j];
+            sum += dEdV[i][atom]*data.dVdV0[i];
+        }
+        dEdV0[atom] = sum;
     }
     threads.syncThreads();
 
@@ -353,6 +419,7 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
     for (int i = 0; i < numAtoms; i++)
         values[index][i] = 0.0f;
     vector<float>& valueArray = (index == 0 ? data.value0 : values[index]);
+    bool vectorize = (index == 0 && data.valueParamDerivExpressions[index].size() == 0);
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
@@ -369,10 +436,18 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        if (useExclusions && exclusions[first].find(second) != exclusions[first].end())
+                        if (useExclusions && exclusions.isExcluded(first, second))
                             continue;
-                        calculateOnePairValue(index, first, second, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
-                        calculateOnePairValue(index, second, first, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                        if (vectorize) {
+                            if (addPairToBatch(first, second, data, posq, atomParameters, false, boxSize, invBoxSize))
+                                flushPairValueBatch(data, valueArray);
+                            if (addPairToBatch(second, first, data, posq, atomParameters, false, boxSize, invBoxSize))
+                                flushPairValueBatch(data, valueArray);
+                        }
+                        else {
+                            calculateOnePairValue(index, first, second, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                            calculateOnePairValue(index, second, first, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                        }
                     }
                 }
             }
@@ -386,13 +461,23 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
-                calculateOnePairValue(index, i, j, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
-                calculateOnePairValue(index, j, i, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                if (vectorize) {
+                    if (addPairToBatch(i, j, data, posq, atomParameters, false, boxSize, invBoxSize))
+                        flushPairValueBatch(data, valueArray);
+                    if (addPairToBatch(j, i, data, posq, atomParameters, false, boxSize, invBoxSize))
+                        flushPairValueBatch(data, valueArray);
+                }
+                else {
+                    calculateOnePairValue(index, i, j, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                    calculateOnePairValue(index, j, i, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                }
            }
         }
     }
+    if (vectorize)
+        flushPairValueBatch(data, valueArray);
 }
 
 void CpuCustomGBForce::calculateOnePairValue(int index, int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
@@ -421,6 +506,42 @@ void CpuCustomGBForce::calculateOnePairValue(int index, int atom1, int atom2, Th
         data.dValue0dParam[i][atom1] += data.valueParamDerivExpressions[index][i].evaluate();
 }
 
+bool CpuCustomGBForce::addPairToBatch(int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
+        bool includeValues, const fvec4& boxSize, const fvec4& invBoxSize) {
+    fvec4 deltaR;
+    fvec4 pos1(posq+4*atom1);
+    fvec4 pos2(posq+4*atom2);
+    float r2;
+    getDeltaR(pos2, pos1, deltaR, r2, periodic, boxSize, invBoxSize);
+    if (cutoff && r2 >= cutoffDistance2)
+        return false;
+    int width = data.vecWidth;
+    int lane = data.batchSize++;
+    data.vecR[lane] = sqrtf(r2);
+    for (int i = 0; i < numParams; i++) {
+        data.vecParticleParam[2*i*width+lane] = atomParameters[atom1][i];
+        data.vecParticleParam[(2*i+1)*width+lane] = atomParameters[atom2][i];
+    }
+    if (includeValues)
+        for (int i = 0; i < numValues; i++) {
+            data.vecParticleValue[2*i*width+lane] = values[i][atom1];
+            data.vecParticleValue[(2*i+1)*width+lane] = values[i][atom2];
+        }
+    data.batchAtom1[lane] = atom1;
+    data.batchAtom2[lane] = atom2;
+    deltaR.store(&data.batchDeltaR[4*lane]);
+    return (data.batchSize == width);
+}
+
+void CpuCustomGBForce::flushPairValueBatch(ThreadData& data, vector<float>& valueArray) {
+    if (data.batchSize == 0)
+        return;
+    const float* value = data.valueVecExpressions[0].evaluate();
+    for (int i = 0; i < data.batchSize; i++)
+        valueArray[data.batchAtom1[i]] += value[i];
+    data.batchSize = 0;
+}
+
 void CpuCustomGBForce::calculateSingleParticleEnergyTerm(int index, ThreadData& data, int numAtoms, float* posq,
         vector<double>* atomParameters, float* forces, double& totalEnergy) {
     for (int i = data.firstAtom; i < data.lastAtom; i++) {
@@ -448,6 +569,7 @@ void CpuCustomGBForce::calculateSingleParticleEnergyTerm(int index, ThreadData&
 
 void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& data, int numAtoms, float* posq, vector<double>* atomParameters,
         bool useExclusions, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
+    bool vectorize = (data.energyParamDerivExpressions[index].size() == 0);
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
@@ -464,9 +586,12 @@ void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& da
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        if (useExclusions && exclusions[first].find(second) != exclusions[first].end())
+                        if (useExclusions && exclusions.isExcluded(first, second))
                             continue;
-                        calculateOnePairEnergyTerm(index, first, second, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
+                        if (!vectorize)
+                            calculateOnePairEnergyTerm(index, first, second, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
+                        else if (addPairToBatch(first, second, data, posq, atomParameters, true, boxSize, invBoxSize))
+                            flushPairEnergyBatch(index, data, forces, totalEnergy);
                     }
                 }
             }
@@ -480,12 +605,17 @@ void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& da
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
-                calculateOnePairEnergyTerm(index, i, j, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
+                if (!vectorize)
+                    calculateOnePairEnergyTerm(index, i, j, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
+                else if (addPairToBatch(i, j, data, posq, atomParameters, true, boxSize, invBoxSize))
+                    flushPairEnergyBatch(index, data, forces, totalEnergy);
            }
         }
     }
+    if (vectorize)
+        flushPairEnergyBatch(index, data, forces, totalEnergy);
 }
 
 void CpuCustomGBForce::calculateOnePairEnergyTerm(int index, int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
@@ -533,8 +663,41 @@ void CpuCustomGBForce::calculateOnePairEnergyTerm(int index, int atom1, int atom
         data.energyParamDerivs[i] += data.energyParamDerivExpressions[index][i].evaluate();
 }
 
+void CpuCustomGBForce::flushPairEnergyBatch(int index, ThreadData& data, float* forces, double& totalEnergy) {
+    int count = data.batchSize;
+    if (count == 0)
+        return;
+    vector<Lepton::CompiledVectorExpression>& expressions = data.energyVecExpressions[index];
+    if (includeEnergy) {
+        const float* energy = expressions[0].evaluate();
+        for (int i = 0; i < count; i++)
+            totalEnergy += energy[i];
+    }
+    const float* dEdR = expressions[1].evaluate();
+    for (int i = 0; i < count; i++) {
+        int atom1 = data.batchAtom1[i];
+        int atom2 = data.batchAtom2[i];
+        fvec4 result = fvec4(&data.batchDeltaR[4*i])*(dEdR[i]/data.vecR[i]);
+        (fvec4(forces+4*atom1)-result).store(forces+4*atom1);
+        (fvec4(forces+4*atom2)+result).store(forces+4*atom2);
+    }
+    for (int j = 0; j < numValues; j++) {
+        const float* dEdV1 = expressions[2*j+2].evaluate();
+        for (int i = 0; i < count; i++)
+            data.dEdV[j][data.batchAtom1[i]] += dEdV1[i];
+        const float* dEdV2 = expressions[2*j+3].evaluate();
+        for (int i = 0; i < count; i++)
+            data.dEdV[j][data.batchAtom2[i]] += dEdV2[i];
+    }
+    data.batchSize = 0;
+}
+
 void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms, float* posq, vector<double>* atomParameters,
         float* forces, const fvec4& boxSize, const fvec4& invBoxSize) {
+    // Excluded pairs do not contribute to the first computed value, and the other values depend on pairs
+    // only through it, so excluded pairs can be skipped entirely.
+
+    bool excludePairs = (valueTypes[0] == CustomGBForce::ParticlePair);
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
@@ -551,9 +714,12 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        bool isExcluded = (exclusions[first].find(second) != exclusions[first].end());
-                        calculateOnePairChainRule(first, second, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
-                        calculateOnePairChainRule(second, first, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
+                        if (excludePairs && exclusions.isExcluded(first, second))
+                            continue;
+                        if (addPairToBatch(first, second, data, posq, atomParameters, false, boxSize, invBoxSize))
+                            flushPairChainRuleBatch(data, forces);
+                        if (addPairToBatch(second, first, data, posq, atomParameters, false, boxSize, invBoxSize))
+                            flushPairChainRuleBatch(data, forces);
                     }
                 }
             }
@@ -567,12 +733,16 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                bool isExcluded = (exclusions[i].find(j) != exclusions[i].end());
-                calculateOnePairChainRule(i, j, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
-                calculateOnePairChainRule(j, i, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
+                if (excludePairs && exclusions.isExcluded(i, j))
+                    continue;
+                if (addPairToBatch(i, j, data, posq, atomParameters, false, boxSize, invBoxSize))
+                    flushPairChainRuleBatch(data, forces);
+                if (addPairToBatch(j, i, data, posq, atomParameters, false, boxSize, invBoxSize))
+                    flushPairChainRuleBatch(data, forces);
            }
         }
     }
+    flushPairChainRuleBatch(data, forces);
 
     // Compute chain rule terms for computed values that depend explicitly on particle coordinates.
 
@@ -610,59 +780,18 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
                 data.energyParamDerivs[k] += dEdV[j][i]*dValuedParam[j][k][i];
 }
 
-void CpuCustomGBForce::calculateOnePairChainRule(int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
-        float* forces, bool isExcluded, const fvec4& boxSize, const fvec4& invBoxSize) {
-    // Compute the displacement.
-
-    fvec4 deltaR;
-    fvec4 pos1(posq+4*atom1);
-    fvec4 pos2(posq+4*atom2);
-    float r2;
-    getDeltaR(pos2, pos1, deltaR, r2, periodic, boxSize, invBoxSize);
-    if (cutoff && r2 >= cutoffDistance2)
+void CpuCustomGBForce::flushPairChainRuleBatch(ThreadData& data, float* forces) {
+    if (data.batchSize == 0)
         return;
-    float r = sqrtf(r2);
-    data.r = r;
-
-    // Record variables for evaluating expressions.
-
-    for (int i = 0; i < numParams; i++) {
-        data.particleParam[i*2] = atomParameters[atom1][i];
-        data.particleParam[i*2+1] = atomParameters[atom2][i];
-        data.param[i] = atomParameters[atom1][i];
-    }
-    data.value[0] = values[0][atom1];
-    data.x = posq[4*atom1];
-    data.y = posq[4*atom1+1];
-    data.z = posq[4*atom1+2];
-    data.particleValue[0] = values[0][atom1];
-    data.particleValue[1] = values[0][atom2];
-
-    // Evaluate the derivative of each parameter with respect to position and apply forces.
-
-    float rinv = 1/r;
-    deltaR *= rinv;
-    fvec4 f1(0.0f), f2(0.0f);
-    if (!isExcluded || valueTypes[0] != CustomGBForce::ParticlePair) {
-        data.dVdR1[0] = (float) data.valueDerivExpressions[0][0].evaluate();
-        data.dVdR2[0] = -data.dVdR1[0];
-        f1 -= deltaR*(dEdV[0][atom1]*data.dVdR1[0]);
-        f2 -= deltaR*(dEdV[0][atom1]*data.dVdR2[0]);
-    }
-    for (int i = 1; i < (int) values.size(); i++) {
-        data.value[i] = values[i][atom1];
-        data.dVdR1[i] = 0.0;
-        data.dVdR2[i] = 0.0;
-        for (int j = 0; j < i; j++) {
-            float dVdV = (float) data.valueDerivExpressions[i][j].evaluate();
-            data.dVdR1[i] += dVdV*data.dVdR1[j];
-            data.dVdR2[i] += dVdV*data.dVdR2[j];
-        }
-        f1 -= deltaR*(dEdV[i][atom1]*data.dVdR1[i]);
-        f2 -= deltaR*(dEdV[i][atom1]*data.dVdR2[i]);
+    const float* dVdR = data.valueVecExpressions[1].evaluate();
+    for (int i = 0; i < data.batchSize; i++) {
+        int atom1 = data.batchAtom1[i];
+        int atom2 = data.batchAtom2[i];
+        fvec4 f = fvec4(&data.batchDeltaR[4*i])*(dEdV0[atom1]*dVdR[i]/data.vecR[i]);
+        (fvec4(forces+4*atom1)-f).store(forces+4*atom1);
+        (fvec4(forces+4*atom2)+f).store(forces+4*atom2);
     }
-    (fvec4(forces+4*atom1)+f1).store(forces+4*atom1);
-    (fvec4(forces+4*atom2)+f2).store(forces+4*atom2);
+    data.batchSize = 0;
 }
 
 void CpuCustomGBForce::getDeltaR(const fvec4& posI, const fvec4& posJ, fvec4& deltaR, float& r2, bool periodic, const fvec4& boxSize, const fvec4& invBoxSize) const {
@@ -47,7 +47,7 @@ CpuCustomManyParticleForce::CpuCustomManyParticleForce(const CustomManyParticleF
 
     map<string, Lepton::CustomFunction*> functions;
     for (int i = 0; i < (int) force.getNumTabulatedFunctions(); i++)
-        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i), threads);
 
     // Create implementations of point functions.
 
@@ -70,17 +70,37 @@ CpuCustomManyParticleForce::CpuCustomManyParticleForce(const CustomManyParticleF
     
     // Record exclusions.
     
-    exclusions.resize(force.getNumParticles());
+    vector<pair<int, int> > excludedPairs;
     for (int i = 0; i < (int) force.getNumExclusions(); i++) {
         int p1, p2;
         force.getExclusionParticles(i, p1, p2);
-        exclusions[p1].insert(p2);
-        exclusions[p2].insert(p1);
+        excludedPairs.push_back(make_pair(p1, p2));
     }
+    exclusions = CpuExclusionList(force.getNumParticles(), excludedPairs);
     
     // Record information about type filters.
     
     CustomManyParticleForceImpl::buildFilterArrays(force, numTypes, particleTypes, orderIndex, particleOrder);
+
+    // Record which combinations of types for the first few particles in a set can be completed to
+    // an allowed set.  This lets us skip partial sets early rather than enumerating every set.
+
+    if (particleOrder.size() > 1) {
+        validTypePrefix.resize(numParticlesPerSet);
+        int numPrefixes = 1;
+        for (int i = 1; i < numParticlesPerSet; i++) {
+            numPrefixes *= numTypes;
+            validTypePrefix[i].resize(numPrefixes, false);
+        }
+        for (int index = 0; index < (int) orderIndex.size(); index++)
+            if (orderIndex[index] != -1) {
+                int divisor = 1;
+                for (int i = 1; i < numParticlesPerSet; i++) {
+                    divisor *= numTypes;
+                    validTypePrefix[i][index%divisor] = true;
+                }
+            }
+    }
 }
 
 CpuCustomManyParticleForce::~CpuCustomManyParticleForce() {
@@ -159,6 +179,8 @@ void CpuCustomManyParticleForce::threadComputeForce(ThreadPool& threads, int thr
             int i = atomicCounter++;
             if (i >= numParticles)
                 break;
+            if (!isValidTypePrefix(particleIndices, 0, i))
+                continue;
             particleIndices[0] = i;
             loopOverInteractions(particleNeighbors[i], particleIndices, 1, 0, particleParameters, forces, data, boxSize, invBoxSize);
         }
@@ -173,6 +195,8 @@ void CpuCustomManyParticleForce::threadComputeForce(ThreadPool& threads, int thr
             int i = atomicCounter++;
             if (i >= numParticles)
                 break;
+            if (!isValidTypePrefix(particleIndices, 0, i))
+                continue;
             particleIndices[0] = i;
             int startIndex = (centralParticleMode ? 0 : i+1);
             loopOverInteractions(particles, particleIndices, 1, startIndex, particleParameters, forces, data, boxSize, invBoxSize);
@@ -180,6 +204,19 @@ void CpuCustomManyParticleForce::threadComputeForce(ThreadPool& threads, int thr
     }
 }
 
+bool CpuCustomManyParticleForce::isValidTypePrefix(const vector<int>& particleSet, int loopIndex, int particle) const {
+    if (validTypePrefix.size() == 0 || loopIndex == numParticlesPerSet-1)
+        return true;
+    int index = 0;
+    int scale = 1;
+    for (int i = 0; i < loopIndex; i++) {
+        index += particleTypes[particleSet[i]]*scale;
+        scale *= numTypes;
+    }
+    index += particleTypes[particle]*scale;
+    return validTypePrefix[loopIndex+1][index];
+}
+
 void CpuCustomManyParticleForce::setUseCutoff(double distance) {
     useCutoff = true;
     cutoffDistance = distance;
@@ -219,8 +256,8 @@ void CpuCustomManyParticleForce::loopOverInteractions(vector<int>& availablePart
         
         // Check whether this particle can actually participate in interactions with the others found so far.
         
-        bool include = true;
-        if (useCutoff) {
+        bool include = isValidTypePrefix(particleSet, loopIndex, particle);
+        if (useCutoff && include) {
             fvec4 deltaR;
             fvec4 pos1(posq+4*particle);
             float r2;
@@ -231,7 +268,7 @@ void CpuCustomManyParticleForce::loopOverInteractions(vector<int>& availablePart
             }
         }
         for (int j = 0; j < loopIndex && include; j++)
-            include &= (exclusions[particle].find(particleSet[j]) == exclusions[particle].end());
+            include &= !exclusions.isExcluded(particle, particleSet[j]);
         if (include) {
             if (loopIndex > 0 && availableParticles[i] == particleSet[0])
                 continue;
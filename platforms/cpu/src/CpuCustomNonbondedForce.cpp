@@ -95,11 +95,11 @@ CpuCustomNonbondedForce::ThreadData::ThreadData(const CompiledExpression& energy
 }
 
 CpuCustomNonbondedForce::CpuCustomNonbondedForce(ThreadPool& threads, const CpuNeighborList& neighbors) : cutoff(false), useSwitch(false),
-        periodic(false), useInteractionGroups(false), threads(threads), neighborList(&neighbors) {
+        periodic(false), useInteractionGroups(false), deterministic(false), threads(threads), neighborList(&neighbors), computedValuesValid(false) {
 }
 
 void CpuCustomNonbondedForce::initialize(const ParsedExpression& energyExpression,
-            const ParsedExpression& forceExpression, const vector<string>& parameterNames, const vector<set<int> >& exclusions,
+            const ParsedExpression& forceExpression, const vector<string>& parameterNames, const CpuExclusionList& exclusions,
             const vector<ParsedExpression> energyParamDerivExpressions, const vector<string>& computedValueNames,
             const vector<ParsedExpression> computedValueExpressions) {
     this->paramNames = parameterNames;
@@ -136,7 +136,7 @@ void CpuCustomNonbondedForce::setInteractionGroups(const vector<pair<set<int>, s
         const set<int>& set2 = group.second;
         for (set<int>::const_iterator atom1 = set1.begin(); atom1 != set1.end(); ++atom1) {
             for (set<int>::const_iterator atom2 = set2.begin(); atom2 != set2.end(); ++atom2) {
-                if (*atom1 == *atom2 || exclusions[*atom1].find(*atom2) != exclusions[*atom1].end())
+                if (*atom1 == *atom2 || exclusions.isExcluded(*atom1, *atom2))
                     continue; // This is an excluded interaction.
                 if (*atom1 > *atom2 && set1.find(*atom2) != set1.end() && set2.find(*atom1) != set2.end())
                     continue; // Both atoms are in both sets, so skip duplicate interactions.
@@ -172,6 +172,14 @@ void CpuCustomNonbondedForce::setPeriodic(Vec3* periodicBoxVectors) {
                  periodicBoxVectors[2][0] != 0.0 || periodicBoxVectors[2][1] != 0.0);
 }
 
+void CpuCustomNonbondedForce::setDeterministic(bool deterministic) {
+    this->deterministic = deterministic;
+}
+
+void CpuCustomNonbondedForce::invalidateComputedValues() {
+    computedValuesValid = false;
+}
+
 
 void CpuCustomNonbondedForce::calculatePairIxn(int numberOfAtoms, float* posq, vector<Vec3>& atomCoordinates, vector<vector<double> >& atomParameters,
                                                const map<string, double>& globalParameters, vector<AlignedArray<float> >& threadForce,
@@ -187,8 +195,19 @@ void CpuCustomNonbondedForce::calculatePairIxn(int numberOfAtoms, float* posq, v
     this->includeForce = includeForce;
     this->includeEnergy = includeEnergy;
     threadEnergy.resize(threads.getNumThreads());
-    atomComputedValues.resize(computedValueNames.size(), vector<double>(numberOfAtoms));
+    if (atomComputedValues.size() != computedValueNames.size() || (atomComputedValues.size() > 0 && atomComputedValues[0].size() != numberOfAtoms)) {
+        atomComputedValues.clear();
+        atomComputedValues.resize(computedValueNames.size(), vector<double>(numberOfAtoms));
+        computedValuesValid = false;
+    }
+    recomputeValues = (!computedValuesValid || globalParameters != computedValueGlobals);
+    if (recomputeValues) {
+        computedValueGlobals = globalParameters;
+        computedValuesValid = true;
+    }
     atomicCounter = 0;
+    if (deterministic && !useInteractionGroups)
+        neighborList->getBalancedBlockRanges(threads.getNumThreads(), blockRanges);
     
     // Signal the threads to start running and wait for them to finish.
     
@@ -240,7 +259,7 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
     // Process computed values for this thread's subset of interactions.
 
     int numComputedValues = atomComputedValues.size();
-    if (numComputedValues > 0) {
+    if (numComputedValues > 0 && recomputeValues) {
         int start = threadIndex*numberOfAtoms/numThreads;
         int end = (threadIndex+1)*numberOfAtoms/numThreads;
         for (int i = start; i < end; i++) {
@@ -281,11 +300,17 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
         }
     }
     else {
-        // Get the interactions from the neighbor list.
+        // Get the interactions from the neighbor list.  In deterministic mode, each thread processes a
+        // fixed range of blocks instead of taking the next one that is available.
 
+        int blockIndex = (deterministic ? blockRanges[threadIndex]-1 : 0);
+        int endBlock = (deterministic ? blockRanges[threadIndex+1] : neighborList->getNumBlocks());
         while (true) {
-            int blockIndex = atomicCounter++;
-            if (blockIndex >= neighborList->getNumBlocks())
+            if (deterministic)
+                blockIndex++;
+            else
+                blockIndex = atomicCounter++;
+            if (blockIndex >= endBlock)
                 break;
             if (data.energyParamDerivs.size() == 0)
                 calculateBlockIxn(data, blockIndex, forces, energy, boxSize, invBoxSize);
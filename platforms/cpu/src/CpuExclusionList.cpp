@@ -0,0 +1,87 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuExclusionList.h"
+#include <algorithm>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuExclusionList::CpuExclusionList() : offsets(1, 0) {
+}
+
+CpuExclusionList::CpuExclusionList(int numAtoms) : offsets(numAtoms+1, 0) {
+}
+
+CpuExclusionList::CpuExclusionList(int numAtoms, const vector<pair<int, int> >& pairs) : offsets(numAtoms+1, 0) {
+    // Count the exclusions for each atom and fill in the rows.
+
+    for (auto& pair : pairs) {
+        offsets[pair.first+1]++;
+        offsets[pair.second+1]++;
+    }
+    for (int i = 0; i < numAtoms; i++)
+        offsets[i+1] += offsets[i];
+    indices.resize(offsets[numAtoms]);
+    vector<int> next(offsets.begin(), offsets.end()-1);
+    for (auto& pair : pairs) {
+        indices[next[pair.first]++] = pair.second;
+        indices[next[pair.second]++] = pair.first;
+    }
+
+    // Sort each row and compact it to remove duplicates.
+
+    int numStored = 0;
+    for (int i = 0; i < numAtoms; i++) {
+        auto start = indices.begin()+offsets[i];
+        auto end = indices.begin()+offsets[i+1];
+        sort(start, end);
+        end = unique(start, end);
+        offsets[i] = numStored;
+        numStored = copy(start, end, indices.begin()+numStored)-indices.begin();
+    }
+    offsets[numAtoms] = numStored;
+    indices.resize(numStored);
+    indices.shrink_to_fit();
+}
+
+CpuExclusionList::CpuExclusionList(const vector<set<int> >& exclusions) : offsets(exclusions.size()+1, 0) {
+    for (int i = 0; i < (int) exclusions.size(); i++)
+        offsets[i+1] = offsets[i]+exclusions[i].size();
+    indices.reserve(offsets.back());
+    for (const set<int>& atomExclusions : exclusions)
+        indices.insert(indices.end(), atomExclusions.begin(), atomExclusions.end());
+}
+
+bool CpuExclusionList::isExcluded(int atom1, int atom2) const {
+    Range exclusions = (*this)[atom1];
+    return binary_search(exclusions.begin(), exclusions.end(), atom2);
+}
@@ -35,7 +35,7 @@ const int CpuGBSAOBCForce::NUM_TABLE_POINTS = 4096;
 const float CpuGBSAOBCForce::TABLE_MIN = 0.25f;
 const float CpuGBSAOBCForce::TABLE_MAX = 1.5f;
 
-CpuGBSAOBCForce::CpuGBSAOBCForce() : cutoff(false), periodic(false) {
+CpuGBSAOBCForce::CpuGBSAOBCForce() : cutoff(false), periodic(false), deterministic(false) {
     logDX = (TABLE_MAX-TABLE_MIN)/NUM_TABLE_POINTS;
     logDXInv = 1.0f/logDX;
     logTable.resize(NUM_TABLE_POINTS+4);
@@ -69,6 +69,10 @@ void CpuGBSAOBCForce::setSurfaceAreaEnergy(float energy) {
     surfaceAreaFactor = 4*M_PI*energy;
 }
 
+void CpuGBSAOBCForce::setDeterministic(bool deterministic) {
+    this->deterministic = deterministic;
+}
+
 const std::vector<std::pair<float, float> >& CpuGBSAOBCForce::getParticleParameters() const {
     return particleParams;
 }
@@ -211,8 +215,13 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
     AlignedArray<float>& bornForces = threadBornForces[threadIndex];
     for (int i = 0; i < numParticles; i++)
         bornForces[i] = 0.0f;
+    // The following loops accumulate values into per-thread buffers.  In deterministic mode, work is
+    // assigned to threads in a fixed interleaved order rather than taken as threads become free.
+
+    int atomI = threadIndex;
     while (true) {
-        int atomI = atomicCounter++;
+        if (!deterministic)
+            atomI = atomicCounter++;
         if (atomI >= numParticles)
             break;
         if (bornRadii[atomI] > 0) {
@@ -225,6 +234,8 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
         }
         else
             bornForces[atomI] = 0.0f;
+        if (deterministic)
+            atomI += numThreads;
     }
     threads.syncThreads();
  
@@ -236,8 +247,10 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
         preFactor = ONE_4PI_EPS0*((1.0f/solventDielectric) - (1.0f/soluteDielectric));
     else
         preFactor = 0.0f;
+    int blockStart = 4*threadIndex;
     while (true) {
-        int blockStart = atomicCounter.fetch_add(4);
+        if (!deterministic)
+            blockStart = atomicCounter.fetch_add(4);
         if (blockStart >= numParticles)
             break;
         int numInBlock = min(4, numParticles-blockStart);
@@ -309,13 +322,17 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
             (fvec4(forces+4*atomIndex)+f[i]).store(forces+4*atomIndex);
             bornForces[atomIndex] += blockAtomBornForce[i];
         }
+        if (deterministic)
+            blockStart += 4*numThreads;
     }
     threads.syncThreads();
 
     // Second loop of Born energy computation.
 
+    blockStart = 4*threadIndex;
     while (true) {
-        int blockStart = atomicCounter.fetch_add(4);
+        if (!deterministic)
+            blockStart = atomicCounter.fetch_add(4);
         if (blockStart >= numParticles)
             break;
         fvec4 bornForce(0.0f);
@@ -388,6 +405,8 @@ void CpuGBSAOBCForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
             int atomIndex = blockStart+i;
             (fvec4(forces+4*atomIndex)+f[i]).store(forces+4*atomIndex);
         }
+        if (deterministic)
+            blockStart += 4*numThreads;
     }
     threadEnergy[threadIndex] = energy;
 }
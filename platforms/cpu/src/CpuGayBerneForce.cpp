@@ -43,6 +43,97 @@
 using namespace OpenMM;
 using namespace std;
 
+namespace {
+
+/**
+ * The layout of the per-particle values in CpuGayBerneForce::frames.
+ */
+enum FrameComponent {
+    FrameA = 0, FrameB = 9, FrameG = 18, FrameRadius2 = 27, FrameShape = 30, FrameSigmaOver2 = 31,
+    FrameSqrtEpsilon = 32, FramePointParticle = 33, NumFrameComponents = 34
+};
+
+/**
+ * Four 3-vectors, stored with one vector per lane.
+ */
+struct Vec3x4 {
+    fvec4 x, y, z;
+    Vec3x4() {
+    }
+    Vec3x4(fvec4 x, fvec4 y, fvec4 z) : x(x), y(y), z(z) {
+    }
+    Vec3x4 operator+(const Vec3x4& v) const {
+        return Vec3x4(x+v.x, y+v.y, z+v.z);
+    }
+    Vec3x4 operator-(const Vec3x4& v) const {
+        return Vec3x4(x-v.x, y-v.y, z-v.z);
+    }
+    Vec3x4 operator*(fvec4 scale) const {
+        return Vec3x4(x*scale, y*scale, z*scale);
+    }
+    fvec4 dot(const Vec3x4& v) const {
+        return x*v.x + y*v.y + z*v.z;
+    }
+    Vec3x4 cross(const Vec3x4& v) const {
+        return Vec3x4(y*v.z-z*v.y, z*v.x-x*v.z, x*v.y-y*v.x);
+    }
+};
+
+/**
+ * Four 3x3 matrices, stored with one matrix per lane.
+ */
+struct Mat3x4 {
+    fvec4 v[3][3];
+    Mat3x4() {
+    }
+    Mat3x4(const fvec4* components) {
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                v[i][j] = components[3*i+j];
+    }
+    Vec3x4 operator*(const Vec3x4& r) const {
+        return Vec3x4(v[0][0]*r.x + v[0][1]*r.y + v[0][2]*r.z,
+                      v[1][0]*r.x + v[1][1]*r.y + v[1][2]*r.z,
+                      v[2][0]*r.x + v[2][1]*r.y + v[2][2]*r.z);
+    }
+    Mat3x4 operator+(const Mat3x4& m) const {
+        Mat3x4 result;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                result.v[i][j] = v[i][j]+m.v[i][j];
+        return result;
+    }
+    Vec3x4 row(int i) const {
+        return Vec3x4(v[i][0], v[i][1], v[i][2]);
+    }
+    fvec4 determinant() const {
+        return (v[0][0]*v[1][1]*v[2][2] + v[0][1]*v[1][2]*v[2][0] + v[0][2]*v[1][0]*v[2][1] -
+                v[0][0]*v[1][2]*v[2][1] - v[0][1]*v[1][0]*v[2][2] - v[0][2]*v[1][1]*v[2][0]);
+    }
+    Mat3x4 inverse() const {
+        fvec4 invDet = 1.0f/determinant();
+        Mat3x4 result;
+        result.v[0][0] = invDet*(v[1][1]*v[2][2] - v[1][2]*v[2][1]);
+        result.v[1][0] = -invDet*(v[1][0]*v[2][2] - v[1][2]*v[2][0]);
+        result.v[2][0] = invDet*(v[1][0]*v[2][1] - v[1][1]*v[2][0]);
+        result.v[0][1] = -invDet*(v[0][1]*v[2][2] - v[0][2]*v[2][1]);
+        result.v[1][1] = invDet*(v[0][0]*v[2][2] - v[0][2]*v[2][0]);
+        result.v[2][1] = -invDet*(v[0][0]*v[2][1] - v[0][1]*v[2][0]);
+        result.v[0][2] = invDet*(v[0][1]*v[1][2] - v[0][2]*v[1][1]);
+        result.v[1][2] = -invDet*(v[0][0]*v[1][2] - v[0][2]*v[1][0]);
+        result.v[2][2] = invDet*(v[0][0]*v[1][1] - v[0][1]*v[1][0]);
+        return result;
+    }
+};
+
+Vec3x4 operator*(const Vec3x4& r, const Mat3x4& m) {
+    return Vec3x4(m.v[0][0]*r.x + m.v[1][0]*r.y + m.v[2][0]*r.z,
+                  m.v[0][1]*r.x + m.v[1][1]*r.y + m.v[2][1]*r.z,
+                  m.v[0][2]*r.x + m.v[1][2]*r.y + m.v[2][2]*r.z);
+}
+
+} // namespace
+
 CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     // Record the force parameters.
 
@@ -64,7 +155,7 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     }
     int numExceptions = force.getNumExceptions();
     exceptions.resize(numExceptions);
-    particleExclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs;
     for (int i = 0; i < numExceptions; i++) {
         ExceptionInfo& e = exceptions[i];
         double sigma, epsilon;
@@ -72,9 +163,9 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
         e.sigma = sigma;
         e.epsilon = epsilon;
         exclusions.insert(make_pair(min(e.particle1, e.particle2), max(e.particle1, e.particle2)));
-        particleExclusions[e.particle1].insert(e.particle2);
-        particleExclusions[e.particle2].insert(e.particle1);
+        excludedPairs.push_back(make_pair(e.particle1, e.particle2));
     }
+    particleExclusions = CpuExclusionList(numParticles, excludedPairs);
     nonbondedMethod = force.getNonbondedMethod();
     if (nonbondedMethod == GayBerneForce::NoCutoff) {
         cutoffDistance = 0.0;
@@ -92,16 +183,24 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     A.resize(numParticles);
     B.resize(numParticles);
     G.resize(numParticles);
+    frames.resize(NumFrameComponents*numParticles);
 
     // We can precompute the shape factors.
 
     for (int i = 0; i < numParticles; i++) {
         ParticleInfo& p = particles[i];
         s[i] = (p.rx*p.ry + p.rz*p.rz)*sqrtf(p.rx*p.ry);
+        frames[(FrameRadius2+0)*numParticles+i] = p.rx*p.rx;
+        frames[(FrameRadius2+1)*numParticles+i] = p.ry*p.ry;
+        frames[(FrameRadius2+2)*numParticles+i] = p.rz*p.rz;
+        frames[FrameShape*numParticles+i] = s[i];
+        frames[FrameSigmaOver2*numParticles+i] = p.sigmaOver2;
+        frames[FrameSqrtEpsilon*numParticles+i] = p.sqrtEpsilon;
+        frames[FramePointParticle*numParticles+i] = (p.isPointParticle ? 1.0f : 0.0f);
     }
 }
 
-const vector<set<int> >& CpuGayBerneForce::getExclusions() const {
+const CpuExclusionList& CpuGayBerneForce::getExclusions() const {
     return particleExclusions;
 }
 
@@ -163,6 +262,8 @@ void CpuGayBerneForce::threadComputeForce(ThreadPool& threads, int threadIndex,
 
     // Compute this thread's subset of interactions.
     
+    fvec4 frame2[NumFrameComponents];
+    int lanes[4];
     if (cutoffDistance == 0.0) {
         while (true) {
             int i = atomicCounter++;
@@ -170,14 +271,22 @@ void CpuGayBerneForce::threadComputeForce(ThreadPool& threads, int threadIndex,
                 break;
             if (particles[i].sqrtEpsilon == 0.0f)
                 continue;
-            for (int j = 0; j < i; j++) {
-                if (particles[j].sqrtEpsilon == 0.0f)
+            for (int start = 0; start < i; start += 4) {
+                int laneMask = 0;
+                for (int k = 0; k < 4; k++) {
+                    int j = start+k;
+                    lanes[k] = 0;
+                    if (j >= i || particles[j].sqrtEpsilon == 0.0f)
+                        continue;
+                    if (particleExclusions.isExcluded(i, j))
+                        continue; // This interaction will be handled by an exception.
+                    lanes[k] = j;
+                    laneMask |= 1<<k;
+                }
+                if (laneMask == 0)
                     continue;
-                if (particleExclusions[i].find(j) != particleExclusions[i].end())
-                    continue; // This interaction will be handled by an exception.
-                double sigma = particles[i].sigmaOver2+particles[j].sigmaOver2;
-                double epsilon = particles[i].sqrtEpsilon*particles[j].sqrtEpsilon;
-                energy += computeOneInteraction(i, j, sigma, epsilon, positions, forces, torques, boxVectors);
+                loadFrames(lanes, frame2);
+                energy += computeFourInteractions(i, lanes, laneMask, frame2, forces, torques);
             }
         }
     }
@@ -190,20 +299,30 @@ void CpuGayBerneForce::threadComputeForce(ThreadPool& threads, int threadIndex,
             const int32_t* blockAtom = &neighborList->getSortedAtoms()[blockSize*blockIndex];
             const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
             const auto& exclusions = neighborList->getBlockExclusions(blockIndex);
-            for (int i = 0; i < (int) neighbors.size(); i++) {
-                int first = neighbors[i];
-                if (particles[first].sqrtEpsilon == 0.0f)
-                    continue;
-                for (int k = 0; k < blockSize; k++) {
-                    if ((exclusions[i] & (1<<k)) == 0) {
-                        int second = blockAtom[k];
-                        if (particles[second].sqrtEpsilon == 0.0f)
-                            continue;
-                        double sigma = particles[first].sigmaOver2+particles[second].sigmaOver2;
-                        double epsilon = particles[first].sqrtEpsilon*particles[second].sqrtEpsilon;
-                        energy += computeOneInteraction(first, second, sigma, epsilon, positions, forces, torques, boxVectors);
+            int atomsInBlock = min(blockSize, (int) neighborList->getSortedAtoms().size()-blockSize*blockIndex);
+
+            // Process the block atoms four at a time, loading their frames once for all neighbors.
+
+            for (int start = 0; start < atomsInBlock; start += 4) {
+                int blockMask = 0;
+                for (int k = 0; k < 4; k++) {
+                    lanes[k] = 0;
+                    if (start+k < atomsInBlock && particles[blockAtom[start+k]].sqrtEpsilon != 0.0f) {
+                        lanes[k] = blockAtom[start+k];
+                        blockMask |= 1<<k;
                     }
                 }
+                if (blockMask == 0)
+                    continue;
+                loadFrames(lanes, frame2);
+                for (int i = 0; i < (int) neighbors.size(); i++) {
+                    int first = neighbors[i];
+                    if (particles[first].sqrtEpsilon == 0.0f)
+                        continue;
+                    int laneMask = blockMask & ~(exclusions[i]>>start);
+                    if (laneMask != 0)
+                        energy += computeFourInteractions(first, lanes, laneMask, frame2, forces, torques);
+                }
             }
         }
     }
@@ -279,6 +398,12 @@ void CpuGayBerneForce::computeEllipsoidFrames(const vector<Vec3>& positions) {
                     g[i][j] += a[k][i]*r2[k]*a[k][j];
                 }
             }
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++) {
+                frames[(FrameA+3*i+j)*numParticles+particle] = a[i][j];
+                frames[(FrameB+3*i+j)*numParticles+particle] = b[i][j];
+                frames[(FrameG+3*i+j)*numParticles+particle] = g[i][j];
+            }
     }
 }
 
@@ -446,3 +571,199 @@ double CpuGayBerneForce::computeOneInteraction(int particle1, int particle2, dou
     }
     return switchValue*energy;
 }
+
+void CpuGayBerneForce::loadFrames(const int* lanes, fvec4* frame) const {
+    int numParticles = particles.size();
+    for (int i = 0; i < NumFrameComponents; i++) {
+        const float* component = &frames[i*numParticles];
+        frame[i] = fvec4(component[lanes[0]], component[lanes[1]], component[lanes[2]], component[lanes[3]]);
+    }
+}
+
+double CpuGayBerneForce::computeFourInteractions(int particle1, const int* lanes, int laneMask, const fvec4* frame2,
+        float* forces, vector<Vec3>& torques) {
+    // Compute the displacements in double precision, then check them against the cutoff.  Empty lanes
+    // get an arbitrary finite displacement and are masked out at the end.
+
+    float dx[4], dy[4], dz[4];
+    bool anyPointPairs = false, anyEllipsoidPairs = false;
+    for (int k = 0; k < 4; k++) {
+        Vec3 delta(1, 0, 0);
+        if (laneMask & (1<<k)) {
+            if (nonbondedMethod == GayBerneForce::CutoffPeriodic)
+                delta = ReferenceForce::getDeltaRPeriodic(positions[lanes[k]], positions[particle1], boxVectors);
+            else
+                delta = positions[particle1]-positions[lanes[k]];
+            if (particles[particle1].isPointParticle && particles[lanes[k]].isPointParticle)
+                anyPointPairs = true;
+            else
+                anyEllipsoidPairs = true;
+        }
+        dx[k] = delta[0];
+        dy[k] = delta[1];
+        dz[k] = delta[2];
+    }
+    Vec3x4 dr = Vec3x4(fvec4(dx), fvec4(dy), fvec4(dz));
+    fvec4 r = sqrt(dr.dot(dr));
+    auto include = fvec4::expandBitsToMask(laneMask);
+    if (nonbondedMethod != GayBerneForce::NoCutoff)
+        include = blendZero(r < (float) cutoffDistance, include);
+    if (!any(include))
+        return 0;
+    fvec4 rInv = 1.0f/r;
+    Vec3x4 drUnit = dr*rInv;
+
+    // Compute the switching function.
+
+    fvec4 switchValue = 1.0f, switchDeriv = 0.0f;
+    if (useSwitchingFunction) {
+        float invSwitchingInterval = 1/(cutoffDistance-switchingDistance);
+        fvec4 t = blendZero((r-(float) switchingDistance)*invSwitchingInterval, r > (float) switchingDistance);
+        switchValue = 1.0f+t*t*t*(-10.0f+t*(15.0f-t*6.0f));
+        switchDeriv = t*t*(-30.0f+t*(60.0f-t*30.0f))*invSwitchingInterval;
+    }
+
+    // Load the frames of the first particle and apply the combining rules.
+
+    int numParticles = particles.size();
+    fvec4 frame1[NumFrameComponents];
+    for (int i = 0; i < NumFrameComponents; i++)
+        frame1[i] = fvec4(frames[i*numParticles+particle1]);
+    fvec4 sigma = frame1[FrameSigmaOver2]+frame2[FrameSigmaOver2];
+    fvec4 epsilon = frame1[FrameSqrtEpsilon]*frame2[FrameSqrtEpsilon];
+    fvec4 energy = 0.0f;
+    Vec3x4 force(0.0f, 0.0f, 0.0f);
+
+    // Interactions between two point particles can be computed more easily.
+
+    if (anyPointPairs) {
+        fvec4 sig = sigma*rInv;
+        fvec4 sig2 = sig*sig;
+        fvec4 sig6 = sig2*sig2*sig2;
+        energy = 4.0f*epsilon*(sig6-1.0f)*sig6;
+        force = drUnit*(switchValue*4.0f*epsilon*(12.0f*sig6-6.0f)*sig6*rInv - energy*switchDeriv);
+        energy *= switchValue;
+    }
+    if (anyEllipsoidPairs) {
+        // Compute vectors and matrices we'll be needing.
+
+        Mat3x4 B12 = Mat3x4(&frame1[FrameB])+Mat3x4(&frame2[FrameB]);
+        Mat3x4 G12 = Mat3x4(&frame1[FrameG])+Mat3x4(&frame2[FrameG]);
+        Mat3x4 B12inv = B12.inverse();
+        Mat3x4 G12inv = G12.inverse();
+        fvec4 detG12 = G12.determinant();
+
+        // Estimate the distance between the ellipsoids and compute the first terms needed for the energy.
+
+        fvec4 sigma12 = 1.0f/sqrt(0.5f*drUnit.dot(G12inv*drUnit));
+        fvec4 h12 = r - sigma12;
+        fvec4 rho = sigma/(h12+sigma);
+        fvec4 rho2 = rho*rho;
+        fvec4 rho6 = rho2*rho2*rho2;
+        fvec4 u = 4.0f*epsilon*(rho6*rho6-rho6);
+        fvec4 eta = sqrt(2.0f*frame1[FrameShape]*frame2[FrameShape]/detG12);
+        fvec4 chi = 2.0f*drUnit.dot(B12inv*drUnit);
+        chi *= chi;
+        fvec4 ellipsoidEnergy = u*eta*chi;
+
+        // Compute the terms needed for the force.
+
+        Vec3x4 kappa = G12inv*dr;
+        Vec3x4 iota = B12inv*dr;
+        fvec4 rInv2 = rInv*rInv;
+        fvec4 dUSLJdr = 24.0f*epsilon*(2.0f*rho6-1.0f)*rho6*rho/sigma;
+        fvec4 temp = 0.5f*sigma12*sigma12*sigma12*rInv2;
+        Vec3x4 dudr = (drUnit + (kappa-drUnit*kappa.dot(drUnit))*temp)*dUSLJdr;
+        Vec3x4 dchidr = (iota-drUnit*iota.dot(drUnit))*(-8.0f*rInv2*sqrt(chi));
+        Vec3x4 ellipsoidForce = (dchidr*u + dudr*chi)*(eta*switchValue) - drUnit*(ellipsoidEnergy*switchDeriv);
+        ellipsoidEnergy *= switchValue;
+
+        // Select the appropriate result for each lane.
+
+        if (anyPointPairs) {
+            auto isPointPair = (frame1[FramePointParticle]*frame2[FramePointParticle] != 0.0f);
+            energy = blend(ellipsoidEnergy, energy, isPointPair);
+            force = Vec3x4(blend(ellipsoidForce.x, force.x, isPointPair), blend(ellipsoidForce.y, force.y, isPointPair),
+                    blend(ellipsoidForce.z, force.z, isPointPair));
+        }
+        else {
+            energy = ellipsoidEnergy;
+            force = ellipsoidForce;
+        }
+
+        // Compute the terms needed for the torque.
+
+        for (int j = 0; j < 2; j++) {
+            const fvec4* frame = (j == 0 ? frame1 : frame2);
+            if (j == 0 && particles[particle1].isPointParticle)
+                continue;
+            Mat3x4 A(&frame[FrameA]), B(&frame[FrameB]), G(&frame[FrameG]);
+            Vec3x4 dudq = (kappa*G).cross(kappa*(temp*dUSLJdr));
+            Vec3x4 dchidq = (iota*B).cross(iota)*(-4.0f*rInv2);
+            const fvec4 (&g12)[3][3] = G12.v;
+            const fvec4 (&a)[3][3] = A.v;
+            fvec4 scaleFactor = -0.5f*eta/detG12;
+            fvec4 scale[3] = {frame[FrameRadius2]*scaleFactor, frame[FrameRadius2+1]*scaleFactor, frame[FrameRadius2+2]*scaleFactor};
+            Mat3x4 D;
+            fvec4 (&d)[3][3] = D.v;
+            d[0][0] = scale[0]*(2.0f*a[0][0]*(g12[1][1]*g12[2][2] - g12[1][2]*g12[2][1]) +
+                                     a[0][2]*(g12[1][2]*g12[0][1] + g12[1][0]*g12[2][1] - g12[1][1]*(g12[0][2] + g12[2][0])) +
+                                     a[0][1]*(g12[0][2]*g12[2][1] + g12[2][0]*g12[1][2] - g12[2][2]*(g12[0][1] + g12[1][0])));
+            d[0][1] = scale[0]*(     a[0][0]*(g12[0][2]*g12[2][1] + g12[2][0]*g12[1][2] - g12[2][2]*(g12[0][1] + g12[1][0])) +
+                                2.0f*a[0][1]*(g12[0][0]*g12[2][2] - g12[2][0]*g12[0][2]) +
+                                     a[0][2]*(g12[1][0]*g12[0][2] + g12[2][0]*g12[0][1] - g12[0][0]*(g12[1][2] + g12[2][1])));
+            d[0][2] = scale[0]*(     a[0][0]*(g12[0][1]*g12[1][2] + g12[1][0]*g12[2][1] - g12[1][1]*(g12[0][2] + g12[2][0])) +
+                                     a[0][1]*(g12[1][0]*g12[0][2] + g12[2][0]*g12[0][1] - g12[0][0]*(g12[1][2] + g12[2][1])) +
+                                2.0f*a[0][2]*(g12[1][1]*g12[0][0] - g12[1][0]*g12[0][1]));
+            d[1][0] = scale[1]*(2.0f*a[1][0]*(g12[1][1]*g12[2][2] - g12[1][2]*g12[2][1]) +
+                                     a[1][1]*(g12[0][2]*g12[2][1] + g12[2][0]*g12[1][2] - g12[2][2]*(g12[0][1] + g12[1][0])) +
+                                     a[1][2]*(g12[1][2]*g12[0][1] + g12[1][0]*g12[2][1] - g12[1][1]*(g12[0][2] + g12[2][0])));
+            d[1][1] = scale[1]*(     a[1][0]*(g12[0][2]*g12[2][1] + g12[2][0]*g12[1][2] - g12[2][2]*(g12[0][1] + g12[1][0])) +
+                                2.0f*a[1][1]*(g12[2][2]*g12[0][0] - g12[2][0]*g12[0][2]) +
+                                     a[1][2]*(g12[1][0]*g12[0][2] + g12[0][1]*g12[2][0] - g12[0][0]*(g12[1][2] + g12[2][1])));
+            d[1][2] = scale[1]*(     a[1][0]*(g12[0][1]*g12[1][2] + g12[1][0]*g12[2][1] - g12[1][1]*(g12[0][2] + g12[2][0])) +
+                                     a[1][1]*(g12[1][0]*g12[0][2] + g12[0][1]*g12[2][0] - g12[0][0]*(g12[1][2] + g12[2][1])) +
+                                2.0f*a[1][2]*(g12[1][1]*g12[0][0] - g12[1][0]*g12[0][1]));
+            d[2][0] = scale[2]*(2.0f*a[2][0]*(g12[1][1]*g12[2][2] - g12[2][1]*g12[1][2]) +
+                                     a[2][1]*(g12[0][2]*g12[2][1] + g12[1][2]*g12[2][0] - g12[2][2]*(g12[0][1] + g12[1][0])) +
+                                     a[2][2]*(g12[0][1]*g12[1][2] + g12[2][1]*g12[1][0] - g12[1][1]*(g12[0][2] + g12[2][0])));
+            d[2][1] = scale[2]*(     a[2][0]*(g12[0][2]*g12[2][1] + g12[1][2]*g12[2][0] - g12[2][2]*(g12[0][1] + g12[1][0])) +
+                                2.0f*a[2][1]*(g12[0][0]*g12[2][2] - g12[0][2]*g12[2][0]) +
+                                     a[2][2]*(g12[1][0]*g12[0][2] + g12[0][1]*g12[2][0] - g12[0][0]*(g12[1][2] + g12[2][1])));
+            d[2][2] = scale[2]*(     a[2][0]*(g12[0][1]*g12[1][2] + g12[2][1]*g12[1][0] - g12[1][1]*(g12[0][2] + g12[2][0])) +
+                                     a[2][1]*(g12[1][0]*g12[0][2] + g12[2][0]*g12[0][1] - g12[0][0]*(g12[1][2] + g12[2][1])) +
+                                2.0f*a[2][2]*(g12[1][1]*g12[0][0] - g12[1][0]*g12[0][1]));
+            Vec3x4 detadq(0.0f, 0.0f, 0.0f);
+            for (int i = 0; i < 3; i++)
+                detadq = detadq + A.row(i).cross(D.row(i));
+            Vec3x4 torque = (dchidq*(u*eta) + detadq*(u*chi) + dudq*(eta*chi))*switchValue;
+
+            // Only ellipsoids feel torques, and point-point lanes do not contribute.
+
+            auto torqueLanes = blendZero(frame[FramePointParticle] == 0.0f, include);
+            torque = Vec3x4(blendZero(torque.x, torqueLanes), blendZero(torque.y, torqueLanes), blendZero(torque.z, torqueLanes));
+            if (j == 0)
+                torques[particle1] -= Vec3(reduceAdd(torque.x), reduceAdd(torque.y), reduceAdd(torque.z));
+            else
+                for (int k = 0; k < 4; k++)
+                    if (laneMask & (1<<k))
+                        torques[lanes[k]] -= Vec3(torque.x[k], torque.y[k], torque.z[k]);
+        }
+    }
+
+    // Apply the forces.
+
+    energy = blendZero(energy, include);
+    force = Vec3x4(blendZero(force.x, include), blendZero(force.y, include), blendZero(force.z, include));
+    fvec4 f[4];
+    transpose(force.x, force.y, force.z, fvec4(0.0f), f);
+    fvec4 totalForce(0.0f);
+    for (int k = 0; k < 4; k++) {
+        if (laneMask & (1<<k)) {
+            (fvec4(forces+4*lanes[k])-f[k]).store(forces+4*lanes[k]);
+            totalForce += f[k];
+        }
+    }
+    (fvec4(forces+4*particle1)+totalForce).store(forces+4*particle1);
+    return reduceAdd(energy);
+}
@@ -41,12 +41,28 @@ KernelImpl* CpuKernelFactory::createKernelImpl(std::string name, const Platform&
     CpuPlatform::PlatformData& data = CpuPlatform::getPlatformData(context);
     if (name == CalcForcesAndEnergyKernel::Name())
         return new CpuCalcForcesAndEnergyKernel(name, platform, data, context);
+    if (name == CalcHarmonicBondForceKernel::Name())
+        return new CpuCalcHarmonicBondForceKernel(name, platform, data);
+    if (name == CalcCustomBondForceKernel::Name())
+        return new CpuCalcCustomBondForceKernel(name, platform, data);
     if (name == CalcHarmonicAngleForceKernel::Name())
         return new CpuCalcHarmonicAngleForceKernel(name, platform, data);
+    if (name == CalcCustomAngleForceKernel::Name())
+        return new CpuCalcCustomAngleForceKernel(name, platform, data);
     if (name == CalcPeriodicTorsionForceKernel::Name())
         return new CpuCalcPeriodicTorsionForceKernel(name, platform, data);
     if (name == CalcRBTorsionForceKernel::Name())
         return new CpuCalcRBTorsionForceKernel(name, platform, data);
+    if (name == CalcCMAPTorsionForceKernel::Name())
+        return new CpuCalcCMAPTorsionForceKernel(name, platform, data);
+    if (name == CalcCustomTorsionForceKernel::Name())
+        return new CpuCalcCustomTorsionForceKernel(name, platform, data);
+    if (name == CalcCustomCentroidBondForceKernel::Name())
+        return new CpuCalcCustomCentroidBondForceKernel(name, platform, data);
+    if (name == CalcCustomCompoundBondForceKernel::Name())
+        return new CpuCalcCustomCompoundBondForceKernel(name, platform, data);
+    if (name == CalcCustomExternalForceKernel::Name())
+        return new CpuCalcCustomExternalForceKernel(name, platform, data);
     if (name == CalcNonbondedForceKernel::Name())
         return new CpuCalcNonbondedForceKernel(name, platform, data);
     if (name == CalcCustomNonbondedForceKernel::Name())
@@ -63,5 +79,11 @@ KernelImpl* CpuKernelFactory::createKernelImpl(std::string name, const Platform&
         return new CpuIntegrateLangevinStepKernel(name, platform, data);
     if (name == IntegrateLangevinMiddleStepKernel::Name())
         return new CpuIntegrateLangevinMiddleStepKernel(name, platform, data);
+    if (name == IntegrateVerletStepKernel::Name())
+        return new CpuIntegrateVerletStepKernel(name, platform, data);
+    if (name == IntegrateBrownianStepKernel::Name())
+        return new CpuIntegrateBrownianStepKernel(name, platform, data);
+    if (name == IntegrateCustomStepKernel::Name())
+        return new CpuIntegrateCustomStepKernel(name, platform, data);
     throw OpenMMException((std::string("Tried to create kernel with illegal kernel name '") + name + "'").c_str());
 }
@@ -32,23 +32,38 @@
 #include "CpuKernels.h"
 #include "ReferenceAngleBondIxn.h"
 #include "ReferenceBondForce.h"
+#include "ReferenceCMAPTorsionIxn.h"
 #include "ReferenceConstraints.h"
+#include "ReferenceCustomAngleIxn.h"
+#include "ReferenceCustomBondIxn.h"
+#include "ReferenceCustomCentroidBondIxn.h"
+#include "ReferenceCustomCompoundBondIxn.h"
+#include "ReferenceCustomTorsionIxn.h"
+#include "ReferenceHarmonicBondIxn.h"
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
 #include "ReferenceLJCoulomb14.h"
+#include "ReferencePointFunctions.h"
 #include "ReferenceProperDihedralBond.h"
 #include "ReferenceRbDihedralBond.h"
 #include "ReferenceTabulatedFunction.h"
+#include "SimTKOpenMMUtilities.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/Vec3.h"
+#include "openmm/internal/CMAPTorsionForceImpl.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/CustomCentroidBondForceImpl.h"
+#include "openmm/internal/CustomCompoundBondForceImpl.h"
+#include "openmm/internal/ExpressionCache.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include "openmm/internal/hardware.h"
 #include "openmm/internal/vectorize.h"
 #include "lepton/CompiledExpression.h"
 #include "lepton/CustomFunction.h"
 #include "lepton/Operation.h"
 #include "lepton/Parser.h"
+#include <cmath>
 #include <iostream>
 #include "lepton/ParsedExpression.h"
 
@@ -153,7 +168,8 @@ static void copyChargesToPosq(ContextImpl& context, const vector<float>& charges
 }
 
 CpuCalcForcesAndEnergyKernel::CpuCalcForcesAndEnergyKernel(std::string name, const Platform& platform, CpuPlatform::PlatformData& data, ContextImpl& context) :
-        CalcForcesAndEnergyKernel(name, platform), data(data) {
+        CalcForcesAndEnergyKernel(name, platform), data(data), neighborListGroups(-1), stepsSinceRebuild(0), requestedPadding(0.0),
+        totalRebuildSteps(0.0), totalRebuildPadding(0.0), neighborListChecks(0), neighborListBuilds(0), neighborListPatches(0) {
     // Create a Reference platform version of this kernel.
     
     ReferenceKernelFactory referenceFactory;
@@ -163,6 +179,23 @@ CpuCalcForcesAndEnergyKernel::CpuCalcForcesAndEnergyKernel(std::string name, con
 void CpuCalcForcesAndEnergyKernel::initialize(const System& system) {
     referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().initialize(system);
     lastPositions.resize(system.getNumParticles(), Vec3(1e10, 1e10, 1e10));
+
+    // Record which force groups might use the neighbor list.  When only other groups are computed,
+    // as happens for the fast forces with a multiple time step integrator, there is no need to check
+    // whether it must be rebuilt.
+
+    neighborListGroups = 0;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const Force& force = system.getForce(i);
+        bool isBonded = (dynamic_cast<const HarmonicBondForce*>(&force) != NULL || dynamic_cast<const HarmonicAngleForce*>(&force) != NULL ||
+                dynamic_cast<const PeriodicTorsionForce*>(&force) != NULL || dynamic_cast<const RBTorsionForce*>(&force) != NULL ||
+                dynamic_cast<const CMAPTorsionForce*>(&force) != NULL || dynamic_cast<const CustomBondForce*>(&force) != NULL ||
+                dynamic_cast<const CustomAngleForce*>(&force) != NULL || dynamic_cast<const CustomTorsionForce*>(&force) != NULL ||
+                dynamic_cast<const CustomCompoundBondForce*>(&force) != NULL || dynamic_cast<const CustomCentroidBondForce*>(&force) != NULL ||
+                dynamic_cast<const CustomExternalForce*>(&force) != NULL);
+        if (!isBonded)
+            neighborListGroups |= 1<<force.getForceGroup();
+    }
 }
 
 void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups) {
@@ -220,19 +253,23 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
             if (posq[i] != posq[i] || posq[i+1] != posq[i+1] || posq[i+2] != posq[i+2])
                 positionsValid = false;
 
-        // Clear the forces.
+        // The force buffers are normally cleared by finishComputation() as they are summed.  If the
+        // flag is still set, a previous computation was interrupted and we need to clear them here.
 
-        fvec4 zero(0.0f);
-        for (int j = 0; j < numParticles; j++)
-            zero.store(&data.threadForce[threadIndex][j*4]);
+        if (data.threadForceModified) {
+            fvec4 zero(0.0f);
+            for (int j = 0; j < numParticles; j++)
+                zero.store(&data.threadForce[threadIndex][j*4]);
+        }
     });
+    data.threadForceModified = false;
     data.threads.waitForThreads();
     if (!positionsValid)
         throw OpenMMException("Particle coordinate is NaN.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan");
 
     // Determine whether we need to recompute the neighbor list.
         
-    if (data.neighborList != NULL && data.cutoff > 0.0) {
+    if (data.neighborList != NULL && data.cutoff > 0.0 && (groups&neighborListGroups) != 0) {
         double padding = data.paddedCutoff-data.cutoff;;
         bool needRecompute = false;
         double closeCutoff2 = 0.25*padding*padding;
@@ -251,6 +288,24 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
                 }
             }
         }
+        stepsSinceRebuild++;
+        neighborListChecks++;
+        int maxNumPatched = numParticles/50;
+        if (!needRecompute && moved.size() > 0 && (int) moved.size() <= maxNumPatched) {
+            // Only a few particles have moved further than half the padding distance.  Add their new
+            // neighbors to the existing list, and measure their future motion from where they are now.
+            // Every other particle may already be up to half the padding from where the list last saw
+            // it, and the moved particles get another half padding before they are checked again, so
+            // search out to twice the padding to be sure no pair can come within the cutoff unseen.
+
+            float searchDistance = (float) (data.cutoff+2*padding);
+            if (data.neighborList->updateNeighborList(data.posq, moved, extractBoxVectors(context), searchDistance)) {
+                for (int i : moved)
+                    lastPositions[i] = posData[i];
+                moved.clear();
+                neighborListPatches++;
+            }
+        }
         if (!needRecompute && moved.size() > 0) {
             // Some particles have moved further than half the padding distance.  Look for pairs
             // that are missing from the neighbor list.
@@ -273,36 +328,273 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
                 }
         }
         if (needRecompute) {
+            tuneNeighborListPadding();
             data.neighborList->computeNeighborList(numParticles, data.posq, data.exclusions, extractBoxVectors(context), data.isPeriodic, data.paddedCutoff, data.threads);
             lastPositions = posData;
+            neighborListBuilds++;
+        }
+    }
+}
+
+void CpuCalcForcesAndEnergyKernel::tuneNeighborListPadding() {
+    // A larger padding means the neighbor list needs to be rebuilt less often, but it contains more
+    // pairs, which makes every force evaluation slower.  Assume the number of steps between rebuilds
+    // is proportional to the padding, estimate the constant from the intervals we have seen so far,
+    // and select the padding that minimizes the cost per step.  Both the number of pairs and the cost
+    // of a rebuild scale as the cube of the padded cutoff.  This uses only step counts, not timings,
+    // so the choice is reproducible.
+
+    double padding = data.paddedCutoff-data.cutoff;
+    bool firstBuild = (requestedPadding == 0.0);
+    if (firstBuild)
+        requestedPadding = padding;
+    else {
+        totalRebuildSteps += stepsSinceRebuild;
+        totalRebuildPadding += padding;
+    }
+    stepsSinceRebuild = 0;
+    if (firstBuild || requestedPadding <= 0.0)
+        return;
+    const double rebuildCost = 3.0; // The cost of a rebuild relative to one force evaluation
+    double stepsPerPadding = totalRebuildSteps/totalRebuildPadding;
+    double bestPadding = padding, bestCost = 0.0;
+    for (int i = 0; i <= 16; i++) {
+        double p = requestedPadding*pow(2.0, (i-8)/8.0);
+        double r = data.cutoff+p;
+        double cost = r*r*r*(1.0+rebuildCost/(stepsPerPadding*p));
+        if (i == 0 || cost < bestCost) {
+            bestPadding = p;
+            bestCost = cost;
         }
     }
+    data.paddedCutoff = data.cutoff+bestPadding;
 }
 
 double CpuCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid) {
-    // Sum the forces from all the threads.
+    // Sum the forces from all the threads.  This is skipped entirely if no kernel used the thread
+    // buffers, as happens when only bonded forces are evaluated.  Each element is cleared as soon
+    // as it has been read, so the buffers are ready for the next step without a separate pass
+    // over them in beginComputation().
     
-    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
-        // Sum the contributions to forces that have been calculated by different threads.
-        
-        int numParticles = context.getSystem().getNumParticles();
-        int numThreads = threads.getNumThreads();
-        int start = threadIndex*numParticles/numThreads;
-        int end = (threadIndex+1)*numParticles/numThreads;
-        vector<Vec3>& forceData = extractForces(context);
-        for (int i = start; i < end; i++) {
-            fvec4 f(0.0f);
-            for (int j = 0; j < numThreads; j++)
-                f += fvec4(&data.threadForce[j][4*i]);
-            forceData[i][0] += f[0];
-            forceData[i][1] += f[1];
-            forceData[i][2] += f[2];
-        }
-    });
-    data.threads.waitForThreads();
+    if (data.threadForceModified) {
+        data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int numParticles = context.getSystem().getNumParticles();
+            int numThreads = threads.getNumThreads();
+            int start = threadIndex*numParticles/numThreads;
+            int end = (threadIndex+1)*numParticles/numThreads;
+            vector<Vec3>& forceData = extractForces(context);
+            fvec4 zero(0.0f);
+            for (int i = start; i < end; i++) {
+                fvec4 f(0.0f);
+                for (int j = 0; j < numThreads; j++) {
+                    f += fvec4(&data.threadForce[j][4*i]);
+                    zero.store(&data.threadForce[j][4*i]);
+                }
+                forceData[i][0] += f[0];
+                forceData[i][1] += f[1];
+                forceData[i][2] += f[2];
+            }
+        });
+        data.threads.waitForThreads();
+        data.threadForceModified = false;
+    }
+    if (includeForce && data.virtualSites != NULL) {
+        data.virtualSites->distributeSiteForces(extractPositions(context), extractForces(context));
+        return 0.0;
+    }
     return referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().finishComputation(context, includeForce, includeEnergy, groups, valid);
 }
 
+void CpuCalcForcesAndEnergyKernel::synchronize(ContextImpl& context) {
+    // All calculations are done synchronously, so there is nothing to wait for.
+}
+
+void CpuCalcForcesAndEnergyKernel::getNeighborListStatistics(ContextImpl& context, map<string, double>& statistics) {
+    if (data.neighborList == NULL || data.cutoff == 0.0)
+        return;
+    statistics["Neighbor List Checks"] = neighborListChecks;
+    statistics["Neighbor List Builds"] = neighborListBuilds;
+    statistics["Neighbor List Patches"] = neighborListPatches;
+    if (neighborListBuilds == 0)
+        return;
+
+    // Count the pairs in the neighbor list, and how many of them are within the cutoff based on the
+    // positions from the most recent force computation.  Excluded pairs are not counted.
+
+    const CpuNeighborList& neighborList = *data.neighborList;
+    int numParticles = context.getSystem().getNumParticles();
+    int blockSize = neighborList.getBlockSize();
+    Vec3* boxVectors = extractBoxVectors(context);
+    double cutoff2 = data.cutoff*data.cutoff;
+    long long numPairs = 0, numPairsInCutoff = 0;
+    int numInteractingBlocks = 0;
+    for (int block = 0; block < neighborList.getNumBlocks(); block++) {
+        const int32_t* blockAtom = &neighborList.getSortedAtoms()[blockSize*block];
+        int atomsInBlock = min(blockSize, numParticles-blockSize*block);
+        CpuNeighborList::NeighborIterator neighbors = neighborList.getNeighborIterator(block);
+        if (!neighborList.getBlockNeighbors(block).empty())
+            numInteractingBlocks++;
+        while (neighbors.next()) {
+            int neighbor = neighbors.getNeighbor();
+            CpuNeighborList::BlockExclusionMask exclusions = neighbors.getExclusions();
+            Vec3 pos1(data.posq[4*neighbor], data.posq[4*neighbor+1], data.posq[4*neighbor+2]);
+            for (int k = 0; k < atomsInBlock; k++) {
+                if ((exclusions & (1<<k)) != 0)
+                    continue;
+                numPairs++;
+                int atom = blockAtom[k];
+                Vec3 delta = Vec3(data.posq[4*atom], data.posq[4*atom+1], data.posq[4*atom+2])-pos1;
+                if (data.isPeriodic) {
+                    delta -= boxVectors[2]*round(delta[2]/boxVectors[2][2]);
+                    delta -= boxVectors[1]*round(delta[1]/boxVectors[1][1]);
+                    delta -= boxVectors[0]*round(delta[0]/boxVectors[0][0]);
+                }
+                if (delta.dot(delta) < cutoff2)
+                    numPairsInCutoff++;
+            }
+        }
+    }
+    statistics["Interacting Blocks"] = numInteractingBlocks;
+    statistics["Neighbor List Pairs"] = numPairs;
+    statistics["Pairs Within Cutoff"] = numPairsInCutoff;
+}
+
+void CpuCalcHarmonicBondForceKernel::initialize(const System& system, const HarmonicBondForce& force) {
+    numBonds = force.getNumBonds();
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(2));
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        double length, k;
+        force.getBondParameters(i, particle1, particle2, length, k);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        bondParamArray[i][0] = length;
+        bondParamArray[i][1] = k;
+    }
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+}
+
+double CpuCalcHarmonicBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    ReferenceHarmonicBondIxn harmonicBond;
+    if (usePeriodic)
+        harmonicBond.setPeriodic(extractBoxVectors(context));
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, harmonicBond);
+    return energy;
+}
+
+void CpuCalcHarmonicBondForceKernel::copyParametersToContext(ContextImpl& context, const HarmonicBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        double length, k;
+        force.getBondParameters(i, particle1, particle2, length, k);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        bondParamArray[i][0] = length;
+        bondParamArray[i][1] = k;
+    }
+}
+
+CpuCalcCustomBondForceKernel::~CpuCalcCustomBondForceKernel() {
+    for (ReferenceBondIxn* ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomBondForceKernel::initialize(const System& system, const CustomBondForce& force) {
+    numBonds = force.getNumBonds();
+    int numParameters = force.getNumPerBondParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = ExpressionCache::getExpression(force.getEnergyFunction());
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = ExpressionCache::getDerivative(force.getEnergyFunction(), "r").createCompiledExpression();
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerBondParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(ExpressionCache::getDerivative(force.getEnergyFunction(), param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("r");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Compiled expressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomBondIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (ReferenceBondIxn* ixn : threadIxn) {
+        ReferenceCustomBondIxn* customIxn = static_cast<ReferenceCustomBondIxn*>(ixn);
+        customIxn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            customIxn->setPeriodic(extractBoxVectors(context));
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, threadIxn, energyParamDerivNames.size(), &energyParamDerivValues[0]);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcHarmonicAngleForceKernel::initialize(const System& system, const HarmonicAngleForce& force) {
     numAngles = force.getNumAngles();
     angleIndexArray.resize(numAngles, vector<int>(3));
@@ -349,6 +641,98 @@ void CpuCalcHarmonicAngleForceKernel::copyParametersToContext(ContextImpl& conte
     }
 }
 
+CpuCalcCustomAngleForceKernel::~CpuCalcCustomAngleForceKernel() {
+    for (ReferenceBondIxn* ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomAngleForceKernel::initialize(const System& system, const CustomAngleForce& force) {
+    numAngles = force.getNumAngles();
+    int numParameters = force.getNumPerAngleParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    angleIndexArray.resize(numAngles, vector<int>(3));
+    angleParamArray.resize(numAngles, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        angleIndexArray[i][0] = particle1;
+        angleIndexArray[i][1] = particle2;
+        angleIndexArray[i][2] = particle3;
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numAngles, 3, angleIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = ExpressionCache::getExpression(force.getEnergyFunction());
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = ExpressionCache::getDerivative(force.getEnergyFunction(), "theta").createCompiledExpression();
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerAngleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(ExpressionCache::getDerivative(force.getEnergyFunction(), param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Compiled expressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomAngleIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomAngleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (ReferenceBondIxn* ixn : threadIxn) {
+        ReferenceCustomAngleIxn* customIxn = static_cast<ReferenceCustomAngleIxn*>(ixn);
+        customIxn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            customIxn->setPeriodic(extractBoxVectors(context));
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    bondForce.calculateForce(posData, angleParamArray, forceData, includeEnergy ? &energy : NULL, threadIxn, energyParamDerivNames.size(), &energyParamDerivValues[0]);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomAngleForceKernel::copyParametersToContext(ContextImpl& context, const CustomAngleForce& force) {
+    if (numAngles != force.getNumAngles())
+        throw OpenMMException("updateParametersInContext: The number of angles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerAngleParameters();
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        if (particle1 != angleIndexArray[i][0] || particle2 != angleIndexArray[i][1] || particle3 != angleIndexArray[i][2])
+            throw OpenMMException("updateParametersInContext: The set of particles in an angle has changed");
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcPeriodicTorsionForceKernel::initialize(const System& system, const PeriodicTorsionForce& force) {
     numTorsions = force.getNumTorsions();
     torsionIndexArray.resize(numTorsions, vector<int>(4));
@@ -398,58 +782,572 @@ void CpuCalcPeriodicTorsionForceKernel::copyParametersToContext(ContextImpl& con
     }
 }
 
-void CpuCalcRBTorsionForceKernel::initialize(const System& system, const RBTorsionForce& force) {
-    numTorsions = force.getNumTorsions();
-    torsionIndexArray.resize(numTorsions, vector<int>(4));
-    torsionParamArray.resize(numTorsions, vector<double>(6));
-    for (int i = 0; i < numTorsions; ++i) {
-        int particle1, particle2, particle3, particle4;
-        double c0, c1, c2, c3, c4, c5;
-        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
-        torsionIndexArray[i][0] = particle1;
-        torsionIndexArray[i][1] = particle2;
-        torsionIndexArray[i][2] = particle3;
-        torsionIndexArray[i][3] = particle4;
-        torsionParamArray[i][0] = c0;
-        torsionParamArray[i][1] = c1;
-        torsionParamArray[i][2] = c2;
-        torsionParamArray[i][3] = c3;
-        torsionParamArray[i][4] = c4;
-        torsionParamArray[i][5] = c5;
-    }
-    bondForce.initialize(system.getNumParticles(), numTorsions, 4, torsionIndexArray, data.threads);
-    usePeriodic = force.usesPeriodicBoundaryConditions();
+void CpuCalcRBTorsionForceKernel::initialize(const System& system, const RBTorsionForce& force) {
+    numTorsions = force.getNumTorsions();
+    torsionIndexArray.resize(numTorsions, vector<int>(4));
+    torsionParamArray.resize(numTorsions, vector<double>(6));
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        double c0, c1, c2, c3, c4, c5;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
+        torsionIndexArray[i][0] = particle1;
+        torsionIndexArray[i][1] = particle2;
+        torsionIndexArray[i][2] = particle3;
+        torsionIndexArray[i][3] = particle4;
+        torsionParamArray[i][0] = c0;
+        torsionParamArray[i][1] = c1;
+        torsionParamArray[i][2] = c2;
+        torsionParamArray[i][3] = c3;
+        torsionParamArray[i][4] = c4;
+        torsionParamArray[i][5] = c5;
+    }
+    bondForce.initialize(system.getNumParticles(), numTorsions, 4, torsionIndexArray, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+}
+
+double CpuCalcRBTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    ReferenceRbDihedralBond rbTorsionBond;
+    if (usePeriodic)
+        rbTorsionBond.setPeriodic(extractBoxVectors(context));
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, rbTorsionBond);
+    return energy;
+}
+
+void CpuCalcRBTorsionForceKernel::copyParametersToContext(ContextImpl& context, const RBTorsionForce& force) {
+    if (numTorsions != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
+
+    // Record the values.
+
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        double c0, c1, c2, c3, c4, c5;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
+        if (particle1 != torsionIndexArray[i][0] || particle2 != torsionIndexArray[i][1] || particle3 != torsionIndexArray[i][2] || particle4 != torsionIndexArray[i][3])
+            throw OpenMMException("updateParametersInContext: The set of particles in a torsion has changed");
+        torsionParamArray[i][0] = c0;
+        torsionParamArray[i][1] = c1;
+        torsionParamArray[i][2] = c2;
+        torsionParamArray[i][3] = c3;
+        torsionParamArray[i][4] = c4;
+        torsionParamArray[i][5] = c5;
+    }
+}
+
+/**
+ * This adapts ReferenceCMAPTorsionIxn to the interface expected by CpuBondForce.  The only parameter
+ * of each torsion is its index.
+ */
+class CpuCalcCMAPTorsionForceKernel::TorsionIxn : public ReferenceBondIxn {
+public:
+    TorsionIxn(const vector<vector<vector<double> > >& coeff, const vector<int>& torsionMaps, const vector<vector<int> >& torsionIndices) :
+            ixn(coeff, torsionMaps, torsionIndices) {
+    }
+    void setPeriodic(Vec3* vectors) {
+        ixn.setPeriodic(vectors);
+    }
+    void calculateBondIxn(vector<int>& atomIndices, vector<Vec3>& atomCoordinates, vector<double>& parameters, vector<Vec3>& forces,
+            double* totalEnergy, double* energyParamDerivs) {
+        ixn.calculateOneIxn((int) parameters[0], atomCoordinates, forces, totalEnergy);
+    }
+private:
+    ReferenceCMAPTorsionIxn ixn;
+};
+
+CpuCalcCMAPTorsionForceKernel::~CpuCalcCMAPTorsionForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcCMAPTorsionForceKernel::initialize(const System& system, const CMAPTorsionForce& force) {
+    int numMaps = force.getNumMaps();
+    int numTorsions = force.getNumTorsions();
+    coeff.resize(numMaps);
+    vector<double> energy;
+    vector<vector<double> > c;
+    for (int i = 0; i < numMaps; i++) {
+        int size;
+        force.getMapParameters(i, size, energy);
+        CMAPTorsionForceImpl::calcMapDerivatives(size, energy, c);
+        coeff[i].resize(size*size);
+        for (int j = 0; j < size*size; j++) {
+            coeff[i][j].resize(16);
+            for (int k = 0; k < 16; k++)
+                coeff[i][j][k] = c[j][k];
+        }
+    }
+    torsionMaps.resize(numTorsions);
+    torsionIndices.resize(numTorsions);
+    torsionParamArray.resize(numTorsions);
+    for (int i = 0; i < numTorsions; i++) {
+        torsionIndices[i].resize(8);
+        force.getTorsionParameters(i, torsionMaps[i], torsionIndices[i][0], torsionIndices[i][1], torsionIndices[i][2],
+            torsionIndices[i][3], torsionIndices[i][4], torsionIndices[i][5], torsionIndices[i][6], torsionIndices[i][7]);
+        torsionParamArray[i].push_back(i);
+    }
+    bondForce.initialize(system.getNumParticles(), numTorsions, 8, torsionIndices, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+    ixn = new TorsionIxn(coeff, torsionMaps, torsionIndices);
+}
+
+double CpuCalcCMAPTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    if (usePeriodic)
+        ixn->setPeriodic(extractBoxVectors(context));
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, *ixn);
+    return energy;
+}
+
+void CpuCalcCMAPTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CMAPTorsionForce& force) {
+    int numMaps = force.getNumMaps();
+    int numTorsions = force.getNumTorsions();
+    if (coeff.size() != numMaps)
+        throw OpenMMException("updateParametersInContext: The number of maps has changed");
+    if (torsionMaps.size() != numTorsions)
+        throw OpenMMException("updateParametersInContext: The number of CMAP torsions has changed");
+
+    // Update the maps.
+
+    vector<double> energy;
+    vector<vector<double> > c;
+    for (int i = 0; i < numMaps; i++) {
+        int size;
+        force.getMapParameters(i, size, energy);
+        if (coeff[i].size() != size*size)
+            throw OpenMMException("updateParametersInContext: The size of a map has changed");
+        CMAPTorsionForceImpl::calcMapDerivatives(size, energy, c);
+        for (int j = 0; j < size*size; j++)
+            for (int k = 0; k < 16; k++)
+                coeff[i][j][k] = c[j][k];
+    }
+
+    // Update the indices.
+
+    for (int i = 0; i < numTorsions; i++) {
+        int index[8];
+        force.getTorsionParameters(i, torsionMaps[i], index[0], index[1], index[2], index[3], index[4], index[5], index[6], index[7]);
+        for (int j = 0; j < 8; j++)
+            if (index[j] != torsionIndices[i][j])
+                throw OpenMMException("updateParametersInContext: The set of particles in a CMAP torsion has changed");
+    }
+    delete ixn;
+    ixn = new TorsionIxn(coeff, torsionMaps, torsionIndices);
+}
+
+CpuCalcCustomTorsionForceKernel::~CpuCalcCustomTorsionForceKernel() {
+    for (ReferenceBondIxn* ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomTorsionForceKernel::initialize(const System& system, const CustomTorsionForce& force) {
+    numTorsions = force.getNumTorsions();
+    int numParameters = force.getNumPerTorsionParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    torsionIndexArray.resize(numTorsions, vector<int>(4));
+    torsionParamArray.resize(numTorsions, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        torsionIndexArray[i][0] = particle1;
+        torsionIndexArray[i][1] = particle2;
+        torsionIndexArray[i][2] = particle3;
+        torsionIndexArray[i][3] = particle4;
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numTorsions, 4, torsionIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = ExpressionCache::getExpression(force.getEnergyFunction());
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = ExpressionCache::getDerivative(force.getEnergyFunction(), "theta").createCompiledExpression();
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerTorsionParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(ExpressionCache::getDerivative(force.getEnergyFunction(), param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Compiled expressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomTorsionIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    for (ReferenceBondIxn* ixn : threadIxn) {
+        ReferenceCustomTorsionIxn* customIxn = static_cast<ReferenceCustomTorsionIxn*>(ixn);
+        customIxn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            customIxn->setPeriodic(extractBoxVectors(context));
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, threadIxn, energyParamDerivNames.size(), &energyParamDerivValues[0]);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CustomTorsionForce& force) {
+    if (numTorsions != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerTorsionParameters();
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        if (particle1 != torsionIndexArray[i][0] || particle2 != torsionIndexArray[i][1] || particle3 != torsionIndexArray[i][2] || particle4 != torsionIndexArray[i][3])
+            throw OpenMMException("updateParametersInContext: The set of particles in a torsion has changed");
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
+    }
+}
+
+CpuCalcCustomCentroidBondForceKernel::~CpuCalcCustomCentroidBondForceKernel() {
+    deleteInteraction();
+}
+
+void CpuCalcCustomCentroidBondForceKernel::initialize(const System& system, const CustomCentroidBondForce& force) {
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    int numGroups = force.getNumGroups();
+    groupAtoms.resize(numGroups);
+    vector<double> ignored;
+    for (int i = 0; i < numGroups; i++)
+        force.getGroupParameters(i, groupAtoms[i], ignored);
+    CustomCentroidBondForceImpl::computeNormalizedWeights(force, system, normalizedWeights);
+    numBonds = force.getNumBonds();
+    bondGroups.resize(numBonds);
+    bondParamArray.resize(numBonds);
+    for (int i = 0; i < numBonds; ++i)
+        force.getBondParameters(i, bondGroups[i], bondParamArray[i]);
+    bondForce.initialize(numGroups, numBonds, force.getNumGroupsPerBond(), bondGroups, data.threads);
+    groupCenters.resize(numGroups);
+    groupForces.resize(numGroups);
+
+    // Record which groups each atom belongs to, so forces can be applied to atoms in parallel.
+
+    map<int, int> atomIndex;
+    for (int group = 0; group < numGroups; group++)
+        for (int i = 0; i < groupAtoms[group].size(); i++) {
+            int atom = groupAtoms[group][i];
+            if (atomIndex.find(atom) == atomIndex.end()) {
+                atomIndex[atom] = forceAtoms.size();
+                forceAtoms.push_back(atom);
+                forceAtomGroups.push_back(vector<pair<int, double> >());
+            }
+            forceAtomGroups[atomIndex[atom]].push_back(make_pair(group, normalizedWeights[group][i]));
+        }
+
+    // Record the tabulated function update counts for future reference.
+
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        tabulatedFunctionUpdateCount[force.getTabulatedFunctionName(i)] = force.getTabulatedFunction(i).getUpdateCount();
+
+    // Create the interaction.
+
+    createInteraction(force);
+}
+
+void CpuCalcCustomCentroidBondForceKernel::createInteraction(const CustomCentroidBondForce& force) {
+    // Create custom functions for the tabulated functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i), data.threads);
+
+    // Create implementations of point functions.
+
+    functions["pointdistance"] = new ReferencePointDistanceFunction(usePeriodic, &boxVectors);
+    functions["pointangle"] = new ReferencePointAngleFunction(usePeriodic, &boxVectors);
+    functions["pointdihedral"] = new ReferencePointDihedralFunction(usePeriodic, &boxVectors);
+
+    // Parse the expression.
+
+    Lepton::ParsedExpression energyExpression = CustomCentroidBondForceImpl::prepareExpression(force, functions);
+    vector<string> bondParameterNames;
+    for (int i = 0; i < force.getNumPerBondParameters(); i++)
+        bondParameterNames.push_back(force.getPerBondParameterName(i));
+    globalParameterNames.clear();
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    energyParamDerivNames.clear();
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(energyExpression.differentiate(param).createCompiledExpression());
+    }
+
+    // Compiled expressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomCentroidBondIxn(force.getNumGroupsPerBond(), groupAtoms, normalizedWeights, bondGroups,
+                energyExpression, bondParameterNames, energyParamDerivExpressions));
+
+    // Delete the custom functions.
+
+    for (auto& function : functions)
+        delete function.second;
+}
+
+void CpuCalcCustomCentroidBondForceKernel::deleteInteraction() {
+    for (ReferenceBondIxn* ixn : threadIxn)
+        delete ixn;
+    threadIxn.clear();
+}
+
+double CpuCalcCustomCentroidBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    if (usePeriodic)
+        boxVectors = extractBoxVectors(context);
+    for (ReferenceBondIxn* ixn : threadIxn) {
+        ReferenceCustomCentroidBondIxn* centroidIxn = static_cast<ReferenceCustomCentroidBondIxn*>(ixn);
+        centroidIxn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            centroidIxn->setPeriodic(boxVectors);
+    }
+
+    // Compute the center of each group.
+
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int numGroups = groupAtoms.size();
+        int numThreads = threads.getNumThreads();
+        int start = threadIndex*numGroups/numThreads;
+        int end = (threadIndex+1)*numGroups/numThreads;
+        for (int group = start; group < end; group++) {
+            Vec3 center;
+            for (int i = 0; i < groupAtoms[group].size(); i++)
+                center += posData[groupAtoms[group][i]]*normalizedWeights[group][i];
+            groupCenters[group] = center;
+            groupForces[group] = Vec3();
+        }
+    });
+    data.threads.waitForThreads();
+
+    // Compute the forces on groups.
+
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    bondForce.calculateForce(groupCenters, bondParamArray, groupForces, includeEnergy ? &energy : NULL, threadIxn, energyParamDerivNames.size(), &energyParamDerivValues[0]);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+
+    // Apply the forces to the individual atoms.
+
+    if (includeForces) {
+        data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int numAtoms = forceAtoms.size();
+            int numThreads = threads.getNumThreads();
+            int start = threadIndex*numAtoms/numThreads;
+            int end = (threadIndex+1)*numAtoms/numThreads;
+            for (int i = start; i < end; i++)
+                for (auto& groupWeight : forceAtomGroups[i])
+                    forceData[forceAtoms[i]] += groupForces[groupWeight.first]*groupWeight.second;
+        });
+        data.threads.waitForThreads();
+    }
+    return energy;
+}
+
+void CpuCalcCustomCentroidBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomCentroidBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<int> groups;
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        force.getBondParameters(i, groups, params);
+        for (int j = 0; j < groups.size(); j++)
+            if (groups[j] != bondGroups[i][j])
+                throw OpenMMException("updateParametersInContext: The set of groups in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+
+    // See if any tabulated functions have changed.
+
+    bool changed = false;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
+        string name = force.getTabulatedFunctionName(i);
+        if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
+            tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
+            changed = true;
+        }
+    }
+    if (changed) {
+        deleteInteraction();
+        createInteraction(force);
+    }
+}
+
+CpuCalcCustomCompoundBondForceKernel::~CpuCalcCustomCompoundBondForceKernel() {
+    deleteInteraction();
+}
+
+void CpuCalcCustomCompoundBondForceKernel::initialize(const System& system, const CustomCompoundBondForce& force) {
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    numBonds = force.getNumBonds();
+    bondParticles.resize(numBonds);
+    bondParamArray.resize(numBonds);
+    for (int i = 0; i < numBonds; ++i)
+        force.getBondParameters(i, bondParticles[i], bondParamArray[i]);
+    bondForce.initialize(system.getNumParticles(), numBonds, force.getNumParticlesPerBond(), bondParticles, data.threads);
+
+    // Record the tabulated function update counts for future reference.
+
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        tabulatedFunctionUpdateCount[force.getTabulatedFunctionName(i)] = force.getTabulatedFunction(i).getUpdateCount();
+
+    // Create the interaction.
+
+    createInteraction(force);
+}
+
+void CpuCalcCustomCompoundBondForceKernel::createInteraction(const CustomCompoundBondForce& force) {
+    // Create custom functions for the tabulated functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i), data.threads);
+
+    // Create implementations of point functions.
+
+    functions["pointdistance"] = new ReferencePointDistanceFunction(usePeriodic, &boxVectors);
+    functions["pointangle"] = new ReferencePointAngleFunction(usePeriodic, &boxVectors);
+    functions["pointdihedral"] = new ReferencePointDihedralFunction(usePeriodic, &boxVectors);
+
+    // Parse the expression.
+
+    Lepton::ParsedExpression energyExpression = CustomCompoundBondForceImpl::prepareExpression(force, functions);
+    vector<string> bondParameterNames;
+    for (int i = 0; i < force.getNumPerBondParameters(); i++)
+        bondParameterNames.push_back(force.getPerBondParameterName(i));
+    globalParameterNames.clear();
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    energyParamDerivNames.clear();
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(energyExpression.differentiate(param).createCompiledExpression());
+    }
+
+    // Compiled expressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomCompoundBondIxn(force.getNumParticlesPerBond(), bondParticles, energyExpression,
+                bondParameterNames, energyParamDerivExpressions));
+
+    // Delete the custom functions.
+
+    for (auto& function : functions)
+        delete function.second;
+}
+
+void CpuCalcCustomCompoundBondForceKernel::deleteInteraction() {
+    for (ReferenceBondIxn* ixn : threadIxn)
+        delete ixn;
+    threadIxn.clear();
 }
 
-double CpuCalcRBTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+double CpuCalcCustomCompoundBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
     double energy = 0;
-    ReferenceRbDihedralBond rbTorsionBond;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
     if (usePeriodic)
-        rbTorsionBond.setPeriodic(extractBoxVectors(context));
-    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, rbTorsionBond);
+        boxVectors = extractBoxVectors(context);
+    for (ReferenceBondIxn* ixn : threadIxn) {
+        ReferenceCustomCompoundBondIxn* compoundIxn = static_cast<ReferenceCustomCompoundBondIxn*>(ixn);
+        compoundIxn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            compoundIxn->setPeriodic(boxVectors);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, threadIxn, energyParamDerivNames.size(), &energyParamDerivValues[0]);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
     return energy;
 }
 
-void CpuCalcRBTorsionForceKernel::copyParametersToContext(ContextImpl& context, const RBTorsionForce& force) {
-    if (numTorsions != force.getNumTorsions())
-        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
+void CpuCalcCustomCompoundBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomCompoundBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
 
     // Record the values.
 
-    for (int i = 0; i < numTorsions; ++i) {
-        int particle1, particle2, particle3, particle4;
-        double c0, c1, c2, c3, c4, c5;
-        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
-        if (particle1 != torsionIndexArray[i][0] || particle2 != torsionIndexArray[i][1] || particle3 != torsionIndexArray[i][2] || particle4 != torsionIndexArray[i][3])
-            throw OpenMMException("updateParametersInContext: The set of particles in a torsion has changed");
-        torsionParamArray[i][0] = c0;
-        torsionParamArray[i][1] = c1;
-        torsionParamArray[i][2] = c2;
-        torsionParamArray[i][3] = c3;
-        torsionParamArray[i][4] = c4;
-        torsionParamArray[i][5] = c5;
+    int numParameters = force.getNumPerBondParameters();
+    vector<int> particles;
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        force.getBondParameters(i, particles, params);
+        for (int j = 0; j < particles.size(); j++)
+            if (particles[j] != bondParticles[i][j])
+                throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+
+    // See if any tabulated functions have changed.
+
+    bool changed = false;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
+        string name = force.getTabulatedFunctionName(i);
+        if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
+            tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
+            changed = true;
+        }
+    }
+    if (changed) {
+        deleteInteraction();
+        createInteraction(force);
     }
 }
 
@@ -475,6 +1373,73 @@ private:
 
 CpuNonbondedForce* createCpuNonbondedForceVec(const CpuNeighborList& neighbors);
 
+CpuCalcCustomExternalForceKernel::~CpuCalcCustomExternalForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcCustomExternalForceKernel::initialize(const System& system, const CustomExternalForce& force) {
+    numParticles = force.getNumParticles();
+    int numParameters = force.getNumPerParticleParameters();
+
+    // Build the arrays.
+
+    particles.resize(numParticles);
+    particleParamArray.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        force.getParticleParameters(i, particles[i], particleParamArray[i]);
+
+    // Parse the expression used to calculate the force.  The periodic distance function reads
+    // the box vectors through a pointer, so it sees the current box when the expression is evaluated.
+
+    map<string, Lepton::CustomFunction*> functions;
+    ReferencePointDistanceFunction periodicDistance(true, &boxVectors);
+    functions["periodicdistance"] = &periodicDistance;
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction(), functions).optimize();
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerParticleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    set<string> variables;
+    variables.insert("x");
+    variables.insert("y");
+    variables.insert("z");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+    ixn = new CpuCustomExternalForce(expression, parameterNames, data.threads);
+}
+
+double CpuCalcCustomExternalForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    boxVectors = extractBoxVectors(context);
+    double energy = 0;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    if (includeForces)
+        data.threadForceModified = true;
+    ixn->calculateForce(particles, posData, particleParamArray, globalParameters, data.threadForce, includeForces, includeEnergy, energy);
+    return energy;
+}
+
+void CpuCalcCustomExternalForceKernel::copyParametersToContext(ContextImpl& context, const CustomExternalForce& force) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerParticleParameters();
+    for (int i = 0; i < numParticles; ++i) {
+        int particle;
+        vector<double> parameters;
+        force.getParticleParameters(i, particle, parameters);
+        if (particle != particles[i])
+            throw OpenMMException("updateParametersInContext: A particle index has changed");
+        for (int j = 0; j < numParameters; j++)
+            particleParamArray[i][j] = parameters[j];
+    }
+}
+
 CpuCalcNonbondedForceKernel::CpuCalcNonbondedForceKernel(string name, const Platform& platform, CpuPlatform::PlatformData& data) : CalcNonbondedForceKernel(name, platform),
         data(data), hasInitializedPme(false), hasInitializedDispersionPme(false), nonbonded(NULL) {
 }
@@ -499,20 +1464,20 @@ void CpuCalcNonbondedForceKernel::initialize(const System& system, const Nonbond
         exceptionsWithOffsets.insert(exception);
     }
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs;
     vector<int> nb14s;
     map<int, int> nb14Index;
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
+        excludedPairs.push_back(make_pair(particle1, particle2));
         if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end()) {
             nb14Index[i] = nb14s.size();
             nb14s.push_back(i);
         }
     }
+    exclusions = CpuExclusionList(numParticles, excludedPairs);
 
     // Record the particle parameters.
 
@@ -588,6 +1553,8 @@ void CpuCalcNonbondedForceKernel::initialize(const System& system, const Nonbond
         useSwitchingFunction = force.getUseSwitchingFunction();
         switchingDistance = force.getSwitchingDistance();
     }
+    if ((nonbondedMethod == PME || nonbondedMethod == LJPME) && force.getPMEOrder() != 5)
+        throw OpenMMException("NonbondedForce: The CPU platform only supports a PME order of 5");
     if (nonbondedMethod == Ewald) {
         double alpha;
         NonbondedForceImpl::calcEwaldParameters(system, force, alpha, kmax[0], kmax[1], kmax[2]);
@@ -617,6 +1584,7 @@ void CpuCalcNonbondedForceKernel::initialize(const System& system, const Nonbond
         dispersionCoefficient = 0.0;
     data.isPeriodic |= (nonbondedMethod == CutoffPeriodic || nonbondedMethod == Ewald || nonbondedMethod == PME || nonbondedMethod == LJPME);
     nonbonded = createCpuNonbondedForceVec(*data.neighborList);
+    nonbonded->setDeterministic(data.deterministicForces);
 }
 
 double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy, bool includeDirect, bool includeReciprocal) {
@@ -682,13 +1650,21 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
         nonbonded->setUseLJPME(ewaldDispersionAlpha, dispersionGridSize);
     }
     double nonbondedEnergy = 0;
+    data.threadForceModified = true;
+
+    // The optimized PME kernel runs on its own threads, so start it first and let reciprocal space
+    // overlap with direct space.  It only reads posq, and its forces are not added to the buffers
+    // until finishComputation().
+
+    bool usePmeKernel = (includeReciprocal && useOptimizedPme);
+    PmeIO io(&posq[0], &data.threadForce[0][0], numParticles);
+    Vec3 periodicBoxVectors[3] = {boxVectors[0], boxVectors[1], boxVectors[2]};
+    if (usePmeKernel)
+        optimizedPme.getAs<CalcPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
     if (includeDirect)
-        nonbonded->calculateDirectIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, data.threadForce, includeEnergy ? &nonbondedEnergy : NULL, data.threads);
+        nonbonded->calculateDirectIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, data.threadForce, includeEnergy ? &nonbondedEnergy : NULL, data.threads, includeForces);
     if (includeReciprocal) {
         if (useOptimizedPme) {
-            PmeIO io(&posq[0], &data.threadForce[0][0], numParticles);
-            Vec3 periodicBoxVectors[3] = {boxVectors[0], boxVectors[1], boxVectors[2]};
-            optimizedPme.getAs<CalcPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
             nonbondedEnergy += optimizedPme.getAs<CalcPmeReciprocalForceKernel>().finishComputation(io);
             if (nonbondedMethod == LJPME) {
                 copyChargesToPosq(context, C6params, ljPosqIndex);
@@ -697,7 +1673,7 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
             }
         }
         else
-            nonbonded->calculateReciprocalIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, forceData, includeEnergy ? &nonbondedEnergy : NULL);
+            nonbonded->calculateReciprocalIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, forceData, includeEnergy ? &nonbondedEnergy : NULL, data.threads);
     }
     energy += nonbondedEnergy;
     if (includeDirect) {
@@ -862,13 +1838,13 @@ void CpuCalcCustomNonbondedForceKernel::initialize(const System& system, const C
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs;
     for (int i = 0; i < force.getNumExclusions(); i++) {
         int particle1, particle2;
         force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
+        excludedPairs.push_back(make_pair(particle1, particle2));
     }
+    exclusions = CpuExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -922,17 +1898,24 @@ void CpuCalcCustomNonbondedForceKernel::createInteraction(const CustomNonbondedF
 
     map<string, Lepton::CustomFunction*> functions;
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
-        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i), data.threads);
 
     // Parse the various expressions used to calculate the force.
 
-    Lepton::ParsedExpression energyExpression = Lepton::Parser::parse(force.getEnergyFunction(), functions).optimize();
-    Lepton::ParsedExpression forceExpression = energyExpression.differentiate("r");
+    energyExpression = Lepton::Parser::parse(force.getEnergyFunction(), functions).optimize();
+    forceExpression = energyExpression.differentiate("r");
+    parameterNames.clear();
+    globalParameterNames.clear();
+    computedValueNames.clear();
+    energyParamDerivNames.clear();
+    computedValueExpressions.clear();
+    energyParamDerivExpressions.clear();
     for (int i = 0; i < force.getNumPerParticleParameters(); i++)
         parameterNames.push_back(force.getPerParticleParameterName(i));
     for (int i = 0; i < force.getNumGlobalParameters(); i++) {
         globalParameterNames.push_back(force.getGlobalParameterName(i));
-        globalParamValues[force.getGlobalParameterName(i)] = force.getGlobalParameterDefaultValue(i);
+        if (globalParamValues.find(force.getGlobalParameterName(i)) == globalParamValues.end())
+            globalParamValues[force.getGlobalParameterName(i)] = force.getGlobalParameterDefaultValue(i);
     }
     set<string> particleVariables, pairVariables;
     particleVariables.insert("r");
@@ -944,7 +1927,6 @@ void CpuCalcCustomNonbondedForceKernel::createInteraction(const CustomNonbondedF
     }
     particleVariables.insert(globalParameterNames.begin(), globalParameterNames.end());
     pairVariables.insert(globalParameterNames.begin(), globalParameterNames.end());
-    vector<Lepton::ParsedExpression> computedValueExpressions, energyParamDerivExpressions;
     for (int i = 0; i < force.getNumComputedValues(); i++) {
         string name, exp;
         force.getComputedValueParameters(i, name, exp);
@@ -968,12 +1950,105 @@ void CpuCalcCustomNonbondedForceKernel::createInteraction(const CustomNonbondedF
 
     for (auto& function : functions)
         delete function.second;
+    createNonbonded();
+}
 
-    // Create the object that computes the interaction.
+/**
+ * Try to replace an energy expression that depends only on r with a cubic spline over [0, cutoff].  The
+ * number of points is doubled until the spline reproduces both the energy and force at the midpoints
+ * between nodes to within a tight tolerance.  Returns false if the expression depends on anything other
+ * than r, is not finite over the range, or cannot be fit accurately.
+ */
+static bool tabulateEnergyExpression(const Lepton::ParsedExpression& energy, double cutoff, Lepton::ParsedExpression& tabulated) {
+    Lepton::CompiledExpression compiled = energy.createCompiledExpression();
+    const set<string>& variables = compiled.getVariables();
+    if (variables.size() > 1 || (variables.size() == 1 && variables.find("r") == variables.end()))
+        return false;
+    Lepton::CompiledExpression compiledForce = energy.differentiate("r").createCompiledExpression();
+    double dummy;
+    double& r = (variables.size() == 1 ? compiled.getVariableReference("r") : dummy);
+    double& forceR = (compiledForce.getVariables().size() == 1 ? compiledForce.getVariableReference("r") : dummy);
+    for (int numPoints = 256; numPoints <= 65536; numPoints *= 2) {
+        vector<double> values(numPoints);
+        bool finite = true;
+        for (int i = 0; i < numPoints && finite; i++) {
+            r = cutoff*i/(numPoints-1);
+            values[i] = compiled.evaluate();
+            finite = isfinite(values[i]);
+        }
+        if (!finite)
+            return false;
+        Continuous1DFunction function(values, 0.0, cutoff);
+        Lepton::CustomFunction* spline = createReferenceTabulatedFunction(function);
+        bool accurate = true;
+        int derivOrder = 1;
+        for (int i = 0; i < numPoints-1 && accurate; i++) {
+            double x = cutoff*(i+0.5)/(numPoints-1);
+            r = x;
+            forceR = x;
+            double exactEnergy = compiled.evaluate();
+            double exactForce = compiledForce.evaluate();
+            double fitEnergy = spline->evaluate(&x);
+            double fitForce = spline->evaluateDerivative(&x, &derivOrder);
+            if (!isfinite(exactEnergy) || !isfinite(exactForce))
+                finite = false;
+            accurate = finite && fabs(fitEnergy-exactEnergy) <= 1e-5*max(1.0, fabs(exactEnergy)) &&
+                    fabs(fitForce-exactForce) <= 1e-4*max(1.0, fabs(exactForce));
+        }
+        if (accurate) {
+            Lepton::ExpressionTreeNode node(new Lepton::Operation::Custom("tabulatedEnergy", spline), Lepton::ExpressionTreeNode(new Lepton::Operation::Variable("r")));
+            tabulated = Lepton::ParsedExpression(node);
+            return true;
+        }
+        delete spline;
+        if (!finite)
+            return false;
+    }
+    return false;
+}
 
+void CpuCalcCustomNonbondedForceKernel::createNonbonded() {
+    if (nonbonded != NULL)
+        delete nonbonded;
     nonbonded = createCpuCustomNonbondedForce(data.threads, *data.neighborList);
-    nonbonded->initialize(energyExpression, forceExpression, parameterNames, exclusions, energyParamDerivExpressions,
-            computedValueNames, computedValueExpressions);
+    nonbonded->setDeterministic(data.deterministicForces);
+    if (data.tabulateCustomNonbonded && nonbondedMethod != NoCutoff && computedValueNames.size() == 0 && energyParamDerivNames.size() == 0) {
+        // If the energy depends only on r, replace it with a spline.
+
+        Lepton::ParsedExpression energy = energyExpression;
+        if (data.specializeGlobals && globalParameterNames.size() > 0) {
+            map<string, double> globals;
+            for (auto& name : globalParameterNames)
+                globals[name] = globalParamValues[name];
+            energy = energyExpression.optimize(globals);
+        }
+        Lepton::ParsedExpression tabulated;
+        if (tabulateEnergyExpression(energy, nonbondedCutoff, tabulated)) {
+            nonbonded->initialize(tabulated, tabulated.differentiate("r"), parameterNames, exclusions, energyParamDerivExpressions,
+                    computedValueNames, computedValueExpressions);
+            if (interactionGroups.size() > 0)
+                nonbonded->setInteractionGroups(interactionGroups);
+            return;
+        }
+    }
+    if (data.specializeGlobals && globalParameterNames.size() > 0) {
+        // Fold the current values of the global parameters into the expressions.  Derivatives with
+        // respect to them were already taken, so they remain correct.
+
+        map<string, double> globals;
+        for (auto& name : globalParameterNames)
+            globals[name] = globalParamValues[name];
+        vector<Lepton::ParsedExpression> specializedComputedValues, specializedParamDerivs;
+        for (auto& expression : computedValueExpressions)
+            specializedComputedValues.push_back(expression.optimize(globals));
+        for (auto& expression : energyParamDerivExpressions)
+            specializedParamDerivs.push_back(expression.optimize(globals));
+        nonbonded->initialize(energyExpression.optimize(globals), forceExpression.optimize(globals), parameterNames, exclusions,
+                specializedParamDerivs, computedValueNames, specializedComputedValues);
+    }
+    else
+        nonbonded->initialize(energyExpression, forceExpression, parameterNames, exclusions, energyParamDerivExpressions,
+                computedValueNames, computedValueExpressions);
     if (interactionGroups.size() > 0)
         nonbonded->setInteractionGroups(interactionGroups);
 }
@@ -983,6 +2058,15 @@ double CpuCalcCustomNonbondedForceKernel::execute(ContextImpl& context, bool inc
     vector<Vec3>& forceData = extractForces(context);
     Vec3* boxVectors = extractBoxVectors(context);
     double energy = 0;
+    bool globalParamsChanged = false;
+    for (auto& name : globalParameterNames) {
+        double value = context.getParameter(name);
+        if (globalParamValues[name] != value)
+            globalParamsChanged = true;
+        globalParamValues[name] = value;
+    }
+    if (globalParamsChanged && data.specializeGlobals)
+        createNonbonded();
     bool periodic = (nonbondedMethod == CutoffPeriodic);
     if (nonbondedMethod != NoCutoff)
         nonbonded->setUseCutoff(nonbondedCutoff);
@@ -992,16 +2076,10 @@ double CpuCalcCustomNonbondedForceKernel::execute(ContextImpl& context, bool inc
             throw OpenMMException("The periodic box size has decreased to less than twice the nonbonded cutoff.");
         nonbonded->setPeriodic(boxVectors);
     }
-    bool globalParamsChanged = false;
-    for (auto& name : globalParameterNames) {
-        double value = context.getParameter(name);
-        if (globalParamValues[name] != value)
-            globalParamsChanged = true;
-        globalParamValues[name] = value;
-    }
     if (useSwitchingFunction)
         nonbonded->setUseSwitchingFunction(switchingDistance);
     vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.threadForceModified = true;
     nonbonded->calculatePairIxn(numParticles, &data.posq[0], posData, particleParamArray, globalParamValues, data.threadForce, includeForces, includeEnergy, energy, &energyParamDerivValues[0]);
     map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
     for (int i = 0; i < energyParamDerivNames.size(); i++)
@@ -1037,6 +2115,7 @@ void CpuCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImpl& con
         for (int j = 0; j < numParameters; j++)
             particleParamArray[i][j] = parameters[j];
     }
+    nonbonded->invalidateComputedValues();
     
     // If necessary, recompute the long range correction.
     
@@ -1057,11 +2136,8 @@ void CpuCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImpl& con
             changed = true;
         }
     }
-    if (changed) {
-        delete nonbonded;
-        nonbonded = NULL;
+    if (changed)
         createInteraction(force);
-    }
 }
 
 CpuCalcGBSAOBCForceKernel::~CpuCalcGBSAOBCForceKernel() {
@@ -1083,6 +2159,7 @@ void CpuCalcGBSAOBCForceKernel::initialize(const System& system, const GBSAOBCFo
     obc.setSolventDielectric((float) force.getSolventDielectric());
     obc.setSoluteDielectric((float) force.getSoluteDielectric());
     obc.setSurfaceAreaEnergy((float) force.getSurfaceAreaEnergy());
+    obc.setDeterministic(data.deterministicForces);
     if (force.getNonbondedMethod() != GBSAOBCForce::NoCutoff)
         obc.setUseCutoff((float) force.getCutoffDistance());
     data.isPeriodic |= (force.getNonbondedMethod() == GBSAOBCForce::CutoffPeriodic);
@@ -1096,6 +2173,7 @@ double CpuCalcGBSAOBCForceKernel::execute(ContextImpl& context, bool includeForc
         obc.setPeriodic(floatBoxSize);
     }
     double energy = 0.0;
+    data.threadForceModified = true;
     obc.computeForce(data.posq, data.threadForce, includeEnergy ? &energy : NULL, data.threads);
     return energy;
 }
@@ -1142,13 +2220,13 @@ void CpuCalcCustomGBForceKernel::initialize(const System& system, const CustomGB
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs;
     for (int i = 0; i < force.getNumExclusions(); i++) {
         int particle1, particle2;
         force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
+        excludedPairs.push_back(make_pair(particle1, particle2));
     }
+    exclusions = CpuExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -1180,7 +2258,7 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
 
     map<string, Lepton::CustomFunction*> functions;
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
-        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i), data.threads);
 
     // Parse the expressions for computed values.
 
@@ -1192,6 +2270,8 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
     vector<vector<Lepton::CompiledExpression> > valueParamDerivExpressions(force.getNumComputedValues());
     vector<Lepton::CompiledExpression> valueExpressions;
     vector<Lepton::CompiledExpression> energyExpressions;
+    vector<Lepton::CompiledVectorExpression> valueVecExpressions;
+    int width = getVectorWidth();
     set<string> particleVariables, pairVariables;
     pairVariables.insert("r");
     particleVariables.insert("x");
@@ -1213,8 +2293,11 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         valueTypes.push_back(type);
         valueNames.push_back(name);
         if (i == 0) {
-            valueDerivExpressions[i].push_back(ex.differentiate("r").createCompiledExpression());
+            Lepton::ParsedExpression dVdR = ex.differentiate("r");
+            valueDerivExpressions[i].push_back(dVdR.createCompiledExpression());
             validateVariables(ex.getRootNode(), pairVariables);
+            valueVecExpressions.push_back(ex.createCompiledVectorExpression(width));
+            valueVecExpressions.push_back(dVdR.createCompiledVectorExpression(width));
         }
         else {
             valueGradientExpressions[i].push_back(ex.differentiate("x").createCompiledExpression());
@@ -1240,6 +2323,7 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
     vector<vector<Lepton::CompiledExpression> > energyDerivExpressions(force.getNumEnergyTerms());
     vector<vector<Lepton::CompiledExpression> > energyGradientExpressions(force.getNumEnergyTerms());
     vector<vector<Lepton::CompiledExpression> > energyParamDerivExpressions(force.getNumEnergyTerms());
+    vector<vector<Lepton::CompiledVectorExpression> > energyVecExpressions(force.getNumEnergyTerms());
     for (int i = 0; i < force.getNumEnergyTerms(); i++) {
         string expression;
         CustomGBForce::ComputationType type;
@@ -1247,8 +2331,12 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         Lepton::ParsedExpression ex = Lepton::Parser::parse(expression, functions).optimize();
         energyExpressions.push_back(ex.createCompiledExpression());
         energyTypes.push_back(type);
-        if (type != CustomGBForce::SingleParticle)
-            energyDerivExpressions[i].push_back(ex.differentiate("r").createCompiledExpression());
+        vector<Lepton::ParsedExpression> pairExpressions;
+        if (type != CustomGBForce::SingleParticle) {
+            pairExpressions.push_back(ex);
+            pairExpressions.push_back(ex.differentiate("r"));
+            energyDerivExpressions[i].push_back(pairExpressions.back().createCompiledExpression());
+        }
         for (int j = 0; j < force.getNumComputedValues(); j++) {
             if (type == CustomGBForce::SingleParticle) {
                 energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]).createCompiledExpression());
@@ -1258,11 +2346,15 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
                 validateVariables(ex.getRootNode(), particleVariables);
             }
             else {
-                energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]+"1").createCompiledExpression());
-                energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]+"2").createCompiledExpression());
+                pairExpressions.push_back(ex.differentiate(valueNames[j]+"1"));
+                energyDerivExpressions[i].push_back(pairExpressions.back().createCompiledExpression());
+                pairExpressions.push_back(ex.differentiate(valueNames[j]+"2"));
+                energyDerivExpressions[i].push_back(pairExpressions.back().createCompiledExpression());
                 validateVariables(ex.getRootNode(), pairVariables);
             }
         }
+        for (auto& pairExpression : pairExpressions)
+            energyVecExpressions[i].push_back(pairExpression.createCompiledVectorExpression(width));
         for (int j = 0; j < force.getNumEnergyParameterDerivatives(); j++)
             energyParamDerivExpressions[i].push_back(ex.differentiate(force.getEnergyParameterDerivativeName(j)).createCompiledExpression());
     }
@@ -1273,7 +2365,7 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         delete function.second;
     ixn = new CpuCustomGBForce(numParticles, exclusions, valueExpressions, valueDerivExpressions, valueGradientExpressions, valueParamDerivExpressions,
         valueNames, valueTypes, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, energyTypes,
-        particleParameterNames, data.threads);
+        particleParameterNames, valueVecExpressions, energyVecExpressions, data.threads);
 }
 
 double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
@@ -1283,7 +2375,7 @@ double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeFor
     if (data.isPeriodic)
         ixn->setPeriodic(extractBoxSize(context));
     if (nonbondedMethod != NoCutoff) {
-        vector<set<int> > noExclusions(numParticles);
+        CpuExclusionList noExclusions(numParticles);
         neighborList->computeNeighborList(numParticles, data.posq, noExclusions, boxVectors, data.isPeriodic, nonbondedCutoff, data.threads);
         ixn->setUseCutoff(nonbondedCutoff, *neighborList);
     }
@@ -1291,6 +2383,7 @@ double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeFor
     for (auto& name : globalParameterNames)
         globalParameters[name] = context.getParameter(name);
     vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.threadForceModified = true;
     ixn->calculateIxn(numParticles, &data.posq[0], particleParamArray, globalParameters, data.threadForce, includeForces, includeEnergy, energy, &energyParamDerivValues[0]);
     map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
     for (int i = 0; i < energyParamDerivNames.size(); i++)
@@ -1373,6 +2466,7 @@ double CpuCalcCustomManyParticleForceKernel::execute(ContextImpl& context, bool
         ixn->setPeriodic(boxVectors);
     }
     double energy = 0;
+    data.threadForceModified = true;
     ixn->calculateIxn(data.posq, particleParamArray, globalParameters, data.threadForce, includeForces, includeEnergy, energy);
     return energy;
 }
@@ -1425,6 +2519,7 @@ void CpuCalcGayBerneForceKernel::initialize(const System& system, const GayBerne
 }
 
 double CpuCalcGayBerneForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    data.threadForceModified = true;
     return ixn->calculateForce(extractPositions(context), extractForces(context), data.threadForce, extractBoxVectors(context), data);
 }
 
@@ -1461,6 +2556,7 @@ void CpuIntegrateLangevinStepKernel::execute(ContextImpl& context, const Langevi
             delete dynamics;
         dynamics = new CpuLangevinDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, data.threads, data.random);
         dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(data.virtualSites);
         prevTemp = temperature;
         prevFriction = friction;
         prevStepSize = stepSize;
@@ -1501,6 +2597,7 @@ void CpuIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, const L
             delete dynamics;
         dynamics = new CpuLangevinMiddleDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, data.threads, data.random);
         dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(data.virtualSites);
         prevTemp = temperature;
         prevFriction = friction;
         prevStepSize = stepSize;
@@ -1514,3 +2611,175 @@ void CpuIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, const L
 double CpuIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) {
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
+
+CpuIntegrateVerletStepKernel::~CpuIntegrateVerletStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVerletStepKernel::initialize(const System& system, const VerletIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+}
+
+void CpuIntegrateVerletStepKernel::execute(ContextImpl& context, const VerletIntegrator& integrator) {
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVerletDynamics(context.getSystem().getNumParticles(), stepSize, data.threads);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(data.virtualSites);
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VerletIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+CpuIntegrateBrownianStepKernel::~CpuIntegrateBrownianStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateBrownianStepKernel::initialize(const System& system, const BrownianIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+
+    // Use a separate generator from the platform's shared one, so this integrator can be combined with
+    // others that use a different seed in a CompoundIntegrator.
+
+    random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateBrownianStepKernel::execute(ContextImpl& context, const BrownianIntegrator& integrator) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuBrownianDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, data.threads, random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(data.virtualSites);
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateBrownianStepKernel::computeKineticEnergy(ContextImpl& context, const BrownianIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0);
+}
+
+CpuIntegrateCustomStepKernel::~CpuIntegrateCustomStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateCustomStepKernel::initialize(const System& system, const CustomIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    perDofValues.resize(integrator.getNumPerDofVariables());
+    for (auto& values : perDofValues)
+        values.resize(numParticles);
+
+    // Create the computation objects.  Per-DOF computations draw random numbers from a generator owned
+    // by this kernel rather than the platform's shared one, so this integrator can be combined with others
+    // that use a different seed in a CompoundIntegrator.  Global and per-particle computations still draw
+    // random numbers from the Reference platform's generator, so that needs to be seeded too.
+
+    dynamics = new CpuCustomDynamics(system.getNumParticles(), integrator, data.threads, random);
+    random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+}
+
+void CpuIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    
+    // Record global variables.
+    
+    map<string, double> globals;
+    globals["dt"] = integrator.getStepSize();
+    for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+        globals[integrator.getGlobalVariableName(i)] = globalValues[i];
+    
+    // Execute the step.
+    
+    dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+    dynamics->setVirtualSites(data.virtualSites);
+    dynamics->update(context, context.getSystem().getNumParticles(), posData, velData, forceData, masses, globals, perDofValues, forcesAreValid, integrator.getConstraintTolerance());
+    
+    // Record changed global variables.
+    
+    integrator.setStepSize(globals["dt"]);
+    for (int i = 0; i < (int) globalValues.size(); i++)
+        globalValues[i] = globals[integrator.getGlobalVariableName(i)];
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += dynamics->getDeltaT();
+    refData->stepCount++;
+}
+
+double CpuIntegrateCustomStepKernel::computeKineticEnergy(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    
+    // Record global variables.
+    
+    map<string, double> globals;
+    globals["dt"] = integrator.getStepSize();
+    for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+        globals[integrator.getGlobalVariableName(i)] = globalValues[i];
+    
+    // Compute the kinetic energy.
+    
+    return dynamics->computeKineticEnergy(context, context.getSystem().getNumParticles(), posData, velData, forceData, masses, globals, perDofValues, forcesAreValid);
+}
+
+void CpuIntegrateCustomStepKernel::getGlobalVariables(ContextImpl& context, vector<double>& values) const {
+    values = globalValues;
+}
+
+void CpuIntegrateCustomStepKernel::setGlobalVariables(ContextImpl& context, const vector<double>& values) {
+    globalValues = values;
+}
+
+void CpuIntegrateCustomStepKernel::getPerDofVariable(ContextImpl& context, int variable, vector<Vec3>& values) const {
+    values.resize(perDofValues[variable].size());
+    for (int i = 0; i < (int) values.size(); i++)
+        values[i] = perDofValues[variable][i];
+}
+
+void CpuIntegrateCustomStepKernel::setPerDofVariable(ContextImpl& context, int variable, const vector<Vec3>& values) {
+    perDofValues[variable].resize(values.size());
+    for (int i = 0; i < (int) values.size(); i++)
+        perDofValues[variable][i] = values[i];
+}
@@ -0,0 +1,200 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuLINCS.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuLINCS::CpuLINCS(const ReferenceCCMAAlgorithm& ccma, ThreadPool& threads, int numTerms) : threads(threads), numTerms(numTerms) {
+    numConstraints = ccma.getNumberOfConstraints();
+    atomIndices.resize(numConstraints);
+    distance.resize(numConstraints);
+    for (int i = 0; i < numConstraints; i++)
+        ccma.getConstraintParameters(i, atomIndices[i].first, atomIndices[i].second, distance[i]);
+    sDiag.resize(numConstraints);
+    rhs1.resize(numConstraints);
+    rhs2.resize(numConstraints);
+    solution.resize(numConstraints);
+    direction.resize(numConstraints);
+
+    // Record which constraints affect each atom, and the sign with which their corrections are applied.
+
+    vector<int> atomIndex;
+    for (int i = 0; i < numConstraints; i++) {
+        int atoms[] = {atomIndices[i].first, atomIndices[i].second};
+        for (int j = 0; j < 2; j++) {
+            int atom = atoms[j];
+            if (atom >= atomIndex.size())
+                atomIndex.resize(atom+1, -1);
+            if (atomIndex[atom] == -1) {
+                atomIndex[atom] = constrainedAtoms.size();
+                constrainedAtoms.push_back(atom);
+                atomConstraints.push_back(vector<pair<int, double> >());
+            }
+            atomConstraints[atomIndex[atom]].push_back(make_pair(i, j == 0 ? 1.0 : -1.0));
+        }
+    }
+
+    // Two constraints are coupled if they share an atom.  Record the shared atom and the product
+    // of the signs with which the two constraints act on it.
+
+    couplingConstraint.resize(numConstraints);
+    couplingAtom.resize(numConstraints);
+    couplingSign.resize(numConstraints);
+    couplingCoeff.resize(numConstraints);
+    for (int i = 0; i < constrainedAtoms.size(); i++) {
+        for (auto& c1 : atomConstraints[i])
+            for (auto& c2 : atomConstraints[i])
+                if (c1.first != c2.first) {
+                    couplingConstraint[c1.first].push_back(c2.first);
+                    couplingAtom[c1.first].push_back(constrainedAtoms[i]);
+                    couplingSign[c1.first].push_back(c1.second*c2.second);
+                }
+    }
+    for (int i = 0; i < numConstraints; i++)
+        couplingCoeff[i].resize(couplingConstraint[i].size());
+}
+
+void CpuLINCS::apply(vector<Vec3>& atomCoordinates, vector<Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
+    if (numConstraints == 0)
+        return;
+    computeDirections(atomCoordinates, inverseMasses);
+
+    // Project out the components of the displacements along the old constraint directions.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            Vec3 rp_ij = atomCoordinatesP[atomIndices[i].first] - atomCoordinatesP[atomIndices[i].second];
+            rhs1[i] = solution[i] = sDiag[i]*(direction[i].dot(rp_ij) - distance[i]);
+        }
+    });
+    threads.waitForThreads();
+    solveMatrix();
+    updateAtoms(atomCoordinatesP, inverseMasses);
+
+    // Correct for the lengthening caused by rotation of the constraints.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            Vec3 rp_ij = atomCoordinatesP[atomIndices[i].first] - atomCoordinatesP[atomIndices[i].second];
+            double p2 = 2*distance[i]*distance[i] - rp_ij.dot(rp_ij);
+            double p = (p2 > 0 ? sqrt(p2) : 0.0);
+            rhs1[i] = solution[i] = sDiag[i]*(distance[i] - p);
+        }
+    });
+    threads.waitForThreads();
+    solveMatrix();
+    updateAtoms(atomCoordinatesP, inverseMasses);
+}
+
+void CpuLINCS::applyToVelocities(vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
+    if (numConstraints == 0)
+        return;
+    computeDirections(atomCoordinates, inverseMasses);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            Vec3 v_ij = velocities[atomIndices[i].first] - velocities[atomIndices[i].second];
+            rhs1[i] = solution[i] = sDiag[i]*direction[i].dot(v_ij);
+        }
+    });
+    threads.waitForThreads();
+    solveMatrix();
+    updateAtoms(velocities, inverseMasses);
+}
+
+void CpuLINCS::computeDirections(vector<Vec3>& atomCoordinates, vector<double>& inverseMasses) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            Vec3 r_ij = atomCoordinates[atomIndices[i].first] - atomCoordinates[atomIndices[i].second];
+            direction[i] = r_ij/sqrt(r_ij.dot(r_ij));
+            double invMassSum = inverseMasses[atomIndices[i].first] + inverseMasses[atomIndices[i].second];
+            sDiag[i] = (invMassSum > 0 ? 1.0/sqrt(invMassSum) : 0.0);
+        }
+    });
+    threads.waitForThreads();
+
+    // Compute the off-diagonal elements of the normalized coupling matrix.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            for (int k = 0; k < couplingConstraint[i].size(); k++) {
+                int j = couplingConstraint[i][k];
+                couplingCoeff[i][k] = -sDiag[i]*sDiag[j]*couplingSign[i][k]*inverseMasses[couplingAtom[i][k]]*direction[i].dot(direction[j]);
+            }
+    });
+    threads.waitForThreads();
+}
+
+void CpuLINCS::solveMatrix() {
+    for (int term = 0; term < numTerms; term++) {
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = threadIndex*numConstraints/threads.getNumThreads();
+            int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+            for (int i = start; i < end; i++) {
+                double sum = 0.0;
+                for (int k = 0; k < couplingConstraint[i].size(); k++)
+                    sum += couplingCoeff[i][k]*rhs1[couplingConstraint[i][k]];
+                rhs2[i] = sum;
+                solution[i] += sum;
+            }
+        });
+        threads.waitForThreads();
+        rhs1.swap(rhs2);
+    }
+}
+
+void CpuLINCS::updateAtoms(vector<Vec3>& atomCoordinatesP, vector<double>& inverseMasses) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int numAtoms = constrainedAtoms.size();
+        int start = threadIndex*numAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            int atom = constrainedAtoms[i];
+            Vec3 dr;
+            for (auto& c : atomConstraints[i])
+                dr += direction[c.first]*(c.second*sDiag[c.first]*solution[c.first]);
+            atomCoordinatesP[atom] -= dr*inverseMasses[atom];
+        }
+    });
+    threads.waitForThreads();
+}
@@ -30,12 +30,11 @@
  * -------------------------------------------------------------------------- */
 
 #include "CpuNeighborList.h"
+#include "openmm/internal/TraceRange.h"
 #include "openmm/internal/hardware.h"
 #include "openmm/internal/vectorize.h"
 #include "hilbert.h"
 #include <algorithm>
-#include <set>
-#include <map>
 #include <cmath>
 
 using namespace std;
@@ -410,12 +409,14 @@ private:
     vector<vector<vector<pair<float, int> > > > bins;
 };
 
-CpuNeighborList::CpuNeighborList(int blockSize) : blockSize(blockSize) {
+CpuNeighborList::CpuNeighborList(int blockSize) : blockSize(blockSize), dense(false), cellsBuilt(false) {
 }
 
-void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const vector<set<int> >& exclusions,
+void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const CpuExclusionList& exclusions,
             const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads) {
+    OPENMM_TRACE_RANGE("Build neighbor list");
     dense = false;
+    cellsBuilt = false;
     int numBlocks = (numAtoms+blockSize-1)/blockSize;
     blockNeighbors.resize(numBlocks);
     blockExclusions.resize(numBlocks);
@@ -495,42 +496,40 @@ void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float
     }
 }
 
-void CpuNeighborList::createDenseNeighborList(int numAtoms, const vector<set<int> >& exclusions) {
+void CpuNeighborList::createDenseNeighborList(int numAtoms, const CpuExclusionList& exclusions) {
     dense = true;
     this->numAtoms = numAtoms;
+    this->exclusions = &exclusions;
     int numBlocks = (numAtoms+blockSize-1)/blockSize;
     blockExclusionIndices.resize(numBlocks);
     blockExclusions.resize(numBlocks);
     sortedAtoms.resize(numAtoms);
     for (int i = 0; i < numAtoms; i++)
         sortedAtoms[i] = i;
+    vector<pair<int, BlockExclusionMask> > merged;
     for (int i = 0; i < numBlocks; i++) {
-        // Build the list of exclusions for this block.
+        // Build the list of exclusions for this block.  Every atom in the block also excludes
+        // itself and the atoms before it, so combine those entries with the merged exclusions.
 
         int firstIndex = blockSize*i;
         int atomsInBlock = min(blockSize, numAtoms-firstIndex);
-        map<int, int> exclusionMap;
-        for (int j = 0; j < atomsInBlock; j++) {
-            exclusionMap[firstIndex+j] = (1<<(j+1))-1;
-        }
+        mergeBlockExclusions(&sortedAtoms[firstIndex], atomsInBlock, merged);
+        vector<int>& indices = blockExclusionIndices[i];
+        vector<BlockExclusionMask>& masks = blockExclusions[i];
+        indices.clear();
+        masks.clear();
+        auto next = lower_bound(merged.begin(), merged.end(), firstIndex,
+                [] (const pair<int, BlockExclusionMask>& entry, int index) { return entry.first < index; });
         for (int j = 0; j < atomsInBlock; j++) {
-            const set<int>& atomExclusions = exclusions[firstIndex+j];
-            const BlockExclusionMask mask = 1<<j;
-            for (int exclusion : atomExclusions) {
-                if (firstIndex <= exclusion) {
-                    auto thisAtomFlags = exclusionMap.find(exclusion);
-                    if (thisAtomFlags == exclusionMap.end())
-                        exclusionMap[exclusion] = mask;
-                    else
-                        thisAtomFlags->second |= mask;
-                }
-            }
+            BlockExclusionMask mask = (1<<(j+1))-1;
+            if (next != merged.end() && next->first == firstIndex+j)
+                mask |= (next++)->second;
+            indices.push_back(firstIndex+j);
+            masks.push_back(mask);
         }
-        blockExclusionIndices[i].clear();
-        blockExclusions[i].clear();
-        for (auto flags : exclusionMap) {
-            blockExclusionIndices[i].push_back(flags.first);
-            blockExclusions[i].push_back(flags.second);
+        for (; next != merged.end(); ++next) {
+            indices.push_back(next->first);
+            masks.push_back(next->second);
         }
     }
 
@@ -547,6 +546,178 @@ void CpuNeighborList::createDenseNeighborList(int numAtoms, const vector<set<int
     }
 }
 
+bool CpuNeighborList::updateNeighborList(const AlignedArray<float>& atomLocations, const vector<int>& movedAtoms, const Vec3* periodicBoxVectors, float searchDistance) {
+    if (dense)
+        return false;
+    if (usePeriodic) {
+        if (periodicBoxVectors[1][0] != 0 || periodicBoxVectors[2][0] != 0 || periodicBoxVectors[2][1] != 0)
+            return false;
+        for (int i = 0; i < 3; i++)
+            if (periodicBoxVectors[i] != this->periodicBoxVectors[i])
+                return false;
+    }
+    if ((!cellsBuilt || searchDistance > cellDistance) && !buildAtomCells(searchDistance))
+        return false;
+
+    // Move the atoms to their new cells and record their new positions.
+
+    for (int atom : movedAtoms) {
+        int sortedIndex = atomSortedIndex[atom];
+        int oldCell = atomCell[sortedIndex];
+        int newCell = findAtomCell(&atomLocations[4*atom]);
+        if (newCell != oldCell) {
+            vector<int>& oldCellAtoms = cells[oldCell];
+            *find(oldCellAtoms.begin(), oldCellAtoms.end(), sortedIndex) = oldCellAtoms.back();
+            oldCellAtoms.pop_back();
+            cells[newCell].push_back(sortedIndex);
+            atomCell[sortedIndex] = newCell;
+        }
+        fvec4(&atomLocations[4*atom]).store(&sortedPositions[4*sortedIndex]);
+    }
+
+    // Search the surrounding cells for pairs that are now within range.  The cells are at least
+    // searchDistance wide, so only the adjacent ones need to be checked.
+
+    float searchDistanceSquared = searchDistance*searchDistance;
+    fvec4 boxSize((float) periodicBoxVectors[0][0], (float) periodicBoxVectors[1][1], (float) periodicBoxVectors[2][2], 0);
+    fvec4 invBoxSize((float) (1/periodicBoxVectors[0][0]), (float) (1/periodicBoxVectors[1][1]), (float) (1/periodicBoxVectors[2][2]), 0);
+    for (int atom : movedAtoms) {
+        int sortedIndex = atomSortedIndex[atom];
+        fvec4 atomPos(&sortedPositions[4*sortedIndex]);
+        int cell = atomCell[sortedIndex];
+        int cellIndex[3] = {cell%numCells[0], (cell/numCells[0])%numCells[1], cell/(numCells[0]*numCells[1])};
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++) {
+                    int index[3] = {cellIndex[0]+dx, cellIndex[1]+dy, cellIndex[2]+dz};
+                    bool inRange = true;
+                    for (int i = 0; i < 3; i++) {
+                        if (usePeriodic)
+                            index[i] = (index[i]+numCells[i])%numCells[i];
+                        else if (index[i] < 0 || index[i] >= numCells[i])
+                            inRange = false;
+                    }
+                    if (!inRange)
+                        continue;
+                    for (int other : cells[index[0]+numCells[0]*(index[1]+numCells[1]*index[2])]) {
+                        if (other == sortedIndex)
+                            continue;
+                        fvec4 delta = fvec4(&sortedPositions[4*other])-atomPos;
+                        if (usePeriodic)
+                            delta -= round(delta*invBoxSize)*boxSize;
+                        if (dot3(delta, delta) < searchDistanceSquared && !exclusions->isExcluded(atom, sortedAtoms[other]))
+                            addPair(sortedIndex, other);
+                    }
+                }
+    }
+    return true;
+}
+
+bool CpuNeighborList::buildAtomCells(float distance) {
+    long long totalCells = 1;
+    if (usePeriodic) {
+        for (int i = 0; i < 3; i++) {
+            numCells[i] = (int) floor(periodicBoxVectors[i][i]/distance);
+            if (numCells[i] < 3)
+                return false;
+            cellOrigin[i] = 0.0f;
+            cellSize[i] = (float) (periodicBoxVectors[i][i]/numCells[i]);
+            totalCells *= numCells[i];
+        }
+    }
+    else {
+        float minPos[3] = {minx, miny, minz};
+        float maxPos[3] = {maxx, maxy, maxz};
+        for (int i = 0; i < 3; i++) {
+            numCells[i] = (int) ((maxPos[i]-minPos[i])/distance)+1;
+            cellOrigin[i] = minPos[i];
+            cellSize[i] = distance;
+            totalCells *= numCells[i];
+        }
+    }
+
+    // A very sparse system could need a huge number of cells.  It is better to just rebuild the list.
+
+    if (totalCells > 8*(long long) numAtoms+27)
+        return false;
+    cells.clear();
+    cells.resize(totalCells);
+    atomCell.resize(numAtoms);
+    atomSortedIndex.resize(numAtoms);
+    for (int i = 0; i < numAtoms; i++) {
+        atomSortedIndex[sortedAtoms[i]] = i;
+        atomCell[i] = findAtomCell(&sortedPositions[4*i]);
+        cells[atomCell[i]].push_back(i);
+    }
+    cellDistance = distance;
+    cellsBuilt = true;
+    return true;
+}
+
+int CpuNeighborList::findAtomCell(const float* pos) const {
+    // Atoms outside the range of a non-periodic grid go into the edge cells.  Anything within
+    // one cell width of them is still in an adjacent cell.
+
+    int index[3];
+    for (int i = 0; i < 3; i++) {
+        index[i] = (int) floorf((pos[i]-cellOrigin[i])/cellSize[i]);
+        if (usePeriodic)
+            index[i] = ((index[i]%numCells[i])+numCells[i])%numCells[i];
+        else
+            index[i] = max(0, min(numCells[i]-1, index[i]));
+    }
+    return index[0]+numCells[0]*(index[1]+numCells[1]*index[2]);
+}
+
+void CpuNeighborList::addPair(int sortedIndex1, int sortedIndex2) {
+    // Each pair is stored in the block containing the atom that comes later in the sorted order.
+    // Pairs within a single block are always present.
+
+    int lower = min(sortedIndex1, sortedIndex2);
+    int upper = max(sortedIndex1, sortedIndex2);
+    int block = upper/blockSize;
+    if (lower >= block*blockSize)
+        return;
+    const BlockExclusionMask laneMask = 1<<(upper-block*blockSize);
+    int atom = sortedAtoms[lower];
+    vector<int>& neighbors = blockNeighbors[block];
+    vector<BlockExclusionMask>& masks = blockExclusions[block];
+    for (int i = 0; i < (int) neighbors.size(); i++)
+        if (neighbors[i] == atom) {
+            masks[i] &= ~laneMask;
+            return;
+        }
+    neighbors.push_back(atom);
+    masks.push_back(((1<<blockSize)-1) & ~laneMask);
+}
+
+void CpuNeighborList::mergeBlockExclusions(const int* blockAtoms, int atomsInBlock, vector<pair<int, BlockExclusionMask> >& merged) const {
+    const int maxBlockSize = 8*sizeof(BlockExclusionMask);
+    const int* current[maxBlockSize];
+    const int* end[maxBlockSize];
+    for (int j = 0; j < atomsInBlock; j++) {
+        CpuExclusionList::Range atomExclusions = (*exclusions)[blockAtoms[j]];
+        current[j] = atomExclusions.begin();
+        end[j] = atomExclusions.end();
+    }
+    merged.clear();
+    while (true) {
+        int next = -1;
+        for (int j = 0; j < atomsInBlock; j++)
+            if (current[j] != end[j] && (next == -1 || *current[j] < next))
+                next = *current[j];
+        if (next == -1)
+            break;
+        BlockExclusionMask mask = 0;
+        for (int j = 0; j < atomsInBlock; j++)
+            if (current[j] != end[j] && *current[j] == next) {
+                mask |= 1<<j;
+                current[j]++;
+            }
+        merged.push_back(make_pair(next, mask));
+    }
+}
+
 int CpuNeighborList::getNumBlocks() const {
     return sortedAtoms.size()/blockSize;
 }
@@ -555,6 +726,30 @@ int CpuNeighborList::getBlockSize() const {
     return blockSize;
 }
 
+void CpuNeighborList::getBalancedBlockRanges(int numRanges, vector<int>& ranges) const {
+    // The cost of a block is taken to be proportional to the number of neighbors, plus a fixed
+    // overhead for the atoms in the block itself.
+
+    int numBlocks = getNumBlocks();
+    auto blockCost = [&] (int block) -> long long {
+        return blockSize + (dense ? numAtoms-block*blockSize : blockNeighbors[block].size());
+    };
+    long long totalCost = 0;
+    for (int i = 0; i < numBlocks; i++)
+        totalCost += blockCost(i);
+    ranges.resize(numRanges+1);
+    ranges[0] = 0;
+    int range = 1;
+    long long cost = 0;
+    for (int i = 0; i < numBlocks; i++) {
+        while (range < numRanges && cost >= (totalCost*range)/numRanges)
+            ranges[range++] = i;
+        cost += blockCost(i);
+    }
+    while (range <= numRanges)
+        ranges[range++] = numBlocks;
+}
+
 const std::vector<int32_t>& CpuNeighborList::getSortedAtoms() const {
     return sortedAtoms;
 }
@@ -598,6 +793,7 @@ void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadI
     vector<int> blockAtoms;
     vector<float> blockAtomX(blockSize), blockAtomY(blockSize), blockAtomZ(blockSize);
     vector<VoxelIndex> atomVoxelIndex;
+    vector<pair<int, BlockExclusionMask> > merged;
     while (true) {
         int i = atomicCounter++;
         if (i >= numBlocks)
@@ -634,23 +830,15 @@ void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadI
 
         // Record the exclusions for this block.
 
-        map<int, BlockExclusionMask> atomFlags;
-        for (int j = 0; j < atomsInBlock; j++) {
-            const set<int>& atomExclusions = (*exclusions)[sortedAtoms[firstIndex+j]];
-            const BlockExclusionMask mask = 1<<j;
-            for (int exclusion : atomExclusions) {
-                const auto thisAtomFlags = atomFlags.find(exclusion);
-                if (thisAtomFlags == atomFlags.end())
-                    atomFlags[exclusion] = mask;
-                else
-                    thisAtomFlags->second |= mask;
-            }
-        }
+        mergeBlockExclusions(&blockAtoms[0], atomsInBlock, merged);
+        if (merged.size() == 0)
+            continue;
         int numNeighbors = blockNeighbors[i].size();
         for (int k = 0; k < numNeighbors; k++) {
             int atomIndex = blockNeighbors[i][k];
-            auto thisAtomFlags = atomFlags.find(atomIndex);
-            if (thisAtomFlags != atomFlags.end())
+            auto thisAtomFlags = lower_bound(merged.begin(), merged.end(), atomIndex,
+                    [] (const pair<int, BlockExclusionMask>& entry, int index) { return entry.first < index; });
+            if (thisAtomFlags != merged.end() && thisAtomFlags->first == atomIndex)
                 blockExclusions[i][k] |= thisAtomFlags->second;
         }
     }
@@ -28,6 +28,7 @@
 #include "CpuNonbondedForce.h"
 #include "ReferenceForce.h"
 #include "ReferencePME.h"
+#include "openmm/internal/TraceRange.h"
 #include <algorithm>
 #include <iostream>
 
@@ -48,7 +49,7 @@ const int CpuNonbondedForce::NUM_TABLE_POINTS = 2048;
    --------------------------------------------------------------------------------------- */
 
 CpuNonbondedForce::CpuNonbondedForce(const CpuNeighborList& neighbors) : neighborList(&neighbors), cutoff(false), useSwitch(false), periodic(false),
-        periodicExceptions(false), ewald(false), pme(false), ljpme(false), tableIsValid(false), expTableIsValid(false), cutoffDistance(0.0f),
+        periodicExceptions(false), ewald(false), pme(false), ljpme(false), deterministic(false), tableIsValid(false), expTableIsValid(false), cutoffDistance(0.0f),
         alphaDispersionEwald(0.0f), alphaEwald(0.0f) {
 }
 
@@ -205,6 +206,10 @@ void CpuNonbondedForce::setPeriodicExceptions(bool periodic) {
     periodicExceptions = periodic;
 }
 
+void CpuNonbondedForce::setDeterministic(bool deterministic) {
+    this->deterministic = deterministic;
+}
+
 void CpuNonbondedForce::tabulateEwaldScaleFactor() {
     if (tableIsValid)
         return;
@@ -243,8 +248,9 @@ void CpuNonbondedForce::tabulateExpTerms() {
 }
 
 void CpuNonbondedForce::calculateReciprocalIxn(int numberOfAtoms, float* posq, const vector<Vec3>& atomCoordinates,
-                                               const vector<pair<float, float> >& atomParameters, const vector<float> &C6params, const vector<set<int> >& exclusions,
-                                               vector<Vec3>& forces, double* totalEnergy) const {
+                                               const vector<pair<float, float> >& atomParameters, const vector<float> &C6params, const CpuExclusionList& exclusions,
+                                               vector<Vec3>& forces, double* totalEnergy, ThreadPool& threads) const {
+    OPENMM_TRACE_RANGE("Nonbonded reciprocal space");
     typedef std::complex<float> d_complex;
 
     static const float epsilon     =  1.0;
@@ -298,87 +304,155 @@ void CpuNonbondedForce::calculateReciprocalIxn(int numberOfAtoms, float* posq, c
 
         float recipBoxSize[3] = {(float) (TWO_PI/periodicBoxVectors[0][0]), (float) (TWO_PI/periodicBoxVectors[1][1]), (float) (TWO_PI/periodicBoxVectors[2][2])};
 
+        // Tabulate exp(i*k*r) for each atom and each component of the K-vectors.  The values for different
+        // atoms are stored contiguously so they can be processed four at a time.  The number of atoms is padded
+        // to a multiple of 4, and the padding atoms have zero charge.
 
-        // setup K-vectors
-
-#define EIR(x, y, z) eir[(x)*numberOfAtoms*3+(y)*3+z]
-        vector<d_complex> eir(kmax*numberOfAtoms*3);
-        vector<d_complex> tab_xy(numberOfAtoms);
-        vector<d_complex> tab_qxyz(numberOfAtoms);
-
-        for (int i = 0; (i < numberOfAtoms); i++) {
-            float* pos = posq+4*i;
-            for (int m = 0; (m < 3); m++)
-                EIR(0, i, m) = d_complex(1,0);
-
-            for (int m=0; (m<3); m++)
-                EIR(1, i, m) = d_complex(cos(pos[m]*recipBoxSize[m]),
-                                         sin(pos[m]*recipBoxSize[m]));
-
-            for (int j=2; (j<kmax); j++)
-                for (int m=0; (m<3); m++)
-                    EIR(j, i, m) = EIR(j-1, i, m) * EIR(1, i, m);
-        }
+        int numThreads = threads.getNumThreads();
+        int paddedAtoms = 4*((numberOfAtoms+3)/4);
+        int numAtomBlocks = paddedAtoms/4;
+#define EIR_INDEX(k, m) (((k)*3+(m))*paddedAtoms)
+        vector<float> eirReal(kmax*3*paddedAtoms, 0.0f), eirImag(kmax*3*paddedAtoms, 0.0f);
+        vector<float> charges(paddedAtoms, 0.0f);
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = (threadIndex*numberOfAtoms)/numThreads;
+            int end = ((threadIndex+1)*numberOfAtoms)/numThreads;
+            for (int i = start; i < end; i++) {
+                float* pos = posq+4*i;
+                charges[i] = pos[3];
+                for (int m = 0; m < 3; m++) {
+                    eirReal[EIR_INDEX(0, m)+i] = 1.0f;
+                    eirImag[EIR_INDEX(0, m)+i] = 0.0f;
+                    if (kmax < 2)
+                        continue;
+                    d_complex eir1(cos(pos[m]*recipBoxSize[m]), sin(pos[m]*recipBoxSize[m]));
+                    d_complex eir = eir1;
+                    eirReal[EIR_INDEX(1, m)+i] = eir.real();
+                    eirImag[EIR_INDEX(1, m)+i] = eir.imag();
+                    for (int j = 2; j < kmax; j++) {
+                        eir *= eir1;
+                        eirReal[EIR_INDEX(j, m)+i] = eir.real();
+                        eirImag[EIR_INDEX(j, m)+i] = eir.imag();
+                    }
+                }
+            }
+        });
+        threads.waitForThreads();
 
-        // calculate reciprocal space energy and forces
+        // Build the list of K-vectors.
 
+        vector<int> kIndex;
         int lowry = 0;
         int lowrz = 1;
-
         for (int rx = 0; rx < numRx; rx++) {
-            float kx = rx * recipBoxSize[0];
             for (int ry = lowry; ry < numRy; ry++) {
-                float ky = ry * recipBoxSize[1];
-                if (ry >= 0) {
-                    for (int n = 0; n < numberOfAtoms; n++)
-                        tab_xy[n] = EIR(rx, n, 0) * EIR(ry, n, 1);
-                }
-                else {
-                    for (int n = 0; n < numberOfAtoms; n++)
-                        tab_xy[n]= EIR(rx, n, 0) * conj (EIR(-ry, n, 1));
-                }
                 for (int rz = lowrz; rz < numRz; rz++) {
-                    if (rz >= 0) {
-                        for (int n = 0; n < numberOfAtoms; n++)
-                            tab_qxyz[n] = posq[4*n+3] * (tab_xy[n] * EIR(rz, n, 2));
-                    }
-                    else {
-                        for (int n = 0; n < numberOfAtoms; n++)
-                            tab_qxyz[n] = posq[4*n+3] * (tab_xy[n] * conj(EIR(-rz, n, 2)));
-                    }
-                    float cs = 0.0f;
-                    float ss = 0.0f;
-
-                    for (int n = 0; n < numberOfAtoms; n++) {
-                        cs += tab_qxyz[n].real();
-                        ss += tab_qxyz[n].imag();
-                    }
-
-                    float kz = rz * recipBoxSize[2];
-                    float k2 = kx * kx + ky * ky + kz * kz;
-                    float ak = exp(k2*factorEwald) / k2;
-
-                    for (int n = 0; n < numberOfAtoms; n++) {
-                        float force = ak * (cs * tab_qxyz[n].imag() - ss * tab_qxyz[n].real());
-                        forces[n][0] += 2 * recipCoeff * force * kx;
-                        forces[n][1] += 2 * recipCoeff * force * ky;
-                        forces[n][2] += 2 * recipCoeff * force * kz;
-                    }
-
-                    if (totalEnergy)
-                        *totalEnergy += recipCoeff * ak * (cs * cs + ss * ss);
-
+                    kIndex.push_back(rx);
+                    kIndex.push_back(ry);
+                    kIndex.push_back(rz);
                     lowrz = 1 - numRz;
                 }
                 lowry = 1 - numRy;
             }
         }
+        int numK = kIndex.size()/3;
+
+        // Compute exp(i*k*r) for one K-vector and four atoms.
+
+        auto computePhase = [&] (int k, int block, fvec4& re, fvec4& im) {
+            int offset = 4*block;
+            int rx = kIndex[3*k], ry = kIndex[3*k+1], rz = kIndex[3*k+2];
+            fvec4 xr(&eirReal[EIR_INDEX(rx, 0)+offset]), xi(&eirImag[EIR_INDEX(rx, 0)+offset]);
+            fvec4 yr(&eirReal[EIR_INDEX(abs(ry), 1)+offset]), yi(&eirImag[EIR_INDEX(abs(ry), 1)+offset]);
+            fvec4 zr(&eirReal[EIR_INDEX(abs(rz), 2)+offset]), zi(&eirImag[EIR_INDEX(abs(rz), 2)+offset]);
+            if (ry < 0)
+                yi = -yi;
+            if (rz < 0)
+                zi = -zi;
+            fvec4 xyr = xr*yr - xi*yi;
+            fvec4 xyi = xr*yi + xi*yr;
+            re = xyr*zr - xyi*zi;
+            im = xyr*zi + xyi*zr;
+        };
+
+        // Compute the structure factor for each K-vector.  The K-vectors are divided between threads,
+        // and each one is summed over all atoms by a single thread, so the result does not depend on
+        // the number of threads.
+
+        vector<float> cs(numK), ss(numK), ak(numK);
+        vector<fvec4> kvec(numK);
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = (threadIndex*numK)/numThreads;
+            int end = ((threadIndex+1)*numK)/numThreads;
+            for (int k = start; k < end; k++) {
+                fvec4 sumReal(0.0f), sumImag(0.0f);
+                for (int block = 0; block < numAtomBlocks; block++) {
+                    fvec4 re, im;
+                    computePhase(k, block, re, im);
+                    fvec4 q(&charges[4*block]);
+                    sumReal += q*re;
+                    sumImag += q*im;
+                }
+                cs[k] = reduceAdd(sumReal);
+                ss[k] = reduceAdd(sumImag);
+                float kx = kIndex[3*k]*recipBoxSize[0];
+                float ky = kIndex[3*k+1]*recipBoxSize[1];
+                float kz = kIndex[3*k+2]*recipBoxSize[2];
+                float k2 = kx * kx + ky * ky + kz * kz;
+                ak[k] = exp(k2*factorEwald) / k2;
+                kvec[k] = fvec4(kx, ky, kz, 0.0f);
+            }
+        });
+        threads.waitForThreads();
+
+        // Compute the forces.  The atoms are divided between threads, so each force is written by
+        // only one thread.
+
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = (threadIndex*numAtomBlocks)/numThreads;
+            int end = ((threadIndex+1)*numAtomBlocks)/numThreads;
+            for (int block = start; block < end; block++) {
+                fvec4 fx(0.0f), fy(0.0f), fz(0.0f);
+                for (int k = 0; k < numK; k++) {
+                    fvec4 re, im;
+                    computePhase(k, block, re, im);
+                    fvec4 force = ak[k]*(cs[k]*im - ss[k]*re);
+                    fx += force*kvec[k][0];
+                    fy += force*kvec[k][1];
+                    fz += force*kvec[k][2];
+                }
+                fvec4 scale = fvec4(2*recipCoeff)*fvec4(&charges[4*block]);
+                float f[3][4];
+                (fx*scale).store(f[0]);
+                (fy*scale).store(f[1]);
+                (fz*scale).store(f[2]);
+                for (int j = 0; j < 4 && 4*block+j < numberOfAtoms; j++) {
+                    int n = 4*block+j;
+                    forces[n][0] += f[0][j];
+                    forces[n][1] += f[1][j];
+                    forces[n][2] += f[2][j];
+                }
+            }
+        });
+        threads.waitForThreads();
+#undef EIR_INDEX
+
+        // Sum the energy in a fixed order.
+
+        if (totalEnergy) {
+            double recipEnergy = 0.0;
+            for (int k = 0; k < numK; k++)
+                recipEnergy += recipCoeff * ak[k] * (cs[k] * cs[k] + ss[k] * ss[k]);
+            *totalEnergy += recipEnergy;
+        }
     }
 }
 
 
 void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const vector<Vec3>& atomCoordinates, const vector<pair<float, float> >& atomParameters,
-                                           const vector<float>& C6params, const vector<set<int> >& exclusions, vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads) {
+                                           const vector<float>& C6params, const CpuExclusionList& exclusions, vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads,
+                                           bool includeForces) {
+    OPENMM_TRACE_RANGE("Nonbonded direct space");
     // Record the parameters for the threads.
     
     this->numberOfAtoms = numberOfAtoms;
@@ -386,12 +460,15 @@ void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const
     this->atomCoordinates = &atomCoordinates[0];
     this->atomParameters = &atomParameters[0];
     this->C6params = &C6params[0];
-    this->exclusions = &exclusions[0];
+    this->exclusions = &exclusions;
     this->threadForce = &threadForce;
+    this->includeForces = includeForces;
     includeEnergy = (totalEnergy != NULL);
     threadEnergy.resize(threads.getNumThreads());
     atomicCounter = 0;
     atomicCounter2 = 0;
+    if (deterministic)
+        neighborList->getBalancedBlockRanges(threads.getNumThreads(), blockRanges);
     
     // Signal the threads to start running and wait for them to finish.
     
@@ -418,27 +495,38 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
     float* forces = &(*threadForce)[threadIndex][0];
     fvec4 boxSize(periodicBoxVectors[0][0], periodicBoxVectors[1][1], periodicBoxVectors[2][2], 0);
     fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
+    // Normally each thread takes the next block as soon as it finishes the previous one.  In deterministic
+    // mode, every thread processes a fixed range of blocks so its force buffer is always summed in the
+    // same order.
+
+    int nextBlock = (deterministic ? blockRanges[threadIndex] : 0);
+    int endBlock = (deterministic ? blockRanges[threadIndex+1] : neighborList->getNumBlocks());
     if (ewald || pme || ljpme) {
         // Compute the interactions from the neighbor list.
         while (true) {
-            int nextBlock = atomicCounter++;
-            if (nextBlock >= neighborList->getNumBlocks())
+            if (!deterministic)
+                nextBlock = atomicCounter++;
+            if (nextBlock >= endBlock)
                 break;
             calculateBlockEwaldIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
+            if (deterministic)
+                nextBlock++;
         }
 
         // Now subtract off the exclusions, since they were implicitly included in the reciprocal space sum.
 
         const int groupSize = max(1, numberOfAtoms/(10*numThreads));
+        int start = groupSize*threadIndex;
         while (true) {
-            int start = atomicCounter2.fetch_add(groupSize);
+            if (!deterministic)
+                start = atomicCounter2.fetch_add(groupSize);
             if (start >= numberOfAtoms)
                 break;
             int end = min(start+groupSize, numberOfAtoms);
             for (int i = start; i < end; i++) {
                 fvec4 posI((float) atomCoordinates[i][0], (float) atomCoordinates[i][1], (float) atomCoordinates[i][2], 0.0f);
                 float scaledChargeI = (float) (ONE_4PI_EPS0*posq[4*i+3]);
-                for (int excluded : exclusions[i]) {
+                for (int excluded : (*exclusions)[i]) {
                     if (excluded > i) {
                         int j = excluded;
                         fvec4 deltaR;
@@ -451,11 +539,13 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
                         if (erfAlphaR > 1e-6f) {
                             float inverseR = 1/r;
                             float chargeProdOverR = scaledChargeI*posq[4*j+3]*inverseR;
-                            float dEdR = chargeProdOverR*inverseR*inverseR;
-                            dEdR = dEdR * (erfAlphaR-TWO_OVER_SQRT_PI*alphaR*(float)exp(-alphaR*alphaR));
-                            fvec4 result = deltaR*dEdR;
-                            (fvec4(forces+4*i)-result).store(forces+4*i);
-                            (fvec4(forces+4*j)+result).store(forces+4*j);
+                            if (includeForces) {
+                                float dEdR = chargeProdOverR*inverseR*inverseR;
+                                dEdR = dEdR * (erfAlphaR-TWO_OVER_SQRT_PI*alphaR*(float)exp(-alphaR*alphaR));
+                                fvec4 result = deltaR*dEdR;
+                                (fvec4(forces+4*i)-result).store(forces+4*i);
+                                (fvec4(forces+4*j)+result).store(forces+4*j);
+                            }
                             if (includeEnergy)
                                 threadEnergy[threadIndex] -= chargeProdOverR*erfAlphaR;
                         }
@@ -467,24 +557,31 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
                             float emult = C6ij*inverseR2*inverseR2*inverseR2*exptermsApprox(r);
                             if(includeEnergy)
                                 threadEnergy[threadIndex] += emult;
-                            float dEdR = -6.0f*C6ij*inverseR2*inverseR2*inverseR2*inverseR2*dExptermsApprox(r);
-                            fvec4 result = deltaR*dEdR;
-                            (fvec4(forces+4*i)-result).store(forces+4*i);
-                            (fvec4(forces+4*j)+result).store(forces+4*j);
+                            if (includeForces) {
+                                float dEdR = -6.0f*C6ij*inverseR2*inverseR2*inverseR2*inverseR2*dExptermsApprox(r);
+                                fvec4 result = deltaR*dEdR;
+                                (fvec4(forces+4*i)-result).store(forces+4*i);
+                                (fvec4(forces+4*j)+result).store(forces+4*j);
+                            }
                         }
                     }
                 }
             }
+            if (deterministic)
+                start += groupSize*numThreads;
         }
     }
     else {
         // Compute the interactions from the neighbor list.
 
         while (true) {
-            int nextBlock = atomicCounter++;
-            if (nextBlock >= neighborList->getNumBlocks())
+            if (!deterministic)
+                nextBlock = atomicCounter++;
+            if (nextBlock >= endBlock)
                 break;
             calculateBlockIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
+            if (deterministic)
+                nextBlock++;
         }
     }
 }
@@ -31,12 +31,23 @@ using namespace OpenMM;
 CpuNonbondedForce* createCpuNonbondedForceVec4(const CpuNeighborList& neighbors);
 CpuNonbondedForce* createCpuNonbondedForceAvx(const CpuNeighborList& neighbors);
 CpuNonbondedForce* createCpuNonbondedForceAvx2(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceAvx512(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceNeon(const CpuNeighborList& neighbors);
 
 bool isAvx2Supported();
+bool isNeonVec8Supported();
 
 #include <iostream>
 
 CpuNonbondedForce* createCpuNonbondedForceVec(const CpuNeighborList& neighbors) {
+    // The vector width must match the neighbor list's block size.  The platform only builds
+    // 16 atom blocks when AVX-512 is available, and 8 atom blocks on ARM when it can use
+    // pairs of NEON registers.
+
+    if (neighbors.getBlockSize() == 16)
+        return createCpuNonbondedForceAvx512(neighbors);
+    if (neighbors.getBlockSize() == 8 && isNeonVec8Supported())
+        return createCpuNonbondedForceNeon(neighbors);
     if (isAvx2Supported())
         return createCpuNonbondedForceAvx2(neighbors);
     else if (isAvxSupported())
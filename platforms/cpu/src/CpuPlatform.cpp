@@ -32,18 +32,29 @@
 #include "CpuPlatform.h"
 #include "CpuKernelFactory.h"
 #include "CpuKernels.h"
+#include "CpuCCMA.h"
+#include "CpuLINCS.h"
 #include "CpuSETTLE.h"
 #include "ReferenceConstraints.h"
+#include "openmm/CustomNonbondedForce.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/hardware.h"
 #include "openmm/internal/vectorize.h"
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <stdlib.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 using namespace OpenMM;
 using namespace std;
 
+bool isAvx512Supported();
+bool isNeonVec8Supported();
+
 #ifdef OPENMM_CPU_BUILDING_STATIC_LIBRARY
 extern "C" void registerCpuPlatform() {
     if (CpuPlatform::isProcessorSupported())
@@ -64,9 +75,17 @@ CpuPlatform::CpuPlatform() {
     deprecatedPropertyReplacements["CpuThreads"] = CpuThreads();
     CpuKernelFactory* factory = new CpuKernelFactory();
     registerKernelFactory(CalcForcesAndEnergyKernel::Name(), factory);
+    registerKernelFactory(CalcHarmonicBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomAngleForceKernel::Name(), factory);
     registerKernelFactory(CalcPeriodicTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcRBTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCMAPTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCentroidBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCompoundBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomExternalForceKernel::Name(), factory);
     registerKernelFactory(CalcNonbondedForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomNonbondedForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
@@ -75,8 +94,16 @@ CpuPlatform::CpuPlatform() {
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
-    platformProperties.push_back(CpuThreads());
+    registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateCustomStepKernel::Name(), factory);
     platformProperties.push_back(CpuDeterministicForces());
+    platformProperties.push_back(CpuPinThreads());
+    platformProperties.push_back(CpuPmeThreads());
+    platformProperties.push_back(CpuSharedThreadPool());
+    platformProperties.push_back(CpuSpecializeGlobalParameters());
+    platformProperties.push_back(CpuTabulateCustomNonbondedForces());
+    platformProperties.push_back(CpuConstraintAlgorithm());
     int threads = getNumProcessors();
     char* threadsEnv = getenv("OPENMM_CPU_THREADS");
     if (threadsEnv != NULL)
@@ -85,6 +112,12 @@ CpuPlatform::CpuPlatform() {
     defaultThreads << threads;
     setPropertyDefaultValue(CpuThreads(), defaultThreads.str());
     setPropertyDefaultValue(CpuDeterministicForces(), "false");
+    setPropertyDefaultValue(CpuPinThreads(), "false");
+    setPropertyDefaultValue(CpuPmeThreads(), defaultThreads.str());
+    setPropertyDefaultValue(CpuSharedThreadPool(), "false");
+    setPropertyDefaultValue(CpuSpecializeGlobalParameters(), "false");
+    setPropertyDefaultValue(CpuTabulateCustomNonbondedForces(), "false");
+    setPropertyDefaultValue(CpuConstraintAlgorithm(), "CCMA");
 }
 
 const string& CpuPlatform::getPropertyValue(const Context& context, const string& property) const {
@@ -112,23 +145,90 @@ bool CpuPlatform::isProcessorSupported() {
 }
 
 void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
-    ReferencePlatform::contextCreated(context, properties);
+    // The CPU platform has its own implementations of every force the Reference kernels can divide
+    // between threads, so there is no need to create a second ThreadPool for them.
+
+    map<string, string> referenceProperties = properties;
+    referenceProperties[ReferenceThreads()] = "1";
+    ReferencePlatform::contextCreated(context, referenceProperties);
     const string& threadsPropValue = (properties.find(CpuThreads()) == properties.end() ?
             getPropertyDefaultValue(CpuThreads()) : properties.find(CpuThreads())->second);
     string deterministicForcesValue = (properties.find(CpuDeterministicForces()) == properties.end() ?
             getPropertyDefaultValue(CpuDeterministicForces()) : properties.find(CpuDeterministicForces())->second);
     int numThreads;
     stringstream(threadsPropValue) >> numThreads;
+    string pinThreadsValue = (properties.find(CpuPinThreads()) == properties.end() ?
+            getPropertyDefaultValue(CpuPinThreads()) : properties.find(CpuPinThreads())->second);
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
+    string sharedThreadsValue = (properties.find(CpuSharedThreadPool()) == properties.end() ?
+            getPropertyDefaultValue(CpuSharedThreadPool()) : properties.find(CpuSharedThreadPool())->second);
+    transform(pinThreadsValue.begin(), pinThreadsValue.end(), pinThreadsValue.begin(), ::tolower);
+    string specializeGlobalsValue = (properties.find(CpuSpecializeGlobalParameters()) == properties.end() ?
+            getPropertyDefaultValue(CpuSpecializeGlobalParameters()) : properties.find(CpuSpecializeGlobalParameters())->second);
+    string tabulateValue = (properties.find(CpuTabulateCustomNonbondedForces()) == properties.end() ?
+            getPropertyDefaultValue(CpuTabulateCustomNonbondedForces()) : properties.find(CpuTabulateCustomNonbondedForces())->second);
+    transform(sharedThreadsValue.begin(), sharedThreadsValue.end(), sharedThreadsValue.begin(), ::tolower);
+    transform(specializeGlobalsValue.begin(), specializeGlobalsValue.end(), specializeGlobalsValue.begin(), ::tolower);
+    transform(tabulateValue.begin(), tabulateValue.end(), tabulateValue.begin(), ::tolower);
     bool deterministicForces = (deterministicForcesValue == "true");
-    PlatformData* data = new PlatformData(context.getSystem().getNumParticles(), numThreads, deterministicForces);
+    bool pinThreads = (pinThreadsValue == "true");
+    bool sharedThreads = (sharedThreadsValue == "true");
+    bool specializeGlobals = (specializeGlobalsValue == "true");
+    bool tabulateCustomNonbonded = (tabulateValue == "true");
+    string constraintAlgorithm = (properties.find(CpuConstraintAlgorithm()) == properties.end() ?
+            getPropertyDefaultValue(CpuConstraintAlgorithm()) : properties.find(CpuConstraintAlgorithm())->second);
+    transform(constraintAlgorithm.begin(), constraintAlgorithm.end(), constraintAlgorithm.begin(), ::toupper);
+    if (constraintAlgorithm != "CCMA" && constraintAlgorithm != "LINCS")
+        throw OpenMMException("Illegal value for ConstraintAlgorithm: "+constraintAlgorithm);
+    int numPmeThreads = 0;
+    if (properties.find(CpuPmeThreads()) != properties.end()) {
+        stringstream(properties.find(CpuPmeThreads())->second) >> numPmeThreads;
+        if (numPmeThreads < 1)
+            throw OpenMMException("PmeThreads must be at least 1");
+    }
+    PlatformData* data = new PlatformData(context.getSystem().getNumParticles(), numThreads, deterministicForces, pinThreads, sharedThreads, specializeGlobals, tabulateCustomNonbonded);
     contextData[&context] = data;
+    if (numPmeThreads == 0)
+        numPmeThreads = data->threads.getNumThreads();
+    stringstream pmeThreadsProperty;
+    pmeThreadsProperty << numPmeThreads;
+    data->propertyValues[CpuPmeThreads()] = pmeThreadsProperty.str();
+    data->propertyValues[CpuConstraintAlgorithm()] = constraintAlgorithm;
+    for (int i = 0; i < context.getSystem().getNumParticles(); i++)
+        if (context.getSystem().isVirtualSite(i)) {
+            data->virtualSites = new CpuVirtualSites(context.getSystem(), data->threads);
+            break;
+        }
+
+    // Use 16 atom neighbor blocks if the CPU supports AVX-512, or 8 atom blocks on ARM.  A
+    // CustomNonbondedForce shares the neighbor list, but its compiled vector expressions only
+    // support the width returned by getVectorWidth(), so in that case we keep the default.
+
+    bool anyCustomNonbonded = false;
+    for (int i = 0; i < context.getSystem().getNumForces(); i++)
+        if (dynamic_cast<const CustomNonbondedForce*>(&context.getSystem().getForce(i)) != NULL)
+            anyCustomNonbonded = true;
+    if (!anyCustomNonbonded) {
+        if (isAvx512Supported())
+            data->neighborBlockSize = 16;
+        else if (isNeonVec8Supported())
+            data->neighborBlockSize = 8;
+    }
     ReferenceConstraints& constraints = *(ReferenceConstraints*) reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData())->constraints;
     if (constraints.settle != NULL) {
         CpuSETTLE* parallelSettle = new CpuSETTLE(context.getSystem(), *(ReferenceSETTLEAlgorithm*) constraints.settle, data->threads);
         delete constraints.settle;
         constraints.settle = parallelSettle;
     }
+    if (constraints.ccma != NULL) {
+        ReferenceConstraintAlgorithm* parallelCCMA;
+        if (constraintAlgorithm == "LINCS")
+            parallelCCMA = new CpuLINCS(*(ReferenceCCMAAlgorithm*) constraints.ccma, data->threads);
+        else
+            parallelCCMA = new CpuCCMA(*(ReferenceCCMAAlgorithm*) constraints.ccma, data->threads);
+        delete constraints.ccma;
+        constraints.ccma = parallelCCMA;
+    }
 }
 
 void CpuPlatform::contextDestroyed(ContextImpl& context) const {
@@ -147,28 +247,90 @@ const CpuPlatform::PlatformData& CpuPlatform::getPlatformData(const ContextImpl&
     return *contextData[&context];
 }
 
-CpuPlatform::PlatformData::PlatformData(int numParticles, int numThreads, bool deterministicForces) : posq(4*numParticles), threads(numThreads),
-        deterministicForces(deterministicForces), numParticles(numParticles), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0), anyExclusions(false),
-        currentPosqIndex(-1), nextPosqIndex(0) {
+/**
+ * Bind the calling thread to one logical core.  The index selects among the cores in the
+ * process's affinity mask, wrapping around if there are more threads than cores.
+ */
+static void pinCurrentThread(int index) {
+#ifdef __linux__
+    cpu_set_t available;
+    if (sched_getaffinity(0, sizeof(available), &available) != 0)
+        return;
+    int numAvailable = CPU_COUNT(&available);
+    if (numAvailable == 0)
+        return;
+    int target = index%numAvailable;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &available) && target-- == 0) {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            CPU_SET(cpu, &mask);
+            pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+            return;
+        }
+    }
+#endif
+}
+
+/**
+ * Get a ThreadPool for a Context.  Shared pools are kept in a table indexed by the number of threads,
+ * and live as long as any Context is using them.
+ */
+static shared_ptr<ThreadPool> createThreadPool(int numThreads, bool shared) {
+    if (!shared)
+        return make_shared<ThreadPool>(numThreads);
+    static mutex poolsLock;
+    static map<int, weak_ptr<ThreadPool> > sharedPools;
+    lock_guard<mutex> guard(poolsLock);
+    shared_ptr<ThreadPool> pool = sharedPools[numThreads].lock();
+    if (!pool) {
+        pool = make_shared<ThreadPool>(numThreads);
+        pool->setShared(true);
+        sharedPools[numThreads] = pool;
+    }
+    return pool;
+}
+
+CpuPlatform::PlatformData::PlatformData(int numParticles, int numThreads, bool deterministicForces, bool pinThreads, bool sharedThreads, bool specializeGlobals, bool tabulateCustomNonbonded) : posq(4*numParticles),
+        threadPool(createThreadPool(numThreads, sharedThreads)), threads(*threadPool), deterministicForces(deterministicForces), pinThreads(pinThreads), sharedThreads(sharedThreads), specializeGlobals(specializeGlobals), tabulateCustomNonbonded(tabulateCustomNonbonded), numParticles(numParticles), neighborList(NULL), virtualSites(NULL), neighborBlockSize(getVectorWidth()), cutoff(0.0), paddedCutoff(0.0),
+        anyExclusions(false), currentPosqIndex(-1), nextPosqIndex(0) {
     numThreads = threads.getNumThreads();
+
+    // Each thread allocates and clears its own force buffer, so the memory is first touched,
+    // and therefore placed, on the NUMA node of the thread that uses it.
+
     threadForce.resize(numThreads);
-    for (int i = 0; i < numThreads; i++)
-        threadForce[i].resize(4*numParticles);
+    threadForceModified = false;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        if (pinThreads)
+            pinCurrentThread(threadIndex);
+        AlignedArray<float>& forces = threadForce[threadIndex];
+        forces.resize(4*numParticles);
+        for (int i = 0; i < 4*numParticles; i++)
+            forces[i] = 0.0f;
+    });
+    threads.waitForThreads();
     isPeriodic = false;
     stringstream threadsProperty;
     threadsProperty << numThreads;
     propertyValues[CpuThreads()] = threadsProperty.str();
     propertyValues[CpuDeterministicForces()] = deterministicForces ? "true" : "false";
+    propertyValues[CpuPinThreads()] = pinThreads ? "true" : "false";
+    propertyValues[CpuSharedThreadPool()] = sharedThreads ? "true" : "false";
+    propertyValues[CpuSpecializeGlobalParameters()] = specializeGlobals ? "true" : "false";
+    propertyValues[CpuTabulateCustomNonbondedForces()] = tabulateCustomNonbonded ? "true" : "false";
 }
 
 CpuPlatform::PlatformData::~PlatformData() {
     if (neighborList != NULL)
         delete neighborList;
+    if (virtualSites != NULL)
+        delete virtualSites;
 }
 
-void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const vector<set<int> >& exclusionList) {
+void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const CpuExclusionList& exclusionList) {
     if (neighborList == NULL) {
-        neighborList = new CpuNeighborList(getVectorWidth());
+        neighborList = new CpuNeighborList(neighborBlockSize);
         if (cutoffDistance == 0.0)
             neighborList->createDenseNeighborList(numParticles, exclusionList);
     }
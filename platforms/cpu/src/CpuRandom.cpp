@@ -34,8 +34,8 @@ CpuRandom::CpuRandom() : hasInitialized(false) {
 }
 
 CpuRandom::~CpuRandom() {
-    for (auto random : threadRandom)
-        delete random;
+    for (auto data : threadData)
+        delete data;
 }
 
 void CpuRandom::initialize(int seed, int numThreads) {
@@ -46,9 +46,7 @@ void CpuRandom::initialize(int seed, int numThreads) {
     }
     randomSeed = seed;
     hasInitialized = true;
-    threadRandom.resize(numThreads);
-    nextGaussian.resize(numThreads);
-    nextGaussianIsValid.resize(numThreads, false);
+    threadData.resize(numThreads);
 
     /* Use a quick and dirty RNG to pick seeds for the real random number generator.
      * A random seed of 0 means pick a unique seed
@@ -59,31 +57,29 @@ void CpuRandom::initialize(int seed, int numThreads) {
         r = (unsigned int) osrngseed();
     for (int i = 0; i < numThreads; i++) {
         r = (1664525*r + 1013904223) & 0xFFFFFFFF;
-        threadRandom[i] = new OpenMM_SFMT::SFMT();
-        init_gen_rand(r, *threadRandom[i]);
+        threadData[i] = new ThreadData();
+        init_gen_rand(r, threadData[i]->sfmt);
+        threadData[i]->nextGaussian = GaussianBufferSize;
     }
 }
 
-float CpuRandom::getGaussianRandom(int threadIndex) {
-    if (nextGaussianIsValid[threadIndex]) {
-        nextGaussianIsValid[threadIndex] = false;
-        return nextGaussian[threadIndex];
+void CpuRandom::fillGaussianBuffer(ThreadData& data) {
+    // Use the polar form of the Box-Muller transformation to generate pairs of Gaussian random numbers.
+
+    for (int i = 0; i < GaussianBufferSize; i += 2) {
+        float x, y, r2;
+        do {
+            x = 2.0f*(float) genrand_real2(data.sfmt)-1.0f;
+            y = 2.0f*(float) genrand_real2(data.sfmt)-1.0f;
+            r2 = x*x + y*y;
+        } while (r2 >= 1.0f || r2 == 0.0f);
+        float multiplier = sqrtf((-2.0f*logf(r2))/r2);
+        data.gaussians[i] = x*multiplier;
+        data.gaussians[i+1] = y*multiplier;
     }
-    
-    // Use the polar form of the Box-Muller transformation to generate two Gaussian random numbers.
-    
-    float x, y, r2;
-    do {
-        x = 2.0f*(float) genrand_real2(*threadRandom[threadIndex])-1.0f;
-        y = 2.0f*(float) genrand_real2(*threadRandom[threadIndex])-1.0f;
-        r2 = x*x + y*y;
-    } while (r2 >= 1.0f || r2 == 0.0f);
-    float multiplier = sqrtf((-2.0f*logf(r2))/r2);
-    nextGaussian[threadIndex] = y*multiplier;
-    nextGaussianIsValid[threadIndex] = true;
-    return x*multiplier;
+    data.nextGaussian = 0;
 }
 
 float CpuRandom::getUniformRandom(int threadIndex) {
-    return genrand_real2(*threadRandom[threadIndex]);
+    return genrand_real2(threadData[threadIndex]->sfmt);
 }
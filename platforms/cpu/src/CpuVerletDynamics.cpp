@@ -0,0 +1,65 @@
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: agent
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuVerletDynamics.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuVerletDynamics::CpuVerletDynamics(int numberOfAtoms, double deltaT, ThreadPool& threads) :
+           ReferenceVerletDynamics(numberOfAtoms, deltaT), threads(threads) {
+}
+
+CpuVerletDynamics::~CpuVerletDynamics() {
+}
+
+void CpuVerletDynamics::updatePart1(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                    vector<Vec3>& forces, vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        const double dt = getDeltaT();
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0) {
+                velocities[i] += (inverseMasses[i]*dt)*forces[i];
+                xPrime[i] = atomCoordinates[i] + velocities[i]*dt;
+            }
+    });
+    threads.waitForThreads();
+}
+
+void CpuVerletDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                    vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        const double velocityScale = 1.0/getDeltaT();
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0) {
+                velocities[i] = (xPrime[i]-atomCoordinates[i])*velocityScale;
+                atomCoordinates[i] = xPrime[i];
+            }
+    });
+    threads.waitForThreads();
+}
@@ -0,0 +1,225 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuVirtualSites.h"
+#include "openmm/VirtualSite.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <numeric>
+
+using namespace OpenMM;
+using namespace std;
+
+static int findRoot(vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+CpuVirtualSites::CpuVirtualSites(const System& system, ThreadPool& threads) : threads(threads) {
+    int numParticles = system.getNumParticles();
+    vector<int> sites;
+    for (int i = 0; i < numParticles; i++)
+        if (system.isVirtualSite(i))
+            sites.push_back(i);
+
+    // A site's level is one more than the highest level of any virtual site it is based on.
+
+    vector<int> siteLevel(numParticles, 0);
+    bool changed = true;
+    for (int pass = 0; changed && pass < (int) sites.size(); pass++) {
+        changed = false;
+        for (int i : sites) {
+            const VirtualSite& site = system.getVirtualSite(i);
+            for (int j = 0; j < site.getNumParticles(); j++) {
+                int p = site.getParticle(j);
+                if (system.isVirtualSite(p) && siteLevel[i] <= siteLevel[p]) {
+                    siteLevel[i] = siteLevel[p]+1;
+                    changed = true;
+                }
+            }
+        }
+    }
+    int numLevels = 0;
+    for (int i : sites)
+        numLevels = max(numLevels, siteLevel[i]+1);
+    levels.resize(numLevels);
+
+    // Within each level, find clusters of sites that share particles, then divide the clusters
+    // into blocks with roughly equal numbers of sites.
+
+    int numBlocks = 10*threads.getNumThreads();
+    vector<int> parent(numParticles);
+    for (int level = 0; level < numLevels; level++) {
+        iota(parent.begin(), parent.end(), 0);
+        vector<int> levelSites;
+        for (int i : sites)
+            if (siteLevel[i] == level) {
+                levelSites.push_back(i);
+                const VirtualSite& site = system.getVirtualSite(i);
+                int root = findRoot(parent, site.getParticle(0));
+                for (int j = 1; j < site.getNumParticles(); j++)
+                    parent[findRoot(parent, site.getParticle(j))] = root;
+            }
+        map<int, int> clusterIndex;
+        vector<vector<int> > clusters;
+        for (int i : levelSites) {
+            int root = findRoot(parent, system.getVirtualSite(i).getParticle(0));
+            if (clusterIndex.find(root) == clusterIndex.end()) {
+                clusterIndex[root] = clusters.size();
+                clusters.push_back(vector<int>());
+            }
+            clusters[clusterIndex[root]].push_back(i);
+        }
+        int numLevelSites = levelSites.size();
+        int sitesInBlocks = 0, sitesInCurrentBlock = 0;
+        levels[level].push_back(SiteBlock());
+        for (auto& cluster : clusters) {
+            if (sitesInCurrentBlock > 0 && sitesInBlocks >= (long long) levels[level].size()*numLevelSites/numBlocks) {
+                levels[level].push_back(SiteBlock());
+                sitesInCurrentBlock = 0;
+            }
+            SiteBlock& block = levels[level].back();
+            for (int i : cluster) {
+                const VirtualSite& site = system.getVirtualSite(i);
+                if (dynamic_cast<const TwoParticleAverageSite*>(&site) != NULL) {
+                    const TwoParticleAverageSite& s = dynamic_cast<const TwoParticleAverageSite&>(site);
+                    block.twoParticle.push_back({i, s.getParticle(0), s.getParticle(1), s.getWeight(0), s.getWeight(1)});
+                }
+                else if (dynamic_cast<const ThreeParticleAverageSite*>(&site) != NULL) {
+                    const ThreeParticleAverageSite& s = dynamic_cast<const ThreeParticleAverageSite&>(site);
+                    block.threeParticle.push_back({i, s.getParticle(0), s.getParticle(1), s.getParticle(2), s.getWeight(0), s.getWeight(1), s.getWeight(2)});
+                }
+                else if (dynamic_cast<const OpenMM::OutOfPlaneSite*>(&site) != NULL) {
+                    const OpenMM::OutOfPlaneSite& s = dynamic_cast<const OpenMM::OutOfPlaneSite&>(site);
+                    block.outOfPlane.push_back({i, s.getParticle(0), s.getParticle(1), s.getParticle(2), s.getWeight12(), s.getWeight13(), s.getWeightCross()});
+                }
+                else if (dynamic_cast<const OpenMM::LocalCoordinatesSite*>(&site) != NULL) {
+                    const OpenMM::LocalCoordinatesSite& s = dynamic_cast<const OpenMM::LocalCoordinatesSite&>(site);
+                    LocalCoordinatesParams params;
+                    params.site = i;
+                    for (int j = 0; j < s.getNumParticles(); j++)
+                        params.particles.push_back(s.getParticle(j));
+                    s.getOriginWeights(params.originWeights);
+                    s.getXWeights(params.xWeights);
+                    s.getYWeights(params.yWeights);
+                    params.localPosition = s.getLocalPosition();
+                    block.localCoordinates.push_back(params);
+                }
+            }
+            sitesInBlocks += cluster.size();
+            sitesInCurrentBlock += cluster.size();
+        }
+    }
+}
+
+void CpuVirtualSites::computeSitePositions(const System& system, vector<Vec3>& atomCoordinates) {
+    for (auto& blocks : levels) {
+        atomic<int> atomicCounter;
+        atomicCounter = 0;
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            while (true) {
+                int index = atomicCounter++;
+                if (index >= blocks.size())
+                    break;
+                computeBlockPositions(blocks[index], atomCoordinates);
+            }
+        });
+        threads.waitForThreads();
+    }
+}
+
+void CpuVirtualSites::distributeSiteForces(const vector<Vec3>& atomCoordinates, vector<Vec3>& forces) {
+    for (int level = (int) levels.size()-1; level >= 0; level--) {
+        auto& blocks = levels[level];
+        atomic<int> atomicCounter;
+        atomicCounter = 0;
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            while (true) {
+                int index = atomicCounter++;
+                if (index >= blocks.size())
+                    break;
+                distributeBlockForces(blocks[index], atomCoordinates, forces);
+            }
+        });
+        threads.waitForThreads();
+    }
+}
+
+void CpuVirtualSites::computeBlockPositions(const SiteBlock& block, vector<Vec3>& atomCoordinates) {
+    for (const TwoParticleAverageParams& s : block.twoParticle)
+        atomCoordinates[s.site] = atomCoordinates[s.p1]*s.w1 + atomCoordinates[s.p2]*s.w2;
+    for (const ThreeParticleAverageParams& s : block.threeParticle)
+        atomCoordinates[s.site] = atomCoordinates[s.p1]*s.w1 + atomCoordinates[s.p2]*s.w2 + atomCoordinates[s.p3]*s.w3;
+    for (const OutOfPlaneParams& s : block.outOfPlane) {
+        Vec3 v12 = atomCoordinates[s.p2]-atomCoordinates[s.p1];
+        Vec3 v13 = atomCoordinates[s.p3]-atomCoordinates[s.p1];
+        Vec3 cross = v12.cross(v13);
+        atomCoordinates[s.site] = atomCoordinates[s.p1] + v12*s.w12 + v13*s.w13 + cross*s.wcross;
+    }
+    for (const LocalCoordinatesParams& s : block.localCoordinates)
+        atomCoordinates[s.site] = computeLocalCoordinatesPosition(s.particles.size(), &s.particles[0], &s.originWeights[0], &s.xWeights[0],
+                &s.yWeights[0], s.localPosition, atomCoordinates);
+}
+
+void CpuVirtualSites::distributeBlockForces(const SiteBlock& block, const vector<Vec3>& atomCoordinates, vector<Vec3>& forces) {
+    for (const TwoParticleAverageParams& s : block.twoParticle) {
+        Vec3 f = forces[s.site];
+        forces[s.p1] += f*s.w1;
+        forces[s.p2] += f*s.w2;
+    }
+    for (const ThreeParticleAverageParams& s : block.threeParticle) {
+        Vec3 f = forces[s.site];
+        forces[s.p1] += f*s.w1;
+        forces[s.p2] += f*s.w2;
+        forces[s.p3] += f*s.w3;
+    }
+    for (const OutOfPlaneParams& s : block.outOfPlane) {
+        Vec3 f = forces[s.site];
+        Vec3 v12 = atomCoordinates[s.p2]-atomCoordinates[s.p1];
+        Vec3 v13 = atomCoordinates[s.p3]-atomCoordinates[s.p1];
+        Vec3 f2(s.w12*f[0] - s.wcross*v13[2]*f[1] + s.wcross*v13[1]*f[2],
+                s.wcross*v13[2]*f[0] + s.w12*f[1] - s.wcross*v13[0]*f[2],
+               -s.wcross*v13[1]*f[0] + s.wcross*v13[0]*f[1] + s.w12*f[2]);
+        Vec3 f3(s.w13*f[0] + s.wcross*v12[2]*f[1] - s.wcross*v12[1]*f[2],
+               -s.wcross*v12[2]*f[0] + s.w13*f[1] + s.wcross*v12[0]*f[2],
+                s.wcross*v12[1]*f[0] - s.wcross*v12[0]*f[1] + s.w13*f[2]);
+        forces[s.p1] += f-f2-f3;
+        forces[s.p2] += f2;
+        forces[s.p3] += f3;
+    }
+    for (const LocalCoordinatesParams& s : block.localCoordinates)
+        distributeLocalCoordinatesForce(forces[s.site], s.particles.size(), &s.particles[0], &s.originWeights[0], &s.xWeights[0],
+                &s.yWeights[0], s.localPosition, atomCoordinates, forces);
+}
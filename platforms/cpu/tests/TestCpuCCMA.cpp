@@ -0,0 +1,200 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "ReferenceCCMAAlgorithm.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void buildChains(System& system, vector<Vec3>& positions) {
+    const int numMolecules = 100;
+    const int atomsPerMolecule = 6;
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    system.addForce(angles);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        int first = i*atomsPerMolecule;
+        Vec3 origin(3*(i%5), 3*((i/5)%5), 3*(i/25));
+        for (int j = 0; j < atomsPerMolecule; j++) {
+            system.addParticle(j%3 == 0 ? 12.0 : 1.0);
+            positions.push_back(origin+Vec3(0.0866*j, 0.05*(j%2), 0.01*genrand_real2(sfmt)));
+        }
+        for (int j = 1; j < atomsPerMolecule; j++) {
+            system.addConstraint(first+j-1, first+j, 0.1);
+            bonds->addBond(first+j-1, first+j, 0.1, 1000.0);
+        }
+        for (int j = 2; j < atomsPerMolecule; j++)
+            angles->addAngle(first+j-2, first+j-1, first+j, 2.0, 100.0);
+    }
+}
+
+void testParallelConstraints() {
+    // Build a set of chain molecules where every bond is constrained, so that
+    // CCMA has a nontrivial coupling matrix, and make sure the CPU and Reference
+    // platforms produce the same trajectory.
+
+    System system;
+    vector<Vec3> positions;
+    buildChains(system, positions);
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    integrator1.setConstraintTolerance(1e-8);
+    integrator2.setConstraintTolerance(1e-8);
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, Platform::getPlatformByName("Reference"));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context1.applyConstraints(1e-8);
+    context2.applyConstraints(1e-8);
+    context1.setVelocitiesToTemperature(300.0, 1);
+    context2.setVelocities(context1.getState(State::Velocities).getVelocities());
+    integrator1.step(20);
+    integrator2.step(20);
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    State state2 = context2.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int atom1, atom2;
+        double distance;
+        system.getConstraintParameters(i, atom1, atom2, distance);
+        Vec3 delta = state1.getPositions()[atom1]-state1.getPositions()[atom2];
+        ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-6);
+    }
+    for (int i = 0; i < system.getNumParticles(); i++) {
+        ASSERT_EQUAL_VEC(state2.getPositions()[i], state1.getPositions()[i], 1e-4);
+        ASSERT_EQUAL_VEC(state2.getVelocities()[i], state1.getVelocities()[i], 1e-3);
+    }
+}
+
+void testLincs() {
+    // LINCS only satisfies the constraints approximately, but it should stay close
+    // to the trajectory computed with CCMA.
+
+    System system;
+    vector<Vec3> positions;
+    buildChains(system, positions);
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    integrator2.setConstraintTolerance(1e-8);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuConstraintAlgorithm()] = "LINCS";
+    Context context1(system, integrator1, platform, properties);
+    Context context2(system, integrator2, Platform::getPlatformByName("Reference"));
+    ASSERT_EQUAL("LINCS", platform.getPropertyValue(context1, CpuPlatform::CpuConstraintAlgorithm()));
+    context2.setPositions(positions);
+    context2.applyConstraints(1e-8);
+    context2.setVelocitiesToTemperature(300.0, 1);
+    State initial = context2.getState(State::Positions | State::Velocities);
+    context1.setPositions(initial.getPositions());
+    context1.setVelocities(initial.getVelocities());
+    integrator1.step(20);
+    integrator2.step(20);
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    State state2 = context2.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int atom1, atom2;
+        double distance;
+        system.getConstraintParameters(i, atom1, atom2, distance);
+        Vec3 delta = state1.getPositions()[atom1]-state1.getPositions()[atom2];
+        ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-4);
+    }
+    for (int i = 0; i < system.getNumParticles(); i++) {
+        ASSERT_EQUAL_VEC(state2.getPositions()[i], state1.getPositions()[i], 1e-3);
+        ASSERT_EQUAL_VEC(state2.getVelocities()[i], state1.getVelocities()[i], 1e-2);
+    }
+
+    // An unknown algorithm should be rejected.
+
+    properties[CpuPlatform::CpuConstraintAlgorithm()] = "SHAKE";
+    VerletIntegrator integrator3(0.001);
+    bool threwException = false;
+    try {
+        Context context3(system, integrator3, platform, properties);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testCachedMatrix() {
+    // Creating a second ReferenceCCMAAlgorithm for the same constraints should reuse the
+    // inverse matrix, and changing any input should produce a new one.
+
+    const int numAtoms = 5;
+    vector<pair<int, int> > indices;
+    vector<double> distances;
+    for (int i = 1; i < numAtoms; i++) {
+        indices.push_back(make_pair(i-1, i));
+        distances.push_back(0.1);
+    }
+    vector<double> masses = {12.0, 1.0, 1.0, 12.0, 1.0};
+    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
+    for (int i = 2; i < numAtoms; i++)
+        angles.push_back(ReferenceCCMAAlgorithm::AngleInfo(i-2, i-1, i, 2.0));
+    ReferenceCCMAAlgorithm::clearMatrixCache();
+    ReferenceCCMAAlgorithm ccma1(numAtoms, indices.size(), indices, distances, masses, angles, 0.02);
+    ReferenceCCMAAlgorithm ccma2(numAtoms, indices.size(), indices, distances, masses, angles, 0.02);
+    ASSERT(ccma1.getMatrix() == ccma2.getMatrix());
+    masses[1] = 2.0;
+    ReferenceCCMAAlgorithm ccma3(numAtoms, indices.size(), indices, distances, masses, angles, 0.02);
+    ASSERT(ccma1.getMatrix() != ccma3.getMatrix());
+    ReferenceCCMAAlgorithm::clearMatrixCache();
+    masses[1] = 1.0;
+    ReferenceCCMAAlgorithm ccma4(numAtoms, indices.size(), indices, distances, masses, angles, 0.02);
+    ASSERT(ccma1.getMatrix() == ccma4.getMatrix());
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testParallelConstraints();
+        testLincs();
+        testCachedMatrix();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -31,6 +31,35 @@
 
 #include "CpuTests.h"
 #include "TestCompoundIntegrator.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+
+void testDifferentRandomSeeds() {
+    // Integrators with different random number seeds should be able to share a Context.
+
+    System system;
+    system.addParticle(1.0);
+    system.addParticle(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->addBond(0, 1, 1.0, 100.0);
+    system.addForce(bonds);
+    CompoundIntegrator integrator;
+    integrator.addIntegrator(new LangevinMiddleIntegrator(300.0, 1.0, 0.001));
+    integrator.addIntegrator(new CustomIntegrator(0.001));
+    integrator.addIntegrator(new BrownianIntegrator(300.0, 1.0, 0.001));
+    dynamic_cast<LangevinMiddleIntegrator&>(integrator.getIntegrator(0)).setRandomNumberSeed(5);
+    CustomIntegrator& custom = dynamic_cast<CustomIntegrator&>(integrator.getIntegrator(1));
+    custom.addComputePerDof("v", "v+dt*f/m");
+    custom.addComputePerDof("x", "x+dt*v");
+    dynamic_cast<BrownianIntegrator&>(integrator.getIntegrator(2)).setRandomNumberSeed(7);
+    Context context(system, integrator, platform);
+    context.setPositions({Vec3(0, 0, 0), Vec3(1.1, 0, 0)});
+    for (int i = 0; i < 3; i++) {
+        integrator.setCurrentIntegrator(i);
+        integrator.step(5);
+    }
+    ASSERT_EQUAL(15, context.getStepCount());
+}
 
 void runPlatformTests() {
+    testDifferentRandomSeeds();
 }
@@ -0,0 +1,87 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestCustomIntegrator.h"
+
+void addTestComputations(CustomIntegrator* integrator) {
+    integrator->addGlobalVariable("ke", 0);
+    integrator->addGlobalVariable("damping", 0.99);
+    integrator->addPerDofVariable("x1", 0);
+    integrator->addComputePerDof("v", "damping*v+0.5*dt*f/m");
+    integrator->addComputePerDof("x", "x+dt*v");
+    integrator->addComputePerDof("x1", "x");
+    integrator->addConstrainPositions();
+    integrator->addComputePerDof("v", "v+0.5*dt*f/m+(x-x1)/dt");
+    integrator->addComputeSum("ke", "0.5*m*v*v");
+}
+
+void testParallelComputation() {
+    // Run a deterministic integrator on both the CPU and Reference platforms, and make sure they agree.
+
+    const int numParticles = 500;
+    System system;
+    CustomExternalForce* force = new CustomExternalForce("k*(x^2+y^2+z^2)");
+    force->addPerParticleParameter("k");
+    system.addForce(force);
+    vector<Vec3> positions(numParticles);
+    vector<Vec3> velocities(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(i%10 == 0 ? 0.0 : 1.0+0.1*(i%7));
+        force->addParticle(i, {1.0+(i%5)});
+        positions[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*5;
+        velocities[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))-Vec3(0.5, 0.5, 0.5);
+    }
+    CustomIntegrator integrator1(0.001), integrator2(0.001);
+    addTestComputations(&integrator1);
+    addTestComputations(&integrator2);
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, Platform::getPlatformByName("Reference"));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context1.setVelocities(velocities);
+    context2.setVelocities(velocities);
+    integrator1.step(10);
+    integrator2.step(10);
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    State state2 = context2.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(state2.getPositions()[i], state1.getPositions()[i], 1e-6);
+        ASSERT_EQUAL_VEC(state2.getVelocities()[i], state1.getVelocities()[i], 1e-6);
+    }
+    ASSERT_EQUAL_TOL(integrator2.getGlobalVariableByName("ke"), integrator1.getGlobalVariableByName("ke"), 1e-6);
+}
+
+void runPlatformTests() {
+    testParallelComputation();
+}
@@ -32,5 +32,55 @@
 #include "CpuTests.h"
 #include "TestCustomManyParticleForce.h"
 
+void testLargeSystemTypeFilters(CustomManyParticleForce::PermutationMode mode) {
+    // Type filters allow partial sets of particles to be rejected early.  Make sure that gives the
+    // same results as the Reference platform.
+
+    int gridSize = 8;
+    int numParticles = gridSize*gridSize*gridSize;
+    double boxSize = 3.0;
+    double spacing = boxSize/gridSize;
+    CustomManyParticleForce* force = new CustomManyParticleForce(3, "(c1+c2+c3)*exp(-distance(p1,p2)-distance(p1,p3))*cos(angle(p2,p1,p3))");
+    force->addPerParticleParameter("c");
+    force->setPermutationMode(mode);
+    force->setNonbondedMethod(CustomManyParticleForce::CutoffPeriodic);
+    force->setCutoffDistance(0.6);
+    set<int> f1, f2;
+    f1.insert(0);
+    f2.insert(1);
+    f2.insert(2);
+    force->setTypeFilter(0, f1);
+    force->setTypeFilter(1, f2);
+    force->setTypeFilter(2, f2);
+    vector<Vec3> positions;
+    System system;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                int index = positions.size();
+                force->addParticle({1.0+0.1*(index%5)}, index%4);
+                positions.push_back(Vec3((i+0.4*genrand_real2(sfmt))*spacing, (j+0.4*genrand_real2(sfmt))*spacing, (k+0.4*genrand_real2(sfmt))*spacing));
+                system.addParticle(1.0);
+            }
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    system.addForce(force);
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context context1(system, integrator1, Platform::getPlatformByName("Reference"));
+    Context context2(system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT(state1.getPotentialEnergy() != 0.0);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-4);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+}
+
 void runPlatformTests() {
+    testLargeSystemTypeFilters(CustomManyParticleForce::SinglePermutation);
+    testLargeSystemTypeFilters(CustomManyParticleForce::UniqueCentralParticle);
 }
@@ -32,5 +32,98 @@
 #include "CpuTests.h"
 #include "TestCustomNonbondedForce.h"
 
+void testSpecializeGlobalParameters() {
+    // Folding global parameters into the expressions should not change the results, including
+    // after a parameter changes and for derivatives with respect to the parameters.
+
+    const int numParticles = 500;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomNonbondedForce* custom = new CustomNonbondedForce("lambda*4*eps*(x^2-x); x=1/(alpha*(1-lambda)+(r/sigma)^6); sigma=0.5*(s1+s2)");
+    custom->addPerParticleParameter("s");
+    custom->addGlobalParameter("lambda", 0.8);
+    custom->addGlobalParameter("alpha", 0.5);
+    custom->addGlobalParameter("eps", 0.8);
+    custom->addEnergyParameterDerivative("lambda");
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(1.0);
+    system.addForce(custom);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        custom->addParticle({i%2 == 0 ? 0.3 : 0.25});
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    map<string, string> properties;
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuSpecializeGlobalParameters()] = "true";
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("false", platform.getPropertyValue(context1, CpuPlatform::CpuSpecializeGlobalParameters()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuSpecializeGlobalParameters()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for (double lambda : {0.8, 0.5, 0.0}) {
+        context1.setParameter("lambda", lambda);
+        context2.setParameter("lambda", lambda);
+        State state1 = context1.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+        State state2 = context2.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        ASSERT_EQUAL_TOL(state1.getEnergyParameterDerivatives().at("lambda"), state2.getEnergyParameterDerivatives().at("lambda"), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+    }
+}
+
+void testTabulateEnergy() {
+    // Replacing an r-only energy with a spline should not change the results, including when the
+    // expression only becomes r-only after folding in global parameters.
+
+    const int numParticles = 500;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomNonbondedForce* custom = new CustomNonbondedForce("a*exp(-r/0.1)*erfc(2*r)+b*erfc(3*r)/(r+0.5)");
+    custom->addGlobalParameter("a", 10.0);
+    custom->addGlobalParameter("b", 2.0);
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(1.0);
+    system.addForce(custom);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        custom->addParticle();
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    map<string, string> properties;
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuSpecializeGlobalParameters()] = "true";
+    properties[CpuPlatform::CpuTabulateCustomNonbondedForces()] = "true";
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("false", platform.getPropertyValue(context1, CpuPlatform::CpuTabulateCustomNonbondedForces()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuTabulateCustomNonbondedForces()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for (double a : {10.0, 5.0}) {
+        context1.setParameter("a", a);
+        context2.setParameter("a", a);
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+    }
+}
+
 void runPlatformTests() {
+    testSpecializeGlobalParameters();
+    testTabulateEnergy();
 }
@@ -32,5 +32,26 @@
 #include "CpuTests.h"
 #include "TestEwald.h"
 
+void testUnsupportedPMEOrder() {
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    system.addParticle(1.0);
+    NonbondedForce* force = new NonbondedForce();
+    force->addParticle(1.0, 0.3, 1.0);
+    force->setNonbondedMethod(NonbondedForce::PME);
+    force->setPMEOrder(4);
+    system.addForce(force);
+    VerletIntegrator integrator(0.01);
+    bool threwException = false;
+    try {
+        Context context(system, integrator, platform);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
 void runPlatformTests() {
+    testUnsupportedPMEOrder();
 }
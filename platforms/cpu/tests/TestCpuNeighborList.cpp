@@ -48,6 +48,48 @@
 using namespace OpenMM;
 using namespace std;
 
+void checkNeighborList(const CpuNeighborList& neighborList, int numParticles, const AlignedArray<float>& positions, const vector<set<int> >& exclusions,
+        const Vec3* boxVectors, bool periodic, float cutoff) {
+    const int blockSize = neighborList.getBlockSize();
+    const float boxSize[3] = {(float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2]};
+
+    // Convert the neighbor list to a set for faster lookup.
+    
+    set<pair<int, int> > neighbors;
+    for (int i = 0; i < (int) neighborList.getSortedAtoms().size(); i++) {
+        int blockIndex = i/blockSize;
+        int indexInBlock = i-blockIndex*blockSize;
+        char mask = 1<<indexInBlock;
+        for (int j = 0; j < (int) neighborList.getBlockExclusions(blockIndex).size(); j++) {
+            if ((neighborList.getBlockExclusions(blockIndex)[j] & mask) == 0) {
+                int atom1 = neighborList.getSortedAtoms()[i];
+                int atom2 = neighborList.getBlockNeighbors(blockIndex)[j];
+                pair<int, int> entry = make_pair(min(atom1, atom2), max(atom1, atom2));
+                ASSERT(neighbors.find(entry) == neighbors.end() && neighbors.find(make_pair(entry.second, entry.first)) == neighbors.end()); // No duplicates
+                neighbors.insert(entry);
+            }
+        }
+    }
+    
+    // Check each particle pair and figure out whether they should be in the neighbor list.
+
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j <= i; j++) {
+            bool shouldInclude = (exclusions[i].find(j) == exclusions[i].end());
+            Vec3 diff(positions[4*i]-positions[4*j], positions[4*i+1]-positions[4*j+1], positions[4*i+2]-positions[4*j+2]);
+            if (periodic) {
+                diff -= boxVectors[2]*floor(diff[2]/boxSize[2]+0.5);
+                diff -= boxVectors[1]*floor(diff[1]/boxSize[1]+0.5);
+                diff -= boxVectors[0]*floor(diff[0]/boxSize[0]+0.5);
+            }
+            if (diff.dot(diff) > cutoff*cutoff)
+                shouldInclude = false;
+            bool isIncluded = (neighbors.find(make_pair(i, j)) != neighbors.end() || neighbors.find(make_pair(j, i)) != neighbors.end());
+            if (shouldInclude)
+                ASSERT(isIncluded);
+        }
+}
+
 void testNeighborList(bool periodic, bool triclinic) {
     const int numParticles = 500;
     const float cutoff = 2.0f;
@@ -78,45 +120,120 @@ void testNeighborList(bool periodic, bool triclinic) {
             exclusions[i-j].insert(i);
         }
     }
+    CpuExclusionList exclusionList(exclusions);
     ThreadPool threads;
     CpuNeighborList neighborList(blockSize);
-    neighborList.computeNeighborList(numParticles, positions, exclusions, boxVectors, periodic, cutoff, threads);
-    
-    // Convert the neighbor list to a set for faster lookup.
-    
+    neighborList.computeNeighborList(numParticles, positions, exclusionList, boxVectors, periodic, cutoff, threads);
+    checkNeighborList(neighborList, numParticles, positions, exclusions, boxVectors, periodic, cutoff);
+}
+
+void testIncrementalUpdate(bool periodic) {
+    const int numParticles = 500;
+    const float cutoff = 2.0f;
+    Vec3 boxVectors[3];
+    boxVectors[0] = Vec3(10, 0, 0);
+    boxVectors[1] = Vec3(0, 9, 0);
+    boxVectors[2] = Vec3(0, 0, 11);
+    const float boxSize[3] = {(float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2]};
+    const int blockSize = 8;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    AlignedArray<float> positions(4*numParticles);
+    for (int i = 0; i < 4*numParticles; i++)
+        if (i%4 < 3)
+            positions[i] = boxSize[i%4]*genrand_real2(sfmt);
+    vector<set<int> > exclusions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        int num = min(i+1, 4);
+        for (int j = 0; j < num; j++) {
+            exclusions[i].insert(i-j);
+            exclusions[i-j].insert(i);
+        }
+    }
+    CpuExclusionList exclusionList(exclusions);
+    ThreadPool threads;
+    CpuNeighborList neighborList(blockSize);
+    neighborList.computeNeighborList(numParticles, positions, exclusionList, boxVectors, periodic, cutoff, threads);
+
+    // Move a few atoms to new locations, some of them more than once, and check that the
+    // updated list contains every pair it should.
+
+    for (int iteration = 0; iteration < 5; iteration++) {
+        vector<int> moved;
+        for (int i = 0; i < 10; i++) {
+            int atom = (int) (numParticles*genrand_real2(sfmt));
+            if (find(moved.begin(), moved.end(), atom) != moved.end())
+                continue;
+            moved.push_back(atom);
+            for (int j = 0; j < 3; j++)
+                positions[4*atom+j] = boxSize[j]*genrand_real2(sfmt);
+        }
+        ASSERT(neighborList.updateNeighborList(positions, moved, boxVectors, cutoff));
+        checkNeighborList(neighborList, numParticles, positions, exclusions, boxVectors, periodic, cutoff);
+    }
+}
+
+void testExclusionList() {
+    const int numParticles = 50;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<pair<int, int> > pairs;
+    vector<set<int> > exclusions(numParticles);
+    for (int i = 0; i < 200; i++) {
+        int p1 = (int) (numParticles*genrand_real2(sfmt));
+        int p2 = (int) (numParticles*genrand_real2(sfmt));
+        pairs.push_back(make_pair(p1, p2));
+        exclusions[p1].insert(p2);
+        exclusions[p2].insert(p1);
+    }
+    CpuExclusionList list1(numParticles, pairs), list2(exclusions);
+    ASSERT(list1 == list2);
+    ASSERT_EQUAL(numParticles, list1.getNumAtoms());
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL(exclusions[i].size(), list1[i].size());
+        ASSERT(equal(exclusions[i].begin(), exclusions[i].end(), list1[i].begin()));
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL(exclusions[i].find(j) != exclusions[i].end(), list1.isExcluded(i, j));
+    }
+    ASSERT(CpuExclusionList(numParticles) != list1);
+}
+
+void testDenseNeighborList() {
+    const int numParticles = 37;
+    const int blockSize = 8;
+    vector<set<int> > exclusions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        for (int j = i+1; j < numParticles; j++)
+            if ((i*j)%7 == 1 || j-i == 20) {
+                exclusions[i].insert(j);
+                exclusions[j].insert(i);
+            }
+    CpuExclusionList exclusionList(exclusions);
+    CpuNeighborList neighborList(blockSize);
+    neighborList.createDenseNeighborList(numParticles, exclusionList);
+
+    // Every pair should be found exactly once, except the excluded ones.
+
     set<pair<int, int> > neighbors;
-    for (int i = 0; i < (int) neighborList.getSortedAtoms().size(); i++) {
-        int blockIndex = i/blockSize;
-        int indexInBlock = i-blockIndex*blockSize;
-        char mask = 1<<indexInBlock;
-        for (int j = 0; j < (int) neighborList.getBlockExclusions(blockIndex).size(); j++) {
-            if ((neighborList.getBlockExclusions(blockIndex)[j] & mask) == 0) {
-                int atom1 = neighborList.getSortedAtoms()[i];
-                int atom2 = neighborList.getBlockNeighbors(blockIndex)[j];
+    for (int block = 0; block < neighborList.getNumBlocks(); block++) {
+        CpuNeighborList::NeighborIterator iter = neighborList.getNeighborIterator(block);
+        while (iter.next()) {
+            int atom2 = iter.getNeighbor();
+            for (int k = 0; k < blockSize; k++) {
+                int atom1 = block*blockSize+k;
+                if ((iter.getExclusions() & (1<<k)) != 0)
+                    continue;
+                ASSERT(atom1 < numParticles);
                 pair<int, int> entry = make_pair(min(atom1, atom2), max(atom1, atom2));
-                ASSERT(neighbors.find(entry) == neighbors.end() && neighbors.find(make_pair(entry.second, entry.first)) == neighbors.end()); // No duplicates
+                ASSERT(atom1 != atom2);
+                ASSERT(neighbors.find(entry) == neighbors.end());
                 neighbors.insert(entry);
             }
         }
     }
-    
-    // Check each particle pair and figure out whether they should be in the neighbor list.
-
     for (int i = 0; i < numParticles; i++)
-        for (int j = 0; j <= i; j++) {
-            bool shouldInclude = (exclusions[i].find(j) == exclusions[i].end());
-            Vec3 diff(positions[4*i]-positions[4*j], positions[4*i+1]-positions[4*j+1], positions[4*i+2]-positions[4*j+2]);
-            if (periodic) {
-                diff -= boxVectors[2]*floor(diff[2]/boxSize[2]+0.5);
-                diff -= boxVectors[1]*floor(diff[1]/boxSize[1]+0.5);
-                diff -= boxVectors[0]*floor(diff[0]/boxSize[0]+0.5);
-            }
-            if (diff.dot(diff) > cutoff*cutoff)
-                shouldInclude = false;
-            bool isIncluded = (neighbors.find(make_pair(i, j)) != neighbors.end() || neighbors.find(make_pair(j, i)) != neighbors.end());
-            if (shouldInclude)
-                ASSERT(isIncluded);
-        }
+        for (int j = i+1; j < numParticles; j++)
+            ASSERT_EQUAL(exclusions[i].find(j) == exclusions[i].end(), neighbors.find(make_pair(i, j)) != neighbors.end());
 }
 
 int main() {
@@ -125,9 +242,13 @@ int main() {
             cout << "CPU is not supported.  Exiting." << endl;
             return 0;
         }
+        testExclusionList();
+        testDenseNeighborList();
         testNeighborList(false, false);
         testNeighborList(true, false);
         testNeighborList(true, true);
+        testIncrementalUpdate(false);
+        testIncrementalUpdate(true);
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -31,7 +31,404 @@
 
 #include "CpuTests.h"
 #include "TestNonbondedForce.h"
+#include "openmm/CustomNonbondedForce.h"
+#include "openmm/GBSAOBCForce.h"
+#include <thread>
+
+void testPinThreads() {
+    // Pinning threads should not change the results.
+
+    const int numParticles = 1000;
+    const double boxSize = 5.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 1.0);
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuPinThreads()] = "true";
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("false", platform.getPropertyValue(context1, CpuPlatform::CpuPinThreads()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuPinThreads()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-5);
+}
+
+void testPmeThreads() {
+    // Changing the number of reciprocal space threads should not change the results.
+
+    const int numParticles = 1000;
+    const double boxSize = 5.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 1.0);
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "3";
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuPmeThreads()] = "1";
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("3", platform.getPropertyValue(context1, CpuPlatform::CpuPmeThreads()));
+    ASSERT_EQUAL("1", platform.getPropertyValue(context2, CpuPlatform::CpuPmeThreads()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+}
+
+void testSharedThreadPool() {
+    // Contexts that share a thread pool should get the same results as one with its own pool,
+    // even when they are used from different threads at the same time.
+
+    const int numParticles = 1000;
+    const double boxSize = 5.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 1.0);
+        positions.push_back(Vec3(0.5*(i%10), 0.5*((i/10)%10), 0.5*(i/100))+0.1*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "3";
+    properties[CpuPlatform::CpuDeterministicForces()] = "true";
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuSharedThreadPool()] = "true";
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform, properties);
+    VerletIntegrator integrator3(0.001);
+    Context context3(system, integrator3, platform, properties);
+    ASSERT_EQUAL("false", platform.getPropertyValue(context1, CpuPlatform::CpuSharedThreadPool()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuSharedThreadPool()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context3.setPositions(positions);
+    context1.getIntegrator().step(10);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2, state3;
+    thread thread2([&] () {
+        context2.getIntegrator().step(10);
+        state2 = context2.getState(State::Forces | State::Energy);
+    });
+    thread thread3([&] () {
+        context3.getIntegrator().step(10);
+        state3 = context3.getState(State::Forces | State::Energy);
+    });
+    thread2.join();
+    thread3.join();
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state3.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state3.getForces()[i], 1e-4);
+    }
+}
+
+void testDeterministicForces() {
+    // With DeterministicForces set, repeated evaluations and separate Contexts should give bitwise
+    // identical results.  They also should agree with the default mode to within rounding error.
+
+    const int numParticles = 1000;
+    const double boxSize = 3.5;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    CustomNonbondedForce* custom = new CustomNonbondedForce("a1*a2*r^2");
+    custom->addPerParticleParameter("a");
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(1.0);
+    system.addForce(custom);
+    GBSAOBCForce* gbsa = new GBSAOBCForce();
+    gbsa->setNonbondedMethod(GBSAOBCForce::CutoffPeriodic);
+    gbsa->setCutoffDistance(1.0);
+    system.addForce(gbsa);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        double charge = (i%2 == 0 ? 0.5 : -0.5);
+        nonbonded->addParticle(charge, 0.3, 1.0);
+        custom->addParticle({0.1*(i%3)});
+        gbsa->addParticle(charge, 0.15, 1.0);
+        positions.push_back(Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt)));
+    }
+    for (int i = 0; i < numParticles; i += 10) {
+        nonbonded->addException(i, i+1, 0.0, 1.0, 0.0);
+        custom->addExclusion(i, i+1);
+    }
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    VerletIntegrator integrator1(0.001), integrator2(0.001), integrator3(0.001);
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuDeterministicForces()] = "true";
+    Context context2(system, integrator2, platform, properties);
+    Context context3(system, integrator3, platform, properties);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context3.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    for (int repeat = 0; repeat < 3; repeat++) {
+        State state3 = (repeat == 0 ? context3 : context2).getState(State::Forces | State::Energy);
+        ASSERT_EQUAL(state2.getPotentialEnergy(), state3.getPotentialEnergy());
+        for (int i = 0; i < numParticles; i++)
+            for (int j = 0; j < 3; j++)
+                ASSERT_EQUAL(state2.getForces()[i][j], state3.getForces()[i][j]);
+    }
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+}
+
+void testNeighborListWithForceGroups() {
+    // Evaluating only a group that does not use the neighbor list skips checking whether it needs
+    // to be rebuilt.  Make sure it still gets rebuilt when the nonbonded group is evaluated later.
+
+    const int numParticles = 500;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->addBond(0, 1, 0.1, 100.0);
+    system.addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setForceGroup(1);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.5);
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform);
+    context1.setPositions(positions);
+    context1.getState(State::Forces, false, 1<<1);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+    context1.setPositions(positions);
+    context1.getState(State::Forces, false, 1<<0);
+    State state1 = context1.getState(State::Forces | State::Energy, false, 1<<1);
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(positions);
+    State state2 = context2.getState(State::Forces | State::Energy, false, 1<<1);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-4);
+}
+
+void testNeighborListStatistics() {
+    const int numParticles = 500;
+    const double boxSize = 4.0;
+    const double cutoff = 1.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(cutoff);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.5);
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setForceCachingEnabled(false);
+
+    // The first computation builds the neighbor list.  Repeating it with the same positions should only check it.
+
+    context.getState(State::Forces);
+    map<string, double> stats = context.getNeighborListStatistics();
+    ASSERT_EQUAL(1, stats["Neighbor List Checks"]);
+    ASSERT_EQUAL(1, stats["Neighbor List Builds"]);
+    context.getState(State::Forces);
+    stats = context.getNeighborListStatistics();
+    ASSERT_EQUAL(2, stats["Neighbor List Checks"]);
+    ASSERT_EQUAL(1, stats["Neighbor List Builds"]);
+    ASSERT_EQUAL_TOL(0.5, stats["Neighbor List Build Frequency"], 1e-10);
+
+    // Moving every particle forces a rebuild.
+
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+    context.setPositions(positions);
+    context.getState(State::Forces);
+    stats = context.getNeighborListStatistics();
+    ASSERT_EQUAL(3, stats["Neighbor List Checks"]);
+    ASSERT_EQUAL(2, stats["Neighbor List Builds"]);
+
+    // The neighbor list should contain every pair within the cutoff, and the fraction of useful pairs
+    // should be consistent with the counts.
+
+    int expectedPairs = 0;
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < i; j++) {
+            Vec3 delta = positions[i]-positions[j];
+            for (int k = 0; k < 3; k++)
+                delta[k] -= boxSize*round(delta[k]/boxSize);
+            if (delta.dot(delta) < cutoff*cutoff)
+                expectedPairs++;
+        }
+    ASSERT_EQUAL(expectedPairs, stats["Pairs Within Cutoff"]);
+    ASSERT(stats["Neighbor List Pairs"] >= stats["Pairs Within Cutoff"]);
+    ASSERT(stats["Interacting Blocks"] > 0);
+    ASSERT_EQUAL_TOL(stats["Pairs Within Cutoff"]/stats["Neighbor List Pairs"], stats["Useful Pair Fraction"], 1e-10);
+}
+
+void testNeighborListPatches() {
+    // Repeatedly move a few particles past half the padding, which causes the neighbor list to be patched
+    // rather than rebuilt, while all the others drift toward each other by nearly half the padding.  The
+    // forces should match a Context that builds its neighbor list from scratch.
+
+    const int numParticles = 2000;
+    const double boxSize = 6.0;
+    const double cutoff = 1.0;
+    const double padding = 0.25*cutoff;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(cutoff);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.5);
+        positions.push_back(boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.getState(State::Forces);
+    const int numSteps = 10;
+    const int numMoved = numParticles/80;
+    for (int step = 0; step < numSteps; step++) {
+        for (int i = 0; i < numParticles; i++)
+            positions[i][0] += (i%2 == 0 ? 1 : -1)*0.45*padding/numSteps;
+        for (int i = 0; i < numMoved; i++) {
+            int index = (int) (numParticles*genrand_real2(sfmt));
+            positions[index][0] += (index%2 == 0 ? 0.6 : -0.6)*padding;
+        }
+        context.setPositions(positions);
+        State state = context.getState(State::Forces | State::Energy);
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, platform);
+        context2.setPositions(positions);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state2.getForces()[i], state.getForces()[i], 1e-4);
+    }
+    ASSERT(context.getNeighborListStatistics()["Neighbor List Patches"] > 0);
+}
+
+void testTriclinicMatchesReference() {
+    // Use a box large enough that most blocks can apply a single periodic shift to each neighbor.
+
+    const int numParticles = 1500;
+    Vec3 a(4.0, 0, 0);
+    Vec3 b(1.2, 4.2, 0);
+    Vec3 c(-1.5, 1.8, 4.4);
+    System system;
+    system.setDefaultPeriodicBoxVectors(a, b, c);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    CustomNonbondedForce* custom = new CustomNonbondedForce("4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.3; eps=0.5");
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(1.0);
+    custom->setForceGroup(1);
+    system.addForce(custom);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.5);
+        custom->addParticle();
+        positions.push_back(a*(3*genrand_real2(sfmt)-1) + b*(3*genrand_real2(sfmt)-1) + c*(3*genrand_real2(sfmt)-1));
+    }
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, platform);
+    context1.setPositions(positions);
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, Platform::getPlatformByName("Reference"));
+    context2.setPositions(positions);
+    for (int group = 0; group < 2; group++) {
+        State state1 = context1.getState(State::Forces | State::Energy, false, 1<<group);
+        State state2 = context2.getState(State::Forces | State::Energy, false, 1<<group);
+        ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-4);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-3);
+    }
+}
 
 void runPlatformTests() {
     testHugeSystem();
+    testPinThreads();
+    testPmeThreads();
+    testSharedThreadPool();
+    testDeterministicForces();
+    testNeighborListWithForceGroups();
+    testNeighborListStatistics();
+    testNeighborListPatches();
+    testTriclinicMatchesReference();
 }
@@ -131,6 +131,12 @@ public:
     CUdeviceptr& getDevicePointer() {
         return pointer;
     }
+    /**
+     * Get the device pointer, converted to a void*.
+     */
+    void* getDeviceHandle() {
+        return reinterpret_cast<void*>(pointer);
+    }
     /**
      * Copy the values in a vector to the device memory.
      */
@@ -185,7 +191,7 @@ private:
     size_t size;
     int elementSize;
     bool ownsMemory;
-    std::string name;
+    std::string name, memoryCategory;
 };
 
 } // namespace OpenMM
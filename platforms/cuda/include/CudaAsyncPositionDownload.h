@@ -0,0 +1,93 @@
+#ifndef OPENMM_CUDAASYNCPOSITIONDOWNLOAD_H_
+#define OPENMM_CUDAASYNCPOSITIONDOWNLOAD_H_
+
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CudaArray.h"
+#include "CudaContext.h"
+#include "openmm/Vec3.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class downloads the positions from a CudaContext without making the host wait for
+ * the copy to finish.  Calling start() takes a device-side copy of the positions, which is
+ * fast, then transfers that copy to pinned host memory on a separate stream while the
+ * context continues to integrate.  Two buffers are used, so a new download can be started
+ * before the result of the previous one has been retrieved.
+ *
+ * This is intended for reporters that are called periodically during a simulation.  The
+ * positions that are eventually returned are the ones at the moment start() was called.
+ */
+
+class OPENMM_EXPORT_COMMON CudaAsyncPositionDownload {
+public:
+    CudaAsyncPositionDownload(CudaContext& context);
+    ~CudaAsyncPositionDownload();
+    /**
+     * Begin downloading the current positions.  If the buffer this download will use is
+     * still being filled by an earlier call, this waits for that transfer to complete.
+     *
+     * @return an identifier for this download, to pass to isReady() and getPositions().
+     */
+    int start();
+    /**
+     * Get whether a download has completed, so getPositions() can be called without blocking.
+     *
+     * @param id   the identifier returned by start()
+     */
+    bool isReady(int id);
+    /**
+     * Get the positions from a download, blocking until it has completed if necessary.
+     * Only the two most recent downloads can be retrieved.
+     *
+     * @param id          the identifier returned by start()
+     * @param positions   on exit, this contains the position of every particle
+     */
+    void getPositions(int id, std::vector<Vec3>& positions);
+private:
+    struct Buffer {
+        CudaArray posq, posqCorrection;
+        void* hostMemory;
+        CUevent copiedEvent, downloadedEvent;
+        std::vector<int> atomIndex;
+        std::vector<mm_int4> posCellOffsets;
+        Vec3 boxVectors[3];
+        int id;
+    };
+    Buffer& findBuffer(int id);
+    CudaContext& context;
+    CUstream stream;
+    Buffer buffers[2];
+    int numStarted;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CUDAASYNCPOSITIONDOWNLOAD_H_*/
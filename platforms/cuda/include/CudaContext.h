@@ -28,6 +28,7 @@
  * -------------------------------------------------------------------------- */
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #define __CL_ENABLE_EXCEPTIONS
@@ -160,6 +161,25 @@ public:
      * Reset the context to using the default stream for execution.
      */
     void restoreDefaultStream();
+    /**
+     * Allocate device memory.  When the device supports memory pools, the memory is taken from the
+     * device's default pool in stream order on the default stream.  Otherwise it is allocated with cuMemAlloc().
+     *
+     * @param pointer    on exit, the address of the allocated memory
+     * @param size       the number of bytes to allocate
+     */
+    CUresult allocateMemory(CUdeviceptr& pointer, size_t size);
+    /**
+     * Free memory that was allocated with allocateMemory().  Memory taken from a pool is returned to it without
+     * synchronizing the device.
+     */
+    CUresult freeMemory(CUdeviceptr pointer);
+    /**
+     * Get the number of bytes of device memory currently reserved by the memory pool that arrays are allocated from.
+     * This includes memory that has been freed and is being held for reuse.  The pool is shared by all contexts
+     * on the same device.  If memory pools are not being used, this returns 0.
+     */
+    long long getMemoryPoolSize() const;
     /**
      * Construct an uninitialized array of the appropriate class for this platform.  The returned
      * value should be created on the heap with the "new" operator.
@@ -294,6 +314,27 @@ public:
      * @param sharedSize   the amount of dynamic shared memory to allocated for the kernel, in bytes
      */
     void executeKernel(CUfunction kernel, void** arguments, int workUnits, int blockSize = -1, unsigned int sharedSize = 0);
+    /**
+     * Get whether sequences of kernels that support it should be executed as CUDA graphs.
+     */
+    bool getUseCudaGraphs() const {
+        return platformData.useCudaGraphs;
+    }
+    /**
+     * Begin capturing the work submitted to the current stream into a CUDA graph.  None of it is
+     * executed until endGraphCapture() is called.  The work between the two calls must not wait
+     * for its own results, for example by downloading an array or synchronizing on an event.
+     */
+    void beginGraphCapture();
+    /**
+     * Finish capturing work into a CUDA graph and launch it.  The executable graph is kept and
+     * reused by later captures with the same key.  They update its kernel arguments in place, which
+     * is much less expensive than instantiating a new one.  It is only instantiated again if the
+     * sequence of operations changes.
+     *
+     * @param key    identifies which executable graph to reuse
+     */
+    void endGraphCapture(long long key);
     /**
      * Compute the largest thread block size that can be used for a kernel that requires a particular amount of
      * shared memory per thread.
@@ -561,13 +602,20 @@ private:
     bool useBlockingSync, useDoublePrecision, useMixedPrecision, contextIsValid, boxIsTriclinic, hasCompilerKernel, isNvccAvailable, hasAssignedPosqCharges;
     bool isLinkedContext;
     std::string compiler, tempDir, cacheDir;
+    std::vector<std::string> kernelSearchPath;
     float4 periodicBoxVecXFloat, periodicBoxVecYFloat, periodicBoxVecZFloat, periodicBoxSizeFloat, invPeriodicBoxSizeFloat;
     double4 periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ, periodicBoxSize, invPeriodicBoxSize;
     std::string defaultOptimizationOptions;
     std::map<std::string, std::string> compilationDefines;
+    std::map<std::string, CUmodule> loadedModules;
     CUcontext context;
     CUdevice device;
     CUstream currentStream;
+#if CUDA_VERSION >= 11020
+    CUmemoryPool memoryPool;
+#endif
+    bool useMemoryPool;
+    std::set<CUdeviceptr> pooledAllocations;
     CUfunction clearBufferKernel;
     CUfunction clearTwoBuffersKernel;
     CUfunction clearThreeBuffersKernel;
@@ -595,6 +643,8 @@ private:
     CudaBondedUtilities* bonded;
     CudaNonbondedUtilities* nonbonded;
     Kernel compilerKernel;
+    std::map<long long, CUgraphExec> graphs;
+    CUstream graphCaptureStream, streamBeforeCapture;
 };
 
 /**
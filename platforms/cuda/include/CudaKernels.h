@@ -104,6 +104,19 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * Wait until all calculations that have been queued for this context have completed.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void synchronize(ContextImpl& context);
+    /**
+     * Get statistics describing the neighbor list used for nonbonded interactions.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(ContextImpl& context, std::map<std::string, double>& statistics);
 private:
    CudaContext& cu;
 };
@@ -152,6 +165,13 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     void getPositions(ContextImpl& context, std::vector<Vec3>& positions);
+    /**
+     * Get the positions of a subset of the particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, this contains the positions of the requested particles in the same order as particles
+     */
+    void getPositionSubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions);
     /**
      * Set the positions of all particles.
      *
@@ -164,6 +184,13 @@ public:
      * @param velocities  on exit, this contains the particle velocities
      */
     void getVelocities(ContextImpl& context, std::vector<Vec3>& velocities);
+    /**
+     * Get the velocities of a subset of the particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, this contains the velocities of the requested particles in the same order as particles
+     */
+    void getVelocitySubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities);
     /**
      * Set the velocities of all particles.
      *
@@ -220,7 +247,10 @@ public:
      */
     void loadCheckpoint(ContextImpl& context, std::istream& stream);
 private:
+    void gatherSubset(const std::vector<int>& particles, bool positions, std::vector<int>& atoms);
     CudaContext& cu;
+    CudaArray subsetAtoms, subsetData;
+    ComputeKernel gatherPositionsKernel, gatherVelocitiesKernel;
 };
 
 /**
@@ -229,7 +259,7 @@ private:
 class CudaCalcNonbondedForceKernel : public CalcNonbondedForceKernel {
 public:
     CudaCalcNonbondedForceKernel(std::string name, const Platform& platform, CudaContext& cu, const System& system) : CalcNonbondedForceKernel(name, platform),
-            cu(cu), hasInitializedFFT(false), sort(NULL), dispersionFft(NULL), fft(NULL), pmeio(NULL), usePmeStream(false) {
+            cu(cu), hasInitializedFFT(false), sort(NULL), dispersionFft(NULL), fft(NULL), pmeio(NULL), usePmeStream(false), hasPmeTiming(false) {
     }
     ~CudaCalcNonbondedForceKernel();
     /**
@@ -275,6 +305,17 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     void getLJPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Get timing information for the most recent force computation that included reciprocal space.
+     * This is only available when PME is computed on its own stream.  It can be used to check how
+     * well reciprocal space overlaps with the direct space calculation.  If the most recent
+     * computation has not finished yet, this blocks until it does.
+     *
+     * @param pmeTime     the time in milliseconds the PME stream spent computing reciprocal space
+     * @param stallTime   the time in milliseconds the main stream spent waiting for the PME stream to finish
+     * @return true if timing information is available, false otherwise
+     */
+    bool getPmeStreamTiming(double& pmeTime, double& stallTime);
 private:
     class SortTrait : public CudaSort::SortTrait {
         int getDataSize() const {return 8;}
@@ -322,7 +363,7 @@ private:
     Kernel cpuPme;
     PmeIO* pmeio;
     CUstream pmeStream;
-    CUevent pmeSyncEvent, paramsSyncEvent;
+    CUevent pmeSyncEvent, paramsSyncEvent, pmeStartEvent, pmeEndEvent, pmeWaitEvent;
     CudaFFT3D* fft;
     cufftHandle fftForward;
     cufftHandle fftBackward;
@@ -338,10 +379,10 @@ private:
     CUfunction pmeDispersionSpreadChargeKernel;
     CUfunction pmeFinishSpreadChargeKernel;
     CUfunction pmeDispersionFinishSpreadChargeKernel;
-    CUfunction pmeEvalEnergyKernel;
-    CUfunction pmeEvalDispersionEnergyKernel;
     CUfunction pmeConvolutionKernel;
     CUfunction pmeDispersionConvolutionKernel;
+    CUfunction pmeConvolutionEnergyKernel;
+    CUfunction pmeDispersionConvolutionEnergyKernel;
     CUfunction pmeInterpolateForceKernel;
     CUfunction pmeInterpolateDispersionForceKernel;
     std::vector<std::pair<int, int> > exceptionAtoms;
@@ -351,7 +392,7 @@ private:
     int interpolateForceThreads;
     int gridSizeX, gridSizeY, gridSizeZ;
     int dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ;
-    bool hasCoulomb, hasLJ, usePmeStream, useCudaFFT, doLJPME, usePosqCharges, recomputeParams, hasOffsets;
+    bool hasCoulomb, hasLJ, usePmeStream, useCudaFFT, doLJPME, usePosqCharges, recomputeParams, hasOffsets, hasPmeTiming;
     NonbondedMethod nonbondedMethod;
     static const int PmeOrder = 5;
 };
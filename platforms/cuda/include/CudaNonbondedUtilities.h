@@ -196,6 +196,24 @@ public:
      * @param includeEnergy  whether to compute the potential energy
      */
     void computeInteractions(int forceGroups, bool includeForces, bool includeEnergy);
+    /**
+     * Launch the kernel that computes the nonbonded interactions, without checking whether the
+     * neighbor list arrays were large enough.  Calling this followed by checkNeighborListSize() is
+     * equivalent to calling computeInteractions(), but it allows the launch to be captured in a
+     * CUDA graph.
+     *
+     * @param forceGroups    the flags specifying which force groups to include
+     * @param includeForces  whether to compute forces
+     * @param includeEnergy  whether to compute the potential energy
+     */
+    void executeInteractionKernel(int forceGroups, bool includeForces, bool includeEnergy);
+    /**
+     * Wait for the neighbor list built by the most recent call to prepareInteractions() and check
+     * whether it fit in the arrays, making them bigger if necessary.
+     *
+     * @param forceGroups    the flags specifying which force groups to include
+     */
+    void checkNeighborListSize(int forceGroups);
     /**
      * Check to see if the neighbor list arrays are large enough, and make them bigger if necessary.
      *
@@ -281,6 +299,14 @@ public:
     int getNumTiles() const {
         return numTiles;
     }
+    /**
+     * Compute statistics describing how often the neighbor list has been rebuilt and how efficiently it
+     * packs interactions into tiles.  See Context::getNeighborListStatistics() for the meaning of each
+     * value.  This downloads the neighbor list from the device, so it should not be called on every step.
+     *
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(std::map<std::string, double>& statistics);
     /**
      * Set whether to add padding to the cutoff distance when building the neighbor list.
      * This increases the size of the neighbor list (and thus the cost of computing interactions),
@@ -308,6 +334,10 @@ public:
      * @param includeEnergy whether this kernel should compute potential energy
      */
     CUfunction createInteractionKernel(const std::string& source, std::vector<ParameterInfo>& params, std::vector<ParameterInfo>& arguments, bool useExclusions, bool isSymmetric, int groups, bool includeForces, bool includeEnergy);
+    /**
+     * Get the expression for loading a per-atom parameter inside the interaction kernel.
+     */
+    static std::string loadParameter(const ParameterInfo& param, const std::string& index);
     /**
      * Create the set of kernels that will be needed for a particular combination of force groups.
      * 
@@ -331,6 +361,7 @@ private:
     CudaArray interactingTiles;
     CudaArray interactingAtoms;
     CudaArray interactionCount;
+    CudaArray tileCounter;
     CudaArray singlePairs;
     CudaArray singlePairCount;
     CudaArray blockCenter;
@@ -354,7 +385,7 @@ private:
     bool useCutoff, usePeriodic, anyExclusions, usePadding, useNeighborList, forceRebuildNeighborList, canUsePairList;
     int startTileIndex, startBlockIndex, numBlocks, maxExclusions, numForceThreadBlocks, forceThreadBlockSize, numAtoms, groupFlags;
     unsigned int maxTiles, maxSinglePairs, tilesAfterReorder;
-    long long numTiles;
+    long long numTiles, numNeighborListChecks, numNeighborListBuilds, numNeighborListReallocations;
     std::string kernelSource;
 };
 
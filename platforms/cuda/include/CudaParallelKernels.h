@@ -77,13 +77,45 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * Wait until all calculations that have been queued for this context have completed.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void synchronize(ContextImpl& context);
+    /**
+     * Get statistics describing the neighbor list used for nonbonded interactions.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(ContextImpl& context, std::map<std::string, double>& statistics);
+    /**
+     * Get the fraction of the nonbonded work currently assigned to each device.
+     */
+    const std::vector<double>& getNonbondedFractions() const {
+        return contextNonbondedFractions;
+    }
+    /**
+     * Get the times (in seconds) each device spent computing forces on recent load balanced steps.
+     * Each element holds one step, with one entry per device.  Only the most recent steps are retained.
+     */
+    const std::vector<std::vector<double> >& getDeviceTimeHistory() const {
+        return deviceTimeHistory;
+    }
 private:
     class BeginComputationTask;
     class FinishComputationTask;
+    static const int maxHistoryLength = 100;
+    void balanceNonbondedWork(const std::vector<double>& deviceTimes);
     CudaPlatform::PlatformData& data;
     std::vector<Kernel> kernels;
-    std::vector<long long> completionTimes;
     std::vector<double> contextNonbondedFractions;
+    std::vector<std::vector<double> > deviceTimeHistory;
+    std::vector<CUevent> timingStartEvent;
+    std::vector<CUevent> timingEndEvent;
+    int timingSet;
+    bool timingRecorded[2];
     bool loadBalance;
     int2* interactionCounts;
     CudaArray contextForces;
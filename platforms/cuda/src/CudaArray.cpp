@@ -43,12 +43,13 @@ CudaArray::CudaArray(CudaContext& context, size_t size, int elementSize, const s
 CudaArray::~CudaArray() {
     if (pointer != 0 && ownsMemory && context->getContextIsValid()) {
         ContextSelector selector(*context);
-        CUresult result = cuMemFree(pointer);
+        CUresult result = context->freeMemory(pointer);
         if (result != CUDA_SUCCESS) {
             std::stringstream str;
             str<<"Error deleting array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
             throw OpenMMException(str.str());
         }
+        context->recordMemoryUsage(memoryCategory, -(long long) (size*elementSize));
     }
 }
 
@@ -61,12 +62,15 @@ void CudaArray::initialize(ComputeContext& context, size_t size, int elementSize
     this->name = name;
     ownsMemory = true;
     ContextSelector selector(*this->context);
-    CUresult result = cuMemAlloc(&pointer, size*elementSize);
+    CUresult result = this->context->allocateMemory(pointer, size*elementSize);
     if (result != CUDA_SUCCESS) {
         std::stringstream str;
         str<<"Error creating array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
+    if (memoryCategory.empty())
+        memoryCategory = context.getMemoryCategory();
+    context.recordMemoryUsage(memoryCategory, size*elementSize);
 }
 
 void CudaArray::resize(size_t size) {
@@ -75,12 +79,13 @@ void CudaArray::resize(size_t size) {
     if (!ownsMemory)
         throw OpenMMException("Cannot resize an array that does not own its storage");
     ContextSelector selector(*context);
-    CUresult result = cuMemFree(pointer);
+    CUresult result = context->freeMemory(pointer);
     if (result != CUDA_SUCCESS) {
         std::stringstream str;
         str<<"Error deleting array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
+    context->recordMemoryUsage(memoryCategory, -(long long) (this->size*elementSize));
     pointer = 0;
     initialize(*context, size, elementSize, name);
 }
@@ -0,0 +1,156 @@
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CudaAsyncPositionDownload.h"
+#include "openmm/common/ContextSelector.h"
+#include "openmm/OpenMMException.h"
+
+using namespace OpenMM;
+using namespace std;
+
+#define CHECK_RESULT(result, prefix) \
+    if (result != CUDA_SUCCESS) { \
+        std::stringstream m; \
+        m<<prefix<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")"<<" at "<<__FILE__<<":"<<__LINE__; \
+        throw OpenMMException(m.str());\
+    }
+
+CudaAsyncPositionDownload::CudaAsyncPositionDownload(CudaContext& context) : context(context), numStarted(0) {
+    ContextSelector selector(context);
+
+    // The download stream must not synchronize with the default stream, or integration
+    // would wait for every transfer to finish.
+
+    CHECK_RESULT(cuStreamCreate(&stream, CU_STREAM_NON_BLOCKING), "Error creating stream for asynchronous download");
+    CudaArray& posq = context.getPosq();
+    CudaArray& posqCorrection = context.getPosqCorrection();
+    size_t posqBytes = posq.getSize()*posq.getElementSize();
+    size_t correctionBytes = (context.getUseMixedPrecision() ? posqCorrection.getSize()*posqCorrection.getElementSize() : 0);
+    for (Buffer& buffer : buffers) {
+        buffer.posq.initialize(context, posq.getSize(), posq.getElementSize(), "asyncPosq");
+        if (context.getUseMixedPrecision())
+            buffer.posqCorrection.initialize(context, posqCorrection.getSize(), posqCorrection.getElementSize(), "asyncPosqCorrection");
+        CHECK_RESULT(cuMemHostAlloc(&buffer.hostMemory, posqBytes+correctionBytes, 0), "Error allocating pinned memory");
+        CHECK_RESULT(cuEventCreate(&buffer.copiedEvent, CU_EVENT_DISABLE_TIMING), "Error creating event");
+        CHECK_RESULT(cuEventCreate(&buffer.downloadedEvent, context.getEventFlags()), "Error creating event");
+        buffer.id = -1;
+    }
+}
+
+CudaAsyncPositionDownload::~CudaAsyncPositionDownload() {
+    ContextSelector selector(context);
+    cuStreamSynchronize(stream);
+    for (Buffer& buffer : buffers) {
+        cuMemFreeHost(buffer.hostMemory);
+        cuEventDestroy(buffer.copiedEvent);
+        cuEventDestroy(buffer.downloadedEvent);
+    }
+    cuStreamDestroy(stream);
+}
+
+int CudaAsyncPositionDownload::start() {
+    ContextSelector selector(context);
+    int id = numStarted++;
+    Buffer& buffer = buffers[id%2];
+    if (buffer.id != -1)
+        CHECK_RESULT(cuEventSynchronize(buffer.downloadedEvent), "Error waiting for download");
+    buffer.id = id;
+
+    // Take a copy of the positions on the device, then transfer it to the host on the
+    // download stream once the copy is complete.
+
+    CUstream mainStream = context.getCurrentStream();
+    context.getPosq().copyTo(buffer.posq);
+    if (context.getUseMixedPrecision())
+        context.getPosqCorrection().copyTo(buffer.posqCorrection);
+    CHECK_RESULT(cuEventRecord(buffer.copiedEvent, mainStream), "Error recording event");
+    CHECK_RESULT(cuStreamWaitEvent(stream, buffer.copiedEvent, 0), "Error synchronizing streams");
+    size_t posqBytes = buffer.posq.getSize()*buffer.posq.getElementSize();
+    CHECK_RESULT(cuMemcpyDtoHAsync(buffer.hostMemory, buffer.posq.getDevicePointer(), posqBytes, stream), "Error downloading positions");
+    if (context.getUseMixedPrecision()) {
+        size_t correctionBytes = buffer.posqCorrection.getSize()*buffer.posqCorrection.getElementSize();
+        CHECK_RESULT(cuMemcpyDtoHAsync((char*) buffer.hostMemory+posqBytes, buffer.posqCorrection.getDevicePointer(), correctionBytes, stream), "Error downloading positions");
+    }
+    CHECK_RESULT(cuEventRecord(buffer.downloadedEvent, stream), "Error recording event");
+
+    // Record the host-side information needed to interpret the positions, since the
+    // atom order and box may change before they are retrieved.
+
+    buffer.atomIndex = context.getAtomIndex();
+    buffer.posCellOffsets = context.getPosCellOffsets();
+    context.getPeriodicBoxVectors(buffer.boxVectors[0], buffer.boxVectors[1], buffer.boxVectors[2]);
+    return id;
+}
+
+CudaAsyncPositionDownload::Buffer& CudaAsyncPositionDownload::findBuffer(int id) {
+    Buffer& buffer = buffers[id%2];
+    if (id < 0 || buffer.id != id)
+        throw OpenMMException("CudaAsyncPositionDownload: Illegal download identifier");
+    return buffer;
+}
+
+bool CudaAsyncPositionDownload::isReady(int id) {
+    Buffer& buffer = findBuffer(id);
+    ContextSelector selector(context);
+    return (cuEventQuery(buffer.downloadedEvent) == CUDA_SUCCESS);
+}
+
+void CudaAsyncPositionDownload::getPositions(int id, vector<Vec3>& positions) {
+    Buffer& buffer = findBuffer(id);
+    ContextSelector selector(context);
+    CHECK_RESULT(cuEventSynchronize(buffer.downloadedEvent), "Error waiting for download");
+    int numParticles = context.getNumAtoms();
+    positions.resize(numParticles);
+    const vector<int>& order = buffer.atomIndex;
+    const Vec3* box = buffer.boxVectors;
+    if (context.getUseDoublePrecision()) {
+        double4* posq = (double4*) buffer.hostMemory;
+        for (int i = 0; i < numParticles; ++i) {
+            double4 pos = posq[i];
+            mm_int4 offset = buffer.posCellOffsets[i];
+            positions[order[i]] = Vec3(pos.x, pos.y, pos.z)-box[0]*offset.x-box[1]*offset.y-box[2]*offset.z;
+        }
+    }
+    else if (context.getUseMixedPrecision()) {
+        float4* posq = (float4*) buffer.hostMemory;
+        float4* posCorrection = (float4*) ((char*) buffer.hostMemory+buffer.posq.getSize()*buffer.posq.getElementSize());
+        for (int i = 0; i < numParticles; ++i) {
+            float4 pos1 = posq[i];
+            float4 pos2 = posCorrection[i];
+            mm_int4 offset = buffer.posCellOffsets[i];
+            positions[order[i]] = Vec3((double)pos1.x+(double)pos2.x, (double)pos1.y+(double)pos2.y, (double)pos1.z+(double)pos2.z)-box[0]*offset.x-box[1]*offset.y-box[2]*offset.z;
+        }
+    }
+    else {
+        float4* posq = (float4*) buffer.hostMemory;
+        for (int i = 0; i < numParticles; ++i) {
+            float4 pos = posq[i];
+            mm_int4 offset = buffer.posCellOffsets[i];
+            positions[order[i]] = Vec3(pos.x, pos.y, pos.z)-box[0]*offset.x-box[1]*offset.y-box[2]*offset.z;
+        }
+    }
+}
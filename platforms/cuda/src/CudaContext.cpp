@@ -45,11 +45,15 @@
 #include "openmm/VirtualSite.h"
 #include "CudaExpressionUtilities.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/TraceRange.h"
 #include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <typeinfo>
@@ -73,6 +77,73 @@ using namespace std;
 
 const int CudaContext::ThreadBlockSize = 64;
 const int CudaContext::TileSize = sizeof(tileflags)*8;
+
+// Linked images of every module loaded in this process, indexed by the same name used for the on-disk cache
+// plus the architecture they were linked for.  The on-disk cache holds PTX, which the driver must compile for
+// the device every time it is loaded.  Keeping the result lets other contexts on the same kind of device,
+// including ones created by Context::reinitialize(), skip that step.
+
+static mutex moduleImagesLock;
+static map<string, vector<char> > moduleImages;
+static long long moduleImagesSize = 0;
+static const long long maxModuleImagesSize = 256*1024*1024;
+
+/**
+ * Load a module that was previously linked in this process.
+ */
+static bool loadModuleImage(const string& key, CUmodule& module) {
+    lock_guard<mutex> lock(moduleImagesLock);
+    auto found = moduleImages.find(key);
+    return (found != moduleImages.end() && cuModuleLoadData(&module, found->second.data()) == CUDA_SUCCESS);
+}
+
+/**
+ * Load a module from PTX.  It is linked explicitly rather than passed directly to cuModuleLoadData(),
+ * so the linked image can be saved for later use.
+ */
+static CUresult loadModuleFromPtx(const string& ptx, const string& key, CUmodule& module) {
+    CUlinkState linkState;
+    CUresult result = cuLinkCreate(0, NULL, NULL, &linkState);
+    if (result == CUDA_SUCCESS) {
+        void* image;
+        size_t imageSize;
+        result = cuLinkAddData(linkState, CU_JIT_INPUT_PTX, (void*) ptx.c_str(), ptx.size()+1, "module", 0, NULL, NULL);
+        if (result == CUDA_SUCCESS)
+            result = cuLinkComplete(linkState, &image, &imageSize);
+        if (result == CUDA_SUCCESS)
+            result = cuModuleLoadData(&module, image);
+        if (result == CUDA_SUCCESS) {
+            lock_guard<mutex> lock(moduleImagesLock);
+            if (moduleImages.find(key) == moduleImages.end()) {
+                if (moduleImagesSize+(long long) imageSize > maxModuleImagesSize) {
+                    // Rather than tracking usage, just start over.  Anything still needed will be added again.
+
+                    moduleImages.clear();
+                    moduleImagesSize = 0;
+                }
+                moduleImages[key].assign((char*) image, (char*) image+imageSize);
+                moduleImagesSize += imageSize;
+            }
+        }
+        cuLinkDestroy(linkState);
+    }
+    if (result != CUDA_SUCCESS)
+        result = cuModuleLoadData(&module, ptx.c_str());
+    return result;
+}
+
+/**
+ * Load a module from a file containing PTX.
+ */
+static CUresult loadModuleFromFile(const string& file, const string& key, CUmodule& module) {
+    ifstream in(file.c_str());
+    if (!in.is_open())
+        return CUDA_ERROR_FILE_NOT_FOUND;
+    string ptx((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    if (ptx.empty())
+        return CUDA_ERROR_INVALID_IMAGE;
+    return loadModuleFromPtx(ptx, key, module);
+}
 bool CudaContext::hasInitializedCuda = false;
 
 #ifdef WIN32
@@ -108,7 +179,7 @@ static int executeInWindows(const string &command) {
 
 CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlockingSync, const string& precision, const string& compiler,
         const string& tempDir, const std::string& hostCompiler, bool allowRuntimeCompiler, CudaPlatform::PlatformData& platformData,
-        CudaContext* originalContext) : ComputeContext(system), currentStream(0), platformData(platformData), contextIsValid(false), hasAssignedPosqCharges(false),
+        CudaContext* originalContext) : ComputeContext(system), currentStream(0), useMemoryPool(false), graphCaptureStream(0), platformData(platformData), contextIsValid(false), hasAssignedPosqCharges(false),
         hasCompilerKernel(false), isNvccAvailable(false), pinnedBuffer(NULL), integration(NULL), expression(NULL), bonded(NULL), nonbonded(NULL),
         useBlockingSync(useBlockingSync) {
     // Determine what compiler to use.
@@ -163,6 +234,25 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
     this->tempDir = tempDir+"/";
     cacheDir = cacheDir+"/";
 #endif
+
+    // Additional directories of precompiled modules can be listed in OPENMM_KERNEL_PATH.  They are only read,
+    // never written, so they can be shipped read-only with an installation or container image.
+
+    char* pathVariable = getenv("OPENMM_KERNEL_PATH");
+    if (pathVariable != NULL) {
+#ifdef WIN32
+        char separator = ';';
+        string dirSeparator = "\\";
+#else
+        char separator = ':';
+        string dirSeparator = "/";
+#endif
+        stringstream path(pathVariable);
+        string dir;
+        while (getline(path, dir, separator))
+            if (!dir.empty())
+                kernelSearchPath.push_back(dir+dirSeparator);
+    }
     contextIndex = platformData.contexts.size();
     string errorMessage = "Error initializing Context";
     if (originalContext == NULL) {
@@ -237,6 +327,23 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
     contextIsValid = true;
     ContextSelector selector(*this);
     CHECK_RESULT(cuCtxSetCacheConfig(CU_FUNC_CACHE_PREFER_SHARED));
+
+    // Allocate arrays from the device's default memory pool when it is supported.  cuMemFree() synchronizes
+    // the whole device, while cuMemFreeAsync() just returns the memory to the pool.  The release threshold keeps
+    // freed memory in the pool instead of giving it back to the driver, so it can be reused by later arrays and
+    // by other contexts on the same device.
+
+#if CUDA_VERSION >= 11020
+    int poolsSupported = 0;
+    if (cudaDriverVersion >= 11020)
+        cuDeviceGetAttribute(&poolsSupported, CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED, device);
+    if (poolsSupported) {
+        CHECK_RESULT(cuDeviceGetDefaultMemPool(&memoryPool, device));
+        cuuint64_t threshold = numeric_limits<cuuint64_t>::max();
+        CHECK_RESULT(cuMemPoolSetAttribute(memoryPool, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &threshold));
+        useMemoryPool = true;
+    }
+#endif
     if (contextIndex > 0) {
         int canAccess;
         cuDeviceCanAccessPeer(&canAccess, getDevice(), platformData.contexts[0]->getDevice());
@@ -246,6 +353,20 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
                 CHECK_RESULT(cuCtxEnablePeerAccess(getContext(), 0));
             }
             CHECK_RESULT(cuCtxEnablePeerAccess(platformData.contexts[0]->getContext(), 0));
+#if CUDA_VERSION >= 11020
+            // Peer access does not extend to memory pools, so it must be granted separately.
+
+            CudaContext& first = *platformData.contexts[0];
+            if (useMemoryPool && first.useMemoryPool && memoryPool != first.memoryPool) {
+                CUmemAccessDesc access;
+                access.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+                access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+                access.location.id = first.getDeviceIndex();
+                CHECK_RESULT(cuMemPoolSetAccess(memoryPool, &access, 1));
+                access.location.id = getDeviceIndex();
+                CHECK_RESULT(cuMemPoolSetAccess(first.memoryPool, &access, 1));
+            }
+#endif
         }
     }
     numAtoms = system.getNumParticles();
@@ -264,6 +385,7 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
         compilationDefines["SHFL(var, srcLane)"] = "__shfl(var, srcLane);";
         compilationDefines["BALLOT(var)"] = "__ballot(var);";
     }
+    setMemoryCategory("Context");
     if (useDoublePrecision) {
         posq.initialize<double4>(*this, paddedNumAtoms, "posq");
         velm.initialize<double4>(*this, paddedNumAtoms, "velm");
@@ -394,8 +516,10 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
             "pos.z -= floor((pos.z-center.z)*invPeriodicBoxSize.z+0.5f)*periodicBoxSize.z;}";
     }
 
-    // Create utilities objects.
+    // Create utilities objects.  Memory they allocate is attributed to their own categories,
+    // or to the Forces that use them.
 
+    setMemoryCategory("Forces");
     bonded = new CudaBondedUtilities(*this);
     nonbonded = new CudaNonbondedUtilities(*this);
     integration = new CudaIntegrationUtilities(*this, system);
@@ -422,8 +546,23 @@ CudaContext::~CudaContext() {
         delete bonded;
     if (nonbonded != NULL)
         delete nonbonded;
+    for (auto& graph : graphs)
+        cuGraphExecDestroy(graph.second);
+    if (graphCaptureStream != 0)
+        cuStreamDestroy(graphCaptureStream);
     if (contextIsValid && !isLinkedContext)
         cuProfilerStop();
+    if (contextIsValid && !pooledAllocations.empty()) {
+        // Arrays that are members of this object are not destroyed until after the context, when they can no
+        // longer free their memory.  Return it to the pool now so it does not leak.
+
+#if CUDA_VERSION >= 11020
+        for (CUdeviceptr pointer : pooledAllocations)
+            cuMemFreeAsync(pointer, 0);
+        cuStreamSynchronize(0);
+#endif
+        pooledAllocations.clear();
+    }
     popAsCurrent();
     string errorMessage = "Error deleting Context";
     if (contextIsValid && !isLinkedContext)
@@ -437,6 +576,7 @@ void CudaContext::initialize() {
     int numEnergyBuffers = max(numThreadBlocks*ThreadBlockSize, nonbonded->getNumEnergyBuffers());
     int multiprocessors;
     CHECK_RESULT2(cuDeviceGetAttribute(&multiprocessors, CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, device), "Error checking GPU properties");
+    setMemoryCategory("Context");
     if (useDoublePrecision) {
         energyBuffer.initialize<double>(*this, numEnergyBuffers, "energyBuffer");
         energySum.initialize<double>(*this, multiprocessors, "energySum");
@@ -463,6 +603,7 @@ void CudaContext::initialize() {
             ((float4*) pinnedBuffer)[i] = make_float4(0.0f, 0.0f, 0.0f, mass == 0.0 ? 0.0f : (float) (1.0/mass));
     }
     velm.upload(pinnedBuffer);
+    setMemoryCategory("Forces");
     bonded->initialize(system);
     addAutoclearBuffer(force.getDevicePointer(), force.getSize()*force.getElementSize());
     addAutoclearBuffer(energyBuffer.getDevicePointer(), energyBuffer.getSize()*energyBuffer.getElementSize());
@@ -572,15 +713,35 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
     sha1.Final();
     UINT_8 hash[20];
     sha1.GetHash(hash);
-    stringstream cacheFile;
-    cacheFile << cacheDir;
-    cacheFile.flags(ios::hex);
+    stringstream cacheName, cacheFile;
+    cacheName.flags(ios::hex);
     for (int i = 0; i < 20; i++)
-        cacheFile << setw(2) << setfill('0') << (int) hash[i];
-    cacheFile << '_' << compileArchitecture << '_' << bits;
+        cacheName << setw(2) << setfill('0') << (int) hash[i];
+    cacheName << '_' << compileArchitecture << '_' << bits;
+    cacheFile << cacheDir << cacheName.str();
+
+    // Many forces generate identical modules (for example, several copies of the same custom force).
+    // If this one has already been loaded by this context, reuse it.
+
+    auto loaded = loadedModules.find(cacheFile.str());
+    if (loaded != loadedModules.end())
+        return loaded->second;
     CUmodule module;
-    if (cuModuleLoad(&module, cacheFile.str().c_str()) == CUDA_SUCCESS)
+    string imageKey = cacheName.str()+"_sm"+intToString(gpuArchitecture);
+    if (loadModuleImage(imageKey, module)) {
+        loadedModules[cacheFile.str()] = module;
+        return module;
+    }
+    if (loadModuleFromFile(cacheFile.str(), imageKey, module) == CUDA_SUCCESS) {
+        loadedModules[cacheFile.str()] = module;
         return module;
+    }
+    for (const string& dir : kernelSearchPath) {
+        if (loadModuleFromFile(dir+cacheName.str(), imageKey, module) == CUDA_SUCCESS) {
+            loadedModules[cacheFile.str()] = module;
+            return module;
+        }
+    }
 
     // Select names for the various temporary files.
 
@@ -617,7 +778,8 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
         if (!wroteCache) {
             // An error occurred.  Possibly we don't have permission to write to the temp directory.  Just try to load the module directly.
 
-            CHECK_RESULT2(cuModuleLoadDataEx(&module, &ptx[0], 0, NULL, NULL), "Error loading CUDA module");
+            CHECK_RESULT2(loadModuleFromPtx(ptx, imageKey, module), "Error loading CUDA module");
+            loadedModules[cacheFile.str()] = module;
             return module;
         }
     }
@@ -656,7 +818,7 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
             }
             throw OpenMMException(error.str());
         }
-        CUresult result = cuModuleLoad(&module, outputFile.c_str());
+        CUresult result = loadModuleFromFile(outputFile, imageKey, module);
         if (result != CUDA_SUCCESS) {
             std::stringstream m;
             m<<"Error loading CUDA module: "<<getErrorString(result)<<" ("<<result<<")";
@@ -666,6 +828,7 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
         if (rename(outputFile.c_str(), cacheFile.str().c_str()) != 0)
             remove(outputFile.c_str());
         remove(logFile.c_str());
+        loadedModules[cacheFile.str()] = module;
         return module;
     }
     catch (...) {
@@ -699,6 +862,37 @@ void CudaContext::restoreDefaultStream() {
     setCurrentStream(0);
 }
 
+CUresult CudaContext::allocateMemory(CUdeviceptr& pointer, size_t size) {
+#if CUDA_VERSION >= 11020
+    if (useMemoryPool) {
+        CUresult result = cuMemAllocFromPoolAsync(&pointer, size, memoryPool, 0);
+        if (result == CUDA_SUCCESS)
+            pooledAllocations.insert(pointer);
+        return result;
+    }
+#endif
+    return cuMemAlloc(&pointer, size);
+}
+
+CUresult CudaContext::freeMemory(CUdeviceptr pointer) {
+#if CUDA_VERSION >= 11020
+    if (pooledAllocations.erase(pointer) > 0)
+        return cuMemFreeAsync(pointer, 0);
+#endif
+    return cuMemFree(pointer);
+}
+
+long long CudaContext::getMemoryPoolSize() const {
+#if CUDA_VERSION >= 11020
+    if (useMemoryPool) {
+        cuuint64_t size;
+        if (cuMemPoolGetAttribute(memoryPool, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT, &size) == CUDA_SUCCESS)
+            return (long long) size;
+    }
+#endif
+    return 0;
+}
+
 CudaArray* CudaContext::createArray() {
     return new CudaArray();
 }
@@ -743,6 +937,57 @@ void CudaContext::executeKernel(CUfunction kernel, void** arguments, int threads
     }
 }
 
+void CudaContext::beginGraphCapture() {
+    // The legacy default stream cannot be captured, so record the work on a separate stream and
+    // launch the graph on the original one.
+
+    if (graphCaptureStream == 0)
+        CHECK_RESULT2(cuStreamCreate(&graphCaptureStream, CU_STREAM_DEFAULT), "Error creating stream for graph capture");
+    streamBeforeCapture = currentStream;
+    setCurrentStream(graphCaptureStream);
+    CHECK_RESULT2(cuStreamBeginCapture(graphCaptureStream, CU_STREAM_CAPTURE_MODE_RELAXED), "Error beginning graph capture");
+}
+
+void CudaContext::endGraphCapture(long long key) {
+    OPENMM_TRACE_RANGE("Launch CUDA graph");
+    CUgraph graph;
+    CUresult captureResult = cuStreamEndCapture(graphCaptureStream, &graph);
+    setCurrentStream(streamBeforeCapture);
+    CHECK_RESULT2(captureResult, "Error ending graph capture");
+
+    // Try to update the existing executable graph with the new arguments.  That fails if the
+    // sequence of operations has changed, in which case we need to instantiate it again.
+
+    auto existing = graphs.find(key);
+    if (existing != graphs.end()) {
+#if CUDA_VERSION >= 12000
+        CUgraphExecUpdateResultInfo info;
+        CUresult result = cuGraphExecUpdate(existing->second, graph, &info);
+#else
+        CUgraphNode errorNode;
+        CUgraphExecUpdateResult updateResult;
+        CUresult result = cuGraphExecUpdate(existing->second, graph, &errorNode, &updateResult);
+#endif
+        if (result != CUDA_SUCCESS) {
+            cuGraphExecDestroy(existing->second);
+            graphs.erase(existing);
+        }
+    }
+    if (graphs.find(key) == graphs.end()) {
+        CUgraphExec graphExec;
+        CUresult result = cuGraphInstantiateWithFlags(&graphExec, graph, 0);
+        if (result != CUDA_SUCCESS) {
+            cuGraphDestroy(graph);
+            throw OpenMMException("Error instantiating graph: "+getErrorString(result));
+        }
+        graphs[key] = graphExec;
+    }
+    CUresult result = cuGraphLaunch(graphs[key], currentStream);
+    cuGraphDestroy(graph);
+    if (result != CUDA_SUCCESS)
+        throw OpenMMException("Error launching graph: "+getErrorString(result));
+}
+
 int CudaContext::computeThreadBlockSize(double memory) const {
     int maxShared;
     CHECK_RESULT2(cuDeviceGetAttribute(&maxShared, CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK, device), "Error querying device property");
@@ -27,6 +27,7 @@
 #include "CudaIntegrationUtilities.h"
 #include "CudaContext.h"
 #include "openmm/common/ContextSelector.h"
+#include "openmm/internal/TraceRange.h"
 
 using namespace OpenMM;
 using namespace std;
@@ -135,6 +136,7 @@ void CudaIntegrationUtilities::applyConstraintsImpl(bool constrainVelocities, do
 void CudaIntegrationUtilities::distributeForcesFromVirtualSites() {
     ContextSelector selector(context);
     if (numVsites > 0) {
+        OPENMM_TRACE_RANGE("Distribute virtual site forces");
         vsiteForceKernel->setArg(2, context.getLongForceBuffer());
         vsiteForceKernel->execute(numVsites);
     }
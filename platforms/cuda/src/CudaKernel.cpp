@@ -27,6 +27,7 @@
 #include "CudaKernel.h"
 #include "openmm/common/ComputeArray.h"
 #include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/TraceRange.h"
 #include <cstring>
 #include <vector>
 
@@ -49,6 +50,7 @@ int CudaKernel::getMaxBlockSize() const {
 }
 
 void CudaKernel::execute(int threads, int blockSize) {
+    OPENMM_TRACE_RANGE(name);
     int numArgs = arrayArgs.size();
     argPointers.resize(numArgs);
     for (int i = 0; i < numArgs; i++) {
@@ -29,6 +29,7 @@
 #include "openmm/Context.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include "openmm/internal/TraceRange.h"
 #include "openmm/common/ContextSelector.h"
 #include "CommonKernelSources.h"
 #include "CudaBondedUtilities.h"
@@ -54,10 +55,21 @@ using namespace std;
         throw OpenMMException(m.str());\
     }
 
+/**
+ * Get the size of the work area cuFFT allocated for a plan.
+ */
+static long long getFFTWorkSize(cufftHandle plan) {
+    size_t size;
+    if (cufftGetSize(plan, &size) != CUFFT_SUCCESS)
+        return 0;
+    return size;
+}
+
 void CudaCalcForcesAndEnergyKernel::initialize(const System& system) {
 }
 
 void CudaCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
+    OPENMM_TRACE_RANGE("Begin force computation");
     cu.setForcesValid(true);
     ContextSelector selector(cu);
     cu.clearAutoclearBuffers();
@@ -72,9 +84,21 @@ void CudaCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool
 }
 
 double CudaCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bool includeForces, bool includeEnergy, int groups, bool& valid) {
+    OPENMM_TRACE_RANGE("Finish force computation");
     ContextSelector selector(cu);
+    CudaNonbondedUtilities& nb = cu.getNonbondedUtilities();
+
+    // The bonded and nonbonded kernels only depend on data already on the device, so they can be
+    // captured in a graph.  Checking the neighbor list size must wait until after it is launched.
+
+    bool useGraph = cu.getUseCudaGraphs();
+    if (useGraph)
+        cu.beginGraphCapture();
     cu.getBondedUtilities().computeInteractions(groups);
-    cu.getNonbondedUtilities().computeInteractions(groups, includeForces, includeEnergy);
+    nb.executeInteractionKernel(groups, includeForces, includeEnergy);
+    if (useGraph)
+        cu.endGraphCapture(4*(long long) (unsigned int) groups + (includeForces ? 2 : 0) + (includeEnergy ? 1 : 0));
+    nb.checkNeighborListSize(groups);
     double sum = 0.0;
     for (auto computation : cu.getPostComputations())
         sum += computation->computeForceAndEnergy(includeForces, includeEnergy, groups);
@@ -86,6 +110,17 @@ double CudaCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bo
     return sum;
 }
 
+void CudaCalcForcesAndEnergyKernel::synchronize(ContextImpl& context) {
+    ContextSelector selector(cu);
+    cuStreamSynchronize(cu.getCurrentStream());
+}
+
+void CudaCalcForcesAndEnergyKernel::getNeighborListStatistics(ContextImpl& context, map<string, double>& statistics) {
+    cu.getNonbondedUtilities().getNeighborListStatistics(statistics);
+    if (cu.getNonbondedUtilities().getUseCutoff())
+        statistics["Atom Reorders"] = cu.getNumAtomReorders();
+}
+
 void CudaUpdateStateDataKernel::initialize(const System& system) {
 }
 
@@ -170,6 +205,78 @@ void CudaUpdateStateDataKernel::getPositions(ContextImpl& context, vector<Vec3>&
     cu.getPlatformData().threads.waitForThreads();
 }
 
+void CudaUpdateStateDataKernel::gatherSubset(const vector<int>& particles, bool positions, vector<int>& atoms) {
+    // Atoms are reordered on the device, so find where each requested particle is currently stored.
+
+    const vector<int>& order = cu.getAtomIndex();
+    int numAtoms = cu.getNumAtoms();
+    vector<int> inverseOrder(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+        inverseOrder[order[i]] = i;
+    int numSubset = particles.size();
+    atoms.resize(numSubset);
+    for (int i = 0; i < numSubset; i++)
+        atoms[i] = inverseOrder[particles[i]];
+
+    // Copy the requested atoms into a compact array on the device.
+
+    if (!subsetAtoms.isInitialized()) {
+        int elementSize = (cu.getUseDoublePrecision() || cu.getUseMixedPrecision() ? sizeof(double4) : sizeof(float4));
+        subsetAtoms.initialize<int>(cu, numSubset, "subsetAtoms");
+        subsetData.initialize(cu, numSubset, elementSize, "subsetData");
+        ComputeProgram program = cu.compileProgram(CommonKernelSources::gatherState);
+        gatherPositionsKernel = program->createKernel("gatherPositions");
+        gatherPositionsKernel->addArg(cu.getPosq());
+        if (cu.getUseMixedPrecision())
+            gatherPositionsKernel->addArg(cu.getPosqCorrection());
+        for (int i = 0; i < 3; i++)
+            gatherPositionsKernel->addArg();
+        gatherVelocitiesKernel = program->createKernel("gatherVelocities");
+        gatherVelocitiesKernel->addArg(cu.getVelm());
+        for (int i = 0; i < 3; i++)
+            gatherVelocitiesKernel->addArg();
+    }
+    else if (subsetAtoms.getSize() != numSubset) {
+        subsetAtoms.resize(numSubset);
+        subsetData.resize(numSubset);
+    }
+    subsetAtoms.upload(atoms);
+    ComputeKernel& kernel = (positions ? gatherPositionsKernel : gatherVelocitiesKernel);
+    int firstArg = (positions && cu.getUseMixedPrecision() ? 2 : 1);
+    kernel->setArg(firstArg, subsetAtoms);
+    kernel->setArg(firstArg+1, subsetData);
+    kernel->setArg(firstArg+2, numSubset);
+    kernel->execute(numSubset);
+}
+
+void CudaUpdateStateDataKernel::getPositionSubset(ContextImpl& context, const vector<int>& particles, vector<Vec3>& positions) {
+    ContextSelector selector(cu);
+    int numSubset = particles.size();
+    positions.resize(numSubset);
+    if (numSubset == 0)
+        return;
+    vector<int> atoms;
+    gatherSubset(particles, true, atoms);
+    Vec3 boxVectors[3];
+    cu.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    if (cu.getUseDoublePrecision() || cu.getUseMixedPrecision()) {
+        vector<double4> pos;
+        subsetData.download(pos);
+        for (int i = 0; i < numSubset; i++) {
+            mm_int4 offset = cu.getPosCellOffsets()[atoms[i]];
+            positions[i] = Vec3(pos[i].x, pos[i].y, pos[i].z)-boxVectors[0]*offset.x-boxVectors[1]*offset.y-boxVectors[2]*offset.z;
+        }
+    }
+    else {
+        vector<float4> pos;
+        subsetData.download(pos);
+        for (int i = 0; i < numSubset; i++) {
+            mm_int4 offset = cu.getPosCellOffsets()[atoms[i]];
+            positions[i] = Vec3(pos[i].x, pos[i].y, pos[i].z)-boxVectors[0]*offset.x-boxVectors[1]*offset.y-boxVectors[2]*offset.z;
+        }
+    }
+}
+
 void CudaUpdateStateDataKernel::setPositions(ContextImpl& context, const vector<Vec3>& positions) {
     ContextSelector selector(cu);
     const vector<int>& order = cu.getAtomIndex();
@@ -246,6 +353,28 @@ void CudaUpdateStateDataKernel::getVelocities(ContextImpl& context, vector<Vec3>
     }
 }
 
+void CudaUpdateStateDataKernel::getVelocitySubset(ContextImpl& context, const vector<int>& particles, vector<Vec3>& velocities) {
+    ContextSelector selector(cu);
+    int numSubset = particles.size();
+    velocities.resize(numSubset);
+    if (numSubset == 0)
+        return;
+    vector<int> atoms;
+    gatherSubset(particles, false, atoms);
+    if (cu.getUseDoublePrecision() || cu.getUseMixedPrecision()) {
+        vector<double4> vel;
+        subsetData.download(vel);
+        for (int i = 0; i < numSubset; i++)
+            velocities[i] = Vec3(vel[i].x, vel[i].y, vel[i].z);
+    }
+    else {
+        vector<float4> vel;
+        subsetData.download(vel);
+        for (int i = 0; i < numSubset; i++)
+            velocities[i] = Vec3(vel[i].x, vel[i].y, vel[i].z);
+    }
+}
+
 void CudaUpdateStateDataKernel::setVelocities(ContextImpl& context, const vector<Vec3>& velocities) {
     ContextSelector selector(cu);
     const vector<int>& order = cu.getAtomIndex();
@@ -526,11 +655,15 @@ private:
 
 class CudaCalcNonbondedForceKernel::SyncStreamPostComputation : public CudaContext::ForcePostComputation {
 public:
-    SyncStreamPostComputation(CudaContext& cu, CUevent event, CUfunction addEnergyKernel, CudaArray& pmeEnergyBuffer, int forceGroup) : cu(cu), event(event),
-            addEnergyKernel(addEnergyKernel), pmeEnergyBuffer(pmeEnergyBuffer), forceGroup(forceGroup) {
+    SyncStreamPostComputation(CudaContext& cu, CUevent event, CUevent waitEvent, CUfunction addEnergyKernel, CudaArray& pmeEnergyBuffer, int forceGroup) : cu(cu), event(event),
+            waitEvent(waitEvent), addEnergyKernel(addEnergyKernel), pmeEnergyBuffer(pmeEnergyBuffer), forceGroup(forceGroup) {
     }
     double computeForceAndEnergy(bool includeForces, bool includeEnergy, int groups) {
         if ((groups&(1<<forceGroup)) != 0) {
+            // Record when the main stream reached this point, so getPmeStreamTiming() can tell how
+            // long it had to wait for the PME stream.
+
+            cuEventRecord(waitEvent, cu.getCurrentStream());
             cuStreamWaitEvent(cu.getCurrentStream(), event, 0);
             if (includeEnergy) {
                 int bufferSize = pmeEnergyBuffer.getSize();
@@ -542,7 +675,7 @@ public:
     }
 private:
     CudaContext& cu;
-    CUevent event;
+    CUevent event, waitEvent;
     CUfunction addEnergyKernel;
     CudaArray& pmeEnergyBuffer;
     int forceGroup;
@@ -560,9 +693,11 @@ CudaCalcNonbondedForceKernel::~CudaCalcNonbondedForceKernel() {
         delete pmeio;
     if (hasInitializedFFT) {
         if (useCudaFFT) {
+            cu.recordMemoryUsage("PME", -(getFFTWorkSize(fftForward)+getFFTWorkSize(fftBackward)));
             cufftDestroy(fftForward);
             cufftDestroy(fftBackward);
             if (doLJPME) {
+                cu.recordMemoryUsage("PME", -(getFFTWorkSize(dispersionFftForward)+getFFTWorkSize(dispersionFftBackward)));
                 cufftDestroy(dispersionFftForward);
                 cufftDestroy(dispersionFftBackward);                
             }
@@ -571,6 +706,9 @@ CudaCalcNonbondedForceKernel::~CudaCalcNonbondedForceKernel() {
             cuStreamDestroy(pmeStream);
             cuEventDestroy(pmeSyncEvent);
             cuEventDestroy(paramsSyncEvent);
+            cuEventDestroy(pmeStartEvent);
+            cuEventDestroy(pmeEndEvent);
+            cuEventDestroy(pmeWaitEvent);
         }
     }
 }
@@ -718,6 +856,8 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
     else if (((nonbondedMethod == PME || nonbondedMethod == LJPME) && hasCoulomb) || doLJPME) {
         // Compute the PME parameters.
 
+        if (force.getPMEOrder() != PmeOrder)
+            throw OpenMMException("NonbondedForce: The CUDA platform only supports a PME order of 5");
         NonbondedForceImpl::calcPMEParameters(system, force, alpha, gridSizeX, gridSizeY, gridSizeZ, false);
         gridSizeX = CudaFFT3D::findLegalDimension(gridSizeX);
         gridSizeY = CudaFFT3D::findLegalDimension(gridSizeY);
@@ -795,7 +935,7 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
                 pmeSpreadChargeKernel = cu.getKernel(module, "gridSpreadCharge");
                 pmeConvolutionKernel = cu.getKernel(module, "reciprocalConvolution");
                 pmeInterpolateForceKernel = cu.getKernel(module, "gridInterpolateForce");
-                pmeEvalEnergyKernel = cu.getKernel(module, "gridEvaluateEnergy");
+                pmeConvolutionEnergyKernel = cu.getKernel(module, "reciprocalConvolutionWithEnergy");
                 pmeFinishSpreadChargeKernel = cu.getKernel(module, "finishSpreadCharge");
                 cuFuncSetCacheConfig(pmeSpreadChargeKernel, CU_FUNC_CACHE_PREFER_SHARED);
                 cuFuncSetCacheConfig(pmeInterpolateForceKernel, CU_FUNC_CACHE_PREFER_L1);
@@ -814,13 +954,14 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
                     pmeDispersionGridIndexKernel = cu.getKernel(module, "findAtomGridIndex");
                     pmeDispersionSpreadChargeKernel = cu.getKernel(module, "gridSpreadCharge");
                     pmeDispersionConvolutionKernel = cu.getKernel(module, "reciprocalConvolution");
-                    pmeEvalDispersionEnergyKernel = cu.getKernel(module, "gridEvaluateEnergy");
+                    pmeDispersionConvolutionEnergyKernel = cu.getKernel(module, "reciprocalConvolutionWithEnergy");
                     pmeInterpolateDispersionForceKernel = cu.getKernel(module, "gridInterpolateForce");
                     cuFuncSetCacheConfig(pmeDispersionSpreadChargeKernel, CU_FUNC_CACHE_PREFER_L1);
                 }
 
                 // Create required data structures.
 
+                ComputeContext::MemoryCategory category(cu, "PME");
                 int elementSize = (cu.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
                 int roundedZSize = PmeOrder*(int) ceil(gridSizeZ/(double) PmeOrder);
                 int gridElements = gridSizeX*gridSizeY*roundedZSize;
@@ -854,6 +995,7 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
                     result = cufftPlan3d(&fftBackward, gridSizeX, gridSizeY, gridSizeZ, cu.getUseDoublePrecision() ? CUFFT_Z2D : CUFFT_C2R);
                     if (result != CUFFT_SUCCESS)
                         throw OpenMMException("Error initializing FFT: "+cu.intToString(result));
+                    cu.recordMemoryUsage("PME", getFFTWorkSize(fftForward)+getFFTWorkSize(fftBackward));
                     if (doLJPME) {
                         result = cufftPlan3d(&dispersionFftForward, dispersionGridSizeX, dispersionGridSizeY, 
                                                 dispersionGridSizeZ, cu.getUseDoublePrecision() ? CUFFT_D2Z : CUFFT_R2C);
@@ -863,6 +1005,7 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
                                              dispersionGridSizeZ, cu.getUseDoublePrecision() ? CUFFT_Z2D : CUFFT_C2R);
                         if (result != CUFFT_SUCCESS)
                             throw OpenMMException("Error initializing disperison FFT: "+cu.intToString(result));
+                        cu.recordMemoryUsage("PME", getFFTWorkSize(dispersionFftForward)+getFFTWorkSize(dispersionFftBackward));
                     }
                 }
                 else {
@@ -874,7 +1017,12 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
                 // Prepare for doing PME on its own stream.
 
                 if (usePmeStream) {
-                    cuStreamCreate(&pmeStream, CU_STREAM_NON_BLOCKING);
+                    // Give the PME stream the highest priority.  Reciprocal space is usually on the critical
+                    // path, while the direct space kernels can fill in whatever resources it leaves unused.
+
+                    int leastPriority, greatestPriority;
+                    CHECK_RESULT(cuCtxGetStreamPriorityRange(&leastPriority, &greatestPriority), "Error querying stream priorities");
+                    CHECK_RESULT(cuStreamCreateWithPriority(&pmeStream, CU_STREAM_NON_BLOCKING, greatestPriority), "Error creating stream for NonbondedForce");
                     if (useCudaFFT) {
                         cufftSetStream(fftForward, pmeStream);
                         cufftSetStream(fftBackward, pmeStream);
@@ -885,11 +1033,14 @@ void CudaCalcNonbondedForceKernel::initialize(const System& system, const Nonbon
                     }
                     CHECK_RESULT(cuEventCreate(&pmeSyncEvent, cu.getEventFlags()), "Error creating event for NonbondedForce");
                     CHECK_RESULT(cuEventCreate(&paramsSyncEvent, cu.getEventFlags()), "Error creating event for NonbondedForce");
+                    CHECK_RESULT(cuEventCreate(&pmeStartEvent, CU_EVENT_DEFAULT), "Error creating event for NonbondedForce");
+                    CHECK_RESULT(cuEventCreate(&pmeEndEvent, CU_EVENT_DEFAULT), "Error creating event for NonbondedForce");
+                    CHECK_RESULT(cuEventCreate(&pmeWaitEvent, CU_EVENT_DEFAULT), "Error creating event for NonbondedForce");
                     int recipForceGroup = force.getReciprocalSpaceForceGroup();
                     if (recipForceGroup < 0)
                         recipForceGroup = force.getForceGroup();
                     cu.addPreComputation(new SyncStreamPreComputation(cu, pmeStream, pmeSyncEvent, recipForceGroup));
-                    cu.addPostComputation(new SyncStreamPostComputation(cu, pmeSyncEvent, cu.getKernel(module, "addEnergy"), pmeEnergyBuffer, recipForceGroup));
+                    cu.addPostComputation(new SyncStreamPostComputation(cu, pmeSyncEvent, pmeWaitEvent, cu.getKernel(module, "addEnergy"), pmeEnergyBuffer, recipForceGroup));
                 }
                 hasInitializedFFT = true;
 
@@ -1194,14 +1345,18 @@ double CudaCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeF
     // Do reciprocal space calculations.
     
     if (cosSinSums.isInitialized() && includeReciprocal) {
+        OPENMM_TRACE_RANGE("Ewald reciprocal space");
         void* sumsArgs[] = {&cu.getEnergyBuffer().getDevicePointer(), &cu.getPosq().getDevicePointer(), &cosSinSums.getDevicePointer(), cu.getPeriodicBoxSizePointer()};
         cu.executeKernel(ewaldSumsKernel, sumsArgs, cosSinSums.getSize());
         void* forcesArgs[] = {&cu.getForce().getDevicePointer(), &cu.getPosq().getDevicePointer(), &cosSinSums.getDevicePointer(), cu.getPeriodicBoxSizePointer()};
         cu.executeKernel(ewaldForcesKernel, forcesArgs, cu.getNumAtoms());
     }
     if (pmeGrid1.isInitialized() && includeReciprocal) {
-        if (usePmeStream)
+        OPENMM_TRACE_RANGE("PME reciprocal space");
+        if (usePmeStream) {
             cu.setCurrentStream(pmeStream);
+            cuEventRecord(pmeStartEvent, pmeStream);
+        }
 
         // Invert the periodic box vectors.
 
@@ -1264,37 +1419,45 @@ double CudaCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeF
             }
 
             if (includeEnergy) {
-                void* computeEnergyArgs[] = {&pmeGrid2.getDevicePointer(), usePmeStream ? &pmeEnergyBuffer.getDevicePointer() : &cu.getEnergyBuffer().getDevicePointer(),
+                // Compute the energy and apply the convolution in a single pass over the grid.
+
+                void* convolutionArgs[] = {&pmeGrid2.getDevicePointer(), usePmeStream ? &pmeEnergyBuffer.getDevicePointer() : &cu.getEnergyBuffer().getDevicePointer(),
                         &pmeBsplineModuliX.getDevicePointer(), &pmeBsplineModuliY.getDevicePointer(), &pmeBsplineModuliZ.getDevicePointer(),
                         recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2]};
-                cu.executeKernel(pmeEvalEnergyKernel, computeEnergyArgs, gridSizeX*gridSizeY*gridSizeZ);
+                cu.executeKernel(pmeConvolutionEnergyKernel, convolutionArgs, gridSizeX*gridSizeY*gridSizeZ);
+            }
+            else {
+                void* convolutionArgs[] = {&pmeGrid2.getDevicePointer(), &pmeBsplineModuliX.getDevicePointer(),
+                        &pmeBsplineModuliY.getDevicePointer(), &pmeBsplineModuliZ.getDevicePointer(),
+                        recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2]};
+                cu.executeKernel(pmeConvolutionKernel, convolutionArgs, gridSizeX*gridSizeY*gridSizeZ, 256);
             }
 
-            void* convolutionArgs[] = {&pmeGrid2.getDevicePointer(), &pmeBsplineModuliX.getDevicePointer(),
-                    &pmeBsplineModuliY.getDevicePointer(), &pmeBsplineModuliZ.getDevicePointer(),
-                    recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2]};
-            cu.executeKernel(pmeConvolutionKernel, convolutionArgs, gridSizeX*gridSizeY*gridSizeZ, 256);
+            // The energy is computed during the convolution, so the inverse FFT and force interpolation are
+            // only needed when forces are requested.
 
-            if (useCudaFFT) {
-                if (cu.getUseDoublePrecision()) {
-                    cufftResult result = cufftExecZ2D(fftBackward, (double2*) pmeGrid2.getDevicePointer(), (double*) pmeGrid1.getDevicePointer());
-                    if (result != CUFFT_SUCCESS)
-                        throw OpenMMException("Error executing FFT: "+cu.intToString(result));
-                } else {
-                    cufftResult result = cufftExecC2R(fftBackward, (float2*) pmeGrid2.getDevicePointer(), (float*)  pmeGrid1.getDevicePointer());
-                    if (result != CUFFT_SUCCESS)
-                        throw OpenMMException("Error executing FFT: "+cu.intToString(result));
+            if (includeForces) {
+                if (useCudaFFT) {
+                    if (cu.getUseDoublePrecision()) {
+                        cufftResult result = cufftExecZ2D(fftBackward, (double2*) pmeGrid2.getDevicePointer(), (double*) pmeGrid1.getDevicePointer());
+                        if (result != CUFFT_SUCCESS)
+                            throw OpenMMException("Error executing FFT: "+cu.intToString(result));
+                    } else {
+                        cufftResult result = cufftExecC2R(fftBackward, (float2*) pmeGrid2.getDevicePointer(), (float*)  pmeGrid1.getDevicePointer());
+                        if (result != CUFFT_SUCCESS)
+                            throw OpenMMException("Error executing FFT: "+cu.intToString(result));
+                    }
+                }
+                else {
+                    fft->execFFT(pmeGrid2, pmeGrid1, false);
                 }
-            }
-            else {
-                fft->execFFT(pmeGrid2, pmeGrid1, false);
-            }
 
-            void* interpolateArgs[] = {&cu.getPosq().getDevicePointer(), &cu.getForce().getDevicePointer(), &pmeGrid1.getDevicePointer(), cu.getPeriodicBoxSizePointer(),
-                    cu.getInvPeriodicBoxSizePointer(), cu.getPeriodicBoxVecXPointer(), cu.getPeriodicBoxVecYPointer(), cu.getPeriodicBoxVecZPointer(),
-                    recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2], &pmeAtomGridIndex.getDevicePointer(),
-                    &charges.getDevicePointer()};
-            cu.executeKernel(pmeInterpolateForceKernel, interpolateArgs, cu.getNumAtoms(), 128);
+                void* interpolateArgs[] = {&cu.getPosq().getDevicePointer(), &cu.getForce().getDevicePointer(), &pmeGrid1.getDevicePointer(), cu.getPeriodicBoxSizePointer(),
+                        cu.getInvPeriodicBoxSizePointer(), cu.getPeriodicBoxVecXPointer(), cu.getPeriodicBoxVecYPointer(), cu.getPeriodicBoxVecZPointer(),
+                        recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2], &pmeAtomGridIndex.getDevicePointer(),
+                        &charges.getDevicePointer()};
+                cu.executeKernel(pmeInterpolateForceKernel, interpolateArgs, cu.getNumAtoms(), 128);
+            }
         }
 
         if (doLJPME && hasLJ) {
@@ -1334,41 +1497,48 @@ double CudaCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeF
             }
 
             if (includeEnergy) {
-                void* computeEnergyArgs[] = {&pmeGrid2.getDevicePointer(), usePmeStream ? &pmeEnergyBuffer.getDevicePointer() : &cu.getEnergyBuffer().getDevicePointer(),
+                void* convolutionArgs[] = {&pmeGrid2.getDevicePointer(), usePmeStream ? &pmeEnergyBuffer.getDevicePointer() : &cu.getEnergyBuffer().getDevicePointer(),
                         &pmeDispersionBsplineModuliX.getDevicePointer(), &pmeDispersionBsplineModuliY.getDevicePointer(), &pmeDispersionBsplineModuliZ.getDevicePointer(),
                         recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2]};
-                cu.executeKernel(pmeEvalDispersionEnergyKernel, computeEnergyArgs, dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ);
+                cu.executeKernel(pmeDispersionConvolutionEnergyKernel, convolutionArgs, dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ);
+            }
+            else {
+                void* convolutionArgs[] = {&pmeGrid2.getDevicePointer(), &pmeDispersionBsplineModuliX.getDevicePointer(),
+                        &pmeDispersionBsplineModuliY.getDevicePointer(), &pmeDispersionBsplineModuliZ.getDevicePointer(),
+                        recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2]};
+                cu.executeKernel(pmeDispersionConvolutionKernel, convolutionArgs, dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ, 256);
             }
 
-            void* convolutionArgs[] = {&pmeGrid2.getDevicePointer(), &pmeDispersionBsplineModuliX.getDevicePointer(),
-                    &pmeDispersionBsplineModuliY.getDevicePointer(), &pmeDispersionBsplineModuliZ.getDevicePointer(),
-                    recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2]};
-            cu.executeKernel(pmeDispersionConvolutionKernel, convolutionArgs, dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ, 256);
+            // As above, the inverse FFT and force interpolation are only needed when forces are requested.
 
-            if (useCudaFFT) {
-                if (cu.getUseDoublePrecision()) {
-                    cufftResult result = cufftExecZ2D(dispersionFftBackward, (double2*) pmeGrid2.getDevicePointer(), (double*) pmeGrid1.getDevicePointer());
-                    if (result != CUFFT_SUCCESS)
-                        throw OpenMMException("Error executing FFT: "+cu.intToString(result));
-                } else {
-                    cufftResult result = cufftExecC2R(dispersionFftBackward, (float2*) pmeGrid2.getDevicePointer(), (float*)  pmeGrid1.getDevicePointer());
-                    if (result != CUFFT_SUCCESS)
-                        throw OpenMMException("Error executing FFT: "+cu.intToString(result));
+            if (includeForces) {
+                if (useCudaFFT) {
+                    if (cu.getUseDoublePrecision()) {
+                        cufftResult result = cufftExecZ2D(dispersionFftBackward, (double2*) pmeGrid2.getDevicePointer(), (double*) pmeGrid1.getDevicePointer());
+                        if (result != CUFFT_SUCCESS)
+                            throw OpenMMException("Error executing FFT: "+cu.intToString(result));
+                    } else {
+                        cufftResult result = cufftExecC2R(dispersionFftBackward, (float2*) pmeGrid2.getDevicePointer(), (float*)  pmeGrid1.getDevicePointer());
+                        if (result != CUFFT_SUCCESS)
+                            throw OpenMMException("Error executing FFT: "+cu.intToString(result));
+                    }
+                }
+                else {
+                    dispersionFft->execFFT(pmeGrid2, pmeGrid1, false);
                 }
-            }
-            else {
-                dispersionFft->execFFT(pmeGrid2, pmeGrid1, false);
-            }
 
-            void* interpolateArgs[] = {&cu.getPosq().getDevicePointer(), &cu.getForce().getDevicePointer(), &pmeGrid1.getDevicePointer(), cu.getPeriodicBoxSizePointer(),
-                    cu.getInvPeriodicBoxSizePointer(), cu.getPeriodicBoxVecXPointer(), cu.getPeriodicBoxVecYPointer(), cu.getPeriodicBoxVecZPointer(),
-                    recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2], &pmeAtomGridIndex.getDevicePointer(),
-                    &sigmaEpsilon.getDevicePointer()};
-            cu.executeKernel(pmeInterpolateDispersionForceKernel, interpolateArgs, cu.getNumAtoms(), 128);
+                void* interpolateArgs[] = {&cu.getPosq().getDevicePointer(), &cu.getForce().getDevicePointer(), &pmeGrid1.getDevicePointer(), cu.getPeriodicBoxSizePointer(),
+                        cu.getInvPeriodicBoxSizePointer(), cu.getPeriodicBoxVecXPointer(), cu.getPeriodicBoxVecYPointer(), cu.getPeriodicBoxVecZPointer(),
+                        recipBoxVectorPointer[0], recipBoxVectorPointer[1], recipBoxVectorPointer[2], &pmeAtomGridIndex.getDevicePointer(),
+                        &sigmaEpsilon.getDevicePointer()};
+                cu.executeKernel(pmeInterpolateDispersionForceKernel, interpolateArgs, cu.getNumAtoms(), 128);
+            }
         }
         if (usePmeStream) {
+            cuEventRecord(pmeEndEvent, pmeStream);
             cuEventRecord(pmeSyncEvent, pmeStream);
             cu.restoreDefaultStream();
+            hasPmeTiming = true;
         }
     }
 
@@ -1475,6 +1645,21 @@ void CudaCalcNonbondedForceKernel::getPMEParameters(double& alpha, int& nx, int&
     }
 }
 
+bool CudaCalcNonbondedForceKernel::getPmeStreamTiming(double& pmeTime, double& stallTime) {
+    if (!hasPmeTiming)
+        return false;
+    ContextSelector selector(cu);
+    if (cuEventSynchronize(pmeEndEvent) != CUDA_SUCCESS || cuEventSynchronize(pmeWaitEvent) != CUDA_SUCCESS)
+        return false;
+    float pmeMillis, stallMillis;
+    if (cuEventElapsedTime(&pmeMillis, pmeStartEvent, pmeEndEvent) != CUDA_SUCCESS ||
+            cuEventElapsedTime(&stallMillis, pmeWaitEvent, pmeEndEvent) != CUDA_SUCCESS)
+        return false;
+    pmeTime = pmeMillis;
+    stallTime = max(0.0f, stallMillis);
+    return true;
+}
+
 void CudaCalcNonbondedForceKernel::getLJPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
     if (!doLJPME)
         throw OpenMMException("getPMEParametersInContext: This Context is not using PME");
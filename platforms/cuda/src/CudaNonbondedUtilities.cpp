@@ -31,9 +31,12 @@
 #include "CudaKernelSources.h"
 #include "CudaExpressionUtilities.h"
 #include "CudaSort.h"
+#include "openmm/common/ContextSelector.h"
+#include "openmm/internal/TraceRange.h"
 #include <algorithm>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
 
 using namespace OpenMM;
@@ -64,14 +67,15 @@ private:
 };
 
 CudaNonbondedUtilities::CudaNonbondedUtilities(CudaContext& context) : context(context), useCutoff(false), usePeriodic(false), useNeighborList(false), anyExclusions(false), usePadding(true),
-        blockSorter(NULL), pinnedCountBuffer(NULL), forceRebuildNeighborList(true), lastCutoff(0.0), groupFlags(0), canUsePairList(true), tilesAfterReorder(0) {
+        blockSorter(NULL), pinnedCountBuffer(NULL), forceRebuildNeighborList(true), lastCutoff(0.0), groupFlags(0), canUsePairList(true), tilesAfterReorder(0),
+        numNeighborListChecks(0), numNeighborListBuilds(0), numNeighborListReallocations(0) {
     // Decide how many thread blocks to use.
 
     string errorMessage = "Error initializing nonbonded utilities";
     int multiprocessors;
     CHECK_RESULT(cuDeviceGetAttribute(&multiprocessors, CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, context.getDevice()));
     CHECK_RESULT(cuEventCreate(&downloadCountEvent, context.getEventFlags()));
-    CHECK_RESULT(cuMemHostAlloc((void**) &pinnedCountBuffer, 2*sizeof(unsigned int), CU_MEMHOSTALLOC_PORTABLE));
+    CHECK_RESULT(cuMemHostAlloc((void**) &pinnedCountBuffer, 3*sizeof(unsigned int), CU_MEMHOSTALLOC_PORTABLE));
     numForceThreadBlocks = 4*multiprocessors;
     forceThreadBlockSize = (context.getComputeCapability() < 2.0 ? 128 : 256);
     setKernelSource(CudaKernelSources::nonbonded);
@@ -151,13 +155,14 @@ void CudaNonbondedUtilities::requestExclusions(const vector<vector<int> >& exclu
     if (anyExclusions) {
         bool sameExclusions = (exclusionList.size() == atomExclusions.size());
         for (int i = 0; i < (int) exclusionList.size() && sameExclusions; i++) {
-             if (exclusionList[i].size() != atomExclusions[i].size())
-                 sameExclusions = false;
-            set<int> expectedExclusions;
-            expectedExclusions.insert(atomExclusions[i].begin(), atomExclusions[i].end());
-            for (int j = 0; j < (int) exclusionList[i].size(); j++)
-                if (expectedExclusions.find(exclusionList[i][j]) == expectedExclusions.end())
-                     sameExclusions = false;
+            if (exclusionList[i].size() != atomExclusions[i].size()) {
+                sameExclusions = false;
+                break;
+            }
+            vector<int> expected = atomExclusions[i], requested = exclusionList[i];
+            sort(expected.begin(), expected.end());
+            sort(requested.begin(), requested.end());
+            sameExclusions = (expected == requested);
         }
         if (!sameExclusions)
             throw OpenMMException("All Forces must have identical exceptions");
@@ -174,6 +179,7 @@ static bool compareInt2(int2 a, int2 b) {
 
 void CudaNonbondedUtilities::initialize(const System& system) {
     string errorMessage = "Error initializing nonbonded utilities";    
+    ComputeContext::MemoryCategory category(context, "Nonbonded");
     if (atomExclusions.size() == 0) {
         // No exclusions were specifically requested, so just mark every atom as not interacting with itself.
         
@@ -189,34 +195,42 @@ void CudaNonbondedUtilities::initialize(const System& system) {
     int numContexts = context.getPlatformData().contexts.size();
     setAtomBlockRange(context.getContextIndex()/(double) numContexts, (context.getContextIndex()+1)/(double) numContexts);
 
-    // Build a list of tiles that contain exclusions.
+    // Build a list of tiles that contain exclusions.  Each tile is encoded as a single 64 bit key, so they can
+    // be found by sorting rather than by inserting into a set.  Consecutive exclusions of an atom usually fall
+    // in the same tile, so skip repeats as they are generated to keep the list short.
 
-    set<pair<int, int> > tilesWithExclusions;
+    vector<long long> tilesWithExclusions;
     for (int atom1 = 0; atom1 < (int) atomExclusions.size(); ++atom1) {
         int x = atom1/CudaContext::TileSize;
-        for (int j = 0; j < (int) atomExclusions[atom1].size(); ++j) {
-            int atom2 = atomExclusions[atom1][j];
+        for (int atom2 : atomExclusions[atom1]) {
             int y = atom2/CudaContext::TileSize;
-            tilesWithExclusions.insert(make_pair(max(x, y), min(x, y)));
+            long long key = (((long long) max(x, y))<<32)+min(x, y);
+            if (tilesWithExclusions.empty() || tilesWithExclusions.back() != key)
+                tilesWithExclusions.push_back(key);
         }
     }
+    sort(tilesWithExclusions.begin(), tilesWithExclusions.end());
+    tilesWithExclusions.erase(unique(tilesWithExclusions.begin(), tilesWithExclusions.end()), tilesWithExclusions.end());
     vector<int2> exclusionTilesVec;
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter)
-        exclusionTilesVec.push_back(make_int2(iter->first, iter->second));
+    for (long long key : tilesWithExclusions)
+        exclusionTilesVec.push_back(make_int2((int) (key>>32), (int) (key&0xFFFFFFFF)));
     sort(exclusionTilesVec.begin(), exclusionTilesVec.end(), compareInt2);
     exclusionTiles.initialize<int2>(context, exclusionTilesVec.size(), "exclusionTiles");
     exclusionTiles.upload(exclusionTilesVec);
-    map<pair<int, int>, int> exclusionTileMap;
+    unordered_map<long long, int> exclusionTileMap;
+    exclusionTileMap.reserve(exclusionTilesVec.size());
     for (int i = 0; i < (int) exclusionTilesVec.size(); i++) {
         int2 tile = exclusionTilesVec[i];
-        exclusionTileMap[make_pair(tile.x, tile.y)] = i;
+        exclusionTileMap[(((long long) tile.x)<<32)+tile.y] = i;
     }
     vector<vector<int> > exclusionBlocksForBlock(numAtomBlocks);
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter) {
-        exclusionBlocksForBlock[iter->first].push_back(iter->second);
-        if (iter->first != iter->second)
-            exclusionBlocksForBlock[iter->second].push_back(iter->first);
+    for (int2 tile : exclusionTilesVec) {
+        exclusionBlocksForBlock[tile.x].push_back(tile.y);
+        if (tile.x != tile.y)
+            exclusionBlocksForBlock[tile.y].push_back(tile.x);
     }
+    for (vector<int>& blocks : exclusionBlocksForBlock)
+        sort(blocks.begin(), blocks.end());
     vector<unsigned int> exclusionRowIndicesVec(numAtomBlocks+1, 0);
     vector<unsigned int> exclusionIndicesVec;
     for (int i = 0; i < numAtomBlocks; i++) {
@@ -244,11 +258,11 @@ void CudaNonbondedUtilities::initialize(const System& system) {
             int y = atom2/CudaContext::TileSize;
             int offset2 = atom2-y*CudaContext::TileSize;
             if (x > y) {
-                int index = exclusionTileMap[make_pair(x, y)]*CudaContext::TileSize;
+                int index = exclusionTileMap[(((long long) x)<<32)+y]*CudaContext::TileSize;
                 exclusionVec[index+offset1] &= allFlags-(1<<offset2);
             }
             else {
-                int index = exclusionTileMap[make_pair(y, x)]*CudaContext::TileSize;
+                int index = exclusionTileMap[(((long long) y)<<32)+x]*CudaContext::TileSize;
                 exclusionVec[index+offset2] &= allFlags-(1<<offset1);
             }
         }
@@ -268,10 +282,14 @@ void CudaNonbondedUtilities::initialize(const System& system) {
         if (maxTiles < 1)
             maxTiles = 1;
         maxSinglePairs = 5*numAtoms;
-        interactingTiles.initialize<int>(context, maxTiles, "interactingTiles");
-        interactingAtoms.initialize<int>(context, CudaContext::TileSize*maxTiles, "interactingAtoms");
-        interactionCount.initialize<unsigned int>(context, 2, "interactionCount");
-        singlePairs.initialize<int2>(context, maxSinglePairs, "singlePairs");
+        {
+            ComputeContext::MemoryCategory listCategory(context, "Neighbor List");
+            interactingTiles.initialize<int>(context, maxTiles, "interactingTiles");
+            interactingAtoms.initialize<int>(context, CudaContext::TileSize*maxTiles, "interactingAtoms");
+            interactionCount.initialize<unsigned int>(context, 2, "interactionCount");
+            tileCounter.initialize<unsigned int>(context, 1, "tileCounter");
+            singlePairs.initialize<int2>(context, maxSinglePairs, "singlePairs");
+        }
         int elementSize = (context.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
         blockCenter.initialize(context, numAtomBlocks, 4*elementSize, "blockCenter");
         blockBoundingBox.initialize(context, numAtomBlocks, 4*elementSize, "blockBoundingBox");
@@ -309,6 +327,7 @@ void CudaNonbondedUtilities::initialize(const System& system) {
         forceArgs.push_back(&interactingAtoms.getDevicePointer());
         forceArgs.push_back(&maxSinglePairs);
         forceArgs.push_back(&singlePairs.getDevicePointer());
+        forceArgs.push_back(&tileCounter.getDevicePointer());
     }
     for (int i = 0; i < (int) parameters.size(); i++)
         forceArgs.push_back(&parameters[i].getMemory());
@@ -393,6 +412,7 @@ void CudaNonbondedUtilities::prepareInteractions(int forceGroups) {
 
     // Compute the neighbor list.
 
+    OPENMM_TRACE_RANGE("Build neighbor list");
     if (lastCutoff != kernels.cutoffDistance)
         forceRebuildNeighborList = true;
     context.executeKernel(kernels.findBlockBoundsKernel, &findBlockBoundsArgs[0], context.getNumAtoms());
@@ -402,25 +422,63 @@ void CudaNonbondedUtilities::prepareInteractions(int forceGroups) {
     forceRebuildNeighborList = false;
     lastCutoff = kernels.cutoffDistance;
     interactionCount.download(pinnedCountBuffer, false);
+    rebuildNeighborList.download(&pinnedCountBuffer[2], false);
     cuEventRecord(downloadCountEvent, context.getCurrentStream());
 }
 
 void CudaNonbondedUtilities::computeInteractions(int forceGroups, bool includeForces, bool includeEnergy) {
+    executeInteractionKernel(forceGroups, includeForces, includeEnergy);
+    checkNeighborListSize(forceGroups);
+}
+
+void CudaNonbondedUtilities::executeInteractionKernel(int forceGroups, bool includeForces, bool includeEnergy) {
     if ((forceGroups&groupFlags) == 0)
         return;
     KernelSet& kernels = groupKernels[forceGroups];
     if (kernels.hasForces) {
+        OPENMM_TRACE_RANGE("Nonbonded interactions");
         CUfunction& kernel = (includeForces ? (includeEnergy ? kernels.forceEnergyKernel : kernels.forceKernel) : kernels.energyKernel);
         if (kernel == NULL)
             kernel = createInteractionKernel(kernels.source, parameters, arguments, true, true, forceGroups, includeForces, includeEnergy);
+        if (useNeighborList)
+            context.clearBuffer(tileCounter);
         context.executeKernel(kernel, &forceArgs[0], numForceThreadBlocks*forceThreadBlockSize, forceThreadBlockSize);
     }
+}
+
+void CudaNonbondedUtilities::checkNeighborListSize(int forceGroups) {
+    if ((forceGroups&groupFlags) == 0)
+        return;
     if (useNeighborList && numTiles > 0) {
+        OPENMM_TRACE_RANGE("Check neighbor list size");
         cuEventSynchronize(downloadCountEvent);
+        numNeighborListChecks++;
+        if (pinnedCountBuffer[2] != 0)
+            numNeighborListBuilds++;
         updateNeighborListSize();
     }
 }
 
+void CudaNonbondedUtilities::getNeighborListStatistics(map<string, double>& statistics) {
+    if (!useNeighborList || numTiles == 0)
+        return;
+    statistics["Neighbor List Checks"] = numNeighborListChecks;
+    statistics["Neighbor List Builds"] = numNeighborListBuilds;
+    statistics["Neighbor List Reallocations"] = numNeighborListReallocations;
+    if (numNeighborListChecks == 0)
+        return;
+    ContextSelector selector(context);
+    vector<unsigned int> count;
+    interactionCount.download(count);
+    int numInteractingTiles = min(count[0], maxTiles);
+    long long numPairs, numPairsInCutoff;
+    context.countNeighborListPairs(numInteractingTiles, getMaxCutoffDistance(), numPairs, numPairsInCutoff);
+    statistics["Interacting Tiles"] = numInteractingTiles;
+    statistics["Single Pairs"] = min(count[1], maxSinglePairs);
+    statistics["Neighbor List Pairs"] = numPairs;
+    statistics["Pairs Within Cutoff"] = numPairsInCutoff;
+}
+
 bool CudaNonbondedUtilities::updateNeighborListSize() {
     if (!useCutoff)
         return false;
@@ -428,16 +486,22 @@ bool CudaNonbondedUtilities::updateNeighborListSize() {
         tilesAfterReorder = pinnedCountBuffer[0];
     else if (context.getStepsSinceReorder() > 25 && pinnedCountBuffer[0] > 1.1*tilesAfterReorder)
         context.forceReorder();
-    if (pinnedCountBuffer[0] <= maxTiles && pinnedCountBuffer[1] <= maxSinglePairs)
+    unsigned int numBlocks = context.getNumAtomBlocks();
+    unsigned int totalTiles = numBlocks*(numBlocks+1)/2;
+    bool overflow = (pinnedCountBuffer[0] > maxTiles || pinnedCountBuffer[1] > maxSinglePairs);
+    bool growTiles = (pinnedCountBuffer[0] > 0.9*maxTiles && maxTiles < totalTiles);
+    bool growPairs = (pinnedCountBuffer[1] > 0.9*maxSinglePairs);
+    if (!growTiles && !growPairs)
         return false;
 
-    // The most recent timestep had too many interactions to fit in the arrays.  Make the arrays bigger to prevent
-    // this from happening in the future.
+    // Either the most recent timestep had too many interactions to fit in the arrays, or they are nearly full.
+    // Make the arrays bigger to prevent this from happening in the future.  Growing them before they overflow
+    // (for example, as a barostat compresses the box) only requires rebuilding the neighbor list, whereas an
+    // overflow also requires the forces to be recomputed.
 
-    if (pinnedCountBuffer[0] > maxTiles) {
-        maxTiles = (unsigned int) (1.2*pinnedCountBuffer[0]);
-        unsigned int numBlocks = context.getNumAtomBlocks();
-        int totalTiles = numBlocks*(numBlocks+1)/2;
+    numNeighborListReallocations++;
+    if (growTiles) {
+        maxTiles = (unsigned int) (1.2*max(pinnedCountBuffer[0], maxTiles));
         if (maxTiles > totalTiles)
             maxTiles = totalTiles;
         interactingTiles.resize(maxTiles);
@@ -449,14 +513,16 @@ bool CudaNonbondedUtilities::updateNeighborListSize() {
             forceArgs[17] = &interactingAtoms.getDevicePointer();
         findInteractingBlocksArgs[7] = &interactingAtoms.getDevicePointer();
     }
-    if (pinnedCountBuffer[1] > maxSinglePairs) {
-        maxSinglePairs = (unsigned int) (1.2*pinnedCountBuffer[1]);
+    if (growPairs) {
+        maxSinglePairs = (unsigned int) (1.2*max(pinnedCountBuffer[1], maxSinglePairs));
         singlePairs.resize(maxSinglePairs);
         if (forceArgs.size() > 0)
             forceArgs[19] = &singlePairs.getDevicePointer();
         findInteractingBlocksArgs[8] = &singlePairs.getDevicePointer();
     }
     forceRebuildNeighborList = true;
+    if (!overflow)
+        return false;
     context.setForcesValid(false);
     return true;
 }
@@ -513,6 +579,15 @@ void CudaNonbondedUtilities::createKernelsForGroups(int groups) {
     groupKernels[groups] = kernels;
 }
 
+string CudaNonbondedUtilities::loadParameter(const ParameterInfo& param, const string& index) {
+    // Constant parameters are read through the read-only data cache, which reduces the
+    // memory traffic of the interaction kernel when there are many per-atom parameters.
+
+    if (param.isConstant())
+        return "loadParameter(&global_"+param.getName()+"["+index+"])";
+    return "global_"+param.getName()+"["+index+"]";
+}
+
 CUfunction CudaNonbondedUtilities::createInteractionKernel(const string& source, vector<ParameterInfo>& params, vector<ParameterInfo>& arguments, bool useExclusions, bool isSymmetric, int groups, bool includeForces, bool includeEnergy) {
     map<string, string> replacements;
     replacements["COMPUTE_INTERACTION"] = source;
@@ -551,14 +626,8 @@ CUfunction CudaNonbondedUtilities::createInteractionKernel(const string& source,
     replacements["PARAMETER_ARGUMENTS"] = args.str();
 
     stringstream load1;
-    for (const ParameterInfo& param : params) {
-        load1 << param.getType();
-        load1 << " ";
-        load1 << param.getName();
-        load1 << "1 = global_";
-        load1 << param.getName();
-        load1 << "[atom1];\n";
-    }
+    for (const ParameterInfo& param : params)
+        load1<<param.getType()<<" "<<param.getName()<<"1 = "<<loadParameter(param, "atom1")<<";\n";
     replacements["LOAD_ATOM1_PARAMETERS"] = load1.str();
 
     // Part 1. Defines for on diagonal exclusion tiles
@@ -587,7 +656,7 @@ CUfunction CudaNonbondedUtilities::createInteractionKernel(const string& source,
 
     stringstream loadLocal2;
     for (const ParameterInfo& param : params)
-        loadLocal2<<"shfl"<<param.getName()<<" = global_"<<param.getName()<<"[j];\n";
+        loadLocal2<<"shfl"<<param.getName()<<" = "<<loadParameter(param, "j")<<";\n";
     replacements["LOAD_LOCAL_PARAMETERS_FROM_GLOBAL"] = loadLocal2.str();
    
     stringstream load2j;
@@ -597,7 +666,7 @@ CUfunction CudaNonbondedUtilities::createInteractionKernel(const string& source,
 
     stringstream load2g;
     for (const ParameterInfo& param : params)
-        load2g<<param.getType()<<" "<<param.getName()<<"2 = global_"<<param.getName()<<"[atom2];\n";
+        load2g<<param.getType()<<" "<<param.getName()<<"2 = "<<loadParameter(param, "atom2")<<";\n";
     replacements["LOAD_ATOM2_PARAMETERS_FROM_GLOBAL"] = load2g.str();
     
     stringstream clearLocal;
@@ -39,33 +39,11 @@ if (result != CUDA_SUCCESS) { \
     throw OpenMMException(m.str());\
 }
 
-/**
- * Get the current clock time, measured in microseconds.
- */
-#ifdef _MSC_VER
-    #include <Windows.h>
-    static long long getTime() {
-        FILETIME ft;
-        GetSystemTimeAsFileTime(&ft); // 100-nanoseconds since 1-1-1601
-        ULARGE_INTEGER result;
-        result.LowPart = ft.dwLowDateTime;
-        result.HighPart = ft.dwHighDateTime;
-        return result.QuadPart/10;
-    }
-#else
-    #include <sys/time.h> 
-    static long long getTime() {
-        struct timeval tod;
-        gettimeofday(&tod, 0);
-        return 1000000*tod.tv_sec+tod.tv_usec;
-    }
-#endif
-
 class CudaParallelCalcForcesAndEnergyKernel::BeginComputationTask : public CudaContext::WorkTask {
 public:
     BeginComputationTask(ContextImpl& context, CudaContext& cu, CudaCalcForcesAndEnergyKernel& kernel,
-            bool includeForce, bool includeEnergy, int groups, void* pinnedMemory, CUevent event, int2& interactionCount) : context(context), cu(cu), kernel(kernel),
-            includeForce(includeForce), includeEnergy(includeEnergy), groups(groups), pinnedMemory(pinnedMemory), event(event), interactionCount(interactionCount) {
+            bool includeForce, bool includeEnergy, int groups, void* pinnedMemory, CUevent event, CUevent timingEvent, int2& interactionCount) : context(context), cu(cu), kernel(kernel),
+            includeForce(includeForce), includeEnergy(includeEnergy), groups(groups), pinnedMemory(pinnedMemory), event(event), timingEvent(timingEvent), interactionCount(interactionCount) {
     }
     void execute() {
         // Copy coordinates over to this device and execute the kernel.
@@ -76,6 +54,8 @@ public:
             if (!cu.getPlatformData().peerAccessSupported)
                 cu.getPosq().upload(pinnedMemory, false);
         }
+        if (timingEvent != 0)
+            cuEventRecord(timingEvent, cu.getCurrentStream());
         kernel.beginComputation(context, includeForce, includeEnergy, groups);
         if (cu.getNonbondedUtilities().getUsePeriodic())
             cu.getNonbondedUtilities().getInteractionCount().download(&interactionCount, false);
@@ -87,29 +67,29 @@ private:
     bool includeForce, includeEnergy;
     int groups;
     void* pinnedMemory;
-    CUevent event;
+    CUevent event, timingEvent;
     int2& interactionCount;
 };
 
 class CudaParallelCalcForcesAndEnergyKernel::FinishComputationTask : public CudaContext::WorkTask {
 public:
     FinishComputationTask(ContextImpl& context, CudaContext& cu, CudaCalcForcesAndEnergyKernel& kernel,
-            bool includeForce, bool includeEnergy, int groups, double& energy, long long& completionTime, long long* pinnedMemory, CudaArray& contextForces,
-            bool& valid, int2& interactionCount, CUstream stream, CUevent event, CUevent localEvent, bool loadBalance) :
+            bool includeForce, bool includeEnergy, int groups, double& energy, long long* pinnedMemory, CudaArray& contextForces,
+            bool& valid, int2& interactionCount, CUstream stream, CUevent event, CUevent localEvent, CUevent timingEvent) :
             context(context), cu(cu), kernel(kernel), includeForce(includeForce), includeEnergy(includeEnergy), groups(groups), energy(energy),
-            completionTime(completionTime), pinnedMemory(pinnedMemory), contextForces(contextForces), valid(valid), interactionCount(interactionCount),
-            stream(stream), event(event), localEvent(localEvent), loadBalance(loadBalance) {
+            pinnedMemory(pinnedMemory), contextForces(contextForces), valid(valid), interactionCount(interactionCount),
+            stream(stream), event(event), localEvent(localEvent), timingEvent(timingEvent) {
     }
     void execute() {
         // Execute the kernel, then download forces.
         
         ContextSelector selector(cu);
         energy += kernel.finishComputation(context, includeForce, includeEnergy, groups, valid);
-        if (loadBalance) {
-            // Record timing information for load balancing.  Since this takes time, only do it at the start of the simulation.
+        if (timingEvent != 0) {
+            // Record timing information for load balancing.  The event is only read back on a later step,
+            // so this never makes the host wait for the device.
 
-            CHECK_RESULT(cuCtxSynchronize(), "Error synchronizing CUDA context");
-            completionTime = getTime();
+            cuEventRecord(timingEvent, cu.getCurrentStream());
         }
         if (includeForce) {
             if (cu.getContextIndex() > 0) {
@@ -137,10 +117,9 @@ private:
     ContextImpl& context;
     CudaContext& cu;
     CudaCalcForcesAndEnergyKernel& kernel;
-    bool includeForce, includeEnergy, loadBalance;
+    bool includeForce, includeEnergy;
     int groups;
     double& energy;
-    long long& completionTime;
     long long* pinnedMemory;
     CudaArray& contextForces;
     bool& valid;
@@ -148,10 +127,11 @@ private:
     CUstream stream;
     CUevent event;
     CUevent localEvent;
+    CUevent timingEvent;
 };
 
 CudaParallelCalcForcesAndEnergyKernel::CudaParallelCalcForcesAndEnergyKernel(string name, const Platform& platform, CudaPlatform::PlatformData& data) :
-        CalcForcesAndEnergyKernel(name, platform), data(data), completionTimes(data.contexts.size()), contextNonbondedFractions(data.contexts.size()),
+        CalcForcesAndEnergyKernel(name, platform), data(data), contextNonbondedFractions(data.contexts.size()), timingSet(0),
         interactionCounts(NULL), pinnedPositionBuffer(NULL), pinnedForceBuffer(NULL) {
     for (int i = 0; i < (int) data.contexts.size(); i++)
         kernels.push_back(Kernel(new CudaCalcForcesAndEnergyKernel(name, platform, *data.contexts[i])));
@@ -170,6 +150,10 @@ CudaParallelCalcForcesAndEnergyKernel::~CudaParallelCalcForcesAndEnergyKernel()
         cuEventDestroy(peerCopyEventLocal[i]);
     for (int i = 0; i < peerCopyStream.size(); i++)
         cuStreamDestroy(peerCopyStream[i]);
+    for (int i = 0; i < timingStartEvent.size(); i++)
+        cuEventDestroy(timingStartEvent[i]);
+    for (int i = 0; i < timingEndEvent.size(); i++)
+        cuEventDestroy(timingEndEvent[i]);
     if (interactionCounts != NULL)
         cuMemFreeHost(interactionCounts);
 }
@@ -200,6 +184,20 @@ void CudaParallelCalcForcesAndEnergyKernel::initialize(const System& system) {
         ContextSelector selectorLocal(cuLocal);
         CHECK_RESULT(cuEventCreate(&peerCopyEventLocal[i], cu.getEventFlags()), "Error creating event");
     }
+
+    // Timing events are double buffered, so the ones recorded on one load balancing step can be read back on the
+    // next one without waiting.
+
+    timingStartEvent.resize(2*numContexts);
+    timingEndEvent.resize(2*numContexts);
+    for (int set = 0; set < 2; set++) {
+        timingRecorded[set] = false;
+        for (int i = 0; i < numContexts; i++) {
+            ContextSelector selectorLocal(*data.contexts[i]);
+            CHECK_RESULT(cuEventCreate(&timingStartEvent[set*numContexts+i], CU_EVENT_DEFAULT), "Error creating event");
+            CHECK_RESULT(cuEventCreate(&timingEndEvent[set*numContexts+i], CU_EVENT_DEFAULT), "Error creating event");
+        }
+    }
     CHECK_RESULT(cuMemHostAlloc((void**) &interactionCounts, numContexts*sizeof(int2), 0), "Error creating interaction counts buffer");
 }
 
@@ -233,7 +231,8 @@ void CudaParallelCalcForcesAndEnergyKernel::beginComputation(ContextImpl& contex
         CudaContext& cu = *data.contexts[i];
         ComputeContext::WorkThread& thread = cu.getWorkThread();
         CUevent waitEvent = (cu.getPlatformData().peerAccessSupported ? peerCopyEvent[i] : event);
-        thread.addTask(new BeginComputationTask(context, cu, getKernel(i), includeForce, includeEnergy, groups, pinnedPositionBuffer, waitEvent, interactionCounts[i]));
+        CUevent timingEvent = (loadBalance ? timingStartEvent[timingSet*data.contexts.size()+i] : 0);
+        thread.addTask(new BeginComputationTask(context, cu, getKernel(i), includeForce, includeEnergy, groups, pinnedPositionBuffer, waitEvent, timingEvent, interactionCounts[i]));
     }
     data.syncContexts();
 }
@@ -242,8 +241,9 @@ double CudaParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& con
     for (int i = 0; i < (int) data.contexts.size(); i++) {
         CudaContext& cu = *data.contexts[i];
         ComputeContext::WorkThread& thread = cu.getWorkThread();
-        thread.addTask(new FinishComputationTask(context, cu, getKernel(i), includeForce, includeEnergy, groups, data.contextEnergy[i], completionTimes[i],
-                pinnedForceBuffer, contextForces, valid, interactionCounts[i], peerCopyStream[i], peerCopyEvent[i], peerCopyEventLocal[i], loadBalance));
+        CUevent timingEvent = (loadBalance ? timingEndEvent[timingSet*data.contexts.size()+i] : 0);
+        thread.addTask(new FinishComputationTask(context, cu, getKernel(i), includeForce, includeEnergy, groups, data.contextEnergy[i],
+                pinnedForceBuffer, contextForces, valid, interactionCounts[i], peerCopyStream[i], peerCopyEvent[i], peerCopyEventLocal[i], timingEvent));
     }
     data.syncContexts();
     CudaContext& cu = *data.contexts[0];
@@ -264,33 +264,92 @@ double CudaParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& con
         void* args[] = {&cu.getForce().getDevicePointer(), &contextForces.getDevicePointer(), &bufferSize, &numBuffers};
         cu.executeKernel(sumKernel, args, bufferSize);
         
-        // Balance work between the contexts by transferring a little nonbonded work from the context that
-        // finished last to the one that finished first.
-        
+        // Balance work between the contexts by transferring nonbonded work from the context that took longest
+        // to the one that was fastest.  This uses the timings recorded on the previous load balancing step.
+        // If the devices have not finished that step yet, skip balancing this time rather than waiting.
+
         if (loadBalance) {
-            int firstIndex = 0, lastIndex = 0;
-            for (int i = 0; i < (int) completionTimes.size(); i++) {
-                if (completionTimes[i] < completionTimes[firstIndex])
-                    firstIndex = i;
-                if (completionTimes[i] > completionTimes[lastIndex])
-                    lastIndex = i;
-            }
-            double fractionToTransfer = min(0.01, contextNonbondedFractions[lastIndex]);
-            contextNonbondedFractions[firstIndex] += fractionToTransfer;
-            contextNonbondedFractions[lastIndex] -= fractionToTransfer;
-            double startFraction = 0.0;
-            for (int i = 0; i < (int) contextNonbondedFractions.size(); i++) {
-                double endFraction = startFraction+contextNonbondedFractions[i];
-                if (i == contextNonbondedFractions.size()-1)
-                    endFraction = 1.0; // Avoid roundoff error
-                data.contexts[i]->getNonbondedUtilities().setAtomBlockRange(startFraction, endFraction);
-                startFraction = endFraction;
+            int numContexts = data.contexts.size();
+            int previousSet = 1-timingSet;
+            vector<double> deviceTimes(numContexts);
+            bool timingReady = timingRecorded[previousSet];
+            for (int i = 0; i < numContexts && timingReady; i++) {
+                ContextSelector selectorLocal(*data.contexts[i]);
+                float elapsed;
+                if (cuEventElapsedTime(&elapsed, timingStartEvent[previousSet*numContexts+i], timingEndEvent[previousSet*numContexts+i]) == CUDA_SUCCESS)
+                    deviceTimes[i] = 1e-3*elapsed;
+                else
+                    timingReady = false;
             }
-	}
+            timingRecorded[timingSet] = true;
+            timingRecorded[previousSet] = false;
+            timingSet = previousSet;
+            if (timingReady)
+                balanceNonbondedWork(deviceTimes);
+        }
     }
     return energy;
 }
 
+void CudaParallelCalcForcesAndEnergyKernel::synchronize(ContextImpl& context) {
+    data.syncContexts();
+    for (auto cu : data.contexts) {
+        ContextSelector selector(*cu);
+        cuStreamSynchronize(cu->getCurrentStream());
+    }
+}
+
+void CudaParallelCalcForcesAndEnergyKernel::getNeighborListStatistics(ContextImpl& context, map<string, double>& statistics) {
+    // Each device has its own neighbor list for its share of the tiles.  Sizes are summed over the
+    // devices, while counts of events such as rebuilds are the largest value from any device.
+
+    data.syncContexts();
+    for (int i = 0; i < (int) data.contexts.size(); i++) {
+        map<string, double> deviceStatistics;
+        getKernel(i).getNeighborListStatistics(context, deviceStatistics);
+        for (auto& entry : deviceStatistics) {
+            const string& name = entry.first;
+            bool isSize = (name == "Interacting Tiles" || name == "Single Pairs" || name == "Neighbor List Pairs" || name == "Pairs Within Cutoff");
+            if (statistics.find(name) == statistics.end())
+                statistics[name] = entry.second;
+            else if (isSize)
+                statistics[name] += entry.second;
+            else
+                statistics[name] = max(statistics[name], entry.second);
+        }
+    }
+}
+
+void CudaParallelCalcForcesAndEnergyKernel::balanceNonbondedWork(const vector<double>& deviceTimes) {
+    // Record the timings, then transfer an amount of work proportional to the imbalance.  This converges
+    // quickly when the devices have very different speeds, while only making small adjustments once they
+    // are nearly balanced.
+
+    if ((int) deviceTimeHistory.size() == maxHistoryLength)
+        deviceTimeHistory.erase(deviceTimeHistory.begin());
+    deviceTimeHistory.push_back(deviceTimes);
+    int firstIndex = 0, lastIndex = 0;
+    for (int i = 0; i < (int) deviceTimes.size(); i++) {
+        if (deviceTimes[i] < deviceTimes[firstIndex])
+            firstIndex = i;
+        if (deviceTimes[i] > deviceTimes[lastIndex])
+            lastIndex = i;
+    }
+    double imbalance = (deviceTimes[lastIndex] > 0.0 ? (deviceTimes[lastIndex]-deviceTimes[firstIndex])/deviceTimes[lastIndex] : 0.0);
+    double fractionToTransfer = max(0.001, min(0.05, 0.5*imbalance*contextNonbondedFractions[lastIndex]));
+    fractionToTransfer = min(fractionToTransfer, contextNonbondedFractions[lastIndex]);
+    contextNonbondedFractions[firstIndex] += fractionToTransfer;
+    contextNonbondedFractions[lastIndex] -= fractionToTransfer;
+    double startFraction = 0.0;
+    for (int i = 0; i < (int) contextNonbondedFractions.size(); i++) {
+        double endFraction = startFraction+contextNonbondedFractions[i];
+        if (i == contextNonbondedFractions.size()-1)
+            endFraction = 1.0; // Avoid roundoff error
+        data.contexts[i]->getNonbondedUtilities().setAtomBlockRange(startFraction, endFraction);
+        startFraction = endFraction;
+    }
+}
+
 class CudaParallelCalcHarmonicBondForceKernel::Task : public CudaContext::WorkTask {
 public:
     Task(ContextImpl& context, CommonCalcHarmonicBondForceKernel& kernel, bool includeForce,
@@ -35,6 +35,7 @@
 #include "openmm/internal/hardware.h"
 #include <algorithm>
 #include <cctype>
+#include <set>
 #include <sstream>
 #include <cstdio>
 #ifdef _MSC_VER
@@ -93,12 +94,14 @@ CudaPlatform::CudaPlatform() {
     registerKernelFactory(CalcCustomCompoundBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomCVForceKernel::Name(), factory);
     registerKernelFactory(CalcRMSDForceKernel::Name(), factory);
+    registerKernelFactory(CalcExternalForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
@@ -116,6 +119,7 @@ CudaPlatform::CudaPlatform() {
     platformProperties.push_back(CudaHostCompiler());
     platformProperties.push_back(CudaDisablePmeStream());
     platformProperties.push_back(CudaDeterministicForces());
+    platformProperties.push_back(CudaUseGraphs());
     setPropertyDefaultValue(CudaDeviceIndex(), "");
     setPropertyDefaultValue(CudaDeviceName(), "");
     setPropertyDefaultValue(CudaUseBlockingSync(), "false");
@@ -123,6 +127,7 @@ CudaPlatform::CudaPlatform() {
     setPropertyDefaultValue(CudaUseCpuPme(), "false");
     setPropertyDefaultValue(CudaDisablePmeStream(), "false");
     setPropertyDefaultValue(CudaDeterministicForces(), "false");
+    setPropertyDefaultValue(CudaUseGraphs(), "false");
 #ifdef _MSC_VER
     char* bindir = getenv("CUDA_BIN_PATH");
     string nvcc = (bindir == NULL ? "nvcc.exe" : string(bindir)+"\\nvcc.exe");
@@ -169,6 +174,37 @@ const string& CudaPlatform::getPropertyValue(const Context& context, const strin
 void CudaPlatform::setPropertyValue(Context& context, const string& property, const string& value) const {
 }
 
+map<string, double> CudaPlatform::getMemoryUsage(const Context& context) const {
+    const ContextImpl& impl = getContextImpl(context);
+    const PlatformData* data = reinterpret_cast<const PlatformData*>(impl.getPlatformData());
+    map<string, double> usage;
+    set<int> devices;
+    for (CudaContext* device : data->contexts) {
+        for (auto& category : device->getMemoryUsage())
+            usage[category.first] += category.second;
+        if (devices.insert(device->getDeviceIndex()).second && device->getMemoryPoolSize() > 0)
+            usage["Memory Pool"] += device->getMemoryPoolSize();
+    }
+    return usage;
+}
+
+map<string, double> CudaPlatform::estimateMemoryUsage(const System& system, const map<string, string>& properties) const {
+    string precision = (properties.find(CudaPrecision()) == properties.end() ?
+            getPropertyDefaultValue(CudaPrecision()) : properties.find(CudaPrecision())->second);
+    string cpuPme = (properties.find(CudaUseCpuPme()) == properties.end() ?
+            getPropertyDefaultValue(CudaUseCpuPme()) : properties.find(CudaUseCpuPme())->second);
+    transform(precision.begin(), precision.end(), precision.begin(), ::tolower);
+    transform(cpuPme.begin(), cpuPme.end(), cpuPme.begin(), ::tolower);
+    map<string, double> usage = ComputeContext::estimateMemoryUsage(system, precision == "double", precision == "mixed");
+    if (cpuPme == "true" && usage.find("PME") != usage.end()) {
+        // The reciprocal space calculation will be done on the CPU.
+
+        usage["Total"] -= usage["PME"];
+        usage.erase("PME");
+    }
+    return usage;
+}
+
 void CudaPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
     const string& devicePropValue = (properties.find(CudaDeviceIndex()) == properties.end() ?
             getPropertyDefaultValue(CudaDeviceIndex()) : properties.find(CudaDeviceIndex())->second);
@@ -188,11 +224,14 @@ void CudaPlatform::contextCreated(ContextImpl& context, const map<string, string
             getPropertyDefaultValue(CudaDisablePmeStream()) : properties.find(CudaDisablePmeStream())->second);
     string deterministicForcesValue = (properties.find(CudaDeterministicForces()) == properties.end() ?
             getPropertyDefaultValue(CudaDeterministicForces()) : properties.find(CudaDeterministicForces())->second);
+    string graphsValue = (properties.find(CudaUseGraphs()) == properties.end() ?
+            getPropertyDefaultValue(CudaUseGraphs()) : properties.find(CudaUseGraphs())->second);
     transform(blockingPropValue.begin(), blockingPropValue.end(), blockingPropValue.begin(), ::tolower);
     transform(precisionPropValue.begin(), precisionPropValue.end(), precisionPropValue.begin(), ::tolower);
     transform(cpuPmePropValue.begin(), cpuPmePropValue.end(), cpuPmePropValue.begin(), ::tolower);
     transform(pmeStreamPropValue.begin(), pmeStreamPropValue.end(), pmeStreamPropValue.begin(), ::tolower);
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
+    transform(graphsValue.begin(), graphsValue.end(), graphsValue.begin(), ::tolower);
     vector<string> pmeKernelName;
     pmeKernelName.push_back(CalcPmeReciprocalForceKernel::Name());
     if (!supportsKernels(pmeKernelName))
@@ -204,7 +243,7 @@ void CudaPlatform::contextCreated(ContextImpl& context, const map<string, string
     char* compilerEnv = getenv("OPENMM_CUDA_COMPILER");
     bool allowRuntimeCompiler = (compilerEnv == NULL && properties.find(CudaCompiler()) == properties.end());
     context.setPlatformData(new PlatformData(&context, context.getSystem(), devicePropValue, blockingPropValue, precisionPropValue, cpuPmePropValue, compilerPropValue, tempPropValue,
-            hostCompilerPropValue, pmeStreamPropValue, deterministicForcesValue, threads, allowRuntimeCompiler, NULL));
+            hostCompilerPropValue, pmeStreamPropValue, deterministicForcesValue, graphsValue, threads, allowRuntimeCompiler, NULL));
 }
 
 void CudaPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const {
@@ -218,10 +257,11 @@ void CudaPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& origi
     string hostCompilerPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaHostCompiler());
     string pmeStreamPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaDisablePmeStream());
     string deterministicForcesValue = platform.getPropertyValue(originalContext.getOwner(), CudaDeterministicForces());
+    string graphsValue = platform.getPropertyValue(originalContext.getOwner(), CudaUseGraphs());
     int threads = reinterpret_cast<PlatformData*>(originalContext.getPlatformData())->threads.getNumThreads();
     bool allowRuntimeCompiler = reinterpret_cast<PlatformData*>(originalContext.getPlatformData())->allowRuntimeCompiler;
     context.setPlatformData(new PlatformData(&context, context.getSystem(), devicePropValue, blockingPropValue, precisionPropValue, cpuPmePropValue, compilerPropValue, tempPropValue,
-            hostCompilerPropValue, pmeStreamPropValue, deterministicForcesValue, threads, allowRuntimeCompiler, &originalContext));
+            hostCompilerPropValue, pmeStreamPropValue, deterministicForcesValue, graphsValue, threads, allowRuntimeCompiler, &originalContext));
 }
 
 void CudaPlatform::contextDestroyed(ContextImpl& context) const {
@@ -231,7 +271,7 @@ void CudaPlatform::contextDestroyed(ContextImpl& context) const {
 
 CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& system, const string& deviceIndexProperty, const string& blockingProperty, const string& precisionProperty,
             const string& cpuPmeProperty, const string& compilerProperty, const string& tempProperty, const string& hostCompilerProperty, const string& pmeStreamProperty,
-            const string& deterministicForcesProperty, int numThreads, bool allowRuntimeCompiler, ContextImpl* originalContext) :
+            const string& deterministicForcesProperty, const string& graphsProperty, int numThreads, bool allowRuntimeCompiler, ContextImpl* originalContext) :
                 context(context), removeCM(false), stepCount(0), computeForceCount(0), time(0.0), hasInitializedContexts(false),
                 threads(numThreads), allowRuntimeCompiler(allowRuntimeCompiler) {
     bool blocking = (blockingProperty == "true");
@@ -277,6 +317,7 @@ CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& sys
     useCpuPme = (cpuPmeProperty == "true" && !contexts[0]->getUseDoublePrecision());
     disablePmeStream = (pmeStreamProperty == "true");
     deterministicForces = (deterministicForcesProperty == "true");
+    useCudaGraphs = (graphsProperty == "true");
     propertyValues[CudaPlatform::CudaDeviceIndex()] = deviceIndex.str();
     propertyValues[CudaPlatform::CudaDeviceName()] = deviceName.str();
     propertyValues[CudaPlatform::CudaUseBlockingSync()] = blocking ? "true" : "false";
@@ -287,6 +328,7 @@ CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& sys
     propertyValues[CudaPlatform::CudaHostCompiler()] = hostCompilerProperty;
     propertyValues[CudaPlatform::CudaDisablePmeStream()] = disablePmeStream ? "true" : "false";
     propertyValues[CudaPlatform::CudaDeterministicForces()] = deterministicForces ? "true" : "false";
+    propertyValues[CudaPlatform::CudaUseGraphs()] = useCudaGraphs ? "true" : "false";
     contextEnergy.resize(contexts.size());
     
     // Determine whether peer-to-peer copying is supported, and enable it if so.
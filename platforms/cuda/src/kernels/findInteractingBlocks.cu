@@ -331,11 +331,20 @@ extern "C" __global__ __launch_bounds__(GROUP_SIZE,3) void findBlocksWithInterac
                 pos2.w = 0.5f * (pos2.x * pos2.x + pos2.y * pos2.y + pos2.z * pos2.z);
 
                 real4 blockCenterY = sortedBlockCenter[block2Base+i];
+                real3 blockSizeY = sortedBlockBoundingBox[block2Base+i].toReal3();
                 real3 atomDelta = trimTo3(posBuffer[warpStart+indexInWarp])-trimTo3(blockCenterY);
 #ifdef USE_PERIODIC
                 APPLY_PERIODIC_TO_DELTA(atomDelta)
 #endif
-                int atomFlags = BALLOT(forceInclude || atomDelta.x*atomDelta.x+atomDelta.y*atomDelta.y+atomDelta.z*atomDelta.z < (PADDED_CUTOFF+blockCenterY.w)*(PADDED_CUTOFF+blockCenterY.w));
+
+                // An atom of block X can only interact with block Y if it is within the cutoff of both Y's bounding
+                // sphere and its bounding box.  The box is much tighter than the sphere for flat or elongated blocks,
+                // such as ones at membrane or solvent interfaces.
+
+                real3 boxDelta = make_real3(max(0.0f, fabs(atomDelta.x)-blockSizeY.x), max(0.0f, fabs(atomDelta.y)-blockSizeY.y), max(0.0f, fabs(atomDelta.z)-blockSizeY.z));
+                bool atomNearBlock = (atomDelta.x*atomDelta.x+atomDelta.y*atomDelta.y+atomDelta.z*atomDelta.z < (PADDED_CUTOFF+blockCenterY.w)*(PADDED_CUTOFF+blockCenterY.w) &&
+                                      boxDelta.x*boxDelta.x+boxDelta.y*boxDelta.y+boxDelta.z*boxDelta.z < PADDED_CUTOFF_SQUARED);
+                int atomFlags = BALLOT(forceInclude || atomNearBlock);
                 int interacts = 0;
                 if (atom2 < NUM_ATOMS && atomFlags != 0) {
 #ifdef USE_PERIODIC
@@ -27,6 +27,40 @@ static __inline__ __device__ long long real_shfl(long long var, int srcLane) {
     return *reinterpret_cast<long long*>(&fuse);
 }
 
+/**
+ * Load a per-atom parameter through the read-only data cache.  This is only used for parameters
+ * that are not modified while the kernel runs.  Types __ldg() does not support fall back to a
+ * normal load.
+ */
+template <class T>
+static __inline__ __device__ T loadParameter(const T* __restrict__ p) {
+    return *p;
+}
+
+static __inline__ __device__ float loadParameter(const float* __restrict__ p) {
+    return __ldg(p);
+}
+
+static __inline__ __device__ float2 loadParameter(const float2* __restrict__ p) {
+    return __ldg(p);
+}
+
+static __inline__ __device__ float4 loadParameter(const float4* __restrict__ p) {
+    return __ldg(p);
+}
+
+static __inline__ __device__ double loadParameter(const double* __restrict__ p) {
+    return __ldg(p);
+}
+
+static __inline__ __device__ double2 loadParameter(const double2* __restrict__ p) {
+    return __ldg(p);
+}
+
+static __inline__ __device__ int loadParameter(const int* __restrict__ p) {
+    return __ldg(p);
+}
+
 /**
  * Save the force on a single atom.
  */
@@ -99,6 +133,8 @@ __device__ void saveSingleForce(int atom, real3 force, unsigned long long* force
  *                      - z is half the distance of total height
  *                      - w is not used
  * [in]interactingAtoms - a list of interactions within a given tile     
+ * [in]tileCounter      - the next tile from the neighbor list to be processed, which must
+ *                      - be zero when the kernel is launched
  *
  */
 extern "C" __global__ void computeNonbonded(
@@ -108,7 +144,7 @@ extern "C" __global__ void computeNonbonded(
         , const int* __restrict__ tiles, const unsigned int* __restrict__ interactionCount, real4 periodicBoxSize, real4 invPeriodicBoxSize, 
         real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ, unsigned int maxTiles, const real4* __restrict__ blockCenter,
         const real4* __restrict__ blockSize, const unsigned int* __restrict__ interactingAtoms, unsigned int maxSinglePairs,
-        const int2* __restrict__ singlePairs
+        const int2* __restrict__ singlePairs, unsigned int* __restrict__ tileCounter
 #endif
         PARAMETER_ARGUMENTS) {
     const unsigned int totalWarps = (blockDim.x*gridDim.x)/TILE_SIZE;
@@ -271,8 +307,15 @@ extern "C" __global__ void computeNonbonded(
     const unsigned int numTiles = interactionCount[0];
     if (numTiles > maxTiles)
         return; // There wasn't enough memory for the neighbor list.
-    int pos = (int) (warp*(long long)numTiles/totalWarps);
-    int end = (int) ((warp+1)*(long long)numTiles/totalWarps);
+    // Each warp fetches its next tile from a global counter rather than processing a fixed range.
+    // Tiles can take very different amounts of time, and warps that spent longer on exclusion tiles
+    // in the first loop then simply end up processing fewer of these.
+
+    int pos = 0;
+    if (tgx == 0)
+        pos = atomicAdd(tileCounter, 1);
+    pos = SHFL(pos, 0);
+    int end = numTiles;
 #else
     int pos = (int) (startTileIndex+warp*numTileIndices/totalWarps);
     int end = (int) (startTileIndex+(warp+1)*numTileIndices/totalWarps);
@@ -471,7 +514,13 @@ extern "C" __global__ void computeNonbonded(
             }
 #endif
         }
+#ifdef USE_NEIGHBOR_LIST
+        if (tgx == 0)
+            pos = atomicAdd(tileCounter, 1);
+        pos = SHFL(pos, 0);
+#else
         pos++;
+#endif
     }
     
     // Third loop: single pairs that aren't part of a tile.
@@ -193,6 +193,12 @@ public:
     cl::Buffer& getDeviceBuffer() {
         return *buffer;
     }
+    /**
+     * Get the cl_mem for the Buffer, converted to a void*.
+     */
+    void* getDeviceHandle() {
+        return (void*) (*buffer)();
+    }
     /**
      * Copy the values in a vector to the Buffer.
      */
@@ -245,7 +251,7 @@ private:
     int elementSize;
     cl_int flags;
     bool ownsBuffer;
-    std::string name;
+    std::string name, memoryCategory;
 };
 
 } // namespace OpenMM
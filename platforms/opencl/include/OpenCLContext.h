@@ -667,6 +667,29 @@ public:
 private:
     OpenCLPlatform::PlatformData& platformData;
     void printProfilingEvents();
+    /**
+     * Try to load a previously compiled program from the on-disk cache.  Returns true if
+     * it was found and successfully built.
+     */
+    bool loadCachedProgram(const std::string& cacheFile, const std::string& options, cl::Program& program);
+    /**
+     * Build a program from a binary that was previously compiled for this device.  Returns true if
+     * the driver accepted it.
+     */
+    bool createProgramFromBinary(const std::vector<unsigned char>& binary, const std::string& options, cl::Program& program);
+    /**
+     * Record the binary for a compiled program in the in-memory cache that is shared by all contexts
+     * in this process.
+     */
+    void rememberProgramBinary(const std::string& hash, cl::Program& program);
+    /**
+     * Write the binary for a compiled program to the on-disk cache.
+     */
+    void saveCachedProgram(const std::string& cacheFile, cl::Program& program);
+    /**
+     * Delete the least recently used files from the cache until its total size is below the limit.
+     */
+    void trimProgramCache();
     int deviceIndex;
     int platformIndex;
     int contextIndex;
@@ -678,7 +701,10 @@ private:
     mm_float4 periodicBoxSize, invPeriodicBoxSize, periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ;
     mm_double4 periodicBoxSizeDouble, invPeriodicBoxSizeDouble, periodicBoxVecXDouble, periodicBoxVecYDouble, periodicBoxVecZDouble;
     std::string defaultOptimizationOptions;
+    std::string cacheDir, cacheDeviceId;
+    long long cacheSizeLimit;
     std::map<std::string, std::string> compilationDefines;
+    std::map<std::string, cl::Program> loadedPrograms;
     cl::Context context;
     cl::Device device;
     cl::CommandQueue defaultQueue, currentQueue;
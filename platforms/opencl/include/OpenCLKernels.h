@@ -78,6 +78,19 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * Wait until all calculations that have been queued for this context have completed.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void synchronize(ContextImpl& context);
+    /**
+     * Get statistics describing the neighbor list used for nonbonded interactions.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(ContextImpl& context, std::map<std::string, double>& statistics);
 private:
    OpenCLContext& cl;
 };
@@ -126,6 +139,13 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     void getPositions(ContextImpl& context, std::vector<Vec3>& positions);
+    /**
+     * Get the positions of a subset of the particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, this contains the positions of the requested particles in the same order as particles
+     */
+    void getPositionSubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions);
     /**
      * Set the positions of all particles.
      *
@@ -138,6 +158,13 @@ public:
      * @param velocities  on exit, this contains the particle velocities
      */
     void getVelocities(ContextImpl& context, std::vector<Vec3>& velocities);
+    /**
+     * Get the velocities of a subset of the particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, this contains the velocities of the requested particles in the same order as particles
+     */
+    void getVelocitySubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities);
     /**
      * Set the velocities of all particles.
      *
@@ -194,7 +221,10 @@ public:
      */
     void loadCheckpoint(ContextImpl& context, std::istream& stream);
 private:
+    void gatherSubset(const std::vector<int>& particles, bool positions, std::vector<int>& atoms);
     OpenCLContext& cl;
+    OpenCLArray subsetAtoms, subsetData;
+    ComputeKernel gatherPositionsKernel, gatherVelocitiesKernel;
 };
 
 /**
@@ -192,6 +192,14 @@ public:
      * @return true if the neighbor list needed to be enlarged.
      */
     bool updateNeighborListSize();
+    /**
+     * Compute statistics describing how often the neighbor list has been rebuilt and how efficiently it
+     * packs interactions into tiles.  See Context::getNeighborListStatistics() for the meaning of each
+     * value.  This downloads the neighbor list from the device, so it should not be called on every step.
+     *
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(std::map<std::string, double>& statistics);
     /**
      * Get the array containing the center of each atom block.
      */
@@ -336,7 +344,7 @@ private:
     int startTileIndex, startBlockIndex, numBlocks, maxExclusions, numForceThreadBlocks;
     int forceThreadBlockSize, interactingBlocksThreadBlockSize, groupFlags;
     unsigned int tilesAfterReorder;
-    long long numTiles;
+    long long numTiles, numNeighborListChecks, numNeighborListBuilds, numNeighborListReallocations;
     std::string kernelSource;
 };
 
@@ -77,6 +77,19 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * Wait until all calculations that have been queued for this context have completed.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void synchronize(ContextImpl& context);
+    /**
+     * Get statistics describing the neighbor list used for nonbonded interactions.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(ContextImpl& context, std::map<std::string, double>& statistics);
 private:
     class BeginComputationTask;
     class FinishComputationTask;
@@ -52,6 +52,8 @@ public:
     static bool isPlatformSupported();
     const std::string& getPropertyValue(const Context& context, const std::string& property) const;
     void setPropertyValue(Context& context, const std::string& property, const std::string& value) const;
+    std::map<std::string, double> getMemoryUsage(const Context& context) const;
+    std::map<std::string, double> estimateMemoryUsage(const System& system, const std::map<std::string, std::string>& properties=std::map<std::string, std::string>()) const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const;
     void contextDestroyed(ContextImpl& context) const;
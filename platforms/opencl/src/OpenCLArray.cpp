@@ -44,8 +44,10 @@ OpenCLArray::OpenCLArray(OpenCLContext& context, cl::Buffer* buffer, size_t size
 }
 
 OpenCLArray::~OpenCLArray() {
-    if (buffer != NULL && ownsBuffer)
+    if (buffer != NULL && ownsBuffer) {
         delete buffer;
+        context->recordMemoryUsage(memoryCategory, -(long long) (size*elementSize));
+    }
 }
 
 void OpenCLArray::initialize(ComputeContext& context, size_t size, int elementSize, const std::string& name) {
@@ -69,6 +71,9 @@ void OpenCLArray::initialize(OpenCLContext& context, size_t size, int elementSiz
         str<<"Error creating array "<<name<<": "<<err.what()<<" ("<<err.err()<<")";
         throw OpenMMException(str.str());
     }
+    if (memoryCategory.empty())
+        memoryCategory = context.getMemoryCategory();
+    context.recordMemoryUsage(memoryCategory, size*elementSize);
 }
 
 void OpenCLArray::initialize(OpenCLContext& context, cl::Buffer* buffer, size_t size, int elementSize, const std::string& name) {
@@ -89,6 +94,7 @@ void OpenCLArray::resize(size_t size) {
         throw OpenMMException("Cannot resize an array that does not own its storage");
     delete buffer;
     buffer = NULL;
+    context->recordMemoryUsage(memoryCategory, -(long long) (this->size*elementSize));
     initialize(*context, size, elementSize, name, flags);
 }
 
@@ -42,12 +42,28 @@
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/internal/ContextImpl.h"
+#include "SHA1.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <typeinfo>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <io.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
 
 using namespace OpenMM;
 using namespace std;
@@ -66,6 +82,15 @@ using namespace std;
 const int OpenCLContext::ThreadBlockSize = 64;
 const int OpenCLContext::TileSize = 32;
 
+// Binaries for every program compiled in this process, indexed by the same hash used for the
+// on-disk cache.  Context::reinitialize() destroys the OpenCLContext along with all its programs, so
+// this lets the new one skip compilation even when the on-disk cache is disabled.
+
+static mutex programBinariesLock;
+static map<string, vector<unsigned char> > programBinaries;
+static long long programBinariesSize = 0;
+static const long long maxProgramBinariesSize = 256*1024*1024;
+
 static void CL_CALLBACK errorCallback(const char* errinfo, const void* private_info, size_t cb, void* user_data) {
     string skip = "OpenCL Build Warning : Compiler build log:";
     if (strncmp(errinfo, skip.c_str(), skip.length()) == 0)
@@ -209,6 +234,22 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
             defaultOptimizationOptions = "";
         else
             defaultOptimizationOptions = "-cl-mad-enable -cl-no-signed-zeros";
+
+        // Compiled programs are cached on disk.  A binary is only valid for the driver and device
+        // that produced it, so those are included in the key that identifies each cached program.
+
+        char* cacheVariable = getenv("OPENMM_CACHE_DIR");
+#ifdef WIN32
+        char* tempVariable = getenv("TEMP");
+        cacheDir = (cacheVariable != NULL ? string(cacheVariable) : tempVariable != NULL ? string(tempVariable) : string("."))+"\\";
+#else
+        char* tempVariable = getenv("TMPDIR");
+        cacheDir = (cacheVariable != NULL ? string(cacheVariable) : tempVariable != NULL ? string(tempVariable) : string("/tmp"))+"/";
+#endif
+        char* cacheSizeVariable = getenv("OPENMM_OPENCL_CACHE_SIZE");
+        cacheSizeLimit = (cacheSizeVariable == NULL ? 500 : atoll(cacheSizeVariable))*1024*1024;
+        cacheDeviceId = platforms[bestPlatform].getInfo<CL_PLATFORM_NAME>()+'\n'+platforms[bestPlatform].getInfo<CL_PLATFORM_VERSION>()+'\n'+
+                device.getInfo<CL_DEVICE_NAME>()+'\n'+device.getInfo<CL_DEVICE_VERSION>()+'\n'+device.getInfo<CL_DRIVER_VERSION>();
         supports64BitGlobalAtomics = (device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_int64_base_atomics") != string::npos);
         supportsDoublePrecision = (device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_fp64") != string::npos);
         if ((useDoublePrecision || useMixedPrecision) && !supportsDoublePrecision)
@@ -316,6 +357,7 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
         paddedNumAtoms = TileSize*((numAtoms+TileSize-1)/TileSize);
         numAtomBlocks = (paddedNumAtoms+(TileSize-1))/TileSize;
         numThreadBlocks = numThreadBlocksPerComputeUnit*device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+        setMemoryCategory("Context");
         if (useDoublePrecision) {
             posq.initialize<mm_double4>(*this, paddedNumAtoms, "posq");
             velm.initialize<mm_double4>(*this, paddedNumAtoms, "velm");
@@ -480,8 +522,10 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
             "pos.z -= floor((pos.z-center.z)*invPeriodicBoxSize.z+0.5f)*periodicBoxSize.z;}";
     }
 
-    // Create utilities objects.
+    // Create utilities objects.  Memory they allocate is attributed to their own categories,
+    // or to the Forces that use them.
 
+    setMemoryCategory("Forces");
     bonded = new OpenCLBondedUtilities(*this);
     nonbonded = new OpenCLNonbondedUtilities(*this);
     integration = new OpenCLIntegrationUtilities(*this, system);
@@ -518,6 +562,7 @@ void OpenCLContext::initialize() {
     numForceBuffers = std::max(numForceBuffers, (int) platformData.contexts.size());
     int energyBufferSize = max(numThreadBlocks*ThreadBlockSize, nonbonded->getNumEnergyBuffers());
     int numComputeUnits = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+    setMemoryCategory("Context");
     if (useDoublePrecision) {
         forceBuffers.initialize<mm_double4>(*this, paddedNumAtoms*numForceBuffers, "forceBuffers");
         force.initialize<mm_double4>(*this, &forceBuffers.getDeviceBuffer(), paddedNumAtoms, "force");
@@ -543,6 +588,7 @@ void OpenCLContext::initialize() {
     addAutoclearBuffer(longForceBuffer);
     addAutoclearBuffer(forceBuffers);
     addAutoclearBuffer(energyBuffer);
+    setMemoryCategory("Forces");
     int numEnergyParamDerivs = energyParamDerivNames.size();
     if (numEnergyParamDerivs > 0) {
         if (useDoublePrecision || useMixedPrecision)
@@ -639,6 +685,54 @@ cl::Program OpenCLContext::createProgram(const string source, const map<string,
     if (!defines.empty())
         src << endl;
     src << source << endl;
+
+    // Many forces generate identical programs (for example, several copies of the same custom force).
+    // If this one has already been built by this context, reuse it.
+
+    string key = cacheDeviceId+'\n'+options+'\n'+src.str();
+    CSHA1 sha1;
+    sha1.Update((const UINT_8*) key.c_str(), key.size());
+    sha1.Final();
+    UINT_8 hash[20];
+    sha1.GetHash(hash);
+    stringstream hashString;
+    hashString.flags(ios::hex);
+    for (int i = 0; i < 20; i++)
+        hashString << setw(2) << setfill('0') << (int) hash[i];
+    auto loaded = loadedPrograms.find(hashString.str());
+    if (loaded != loadedPrograms.end())
+        return loaded->second;
+
+    // If another context in this process has compiled it, for example the one that existed before
+    // the Context was reinitialized, reuse its binary.
+
+    vector<unsigned char> binary;
+    {
+        lock_guard<mutex> lock(programBinariesLock);
+        auto found = programBinaries.find(hashString.str());
+        if (found != programBinaries.end())
+            binary = found->second;
+    }
+    if (!binary.empty()) {
+        cl::Program program;
+        if (createProgramFromBinary(binary, options, program)) {
+            loadedPrograms[hashString.str()] = program;
+            return program;
+        }
+    }
+
+    // See whether we already have a binary for this program cached.
+
+    string cacheFile;
+    if (cacheSizeLimit > 0) {
+        cacheFile = cacheDir+"openmmProgram_"+hashString.str()+".bin";
+        cl::Program program;
+        if (loadCachedProgram(cacheFile, options, program)) {
+            rememberProgramBinary(hashString.str(), program);
+            loadedPrograms[hashString.str()] = program;
+            return program;
+        }
+    }
     cl::Program::Sources sources({src.str()});
     cl::Program program(context, sources);
     try {
@@ -646,9 +740,152 @@ cl::Program OpenCLContext::createProgram(const string source, const map<string,
     } catch (cl::Error err) {
         throw OpenMMException("Error compiling kernel: "+program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device));
     }
+    if (!cacheFile.empty())
+        saveCachedProgram(cacheFile, program);
+    rememberProgramBinary(hashString.str(), program);
+    loadedPrograms[hashString.str()] = program;
     return program;
 }
 
+bool OpenCLContext::loadCachedProgram(const string& cacheFile, const string& options, cl::Program& program) {
+    ifstream in(cacheFile.c_str(), ios::binary);
+    if (!in.is_open())
+        return false;
+    vector<unsigned char> binary((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    if (binary.empty())
+        return false;
+    if (!createProgramFromBinary(binary, options, program)) {
+        // The file is damaged or the driver rejected it.  Fall back to compiling from source, which
+        // will replace it.
+
+        return false;
+    }
+
+    // Update the modification time so trimProgramCache() treats it as recently used.
+
+#ifdef WIN32
+    _utime(cacheFile.c_str(), NULL);
+#else
+    utime(cacheFile.c_str(), NULL);
+#endif
+    return true;
+}
+
+bool OpenCLContext::createProgramFromBinary(const vector<unsigned char>& binary, const string& options, cl::Program& program) {
+    try {
+        program = cl::Program(context, vector<cl::Device>(1, device), cl::Program::Binaries(1, binary));
+        program.build(vector<cl::Device>(1, device), options.c_str());
+    }
+    catch (cl::Error err) {
+        return false;
+    }
+    return true;
+}
+
+void OpenCLContext::rememberProgramBinary(const string& hash, cl::Program& program) {
+    vector<vector<unsigned char> > binaries;
+    try {
+        binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+    }
+    catch (...) {
+        return;
+    }
+    if (binaries.size() != 1 || binaries[0].empty())
+        return;
+    lock_guard<mutex> lock(programBinariesLock);
+    if (programBinaries.find(hash) != programBinaries.end())
+        return;
+    if (programBinariesSize+(long long) binaries[0].size() > maxProgramBinariesSize) {
+        // Rather than tracking usage, just start over.  Anything still needed will be added again.
+
+        programBinaries.clear();
+        programBinariesSize = 0;
+    }
+    programBinariesSize += binaries[0].size();
+    programBinaries[hash].swap(binaries[0]);
+}
+
+void OpenCLContext::saveCachedProgram(const string& cacheFile, cl::Program& program) {
+    // Write to a temporary file, then rename it.  That way another process creating a Context at
+    // the same time never sees a partially written file.
+
+    stringstream tempFile;
+    tempFile << cacheFile << '.' << this;
+#ifdef WIN32
+    tempFile << '_' << _getpid();
+#else
+    tempFile << '_' << getpid();
+#endif
+    try {
+        vector<vector<unsigned char> > binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+        if (binaries.size() != 1 || binaries[0].empty())
+            return;
+        ofstream out(tempFile.str().c_str(), ios::binary);
+        out.write((const char*) &binaries[0][0], binaries[0].size());
+        out.close();
+        if (out.fail() || rename(tempFile.str().c_str(), cacheFile.c_str()) != 0) {
+            remove(tempFile.str().c_str());
+            return;
+        }
+    }
+    catch (...) {
+        // Failing to write the cache is not an error.  Possibly we don't have permission to write to the directory.
+
+        remove(tempFile.str().c_str());
+        return;
+    }
+    trimProgramCache();
+}
+
+void OpenCLContext::trimProgramCache() {
+    // Find all cached programs, along with their sizes and modification times.
+
+    vector<pair<long long, string> > files;
+    map<string, long long> sizes;
+    long long totalSize = 0;
+#ifdef WIN32
+    struct _finddata_t fileInfo;
+    intptr_t handle = _findfirst((cacheDir+"openmmProgram_*.bin").c_str(), &fileInfo);
+    if (handle == -1)
+        return;
+    do {
+        string path = cacheDir+fileInfo.name;
+        files.push_back(make_pair((long long) fileInfo.time_write, path));
+        sizes[path] = fileInfo.size;
+        totalSize += fileInfo.size;
+    } while (_findnext(handle, &fileInfo) == 0);
+    _findclose(handle);
+#else
+    DIR* dir = opendir(cacheDir.c_str());
+    if (dir == NULL)
+        return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        string name = entry->d_name;
+        if (name.size() < 18 || name.compare(0, 14, "openmmProgram_") != 0 || name.compare(name.size()-4, 4, ".bin") != 0)
+            continue;
+        string path = cacheDir+name;
+        struct stat fileInfo;
+        if (stat(path.c_str(), &fileInfo) != 0)
+            continue;
+        files.push_back(make_pair((long long) fileInfo.st_mtime, path));
+        sizes[path] = fileInfo.st_size;
+        totalSize += fileInfo.st_size;
+    }
+    closedir(dir);
+#endif
+
+    // Delete the least recently used ones until the cache fits in the size limit.
+
+    if (totalSize <= cacheSizeLimit)
+        return;
+    sort(files.begin(), files.end());
+    for (int i = 0; i < files.size() && totalSize > cacheSizeLimit; i++)
+        if (remove(files[i].second.c_str()) == 0)
+            totalSize -= sizes[files[i].second];
+}
+
 cl::CommandQueue& OpenCLContext::getQueue() {
     return currentQueue;
 }
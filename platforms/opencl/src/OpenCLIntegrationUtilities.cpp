@@ -26,6 +26,7 @@
 
 #include "OpenCLIntegrationUtilities.h"
 #include "OpenCLContext.h"
+#include "openmm/internal/TraceRange.h"
 
 using namespace OpenMM;
 using namespace std;
@@ -132,6 +133,7 @@ void OpenCLIntegrationUtilities::applyConstraintsImpl(bool constrainVelocities,
 
 void OpenCLIntegrationUtilities::distributeForcesFromVirtualSites() {
     if (numVsites > 0) {
+        OPENMM_TRACE_RANGE("Distribute virtual site forces");
         vsiteForceKernel->setArg(2, context.getLongForceBuffer());
         vsiteForceKernel->execute(numVsites);
         vsiteSaveForcesKernel->setArg(0, context.getLongForceBuffer());
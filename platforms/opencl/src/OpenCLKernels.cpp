@@ -101,6 +101,16 @@ double OpenCLCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context,
     return sum;
 }
 
+void OpenCLCalcForcesAndEnergyKernel::synchronize(ContextImpl& context) {
+    cl.getQueue().finish();
+}
+
+void OpenCLCalcForcesAndEnergyKernel::getNeighborListStatistics(ContextImpl& context, map<string, double>& statistics) {
+    cl.getNonbondedUtilities().getNeighborListStatistics(statistics);
+    if (cl.getNonbondedUtilities().getUseCutoff())
+        statistics["Atom Reorders"] = cl.getNumAtomReorders();
+}
+
 void OpenCLUpdateStateDataKernel::initialize(const System& system) {
 }
 
@@ -184,6 +194,77 @@ void OpenCLUpdateStateDataKernel::getPositions(ContextImpl& context, vector<Vec3
     cl.getPlatformData().threads.waitForThreads();
 }
 
+void OpenCLUpdateStateDataKernel::gatherSubset(const vector<int>& particles, bool positions, vector<int>& atoms) {
+    // Atoms are reordered on the device, so find where each requested particle is currently stored.
+
+    const vector<int>& order = cl.getAtomIndex();
+    int numAtoms = cl.getNumAtoms();
+    vector<int> inverseOrder(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+        inverseOrder[order[i]] = i;
+    int numSubset = particles.size();
+    atoms.resize(numSubset);
+    for (int i = 0; i < numSubset; i++)
+        atoms[i] = inverseOrder[particles[i]];
+
+    // Copy the requested atoms into a compact array on the device.
+
+    if (!subsetAtoms.isInitialized()) {
+        int elementSize = (cl.getUseDoublePrecision() || cl.getUseMixedPrecision() ? sizeof(mm_double4) : sizeof(mm_float4));
+        subsetAtoms.initialize<int>(cl, numSubset, "subsetAtoms");
+        subsetData.initialize(cl, numSubset, elementSize, "subsetData");
+        ComputeProgram program = cl.compileProgram(CommonKernelSources::gatherState);
+        gatherPositionsKernel = program->createKernel("gatherPositions");
+        gatherPositionsKernel->addArg(cl.getPosq());
+        if (cl.getUseMixedPrecision())
+            gatherPositionsKernel->addArg(cl.getPosqCorrection());
+        for (int i = 0; i < 3; i++)
+            gatherPositionsKernel->addArg();
+        gatherVelocitiesKernel = program->createKernel("gatherVelocities");
+        gatherVelocitiesKernel->addArg(cl.getVelm());
+        for (int i = 0; i < 3; i++)
+            gatherVelocitiesKernel->addArg();
+    }
+    else if (subsetAtoms.getSize() != numSubset) {
+        subsetAtoms.resize(numSubset);
+        subsetData.resize(numSubset);
+    }
+    subsetAtoms.upload(atoms);
+    ComputeKernel& kernel = (positions ? gatherPositionsKernel : gatherVelocitiesKernel);
+    int firstArg = (positions && cl.getUseMixedPrecision() ? 2 : 1);
+    kernel->setArg(firstArg, subsetAtoms);
+    kernel->setArg(firstArg+1, subsetData);
+    kernel->setArg(firstArg+2, numSubset);
+    kernel->execute(numSubset);
+}
+
+void OpenCLUpdateStateDataKernel::getPositionSubset(ContextImpl& context, const vector<int>& particles, vector<Vec3>& positions) {
+    int numSubset = particles.size();
+    positions.resize(numSubset);
+    if (numSubset == 0)
+        return;
+    vector<int> atoms;
+    gatherSubset(particles, true, atoms);
+    Vec3 boxVectors[3];
+    cl.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    if (cl.getUseDoublePrecision() || cl.getUseMixedPrecision()) {
+        vector<mm_double4> pos;
+        subsetData.download(pos);
+        for (int i = 0; i < numSubset; i++) {
+            mm_int4 offset = cl.getPosCellOffsets()[atoms[i]];
+            positions[i] = Vec3(pos[i].x, pos[i].y, pos[i].z)-boxVectors[0]*offset.x-boxVectors[1]*offset.y-boxVectors[2]*offset.z;
+        }
+    }
+    else {
+        vector<mm_float4> pos;
+        subsetData.download(pos);
+        for (int i = 0; i < numSubset; i++) {
+            mm_int4 offset = cl.getPosCellOffsets()[atoms[i]];
+            positions[i] = Vec3(pos[i].x, pos[i].y, pos[i].z)-boxVectors[0]*offset.x-boxVectors[1]*offset.y-boxVectors[2]*offset.z;
+        }
+    }
+}
+
 void OpenCLUpdateStateDataKernel::setPositions(ContextImpl& context, const vector<Vec3>& positions) {
     const vector<cl_int>& order = cl.getAtomIndex();
     int numParticles = context.getSystem().getNumParticles();
@@ -256,6 +337,27 @@ void OpenCLUpdateStateDataKernel::getVelocities(ContextImpl& context, vector<Vec
     }
 }
 
+void OpenCLUpdateStateDataKernel::getVelocitySubset(ContextImpl& context, const vector<int>& particles, vector<Vec3>& velocities) {
+    int numSubset = particles.size();
+    velocities.resize(numSubset);
+    if (numSubset == 0)
+        return;
+    vector<int> atoms;
+    gatherSubset(particles, false, atoms);
+    if (cl.getUseDoublePrecision() || cl.getUseMixedPrecision()) {
+        vector<mm_double4> vel;
+        subsetData.download(vel);
+        for (int i = 0; i < numSubset; i++)
+            velocities[i] = Vec3(vel[i].x, vel[i].y, vel[i].z);
+    }
+    else {
+        vector<mm_float4> vel;
+        subsetData.download(vel);
+        for (int i = 0; i < numSubset; i++)
+            velocities[i] = Vec3(vel[i].x, vel[i].y, vel[i].z);
+    }
+}
+
 void OpenCLUpdateStateDataKernel::setVelocities(ContextImpl& context, const vector<Vec3>& velocities) {
     const vector<cl_int>& order = cl.getAtomIndex();
     int numParticles = context.getSystem().getNumParticles();
@@ -721,6 +823,8 @@ void OpenCLCalcNonbondedForceKernel::initialize(const System& system, const Nonb
     else if (((nonbondedMethod == PME || nonbondedMethod == LJPME) && hasCoulomb) || doLJPME) {
         // Compute the PME parameters.
 
+        if (force.getPMEOrder() != PmeOrder)
+            throw OpenMMException("NonbondedForce: The OpenCL platform only supports a PME order of 5");
         NonbondedForceImpl::calcPMEParameters(system, force, alpha, gridSizeX, gridSizeY, gridSizeZ, false);
         gridSizeX = OpenCLFFT3D::findLegalDimension(gridSizeX);
         gridSizeY = OpenCLFFT3D::findLegalDimension(gridSizeY);
@@ -789,6 +893,7 @@ void OpenCLCalcNonbondedForceKernel::initialize(const System& system, const Nonb
             if (pmeio == NULL) {
                 // Create required data structures.
 
+                ComputeContext::MemoryCategory category(cl, "PME");
                 int elementSize = (cl.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
                 int roundedZSize = PmeOrder*(int) ceil(gridSizeZ/(double) PmeOrder);
                 int gridElements = gridSizeX*gridSizeY*roundedZSize;
@@ -1314,40 +1419,49 @@ double OpenCLCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
             }
             if (includeEnergy)
                 cl.executeKernel(pmeEvalEnergyKernel, gridSizeX*gridSizeY*gridSizeZ);
-            cl.executeKernel(pmeConvolutionKernel, gridSizeX*gridSizeY*gridSizeZ);
-            fft->execFFT(pmeGrid2, pmeGrid1, false);
-            setPeriodicBoxArgs(cl, pmeInterpolateForceKernel, 3);
-            if (cl.getUseDoublePrecision()) {
-                pmeInterpolateForceKernel.setArg<mm_double4>(8, recipBoxVectors[0]);
-                pmeInterpolateForceKernel.setArg<mm_double4>(9, recipBoxVectors[1]);
-                pmeInterpolateForceKernel.setArg<mm_double4>(10, recipBoxVectors[2]);
-            }
-            else {
-                pmeInterpolateForceKernel.setArg<mm_float4>(8, recipBoxVectorsFloat[0]);
-                pmeInterpolateForceKernel.setArg<mm_float4>(9, recipBoxVectorsFloat[1]);
-                pmeInterpolateForceKernel.setArg<mm_float4>(10, recipBoxVectorsFloat[2]);
+            // The energy has already been computed from the transformed grid, so the convolution, inverse FFT,
+            // and force interpolation are only needed when forces are requested.
+
+            if (includeForces) {
+                cl.executeKernel(pmeConvolutionKernel, gridSizeX*gridSizeY*gridSizeZ);
+                fft->execFFT(pmeGrid2, pmeGrid1, false);
+                setPeriodicBoxArgs(cl, pmeInterpolateForceKernel, 3);
+                if (cl.getUseDoublePrecision()) {
+                    pmeInterpolateForceKernel.setArg<mm_double4>(8, recipBoxVectors[0]);
+                    pmeInterpolateForceKernel.setArg<mm_double4>(9, recipBoxVectors[1]);
+                    pmeInterpolateForceKernel.setArg<mm_double4>(10, recipBoxVectors[2]);
+                }
+                else {
+                    pmeInterpolateForceKernel.setArg<mm_float4>(8, recipBoxVectorsFloat[0]);
+                    pmeInterpolateForceKernel.setArg<mm_float4>(9, recipBoxVectorsFloat[1]);
+                    pmeInterpolateForceKernel.setArg<mm_float4>(10, recipBoxVectorsFloat[2]);
+                }
+                if (deviceIsCpu)
+                    cl.executeKernel(pmeInterpolateForceKernel, 2*cl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>(), 1);
+                else
+                    cl.executeKernel(pmeInterpolateForceKernel, cl.getNumAtoms());
             }
-            if (deviceIsCpu)
-                cl.executeKernel(pmeInterpolateForceKernel, 2*cl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>(), 1);
-            else
-                cl.executeKernel(pmeInterpolateForceKernel, cl.getNumAtoms());
         }
         
         if (doLJPME && hasLJ) {
-            setPeriodicBoxArgs(cl, pmeDispersionGridIndexKernel, 2);
-            if (cl.getUseDoublePrecision()) {
-                pmeDispersionGridIndexKernel.setArg<mm_double4>(7, recipBoxVectors[0]);
-                pmeDispersionGridIndexKernel.setArg<mm_double4>(8, recipBoxVectors[1]);
-                pmeDispersionGridIndexKernel.setArg<mm_double4>(9, recipBoxVectors[2]);
-            }
-            else {
-                pmeDispersionGridIndexKernel.setArg<mm_float4>(7, recipBoxVectorsFloat[0]);
-                pmeDispersionGridIndexKernel.setArg<mm_float4>(8, recipBoxVectorsFloat[1]);
-                pmeDispersionGridIndexKernel.setArg<mm_float4>(9, recipBoxVectorsFloat[2]);
-            }
-            cl.executeKernel(pmeDispersionGridIndexKernel, cl.getNumAtoms());
-            if (!hasCoulomb)
+            // The spreading and interpolation kernels only use pmeAtomGridIndex to decide what order to process
+            // atoms in.  If the electrostatic grid was already computed, reuse the order it was sorted into.
+
+            if (!hasCoulomb) {
+                setPeriodicBoxArgs(cl, pmeDispersionGridIndexKernel, 2);
+                if (cl.getUseDoublePrecision()) {
+                    pmeDispersionGridIndexKernel.setArg<mm_double4>(7, recipBoxVectors[0]);
+                    pmeDispersionGridIndexKernel.setArg<mm_double4>(8, recipBoxVectors[1]);
+                    pmeDispersionGridIndexKernel.setArg<mm_double4>(9, recipBoxVectors[2]);
+                }
+                else {
+                    pmeDispersionGridIndexKernel.setArg<mm_float4>(7, recipBoxVectorsFloat[0]);
+                    pmeDispersionGridIndexKernel.setArg<mm_float4>(8, recipBoxVectorsFloat[1]);
+                    pmeDispersionGridIndexKernel.setArg<mm_float4>(9, recipBoxVectorsFloat[2]);
+                }
+                cl.executeKernel(pmeDispersionGridIndexKernel, cl.getNumAtoms());
                 sort->sort(pmeAtomGridIndex);
+            }
             cl.clearBuffer(pmeGrid2);
             setPeriodicBoxArgs(cl, pmeDispersionSpreadChargeKernel, 2);
             if (cl.getUseDoublePrecision()) {
@@ -1382,23 +1496,27 @@ double OpenCLCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
             if (!hasCoulomb) cl.clearBuffer(pmeEnergyBuffer);
             if (includeEnergy)
                 cl.executeKernel(pmeDispersionEvalEnergyKernel, gridSizeX*gridSizeY*gridSizeZ);
-            cl.executeKernel(pmeDispersionConvolutionKernel, gridSizeX*gridSizeY*gridSizeZ);
-            dispersionFft->execFFT(pmeGrid2, pmeGrid1, false);
-            setPeriodicBoxArgs(cl, pmeDispersionInterpolateForceKernel, 3);
-            if (cl.getUseDoublePrecision()) {
-                pmeDispersionInterpolateForceKernel.setArg<mm_double4>(8, recipBoxVectors[0]);
-                pmeDispersionInterpolateForceKernel.setArg<mm_double4>(9, recipBoxVectors[1]);
-                pmeDispersionInterpolateForceKernel.setArg<mm_double4>(10, recipBoxVectors[2]);
-            }
-            else {
-                pmeDispersionInterpolateForceKernel.setArg<mm_float4>(8, recipBoxVectorsFloat[0]);
-                pmeDispersionInterpolateForceKernel.setArg<mm_float4>(9, recipBoxVectorsFloat[1]);
-                pmeDispersionInterpolateForceKernel.setArg<mm_float4>(10, recipBoxVectorsFloat[2]);
+            // As above, the remaining steps are only needed when forces are requested.
+
+            if (includeForces) {
+                cl.executeKernel(pmeDispersionConvolutionKernel, gridSizeX*gridSizeY*gridSizeZ);
+                dispersionFft->execFFT(pmeGrid2, pmeGrid1, false);
+                setPeriodicBoxArgs(cl, pmeDispersionInterpolateForceKernel, 3);
+                if (cl.getUseDoublePrecision()) {
+                    pmeDispersionInterpolateForceKernel.setArg<mm_double4>(8, recipBoxVectors[0]);
+                    pmeDispersionInterpolateForceKernel.setArg<mm_double4>(9, recipBoxVectors[1]);
+                    pmeDispersionInterpolateForceKernel.setArg<mm_double4>(10, recipBoxVectors[2]);
+                }
+                else {
+                    pmeDispersionInterpolateForceKernel.setArg<mm_float4>(8, recipBoxVectorsFloat[0]);
+                    pmeDispersionInterpolateForceKernel.setArg<mm_float4>(9, recipBoxVectorsFloat[1]);
+                    pmeDispersionInterpolateForceKernel.setArg<mm_float4>(10, recipBoxVectorsFloat[2]);
+                }
+                if (deviceIsCpu)
+                    cl.executeKernel(pmeDispersionInterpolateForceKernel, 2*cl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>(), 1);
+                else
+                    cl.executeKernel(pmeDispersionInterpolateForceKernel, cl.getNumAtoms());
             }
-            if (deviceIsCpu)
-                cl.executeKernel(pmeDispersionInterpolateForceKernel, 2*cl.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>(), 1);
-            else
-                cl.executeKernel(pmeDispersionInterpolateForceKernel, cl.getNumAtoms());
         }
         if (usePmeQueue) {
             pmeQueue.enqueueMarkerWithWaitList(NULL, &pmeSyncEvent);
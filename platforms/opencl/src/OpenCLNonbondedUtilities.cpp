@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
 
 using namespace OpenMM;
@@ -56,7 +57,8 @@ private:
 };
 
 OpenCLNonbondedUtilities::OpenCLNonbondedUtilities(OpenCLContext& context) : context(context), useCutoff(false), usePeriodic(false), useNeighborList(false), anyExclusions(false), usePadding(true),
-        blockSorter(NULL), pinnedCountBuffer(NULL), pinnedCountMemory(NULL), forceRebuildNeighborList(true), lastCutoff(0.0), groupFlags(0), tilesAfterReorder(0) {
+        blockSorter(NULL), pinnedCountBuffer(NULL), pinnedCountMemory(NULL), forceRebuildNeighborList(true), lastCutoff(0.0), groupFlags(0), tilesAfterReorder(0),
+        numNeighborListChecks(0), numNeighborListBuilds(0), numNeighborListReallocations(0) {
     // Decide how many thread blocks and force buffers to use.
 
     deviceIsCpu = (context.getDevice().getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU);
@@ -78,8 +80,8 @@ OpenCLNonbondedUtilities::OpenCLNonbondedUtilities(OpenCLContext& context) : con
         numForceThreadBlocks = context.getNumThreadBlocks();
         forceThreadBlockSize = (context.getSIMDWidth() >= 32 ? OpenCLContext::ThreadBlockSize : 32);
     }
-    pinnedCountBuffer = new cl::Buffer(context.getContext(), CL_MEM_ALLOC_HOST_PTR, sizeof(unsigned int));
-    pinnedCountMemory = (unsigned int*) context.getQueue().enqueueMapBuffer(*pinnedCountBuffer, CL_TRUE, CL_MAP_READ, 0, sizeof(int));
+    pinnedCountBuffer = new cl::Buffer(context.getContext(), CL_MEM_ALLOC_HOST_PTR, 2*sizeof(unsigned int));
+    pinnedCountMemory = (unsigned int*) context.getQueue().enqueueMapBuffer(*pinnedCountBuffer, CL_TRUE, CL_MAP_READ, 0, 2*sizeof(int));
     setKernelSource(deviceIsCpu ? OpenCLKernelSources::nonbonded_cpu : OpenCLKernelSources::nonbonded);
 }
 
@@ -151,13 +153,14 @@ void OpenCLNonbondedUtilities::requestExclusions(const vector<vector<int> >& exc
     if (anyExclusions) {
         bool sameExclusions = (exclusionList.size() == atomExclusions.size());
         for (int i = 0; i < (int) exclusionList.size() && sameExclusions; i++) {
-            if (exclusionList[i].size() != atomExclusions[i].size())
+            if (exclusionList[i].size() != atomExclusions[i].size()) {
                 sameExclusions = false;
-            set<int> expectedExclusions;
-            expectedExclusions.insert(atomExclusions[i].begin(), atomExclusions[i].end());
-            for (int j = 0; j < (int) exclusionList[i].size(); j++)
-                if (expectedExclusions.find(exclusionList[i][j]) == expectedExclusions.end())
-                    sameExclusions = false;
+                break;
+            }
+            vector<int> expected = atomExclusions[i], requested = exclusionList[i];
+            sort(expected.begin(), expected.end());
+            sort(requested.begin(), requested.end());
+            sameExclusions = (expected == requested);
         }
         if (!sameExclusions)
             throw OpenMMException("All Forces must have identical exceptions");
@@ -189,6 +192,7 @@ static bool compareInt2LargeSIMD(mm_int2 a, mm_int2 b) {
 }
 
 void OpenCLNonbondedUtilities::initialize(const System& system) {
+    ComputeContext::MemoryCategory category(context, "Nonbonded");
     if (atomExclusions.size() == 0) {
         // No exclusions were specifically requested, so just mark every atom as not interacting with itself.
 
@@ -203,34 +207,42 @@ void OpenCLNonbondedUtilities::initialize(const System& system) {
     int numContexts = context.getPlatformData().contexts.size();
     setAtomBlockRange(context.getContextIndex()/(double) numContexts, (context.getContextIndex()+1)/(double) numContexts);
 
-    // Build a list of tiles that contain exclusions.
+    // Build a list of tiles that contain exclusions.  Each tile is encoded as a single 64 bit key, so they can
+    // be found by sorting rather than by inserting into a set.  Consecutive exclusions of an atom usually fall
+    // in the same tile, so skip repeats as they are generated to keep the list short.
 
-    set<pair<int, int> > tilesWithExclusions;
+    vector<long long> tilesWithExclusions;
     for (int atom1 = 0; atom1 < (int) atomExclusions.size(); ++atom1) {
         int x = atom1/OpenCLContext::TileSize;
-        for (int j = 0; j < (int) atomExclusions[atom1].size(); ++j) {
-            int atom2 = atomExclusions[atom1][j];
+        for (int atom2 : atomExclusions[atom1]) {
             int y = atom2/OpenCLContext::TileSize;
-            tilesWithExclusions.insert(make_pair(max(x, y), min(x, y)));
+            long long key = (((long long) max(x, y))<<32)+min(x, y);
+            if (tilesWithExclusions.empty() || tilesWithExclusions.back() != key)
+                tilesWithExclusions.push_back(key);
         }
     }
+    sort(tilesWithExclusions.begin(), tilesWithExclusions.end());
+    tilesWithExclusions.erase(unique(tilesWithExclusions.begin(), tilesWithExclusions.end()), tilesWithExclusions.end());
     vector<mm_int2> exclusionTilesVec;
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter)
-        exclusionTilesVec.push_back(mm_int2(iter->first, iter->second));
+    for (long long key : tilesWithExclusions)
+        exclusionTilesVec.push_back(mm_int2((int) (key>>32), (int) (key&0xFFFFFFFF)));
     sort(exclusionTilesVec.begin(), exclusionTilesVec.end(), context.getSIMDWidth() <= 32 || !useCutoff ? compareInt2 : compareInt2LargeSIMD);
     exclusionTiles.initialize<mm_int2>(context, exclusionTilesVec.size(), "exclusionTiles");
     exclusionTiles.upload(exclusionTilesVec);
-    map<pair<int, int>, int> exclusionTileMap;
+    unordered_map<long long, int> exclusionTileMap;
+    exclusionTileMap.reserve(exclusionTilesVec.size());
     for (int i = 0; i < (int) exclusionTilesVec.size(); i++) {
         mm_int2 tile = exclusionTilesVec[i];
-        exclusionTileMap[make_pair(tile.x, tile.y)] = i;
+        exclusionTileMap[(((long long) tile.x)<<32)+tile.y] = i;
     }
     vector<vector<int> > exclusionBlocksForBlock(numAtomBlocks);
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter) {
-        exclusionBlocksForBlock[iter->first].push_back(iter->second);
-        if (iter->first != iter->second)
-            exclusionBlocksForBlock[iter->second].push_back(iter->first);
+    for (mm_int2 tile : exclusionTilesVec) {
+        exclusionBlocksForBlock[tile.x].push_back(tile.y);
+        if (tile.x != tile.y)
+            exclusionBlocksForBlock[tile.y].push_back(tile.x);
     }
+    for (vector<int>& blocks : exclusionBlocksForBlock)
+        sort(blocks.begin(), blocks.end());
     vector<cl_uint> exclusionRowIndicesVec(numAtomBlocks+1, 0);
     vector<cl_uint> exclusionIndicesVec;
     for (int i = 0; i < numAtomBlocks; i++) {
@@ -260,11 +272,11 @@ void OpenCLNonbondedUtilities::initialize(const System& system) {
             int y = atom2/OpenCLContext::TileSize;
             int offset2 = atom2-y*OpenCLContext::TileSize;
             if (x > y) {
-                int index = exclusionTileMap[make_pair(x, y)]*OpenCLContext::TileSize;
+                int index = exclusionTileMap[(((long long) x)<<32)+y]*OpenCLContext::TileSize;
                 exclusionVec[index+offset1] &= allFlags-(1<<offset2);
             }
             else {
-                int index = exclusionTileMap[make_pair(y, x)]*OpenCLContext::TileSize;
+                int index = exclusionTileMap[(((long long) y)<<32)+x]*OpenCLContext::TileSize;
                 exclusionVec[index+offset2] &= allFlags-(1<<offset1);
             }
         }
@@ -284,9 +296,12 @@ void OpenCLNonbondedUtilities::initialize(const System& system) {
         if (maxTiles < 1)
             maxTiles = 1;
         int numAtoms = context.getNumAtoms();
-        interactingTiles.initialize<cl_int>(context, maxTiles, "interactingTiles");
-        interactingAtoms.initialize<cl_int>(context, OpenCLContext::TileSize*maxTiles, "interactingAtoms");
-        interactionCount.initialize<cl_uint>(context, 1, "interactionCount");
+        {
+            ComputeContext::MemoryCategory listCategory(context, "Neighbor List");
+            interactingTiles.initialize<cl_int>(context, maxTiles, "interactingTiles");
+            interactingAtoms.initialize<cl_int>(context, OpenCLContext::TileSize*maxTiles, "interactingAtoms");
+            interactionCount.initialize<cl_uint>(context, 1, "interactionCount");
+        }
         int elementSize = (context.getUseDoublePrecision() ? sizeof(cl_double) : sizeof(cl_float));
         blockCenter.initialize(context, numAtomBlocks, 4*elementSize, "blockCenter");
         blockBoundingBox.initialize(context, numAtomBlocks, 4*elementSize, "blockBoundingBox");
@@ -361,7 +376,8 @@ void OpenCLNonbondedUtilities::prepareInteractions(int forceGroups) {
     context.executeKernel(kernels.findInteractingBlocksKernel, context.getNumAtoms(), interactingBlocksThreadBlockSize);
     forceRebuildNeighborList = false;
     lastCutoff = kernels.cutoffDistance;
-    context.getQueue().enqueueReadBuffer(interactionCount.getDeviceBuffer(), CL_FALSE, 0, sizeof(int), pinnedCountMemory, NULL, &downloadCountEvent);
+    context.getQueue().enqueueReadBuffer(interactionCount.getDeviceBuffer(), CL_FALSE, 0, sizeof(int), pinnedCountMemory);
+    context.getQueue().enqueueReadBuffer(rebuildNeighborList.getDeviceBuffer(), CL_FALSE, 0, sizeof(int), &pinnedCountMemory[1], NULL, &downloadCountEvent);
 
     #if __APPLE__ && defined(__aarch64__)
     // Segment the command stream to avoid stalls later.
@@ -389,10 +405,31 @@ void OpenCLNonbondedUtilities::computeInteractions(int forceGroups, bool include
             context.getQueue().flush();
         #endif
         downloadCountEvent.wait();
+        numNeighborListChecks++;
+        if (pinnedCountMemory[1] != 0)
+            numNeighborListBuilds++;
         updateNeighborListSize();
     }
 }
 
+void OpenCLNonbondedUtilities::getNeighborListStatistics(map<string, double>& statistics) {
+    if (!useNeighborList || numTiles == 0)
+        return;
+    statistics["Neighbor List Checks"] = numNeighborListChecks;
+    statistics["Neighbor List Builds"] = numNeighborListBuilds;
+    statistics["Neighbor List Reallocations"] = numNeighborListReallocations;
+    if (numNeighborListChecks == 0)
+        return;
+    vector<cl_uint> count;
+    interactionCount.download(count);
+    int numInteractingTiles = min((int) count[0], (int) interactingTiles.getSize());
+    long long numPairs, numPairsInCutoff;
+    context.countNeighborListPairs(numInteractingTiles, getMaxCutoffDistance(), numPairs, numPairsInCutoff);
+    statistics["Interacting Tiles"] = numInteractingTiles;
+    statistics["Neighbor List Pairs"] = numPairs;
+    statistics["Pairs Within Cutoff"] = numPairsInCutoff;
+}
+
 bool OpenCLNonbondedUtilities::updateNeighborListSize() {
     if (!useCutoff)
         return false;
@@ -400,15 +437,19 @@ bool OpenCLNonbondedUtilities::updateNeighborListSize() {
         tilesAfterReorder = pinnedCountMemory[0];
     else if (context.getStepsSinceReorder() > 25 && pinnedCountMemory[0] > 1.1*tilesAfterReorder)
         context.forceReorder();
-    if (pinnedCountMemory[0] <= interactingTiles.getSize())
+    unsigned int currentSize = interactingTiles.getSize();
+    unsigned int numBlocks = context.getNumAtomBlocks();
+    unsigned int totalTiles = numBlocks*(numBlocks+1)/2;
+    bool overflow = (pinnedCountMemory[0] > currentSize);
+    if (pinnedCountMemory[0] <= 0.9*currentSize || currentSize >= totalTiles)
         return false;
 
-    // The most recent timestep had too many interactions to fit in the arrays.  Make the arrays bigger to prevent
-    // this from happening in the future.
+    // Either the most recent timestep had too many interactions to fit in the arrays, or they are nearly full.
+    // Make the arrays bigger to prevent this from happening in the future.  Growing them before they overflow
+    // only requires rebuilding the neighbor list, whereas an overflow also requires the forces to be recomputed.
 
-    unsigned int maxTiles = (unsigned int) (1.2*pinnedCountMemory[0]);
-    unsigned int numBlocks = context.getNumAtomBlocks();
-    int totalTiles = numBlocks*(numBlocks+1)/2;
+    numNeighborListReallocations++;
+    unsigned int maxTiles = (unsigned int) (1.2*max(pinnedCountMemory[0], currentSize));
     if (maxTiles > totalTiles)
         maxTiles = totalTiles;
     interactingTiles.resize(maxTiles);
@@ -435,6 +476,8 @@ bool OpenCLNonbondedUtilities::updateNeighborListSize() {
         kernels.findInteractingBlocksKernel.setArg<cl_uint>(9, maxTiles);
     }
     forceRebuildNeighborList = true;
+    if (!overflow)
+        return false;
     context.setForcesValid(false);
     return true;
 }
@@ -211,6 +211,33 @@ double OpenCLParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& c
     return energy;
 }
 
+void OpenCLParallelCalcForcesAndEnergyKernel::synchronize(ContextImpl& context) {
+    data.syncContexts();
+    for (auto cl : data.contexts)
+        cl->getQueue().finish();
+}
+
+void OpenCLParallelCalcForcesAndEnergyKernel::getNeighborListStatistics(ContextImpl& context, map<string, double>& statistics) {
+    // Each device has its own neighbor list for its share of the tiles.  Sizes are summed over the
+    // devices, while counts of events such as rebuilds are the largest value from any device.
+
+    data.syncContexts();
+    for (int i = 0; i < (int) data.contexts.size(); i++) {
+        map<string, double> deviceStatistics;
+        getKernel(i).getNeighborListStatistics(context, deviceStatistics);
+        for (auto& entry : deviceStatistics) {
+            const string& name = entry.first;
+            bool isSize = (name == "Interacting Tiles" || name == "Single Pairs" || name == "Neighbor List Pairs" || name == "Pairs Within Cutoff");
+            if (statistics.find(name) == statistics.end())
+                statistics[name] = entry.second;
+            else if (isSize)
+                statistics[name] += entry.second;
+            else
+                statistics[name] = max(statistics[name], entry.second);
+        }
+    }
+}
+
 class OpenCLParallelCalcHarmonicBondForceKernel::Task : public OpenCLContext::WorkTask {
 public:
     Task(ContextImpl& context, CommonCalcHarmonicBondForceKernel& kernel, bool includeForce,
@@ -84,12 +84,14 @@ OpenCLPlatform::OpenCLPlatform() {
     registerKernelFactory(CalcCustomCompoundBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomCVForceKernel::Name(), factory);
     registerKernelFactory(CalcRMSDForceKernel::Name(), factory);
+    registerKernelFactory(CalcExternalForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
@@ -172,6 +174,33 @@ const string& OpenCLPlatform::getPropertyValue(const Context& context, const str
 void OpenCLPlatform::setPropertyValue(Context& context, const string& property, const string& value) const {
 }
 
+map<string, double> OpenCLPlatform::getMemoryUsage(const Context& context) const {
+    const ContextImpl& impl = getContextImpl(context);
+    const PlatformData* data = reinterpret_cast<const PlatformData*>(impl.getPlatformData());
+    map<string, double> usage;
+    for (OpenCLContext* device : data->contexts)
+        for (auto& category : device->getMemoryUsage())
+            usage[category.first] += category.second;
+    return usage;
+}
+
+map<string, double> OpenCLPlatform::estimateMemoryUsage(const System& system, const map<string, string>& properties) const {
+    string precision = (properties.find(OpenCLPrecision()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLPrecision()) : properties.find(OpenCLPrecision())->second);
+    string cpuPme = (properties.find(OpenCLUseCpuPme()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLUseCpuPme()) : properties.find(OpenCLUseCpuPme())->second);
+    transform(precision.begin(), precision.end(), precision.begin(), ::tolower);
+    transform(cpuPme.begin(), cpuPme.end(), cpuPme.begin(), ::tolower);
+    map<string, double> usage = ComputeContext::estimateMemoryUsage(system, precision == "double", precision == "mixed");
+    if (cpuPme == "true" && usage.find("PME") != usage.end()) {
+        // The reciprocal space calculation will be done on the CPU.
+
+        usage["Total"] -= usage["PME"];
+        usage.erase("PME");
+    }
+    return usage;
+}
+
 void OpenCLPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
     const string& platformPropValue = (properties.find(OpenCLPlatformIndex()) == properties.end() ?
             getPropertyDefaultValue(OpenCLPlatformIndex()) : properties.find(OpenCLPlatformIndex())->second);
@@ -34,6 +34,7 @@
 #define CL_HPP_MINIMUM_OPENCL_VERSION 120
 #include "OpenCLTests.h"
 #include "TestNonbondedForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
 #include "opencl.hpp"
 #include <string>
 
@@ -156,12 +157,55 @@ bool canRunHugeTest() {
     return (memory >= 4*(long long)(1<<30));
 }
 
+void testMemoryUsage() {
+    // Check that memory is reported in the expected categories, and that the estimate
+    // is reasonably close to it.
+
+    const int numParticles = 3000;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce *nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+        positions.push_back(Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*boxSize);
+    }
+    map<string, double> estimate = platform.estimateMemoryUsage(system);
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    integrator.step(10);
+    map<string, double> usage = platform.getMemoryUsage(context);
+    double sum = 0.0;
+    for (string category : {"Context", "Integration", "Nonbonded", "Neighbor List", "PME"}) {
+        ASSERT(usage.find(category) != usage.end());
+        ASSERT(usage[category] > 0);
+        ASSERT(estimate.find(category) != estimate.end());
+        ASSERT(estimate[category] > 0);
+    }
+    for (auto& category : usage)
+        if (category.first != "Total" && category.first != "Peak")
+            sum += category.second;
+    ASSERT_EQUAL_TOL(sum, usage["Total"], 1e-10);
+    ASSERT(usage["Peak"] >= usage["Total"]);
+    ASSERT(estimate["Total"] > 0.5*usage["Total"]);
+    ASSERT(estimate["Total"] < 2.0*usage["Total"]);
+}
+
 void runPlatformTests() {
     testParallelComputation(NonbondedForce::NoCutoff);
     testParallelComputation(NonbondedForce::Ewald);
     testParallelComputation(NonbondedForce::PME);
     testParallelComputation(NonbondedForce::LJPME);
     testReordering();
+    testMemoryUsage();
     if (canRunHugeTest()) {
         double tol = (platform.getPropertyDefaultValue("Precision") == "single" ? 1e-4 : 1e-5);
         testHugeSystem(tol);
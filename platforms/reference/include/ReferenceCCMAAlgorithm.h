@@ -29,6 +29,7 @@
 #include <utility>
 #include <vector>
 #include <set>
+#include <string>
 
 namespace OpenMM {
 
@@ -116,6 +117,30 @@ public:
      */
     const std::vector<std::vector<std::pair<int, double> > >& getMatrix() const;
 
+    /**
+     * Get the parameters describing one constraint.
+     *
+     * @param index     the index of the constraint
+     * @param atom1     the index of the first atom
+     * @param atom2     the index of the second atom
+     * @param distance  the constrained distance between the atoms
+     */
+    void getConstraintParameters(int index, int& atom1, int& atom2, double& distance) const;
+
+    /**
+     * Discard all inverse matrices that have been cached.  Creating a ReferenceCCMAAlgorithm for
+     * the same constraints, masses, and angles as a previous one reuses its inverse matrix, which
+     * greatly reduces the cost of creating many Contexts for the same System.
+     */
+    static void clearMatrixCache();
+
+private:
+
+    void computeMatrix(int numberOfAtoms, std::vector<double>& masses, std::vector<AngleInfo>& angles);
+    std::string createMatrixKey(int numberOfAtoms, const std::vector<double>& masses, const std::vector<AngleInfo>& angles) const;
+    static bool findCachedMatrix(const std::string& key, std::vector<std::vector<std::pair<int, double> > >& matrix);
+    static void cacheMatrix(const std::string& key, const std::vector<std::vector<std::pair<int, double> > >& matrix);
+
 };
 
 class ReferenceCCMAAlgorithm::AngleInfo
@@ -41,20 +41,6 @@ private:
     bool usePeriodic;
     Vec3 boxVectors[3];
 
-    /**---------------------------------------------------------------------------------------
-
-       Calculate the interaction due to a single torsion pair
-
-       @param index            the index of the torsion
-       @param atomCoordinates  atom coordinates
-       @param forces           force array (forces added)
-       @param totalEnergy      total energy
-
-         --------------------------------------------------------------------------------------- */
-
-    void calculateOneIxn(int index, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& forces,
-                         double* totalEnergy) const;
-
 public:
 
     /**---------------------------------------------------------------------------------------
@@ -89,6 +75,20 @@ public:
 
     void calculateIxn(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& forces, double* totalEnergy) const;
 
+    /**---------------------------------------------------------------------------------------
+
+       Calculate the interaction due to a single torsion pair
+
+       @param index            the index of the torsion
+       @param atomCoordinates  atom coordinates
+       @param forces           force array (forces added)
+       @param totalEnergy      total energy
+
+         --------------------------------------------------------------------------------------- */
+
+    void calculateOneIxn(int index, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& forces,
+                         double* totalEnergy) const;
+
     /**---------------------------------------------------------------------------------------
 
        This is present only because we must define it to subclass ReferenceBondIxn.  It is never called.
@@ -44,6 +44,9 @@ private:
     std::vector<Lepton::CompiledExpression> paramDerivExpressions;
     std::vector<double> globalValues, cvValues;
     std::vector<Lepton::CustomFunction*> tabulatedFunctions;
+    std::vector<bool> cvAffectsEnergy;
+    std::vector<std::vector<std::pair<int, Vec3> > > cvForces;
+    std::vector<std::map<std::string, double> > cvDerivs;
 
 public:
     /**
@@ -68,12 +71,13 @@ public:
      * @param innerContext       the context created by the force for evaluating collective variables
      * @param atomCoordinates    atom coordinates
      * @param globalParameters   the values of global parameters
+     * @param includeForces      true if forces should be computed
      * @param forces             the forces are added to this
      * @param totalEnergy        the energy is added to this
      * @param energyParamDerivs  parameter derivatives are added to this
      */
    void calculateIxn(ContextImpl& innerContext, std::vector<OpenMM::Vec3>& atomCoordinates,
-                     const std::map<std::string, double>& globalParameters,
+                     const std::map<std::string, double>& globalParameters, bool includeForces,
                      std::vector<OpenMM::Vec3>& forces, double* totalEnergy, std::map<std::string, double>& energyParamDerivs);
 };
 
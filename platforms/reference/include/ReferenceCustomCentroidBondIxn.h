@@ -55,14 +55,14 @@ class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
 
          Calculate custom interaction for one bond
 
-         @param bond             the index of the bond
+         @param groups           the indices of the groups in the bond
          @param groupCenters     group center coordinates
          @param forces           force array (forces added)
          @param totalEnergy      total energy
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateOneIxn(int bond, std::vector<OpenMM::Vec3>& groupCenters,
+      void calculateOneIxn(const std::vector<int>& groups, std::vector<OpenMM::Vec3>& groupCenters,
                            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
       void computeDelta(int group1, int group2, double* delta, std::vector<OpenMM::Vec3>& groupCenters) const;
@@ -110,6 +110,53 @@ class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
            return bondGroups;
        }
 
+      /**---------------------------------------------------------------------------------------
+
+         Get the atoms in each group.
+
+         --------------------------------------------------------------------------------------- */
+
+       const std::vector<std::vector<int> >& getGroupAtoms() const {
+           return groupAtoms;
+       }
+
+      /**---------------------------------------------------------------------------------------
+
+         Get the normalized weights of the atoms in each group.
+
+         --------------------------------------------------------------------------------------- */
+
+       const std::vector<std::vector<double> >& getNormalizedWeights() const {
+           return normalizedWeights;
+       }
+
+      /**---------------------------------------------------------------------------------------
+
+         Set the values of all global parameters.
+
+         --------------------------------------------------------------------------------------- */
+
+       void setGlobalParameters(std::map<std::string, double> parameters);
+
+      /**---------------------------------------------------------------------------------------
+
+         Calculate the interaction for a single bond.  This operates on groups rather than atoms:
+         the coordinates are the group centers, and forces are accumulated on groups.
+         setGlobalParameters() must have been called first.
+
+         @param atomIndices      the indices of the groups in the bond
+         @param atomCoordinates  the center of each group
+         @param parameters       the parameter values for the bond
+         @param forces           the force on each group (forces added)
+         @param totalEnergy      if not null, the energy will be added to this
+         @param energyParamDerivs  derivatives of the energy with respect to global parameters are added to this
+
+         --------------------------------------------------------------------------------------- */
+
+      void calculateBondIxn(std::vector<int>& atomIndices, std::vector<OpenMM::Vec3>& atomCoordinates,
+                            std::vector<double>& parameters, std::vector<OpenMM::Vec3>& forces,
+                            double* totalEnergy, double* energyParamDerivs);
+
       /**---------------------------------------------------------------------------------------
 
          Calculate custom compound bond interaction
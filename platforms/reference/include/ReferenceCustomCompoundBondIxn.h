@@ -53,14 +53,14 @@ class ReferenceCustomCompoundBondIxn : public ReferenceBondIxn {
 
          Calculate custom interaction for one bond
 
-         @param bond             the index of the bond
+         @param atoms            the indices of the atoms in the bond
          @param atomCoordinates  atom coordinates
          @param forces           force array (forces added)
          @param totalEnergy      total energy
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateOneIxn(int bond, std::vector<OpenMM::Vec3>& atomCoordinates,
+      void calculateOneIxn(const std::vector<int>& atoms, std::vector<OpenMM::Vec3>& atomCoordinates,
                            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
       void computeDelta(int atom1, int atom2, double* delta, std::vector<OpenMM::Vec3>& atomCoordinates) const;
@@ -107,6 +107,32 @@ class ReferenceCustomCompoundBondIxn : public ReferenceBondIxn {
            return bondAtoms;
        }
 
+      /**---------------------------------------------------------------------------------------
+
+         Set the values of all global parameters.
+
+         --------------------------------------------------------------------------------------- */
+
+       void setGlobalParameters(std::map<std::string, double> parameters);
+
+      /**---------------------------------------------------------------------------------------
+
+         Calculate the interaction for a single bond.  setGlobalParameters() must have been
+         called first.
+
+         @param atomIndices      the indices of the atoms in the bond
+         @param atomCoordinates  atom coordinates
+         @param parameters       the parameter values for the bond
+         @param forces           force array (forces added)
+         @param totalEnergy      if not null, the energy will be added to this
+         @param energyParamDerivs  derivatives of the energy with respect to global parameters are added to this
+
+         --------------------------------------------------------------------------------------- */
+
+      void calculateBondIxn(std::vector<int>& atomIndices, std::vector<OpenMM::Vec3>& atomCoordinates,
+                            std::vector<double>& parameters, std::vector<OpenMM::Vec3>& forces,
+                            double* totalEnergy, double* energyParamDerivs);
+
       /**---------------------------------------------------------------------------------------
 
          Calculate custom compound bond interaction
@@ -31,6 +31,7 @@
 #include "openmm/internal/CustomIntegratorUtilities.h"
 #include "openmm/internal/CompiledExpressionSet.h"
 #include "openmm/internal/VectorExpression.h"
+#include "openmm/internal/windowsExport.h"
 #include "lepton/CompiledExpression.h"
 
 #include <map>
@@ -39,7 +40,7 @@
 
 namespace OpenMM {
 
-class ReferenceCustomDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceCustomDynamics : public ReferenceDynamics {
 private:
 
     class DerivFunction;
@@ -66,10 +67,6 @@ private:
     
     Lepton::ExpressionTreeNode replaceDerivFunctions(const Lepton::ExpressionTreeNode& node, OpenMM::ContextImpl& context);
     
-    void computePerDof(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
-                  const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses,
-                  const std::vector<std::vector<OpenMM::Vec3> >& perDof, const Lepton::CompiledExpression& expression);
-    
     void computePerParticle(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
                   const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses,
                   const std::vector<std::vector<OpenMM::Vec3> >& perDof, const std::map<std::string, double>& globals, const VectorExpression& expression);
@@ -77,6 +74,27 @@ private:
     void recordChangedParameters(OpenMM::ContextImpl& context, std::map<std::string, double>& globals);
 
     bool evaluateCondition(int step);
+
+protected:
+
+      /**---------------------------------------------------------------------------------------
+      
+         Evaluate a per-DOF expression for every degree of freedom
+      
+         @param numberOfAtoms       number of atoms
+         @param results             the computed values are stored into this
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param forces              forces
+         @param masses              atom masses
+         @param perDof              the values of per-DOF variables
+         @param expression          the expression to evaluate
+      
+         --------------------------------------------------------------------------------------- */
+      
+    virtual void computePerDof(int numberOfAtoms, std::vector<OpenMM::Vec3>& results, const std::vector<OpenMM::Vec3>& atomCoordinates,
+                  const std::vector<OpenMM::Vec3>& velocities, const std::vector<OpenMM::Vec3>& forces, const std::vector<double>& masses,
+                  const std::vector<std::vector<OpenMM::Vec3> >& perDof, const Lepton::CompiledExpression& expression);
       
 public:
 
@@ -25,6 +25,7 @@
 #define __ReferenceCustomManyParticleIxn_H__
 
 #include "ReferenceBondIxn.h"
+#include "ReferenceNeighborList.h"
 #include "openmm/CustomManyParticleForce.h"
 #include "lepton/ExpressionProgram.h"
 #include "lepton/ParsedExpression.h"
@@ -43,6 +44,7 @@ class ReferenceCustomManyParticleIxn {
       bool useCutoff, usePeriodic, centralParticleMode;
       double cutoffDistance;
       OpenMM::Vec3* periodicBoxVectors;
+      const OpenMM::CompactNeighborList* neighborList;
       Lepton::ExpressionProgram energyExpression;
       std::vector<std::vector<std::string> > particleParamNames;
       std::vector<std::set<int> > exclusions;
@@ -117,6 +119,19 @@ class ReferenceCustomManyParticleIxn {
 
       void setPeriodic(OpenMM::Vec3* vectors);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set the neighbor list to use for finding particles within the cutoff.  This requires
+         that a cutoff has already been set.  Every particle in an interaction must be a neighbor
+         of the first one, so only those are considered as candidates.  If this is not called,
+         all combinations of particles are checked.
+
+         @param neighbors  the neighbor list to use
+
+         --------------------------------------------------------------------------------------- */
+
+      void setNeighborList(const OpenMM::CompactNeighborList& neighbors);
+
       /**---------------------------------------------------------------------------------------
 
          Calculate the interaction
@@ -28,6 +28,7 @@
 #include "ReferencePairIxn.h"
 #include "ReferenceNeighborList.h"
 #include "openmm/internal/CompiledExpressionSet.h"
+#include "openmm/internal/ThreadPool.h"
 #include <map>
 #include <set>
 #include <utility>
@@ -53,6 +54,30 @@ class ReferenceCustomNonbondedIxn {
       std::vector<int> particleParamIndex, computedValueIndex;
       int rIndex;
       std::vector<std::pair<std::set<int>, std::set<int> > > interactionGroups;
+      OpenMM::ThreadPool* threads;
+
+      /**---------------------------------------------------------------------------------------
+
+         Create a copy of this object with the same settings, for use by another thread.  Each
+         thread needs its own copy of the expressions, since setting variables modifies them.
+
+         --------------------------------------------------------------------------------------- */
+
+      ReferenceCustomNonbondedIxn* createThreadCopy() const;
+
+      /**---------------------------------------------------------------------------------------
+
+         Set the variables for the per-particle parameters and computed values of two atoms
+
+         @param atom1            the index of the first atom
+         @param atom2            the index of the second atom
+         @param atomParameters   atom parameters                atomParameters[atomIndex][paramterIndex]
+         @param computedValues   computed values                computedValues[valueIndex][atomIndex]
+
+         --------------------------------------------------------------------------------------- */
+
+      void setPairVariables(int atom1, int atom2, const std::vector<std::vector<double> >& atomParameters,
+                            const std::vector<std::vector<double> >& computedValues);
 
       /**---------------------------------------------------------------------------------------
 
@@ -134,6 +159,17 @@ class ReferenceCustomNonbondedIxn {
 
       void setPeriodic(OpenMM::Vec3* vectors);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set the ThreadPool to use for computing the interactions.  If this is NULL (the
+         default), everything is computed on the calling thread.
+
+         @param threads    the ThreadPool to use
+
+         --------------------------------------------------------------------------------------- */
+
+      void setThreadPool(OpenMM::ThreadPool* threads);
+
       /**---------------------------------------------------------------------------------------
 
          Calculate custom pair ixn
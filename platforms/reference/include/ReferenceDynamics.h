@@ -26,6 +26,7 @@
 #define __ReferenceDynamics_H__
 
 #include "ReferenceConstraintAlgorithm.h"
+#include "ReferenceVirtualSites.h"
 #include "openmm/System.h"
 #include <cstddef>
 #include <vector>
@@ -54,7 +55,22 @@ class OPENMM_EXPORT ReferenceDynamics {
 
       int _ownReferenceConstraint;
       ReferenceConstraintAlgorithm* _referenceConstraint;
+      ReferenceVirtualSites* _virtualSites;
       
+   protected:
+
+      /**---------------------------------------------------------------------------------------
+      
+         Compute the positions of all virtual sites.  This uses the object passed to
+         setVirtualSites() if there is one, and ReferenceVirtualSites::computePositions() otherwise.
+      
+         @param system              the System being integrated
+         @param atomCoordinates     atom coordinates
+      
+         --------------------------------------------------------------------------------------- */
+      
+      void computeVirtualSites(const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates);
+
    public:
 
       /**---------------------------------------------------------------------------------------
@@ -170,6 +186,17 @@ class OPENMM_EXPORT ReferenceDynamics {
          --------------------------------------------------------------------------------------- */
       
       void setReferenceConstraintAlgorithm(ReferenceConstraintAlgorithm* referenceConstraint);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Set the object used to compute the positions of virtual sites.  It is not deleted
+         when this object is.
+      
+         @param virtualSites  the object to use, or NULL to use ReferenceVirtualSites::computePositions()
+      
+         --------------------------------------------------------------------------------------- */
+      
+      void setVirtualSites(ReferenceVirtualSites* virtualSites);
 };
 
 } // namespace OpenMM
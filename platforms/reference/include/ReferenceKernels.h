@@ -108,6 +108,19 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * Wait until all calculations that have been queued for this context have completed.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void synchronize(ContextImpl& context);
+    /**
+     * Get statistics describing the neighbor list used for nonbonded interactions.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param statistics  the statistics are added to this, keyed by name
+     */
+    void getNeighborListStatistics(ContextImpl& context, std::map<std::string, double>& statistics);
 private:
     std::vector<Vec3> savedForces;
 };
@@ -156,6 +169,13 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     void getPositions(ContextImpl& context, std::vector<Vec3>& positions);
+    /**
+     * Get the positions of a subset of the particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, this contains the positions of the requested particles in the same order as particles
+     */
+    void getPositionSubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions);
     /**
      * Set the positions of all particles.
      *
@@ -168,6 +188,13 @@ public:
      * @param velocities  on exit, this contains the particle velocities
      */
     void getVelocities(ContextImpl& context, std::vector<Vec3>& velocities);
+    /**
+     * Get the velocities of a subset of the particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, this contains the velocities of the requested particles in the same order as particles
+     */
+    void getVelocitySubset(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities);
     /**
      * Set the velocities of all particles.
      *
@@ -653,7 +680,7 @@ private:
     std::vector<std::array<double, 3> > baseParticleParams, baseExceptionParams;
     std::map<std::pair<std::string, int>, std::array<double, 3> > particleParamOffsets, exceptionParamOffsets;
     double nonbondedCutoff, switchingDistance, rfDielectric, ewaldAlpha, ewaldDispersionAlpha, dispersionCoefficient;
-    int kmax[3], gridSize[3], dispersionGridSize[3];
+    int kmax[3], gridSize[3], dispersionGridSize[3], pmeOrder;
     bool useSwitchingFunction, exceptionsArePeriodic;
     std::vector<std::set<int> > exclusions;
     NonbondedMethod nonbondedMethod;
@@ -1130,6 +1157,34 @@ private:
     std::vector<int> particles;
 };
 
+/**
+ * This kernel is invoked by ExternalForce to calculate the forces acting on the system and the energy of the system.
+ */
+class ReferenceCalcExternalForceKernel : public CalcExternalForceKernel {
+public:
+    ReferenceCalcExternalForceKernel(std::string name, const Platform& platform) : CalcExternalForceKernel(name, platform), computation(NULL) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param force      the ExternalForce this kernel will be used for
+     */
+    void initialize(const System& system, const ExternalForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+private:
+    ExternalForce::Computation* computation;
+    std::vector<Vec3> forces;
+};
+
 /**
  * This kernel is invoked by VerletIntegrator to take one time step.
  */
@@ -1342,6 +1397,58 @@ private:
     double prevTemp, prevFriction, prevStepSize;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class ReferenceIntegrateMTSLangevinStepKernel : public IntegrateMTSLangevinStepKernel {
+public:
+    ReferenceIntegrateMTSLangevinStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) : IntegrateMTSLangevinStepKernel(name, platform),
+        data(data) {
+    }
+    /**
+     * Initialize the kernel, setting up the particle masses.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const MTSLangevinIntegrator& integrator);
+    /**
+     * Update the velocities based on the most recently computed forces.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the time interval over which to apply the forces
+     */
+    void updateVelocities(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt);
+    /**
+     * Advance the positions by half a substep, interact with the heat bath, advance them by another half
+     * substep, and then apply constraints to the positions and velocities.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the size of the substep
+     */
+    void updatePositions(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt);
+    /**
+     * Apply constraints to the velocities at the end of a time step, and advance the time and step count.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    void finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+private:
+    ReferencePlatform::PlatformData& data;
+    std::vector<double> masses, inverseMasses;
+    std::vector<Vec3> xPrime, oldx;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -1396,14 +1503,17 @@ public:
      */
     void initialize(const System& system, const VariableLangevinIntegrator& integrator);
     /**
-     * Execute the kernel.
+     * Execute the kernel.  This advances the simulation by up to maxSteps time steps, stopping early once
+     * maxTime is reached.  The kernel is responsible for computing forces before each step, which allows
+     * a platform to take many steps without synchronizing with the host after each one.
      *
      * @param context    the context in which to execute this kernel
      * @param integrator the VariableLangevinIntegrator this kernel is being used for
      * @param maxTime    the maximum time beyond which the simulation should not be advanced
-     * @return the size of the step that was taken
+     * @param maxSteps   the maximum number of steps to take
+     * @return the size of the last step that was taken
      */
-    double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime);
+    double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime, int maxSteps);
     /**
      * Compute the kinetic energy.
      * 
@@ -1435,14 +1545,17 @@ public:
      */
     void initialize(const System& system, const VariableVerletIntegrator& integrator);
     /**
-     * Execute the kernel.
+     * Execute the kernel.  This advances the simulation by up to maxSteps time steps, stopping early once
+     * maxTime is reached.  The kernel is responsible for computing forces before each step, which allows
+     * a platform to take many steps without synchronizing with the host after each one.
      *
      * @param context    the context in which to execute this kernel
      * @param integrator the VariableVerletIntegrator this kernel is being used for
      * @param maxTime    the maximum time beyond which the simulation should not be advanced
-     * @return the size of the step that was taken
+     * @param maxSteps   the maximum number of steps to take
+     * @return the size of the last step that was taken
      */
-    double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime);
+    double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime, int maxSteps);
     /**
      * Compute the kinetic energy.
      * 
@@ -27,6 +27,7 @@
 
 #include "ReferencePairIxn.h"
 #include "ReferenceNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
 
 namespace OpenMM {
 
@@ -40,12 +41,14 @@ class ReferenceLJCoulombIxn {
       bool ewald;
       bool pme, ljpme;
       const OpenMM::NeighborList* neighborList;
+      OpenMM::ThreadPool* threads;
       OpenMM::Vec3 periodicBoxVectors[3];
       double cutoffDistance, switchingDistance;
       double krf, crf;
       double alphaEwald, alphaDispersionEwald;
       int numRx, numRy, numRz;
       int meshDim[3], dispersionMeshDim[3];
+      int pmeOrder;
 
       // parameter indices
 
@@ -143,10 +146,11 @@ class ReferenceLJCoulombIxn {
 
          @param alpha    the Ewald separation parameter
          @param gridSize the dimensions of the mesh
+         @param order    the order of the B-spline interpolation
 
          --------------------------------------------------------------------------------------- */
       
-      void setUsePME(double alpha, int meshSize[3]);
+      void setUsePME(double alpha, int meshSize[3], int order);
       
       /**---------------------------------------------------------------------------------------
 
@@ -154,10 +158,11 @@ class ReferenceLJCoulombIxn {
 
          @param dalpha    the dispersion Ewald separation parameter
          @param dgridSize the dimensions of the dispersion mesh
+         @param order     the order of the B-spline interpolation
 
          --------------------------------------------------------------------------------------- */
 
-      void setUseLJPME(double dalpha, int dmeshSize[3]);
+      void setUseLJPME(double dalpha, int dmeshSize[3], int order);
       
       /**---------------------------------------------------------------------------------------
 
@@ -167,6 +172,17 @@ class ReferenceLJCoulombIxn {
 
       void setPeriodicExceptions(bool periodic);
 
+      /**---------------------------------------------------------------------------------------
+      
+         Set the ThreadPool to use for computing the interactions.  If this is NULL (the
+         default), everything is computed on the calling thread.
+      
+         @param threads    the ThreadPool to use
+      
+         --------------------------------------------------------------------------------------- */
+      
+      void setThreadPool(OpenMM::ThreadPool* threads);
+
       /**---------------------------------------------------------------------------------------
       
          Calculate LJ Coulomb pair ixn
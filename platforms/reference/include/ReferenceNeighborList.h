@@ -44,6 +44,82 @@ void OPENMM_EXPORT computeNeighborListVoxelHash(
                               bool reportSymmetricPairs = false
                             );
 
+/**
+ * A neighbor list stored in compressed sparse row format.  The neighbors of each atom are stored
+ * contiguously in ascending order, and each pair appears in the lists of both atoms.
+ *
+ * The list is built with a padding distance added to the cutoff, and exclusions are not applied to
+ * it, so a single list can be shared by every Force that uses the same cutoff.  update() only
+ * rebuilds it when some atom has moved more than half the padding distance since the last build,
+ * or the periodic box has changed.  getPairs() then selects the pairs that are actually within the
+ * cutoff.
+ */
+class OPENMM_EXPORT CompactNeighborList {
+public:
+    /**
+     * Create a CompactNeighborList.
+     *
+     * @param maxDistance    the cutoff distance
+     * @param padding        the extra distance to include in the list
+     * @param usePeriodic    whether to apply periodic boundary conditions
+     */
+    CompactNeighborList(double maxDistance, double padding, bool usePeriodic);
+    /**
+     * Make sure the list is valid for a set of positions, rebuilding it if necessary.
+     *
+     * @param atomLocations       the current atom positions
+     * @param periodicBoxVectors  the current periodic box vectors
+     * @return true if the list was rebuilt
+     */
+    bool update(const AtomLocationList& atomLocations, const Vec3* periodicBoxVectors);
+    /**
+     * Get the list of pairs that are within a distance of each other and not excluded.  Each pair
+     * is reported once, with the larger index first.  update() must have been called for the
+     * same positions first.
+     *
+     * @param pairs               on exit, contains the pairs.  Any previous contents are cleared.
+     * @param atomLocations       the current atom positions
+     * @param exclusions          the exclusions to omit
+     * @param periodicBoxVectors  the current periodic box vectors
+     * @param maxDistance         the cutoff distance.  This may not be larger than the one the list was created with.
+     */
+    void getPairs(NeighborList& pairs, const AtomLocationList& atomLocations, const std::vector<std::set<int> >& exclusions,
+                  const Vec3* periodicBoxVectors, double maxDistance) const;
+    /**
+     * Get the number of atoms in the list.
+     */
+    int getNumAtoms() const {
+        return (int) neighborStart.size()-1;
+    }
+    /**
+     * Get the number of neighbors of an atom.
+     */
+    int getNumNeighbors(int atom) const {
+        return neighborStart[atom+1]-neighborStart[atom];
+    }
+    /**
+     * Get the neighbors of an atom, sorted in ascending order.
+     */
+    const AtomIndex* getNeighbors(int atom) const {
+        return &neighbors[neighborStart[atom]];
+    }
+    /**
+     * Get the number of times the list has been built.
+     */
+    int getNumBuilds() const {
+        return numBuilds;
+    }
+private:
+    void build(const AtomLocationList& atomLocations, const Vec3* periodicBoxVectors);
+    double maxDistance, padding;
+    bool usePeriodic;
+    int numBuilds;
+    std::vector<int> neighborStart;
+    std::vector<AtomIndex> neighbors;
+    AtomLocationList buildLocations;
+    Vec3 buildBoxVectors[3];
+};
+
 } // namespace OpenMM
 
 #endif // OPENMM_REFERENCE_NEIGHBORLIST_H_
@@ -26,6 +26,7 @@
 #define __ReferenceObc_H__
 
 #include "ObcParameters.h"
+#include "openmm/internal/ThreadPool.h"
 
 namespace OpenMM {
 
@@ -46,6 +47,9 @@ class ReferenceObc {
 
       int _includeAceApproximation;
 
+      // threads to use for the pair loops, or NULL
+
+      ThreadPool* _threads;
 
    public:
 
@@ -109,6 +113,17 @@ class ReferenceObc {
 
       void setIncludeAceApproximation(int includeAceApproximation);
 
+      /**---------------------------------------------------------------------------------------
+      
+         Set the ThreadPool to use for computing the interactions.  If this is NULL (the
+         default), everything is computed on the calling thread.
+      
+         @param threads    the ThreadPool to use
+      
+         --------------------------------------------------------------------------------------- */
+
+      void setThreadPool(ThreadPool* threads);
+
       /**---------------------------------------------------------------------------------------
       
          Return OBC chain derivative: size = _implicitSolventParameters->getNumberOfAtoms()
@@ -38,6 +38,8 @@
 
 namespace OpenMM {
 
+class ThreadPool;
+
 typedef double rvec[3];
 
 
@@ -66,6 +68,16 @@ pme_init(pme_t* ppme,
          int pme_order,
          double epsilon_r);
 
+/*
+ * Set the ThreadPool to use for evaluating PME.  If this is NULL (the default),
+ * everything is computed on the calling thread.  Spreading the charges onto the
+ * grid is always done on the calling thread.  The results do not depend on the
+ * number of threads.
+ */
+int OPENMM_EXPORT
+pme_set_thread_pool(pme_t pme,
+                    ThreadPool* threads);
+
 /*
  * Evaluate reciprocal space PME energy and forces.
  *
@@ -0,0 +1,98 @@
+#ifndef OPENMM_REFERENCE_PARALLEL_LOOP_H_
+#define OPENMM_REFERENCE_PARALLEL_LOOP_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/Vec3.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/internal/windowsExport.h"
+#include <functional>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class runs the loops of the Reference platform's force calculations on a ThreadPool.
+ * The indices of a loop are divided into a fixed set of blocks, and block i is always processed
+ * by thread i%numThreads.  When forces and energies are accumulated, each thread adds its
+ * contributions to its own arrays, which are then summed in thread order.  The result therefore is
+ * identical every time it is computed, as long as the number of threads stays the same.
+ *
+ * Every method accepts NULL for the ThreadPool, in which case the whole loop is executed on the
+ * calling thread, adding directly to the output arrays.  This gives exactly the same result as a
+ * plain serial loop.
+ */
+
+class OPENMM_EXPORT ReferenceParallelLoop {
+public:
+    /**
+     * A function to process the loop indices [start, end).
+     */
+    typedef std::function<void (int threadIndex, int start, int end)> Body;
+    /**
+     * A function to process the loop indices [start, end), adding forces, energy, and energy
+     * derivatives to the arrays it is passed.  energy and derivs are NULL if the caller did
+     * not request them.
+     */
+    typedef std::function<void (int threadIndex, int start, int end, std::vector<Vec3>& forces, double* energy, double* derivs)> AccumulatingBody;
+    /**
+     * Get the number of threads a loop will be divided between.
+     *
+     * @param threads    the ThreadPool to use, or NULL
+     */
+    static int getNumThreads(ThreadPool* threads);
+    /**
+     * Execute a loop whose iterations are independent of each other.
+     *
+     * @param threads      the ThreadPool to use, or NULL to execute it on the calling thread
+     * @param numIndices   the number of loop indices
+     * @param body         the function to execute for each block of indices
+     */
+    static void execute(ThreadPool* threads, int numIndices, const Body& body);
+    /**
+     * Execute a loop that accumulates forces, energy, and (optionally) derivatives of the energy.
+     *
+     * @param threads      the ThreadPool to use, or NULL to execute it on the calling thread
+     * @param numIndices   the number of loop indices
+     * @param forces       the forces are added to this
+     * @param totalEnergy  the energy is added to this.  If NULL, energy is not accumulated.
+     * @param derivs       the derivatives are added to this.  If NULL, derivatives are not accumulated.
+     * @param numDerivs    the number of elements in derivs
+     * @param body         the function to execute for each block of indices
+     */
+    static void execute(ThreadPool* threads, int numIndices, std::vector<Vec3>& forces, double* totalEnergy,
+                        double* derivs, int numDerivs, const AccumulatingBody& body);
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_REFERENCE_PARALLEL_LOOP_H_
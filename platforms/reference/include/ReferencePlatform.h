@@ -34,8 +34,10 @@
 
 #include "openmm/Platform.h"
 #include "openmm/System.h"
+#include "openmm/internal/ThreadPool.h"
 #include "openmm/internal/windowsExport.h"
 #include "ReferenceConstraints.h"
+#include "ReferenceNeighborList.h"
 #include <map>
 #include <vector>
 
@@ -55,13 +57,22 @@ public:
     }
     double getSpeed() const;
     bool supportsDoublePrecision() const;
+    const std::string& getPropertyValue(const Context& context, const std::string& property) const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void contextDestroyed(ContextImpl& context) const;
+    /**
+     * This is the name of the parameter for selecting the number of threads to use.  The default
+     * is 1, which computes everything on the calling thread.
+     */
+    static const std::string& ReferenceThreads() {
+        static const std::string key = "Threads";
+        return key;
+    }
 };
 
 class OPENMM_EXPORT ReferencePlatform::PlatformData {
 public:
-    PlatformData(const System& system);
+    PlatformData(const System& system, int numThreads=1);
     ~PlatformData();
     int numParticles;
     long long stepCount;
@@ -73,6 +84,9 @@ public:
     Vec3* periodicBoxVectors;
     ReferenceConstraints* constraints;
     std::map<std::string, double>* energyParameterDerivatives;
+    ThreadPool* threads;
+    std::map<std::string, std::string> propertyValues;
+    std::map<std::pair<double, bool>, CompactNeighborList*> neighborLists;
 };
 } // namespace OpenMM
 
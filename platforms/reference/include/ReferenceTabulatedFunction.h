@@ -40,11 +40,19 @@
 
 namespace OpenMM {
 
+class ThreadPool;
+
 /**
  * Given a TabulatedFunction, wrap it in an appropriate subclass of Lepton::CustomFunction.
  */
 extern "C" OPENMM_EXPORT Lepton::CustomFunction* createReferenceTabulatedFunction(const TabulatedFunction& function);
 
+/**
+ * Given a TabulatedFunction, wrap it in an appropriate subclass of Lepton::CustomFunction.  Spline
+ * fitting is parallelized with the specified ThreadPool.
+ */
+OPENMM_EXPORT Lepton::CustomFunction* createReferenceTabulatedFunction(const TabulatedFunction& function, ThreadPool& threads);
+
 /**
  * This class adapts a Continuous1DFunction into a Lepton::CustomFunction.
  */
@@ -55,6 +63,7 @@ public:
     double evaluate(const double* arguments) const;
     double evaluateDerivative(const double* arguments, const int* derivOrder) const;
     CustomFunction* clone() const;
+    bool getSplineCoefficients(double& min, double& max, bool& periodic, std::vector<double>& coefficients) const;
 private:
     ReferenceContinuous1DFunction(const ReferenceContinuous1DFunction& other);
     const Continuous1DFunction& function;
@@ -88,7 +97,13 @@ private:
  */
 class OPENMM_EXPORT ReferenceContinuous3DFunction : public Lepton::CustomFunction {
 public:
-    ReferenceContinuous3DFunction(const Continuous3DFunction& function);
+    /**
+     * Create a ReferenceContinuous3DFunction.
+     *
+     * @param function   the function to wrap
+     * @param threads    the ThreadPool to use for fitting the spline.  If this is NULL, a new ThreadPool is created.
+     */
+    ReferenceContinuous3DFunction(const Continuous3DFunction& function, ThreadPool* threads=NULL);
     int getNumArguments() const;
     double evaluate(const double* arguments) const;
     double evaluateDerivative(const double* arguments, const int* derivOrder) const;
@@ -99,8 +114,7 @@ private:
     int xsize, ysize, zsize;
     double xmin, xmax, ymin, ymax, zmin, zmax;
     bool periodic;
-    std::vector<double> x, y, z, values;
-    std::vector<std::vector<double> > c;
+    std::vector<double> x, y, z, d;
 };
 
 /**
@@ -162,6 +176,7 @@ public:
     double evaluate(const double* arguments) const;
     double evaluateDerivative(const double* arguments, const int* derivOrder) const;
     CustomFunction* clone() const;
+    bool getSplineCoefficients(double& min, double& max, bool& periodic, std::vector<double>& coefficients) const;
 private:
     std::shared_ptr<const CustomFunction> pointer;
 };
@@ -40,6 +40,8 @@ namespace OpenMM {
 
 class OPENMM_EXPORT ReferenceVirtualSites {
 public:
+    virtual ~ReferenceVirtualSites() {
+    }
     /**
      * Compute the positions of all virtual sites.
      */
@@ -48,6 +50,32 @@ public:
      * Distribute forces from virtual sites to the atoms they are based on.
      */
     static void distributeForces(const OpenMM::System& system, const std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& forces);
+    /**
+     * Compute the positions of all virtual sites.  ReferenceDynamics calls this at the end of every step
+     * when an instance has been provided to it with setVirtualSites().  Platforms can override it with a
+     * faster implementation.  The default implementation calls computePositions().
+     */
+    virtual void computeSitePositions(const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates);
+    /**
+     * Compute the position of a LocalCoordinatesSite.
+     *
+     * @param numParticles     the number of particles the site is based on
+     * @param particles        the indices of the particles the site is based on
+     * @param originWeights    the weights for computing the origin
+     * @param xWeights         the weights for computing the x axis
+     * @param yWeights         the weights for computing the y axis
+     * @param localPosition    the position of the site in the local coordinate system
+     * @param atomCoordinates  the positions of all particles
+     */
+    static OpenMM::Vec3 computeLocalCoordinatesPosition(int numParticles, const int* particles, const double* originWeights, const double* xWeights,
+            const double* yWeights, OpenMM::Vec3 localPosition, const std::vector<OpenMM::Vec3>& atomCoordinates);
+    /**
+     * Distribute the force on a LocalCoordinatesSite to the particles it is based on.  The arguments are
+     * the same as for computeLocalCoordinatesPosition(), plus the force f on the site and the array
+     * of forces to add to.
+     */
+    static void distributeLocalCoordinatesForce(OpenMM::Vec3 f, int numParticles, const int* particles, const double* originWeights, const double* xWeights,
+            const double* yWeights, OpenMM::Vec3 localPosition, const std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& forces);
 };
 
 } // namespace OpenMM
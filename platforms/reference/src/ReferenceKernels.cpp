@@ -75,6 +75,7 @@
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/CustomCentroidBondForceImpl.h"
 #include "openmm/internal/CustomCompoundBondForceImpl.h"
+#include "openmm/internal/ExpressionCache.h"
 #include "openmm/internal/CustomHbondForceImpl.h"
 #include "openmm/internal/CMAPTorsionForceImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
@@ -127,6 +128,24 @@ static map<string, double>& extractEnergyParameterDerivatives(ContextImpl& conte
     return *data->energyParameterDerivatives;
 }
 
+static ThreadPool* extractThreadPool(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return data->threads;
+}
+
+/**
+ * Get the neighbor list for a cutoff distance, first updating it for the current positions if
+ * necessary.  All forces in a Context that use the same cutoff share a single list.
+ */
+static CompactNeighborList& extractNeighborList(ContextImpl& context, double cutoff, bool periodic) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    CompactNeighborList*& list = data->neighborLists[make_pair(cutoff, periodic)];
+    if (list == NULL)
+        list = new CompactNeighborList(cutoff, 0.1*cutoff, periodic);
+    list->update(*data->positions, data->periodicBoxVectors);
+    return *list;
+}
+
 /**
  * Make sure an expression doesn't use any undefined variables.
  */
@@ -180,6 +199,14 @@ double ReferenceCalcForcesAndEnergyKernel::finishComputation(ContextImpl& contex
     return 0.0;
 }
 
+void ReferenceCalcForcesAndEnergyKernel::synchronize(ContextImpl& context) {
+    // All calculations are done synchronously, so there is nothing to wait for.
+}
+
+void ReferenceCalcForcesAndEnergyKernel::getNeighborListStatistics(ContextImpl& context, map<string, double>& statistics) {
+    // Each Force builds its own neighbor list from scratch on every step, so there is nothing to report.
+}
+
 void ReferenceUpdateStateDataKernel::initialize(const System& system) {
     int numParticles = system.getNumParticles();
     masses.resize(numParticles);
@@ -211,6 +238,13 @@ void ReferenceUpdateStateDataKernel::getPositions(ContextImpl& context, std::vec
         positions[i] = Vec3(posData[i][0], posData[i][1], posData[i][2]);
 }
 
+void ReferenceUpdateStateDataKernel::getPositionSubset(ContextImpl& context, const vector<int>& particles, vector<Vec3>& positions) {
+    vector<Vec3>& posData = extractPositions(context);
+    positions.resize(particles.size());
+    for (int i = 0; i < particles.size(); ++i)
+        positions[i] = posData[particles[i]];
+}
+
 void ReferenceUpdateStateDataKernel::setPositions(ContextImpl& context, const std::vector<Vec3>& positions) {
     int numParticles = context.getSystem().getNumParticles();
     vector<Vec3>& posData = extractPositions(context);
@@ -229,6 +263,13 @@ void ReferenceUpdateStateDataKernel::getVelocities(ContextImpl& context, std::ve
         velocities[i] = Vec3(velData[i][0], velData[i][1], velData[i][2]);
 }
 
+void ReferenceUpdateStateDataKernel::getVelocitySubset(ContextImpl& context, const vector<int>& particles, vector<Vec3>& velocities) {
+    vector<Vec3>& velData = extractVelocities(context);
+    velocities.resize(particles.size());
+    for (int i = 0; i < particles.size(); ++i)
+        velocities[i] = velData[particles[i]];
+}
+
 void ReferenceUpdateStateDataKernel::setVelocities(ContextImpl& context, const std::vector<Vec3>& velocities) {
     int numParticles = context.getSystem().getNumParticles();
     vector<Vec3>& velData = extractVelocities(context);
@@ -432,9 +473,9 @@ void ReferenceCalcCustomBondForceKernel::initialize(const System& system, const
 
     // Parse the expression used to calculate the force.
 
-    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::ParsedExpression expression = ExpressionCache::getExpression(force.getEnergyFunction());
     energyExpression = expression.createCompiledExpression();
-    forceExpression = expression.differentiate("r").createCompiledExpression();
+    forceExpression = ExpressionCache::getDerivative(force.getEnergyFunction(), "r").createCompiledExpression();
     for (int i = 0; i < numParameters; i++)
         parameterNames.push_back(force.getPerBondParameterName(i));
     for (int i = 0; i < force.getNumGlobalParameters(); i++)
@@ -442,7 +483,7 @@ void ReferenceCalcCustomBondForceKernel::initialize(const System& system, const
     for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
         string param = force.getEnergyParameterDerivativeName(i);
         energyParamDerivNames.push_back(param);
-        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+        energyParamDerivExpressions.push_back(ExpressionCache::getDerivative(force.getEnergyFunction(), param).createCompiledExpression());
     }
     set<string> variables;
     variables.insert("r");
@@ -562,9 +603,9 @@ void ReferenceCalcCustomAngleForceKernel::initialize(const System& system, const
 
     // Parse the expression used to calculate the force.
 
-    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::ParsedExpression expression = ExpressionCache::getExpression(force.getEnergyFunction());
     energyExpression = expression.createCompiledExpression();
-    forceExpression = expression.differentiate("theta").createCompiledExpression();
+    forceExpression = ExpressionCache::getDerivative(force.getEnergyFunction(), "theta").createCompiledExpression();
     for (int i = 0; i < numParameters; i++)
         parameterNames.push_back(force.getPerAngleParameterName(i));
     for (int i = 0; i < force.getNumGlobalParameters(); i++)
@@ -572,7 +613,7 @@ void ReferenceCalcCustomAngleForceKernel::initialize(const System& system, const
     for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
         string param = force.getEnergyParameterDerivativeName(i);
         energyParamDerivNames.push_back(param);
-        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+        energyParamDerivExpressions.push_back(ExpressionCache::getDerivative(force.getEnergyFunction(), param).createCompiledExpression());
     }
     set<string> variables;
     variables.insert("theta");
@@ -823,9 +864,9 @@ void ReferenceCalcCustomTorsionForceKernel::initialize(const System& system, con
 
     // Parse the expression used to calculate the force.
 
-    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::ParsedExpression expression = ExpressionCache::getExpression(force.getEnergyFunction());
     energyExpression = expression.createCompiledExpression();
-    forceExpression = expression.differentiate("theta").createCompiledExpression();
+    forceExpression = ExpressionCache::getDerivative(force.getEnergyFunction(), "theta").createCompiledExpression();
     for (int i = 0; i < numParameters; i++)
         parameterNames.push_back(force.getPerTorsionParameterName(i));
     for (int i = 0; i < force.getNumGlobalParameters(); i++)
@@ -833,7 +874,7 @@ void ReferenceCalcCustomTorsionForceKernel::initialize(const System& system, con
     for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
         string param = force.getEnergyParameterDerivativeName(i);
         energyParamDerivNames.push_back(param);
-        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+        energyParamDerivExpressions.push_back(ExpressionCache::getDerivative(force.getEnergyFunction(), param).createCompiledExpression());
     }
     set<string> variables;
     variables.insert("theta");
@@ -954,6 +995,7 @@ void ReferenceCalcNonbondedForceKernel::initialize(const System& system, const N
         useSwitchingFunction = force.getUseSwitchingFunction();
         switchingDistance = force.getSwitchingDistance();
     }
+    pmeOrder = force.getPMEOrder();
     if (nonbondedMethod == Ewald) {
         double alpha;
         NonbondedForceImpl::calcEwaldParameters(system, force, alpha, kmax[0], kmax[1], kmax[2]);
@@ -989,12 +1031,13 @@ double ReferenceCalcNonbondedForceKernel::execute(ContextImpl& context, bool inc
     vector<Vec3>& forceData = extractForces(context);
     double energy = 0;
     ReferenceLJCoulombIxn clj;
+    clj.setThreadPool(extractThreadPool(context));
     bool periodic = (nonbondedMethod == CutoffPeriodic);
     bool ewald  = (nonbondedMethod == Ewald);
     bool pme  = (nonbondedMethod == PME);
     bool ljpme = (nonbondedMethod == LJPME);
     if (nonbondedMethod != NoCutoff) {
-        computeNeighborListVoxelHash(*neighborList, numParticles, posData, exclusions, extractBoxVectors(context), periodic || ewald || pme || ljpme, nonbondedCutoff, 0.0);
+        extractNeighborList(context, nonbondedCutoff, periodic || ewald || pme || ljpme).getPairs(*neighborList, posData, exclusions, extractBoxVectors(context), nonbondedCutoff);
         clj.setUseCutoff(nonbondedCutoff, *neighborList, rfDielectric);
     }
     if (periodic || ewald || pme || ljpme) {
@@ -1008,10 +1051,10 @@ double ReferenceCalcNonbondedForceKernel::execute(ContextImpl& context, bool inc
     if (ewald)
         clj.setUseEwald(ewaldAlpha, kmax[0], kmax[1], kmax[2]);
     if (pme)
-        clj.setUsePME(ewaldAlpha, gridSize);
+        clj.setUsePME(ewaldAlpha, gridSize, pmeOrder);
     if (ljpme){
-        clj.setUsePME(ewaldAlpha, gridSize);
-        clj.setUseLJPME(ewaldDispersionAlpha, dispersionGridSize);
+        clj.setUsePME(ewaldAlpha, gridSize, pmeOrder);
+        clj.setUseLJPME(ewaldDispersionAlpha, dispersionGridSize, pmeOrder);
     }
     if (useSwitchingFunction)
         clj.setUseSwitchingFunction(switchingDistance);
@@ -1271,9 +1314,10 @@ double ReferenceCalcCustomNonbondedForceKernel::execute(ContextImpl& context, bo
     Vec3* boxVectors = extractBoxVectors(context);
     double energy = 0;
     ReferenceCustomNonbondedIxn ixn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions, computedValueNames, computedValueExpressions);
+    ixn.setThreadPool(extractThreadPool(context));
     bool periodic = (nonbondedMethod == CutoffPeriodic);
     if (nonbondedMethod != NoCutoff) {
-        computeNeighborListVoxelHash(*neighborList, numParticles, posData, exclusions, extractBoxVectors(context), periodic, nonbondedCutoff, 0.0);
+        extractNeighborList(context, nonbondedCutoff, periodic).getPairs(*neighborList, posData, exclusions, extractBoxVectors(context), nonbondedCutoff);
         ixn.setUseCutoff(nonbondedCutoff, *neighborList);
     }
     if (periodic) {
@@ -1394,6 +1438,7 @@ double ReferenceCalcGBSAOBCForceKernel::execute(ContextImpl& context, bool inclu
     vector<Vec3>& forceData = extractForces(context);
     if (isPeriodic)
         obc->getObcParameters()->setPeriodic(extractBoxVectors(context));
+    obc->setThreadPool(extractThreadPool(context));
     return obc->computeBornEnergyForces(posData, charges, forceData);
 }
 
@@ -1589,7 +1634,7 @@ double ReferenceCalcCustomGBForceKernel::execute(ContextImpl& context, bool incl
         ixn.setPeriodic(extractBoxVectors(context));
     if (nonbondedMethod != NoCutoff) {
         vector<set<int> > empty(context.getSystem().getNumParticles()); // Don't omit exclusions from the neighbor list
-        computeNeighborListVoxelHash(*neighborList, numParticles, posData, empty, extractBoxVectors(context), periodic, nonbondedCutoff, 0.0);
+        extractNeighborList(context, nonbondedCutoff, periodic).getPairs(*neighborList, posData, empty, extractBoxVectors(context), nonbondedCutoff);
         ixn.setUseCutoff(nonbondedCutoff, *neighborList);
     }
     map<string, double> globalParameters;
@@ -2132,6 +2177,8 @@ double ReferenceCalcCustomManyParticleForceKernel::execute(ContextImpl& context,
             throw OpenMMException("The periodic box size has decreased to less than twice the nonbonded cutoff.");
         ixn->setPeriodic(boxVectors);
     }
+    if (nonbondedMethod != NoCutoff)
+        ixn->setNeighborList(extractNeighborList(context, cutoffDistance, nonbondedMethod == CutoffPeriodic));
     ixn->calculateIxn(posData, particleParamArray, globalParameters, forceData, includeEnergy ? &energy : NULL);
     return energy;
 }
@@ -2210,7 +2257,7 @@ double ReferenceCalcCustomCVForceKernel::execute(ContextImpl& context, ContextIm
     for (auto& name : globalParameterNames)
         globalParameters[name] = context.getParameter(name);
     map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
-    ixn->calculateIxn(innerContext, posData, globalParameters, forceData, includeEnergy ? &energy : NULL, energyParamDerivs);
+    ixn->calculateIxn(innerContext, posData, globalParameters, includeForces, forceData, includeEnergy ? &energy : NULL, energyParamDerivs);
     return energy;
 }
 
@@ -2267,6 +2314,34 @@ void ReferenceCalcRMSDForceKernel::copyParametersToContext(ContextImpl& context,
         p -= center;
 }
 
+void ReferenceCalcExternalForceKernel::initialize(const System& system, const ExternalForce& force) {
+    computation = &force.getComputation();
+    forces.resize(system.getNumParticles());
+}
+
+double ReferenceCalcExternalForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    for (Vec3& f : forces)
+        f = Vec3();
+    ExternalForce::ComputeData data;
+    data.numParticles = forces.size();
+    data.isDeviceMemory = false;
+    data.isDoublePrecision = true;
+    data.stride = 3;
+    data.positions = &posData[0][0];
+    data.forces = &forces[0][0];
+    data.atomIndex = NULL;
+    context.getPeriodicBoxVectors(data.periodicBoxVectors[0], data.periodicBoxVectors[1], data.periodicBoxVectors[2]);
+    data.includeForces = includeForces;
+    data.includeEnergy = includeEnergy;
+    double energy = computation->compute(data);
+    if (includeForces)
+        for (int i = 0; i < forces.size(); i++)
+            forceData[i] += forces[i];
+    return (includeEnergy ? energy : 0.0);
+}
+
 ReferenceIntegrateVerletStepKernel::~ReferenceIntegrateVerletStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -2651,6 +2726,71 @@ double ReferenceIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextI
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
 
+void ReferenceIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    inverseMasses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i) {
+        masses[i] = system.getParticleMass(i);
+        inverseMasses[i] = (masses[i] == 0.0 ? 0.0 : 1.0/masses[i]);
+    }
+    xPrime.resize(numParticles);
+    oldx.resize(numParticles);
+    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::updateVelocities(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) {
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    for (int i = 0; i < masses.size(); i++)
+        if (inverseMasses[i] != 0.0)
+            velData[i] += (dt*inverseMasses[i])*forceData[i];
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::updatePositions(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    ReferenceConstraints& constraints = extractConstraints(context);
+    const double halfdt = 0.5*dt;
+    const double kT = BOLTZ*integrator.getTemperature();
+    const double vscale = exp(-dt*integrator.getFriction());
+    const double noisescale = sqrt(1-vscale*vscale);
+    for (int i = 0; i < masses.size(); i++) {
+        if (inverseMasses[i] != 0.0) {
+            xPrime[i] = posData[i] + velData[i]*halfdt;
+            velData[i] = vscale*velData[i] + noisescale*sqrt(kT*inverseMasses[i])*Vec3(
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber(),
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber(),
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
+            xPrime[i] = xPrime[i] + velData[i]*halfdt;
+            oldx[i] = xPrime[i];
+        }
+        else
+            xPrime[i] = posData[i];
+    }
+    constraints.apply(posData, xPrime, inverseMasses, integrator.getConstraintTolerance());
+    for (int i = 0; i < masses.size(); i++) {
+        if (inverseMasses[i] != 0.0) {
+            velData[i] += (xPrime[i]-oldx[i])/dt;
+            posData[i] = xPrime[i];
+        }
+    }
+    constraints.applyToVelocities(posData, velData, inverseMasses, integrator.getConstraintTolerance());
+    ReferenceVirtualSites::computePositions(context.getSystem(), posData);
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    extractConstraints(context).applyToVelocities(posData, velData, inverseMasses, integrator.getConstraintTolerance());
+    data.time += integrator.getStepSize();
+    data.stepCount++;
+}
+
+double ReferenceIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.0);
+}
+
 ReferenceIntegrateBrownianStepKernel::~ReferenceIntegrateBrownianStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -2708,7 +2848,7 @@ void ReferenceIntegrateVariableLangevinStepKernel::initialize(const System& syst
     SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
 }
 
-double ReferenceIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) {
+double ReferenceIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime, int maxSteps) {
     double temperature = integrator.getTemperature();
     double friction = integrator.getFriction();
     double errorTol = integrator.getErrorTolerance();
@@ -2726,15 +2866,22 @@ double ReferenceIntegrateVariableLangevinStepKernel::execute(ContextImpl& contex
         prevFriction = friction;
         prevErrorTol = errorTol;
     }
-    double maxStepSize = maxTime-data.time;
-    if (integrator.getMaximumStepSize() > 0)
-        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
-    dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
-    data.time += dynamics->getDeltaT();
-    if (dynamics->getDeltaT() == maxStepSize)
-        data.time = maxTime; // Avoid round-off error
-    data.stepCount++;
-    return dynamics->getDeltaT();
+    double dt = integrator.getStepSize();
+    for (int i = 0; i < maxSteps && maxTime > data.time; i++) {
+        context.updateContextState();
+        context.calcForcesAndEnergy(true, false, integrator.getIntegrationForceGroups());
+        double remainingTime = maxTime-data.time;
+        double maxStepSize = remainingTime;
+        if (integrator.getMaximumStepSize() > 0)
+            maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
+        dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
+        dt = dynamics->getDeltaT();
+        data.time += dt;
+        if (dt == remainingTime)
+            data.time = maxTime; // Avoid round-off error
+        data.stepCount++;
+    }
+    return dt;
 }
 
 double ReferenceIntegrateVariableLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const VariableLangevinIntegrator& integrator) {
@@ -2753,7 +2900,7 @@ void ReferenceIntegrateVariableVerletStepKernel::initialize(const System& system
         masses[i] = system.getParticleMass(i);
 }
 
-double ReferenceIntegrateVariableVerletStepKernel::execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime) {
+double ReferenceIntegrateVariableVerletStepKernel::execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime, int maxSteps) {
     double errorTol = integrator.getErrorTolerance();
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& velData = extractVelocities(context);
@@ -2767,15 +2914,22 @@ double ReferenceIntegrateVariableVerletStepKernel::execute(ContextImpl& context,
         dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
         prevErrorTol = errorTol;
     }
-    double maxStepSize = maxTime-data.time;
-    if (integrator.getMaximumStepSize() > 0)
-        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
-    dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
-    data.time += dynamics->getDeltaT();
-    if (dynamics->getDeltaT() == maxStepSize)
-        data.time = maxTime; // Avoid round-off error
-    data.stepCount++;
-    return dynamics->getDeltaT();
+    double dt = integrator.getStepSize();
+    for (int i = 0; i < maxSteps && maxTime > data.time; i++) {
+        context.updateContextState();
+        context.calcForcesAndEnergy(true, false, integrator.getIntegrationForceGroups());
+        double remainingTime = maxTime-data.time;
+        double maxStepSize = remainingTime;
+        if (integrator.getMaximumStepSize() > 0)
+            maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
+        dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
+        dt = dynamics->getDeltaT();
+        data.time += dt;
+        if (dt == remainingTime)
+            data.time = maxTime; // Avoid round-off error
+        data.stepCount++;
+    }
+    return dt;
 }
 
 double ReferenceIntegrateVariableVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VariableVerletIntegrator& integrator) {
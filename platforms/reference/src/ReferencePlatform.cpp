@@ -33,8 +33,10 @@
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/OpenMMException.h"
 #include "SimTKOpenMMRealType.h"
 #include "openmm/Vec3.h"
+#include <sstream>
 
 using namespace OpenMM;
 using namespace std;
@@ -63,12 +65,14 @@ ReferencePlatform::ReferencePlatform() {
     registerKernelFactory(CalcCustomCompoundBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomCVForceKernel::Name(), factory);
     registerKernelFactory(CalcRMSDForceKernel::Name(), factory);
+    registerKernelFactory(CalcExternalForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
@@ -76,6 +80,8 @@ ReferencePlatform::ReferencePlatform() {
     registerKernelFactory(ApplyAndersenThermostatKernel::Name(), factory);
     registerKernelFactory(ApplyMonteCarloBarostatKernel::Name(), factory);
     registerKernelFactory(RemoveCMMotionKernel::Name(), factory);
+    platformProperties.push_back(ReferenceThreads());
+    setPropertyDefaultValue(ReferenceThreads(), "1");
 }
 
 double ReferencePlatform::getSpeed() const {
@@ -86,8 +92,27 @@ bool ReferencePlatform::supportsDoublePrecision() const {
     return true;
 }
 
+const string& ReferencePlatform::getPropertyValue(const Context& context, const string& property) const {
+    const ContextImpl& impl = getContextImpl(context);
+    const PlatformData* data = reinterpret_cast<const PlatformData*>(impl.getPlatformData());
+    map<string, string>::const_iterator value = data->propertyValues.find(property);
+    if (value != data->propertyValues.end())
+        return value->second;
+    return Platform::getPropertyValue(context, property);
+}
+
 void ReferencePlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
-    context.setPlatformData(new PlatformData(context.getSystem()));
+    const string& threadsPropValue = (properties.find(ReferenceThreads()) == properties.end() ?
+            getPropertyDefaultValue(ReferenceThreads()) : properties.find(ReferenceThreads())->second);
+    int numThreads = 0;
+    stringstream(threadsPropValue) >> numThreads;
+    if (numThreads < 1)
+        throw OpenMMException("Threads must be at least 1");
+    PlatformData* data = new PlatformData(context.getSystem(), numThreads);
+    stringstream threadsProperty;
+    threadsProperty << numThreads;
+    data->propertyValues[ReferenceThreads()] = threadsProperty.str();
+    context.setPlatformData(data);
 }
 
 void ReferencePlatform::contextDestroyed(ContextImpl& context) const {
@@ -95,7 +120,8 @@ void ReferencePlatform::contextDestroyed(ContextImpl& context) const {
     delete data;
 }
 
-ReferencePlatform::PlatformData::PlatformData(const System& system) : time(0.0), stepCount(0), numParticles(system.getNumParticles()) {
+ReferencePlatform::PlatformData::PlatformData(const System& system, int numThreads) : time(0.0), stepCount(0), numParticles(system.getNumParticles()),
+        threads(NULL) {
     positions = new vector<Vec3>(numParticles);
     velocities = new vector<Vec3>(numParticles);
     forces = new vector<Vec3>(numParticles);
@@ -103,6 +129,8 @@ ReferencePlatform::PlatformData::PlatformData(const System& system) : time(0.0),
     periodicBoxVectors = new Vec3[3];
     constraints = new ReferenceConstraints(system);
     energyParameterDerivatives = new map<string, double>();
+    if (numThreads > 1)
+        threads = new ThreadPool(numThreads);
 }
 
 ReferencePlatform::PlatformData::~PlatformData() {
@@ -113,4 +141,7 @@ ReferencePlatform::PlatformData::~PlatformData() {
     delete[] periodicBoxVectors;
     delete constraints;
     delete energyParameterDerivatives;
+    delete threads;
+    for (auto& list : neighborLists)
+        delete list.second;
 }
@@ -62,14 +62,14 @@ using namespace OpenMM;
 using namespace std;
 using Lepton::CustomFunction;
 
-extern "C" OPENMM_EXPORT CustomFunction* createReferenceTabulatedFunction(const TabulatedFunction& function) {
+static CustomFunction* createTabulatedFunction(const TabulatedFunction& function, ThreadPool* threads) {
     CustomFunction* fn;
     if (dynamic_cast<const Continuous1DFunction*>(&function) != NULL)
         fn = new ReferenceContinuous1DFunction(dynamic_cast<const Continuous1DFunction&>(function));
     else if (dynamic_cast<const Continuous2DFunction*>(&function) != NULL)
         fn = new ReferenceContinuous2DFunction(dynamic_cast<const Continuous2DFunction&>(function));
     else if (dynamic_cast<const Continuous3DFunction*>(&function) != NULL)
-        fn = new ReferenceContinuous3DFunction(dynamic_cast<const Continuous3DFunction&>(function));
+        fn = new ReferenceContinuous3DFunction(dynamic_cast<const Continuous3DFunction&>(function), threads);
     else if (dynamic_cast<const Discrete1DFunction*>(&function) != NULL)
         fn = new ReferenceDiscrete1DFunction(dynamic_cast<const Discrete1DFunction&>(function));
     else if (dynamic_cast<const Discrete2DFunction*>(&function) != NULL)
@@ -81,6 +81,14 @@ extern "C" OPENMM_EXPORT CustomFunction* createReferenceTabulatedFunction(const
     return new SharedFunctionWrapper(shared_ptr<const CustomFunction>(fn));
 }
 
+extern "C" OPENMM_EXPORT CustomFunction* createReferenceTabulatedFunction(const TabulatedFunction& function) {
+    return createTabulatedFunction(function, NULL);
+}
+
+CustomFunction* OpenMM::createReferenceTabulatedFunction(const TabulatedFunction& function, ThreadPool& threads) {
+    return createTabulatedFunction(function, &threads);
+}
+
 ReferenceContinuous1DFunction::ReferenceContinuous1DFunction(const Continuous1DFunction& function) : function(function) {
     periodic = function.getPeriodic();
     function.getFunctionParameters(values, min, max);
@@ -121,6 +129,25 @@ CustomFunction* ReferenceContinuous1DFunction::clone() const {
     return new ReferenceContinuous1DFunction(*this);
 }
 
+bool ReferenceContinuous1DFunction::getSplineCoefficients(double& min, double& max, bool& periodic, vector<double>& coefficients) const {
+    // Convert the form used by SplineFitter::evaluateSpline() to a polynomial in the position within each interval.
+
+    min = this->min;
+    max = this->max;
+    periodic = this->periodic;
+    int numIntervals = x.size()-1;
+    double dx = (max-min)/numIntervals;
+    double scale = dx*dx/6.0;
+    coefficients.resize(4*numIntervals);
+    for (int i = 0; i < numIntervals; i++) {
+        coefficients[4*i] = values[i];
+        coefficients[4*i+1] = values[i+1]-values[i]-scale*(2*derivs[i]+derivs[i+1]);
+        coefficients[4*i+2] = 3*scale*derivs[i];
+        coefficients[4*i+3] = scale*(derivs[i+1]-derivs[i]);
+    }
+    return true;
+}
+
 ReferenceContinuous2DFunction::ReferenceContinuous2DFunction(const Continuous2DFunction& function) : function(function) {
     periodic = function.getPeriodic();
     function.getFunctionParameters(xsize, ysize, values, xmin, xmax, ymin, ymax);
@@ -176,8 +203,9 @@ CustomFunction* ReferenceContinuous2DFunction::clone() const {
     return new ReferenceContinuous2DFunction(*this);
 }
 
-ReferenceContinuous3DFunction::ReferenceContinuous3DFunction(const Continuous3DFunction& function) : function(function) {
+ReferenceContinuous3DFunction::ReferenceContinuous3DFunction(const Continuous3DFunction& function, ThreadPool* threads) : function(function) {
     periodic = function.getPeriodic();
+    vector<double> values;
     function.getFunctionParameters(xsize, ysize, zsize, values, xmin, xmax, ymin, ymax, zmin, zmax);
     x.resize(xsize);
     y.resize(ysize);
@@ -188,17 +216,24 @@ ReferenceContinuous3DFunction::ReferenceContinuous3DFunction(const Continuous3DF
         y[i] = ymin+i*(ymax-ymin)/(ysize-1);
     for (int i = 0; i < zsize; i++)
         z[i] = zmin+i*(zmax-zmin)/(zsize-1);
-    SplineFitter::create3DSpline(x, y, z, values, periodic, c);
+    SplineFitter::create3DHermiteSpline(x, y, z, values, periodic, d, threads);
 }
 
 ReferenceContinuous3DFunction::ReferenceContinuous3DFunction(const ReferenceContinuous3DFunction& other) : function(other.function) {
-    periodic = function.getPeriodic();
-    function.getFunctionParameters(xsize, ysize, zsize, values, xmin, xmax, ymin, ymax, zmin, zmax);
+    periodic = other.periodic;
+    xsize = other.xsize;
+    ysize = other.ysize;
+    zsize = other.zsize;
+    xmin = other.xmin;
+    xmax = other.xmax;
+    ymin = other.ymin;
+    ymax = other.ymax;
+    zmin = other.zmin;
+    zmax = other.zmax;
     x = other.x;
     y = other.y;
     z = other.z;
-    values = other.values;
-    c = other.c;
+    d = other.d;
 }
 
 int ReferenceContinuous3DFunction::getNumArguments() const {
@@ -215,7 +250,7 @@ double ReferenceContinuous3DFunction::evaluate(const double* arguments) const {
     double w = periodic ? wrap(arguments[2], zmin, zmax) : arguments[2];
     if (w < zmin || w > zmax)
         return 0.0;
-    return SplineFitter::evaluate3DSpline(x, y, z, values, c, u, v, w);
+    return SplineFitter::evaluate3DHermiteSpline(x, y, z, d, u, v, w);
 }
 
 double ReferenceContinuous3DFunction::evaluateDerivative(const double* arguments, const int* derivOrder) const {
@@ -229,7 +264,7 @@ double ReferenceContinuous3DFunction::evaluateDerivative(const double* arguments
     if (w < zmin || w > zmax)
         return 0.0;
     double dx, dy, dz;
-    SplineFitter::evaluate3DSplineDerivatives(x, y, z, values, c, u, v, w, dx, dy, dz);
+    SplineFitter::evaluate3DHermiteSplineDerivatives(x, y, z, d, u, v, w, dx, dy, dz);
     if (derivOrder[0] == 1 && derivOrder[1] == 0 && derivOrder[2] == 0)
         return dx;
     if (derivOrder[0] == 0 && derivOrder[1] == 1 && derivOrder[2] == 0)
@@ -333,3 +368,7 @@ double SharedFunctionWrapper::evaluateDerivative(const double* arguments, const
 CustomFunction* SharedFunctionWrapper::clone() const {
     return new SharedFunctionWrapper(pointer);
 }
+
+bool SharedFunctionWrapper::getSplineCoefficients(double& min, double& max, bool& periodic, vector<double>& coefficients) const {
+    return pointer->getSplineCoefficients(min, max, periodic, coefficients);
+}
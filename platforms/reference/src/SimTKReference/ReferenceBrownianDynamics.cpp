@@ -81,6 +81,54 @@ double ReferenceBrownianDynamics::getFriction() const {
    return friction;
 }
 
+/**---------------------------------------------------------------------------------------
+
+   First update: compute the unconstrained positions
+
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param forces              forces
+   @param inverseMasses       inverse atom masses
+   @param xPrime              xPrime
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceBrownianDynamics::updatePart1(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& forces,
+                                            vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+   const double noiseAmplitude = sqrt(2.0*BOLTZ*getTemperature()*getDeltaT()/getFriction());
+   const double forceScale = getDeltaT()/getFriction();
+   for (int i = 0; i < numberOfAtoms; ++i) {
+       if (inverseMasses[i] != 0.0)
+           for (int j = 0; j < 3; ++j) {
+               xPrime[i][j] = atomCoordinates[i][j] + forceScale*inverseMasses[i]*forces[i][j] + noiseAmplitude*sqrt(inverseMasses[i])*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+           }
+   }
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Second update: compute velocities from the constrained positions and store the positions
+
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param velocities          velocities
+   @param inverseMasses       inverse atom masses
+   @param xPrime              xPrime
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceBrownianDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                            vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+   double velocityScale = 1.0/getDeltaT();
+   for (int i = 0; i < numberOfAtoms; ++i) {
+       if (inverseMasses[i] != 0.0)
+           for (int j = 0; j < 3; ++j) {
+               velocities[i][j] = velocityScale*(xPrime[i][j] - atomCoordinates[i][j]);
+               atomCoordinates[i][j] = xPrime[i][j];
+           }
+   }
+}
+
 /**---------------------------------------------------------------------------------------
 
    Update -- driver routine for performing Brownian dynamics update of coordinates
@@ -114,28 +162,14 @@ void ReferenceBrownianDynamics::update(const OpenMM::System& system, vector<Vec3
    
    // Perform the integration.
    
-   const double noiseAmplitude = sqrt(2.0*BOLTZ*getTemperature()*getDeltaT()/getFriction());
-   const double forceScale = getDeltaT()/getFriction();
-   for (int i = 0; i < numberOfAtoms; ++i) {
-       if (masses[i] != 0.0)
-           for (int j = 0; j < 3; ++j) {
-               xPrime[i][j] = atomCoordinates[i][j] + forceScale*inverseMasses[i]*forces[i][j] + noiseAmplitude*sqrt(inverseMasses[i])*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-           }
-   }
+   updatePart1(numberOfAtoms, atomCoordinates, forces, inverseMasses, xPrime);
    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
    if (referenceConstraintAlgorithm)
       referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
    
    // Update the positions and velocities.
    
-   double velocityScale = 1.0/getDeltaT();
-   for (int i = 0; i < numberOfAtoms; ++i) {
-       if (masses[i] != 0.0)
-           for (int j = 0; j < 3; ++j) {
-               velocities[i][j] = velocityScale*(xPrime[i][j] - atomCoordinates[i][j]);
-               atomCoordinates[i][j] = xPrime[i][j];
-           }
-   }
-   ReferenceVirtualSites::computePositions(system, atomCoordinates);
+   updatePart2(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+   computeVirtualSites(system, atomCoordinates);
    incrementTimeStep();
 }
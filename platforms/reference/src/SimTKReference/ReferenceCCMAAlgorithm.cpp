@@ -32,13 +32,77 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/Vec3.h"
 #include "openmm/internal/ThreadPool.h"
+#include <algorithm>
+#include <iterator>
+#include <list>
 #include <map>
-#include <set>
+#include <mutex>
+#include <string>
 #include <utility>
 
 using namespace OpenMM;
 using namespace std;
 
+static const int MaxCachedMatrices = 4;
+static mutex matrixCacheLock;
+static map<string, vector<vector<pair<int, double> > > > matrixCache;
+static list<string> matrixCacheOrder;
+
+template <class T>
+static void appendToKey(string& key, const T& value) {
+    key.append((const char*) &value, sizeof(T));
+}
+
+string ReferenceCCMAAlgorithm::createMatrixKey(int numberOfAtoms, const vector<double>& masses, const vector<AngleInfo>& angles) const {
+    // The matrix depends on the constraints, the masses of the constrained atoms, and the angles.  The key
+    // records all of them exactly, so a cached matrix is only used when it would be bitwise identical.
+
+    string key;
+    appendToKey(key, numberOfAtoms);
+    appendToKey(key, _numberOfConstraints);
+    appendToKey(key, _elementCutoff);
+    for (int i = 0; i < _numberOfConstraints; i++) {
+        appendToKey(key, _atomIndices[i].first);
+        appendToKey(key, _atomIndices[i].second);
+        appendToKey(key, _distance[i]);
+        appendToKey(key, masses[_atomIndices[i].first]);
+        appendToKey(key, masses[_atomIndices[i].second]);
+    }
+    for (const AngleInfo& angle : angles) {
+        appendToKey(key, angle.atom1);
+        appendToKey(key, angle.atom2);
+        appendToKey(key, angle.atom3);
+        appendToKey(key, angle.angle);
+    }
+    return key;
+}
+
+bool ReferenceCCMAAlgorithm::findCachedMatrix(const string& key, vector<vector<pair<int, double> > >& matrix) {
+    lock_guard<mutex> lock(matrixCacheLock);
+    auto cached = matrixCache.find(key);
+    if (cached == matrixCache.end())
+        return false;
+    matrix = cached->second;
+    return true;
+}
+
+void ReferenceCCMAAlgorithm::cacheMatrix(const string& key, const vector<vector<pair<int, double> > >& matrix) {
+    lock_guard<mutex> lock(matrixCacheLock);
+    if (!matrixCache.insert(make_pair(key, matrix)).second)
+        return;
+    matrixCacheOrder.push_back(key);
+    if (matrixCacheOrder.size() > MaxCachedMatrices) {
+        matrixCache.erase(matrixCacheOrder.front());
+        matrixCacheOrder.pop_front();
+    }
+}
+
+void ReferenceCCMAAlgorithm::clearMatrixCache() {
+    lock_guard<mutex> lock(matrixCacheLock);
+    matrixCache.clear();
+    matrixCacheOrder.clear();
+}
+
 ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm(int numberOfAtoms,
                                                int numberOfConstraints,
                                                const vector<pair<int, int> >& atomIndices,
@@ -62,26 +126,49 @@ ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm(int numberOfAtoms,
         _distanceTolerance = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(numberOfConstraints, NULL, 1, 0.0, "distanceTolerance");
         _reducedMasses = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(numberOfConstraints, NULL, 1, 0.0, "reducedMasses");
     }
-    if (numberOfConstraints > 0)
-    {
-        // Compute the constraint coupling matrix
-
-        vector<vector<int> > atomAngles(numberOfAtoms);
-        for (int i = 0; i < (int) angles.size(); i++)
-            atomAngles[angles[i].atom2].push_back(i);
-        vector<vector<pair<int, double> > > matrix(numberOfConstraints);
-        vector<set<int> > atomConstraints(numberOfAtoms);
-        for (int j = 0; j < numberOfConstraints; j++) {
-            atomConstraints[_atomIndices[j].first].insert(j);
-            atomConstraints[_atomIndices[j].second].insert(j);
+    if (numberOfConstraints > 0) {
+        // Inverting the matrix is expensive, so reuse the result if an identical set of constraints
+        // has been seen before.
+
+        string key = createMatrixKey(numberOfAtoms, masses, angles);
+        if (!findCachedMatrix(key, _matrix)) {
+            computeMatrix(numberOfAtoms, masses, angles);
+            cacheMatrix(key, _matrix);
         }
-        for (int j = 0; j < numberOfConstraints; j++) {
+    }
+}
+
+void ReferenceCCMAAlgorithm::computeMatrix(int numberOfAtoms, vector<double>& masses, vector<AngleInfo>& angles) {
+    int numberOfConstraints = _numberOfConstraints;
+    double elementCutoff = _elementCutoff;
+    const vector<double>& distance = _distance;
+    // Compute the constraint coupling matrix
+
+    vector<vector<int> > atomAngles(numberOfAtoms);
+    for (int i = 0; i < (int) angles.size(); i++)
+        atomAngles[angles[i].atom2].push_back(i);
+    vector<vector<pair<int, double> > > matrix(numberOfConstraints);
+    vector<vector<int> > atomConstraints(numberOfAtoms);
+    for (int j = 0; j < numberOfConstraints; j++) {
+        atomConstraints[_atomIndices[j].first].push_back(j);
+        atomConstraints[_atomIndices[j].second].push_back(j);
+    }
+
+    // Each row of the matrix depends only on the constraints sharing an atom with that row's constraint,
+    // so the rows are built in parallel.
+
+    ThreadPool threads;
+    threads.execute([&] (ThreadPool& pool, int threadIndex) {
+        vector<int> constraints;
+        for (int j = threadIndex; j < numberOfConstraints; j += pool.getNumThreads()) {
             int atomj0 = _atomIndices[j].first;
             int atomj1 = _atomIndices[j].second;
             double invMass0 = 1/masses[atomj0];
             double invMass1 = 1/masses[atomj1];
-            set<int> constraints = atomConstraints[atomj0];
-            constraints.insert(atomConstraints[atomj1].begin(), atomConstraints[atomj1].end());
+            const vector<int>& constraints0 = atomConstraints[atomj0];
+            const vector<int>& constraints1 = atomConstraints[atomj1];
+            constraints.clear();
+            set_union(constraints0.begin(), constraints0.end(), constraints1.begin(), constraints1.end(), back_inserter(constraints));
             for (int k : constraints) {
                 if (j == k) {
                     matrix[j].push_back(pair<int, double>(j, 1.0));
@@ -145,60 +232,60 @@ ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm(int numberOfAtoms,
                 }
             }
         }
+    });
+    threads.waitForThreads();
 
-        // Invert it using QR.
+    // Invert it using QR.
 
-        vector<int> matrixRowStart;
-        vector<int> matrixColIndex;
-        vector<double> matrixValue;
-        for (int i = 0; i < numberOfConstraints; i++) {
-            matrixRowStart.push_back(matrixValue.size());
-            for (auto& element : matrix[i]) {
-                matrixColIndex.push_back(element.first);
-                matrixValue.push_back(element.second);
-            }
-        }
+    vector<int> matrixRowStart;
+    vector<int> matrixColIndex;
+    vector<double> matrixValue;
+    for (int i = 0; i < numberOfConstraints; i++) {
         matrixRowStart.push_back(matrixValue.size());
-        int *qRowStart, *qColIndex, *rRowStart, *rColIndex;
-        double *qValue, *rValue;
-        QUERN_compute_qr(numberOfConstraints, numberOfConstraints, &matrixRowStart[0], &matrixColIndex[0], &matrixValue[0], NULL,
-                &qRowStart, &qColIndex, &qValue, &rRowStart, &rColIndex, &rValue);
-        vector<vector<pair<int, double> > > transposedMatrix(numberOfConstraints);
-        _matrix.resize(numberOfConstraints);
-
-        // Extract columns from the inverse matrix one at a time.  It is done in parallel,
-        // since this can be very slow.
-        
-        ThreadPool threads;
-        threads.execute([&] (ThreadPool& pool, int threadIndex) {
-            vector<double> rhs(numberOfConstraints);
-            for (int i = threadIndex; i < numberOfConstraints; i += pool.getNumThreads()) {
-                // Extract column i of the inverse matrix.
-
-                for (int j = 0; j < numberOfConstraints; j++)
-                    rhs[j] = (i == j ? 1.0 : 0.0);
-                QUERN_multiply_with_q_transpose(numberOfConstraints, qRowStart, qColIndex, qValue, &rhs[0]);
-                QUERN_solve_with_r(numberOfConstraints, rRowStart, rColIndex, rValue, &rhs[0], &rhs[0]);
-                for (int j = 0; j < numberOfConstraints; j++) {
-                    double value = rhs[j]*distance[i]/distance[j];
-                    if (fabs(value) > elementCutoff)
-                        transposedMatrix[i].push_back(pair<int, double>(j, value));
-                }
+        for (auto& element : matrix[i]) {
+            matrixColIndex.push_back(element.first);
+            matrixValue.push_back(element.second);
+        }
+    }
+    matrixRowStart.push_back(matrixValue.size());
+    int *qRowStart, *qColIndex, *rRowStart, *rColIndex;
+    double *qValue, *rValue;
+    QUERN_compute_qr(numberOfConstraints, numberOfConstraints, &matrixRowStart[0], &matrixColIndex[0], &matrixValue[0], NULL,
+            &qRowStart, &qColIndex, &qValue, &rRowStart, &rColIndex, &rValue);
+    vector<vector<pair<int, double> > > transposedMatrix(numberOfConstraints);
+    _matrix.resize(numberOfConstraints);
+
+    // Extract columns from the inverse matrix one at a time.  It is done in parallel,
+    // since this can be very slow.
+    
+    threads.execute([&] (ThreadPool& pool, int threadIndex) {
+        vector<double> rhs(numberOfConstraints);
+        for (int i = threadIndex; i < numberOfConstraints; i += pool.getNumThreads()) {
+            // Extract column i of the inverse matrix.
+
+            for (int j = 0; j < numberOfConstraints; j++)
+                rhs[j] = (i == j ? 1.0 : 0.0);
+            QUERN_multiply_with_q_transpose(numberOfConstraints, qRowStart, qColIndex, qValue, &rhs[0]);
+            QUERN_solve_with_r(numberOfConstraints, rRowStart, rColIndex, rValue, &rhs[0], &rhs[0]);
+            for (int j = 0; j < numberOfConstraints; j++) {
+                double value = rhs[j]*distance[i]/distance[j];
+                if (fabs(value) > elementCutoff)
+                    transposedMatrix[i].push_back(pair<int, double>(j, value));
             }
-        });
-        threads.waitForThreads();
+        }
+    });
+    threads.waitForThreads();
 
-        // For purposes of thread safety we extracted the matrix in transposed form, so we need to transpose it again.
+    // For purposes of thread safety we extracted the matrix in transposed form, so we need to transpose it again.
 
-        for (int i = 0; i < numberOfConstraints; i++) {
-            for (int j = 0; j < transposedMatrix[i].size(); j++) {
-                pair<int, double> value = transposedMatrix[i][j];
-                _matrix[value.first].push_back(make_pair(i, value.second));
-            }
+    for (int i = 0; i < numberOfConstraints; i++) {
+        for (int j = 0; j < transposedMatrix[i].size(); j++) {
+            pair<int, double> value = transposedMatrix[i][j];
+            _matrix[value.first].push_back(make_pair(i, value.second));
         }
-        QUERN_free_result(qRowStart, qColIndex, qValue);
-        QUERN_free_result(rRowStart, rColIndex, rValue);
     }
+    QUERN_free_result(qRowStart, qColIndex, qValue);
+    QUERN_free_result(rRowStart, rColIndex, rValue);
 }
 
 ReferenceCCMAAlgorithm::~ReferenceCCMAAlgorithm() {
@@ -318,3 +405,9 @@ void ReferenceCCMAAlgorithm::applyConstraints(vector<Vec3>& atomCoordinates,
 const vector<vector<pair<int, double> > >& ReferenceCCMAAlgorithm::getMatrix() const {
     return _matrix;
 }
+
+void ReferenceCCMAAlgorithm::getConstraintParameters(int index, int& atom1, int& atom2, double& distance) const {
+    atom1 = _atomIndices[index].first;
+    atom2 = _atomIndices[index].second;
+    distance = _distance[index];
+}
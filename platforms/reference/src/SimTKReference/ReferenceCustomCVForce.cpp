@@ -81,8 +81,13 @@ ReferenceCustomCVForce::ReferenceCustomCVForce(const CustomCVForce& force) {
     ParsedExpression energyExpr = Parser::parse(force.getEnergyFunction(), functions).optimize();
     energyExpression = energyExpr.createCompiledExpression();
     variableDerivExpressions.clear();
-    for (auto& name : variableNames)
-        variableDerivExpressions.push_back(energyExpr.differentiate(name).createCompiledExpression());
+    cvAffectsEnergy.clear();
+    for (auto& name : variableNames) {
+        ParsedExpression deriv = energyExpr.differentiate(name).optimize();
+        const Operation& op = deriv.getRootNode().getOperation();
+        cvAffectsEnergy.push_back(op.getId() != Operation::CONSTANT || dynamic_cast<const Operation::Constant&>(op).getValue() != 0.0);
+        variableDerivExpressions.push_back(deriv.createCompiledExpression());
+    }
     paramDerivExpressions.clear();
     for (auto& name : paramDerivNames)
         paramDerivExpressions.push_back(energyExpr.differentiate(name).createCompiledExpression());
@@ -124,41 +129,60 @@ ReferenceCustomCVForce::~ReferenceCustomCVForce() {
 }
 
 void ReferenceCustomCVForce::calculateIxn(ContextImpl& innerContext, vector<Vec3>& atomCoordinates,
-                                          const map<string, double>& globalParameters, vector<Vec3>& forces,
+                                          const map<string, double>& globalParameters, bool includeForces, vector<Vec3>& forces,
                                           double* totalEnergy, map<string, double>& energyParamDerivs) {
     // Compute the collective variables, and their derivatives with respect to particle positions.
+    // Only the nonzero elements of each force are recorded, since a collective variable usually
+    // depends on a small fraction of the particles.  Forces are not needed at all for collective
+    // variables the energy does not depend on.
     
     int numCVs = variableNames.size();
     ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(innerContext.getPlatformData());
     vector<Vec3>& innerForces = *((vector<Vec3>*) data->forces);
     map<string, double>& innerDerivs = *((map<string, double>*) data->energyParameterDerivatives);
-    vector<vector<Vec3> > cvForces;
-    vector<map<string, double> > cvDerivs;
+    cvForces.resize(numCVs);
+    cvDerivs.resize(numCVs);
+    bool needDerivs = (paramDerivExpressions.size() > 0);
     for (int i = 0; i < numCVs; i++) {
-        cvValues[i] = innerContext.calcForcesAndEnergy(true, true, 1<<i);
-        cvForces.push_back(innerForces);
-        cvDerivs.push_back(innerDerivs);
+        bool needForces = cvAffectsEnergy[i] && (includeForces || needDerivs);
+        cvValues[i] = innerContext.calcForcesAndEnergy(needForces, true, 1<<i);
+        cvForces[i].clear();
+        cvDerivs[i].clear();
+        if (needForces) {
+            if (includeForces) {
+                Vec3 zero;
+                for (int j = 0; j < innerForces.size(); j++)
+                    if (innerForces[j] != zero)
+                        cvForces[i].push_back(make_pair(j, innerForces[j]));
+            }
+            cvDerivs[i] = innerDerivs;
+        }
     }
     
     // Compute the energy and forces.
     
     for (int i = 0; i < globalParameterNames.size(); i++)
         globalValues[i] = globalParameters.at(globalParameterNames[i]);
-    int numParticles = atomCoordinates.size();
     if (totalEnergy != NULL)
         *totalEnergy += energyExpression.evaluate();
-    for (int i = 0; i < numCVs; i++) {
-        double dEdV = variableDerivExpressions[i].evaluate();
-        for (int j = 0; j < numParticles; j++)
-            forces[j] += cvForces[i][j]*dEdV;
+    if (includeForces) {
+        for (int i = 0; i < numCVs; i++) {
+            if (cvForces[i].size() == 0)
+                continue;
+            double dEdV = variableDerivExpressions[i].evaluate();
+            for (auto& f : cvForces[i])
+                forces[f.first] += f.second*dEdV;
+        }
     }
     
     // Compute the energy parameter derivatives.
     
-    if (paramDerivExpressions.size() > 0) {
+    if (needDerivs) {
         for (int i = 0; i < paramDerivExpressions.size(); i++)
             energyParamDerivs[paramDerivNames[i]] += paramDerivExpressions[i].evaluate();
         for (int i = 0; i < numCVs; i++) {
+            if (cvDerivs[i].size() == 0)
+                continue;
             double dEdV = variableDerivExpressions[i].evaluate();
             for (auto& deriv : cvDerivs[i])
                 energyParamDerivs[deriv.first] += dEdV*deriv.second;
@@ -22,6 +22,7 @@
  * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <string.h>
 #include <sstream>
 #include <utility>
@@ -29,6 +30,7 @@
 #include "SimTKOpenMMUtilities.h"
 #include "ReferenceForce.h"
 #include "ReferenceCustomHbondIxn.h"
+#include "ReferenceNeighborList.h"
 
 using std::map;
 using std::pair;
@@ -127,6 +129,40 @@ void ReferenceCustomHbondIxn::calculatePairIxn(vector<Vec3>& atomCoordinates, ve
    int numDonors = donorAtoms.size();
    int numAcceptors = acceptorAtoms.size();
 
+   if (cutoff) {
+      // Only donors and acceptors whose primary atoms are within the cutoff can interact, so use a
+      // neighbor list to find them instead of looping over all pairs.  Donors come first in the list
+      // of locations, followed by acceptors.  Pairs of two donors or two acceptors are skipped.
+
+      AtomLocationList locations(numDonors+numAcceptors);
+      for (int donor = 0; donor < numDonors; donor++)
+         locations[donor] = atomCoordinates[donorAtoms[donor][0]];
+      for (int acceptor = 0; acceptor < numAcceptors; acceptor++)
+         locations[numDonors+acceptor] = atomCoordinates[acceptorAtoms[acceptor][0]];
+      NeighborList neighbors;
+      vector<set<int> > noExclusions(numDonors+numAcceptors);
+      computeNeighborListVoxelHash(neighbors, numDonors+numAcceptors, locations, noExclusions, periodicBoxVectors, periodic, cutoffDistance);
+      vector<vector<int> > donorNeighbors(numDonors);
+      for (auto& pair : neighbors) {
+         int first = std::min(pair.first, pair.second), second = std::max(pair.first, pair.second);
+         if (first < numDonors && second >= numDonors)
+            donorNeighbors[first].push_back(second-numDonors);
+      }
+      for (int donor = 0; donor < numDonors; donor++) {
+         for (int j = 0; j < (int) donorParamNames.size(); j++)
+            variables[donorParamNames[j]] = donorParameters[donor][j];
+         std::sort(donorNeighbors[donor].begin(), donorNeighbors[donor].end());
+         for (int acceptor : donorNeighbors[donor]) {
+            if (exclusions[donor].find(acceptor) == exclusions[donor].end()) {
+               for (int j = 0; j < (int) acceptorParamNames.size(); j++)
+                  variables[acceptorParamNames[j]] = acceptorParameters[acceptor][j];
+               calculateOneIxn(donor, acceptor, atomCoordinates, variables, forces, totalEnergy);
+            }
+         }
+      }
+      return;
+   }
+
    for (int donor = 0; donor < numDonors; donor++) {
       // Initialize per-donor parameters.
 
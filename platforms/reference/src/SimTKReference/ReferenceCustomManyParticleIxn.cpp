@@ -22,6 +22,7 @@
  */
 
 #include <string.h>
+#include <algorithm>
 #include <sstream>
 #include <utility>
 
@@ -36,7 +37,7 @@
 using namespace OpenMM;
 using namespace std;
 
-ReferenceCustomManyParticleIxn::ReferenceCustomManyParticleIxn(const CustomManyParticleForce& force) : useCutoff(false), usePeriodic(false) {
+ReferenceCustomManyParticleIxn::ReferenceCustomManyParticleIxn(const CustomManyParticleForce& force) : useCutoff(false), usePeriodic(false), neighborList(NULL) {
     numParticlesPerSet = force.getNumParticlesPerSet();
     numPerParticleParameters = force.getNumPerParticleParameters();
     centralParticleMode = (force.getPermutationMode() == CustomManyParticleForce::UniqueCentralParticle);
@@ -123,12 +124,31 @@ void ReferenceCustomManyParticleIxn::setPeriodic(Vec3* vectors) {
     periodicBoxVectors = vectors;
 }
 
+void ReferenceCustomManyParticleIxn::setNeighborList(const CompactNeighborList& neighbors) {
+    assert(useCutoff);
+    neighborList = &neighbors;
+}
+
 void ReferenceCustomManyParticleIxn::loopOverInteractions(vector<int>& particles, int loopIndex, vector<OpenMM::Vec3>& atomCoordinates,
                                                           vector<vector<double> >& particleParameters, map<string, double>& variables, vector<OpenMM::Vec3>& forces,
                                                           double* totalEnergy) const {
     int numParticles = atomCoordinates.size();
     int firstPartialLoop = (centralParticleMode ? 2 : 1);
     int start = (loopIndex < firstPartialLoop ? 0 : particles[loopIndex-1]+1);
+    if (loopIndex > 0 && neighborList != NULL) {
+        // Every particle after the first must be within the cutoff of it, so only consider its neighbors.
+
+        int numNeighbors = neighborList->getNumNeighbors(particles[0]);
+        const AtomIndex* neighbors = neighborList->getNeighbors(particles[0]);
+        for (int k = lower_bound(neighbors, neighbors+numNeighbors, (AtomIndex) start)-neighbors; k < numNeighbors; k++) {
+            particles[loopIndex] = neighbors[k];
+            if (loopIndex == numParticlesPerSet-1)
+                calculateOneIxn(particles, atomCoordinates, particleParameters, variables, forces, totalEnergy);
+            else
+                loopOverInteractions(particles, loopIndex+1, atomCoordinates, particleParameters, variables, forces, totalEnergy);
+        }
+        return;
+    }
     for (int i = start; i < numParticles; i++) {
         if (loopIndex > 0 && i == particles[0])
             continue;
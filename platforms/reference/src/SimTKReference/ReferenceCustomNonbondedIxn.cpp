@@ -28,12 +28,15 @@
 #include "SimTKOpenMMUtilities.h"
 #include "ReferenceForce.h"
 #include "ReferenceCustomNonbondedIxn.h"
+#include "ReferenceParallelLoop.h"
+#include <memory>
 
 using std::map;
 using std::pair;
 using std::string;
 using std::stringstream;
 using std::set;
+using std::unique_ptr;
 using std::vector;
 using namespace OpenMM;
 
@@ -49,7 +52,7 @@ ReferenceCustomNonbondedIxn::ReferenceCustomNonbondedIxn(const Lepton::CompiledE
         const std::vector<std::string>& computedValueNames, const std::vector<Lepton::CompiledExpression> computedValueExpressions) :
             cutoff(false), useSwitch(false), periodic(false), energyExpression(energyExpression), forceExpression(forceExpression),
             paramNames(parameterNames), energyParamDerivExpressions(energyParamDerivExpressions), computedValueNames(computedValueNames),
-            computedValueExpressions(computedValueExpressions) {
+            computedValueExpressions(computedValueExpressions), threads(NULL) {
     expressionSet.registerExpression(this->energyExpression);
     expressionSet.registerExpression(this->forceExpression);
     for (int i = 0; i < this->energyParamDerivExpressions.size(); i++)
@@ -82,6 +85,20 @@ ReferenceCustomNonbondedIxn::ReferenceCustomNonbondedIxn(const Lepton::CompiledE
 ReferenceCustomNonbondedIxn::~ReferenceCustomNonbondedIxn() {
 }
 
+ReferenceCustomNonbondedIxn* ReferenceCustomNonbondedIxn::createThreadCopy() const {
+    ReferenceCustomNonbondedIxn* copy = new ReferenceCustomNonbondedIxn(energyExpression, forceExpression, paramNames,
+            energyParamDerivExpressions, computedValueNames, computedValueExpressions);
+    copy->cutoff = cutoff;
+    copy->useSwitch = useSwitch;
+    copy->periodic = periodic;
+    copy->neighborList = neighborList;
+    for (int i = 0; i < 3; i++)
+        copy->periodicBoxVectors[i] = periodicBoxVectors[i];
+    copy->cutoffDistance = cutoffDistance;
+    copy->switchingDistance = switchingDistance;
+    return copy;
+}
+
   /**---------------------------------------------------------------------------------------
 
      Set the force to use a cutoff.
@@ -147,6 +164,22 @@ void ReferenceCustomNonbondedIxn::setUseSwitchingFunction(double distance) {
 
   }
 
+void ReferenceCustomNonbondedIxn::setThreadPool(ThreadPool* threads) {
+    this->threads = threads;
+}
+
+void ReferenceCustomNonbondedIxn::setPairVariables(int atom1, int atom2, const vector<vector<double> >& atomParameters,
+                                                   const vector<vector<double> >& computedValues) {
+    for (int j = 0; j < (int) paramNames.size(); j++) {
+        expressionSet.setVariable(particleParamIndex[j*2], atomParameters[atom1][j]);
+        expressionSet.setVariable(particleParamIndex[j*2+1], atomParameters[atom2][j]);
+    }
+    for (int j = 0; j < (int) computedValueNames.size(); j++) {
+        expressionSet.setVariable(computedValueIndex[j*2], computedValues[j][atom1]);
+        expressionSet.setVariable(computedValueIndex[j*2+1], computedValues[j][atom2]);
+    }
+}
+
 
 /**---------------------------------------------------------------------------------------
 
@@ -186,6 +219,19 @@ void ReferenceCustomNonbondedIxn::calculatePairIxn(int numberOfAtoms, vector<Vec
             computedValues[j][i] = computedValueExpressions[j].evaluate();
     }
     
+    // Each thread other than the first needs its own copy of the expressions.
+
+    int numThreads = ReferenceParallelLoop::getNumThreads(threads);
+    vector<unique_ptr<ReferenceCustomNonbondedIxn> > copies;
+    vector<ReferenceCustomNonbondedIxn*> threadIxn(1, this);
+    for (int i = 1; i < numThreads; i++) {
+        copies.push_back(unique_ptr<ReferenceCustomNonbondedIxn>(createThreadCopy()));
+        threadIxn.push_back(copies.back().get());
+        for (auto& param : globalParameters)
+            copies.back()->expressionSet.setVariable(copies.back()->expressionSet.getVariableIndex(param.first), param.second);
+    }
+    int numDerivs = energyParamDerivExpressions.size();
+
     // Compute the interactions.
 
     if (interactionGroups.size() > 0) {
@@ -194,58 +240,52 @@ void ReferenceCustomNonbondedIxn::calculatePairIxn(int numberOfAtoms, vector<Vec
         for (auto& group : interactionGroups) {
             const set<int>& set1 = group.first;
             const set<int>& set2 = group.second;
-            for (set<int>::const_iterator atom1 = set1.begin(); atom1 != set1.end(); ++atom1) {
-                for (set<int>::const_iterator atom2 = set2.begin(); atom2 != set2.end(); ++atom2) {
-                    if (*atom1 == *atom2 || exclusions[*atom1].find(*atom2) != exclusions[*atom1].end())
-                        continue; // This is an excluded interaction.
-                    if (*atom1 > *atom2 && set1.find(*atom2) != set1.end() && set2.find(*atom1) != set2.end())
-                        continue; // Both atoms are in both sets, so skip duplicate interactions.
-                    for (int j = 0; j < (int) paramNames.size(); j++) {
-                        expressionSet.setVariable(particleParamIndex[j*2], atomParameters[*atom1][j]);
-                        expressionSet.setVariable(particleParamIndex[j*2+1], atomParameters[*atom2][j]);
+            vector<int> atoms1(set1.begin(), set1.end());
+            ReferenceParallelLoop::execute(threads, atoms1.size(), forces, totalEnergy, energyParamDerivs, numDerivs,
+                    [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+                ReferenceCustomNonbondedIxn& ixn = *threadIxn[threadIndex];
+                for (int i = start; i < end; i++) {
+                    int atom1 = atoms1[i];
+                    for (int atom2 : set2) {
+                        if (atom1 == atom2 || exclusions[atom1].find(atom2) != exclusions[atom1].end())
+                            continue; // This is an excluded interaction.
+                        if (atom1 > atom2 && set1.find(atom2) != set1.end() && set2.find(atom1) != set2.end())
+                            continue; // Both atoms are in both sets, so skip duplicate interactions.
+                        ixn.setPairVariables(atom1, atom2, atomParameters, computedValues);
+                        ixn.calculateOneIxn(atom1, atom2, atomCoordinates, forces, totalEnergy, energyParamDerivs);
                     }
-                    for (int j = 0; j < (int) computedValueNames.size(); j++) {
-                        expressionSet.setVariable(computedValueIndex[j*2], computedValues[j][*atom1]);
-                        expressionSet.setVariable(computedValueIndex[j*2+1], computedValues[j][*atom2]);
-                    }
-                    calculateOneIxn(*atom1, *atom2, atomCoordinates, forces, totalEnergy, energyParamDerivs);
                 }
-            }
+            });
         }
     }
     else if (cutoff) {
         // We are using a cutoff, so get the interactions from the neighbor list.
         
-        for (auto& pair : *neighborList) {
-            for (int j = 0; j < (int) paramNames.size(); j++) {
-                expressionSet.setVariable(particleParamIndex[j*2], atomParameters[pair.first][j]);
-                expressionSet.setVariable(particleParamIndex[j*2+1], atomParameters[pair.second][j]);
+        const NeighborList& pairs = *neighborList;
+        ReferenceParallelLoop::execute(threads, pairs.size(), forces, totalEnergy, energyParamDerivs, numDerivs,
+                [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+            ReferenceCustomNonbondedIxn& ixn = *threadIxn[threadIndex];
+            for (int i = start; i < end; i++) {
+                ixn.setPairVariables(pairs[i].first, pairs[i].second, atomParameters, computedValues);
+                ixn.calculateOneIxn(pairs[i].first, pairs[i].second, atomCoordinates, forces, totalEnergy, energyParamDerivs);
             }
-            for (int j = 0; j < (int) computedValueNames.size(); j++) {
-                expressionSet.setVariable(computedValueIndex[j*2], computedValues[j][pair.first]);
-                expressionSet.setVariable(computedValueIndex[j*2+1], computedValues[j][pair.second]);
-            }
-            calculateOneIxn(pair.first, pair.second, atomCoordinates, forces, totalEnergy, energyParamDerivs);
-        }
+        });
     }
     else {
         // Every particle interacts with every other one.
         
-        for (int ii = 0; ii < numberOfAtoms; ii++) {
-            for (int jj = ii+1; jj < numberOfAtoms; jj++) {
-                if (exclusions[jj].find(ii) == exclusions[jj].end()) {
-                    for (int j = 0; j < (int) paramNames.size(); j++) {
-                        expressionSet.setVariable(particleParamIndex[j*2], atomParameters[ii][j]);
-                        expressionSet.setVariable(particleParamIndex[j*2+1], atomParameters[jj][j]);
+        ReferenceParallelLoop::execute(threads, numberOfAtoms, forces, totalEnergy, energyParamDerivs, numDerivs,
+                [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+            ReferenceCustomNonbondedIxn& ixn = *threadIxn[threadIndex];
+            for (int ii = start; ii < end; ii++) {
+                for (int jj = ii+1; jj < numberOfAtoms; jj++) {
+                    if (exclusions[jj].find(ii) == exclusions[jj].end()) {
+                        ixn.setPairVariables(ii, jj, atomParameters, computedValues);
+                        ixn.calculateOneIxn(ii, jj, atomCoordinates, forces, totalEnergy, energyParamDerivs);
                     }
-                    for (int j = 0; j < (int) computedValueNames.size(); j++) {
-                        expressionSet.setVariable(computedValueIndex[j*2], computedValues[j][ii]);
-                        expressionSet.setVariable(computedValueIndex[j*2+1], computedValues[j][jj]);
-                    }
-                    calculateOneIxn(ii, jj, atomCoordinates, forces, totalEnergy, energyParamDerivs);
                 }
             }
-        }
+        });
     }
 }
 
@@ -50,6 +50,7 @@ ReferenceDynamics::ReferenceDynamics(int numberOfAtoms,  double deltaT, double t
    _timeStep = 0;
    _ownReferenceConstraint = false;
    _referenceConstraint    = NULL;
+   _virtualSites           = NULL;
 }
 
 /**---------------------------------------------------------------------------------------
@@ -165,6 +166,34 @@ void ReferenceDynamics::setReferenceConstraintAlgorithm(ReferenceConstraintAlgor
    _ownReferenceConstraint = 0;
 }
 
+/**---------------------------------------------------------------------------------------
+
+   Set the object used to compute the positions of virtual sites
+
+   @param virtualSites  the object to use, or NULL to use ReferenceVirtualSites::computePositions()
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceDynamics::setVirtualSites(ReferenceVirtualSites* virtualSites) {
+   _virtualSites = virtualSites;
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Compute the positions of all virtual sites
+
+   @param system              the System being integrated
+   @param atomCoordinates     atom coordinates
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceDynamics::computeVirtualSites(const OpenMM::System& system, vector<Vec3>& atomCoordinates) {
+   if (_virtualSites == NULL)
+      ReferenceVirtualSites::computePositions(system, atomCoordinates);
+   else
+      _virtualSites->computeSitePositions(system, atomCoordinates);
+}
+
 /**---------------------------------------------------------------------------------------
 
    Update -- driver routine for performing dynamics update of coordinates
@@ -32,6 +32,7 @@
 #include "ReferenceLJCoulombIxn.h"
 #include "ReferenceForce.h"
 #include "ReferencePME.h"
+#include "ReferenceParallelLoop.h"
 #include "openmm/OpenMMException.h"
 
 // In case we're using some primitive version of Visual Studio this will
@@ -48,7 +49,7 @@ using namespace OpenMM;
 
    --------------------------------------------------------------------------------------- */
 
-ReferenceLJCoulombIxn::ReferenceLJCoulombIxn() : cutoff(false), useSwitch(false), periodic(false), periodicExceptions(false), ewald(false), pme(false), ljpme(false) {
+ReferenceLJCoulombIxn::ReferenceLJCoulombIxn() : cutoff(false), useSwitch(false), periodic(false), periodicExceptions(false), ewald(false), pme(false), ljpme(false), pmeOrder(5), threads(NULL) {
 }
 
 /**---------------------------------------------------------------------------------------
@@ -139,14 +140,16 @@ void ReferenceLJCoulombIxn::setUseEwald(double alpha, int kmaxx, int kmaxy, int
 
      @param alpha  the Ewald separation parameter
      @param gridSize the dimensions of the mesh
+     @param order  the order of the B-spline interpolation
 
      --------------------------------------------------------------------------------------- */
 
-void ReferenceLJCoulombIxn::setUsePME(double alpha, int meshSize[3]) {
+void ReferenceLJCoulombIxn::setUsePME(double alpha, int meshSize[3], int order) {
     alphaEwald = alpha;
     meshDim[0] = meshSize[0];
     meshDim[1] = meshSize[1];
     meshDim[2] = meshSize[2];
+    pmeOrder = order;
     pme = true;
 }
 
@@ -156,14 +159,16 @@ void ReferenceLJCoulombIxn::setUsePME(double alpha, int meshSize[3]) {
 
      @param alpha  the dispersion Ewald separation parameter
      @param gridSize the dimensions of the dispersion mesh
+     @param order  the order of the B-spline interpolation
 
      --------------------------------------------------------------------------------------- */
 
-void ReferenceLJCoulombIxn::setUseLJPME(double alpha, int meshSize[3]) {
+void ReferenceLJCoulombIxn::setUseLJPME(double alpha, int meshSize[3], int order) {
     alphaDispersionEwald = alpha;
     dispersionMeshDim[0] = meshSize[0];
     dispersionMeshDim[1] = meshSize[1];
     dispersionMeshDim[2] = meshSize[2];
+    pmeOrder = order;
     ljpme = true;
 }
 
@@ -171,6 +176,10 @@ void ReferenceLJCoulombIxn::setPeriodicExceptions(bool periodic) {
     periodicExceptions = periodic;
 }
 
+void ReferenceLJCoulombIxn::setThreadPool(ThreadPool* threads) {
+    this->threads = threads;
+}
+
 /**---------------------------------------------------------------------------------------
 
    Calculate Ewald ixn
@@ -201,11 +210,9 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<Vec3>& a
     double recipCoeff               = ONE_4PI_EPS0*4*PI_M/(periodicBoxVectors[0][0] * periodicBoxVectors[1][1] * periodicBoxVectors[2][2]) /epsilon;
 
     double totalSelfEwaldEnergy     = 0.0;
-    double realSpaceEwaldEnergy     = 0.0;
     double recipEnergy              = 0.0;
     double recipDispersionEnergy    = 0.0;
     double totalRecipEnergy         = 0.0;
-    double vdwEnergy                = 0.0;
 
     // A couple of sanity checks for
     if(ljpme && useSwitch)
@@ -240,7 +247,8 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<Vec3>& a
     if (pme && includeReciprocal) {
         pme_t          pmedata; /* abstract handle for PME data */
 
-        pme_init(&pmedata,alphaEwald,numberOfAtoms,meshDim,5,1);
+        pme_init(&pmedata,alphaEwald,numberOfAtoms,meshDim,pmeOrder,1);
+        pme_set_thread_pool(pmedata,threads);
 
         vector<double> charges(numberOfAtoms);
         for (int i = 0; i < numberOfAtoms; i++)
@@ -255,6 +263,7 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<Vec3>& a
         if (ljpme) {
             // Dispersion reciprocal space terms
             pme_init(&pmedata,alphaDispersionEwald,numberOfAtoms,dispersionMeshDim,5,1);
+            pme_set_thread_pool(pmedata,threads);
 
             std::vector<Vec3> dpmeforces(numberOfAtoms);
             for (int i = 0; i < numberOfAtoms; i++)
@@ -372,155 +381,161 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<Vec3>& a
 
     if (!includeDirect)
         return;
-    double totalVdwEnergy            = 0.0f;
-    double totalRealSpaceEwaldEnergy = 0.0f;
-
-
-    for (auto& pair : *neighborList) {
-        int ii = pair.first;
-        int jj = pair.second;
-
-        double deltaR[2][ReferenceForce::LastDeltaRIndex];
-        ReferenceForce::getDeltaRPeriodic(atomCoordinates[jj], atomCoordinates[ii], periodicBoxVectors, deltaR[0]);
-        double r         = deltaR[0][ReferenceForce::RIndex];
-        double inverseR  = 1.0/(deltaR[0][ReferenceForce::RIndex]);
-        double switchValue = 1, switchDeriv = 0;
-        if (useSwitch && r > switchingDistance) {
-            double t = (r-switchingDistance)/(cutoffDistance-switchingDistance);
-            switchValue = 1+t*t*t*(-10+t*(15-t*6));
-            switchDeriv = t*t*(-30+t*(60-t*30))/(cutoffDistance-switchingDistance);
-        }
-        double alphaR = alphaEwald * r;
-
+    const NeighborList& pairs = *neighborList;
+    ReferenceParallelLoop::execute(threads, pairs.size(), forces, totalEnergy, NULL, 0,
+            [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* derivs) {
+        double totalVdwEnergy            = 0.0f;
+        double totalRealSpaceEwaldEnergy = 0.0f;
+
+        for (int pairIndex = start; pairIndex < end; pairIndex++) {
+            int ii = pairs[pairIndex].first;
+            int jj = pairs[pairIndex].second;
+
+            double deltaR[2][ReferenceForce::LastDeltaRIndex];
+            ReferenceForce::getDeltaRPeriodic(atomCoordinates[jj], atomCoordinates[ii], periodicBoxVectors, deltaR[0]);
+            double r         = deltaR[0][ReferenceForce::RIndex];
+            double inverseR  = 1.0/(deltaR[0][ReferenceForce::RIndex]);
+            double switchValue = 1, switchDeriv = 0;
+            if (useSwitch && r > switchingDistance) {
+                double t = (r-switchingDistance)/(cutoffDistance-switchingDistance);
+                switchValue = 1+t*t*t*(-10+t*(15-t*6));
+                switchDeriv = t*t*(-30+t*(60-t*30))/(cutoffDistance-switchingDistance);
+            }
+            double alphaR = alphaEwald * r;
 
-        double dEdR = ONE_4PI_EPS0 * atomParameters[ii][QIndex] * atomParameters[jj][QIndex] * inverseR * inverseR * inverseR;
-        dEdR = dEdR * (erfc(alphaR) + 2 * alphaR * exp (- alphaR * alphaR) / SQRT_PI);
 
-        double sig = atomParameters[ii][SigIndex] +  atomParameters[jj][SigIndex];
-        double sig2 = inverseR*sig;
-        sig2 *= sig2;
-        double sig6 = sig2*sig2*sig2;
-        double eps = atomParameters[ii][EpsIndex]*atomParameters[jj][EpsIndex];
-        dEdR += switchValue*eps*(12.0*sig6 - 6.0)*sig6*inverseR*inverseR;
-        vdwEnergy = eps*(sig6-1.0)*sig6;
+            double dEdR = ONE_4PI_EPS0 * atomParameters[ii][QIndex] * atomParameters[jj][QIndex] * inverseR * inverseR * inverseR;
+            dEdR = dEdR * (erfc(alphaR) + 2 * alphaR * exp (- alphaR * alphaR) / SQRT_PI);
 
-        if (ljpme) {
-            double dalphaR   = alphaDispersionEwald * r;
-            double dar2 = dalphaR*dalphaR;
-            double dar4 = dar2*dar2;
-            double dar6 = dar4*dar2;
-            double inverseR2 = inverseR*inverseR;
-            double c6i = 8.0*pow(atomParameters[ii][SigIndex], 3.0) * atomParameters[ii][EpsIndex];
-            double c6j = 8.0*pow(atomParameters[jj][SigIndex], 3.0) * atomParameters[jj][EpsIndex];
-            // For the energies and forces, we first add the regular Lorentz−Berthelot terms.  The C12 term is treated as usual
-            // but we then subtract out (remembering that the C6 term is negative) the multiplicative C6 term that has been
-            // computed in real space.  Finally, we add a potential shift term to account for the difference between the LB
-            // and multiplicative functional forms at the cutoff.
-            double emult = c6i*c6j*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4));
-            dEdR += 6.0*c6i*c6j*inverseR2*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4 + dar6/6.0));
-
-            double inverseCut2 = 1.0/(cutoffDistance*cutoffDistance);
-            double inverseCut6 = inverseCut2*inverseCut2*inverseCut2;
-            sig2 = atomParameters[ii][SigIndex] +  atomParameters[jj][SigIndex];
+            double sig = atomParameters[ii][SigIndex] +  atomParameters[jj][SigIndex];
+            double sig2 = inverseR*sig;
             sig2 *= sig2;
-            sig6 = sig2*sig2*sig2;
-            // The additive part of the potential shift
-            double potentialshift = eps*(1.0-sig6*inverseCut6)*sig6*inverseCut6;
-            dalphaR   = alphaDispersionEwald * cutoffDistance;
-            dar2 = dalphaR*dalphaR;
-            dar4 = dar2*dar2;
-            // The multiplicative part of the potential shift
-            potentialshift -= c6i*c6j*inverseCut6*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4));
-            vdwEnergy += emult + potentialshift;
-        }
-
-        if (useSwitch) {
-            dEdR -= vdwEnergy*switchDeriv*inverseR;
-            vdwEnergy *= switchValue;
-        }
+            double sig6 = sig2*sig2*sig2;
+            double eps = atomParameters[ii][EpsIndex]*atomParameters[jj][EpsIndex];
+            dEdR += switchValue*eps*(12.0*sig6 - 6.0)*sig6*inverseR*inverseR;
+            double vdwEnergy = eps*(sig6-1.0)*sig6;
+
+            if (ljpme) {
+                double dalphaR   = alphaDispersionEwald * r;
+                double dar2 = dalphaR*dalphaR;
+                double dar4 = dar2*dar2;
+                double dar6 = dar4*dar2;
+                double inverseR2 = inverseR*inverseR;
+                double c6i = 8.0*pow(atomParameters[ii][SigIndex], 3.0) * atomParameters[ii][EpsIndex];
+                double c6j = 8.0*pow(atomParameters[jj][SigIndex], 3.0) * atomParameters[jj][EpsIndex];
+                // For the energies and forces, we first add the regular Lorentz−Berthelot terms.  The C12 term is treated as usual
+                // but we then subtract out (remembering that the C6 term is negative) the multiplicative C6 term that has been
+                // computed in real space.  Finally, we add a potential shift term to account for the difference between the LB
+                // and multiplicative functional forms at the cutoff.
+                double emult = c6i*c6j*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4));
+                dEdR += 6.0*c6i*c6j*inverseR2*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4 + dar6/6.0));
+
+                double inverseCut2 = 1.0/(cutoffDistance*cutoffDistance);
+                double inverseCut6 = inverseCut2*inverseCut2*inverseCut2;
+                sig2 = atomParameters[ii][SigIndex] +  atomParameters[jj][SigIndex];
+                sig2 *= sig2;
+                sig6 = sig2*sig2*sig2;
+                // The additive part of the potential shift
+                double potentialshift = eps*(1.0-sig6*inverseCut6)*sig6*inverseCut6;
+                dalphaR   = alphaDispersionEwald * cutoffDistance;
+                dar2 = dalphaR*dalphaR;
+                dar4 = dar2*dar2;
+                // The multiplicative part of the potential shift
+                potentialshift -= c6i*c6j*inverseCut6*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4));
+                vdwEnergy += emult + potentialshift;
+            }
 
-        // accumulate forces
+            if (useSwitch) {
+                dEdR -= vdwEnergy*switchDeriv*inverseR;
+                vdwEnergy *= switchValue;
+            }
 
-        for (int kk = 0; kk < 3; kk++) {
-            double force  = dEdR*deltaR[0][kk];
-            forces[ii][kk]   += force;
-            forces[jj][kk]   -= force;
-        }
+            // accumulate forces
 
-        // accumulate energies
+            for (int kk = 0; kk < 3; kk++) {
+                double force  = dEdR*deltaR[0][kk];
+                forces[ii][kk]   += force;
+                forces[jj][kk]   -= force;
+            }
 
-        realSpaceEwaldEnergy        = ONE_4PI_EPS0*atomParameters[ii][QIndex]*atomParameters[jj][QIndex]*inverseR*erfc(alphaR);
+            // accumulate energies
 
-        totalVdwEnergy             += vdwEnergy;
-        totalRealSpaceEwaldEnergy  += realSpaceEwaldEnergy;
+            double realSpaceEwaldEnergy = ONE_4PI_EPS0*atomParameters[ii][QIndex]*atomParameters[jj][QIndex]*inverseR*erfc(alphaR);
 
-    }
+            totalVdwEnergy             += vdwEnergy;
+            totalRealSpaceEwaldEnergy  += realSpaceEwaldEnergy;
+        }
 
-    if (totalEnergy)
-        *totalEnergy += totalRealSpaceEwaldEnergy + totalVdwEnergy;
+        if (totalEnergy)
+            *totalEnergy += totalRealSpaceEwaldEnergy + totalVdwEnergy;
+    });
 
     // Now subtract off the exclusions, since they were implicitly included in the reciprocal space sum.
 
-    double totalExclusionEnergy = 0.0f;
     const double TWO_OVER_SQRT_PI = 2/sqrt(PI_M);
-    for (int i = 0; i < numberOfAtoms; i++)
-        for (int exclusion : exclusions[i]) {
-            if (exclusion > i) {
-                int ii = i;
-                int jj = exclusion;
-
-                double deltaR[2][ReferenceForce::LastDeltaRIndex];
-                if (periodicExceptions)
-                    ReferenceForce::getDeltaRPeriodic(atomCoordinates[jj], atomCoordinates[ii], periodicBoxVectors, deltaR[0]);
-                else
-                    ReferenceForce::getDeltaR(atomCoordinates[jj], atomCoordinates[ii], deltaR[0]);
-                double r         = deltaR[0][ReferenceForce::RIndex];
-                double inverseR  = 1.0/(deltaR[0][ReferenceForce::RIndex]);
-                double alphaR    = alphaEwald * r;
-                if (erf(alphaR) > 1e-6) {
-                    double dEdR = ONE_4PI_EPS0 * atomParameters[ii][QIndex] * atomParameters[jj][QIndex] * inverseR * inverseR * inverseR;
-                    dEdR = dEdR * (erf(alphaR) - 2 * alphaR * exp (- alphaR * alphaR) / SQRT_PI);
-
-                    // accumulate forces
-
-                    for (int kk = 0; kk < 3; kk++) {
-                        double force = dEdR*deltaR[0][kk];
-                        forces[ii][kk] -= force;
-                        forces[jj][kk] += force;
+    ReferenceParallelLoop::execute(threads, numberOfAtoms, forces, totalEnergy, NULL, 0,
+            [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* derivs) {
+        double totalExclusionEnergy = 0.0f;
+        for (int i = start; i < end; i++)
+            for (int exclusion : exclusions[i]) {
+                if (exclusion > i) {
+                    int ii = i;
+                    int jj = exclusion;
+
+                    double deltaR[2][ReferenceForce::LastDeltaRIndex];
+                    if (periodicExceptions)
+                        ReferenceForce::getDeltaRPeriodic(atomCoordinates[jj], atomCoordinates[ii], periodicBoxVectors, deltaR[0]);
+                    else
+                        ReferenceForce::getDeltaR(atomCoordinates[jj], atomCoordinates[ii], deltaR[0]);
+                    double r         = deltaR[0][ReferenceForce::RIndex];
+                    double inverseR  = 1.0/(deltaR[0][ReferenceForce::RIndex]);
+                    double alphaR    = alphaEwald * r;
+                    double realSpaceEwaldEnergy;
+                    if (erf(alphaR) > 1e-6) {
+                        double dEdR = ONE_4PI_EPS0 * atomParameters[ii][QIndex] * atomParameters[jj][QIndex] * inverseR * inverseR * inverseR;
+                        dEdR = dEdR * (erf(alphaR) - 2 * alphaR * exp (- alphaR * alphaR) / SQRT_PI);
+
+                        // accumulate forces
+
+                        for (int kk = 0; kk < 3; kk++) {
+                            double force = dEdR*deltaR[0][kk];
+                            forces[ii][kk] -= force;
+                            forces[jj][kk] += force;
+                        }
+
+                        // accumulate energies
+
+                        realSpaceEwaldEnergy = ONE_4PI_EPS0*atomParameters[ii][QIndex]*atomParameters[jj][QIndex]*inverseR*erf(alphaR);
+                    }
+                    else {
+                        realSpaceEwaldEnergy = alphaEwald*TWO_OVER_SQRT_PI*ONE_4PI_EPS0*atomParameters[ii][QIndex]*atomParameters[jj][QIndex];
                     }
 
-                    // accumulate energies
-
-                    realSpaceEwaldEnergy = ONE_4PI_EPS0*atomParameters[ii][QIndex]*atomParameters[jj][QIndex]*inverseR*erf(alphaR);
-                }
-                else {
-                    realSpaceEwaldEnergy = alphaEwald*TWO_OVER_SQRT_PI*ONE_4PI_EPS0*atomParameters[ii][QIndex]*atomParameters[jj][QIndex];
-                }
-
-                if(ljpme){
-                    // Dispersion terms.  Here we just back out the reciprocal space terms, and don't add any extra real space terms.
-                    double dalphaR   = alphaDispersionEwald * r;
-                    double inverseR2 = inverseR*inverseR;
-                    double dar2 = dalphaR*dalphaR;
-                    double dar4 = dar2*dar2;
-                    double dar6 = dar4*dar2;
-                    double c6i = 8.0*pow(atomParameters[ii][SigIndex], 3.0) * atomParameters[ii][EpsIndex];
-                    double c6j = 8.0*pow(atomParameters[jj][SigIndex], 3.0) * atomParameters[jj][EpsIndex];
-                    realSpaceEwaldEnergy -= c6i*c6j*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4));
-                    double dEdR = -6.0*c6i*c6j*inverseR2*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4 + dar6/6.0));
-                    for (int kk = 0; kk < 3; kk++) {
-                        double force = dEdR*deltaR[0][kk];
-                        forces[ii][kk] -= force;
-                        forces[jj][kk] += force;
+                    if(ljpme){
+                        // Dispersion terms.  Here we just back out the reciprocal space terms, and don't add any extra real space terms.
+                        double dalphaR   = alphaDispersionEwald * r;
+                        double inverseR2 = inverseR*inverseR;
+                        double dar2 = dalphaR*dalphaR;
+                        double dar4 = dar2*dar2;
+                        double dar6 = dar4*dar2;
+                        double c6i = 8.0*pow(atomParameters[ii][SigIndex], 3.0) * atomParameters[ii][EpsIndex];
+                        double c6j = 8.0*pow(atomParameters[jj][SigIndex], 3.0) * atomParameters[jj][EpsIndex];
+                        realSpaceEwaldEnergy -= c6i*c6j*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4));
+                        double dEdR = -6.0*c6i*c6j*inverseR2*inverseR2*inverseR2*inverseR2*(1.0 - EXP(-dar2) * (1.0 + dar2 + 0.5*dar4 + dar6/6.0));
+                        for (int kk = 0; kk < 3; kk++) {
+                            double force = dEdR*deltaR[0][kk];
+                            forces[ii][kk] -= force;
+                            forces[jj][kk] += force;
+                        }
                     }
-                }
 
-                totalExclusionEnergy += realSpaceEwaldEnergy;
+                    totalExclusionEnergy += realSpaceEwaldEnergy;
+                }
             }
-        }
 
-    if (totalEnergy)
-        *totalEnergy -= totalExclusionEnergy;
+        if (totalEnergy)
+            *totalEnergy -= totalExclusionEnergy;
+    });
 }
 
 
@@ -552,17 +567,24 @@ void ReferenceLJCoulombIxn::calculatePairIxn(int numberOfAtoms, vector<Vec3>& at
     if (!includeDirect)
         return;
     if (cutoff) {
-        for (auto& pair : *neighborList)
-            calculateOneIxn(pair.first, pair.second, atomCoordinates, atomParameters, forces, totalEnergy);
+        const NeighborList& pairs = *neighborList;
+        ReferenceParallelLoop::execute(threads, pairs.size(), forces, totalEnergy, NULL, 0,
+                [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* derivs) {
+            for (int i = start; i < end; i++)
+                calculateOneIxn(pairs[i].first, pairs[i].second, atomCoordinates, atomParameters, forces, totalEnergy);
+        });
     }
     else {
-        for (int ii = 0; ii < numberOfAtoms; ii++) {
-            // loop over atom pairs
-
-            for (int jj = ii+1; jj < numberOfAtoms; jj++)
-                if (exclusions[jj].find(ii) == exclusions[jj].end())
-                    calculateOneIxn(ii, jj, atomCoordinates, atomParameters, forces, totalEnergy);
-        }
+        ReferenceParallelLoop::execute(threads, numberOfAtoms, forces, totalEnergy, NULL, 0,
+                [&] (int threadIndex, int start, int end, vector<Vec3>& forces, double* totalEnergy, double* derivs) {
+            for (int ii = start; ii < end; ii++) {
+                // loop over atom pairs
+
+                for (int jj = ii+1; jj < numberOfAtoms; jj++)
+                    if (exclusions[jj].find(ii) == exclusions[jj].end())
+                        calculateOneIxn(ii, jj, atomCoordinates, atomParameters, forces, totalEnergy);
+            }
+        });
     }
 }
 
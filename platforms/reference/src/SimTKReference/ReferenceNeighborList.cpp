@@ -258,4 +258,75 @@ void OPENMM_EXPORT computeNeighborListVoxelHash(
     }
 }
 
+CompactNeighborList::CompactNeighborList(double maxDistance, double padding, bool usePeriodic) :
+        maxDistance(maxDistance), padding(padding), usePeriodic(usePeriodic), numBuilds(0), neighborStart(1, 0) {
+}
+
+bool CompactNeighborList::update(const AtomLocationList& atomLocations, const Vec3* periodicBoxVectors) {
+    bool rebuild = (numBuilds == 0 || atomLocations.size() != buildLocations.size());
+    if (!rebuild && usePeriodic)
+        for (int i = 0; i < 3; i++)
+            if (periodicBoxVectors[i] != buildBoxVectors[i])
+                rebuild = true;
+    if (!rebuild) {
+        double maxDisplacementSquared = 0.25*padding*padding;
+        for (int i = 0; i < (int) atomLocations.size() && !rebuild; i++) {
+            Vec3 delta = atomLocations[i]-buildLocations[i];
+            if (delta.dot(delta) > maxDisplacementSquared)
+                rebuild = true;
+        }
+    }
+    if (rebuild)
+        build(atomLocations, periodicBoxVectors);
+    return rebuild;
+}
+
+void CompactNeighborList::build(const AtomLocationList& atomLocations, const Vec3* periodicBoxVectors) {
+    int nAtoms = atomLocations.size();
+    NeighborList pairs;
+    vector<set<int> > noExclusions(nAtoms);
+    computeNeighborListVoxelHash(pairs, nAtoms, atomLocations, noExclusions, periodicBoxVectors, usePeriodic, maxDistance+padding);
+
+    // Count the neighbors of each atom, then fill in the rows.
+
+    neighborStart.assign(nAtoms+1, 0);
+    for (auto& pair : pairs) {
+        neighborStart[pair.first+1]++;
+        neighborStart[pair.second+1]++;
+    }
+    for (int i = 0; i < nAtoms; i++)
+        neighborStart[i+1] += neighborStart[i];
+    neighbors.resize(neighborStart[nAtoms]);
+    vector<int> next(neighborStart.begin(), neighborStart.end()-1);
+    for (auto& pair : pairs) {
+        neighbors[next[pair.first]++] = pair.second;
+        neighbors[next[pair.second]++] = pair.first;
+    }
+    for (int i = 0; i < nAtoms; i++)
+        sort(neighbors.begin()+neighborStart[i], neighbors.begin()+neighborStart[i+1]);
+    buildLocations = atomLocations;
+    for (int i = 0; i < 3; i++)
+        buildBoxVectors[i] = periodicBoxVectors[i];
+    numBuilds++;
+}
+
+void CompactNeighborList::getPairs(NeighborList& pairs, const AtomLocationList& atomLocations, const vector<set<int> >& exclusions,
+                                   const Vec3* periodicBoxVectors, double maxDistance) const {
+    assert(maxDistance <= this->maxDistance);
+    pairs.clear();
+    double maxDistanceSquared = maxDistance*maxDistance;
+    for (AtomIndex atomI = 0; atomI < (AtomIndex) getNumAtoms(); atomI++) {
+        for (int k = neighborStart[atomI]; k < neighborStart[atomI+1]; k++) {
+            AtomIndex atomJ = neighbors[k];
+            if (atomJ >= atomI)
+                break;
+            if (compPairDistanceSquared(atomLocations[atomI], atomLocations[atomJ], periodicBoxVectors, usePeriodic) > maxDistanceSquared)
+                continue;
+            if (exclusions[atomI].find(atomJ) != exclusions[atomI].end())
+                continue;
+            pairs.push_back(AtomPair(atomI, atomJ));
+        }
+    }
+}
+
 } // namespace OpenMM
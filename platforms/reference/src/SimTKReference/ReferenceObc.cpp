@@ -30,6 +30,7 @@
 
 #include "ReferenceForce.h"
 #include "ReferenceObc.h"
+#include "ReferenceParallelLoop.h"
 
 using namespace OpenMM;
 using namespace std;
@@ -42,7 +43,7 @@ using namespace std;
     
     --------------------------------------------------------------------------------------- */
 
-ReferenceObc::ReferenceObc(ObcParameters* obcParameters) : _obcParameters(obcParameters), _includeAceApproximation(1) {
+ReferenceObc::ReferenceObc(ObcParameters* obcParameters) : _obcParameters(obcParameters), _includeAceApproximation(1), _threads(NULL) {
     _obcChain.resize(_obcParameters->getNumberOfAtoms());
 }
 
@@ -103,6 +104,18 @@ void ReferenceObc::setIncludeAceApproximation(int includeAceApproximation) {
     _includeAceApproximation = includeAceApproximation;
 }
 
+/**---------------------------------------------------------------------------------------
+
+    Set the ThreadPool to use for computing the interactions
+
+    @param threads    the ThreadPool to use, or NULL to compute everything on the calling thread
+
+    --------------------------------------------------------------------------------------- */
+
+void ReferenceObc::setThreadPool(ThreadPool* threads) {
+    _threads = threads;
+}
+
 /**---------------------------------------------------------------------------------------
 
     Return OBC chain derivative: size = _obcParameters->getNumberOfAtoms()
@@ -145,72 +158,74 @@ void ReferenceObc::computeBornRadii(const vector<Vec3>& atomCoordinates, vector<
 
     // calculate Born radii
 
-    for (int atomI = 0; atomI < numberOfAtoms; atomI++) {
+    ReferenceParallelLoop::execute(_threads, numberOfAtoms, [&] (int threadIndex, int start, int end) {
+        for (int atomI = start; atomI < end; atomI++) {
       
-       double radiusI         = atomicRadii[atomI];
-       double offsetRadiusI   = radiusI - dielectricOffset;
+           double radiusI         = atomicRadii[atomI];
+           double offsetRadiusI   = radiusI - dielectricOffset;
 
-       double radiusIInverse  = 1.0/offsetRadiusI;
-       double sum             = 0.0;
+           double radiusIInverse  = 1.0/offsetRadiusI;
+           double sum             = 0.0;
 
-       // HCT code
+           // HCT code
 
-       for (int atomJ = 0; atomJ < numberOfAtoms; atomJ++) {
+           for (int atomJ = 0; atomJ < numberOfAtoms; atomJ++) {
 
-          if (atomJ != atomI) {
+              if (atomJ != atomI) {
 
-             double deltaR[ReferenceForce::LastDeltaRIndex];
-             if (_obcParameters->getPeriodic())
-                 ReferenceForce::getDeltaRPeriodic(atomCoordinates[atomI], atomCoordinates[atomJ], _obcParameters->getPeriodicBox(), deltaR);
-             else
-                 ReferenceForce::getDeltaR(atomCoordinates[atomI], atomCoordinates[atomJ], deltaR);
-             double r               = deltaR[ReferenceForce::RIndex];
-             if (_obcParameters->getUseCutoff() && r > _obcParameters->getCutoffDistance())
-                 continue;
+                 double deltaR[ReferenceForce::LastDeltaRIndex];
+                 if (_obcParameters->getPeriodic())
+                     ReferenceForce::getDeltaRPeriodic(atomCoordinates[atomI], atomCoordinates[atomJ], _obcParameters->getPeriodicBox(), deltaR);
+                 else
+                     ReferenceForce::getDeltaR(atomCoordinates[atomI], atomCoordinates[atomJ], deltaR);
+                 double r               = deltaR[ReferenceForce::RIndex];
+                 if (_obcParameters->getUseCutoff() && r > _obcParameters->getCutoffDistance())
+                     continue;
 
-             double offsetRadiusJ   = atomicRadii[atomJ] - dielectricOffset; 
-             double scaledRadiusJ   = offsetRadiusJ*scaledRadiusFactor[atomJ];
-             double rScaledRadiusJ  = r + scaledRadiusJ;
+                 double offsetRadiusJ   = atomicRadii[atomJ] - dielectricOffset; 
+                 double scaledRadiusJ   = offsetRadiusJ*scaledRadiusFactor[atomJ];
+                 double rScaledRadiusJ  = r + scaledRadiusJ;
 
-             if (offsetRadiusI < rScaledRadiusJ) {
-                double rInverse = 1.0/r;
-                double l_ij     = offsetRadiusI > fabs(r - scaledRadiusJ) ? offsetRadiusI : fabs(r - scaledRadiusJ);
-                       l_ij     = 1.0/l_ij;
+                 if (offsetRadiusI < rScaledRadiusJ) {
+                    double rInverse = 1.0/r;
+                    double l_ij     = offsetRadiusI > fabs(r - scaledRadiusJ) ? offsetRadiusI : fabs(r - scaledRadiusJ);
+                           l_ij     = 1.0/l_ij;
 
-                double u_ij     = 1.0/rScaledRadiusJ;
+                    double u_ij     = 1.0/rScaledRadiusJ;
 
-                double l_ij2    = l_ij*l_ij;
-                double u_ij2    = u_ij*u_ij;
+                    double l_ij2    = l_ij*l_ij;
+                    double u_ij2    = u_ij*u_ij;
  
-                double ratio    = log((u_ij/l_ij));
-                double term     = l_ij - u_ij + 0.25*r*(u_ij2 - l_ij2)  + (0.5*rInverse*ratio) + (0.25*scaledRadiusJ*scaledRadiusJ*rInverse)*(l_ij2 - u_ij2);
+                    double ratio    = log((u_ij/l_ij));
+                    double term     = l_ij - u_ij + 0.25*r*(u_ij2 - l_ij2)  + (0.5*rInverse*ratio) + (0.25*scaledRadiusJ*scaledRadiusJ*rInverse)*(l_ij2 - u_ij2);
 
-                // this case (atom i completely inside atom j) is not considered in the original paper
-                // Jay Ponder and the authors of Tinker recognized this and
-                // worked out the details
+                    // this case (atom i completely inside atom j) is not considered in the original paper
+                    // Jay Ponder and the authors of Tinker recognized this and
+                    // worked out the details
 
-                if (offsetRadiusI < (scaledRadiusJ - r)) {
-                   term += 2.0*(radiusIInverse - l_ij);
-                }
-                sum += term;
+                    if (offsetRadiusI < (scaledRadiusJ - r)) {
+                       term += 2.0*(radiusIInverse - l_ij);
+                    }
+                    sum += term;
 
-             }
-          }
-       }
+                 }
+              }
+           }
  
-       // OBC-specific code (Eqs. 6-8 in paper)
+           // OBC-specific code (Eqs. 6-8 in paper)
 
-       sum              *= 0.5*offsetRadiusI;
-       double sum2       = sum*sum;
-       double sum3       = sum*sum2;
-       double tanhSum    = tanh(alphaObc*sum - betaObc*sum2 + gammaObc*sum3);
+           sum              *= 0.5*offsetRadiusI;
+           double sum2       = sum*sum;
+           double sum3       = sum*sum2;
+           double tanhSum    = tanh(alphaObc*sum - betaObc*sum2 + gammaObc*sum3);
        
-       bornRadii[atomI]      = 1.0/(1.0/offsetRadiusI - tanhSum/radiusI); 
+           bornRadii[atomI]      = 1.0/(1.0/offsetRadiusI - tanhSum/radiusI); 
  
-       obcChain[atomI]       = offsetRadiusI*(alphaObc - 2.0*betaObc*sum + 3.0*gammaObc*sum2);
-       obcChain[atomI]       = (1.0 - tanhSum*tanhSum)*obcChain[atomI]/radiusI;
+           obcChain[atomI]       = offsetRadiusI*(alphaObc - 2.0*betaObc*sum + 3.0*gammaObc*sum2);
+           obcChain[atomI]       = (1.0 - tanhSum*tanhSum)*obcChain[atomI]/radiusI;
 
-    }
+        }
+    });
 }
 
 /**---------------------------------------------------------------------------------------
@@ -314,66 +329,69 @@ double ReferenceObc::computeBornEnergyForces(const vector<Vec3>& atomCoordinates
 
     // first main loop
 
-    for (int atomI = 0; atomI < numberOfAtoms; atomI++) {
+    ReferenceParallelLoop::execute(_threads, numberOfAtoms, inputForces, &obcEnergy, bornForces.data(), numberOfAtoms,
+            [&] (int threadIndex, int start, int end, vector<Vec3>& inputForces, double* obcEnergy, double* bornForces) {
+        for (int atomI = start; atomI < end; atomI++) {
  
-       double partialChargeI = preFactor*partialCharges[atomI];
-       for (int atomJ = atomI; atomJ < numberOfAtoms; atomJ++) {
-
-          double deltaR[ReferenceForce::LastDeltaRIndex];
-          if (_obcParameters->getPeriodic())
-              ReferenceForce::getDeltaRPeriodic(atomCoordinates[atomI], atomCoordinates[atomJ], _obcParameters->getPeriodicBox(), deltaR);
-          else
-              ReferenceForce::getDeltaR(atomCoordinates[atomI], atomCoordinates[atomJ], deltaR);
-          if (_obcParameters->getUseCutoff() && deltaR[ReferenceForce::RIndex] > cutoffDistance)
-              continue;
-
-          double r2                 = deltaR[ReferenceForce::R2Index];
-          double deltaX             = deltaR[ReferenceForce::XIndex];
-          double deltaY             = deltaR[ReferenceForce::YIndex];
-          double deltaZ             = deltaR[ReferenceForce::ZIndex];
-
-          double alpha2_ij          = bornRadii[atomI]*bornRadii[atomJ];
-          double D_ij               = r2/(4.0*alpha2_ij);
-
-          double expTerm            = exp(-D_ij);
-          double denominator2       = r2 + alpha2_ij*expTerm; 
-          double denominator        = sqrt(denominator2); 
+           double partialChargeI = preFactor*partialCharges[atomI];
+           for (int atomJ = atomI; atomJ < numberOfAtoms; atomJ++) {
+
+              double deltaR[ReferenceForce::LastDeltaRIndex];
+              if (_obcParameters->getPeriodic())
+                  ReferenceForce::getDeltaRPeriodic(atomCoordinates[atomI], atomCoordinates[atomJ], _obcParameters->getPeriodicBox(), deltaR);
+              else
+                  ReferenceForce::getDeltaR(atomCoordinates[atomI], atomCoordinates[atomJ], deltaR);
+              if (_obcParameters->getUseCutoff() && deltaR[ReferenceForce::RIndex] > cutoffDistance)
+                  continue;
+
+              double r2                 = deltaR[ReferenceForce::R2Index];
+              double deltaX             = deltaR[ReferenceForce::XIndex];
+              double deltaY             = deltaR[ReferenceForce::YIndex];
+              double deltaZ             = deltaR[ReferenceForce::ZIndex];
+
+              double alpha2_ij          = bornRadii[atomI]*bornRadii[atomJ];
+              double D_ij               = r2/(4.0*alpha2_ij);
+
+              double expTerm            = exp(-D_ij);
+              double denominator2       = r2 + alpha2_ij*expTerm; 
+              double denominator        = sqrt(denominator2); 
           
-          double Gpol               = (partialChargeI*partialCharges[atomJ])/denominator; 
-          double dGpol_dr           = -Gpol*(1.0 - 0.25*expTerm)/denominator2;  
+              double Gpol               = (partialChargeI*partialCharges[atomJ])/denominator; 
+              double dGpol_dr           = -Gpol*(1.0 - 0.25*expTerm)/denominator2;  
 
-          double dGpol_dalpha2_ij   = -0.5*Gpol*expTerm*(1.0 + D_ij)/denominator2;
+              double dGpol_dalpha2_ij   = -0.5*Gpol*expTerm*(1.0 + D_ij)/denominator2;
           
-          double energy = Gpol;
+              double energy = Gpol;
 
-          if (atomI != atomJ) {
+              if (atomI != atomJ) {
 
-              if (_obcParameters->getUseCutoff())
-                  energy -= partialChargeI*partialCharges[atomJ]/cutoffDistance;
+                  if (_obcParameters->getUseCutoff())
+                      energy -= partialChargeI*partialCharges[atomJ]/cutoffDistance;
               
-              bornForces[atomJ]        += dGpol_dalpha2_ij*bornRadii[atomI];
+                  bornForces[atomJ]        += dGpol_dalpha2_ij*bornRadii[atomI];
 
-              deltaX                   *= dGpol_dr;
-              deltaY                   *= dGpol_dr;
-              deltaZ                   *= dGpol_dr;
+                  deltaX                   *= dGpol_dr;
+                  deltaY                   *= dGpol_dr;
+                  deltaZ                   *= dGpol_dr;
 
-              inputForces[atomI][0]    += deltaX;
-              inputForces[atomI][1]    += deltaY;
-              inputForces[atomI][2]    += deltaZ;
+                  inputForces[atomI][0]    += deltaX;
+                  inputForces[atomI][1]    += deltaY;
+                  inputForces[atomI][2]    += deltaZ;
 
-              inputForces[atomJ][0]    -= deltaX;
-              inputForces[atomJ][1]    -= deltaY;
-              inputForces[atomJ][2]    -= deltaZ;
+                  inputForces[atomJ][0]    -= deltaX;
+                  inputForces[atomJ][1]    -= deltaY;
+                  inputForces[atomJ][2]    -= deltaZ;
 
-          } else {
-             energy *= 0.5;
-          }
+              } else {
+                 energy *= 0.5;
+              }
 
-          obcEnergy         += energy;
-          bornForces[atomI] += dGpol_dalpha2_ij*bornRadii[atomJ];
+              *obcEnergy        += energy;
+              bornForces[atomI] += dGpol_dalpha2_ij*bornRadii[atomJ];
 
-       }
-    }
+           }
+        }
+    });
 
     // ---------------------------------------------------------------------------------------
 
@@ -390,76 +408,79 @@ double ReferenceObc::computeBornEnergyForces(const vector<Vec3>& atomCoordinates
        bornForces[atomI] *= bornRadii[atomI]*bornRadii[atomI]*obcChain[atomI];      
     }
 
-    for (int atomI = 0; atomI < numberOfAtoms; atomI++) {
+    ReferenceParallelLoop::execute(_threads, numberOfAtoms, inputForces, NULL, NULL, 0,
+            [&] (int threadIndex, int start, int end, vector<Vec3>& inputForces, double* energy, double* derivs) {
+        for (int atomI = start; atomI < end; atomI++) {
  
-       // radius w/ dielectric offset applied
+           // radius w/ dielectric offset applied
 
-       double radiusI        = atomicRadii[atomI];
-       double offsetRadiusI  = radiusI - dielectricOffset;
+           double radiusI        = atomicRadii[atomI];
+           double offsetRadiusI  = radiusI - dielectricOffset;
 
-       for (int atomJ = 0; atomJ < numberOfAtoms; atomJ++) {
+           for (int atomJ = 0; atomJ < numberOfAtoms; atomJ++) {
 
-          if (atomJ != atomI) {
+              if (atomJ != atomI) {
 
-             double deltaR[ReferenceForce::LastDeltaRIndex];
-             if (_obcParameters->getPeriodic())
-                ReferenceForce::getDeltaRPeriodic(atomCoordinates[atomI], atomCoordinates[atomJ], _obcParameters->getPeriodicBox(), deltaR);
-             else 
-                ReferenceForce::getDeltaR(atomCoordinates[atomI], atomCoordinates[atomJ], deltaR);
-             if (_obcParameters->getUseCutoff() && deltaR[ReferenceForce::RIndex] > cutoffDistance)
-                    continue;
+                 double deltaR[ReferenceForce::LastDeltaRIndex];
+                 if (_obcParameters->getPeriodic())
+                    ReferenceForce::getDeltaRPeriodic(atomCoordinates[atomI], atomCoordinates[atomJ], _obcParameters->getPeriodicBox(), deltaR);
+                 else 
+                    ReferenceForce::getDeltaR(atomCoordinates[atomI], atomCoordinates[atomJ], deltaR);
+                 if (_obcParameters->getUseCutoff() && deltaR[ReferenceForce::RIndex] > cutoffDistance)
+                        continue;
     
-             double deltaX             = deltaR[ReferenceForce::XIndex];
-             double deltaY             = deltaR[ReferenceForce::YIndex];
-             double deltaZ             = deltaR[ReferenceForce::ZIndex];
-             double r                  = deltaR[ReferenceForce::RIndex];
+                 double deltaX             = deltaR[ReferenceForce::XIndex];
+                 double deltaY             = deltaR[ReferenceForce::YIndex];
+                 double deltaZ             = deltaR[ReferenceForce::ZIndex];
+                 double r                  = deltaR[ReferenceForce::RIndex];
  
-             // radius w/ dielectric offset applied
+                 // radius w/ dielectric offset applied
 
-             double offsetRadiusJ      = atomicRadii[atomJ] - dielectricOffset;
+                 double offsetRadiusJ      = atomicRadii[atomJ] - dielectricOffset;
 
-             double scaledRadiusJ      = offsetRadiusJ*scaledRadiusFactor[atomJ];
-             double scaledRadiusJ2     = scaledRadiusJ*scaledRadiusJ;
-             double rScaledRadiusJ     = r + scaledRadiusJ;
+                 double scaledRadiusJ      = offsetRadiusJ*scaledRadiusFactor[atomJ];
+                 double scaledRadiusJ2     = scaledRadiusJ*scaledRadiusJ;
+                 double rScaledRadiusJ     = r + scaledRadiusJ;
 
-             // dL/dr & dU/dr are zero (this can be shown analytically)
-             // removed from calculation
+                 // dL/dr & dU/dr are zero (this can be shown analytically)
+                 // removed from calculation
 
-             if (offsetRadiusI < rScaledRadiusJ) {
+                 if (offsetRadiusI < rScaledRadiusJ) {
 
-                double l_ij          = offsetRadiusI > fabs(r - scaledRadiusJ) ? offsetRadiusI : fabs(r - scaledRadiusJ);
-                       l_ij          = 1.0/l_ij;
+                    double l_ij          = offsetRadiusI > fabs(r - scaledRadiusJ) ? offsetRadiusI : fabs(r - scaledRadiusJ);
+                           l_ij          = 1.0/l_ij;
 
-                double u_ij          = 1.0/rScaledRadiusJ;
+                    double u_ij          = 1.0/rScaledRadiusJ;
 
-                double l_ij2         = l_ij*l_ij;
+                    double l_ij2         = l_ij*l_ij;
 
-                double u_ij2         = u_ij*u_ij;
+                    double u_ij2         = u_ij*u_ij;
  
-                double rInverse      = 1.0/r;
-                double r2Inverse     = rInverse*rInverse;
+                    double rInverse      = 1.0/r;
+                    double r2Inverse     = rInverse*rInverse;
 
-                double t3            = 0.125*(1.0 + scaledRadiusJ2*r2Inverse)*(l_ij2 - u_ij2) + 0.25*log(u_ij/l_ij)*r2Inverse;
+                    double t3            = 0.125*(1.0 + scaledRadiusJ2*r2Inverse)*(l_ij2 - u_ij2) + 0.25*log(u_ij/l_ij)*r2Inverse;
 
-                double de            = bornForces[atomI]*t3*rInverse;
+                    double de            = bornForces[atomI]*t3*rInverse;
 
-                deltaX                  *= de;
-                deltaY                  *= de;
-                deltaZ                  *= de;
+                    deltaX                  *= de;
+                    deltaY                  *= de;
+                    deltaZ                  *= de;
     
-                inputForces[atomI][0]   -= deltaX;
-                inputForces[atomI][1]   -= deltaY;
-                inputForces[atomI][2]   -= deltaZ;
+                    inputForces[atomI][0]   -= deltaX;
+                    inputForces[atomI][1]   -= deltaY;
+                    inputForces[atomI][2]   -= deltaZ;
   
-                inputForces[atomJ][0]   += deltaX;
-                inputForces[atomJ][1]   += deltaY;
-                inputForces[atomJ][2]   += deltaZ;
+                    inputForces[atomJ][0]   += deltaX;
+                    inputForces[atomJ][1]   += deltaY;
+                    inputForces[atomJ][2]   += deltaZ;
  
-             }
-          }
-       }
+                 }
+              }
+           }
 
-    }
+        }
+    });
 
     return obcEnergy;
 }
@@ -35,6 +35,7 @@
 #include <complex>
 
 #include "ReferencePME.h"
+#include "ReferenceParallelLoop.h"
 #include "SimTKOpenMMRealType.h"
 
 #ifdef _MSC_VER
@@ -91,6 +92,8 @@ struct pme
      */
 
     double       epsilon_r;             /* Dielectric coefficient to use, typically 1.0 */
+
+    ThreadPool*  threads;               /* Threads to use for the per-atom and per-frequency loops, or NULL */
 };
 
 
@@ -276,7 +279,9 @@ pme_update_grid_index_and_fraction(pme_t    pme,
  * In practice, it might help to require order=4 for the cuda port.
  */
 static void
-pme_update_bsplines(pme_t    pme)
+pme_update_bsplines_range(pme_t    pme,
+                          int      start,
+                          int      end)
 {
     int       i,j,k,l;
     int       order;
@@ -286,7 +291,7 @@ pme_update_bsplines(pme_t    pme)
 
     order = pme->order;
 
-    for (i=0; (i<pme->natoms); i++)
+    for (i=start; (i<end); i++)
     {
         for (j=0; j<3; j++)
         {
@@ -331,6 +336,16 @@ pme_update_bsplines(pme_t    pme)
 }
 
 
+static void
+pme_update_bsplines(pme_t    pme)
+{
+    /* Each atom is independent, so the atoms can be divided between threads */
+    ReferenceParallelLoop::execute(pme->threads, pme->natoms, [&] (int threadIndex, int start, int end) {
+        pme_update_bsplines_range(pme, start, end);
+    });
+}
+
+
 static void
 pme_grid_spread_charge(pme_t pme, const vector<double>& charges)
 {
@@ -411,10 +426,12 @@ pme_grid_spread_charge(pme_t pme, const vector<double>& charges)
 
 
 static void
-pme_reciprocal_convolution(pme_t     pme,
-                           const Vec3 periodicBoxVectors[3],
-                           const Vec3 recipBoxVectors[3],
-                           double *  energy)
+pme_reciprocal_convolution_range(pme_t     pme,
+                                 const Vec3 periodicBoxVectors[3],
+                                 const Vec3 recipBoxVectors[3],
+                                 int       kxstart,
+                                 int       kxend,
+                                 double *  planeEnergy)
 {
     int kx,ky,kz;
     int nx,ny,nz;
@@ -441,7 +458,6 @@ pme_reciprocal_convolution(pme_t     pme,
     factor = M_PI*M_PI/(pme->ewaldcoeff*pme->ewaldcoeff);
     boxfactor = M_PI*periodicBoxVectors[0][0]*periodicBoxVectors[1][1]*periodicBoxVectors[2][2];
 
-    esum = 0;
     virxx = 0;
     virxy = 0;
     virxz = 0;
@@ -453,8 +469,10 @@ pme_reciprocal_convolution(pme_t     pme,
     maxky = (ny+1)/2;
     maxkz = (nz+1)/2;
 
-    for (kx=0;kx<nx;kx++)
+    for (kx=kxstart;kx<kxend;kx++)
     {
+        esum = 0;
+
         /* Calculate frequency. Grid indices in the upper half correspond to negative frequencies! */
         mx  = (kx<maxkx) ? kx : (kx-nx);
         mhx = mx*recipBoxVectors[0][0];
@@ -511,18 +529,18 @@ pme_reciprocal_convolution(pme_t     pme,
                 esum     += ets2;
             }
         }
+        planeEnergy[kx] = esum;
     }
-
-    /* The factor 0.5 is nothing special, but it is better to have it here than inside the loop :-) */
-    *energy = 0.5*esum;
 }
 
 
 static void
-dpme_reciprocal_convolution(pme_t pme,
-                           const Vec3 periodicBoxVectors[3],
-                           const Vec3 recipBoxVectors[3],
-                           double* energy)
+dpme_reciprocal_convolution_range(pme_t pme,
+                                  const Vec3 periodicBoxVectors[3],
+                                  const Vec3 recipBoxVectors[3],
+                                  int kxstart,
+                                  int kxend,
+                                  double* planeEnergy)
 {
     int kx,ky,kz;
     int nx,ny,nz;
@@ -544,8 +562,6 @@ dpme_reciprocal_convolution(pme_t pme,
 
     boxfactor = -2*M_PI*sqrt(M_PI) / (6.0*periodicBoxVectors[0][0]*periodicBoxVectors[1][1]*periodicBoxVectors[2][2]);
 
-    esum = 0;
-
     maxkx = (nx+1)/2;
     maxky = (ny+1)/2;
     maxkz = (nz+1)/2;
@@ -556,8 +572,10 @@ dpme_reciprocal_convolution(pme_t pme,
     double fac3 = -2.0*pme->ewaldcoeff*M_PI*M_PI;
     double b, m, m3, expfac, expterm, erfcterm;
 
-    for (kx=0;kx<nx;kx++)
+    for (kx=kxstart;kx<kxend;kx++)
     {
+        esum = 0;
+
         /* Calculate frequency. Grid indices in the upper half correspond to negative frequencies! */
         mx  = ((kx<maxkx) ? kx : (kx-nx));
         mhx = mx*recipBoxVectors[0][0];
@@ -612,17 +630,43 @@ dpme_reciprocal_convolution(pme_t pme,
                 esum     += ets2;
             }
         }
+        planeEnergy[kx] = esum;
     }
-    // Remember the C6 energy is attractive, hence the negative sign.
+}
+
+
+typedef void (*convolution_range_t)(pme_t, const Vec3[3], const Vec3[3], int, int, double*);
+
+static void
+pme_parallel_convolution(pme_t      pme,
+                         const Vec3 periodicBoxVectors[3],
+                         const Vec3 recipBoxVectors[3],
+                         double *   energy,
+                         convolution_range_t convolution)
+{
+    /* Every plane of constant kx is independent.  Summing the energy of each plane separately, then
+     * adding them in order, makes the result independent of how the planes are divided between threads.
+     */
+    vector<double> planeEnergy(pme->ngrid[0]);
+    ReferenceParallelLoop::execute(pme->threads, pme->ngrid[0], [&] (int threadIndex, int start, int end) {
+        convolution(pme, periodicBoxVectors, recipBoxVectors, start, end, planeEnergy.data());
+    });
+    double esum = 0;
+    for (double e : planeEnergy)
+        esum += e;
+
+    /* The factor 0.5 is nothing special, but it is better to have it here than inside the loop :-) */
     *energy = 0.5*esum;
 }
 
 
 static void
-pme_grid_interpolate_force(pme_t pme,
-                           const Vec3 recipBoxVectors[3],
-                           const vector<double>& charges,
-                           vector<Vec3>& forces)
+pme_grid_interpolate_force_range(pme_t pme,
+                                 const Vec3 recipBoxVectors[3],
+                                 const vector<double>& charges,
+                                 vector<Vec3>& forces,
+                                 int start,
+                                 int end)
 {
     int       i;
     int       ix,iy,iz;
@@ -651,7 +695,7 @@ pme_grid_interpolate_force(pme_t pme,
 
     /* This is almost identical to the charge spreading routine! */
 
-    for (i=0;i<pme->natoms;i++)
+    for (i=start;i<end;i++)
     {
         fx = fy = fz = 0;
 
@@ -717,6 +761,19 @@ pme_grid_interpolate_force(pme_t pme,
 }
 
 
+static void
+pme_grid_interpolate_force(pme_t pme,
+                           const Vec3 recipBoxVectors[3],
+                           const vector<double>& charges,
+                           vector<Vec3>& forces)
+{
+    /* Each atom only reads the grid and writes its own force, so the atoms can be divided between threads */
+    ReferenceParallelLoop::execute(pme->threads, pme->natoms, [&] (int threadIndex, int start, int end) {
+        pme_grid_interpolate_force_range(pme, recipBoxVectors, charges, forces, start, end);
+    });
+}
+
+
 
 /* EXPORTED ROUTINES */
 
@@ -737,6 +794,7 @@ pme_init(pme_t *       ppme,
     pme->epsilon_r   = epsilon_r;
     pme->ewaldcoeff  = ewaldcoeff;
     pme->natoms      = natoms;
+    pme->threads     = NULL;
 
     for (d=0;d<3;d++)
     {
@@ -800,7 +858,7 @@ int pme_exec(pme_t       pme,
     pocketfft::c2c(shape, stride, stride, axes, true, pme->grid, pme->grid, 1.0, 0);
 
     /* solve in k-space */
-    pme_reciprocal_convolution(pme,periodicBoxVectors,recipBoxVectors,energy);
+    pme_parallel_convolution(pme,periodicBoxVectors,recipBoxVectors,energy,pme_reciprocal_convolution_range);
 
     /* do 3d-invfft */
     pocketfft::c2c(shape, stride, stride, axes, false, pme->grid, pme->grid, 1.0, 0);
@@ -849,7 +907,7 @@ int pme_exec_dpme(pme_t       pme,
     pocketfft::c2c(shape, stride, stride, axes, true, pme->grid, pme->grid, 1.0, 0);
 
     /* solve in k-space */
-    dpme_reciprocal_convolution(pme,periodicBoxVectors,recipBoxVectors,energy);
+    pme_parallel_convolution(pme,periodicBoxVectors,recipBoxVectors,energy,dpme_reciprocal_convolution_range);
 
     /* do 3d-invfft */
     pocketfft::c2c(shape, stride, stride, axes, false, pme->grid, pme->grid, 1.0, 0);
@@ -861,6 +919,16 @@ int pme_exec_dpme(pme_t       pme,
 }
 
 
+int
+pme_set_thread_pool(pme_t    pme,
+                    ThreadPool* threads)
+{
+    pme->threads = threads;
+
+    return 0;
+}
+
+
 int
 pme_destroy(pme_t    pme)
 {
@@ -0,0 +1,110 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceParallelLoop.h"
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Get the range of indices in one block of a loop.
+ */
+static void getBlockRange(int block, int numBlocks, int numIndices, int& start, int& end) {
+    start = (int) (((long long) block*numIndices)/numBlocks);
+    end = (int) (((long long) (block+1)*numIndices)/numBlocks);
+}
+
+/**
+ * Get the number of blocks to divide a loop into.  Using several blocks per thread balances the
+ * load for loops whose iterations vary in cost, such as the outer loop over a triangle of pairs.
+ */
+static int getNumBlocks(int numThreads, int numIndices) {
+    return min(numIndices, 8*numThreads);
+}
+
+int ReferenceParallelLoop::getNumThreads(ThreadPool* threads) {
+    return (threads == NULL ? 1 : threads->getNumThreads());
+}
+
+void ReferenceParallelLoop::execute(ThreadPool* threads, int numIndices, const Body& body) {
+    int numThreads = getNumThreads(threads);
+    if (numThreads == 1 || numIndices < 2) {
+        body(0, 0, numIndices);
+        return;
+    }
+    int numBlocks = getNumBlocks(numThreads, numIndices);
+    threads->execute([&] (ThreadPool& pool, int threadIndex) {
+        for (int block = threadIndex; block < numBlocks; block += numThreads) {
+            int start, end;
+            getBlockRange(block, numBlocks, numIndices, start, end);
+            body(threadIndex, start, end);
+        }
+    });
+    threads->waitForThreads();
+}
+
+void ReferenceParallelLoop::execute(ThreadPool* threads, int numIndices, vector<Vec3>& forces, double* totalEnergy,
+                                    double* derivs, int numDerivs, const AccumulatingBody& body) {
+    int numThreads = getNumThreads(threads);
+    if (numThreads == 1 || numIndices < 2) {
+        body(0, 0, numIndices, forces, totalEnergy, derivs);
+        return;
+    }
+    int numBlocks = getNumBlocks(numThreads, numIndices);
+    vector<vector<Vec3> > threadForces(numThreads);
+    vector<double> threadEnergy(numThreads, 0.0);
+    vector<vector<double> > threadDerivs(numThreads);
+    threads->execute([&] (ThreadPool& pool, int threadIndex) {
+        threadForces[threadIndex].resize(forces.size(), Vec3());
+        if (derivs != NULL)
+            threadDerivs[threadIndex].resize(numDerivs, 0.0);
+        double* energy = (totalEnergy == NULL ? NULL : &threadEnergy[threadIndex]);
+        double* d = (derivs == NULL ? NULL : threadDerivs[threadIndex].data());
+        for (int block = threadIndex; block < numBlocks; block += numThreads) {
+            int start, end;
+            getBlockRange(block, numBlocks, numIndices, start, end);
+            body(threadIndex, start, end, threadForces[threadIndex], energy, d);
+        }
+    });
+    threads->waitForThreads();
+
+    // Sum the contributions from all threads in a fixed order.
+
+    for (int i = 0; i < numThreads; i++) {
+        for (int j = 0; j < forces.size(); j++)
+            forces[j] += threadForces[i][j];
+        if (totalEnergy != NULL)
+            *totalEnergy += threadEnergy[i];
+        if (derivs != NULL)
+            for (int j = 0; j < numDerivs; j++)
+                derivs[j] += threadDerivs[i][j];
+    }
+}
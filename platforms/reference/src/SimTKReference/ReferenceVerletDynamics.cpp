@@ -60,6 +60,54 @@ ReferenceVerletDynamics::ReferenceVerletDynamics(int numberOfAtoms, double delta
 ReferenceVerletDynamics::~ReferenceVerletDynamics() {
 }
 
+/**---------------------------------------------------------------------------------------
+
+   First update: compute the new velocities and the unconstrained positions
+
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param velocities          velocities
+   @param forces              forces
+   @param inverseMasses       inverse atom masses
+   @param xPrime              xPrime
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceVerletDynamics::updatePart1(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                          vector<Vec3>& forces, vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+   for (int i = 0; i < numberOfAtoms; ++i) {
+       if (inverseMasses[i] != 0.0)
+           for (int j = 0; j < 3; ++j) {
+               velocities[i][j] += inverseMasses[i]*forces[i][j]*getDeltaT();
+               xPrime[i][j] = atomCoordinates[i][j] + velocities[i][j]*getDeltaT();
+           }
+   }
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Second update: compute velocities from the constrained positions and store the positions
+
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param velocities          velocities
+   @param inverseMasses       inverse atom masses
+   @param xPrime              xPrime
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceVerletDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                          vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+   double velocityScale = static_cast<double>(1.0/getDeltaT());
+   for (int i = 0; i < numberOfAtoms; ++i) {
+       if (inverseMasses[i] != 0.0)
+           for (int j = 0; j < 3; ++j) {
+               velocities[i][j] = velocityScale*(xPrime[i][j] - atomCoordinates[i][j]);
+               atomCoordinates[i][j] = xPrime[i][j];
+           }
+   }
+}
+
 /**---------------------------------------------------------------------------------------
 
    Update -- driver routine for performing Verlet dynamics update of coordinates
@@ -92,28 +140,14 @@ void ReferenceVerletDynamics::update(const OpenMM::System& system, vector<Vec3>&
    
    // Perform the integration.
    
-   for (int i = 0; i < numberOfAtoms; ++i) {
-       if (masses[i] != 0.0)
-           for (int j = 0; j < 3; ++j) {
-               velocities[i][j] += inverseMasses[i]*forces[i][j]*getDeltaT();
-               xPrime[i][j] = atomCoordinates[i][j] + velocities[i][j]*getDeltaT();
-           }
-   }
+   updatePart1(numberOfAtoms, atomCoordinates, velocities, forces, inverseMasses, xPrime);
    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
    if (referenceConstraintAlgorithm)
       referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
    
    // Update the positions and velocities.
    
-   double velocityScale = static_cast<double>(1.0/getDeltaT());
-   for (int i = 0; i < numberOfAtoms; ++i) {
-       if (masses[i] != 0.0)
-           for (int j = 0; j < 3; ++j) {
-               velocities[i][j] = velocityScale*(xPrime[i][j] - atomCoordinates[i][j]);
-               atomCoordinates[i][j] = xPrime[i][j];
-           }
-   }
-
-   ReferenceVirtualSites::computePositions(system, atomCoordinates);
+   updatePart2(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+   computeVirtualSites(system, atomCoordinates);
    incrementTimeStep();
 }
@@ -71,27 +71,14 @@ void ReferenceVirtualSites::computePositions(const OpenMM::System& system, vecto
                 
                 const LocalCoordinatesSite& site = dynamic_cast<const LocalCoordinatesSite&>(system.getVirtualSite(i));
                 int numParticles = site.getNumParticles();
+                vector<int> particles(numParticles);
                 vector<double> originWeights, xWeights, yWeights;
+                for (int j = 0; j < numParticles; j++)
+                    particles[j] = site.getParticle(j);
                 site.getOriginWeights(originWeights);
                 site.getXWeights(xWeights);
                 site.getYWeights(yWeights);
-                Vec3 origin, xdir, ydir;
-                for (int j = 0; j < numParticles; j++) {
-                    Vec3 pos = atomCoordinates[site.getParticle(j)];
-                    origin += pos*originWeights[j];
-                    xdir += pos*xWeights[j];
-                    ydir += pos*yWeights[j];
-                }
-                Vec3 localPosition = site.getLocalPosition();
-                Vec3 zdir = xdir.cross(ydir);
-                double normXdir = sqrt(xdir.dot(xdir));
-                double normZdir = sqrt(zdir.dot(zdir));
-                if (normXdir > 0.0)
-                    xdir /= normXdir;
-                if (normZdir > 0.0)
-                    zdir /= normZdir;
-                ydir = zdir.cross(xdir);
-                atomCoordinates[i] = origin + xdir*localPosition[0] + ydir*localPosition[1] + zdir*localPosition[2];
+                atomCoordinates[i] = computeLocalCoordinatesPosition(numParticles, &particles[0], &originWeights[0], &xWeights[0], &yWeights[0], site.getLocalPosition(), atomCoordinates);
             }
         }
 }
@@ -142,52 +129,81 @@ void ReferenceVirtualSites::distributeForces(const OpenMM::System& system, const
                 
                 const LocalCoordinatesSite& site = dynamic_cast<const LocalCoordinatesSite&>(system.getVirtualSite(i));
                 int numParticles = site.getNumParticles();
+                vector<int> particles(numParticles);
                 vector<double> originWeights, wx, wy;
+                for (int j = 0; j < numParticles; j++)
+                    particles[j] = site.getParticle(j);
                 site.getOriginWeights(originWeights);
                 site.getXWeights(wx);
                 site.getYWeights(wy);
-                Vec3 xdir, ydir;
-                for (int j = 0; j < numParticles; j++) {
-                    Vec3 pos = atomCoordinates[site.getParticle(j)];
-                    xdir += pos*wx[j];
-                    ydir += pos*wy[j];
-                }
-                Vec3 localPosition = site.getLocalPosition();
-                Vec3 zdir = xdir.cross(ydir);
-                double normXdir = sqrt(xdir.dot(xdir));
-                double normZdir = sqrt(zdir.dot(zdir));
-                double invNormXdir = (normXdir > 0.0 ? 1.0/normXdir : 0.0);
-                double invNormZdir = (normZdir > 0.0 ? 1.0/normZdir : 0.0);
-                Vec3 dx = xdir*invNormXdir;
-                Vec3 dz = zdir*invNormZdir;
-                Vec3 dy = dz.cross(dx);
-                
-                // The derivatives for this case are very complicated.  They were computed with SymPy then simplified by hand.
-                
-                vector<double> wxScaled(numParticles);
-                for (int j = 0; j < numParticles; j++)
-                    wxScaled[j] = wx[j]*invNormXdir;
-                Vec3 fp1 = localPosition*f[0];
-                Vec3 fp2 = localPosition*f[1];
-                Vec3 fp3 = localPosition*f[2];
-                for (int j = 0; j < numParticles; j++) {
-                    double t1 = (wx[j]*ydir[0]-wy[j]*xdir[0])*invNormZdir;
-                    double t2 = (wx[j]*ydir[1]-wy[j]*xdir[1])*invNormZdir;
-                    double t3 = (wx[j]*ydir[2]-wy[j]*xdir[2])*invNormZdir;
-                    double sx = t3*dz[1]-t2*dz[2];
-                    double sy = t1*dz[2]-t3*dz[0];
-                    double sz = t2*dz[0]-t1*dz[1];
-                    int p = site.getParticle(j);
-                    forces[p][0] += fp1[0]*wxScaled[j]*(1-dx[0]*dx[0]) + fp1[2]*(dz[0]*sx   ) + fp1[1]*((-dx[0]*dy[0]      )*wxScaled[j] + dy[0]*sx - dx[1]*t2 - dx[2]*t3) + f[0]*originWeights[j];
-                    forces[p][1] += fp1[0]*wxScaled[j]*( -dx[0]*dx[1]) + fp1[2]*(dz[0]*sy+t3) + fp1[1]*((-dx[1]*dy[0]-dz[2])*wxScaled[j] + dy[0]*sy + dx[1]*t1);
-                    forces[p][2] += fp1[0]*wxScaled[j]*( -dx[0]*dx[2]) + fp1[2]*(dz[0]*sz-t2) + fp1[1]*((-dx[2]*dy[0]+dz[1])*wxScaled[j] + dy[0]*sz + dx[2]*t1);
-                    forces[p][0] += fp2[0]*wxScaled[j]*( -dx[1]*dx[0]) + fp2[2]*(dz[1]*sx-t3) - fp2[1]*(( dx[0]*dy[1]-dz[2])*wxScaled[j] - dy[1]*sx - dx[0]*t2);
-                    forces[p][1] += fp2[0]*wxScaled[j]*(1-dx[1]*dx[1]) + fp2[2]*(dz[1]*sy   ) - fp2[1]*(( dx[1]*dy[1]      )*wxScaled[j] - dy[1]*sy + dx[0]*t1 + dx[2]*t3) + f[1]*originWeights[j];
-                    forces[p][2] += fp2[0]*wxScaled[j]*( -dx[1]*dx[2]) + fp2[2]*(dz[1]*sz+t1) - fp2[1]*(( dx[2]*dy[1]+dz[0])*wxScaled[j] - dy[1]*sz - dx[2]*t2);
-                    forces[p][0] += fp3[0]*wxScaled[j]*( -dx[2]*dx[0]) + fp3[2]*(dz[2]*sx+t2) + fp3[1]*((-dx[0]*dy[2]-dz[1])*wxScaled[j] + dy[2]*sx + dx[0]*t3);
-                    forces[p][1] += fp3[0]*wxScaled[j]*( -dx[2]*dx[1]) + fp3[2]*(dz[2]*sy-t1) + fp3[1]*((-dx[1]*dy[2]+dz[0])*wxScaled[j] + dy[2]*sy + dx[1]*t3);
-                    forces[p][2] += fp3[0]*wxScaled[j]*(1-dx[2]*dx[2]) + fp3[2]*(dz[2]*sz   ) + fp3[1]*((-dx[2]*dy[2]      )*wxScaled[j] + dy[2]*sz - dx[0]*t1 - dx[1]*t2) + f[2]*originWeights[j];
-                }
+                distributeLocalCoordinatesForce(f, numParticles, &particles[0], &originWeights[0], &wx[0], &wy[0], site.getLocalPosition(), atomCoordinates, forces);
            }
         }
 }
+
+void ReferenceVirtualSites::computeSitePositions(const OpenMM::System& system, vector<OpenMM::Vec3>& atomCoordinates) {
+    computePositions(system, atomCoordinates);
+}
+
+Vec3 ReferenceVirtualSites::computeLocalCoordinatesPosition(int numParticles, const int* particles, const double* originWeights, const double* xWeights,
+        const double* yWeights, Vec3 localPosition, const vector<Vec3>& atomCoordinates) {
+    Vec3 origin, xdir, ydir;
+    for (int j = 0; j < numParticles; j++) {
+        Vec3 pos = atomCoordinates[particles[j]];
+        origin += pos*originWeights[j];
+        xdir += pos*xWeights[j];
+        ydir += pos*yWeights[j];
+    }
+    Vec3 zdir = xdir.cross(ydir);
+    double normXdir = sqrt(xdir.dot(xdir));
+    double normZdir = sqrt(zdir.dot(zdir));
+    if (normXdir > 0.0)
+        xdir /= normXdir;
+    if (normZdir > 0.0)
+        zdir /= normZdir;
+    ydir = zdir.cross(xdir);
+    return origin + xdir*localPosition[0] + ydir*localPosition[1] + zdir*localPosition[2];
+}
+
+void ReferenceVirtualSites::distributeLocalCoordinatesForce(Vec3 f, int numParticles, const int* particles, const double* originWeights, const double* wx,
+        const double* wy, Vec3 localPosition, const vector<Vec3>& atomCoordinates, vector<Vec3>& forces) {
+    Vec3 xdir, ydir;
+    for (int j = 0; j < numParticles; j++) {
+        Vec3 pos = atomCoordinates[particles[j]];
+        xdir += pos*wx[j];
+        ydir += pos*wy[j];
+    }
+    Vec3 zdir = xdir.cross(ydir);
+    double normXdir = sqrt(xdir.dot(xdir));
+    double normZdir = sqrt(zdir.dot(zdir));
+    double invNormXdir = (normXdir > 0.0 ? 1.0/normXdir : 0.0);
+    double invNormZdir = (normZdir > 0.0 ? 1.0/normZdir : 0.0);
+    Vec3 dx = xdir*invNormXdir;
+    Vec3 dz = zdir*invNormZdir;
+    Vec3 dy = dz.cross(dx);
+    
+    // The derivatives for this case are very complicated.  They were computed with SymPy then simplified by hand.
+    
+    Vec3 fp1 = localPosition*f[0];
+    Vec3 fp2 = localPosition*f[1];
+    Vec3 fp3 = localPosition*f[2];
+    for (int j = 0; j < numParticles; j++) {
+        double t1 = (wx[j]*ydir[0]-wy[j]*xdir[0])*invNormZdir;
+        double t2 = (wx[j]*ydir[1]-wy[j]*xdir[1])*invNormZdir;
+        double t3 = (wx[j]*ydir[2]-wy[j]*xdir[2])*invNormZdir;
+        double sx = t3*dz[1]-t2*dz[2];
+        double sy = t1*dz[2]-t3*dz[0];
+        double sz = t2*dz[0]-t1*dz[1];
+        double wxScaled = wx[j]*invNormXdir;
+        int p = particles[j];
+        forces[p][0] += fp1[0]*wxScaled*(1-dx[0]*dx[0]) + fp1[2]*(dz[0]*sx   ) + fp1[1]*((-dx[0]*dy[0]      )*wxScaled + dy[0]*sx - dx[1]*t2 - dx[2]*t3) + f[0]*originWeights[j];
+        forces[p][1] += fp1[0]*wxScaled*( -dx[0]*dx[1]) + fp1[2]*(dz[0]*sy+t3) + fp1[1]*((-dx[1]*dy[0]-dz[2])*wxScaled + dy[0]*sy + dx[1]*t1);
+        forces[p][2] += fp1[0]*wxScaled*( -dx[0]*dx[2]) + fp1[2]*(dz[0]*sz-t2) + fp1[1]*((-dx[2]*dy[0]+dz[1])*wxScaled + dy[0]*sz + dx[2]*t1);
+        forces[p][0] += fp2[0]*wxScaled*( -dx[1]*dx[0]) + fp2[2]*(dz[1]*sx-t3) - fp2[1]*(( dx[0]*dy[1]-dz[2])*wxScaled - dy[1]*sx - dx[0]*t2);
+        forces[p][1] += fp2[0]*wxScaled*(1-dx[1]*dx[1]) + fp2[2]*(dz[1]*sy   ) - fp2[1]*(( dx[1]*dy[1]      )*wxScaled - dy[1]*sy + dx[0]*t1 + dx[2]*t3) + f[1]*originWeights[j];
+        forces[p][2] += fp2[0]*wxScaled*( -dx[1]*dx[2]) + fp2[2]*(dz[1]*sz+t1) - fp2[1]*(( dx[2]*dy[1]+dz[0])*wxScaled - dy[1]*sz - dx[2]*t2);
+        forces[p][0] += fp3[0]*wxScaled*( -dx[2]*dx[0]) + fp3[2]*(dz[2]*sx+t2) + fp3[1]*((-dx[0]*dy[2]-dz[1])*wxScaled + dy[2]*sx + dx[0]*t3);
+        forces[p][1] += fp3[0]*wxScaled*( -dx[2]*dx[1]) + fp3[2]*(dz[2]*sy-t1) + fp3[1]*((-dx[1]*dy[2]+dz[0])*wxScaled + dy[2]*sy + dx[1]*t3);
+        forces[p][2] += fp3[0]*wxScaled*(1-dx[2]*dx[2]) + fp3[2]*(dz[2]*sz   ) + fp3[1]*((-dx[2]*dy[2]      )*wxScaled + dy[2]*sz - dx[0]*t1 - dx[1]*t2) + f[2]*originWeights[j];
+    }
+}
@@ -32,5 +32,65 @@
 #include "ReferenceTests.h"
 #include "TestEwald.h"
 
+void testPMEOrder() {
+    // Create a cloud of random point charges.
+
+    const int numParticles = 51;
+    const double boxWidth = 3.0;
+    const double cutoff = 1.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxWidth, 0, 0), Vec3(0, boxWidth, 0), Vec3(0, 0, boxWidth));
+    NonbondedForce* force = new NonbondedForce();
+    system.addForce(force);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(-1.0+i*2.0/(numParticles-1), 1.0, 0.0);
+        positions[i] = Vec3(boxWidth*genrand_real2(sfmt), boxWidth*genrand_real2(sfmt), boxWidth*genrand_real2(sfmt));
+    }
+    force->setCutoffDistance(cutoff);
+
+    // Compute accurate reference forces with Ewald summation.
+
+    force->setNonbondedMethod(NonbondedForce::Ewald);
+    force->setEwaldErrorTolerance(1e-6);
+    vector<Vec3> refForces;
+    {
+        VerletIntegrator integrator(0.01);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        refForces = context.getState(State::Forces).getForces();
+    }
+    double norm = 0.0;
+    for (int i = 0; i < numParticles; i++)
+        norm += refForces[i].dot(refForces[i]);
+    norm = sqrt(norm);
+
+    // Use PME with a grid coarse enough that the difference comes almost entirely from
+    // interpolation.  Higher orders should be more accurate.
+
+    force->setNonbondedMethod(NonbondedForce::PME);
+    force->setPMEParameters(3.5, 32, 32, 32);
+    double previousError = 1e10;
+    for (int order = 4; order <= 6; order++) {
+        force->setPMEOrder(order);
+        VerletIntegrator integrator(0.01);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        vector<Vec3> forces = context.getState(State::Forces).getForces();
+        double diff = 0.0;
+        for (int i = 0; i < numParticles; i++) {
+            Vec3 delta = refForces[i]-forces[i];
+            diff += delta.dot(delta);
+        }
+        double error = sqrt(diff)/norm;
+        ASSERT(error < previousError);
+        previousError = error;
+    }
+}
+
 void runPlatformTests() {
+    testPMEOrder();
 }
@@ -32,6 +32,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "ReferenceNeighborList.h"
 #include "sfmt/SFMT.h"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
@@ -132,12 +133,72 @@ void testTriclinic() {
     verifyNeighborList(neighborList, numParticles, particleList, periodicBoxVectors, cutoff);
 }
 
+void testCompactNeighborList() {
+    const int numParticles = 500;
+    const double cutoff = 3.0;
+    const double padding = 0.5;
+    Vec3 periodicBoxVectors[3];
+    periodicBoxVectors[0] = Vec3(20, 0, 0);
+    periodicBoxVectors[1] = Vec3(0, 15, 0);
+    periodicBoxVectors[2] = Vec3(0, 0, 22);
+    vector<Vec3> particleList(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+
+    for (int i = 0; i <numParticles; i++) {
+        particleList[i][0] = genrand_real2(sfmt)*periodicBoxVectors[0][0];
+        particleList[i][1] = genrand_real2(sfmt)*periodicBoxVectors[1][1];
+        particleList[i][2] = genrand_real2(sfmt)*periodicBoxVectors[2][2];
+    }
+    vector<set<int> > exclusions(numParticles);
+    CompactNeighborList list(cutoff, padding, true);
+    ASSERT(list.update(particleList, periodicBoxVectors));
+    ASSERT_EQUAL(numParticles, list.getNumAtoms());
+    NeighborList neighborList;
+    list.getPairs(neighborList, particleList, exclusions, periodicBoxVectors, cutoff);
+    verifyNeighborList(neighborList, numParticles, particleList, periodicBoxVectors, cutoff);
+
+    // Small displacements should not cause it to be rebuilt, but the pairs should still be correct.
+
+    for (int i = 0; i < numParticles; i++)
+        particleList[i] += Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.2;
+    ASSERT(!list.update(particleList, periodicBoxVectors));
+    ASSERT_EQUAL(1, list.getNumBuilds());
+    list.getPairs(neighborList, particleList, exclusions, periodicBoxVectors, cutoff);
+    verifyNeighborList(neighborList, numParticles, particleList, periodicBoxVectors, cutoff);
+
+    // Moving one particle far enough should cause a rebuild.
+
+    particleList[0] += Vec3(1.0, 0, 0);
+    ASSERT(list.update(particleList, periodicBoxVectors));
+    list.getPairs(neighborList, particleList, exclusions, periodicBoxVectors, cutoff);
+    verifyNeighborList(neighborList, numParticles, particleList, periodicBoxVectors, cutoff);
+
+    // Each atom's neighbors should be sorted and symmetric, and exclusions should be omitted from the pairs.
+
+    for (int i = 0; i < numParticles; i++) {
+        const AtomIndex* neighbors = list.getNeighbors(i);
+        for (int j = 1; j < list.getNumNeighbors(i); j++)
+            ASSERT(neighbors[j-1] < neighbors[j]);
+        for (int j = 0; j < list.getNumNeighbors(i); j++) {
+            const AtomIndex* other = list.getNeighbors(neighbors[j]);
+            ASSERT(binary_search(other, other+list.getNumNeighbors(neighbors[j]), (AtomIndex) i));
+        }
+    }
+    int numPairs = neighborList.size();
+    exclusions[neighborList[0].first].insert(neighborList[0].second);
+    exclusions[neighborList[0].second].insert(neighborList[0].first);
+    list.getPairs(neighborList, particleList, exclusions, periodicBoxVectors, cutoff);
+    ASSERT_EQUAL(numPairs-1, neighborList.size());
+}
+
 int main() 
 {
     try {
         testNeighborList();
         testPeriodic();
         testTriclinic();
+        testCompactNeighborList();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,179 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the multithreaded mode of the Reference platform, by checking that it produces the
+ * same results as running on a single thread.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomNonbondedForce.h"
+#include "openmm/GBSAOBCForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "ReferencePlatform.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 200;
+const double boxSize = 3.0;
+
+System* createSystem(vector<Vec3>& positions) {
+    System* system = new System();
+    system->setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    positions.clear();
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(1.0);
+        positions.push_back(Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*boxSize);
+    }
+    return system;
+}
+
+/**
+ * Compute the state of a System with the specified number of threads.
+ */
+State computeState(const System& system, const vector<Vec3>& positions, const string& threads) {
+    ReferencePlatform platform;
+    VerletIntegrator integrator(0.001);
+    map<string, string> properties;
+    properties[ReferencePlatform::ReferenceThreads()] = threads;
+    Context context(system, integrator, platform, properties);
+    ASSERT_EQUAL(threads, platform.getPropertyValue(context, ReferencePlatform::ReferenceThreads()));
+    context.setPositions(positions);
+    return context.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+}
+
+void compareThreads(const System& system, const vector<Vec3>& positions) {
+    State state1 = computeState(system, positions, "1");
+    for (string threads : {"2", "3"}) {
+        State state2 = computeState(system, positions, threads);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-10);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-10);
+        for (auto& deriv : state1.getEnergyParameterDerivatives())
+            ASSERT_EQUAL_TOL(deriv.second, state2.getEnergyParameterDerivatives().at(deriv.first), 1e-10);
+    }
+}
+
+void testNonbonded(NonbondedForce::NonbondedMethod method) {
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    for (int i = 0; i < numParticles; i++)
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+    for (int i = 0; i < numParticles; i += 2)
+        nonbonded->addException(i, i+1, 0.1, 0.3, 0.2);
+    system->addForce(nonbonded);
+    compareThreads(*system, positions);
+    delete system;
+}
+
+void testCustomNonbonded(bool useGroups) {
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    CustomNonbondedForce* custom = new CustomNonbondedForce("scale*a1*a2*(r-1.1)^2");
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(1.0);
+    custom->addGlobalParameter("scale", 1.5);
+    custom->addEnergyParameterDerivative("scale");
+    custom->addPerParticleParameter("a");
+    for (int i = 0; i < numParticles; i++)
+        custom->addParticle({1.0+0.01*i});
+    for (int i = 0; i < numParticles; i += 3)
+        custom->addExclusion(i, i+1);
+    if (useGroups) {
+        set<int> set1, set2;
+        for (int i = 0; i < numParticles; i++)
+            (i < numParticles/4 ? set1 : set2).insert(i);
+        custom->addInteractionGroup(set1, set2);
+        custom->addInteractionGroup(set1, set1);
+    }
+    system->addForce(custom);
+    compareThreads(*system, positions);
+    delete system;
+}
+
+void testGBSAOBC() {
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    GBSAOBCForce* gbsa = new GBSAOBCForce();
+    gbsa->setNonbondedMethod(GBSAOBCForce::CutoffPeriodic);
+    gbsa->setCutoffDistance(1.0);
+    for (int i = 0; i < numParticles; i++)
+        gbsa->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.15, 1.0);
+    system->addForce(gbsa);
+    compareThreads(*system, positions);
+    delete system;
+}
+
+void testInvalidThreads() {
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    bool threwException = false;
+    try {
+        computeState(*system, positions, "0");
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    delete system;
+}
+
+int main() {
+    try {
+        testNonbonded(NonbondedForce::NoCutoff);
+        testNonbonded(NonbondedForce::CutoffPeriodic);
+        testNonbonded(NonbondedForce::PME);
+        testCustomNonbonded(false);
+        testCustomNonbonded(true);
+        testGBSAOBC();
+        testInvalidThreads();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
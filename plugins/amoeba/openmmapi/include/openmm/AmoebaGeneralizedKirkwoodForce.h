@@ -153,6 +153,23 @@ public:
      * Set the surface area factor kJ/(nm*nm) used in SASA contribution
      */
     void setSurfaceAreaFactor(double surfaceAreaFactor);
+
+    /**
+     * Get how often the Born radii are recomputed.  See setBornRadiusUpdateInterval() for details.
+     */
+    int getBornRadiusUpdateInterval() const;
+
+    /**
+     * Set how often the Born radii are recomputed.  By default this is 1, so they are recomputed every
+     * time forces are computed.  If it is larger, they are recomputed only on every n'th evaluation,
+     * and the evaluations in between reuse the previous radii.  Computing the radii requires a loop over
+     * all pairs of atoms, and they change slowly as the atoms move, so this can save a significant amount
+     * of time for large molecules.  The forces are no longer exactly consistent with the energy, so it
+     * should be used with care.
+     *
+     * @param interval   the number of force evaluations between updates
+     */
+    void setBornRadiusUpdateInterval(int interval);
     /**
      * Update the per-particle parameters in a Context to match those stored in this Force object.  This method provides
      * an efficient method to update certain parameters in an existing Context without needing to reinitialize it.
@@ -176,7 +193,7 @@ protected:
     ForceImpl* createImpl() const;
 private:
     class ParticleInfo;
-    int includeCavityTerm;
+    int includeCavityTerm, bornRadiusUpdateInterval;
     double solventDielectric, soluteDielectric, dielectricOffset,
            probeRadius, surfaceAreaFactor;
     std::vector<ParticleInfo> particles;
@@ -335,6 +335,30 @@ public:
      */
     void setMutualInducedTargetEpsilon(double inputMutualInducedTargetEpsilon);
 
+    /**
+     * Get how often the mutual induced dipoles are solved for.  See setMutualInducedUpdateInterval()
+     * for details.
+     *
+     * @return the number of force evaluations between solves
+     */
+    int getMutualInducedUpdateInterval() const;
+
+    /**
+     * Set how often the mutual induced dipoles are solved for.  This is only used when the polarization
+     * type is Mutual.  By default it is 1, so the dipoles are converged every time forces are computed.
+     * If it is larger, the dipoles are converged only on every n'th evaluation, and the evaluations in
+     * between reuse the most recently converged dipoles.  The permanent multipole interactions are still
+     * computed every time.
+     *
+     * This is intended for multiple time step integration, where the force group containing this force
+     * is evaluated several times over an outer time step.  Reusing the dipoles makes those evaluations much
+     * cheaper, but the forces are no longer exactly consistent with the energy, so it should be used with
+     * care.
+     *
+     * @param interval   the number of force evaluations between solves
+     */
+    void setMutualInducedUpdateInterval(int interval);
+
     /**
      * Set the coefficients for the mu_0, mu_1, mu_2, ..., mu_n terms in the extrapolation
      * algorithm for induced dipoles.
@@ -450,7 +474,7 @@ private:
     double cutoffDistance;
     double alpha;
     int pmeBSplineOrder, nx, ny, nz;
-    int mutualInducedMaxIterations;
+    int mutualInducedMaxIterations, mutualInducedUpdateInterval;
     std::vector<double> extrapolationCoefficients;
 
     double mutualInducedTargetEpsilon;
@@ -36,7 +36,8 @@
 
 using namespace OpenMM;
 
-AmoebaGeneralizedKirkwoodForce::AmoebaGeneralizedKirkwoodForce() : solventDielectric(78.3), soluteDielectric(1.0), dielectricOffset(0.009), includeCavityTerm(1), probeRadius(0.14) {
+AmoebaGeneralizedKirkwoodForce::AmoebaGeneralizedKirkwoodForce() : solventDielectric(78.3), soluteDielectric(1.0), dielectricOffset(0.009), includeCavityTerm(1), probeRadius(0.14),
+        bornRadiusUpdateInterval(1) {
 
      surfaceAreaFactor = -6.0* 3.1415926535*0.0216*1000.0*0.4184;
 }
@@ -74,6 +75,16 @@ void AmoebaGeneralizedKirkwoodForce::setIncludeCavityTerm(int inputIncludeCavity
     includeCavityTerm = inputIncludeCavityTerm;
 }
 
+int AmoebaGeneralizedKirkwoodForce::getBornRadiusUpdateInterval() const {
+    return bornRadiusUpdateInterval;
+}
+
+void AmoebaGeneralizedKirkwoodForce::setBornRadiusUpdateInterval(int interval) {
+    if (interval < 1)
+        throw OpenMMException("AmoebaGeneralizedKirkwoodForce: the Born radius update interval must be at least 1");
+    bornRadiusUpdateInterval = interval;
+}
+
 double AmoebaGeneralizedKirkwoodForce::getProbeRadius() const {
     return probeRadius;
 }
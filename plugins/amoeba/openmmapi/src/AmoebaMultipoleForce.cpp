@@ -40,7 +40,7 @@ using namespace OpenMM;
 using std::string;
 using std::vector;
 
-AmoebaMultipoleForce::AmoebaMultipoleForce() : nonbondedMethod(NoCutoff), polarizationType(Mutual), pmeBSplineOrder(5), cutoffDistance(1.0), ewaldErrorTol(1e-4), mutualInducedMaxIterations(60),
+AmoebaMultipoleForce::AmoebaMultipoleForce() : nonbondedMethod(NoCutoff), polarizationType(Mutual), pmeBSplineOrder(5), cutoffDistance(1.0), ewaldErrorTol(1e-4), mutualInducedMaxIterations(60), mutualInducedUpdateInterval(1),
                                                mutualInducedTargetEpsilon(1e-5), scalingDistanceCutoff(100.0), electricConstant(ONE_4PI_EPS0), alpha(0.0), nx(0), ny(0), nz(0) {
     extrapolationCoefficients.push_back(-0.154);
     extrapolationCoefficients.push_back(0.017);
@@ -134,6 +134,16 @@ void AmoebaMultipoleForce::setMutualInducedMaxIterations(int inputMutualInducedM
     mutualInducedMaxIterations = inputMutualInducedMaxIterations;
 }
 
+int AmoebaMultipoleForce::getMutualInducedUpdateInterval() const {
+    return mutualInducedUpdateInterval;
+}
+
+void AmoebaMultipoleForce::setMutualInducedUpdateInterval(int interval) {
+    if (interval < 1)
+        throw OpenMMException("AmoebaMultipoleForce: the mutual induced update interval must be at least 1");
+    mutualInducedUpdateInterval = interval;
+}
+
 double AmoebaMultipoleForce::getMutualInducedTargetEpsilon() const {
     return mutualInducedTargetEpsilon;
 }
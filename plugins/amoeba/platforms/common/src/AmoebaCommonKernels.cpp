@@ -43,6 +43,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
 #ifdef _MSC_VER
 #include <windows.h>
 #endif
@@ -69,6 +70,15 @@ static void setPeriodicBoxArgs(ComputeContext& cc, ComputeKernel kernel, int ind
     }
 }
 
+static double binomialCoefficient(int n, int k) {
+    if (k < 0 || k > n)
+        return 0.0;
+    double result = 1.0;
+    for (int i = 1; i <= k; i++)
+        result = result*(n-k+i)/i;
+    return result;
+}
+
 /* -------------------------------------------------------------------------- *
  *                           AmoebaTorsionTorsion                             *
  * -------------------------------------------------------------------------- */
@@ -123,9 +133,11 @@ void CommonCalcAmoebaTorsionTorsionForceKernel::initialize(const System& system,
         force.getTorsionTorsionParameters(startIndex+i, atoms[i][0], atoms[i][1], atoms[i][2], atoms[i][3], atoms[i][4], torsionParamsVec[i].x, torsionParamsVec[i].y);
     torsionParams.upload(torsionParamsVec);
     
-    // Record the grids.
-    
-    vector<mm_float4> gridValuesVec;
+    // Record the grids.  Rather than interpolating the grid values every time a torsion is evaluated, compute
+    // the bicubic coefficients for every patch of every grid once here, the same way CMAPTorsionForce does.
+    // Each patch is stored as four float4s, one for each power of the first angle.
+
+    vector<mm_float4> gridCoefficientsVec;
     vector<mm_float4> gridParamsVec;
     for (int i = 0; i < force.getNumTorsionTorsionGrids(); i++) {
         const TorsionTorsionGrid& initialGrid = force.getTorsionTorsionGrid(i);
@@ -139,24 +151,58 @@ void CommonCalcAmoebaTorsionTorsionForceKernel::initialize(const System& system,
             reordered = true;
         }
         const TorsionTorsionGrid& grid = (reordered ? reorderedGrid : initialGrid);
-        float range = grid[0][grid[0].size()-1][1] - grid[0][0][1];
-        gridParamsVec.push_back(mm_float4(gridValuesVec.size(), grid[0][0][0], range/(grid.size()-1), grid.size()));
-        for (int j = 0; j < grid.size(); j++)
-            for (int k = 0; k < grid[j].size(); k++)
-                gridValuesVec.push_back(mm_float4((float) grid[j][k][2], (float) grid[j][k][3], (float) grid[j][k][4], (float) grid[j][k][5]));
+        double range = grid[0][grid[0].size()-1][1] - grid[0][0][1];
+        double spacing = range/(grid.size()-1);
+        int numPatches = grid.size()-1;
+        gridParamsVec.push_back(mm_float4(gridCoefficientsVec.size(), grid[0][0][0], spacing, numPatches));
+        for (int j = 0; j < numPatches; j++)
+            for (int k = 0; k < numPatches; k++) {
+                // The four corners of the patch, in the order used by TINKER's bicuint: (j,k), (j+1,k), (j+1,k+1), (j,k+1).
+
+                const vector<double>* corners[] = {&grid[j][k], &grid[j+1][k], &grid[j+1][k+1], &grid[j][k+1]};
+                double y[4], y1[4], y2[4], y12[4];
+                for (int m = 0; m < 4; m++) {
+                    y[m] = (*corners[m])[2];
+                    y1[m] = spacing*(*corners[m])[3];
+                    y2[m] = spacing*(*corners[m])[4];
+                    y12[m] = spacing*spacing*(*corners[m])[5];
+                }
+                double c[4][4];
+                c[0][0] = y[0];
+                c[0][1] = y2[0];
+                c[0][2] = 3*(y[3]-y[0]) - (2*y2[0]+y2[3]);
+                c[0][3] = 2*(y[0]-y[3]) + y2[0] + y2[3];
+                c[1][0] = y1[0];
+                c[1][1] = y12[0];
+                c[1][2] = 3*(y1[3]-y1[0]) - (2*y12[0]+y12[3]);
+                c[1][3] = 2*(y1[0]-y1[3]) + y12[0] + y12[3];
+                c[2][0] = 3*(y[1]-y[0]) - (2*y1[0]+y1[1]);
+                c[2][1] = 3*(y2[1]-y2[0]) - (2*y12[0]+y12[1]);
+                c[2][2] = 9*(y[0]-y[1]+y[2]-y[3]) + 6*y1[0] + 3*y1[1] - 3*y1[2] - 6*y1[3] +
+                          6*y2[0] - 6*y2[1] - 3*y2[2] + 3*y2[3] + 4*y12[0] + 2*y12[1] + y12[2] + 2*y12[3];
+                c[2][3] = 6*(y[1]-y[0]+y[3]-y[2]) - 4*y1[0] - 2*y1[1] + 2*y1[2] + 4*y1[3] -
+                          3*y2[0] + 3*y2[1] + 3*y2[2] - 3*y2[3] - 2*y12[0] - y12[1] - y12[2] - 2*y12[3];
+                c[3][0] = 2*(y[0]-y[1]) + y1[0] + y1[1];
+                c[3][1] = 2*(y2[0]-y2[1]) + y12[0] + y12[1];
+                c[3][2] = 6*(y[1]-y[0]+y[3]-y[2]) + 3*(y1[2]+y1[3]-y1[0]-y1[1]) +
+                          2*(2*(y2[1]-y2[0]) + y2[2] - y2[3]) - 2*(y12[0]+y12[1]) - y12[2] - y12[3];
+                c[3][3] = 4*(y[0]-y[1]+y[2]-y[3]) + 2*(y1[0]+y1[1]-y1[2]-y1[3]) +
+                          2*(y2[0]-y2[1]-y2[2]+y2[3]) + y12[0] + y12[1] + y12[2] + y12[3];
+                for (int m = 0; m < 4; m++)
+                    gridCoefficientsVec.push_back(mm_float4((float) c[m][0], (float) c[m][1], (float) c[m][2], (float) c[m][3]));
+            }
     }
-    gridValues.initialize<mm_float4>(cc, gridValuesVec.size(), "torsionTorsionGridValues");
+    gridCoefficients.initialize<mm_float4>(cc, gridCoefficientsVec.size(), "torsionTorsionGridCoefficients");
     gridParams.initialize<mm_float4>(cc, gridParamsVec.size(), "torsionTorsionGridParams");
-    gridValues.upload(gridValuesVec);
+    gridCoefficients.upload(gridCoefficientsVec);
     gridParams.upload(gridParamsVec);
     map<string, string> replacements;
     replacements["APPLY_PERIODIC"] = (force.usesPeriodicBoundaryConditions() ? "1" : "0");
-    replacements["GRID_VALUES"] = cc.getBondedUtilities().addArgument(gridValues, "float4");
+    replacements["GRID_COEFFICIENTS"] = cc.getBondedUtilities().addArgument(gridCoefficients, "float4");
     replacements["GRID_PARAMS"] = cc.getBondedUtilities().addArgument(gridParams, "float4");
     replacements["TORSION_PARAMS"] = cc.getBondedUtilities().addArgument(torsionParams, "int2");
     replacements["RAD_TO_DEG"] = cc.doubleToString(180/M_PI);
     cc.getBondedUtilities().addInteraction(atoms, cc.replaceStrings(CommonAmoebaKernelSources::amoebaTorsionTorsionForce, replacements), force.getForceGroup());
-    cc.getBondedUtilities().addPrefixCode(CommonAmoebaKernelSources::bicubic);
     cc.addForce(new ForceInfo(force));
 }
 
@@ -208,6 +254,19 @@ private:
     const AmoebaMultipoleForce& force;
 };
 
+class CommonCalcAmoebaMultipoleForceKernel::ReorderListener : public ComputeContext::ReorderListener {
+public:
+    ReorderListener(CommonCalcAmoebaMultipoleForceKernel& owner) : owner(owner) {
+    }
+    void execute() {
+        // The previous dipoles are stored in the old order, so they can no longer be used to predict new ones.
+
+        owner.numPredictorDipoles = 0;
+    }
+private:
+    CommonCalcAmoebaMultipoleForceKernel& owner;
+};
+
 CommonCalcAmoebaMultipoleForceKernel::CommonCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const System& system) :
         CalcAmoebaMultipoleForceKernel(name, platform), cc(cc), system(system), hasInitializedScaleFactors(false), multipolesAreValid(false), hasCreatedEvent(false),
         gkKernel(NULL) {
@@ -300,6 +359,30 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         prevErrors.initialize(cc, 3*numMultipoles*MaxPrevDIISDipoles, elementSize, "prevErrors");
         diisMatrix.initialize(cc, MaxPrevDIISDipoles*MaxPrevDIISDipoles, elementSize, "diisMatrix");
         diisCoefficients.initialize(cc, MaxPrevDIISDipoles+1, sizeof(float), "diisMatrix");
+        cgDipole.initialize(cc, 3*paddedNumAtoms, elementSize, "cgDipole");
+        cgDipolePolar.initialize(cc, 3*paddedNumAtoms, elementSize, "cgDipolePolar");
+        cgResidual.initialize(cc, 3*paddedNumAtoms, elementSize, "cgResidual");
+        cgResidualPolar.initialize(cc, 3*paddedNumAtoms, elementSize, "cgResidualPolar");
+        cgPartialSums.initialize(cc, cc.getNumThreadBlocks(), 2*elementSize, "cgPartialSums");
+        cgScalars.initialize(cc, 6, elementSize, "cgScalars");
+        predictorDipoles.initialize(cc, 3*numMultipoles*MaxPrevASPCDipoles, elementSize, "predictorDipoles");
+        predictorDipolesPolar.initialize(cc, 3*numMultipoles*MaxPrevASPCDipoles, elementSize, "predictorDipolesPolar");
+
+        // Row n-1 of the table holds the coefficients of Kolafa's always stable predictor,
+        // J. Comput. Chem. 25, 335 (2004), to use when n previous dipoles are available.
+
+        vector<float> coefficients(MaxPrevASPCDipoles*MaxPrevASPCDipoles, 0.0f);
+        coefficients[0] = 1.0f;
+        for (int numPrev = 2; numPrev <= MaxPrevASPCDipoles; numPrev++) {
+            int k = numPrev-2;
+            for (int j = 1; j <= numPrev; j++)
+                coefficients[(numPrev-1)*MaxPrevASPCDipoles+j-1] = (j%2 == 1 ? 1 : -1)*j*binomialCoefficient(2*k+4, k+2-j)/binomialCoefficient(2*k+2, k+1);
+        }
+        predictorCoefficients.initialize<float>(cc, coefficients.size(), "predictorCoefficients");
+        predictorCoefficients.upload(coefficients);
+        numPredictorDipoles = 0;
+        newestPredictorIndex = 0;
+        cc.addReorderListener(new ReorderListener(*this));
         syncEvent = cc.createEvent();
         hasCreatedEvent = true;
     }
@@ -354,14 +437,16 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
             if (find(atoms12.begin(), atoms12.end(), atom) == atoms12.end())
                 polarizationFlagValues.push_back(mm_int2(i, atom));
     }
-    set<pair<int, int> > tilesWithExclusions;
+    vector<long long> tilesWithExclusions;
     for (int atom1 = 0; atom1 < (int) exclusions.size(); ++atom1) {
         int x = atom1/ComputeContext::TileSize;
         for (int atom2 : exclusions[atom1]) {
             int y = atom2/ComputeContext::TileSize;
-            tilesWithExclusions.insert(make_pair(max(x, y), min(x, y)));
+            tilesWithExclusions.push_back((((long long) max(x, y))<<32)+min(x, y));
         }
     }
+    sort(tilesWithExclusions.begin(), tilesWithExclusions.end());
+    tilesWithExclusions.erase(unique(tilesWithExclusions.begin(), tilesWithExclusions.end()), tilesWithExclusions.end());
     
     // Record other options.
     
@@ -371,6 +456,8 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     }
     else
         maxInducedIterations = 0;
+    mutualInducedUpdateInterval = force.getMutualInducedUpdateInterval();
+    evaluationsSinceSolve = 0;
     if (polarizationType != AmoebaMultipoleForce::Direct) {
         inducedField.initialize(cc, 3*paddedNumAtoms, sizeof(long long), "inducedField");
         inducedFieldPolar.initialize(cc, 3*paddedNumAtoms, sizeof(long long), "inducedFieldPolar");
@@ -464,6 +551,14 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         if (polarizationType == AmoebaMultipoleForce::Mutual) {
             prevDipolesGk.initialize(cc, 3*numMultipoles*MaxPrevDIISDipoles, elementSize, "prevDipolesGk");
             prevDipolesGkPolar.initialize(cc, 3*numMultipoles*MaxPrevDIISDipoles, elementSize, "prevDipolesGkPolar");
+            cgDipoleGk.initialize(cc, 3*paddedNumAtoms, elementSize, "cgDipoleGk");
+            cgDipoleGkPolar.initialize(cc, 3*paddedNumAtoms, elementSize, "cgDipoleGkPolar");
+            cgResidualGk.initialize(cc, 3*paddedNumAtoms, elementSize, "cgResidualGk");
+            cgResidualGkPolar.initialize(cc, 3*paddedNumAtoms, elementSize, "cgResidualGkPolar");
+            cgScalarsGk.initialize(cc, 6, elementSize, "cgScalarsGk");
+            inducedDipoleErrorsGk.initialize(cc, cc.getNumThreadBlocks(), sizeof(mm_float2), "inducedDipoleErrorsGk");
+            predictorDipolesGk.initialize(cc, 3*numMultipoles*MaxPrevASPCDipoles, elementSize, "predictorDipolesGk");
+            predictorDipolesGkPolar.initialize(cc, 3*numMultipoles*MaxPrevASPCDipoles, elementSize, "predictorDipolesGkPolar");
         }
         else if (polarizationType == AmoebaMultipoleForce::Extrapolated) {
             inducedThreadMemory += 12*elementSize;
@@ -540,6 +635,7 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     if (polarizationType != AmoebaMultipoleForce::Direct) {
         defines["THREAD_BLOCK_SIZE"] = cc.intToString(inducedFieldThreads);
         defines["MAX_PREV_DIIS_DIPOLES"] = cc.intToString(MaxPrevDIISDipoles);
+        defines["MAX_PREV_ASPC_DIPOLES"] = cc.intToString(MaxPrevASPCDipoles);
         program = cc.compileProgram(CommonAmoebaKernelSources::multipoleInducedField, defines);
         computeInducedFieldKernel = program->createKernel("computeInducedField");
         computeInducedFieldKernel->addArg(inducedField);
@@ -594,6 +690,50 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
             solveMatrixKernel->addArg();
             solveMatrixKernel->addArg(diisMatrix);
             solveMatrixKernel->addArg(diisCoefficients);
+            predictDipolesKernel = program->createKernel("predictInducedDipoles");
+            for (int i = 0; i < 4; i++)
+                predictDipolesKernel->addArg();
+            predictDipolesKernel->addArg(predictorCoefficients);
+            predictDipolesKernel->addArg();
+            predictDipolesKernel->addArg();
+            recordPredictorDipolesKernel = program->createKernel("recordPredictorDipoles");
+            for (int i = 0; i < 5; i++)
+                recordPredictorDipolesKernel->addArg();
+            initCGKernel = program->createKernel("initializeCGDipoles");
+            initCGKernel->addArg(field);
+            initCGKernel->addArg(fieldPolar);
+            for (int i = 0; i < 3; i++)
+                initCGKernel->addArg();
+            initCGKernel->addArg(polarizability);
+            for (int i = 0; i < 6; i++)
+                initCGKernel->addArg();
+            initCGKernel->addArg(cgPartialSums);
+            initCGKernel->addArg();
+            initCGKernel->addArg();
+            cgDirectionProductKernel = program->createKernel("computeCGDirectionProduct");
+            cgDirectionProductKernel->addArg();
+            cgDirectionProductKernel->addArg();
+            cgDirectionProductKernel->addArg(polarizability);
+            cgDirectionProductKernel->addArg();
+            cgDirectionProductKernel->addArg();
+            cgDirectionProductKernel->addArg(cgPartialSums);
+            cgScalarsKernel = program->createKernel("updateCGScalars");
+            cgScalarsKernel->addArg(cgPartialSums);
+            cgScalarsKernel->addArg(cc.getNumThreadBlocks());
+            cgScalarsKernel->addArg();
+            cgScalarsKernel->addArg();
+            updateCGDipolesKernel = program->createKernel("updateCGDipoles");
+            updateCGDipolesKernel->addArg();
+            updateCGDipolesKernel->addArg();
+            updateCGDipolesKernel->addArg(polarizability);
+            for (int i = 0; i < 7; i++)
+                updateCGDipolesKernel->addArg();
+            updateCGDipolesKernel->addArg(cgPartialSums);
+            updateCGDipolesKernel->addArg();
+            updateCGDirectionKernel = program->createKernel("updateCGDirection");
+            updateCGDirectionKernel->addArg(polarizability);
+            for (int i = 0; i < 5; i++)
+                updateCGDirectionKernel->addArg();
         }
         if (polarizationType == AmoebaMultipoleForce::Extrapolated) {
             initExtrapolatedKernel = program->createKernel("initExtrapolatedDipoles");
@@ -956,15 +1096,20 @@ void CommonCalcAmoebaMultipoleForceKernel::initializeScaleFactors() {
     hasInitializedScaleFactors = true;
     NonbondedUtilities& nb = cc.getNonbondedUtilities();
     
-    // Figure out the covalent flag values to use for each atom pair.
+    // Figure out the covalent flag values to use for each atom pair.  Tiles are looked up in a hash
+    // table, since large systems have many thousands of exclusion tiles.
 
     vector<mm_int2> exclusionTiles;
     nb.getExclusionTiles().download(exclusionTiles);
-    map<pair<int, int>, int> exclusionTileMap;
+    unordered_map<long long, int> exclusionTileMap;
+    exclusionTileMap.reserve(exclusionTiles.size());
     for (int i = 0; i < (int) exclusionTiles.size(); i++) {
         mm_int2 tile = exclusionTiles[i];
-        exclusionTileMap[make_pair(tile.x, tile.y)] = i;
+        exclusionTileMap[(((long long) tile.x)<<32)+tile.y] = i;
     }
+    auto tileStart = [&] (int x, int y) {
+        return exclusionTileMap[(((long long) x)<<32)+y]*ComputeContext::TileSize;
+    };
     covalentFlags.resize(nb.getExclusions().getSize());
     vector<mm_int2> covalentFlagsVec(nb.getExclusions().getSize(), mm_int2(0, 0));
     for (mm_int4 values : covalentFlagValues) {
@@ -978,19 +1123,19 @@ void CommonCalcAmoebaMultipoleForceKernel::initializeScaleFactors() {
         int f1 = (value == 0 || value == 1 ? 1 : 0);
         int f2 = (value == 0 || value == 2 ? 1 : 0);
         if (x == y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
+            int index = tileStart(x, y);
             covalentFlagsVec[index+offset1].x |= f1<<offset2;
             covalentFlagsVec[index+offset1].y |= f2<<offset2;
             covalentFlagsVec[index+offset2].x |= f1<<offset1;
             covalentFlagsVec[index+offset2].y |= f2<<offset1;
         }
         else if (x > y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
+            int index = tileStart(x, y);
             covalentFlagsVec[index+offset1].x |= f1<<offset2;
             covalentFlagsVec[index+offset1].y |= f2<<offset2;
         }
         else {
-            int index = exclusionTileMap[make_pair(y, x)]*ComputeContext::TileSize;
+            int index = tileStart(y, x);
             covalentFlagsVec[index+offset2].x |= f1<<offset1;
             covalentFlagsVec[index+offset2].y |= f2<<offset1;
         }
@@ -1009,16 +1154,16 @@ void CommonCalcAmoebaMultipoleForceKernel::initializeScaleFactors() {
         int y = atom2/ComputeContext::TileSize;
         int offset2 = atom2-y*ComputeContext::TileSize;
         if (x == y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
+            int index = tileStart(x, y);
             polarizationGroupFlagsVec[index+offset1] |= 1<<offset2;
             polarizationGroupFlagsVec[index+offset2] |= 1<<offset1;
         }
         else if (x > y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
+            int index = tileStart(x, y);
             polarizationGroupFlagsVec[index+offset1] |= 1<<offset2;
         }
         else {
-            int index = exclusionTileMap[make_pair(y, x)]*ComputeContext::TileSize;
+            int index = tileStart(y, x);
             polarizationGroupFlagsVec[index+offset2] |= 1<<offset1;
         }
     }
@@ -1083,12 +1228,8 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
         
         if (polarizationType == AmoebaMultipoleForce::Extrapolated)
             computeExtrapolatedDipoles();
-        for (int i = 0; i < maxInducedIterations; i++) {
-            computeInducedField();
-            bool converged = iterateDipolesByDIIS(i);
-            if (converged)
-                break;
-        }
+        else if (polarizationType == AmoebaMultipoleForce::Mutual)
+            convergeMutualDipoles();
         
         // Compute electrostatic force.
         
@@ -1194,12 +1335,8 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
         
         if (polarizationType == AmoebaMultipoleForce::Extrapolated)
             computeExtrapolatedDipoles();
-        for (int i = 0; i < maxInducedIterations; i++) {
-            computeInducedField();
-            bool converged = iterateDipolesByDIIS(i);
-            if (converged)
-                break;
-        }
+        else if (polarizationType == AmoebaMultipoleForce::Mutual)
+            convergeMutualDipoles();
         
         // Compute electrostatic force.
         
@@ -1274,6 +1411,199 @@ void CommonCalcAmoebaMultipoleForceKernel::computeInducedField() {
     }
 }
 
+void CommonCalcAmoebaMultipoleForceKernel::convergeMutualDipoles() {
+    if (numPredictorDipoles > 0 && evaluationsSinceSolve+1 < mutualInducedUpdateInterval) {
+        // Reuse the most recently converged dipoles without iterating.  Predicting from a single previous
+        // set just copies it.  The induced field is still needed for computing forces.
+
+        evaluationsSinceSolve++;
+        predictDipolesKernel->setArg(5, 1);
+        predictDipolesKernel->setArg(6, newestPredictorIndex);
+        predictDipolesKernel->setArg(0, inducedDipole);
+        predictDipolesKernel->setArg(1, inducedDipolePolar);
+        predictDipolesKernel->setArg(2, predictorDipoles);
+        predictDipolesKernel->setArg(3, predictorDipolesPolar);
+        predictDipolesKernel->execute(3*cc.getNumAtoms());
+        if (gkKernel != NULL) {
+            predictDipolesKernel->setArg(0, gkKernel->getInducedDipoles());
+            predictDipolesKernel->setArg(1, gkKernel->getInducedDipolesPolar());
+            predictDipolesKernel->setArg(2, predictorDipolesGk);
+            predictDipolesKernel->setArg(3, predictorDipolesGkPolar);
+            predictDipolesKernel->execute(3*cc.getNumAtoms());
+        }
+        computeInducedField();
+        return;
+    }
+    evaluationsSinceSolve = 0;
+
+    // Predict the initial dipoles from the ones at previous steps.
+
+    if (numPredictorDipoles > 0) {
+        predictDipolesKernel->setArg(5, numPredictorDipoles);
+        predictDipolesKernel->setArg(6, newestPredictorIndex);
+        predictDipolesKernel->setArg(0, inducedDipole);
+        predictDipolesKernel->setArg(1, inducedDipolePolar);
+        predictDipolesKernel->setArg(2, predictorDipoles);
+        predictDipolesKernel->setArg(3, predictorDipolesPolar);
+        predictDipolesKernel->execute(3*cc.getNumAtoms());
+        if (gkKernel != NULL) {
+            predictDipolesKernel->setArg(0, gkKernel->getInducedDipoles());
+            predictDipolesKernel->setArg(1, gkKernel->getInducedDipolesPolar());
+            predictDipolesKernel->setArg(2, predictorDipolesGk);
+            predictDipolesKernel->setArg(3, predictorDipolesGkPolar);
+            predictDipolesKernel->execute(3*cc.getNumAtoms());
+        }
+    }
+
+    // Converge them with conjugate gradients, falling back to DIIS in the rare cases where that fails.
+
+    if (!convergeDipolesByCG()) {
+        for (int i = 0; i < maxInducedIterations; i++) {
+            computeInducedField();
+            bool converged = iterateDipolesByDIIS(i);
+            if (converged)
+                break;
+        }
+    }
+
+    // Record the converged dipoles for predicting the ones at the next step.
+
+    newestPredictorIndex = (newestPredictorIndex+1)%MaxPrevASPCDipoles;
+    numPredictorDipoles = min(numPredictorDipoles+1, MaxPrevASPCDipoles);
+    recordPredictorDipolesKernel->setArg(0, inducedDipole);
+    recordPredictorDipolesKernel->setArg(1, inducedDipolePolar);
+    recordPredictorDipolesKernel->setArg(2, predictorDipoles);
+    recordPredictorDipolesKernel->setArg(3, predictorDipolesPolar);
+    recordPredictorDipolesKernel->setArg(4, newestPredictorIndex);
+    recordPredictorDipolesKernel->execute(3*cc.getNumAtoms());
+    if (gkKernel != NULL) {
+        recordPredictorDipolesKernel->setArg(0, gkKernel->getInducedDipoles());
+        recordPredictorDipolesKernel->setArg(1, gkKernel->getInducedDipolesPolar());
+        recordPredictorDipolesKernel->setArg(2, predictorDipolesGk);
+        recordPredictorDipolesKernel->setArg(3, predictorDipolesGkPolar);
+        recordPredictorDipolesKernel->execute(3*cc.getNumAtoms());
+    }
+}
+
+bool CommonCalcAmoebaMultipoleForceKernel::convergeDipolesByCG() {
+    // The dipoles are solved by preconditioned conjugate gradients (see multipoleInducedField.cc).  With GK,
+    // the dipoles in solvent form a second set of equations that is solved alongside the first.
+
+    void* npt = NULL;
+    int numBlocks = cc.getNumThreadBlocks();
+    int numSets = (gkKernel == NULL ? 1 : 2);
+    ComputeArray* dipoles[] = {&inducedDipole, NULL};
+    ComputeArray* dipolesPolar[] = {&inducedDipolePolar, NULL};
+    ComputeArray* fields[] = {&inducedField, NULL};
+    ComputeArray* fieldsPolar[] = {&inducedFieldPolar, NULL};
+    ComputeArray* cgDipoles[] = {&cgDipole, &cgDipoleGk};
+    ComputeArray* cgDipolesPolar[] = {&cgDipolePolar, &cgDipoleGkPolar};
+    ComputeArray* residuals[] = {&cgResidual, &cgResidualGk};
+    ComputeArray* residualsPolar[] = {&cgResidualPolar, &cgResidualGkPolar};
+    ComputeArray* scalars[] = {&cgScalars, &cgScalarsGk};
+    ComputeArray* errors[] = {&inducedDipoleErrors, &inducedDipoleErrorsGk};
+    if (gkKernel != NULL) {
+        dipoles[1] = &gkKernel->getInducedDipoles();
+        dipolesPolar[1] = &gkKernel->getInducedDipolesPolar();
+        fields[1] = &gkKernel->getInducedField();
+        fieldsPolar[1] = &gkKernel->getInducedFieldPolar();
+    }
+
+    // Compute the initial residuals.
+
+    computeInducedField();
+    for (int set = 0; set < numSets; set++) {
+        if (set == 0)
+            initCGKernel->setArg(2, npt);
+        else
+            initCGKernel->setArg(2, gkKernel->getField());
+        initCGKernel->setArg(3, *fields[set]);
+        initCGKernel->setArg(4, *fieldsPolar[set]);
+        initCGKernel->setArg(6, *dipoles[set]);
+        initCGKernel->setArg(7, *dipolesPolar[set]);
+        initCGKernel->setArg(8, *cgDipoles[set]);
+        initCGKernel->setArg(9, *cgDipolesPolar[set]);
+        initCGKernel->setArg(10, *residuals[set]);
+        initCGKernel->setArg(11, *residualsPolar[set]);
+        initCGKernel->setArg(13, *errors[set]);
+        initCGKernel->setArg(14, set);
+        initCGKernel->execute(numBlocks*64, 64);
+        cgScalarsKernel->setArg(2, *scalars[set]);
+        cgScalarsKernel->setArg(3, 0);
+        cgScalarsKernel->execute(64, 64);
+    }
+    bool converged = false, fieldIsCurrent = true;
+    mm_float2* errorSums = (mm_float2*) cc.getPinnedBuffer();
+    for (int iteration = 0; ; iteration++) {
+        // Determine whether the iteration has converged.
+
+        for (int set = 0; set < numSets; set++)
+            errors[set]->download(&errorSums[set*numBlocks], false);
+        syncEvent->enqueue();
+        syncEvent->wait();
+        double maxError = 0.0;
+        for (int set = 0; set < numSets; set++) {
+            double total1 = 0.0, total2 = 0.0;
+            for (int j = 0; j < numBlocks; j++) {
+                total1 += errorSums[set*numBlocks+j].x;
+                total2 += errorSums[set*numBlocks+j].y;
+            }
+            maxError = max(maxError, max(total1, total2));
+        }
+        if (48.033324*sqrt(maxError/cc.getNumAtoms()) < inducedEpsilon) {
+            converged = true;
+            break;
+        }
+        if (iteration == maxInducedIterations)
+            break;
+
+        // Compute the product of the matrix with each search direction, and take a step along it.
+
+        computeInducedField();
+        fieldIsCurrent = false;
+        for (int set = 0; set < numSets; set++) {
+            cgDirectionProductKernel->setArg(0, *fields[set]);
+            cgDirectionProductKernel->setArg(1, *fieldsPolar[set]);
+            cgDirectionProductKernel->setArg(3, *dipoles[set]);
+            cgDirectionProductKernel->setArg(4, *dipolesPolar[set]);
+            cgDirectionProductKernel->execute(numBlocks*64, 64);
+            cgScalarsKernel->setArg(2, *scalars[set]);
+            cgScalarsKernel->setArg(3, 1);
+            cgScalarsKernel->execute(64, 64);
+            updateCGDipolesKernel->setArg(0, *fields[set]);
+            updateCGDipolesKernel->setArg(1, *fieldsPolar[set]);
+            updateCGDipolesKernel->setArg(3, *dipoles[set]);
+            updateCGDipolesKernel->setArg(4, *dipolesPolar[set]);
+            updateCGDipolesKernel->setArg(5, *cgDipoles[set]);
+            updateCGDipolesKernel->setArg(6, *cgDipolesPolar[set]);
+            updateCGDipolesKernel->setArg(7, *residuals[set]);
+            updateCGDipolesKernel->setArg(8, *residualsPolar[set]);
+            updateCGDipolesKernel->setArg(9, *scalars[set]);
+            updateCGDipolesKernel->setArg(11, *errors[set]);
+            updateCGDipolesKernel->execute(numBlocks*64, 64);
+            cgScalarsKernel->setArg(3, 2);
+            cgScalarsKernel->execute(64, 64);
+            updateCGDirectionKernel->setArg(1, *residuals[set]);
+            updateCGDirectionKernel->setArg(2, *residualsPolar[set]);
+            updateCGDirectionKernel->setArg(3, *dipoles[set]);
+            updateCGDirectionKernel->setArg(4, *dipolesPolar[set]);
+            updateCGDirectionKernel->setArg(5, *scalars[set]);
+            updateCGDirectionKernel->execute(3*cc.getNumAtoms());
+        }
+    }
+
+    // The induced dipole arrays hold the search directions, so copy the dipoles back into them.  The rest of
+    // the calculation depends on the field being computed from the final dipoles.
+
+    for (int set = 0; set < numSets; set++) {
+        cgDipoles[set]->copyTo(*dipoles[set]);
+        cgDipolesPolar[set]->copyTo(*dipolesPolar[set]);
+    }
+    if (converged && !fieldIsCurrent)
+        computeInducedField();
+    return converged;
+}
+
 bool CommonCalcAmoebaMultipoleForceKernel::iterateDipolesByDIIS(int iteration) {
     void* npt = NULL;
 
@@ -1702,6 +2032,7 @@ void CommonCalcAmoebaMultipoleForceKernel::copyParametersToContext(ContextImpl&
     cc.getPosq().upload(cc.getPinnedBuffer());
     cc.invalidateMolecules();
     multipolesAreValid = false;
+    numPredictorDipoles = 0;
 }
 
 void CommonCalcAmoebaMultipoleForceKernel::getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
@@ -1732,7 +2063,8 @@ private:
 };
 
 CommonCalcAmoebaGeneralizedKirkwoodForceKernel::CommonCalcAmoebaGeneralizedKirkwoodForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const System& system) :
-           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), cc(cc), system(system), hasInitializedKernels(false) {
+           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), cc(cc), system(system), hasInitializedKernels(false), hasComputedBornRadii(false),
+           evaluationsSinceUpdate(0), lastAtomReorder(0) {
 }
 
 void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System& system, const AmoebaGeneralizedKirkwoodForce& force) {
@@ -1755,6 +2087,7 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System& sy
     inducedDipoleS .initialize(cc, 3*paddedNumAtoms, elementSize, "inducedDipoleS");
     inducedDipolePolarS .initialize(cc, 3*paddedNumAtoms, elementSize, "inducedDipolePolarS");
     polarizationType = multipoles->getPolarizationType();
+    bornRadiusUpdateInterval = force.getBornRadiusUpdateInterval();
     if (polarizationType != AmoebaMultipoleForce::Direct) {
         inducedField .initialize(cc, 3*paddedNumAtoms, sizeof(long long), "gkInducedField");
         inducedFieldPolar .initialize(cc, 3*paddedNumAtoms, sizeof(long long), "gkInducedFieldPolar");
@@ -1927,6 +2260,16 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::computeBornRadii(ComputeArr
             surfaceAreaKernel->addArg(bornRadii);
         }
     }
+
+    // The radii can be reused from a previous evaluation, unless the atoms have been reordered since then.
+
+    if (hasComputedBornRadii && lastAtomReorder == cc.getNumAtomReorders() && evaluationsSinceUpdate+1 < bornRadiusUpdateInterval) {
+        evaluationsSinceUpdate++;
+        return;
+    }
+    hasComputedBornRadii = true;
+    evaluationsSinceUpdate = 0;
+    lastAtomReorder = cc.getNumAtomReorders();
     computeBornSumKernel->setArg(3, nb.getNumTiles());
     int numForceThreadBlocks = nb.getNumForceThreadBlocks();
     computeBornSumKernel->execute(numForceThreadBlocks*computeBornSumThreads, computeBornSumThreads);
@@ -1977,6 +2320,7 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::copyParametersToContext(Con
     }
     params.upload(paramsVector);
     cc.invalidateMolecules();
+    hasComputedBornRadii = false;
 }
 
 /* -------------------------------------------------------------------------- *
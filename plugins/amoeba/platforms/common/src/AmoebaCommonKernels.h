@@ -66,7 +66,7 @@ private:
     int numTorsionTorsionGrids;
     ComputeContext& cc;
     const System& system;
-    ComputeArray gridValues;
+    ComputeArray gridCoefficients;
     ComputeArray gridParams;
     ComputeArray torsionParams;
 };
@@ -162,13 +162,17 @@ public:
     virtual bool useFixedPointChargeSpreading() const = 0;
 protected:
     class ForceInfo;
+    class ReorderListener;
     void initializeScaleFactors();
     void computeInducedField();
+    void convergeMutualDipoles();
+    bool convergeDipolesByCG();
     bool iterateDipolesByDIIS(int iteration);
     void computeExtrapolatedDipoles();
     void ensureMultipolesValid(ContextImpl& context);
     template <class T, class T4, class M4> void computeSystemMultipoleMoments(ContextImpl& context, std::vector<double>& outputMultipoleMoments);
-    int numMultipoles, maxInducedIterations, maxExtrapolationOrder;
+    int numMultipoles, maxInducedIterations, maxExtrapolationOrder, numPredictorDipoles, newestPredictorIndex;
+    int mutualInducedUpdateInterval, evaluationsSinceSolve;
     int fixedFieldThreads, inducedFieldThreads, electrostaticsThreads;
     int gridSizeX, gridSizeY, gridSizeZ;
     double pmeAlpha, inducedEpsilon;
@@ -203,6 +207,23 @@ protected:
     ComputeArray prevErrors;
     ComputeArray diisMatrix;
     ComputeArray diisCoefficients;
+    ComputeArray cgDipole;
+    ComputeArray cgDipolePolar;
+    ComputeArray cgDipoleGk;
+    ComputeArray cgDipoleGkPolar;
+    ComputeArray cgResidual;
+    ComputeArray cgResidualPolar;
+    ComputeArray cgResidualGk;
+    ComputeArray cgResidualGkPolar;
+    ComputeArray cgPartialSums;
+    ComputeArray cgScalars;
+    ComputeArray cgScalarsGk;
+    ComputeArray inducedDipoleErrorsGk;
+    ComputeArray predictorDipoles;
+    ComputeArray predictorDipolesPolar;
+    ComputeArray predictorDipolesGk;
+    ComputeArray predictorDipolesGkPolar;
+    ComputeArray predictorCoefficients;
     ComputeArray extrapolatedDipole;
     ComputeArray extrapolatedDipolePolar;
     ComputeArray extrapolatedDipoleGk;
@@ -233,6 +254,7 @@ protected:
     ComputeKernel computeMomentsKernel, recordInducedDipolesKernel, mapTorqueKernel, computePotentialKernel, electrostaticsKernel;
     ComputeKernel computeFixedFieldKernel, computeInducedFieldKernel, updateInducedFieldKernel;
     ComputeKernel recordDIISDipolesKernel, buildMatrixKernel, solveMatrixKernel;
+    ComputeKernel predictDipolesKernel, recordPredictorDipolesKernel, initCGKernel, cgDirectionProductKernel, cgScalarsKernel, updateCGDipolesKernel, updateCGDirectionKernel;
     ComputeKernel initExtrapolatedKernel, iterateExtrapolatedKernel, computeExtrapolatedKernel, addExtrapolatedGradientKernel;
     ComputeKernel pmeSpreadFixedMultipolesKernel, pmeSpreadInducedDipolesKernel, pmeFinishSpreadChargeKernel, pmeConvolutionKernel;
     ComputeKernel pmeFixedPotentialKernel, pmeInducedPotentialKernel, pmeFixedForceKernel, pmeInducedForceKernel, pmeRecordInducedFieldDipolesKernel;
@@ -241,6 +263,7 @@ protected:
     CommonCalcAmoebaGeneralizedKirkwoodForceKernel* gkKernel;
     static const int PmeOrder = 5;
     static const int MaxPrevDIISDipoles = 20;
+    static const int MaxPrevASPCDipoles = 6;
 };
 
 /**
@@ -302,8 +325,10 @@ private:
     class ForceInfo;
     ComputeContext& cc;
     const System& system;
-    bool includeSurfaceArea, hasInitializedKernels;
+    bool includeSurfaceArea, hasInitializedKernels, hasComputedBornRadii;
     int computeBornSumThreads, gkForceThreads, chainRuleThreads, ediffThreads;
+    int bornRadiusUpdateInterval, evaluationsSinceUpdate;
+    long long lastAtomReorder;
     AmoebaMultipoleForce::PolarizationType polarizationType;
     std::map<std::string, std::string> defines;
     ComputeArray params;
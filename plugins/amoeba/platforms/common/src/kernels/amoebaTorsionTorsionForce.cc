@@ -105,57 +105,43 @@ float4 gridParams = GRID_PARAMS[torsionParams.y];
 int index1 = (int) ((value1 - gridParams.y)/gridParams.z + 1.0e-05f);
 real fIndex = (real) index1;
 real x1l = gridParams.z*fIndex + gridParams.y;
-real x1u = x1l + gridParams.z;
 
 int index2 = (int) ((value2 - gridParams.y)/gridParams.z + 1.0e-05f);
 fIndex = (real) index2;
 real x2l = gridParams.z*fIndex + gridParams.y;
-real x2u = x2l + gridParams.z;
 
-int posIndex1 = index2 + index1*(int) gridParams.w;
-posIndex1 += (int) gridParams.x;
+// load the precomputed bicubic coefficients for the patch containing the angles
 
-int posIndex2 = index2 + (index1+1)*(int) gridParams.w;
-posIndex2 += (int) gridParams.x;
+int coeffIndex = (int) gridParams.x + 4*(index2 + index1*(int) gridParams.w);
+float4 c[4];
+c[0] = GRID_COEFFICIENTS[coeffIndex];
+c[1] = GRID_COEFFICIENTS[coeffIndex+1];
+c[2] = GRID_COEFFICIENTS[coeffIndex+2];
+c[3] = GRID_COEFFICIENTS[coeffIndex+3];
 
-// load grid points surrounding angle
-
-real4 y;
-real4 y1;
-real4 y2;
-real4 y12;
-
-int localIndex = posIndex1;
-y.x = GRID_VALUES[localIndex].x;
-y1.x = GRID_VALUES[localIndex].y;
-y2.x = GRID_VALUES[localIndex].z;
-y12.x = GRID_VALUES[localIndex].w;
+// perform interpolation
 
-localIndex = posIndex2;
-y.y = GRID_VALUES[localIndex].x;
-y1.y = GRID_VALUES[localIndex].y;
-y2.y = GRID_VALUES[localIndex].z;
-y12.y = GRID_VALUES[localIndex].w;
+real t = (value1-x1l)/gridParams.z;
+real u = (value2-x2l)/gridParams.z;
 
-localIndex = posIndex2 + 1;
-y.z = GRID_VALUES[localIndex].x;
-y1.z = GRID_VALUES[localIndex].y;
-y2.z = GRID_VALUES[localIndex].z;
-y12.z = GRID_VALUES[localIndex].w;
+real e =   ((c[3].w*u + c[3].z)*u + c[3].y)*u + c[3].x;
+e = t*e + ((c[2].w*u + c[2].z)*u + c[2].y)*u + c[2].x;
+e = t*e + ((c[1].w*u + c[1].z)*u + c[1].y)*u + c[1].x;
+e = t*e + ((c[0].w*u + c[0].z)*u + c[0].y)*u + c[0].x;
 
-localIndex = posIndex1 + 1;
-y.w = GRID_VALUES[localIndex].x;
-y1.w = GRID_VALUES[localIndex].y;
-y2.w = GRID_VALUES[localIndex].z;
-y12.w = GRID_VALUES[localIndex].w;
+real dedang1 =             (3.0f*c[3].w*t + 2.0f*c[2].w)*t + c[1].w;
+     dedang1 = u*dedang1 + (3.0f*c[3].z*t + 2.0f*c[2].z)*t + c[1].z;
+     dedang1 = u*dedang1 + (3.0f*c[3].y*t + 2.0f*c[2].y)*t + c[1].y;
+     dedang1 = u*dedang1 + (3.0f*c[3].x*t + 2.0f*c[2].x)*t + c[1].x;
 
-// perform interpolation
+real dedang2 =             (3.0f*c[3].w*u + 2.0f*c[3].z)*u + c[3].y;
+     dedang2 = t*dedang2 + (3.0f*c[2].w*u + 2.0f*c[2].z)*u + c[2].y;
+     dedang2 = t*dedang2 + (3.0f*c[1].w*u + 2.0f*c[1].z)*u + c[1].y;
+     dedang2 = t*dedang2 + (3.0f*c[0].w*u + 2.0f*c[0].z)*u + c[0].y;
 
-real e;
-real dedang1;
-real dedang2;
+dedang1 /= gridParams.z;
+dedang2 /= gridParams.z;
 
-bicubic(y, y1, y2, y12, value1, x1l, x1u, value2, x2l, x2u, &e, &dedang1, &dedang2);
 energy += e;
 dedang1 *= sign * RAD_TO_DEG;
 dedang2 *= sign * RAD_TO_DEG;
@@ -830,6 +830,246 @@ KERNEL void updateInducedFieldByDIIS(GLOBAL real* RESTRICT inducedDipole, GLOBAL
         inducedDipolePolar[index] = sumPolar;
     }
 }
+
+/**
+ * Predict the initial induced dipoles from the converged ones at previous steps.  The previous dipoles are
+ * stored in a ring buffer, and row numPrev-1 of the coefficient table holds the coefficients to use when
+ * numPrev of them are available.
+ */
+KERNEL void predictInducedDipoles(GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT inducedDipolePolar,
+        GLOBAL const real* RESTRICT prevDipoles, GLOBAL const real* RESTRICT prevDipolesPolar, GLOBAL const float* RESTRICT coefficients,
+        int numPrev, int newestIndex) {
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        real sum = 0;
+        real sumPolar = 0;
+        for (int i = 0; i < numPrev; i++) {
+            int prevIndex = (newestIndex-i+MAX_PREV_ASPC_DIPOLES)%MAX_PREV_ASPC_DIPOLES;
+            float c = coefficients[(numPrev-1)*MAX_PREV_ASPC_DIPOLES+i];
+            sum += c*prevDipoles[prevIndex*3*NUM_ATOMS+index];
+            sumPolar += c*prevDipolesPolar[prevIndex*3*NUM_ATOMS+index];
+        }
+        inducedDipole[index] = sum;
+        inducedDipolePolar[index] = sumPolar;
+    }
+}
+
+/**
+ * Record the converged induced dipoles so they can be used to predict the ones at later steps.
+ */
+KERNEL void recordPredictorDipoles(GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real* RESTRICT prevDipoles, GLOBAL real* RESTRICT prevDipolesPolar, int storeIndex) {
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        prevDipoles[storeIndex*3*NUM_ATOMS+index] = inducedDipole[index];
+        prevDipolesPolar[storeIndex*3*NUM_ATOMS+index] = inducedDipolePolar[index];
+    }
+}
+
+/**
+ * The following kernels solve (1/alpha - T)*mu = E with preconditioned conjugate gradients, using the
+ * polarizabilities as a Jacobi preconditioner.  While iterating, the current dipoles are stored in cgDipole
+ * and the search direction is stored in inducedDipole, so computeInducedField() computes the product of T
+ * with the search direction.  Scalars are kept on the device: element 0 is the dot product of the residual
+ * with the preconditioned residual, element 1 is the step length, and element 2 is the factor for updating
+ * the search direction.  The polar dipoles use elements 3-5.
+ */
+
+/**
+ * Sum the per-block partial sums of two dot products over all thread blocks.
+ */
+DEVICE real2 sumCGPartialSums(GLOBAL const real2* RESTRICT partialSums, int numBlocks, LOCAL_ARG real2* buffer) {
+    real2 sum = make_real2(0);
+    for (int i = LOCAL_ID; i < numBlocks; i += LOCAL_SIZE)
+        sum += partialSums[i];
+    buffer[LOCAL_ID] = sum;
+    SYNC_THREADS;
+    for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+        if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0)
+            buffer[LOCAL_ID] += buffer[LOCAL_ID+offset];
+        SYNC_THREADS;
+    }
+    return buffer[0];
+}
+
+/**
+ * Compute the initial residual and search direction from the field of the initial dipoles.
+ */
+KERNEL void initializeCGDipoles(GLOBAL const mm_long* RESTRICT fixedField, GLOBAL const mm_long* RESTRICT fixedFieldPolar,
+        GLOBAL const mm_long* RESTRICT fixedFieldS, GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar,
+        GLOBAL const float* RESTRICT polarizability, GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT inducedDipolePolar,
+        GLOBAL real* RESTRICT cgDipole, GLOBAL real* RESTRICT cgDipolePolar, GLOBAL real* RESTRICT residual, GLOBAL real* RESTRICT residualPolar,
+        GLOBAL real2* RESTRICT partialSums, GLOBAL float2* RESTRICT errors, int isGK) {
+    LOCAL real4 buffer[64];
+    const real fieldScale = 1/(real) 0x100000000;
+    real4 sums = make_real4(0);
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        real scale = polarizability[atom];
+        real3 dipole = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+        real3 dipolePolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
+        real3 fixed = make_real3(fixedField[atom], fixedField[atom+PADDED_NUM_ATOMS], fixedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 fixedPolar = make_real3(fixedFieldPolar[atom], fixedFieldPolar[atom+PADDED_NUM_ATOMS], fixedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 induced = make_real3(inducedField[atom], inducedField[atom+PADDED_NUM_ATOMS], inducedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 inducedPolar = make_real3(inducedFieldPolar[atom], inducedFieldPolar[atom+PADDED_NUM_ATOMS], inducedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 fixedS = make_real3(0);
+        if (isGK)
+            fixedS = make_real3(fixedFieldS[atom], fixedFieldS[atom+PADDED_NUM_ATOMS], fixedFieldS[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 z = scale*(fixed+fixedS+induced)-dipole;
+        real3 zPolar = scale*(fixedPolar+fixedS+inducedPolar)-dipolePolar;
+        real invScale = (scale == 0 ? 0 : 1/scale);
+        real3 r = z*invScale;
+        real3 rPolar = zPolar*invScale;
+        cgDipole[3*atom] = dipole.x;
+        cgDipole[3*atom+1] = dipole.y;
+        cgDipole[3*atom+2] = dipole.z;
+        cgDipolePolar[3*atom] = dipolePolar.x;
+        cgDipolePolar[3*atom+1] = dipolePolar.y;
+        cgDipolePolar[3*atom+2] = dipolePolar.z;
+        residual[3*atom] = r.x;
+        residual[3*atom+1] = r.y;
+        residual[3*atom+2] = r.z;
+        residualPolar[3*atom] = rPolar.x;
+        residualPolar[3*atom+1] = rPolar.y;
+        residualPolar[3*atom+2] = rPolar.z;
+        inducedDipole[3*atom] = z.x;
+        inducedDipole[3*atom+1] = z.y;
+        inducedDipole[3*atom+2] = z.z;
+        inducedDipolePolar[3*atom] = zPolar.x;
+        inducedDipolePolar[3*atom+1] = zPolar.y;
+        inducedDipolePolar[3*atom+2] = zPolar.z;
+        sums += make_real4(dot(r, z), dot(rPolar, zPolar), dot(z, z), dot(zPolar, zPolar));
+    }
+    buffer[LOCAL_ID] = sums;
+    SYNC_THREADS;
+    for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+        if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0)
+            buffer[LOCAL_ID] += buffer[LOCAL_ID+offset];
+        SYNC_THREADS;
+    }
+    if (LOCAL_ID == 0) {
+        partialSums[GROUP_ID] = make_real2(buffer[0].x, buffer[0].y);
+        errors[GROUP_ID] = make_float2((float) buffer[0].z, (float) buffer[0].w);
+    }
+}
+
+/**
+ * Compute the dot product of each search direction with the matrix times the search direction.
+ */
+KERNEL void computeCGDirectionProduct(GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar,
+        GLOBAL const float* RESTRICT polarizability, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real2* RESTRICT partialSums) {
+    LOCAL real2 buffer[64];
+    const real fieldScale = 1/(real) 0x100000000;
+    real2 sums = make_real2(0);
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        real scale = polarizability[atom];
+        if (scale == 0)
+            continue;
+        real3 p = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+        real3 pPolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
+        real3 induced = make_real3(inducedField[atom], inducedField[atom+PADDED_NUM_ATOMS], inducedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 inducedPolar = make_real3(inducedFieldPolar[atom], inducedFieldPolar[atom+PADDED_NUM_ATOMS], inducedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        sums += make_real2(dot(p, p/scale-induced), dot(pPolar, pPolar/scale-inducedPolar));
+    }
+    buffer[LOCAL_ID] = sums;
+    SYNC_THREADS;
+    for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+        if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0)
+            buffer[LOCAL_ID] += buffer[LOCAL_ID+offset];
+        SYNC_THREADS;
+    }
+    if (LOCAL_ID == 0)
+        partialSums[GROUP_ID] = buffer[0];
+}
+
+/**
+ * Update the scalars used by the conjugate gradient iteration.  Stage 0 records the initial dot product of
+ * the residuals, stage 1 computes the step length, and stage 2 computes the factor for updating the search
+ * direction.  This is executed by a single thread block.
+ */
+KERNEL void updateCGScalars(GLOBAL const real2* RESTRICT partialSums, int numBlocks, GLOBAL real* RESTRICT scalars, int stage) {
+    LOCAL real2 buffer[64];
+    real2 sum = sumCGPartialSums(partialSums, numBlocks, buffer);
+    if (LOCAL_ID == 0) {
+        if (stage == 0) {
+            scalars[0] = sum.x;
+            scalars[3] = sum.y;
+        }
+        else if (stage == 1) {
+            scalars[1] = (sum.x == 0 ? 0 : scalars[0]/sum.x);
+            scalars[4] = (sum.y == 0 ? 0 : scalars[3]/sum.y);
+        }
+        else {
+            scalars[2] = (scalars[0] == 0 ? 0 : sum.x/scalars[0]);
+            scalars[5] = (scalars[3] == 0 ? 0 : sum.y/scalars[3]);
+            scalars[0] = sum.x;
+            scalars[3] = sum.y;
+        }
+    }
+}
+
+/**
+ * Take a step along the search direction, updating the dipoles and residuals.
+ */
+KERNEL void updateCGDipoles(GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar,
+        GLOBAL const float* RESTRICT polarizability, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real* RESTRICT cgDipole, GLOBAL real* RESTRICT cgDipolePolar, GLOBAL real* RESTRICT residual, GLOBAL real* RESTRICT residualPolar,
+        GLOBAL const real* RESTRICT scalars, GLOBAL real2* RESTRICT partialSums, GLOBAL float2* RESTRICT errors) {
+    LOCAL real4 buffer[64];
+    const real fieldScale = 1/(real) 0x100000000;
+    real stepLength = scalars[1];
+    real stepLengthPolar = scalars[4];
+    real4 sums = make_real4(0);
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        real scale = polarizability[atom];
+        if (scale == 0)
+            continue;
+        real3 p = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+        real3 pPolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
+        real3 induced = make_real3(inducedField[atom], inducedField[atom+PADDED_NUM_ATOMS], inducedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 inducedPolar = make_real3(inducedFieldPolar[atom], inducedFieldPolar[atom+PADDED_NUM_ATOMS], inducedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 r = make_real3(residual[3*atom], residual[3*atom+1], residual[3*atom+2]) - (p/scale-induced)*stepLength;
+        real3 rPolar = make_real3(residualPolar[3*atom], residualPolar[3*atom+1], residualPolar[3*atom+2]) - (pPolar/scale-inducedPolar)*stepLengthPolar;
+        cgDipole[3*atom] += p.x*stepLength;
+        cgDipole[3*atom+1] += p.y*stepLength;
+        cgDipole[3*atom+2] += p.z*stepLength;
+        cgDipolePolar[3*atom] += pPolar.x*stepLengthPolar;
+        cgDipolePolar[3*atom+1] += pPolar.y*stepLengthPolar;
+        cgDipolePolar[3*atom+2] += pPolar.z*stepLengthPolar;
+        residual[3*atom] = r.x;
+        residual[3*atom+1] = r.y;
+        residual[3*atom+2] = r.z;
+        residualPolar[3*atom] = rPolar.x;
+        residualPolar[3*atom+1] = rPolar.y;
+        residualPolar[3*atom+2] = rPolar.z;
+        real3 z = r*scale;
+        real3 zPolar = rPolar*scale;
+        sums += make_real4(dot(r, z), dot(rPolar, zPolar), dot(z, z), dot(zPolar, zPolar));
+    }
+    buffer[LOCAL_ID] = sums;
+    SYNC_THREADS;
+    for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+        if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0)
+            buffer[LOCAL_ID] += buffer[LOCAL_ID+offset];
+        SYNC_THREADS;
+    }
+    if (LOCAL_ID == 0) {
+        partialSums[GROUP_ID] = make_real2(buffer[0].x, buffer[0].y);
+        errors[GROUP_ID] = make_float2((float) buffer[0].z, (float) buffer[0].w);
+    }
+}
+
+/**
+ * Update the search direction from the preconditioned residual.
+ */
+KERNEL void updateCGDirection(GLOBAL const float* RESTRICT polarizability, GLOBAL const real* RESTRICT residual, GLOBAL const real* RESTRICT residualPolar,
+        GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT inducedDipolePolar, GLOBAL const real* RESTRICT scalars) {
+    real beta = scalars[2];
+    real betaPolar = scalars[5];
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        real scale = polarizability[index/3];
+        inducedDipole[index] = scale*residual[index] + beta*inducedDipole[index];
+        inducedDipolePolar[index] = scale*residualPolar[index] + betaPolar*inducedDipolePolar[index];
+    }
+}
 #endif // not HIPPO
 
 KERNEL void initExtrapolatedDipoles(GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT extrapolatedDipole
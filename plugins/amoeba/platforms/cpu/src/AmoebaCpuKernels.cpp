@@ -0,0 +1,160 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuKernels.h"
+#include "AmoebaReferenceMultipoleForce.h"
+#include "ReferencePlatform.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/AmoebaVdwForceImpl.h"
+#include "openmm/internal/ContextImpl.h"
+
+using namespace OpenMM;
+using namespace std;
+
+static vector<Vec3>& extractPositions(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->positions;
+}
+
+static vector<Vec3>& extractForces(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->forces;
+}
+
+static Vec3* extractBoxVectors(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return data->periodicBoxVectors;
+}
+
+/* -------------------------------------------------------------------------- *
+ *                                AmoebaVdw                                   *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcAmoebaVdwForceKernel::CpuCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) :
+       CalcAmoebaVdwForceKernel(name, platform), data(data), neighborList(NULL) {
+}
+
+CpuCalcAmoebaVdwForceKernel::~CpuCalcAmoebaVdwForceKernel() {
+    if (neighborList)
+        delete neighborList;
+}
+
+void CpuCalcAmoebaVdwForceKernel::initialize(const System& system, const AmoebaVdwForce& force) {
+    numParticles          = system.getNumParticles();
+    useCutoff             = (force.getNonbondedMethod() != AmoebaVdwForce::NoCutoff);
+    usePBC                = (force.getNonbondedMethod() == AmoebaVdwForce::CutoffPeriodic);
+    cutoff                = force.getCutoffDistance();
+    neighborList          = useCutoff ? new NeighborList() : NULL;
+    dispersionCoefficient = force.getUseDispersionCorrection() ?  AmoebaVdwForceImpl::calcDispersionCorrection(system, force) : 0.0;
+    vdwForce.initialize(force);
+}
+
+double CpuCalcAmoebaVdwForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData   = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    Vec3* boxVectors        = extractBoxVectors(context);
+    double lambda           = context.getParameter(AmoebaVdwForce::Lambda());
+    if (usePBC) {
+        double minAllowedSize = 1.999999*cutoff;
+        if (boxVectors[0][0] < minAllowedSize || boxVectors[1][1] < minAllowedSize || boxVectors[2][2] < minAllowedSize)
+            throw OpenMMException("The periodic box size has decreased to less than twice the cutoff.");
+        vdwForce.setPeriodicBox(boxVectors);
+    }
+    if (useCutoff)
+        computeNeighborListVoxelHash(*neighborList, numParticles, posData, vdwForce.getExclusions(), boxVectors, usePBC, cutoff, 0.0);
+    vdwForce.computeReducedPositions(numParticles, posData, reducedPositions);
+
+    // Divide the interactions between threads.  With a neighbor list each thread takes a contiguous
+    // block of pairs.  Without one, particles are interleaved so each thread gets a similar share of
+    // the triangular N^2 loop.
+
+    int numThreads = data.threads.getNumThreads();
+    threadForce.resize(numThreads);
+    threadEnergy.resize(numThreads);
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<Vec3>& forces = threadForce[threadIndex];
+        forces.assign(numParticles, Vec3());
+        if (useCutoff) {
+            long long numPairs = neighborList->size();
+            int firstPair = (int) ((threadIndex*numPairs)/numThreads);
+            int lastPair = (int) (((threadIndex+1)*numPairs)/numThreads);
+            threadEnergy[threadIndex] = vdwForce.calculateNeighborListIxn(lambda, reducedPositions, *neighborList, firstPair, lastPair, forces);
+        }
+        else
+            threadEnergy[threadIndex] = vdwForce.calculateAllPairsIxn(numParticles, lambda, reducedPositions, threadIndex, numThreads, forces);
+        threads.syncThreads();
+
+        // Sum the per-thread forces, with each thread handling a block of particles.
+
+        int firstParticle = (threadIndex*numParticles)/numThreads;
+        int lastParticle = ((threadIndex+1)*numParticles)/numThreads;
+        for (int i = firstParticle; i < lastParticle; i++)
+            for (int j = 0; j < numThreads; j++)
+                forceData[i] += threadForce[j][i];
+    });
+    data.threads.waitForThreads();
+    data.threads.resumeThreads();
+    data.threads.waitForThreads();
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    if (usePBC)
+        energy += dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+    return energy;
+}
+
+void CpuCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+    vdwForce.initialize(force);
+}
+
+/* -------------------------------------------------------------------------- *
+ *                             AmoebaMultipole                                *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcAmoebaMultipoleForceKernel::CpuCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, const System& system, CpuPlatform::PlatformData& data) :
+       ReferenceCalcAmoebaMultipoleForceKernel(name, platform, system), data(data) {
+}
+
+AmoebaReferenceMultipoleForce* CpuCalcAmoebaMultipoleForceKernel::setupAmoebaReferenceMultipoleForce(ContextImpl& context, bool forExecute) {
+    AmoebaReferenceMultipoleForce* multipoleForce = ReferenceCalcAmoebaMultipoleForceKernel::setupAmoebaReferenceMultipoleForce(context, forExecute);
+    AmoebaReferencePmeMultipoleForce* pmeForce = dynamic_cast<AmoebaReferencePmeMultipoleForce*>(multipoleForce);
+    if (pmeForce != NULL) {
+        // Every pair within the cutoff interacts in direct space, including the ones whose
+        // interactions are scaled, so the neighbor list has no exclusions.
+
+        int numParticles = context.getSystem().getNumParticles();
+        noExclusions.resize(numParticles);
+        computeNeighborListVoxelHash(neighborList, numParticles, extractPositions(context), noExclusions, extractBoxVectors(context), true, pmeForce->getCutoffDistance(), 0.0);
+        pmeForce->setNeighborList(numParticles, neighborList);
+    }
+    return multipoleForce;
+}
+
+ThreadPool* CpuCalcAmoebaMultipoleForceKernel::getThreadPool(ContextImpl& context) {
+    return &data.threads;
+}
@@ -0,0 +1,113 @@
+#ifndef AMOEBA_OPENMM_CPU_KERNELS_H_
+#define AMOEBA_OPENMM_CPU_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/System.h"
+#include "openmm/amoebaKernels.h"
+#include "AmoebaReferenceKernels.h"
+#include "AmoebaReferenceVdwForce.h"
+#include "CpuPlatform.h"
+#include "ReferenceNeighborList.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This kernel is invoked to calculate the vdw forces acting on the system and the energy of the system.
+ * The pair interactions are divided between the threads of the CPU platform, each of which accumulates
+ * forces into its own buffer.
+ */
+class CpuCalcAmoebaVdwForceKernel : public CalcAmoebaVdwForceKernel {
+public:
+    CpuCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data);
+    ~CpuCalcAmoebaVdwForceKernel();
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param force      the AmoebaVdwForce this kernel will be used for
+     */
+    void initialize(const System& system, const AmoebaVdwForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+    /**
+     * Copy changed parameters over to a context.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the AmoebaVdwForce to copy the parameters from
+     */
+    void copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force);
+private:
+    CpuPlatform::PlatformData& data;
+    int numParticles;
+    bool useCutoff;
+    bool usePBC;
+    double cutoff;
+    double dispersionCoefficient;
+    AmoebaReferenceVdwForce vdwForce;
+    NeighborList* neighborList;
+    std::vector<Vec3> reducedPositions;
+    std::vector<std::vector<Vec3> > threadForce;
+    std::vector<double> threadEnergy;
+};
+
+/**
+ * This kernel is invoked by AmoebaMultipoleForce to calculate the forces acting on the system and the energy of the system.
+ * It uses the reference implementation, but divides the pair loops between the CPU platform's threads, and with PME
+ * restricts the direct space loops to a neighbor list.
+ */
+class CpuCalcAmoebaMultipoleForceKernel : public ReferenceCalcAmoebaMultipoleForceKernel {
+public:
+    CpuCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, const System& system, CpuPlatform::PlatformData& data);
+    /**
+     * Setup for AmoebaReferenceMultipoleForce instance.
+     *
+     * @param context        the current context
+     * @param forExecute     true if this is for computing forces and energy in execute()
+     *
+     * @return pointer to initialized instance of AmoebaReferenceMultipoleForce
+     */
+    AmoebaReferenceMultipoleForce* setupAmoebaReferenceMultipoleForce(ContextImpl& context, bool forExecute=false);
+protected:
+    ThreadPool* getThreadPool(ContextImpl& context);
+private:
+    CpuPlatform::PlatformData& data;
+    NeighborList neighborList;
+    std::vector<std::set<int> > noExclusions;
+};
+
+} // namespace OpenMM
+
+#endif /*AMOEBA_OPENMM_CPU_KERNELS_H_*/
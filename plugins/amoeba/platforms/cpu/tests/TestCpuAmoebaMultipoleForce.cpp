@@ -0,0 +1,95 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaTests.h"
+#include "TestAmoebaMultipoleForce.h"
+#include "openmm/VerletIntegrator.h"
+
+void testParallelComputation(AmoebaMultipoleForce::PolarizationType polarization) {
+    const int gridSize = 6;
+    const double spacing = 0.4;
+    const double boxSize = gridSize*spacing;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    AmoebaMultipoleForce* multipole = new AmoebaMultipoleForce();
+    multipole->setNonbondedMethod(AmoebaMultipoleForce::PME);
+    multipole->setPolarizationType(polarization);
+    multipole->setCutoffDistance(0.8);
+    multipole->setMutualInducedTargetEpsilon(1e-6);
+    multipole->setEwaldErrorTolerance(1e-5);
+    system.addForce(multipole);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<double> quadrupole(9, 0.0);
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                // Pairs of oppositely charged ions on a jittered lattice.  Each pair is
+                // bonded so the scaled interactions are exercised along with the full ones.
+
+                int index = system.getNumParticles();
+                double charge = ((i+j+k)%2 == 0 ? 0.5 : -0.5);
+                vector<double> dipole = {0.01*(genrand_real2(sfmt)-0.5), 0.01*(genrand_real2(sfmt)-0.5), 0.01*(genrand_real2(sfmt)-0.5)};
+                system.addParticle(20.0);
+                multipole->addMultipole(charge, dipole, quadrupole, AmoebaMultipoleForce::NoAxisType, -1, -1, -1, 0.39, pow(0.001, 1.0/6.0), 0.001);
+                positions.push_back(spacing*Vec3(i+0.2*genrand_real2(sfmt), j+0.2*genrand_real2(sfmt), k+0.2*genrand_real2(sfmt)));
+                if (k%2 == 1) {
+                    multipole->setCovalentMap(index, AmoebaMultipoleForce::Covalent12, {index-1});
+                    multipole->setCovalentMap(index, AmoebaMultipoleForce::PolarizationCovalent11, {index-1});
+                    multipole->setCovalentMap(index-1, AmoebaMultipoleForce::Covalent12, {index});
+                    multipole->setCovalentMap(index-1, AmoebaMultipoleForce::PolarizationCovalent11, {index});
+                }
+            }
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context referenceContext(system, integrator1, Platform::getPlatformByName("Reference"));
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    Context cpuContext(system, integrator2, platform, properties);
+    referenceContext.setPositions(positions);
+    cpuContext.setPositions(positions);
+    State referenceState = referenceContext.getState(State::Energy | State::Forces);
+    State cpuState = cpuContext.getState(State::Energy | State::Forces);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-5);
+    vector<Vec3> referenceDipoles, cpuDipoles;
+    multipole->getInducedDipoles(referenceContext, referenceDipoles);
+    multipole->getInducedDipoles(cpuContext, cpuDipoles);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceDipoles[i], cpuDipoles[i], 1e-5);
+}
+
+void runPlatformTests() {
+    testParallelComputation(AmoebaMultipoleForce::Direct);
+    testParallelComputation(AmoebaMultipoleForce::Mutual);
+}
@@ -0,0 +1,80 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaTests.h"
+#include "TestAmoebaVdwForce.h"
+#include "openmm/VerletIntegrator.h"
+
+void testParallelComputation(AmoebaVdwForce::NonbondedMethod method) {
+    const int numMolecules = 300;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    AmoebaVdwForce* vdw = new AmoebaVdwForce();
+    vdw->setNonbondedMethod(method);
+    vdw->setCutoff(1.0);
+    system.addForce(vdw);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        // Each molecule has a heavy atom and a hydrogen whose interaction site is reduced
+        // toward it, so both the direct and apportioned force paths are exercised.
+
+        system.addParticle(16.0);
+        system.addParticle(1.0);
+        vdw->addParticle(2*i, 0.17, 0.46, 0.0);
+        vdw->addParticle(2*i, 0.13, 0.06, 0.91);
+        vdw->setParticleExclusions(2*i, {2*i+1});
+        vdw->setParticleExclusions(2*i+1, {2*i});
+        Vec3 pos = boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context referenceContext(system, integrator1, Platform::getPlatformByName("Reference"));
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    Context cpuContext(system, integrator2, platform, properties);
+    referenceContext.setPositions(positions);
+    cpuContext.setPositions(positions);
+    State referenceState = referenceContext.getState(State::Energy | State::Forces);
+    State cpuState = cpuContext.getState(State::Energy | State::Forces);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-6);
+}
+
+void runPlatformTests() {
+    testParallelComputation(AmoebaVdwForce::NoCutoff);
+    testParallelComputation(AmoebaVdwForce::CutoffPeriodic);
+}
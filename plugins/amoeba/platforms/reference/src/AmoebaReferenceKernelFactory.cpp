@@ -31,6 +31,7 @@
 #include "openmm/OpenMMException.h"
 
 using namespace OpenMM;
+using namespace std;
 
 #ifdef OPENMM_BUILDING_STATIC_LIBRARY
 static void registerPlatforms() {
@@ -39,27 +40,35 @@ extern "C" OPENMM_EXPORT void registerPlatforms() {
 #endif
 }
 
-#ifdef OPENMM_BUILDING_STATIC_LIBRARY
-static void registerKernelFactories() {
-#else
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
-#endif
+static void registerAmoebaReferenceKernels() {
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
-             AmoebaReferenceKernelFactory* factory = new AmoebaReferenceKernelFactory();
-             platform.registerKernelFactory(CalcAmoebaTorsionTorsionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaVdwForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaMultipoleForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaGeneralizedKirkwoodForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaWcaDispersionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcHippoNonbondedForceKernel::Name(), factory);
+            // Platforms derived from ReferencePlatform (such as CPU) may provide optimized
+            // versions of some kernels through their own plugins.  Only fill in the ones
+            // that are still missing, so plugin load order does not matter.
+
+            AmoebaReferenceKernelFactory* factory = new AmoebaReferenceKernelFactory();
+            vector<string> kernelNames = {CalcAmoebaTorsionTorsionForceKernel::Name(), CalcAmoebaVdwForceKernel::Name(),
+                    CalcAmoebaMultipoleForceKernel::Name(), CalcAmoebaGeneralizedKirkwoodForceKernel::Name(),
+                    CalcAmoebaWcaDispersionForceKernel::Name(), CalcHippoNonbondedForceKernel::Name()};
+            for (const string& name : kernelNames)
+                if (!platform.supportsKernels(vector<string>(1, name)))
+                    platform.registerKernelFactory(name, factory);
         }
     }
 }
 
+#ifdef OPENMM_BUILDING_STATIC_LIBRARY
+static void registerKernelFactories() {
+#else
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+#endif
+    registerAmoebaReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerAmoebaReferenceKernelFactories() {
-    registerKernelFactories();
+    registerAmoebaReferenceKernels();
 }
 
 KernelImpl* AmoebaReferenceKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
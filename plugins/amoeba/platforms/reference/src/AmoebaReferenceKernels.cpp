@@ -41,6 +41,7 @@
 #include "openmm/internal/NonbondedForceImpl.h"
 #include "SimTKReference/AmoebaReferenceHippoNonbondedForce.h"
 
+#include <algorithm>
 #include <cmath>
 #ifdef _MSC_VER
 #include <windows.h>
@@ -159,12 +160,14 @@ double ReferenceCalcAmoebaTorsionTorsionForceKernel::execute(ContextImpl& contex
  * -------------------------------------------------------------------------- */
 
 ReferenceCalcAmoebaMultipoleForceKernel::ReferenceCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, const System& system) :
-         CalcAmoebaMultipoleForceKernel(name, platform), system(system), numMultipoles(0), mutualInducedMaxIterations(60), mutualInducedTargetEpsilon(1.0e-03),
-                                                         usePme(false),alphaEwald(0.0), cutoffDistance(1.0) {  
+         CalcAmoebaMultipoleForceKernel(name, platform), system(system), numMultipoles(0), mutualInducedMaxIterations(60), mutualInducedUpdateInterval(1), evaluationsSinceSolve(0), mutualInducedTargetEpsilon(1.0e-03),
+                                                         usePme(false),alphaEwald(0.0), cutoffDistance(1.0), threads(NULL) {  
 
 }
 
 ReferenceCalcAmoebaMultipoleForceKernel::~ReferenceCalcAmoebaMultipoleForceKernel() {
+    if (threads != NULL)
+        delete threads;
 }
 
 void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, const AmoebaMultipoleForce& force) {
@@ -234,6 +237,7 @@ void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, c
     if (polarizationType == AmoebaMultipoleForce::Mutual) {
         mutualInducedMaxIterations = force.getMutualInducedMaxIterations();
         mutualInducedTargetEpsilon = force.getMutualInducedTargetEpsilon();
+        mutualInducedUpdateInterval = force.getMutualInducedUpdateInterval();
     } else if (polarizationType == AmoebaMultipoleForce::Extrapolated) {
         extrapolationCoefficients = force.getExtrapolationCoefficients();
     }
@@ -262,7 +266,7 @@ void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, c
     return;
 }
 
-AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmoebaReferenceMultipoleForce(ContextImpl& context)
+AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmoebaReferenceMultipoleForce(ContextImpl& context, bool forExecute)
 {
 
     // amoebaReferenceMultipoleForce is set to AmoebaReferenceGeneralizedKirkwoodForce if AmoebaGeneralizedKirkwoodForce is present
@@ -305,10 +309,19 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
         gkKernel->getCharges(parameters);
         amoebaReferenceGeneralizedKirkwoodForce->setCharges(parameters);
 
-        // calculate Grycuk Born radii
-
-        vector<Vec3>& posData   = extractPositions(context);
-        amoebaReferenceGeneralizedKirkwoodForce->calculateGrycukBornRadii(posData);
+        // calculate Grycuk Born radii, or reuse the ones from a previous evaluation
+
+        vector<double> bornRadii;
+        if (forExecute && gkKernel->getReusableBornRadii(bornRadii))
+            amoebaReferenceGeneralizedKirkwoodForce->setGrycukBornRadii(bornRadii);
+        else {
+            vector<Vec3>& posData   = extractPositions(context);
+            amoebaReferenceGeneralizedKirkwoodForce->calculateGrycukBornRadii(posData);
+            if (forExecute) {
+                amoebaReferenceGeneralizedKirkwoodForce->getGrycukBornRadii(bornRadii);
+                gkKernel->recordBornRadii(bornRadii);
+            }
+        }
 
         amoebaReferenceMultipoleForce = new AmoebaReferenceGeneralizedKirkwoodMultipoleForce(amoebaReferenceGeneralizedKirkwoodForce);
 
@@ -330,6 +343,8 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
          amoebaReferenceMultipoleForce = new AmoebaReferenceMultipoleForce(AmoebaReferenceMultipoleForce::NoCutoff);
     }
 
+    amoebaReferenceMultipoleForce->setThreadPool(getThreadPool(context));
+
     // set polarization type
 
     if (polarizationType == AmoebaMultipoleForce::Mutual) {
@@ -349,9 +364,30 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
 }
 
+ThreadPool* ReferenceCalcAmoebaMultipoleForceKernel::getThreadPool(ContextImpl& context) {
+    // The pair loops are divided between threads.  Platforms that let the user choose the number of threads
+    // have a "Threads" property; otherwise use one thread per processor.
+
+    if (threads == NULL) {
+        int numThreads = 0;
+        const vector<string>& propertyNames = getPlatform().getPropertyNames();
+        if (find(propertyNames.begin(), propertyNames.end(), "Threads") != propertyNames.end())
+            numThreads = stoi(getPlatform().getPropertyValue(context.getOwner(), "Threads"));
+        threads = new ThreadPool(numThreads);
+    }
+    return threads;
+}
+
 double ReferenceCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
 
-    AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce(context);
+    AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce(context, true);
+    amoebaReferenceMultipoleForce->setInducedDipoleHistory(&inducedDipoleHistory);
+
+    // Decide whether to converge the induced dipoles or reuse the ones from the last time they were converged.
+
+    bool reuseDipoles = (!inducedDipoleHistory.empty() && evaluationsSinceSolve+1 < mutualInducedUpdateInterval);
+    amoebaReferenceMultipoleForce->setReuseInducedDipoles(reuseDipoles);
+    evaluationsSinceSolve = (reuseDipoles ? evaluationsSinceSolve+1 : 0);
 
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
@@ -504,6 +540,7 @@ void ReferenceCalcAmoebaMultipoleForceKernel::copyParametersToContext(ContextImp
         quadrupoles[quadrupoleIndex++] = quadrupolesD[7];
         quadrupoles[quadrupoleIndex++] = quadrupolesD[8];
     }
+    inducedDipoleHistory.clear();
 }
 
 void ReferenceCalcAmoebaMultipoleForceKernel::getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
@@ -520,7 +557,7 @@ void ReferenceCalcAmoebaMultipoleForceKernel::getPMEParameters(double& alpha, in
  * -------------------------------------------------------------------------- */
 
 ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel(const std::string& name, const Platform& platform, const System& system) :
-           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), system(system) {
+           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), system(system), bornRadiusUpdateInterval(1), evaluationsSinceUpdate(0) {
 }
 
 ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::~ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel() {
@@ -617,6 +654,7 @@ void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System&
     dielectricOffset   = 0.009;
     probeRadius        = force.getProbeRadius(), 
     surfaceAreaFactor  = force.getSurfaceAreaFactor(); 
+    bornRadiusUpdateInterval = force.getBornRadiusUpdateInterval();
     directPolarization = amoebaMultipoleForce->getPolarizationType() == AmoebaMultipoleForce::Direct ? 1 : 0;
 }
 
@@ -638,6 +676,21 @@ void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::copyParametersToContext(
         scaleFactors[i] = scalingFactor;
         charges[i] = particleCharge;
     }
+    savedBornRadii.clear();
+}
+
+bool ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::getReusableBornRadii(vector<double>& radii) {
+    if (savedBornRadii.empty() || evaluationsSinceUpdate+1 >= bornRadiusUpdateInterval)
+        return false;
+    evaluationsSinceUpdate++;
+    radii = savedBornRadii;
+    return true;
+}
+
+void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::recordBornRadii(const vector<double>& radii) {
+    evaluationsSinceUpdate = 0;
+    if (bornRadiusUpdateInterval > 1)
+        savedBornRadii = radii;
 }
 
 ReferenceCalcAmoebaVdwForceKernel::ReferenceCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, const System& system) :
@@ -97,10 +97,12 @@ public:
      * Setup for AmoebaReferenceMultipoleForce instance. 
      *
      * @param context        the current context
+     * @param forExecute     true if this is for computing forces and energy in execute().  Saved values
+     *                       such as Born radii may only be reused in that case.
      *
      * @return pointer to initialized instance of AmoebaReferenceMultipoleForce
      */
-    AmoebaReferenceMultipoleForce* setupAmoebaReferenceMultipoleForce(ContextImpl& context);
+    virtual AmoebaReferenceMultipoleForce* setupAmoebaReferenceMultipoleForce(ContextImpl& context, bool forExecute=false);
     /**
      * Execute the kernel to calculate the forces and/or energy.
      *
@@ -170,6 +172,15 @@ public:
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
 
+protected:
+    /**
+     * Get the ThreadPool the pair loops should be divided between.  By default this creates a pool
+     * owned by the kernel the first time it is called.
+     *
+     * @param context    the current context
+     */
+    virtual ThreadPool* getThreadPool(ContextImpl& context);
+
 private:
 
     int numMultipoles;
@@ -187,14 +198,16 @@ private:
     std::vector<int>   multipoleAtomYs;
     std::vector< std::vector< std::vector<int> > > multipoleAtomCovalentInfo;
 
-    int mutualInducedMaxIterations;
+    int mutualInducedMaxIterations, mutualInducedUpdateInterval, evaluationsSinceSolve;
     double mutualInducedTargetEpsilon;
     std::vector<double> extrapolationCoefficients;
+    std::vector<std::vector<std::vector<Vec3> > > inducedDipoleHistory;
 
     bool usePme;
     double alphaEwald;
     double cutoffDistance;
     std::vector<int> pmeGridDimension;
+    ThreadPool* threads;
 
     const System& system;
 };
@@ -405,9 +418,27 @@ public:
      */
     void copyParametersToContext(ContextImpl& context, const AmoebaGeneralizedKirkwoodForce& force);
 
+    /**
+     * Get the Born radii computed by an earlier force evaluation, if they should be reused for
+     * this one.  Each successful call counts as one evaluation.
+     *
+     * @param radii   on exit, the saved Born radii
+     * @return true if the saved radii should be reused, false if they must be recomputed
+     */
+    bool getReusableBornRadii(std::vector<double>& radii);
+
+    /**
+     * Save newly computed Born radii so they can be reused by later force evaluations.
+     *
+     * @param radii   the Born radii
+     */
+    void recordBornRadii(const std::vector<double>& radii);
+
 private:
 
     int numParticles;
+    int bornRadiusUpdateInterval, evaluationsSinceUpdate;
+    std::vector<double> savedBornRadii;
     std::vector<double> atomicRadii;
     std::vector<double> scaleFactors;
     std::vector<double> charges;
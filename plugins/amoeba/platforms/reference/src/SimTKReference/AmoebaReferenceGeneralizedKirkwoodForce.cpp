@@ -132,6 +132,10 @@ void AmoebaReferenceGeneralizedKirkwoodForce::getGrycukBornRadii(vector<double>&
     copy(_bornRadii.begin(), _bornRadii.end(), bornRadii.begin());
 }
 
+void AmoebaReferenceGeneralizedKirkwoodForce::setGrycukBornRadii(const vector<double>& bornRadii) {
+    _bornRadii = bornRadii;
+}
+
 void AmoebaReferenceGeneralizedKirkwoodForce::calculateGrycukBornRadii(const vector<Vec3>& particlePositions) {
 
     const double bigRadius = 1000.0;
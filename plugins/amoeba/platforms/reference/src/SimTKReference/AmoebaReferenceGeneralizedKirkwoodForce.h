@@ -231,6 +231,14 @@ public:
      */
     void getGrycukBornRadii(vector<double>& bornRadii) const;     
 
+    /**
+     * Set the Grycuk Born radii to use instead of calling calculateGrycukBornRadii()
+     *
+     * @param bornRadii vector of Born radii
+     *
+     */
+    void setGrycukBornRadii(const vector<double>& bornRadii);
+
 private:
 
     int _numParticles;
@@ -48,7 +48,10 @@ AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce() :
                                                    _maximumMutualInducedDipoleIterations(100),
                                                    _mutualInducedDipoleEpsilon(1.0e+50),
                                                    _mutualInducedDipoleTargetEpsilon(1.0e-04),
-                                                   _debye(48.033324)
+                                                   _debye(48.033324),
+                                                   _inducedDipoleHistory(NULL),
+                                                   _reuseInducedDipoles(false),
+                                                   _threads(NULL)
 {
     initialize();
 }
@@ -63,7 +66,10 @@ AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce(NonbondedMethod non
                                                    _maximumMutualInducedDipoleIterations(100),
                                                    _mutualInducedDipoleEpsilon(1.0e+50),
                                                    _mutualInducedDipoleTargetEpsilon(1.0e-04),
-                                                   _debye(48.033324)
+                                                   _debye(48.033324),
+                                                   _inducedDipoleHistory(NULL),
+                                                   _reuseInducedDipoles(false),
+                                                   _threads(NULL)
 {
     initialize();
 }
@@ -182,6 +188,21 @@ void AmoebaReferenceMultipoleForce::setMutualInducedDipoleTargetEpsilon(double m
     _mutualInducedDipoleTargetEpsilon = mutualInducedDipoleTargetEpsilon;
 }
 
+void AmoebaReferenceMultipoleForce::setInducedDipoleHistory(vector<vector<vector<Vec3> > >* history)
+{
+    _inducedDipoleHistory = history;
+}
+
+void AmoebaReferenceMultipoleForce::setReuseInducedDipoles(bool reuse)
+{
+    _reuseInducedDipoles = reuse;
+}
+
+void AmoebaReferenceMultipoleForce::setThreadPool(ThreadPool* threads)
+{
+    _threads = threads;
+}
+
 void AmoebaReferenceMultipoleForce::setupScaleMaps(const vector< vector< vector<int> > >& multipoleParticleCovalentInfo)
 {
 
@@ -247,7 +268,7 @@ void AmoebaReferenceMultipoleForce::setupScaleMaps(const vector< vector< vector<
 double AmoebaReferenceMultipoleForce::getMultipoleScaleFactor(unsigned int particleI, unsigned int particleJ, ScaleType scaleType) const
 {
 
-    MapIntRealOpenMM  scaleMap   = _scaleMaps[particleI][scaleType];
+    const MapIntRealOpenMM& scaleMap = _scaleMaps[particleI][scaleType];
     MapIntRealOpenMMCI isPresent = scaleMap.find(particleJ);
     if (isPresent != scaleMap.end()) {
         return isPresent->second;
@@ -887,9 +908,79 @@ void AmoebaReferenceMultipoleForce::calculateInducedDipoleFields(const vector<Mu
 
     // Add fields from all induced dipoles.
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++)
+    accumulateInducedDipoleFieldRows(updateInducedDipoleFields, [&] (unsigned int ii, vector<UpdateInducedDipoleFieldStruct>& fields) {
         for (unsigned int jj = ii; jj < particleData.size(); jj++)
-            calculateInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
+            calculateInducedDipolePairIxns(particleData[ii], particleData[jj], fields);
+    });
+}
+
+void AmoebaReferenceMultipoleForce::accumulateInducedDipoleFieldRows(vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields,
+                                                                     const std::function<void(unsigned int, vector<UpdateInducedDipoleFieldStruct>&)>& computeRow)
+{
+    int numThreads = (_threads == NULL ? 1 : _threads->getNumThreads());
+    if (numThreads == 1) {
+        for (unsigned int ii = 0; ii < _numParticles; ii++)
+            computeRow(ii, updateInducedDipoleFields);
+        return;
+    }
+
+    // Each thread accumulates into its own copy of the fields.  The copies share the input dipoles.
+    // Rows are interleaved between threads, since rows near the start of the triangular loop have more pairs.
+
+    vector<vector<UpdateInducedDipoleFieldStruct> > threadFields(numThreads, updateInducedDipoleFields);
+    _threads->execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<UpdateInducedDipoleFieldStruct>& fields = threadFields[threadIndex];
+        for (auto& field : fields) {
+            std::fill(field.inducedDipoleField.begin(), field.inducedDipoleField.end(), Vec3());
+            for (auto& gradient : field.inducedDipoleFieldGradient)
+                std::fill(gradient.begin(), gradient.end(), 0.0);
+        }
+        for (unsigned int ii = threadIndex; ii < _numParticles; ii += numThreads)
+            computeRow(ii, fields);
+    });
+    _threads->waitForThreads();
+
+    // Sum the contributions in thread order, so the result does not depend on how the threads were scheduled.
+
+    for (int thread = 0; thread < numThreads; thread++) {
+        for (unsigned int i = 0; i < updateInducedDipoleFields.size(); i++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[i];
+            const UpdateInducedDipoleFieldStruct& threadField = threadFields[thread][i];
+            for (unsigned int j = 0; j < field.inducedDipoleField.size(); j++)
+                field.inducedDipoleField[j] += threadField.inducedDipoleField[j];
+            for (unsigned int j = 0; j < field.inducedDipoleFieldGradient.size(); j++)
+                for (unsigned int k = 0; k < field.inducedDipoleFieldGradient[j].size(); k++)
+                    field.inducedDipoleFieldGradient[j][k] += threadField.inducedDipoleFieldGradient[j][k];
+        }
+    }
+}
+
+double AmoebaReferenceMultipoleForce::accumulateElectrostaticRows(vector<Vec3>& forces, vector<Vec3>& torques,
+                                                                  const std::function<double(unsigned int, vector<Vec3>&, vector<Vec3>&)>& computeRow)
+{
+    int numThreads = (_threads == NULL ? 1 : _threads->getNumThreads());
+    double energy = 0.0;
+    if (numThreads == 1) {
+        for (unsigned int ii = 0; ii < _numParticles; ii++)
+            energy += computeRow(ii, forces, torques);
+        return energy;
+    }
+    vector<vector<Vec3> > threadForces(numThreads, vector<Vec3>(forces.size()));
+    vector<vector<Vec3> > threadTorques(numThreads, vector<Vec3>(torques.size()));
+    vector<double> threadEnergy(numThreads, 0.0);
+    _threads->execute([&] (ThreadPool& threads, int threadIndex) {
+        for (unsigned int ii = threadIndex; ii < _numParticles; ii += numThreads)
+            threadEnergy[threadIndex] += computeRow(ii, threadForces[threadIndex], threadTorques[threadIndex]);
+    });
+    _threads->waitForThreads();
+    for (int thread = 0; thread < numThreads; thread++) {
+        energy += threadEnergy[thread];
+        for (unsigned int i = 0; i < forces.size(); i++)
+            forces[i] += threadForces[thread][i];
+        for (unsigned int i = 0; i < torques.size(); i++)
+            torques[i] += threadTorques[thread][i];
+    }
+    return energy;
 }
 
 void AmoebaReferenceMultipoleForce::convergeInduceDipolesByExtrapolation(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
@@ -940,6 +1031,163 @@ void AmoebaReferenceMultipoleForce::convergeInduceDipolesByExtrapolation(const v
     setMutualInducedDipoleConverged(true);
 }
 
+/**
+ * The number of previous induced dipoles used to predict the initial guess for mutual polarization.
+ */
+static const int MaxPrevASPCDipoles = 6;
+
+static double binomialCoefficient(int n, int k) {
+    if (k < 0 || k > n)
+        return 0.0;
+    double result = 1.0;
+    for (int i = 1; i <= k; i++)
+        result = result*(n-k+i)/i;
+    return result;
+}
+
+static void computeASPCCoefficients(int numPrevious, vector<double>& coefficients) {
+    // These are the coefficients of Kolafa's always stable predictor, J. Comput. Chem. 25, 335 (2004),
+    // using as many previous values as are available.
+
+    coefficients.resize(numPrevious);
+    if (numPrevious == 1) {
+        coefficients[0] = 1.0;
+        return;
+    }
+    int k = numPrevious-2;
+    for (int j = 1; j <= numPrevious; j++)
+        coefficients[j-1] = (j%2 == 1 ? 1 : -1)*j*binomialCoefficient(2*k+4, k+2-j)/binomialCoefficient(2*k+2, k+1);
+}
+
+void AmoebaReferenceMultipoleForce::convergeMutualInducedDipoles(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
+    int numFields = updateInducedDipoleField.size();
+    if (_reuseInducedDipoles && _inducedDipoleHistory != NULL && _inducedDipoleHistory->size() > 0 && (int) (*_inducedDipoleHistory)[0].size() == numFields) {
+        // Use the most recently converged dipoles without iterating.  The fields still need to be computed,
+        // since the PME forces are computed from them.
+
+        for (int k = 0; k < numFields; k++)
+            *updateInducedDipoleField[k].inducedDipoles = (*_inducedDipoleHistory)[0][k];
+        calculateInducedDipoleFields(particleData, updateInducedDipoleField);
+        setMutualInducedDipoleConverged(true);
+        return;
+    }
+    if (_inducedDipoleHistory != NULL && _inducedDipoleHistory->size() > 0 && (int) (*_inducedDipoleHistory)[0].size() == numFields) {
+        // Predict the initial dipoles from the previous ones with the always stable predictor.
+
+        vector<double> coefficients;
+        computeASPCCoefficients(_inducedDipoleHistory->size(), coefficients);
+        for (int k = 0; k < numFields; k++) {
+            vector<Vec3>& dipoles = *updateInducedDipoleField[k].inducedDipoles;
+            for (int i = 0; i < _numParticles; i++) {
+                dipoles[i] = Vec3();
+                for (int j = 0; j < (int) coefficients.size(); j++)
+                    dipoles[i] += (*_inducedDipoleHistory)[j][k][i]*coefficients[j];
+            }
+        }
+    }
+    convergeInduceDipolesByPCG(particleData, updateInducedDipoleField);
+    if (!getMutualInducedDipoleConverged())
+        convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+    if (_inducedDipoleHistory != NULL) {
+        if (_inducedDipoleHistory->size() > 0 && (int) (*_inducedDipoleHistory)[0].size() != numFields)
+            _inducedDipoleHistory->clear();
+        if ((int) _inducedDipoleHistory->size() == MaxPrevASPCDipoles)
+            _inducedDipoleHistory->pop_back();
+        vector<vector<Vec3> > dipoles(numFields);
+        for (int k = 0; k < numFields; k++)
+            dipoles[k] = *updateInducedDipoleField[k].inducedDipoles;
+        _inducedDipoleHistory->insert(_inducedDipoleHistory->begin(), dipoles);
+    }
+}
+
+void AmoebaReferenceMultipoleForce::convergeInduceDipolesByPCG(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
+    // This solves (1/alpha - T)*mu = E using the polarizabilities as a Jacobi preconditioner.  With that choice,
+    // the preconditioned residual is just the difference between the dipoles induced by the current ones and the
+    // current ones.  The field from the search direction is computed by temporarily storing it as the induced dipoles.
+
+    int numFields = updateInducedDipoleField.size();
+    vector<vector<Vec3> > dipoles(numFields), residual(numFields), precondResidual(numFields), direction(numFields);
+    vector<double> residualDot(numFields, 0.0);
+    setMutualInducedDipoleConverged(false);
+    calculateInducedDipoleFields(particleData, updateInducedDipoleField);
+    for (int k = 0; k < numFields; k++) {
+        UpdateInducedDipoleFieldStruct& field = updateInducedDipoleField[k];
+        dipoles[k] = *field.inducedDipoles;
+        residual[k].resize(_numParticles);
+        precondResidual[k].resize(_numParticles);
+        for (int i = 0; i < _numParticles; i++) {
+            double polarity = particleData[i].polarity;
+            Vec3 error = (*field.fixedMultipoleField)[i] + field.inducedDipoleField[i]*polarity - dipoles[k][i];
+            precondResidual[k][i] = error;
+            residual[k][i] = (polarity == 0.0 ? Vec3() : error/polarity);
+            residualDot[k] += residual[k][i].dot(precondResidual[k][i]);
+        }
+        direction[k] = precondResidual[k];
+    }
+    for (int iteration = 0; ; iteration++) {
+        // Decide whether to stop or continue iterating.
+
+        double maxEpsilon = 0;
+        for (int k = 0; k < numFields; k++) {
+            double epsilon = 0;
+            for (int i = 0; i < _numParticles; i++)
+                epsilon += precondResidual[k][i].dot(precondResidual[k][i]);
+            if (epsilon > maxEpsilon)
+                maxEpsilon = epsilon;
+        }
+        maxEpsilon = _debye*sqrt(maxEpsilon/_numParticles);
+        bool converged = (maxEpsilon < getMutualInducedDipoleTargetEpsilon());
+        if (converged || iteration == getMaximumMutualInducedDipoleIterations()) {
+            // Compute the field from the final dipoles, since the rest of the calculation depends on it.
+
+            for (int k = 0; k < numFields; k++)
+                *updateInducedDipoleField[k].inducedDipoles = dipoles[k];
+            calculateInducedDipoleFields(particleData, updateInducedDipoleField);
+            setMutualInducedDipoleConverged(converged);
+            setMutualInducedDipoleEpsilon(maxEpsilon);
+            setMutualInducedDipoleIterations(iteration);
+            return;
+        }
+
+        // Compute the product of the matrix with each search direction.
+
+        for (int k = 0; k < numFields; k++)
+            *updateInducedDipoleField[k].inducedDipoles = direction[k];
+        calculateInducedDipoleFields(particleData, updateInducedDipoleField);
+
+        // Update the dipoles, residuals, and search directions.
+
+        for (int k = 0; k < numFields; k++) {
+            if (residualDot[k] == 0.0)
+                continue;
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleField[k];
+            vector<Vec3> product(_numParticles);
+            double directionDot = 0;
+            for (int i = 0; i < _numParticles; i++) {
+                double polarity = particleData[i].polarity;
+                if (polarity != 0.0) {
+                    product[i] = direction[k][i]/polarity - field.inducedDipoleField[i];
+                    directionDot += direction[k][i].dot(product[i]);
+                }
+            }
+            if (directionDot == 0.0)
+                continue;
+            double alpha = residualDot[k]/directionDot;
+            double newResidualDot = 0;
+            for (int i = 0; i < _numParticles; i++) {
+                dipoles[k][i] += direction[k][i]*alpha;
+                residual[k][i] -= product[i]*alpha;
+                precondResidual[k][i] = residual[k][i]*particleData[i].polarity;
+                newResidualDot += residual[k][i].dot(precondResidual[k][i]);
+            }
+            double beta = newResidualDot/residualDot[k];
+            residualDot[k] = newResidualDot;
+            for (int i = 0; i < _numParticles; i++)
+                direction[k][i] = precondResidual[k][i] + direction[k][i]*beta;
+        }
+    }
+}
+
 void AmoebaReferenceMultipoleForce::convergeInduceDipolesByDIIS(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
     int numFields = updateInducedDipoleField.size();
     vector<vector<vector<Vec3> > > prevDipoles(numFields);
@@ -1080,7 +1328,7 @@ void AmoebaReferenceMultipoleForce::calculateInducedDipoles(const vector<Multipo
     // UpdateInducedDipoleFieldStruct contains induced dipole, fixed multipole fields and fields
     // due to other induced dipoles at each site
     if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual)
-        convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+        convergeMutualInducedDipoles(particleData, updateInducedDipoleField);
     else if (getPolarizationType() == AmoebaReferenceMultipoleForce::Extrapolated)
         convergeInduceDipolesByExtrapolation(particleData, updateInducedDipoleField);
 }
@@ -1719,21 +1967,18 @@ double AmoebaReferenceMultipoleForce::calculateElectrostatic(const vector<Multip
                                                              vector<Vec3>& torques,
                                                              vector<Vec3>& forces)
 {
-    double energy = 0.0;
-    vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
-    for (auto& s : scaleFactors)
-        s = 1.0;
-
     // main loop over particle pairs
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
+    double energy = accumulateElectrostaticRows(forces, torques, [&] (unsigned int ii, vector<Vec3>& rowForces, vector<Vec3>& rowTorques) {
+        double rowEnergy = 0.0;
+        vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX, 1.0);
         for (unsigned int jj = ii+1; jj < particleData.size(); jj++) {
 
             if (jj <= _maxScaleIndex[ii]) {
                 getMultipoleScaleFactors(ii, jj, scaleFactors);
             }
 
-            energy += calculateElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors, forces, torques);
+            rowEnergy += calculateElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors, rowForces, rowTorques);
 
             if (jj <= _maxScaleIndex[ii]) {
                 for (unsigned int kk = 0; kk < LAST_SCALE_TYPE_INDEX; kk++) {
@@ -1741,7 +1986,8 @@ double AmoebaReferenceMultipoleForce::calculateElectrostatic(const vector<Multip
                 }
             }
         }
-    }
+        return rowEnergy;
+    });
     if (getPolarizationType() == AmoebaReferenceMultipoleForce::Extrapolated) {
         double prefac = (_electric/_dielectric);
         for (int i = 0; i < _numParticles; i++) {
@@ -2534,7 +2780,7 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateInducedDipoles(c
     updateInducedDipoleField.push_back(UpdateInducedDipoleFieldStruct(gkFieldPolar, _inducedDipolePolarS, _ptDipolePS, _ptDipoleFieldGradientPS));
 
     if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual)
-        convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+        convergeMutualInducedDipoles(particleData, updateInducedDipoleField);
     else if (getPolarizationType() == AmoebaReferenceMultipoleForce::Extrapolated)
         convergeInduceDipolesByExtrapolation(particleData, updateInducedDipoleField);
 }
@@ -4809,7 +5055,7 @@ const double AmoebaReferencePmeMultipoleForce::SQRT_PI = 1.77245385091;
 
 AmoebaReferencePmeMultipoleForce::AmoebaReferencePmeMultipoleForce() :
                AmoebaReferenceMultipoleForce(PME),
-               _cutoffDistance(1.0), _cutoffDistanceSquared(1.0),
+               _cutoffDistance(1.0), _cutoffDistanceSquared(1.0), _useNeighborList(false),
                _pmeGridSize(0), _totalGridSize(0), _alphaEwald(0.0)
 {
 
@@ -4890,6 +5136,24 @@ void AmoebaReferencePmeMultipoleForce::setPeriodicBoxSize(OpenMM::Vec3* vectors)
     _recipBoxVectors[2] = Vec3(vectors[1][0]*vectors[2][1]-vectors[1][1]*vectors[2][0], -vectors[0][0]*vectors[2][1], vectors[0][0]*vectors[1][1])*scale;
 };
 
+void AmoebaReferencePmeMultipoleForce::setNeighborList(int numParticles, const NeighborList& neighbors)
+{
+    // Store the neighbors of each particle that have higher indices, sorted so pairs are visited
+    // in the same order as the all pairs loops.
+
+    _neighbors.resize(numParticles);
+    for (auto& row : _neighbors)
+        row.clear();
+    for (auto& pair : neighbors) {
+        unsigned int first = std::min(pair.first, pair.second);
+        unsigned int second = std::max(pair.first, pair.second);
+        _neighbors[first].push_back(second);
+    }
+    for (auto& row : _neighbors)
+        std::sort(row.begin(), row.end());
+    _useNeighborList = true;
+}
+
 int compareInt2(const int2& v1, const int2& v2)
 {
     return v1[1] < v2[1];
@@ -5193,7 +5457,21 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector
 
     // include direct space fixed multipole fields
 
-    this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField(particleData);
+    if (!_useNeighborList) {
+        this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField(particleData);
+        return;
+    }
+    for (unsigned int ii = 0; ii < _numParticles; ii++) {
+        for (unsigned int jj : _neighbors[ii]) {
+            double dScale, pScale;
+            if (jj <= _maxScaleIndex[ii]) {
+                getDScaleAndPScale(ii, jj, dScale, pScale);
+            } else {
+                dScale = pScale = 1.0;
+            }
+            calculateFixedMultipoleFieldPairIxn(particleData[ii], particleData[jj], dScale, pScale);
+        }
+    }
 }
 
 #define ARRAY(x,y) array[(x)-1+((y)-1)*AMOEBA_PME_ORDER]
@@ -6070,11 +6348,16 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
 
     // Add fields from direct space interactions.
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii + 1; jj < particleData.size(); jj++) {
-            calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
+    accumulateInducedDipoleFieldRows(updateInducedDipoleFields, [&] (unsigned int ii, vector<UpdateInducedDipoleFieldStruct>& fields) {
+        if (_useNeighborList) {
+            for (unsigned int jj : _neighbors[ii])
+                calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], fields);
         }
-    }
+        else {
+            for (unsigned int jj = ii + 1; jj < particleData.size(); jj++)
+                calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], fields);
+        }
+    });
 
     // reciprocal space ixns
 
@@ -6756,28 +7039,34 @@ double AmoebaReferencePmeMultipoleForce::calculatePmeDirectElectrostaticPairIxn(
 double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<MultipoleParticleData>& particleData,
                                                                 vector<Vec3>& torques, vector<Vec3>& forces)
 {
-    double energy = 0.0;
-    vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
-    for (auto& s : scaleFactors)
-        s = 1.0;
-
     // loop over particle pairs for direct space interactions
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii+1; jj < particleData.size(); jj++) {
+    double energy = accumulateElectrostaticRows(forces, torques, [&] (unsigned int ii, vector<Vec3>& rowForces, vector<Vec3>& rowTorques) {
+        double rowEnergy = 0.0;
+        vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX, 1.0);
+        auto computePair = [&] (unsigned int jj) {
 
             if (jj <= _maxScaleIndex[ii]) {
                 getMultipoleScaleFactors(ii, jj, scaleFactors);
             }
 
-            energy += calculatePmeDirectElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors, forces, torques);
+            rowEnergy += calculatePmeDirectElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors, rowForces, rowTorques);
 
             if (jj <= _maxScaleIndex[ii]) {
                 for (auto& s : scaleFactors)
                     s = 1.0;
             }
+        };
+        if (_useNeighborList) {
+            for (unsigned int jj : _neighbors[ii])
+                computePair(jj);
         }
-    }
+        else {
+            for (unsigned int jj = ii+1; jj < particleData.size(); jj++)
+                computePair(jj);
+        }
+        return rowEnergy;
+    });
 
     // The polarization energy
     calculatePmeSelfTorque(particleData, torques);
@@ -26,9 +26,12 @@
 
 #include "openmm/AmoebaMultipoleForce.h"
 #include "openmm/Vec3.h"
+#include "openmm/internal/ThreadPool.h"
 #include "AmoebaReferenceGeneralizedKirkwoodForce.h"
+#include "ReferenceNeighborList.h"
 #include <map>
 #include <complex>
+#include <functional>
 
 namespace OpenMM {
 
@@ -443,6 +446,34 @@ public:
      */
     void setMutualInducedDipoleTargetEpsilon(double targetEpsilon);
 
+    /**
+     * Set the storage for the induced dipoles from previous calculations.  If this is set, the converged
+     * mutual induced dipoles are recorded into it and used to predict the initial guess for the next calculation.
+     *
+     * @param history the induced dipole history, or NULL to always start from the direct dipoles
+     *
+     */
+    void setInducedDipoleHistory(std::vector<std::vector<std::vector<Vec3> > >* history);
+
+    /**
+     * Set whether to reuse the most recent dipoles in the induced dipole history instead of converging
+     * the mutual induced dipoles.  This has no effect if the history is empty.
+     *
+     * @param reuse  true to reuse the previous dipoles
+     *
+     */
+    void setReuseInducedDipoles(bool reuse);
+
+    /**
+     * Set the thread pool used to parallelize the loops over particle pairs.  The pairs are divided
+     * between threads by row, each thread accumulates into its own buffers, and the buffers are summed
+     * in a fixed order, so the results for a given number of threads do not depend on scheduling.
+     *
+     * @param threads the thread pool to use, or NULL to do all calculations on the calling thread
+     *
+     */
+    void setThreadPool(ThreadPool* threads);
+
     /**
      * Get the target epsilon for converging mutual induced dipoles.
      *
@@ -750,6 +781,9 @@ protected:
     double  _mutualInducedDipoleEpsilon;
     double  _mutualInducedDipoleTargetEpsilon;
     double  _debye;
+    std::vector<std::vector<std::vector<Vec3> > >* _inducedDipoleHistory;
+    bool _reuseInducedDipoles;
+    ThreadPool* _threads;
 
     /**
      * Helper constructor method to centralize initialization of objects.
@@ -1011,6 +1045,30 @@ protected:
      */
     virtual void calculateInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
                                               std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+
+    /**
+     * Add the pairwise contributions to the induced dipole fields, dividing the rows of the pair
+     * loop between the threads in the thread pool if one has been set.
+     *
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     * @param computeRow                adds the contributions of all pairs (ii, jj) with jj >= ii for row ii to the fields passed to it
+     */
+    void accumulateInducedDipoleFieldRows(std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields,
+                                          const std::function<void(unsigned int, std::vector<UpdateInducedDipoleFieldStruct>&)>& computeRow);
+
+    /**
+     * Add the pairwise contributions to the forces, torques, and energy, dividing the rows of the pair
+     * loop between the threads in the thread pool if one has been set.
+     *
+     * @param forces     forces to add to
+     * @param torques    torques to add to
+     * @param computeRow adds the contributions of all pairs (ii, jj) with jj > ii for row ii to the forces
+     *                   and torques passed to it, and returns their energy
+     *
+     * @return the energy of all pairs
+     */
+    double accumulateElectrostaticRows(std::vector<Vec3>& forces, std::vector<Vec3>& torques,
+                                       const std::function<double(unsigned int, std::vector<Vec3>&, std::vector<Vec3>&)>& computeRow);
     /**
      * Calculated induced dipoles using extrapolated perturbation theory.
      *
@@ -1019,6 +1077,24 @@ protected:
      */
     void convergeInduceDipolesByExtrapolation(const std::vector<MultipoleParticleData>& particleData,
                                               std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField);
+    /**
+     * Converge mutual induced dipoles.  The initial guess is predicted from the induced dipole history, the dipoles
+     * are converged by preconditioned conjugate gradients (falling back to DIIS if that fails), and the result is
+     * recorded into the history.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    void convergeMutualInducedDipoles(const std::vector<MultipoleParticleData>& particleData,
+                                      std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+    /**
+     * Converge induced dipoles with preconditioned conjugate gradients.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    void convergeInduceDipolesByPCG(const std::vector<MultipoleParticleData>& particleData,
+                                    std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
     /**
      * Converge induced dipoles.
      * 
@@ -1458,6 +1534,16 @@ public:
      */
      void setPeriodicBoxSize(OpenMM::Vec3* vectors);
 
+    /**
+     * Set a neighbor list to use for the direct space pair loops.  It must contain every pair of particles
+     * within the cutoff.  If this is not called, the loops visit every pair and skip the ones that are
+     * beyond the cutoff.
+     *
+     * @param numParticles  the number of particles in the system
+     * @param neighbors     the neighbor list
+     */
+    void setNeighborList(int numParticles, const NeighborList& neighbors);
+
 private:
 
     static const int AMOEBA_PME_ORDER;
@@ -1467,6 +1553,9 @@ private:
     double _cutoffDistance;
     double _cutoffDistanceSquared;
 
+    bool _useNeighborList;
+    std::vector<std::vector<unsigned int> > _neighbors;
+
     Vec3 _recipBoxVectors[3];
     Vec3 _periodicBoxVectors[3];
 
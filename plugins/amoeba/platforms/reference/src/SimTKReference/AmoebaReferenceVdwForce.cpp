@@ -192,6 +192,12 @@ void AmoebaReferenceVdwForce::setReducedPositions(int numParticles,
     }
 }
 
+void AmoebaReferenceVdwForce::computeReducedPositions(int numParticles,
+                                                      const vector<Vec3>& particlePositions,
+                                                      vector<Vec3>& reducedPositions) const {
+    setReducedPositions(numParticles, particlePositions, indexIVs, reductions, reducedPositions);
+}
+
 double AmoebaReferenceVdwForce::calculateForceAndEnergy(int numParticles, double lambda,
                                                         const vector<Vec3>& particlePositions,
                                                         vector<Vec3>& forces) const {
@@ -200,6 +206,13 @@ double AmoebaReferenceVdwForce::calculateForceAndEnergy(int numParticles, double
 
     std::vector<Vec3> reducedPositions;
     setReducedPositions(numParticles, particlePositions, indexIVs, reductions, reducedPositions);
+    return calculateAllPairsIxn(numParticles, lambda, reducedPositions, 0, 1, forces);
+}
+
+double AmoebaReferenceVdwForce::calculateAllPairsIxn(int numParticles, double lambda,
+                                                     const vector<Vec3>& reducedPositions,
+                                                     int firstParticle, int particleStride,
+                                                     vector<Vec3>& forces) const {
 
     // loop over all particle pairs
 
@@ -212,7 +225,7 @@ double AmoebaReferenceVdwForce::calculateForceAndEnergy(int numParticles, double
 
     double energy = 0.0;
     std::vector<unsigned int> exclusions(numParticles, 0);
-    for (unsigned int ii = 0; ii < static_cast<unsigned int>(numParticles); ii++) {
+    for (unsigned int ii = firstParticle; ii < static_cast<unsigned int>(numParticles); ii += particleStride) {
 
         bool isAlchemicalI = isAlchemical[ii];
         for (int jj : allExclusions[ii])
@@ -270,6 +283,12 @@ double AmoebaReferenceVdwForce::calculateForceAndEnergy(int numParticles, double
 
     std::vector<Vec3> reducedPositions;
     setReducedPositions(numParticles, particlePositions, indexIVs, reductions, reducedPositions);
+    return calculateNeighborListIxn(lambda, reducedPositions, neighborList, 0, neighborList.size(), forces);
+}
+
+double AmoebaReferenceVdwForce::calculateNeighborListIxn(double lambda, const vector<Vec3>& reducedPositions,
+                                                         const NeighborList& neighborList, int firstPair, int lastPair,
+                                                         vector<Vec3>& forces) const {
 
     // loop over neighbor list
     //    (1) calculate pair vdw ixn
@@ -278,7 +297,7 @@ double AmoebaReferenceVdwForce::calculateForceAndEnergy(int numParticles, double
     //        based on reduction factor
 
     double energy = 0.0;
-    for (unsigned int ii = 0; ii < neighborList.size(); ii++) {
+    for (int ii = firstPair; ii < lastPair; ii++) {
 
         OpenMM::AtomPair pair       = neighborList[ii];
         int siteI                   = pair.first;
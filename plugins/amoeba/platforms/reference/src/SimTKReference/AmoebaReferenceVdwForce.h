@@ -114,6 +114,59 @@ public:
     
     double calculateForceAndEnergy(int numParticles, double lambda, const std::vector<OpenMM::Vec3>& particlePositions, 
                                    const NeighborList& neighborList, std::vector<OpenMM::Vec3>& forces) const;
+
+    /**---------------------------------------------------------------------------------------
+    
+       Compute the positions of the interaction sites, which are moved towards the
+       covalent partner of each particle by its reduction factor
+    
+       @param numParticles            number of particles
+       @param particlePositions       Cartesian coordinates of particles
+       @param reducedPositions        output: interaction site positions
+    
+       --------------------------------------------------------------------------------------- */
+    
+    void computeReducedPositions(int numParticles, const std::vector<OpenMM::Vec3>& particlePositions,
+                                 std::vector<OpenMM::Vec3>& reducedPositions) const;
+
+    /**---------------------------------------------------------------------------------------
+    
+       Calculate Amoeba Hal vdw ixns between a subset of particles and all particles
+       with higher indices.  This allows the N^2 loop to be divided between threads:
+       particle i is processed if i = firstParticle + k*particleStride for some k.
+    
+       @param numParticles            number of particles
+       @param lambda                  lambda value
+       @param reducedPositions        interaction site positions from computeReducedPositions()
+       @param firstParticle           index of the first particle to process
+       @param particleStride          stride between processed particles
+       @param forces                  add forces to this vector
+    
+       @return energy
+    
+       --------------------------------------------------------------------------------------- */
+    
+    double calculateAllPairsIxn(int numParticles, double lambda, const std::vector<OpenMM::Vec3>& reducedPositions,
+                                int firstParticle, int particleStride, std::vector<OpenMM::Vec3>& forces) const;
+
+    /**---------------------------------------------------------------------------------------
+    
+       Calculate Vdw ixn for a contiguous range of entries in a neighbor list
+    
+       @param lambda                  lambda value
+       @param reducedPositions        interaction site positions from computeReducedPositions()
+       @param neighborList            neighbor list
+       @param firstPair               index of the first neighbor list entry to process
+       @param lastPair                one past the index of the last entry to process
+       @param forces                  add forces to this vector
+    
+       @return energy
+    
+       --------------------------------------------------------------------------------------- */
+    
+    double calculateNeighborListIxn(double lambda, const std::vector<OpenMM::Vec3>& reducedPositions,
+                                    const NeighborList& neighborList, int firstPair, int lastPair,
+                                    std::vector<OpenMM::Vec3>& forces) const;
          
 private:
     // taper coefficient indices
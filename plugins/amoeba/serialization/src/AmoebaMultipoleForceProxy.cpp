@@ -68,7 +68,7 @@ void loadCovalentMap(const SerializationNode& map, std::vector< int >& covalentM
 }
 
 void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 4);
+    node.setIntProperty("version", 5);
     const AmoebaMultipoleForce& force = *reinterpret_cast<const AmoebaMultipoleForce*>(object);
 
     node.setIntProperty("forceGroup", force.getForceGroup());
@@ -76,6 +76,7 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
     node.setIntProperty("nonbondedMethod",                  force.getNonbondedMethod());
     node.setIntProperty("polarizationType",                 force.getPolarizationType());
     node.setIntProperty("mutualInducedMaxIterations",       force.getMutualInducedMaxIterations());
+    node.setIntProperty("mutualInducedUpdateInterval",      force.getMutualInducedUpdateInterval());
 
     node.setDoubleProperty("cutoffDistance",                force.getCutoffDistance());
     double alpha;
@@ -133,7 +134,7 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
 
 void* AmoebaMultipoleForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 0 || version > 4)
+    if (version < 0 || version > 5)
         throw OpenMMException("Unsupported version number");
     AmoebaMultipoleForce* force = new AmoebaMultipoleForce();
 
@@ -144,6 +145,8 @@ void* AmoebaMultipoleForceProxy::deserialize(const SerializationNode& node) cons
         if (version >= 2)
             force->setPolarizationType(static_cast<AmoebaMultipoleForce::PolarizationType>(node.getIntProperty("polarizationType")));
         force->setMutualInducedMaxIterations(node.getIntProperty("mutualInducedMaxIterations"));
+        if (version >= 5)
+            force->setMutualInducedUpdateInterval(node.getIntProperty("mutualInducedUpdateInterval"));
 
         force->setCutoffDistance(node.getDoubleProperty("cutoffDistance"));
         force->setMutualInducedTargetEpsilon(node.getDoubleProperty("mutualInducedTargetEpsilon"));
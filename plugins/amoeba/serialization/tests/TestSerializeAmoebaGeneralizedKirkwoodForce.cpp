@@ -53,6 +53,7 @@ void testSerialization() {
     force1.setProbeRadius(        1.40);
     force1.setSurfaceAreaFactor(  0.888);
     force1.setIncludeCavityTerm(  1);
+    force1.setBornRadiusUpdateInterval(4);
 
     force1.addParticle(1.0, 2.0, 0.9);
     force1.addParticle(-1.1,2.1, 0.8);
@@ -74,6 +75,7 @@ void testSerialization() {
     ASSERT_EQUAL(force1.getProbeRadius(),          force2.getProbeRadius());
     ASSERT_EQUAL(force1.getSurfaceAreaFactor(),    force2.getSurfaceAreaFactor());
     ASSERT_EQUAL(force1.getIncludeCavityTerm(),    force2.getIncludeCavityTerm());
+    ASSERT_EQUAL(force1.getBornRadiusUpdateInterval(), force2.getBornRadiusUpdateInterval());
 
     ASSERT_EQUAL(force1.getNumParticles(), force2.getNumParticles());
     for (unsigned int ii = 0; ii < static_cast<unsigned int>(force1.getNumParticles()); ii++) {
@@ -72,6 +72,7 @@ void testSerialization() {
     gridDimension.push_back(61);
     force1.setPmeGridDimensions(gridDimension); 
     force1.setMutualInducedMaxIterations(200); 
+    force1.setMutualInducedUpdateInterval(4);
     force1.setMutualInducedTargetEpsilon(1.0e-05); 
     force1.setEwaldErrorTolerance(1.0e-05); 
     
@@ -117,6 +118,7 @@ void testSerialization() {
     ASSERT_EQUAL(force1.getNonbondedMethod(),               force2.getNonbondedMethod());
     ASSERT_EQUAL(force1.getAEwald(),                        force2.getAEwald());
     ASSERT_EQUAL(force1.getMutualInducedMaxIterations(),    force2.getMutualInducedMaxIterations());
+    ASSERT_EQUAL(force1.getMutualInducedUpdateInterval(),   force2.getMutualInducedUpdateInterval());
     ASSERT_EQUAL(force1.getMutualInducedTargetEpsilon(),    force2.getMutualInducedTargetEpsilon());
     ASSERT_EQUAL(force1.getEwaldErrorTolerance(),           force2.getEwaldErrorTolerance());
 
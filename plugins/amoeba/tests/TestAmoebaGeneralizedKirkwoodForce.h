@@ -7131,6 +7131,49 @@ static void testGeneralizedKirkwoodAmmoniaMutualPolarization() {
     compareForcesEnergy(testName, expectedEnergy, energy, expectedForces, forces, tolerance);
 }
 
+// test reusing the Born radii between evaluations
+
+static void testBornRadiusUpdateInterval() {
+    System system1, system2;
+    AmoebaGeneralizedKirkwoodForce* gk1 = new AmoebaGeneralizedKirkwoodForce();
+    AmoebaGeneralizedKirkwoodForce* gk2 = new AmoebaGeneralizedKirkwoodForce();
+    setupMultipoleAmmonia(system1, gk1, AmoebaMultipoleForce::Mutual, 0);
+    setupMultipoleAmmonia(system2, gk2, AmoebaMultipoleForce::Mutual, 0);
+    ASSERT_EQUAL(1, gk2->getBornRadiusUpdateInterval());
+    gk2->setBornRadiusUpdateInterval(3);
+    ASSERT_EQUAL(3, gk2->getBornRadiusUpdateInterval());
+    LangevinIntegrator integrator1(0.0, 0.1, 0.01);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context1(system1, integrator1, platform);
+    Context context2(system2, integrator2, platform);
+    std::vector<Vec3> forces1;
+    double energy1;
+    getForcesEnergyMultipoleAmmonia(context1, forces1, energy1);
+    std::vector<Vec3> positions = context1.getState(State::Positions).getPositions();
+    context2.setPositions(positions);
+    ASSERT_EQUAL_TOL(context1.getState(State::Energy).getPotentialEnergy(), context2.getState(State::Energy).getPotentialEnergy(), 1e-5);
+
+    // Move one molecule a little at a time.  The Born radii should only be recomputed on every third evaluation.
+
+    for (int step = 1; step < 7; step++) {
+        for (int i = 4; i < 8; i++)
+            positions[i][0] -= 0.002;
+        context1.setPositions(positions);
+        context2.setPositions(positions);
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        if (step%3 == 0) {
+            ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+            for (int i = 0; i < system1.getNumParticles(); i++)
+                ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+        }
+        else {
+            ASSERT(fabs(state1.getPotentialEnergy()-state2.getPotentialEnergy()) > 1e-8*fabs(state1.getPotentialEnergy()));
+            ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 0.05);
+        }
+    }
+}
+
 // test GK mutual polarization for system comprised of two ammonia molecules
 // including cavity term
 
@@ -8463,6 +8506,7 @@ int main(int argc, char* argv[]) {
 
         testGeneralizedKirkwoodAmmoniaDirectPolarization();
         testGeneralizedKirkwoodAmmoniaMutualPolarization();
+        testBornRadiusUpdateInterval();
         testGeneralizedKirkwoodAmmoniaExtrapolatedPolarization();
         testGeneralizedKirkwoodAmmoniaMutualPolarizationWithCavityTerm();
         testGeneralizedKirkwoodVillinDirectPolarization();
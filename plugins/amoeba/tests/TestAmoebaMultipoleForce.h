@@ -2657,6 +2657,49 @@ static void testParticleInducedDipoles() {
         ASSERT_EQUAL_VEC(expectedDipole[i], dipole[i], 1e-4);
 }
 
+// test reusing the mutual induced dipoles between solves
+
+static void testMutualInducedUpdateInterval() {
+    System system1, system2;
+    AmoebaMultipoleForce* force1 = new AmoebaMultipoleForce();
+    AmoebaMultipoleForce* force2 = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(system1, force1, AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual, 9000000.0, 0);
+    setupMultipoleAmmonia(system2, force2, AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual, 9000000.0, 0);
+    ASSERT_EQUAL(1, force2->getMutualInducedUpdateInterval());
+    force2->setMutualInducedUpdateInterval(3);
+    ASSERT_EQUAL(3, force2->getMutualInducedUpdateInterval());
+    LangevinIntegrator integrator1(0.0, 0.1, 0.01);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context1(system1, integrator1, platform);
+    Context context2(system2, integrator2, platform);
+    std::vector<Vec3> forces1, forces2;
+    double energy1, energy2;
+    getForcesEnergyMultipoleAmmonia(context1, forces1, energy1);
+    getForcesEnergyMultipoleAmmonia(context2, forces2, energy2);
+    ASSERT_EQUAL_TOL(energy1, energy2, 1e-5);
+
+    // Move one molecule a little at a time.  The dipoles should only be recomputed on every third evaluation.
+
+    std::vector<Vec3> positions = context1.getState(State::Positions).getPositions();
+    for (int step = 1; step < 7; step++) {
+        for (int i = 4; i < 8; i++)
+            positions[i][0] -= 0.002;
+        context1.setPositions(positions);
+        context2.setPositions(positions);
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        if (step%3 == 0) {
+            ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+            for (int i = 0; i < system1.getNumParticles(); i++)
+                ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+        }
+        else {
+            ASSERT(fabs(state1.getPotentialEnergy()-state2.getPotentialEnergy()) > 1e-6*fabs(state1.getPotentialEnergy()));
+            ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 0.05);
+        }
+    }
+}
+
 // test querying particle lab frame permanent dipoles
 
 static void testParticleLabFramePermanentDipoles() {
@@ -3296,6 +3339,7 @@ int main(int argc, char* argv[]) {
         // test querying induced dipoles
         
         testParticleInducedDipoles();
+        testMutualInducedUpdateInterval();
         
         // test computation of system multipole moments
 
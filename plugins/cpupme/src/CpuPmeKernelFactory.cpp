@@ -29,6 +29,8 @@
 #include "internal/windowsExportPme.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/OpenMMException.h"
+#include <algorithm>
+#include <sstream>
 
 using namespace OpenMM;
 
@@ -55,9 +57,15 @@ extern "C" OPENMM_EXPORT_PME void registerPlatforms() {
 #endif
 
 KernelImpl* CpuPmeKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
+    // If the Platform lets the user choose how many threads to use for PME, respect that.
+
+    int numThreads = 0;
+    const std::vector<std::string>& properties = platform.getPropertyNames();
+    if (std::find(properties.begin(), properties.end(), "PmeThreads") != properties.end())
+        std::stringstream(platform.getPropertyValue(context.getOwner(), "PmeThreads")) >> numThreads;
     if (name == CalcPmeReciprocalForceKernel::Name())
-        return new CpuCalcPmeReciprocalForceKernel(name, platform);
+        return new CpuCalcPmeReciprocalForceKernel(name, platform, numThreads);
     if (name == CalcDispersionPmeReciprocalForceKernel::Name())
-        return new CpuCalcDispersionPmeReciprocalForceKernel(name, platform);
+        return new CpuCalcDispersionPmeReciprocalForceKernel(name, platform, numThreads);
     throw OpenMMException((std::string("Tried to create kernel with illegal kernel name '")+name+"'").c_str());
 }
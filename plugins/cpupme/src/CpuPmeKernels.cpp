@@ -52,23 +52,131 @@ using namespace OpenMM;
 using namespace std;
 
 static const int PME_ORDER = 5;
+static_assert(PME_ORDER == 5, "The force interpolation handles the z stencil as a group of four points plus one more, so it requires PME_ORDER == 5");
 
 bool CpuCalcDispersionPmeReciprocalForceKernel::hasInitializedThreads = false;
-int CpuCalcDispersionPmeReciprocalForceKernel::numThreads = 0;
+int CpuCalcDispersionPmeReciprocalForceKernel::defaultNumThreads = 0;
 
-static void spreadCharge(float* posq, vector<float>& grid, int gridx, int gridy, int gridz, int numParticles, Vec3* periodicBoxVectors, Vec3* recipBoxVectors,
-        atomic<int>& atomicCounter, const float epsilonFactor, int threadIndex, int numThreads, bool deterministic) {
+/**
+ * This holds the quantities needed to find which grid points an atom's charge is spread to.
+ */
+struct GridGeometry {
+    GridGeometry(Vec3* periodicBoxVectors, Vec3* recipBoxVectors, int gridx, int gridy, int gridz) :
+            boxSize((float) periodicBoxVectors[0][0], (float) periodicBoxVectors[1][1], (float) periodicBoxVectors[2][2], 0),
+            invBoxSize((float) recipBoxVectors[0][0], (float) recipBoxVectors[1][1], (float) recipBoxVectors[2][2], 0),
+            recipBoxVec0((float) recipBoxVectors[0][0], (float) recipBoxVectors[0][1], (float) recipBoxVectors[0][2], 0),
+            recipBoxVec1((float) recipBoxVectors[1][0], (float) recipBoxVectors[1][1], (float) recipBoxVectors[1][2], 0),
+            recipBoxVec2((float) recipBoxVectors[2][0], (float) recipBoxVectors[2][1], (float) recipBoxVectors[2][2], 0),
+            gridSize(gridx, gridy, gridz, 0), gridSizeInt(gridx, gridy, gridz, 0) {
+    }
+    /**
+     * Find the grid point an atom is spread from, and its offset from that point in grid units.
+     */
+    ivec4 findGridIndex(const float* atomPos, fvec4& dr) const {
+        float posInBox[4];
+        fvec4 pos(atomPos);
+        (pos-boxSize*floor(pos*invBoxSize)).store(posInBox);
+        fvec4 t = posInBox[0]*recipBoxVec0 + posInBox[1]*recipBoxVec1 + posInBox[2]*recipBoxVec2;
+        t = (t-floor(t))*gridSize;
+        ivec4 ti = t;
+        dr = t-ti;
+        return ti-(gridSizeInt&ti==gridSizeInt);
+    }
+    fvec4 boxSize, invBoxSize, recipBoxVec0, recipBoxVec1, recipBoxVec2, gridSize;
+    ivec4 gridSizeInt;
+};
+
+/**
+ * Spread the charge of one atom onto the grid.  This returns false if the atom's position
+ * is not valid.
+ */
+static bool spreadAtomCharge(float* posq, int i, vector<float>& grid, int gridx, int gridy, int gridz, const GridGeometry& geometry, const float epsilonFactor) {
     float temp[4];
-    fvec4 boxSize((float) periodicBoxVectors[0][0], (float) periodicBoxVectors[1][1], (float) periodicBoxVectors[2][2], 0);
-    fvec4 invBoxSize((float) recipBoxVectors[0][0], (float) recipBoxVectors[1][1], (float) recipBoxVectors[2][2], 0);
-    fvec4 recipBoxVec0((float) recipBoxVectors[0][0], (float) recipBoxVectors[0][1], (float) recipBoxVectors[0][2], 0);
-    fvec4 recipBoxVec1((float) recipBoxVectors[1][0], (float) recipBoxVectors[1][1], (float) recipBoxVectors[1][2], 0);
-    fvec4 recipBoxVec2((float) recipBoxVectors[2][0], (float) recipBoxVectors[2][1], (float) recipBoxVectors[2][2], 0);
-    fvec4 gridSize(gridx, gridy, gridz, 0);
-    ivec4 gridSizeInt(gridx, gridy, gridz, 0);
     fvec4 one(1);
     fvec4 scale(1.0f/(PME_ORDER-1));
-    float posInBox[4] = {0,0,0,0};
+
+    // Find the position relative to the nearest grid point.
+
+    fvec4 dr;
+    ivec4 gridIndex = geometry.findGridIndex(&posq[4*i], dr);
+
+    // Compute the B-spline coefficients.
+
+    fvec4 data[PME_ORDER];
+    data[PME_ORDER-1] = 0.0f;
+    data[1] = dr;
+    data[0] = one-dr;
+    for (int j = 3; j < PME_ORDER; j++) {
+        fvec4 div(1.0f/(j-1));
+        data[j-1] = div*dr*data[j-2];
+        for (int k = 1; k < j-1; k++)
+            data[j-k-1] = div*((dr+k)*data[j-k-2]+(fvec4(j-k)-dr)*data[j-k-1]);
+        data[0] = div*(one-dr)*data[0];
+    }
+    data[PME_ORDER-1] = scale*dr*data[PME_ORDER-2];
+    for (int j = 1; j < (PME_ORDER-1); j++)
+        data[PME_ORDER-j-1] = scale*((dr+j)*data[PME_ORDER-j-2]+(fvec4(PME_ORDER-j)-dr)*data[PME_ORDER-j-1]);
+    data[0] = scale*(one-dr)*data[0];
+
+    // Spread the charges.
+
+    int gridIndexX = gridIndex[0];
+    int gridIndexY = gridIndex[1];
+    int gridIndexZ = gridIndex[2];
+    if (gridIndexX < 0)
+        return false; // This happens when a simulation blows up and coordinates become NaN.
+    int zindex[PME_ORDER];
+    for (int j = 0; j < PME_ORDER; j++) {
+        zindex[j] = gridIndexZ+j;
+        zindex[j] -= (zindex[j] >= gridz ? gridz : 0);
+    }
+    float charge = epsilonFactor*posq[4*i+3];
+    fvec4 zdata0to3(data[0][2], data[1][2], data[2][2], data[3][2]);
+    float zdata4 = data[4][2];
+    if (gridIndexZ+4 < gridz) {
+        for (int ix = 0; ix < PME_ORDER; ix++) {
+            int xbase = gridIndexX+ix;
+            xbase -= (xbase >= gridx ? gridx : 0);
+            xbase = xbase*gridy*gridz;
+            float xdata = charge*data[ix][0];
+            for (int iy = 0; iy < PME_ORDER; iy++) {
+                int ybase = gridIndexY+iy;
+                ybase -= (ybase >= gridy ? gridy : 0);
+                ybase = xbase + ybase*gridz;
+                float multiplier = xdata*data[iy][1];
+                fvec4 add0to3 = zdata0to3*multiplier;
+                (fvec4(&grid[ybase+gridIndexZ])+add0to3).store(&grid[ybase+gridIndexZ]);
+                grid[ybase+zindex[4]] += multiplier*zdata4;
+            }
+        }
+    }
+    else {
+        for (int ix = 0; ix < PME_ORDER; ix++) {
+            int xbase = gridIndexX+ix;
+            xbase -= (xbase >= gridx ? gridx : 0);
+            xbase = xbase*gridy*gridz;
+            float xdata = charge*data[ix][0];
+            for (int iy = 0; iy < PME_ORDER; iy++) {
+                int ybase = gridIndexY+iy;
+                ybase -= (ybase >= gridy ? gridy : 0);
+                ybase = xbase + ybase*gridz;
+                float multiplier = xdata*data[iy][1];
+                fvec4 add0to3 = zdata0to3*multiplier;
+                add0to3.store(temp);
+                grid[ybase+zindex[0]] += temp[0];
+                grid[ybase+zindex[1]] += temp[1];
+                grid[ybase+zindex[2]] += temp[2];
+                grid[ybase+zindex[3]] += temp[3];
+                grid[ybase+zindex[4]] += multiplier*zdata4;
+            }
+        }
+    }
+    return true;
+}
+
+static void spreadCharge(float* posq, vector<float>& grid, int gridx, int gridy, int gridz, int numParticles, Vec3* periodicBoxVectors, Vec3* recipBoxVectors,
+        atomic<int>& atomicCounter, const float epsilonFactor, int threadIndex, int numThreads, bool deterministic) {
+    GridGeometry geometry(periodicBoxVectors, recipBoxVectors, gridx, gridy, gridz);
     memset(grid.data(), 0, sizeof(float)*gridx*gridy*gridz);
 
     const int groupSize = max(1, numParticles / (10 * numThreads));
@@ -81,92 +189,113 @@ static void spreadCharge(float* posq, vector<float>& grid, int gridx, int gridy,
             break;
 
         int end = min(start + groupSize, numParticles);
-        for (int i = start; i < end; ++i) {
-            // Find the position relative to the nearest grid point.
+        for (int i = start; i < end; ++i)
+            if (!spreadAtomCharge(posq, i, grid, gridx, gridy, gridz, geometry, epsilonFactor))
+                return;
 
-            fvec4 pos(&posq[4*i]);
-            (pos-boxSize*floor(pos*invBoxSize)).store(posInBox);
-            fvec4 t = posInBox[0]*recipBoxVec0 + posInBox[1]*recipBoxVec1 + posInBox[2]*recipBoxVec2;
-            t = (t-floor(t))*gridSize;
-            ivec4 ti = t;
-            fvec4 dr = t-ti;
-            ivec4 gridIndex = ti-(gridSizeInt&ti==gridSizeInt);
+        if (deterministic)
+            start += groupSize * numThreads;
+    }
+}
 
-            // Compute the B-spline coefficients.
+/*
+ * When there are enough grid points, charges are spread directly onto a single shared grid
+ * instead of a separate grid for each thread.  The grid is divided into columns of cells along
+ * the x and y axes, each at least PME_ORDER-1 points wide, so an atom in one cell only touches
+ * grid points in that cell and the next one along each axis.  The cells are processed in up to
+ * four phases such that no two cells in the same phase are adjacent.  Within a phase, each
+ * cell is spread by one thread, so no locks or atomics are needed, and the result does not
+ * depend on how the threads are scheduled.
+ */
 
-            fvec4 data[PME_ORDER];
-            data[PME_ORDER-1] = 0.0f;
-            data[1] = dr;
-            data[0] = one-dr;
-            for (int j = 3; j < PME_ORDER; j++) {
-                fvec4 div(1.0f/(j-1));
-                data[j-1] = div*dr*data[j-2];
-                for (int k = 1; k < j-1; k++)
-                    data[j-k-1] = div*((dr+k)*data[j-k-2]+(fvec4(j-k)-dr)*data[j-k-1]);
-                data[0] = div*(one-dr)*data[0];
-            }
-            data[PME_ORDER-1] = scale*dr*data[PME_ORDER-2];
-            for (int j = 1; j < (PME_ORDER-1); j++)
-                data[PME_ORDER-j-1] = scale*((dr+j)*data[PME_ORDER-j-2]+(fvec4(PME_ORDER-j)-dr)*data[PME_ORDER-j-1]);
-            data[0] = scale*(one-dr)*data[0];
+/**
+ * Select the number of spreading cells along one axis of the grid, or 1 if the axis is too
+ * small to divide.
+ */
+static int findNumSpreadCells(int gridSize) {
+    int numCells = gridSize/(PME_ORDER-1);
+    if (numCells < 2)
+        return 1;
+    return numCells-numCells%2;
+}
 
-            // Spread the charges.
+/**
+ * Get the number of phases needed to spread charges with the given number of cells along
+ * each axis.
+ */
+static int getNumSpreadPhases(const int numCells[2]) {
+    return (numCells[0] > 1 ? 2 : 1)*(numCells[1] > 1 ? 2 : 1);
+}
 
-            int gridIndexX = gridIndex[0];
-            int gridIndexY = gridIndex[1];
-            int gridIndexZ = gridIndex[2];
-            if (gridIndexX < 0)
-                return; // This happens when a simulation blows up and coordinates become NaN.
-            int zindex[PME_ORDER];
-            for (int j = 0; j < PME_ORDER; j++) {
-                zindex[j] = gridIndexZ+j;
-                zindex[j] -= (zindex[j] >= gridz ? gridz : 0);
-            }
-            float charge = epsilonFactor*posq[4*i+3];
-            fvec4 zdata0to3(data[0][2], data[1][2], data[2][2], data[3][2]);
-            float zdata4 = data[4][2];
-            if (gridIndexZ+4 < gridz) {
-                for (int ix = 0; ix < PME_ORDER; ix++) {
-                    int xbase = gridIndexX+ix;
-                    xbase -= (xbase >= gridx ? gridx : 0);
-                    xbase = xbase*gridy*gridz;
-                    float xdata = charge*data[ix][0];
-                    for (int iy = 0; iy < PME_ORDER; iy++) {
-                        int ybase = gridIndexY+iy;
-                        ybase -= (ybase >= gridy ? gridy : 0);
-                        ybase = xbase + ybase*gridz;
-                        float multiplier = xdata*data[iy][1];
-                        fvec4 add0to3 = zdata0to3*multiplier;
-                        (fvec4(&grid[ybase+gridIndexZ])+add0to3).store(&grid[ybase+gridIndexZ]);
-                        grid[ybase+zindex[4]] += multiplier*zdata4;
-                    }
-                }
-            }
-            else {
-                for (int ix = 0; ix < PME_ORDER; ix++) {
-                    int xbase = gridIndexX+ix;
-                    xbase -= (xbase >= gridx ? gridx : 0);
-                    xbase = xbase*gridy*gridz;
-                    float xdata = charge*data[ix][0];
-                    for (int iy = 0; iy < PME_ORDER; iy++) {
-                        int ybase = gridIndexY+iy;
-                        ybase -= (ybase >= gridy ? gridy : 0);
-                        ybase = xbase + ybase*gridz;
-                        float multiplier = xdata*data[iy][1];
-                        fvec4 add0to3 = zdata0to3*multiplier;
-                        add0to3.store(temp);
-                        grid[ybase+zindex[0]] += temp[0];
-                        grid[ybase+zindex[1]] += temp[1];
-                        grid[ybase+zindex[2]] += temp[2];
-                        grid[ybase+zindex[3]] += temp[3];
-                        grid[ybase+zindex[4]] += multiplier*zdata4;
-                    }
-                }
-            }
-        }
+/**
+ * Decide whether to spread charges in cells, rather than onto separate grids for each thread.
+ */
+static bool shouldUseSpreadCells(const int numCells[2], int numThreads) {
+    int phases[2] = {numCells[0] > 1 ? 2 : 1, numCells[1] > 1 ? 2 : 1};
+    int cellsPerPhase = (numCells[0]/phases[0])*(numCells[1]/phases[1]);
+    return (numThreads > 1 && cellsPerPhase >= numThreads);
+}
 
-        if (deterministic)
-            start += groupSize * numThreads;
+/**
+ * Find the spreading cell containing each atom in a range, and clear part of the grid.
+ */
+static void findAtomSpreadCells(float* posq, vector<int>& atomCell, vector<float>& grid, int gridx, int gridy, int gridz, const int numCells[2],
+        Vec3* periodicBoxVectors, Vec3* recipBoxVectors, int threadIndex, int numThreads) {
+    GridGeometry geometry(periodicBoxVectors, recipBoxVectors, gridx, gridy, gridz);
+    int numParticles = atomCell.size();
+    int start = (threadIndex*numParticles)/numThreads;
+    int end = ((threadIndex+1)*numParticles)/numThreads;
+    for (int i = start; i < end; i++) {
+        fvec4 dr;
+        ivec4 gridIndex = geometry.findGridIndex(&posq[4*i], dr);
+        int gridIndexX = gridIndex[0];
+        int gridIndexY = gridIndex[1];
+        if (gridIndexX < 0 || gridIndexY < 0)
+            atomCell[i] = 0; // The coordinates are NaN.  spreadAtomCharge() will skip it.
+        else
+            atomCell[i] = ((gridIndexX*numCells[0])/gridx)*numCells[1] + (gridIndexY*numCells[1])/gridy;
+    }
+    int gridSize = gridx*gridy*gridz;
+    int gridStart = (threadIndex*gridSize)/numThreads;
+    int gridEnd = ((threadIndex+1)*gridSize)/numThreads;
+    memset(&grid[gridStart], 0, sizeof(float)*(gridEnd-gridStart));
+}
+
+/**
+ * Sort the atoms by spreading cell.  On exit, the atoms in cell i are
+ * cellAtoms[cellStart[i]] through cellAtoms[cellStart[i+1]-1], in increasing order.
+ */
+static void sortAtomsBySpreadCell(const vector<int>& atomCell, vector<int>& cellStart, vector<int>& cellAtoms) {
+    int numCells = cellStart.size()-1;
+    for (int i = 0; i <= numCells; i++)
+        cellStart[i] = 0;
+    for (int cell : atomCell)
+        cellStart[cell+1]++;
+    for (int i = 0; i < numCells; i++)
+        cellStart[i+1] += cellStart[i];
+    for (int i = 0; i < (int) atomCell.size(); i++)
+        cellAtoms[cellStart[atomCell[i]]++] = i;
+    for (int i = numCells; i > 0; i--)
+        cellStart[i] = cellStart[i-1];
+    cellStart[0] = 0;
+}
+
+/**
+ * Spread the charges of all atoms in the cells belonging to one phase.
+ */
+static void spreadChargeInCells(float* posq, vector<float>& grid, int gridx, int gridy, int gridz, const int numCells[2], const vector<int>& cellStart,
+        const vector<int>& cellAtoms, Vec3* periodicBoxVectors, Vec3* recipBoxVectors, const float epsilonFactor, int phase, int threadIndex, int numThreads) {
+    GridGeometry geometry(periodicBoxVectors, recipBoxVectors, gridx, gridy, gridz);
+    int phasesX = (numCells[0] > 1 ? 2 : 1);
+    int phasesY = (numCells[1] > 1 ? 2 : 1);
+    int phaseX = phase%phasesX;
+    int phaseY = phase/phasesX;
+    int cellsX = numCells[0]/phasesX;
+    int cellsY = numCells[1]/phasesY;
+    for (int i = threadIndex; i < cellsX*cellsY; i += numThreads) {
+        int cell = (phaseX+phasesX*(i%cellsX))*numCells[1] + phaseY+phasesY*(i/cellsX);
+        for (int j = cellStart[cell]; j < cellStart[cell+1]; j++)
+            spreadAtomCharge(posq, cellAtoms[j], grid, gridx, gridy, gridz, geometry, epsilonFactor);
     }
 }
 
@@ -385,17 +514,21 @@ static void interpolateForces(float* posq, vector<float>& force, vector<float>&
                 zindex[j] = gridIndexZ+j;
                 zindex[j] -= (zindex[j] >= gridz ? gridz : 0);
             }
-            fvec4 zdata[PME_ORDER];
-            for (int j = 0; j < PME_ORDER; j++)
-                zdata[j] = fvec4(data[j][2], data[j][2], ddata[j][2], 0);
-            fvec4 f = 0.0f;
+            bool zContiguous = (gridIndexZ+3 < gridz);
+
+            // Rather than multiplying every grid point by all three coefficients, accumulate
+            // weighted sums of the z stencil over y and then x, and only take the dot products
+            // with the z coefficients at the end.  The first four points of the stencil are
+            // handled as a vector and the fifth one separately.
+
+            fvec4 sumX0to3 = 0.0f, sumY0to3 = 0.0f, sumZ0to3 = 0.0f;
+            float sumX4 = 0.0f, sumY4 = 0.0f, sumZ4 = 0.0f;
             for (int ix = 0; ix < PME_ORDER; ix++) {
                 int xbase = gridIndexX+ix;
                 xbase -= (xbase >= gridx ? gridx : 0);
                 xbase = xbase*gridy*gridz;
-                float dx = data[ix][0];
-                float ddx = ddata[ix][0];
-                fvec4 xdata(ddx, dx, dx, 0);
+                fvec4 rowSum0to3 = 0.0f, rowDeriv0to3 = 0.0f;
+                float rowSum4 = 0.0f, rowDeriv4 = 0.0f;
 
                 for (int iy = 0; iy < PME_ORDER; iy++) {
                     int ybase = gridIndexY+iy;
@@ -403,14 +536,28 @@ static void interpolateForces(float* posq, vector<float>& force, vector<float>&
                     ybase = xbase + ybase*gridz;
                     float dy = data[iy][1];
                     float ddy = ddata[iy][1];
-                    fvec4 xydata = xdata*fvec4(dy, ddy, dy, 0);
-
-                    for (int iz = 0; iz < PME_ORDER; iz++) {
-                        fvec4 gridValue(grid[ybase+zindex[iz]]);
-                        f = f+xydata*zdata[iz]*gridValue;
-                    }
+                    fvec4 gridValue0to3 = (zContiguous ? fvec4(&grid[ybase+gridIndexZ]) :
+                            fvec4(grid[ybase+zindex[0]], grid[ybase+zindex[1]], grid[ybase+zindex[2]], grid[ybase+zindex[3]]));
+                    float gridValue4 = grid[ybase+zindex[4]];
+                    rowSum0to3 += dy*gridValue0to3;
+                    rowDeriv0to3 += ddy*gridValue0to3;
+                    rowSum4 += dy*gridValue4;
+                    rowDeriv4 += ddy*gridValue4;
                 }
+                float dx = data[ix][0];
+                float ddx = ddata[ix][0];
+                sumX0to3 += ddx*rowSum0to3;
+                sumY0to3 += dx*rowDeriv0to3;
+                sumZ0to3 += dx*rowSum0to3;
+                sumX4 += ddx*rowSum4;
+                sumY4 += dx*rowDeriv4;
+                sumZ4 += dx*rowSum4;
             }
+            fvec4 zdata0to3(data[0][2], data[1][2], data[2][2], data[3][2]);
+            fvec4 zderiv0to3(ddata[0][2], ddata[1][2], ddata[2][2], ddata[3][2]);
+            float zdata4 = data[4][2];
+            float zderiv4 = ddata[4][2];
+            fvec4 f(dot4(sumX0to3, zdata0to3)+sumX4*zdata4, dot4(sumY0to3, zdata0to3)+sumY4*zdata4, dot4(sumZ0to3, zderiv0to3)+sumZ4*zderiv4, 0.0f);
             f *= -epsilonFactor*posq[4*i+3];
             float fc[4];
             f.store(fc);
@@ -428,12 +575,15 @@ static void* threadBody(void* args) {
 }
 
 void CpuCalcPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize, int numParticles, double alpha, bool deterministic) {
-    if (!hasInitializedThreads) {
-        numThreads = getNumProcessors();
-        char* threadsEnv = getenv("OPENMM_CPU_THREADS");
-        if (threadsEnv != NULL)
-            stringstream(threadsEnv) >> numThreads;
-        hasInitializedThreads = true;
+    if (numThreads < 1) {
+        if (!hasInitializedThreads) {
+            defaultNumThreads = getNumProcessors();
+            char* threadsEnv = getenv("OPENMM_CPU_THREADS");
+            if (threadsEnv != NULL)
+                stringstream(threadsEnv) >> defaultNumThreads;
+            hasInitializedThreads = true;
+        }
+        numThreads = defaultNumThreads;
     }
     threadEnergy.resize(numThreads);
     gridx = findFFTDimension(xsize);
@@ -474,7 +624,15 @@ void CpuCalcPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize
     
     // Initialize the FFT grids.
 
-    realGrids.resize(numThreads, vector<float>(gridx*gridy*gridz+3));
+    numSpreadCells[0] = findNumSpreadCells(gridx);
+    numSpreadCells[1] = findNumSpreadCells(gridy);
+    useSpreadCells = shouldUseSpreadCells(numSpreadCells, numThreads);
+    if (useSpreadCells) {
+        atomSpreadCell.resize(numParticles);
+        spreadCellStart.resize(numSpreadCells[0]*numSpreadCells[1]+1);
+        spreadCellAtoms.resize(numParticles);
+    }
+    realGrids.resize(useSpreadCells ? 1 : numThreads, vector<float>(gridx*gridy*gridz+3));
     complexGrid.resize(gridx*gridy*(gridz/2+1));
     
     // Initialize the b-spline moduli.
@@ -559,10 +717,19 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
             break;
         posq = io->getPosq();
         atomicCounter = 0;
-        threads.execute([&] (ThreadPool& threads, int threadIndex) { runWorkerThread(threads, threadIndex); }); // Signal threads to perform charge spreading.
-        threads.waitForThreads();
-        threads.resumeThreads(); // Signal threads to sum the charge grids.
+        threads.execute([&] (ThreadPool& threads, int threadIndex) { runWorkerThread(threads, threadIndex); }); // Signal threads to perform charge spreading, or find the atoms in each cell.
         threads.waitForThreads();
+        if (useSpreadCells) {
+            sortAtomsBySpreadCell(atomSpreadCell, spreadCellStart, spreadCellAtoms);
+            for (int phase = 0; phase < getNumSpreadPhases(numSpreadCells); phase++) {
+                threads.resumeThreads(); // Signal threads to spread the charges in one phase.
+                threads.waitForThreads();
+            }
+        }
+        else {
+            threads.resumeThreads(); // Signal threads to sum the charge grids.
+            threads.waitForThreads();
+        }
         pocketfft::r2c(gridShape, realGridStride, complexGridStride, fftAxes, true, realGrids[0].data(), complexGrid.data(), 1.0f, 0);
         if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
             threads.resumeThreads(); // Signal threads to compute the reciprocal scale factors.
@@ -599,16 +766,26 @@ void CpuCalcPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int i
     int complexStart = std::max(1, ((index*complexSize)/numThreads));
     int complexEnd = (((index+1)*complexSize)/numThreads);
     const float epsilonFactor = sqrt(ONE_4PI_EPS0);
-    spreadCharge(posq, realGrids[index], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, index, numThreads, deterministic);
-    threads.syncThreads();
-    int numGrids = realGrids.size();
-    for (int i = gridStart; i < gridEnd; i += 4) {
-        fvec4 sum(&realGrids[0][i]);
-        for (int j = 1; j < numGrids; j++)
-            sum += fvec4(&realGrids[j][i]);
-        sum.store(&realGrids[0][i]);
+    if (useSpreadCells) {
+        findAtomSpreadCells(posq, atomSpreadCell, realGrids[0], gridx, gridy, gridz, numSpreadCells, periodicBoxVectors, recipBoxVectors, index, numThreads);
+        threads.syncThreads();
+        for (int phase = 0; phase < getNumSpreadPhases(numSpreadCells); phase++) {
+            spreadChargeInCells(posq, realGrids[0], gridx, gridy, gridz, numSpreadCells, spreadCellStart, spreadCellAtoms, periodicBoxVectors, recipBoxVectors, epsilonFactor, phase, index, numThreads);
+            threads.syncThreads();
+        }
+    }
+    else {
+        spreadCharge(posq, realGrids[index], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, index, numThreads, deterministic);
+        threads.syncThreads();
+        int numGrids = realGrids.size();
+        for (int i = gridStart; i < gridEnd; i += 4) {
+            fvec4 sum(&realGrids[0][i]);
+            for (int j = 1; j < numGrids; j++)
+                sum += fvec4(&realGrids[j][i]);
+            sum.store(&realGrids[0][i]);
+        }
+        threads.syncThreads();
     }
-    threads.syncThreads();
     if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
         computeReciprocalEterm(gridxStart, gridxEnd, gridx, gridy, gridz, recipEterm, alpha, bsplineModuli, periodicBoxVectors, recipBoxVectors);
         threads.syncThreads();
@@ -690,7 +867,7 @@ int CpuCalcPmeReciprocalForceKernel::findFFTDimension(int minimum) {
  */
 
 bool CpuCalcPmeReciprocalForceKernel::hasInitializedThreads = false;
-int CpuCalcPmeReciprocalForceKernel::numThreads = 0;
+int CpuCalcPmeReciprocalForceKernel::defaultNumThreads = 0;
 
 
 class CpuCalcDispersionPmeReciprocalForceKernel::ComputeTask : public ThreadPool::Task {
@@ -710,12 +887,15 @@ static void* dispersionThreadBody(void* args) {
 }
 
 void CpuCalcDispersionPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize, int numParticles, double alpha, bool deterministic) {
-    if (!hasInitializedThreads) {
-        numThreads = getNumProcessors();
-        char* threadsEnv = getenv("OPENMM_CPU_THREADS");
-        if (threadsEnv != NULL)
-            stringstream(threadsEnv) >> numThreads;
-        hasInitializedThreads = true;
+    if (numThreads < 1) {
+        if (!hasInitializedThreads) {
+            defaultNumThreads = getNumProcessors();
+            char* threadsEnv = getenv("OPENMM_CPU_THREADS");
+            if (threadsEnv != NULL)
+                stringstream(threadsEnv) >> defaultNumThreads;
+            hasInitializedThreads = true;
+        }
+        numThreads = defaultNumThreads;
     }
     threadEnergy.resize(numThreads);
     gridx = findFFTDimension(xsize);
@@ -757,7 +937,15 @@ void CpuCalcDispersionPmeReciprocalForceKernel::initialize(int xsize, int ysize,
 
     // Initialize the FFT grids.
 
-    realGrids.resize(numThreads, vector<float>(gridx*gridy*gridz+3));
+    numSpreadCells[0] = findNumSpreadCells(gridx);
+    numSpreadCells[1] = findNumSpreadCells(gridy);
+    useSpreadCells = shouldUseSpreadCells(numSpreadCells, numThreads);
+    if (useSpreadCells) {
+        atomSpreadCell.resize(numParticles);
+        spreadCellStart.resize(numSpreadCells[0]*numSpreadCells[1]+1);
+        spreadCellAtoms.resize(numParticles);
+    }
+    realGrids.resize(useSpreadCells ? 1 : numThreads, vector<float>(gridx*gridy*gridz+3));
     complexGrid.resize(gridx*gridy*(gridz/2+1));
     
     // Initialize the b-spline moduli.
@@ -843,10 +1031,19 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
         posq = io->getPosq();
         ComputeTask task(*this);
         atomicCounter = 0;
-        threads.execute(task); // Signal threads to perform charge spreading.
-        threads.waitForThreads();
-        threads.resumeThreads(); // Signal threads to sum the charge grids.
+        threads.execute(task); // Signal threads to perform charge spreading, or find the atoms in each cell.
         threads.waitForThreads();
+        if (useSpreadCells) {
+            sortAtomsBySpreadCell(atomSpreadCell, spreadCellStart, spreadCellAtoms);
+            for (int phase = 0; phase < getNumSpreadPhases(numSpreadCells); phase++) {
+                threads.resumeThreads(); // Signal threads to spread the charges in one phase.
+                threads.waitForThreads();
+            }
+        }
+        else {
+            threads.resumeThreads(); // Signal threads to sum the charge grids.
+            threads.waitForThreads();
+        }
         pocketfft::r2c(gridShape, realGridStride, complexGridStride, fftAxes, true, realGrids[0].data(), complexGrid.data(), 1.0f, 0);
         if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
             threads.resumeThreads(); // Signal threads to compute the reciprocal scale factors.
@@ -883,16 +1080,26 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runWorkerThread(ThreadPool& thre
     int complexStart = std::max(1, ((index*complexSize)/numThreads));
     int complexEnd = (((index+1)*complexSize)/numThreads);
     const float epsilonFactor = 1.0f;
-    spreadCharge(posq, realGrids[index], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, index, numThreads, deterministic);
-    threads.syncThreads();
-    int numGrids = realGrids.size();
-    for (int i = gridStart; i < gridEnd; i += 4) {
-        fvec4 sum(&realGrids[0][i]);
-        for (int j = 1; j < numGrids; j++)
-            sum += fvec4(&realGrids[j][i]);
-        sum.store(&realGrids[0][i]);
+    if (useSpreadCells) {
+        findAtomSpreadCells(posq, atomSpreadCell, realGrids[0], gridx, gridy, gridz, numSpreadCells, periodicBoxVectors, recipBoxVectors, index, numThreads);
+        threads.syncThreads();
+        for (int phase = 0; phase < getNumSpreadPhases(numSpreadCells); phase++) {
+            spreadChargeInCells(posq, realGrids[0], gridx, gridy, gridz, numSpreadCells, spreadCellStart, spreadCellAtoms, periodicBoxVectors, recipBoxVectors, epsilonFactor, phase, index, numThreads);
+            threads.syncThreads();
+        }
+    }
+    else {
+        spreadCharge(posq, realGrids[index], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, index, numThreads, deterministic);
+        threads.syncThreads();
+        int numGrids = realGrids.size();
+        for (int i = gridStart; i < gridEnd; i += 4) {
+            fvec4 sum(&realGrids[0][i]);
+            for (int j = 1; j < numGrids; j++)
+                sum += fvec4(&realGrids[j][i]);
+            sum.store(&realGrids[0][i]);
+        }
+        threads.syncThreads();
     }
-    threads.syncThreads();
     if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
         computeReciprocalDispersionEterm(gridxStart, gridxEnd, gridx, gridy, gridz, recipEterm, alpha, bsplineModuli, periodicBoxVectors, recipBoxVectors);
         threads.syncThreads();
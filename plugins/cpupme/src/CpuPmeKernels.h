@@ -51,8 +51,16 @@ namespace OpenMM {
 
 class OPENMM_EXPORT_PME CpuCalcPmeReciprocalForceKernel : public CalcPmeReciprocalForceKernel {
 public:
-    CpuCalcPmeReciprocalForceKernel(const std::string& name, const Platform& platform) : CalcPmeReciprocalForceKernel(name, platform),
-            isDeleted(false) {
+    /**
+     * Create the kernel.
+     *
+     * @param name        the name of the kernel
+     * @param platform    the Platform it is being created for
+     * @param numThreads  the number of threads to use.  If this is 0, the number of threads is taken from
+     *                    the OPENMM_CPU_THREADS environment variable, or else the number of processors.
+     */
+    CpuCalcPmeReciprocalForceKernel(const std::string& name, const Platform& platform, int numThreads=0) : CalcPmeReciprocalForceKernel(name, platform),
+            numThreads(numThreads), isDeleted(false) {
     }
     /**
      * Initialize the kernel.
@@ -108,8 +116,8 @@ private:
      */
     int findFFTDimension(int minimum);
     static bool hasInitializedThreads;
-    static int numThreads;
-    int gridx, gridy, gridz, numParticles;
+    static int defaultNumThreads;
+    int numThreads, gridx, gridy, gridz, numParticles;
     double alpha;
     bool deterministic;
     bool isFinished, isDeleted;
@@ -119,6 +127,9 @@ private:
     Vec3 lastBoxVectors[3];
     std::vector<float> threadEnergy;
     std::vector<std::vector<float> > realGrids;
+    bool useSpreadCells;
+    int numSpreadCells[2];
+    std::vector<int> atomSpreadCell, spreadCellStart, spreadCellAtoms;
     std::vector<std::complex<float> > complexGrid;
     std::vector<std::size_t> gridShape, fftAxes;
     std::vector<std::ptrdiff_t> realGridStride, complexGridStride;
@@ -144,8 +155,16 @@ private:
 
 class OPENMM_EXPORT_PME CpuCalcDispersionPmeReciprocalForceKernel : public CalcDispersionPmeReciprocalForceKernel {
 public:
-    CpuCalcDispersionPmeReciprocalForceKernel(const std::string& name, const Platform& platform) : CalcDispersionPmeReciprocalForceKernel(name, platform),
-            isDeleted(false) {
+    /**
+     * Create the kernel.
+     *
+     * @param name        the name of the kernel
+     * @param platform    the Platform it is being created for
+     * @param numThreads  the number of threads to use.  If this is 0, the number of threads is taken from
+     *                    the OPENMM_CPU_THREADS environment variable, or else the number of processors.
+     */
+    CpuCalcDispersionPmeReciprocalForceKernel(const std::string& name, const Platform& platform, int numThreads=0) : CalcDispersionPmeReciprocalForceKernel(name, platform),
+            numThreads(numThreads), isDeleted(false) {
     }
     /**
      * Initialize the kernel.
@@ -202,8 +221,8 @@ private:
      */
     int findFFTDimension(int minimum);
     static bool hasInitializedThreads;
-    static int numThreads;
-    int gridx, gridy, gridz, numParticles;
+    static int defaultNumThreads;
+    int numThreads, gridx, gridy, gridz, numParticles;
     double alpha;
     bool deterministic;
     bool isFinished, isDeleted;
@@ -213,6 +232,9 @@ private:
     Vec3 lastBoxVectors[3];
     std::vector<float> threadEnergy;
     std::vector<std::vector<float> > realGrids;
+    bool useSpreadCells;
+    int numSpreadCells[2];
+    std::vector<int> atomSpreadCell, spreadCellStart, spreadCellAtoms;
     std::vector<std::complex<float> > complexGrid;
     std::vector<std::size_t> gridShape, fftAxes;
     std::vector<std::ptrdiff_t> realGridStride, complexGridStride;
@@ -565,7 +565,7 @@ void test_water2_dpme_energies_forces_no_exclusions() {
 }
 
 
-void testPME(bool triclinic) {
+void testPME(bool triclinic, int numThreads=0) {
     // Create a cloud of random point charges.
 
     const int numParticles = 51;
@@ -613,7 +613,7 @@ void testPME(bool triclinic) {
     double alpha;
     int gridx, gridy, gridz;
     NonbondedForceImpl::calcPMEParameters(system, *force, alpha, gridx, gridy, gridz, false);
-    CpuCalcPmeReciprocalForceKernel pme(CalcPmeReciprocalForceKernel::Name(), platform);
+    CpuCalcPmeReciprocalForceKernel pme(CalcPmeReciprocalForceKernel::Name(), platform, numThreads);
     IO io;
     double sumSquaredCharges = 0;
     for (int i = 0; i < numParticles; i++) {
@@ -637,7 +637,7 @@ void testPME(bool triclinic) {
         ASSERT_EQUAL_VEC(refState.getForces()[i], Vec3(io.force[4*i], io.force[4*i+1], io.force[4*i+2]), 1e-3);
 }
 
-void testLJPME(bool triclinic) {
+void testLJPME(bool triclinic, int numThreads=0) {
     // Create a cloud of random LJ particles.
 
     const int numParticles = 51;
@@ -683,7 +683,7 @@ void testLJPME(bool triclinic) {
     
     // Now compute them with the optimized kernel.
     
-    CpuCalcDispersionPmeReciprocalForceKernel pme(CalcDispersionPmeReciprocalForceKernel::Name(), platform);
+    CpuCalcDispersionPmeReciprocalForceKernel pme(CalcDispersionPmeReciprocalForceKernel::Name(), platform, numThreads);
     IO io;
     double ewaldSelfEnergy = 0;
     for (int i = 0; i < numParticles; i++) {
@@ -714,8 +714,12 @@ int main(int argc, char* argv[]) {
         }
         testPME(false);
         testPME(true);
+        testPME(false, 1);
+        testPME(true, 3);
         testLJPME(false);
         testLJPME(true);
+        testLJPME(false, 1);
+        testLJPME(true, 3);
         test_water2_dpme_energies_forces_no_exclusions();
     }
     catch(const exception& e) {
@@ -38,11 +38,22 @@
 #include "openmm/common/IntegrationUtilities.h"
 #include "CommonKernelSources.h"
 #include "SimTKOpenMMRealType.h"
+#include <map>
 #include <set>
 
 using namespace OpenMM;
 using namespace std;
 
+/**
+ * The maximum number of previous positions used for DIIS extrapolation in DrudeSCFIntegrator.
+ */
+static const int MaxPrevSCFPositions = 8;
+
+/**
+ * The maximum number of SCF iterations DrudeSCFIntegrator takes before falling back to a general minimizer.
+ */
+static const int MaxSCFIterations = 50;
+
 class CommonDrudeForceInfo : public ComputeForceInfo {
 public:
     CommonDrudeForceInfo(const DrudeForce& force) : force(force) {
@@ -383,13 +394,22 @@ void CommonIntegrateDrudeSCFStepKernel::initialize(const System& system, const D
     cc.initializeContexts();
     ContextSelector selector(cc);
 
-    // Identify Drude particles.
+    // Identify Drude particles, and find the stiffness of the spring attaching each one to its parent.
+    // It is used to precondition the SCF iteration.
     
+    vector<double> invSpringConstant;
     for (int i = 0; i < force.getNumParticles(); i++) {
         int p, p1, p2, p3, p4;
         double charge, polarizability, aniso12, aniso34;
         force.getParticleParameters(i, p, p1, p2, p3, p4, charge, polarizability, aniso12, aniso34);
         drudeParticles.push_back(p);
+        double a1 = (p2 == -1 ? 1 : aniso12);
+        double a2 = (p3 == -1 || p4 == -1 ? 1 : aniso34);
+        double a3 = 3-a1-a2;
+        double k3 = ONE_4PI_EPS0*charge*charge/(polarizability*a3);
+        double k1 = ONE_4PI_EPS0*charge*charge/(polarizability*a1) - k3;
+        double k2 = ONE_4PI_EPS0*charge*charge/(polarizability*a2) - k3;
+        invSpringConstant.push_back(1.0/(k3+max(k1, 0.0)+max(k2, 0.0)));
     }
     
     // Initialize the energy minimizer.
@@ -406,6 +426,68 @@ void CommonIntegrateDrudeSCFStepKernel::initialize(const System& system, const D
     kernel1 = program->createKernel("integrateVerletPart1");
     kernel2 = program->createKernel("integrateVerletPart2");
     prevStepSize = -1.0;
+
+    // Create the arrays and kernels for the SCF iteration.
+
+    int numDrude = drudeParticles.size();
+    if (numDrude > 0) {
+        bool useMixed = (cc.getUseDoublePrecision() || cc.getUseMixedPrecision());
+        int elementSize = (useMixed ? sizeof(double) : sizeof(float));
+        numSCFBlocks = min(cc.getNumThreadBlocks(), (numDrude+63)/64);
+        drudeIndex.initialize<int>(cc, numDrude, "drudeIndex");
+        drudeInvSpringConstant.initialize(cc, numDrude, elementSize, "drudeInvSpringConstant");
+        prevPositions.initialize(cc, 3*numDrude*MaxPrevSCFPositions, elementSize, "prevPositions");
+        prevErrors.initialize(cc, 3*numDrude*MaxPrevSCFPositions, elementSize, "prevErrors");
+        diisMatrix.initialize(cc, MaxPrevSCFPositions*MaxPrevSCFPositions, elementSize, "diisMatrix");
+        diisCoefficients.initialize(cc, MaxPrevSCFPositions, elementSize, "diisCoefficients");
+        scfErrorBuffer.initialize(cc, numSCFBlocks, elementSize, "scfErrorBuffer");
+        scfState.initialize<mm_int2>(cc, 1, "scfState");
+        drudeIndex.upload(drudeParticles);
+        drudeInvSpringConstant.upload(invSpringConstant, true);
+        map<string, string> defines;
+        defines["NUM_DRUDE"] = cc.intToString(numDrude);
+        defines["MAX_PREV_DIIS"] = cc.intToString(MaxPrevSCFPositions);
+        defines["PADDED_NUM_ATOMS"] = cc.intToString(cc.getPaddedNumAtoms());
+        ComputeProgram scfProgram = cc.compileProgram(CommonDrudeKernelSources::drudeSCF, defines);
+        recordSCFKernel = scfProgram->createKernel("recordDrudeSCFIteration");
+        computeMatrixKernel = scfProgram->createKernel("computeDrudeSCFMatrix");
+        solveMatrixKernel = scfProgram->createKernel("solveDrudeSCFMatrix");
+        updatePositionsKernel = scfProgram->createKernel("updateDrudeSCFPositions");
+        recordSCFKernel->addArg(cc.getLongForceBuffer());
+        recordSCFKernel->addArg(cc.getPosq());
+        if (cc.getUseMixedPrecision())
+            recordSCFKernel->addArg(cc.getPosqCorrection());
+        recordSCFKernel->addArg(drudeIndex);
+        recordSCFKernel->addArg(drudeInvSpringConstant);
+        recordSCFKernel->addArg(prevPositions);
+        recordSCFKernel->addArg(prevErrors);
+        recordSCFKernel->addArg(diisMatrix);
+        recordSCFKernel->addArg(scfErrorBuffer);
+        recordSCFKernel->addArg(scfState);
+        recordSCFKernel->addArg(0);
+        computeMatrixKernel->addArg(prevErrors);
+        computeMatrixKernel->addArg(0);
+        computeMatrixKernel->addArg(diisMatrix);
+        computeMatrixKernel->addArg(scfState);
+        solveMatrixKernel->addArg(0);
+        solveMatrixKernel->addArg(diisMatrix);
+        solveMatrixKernel->addArg(diisCoefficients);
+        solveMatrixKernel->addArg(scfErrorBuffer);
+        solveMatrixKernel->addArg(numSCFBlocks);
+        if (useMixed)
+            solveMatrixKernel->addArg(integrator.getMinimizationErrorTolerance());
+        else
+            solveMatrixKernel->addArg((float) integrator.getMinimizationErrorTolerance());
+        solveMatrixKernel->addArg(scfState);
+        updatePositionsKernel->addArg(cc.getPosq());
+        if (cc.getUseMixedPrecision())
+            updatePositionsKernel->addArg(cc.getPosqCorrection());
+        updatePositionsKernel->addArg(drudeIndex);
+        updatePositionsKernel->addArg(prevPositions);
+        updatePositionsKernel->addArg(diisCoefficients);
+        updatePositionsKernel->addArg(0);
+        updatePositionsKernel->addArg(scfState);
+    }
 }
 
 void CommonIntegrateDrudeSCFStepKernel::execute(ContextImpl& context, const DrudeSCFIntegrator& integrator) {
@@ -461,7 +543,8 @@ void CommonIntegrateDrudeSCFStepKernel::execute(ContextImpl& context, const Drud
     // Update the positions of virtual sites and Drude particles.
 
     integration.computeVirtualSites();
-    minimize(context, integrator.getMinimizationErrorTolerance());
+    if (!iterateSCF(context, integrator.getMinimizationErrorTolerance()))
+        minimize(context, integrator.getMinimizationErrorTolerance());
 
     // Update the time and step count.
 
@@ -480,6 +563,42 @@ double CommonIntegrateDrudeSCFStepKernel::computeKineticEnergy(ContextImpl& cont
     return cc.getIntegrationUtilities().computeKineticEnergy(0.5*integrator.getStepSize());
 }
 
+bool CommonIntegrateDrudeSCFStepKernel::iterateSCF(ContextImpl& context, double tolerance) {
+    // Each iteration moves every Drude particle by the displacement that would cancel the force on it if
+    // only its spring were present, then uses DIIS to extrapolate from the previous iterations.  All of this
+    // happens on the device.  To avoid synchronizing after every force evaluation, we only check whether it
+    // has converged once we reach the number of iterations the previous step needed.  Any iterations beyond
+    // convergence do nothing except evaluate the forces again at the same positions.
+
+    if (drudeParticles.size() == 0)
+        return true;
+    int recordIterationIndex = (cc.getUseMixedPrecision() ? 11 : 10);
+    int numPrevIndex = (cc.getUseMixedPrecision() ? 5 : 4);
+    int matrixBlockSize = min(512, cc.getMaxThreadBlockSize());
+    int matrixThreadBlocks = min(MaxPrevSCFPositions, cc.getNumThreadBlocks());
+    for (int iteration = 0; iteration < MaxSCFIterations; iteration++) {
+        context.calcForcesAndEnergy(true, false, context.getIntegrator().getIntegrationForceGroups());
+        recordSCFKernel->setArg(recordIterationIndex, iteration);
+        recordSCFKernel->execute(numSCFBlocks*64, 64);
+        computeMatrixKernel->setArg(1, iteration);
+        computeMatrixKernel->execute(matrixThreadBlocks*matrixBlockSize, matrixBlockSize);
+        solveMatrixKernel->setArg(0, iteration);
+        solveMatrixKernel->execute(32, 32);
+        updatePositionsKernel->setArg(numPrevIndex, min(iteration+1, MaxPrevSCFPositions));
+        updatePositionsKernel->execute(drudeParticles.size());
+        if (iteration+1 >= expectedSCFIterations) {
+            vector<mm_int2> state;
+            scfState.download(state);
+            if (state[0].x != 0) {
+                expectedSCFIterations = state[0].y;
+                return true;
+            }
+        }
+    }
+    expectedSCFIterations = 1;
+    return false;
+}
+
 struct MinimizerData {
     ContextImpl& context;
     ComputeContext& cc;
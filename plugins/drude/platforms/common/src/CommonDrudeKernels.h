@@ -121,7 +121,7 @@ private:
 class CommonIntegrateDrudeSCFStepKernel : public IntegrateDrudeSCFStepKernel {
 public:
     CommonIntegrateDrudeSCFStepKernel(const std::string& name, const Platform& platform, ComputeContext& cc) :
-            IntegrateDrudeSCFStepKernel(name, platform), cc(cc), minimizerPos(NULL), hasInitializedKernels(false) {
+            IntegrateDrudeSCFStepKernel(name, platform), cc(cc), minimizerPos(NULL), hasInitializedKernels(false), expectedSCFIterations(1) {
     }
     ~CommonIntegrateDrudeSCFStepKernel();
     /**
@@ -147,14 +147,17 @@ public:
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
 private:
+    bool iterateSCF(ContextImpl& context, double tolerance);
     void minimize(ContextImpl& context, double tolerance);
     ComputeContext& cc;
     double prevStepSize;
     bool hasInitializedKernels;
+    int expectedSCFIterations, numSCFBlocks;
     std::vector<int> drudeParticles;
     lbfgsfloatval_t *minimizerPos;
     lbfgs_parameter_t minimizerParams;
-    ComputeKernel kernel1, kernel2;
+    ComputeArray drudeIndex, drudeInvSpringConstant, prevPositions, prevErrors, diisMatrix, diisCoefficients, scfErrorBuffer, scfState;
+    ComputeKernel kernel1, kernel2, recordSCFKernel, computeMatrixKernel, solveMatrixKernel, updatePositionsKernel;
 };
 
 } // namespace OpenMM
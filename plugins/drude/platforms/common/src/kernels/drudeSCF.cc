@@ -0,0 +1,269 @@
+/**
+ * Each SCF iteration moves every Drude particle by the displacement that would cancel the force on it if only
+ * its spring were present, then uses DIIS to extrapolate from the previous iterations.  The state array records
+ * whether the iteration has converged, and if so, how many force evaluations that took.  Once it has converged,
+ * all the kernels do nothing for the remaining iterations of the step.
+ */
+
+/**
+ * Record the positions and errors from the latest force evaluation, and sum the squared forces on Drude particles.
+ */
+KERNEL void recordDrudeSCFIteration(GLOBAL const mm_long* RESTRICT force, GLOBAL const real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL const real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL const int* RESTRICT drudeIndex, GLOBAL const mixed* RESTRICT invSpringConstant, GLOBAL mixed* RESTRICT prevPositions,
+        GLOBAL mixed* RESTRICT prevErrors, GLOBAL mixed* RESTRICT matrix, GLOBAL mixed* RESTRICT errorBuffer, GLOBAL const int2* RESTRICT state, int iteration) {
+    if (iteration > 0 && state[0].x != 0)
+        return;
+    LOCAL mixed buffer[64];
+    const mixed forceScale = 1/(mixed) 0x100000000;
+    mixed sumForce2 = 0;
+    int storeIndex = min(iteration, MAX_PREV_DIIS-1);
+    for (int i = GLOBAL_ID; i < NUM_DRUDE; i += GLOBAL_SIZE) {
+        if (iteration >= MAX_PREV_DIIS) {
+            // We have filled up the buffer for previous positions, so shift them all over by one.
+
+            for (int j = 1; j < MAX_PREV_DIIS; j++) {
+                int index1 = 3*(i+(j-1)*NUM_DRUDE);
+                int index2 = 3*(i+j*NUM_DRUDE);
+                for (int k = 0; k < 3; k++) {
+                    prevPositions[index1+k] = prevPositions[index2+k];
+                    prevErrors[index1+k] = prevErrors[index2+k];
+                }
+            }
+        }
+
+        // Record the new position and the error.
+
+        int atom = drudeIndex[i];
+        real4 pos1 = posq[atom];
+#ifdef USE_MIXED_PRECISION
+        real4 pos2 = posqCorrection[atom];
+        mixed3 pos = make_mixed3(pos1.x+(mixed)pos2.x, pos1.y+(mixed)pos2.y, pos1.z+(mixed)pos2.z);
+#else
+        mixed3 pos = make_mixed3(pos1.x, pos1.y, pos1.z);
+#endif
+        mixed3 f = make_mixed3(force[atom], force[atom+PADDED_NUM_ATOMS], force[atom+2*PADDED_NUM_ATOMS])*forceScale;
+        mixed3 error = f*invSpringConstant[i];
+        int index = 3*(i+storeIndex*NUM_DRUDE);
+        prevPositions[index] = pos.x+error.x;
+        prevPositions[index+1] = pos.y+error.y;
+        prevPositions[index+2] = pos.z+error.z;
+        prevErrors[index] = error.x;
+        prevErrors[index+1] = error.y;
+        prevErrors[index+2] = error.z;
+        sumForce2 += f.x*f.x + f.y*f.y + f.z*f.z;
+    }
+
+    // Sum the squared forces over threads and store the total for this block.
+
+    buffer[LOCAL_ID] = sumForce2;
+    SYNC_THREADS;
+    for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+        if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0)
+            buffer[LOCAL_ID] += buffer[LOCAL_ID+offset];
+        SYNC_THREADS;
+    }
+    if (LOCAL_ID == 0)
+        errorBuffer[GROUP_ID] = buffer[0];
+    if (iteration >= MAX_PREV_DIIS && GROUP_ID == 0) {
+        // Shift over the existing matrix elements.
+
+        for (int i = 0; i < MAX_PREV_DIIS-1; i++) {
+            if (LOCAL_ID < MAX_PREV_DIIS-1)
+                matrix[LOCAL_ID+i*MAX_PREV_DIIS] = matrix[(LOCAL_ID+1)+(i+1)*MAX_PREV_DIIS];
+            SYNC_THREADS;
+        }
+    }
+}
+
+/**
+ * Compute the row of the DIIS matrix for the latest iteration.
+ */
+KERNEL void computeDrudeSCFMatrix(GLOBAL const mixed* RESTRICT prevErrors, int iteration, GLOBAL mixed* RESTRICT matrix, GLOBAL const int2* RESTRICT state) {
+    if (iteration > 0 && state[0].x != 0)
+        return;
+    LOCAL mixed sumBuffer[512];
+    int j = min(iteration, MAX_PREV_DIIS-1);
+    for (int i = GROUP_ID; i <= j; i += NUM_GROUPS) {
+        // All the threads in this thread block work together to compute a single matrix element.
+
+        mixed sum = 0;
+        for (int index = LOCAL_ID; index < 3*NUM_DRUDE; index += LOCAL_SIZE)
+            sum += prevErrors[index+i*3*NUM_DRUDE]*prevErrors[index+j*3*NUM_DRUDE];
+        sumBuffer[LOCAL_ID] = sum;
+        SYNC_THREADS;
+        for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+            if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0)
+                sumBuffer[LOCAL_ID] += sumBuffer[LOCAL_ID+offset];
+            SYNC_THREADS;
+        }
+        if (LOCAL_ID == 0) {
+            matrix[i+MAX_PREV_DIIS*j] = sumBuffer[0];
+            if (i != j)
+                matrix[j+MAX_PREV_DIIS*i] = sumBuffer[0];
+        }
+    }
+}
+
+/**
+ * Check whether the iteration has converged.  If not, solve for the DIIS coefficients.
+ */
+KERNEL void solveDrudeSCFMatrix(int iteration, GLOBAL const mixed* RESTRICT matrix, GLOBAL mixed* RESTRICT coefficients,
+        GLOBAL const mixed* RESTRICT errorBuffer, int numErrorBlocks, mixed tolerance, GLOBAL int2* RESTRICT state) {
+    LOCAL mixed b[MAX_PREV_DIIS+1][MAX_PREV_DIIS+1];
+    LOCAL mixed piv[MAX_PREV_DIIS+1];
+    LOCAL mixed x[MAX_PREV_DIIS+1];
+    LOCAL int converged;
+
+    // Check for convergence.
+
+    if (LOCAL_ID == 0) {
+        if (iteration > 0 && state[0].x != 0)
+            converged = 1;
+        else {
+            mixed sumForce2 = 0;
+            for (int i = 0; i < numErrorBlocks; i++)
+                sumForce2 += errorBuffer[i];
+            converged = (SQRT(sumForce2/NUM_DRUDE) < tolerance);
+            state[0] = make_int2(converged, iteration+1);
+        }
+    }
+    SYNC_THREADS;
+    if (converged)
+        return;
+
+    // On the first iteration we don't need to do any calculation.
+
+    if (iteration == 0) {
+        if (LOCAL_ID == 0)
+            coefficients[0] = 1;
+        return;
+    }
+
+    // Load the matrix.
+
+    int numPrev = min(iteration+1, MAX_PREV_DIIS);
+    int rank = numPrev+1;
+    for (int index = LOCAL_ID; index < numPrev*numPrev; index += LOCAL_SIZE) {
+        int i = index/numPrev;
+        int j = index-i*numPrev;
+        b[i+1][j+1] = matrix[i*MAX_PREV_DIIS+j];
+    }
+    for (int i = LOCAL_ID; i < rank; i += LOCAL_SIZE) {
+        b[i][0] = -1;
+        piv[i] = i;
+    }
+    SYNC_THREADS;
+
+    // Compute the mean absolute value of the values we just loaded.  We use that for preconditioning it,
+    // which is essential for doing the computation in single precision.
+
+    if (LOCAL_ID == 0) {
+        mixed mean = 0;
+        for (int i = 0; i < numPrev; i++)
+            for (int j = 0; j < numPrev; j++)
+                mean += fabs(b[i+1][j+1]);
+        mean /= numPrev*numPrev;
+        b[0][0] = 0;
+        for (int i = 1; i < rank; i++)
+            b[0][i] = -mean;
+
+        // Compute the LU decomposition of the matrix.  This code is adapted from JAMA.
+
+        for (int j = 0; j < rank; j++) {
+            // Apply previous transformations.
+
+            for (int i = 0; i < rank; i++) {
+                int kmax = min(i, j);
+                mixed s = 0;
+                for (int k = 0; k < kmax; k++)
+                    s += b[i][k] * b[k][j];
+                b[i][j] -= s;
+            }
+
+            // Find pivot and exchange if necessary.
+
+            int p = j;
+            for (int i = j+1; i < rank; i++)
+                if (fabs(b[i][j]) > fabs(b[p][j]))
+                    p = i;
+            if (p != j) {
+                for (int k = 0; k < rank; k++) {
+                    mixed t = b[p][k];
+                    b[p][k] = b[j][k];
+                    b[j][k] = t;
+                }
+                mixed t = piv[p];
+                piv[p] = piv[j];
+                piv[j] = t;
+            }
+
+            // Compute multipliers.
+
+            if (b[j][j] != 0)
+                for (int i = j+1; i < rank; i++)
+                    b[i][j] /= b[j][j];
+        }
+        for (int i = 0; i < rank; i++)
+            if (b[i][i] == 0) {
+                // The matrix is singular, so just use the latest positions.
+
+                for (int j = 0; j < rank-1; j++)
+                    coefficients[j] = 0;
+                coefficients[rank-2] = 1;
+                return;
+            }
+
+        // Solve b*Y = X(piv)
+
+        for (int i = 0; i < rank; i++)
+            x[i] = (piv[i] == 0 ? -1 : 0);
+        for (int k = 0; k < rank; k++)
+            for (int i = k+1; i < rank; i++)
+                x[i] -= x[k] * b[i][k];
+
+        // Solve U*X = Y;
+
+        for (int k = rank-1; k >= 0; k--) {
+            x[k] /= b[k][k];
+            for (int i = 0; i < k; i++)
+                x[i] -= x[k] * b[i][k];
+        }
+
+        // Record the coefficients.
+
+        for (int i = 0; i < rank-1; i++)
+            coefficients[i] = x[i+1]*mean;
+    }
+}
+
+/**
+ * Set the positions of Drude particles to the combination of previous positions selected by DIIS.
+ */
+KERNEL void updateDrudeSCFPositions(GLOBAL real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL const int* RESTRICT drudeIndex, GLOBAL const mixed* RESTRICT prevPositions, GLOBAL const mixed* RESTRICT coefficients,
+        int numPrev, GLOBAL const int2* RESTRICT state) {
+    if (state[0].x != 0)
+        return;
+    for (int i = GLOBAL_ID; i < NUM_DRUDE; i += GLOBAL_SIZE) {
+        mixed3 pos = make_mixed3(0);
+        for (int j = 0; j < numPrev; j++) {
+            int index = 3*(i+j*NUM_DRUDE);
+            pos += make_mixed3(prevPositions[index], prevPositions[index+1], prevPositions[index+2])*coefficients[j];
+        }
+        int atom = drudeIndex[i];
+        real4 p = posq[atom];
+        p.x = (real) pos.x;
+        p.y = (real) pos.y;
+        p.z = (real) pos.z;
+        posq[atom] = p;
+#ifdef USE_MIXED_PRECISION
+        posqCorrection[atom] = make_real4(pos.x-(real) pos.x, pos.y-(real) pos.y, pos.z-(real) pos.z, 0);
+#endif
+    }
+}
@@ -0,0 +1,68 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMDrude                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuDrudeKernelFactory.h"
+#include "CpuDrudeKernels.h"
+#include "CpuPlatform.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/OpenMMException.h"
+
+using namespace OpenMM;
+
+extern "C" OPENMM_EXPORT void registerPlatforms() {
+}
+
+// The registration is done by a static function so that calls made through
+// registerDrudeCpuKernelFactories() cannot be redirected to the identically
+// named registerKernelFactories() of another plugin the program is linked against.
+
+static void registerDrudeCpuKernels() {
+    for (int i = 0; i < Platform::getNumPlatforms(); i++) {
+        Platform& platform = Platform::getPlatform(i);
+        if (dynamic_cast<CpuPlatform*>(&platform) != NULL) {
+            CpuDrudeKernelFactory* factory = new CpuDrudeKernelFactory();
+            platform.registerKernelFactory(CalcDrudeForceKernel::Name(), factory);
+            platform.registerKernelFactory(IntegrateDrudeLangevinStepKernel::Name(), factory);
+        }
+    }
+}
+
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+    registerDrudeCpuKernels();
+}
+
+extern "C" OPENMM_EXPORT void registerDrudeCpuKernelFactories() {
+    registerDrudeCpuKernels();
+}
+
+KernelImpl* CpuDrudeKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
+    CpuPlatform::PlatformData& data = CpuPlatform::getPlatformData(context);
+    if (name == CalcDrudeForceKernel::Name())
+        return new CpuCalcDrudeForceKernel(name, platform, data);
+    if (name == IntegrateDrudeLangevinStepKernel::Name())
+        return new CpuIntegrateDrudeLangevinStepKernel(name, platform, data);
+    throw OpenMMException((std::string("Tried to create kernel with illegal kernel name '")+name+"'").c_str());
+}
@@ -31,24 +31,35 @@
 #include "openmm/OpenMMException.h"
 
 using namespace OpenMM;
+using namespace std;
 
 extern "C" OPENMM_EXPORT void registerPlatforms() {
 }
 
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
+static void registerDrudeReferenceKernels() {
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
+            // Platforms derived from ReferencePlatform (such as CPU) may provide optimized
+            // versions of some kernels through their own plugins.  Only fill in the ones
+            // that are still missing, so plugin load order does not matter.
+
             ReferenceDrudeKernelFactory* factory = new ReferenceDrudeKernelFactory();
-            platform.registerKernelFactory(CalcDrudeForceKernel::Name(), factory);
-            platform.registerKernelFactory(IntegrateDrudeLangevinStepKernel::Name(), factory);
-            platform.registerKernelFactory(IntegrateDrudeSCFStepKernel::Name(), factory);
+            vector<string> kernelNames = {CalcDrudeForceKernel::Name(), IntegrateDrudeLangevinStepKernel::Name(),
+                    IntegrateDrudeSCFStepKernel::Name()};
+            for (const string& name : kernelNames)
+                if (!platform.supportsKernels(vector<string>(1, name)))
+                    platform.registerKernelFactory(name, factory);
         }
     }
 }
 
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+    registerDrudeReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerDrudeReferenceKernelFactories() {
-    registerKernelFactories();
+    registerDrudeReferenceKernels();
 }
 
 KernelImpl* ReferenceDrudeKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
@@ -36,11 +36,22 @@
 #include "SimTKOpenMMUtilities.h"
 #include "ReferenceConstraints.h"
 #include "ReferenceVirtualSites.h"
+#include "jama_svd.h"
 #include <set>
 
 using namespace OpenMM;
 using namespace std;
 
+/**
+ * The maximum number of previous positions used for DIIS extrapolation in DrudeSCFIntegrator.
+ */
+static const int MaxPrevSCFPositions = 8;
+
+/**
+ * The maximum number of SCF iterations DrudeSCFIntegrator takes before falling back to a general minimizer.
+ */
+static const int MaxSCFIterations = 50;
+
 static vector<Vec3>& extractPositions(ContextImpl& context) {
     ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
     return *data->positions;
@@ -389,13 +400,21 @@ ReferenceIntegrateDrudeSCFStepKernel::~ReferenceIntegrateDrudeSCFStepKernel() {
 }
 
 void ReferenceIntegrateDrudeSCFStepKernel::initialize(const System& system, const DrudeSCFIntegrator& integrator, const DrudeForce& force) {
-    // Identify Drude particles.
+    // Identify Drude particles, and find the stiffness of the spring attaching each one to its parent.
+    // It is used to precondition the SCF iteration.
     
     for (int i = 0; i < force.getNumParticles(); i++) {
         int p, p1, p2, p3, p4;
         double charge, polarizability, aniso12, aniso34;
         force.getParticleParameters(i, p, p1, p2, p3, p4, charge, polarizability, aniso12, aniso34);
         drudeParticles.push_back(p);
+        double a1 = (p2 == -1 ? 1 : aniso12);
+        double a2 = (p3 == -1 || p4 == -1 ? 1 : aniso34);
+        double a3 = 3-a1-a2;
+        double k3 = ONE_4PI_EPS0*charge*charge/(polarizability*a3);
+        double k1 = ONE_4PI_EPS0*charge*charge/(polarizability*a1) - k3;
+        double k2 = ONE_4PI_EPS0*charge*charge/(polarizability*a2) - k3;
+        drudeInvSpringConstant.push_back(1.0/(k3+max(k1, 0.0)+max(k2, 0.0)));
     }
 
     // Record particle masses.
@@ -452,7 +471,8 @@ void ReferenceIntegrateDrudeSCFStepKernel::execute(ContextImpl& context, const D
     // Update the positions of virtual sites and Drude particles.
     
     ReferenceVirtualSites::computePositions(context.getSystem(), pos);
-    minimize(context, integrator.getMinimizationErrorTolerance());
+    if (!iterateSCF(context, integrator.getMinimizationErrorTolerance()))
+        minimize(context, integrator.getMinimizationErrorTolerance());
     data.time += integrator.getStepSize();
     data.stepCount++;
 }
@@ -461,6 +481,95 @@ double ReferenceIntegrateDrudeSCFStepKernel::computeKineticEnergy(ContextImpl& c
     return computeShiftedKineticEnergy(context, particleInvMass, 0.5*integrator.getStepSize());
 }
 
+static void computeDIISCoefficients(const vector<vector<Vec3> >& prevErrors, vector<double>& coefficients) {
+    int steps = coefficients.size();
+    if (steps == 1) {
+        coefficients[0] = 1;
+        return;
+    }
+
+    // Create the DIIS matrix.
+
+    int rank = steps+1;
+    int numParticles = prevErrors[0].size();
+    TNT::Array2D<double> b(rank, rank);
+    b[0][0] = 0;
+    for (int i = 0; i < steps; i++)
+        b[i+1][0] = b[0][i+1] = -1;
+    for (int i = 0; i < steps; i++)
+        for (int j = i; j < steps; j++) {
+            double sum = 0;
+            for (int k = 0; k < numParticles; k++)
+                sum += prevErrors[i][k].dot(prevErrors[j][k]);
+            b[i+1][j+1] = b[j+1][i+1] = sum;
+        }
+
+    // Solve using SVD.  Since the right hand side is (-1, 0, 0, 0, ...), this is simpler than the general case.
+
+    JAMA::SVD<double> svd(b);
+    TNT::Array2D<double> u, v;
+    svd.getU(u);
+    svd.getV(v);
+    TNT::Array1D<double> s;
+    svd.getSingularValues(s);
+    int effectiveRank = svd.rank();
+    for (int i = 1; i < rank; i++) {
+        double d = 0;
+        for (int j = 0; j < effectiveRank; j++)
+            d -= u[0][j]*v[i][j]/s[j];
+        coefficients[i-1] = d;
+    }
+}
+
+bool ReferenceIntegrateDrudeSCFStepKernel::iterateSCF(ContextImpl& context, double tolerance) {
+    // Each iteration moves every Drude particle by the displacement that would cancel the force on it if
+    // only its spring were present, then uses DIIS to extrapolate from the previous iterations.  This usually
+    // converges in far fewer force evaluations than a general purpose minimizer.
+
+    vector<Vec3>& pos = extractPositions(context);
+    vector<Vec3>& force = extractForces(context);
+    int numDrudeParticles = drudeParticles.size();
+    if (numDrudeParticles == 0)
+        return true;
+    vector<vector<Vec3> > prevPositions, prevErrors;
+    for (int iteration = 0; iteration < MaxSCFIterations; iteration++) {
+        // Compute the forces on the Drude particles and check for convergence.
+
+        context.calcForcesAndEnergy(true, false, context.getIntegrator().getIntegrationForceGroups());
+        vector<Vec3> position(numDrudeParticles), error(numDrudeParticles);
+        double sumForce2 = 0;
+        for (int i = 0; i < numDrudeParticles; i++) {
+            Vec3 f = force[drudeParticles[i]];
+            sumForce2 += f.dot(f);
+            error[i] = f*drudeInvSpringConstant[i];
+            position[i] = pos[drudeParticles[i]]+error[i];
+        }
+        if (sqrt(sumForce2/numDrudeParticles) < tolerance)
+            return true;
+
+        // Record the new positions and errors, discarding the oldest ones if necessary.
+
+        if ((int) prevPositions.size() == MaxPrevSCFPositions) {
+            prevPositions.erase(prevPositions.begin());
+            prevErrors.erase(prevErrors.begin());
+        }
+        prevPositions.push_back(position);
+        prevErrors.push_back(error);
+
+        // Take the combination of previous positions that minimizes the error.
+
+        vector<double> coefficients(prevErrors.size());
+        computeDIISCoefficients(prevErrors, coefficients);
+        for (int i = 0; i < numDrudeParticles; i++) {
+            Vec3 p;
+            for (int j = 0; j < (int) coefficients.size(); j++)
+                p += prevPositions[j][i]*coefficients[j];
+            pos[drudeParticles[i]] = p;
+        }
+    }
+    return false;
+}
+
 struct MinimizerData {
     ContextImpl& context;
     vector<int>& drudeParticles;
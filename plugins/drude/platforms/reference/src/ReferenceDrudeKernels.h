@@ -153,10 +153,11 @@ public:
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
 private:
+    bool iterateSCF(ContextImpl& context, double tolerance);
     void minimize(ContextImpl& context, double tolerance);
     ReferencePlatform::PlatformData& data;
     std::vector<int> drudeParticles;
-    std::vector<double> particleInvMass;
+    std::vector<double> particleInvMass, drudeInvSpringConstant;
     lbfgsfloatval_t *minimizerPos;
     lbfgs_parameter_t minimizerParams;
     double maxDrudeDistance;
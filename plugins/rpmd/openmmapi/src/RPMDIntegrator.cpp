@@ -107,12 +107,14 @@ State RPMDIntegrator::getState(int copy, int types, bool enforcePeriodicBox, int
         isFirstStep = false;
     }
     kernel.getAs<IntegrateRPMDStepKernel>().copyToContext(copy, *context);
+    context->invalidateCachedForces();
     State state = context->getOwner().getState(types, enforcePeriodicBox && copy == 0, groups);
     if (enforcePeriodicBox && copy > 0 && (types&State::Positions) != 0) {
         // Apply periodic boundary conditions based on copy 0.  Otherwise, molecules might end
         // up in different places for different copies.
 
         kernel.getAs<IntegrateRPMDStepKernel>().copyToContext(0, *context);
+        context->invalidateCachedForces();
         State state2 = context->getOwner().getState(State::Positions, false, groups);
         vector<Vec3> positions = state.getPositions();
         const vector<Vec3>& refPos = state2.getPositions();
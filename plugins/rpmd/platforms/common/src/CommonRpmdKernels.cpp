@@ -151,6 +151,7 @@ void CommonIntegrateRPMDStepKernel::initialize(const System& system, const RPMDI
     velocitiesKernel = program->createKernel("advanceVelocities");
     copyToContextKernel = program->createKernel("copyDataToContext");
     copyFromContextKernel = program->createKernel("copyDataFromContext");
+    swapContextKernel = program->createKernel("swapDataInContext");
     translateKernel = program->createKernel("applyCellTranslations");
     
     // Create kernels for doing contractions.
@@ -205,6 +206,16 @@ void CommonIntegrateRPMDStepKernel::initializeKernels(ContextImpl& context) {
     copyFromContextKernel->addArg();
     copyFromContextKernel->addArg(cc.getAtomIndexArray());
     copyFromContextKernel->addArg();
+    swapContextKernel->addArg(cc.getLongForceBuffer());
+    swapContextKernel->addArg();
+    swapContextKernel->addArg(cc.getVelm());
+    swapContextKernel->addArg(velocities);
+    swapContextKernel->addArg(cc.getPosq());
+    swapContextKernel->addArg();
+    swapContextKernel->addArg();
+    swapContextKernel->addArg(cc.getAtomIndexArray());
+    swapContextKernel->addArg();
+    swapContextKernel->addArg();
     for (auto& g : groupsByCopies) {
         int copies = g.first;
         positionContractionKernels[copies]->addArg(positions);
@@ -283,14 +294,21 @@ void CommonIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDInte
 }
 
 void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
-    // Compute forces from all groups that didn't have a specified contraction.
+    // Compute forces from all groups that didn't have a specified contraction.  Between copies, a single
+    // kernel copies the results for one copy out of the context and the positions for the next one in.
 
     copyToContextKernel->setArg(2, positions);
-    copyFromContextKernel->setArg(1, forces);
-    copyFromContextKernel->setArg(5, positions);
+    copyToContextKernel->setArg(5, 0);
+    copyToContextKernel->execute(cc.getNumAtoms());
+    swapContextKernel->setArg(1, forces);
+    swapContextKernel->setArg(5, positions);
+    swapContextKernel->setArg(6, positions);
     for (int i = 0; i < numCopies; i++) {
-        copyToContextKernel->setArg(5, i);
-        copyToContextKernel->execute(cc.getNumAtoms());
+        if (i > 0) {
+            swapContextKernel->setArg(8, i-1);
+            swapContextKernel->setArg(9, i);
+            swapContextKernel->execute(cc.getNumAtoms());
+        }
         context.computeVirtualSites();
         Vec3 initialBox[3];
         context.getPeriodicBoxVectors(initialBox[0], initialBox[1], initialBox[2]);
@@ -300,9 +318,11 @@ void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
         if (initialBox[0] != finalBox[0] || initialBox[1] != finalBox[1] || initialBox[2] != finalBox[2])
             throw OpenMMException("Standard barostats cannot be used with RPMDIntegrator.  Use RPMDMonteCarloBarostat instead.");
         context.calcForcesAndEnergy(true, false, groupsNotContracted);
-        copyFromContextKernel->setArg(7, i);
-        copyFromContextKernel->execute(cc.getNumAtoms());
     }
+    copyFromContextKernel->setArg(1, forces);
+    copyFromContextKernel->setArg(5, positions);
+    copyFromContextKernel->setArg(7, numCopies-1);
+    copyFromContextKernel->execute(cc.getNumAtoms());
     
     // Now loop over contractions and compute forces from them.
     
@@ -310,22 +330,42 @@ void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
         copyToContextKernel->setArg(2, contractedPositions);
         copyFromContextKernel->setArg(1, contractedForces);
         copyFromContextKernel->setArg(5, contractedPositions);
+        swapContextKernel->setArg(1, contractedForces);
+        swapContextKernel->setArg(5, contractedPositions);
+        int groupIndex = 0;
         for (auto& g : groupsByCopies) {
             int copies = g.first;
             int groupFlags = g.second;
+            bool isLastGroup = (++groupIndex == (int) groupsByCopies.size());
 
             // Find the contracted positions.
 
-           positionContractionKernels[copies]->execute(numParticles*numCopies, workgroupSize);
+            positionContractionKernels[copies]->execute(numParticles*numCopies, workgroupSize);
 
             // Compute forces.
 
+            copyToContextKernel->setArg(5, 0);
+            copyToContextKernel->execute(cc.getNumAtoms());
+            swapContextKernel->setArg(6, contractedPositions);
             for (int i = 0; i < copies; i++) {
-                copyToContextKernel->setArg(5, i);
-                copyToContextKernel->execute(cc.getNumAtoms());
+                if (i > 0) {
+                    swapContextKernel->setArg(8, i-1);
+                    swapContextKernel->setArg(9, i);
+                    swapContextKernel->execute(cc.getNumAtoms());
+                }
                 context.computeVirtualSites();
                 context.calcForcesAndEnergy(true, false, groupFlags);
-                copyFromContextKernel->setArg(7, i);
+            }
+            if (isLastGroup) {
+                // Ensure the Context contains the positions from the last copy, since we'll assume that later.
+
+                swapContextKernel->setArg(6, positions);
+                swapContextKernel->setArg(8, copies-1);
+                swapContextKernel->setArg(9, numCopies-1);
+                swapContextKernel->execute(cc.getNumAtoms());
+            }
+            else {
+                copyFromContextKernel->setArg(7, copies-1);
                 copyFromContextKernel->execute(cc.getNumAtoms());
             }
 
@@ -334,13 +374,6 @@ void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
             forceContractionKernels[copies]->execute(numParticles*numCopies, workgroupSize);
         }
     }
-    if (groupsByCopies.size() > 0) {
-        // Ensure the Context contains the positions from the last copy, since we'll assume that later.
-        
-        copyToContextKernel->setArg(2, positions);
-        copyToContextKernel->setArg(5, numCopies-1);
-        copyToContextKernel->execute(cc.getNumAtoms());
-    }
 }
 
 double CommonIntegrateRPMDStepKernel::computeKineticEnergy(ContextImpl& context, const RPMDIntegrator& integrator) {
@@ -97,7 +97,7 @@ private:
     ComputeArray velocities;
     ComputeArray contractedForces;
     ComputeArray contractedPositions;
-    ComputeKernel pileKernel, stepKernel, velocitiesKernel, copyToContextKernel, copyFromContextKernel, translateKernel;
+    ComputeKernel pileKernel, stepKernel, velocitiesKernel, copyToContextKernel, copyFromContextKernel, swapContextKernel, translateKernel;
     std::map<int, ComputeKernel> positionContractionKernels;
     std::map<int, ComputeKernel> forceContractionKernels;
 };
@@ -220,6 +220,34 @@ KERNEL void copyDataFromContext(GLOBAL mm_long* srcForce, GLOBAL mm_long* dstFor
     }
 }
 
+/**
+ * Copy the positions, velocities, and forces of one copy from the context to the integrator's arrays, then copy
+ * the positions and velocities of another copy into the context.  This is equivalent to copyDataFromContext()
+ * followed by copyDataToContext(), but needs only one kernel launch.
+ */
+KERNEL void swapDataInContext(GLOBAL mm_long* srcForce, GLOBAL mm_long* dstForce, GLOBAL mixed4* contextVel, GLOBAL mixed4* vel,
+        GLOBAL real4* contextPos, GLOBAL mixed4* dstPos, GLOBAL mixed4* srcPos, GLOBAL int* order, int fromCopy, int toCopy) {
+    const int fromBase = fromCopy*PADDED_NUM_ATOMS;
+    const int toBase = toCopy*PADDED_NUM_ATOMS;
+    for (int particle = GLOBAL_ID; particle < NUM_ATOMS; particle += GLOBAL_SIZE) {
+        int index = order[particle];
+        dstForce[fromBase*3+index] = srcForce[particle];
+        dstForce[fromBase*3+index+PADDED_NUM_ATOMS] = srcForce[particle+PADDED_NUM_ATOMS];
+        dstForce[fromBase*3+index+PADDED_NUM_ATOMS*2] = srcForce[particle+PADDED_NUM_ATOMS*2];
+        vel[fromBase+index] = contextVel[particle];
+        real4 posq = contextPos[particle];
+        dstPos[fromBase+index].x = posq.x;
+        dstPos[fromBase+index].y = posq.y;
+        dstPos[fromBase+index].z = posq.z;
+        contextVel[particle] = vel[toBase+index];
+        mixed4 newPos = srcPos[toBase+index];
+        posq.x = newPos.x;
+        posq.y = newPos.y;
+        posq.z = newPos.z;
+        contextPos[particle] = posq;
+    }
+}
+
 /**
  * Atom positions in one copy have been modified.  Apply the same offsets to all the other copies.
  */
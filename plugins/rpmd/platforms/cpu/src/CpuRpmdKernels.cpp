@@ -0,0 +1,389 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuRpmdKernels.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/ContextImpl.h"
+#include "SimTKOpenMMUtilities.h"
+#ifdef _MSC_VER
+  #define POCKETFFT_NO_VECTORS
+#endif
+#include "pocketfft_hdronly.h"
+
+using namespace OpenMM;
+using namespace std;
+
+static vector<Vec3>& extractPositions(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->positions;
+}
+
+static vector<Vec3>& extractVelocities(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->velocities;
+}
+
+static vector<Vec3>& extractForces(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->forces;
+}
+
+/**
+ * Perform an in-place FFT of length n.  Each call is small, so it is done on the calling thread.
+ */
+static void fft(vector<complex<double> >& data, int n, bool forward) {
+    pocketfft::c2c({(size_t) n}, {sizeof(complex<double>)}, {sizeof(complex<double>)}, {0}, forward, data.data(), data.data(), 1.0, 1);
+}
+
+void CpuIntegrateRPMDStepKernel::initialize(const System& system, const RPMDIntegrator& integrator) {
+    int numCopies = integrator.getNumCopies();
+    int numParticles = system.getNumParticles();
+    positions.resize(numCopies);
+    velocities.resize(numCopies);
+    forces.resize(numCopies);
+    for (int i = 0; i < numCopies; i++) {
+        positions[i].resize(numParticles);
+        velocities[i].resize(numParticles);
+        forces[i].resize(numParticles);
+    }
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        masses[i] = system.getParticleMass(i);
+    int numThreads = data.threads.getNumThreads();
+    threadQ.resize(numThreads, vector<complex<double> >(numCopies));
+    threadV.resize(numThreads, vector<complex<double> >(numCopies));
+    data.random.initialize(integrator.getRandomNumberSeed(), numThreads);
+    
+    // Build a list of contractions.
+    
+    groupsNotContracted = -1;
+    const map<int, int>& contractions = integrator.getContractions();
+    int maxContractedCopies = 0;
+    for (auto& c : contractions) {
+        int group = c.first;
+        int copies = c.second;
+        if (group < 0 || group > 31)
+            throw OpenMMException("RPMDIntegrator: Force group must be between 0 and 31");
+        if (copies < 0 || copies > numCopies)
+            throw OpenMMException("RPMDIntegrator: Number of copies for contraction cannot be greater than the total number of copies being simulated");
+        if (copies != numCopies) {
+            if (groupsByCopies.find(copies) == groupsByCopies.end()) {
+                groupsByCopies[copies] = 1<<group;
+                if (copies > maxContractedCopies)
+                    maxContractedCopies = copies;
+            }
+            else
+                groupsByCopies[copies] |= 1<<group;
+            groupsNotContracted -= 1<<group;
+        }
+    }
+    groupsNotContracted &= integrator.getIntegrationForceGroups();
+    
+    // Create workspace for doing contractions.
+    
+    contractedPositions.resize(maxContractedCopies);
+    contractedForces.resize(maxContractedCopies);
+    for (int i = 0; i < maxContractedCopies; i++) {
+        contractedPositions[i].resize(numParticles);
+        contractedForces[i].resize(numParticles);
+    }
+}
+
+void CpuIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDIntegrator& integrator, bool forcesAreValid) {
+    const double dt = integrator.getStepSize();
+    
+    // Loop over copies and compute the force on each one.
+    
+    if (!forcesAreValid)
+        computeForces(context, integrator);
+    if (integrator.getApplyThermostat())
+        applyThermostat(integrator);
+    updateVelocities(0.5*dt);
+    evolveFreeRingPolymer(integrator);
+    
+    // Calculate forces based on the updated positions.
+    
+    computeForces(context, integrator);
+    updateVelocities(0.5*dt);
+    if (integrator.getApplyThermostat())
+        applyThermostat(integrator);
+    
+    // Update the time.
+    
+    context.setTime(context.getTime()+dt);
+}
+
+void CpuIntegrateRPMDStepKernel::applyThermostat(const RPMDIntegrator& integrator) {
+    // Apply the PILE-L thermostat.  Each thread handles a block of particles, drawing from its own
+    // random number stream.
+
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    const double halfdt = 0.5*integrator.getStepSize();
+    const double hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
+    const double scale = 1.0/sqrt((double) numCopies);
+    const double nkT = numCopies*BOLTZ*integrator.getTemperature();
+    const double twown = 2.0*nkT/hbar;
+    const double c1_0 = exp(-halfdt*integrator.getFriction());
+    const double c2_0 = sqrt(1.0-c1_0*c1_0);
+    int numThreads = data.threads.getNumThreads();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<complex<double> >& v = threadV[threadIndex];
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int particle = start; particle < end; particle++) {
+            if (masses[particle] == 0.0)
+                continue;
+            const double c3_0 = c2_0*sqrt(nkT/masses[particle]);
+            for (int component = 0; component < 3; component++) {
+                for (int k = 0; k < numCopies; k++)
+                    v[k] = complex<double>(scale*velocities[k][particle][component], 0.0);
+                fft(v, numCopies, true);
+
+                // Apply a local Langevin thermostat to the centroid mode.
+
+                v[0].real(v[0].real()*c1_0 + c3_0*data.random.getGaussianRandom(threadIndex));
+
+                // Use critical damping white noise for the remaining modes.
+
+                for (int k = 1; k <= numCopies/2; k++) {
+                    const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
+                    const double wk = twown*sin(k*M_PI/numCopies);
+                    const double c1 = exp(-2.0*wk*halfdt);
+                    const double c2 = sqrt((1.0-c1*c1)/2) * (isCenter ? sqrt(2.0) : 1.0);
+                    const double c3 = c2*sqrt(nkT/masses[particle]);
+                    double rand1 = c3*data.random.getGaussianRandom(threadIndex);
+                    double rand2 = (isCenter ? 0.0 : c3*data.random.getGaussianRandom(threadIndex));
+                    v[k] = v[k]*c1 + complex<double>(rand1, rand2);
+                    if (k < numCopies-k)
+                        v[numCopies-k] = v[numCopies-k]*c1 + complex<double>(rand1, -rand2);
+                }
+                fft(v, numCopies, false);
+                for (int k = 0; k < numCopies; k++)
+                    velocities[k][particle][component] = scale*v[k].real();
+            }
+        }
+    });
+    data.threads.waitForThreads();
+}
+
+void CpuIntegrateRPMDStepKernel::updateVelocities(double dt) {
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    int numThreads = data.threads.getNumThreads();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int i = 0; i < numCopies; i++)
+            for (int j = start; j < end; j++)
+                if (masses[j] != 0.0)
+                    velocities[i][j] += forces[i][j]*(dt/masses[j]);
+    });
+    data.threads.waitForThreads();
+}
+
+void CpuIntegrateRPMDStepKernel::evolveFreeRingPolymer(const RPMDIntegrator& integrator) {
+    // Evolve the free ring polymer by transforming to the frequency domain.
+
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    const double dt = integrator.getStepSize();
+    const double hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
+    const double scale = 1.0/sqrt((double) numCopies);
+    const double nkT = numCopies*BOLTZ*integrator.getTemperature();
+    const double twown = 2.0*nkT/hbar;
+    int numThreads = data.threads.getNumThreads();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<complex<double> >& q = threadQ[threadIndex];
+        vector<complex<double> >& v = threadV[threadIndex];
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int particle = start; particle < end; particle++) {
+            if (masses[particle] == 0.0)
+                continue;
+            for (int component = 0; component < 3; component++) {
+                for (int k = 0; k < numCopies; k++) {
+                    q[k] = complex<double>(scale*positions[k][particle][component], 0.0);
+                    v[k] = complex<double>(scale*velocities[k][particle][component], 0.0);
+                }
+                fft(q, numCopies, true);
+                fft(v, numCopies, true);
+                q[0] += v[0]*dt;
+                for (int k = 1; k < numCopies; k++) {
+                    const double wk = twown*sin(k*M_PI/numCopies);
+                    const double wt = wk*dt;
+                    const double coswt = cos(wt);
+                    const double sinwt = sin(wt);
+                    const complex<double> vprime = v[k]*coswt - q[k]*(wk*sinwt); // Advance velocity from t to t+dt
+                    q[k] = v[k]*(sinwt/wk) + q[k]*coswt; // Advance position from t to t+dt
+                    v[k] = vprime;
+                }
+                fft(q, numCopies, false);
+                fft(v, numCopies, false);
+                for (int k = 0; k < numCopies; k++) {
+                    positions[k][particle][component] = scale*q[k].real();
+                    velocities[k][particle][component] = scale*v[k].real();
+                }
+            }
+        }
+    });
+    data.threads.waitForThreads();
+}
+
+void CpuIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const RPMDIntegrator& integrator) {
+    const int totalCopies = positions.size();
+    const int numParticles = positions[0].size();
+    vector<Vec3>& pos = extractPositions(context);
+    vector<Vec3>& vel = extractVelocities(context);
+    vector<Vec3>& f = extractForces(context);
+    
+    // Compute forces from all groups that didn't have a specified contraction.  The copies are
+    // evaluated in turn, since the force kernels of the Context already use all the threads.
+    
+    for (int i = 0; i < totalCopies; i++) {
+        pos = positions[i];
+        vel = velocities[i];
+        context.computeVirtualSites();
+        Vec3 initialBox[3];
+        context.getPeriodicBoxVectors(initialBox[0], initialBox[1], initialBox[2]);
+        context.updateContextState();
+        Vec3 finalBox[3];
+        context.getPeriodicBoxVectors(finalBox[0], finalBox[1], finalBox[2]);
+        if (initialBox[0] != finalBox[0] || initialBox[1] != finalBox[1] || initialBox[2] != finalBox[2])
+            throw OpenMMException("Standard barostats cannot be used with RPMDIntegrator.  Use RPMDMonteCarloBarostat instead.");
+        positions[i] = pos;
+        velocities[i] = vel;
+        context.calcForcesAndEnergy(true, false, groupsNotContracted);
+        forces[i] = f;
+    }
+    
+    // Now loop over contractions and compute forces from them.
+    
+    int numThreads = data.threads.getNumThreads();
+    for (auto& g : groupsByCopies) {
+        int copies = g.first;
+        int groupFlags = g.second;
+        
+        // Find the contracted positions.  Each thread transforms a block of particles: to the frequency
+        // domain, set high frequency components to zero, and back.
+        
+        const double scale1 = 1.0/totalCopies;
+        data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            vector<complex<double> >& q = threadQ[threadIndex];
+            int firstParticle = (threadIndex*numParticles)/numThreads;
+            int lastParticle = ((threadIndex+1)*numParticles)/numThreads;
+            for (int particle = firstParticle; particle < lastParticle; particle++) {
+                for (int component = 0; component < 3; component++) {
+                    for (int k = 0; k < totalCopies; k++)
+                        q[k] = complex<double>(positions[k][particle][component], 0.0);
+                    fft(q, totalCopies, true);
+                    if (copies > 1) {
+                        int start = (copies+1)/2;
+                        int end = totalCopies-copies+start;
+                        for (int k = end; k < totalCopies; k++)
+                            q[k-(totalCopies-copies)] = q[k];
+                        fft(q, copies, false);
+                    }
+                    for (int k = 0; k < copies; k++)
+                        contractedPositions[k][particle][component] = scale1*q[k].real();
+                }
+            }
+        });
+        data.threads.waitForThreads();
+        
+        // Compute forces.
+
+        for (int i = 0; i < copies; i++) {
+            pos = contractedPositions[i];
+            context.computeVirtualSites();
+            context.calcForcesAndEnergy(true, false, groupFlags);
+            contractedForces[i] = f;
+        }
+        
+        // Apply the forces to the original copies.  Transform to the frequency domain, pad with zeros,
+        // and transform back.
+        
+        const double scale2 = 1.0/copies;
+        data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            vector<complex<double> >& q = threadQ[threadIndex];
+            int firstParticle = (threadIndex*numParticles)/numThreads;
+            int lastParticle = ((threadIndex+1)*numParticles)/numThreads;
+            for (int particle = firstParticle; particle < lastParticle; particle++) {
+                for (int component = 0; component < 3; component++) {
+                    for (int k = 0; k < copies; k++)
+                        q[k] = complex<double>(contractedForces[k][particle][component], 0.0);
+                    if (copies > 1)
+                        fft(q, copies, true);
+                    int start = (copies+1)/2;
+                    int end = totalCopies-copies+start;
+                    for (int k = end; k < totalCopies; k++)
+                        q[k] = q[k-(totalCopies-copies)];
+                    for (int k = start; k < end; k++)
+                        q[k] = complex<double>(0, 0);
+                    fft(q, totalCopies, false);
+                    for (int k = 0; k < totalCopies; k++)
+                        forces[k][particle][component] += scale2*q[k].real();
+                }
+            }
+        });
+        data.threads.waitForThreads();
+    }
+}
+
+double CpuIntegrateRPMDStepKernel::computeKineticEnergy(ContextImpl& context, const RPMDIntegrator& integrator) {
+    int numParticles = masses.size();
+    vector<Vec3>& velData = extractVelocities(context);
+    double energy = 0.0;
+    for (int i = 0; i < numParticles; ++i) {
+        if (masses[i] > 0) {
+            Vec3 v = velData[i];
+            energy += masses[i]*(v.dot(v));
+        }
+    }
+    return 0.5*energy;
+}
+
+void CpuIntegrateRPMDStepKernel::setPositions(int copy, const vector<Vec3>& pos) {
+    int numParticles = positions[copy].size();
+    for (int i = 0; i < numParticles; i++)
+        positions[copy][i] = pos[i];
+}
+
+void CpuIntegrateRPMDStepKernel::setVelocities(int copy, const vector<Vec3>& vel) {
+    int numParticles = velocities[copy].size();
+    for (int i = 0; i < numParticles; i++)
+        velocities[copy][i] = vel[i];
+}
+
+void CpuIntegrateRPMDStepKernel::copyToContext(int copy, ContextImpl& context) {
+    extractPositions(context) = positions[copy];
+    extractVelocities(context) = velocities[copy];
+}
@@ -0,0 +1,109 @@
+#ifndef CPU_RPMD_KERNELS_H_
+#define CPU_RPMD_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuPlatform.h"
+#include "openmm/RpmdKernels.h"
+#include "openmm/Vec3.h"
+#include <complex>
+#include <map>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This kernel is invoked by RPMDIntegrator to take one time step, and to get and
+ * set the state of system copies.  The copies are evaluated one at a time, each using
+ * all the threads of the CPU platform for its forces.  The normal mode transformations,
+ * the thermostat, and the contractions are divided between threads by particle.
+ */
+class CpuIntegrateRPMDStepKernel : public IntegrateRPMDStepKernel {
+public:
+    CpuIntegrateRPMDStepKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) :
+            IntegrateRPMDStepKernel(name, platform), data(data) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param integrator the RPMDIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const RPMDIntegrator& integrator);
+    /**
+     * Execute the kernel.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the RPMDIntegrator this kernel is being used for
+     * @param forcesAreValid if the context has been modified since the last time step, this will be
+     *                       false to show that cached forces are invalid and must be recalculated
+     */
+    void execute(ContextImpl& context, const RPMDIntegrator& integrator, bool forcesAreValid);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator     the RPMDIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const RPMDIntegrator& integrator);
+    /**
+     * Set the positions of all particles in one copy of the system.
+     */
+    void setPositions(int copy, const std::vector<Vec3>& positions);
+    /**
+     * Set the velocities of all particles in one copy of the system.
+     */
+    void setVelocities(int copy, const std::vector<Vec3>& velocities);
+    /**
+     * Copy positions and velocities for one copy into the context.
+     */
+    void copyToContext(int copy, ContextImpl& context);
+private:
+    void computeForces(ContextImpl& context, const RPMDIntegrator& integrator);
+    void applyThermostat(const RPMDIntegrator& integrator);
+    void updateVelocities(double dt);
+    void evolveFreeRingPolymer(const RPMDIntegrator& integrator);
+    CpuPlatform::PlatformData& data;
+    std::vector<std::vector<Vec3> > positions;
+    std::vector<std::vector<Vec3> > velocities;
+    std::vector<std::vector<Vec3> > forces;
+    std::vector<std::vector<Vec3> > contractedPositions;
+    std::vector<std::vector<Vec3> > contractedForces;
+    std::vector<double> masses;
+    std::vector<std::vector<std::complex<double> > > threadQ, threadV;
+    std::map<int, int> groupsByCopies;
+    int groupsNotContracted;
+};
+
+} // namespace OpenMM
+
+#endif /*CPU_RPMD_KERNELS_H_*/
@@ -35,18 +35,28 @@ using namespace OpenMM;
 extern "C" OPENMM_EXPORT void registerPlatforms() {
 }
 
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
+static void registerRpmdReferenceKernels() {
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
-            ReferenceRpmdKernelFactory* factory = new ReferenceRpmdKernelFactory();
-            platform.registerKernelFactory(IntegrateRPMDStepKernel::Name(), factory);
+            // Platforms derived from ReferencePlatform (such as CPU) may provide an optimized
+            // version of the kernel through their own plugins.  Only register it if it is
+            // still missing, so plugin load order does not matter.
+
+            if (!platform.supportsKernels({IntegrateRPMDStepKernel::Name()})) {
+                ReferenceRpmdKernelFactory* factory = new ReferenceRpmdKernelFactory();
+                platform.registerKernelFactory(IntegrateRPMDStepKernel::Name(), factory);
+            }
         }
     }
 }
 
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+    registerRpmdReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerRpmdReferenceKernelFactories() {
-    registerKernelFactories();
+    registerRpmdReferenceKernels();
 }
 
 KernelImpl* ReferenceRpmdKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
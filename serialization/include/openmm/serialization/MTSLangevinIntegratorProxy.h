@@ -0,0 +1,17 @@
+#ifndef OPENMM_MTS_LANGEVIN_INTEGRATOR_PROXY_H_
+#define OPENMM_MTS_LANGEVIN_INTEGRATOR_PROXY_H_
+
+#include "openmm/serialization/XmlSerializer.h"
+
+namespace OpenMM {
+
+class MTSLangevinIntegratorProxy : public SerializationProxy {
+public:
+    MTSLangevinIntegratorProxy();
+    void serialize(const void* object, SerializationNode& node) const;
+    void* deserialize(const SerializationNode& node) const;
+};
+
+}
+
+#endif /*OPENMM_MTS_LANGEVIN_INTEGRATOR_PROXY_H_*/
\ No newline at end of file
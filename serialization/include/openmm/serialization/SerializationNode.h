@@ -62,6 +62,11 @@ namespace OpenMM {
  * property as a string.  Similarly, you can use setStringProperty() to specify a property and then access it
  * using getIntProperty().  This will produce the expected result if the original value was, in fact, the
  * string representation of an int, but if the original string was non-numeric, the result is undefined.
+ *
+ * A node can also store arrays of ints or doubles.  These are intended for large amounts of per-particle
+ * or per-interaction data.  They are kept in their native form rather than being converted to strings,
+ * and each serializer writes them out in whatever compact form is appropriate for its format.  Arrays
+ * are stored separately from properties, so hasProperty() and getProperties() do not include them.
  */
 
 class OPENMM_EXPORT SerializationNode {
@@ -218,6 +223,62 @@ public:
      * @param value  the value to set for the property
      */
     SerializationNode& setDoubleProperty(const std::string& name, double value);
+    /**
+     * Determine whether this node has an array (of either type) with a particular name.
+     *
+     * @param name  the name of the array to check for
+     */
+    bool hasArray(const std::string& name) const;
+    /**
+     * Get a map containing all of this node's int arrays.
+     */
+    const std::map<std::string, std::vector<int> >& getIntArrays() const;
+    /**
+     * Get an int array with a particular name.  If there is no int array with the specified name,
+     * an exception is thrown.
+     *
+     * @param name   the name of the array to get
+     */
+    const std::vector<int>& getIntArray(const std::string& name) const;
+    /**
+     * Set the value of an int array.
+     *
+     * @param name    the name of the array to set
+     * @param values  the values to store in the array
+     */
+    SerializationNode& setIntArray(const std::string& name, const std::vector<int>& values);
+    /**
+     * Set the value of an int array, taking ownership of the values instead of copying them.
+     *
+     * @param name    the name of the array to set
+     * @param values  the values to store in the array
+     */
+    SerializationNode& setIntArray(const std::string& name, std::vector<int>&& values);
+    /**
+     * Get a map containing all of this node's double arrays.
+     */
+    const std::map<std::string, std::vector<double> >& getDoubleArrays() const;
+    /**
+     * Get a double array with a particular name.  If there is no double array with the specified name,
+     * an exception is thrown.
+     *
+     * @param name   the name of the array to get
+     */
+    const std::vector<double>& getDoubleArray(const std::string& name) const;
+    /**
+     * Set the value of a double array.
+     *
+     * @param name    the name of the array to set
+     * @param values  the values to store in the array
+     */
+    SerializationNode& setDoubleArray(const std::string& name, const std::vector<double>& values);
+    /**
+     * Set the value of a double array, taking ownership of the values instead of copying them.
+     *
+     * @param name    the name of the array to set
+     * @param values  the values to store in the array
+     */
+    SerializationNode& setDoubleArray(const std::string& name, std::vector<double>&& values);
     /**
      * Create a new child node
      *
@@ -266,6 +327,8 @@ private:
     std::string name;
     std::vector<SerializationNode> children;
     std::map<std::string, std::string> properties;
+    std::map<std::string, std::vector<int> > intArrays;
+    std::map<std::string, std::vector<double> > doubleArrays;
 };
 
 } // namespace OpenMM
@@ -0,0 +1,232 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/serialization/BinarySerializer.h"
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <map>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Every binary file starts with this sequence of bytes, followed by the format version.
+ */
+static const char binaryMagic[8] = {'O', 'M', 'M', 'B', 'I', 'N', '\r', '\n'};
+static const unsigned int binaryVersion = 2;
+
+/**
+ * This class writes the contents of SerializationNodes to a stream.  Integers are written as
+ * variable length unsigned values (7 bits per byte, least significant first).  Names are written
+ * in full the first time they appear, and as a reference to that first occurrence after that.
+ * Arrays are written as their raw in-memory bytes, which are little endian on every platform
+ * OpenMM supports.
+ */
+class BinarySerializer::Writer {
+public:
+    Writer(ostream& stream) : stream(stream) {
+    }
+    void writeInt(unsigned long long value) {
+        char bytes[10];
+        int numBytes = 0;
+        while (value >= 0x80) {
+            bytes[numBytes++] = (char) ((value&0x7F) | 0x80);
+            value >>= 7;
+        }
+        bytes[numBytes++] = (char) value;
+        stream.write(bytes, numBytes);
+    }
+    void writeString(const string& str) {
+        writeInt(str.size());
+        stream.write(str.c_str(), str.size());
+    }
+    void writeName(const string& name) {
+        auto iter = names.find(name);
+        if (iter == names.end()) {
+            // A zero marks a new name that is written out in full.
+
+            writeInt(0);
+            writeString(name);
+            int index = names.size();
+            names[name] = index;
+        }
+        else
+            writeInt(iter->second+1);
+    }
+    void writeNode(const SerializationNode& node) {
+        writeName(node.getName());
+        const map<string, string>& properties = node.getProperties();
+        writeInt(properties.size());
+        for (auto& prop : properties) {
+            writeName(prop.first);
+            writeString(prop.second);
+        }
+        const map<string, vector<int> >& intArrays = node.getIntArrays();
+        writeInt(intArrays.size());
+        for (auto& array : intArrays) {
+            writeName(array.first);
+            writeInt(array.second.size());
+            stream.write((const char*) array.second.data(), array.second.size()*sizeof(int));
+        }
+        const map<string, vector<double> >& doubleArrays = node.getDoubleArrays();
+        writeInt(doubleArrays.size());
+        for (auto& array : doubleArrays) {
+            writeName(array.first);
+            writeInt(array.second.size());
+            stream.write((const char*) array.second.data(), array.second.size()*sizeof(double));
+        }
+        const vector<SerializationNode>& children = node.getChildren();
+        writeInt(children.size());
+        for (auto& child : children)
+            writeNode(child);
+    }
+private:
+    ostream& stream;
+    map<string, int> names;
+};
+
+/**
+ * This class reconstructs SerializationNodes from data that has been loaded into memory.
+ */
+class BinarySerializer::Reader {
+public:
+    Reader(const char* data, size_t size) : data(data), end(data+size), version(binaryVersion) {
+    }
+    void setVersion(int version) {
+        this->version = version;
+    }
+    unsigned long long readInt() {
+        unsigned long long value = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (data == end)
+                throw OpenMMException("BinarySerializer: unexpected end of input");
+            if (shift > 63)
+                throw OpenMMException("BinarySerializer: invalid integer in input");
+            unsigned char byte = (unsigned char) *data++;
+            value |= ((unsigned long long) (byte&0x7F)) << shift;
+            if ((byte&0x80) == 0)
+                return value;
+        }
+    }
+    const char* readBytes(size_t length) {
+        if (length > (size_t) (end-data))
+            throw OpenMMException("BinarySerializer: unexpected end of input");
+        const char* start = data;
+        data += length;
+        return start;
+    }
+    string readString() {
+        size_t length = readInt();
+        const char* start = readBytes(length);
+        return string(start, length);
+    }
+    const string& readName() {
+        unsigned long long index = readInt();
+        if (index == 0) {
+            names.push_back(readString());
+            return names.back();
+        }
+        if (index > names.size())
+            throw OpenMMException("BinarySerializer: invalid name reference in input");
+        return names[index-1];
+    }
+    template <class T>
+    vector<T> readArray() {
+        size_t length = readInt();
+        if (length > (size_t) (end-data)/sizeof(T))
+            throw OpenMMException("BinarySerializer: unexpected end of input");
+        vector<T> array(length);
+        memcpy(array.data(), readBytes(length*sizeof(T)), length*sizeof(T));
+        return array;
+    }
+    void readNode(SerializationNode& node) {
+        node.setName(readName());
+        unsigned long long numProperties = readInt();
+        for (unsigned long long i = 0; i < numProperties; i++) {
+            const string& name = readName();
+            node.setStringProperty(name, readString());
+        }
+        if (version > 1) {
+            unsigned long long numIntArrays = readInt();
+            for (unsigned long long i = 0; i < numIntArrays; i++) {
+                const string& name = readName();
+                node.setIntArray(name, readArray<int>());
+            }
+            unsigned long long numDoubleArrays = readInt();
+            for (unsigned long long i = 0; i < numDoubleArrays; i++) {
+                const string& name = readName();
+                node.setDoubleArray(name, readArray<double>());
+            }
+        }
+        unsigned long long numChildren = readInt();
+        if (numChildren > (unsigned long long) (end-data))
+            throw OpenMMException("BinarySerializer: unexpected end of input");
+        vector<SerializationNode>& children = node.getChildren();
+        children.resize(numChildren);
+        for (auto& child : children)
+            readNode(child);
+    }
+private:
+    const char* data;
+    const char* end;
+    int version;
+    vector<string> names;
+};
+
+void BinarySerializer::serialize(const SerializationNode& node, std::ostream& stream) {
+    Writer writer(stream);
+    stream.write(binaryMagic, sizeof(binaryMagic));
+    writer.writeInt(binaryVersion);
+    writer.writeNode(node);
+    if (!stream)
+        throw OpenMMException("BinarySerializer: error writing to stream");
+}
+
+void* BinarySerializer::deserializeStream(std::istream& stream) {
+    // Load the whole input into memory so the nodes can be decoded without going back to the stream.
+
+    vector<char> buffer((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(binaryMagic) || memcmp(buffer.data(), binaryMagic, sizeof(binaryMagic)) != 0)
+        throw OpenMMException("BinarySerializer: input is not in OpenMM binary serialization format");
+    Reader reader(buffer.data()+sizeof(binaryMagic), buffer.size()-sizeof(binaryMagic));
+    unsigned long long version = reader.readInt();
+    if (version < 1 || version > binaryVersion)
+        throw OpenMMException("BinarySerializer: unsupported format version");
+    reader.setVersion(version);
+    SerializationNode root;
+    reader.readNode(root);
+
+    // Process the SerializationNodes.
+
+    const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
+    return proxy.deserialize(root);
+}
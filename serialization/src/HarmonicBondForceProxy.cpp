@@ -34,6 +34,7 @@
 #include "openmm/Force.h"
 #include "openmm/HarmonicBondForce.h"
 #include <sstream>
+#include <utility>
 
 using namespace OpenMM;
 using namespace std;
@@ -42,23 +43,24 @@ HarmonicBondForceProxy::HarmonicBondForceProxy() : SerializationProxy("HarmonicB
 }
 
 void HarmonicBondForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 2);
+    node.setIntProperty("version", 3);
     const HarmonicBondForce& force = *reinterpret_cast<const HarmonicBondForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
     node.setBoolProperty("usesPeriodic", force.usesPeriodicBoundaryConditions());
+    int numBonds = force.getNumBonds();
+    vector<int> particle1(numBonds), particle2(numBonds);
+    vector<double> distance(numBonds), k(numBonds);
+    for (int i = 0; i < numBonds; i++)
+        force.getBondParameters(i, particle1[i], particle2[i], distance[i], k[i]);
     SerializationNode& bonds = node.createChildNode("Bonds");
-    for (int i = 0; i < force.getNumBonds(); i++) {
-        int particle1, particle2;
-        double distance, k;
-        force.getBondParameters(i, particle1, particle2, distance, k);
-        bonds.createChildNode("Bond").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("d", distance).setDoubleProperty("k", k);
-    }
+    bonds.setIntArray("p1", std::move(particle1)).setIntArray("p2", std::move(particle2));
+    bonds.setDoubleArray("d", std::move(distance)).setDoubleArray("k", std::move(k));
 }
 
 void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 1 || version > 2)
+    if (version < 1 || version > 3)
         throw OpenMMException("Unsupported version number");
     HarmonicBondForce* force = new HarmonicBondForce();
     try {
@@ -67,8 +69,20 @@ void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
         if (version > 1)
             force->setUsesPeriodicBoundaryConditions(node.getBoolProperty("usesPeriodic"));
         const SerializationNode& bonds = node.getChildNode("Bonds");
-        for (auto& bond : bonds.getChildren())
-            force->addBond(bond.getIntProperty("p1"), bond.getIntProperty("p2"), bond.getDoubleProperty("d"), bond.getDoubleProperty("k"));
+        if (version > 2) {
+            const vector<int>& particle1 = bonds.getIntArray("p1");
+            const vector<int>& particle2 = bonds.getIntArray("p2");
+            const vector<double>& distance = bonds.getDoubleArray("d");
+            const vector<double>& k = bonds.getDoubleArray("k");
+            int numBonds = particle1.size();
+            if (particle2.size() != particle1.size() || distance.size() != particle1.size() || k.size() != particle1.size())
+                throw OpenMMException("HarmonicBondForceProxy: bond arrays have different lengths");
+            for (int i = 0; i < numBonds; i++)
+                force->addBond(particle1[i], particle2[i], distance[i], k[i]);
+        }
+        else
+            for (auto& bond : bonds.getChildren())
+                force->addBond(bond.getIntProperty("p1"), bond.getIntProperty("p2"), bond.getDoubleProperty("d"), bond.getDoubleProperty("k"));
     }
     catch (...) {
         delete force;
@@ -34,6 +34,7 @@
 #include "openmm/Force.h"
 #include "openmm/NonbondedForce.h"
 #include <sstream>
+#include <utility>
 
 using namespace OpenMM;
 using namespace std;
@@ -42,7 +43,7 @@ NonbondedForceProxy::NonbondedForceProxy() : SerializationProxy("NonbondedForce"
 }
 
 void NonbondedForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 4);
+    node.setIntProperty("version", 5);
     const NonbondedForce& force = *reinterpret_cast<const NonbondedForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
@@ -67,6 +68,7 @@ void NonbondedForceProxy::serialize(const void* object, SerializationNode& node)
     node.setIntProperty("ljnx", nx);
     node.setIntProperty("ljny", ny);
     node.setIntProperty("ljnz", nz);
+    node.setIntProperty("pmeOrder", force.getPMEOrder());
     node.setIntProperty("recipForceGroup", force.getReciprocalSpaceForceGroup());
     SerializationNode& globalParams = node.createChildNode("GlobalParameters");
     for (int i = 0; i < force.getNumGlobalParameters(); i++)
@@ -87,24 +89,25 @@ void NonbondedForceProxy::serialize(const void* object, SerializationNode& node)
         force.getExceptionParameterOffset(i, parameter, exception, chargeProdScale, sigmaScale, epsilonScale);
         exceptionOffsets.createChildNode("Offset").setStringProperty("parameter", parameter).setIntProperty("exception", exception).setDoubleProperty("q", chargeProdScale).setDoubleProperty("sig", sigmaScale).setDoubleProperty("eps", epsilonScale);
     }
+    int numParticles = force.getNumParticles();
+    vector<double> charge(numParticles), sigma(numParticles), epsilon(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        force.getParticleParameters(i, charge[i], sigma[i], epsilon[i]);
     SerializationNode& particles = node.createChildNode("Particles");
-    for (int i = 0; i < force.getNumParticles(); i++) {
-        double charge, sigma, epsilon;
-        force.getParticleParameters(i, charge, sigma, epsilon);
-        particles.createChildNode("Particle").setDoubleProperty("q", charge).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
-    }
+    particles.setDoubleArray("q", std::move(charge)).setDoubleArray("sig", std::move(sigma)).setDoubleArray("eps", std::move(epsilon));
+    int numExceptions = force.getNumExceptions();
+    vector<int> particle1(numExceptions), particle2(numExceptions);
+    vector<double> chargeProd(numExceptions), exceptionSigma(numExceptions), exceptionEpsilon(numExceptions);
+    for (int i = 0; i < numExceptions; i++)
+        force.getExceptionParameters(i, particle1[i], particle2[i], chargeProd[i], exceptionSigma[i], exceptionEpsilon[i]);
     SerializationNode& exceptions = node.createChildNode("Exceptions");
-    for (int i = 0; i < force.getNumExceptions(); i++) {
-        int particle1, particle2;
-        double chargeProd, sigma, epsilon;
-        force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exceptions.createChildNode("Exception").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("q", chargeProd).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
-    }
+    exceptions.setIntArray("p1", std::move(particle1)).setIntArray("p2", std::move(particle2));
+    exceptions.setDoubleArray("q", std::move(chargeProd)).setDoubleArray("sig", std::move(exceptionSigma)).setDoubleArray("eps", std::move(exceptionEpsilon));
 }
 
 void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 1 || version > 4)
+    if (version < 1 || version > 5)
         throw OpenMMException("Unsupported version number");
     NonbondedForce* force = new NonbondedForce();
     try {
@@ -131,6 +134,7 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
             nz = node.getIntProperty("ljnz", 0);
             force->setLJPMEParameters(alpha, nx, ny, nz);
         }
+        force->setPMEOrder(node.getIntProperty("pmeOrder", 5));
         force->setReciprocalSpaceForceGroup(node.getIntProperty("recipForceGroup", -1));
         if (version >= 3) {
             const SerializationNode& globalParams = node.getChildNode("GlobalParameters");
@@ -146,11 +150,31 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
         if (version >= 4)
             force->setExceptionsUsePeriodicBoundaryConditions(node.getIntProperty("exceptionsUsePeriodic"));
         const SerializationNode& particles = node.getChildNode("Particles");
-        for (auto& particle : particles.getChildren())
-            force->addParticle(particle.getDoubleProperty("q"), particle.getDoubleProperty("sig"), particle.getDoubleProperty("eps"));
         const SerializationNode& exceptions = node.getChildNode("Exceptions");
-        for (auto& exception : exceptions.getChildren())
-            force->addException(exception.getIntProperty("p1"), exception.getIntProperty("p2"), exception.getDoubleProperty("q"), exception.getDoubleProperty("sig"), exception.getDoubleProperty("eps"));
+        if (version >= 5) {
+            const vector<double>& charge = particles.getDoubleArray("q");
+            const vector<double>& sigma = particles.getDoubleArray("sig");
+            const vector<double>& epsilon = particles.getDoubleArray("eps");
+            if (sigma.size() != charge.size() || epsilon.size() != charge.size())
+                throw OpenMMException("NonbondedForceProxy: particle arrays have different lengths");
+            for (int i = 0; i < (int) charge.size(); i++)
+                force->addParticle(charge[i], sigma[i], epsilon[i]);
+            const vector<int>& particle1 = exceptions.getIntArray("p1");
+            const vector<int>& particle2 = exceptions.getIntArray("p2");
+            const vector<double>& chargeProd = exceptions.getDoubleArray("q");
+            const vector<double>& exceptionSigma = exceptions.getDoubleArray("sig");
+            const vector<double>& exceptionEpsilon = exceptions.getDoubleArray("eps");
+            if (particle2.size() != particle1.size() || chargeProd.size() != particle1.size() || exceptionSigma.size() != particle1.size() || exceptionEpsilon.size() != particle1.size())
+                throw OpenMMException("NonbondedForceProxy: exception arrays have different lengths");
+            for (int i = 0; i < (int) particle1.size(); i++)
+                force->addException(particle1[i], particle2[i], chargeProd[i], exceptionSigma[i], exceptionEpsilon[i]);
+        }
+        else {
+            for (auto& particle : particles.getChildren())
+                force->addParticle(particle.getDoubleProperty("q"), particle.getDoubleProperty("sig"), particle.getDoubleProperty("eps"));
+            for (auto& exception : exceptions.getChildren())
+                force->addException(exception.getIntProperty("p1"), exception.getIntProperty("p2"), exception.getDoubleProperty("q"), exception.getDoubleProperty("sig"), exception.getDoubleProperty("eps"));
+        }
     }
     catch (...) {
         delete force;
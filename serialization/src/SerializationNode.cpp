@@ -32,6 +32,7 @@
 #include "openmm/serialization/SerializationNode.h"
 #include "openmm/OpenMMException.h"
 #include <sstream>
+#include <utility>
 
 using namespace OpenMM;
 using namespace std;
@@ -192,6 +193,52 @@ SerializationNode& SerializationNode::setDoubleProperty(const string& name, doub
     return *this;
 }
 
+bool SerializationNode::hasArray(const string& name) const {
+    return (intArrays.find(name) != intArrays.end() || doubleArrays.find(name) != doubleArrays.end());
+}
+
+const map<string, vector<int> >& SerializationNode::getIntArrays() const {
+    return intArrays;
+}
+
+const vector<int>& SerializationNode::getIntArray(const string& name) const {
+    map<string, vector<int> >::const_iterator iter = intArrays.find(name);
+    if (iter == intArrays.end())
+        throw OpenMMException("Unknown int array '"+name+"' in node '"+getName()+"'");
+    return iter->second;
+}
+
+SerializationNode& SerializationNode::setIntArray(const string& name, const vector<int>& values) {
+    intArrays[name] = values;
+    return *this;
+}
+
+SerializationNode& SerializationNode::setIntArray(const string& name, vector<int>&& values) {
+    intArrays[name] = std::move(values);
+    return *this;
+}
+
+const map<string, vector<double> >& SerializationNode::getDoubleArrays() const {
+    return doubleArrays;
+}
+
+const vector<double>& SerializationNode::getDoubleArray(const string& name) const {
+    map<string, vector<double> >::const_iterator iter = doubleArrays.find(name);
+    if (iter == doubleArrays.end())
+        throw OpenMMException("Unknown double array '"+name+"' in node '"+getName()+"'");
+    return iter->second;
+}
+
+SerializationNode& SerializationNode::setDoubleArray(const string& name, const vector<double>& values) {
+    doubleArrays[name] = values;
+    return *this;
+}
+
+SerializationNode& SerializationNode::setDoubleArray(const string& name, vector<double>&& values) {
+    doubleArrays[name] = std::move(values);
+    return *this;
+}
+
 SerializationNode& SerializationNode::createChildNode(const std::string& name) {
     children.push_back(SerializationNode());
     children.back().setName(name);
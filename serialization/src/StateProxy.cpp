@@ -34,6 +34,7 @@
 #include "openmm/State.h"
 #include "openmm/Vec3.h"
 #include <map>
+#include <utility>
 
 using namespace std;
 using namespace OpenMM;
@@ -42,8 +43,43 @@ StateProxy::StateProxy() : SerializationProxy("State") {
 
 }
 
+/**
+ * Store a per-particle array of vectors into a node as three arrays of components.
+ */
+static void serializeVectors(const vector<Vec3>& vectors, SerializationNode& node) {
+    int numVectors = vectors.size();
+    vector<double> x(numVectors), y(numVectors), z(numVectors);
+    for (int i = 0; i < numVectors; i++) {
+        x[i] = vectors[i][0];
+        y[i] = vectors[i][1];
+        z[i] = vectors[i][2];
+    }
+    node.setDoubleArray("x", std::move(x)).setDoubleArray("y", std::move(y)).setDoubleArray("z", std::move(z));
+}
+
+/**
+ * Reconstruct a per-particle array of vectors.  Version 1 stored each vector in its own child node.
+ */
+static vector<Vec3> deserializeVectors(const SerializationNode& node, int version) {
+    vector<Vec3> vectors;
+    if (version > 1) {
+        const vector<double>& x = node.getDoubleArray("x");
+        const vector<double>& y = node.getDoubleArray("y");
+        const vector<double>& z = node.getDoubleArray("z");
+        if (y.size() != x.size() || z.size() != x.size())
+            throw OpenMMException("StateProxy: vector component arrays have different lengths");
+        vectors.resize(x.size());
+        for (int i = 0; i < (int) x.size(); i++)
+            vectors[i] = Vec3(x[i], y[i], z[i]);
+    }
+    else
+        for (auto& particle : node.getChildren())
+            vectors.push_back(Vec3(particle.getDoubleProperty("x"),particle.getDoubleProperty("y"),particle.getDoubleProperty("z")));
+    return vectors;
+}
+
 void StateProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 1);
+    node.setIntProperty("version", 2);
     node.setStringProperty("openmmVersion", Platform::getOpenMMVersion());
     const State& s = *reinterpret_cast<const State*>(object);
     node.setDoubleProperty("time", s.getTime());
@@ -68,27 +104,15 @@ void StateProxy::serialize(const void* object, SerializationNode& node) const {
     }
     if ((s.getDataTypes()&State::Positions) != 0) {
         s.getPositions();
-        SerializationNode& positionsNode = node.createChildNode("Positions");
-        vector<Vec3> statePositions = s.getPositions();
-        for (int i=0; i<statePositions.size();i++) {
-           positionsNode.createChildNode("Position").setDoubleProperty("x", statePositions[i][0]).setDoubleProperty("y", statePositions[i][1]).setDoubleProperty("z", statePositions[i][2]);
-        }
+        serializeVectors(s.getPositions(), node.createChildNode("Positions"));
     }
     if ((s.getDataTypes()&State::Velocities) != 0) {
         s.getVelocities();
-        SerializationNode& velocitiesNode = node.createChildNode("Velocities");
-        vector<Vec3> stateVelocities = s.getVelocities();
-        for (int i=0; i<stateVelocities.size();i++) {
-           velocitiesNode.createChildNode("Velocity").setDoubleProperty("x", stateVelocities[i][0]).setDoubleProperty("y", stateVelocities[i][1]).setDoubleProperty("z", stateVelocities[i][2]);
-        }
+        serializeVectors(s.getVelocities(), node.createChildNode("Velocities"));
     }
     if ((s.getDataTypes()&State::Forces) != 0) {
         s.getForces();
-        SerializationNode& forcesNode = node.createChildNode("Forces");
-        vector<Vec3> stateForces = s.getForces();
-        for (int i=0; i<stateForces.size();i++) {
-            forcesNode.createChildNode("Force").setDoubleProperty("x", stateForces[i][0]).setDoubleProperty("y", stateForces[i][1]).setDoubleProperty("z", stateForces[i][2]);
-        }
+        serializeVectors(s.getForces(), node.createChildNode("Forces"));
     }
     if ((s.getDataTypes()&State::IntegratorParameters) != 0) {
         node.getChildren().push_back(s.getIntegratorParameters());
@@ -96,7 +120,8 @@ void StateProxy::serialize(const void* object, SerializationNode& node) const {
 }
 
 void* StateProxy::deserialize(const SerializationNode& node) const {
-    if (node.getIntProperty("version") != 1)
+    int version = node.getIntProperty("version");
+    if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
     double outTime = node.getDoubleProperty("time");
     long long outStepCount = node.getLongProperty("stepCount", 0);
@@ -123,23 +148,17 @@ void* StateProxy::deserialize(const SerializationNode& node) const {
             builder.setEnergy(kineticEnergy, potentialEnergy);
         }
         else if (child.getName() == "Positions") {
-            vector<Vec3> outPositions;
-            for (auto& particle : child.getChildren())
-                outPositions.push_back(Vec3(particle.getDoubleProperty("x"),particle.getDoubleProperty("y"),particle.getDoubleProperty("z")));
+            vector<Vec3> outPositions = deserializeVectors(child, version);
             builder.setPositions(outPositions);
             arraySizes.push_back(outPositions.size());
         }
         else if (child.getName() == "Velocities") {
-            vector<Vec3> outVelocities;
-            for (auto& particle : child.getChildren())
-                outVelocities.push_back(Vec3(particle.getDoubleProperty("x"),particle.getDoubleProperty("y"),particle.getDoubleProperty("z")));
+            vector<Vec3> outVelocities = deserializeVectors(child, version);
             builder.setVelocities(outVelocities);
             arraySizes.push_back(outVelocities.size());
         }
         else if (child.getName() == "Forces") {
-            vector<Vec3> outForces;
-            for (auto& particle : child.getChildren())
-                outForces.push_back(Vec3(particle.getDoubleProperty("x"),particle.getDoubleProperty("y"),particle.getDoubleProperty("z")));
+            vector<Vec3> outForces = deserializeVectors(child, version);
             builder.setForces(outForces);
             arraySizes.push_back(outForces.size());
         }
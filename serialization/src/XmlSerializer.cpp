@@ -30,15 +30,21 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/serialization/XmlSerializer.h"
-#include "irrXML.h"
+#include "openmm/internal/ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <utility>
 
 using namespace OpenMM;
 using namespace std;
-using namespace irr;
-using namespace io;
+
+extern "C" char* g_fmt(char*, double);
+extern "C" double strtod2(const char* s00, char** se);
 
 /**
  * Apply XML encoding to a string.  This is adapted from TinyXML (written by Lee Thomason).
@@ -106,6 +112,204 @@ static void encodeString(const string& str, string* outString) {
     }
 }
 
+/**
+ * Arrays with at least this many values are formatted or parsed on multiple threads.
+ */
+static const int minValuesForThreads = 1<<15;
+
+/**
+ * Append the text representation of an int to a string.
+ */
+static void appendValue(string& text, int value) {
+    char buffer[16];
+    char* end = buffer+sizeof(buffer);
+    char* start = end;
+    unsigned int magnitude = (value < 0 ? 0u-(unsigned int) value : (unsigned int) value);
+    do {
+        *--start = (char) ('0'+magnitude%10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+        *--start = '-';
+    text.append(start, end-start);
+}
+
+/**
+ * Append the shortest text representation of a double that converts back to exactly the same value.
+ */
+static void appendValue(string& text, double value) {
+    char buffer[32];
+    g_fmt(buffer, value);
+    text += buffer;
+}
+
+/**
+ * Write the values in an array separated by spaces.  Large arrays are divided into blocks, and the
+ * values in each block are formatted on multiple threads before being written in order.
+ */
+template <class T>
+static void writeValues(const vector<T>& values, std::ostream& stream) {
+    int numValues = values.size();
+    if (numValues < minValuesForThreads) {
+        string text;
+        for (int i = 0; i < numValues; i++) {
+            if (i > 0)
+                text += ' ';
+            appendValue(text, values[i]);
+        }
+        stream << text;
+        return;
+    }
+    ThreadPool threads;
+    int numThreads = threads.getNumThreads();
+    vector<string> text(numThreads);
+    int blockSize = numThreads*minValuesForThreads;
+    for (int blockStart = 0; blockStart < numValues; blockStart += blockSize) {
+        int blockEnd = min(blockStart+blockSize, numValues);
+        threads.execute([&] (ThreadPool& pool, int thread) {
+            int start = blockStart+(int) ((blockEnd-blockStart)*(long long) thread/numThreads);
+            int end = blockStart+(int) ((blockEnd-blockStart)*(long long) (thread+1)/numThreads);
+            text[thread].clear();
+            for (int i = start; i < end; i++) {
+                if (i > 0)
+                    text[thread] += ' ';
+                appendValue(text[thread], values[i]);
+            }
+        });
+        threads.waitForThreads();
+        for (int i = 0; i < numThreads; i++)
+            stream << text[i];
+    }
+}
+
+/**
+ * Parse an int, setting end to point to the first character after it.
+ */
+static void parseValue(const char* start, char** end, int& value) {
+    value = (int) strtol(start, end, 10);
+}
+
+/**
+ * Parse a double, setting end to point to the first character after it.  Most values have few enough
+ * digits to be converted exactly with a single floating point multiplication or division (Clinger's fast
+ * path).  Anything else is converted by strtod2().
+ */
+static void parseValue(const char* start, char** end, double& value) {
+    static const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* p = start;
+    bool negative = (*p == '-');
+    if (*p == '-' || *p == '+')
+        p++;
+    unsigned long long mantissa = 0;
+    int numDigits = 0, exponent = 0;
+    bool hasDigits = false;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        hasDigits = true;
+        mantissa = 10*mantissa+(*p-'0');
+        if (mantissa != 0)
+            numDigits++;
+    }
+    if (*p == '.')
+        for (p++; *p >= '0' && *p <= '9'; p++) {
+            hasDigits = true;
+            mantissa = 10*mantissa+(*p-'0');
+            if (mantissa != 0)
+                numDigits++;
+            exponent--;
+        }
+    if (hasDigits && (*p == 'e' || *p == 'E')) {
+        const char* e = p+1;
+        bool negativeExponent = (*e == '-');
+        if (*e == '-' || *e == '+')
+            e++;
+        int explicitExponent = 0;
+        bool hasExponentDigits = false;
+        for (; *e >= '0' && *e <= '9' && explicitExponent < 10000; e++) {
+            explicitExponent = 10*explicitExponent+(*e-'0');
+            hasExponentDigits = true;
+        }
+        if (hasExponentDigits) {
+            exponent += (negativeExponent ? -explicitExponent : explicitExponent);
+            p = e;
+        }
+    }
+    bool isTerminated = (*p == 0 || *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r');
+    if (hasDigits && isTerminated && numDigits <= 15 && mantissa < (1ULL<<53) && exponent >= -22 && exponent <= 22) {
+        double x = (double) mantissa;
+        x = (exponent < 0 ? x/powersOf10[-exponent] : x*powersOf10[exponent]);
+        value = (negative ? -x : x);
+        *end = (char*) p;
+        return;
+    }
+    value = strtod2(start, end);
+}
+
+/**
+ * Parse a list of values separated by whitespace, appending them to an array.  Long lists are
+ * divided between multiple threads, each of which parses a contiguous range.
+ */
+template <class T>
+static void parseValues(const char* text, const char* textEnd, vector<T>& values, unique_ptr<ThreadPool>& threads, const string& arrayName) {
+    int numThreads = 1;
+    if (textEnd-text > 8*minValuesForThreads) {
+        if (threads == NULL)
+            threads.reset(new ThreadPool());
+        numThreads = threads->getNumThreads();
+    }
+
+    // Divide the text into ranges at whitespace boundaries.
+
+    vector<const char*> rangeStart(numThreads+1);
+    rangeStart[0] = text;
+    rangeStart[numThreads] = textEnd;
+    for (int i = 1; i < numThreads; i++) {
+        const char* p = max(rangeStart[i-1], text+(textEnd-text)*i/numThreads);
+        while (p < textEnd && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+            p++;
+        rangeStart[i] = p;
+    }
+    vector<vector<T> > rangeValues(numThreads);
+    vector<int> rangeValid(numThreads, 1);
+    auto parseRange = [&] (int range) {
+        const char* p = rangeStart[range];
+        const char* rangeEnd = rangeStart[range+1];
+        while (true) {
+            while (p < rangeEnd && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                p++;
+            if (p == rangeEnd)
+                break;
+            T value;
+            char* end;
+            parseValue(p, &end, value);
+            if (end == p || end > rangeEnd || (end < rangeEnd && *end != ' ' && *end != '\t' && *end != '\n' && *end != '\r')) {
+                rangeValid[range] = 0;
+                break;
+            }
+            rangeValues[range].push_back(value);
+            p = end;
+        }
+    };
+    if (numThreads == 1) {
+        // Append directly to the array to avoid copying the values.
+
+        rangeValues[0].swap(values);
+        parseRange(0);
+        rangeValues[0].swap(values);
+    }
+    else {
+        threads->execute([&] (ThreadPool& pool, int thread) {
+            parseRange(thread);
+        });
+        threads->waitForThreads();
+        for (int i = 0; i < numThreads; i++)
+            values.insert(values.end(), rangeValues[i].begin(), rangeValues[i].end());
+    }
+    for (int i = 0; i < numThreads; i++)
+        if (!rangeValid[i])
+            throw OpenMMException("XmlSerializer: invalid number in array '"+arrayName+"'");
+}
+
 void XmlSerializer::serialize(const SerializationNode& node, std::ostream& stream) {
     stream << "<?xml version=\"1.0\" ?>\n";
     encodeNode(node, stream, 0);
@@ -122,10 +326,33 @@ void XmlSerializer::encodeNode(const SerializationNode& node, std::ostream& stre
         stream << ' ' << name << "=\"" << value << '\"';
     }
     const vector<SerializationNode>& children = node.getChildren();
-    if (children.size() == 0)
+    const map<string, vector<int> >& intArrays = node.getIntArrays();
+    const map<string, vector<double> >& doubleArrays = node.getDoubleArrays();
+    if (children.size() == 0 && intArrays.size() == 0 && doubleArrays.size() == 0)
         stream << "/>\n";
     else {
         stream << ">\n";
+
+        // Arrays are written as child elements that list all their values in a single attribute.
+
+        for (auto& array : intArrays) {
+            string name;
+            encodeString(array.first, &name);
+            for (int i = 0; i <= depth; i++)
+                stream << '\t';
+            stream << "<IntArray name=\"" << name << "\" size=\"" << array.second.size() << "\" values=\"";
+            writeValues(array.second, stream);
+            stream << "\"/>\n";
+        }
+        for (auto& array : doubleArrays) {
+            string name;
+            encodeString(array.first, &name);
+            for (int i = 0; i <= depth; i++)
+                stream << '\t';
+            stream << "<DoubleArray name=\"" << name << "\" size=\"" << array.second.size() << "\" values=\"";
+            writeValues(array.second, stream);
+            stream << "\"/>\n";
+        }
         for (auto& child : children)
             encodeNode(child, stream, depth+1);
         for (int i = 0; i < depth; i++)
@@ -135,63 +362,325 @@ void XmlSerializer::encodeNode(const SerializationNode& node, std::ostream& stre
 }
 
 /**
- * Adapter class to let irrXML read a C++ stream.
+ * This class parses XML incrementally as it is read from a stream, storing the content into
+ * SerializationNodes.  The stream is read in fixed size blocks, so the memory required is only
+ * what is needed to hold the nodes themselves.  Arrays are converted to numbers as they are read
+ * without ever storing their text.
+ *
+ * This supports the subset of XML that is needed for serialized objects: elements, attributes, and
+ * the predefined entities.  Comments, processing instructions, and document type declarations are
+ * skipped, and text content is ignored.
  */
-class XmlSerializer::StreamReader : public IFileReadCallBack {
+class XmlSerializer::StreamReader {
 public:
-    StreamReader(std::istream& stream) : stream(stream) {
-        stream.seekg(0, ios_base::end);
-        size = stream.tellg();
-        stream.seekg(0);
-    }
-    int read(void* buffer, int sizeToRead) {
-        stream.read((char*) buffer, sizeToRead);
-        return stream.gcount();
+    StreamReader(std::istream& stream) : stream(stream), buffer(1<<16), pos(0), size(0) {
     }
-    int getSize() {
-        return size;
+    /**
+     * Read the document and store the root element into a SerializationNode.
+     */
+    void decodeDocument(SerializationNode& root) {
+        // Skip a UTF-8 byte order mark if there is one.
+
+        if (peek() == 0xEF) {
+            get();
+            if (get() != 0xBB || get() != 0xBF)
+                throw OpenMMException("XmlSerializer: invalid character at start of input");
+        }
+
+        // Find the root element.
+
+        while (true) {
+            int c = get();
+            if (c == EOF)
+                throw OpenMMException("XmlSerializer: no root element found in input");
+            if (c == '<' && !skipMarkup()) {
+                root.setName(readName());
+                decodeElement(root);
+                return;
+            }
+        }
     }
 private:
-    std::istream& stream;
-    int size;
-};
-
-/**
- * Process an XML node, storing its content into a SerializationNode.
- */
-static void decodeNode(SerializationNode& node, IrrXMLReader& xml) {
-    for (int i = 0; i < xml.getAttributeCount(); i++)
-        node.setStringProperty(xml.getAttributeName(i), xml.getAttributeValue(i));
-    if (xml.isEmptyElement())
-        return;
-    while (xml.read()) {
-        switch (xml.getNodeType()) {
-            case EXN_ELEMENT:
-            {
-                SerializationNode& childNode = node.createChildNode(xml.getNodeName());
-                decodeNode(childNode, xml);
+    int peek() {
+        if (pos == size && !fill())
+            return EOF;
+        return (unsigned char) buffer[pos];
+    }
+    int get() {
+        int c = peek();
+        if (c != EOF)
+            pos++;
+        return c;
+    }
+    int getRequired() {
+        int c = get();
+        if (c == EOF)
+            throw OpenMMException("XmlSerializer: unexpected end of input");
+        return c;
+    }
+    bool fill() {
+        stream.read(buffer.data(), buffer.size());
+        size = stream.gcount();
+        pos = 0;
+        return (size > 0);
+    }
+    static bool isSpace(int c) {
+        return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+    }
+    void skipSpace() {
+        while (isSpace(peek()))
+            get();
+    }
+    /**
+     * Skip input until the specified terminator has been read.
+     */
+    void skipPast(const string& terminator) {
+        string recent;
+        while (recent != terminator) {
+            recent += (char) getRequired();
+            if (recent.size() > terminator.size())
+                recent.erase(0, 1);
+        }
+    }
+    /**
+     * This is called just after a '<' has been read.  If it begins a comment, processing instruction,
+     * or declaration, skip over it and return true.  Otherwise return false.
+     */
+    bool skipMarkup() {
+        int c = peek();
+        if (c == '?') {
+            skipPast("?>");
+            return true;
+        }
+        if (c == '!') {
+            get();
+            if (peek() == '-') {
+                get();
+                if (getRequired() != '-')
+                    throw OpenMMException("XmlSerializer: invalid comment in input");
+                skipPast("-->");
+            }
+            else if (peek() == '[')
+                skipPast("]]>");
+            else
+                skipPast(">");
+            return true;
+        }
+        return false;
+    }
+    string readName() {
+        string name;
+        while (true) {
+            int c = peek();
+            if (c == EOF || isSpace(c) || c == '/' || c == '>' || c == '=')
                 break;
+            name += (char) get();
+        }
+        if (name.size() == 0)
+            throw OpenMMException("XmlSerializer: expected a name in input");
+        return name;
+    }
+    /**
+     * Read the opening quote of an attribute value and return it.
+     */
+    int readQuote() {
+        skipSpace();
+        if (getRequired() != '=')
+            throw OpenMMException("XmlSerializer: expected '=' in input");
+        skipSpace();
+        int quote = getRequired();
+        if (quote != '"' && quote != '\'')
+            throw OpenMMException("XmlSerializer: expected a quoted attribute value");
+        return quote;
+    }
+    /**
+     * Read an attribute value, decoding the predefined entities.  Any other '&' sequences are left
+     * unchanged, matching the encoding done by encodeString().
+     */
+    string readValue(int quote) {
+        string value;
+        while (true) {
+            int c = getRequired();
+            if (c == quote)
+                return value;
+            if (c != '&') {
+                value += (char) c;
+                continue;
+            }
+            string entity;
+            while (entity.size() < 5 && peek() != ';' && peek() != quote && peek() != EOF)
+                entity += (char) get();
+            if (peek() == ';') {
+                char replacement = 0;
+                if (entity == "amp")
+                    replacement = '&';
+                else if (entity == "lt")
+                    replacement = '<';
+                else if (entity == "gt")
+                    replacement = '>';
+                else if (entity == "quot")
+                    replacement = '"';
+                else if (entity == "apos")
+                    replacement = '\'';
+                if (replacement != 0) {
+                    get();
+                    value += replacement;
+                    continue;
+                }
+            }
+            value += '&';
+            value += entity;
+        }
+    }
+    /**
+     * Read the attributes of an element.  If it is terminated by "/>" this returns true.
+     * Otherwise it returns false, and the content of the element follows.
+     */
+    template <class F>
+    bool readAttributes(F processAttribute) {
+        while (true) {
+            skipSpace();
+            int c = peek();
+            if (c == '/') {
+                get();
+                if (getRequired() != '>')
+                    throw OpenMMException("XmlSerializer: expected '>' in input");
+                return true;
+            }
+            if (c == '>') {
+                get();
+                return false;
             }
-            case EXN_ELEMENT_END:
+            string name = readName();
+            processAttribute(name, readQuote());
+        }
+    }
+    /**
+     * Read the remainder of an element whose name has already been read.
+     */
+    void decodeElement(SerializationNode& node) {
+        bool isEmpty = readAttributes([&] (const string& name, int quote) {
+            node.setStringProperty(name, readValue(quote));
+        });
+        if (!isEmpty)
+            decodeContent(node);
+    }
+    /**
+     * Read the content of an element up to and including its end tag.
+     */
+    void decodeContent(SerializationNode& node) {
+        while (true) {
+            if (getRequired() != '<' || skipMarkup())
+                continue;
+            if (peek() == '/') {
+                get();
+                if (readName() != node.getName())
+                    throw OpenMMException("XmlSerializer: mismatched end tag for '"+node.getName()+"'");
+                skipSpace();
+                if (getRequired() != '>')
+                    throw OpenMMException("XmlSerializer: expected '>' in input");
                 return;
+            }
+            string name = readName();
+            if (name == "IntArray" || name == "DoubleArray")
+                decodeArray(node, name);
+            else {
+                SerializationNode& child = node.createChildNode(name);
+                decodeElement(child);
+            }
         }
     }
-}
+    /**
+     * Read the list of values for an array, up to and including the closing quote.  The text is
+     * parsed in chunks as it is read, so the full text never needs to be stored.
+     */
+    template <class T>
+    void readValues(int quote, vector<T>& values, const string& arrayName) {
+        const size_t chunkSize = 1<<22;
+        string text;
+        while (true) {
+            if (pos == size && !fill())
+                throw OpenMMException("XmlSerializer: unexpected end of input");
+            const char* start = &buffer[pos];
+            const char* end = (const char*) memchr(start, quote, size-pos);
+            int length = (end == NULL ? size-pos : end-start);
+            text.append(start, length);
+            pos += length;
+            if (end != NULL) {
+                pos++;
+                parseValues(text.data(), text.data()+text.size(), values, threads, arrayName);
+                return;
+            }
+            if (text.size() >= chunkSize) {
+                size_t last = text.find_last_of(" \t\r\n");
+                if (last != string::npos) {
+                    parseValues(text.data(), text.data()+last, values, threads, arrayName);
+                    text.erase(0, last);
+                }
+            }
+        }
+    }
+    /**
+     * Read an element representing an array, storing it into the node it belongs to.
+     */
+    void decodeArray(SerializationNode& node, const string& elementName) {
+        bool isDouble = (elementName == "DoubleArray");
+        string arrayName;
+        long long declaredSize = -1;
+        vector<double> doubles;
+        vector<int> ints;
+        bool hasValues = false;
+        bool isEmpty = readAttributes([&] (const string& name, int quote) {
+            if (name == "values") {
+                if (isDouble)
+                    readValues(quote, doubles, arrayName);
+                else
+                    readValues(quote, ints, arrayName);
+                hasValues = true;
+            }
+            else {
+                string value = readValue(quote);
+                if (name == "name")
+                    arrayName = value;
+                else if (name == "size") {
+                    declaredSize = atoll(value.c_str());
+                    if (declaredSize < 0)
+                        throw OpenMMException("XmlSerializer: invalid size for array '"+arrayName+"'");
+                    if (isDouble)
+                        doubles.reserve(declaredSize);
+                    else
+                        ints.reserve(declaredSize);
+                }
+            }
+        });
+        if (arrayName.size() == 0 || declaredSize == -1 || !hasValues)
+            throw OpenMMException("XmlSerializer: array in node '"+node.getName()+"' is missing an attribute");
+        if (declaredSize != (long long) (isDouble ? doubles.size() : ints.size()))
+            throw OpenMMException("XmlSerializer: wrong number of values for array '"+arrayName+"'");
+        if (isDouble)
+            node.setDoubleArray(arrayName, std::move(doubles));
+        else
+            node.setIntArray(arrayName, std::move(ints));
+        if (!isEmpty) {
+            SerializationNode content;
+            content.setName(elementName);
+            decodeContent(content);
+        }
+    }
+
+    std::istream& stream;
+    vector<char> buffer;
+    int pos, size;
+    unique_ptr<ThreadPool> threads;
+};
 
 void* XmlSerializer::deserializeStream(std::istream& stream) {
     SerializationNode root;
     StreamReader reader(stream);
-    IrrXMLReader* xml = createIrrXMLReader(&reader);
-    
-    // Find the root node in the file.
-    
-    while (xml->read() && xml->getNodeType() != EXN_ELEMENT)
-        ;
-    decodeNode(root, *xml);
-    delete xml;
-    
+    reader.decodeDocument(root);
+
     // Process the SerializationNodes.
-    
+
     const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
     return proxy.deserialize(root);
 }
@@ -194,6 +194,17 @@ typedef unsigned Long ULong;
 #include "stdlib.h"
 #include "string.h"
 
+/* OpenMM converts numbers on multiple threads at once.  Each thread keeps its
+ * own list of free Bigints, so the only lock needed is the one protecting the
+ * shared table of powers of 5 used by pow5mult().
+ */
+#include <mutex>
+#define MULTIPLE_THREADS
+#define Omit_Private_Memory
+static std::mutex pow5Lock;
+#define ACQUIRE_DTOA_LOCK(n)	if (n == 1) pow5Lock.lock()
+#define FREE_DTOA_LOCK(n)	if (n == 1) pow5Lock.unlock()
+
 #ifdef USE_LOCALE
 #include "locale.h"
 #endif
@@ -526,7 +537,38 @@ Bigint {
 
  typedef struct Bigint Bigint;
 
- static Bigint *freelist[Kmax+1];
+ /* Each thread has its own list of free Bigints.  They are released when the
+  * thread exits by a FreelistCleanup, which is created the first time the
+  * thread frees a Bigint.
+  */
+
+ struct
+ThreadFreelist {
+	Bigint *list[Kmax+1];
+	int hasCleanup;
+	};
+
+ /* The initial-exec model avoids a call to look up the address on every access. */
+
+#if defined(__GNUC__) && defined(__linux__)
+ static thread_local ThreadFreelist threadFreelist __attribute__((tls_model("initial-exec")));
+#else
+ static thread_local ThreadFreelist threadFreelist;
+#endif
+
+ struct
+FreelistCleanup {
+	~FreelistCleanup() {
+		for(int k = 0; k <= Kmax; k++)
+			while(threadFreelist.list[k]) {
+				Bigint *next = threadFreelist.list[k]->next;
+				free((void*)threadFreelist.list[k]);
+				threadFreelist.list[k] = next;
+				}
+		}
+	};
+
+#define freelist threadFreelist.list
 
  static Bigint *
 Balloc
@@ -586,6 +628,11 @@ Bfree
 #endif
 		else {
 			ACQUIRE_DTOA_LOCK(0);
+			if (!threadFreelist.hasCleanup) {
+				static thread_local FreelistCleanup cleanup;
+				(void) cleanup;
+				threadFreelist.hasCleanup = 1;
+				}
 			v->next = freelist[v->k];
 			freelist[v->k] = v;
 			FREE_DTOA_LOCK(0);
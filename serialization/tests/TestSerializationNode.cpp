@@ -32,6 +32,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/serialization/SerializationNode.h"
 #include <iostream>
+#include <vector>
 
 using namespace OpenMM;
 using namespace std;
@@ -75,9 +76,39 @@ void testProperties() {
     ASSERT_EQUAL(false, node.hasProperty("prop2"));
 }
 
+void testArrays() {
+    SerializationNode node;
+    ASSERT_EQUAL(false, node.hasArray("array1"));
+    bool exists = false;
+    try {
+        node.getIntArray("array1");
+        exists = true;
+    }
+    catch (const exception& ex) {
+    }
+    ASSERT_EQUAL(false, exists);
+    vector<int> ints = {1, -2, 3};
+    vector<double> doubles = {0.1, 1e-300, -2.5e10};
+    node.setIntArray("array1", ints);
+    node.setDoubleArray("array2", doubles);
+    ASSERT_EQUAL(true, node.hasArray("array1"));
+    ASSERT_EQUAL(true, node.hasArray("array2"));
+    ASSERT_EQUAL(false, node.hasProperty("array1"));
+    ASSERT_EQUAL_CONTAINERS(ints, node.getIntArray("array1"));
+    ASSERT_EQUAL_CONTAINERS(doubles, node.getDoubleArray("array2"));
+    try {
+        node.getDoubleArray("array1");
+        exists = true;
+    }
+    catch (const exception& ex) {
+    }
+    ASSERT_EQUAL(false, exists);
+}
+
 int main() {
     try {
         testProperties();
+        testArrays();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
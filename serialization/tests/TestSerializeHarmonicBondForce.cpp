@@ -75,9 +75,36 @@ void testSerialization() {
     }
 }
 
+void testLegacyFormat() {
+    // Files written by older versions stored every bond as its own node.  Make sure they can still be read.
+
+    stringstream buffer;
+    buffer << "<?xml version=\"1.0\" ?>\n";
+    buffer << "<!-- A comment -> with <markup> -->\n";
+    buffer << "<Force forceGroup=\"1\" name='a &amp; &quot;b&quot;' type=\"HarmonicBondForce\" usesPeriodic=\"0\" version=\"2\">\n";
+    buffer << "\t<Bonds>\n";
+    buffer << "\t\t<Bond d=\"1.5\" k=\"100\" p1=\"0\" p2=\"1\"/>\n";
+    buffer << "\t\t<Bond d=\"2.5\" k=\"200\" p1=\"1\" p2=\"2\"/>\n";
+    buffer << "\t</Bonds>\n";
+    buffer << "</Force>\n";
+    HarmonicBondForce* force = XmlSerializer::deserialize<HarmonicBondForce>(buffer);
+    ASSERT_EQUAL(1, force->getForceGroup());
+    ASSERT_EQUAL("a & \"b\"", force->getName());
+    ASSERT_EQUAL(2, force->getNumBonds());
+    int p1, p2;
+    double d, k;
+    force->getBondParameters(1, p1, p2, d, k);
+    ASSERT_EQUAL(1, p1);
+    ASSERT_EQUAL(2, p2);
+    ASSERT_EQUAL(2.5, d);
+    ASSERT_EQUAL(200.0, k);
+    delete force;
+}
+
 int main() {
     try {
         testSerialization();
+        testLegacyFormat();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -59,6 +59,7 @@ void testSerialization() {
     double dalpha = 0.8;
     int dnx = 4, dny = 6, dnz = 7;
     force.setLJPMEParameters(dalpha, dnx, dny, dnz);
+    force.setPMEOrder(6);
     force.addParticle(1, 0.1, 0.01);
     force.addParticle(0.5, 0.2, 0.02);
     force.addParticle(-0.5, 0.3, 0.03);
@@ -94,6 +95,7 @@ void testSerialization() {
     ASSERT_EQUAL(force.getNumParticleParameterOffsets(), force2.getNumParticleParameterOffsets());
     ASSERT_EQUAL(force.getNumExceptionParameterOffsets(), force2.getNumExceptionParameterOffsets());
     ASSERT_EQUAL(force.getIncludeDirectSpace(), force2.getIncludeDirectSpace());
+    ASSERT_EQUAL(force.getPMEOrder(), force2.getPMEOrder());
     double alpha2;
     int nx2, ny2, nz2;
     force2.getPMEParameters(alpha2, nx2, ny2, nz2);
@@ -33,6 +33,7 @@
 #include "openmm/HarmonicBondForce.h"
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
+#include "openmm/serialization/BinarySerializer.h"
 #include "openmm/serialization/XmlSerializer.h"
 #include <iostream>
 #include <sstream>
@@ -104,10 +105,7 @@ void compareSystems(System& system, System& system2) {
         ASSERT(typeid(system.getForce(i)) == typeid(system2.getForce(i)))
 }
 
-void testSerialization() {
-    // Create a System.
-
-    System system;
+void createSystem(System& system) {
     for (int i = 0; i < 5; i++)
         system.addParticle(0.1*i+1);
     for (int i = 0; i < 5; i++)
@@ -121,6 +119,11 @@ void testSerialization() {
     system.setVirtualSite(7, new OutOfPlaneSite(0, 3, 1, 0.1, 0.2, 0.5));
     system.setVirtualSite(8, new LocalCoordinatesSite({4, 3, 2, 1}, {0.1, 0.2, 0.3, 0.4}, {-1.0, 0.4, 0.4, 0.2}, {0.3, 0.7, 0.0, -1.0}, Vec3(-0.5, 1.0, 1.5)));
     system.addForce(new HarmonicBondForce());
+}
+
+void testSerialization() {
+    System system;
+    createSystem(system);
 
     // Serialize and then deserialize it, then make sure the systems are identical.
 
@@ -137,9 +140,76 @@ void testSerialization() {
     delete copy;
 }
 
+void testBinarySerialization() {
+    System system;
+    createSystem(system);
+
+    // Serialize and deserialize it in binary form, and make sure the systems are identical.
+
+    stringstream buffer;
+    BinarySerializer::serialize<System>(&system, "System", buffer);
+    string binary = buffer.str();
+    System* copy = BinarySerializer::deserialize<System>(buffer);
+    compareSystems(system, *copy);
+    delete copy;
+
+    // The binary form should be smaller than XML.
+
+    stringstream xml;
+    XmlSerializer::serialize<System>(&system, "System", xml);
+    ASSERT(binary.size() < xml.str().size());
+
+    // Truncated or invalid input should produce an exception.
+
+    vector<string> invalid = {xml.str()};
+    for (int length : {0, 4, 12, (int) binary.size()/2, (int) binary.size()-1})
+        invalid.push_back(binary.substr(0, length));
+    for (string& data : invalid) {
+        stringstream input(data);
+        bool threwException = false;
+        try {
+            delete BinarySerializer::deserialize<System>(input);
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+    }
+}
+
+void testLargeSystem() {
+    // Large arrays are formatted and parsed in blocks on multiple threads.  Make sure every value,
+    // including ones that need the full 17 digits, is reproduced exactly.
+
+    System system;
+    for (int i = 0; i < 300000; i++)
+        system.addParticle(i%3 == 0 ? 1.008 : (i%3 == 1 ? 1.0/(i+1) : 1e-20*i));
+    for (int i = 0; i < 100000; i++)
+        system.addConstraint(3*i, 3*i+1, 0.1*i);
+    stringstream buffer;
+    XmlSerializer::serialize<System>(&system, "System", buffer);
+    System* copy = XmlSerializer::deserialize<System>(buffer);
+    ASSERT_EQUAL(system.getNumParticles(), copy->getNumParticles());
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL(system.getParticleMass(i), copy->getParticleMass(i));
+    ASSERT_EQUAL(system.getNumConstraints(), copy->getNumConstraints());
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int p1, p2, p3, p4;
+        double d1, d2;
+        system.getConstraintParameters(i, p1, p2, d1);
+        copy->getConstraintParameters(i, p3, p4, d2);
+        ASSERT_EQUAL(p1, p3);
+        ASSERT_EQUAL(p2, p4);
+        ASSERT_EQUAL(d1, d2);
+    }
+    delete copy;
+}
+
 int main() {
     try {
         testSerialization();
+        testBinarySerialization();
+        testLargeSystem();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
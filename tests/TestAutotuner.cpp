@@ -0,0 +1,186 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/Autotuner.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "ReferencePlatform.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * A version of the Reference platform with a property to tune.  Contexts cannot be created
+ * when the property is set to "broken".
+ */
+class TunablePlatform : public ReferencePlatform {
+public:
+    TunablePlatform() {
+        platformProperties.push_back("Mode");
+        setPropertyDefaultValue("Mode", "a");
+    }
+    const string& getPropertyValue(const Context& context, const string& property) const {
+        if (property == "Mode")
+            return modes[&context];
+        return ReferencePlatform::getPropertyValue(context, property);
+    }
+    void contextCreated(ContextImpl& context, const map<string, string>& properties) const {
+        string mode = getPropertyDefaultValue("Mode");
+        if (properties.find("Mode") != properties.end())
+            mode = properties.find("Mode")->second;
+        if (mode == "broken")
+            throw OpenMMException("This mode is broken");
+        modes[&context.getOwner()] = mode;
+        ReferencePlatform::contextCreated(context, properties);
+    }
+    mutable map<const Context*, string> modes;
+};
+
+void createSystem(System& system, vector<Vec3>& positions) {
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    for (int i = 0; i < 10; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.2 : -0.2, 0.3, 0.5);
+        positions.push_back(Vec3(0.5*(i%5), 0.5*(i/5), 0));
+    }
+}
+
+void testTuning() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    TunablePlatform platform;
+    Autotuner tuner(platform);
+    tuner.setNumSteps(5);
+    tuner.setUseCache(false);
+    tuner.addCandidates("Mode", {"a", "b", "broken"});
+    unique_ptr<Context> context(tuner.createContext(system, integrator, positions));
+
+    // The broken mode should have been skipped, and the Context should use the selected one.
+
+    string mode = tuner.getSelectedProperties().at("Mode");
+    ASSERT(mode == "a" || mode == "b");
+    ASSERT_EQUAL(mode, platform.getPropertyValue(*context, "Mode"));
+    ASSERT(!tuner.getLoadedFromCache());
+    const string& report = tuner.getReport();
+    ASSERT(report.find("Mode=b") != string::npos);
+    ASSERT(report.find("Mode=broken: failed") != string::npos);
+    ASSERT(report.find("Selected: Mode="+mode) != string::npos);
+
+    // The returned Context should be ready to use with the original Integrator.
+
+    State state = context->getState(State::Positions);
+    for (int i = 0; i < positions.size(); i++)
+        ASSERT_EQUAL_VEC(positions[i], state.getPositions()[i], 1e-10);
+    integrator.step(1);
+}
+
+void testCache() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    TunablePlatform platform;
+    Autotuner tuner(platform);
+    tuner.setNumSteps(5);
+    tuner.addCandidates("Mode", {"a", "b"});
+    VerletIntegrator integrator1(0.001);
+    delete tuner.createContext(system, integrator1, positions);
+    string mode = tuner.getSelectedProperties().at("Mode");
+
+    // The second time, the result should come from the cache.
+
+    VerletIntegrator integrator2(0.001);
+    delete tuner.createContext(system, integrator2, positions);
+    ASSERT(tuner.getLoadedFromCache());
+    ASSERT_EQUAL(mode, tuner.getSelectedProperties().at("Mode"));
+    ASSERT(tuner.getReport().find("Loaded configuration") != string::npos);
+
+}
+
+/**
+ * Check that an operation throws an OpenMMException.
+ */
+template <class F>
+void assertThrows(F operation) {
+    bool threwException = false;
+    try {
+        operation();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testErrors() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    TunablePlatform platform;
+    map<string, string> fixed;
+    fixed["Mode"] = "a";
+    Autotuner tuner1(platform, fixed);
+    assertThrows([&] () {tuner1.addCandidates("Mode", {"b"});});
+    Autotuner tuner2(platform);
+    assertThrows([&] () {tuner2.addCandidates("Mode", {});});
+
+    // If the initial configuration fails, there is nothing to compare against.
+
+    tuner2.addCandidates("Mode", {"broken", "a"});
+    tuner2.setUseCache(false);
+    VerletIntegrator integrator(0.001);
+    assertThrows([&] () {tuner2.createContext(system, integrator, positions);});
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testTuning();
+        testCache();
+        testErrors();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -31,7 +31,11 @@
 
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/AndersenThermostat.h"
+#include "openmm/CheckpointCompressor.h"
 #include "openmm/Context.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/HarmonicBondForce.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
@@ -116,12 +120,210 @@ void testSetState() {
     }
 }
 
+void testComputeEnergies() {
+    const int numParticles = 10;
+    const int numFrames = 5;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    system.addForce(nonbonded);
+    CustomExternalForce* external = new CustomExternalForce("k*x^2");
+    external->addGlobalParameter("k", 1.0);
+    external->setForceGroup(1);
+    system.addForce(external);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<vector<Vec3> > frames(numFrames, vector<Vec3>(numParticles));
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        external->addParticle(i);
+        for (int j = 0; j < numFrames; j++)
+            frames[j][i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(i*0.3, 0, 0);
+    context.setPositions(positions);
+    vector<map<string, double> > parameterSets(3);
+    parameterSets[0]["k"] = 1.0;
+    parameterSets[1]["k"] = 2.5;
+    parameterSets[2]["k"] = 0.0;
+
+    // Compute the energies, and compare them to evaluating each frame separately.
+
+    vector<double> energies = context.computeEnergies(frames);
+    vector<double> groupEnergies = context.computeEnergies(frames, 1<<1);
+    vector<vector<double> > parameterEnergies = context.computeEnergies(frames, parameterSets);
+    vector<vector<double> > independentEnergies = context.computeEnergies(frames, parameterSets, 1<<0);
+    ASSERT_EQUAL(numFrames, energies.size());
+    ASSERT_EQUAL(numFrames, parameterEnergies.size());
+    State state = context.getState(State::Positions | State::Parameters);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(positions[i], state.getPositions()[i], TOL);
+    ASSERT_EQUAL(1.0, state.getParameters().find("k")->second);
+    for (int i = 0; i < numFrames; i++) {
+        context.setPositions(frames[i]);
+        ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), energies[i], TOL);
+        ASSERT_EQUAL_TOL(context.getState(State::Energy, false, 1<<1).getPotentialEnergy(), groupEnergies[i], TOL);
+        ASSERT_EQUAL(parameterSets.size(), parameterEnergies[i].size());
+        for (int j = 0; j < (int) parameterSets.size(); j++) {
+            context.setParameter("k", parameterSets[j]["k"]);
+            ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), parameterEnergies[i][j], TOL);
+            ASSERT_EQUAL_TOL(context.getState(State::Energy, false, 1<<0).getPotentialEnergy(), independentEnergies[i][j], TOL);
+        }
+        context.setParameter("k", 1.0);
+    }
+}
+
+void testCompressedCheckpoint() {
+    const int numParticles = 200;
+    const double boxSize = 3.0;
+    System system;
+    system.addForce(new AndersenThermostat(300.0, 100.0));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator.step(10);
+
+    // Create two checkpoints a few steps apart.
+
+    stringstream stream1, stream2;
+    context.createCheckpoint(stream1);
+    State s1 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    integrator.step(2);
+    context.createCheckpoint(stream2);
+    State s2 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    string checkpoint1 = stream1.str();
+    string checkpoint2 = stream2.str();
+
+    // Compress them, and verify they round trip exactly.
+
+    string compressed = CheckpointCompressor::compress(checkpoint1);
+    string delta = CheckpointCompressor::compress(checkpoint2, checkpoint1);
+    ASSERT(CheckpointCompressor::isCompressed(compressed));
+    ASSERT(!CheckpointCompressor::isCompressed(checkpoint1));
+    ASSERT(compressed.size() < checkpoint1.size());
+    ASSERT(delta.size() < compressed.size());
+    ASSERT(CheckpointCompressor::decompress(compressed) == checkpoint1);
+    ASSERT(CheckpointCompressor::decompress(delta, checkpoint1) == checkpoint2);
+
+    // A delta cannot be restored without the correct previous checkpoint.
+
+    bool threwException = false;
+    try {
+        CheckpointCompressor::decompress(delta);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    threwException = false;
+    try {
+        CheckpointCompressor::decompress(delta, checkpoint2);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // Load the checkpoints into the Context.
+
+    stringstream compressedStream(compressed);
+    context.loadCheckpoint(compressedStream);
+    State s3 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    compareStates(s1, s3);
+    stringstream deltaStream(CheckpointCompressor::decompress(delta, checkpoint1));
+    context.loadCheckpoint(deltaStream);
+    State s4 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    compareStates(s2, s4);
+}
+
+void testParticleSubset() {
+    const int numMolecules = 20;
+    const double boxSize = 2.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        // Place each molecule far outside the periodic box so that wrapping matters.
+
+        Vec3 center(5*boxSize*(genrand_real2(sfmt)-0.5), 5*boxSize*(genrand_real2(sfmt)-0.5), 5*boxSize*(genrand_real2(sfmt)-0.5));
+        for (int j = 0; j < 3; j++) {
+            system.addParticle(1.0);
+            nonbonded->addParticle(j == 0 ? 0.2 : -0.1, 0.2, 0.1);
+            positions.push_back(center+Vec3(0.1*j, 0.05*j, 0));
+        }
+        bonds->addBond(3*i, 3*i+1, 0.1, 1000.0);
+        bonds->addBond(3*i, 3*i+2, 0.12, 1000.0);
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0);
+    integrator.step(10);
+
+    // Request an arbitrary subset, including a partial molecule and a repeated particle.
+
+    vector<int> particles = {7, 0, 31, 2, 59, 7, 45};
+    int types = State::Positions | State::Velocities | State::Forces | State::Energy;
+    for (bool enforcePeriodicBox : {false, true}) {
+        State full = context.getState(types, enforcePeriodicBox);
+        State subset = context.getState(types, particles, enforcePeriodicBox);
+        ASSERT_EQUAL(particles.size(), subset.getPositions().size());
+        ASSERT_EQUAL(particles.size(), subset.getVelocities().size());
+        ASSERT_EQUAL(particles.size(), subset.getForces().size());
+        ASSERT_EQUAL_TOL(full.getPotentialEnergy(), subset.getPotentialEnergy(), TOL);
+        for (int i = 0; i < particles.size(); i++) {
+            ASSERT_EQUAL_VEC(full.getPositions()[particles[i]], subset.getPositions()[i], TOL);
+            ASSERT_EQUAL_VEC(full.getVelocities()[particles[i]], subset.getVelocities()[i], TOL);
+            ASSERT_EQUAL_VEC(full.getForces()[particles[i]], subset.getForces()[i], TOL);
+        }
+    }
+    ASSERT_EQUAL(0, context.getState(State::Positions, vector<int>()).getPositions().size());
+    bool threwException = false;
+    try {
+        context.getState(State::Positions, vector<int>(1, 3*numMolecules));
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
     try {
         initializeTests(argc, argv);
         testSetState();
+        testComputeEnergies();
+        testCompressedCheckpoint();
+        testParticleSubset();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -268,6 +268,71 @@ void testSaveParameters() {
     ASSERT_EQUAL_VEC(b1[0], b3[0], 1e-6);
 }
 
+void testAlternatingIntegrators() {
+    // A CustomIntegrator caches whether the forces are valid.  Switching to it after another integrator
+    // has moved the particles must not let it reuse forces computed for the old positions.
+
+    System system;
+    system.addParticle(2.0);
+    system.addParticle(2.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->addBond(0, 1, 1.5, 1);
+    system.addForce(bonds);
+    CompoundIntegrator integrator;
+    CustomIntegrator* verlet = new CustomIntegrator(0.01);
+    verlet->addUpdateContextState();
+    verlet->addComputePerDof("v", "v+0.5*dt*f/m");
+    verlet->addComputePerDof("x", "x+dt*v");
+    verlet->addComputePerDof("v", "v+0.5*dt*f/m");
+    integrator.addIntegrator(verlet);
+    CustomIntegrator* drift = new CustomIntegrator(0.01);
+    drift->addComputePerDof("x", "x+dt*v");
+    integrator.addIntegrator(drift);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(2), velocities(2);
+    positions[0] = Vec3(-1, 0, 0);
+    positions[1] = Vec3(1, 0, 0);
+    velocities[0] = Vec3(0, 0.5, 0);
+    velocities[1] = Vec3(0, -0.5, 0);
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    for (int i = 0; i < 10; i++) {
+        integrator.setCurrentIntegrator(0);
+        integrator.step(1);
+        integrator.setCurrentIntegrator(1);
+        integrator.step(1);
+    }
+
+    // Repeat the same steps by hand and compare.
+
+    const double dt = 0.01, mass = 2.0;
+    auto computeForces = [&] (vector<Vec3>& forces) {
+        Vec3 delta = positions[1]-positions[0];
+        double r = sqrt(delta.dot(delta));
+        forces.resize(2);
+        forces[1] = -delta*((r-1.5)/r);
+        forces[0] = -forces[1];
+    };
+    vector<Vec3> forces;
+    for (int i = 0; i < 10; i++) {
+        computeForces(forces);
+        for (int j = 0; j < 2; j++) {
+            velocities[j] += forces[j]*(0.5*dt/mass);
+            positions[j] += velocities[j]*dt;
+        }
+        computeForces(forces);
+        for (int j = 0; j < 2; j++) {
+            velocities[j] += forces[j]*(0.5*dt/mass);
+            positions[j] += velocities[j]*dt;
+        }
+    }
+    State state = context.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQUAL_VEC(positions[i], state.getPositions()[i], 1e-5);
+        ASSERT_EQUAL_VEC(velocities[i], state.getVelocities()[i], 1e-5);
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -278,6 +343,7 @@ int main(int argc, char* argv[]) {
         testDifferentStepSizes();
         testCheckpoint();
         testSaveParameters();
+        testAlternatingIntegrators();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -0,0 +1,156 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 20;
+
+System* createSystem() {
+    System* system = new System();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(1.0+i%3);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+    }
+    for (int i = 0; i < numParticles-1; i += 2)
+        bonds->addBond(i, i+1, 0.2, 1000.0);
+    nonbonded->setForceGroup(1);
+    system->addForce(nonbonded);
+    system->addForce(bonds);
+    return system;
+}
+
+void testArrays() {
+    System* system = createSystem();
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, Platform::getPlatformByName("Reference"));
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<double> positions(3*numParticles), velocities(3*numParticles);
+    for (int i = 0; i < 3*numParticles; i++) {
+        positions[i] = 2.0*genrand_real2(sfmt);
+        velocities[i] = genrand_real2(sfmt)-0.5;
+    }
+
+    // Set the positions and velocities from arrays, and see if they match the State.
+
+    context.setPositionArray(positions.data());
+    context.setVelocityArray(velocities.data());
+    State state = context.getState(State::Positions | State::Velocities | State::Forces);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(Vec3(positions[3*i], positions[3*i+1], positions[3*i+2]), state.getPositions()[i], 1e-10);
+        ASSERT_EQUAL_VEC(Vec3(velocities[3*i], velocities[3*i+1], velocities[3*i+2]), state.getVelocities()[i], 1e-10);
+    }
+
+    // Retrieve them as arrays of both precisions.
+
+    vector<double> doubleArray(3*numParticles);
+    vector<float> floatArray(3*numParticles);
+    context.getPositionArray(doubleArray.data());
+    context.getPositionArray(floatArray.data());
+    for (int i = 0; i < 3*numParticles; i++) {
+        ASSERT_EQUAL(positions[i], doubleArray[i]);
+        ASSERT_EQUAL_TOL(positions[i], floatArray[i], 1e-6);
+    }
+    context.getVelocityArray(doubleArray.data());
+    context.getVelocityArray(floatArray.data());
+    for (int i = 0; i < 3*numParticles; i++) {
+        ASSERT_EQUAL(velocities[i], doubleArray[i]);
+        ASSERT_EQUAL_TOL(velocities[i], floatArray[i], 1e-6);
+    }
+    context.getForceArray(doubleArray.data());
+    context.getForceArray(floatArray.data());
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(state.getForces()[i], Vec3(doubleArray[3*i], doubleArray[3*i+1], doubleArray[3*i+2]), 1e-10);
+        ASSERT_EQUAL_VEC(state.getForces()[i], Vec3(floatArray[3*i], floatArray[3*i+1], floatArray[3*i+2]), 1e-5);
+    }
+
+    // Setting single precision values should work too.
+
+    for (int i = 0; i < 3*numParticles; i++)
+        floatArray[i] = (float) positions[i]+0.01f;
+    context.setPositionArray(floatArray.data());
+    context.getPositionArray(doubleArray.data());
+    for (int i = 0; i < 3*numParticles; i++)
+        ASSERT_EQUAL((double) floatArray[i], doubleArray[i]);
+    for (int i = 0; i < 3*numParticles; i++)
+        floatArray[i] = (float) velocities[i]+0.01f;
+    context.setVelocityArray(floatArray.data());
+    context.getVelocityArray(doubleArray.data());
+    for (int i = 0; i < 3*numParticles; i++)
+        ASSERT_EQUAL((double) floatArray[i], doubleArray[i]);
+
+    // Check selecting force groups.
+
+    state = context.getState(State::Forces, false, 1<<1);
+    context.getForceArray(doubleArray.data(), 1<<1);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state.getForces()[i], Vec3(doubleArray[3*i], doubleArray[3*i+1], doubleArray[3*i+2]), 1e-10);
+
+    // A NULL array should throw an exception.
+
+    bool threwException = false;
+    try {
+        context.setPositionArray((double*) NULL);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    delete system;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testArrays();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -93,6 +93,45 @@ void testCVs() {
     ASSERT_EQUAL_VEC(Vec3(0.0, 0.0, -3.0), state.getForces()[2], 1e-6);
 }
 
+void testUnusedCV() {
+    // The energy does not depend on one of the collective variables, so it should not contribute any
+    // force.  It also involves only a few particles out of many.
+
+    System system;
+    int numParticles = 20;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    CustomCVForce* cv = new CustomCVForce("v1^2");
+    system.addForce(cv);
+    CustomBondForce* v1 = new CustomBondForce("r");
+    v1->addBond(3, 7);
+    cv->addCollectiveVariable("v1", v1);
+    CustomBondForce* v2 = new CustomBondForce("r");
+    v2->addBond(0, 2);
+    cv->addCollectiveVariable("v2", v2);
+    VerletIntegrator integrator(1.0);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(i, 0.5*i, 0);
+    positions[7] = Vec3(3, 1.5, 2);
+    context.setPositions(positions);
+    vector<double> values;
+    cv->getCollectiveVariableValues(context, values);
+    ASSERT_EQUAL_TOL(2.0, values[0], 1e-6);
+    ASSERT_EQUAL_TOL(sqrt(5.0), values[1], 1e-6);
+    State state = context.getState(State::Energy | State::Forces);
+    ASSERT_EQUAL_TOL(4.0, state.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < numParticles; i++) {
+        Vec3 expected;
+        if (i == 3)
+            expected = Vec3(0, 0, 4.0);
+        else if (i == 7)
+            expected = Vec3(0, 0, -4.0);
+        ASSERT_EQUAL_VEC(expected, state.getForces()[i], 1e-5);
+    }
+}
+
 void testEnergyParameterDerivatives() {
     System system;
     system.addParticle(1.0);
@@ -274,6 +313,7 @@ int main(int argc, char* argv[]) {
     try {
         initializeTests(argc, argv);
         testCVs();
+        testUnusedCV();
         testEnergyParameterDerivatives();
         testTabulatedFunction();
         testReordering();
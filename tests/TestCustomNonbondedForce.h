@@ -36,6 +36,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "sfmt/SFMT.h"
 #include "openmm/Context.h"
+#include "openmm/CustomBondForce.h"
 #include "openmm/CustomNonbondedForce.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/System.h"
@@ -918,6 +919,54 @@ void testLongRangeCorrection() {
     ASSERT_EQUAL_TOL(standardEnergy1-standardEnergy2, customEnergy1-customEnergy2, 1e-4);
 }
 
+void testLongRangeCorrectionGlobalParameters() {
+    // The long range correction caches integrals for pairs of classes.  Make sure it is updated correctly when
+    // global parameters change, whether they affect only some classes (lambda) or all of them (scale).
+
+    int numParticles = 60;
+    double boxSize = 2.5;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomNonbondedForce* nonbonded = new CustomNonbondedForce("scale*4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)*s1*s2");
+    nonbonded->addPerParticleParameter("sigma");
+    nonbonded->addPerParticleParameter("eps");
+    nonbonded->addPerParticleParameter("solute");
+    nonbonded->addGlobalParameter("lambda", 1.0);
+    nonbonded->addGlobalParameter("scale", 1.0);
+    nonbonded->addComputedValue("s", "1-solute*(1-lambda)");
+    nonbonded->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseLongRangeCorrection(true);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle({0.3+0.02*(i%3), 0.5+0.1*(i%4), (i < 5 ? 1.0 : 0.0)});
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.getState(State::Energy);
+    vector<pair<double, double> > values = {{0.5, 1.0}, {0.2, 1.0}, {0.2, 0.7}, {1.0, 0.7}};
+    for (auto& v : values) {
+        context.setParameter("lambda", v.first);
+        context.setParameter("scale", v.second);
+        double energy = context.getState(State::Energy).getPotentialEnergy();
+
+        // Compare to a new Context that computes the correction from scratch.
+
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, platform);
+        context2.setPositions(positions);
+        context2.setParameter("lambda", v.first);
+        context2.setParameter("scale", v.second);
+        ASSERT_EQUAL_TOL(context2.getState(State::Energy).getPotentialEnergy(), energy, 1e-5);
+    }
+}
+
 void testInteractionGroups() {
     const int numParticles = 6;
     System system;
@@ -1506,6 +1555,86 @@ void testComputedValues(int mode) {
         double e2 = context.getState(State::Energy, false, 1<<1).getPotentialEnergy();
         ASSERT_EQUAL_TOL(e1, e2, 1e-5);
     }
+
+    // Change the per-particle parameters and make sure the computed values get updated, both
+    // the first time the force is evaluated and on later evaluations.
+
+    for (int model = 0; model < 2; model++) {
+        CustomNonbondedForce* force = (model == 0 ? nb1 : nb2);
+        for (int i = 0; i < numParticles; i += 3)
+            force->setParticleParameters(i, {1.2, 1.4, 0.8});
+        force->updateParametersInContext(context);
+    }
+    for (int repeat = 0; repeat < 2; repeat++) {
+        double e1 = context.getState(State::Energy, false, 1<<0).getPotentialEnergy();
+        double e2 = context.getState(State::Energy, false, 1<<1).getPotentialEnergy();
+        ASSERT_EQUAL_TOL(e1, e2, 1e-5);
+    }
+}
+
+void testUpdateSomeParameters() {
+    // Create a box of identical diatomic molecules.
+
+    const int numMolecules = 50;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomNonbondedForce* force = new CustomNonbondedForce("4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+    force->addPerParticleParameter("sigma");
+    force->addPerParticleParameter("eps");
+    force->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    force->setCutoffDistance(1.0);
+    CustomBondForce* bonds = new CustomBondForce("1000*(r-0.1)^2");
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        force->addParticle({0.2, 0.5});
+        force->addParticle({0.25, 0.4});
+        force->addExclusion(2*i, 2*i+1);
+        bonds->addBond(2*i, 2*i+1);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    system.addForce(force);
+    system.addForce(bonds);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.getState(State::Energy);
+
+    // Change the parameters of one molecule, so it is no longer identical to the others, and make sure
+    // the results match a newly created Context.
+
+    force->setParticleParameters(20, {0.3, 0.6});
+    force->setParticleParameters(21, {0.35, 0.7});
+    force->updateParametersInContext(context, 20, 2);
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(positions);
+    State state1 = context.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-5);
+
+    // Take a few steps to let atoms be reordered, then change it back to match the other molecules.
+
+    integrator.step(10);
+    force->setParticleParameters(20, {0.2, 0.5});
+    force->setParticleParameters(21, {0.25, 0.4});
+    force->updateParametersInContext(context, 20, 2);
+    VerletIntegrator integrator3(0.001);
+    Context context3(system, integrator3, platform);
+    context3.setPositions(context.getState(State::Positions).getPositions());
+    state1 = context.getState(State::Forces | State::Energy);
+    state2 = context3.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-5);
 }
 
 void runPlatformTests();
@@ -1531,6 +1660,7 @@ int main(int argc, char* argv[]) {
         testCoulombLennardJones();
         testSwitchingFunction();
         testLongRangeCorrection();
+        testLongRangeCorrectionGlobalParameters();
         testInteractionGroups();
         testLargeInteractionGroup();
         testInteractionGroupLongRangeCorrection();
@@ -1545,6 +1675,7 @@ int main(int argc, char* argv[]) {
         testComputedValues(0); // No cutoff
         testComputedValues(1); // Cutoff, periodic
         testComputedValues(2); // Interaction groups
+        testUpdateSomeParameters();
         runPlatformTests();
     }
     catch(const exception& e) {
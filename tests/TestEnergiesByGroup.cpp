@@ -0,0 +1,125 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 30;
+
+/**
+ * Compare the energies of all groups with the ones computed separately for each group.
+ */
+void checkEnergies(Context& context, int groups) {
+    vector<double> energies = context.computeEnergiesByGroup(groups);
+    ASSERT_EQUAL(32, energies.size());
+    for (int i = 0; i < 32; i++) {
+        if ((groups&(1<<i)) == 0) {
+            ASSERT_EQUAL(0.0, energies[i]);
+        }
+        else {
+            double expected = context.getState(State::Energy, false, 1<<i).getPotentialEnergy();
+            ASSERT_EQUAL_TOL(expected, energies[i], 1e-10);
+        }
+    }
+}
+
+void testEnergies(bool splitNonbonded) {
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+        positions.push_back(Vec3(3*genrand_real2(sfmt), 3*genrand_real2(sfmt), 3*genrand_real2(sfmt)));
+    }
+    for (int i = 0; i < numParticles-2; i += 3) {
+        bonds->addBond(i, i+1, 0.2, 1000.0);
+        bonds->addBond(i+1, i+2, 0.2, 1000.0);
+        angles->addAngle(i, i+1, i+2, 2.0, 100.0);
+        nonbonded->addException(i, i+1, 0.0, 1.0, 0.0);
+        nonbonded->addException(i+1, i+2, 0.0, 1.0, 0.0);
+        nonbonded->addException(i, i+2, 0.0, 1.0, 0.0);
+    }
+    bonds->setForceGroup(2);
+    angles->setForceGroup(5);
+    nonbonded->setForceGroup(7);
+    if (splitNonbonded)
+        nonbonded->setReciprocalSpaceForceGroup(9);
+    system.addForce(bonds);
+    system.addForce(angles);
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    checkEnergies(context, 0xFFFFFFFF);
+    checkEnergies(context, (1<<2) + (1<<7) + (1<<9));
+
+    // Computing the energies should not affect forces computed afterward.
+
+    State state1 = context.getState(State::Forces | State::Energy);
+    context.computeEnergiesByGroup();
+    State state2 = context.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-10);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-10);
+}
+
+int main() {
+    try {
+        testEnergies(false);
+        testEnergies(true);
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -31,10 +31,12 @@
 
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/Platform.h"
 #include "openmm/VerletIntegrator.h"
 #include "sfmt/SFMT.h"
+#include <cmath>
 #include <iostream>
 
 using namespace OpenMM;
@@ -91,9 +93,51 @@ void testTruncatedOctahedron() {
     ASSERT_EQUAL_TOL(initialEnergy, finalEnergy, 1e-4);
 }
 
+void testManyMolecules() {
+    // Use enough particles that the molecules are wrapped in parallel.
+
+    const int numMolecules = 60000;
+    const int numParticles = numMolecules*2;
+    Vec3 a(5, 0, 0);
+    Vec3 b(0, 6, 0);
+    Vec3 c(0, 0, 7);
+    System system;
+    system.setDefaultPeriodicBoxVectors(a, b, c);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        positions[2*i] = Vec3(30*genrand_real2(sfmt)-15, 30*genrand_real2(sfmt)-15, 30*genrand_real2(sfmt)-15);
+        positions[2*i+1] = positions[2*i] + Vec3(0.1, 0.0, 0.0);
+        bonds->addBond(2*i, 2*i+1, 0.1, 1000.0);
+    }
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    State state = context.getState(State::Positions, true);
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 pos1 = state.getPositions()[2*i];
+        Vec3 pos2 = state.getPositions()[2*i+1];
+        Vec3 center = (pos1+pos2)*0.5;
+        ASSERT(center[0] >= 0.0 && center[0] <= a[0]);
+        ASSERT(center[1] >= 0.0 && center[1] <= b[1]);
+        ASSERT(center[2] >= 0.0 && center[2] <= c[2]);
+        ASSERT_EQUAL_VEC(positions[2*i+1]-positions[2*i], pos2-pos1, 1e-6);
+        Vec3 shift = positions[2*i]-pos1;
+        ASSERT_EQUAL_TOL(shift[0]/a[0], round(shift[0]/a[0]), 1e-6);
+        ASSERT_EQUAL_TOL(shift[1]/b[1], round(shift[1]/b[1]), 1e-6);
+        ASSERT_EQUAL_TOL(shift[2]/c[2], round(shift[2]/c[2]), 1e-6);
+    }
+}
+
 int main(int argc, char* argv[]) {
     try {
         testTruncatedOctahedron();
+        testManyMolecules();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -372,6 +372,13 @@ void testErrorTolerance(NonbondedForce::NonbondedMethod method) {
                     ASSERT(actualSize[i] >= expectedSize[i]);
                     ASSERT(actualSize[i] < expectedSize[i]+10);
                 }
+
+                // The estimated errors for the selected parameters should be within the tolerance.
+
+                double directError, reciprocalError;
+                force->estimatePMEError(system, directError, reciprocalError);
+                ASSERT_EQUAL_TOL(tol, directError, 1e-5);
+                ASSERT(reciprocalError <= tol*(1+1e-5));
             }
         }
     }
@@ -425,6 +432,73 @@ void testPMEParameters() {
     ASSERT(fabs((energy1-energy2)/energy1) > 1e-5);
 }
 
+void testEstimatePMEError() {
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(4, 0, 0), Vec3(0, 4, 0), Vec3(0, 0, 4));
+    system.addParticle(1.0);
+    NonbondedForce force;
+    force.addParticle(1.0, 0.3, 1.0);
+    force.setCutoffDistance(1.0);
+    force.setEwaldErrorTolerance(1e-4);
+    double directError, reciprocalError;
+
+    // The estimates are only defined for PME and LJPME.
+
+    force.setNonbondedMethod(NonbondedForce::Ewald);
+    bool threwException = false;
+    try {
+        force.estimatePMEError(system, directError, reciprocalError);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    force.setNonbondedMethod(NonbondedForce::PME);
+    threwException = false;
+    try {
+        force.estimateLJPMEError(system, directError, reciprocalError);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    threwException = false;
+    try {
+        force.setPMEOrder(3);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // A higher order should need a smaller grid to reach the tolerance, and the estimate
+    // for the chosen parameters should still be within it.
+
+    int previousSize = 1000;
+    for (int order = 4; order <= 6; order++) {
+        force.setPMEOrder(order);
+        double alpha;
+        int size[3];
+        NonbondedForceImpl::calcPMEParameters(system, force, alpha, size[0], size[1], size[2], false);
+        ASSERT(size[0] < previousSize);
+        previousSize = size[0];
+        force.estimatePMEError(system, directError, reciprocalError);
+        ASSERT_EQUAL_TOL(1e-4, directError, 1e-5);
+        ASSERT(reciprocalError <= 1e-4*(1+1e-5));
+    }
+
+    // Explicitly specified parameters should give a larger error with a coarser grid.
+
+    force.setNonbondedMethod(NonbondedForce::LJPME);
+    force.setLJPMEParameters(3.0, 24, 24, 24);
+    double fineError, coarseError;
+    force.estimateLJPMEError(system, directError, fineError);
+    force.setLJPMEParameters(3.0, 12, 12, 12);
+    force.estimateLJPMEError(system, directError, coarseError);
+    ASSERT_EQUAL_TOL(0.5*exp(-9.0), directError, 1e-5);
+    ASSERT(coarseError > fineError);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -438,6 +512,7 @@ int main(int argc, char* argv[]) {
         testErrorTolerance(NonbondedForce::Ewald);
         testErrorTolerance(NonbondedForce::PME);
         testPMEParameters();
+        testEstimatePMEError();
         runPlatformTests();
     }
     catch(const exception& e) {
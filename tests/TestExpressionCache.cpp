@@ -0,0 +1,123 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ExpressionCache.h"
+#include "lepton/Parser.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OpenMM;
+using namespace Lepton;
+using namespace std;
+
+void testCachedExpressions() {
+    string expression = "k*(r-r0)^2+sin(r*k)";
+    ParsedExpression expected = Parser::parse(expression).optimize();
+    ParsedExpression expectedDeriv = Parser::parse(expression).differentiate("r").optimize();
+    map<string, double> variables;
+    variables["k"] = 1.5;
+    variables["r"] = 0.7;
+    variables["r0"] = 0.2;
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQUAL_TOL(expected.evaluate(variables), ExpressionCache::getExpression(expression).evaluate(variables), 1e-10);
+        ASSERT_EQUAL_TOL(expectedDeriv.evaluate(variables), ExpressionCache::getDerivative(expression, "r").evaluate(variables), 1e-10);
+    }
+    ASSERT_EQUAL_TOL(Parser::parse(expression).differentiate("k").optimize().evaluate(variables), ExpressionCache::getDerivative(expression, "k").evaluate(variables), 1e-10);
+}
+
+void testInvalidExpression() {
+    for (int i = 0; i < 2; i++) {
+        bool threwException = false;
+        try {
+            ExpressionCache::getExpression("x+*y");
+        }
+        catch (const exception& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+    }
+}
+
+void testMultipleThreads() {
+    const int numThreads = 4;
+    vector<double> results(numThreads);
+    vector<thread> threads;
+    for (int i = 0; i < numThreads; i++)
+        threads.push_back(thread([&results, i] () {
+            map<string, double> variables;
+            variables["x"] = 2.0;
+            results[i] = ExpressionCache::getDerivative("x^3+exp(x)", "x").evaluate(variables);
+        }));
+    for (thread& t : threads)
+        t.join();
+    for (int i = 0; i < numThreads; i++)
+        ASSERT_EQUAL_TOL(12.0+exp(2.0), results[i], 1e-10);
+}
+
+void testCacheSize() {
+    ExpressionCache::clearCache();
+    ASSERT_EQUAL(0, ExpressionCache::getCacheSize());
+    ExpressionCache::getDerivative("x^2", "x");
+    ASSERT_EQUAL(2, ExpressionCache::getCacheSize());
+    ExpressionCache::clearCache();
+    ASSERT_EQUAL(0, ExpressionCache::getCacheSize());
+
+    // Old entries should be discarded once the cache is full, while every result is still correct.
+
+    map<string, double> variables;
+    variables["x"] = 2.0;
+    for (int i = 0; i < 1500; i++) {
+        string expression = "x+"+to_string(i);
+        ASSERT_EQUAL_TOL(2.0+i, ExpressionCache::getExpression(expression).evaluate(variables), 1e-10);
+        ASSERT_EQUAL_TOL(1.0, ExpressionCache::getDerivative(expression, "x").evaluate(variables), 1e-10);
+    }
+    ASSERT_EQUAL(2000, ExpressionCache::getCacheSize());
+    ExpressionCache::clearCache();
+}
+
+int main() {
+    try {
+        testCachedExpressions();
+        testInvalidExpression();
+        testMultipleThreads();
+        testCacheSize();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,148 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/ExternalForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * A Computation that applies a harmonic restraint pulling every particle toward the origin.  It
+ * only supports host memory, so these tests can only be run on platforms that pass host arrays.
+ */
+class HarmonicComputation : public ExternalForce::Computation {
+public:
+    HarmonicComputation(double k) : k(k), numCalls(0) {
+    }
+    double compute(const ExternalForce::ComputeData& data) {
+        numCalls++;
+        if (data.isDeviceMemory || !data.isDoublePrecision)
+            throw OpenMMException("HarmonicComputation only supports host arrays of doubles");
+        const double* pos = (const double*) data.positions;
+        double* forces = (double*) data.forces;
+        double energy = 0.0;
+        for (int i = 0; i < data.numParticles; i++) {
+            for (int j = 0; j < 3; j++) {
+                double x = pos[data.stride*i+j];
+                energy += 0.5*k*x*x;
+                if (data.includeForces)
+                    forces[data.stride*i+j] = -k*x;
+            }
+        }
+        return energy;
+    }
+    double k;
+    int numCalls;
+};
+
+void testHarmonicRestraint() {
+    const int numParticles = 10;
+    const double k = 2.5;
+    System system;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    HarmonicComputation* computation = new HarmonicComputation(k);
+    ExternalForce* external = new ExternalForce(computation);
+    system.addForce(external);
+
+    // Add an equivalent CustomExternalForce in a different force group, so we can compare them.
+
+    CustomExternalForce* custom = new CustomExternalForce("0.5*k*(x^2+y^2+z^2)");
+    custom->addGlobalParameter("k", k);
+    for (int i = 0; i < numParticles; i++)
+        custom->addParticle(i);
+    custom->setForceGroup(1);
+    system.addForce(custom);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    State state1 = context.getState(State::Forces | State::Energy, false, 1<<0);
+    State state2 = context.getState(State::Forces | State::Energy, false, 1<<1);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-5);
+
+    // The Computation should not be called when its force group is excluded.
+
+    int numCalls = computation->numCalls;
+    context.getState(State::Energy, false, 1<<1);
+    ASSERT_EQUAL(numCalls, computation->numCalls);
+
+    // Take a few steps and make sure it still agrees.
+
+    integrator.step(10);
+    state1 = context.getState(State::Forces | State::Energy, false, 1<<0);
+    state2 = context.getState(State::Forces | State::Energy, false, 1<<1);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-5);
+}
+
+void testNullComputation() {
+    bool threwException = false;
+    try {
+        ExternalForce force(NULL);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testHarmonicRestraint();
+        testNullComputation();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,239 @@
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/FIREMinimizer.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testHarmonicBonds() {
+    const int numParticles = 10;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+
+    // Create a chain of particles connected by harmonic bonds.
+
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        positions[i] = Vec3(i, 0, 0);
+        if (i > 0)
+            bonds->addBond(i-1, i, 1+0.1*i, 1000);
+    }
+
+    // Minimize it and check that all bonds are at their equilibrium distances.
+
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    FIREMinimizer::minimize(context, 1e-3);
+    State state = context.getState(State::Positions);
+    for (int i = 1; i < numParticles; i++) {
+        Vec3 delta = state.getPositions()[i]-state.getPositions()[i-1];
+        ASSERT_EQUAL_TOL(1+0.1*i, sqrt(delta.dot(delta)), 1e-4);
+    }
+}
+
+void testConstraints() {
+    const int numMolecules = 25;
+    const int numParticles = numMolecules*2;
+    const double cutoff = 2.0;
+    const double boxSize = 4.0;
+    const double tolerance = 5;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setCutoffDistance(cutoff);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    system.addForce(nonbonded);
+
+    // Create a cloud of molecules.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(2.0);
+        nonbonded->addParticle(-1.0, 0.2, 0.2);
+        nonbonded->addParticle(1.0, 0.2, 0.2);
+        positions[2*i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions[2*i+1] = Vec3(positions[2*i][0]+1.0, positions[2*i][1], positions[2*i][2]);
+        system.addConstraint(2*i, 2*i+1, 1.0);
+    }
+
+    // Minimize it and verify that the energy has decreased and the constraints are satisfied.
+
+    VerletIntegrator integrator(0.01);
+    integrator.setConstraintTolerance(1e-6);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocities(vector<Vec3>(numParticles, Vec3(1, 2, 3)));
+    State initialState = context.getState(State::Forces | State::Energy);
+    FIREMinimizer::minimize(context, tolerance);
+    State finalState = context.getState(State::Forces | State::Energy | State::Positions | State::Velocities);
+    ASSERT(finalState.getPotentialEnergy() < initialState.getPotentialEnergy());
+    for (int i = 0; i < numParticles; i += 2) {
+        Vec3 delta = finalState.getPositions()[i+1]-finalState.getPositions()[i];
+        ASSERT_EQUAL_TOL(1.0, sqrt(delta.dot(delta)), 1e-5);
+    }
+
+    // The velocities should not have been modified.
+
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(Vec3(1, 2, 3), finalState.getVelocities()[i], 1e-6);
+
+    // Compute the force magnitude, subtracting off any component parallel to a constraint, and
+    // check that it satisfies the requested tolerance.  Since the masses differ, the projection
+    // must be mass weighted.
+
+    double forceNorm = 0.0;
+    for (int i = 0; i < numParticles; i += 2) {
+        Vec3 dir = finalState.getPositions()[i+1]-finalState.getPositions()[i];
+        dir *= 1.0/sqrt(dir.dot(dir));
+        Vec3 f1 = finalState.getForces()[i];
+        Vec3 f2 = finalState.getForces()[i+1];
+        double m1 = system.getParticleMass(i), m2 = system.getParticleMass(i+1);
+        double lambda = dir.dot(f2*(1/m2)-f1*(1/m1))/(1/m1+1/m2);
+        f1 += dir*lambda;
+        f2 -= dir*lambda;
+        forceNorm += f1.dot(f1)+f2.dot(f2);
+    }
+    forceNorm = sqrt(forceNorm/(3*numParticles));
+    ASSERT(forceNorm <= tolerance*1.01);
+}
+
+void testLargeForces() {
+    // Create a cluster of Lennard-Jones particles that are almost on top of each other so
+    // the initial forces are huge.
+
+    const int numParticles = 10;
+    const double maxDisplacement = 0.02;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(0.0, 0.2, 1.0);
+    }
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*1e-3;
+
+    // A single iteration should never move a particle farther than the limit.
+
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    FIREMinimizer::minimize(context, 1.0, 1, maxDisplacement);
+    State state = context.getState(State::Positions);
+    for (int i = 0; i < numParticles; i++) {
+        Vec3 delta = state.getPositions()[i]-positions[i];
+        ASSERT(sqrt(delta.dot(delta)) <= maxDisplacement*(1+1e-6));
+    }
+
+    // Minimize it fully and verify that it didn't blow up.  Every particle should end up
+    // near the Lennard-Jones minimum distance from its nearest neighbor.
+
+    FIREMinimizer::minimize(context, 1.0);
+    state = context.getState(State::Positions);
+    for (int i = 0; i < numParticles; i++) {
+        double minDist = 1e10;
+        for (int j = 0; j < numParticles; j++) {
+            if (j != i) {
+                Vec3 delta = state.getPositions()[i]-state.getPositions()[j];
+                minDist = min(minDist, sqrt(delta.dot(delta)));
+            }
+        }
+        ASSERT(minDist > 0.18);
+        ASSERT(minDist < 0.3);
+    }
+}
+
+void testForceGroups() {
+    // Create a system with two forces, only one of which is in the standard
+    // integration force groups.
+
+    System system;
+    system.addParticle(1.0);
+    system.addParticle(1.0);
+    HarmonicBondForce* bonds1 = new HarmonicBondForce();
+    HarmonicBondForce* bonds2 = new HarmonicBondForce();
+    system.addForce(bonds1);
+    system.addForce(bonds2);
+    bonds1->addBond(0, 1, 2.0, 1000);
+    bonds2->addBond(0, 1, 4.0, 1000);
+    bonds1->setForceGroup(1);
+    bonds2->setForceGroup(2);
+
+    // Minimize it and check that the bond has the correct length.
+
+    VerletIntegrator integrator(0.01);
+    integrator.setIntegrationForceGroups(1<<1);
+    Context context(system, integrator, platform);
+    context.setPositions({Vec3(0, 0, 0), Vec3(5, 0, 0)});
+    FIREMinimizer::minimize(context, 1e-3);
+    State state = context.getState(State::Positions);
+    Vec3 delta = state.getPositions()[0]-state.getPositions()[1];
+    ASSERT_EQUAL_TOL(2.0, sqrt(delta.dot(delta)), 1e-4);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testHarmonicBonds();
+        testConstraints();
+        testLargeForces();
+        testForceGroups();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
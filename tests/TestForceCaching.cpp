@@ -0,0 +1,298 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/ExternalForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/ForceImpl.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * A Force that contributes no energy and only counts how many times it has been evaluated.
+ */
+class CountingForce : public Force {
+public:
+    CountingForce() : numCalls(0) {
+    }
+    mutable int numCalls;
+protected:
+    ForceImpl* createImpl() const;
+};
+
+class CountingForceImpl : public ForceImpl {
+public:
+    CountingForceImpl(const CountingForce& owner) : owner(owner) {
+    }
+    void initialize(ContextImpl& context) {
+    }
+    const Force& getOwner() const {
+        return owner;
+    }
+    void updateContextState(ContextImpl& context, bool& forcesInvalid) {
+    }
+    double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
+        if ((groups&(1<<owner.getForceGroup())) != 0 && (includeForces || includeEnergy))
+            owner.numCalls++;
+        return 0.0;
+    }
+    map<string, double> getDefaultParameters() {
+        return map<string, double>();
+    }
+    vector<string> getKernelNames() {
+        return vector<string>();
+    }
+private:
+    const CountingForce& owner;
+};
+
+ForceImpl* CountingForce::createImpl() const {
+    return new CountingForceImpl(*this);
+}
+
+/**
+ * A Computation whose energy depends on a value stored outside the Context.
+ */
+class ExternalStateComputation : public ExternalForce::Computation {
+public:
+    ExternalStateComputation() : value(1.0) {
+    }
+    double compute(const ExternalForce::ComputeData& data) {
+        return value;
+    }
+    double value;
+};
+
+void testCaching() {
+    const int numParticles = 4;
+    System system;
+    vector<Vec3> positions;
+    CustomExternalForce* custom = new CustomExternalForce("k*x^2");
+    custom->addGlobalParameter("k", 1.0);
+    custom->addPerParticleParameter("scale");
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        custom->addParticle(i, {1.0});
+        positions.push_back(Vec3(0.1*i, 0, 0));
+    }
+    system.addForce(custom);
+    CountingForce* computation = new CountingForce();
+    computation->setForceGroup(1);
+    system.addForce(computation);
+
+    // Use an integrator whose kinetic energy does not depend on the forces, so an energy query
+    // computes only the energy.
+
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    ASSERT(context.getForceCachingEnabled());
+
+    // Repeating a query should reuse the results.
+
+    double energy = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL(1, computation->numCalls);
+    ASSERT_EQUAL_TOL(energy, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+    ASSERT_EQUAL(1, computation->numCalls);
+
+    // Asking for forces when only the energy was computed, or for different groups, requires a new computation.
+
+    State state = context.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL(2, computation->numCalls);
+    ASSERT_EQUAL_TOL(energy, state.getPotentialEnergy(), 1e-10);
+    context.getState(State::Energy);
+    context.getState(State::Forces);
+    ASSERT_EQUAL(2, computation->numCalls);
+    context.getState(State::Energy, false, 1<<1);
+    ASSERT_EQUAL(3, computation->numCalls);
+    context.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL(4, computation->numCalls);
+    ASSERT_EQUAL_VEC(state.getForces()[1], context.getState(State::Forces).getForces()[1], 1e-10);
+    ASSERT_EQUAL(4, computation->numCalls);
+
+    // Changing anything that affects the forces should discard the cache.
+
+    context.setPositions(positions);
+    context.getState(State::Energy);
+    ASSERT_EQUAL(5, computation->numCalls);
+    context.setParameter("k", 2.0);
+    ASSERT_EQUAL_TOL(2*energy, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+    ASSERT_EQUAL(6, computation->numCalls);
+    custom->setParticleParameters(0, 0, {3.0});
+    custom->updateParametersInContext(context);
+    context.getState(State::Energy);
+    ASSERT_EQUAL(7, computation->numCalls);
+    context.setPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    context.getState(State::Energy);
+    ASSERT_EQUAL(8, computation->numCalls);
+    integrator.step(1);
+    int numCalls = computation->numCalls;
+    energy = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL(numCalls+1, computation->numCalls);
+    context.setStepCount(0);
+    context.getState(State::Energy);
+    ASSERT_EQUAL(numCalls+2, computation->numCalls);
+
+    // When caching is disabled, every query should compute the forces.
+
+    context.setForceCachingEnabled(false);
+    ASSERT(!context.getForceCachingEnabled());
+    context.getState(State::Energy);
+    context.getState(State::Energy);
+    ASSERT_EQUAL(numCalls+4, computation->numCalls);
+}
+
+/**
+ * A Force that computes the energy in updateContextState(), the way a Monte Carlo barostat does.
+ */
+class EnergyCheckingForce : public Force {
+public:
+    EnergyCheckingForce() : energy(0.0) {
+    }
+    mutable double energy;
+protected:
+    ForceImpl* createImpl() const;
+};
+
+class EnergyCheckingForceImpl : public ForceImpl {
+public:
+    EnergyCheckingForceImpl(const EnergyCheckingForce& owner) : owner(owner) {
+    }
+    void initialize(ContextImpl& context) {
+    }
+    const Force& getOwner() const {
+        return owner;
+    }
+    void updateContextState(ContextImpl& context, bool& forcesInvalid) {
+        owner.energy = context.calcForcesAndEnergyCached(false, true);
+    }
+    double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
+        return 0.0;
+    }
+    map<string, double> getDefaultParameters() {
+        return map<string, double>();
+    }
+    vector<string> getKernelNames() {
+        return vector<string>();
+    }
+private:
+    const EnergyCheckingForce& owner;
+};
+
+ForceImpl* EnergyCheckingForce::createImpl() const {
+    return new EnergyCheckingForceImpl(*this);
+}
+
+void testUpdateContextStateAfterMove() {
+    // A CustomIntegrator can move particles and then update the context state within the same step.
+    // Forces that compute the energy at that point must not get results cached before the move.
+
+    System system;
+    system.addParticle(1.0);
+    CustomExternalForce* custom = new CustomExternalForce("x^2");
+    custom->addParticle(0);
+    system.addForce(custom);
+    EnergyCheckingForce* checker = new EnergyCheckingForce();
+    system.addForce(checker);
+    CustomIntegrator integrator(0.001);
+    integrator.addComputePerDof("x", "x+1");
+    integrator.addUpdateContextState();
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions({Vec3(1, 0, 0)});
+    ASSERT_EQUAL_TOL(1.0, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+    integrator.step(1);
+    ASSERT_EQUAL_TOL(4.0, checker->energy, 1e-10);
+}
+
+void testLoadCheckpoint() {
+    // Loading a checkpoint saved at the same step but with different positions should discard the cache.
+
+    System system;
+    system.addParticle(1.0);
+    CustomExternalForce* custom = new CustomExternalForce("x^2");
+    custom->addParticle(0);
+    system.addForce(custom);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions({Vec3(1, 0, 0)});
+    stringstream checkpoint;
+    context.createCheckpoint(checkpoint);
+    context.setPositions({Vec3(2, 0, 0)});
+    State state = context.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(4.0, state.getPotentialEnergy(), 1e-10);
+    ASSERT_EQUAL_VEC(Vec3(-4, 0, 0), state.getForces()[0], 1e-10);
+    context.loadCheckpoint(checkpoint);
+    ASSERT_EQUAL(0, context.getStepCount());
+    state = context.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(1.0, state.getPotentialEnergy(), 1e-10);
+    ASSERT_EQUAL_VEC(Vec3(-2, 0, 0), state.getForces()[0], 1e-10);
+}
+
+void testExternalForceNotCached() {
+    // An ExternalForce may depend on state the Context cannot see, so its results should never be reused.
+
+    System system;
+    system.addParticle(1.0);
+    ExternalStateComputation* computation = new ExternalStateComputation();
+    system.addForce(new ExternalForce(computation));
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions({Vec3()});
+    ASSERT_EQUAL_TOL(1.0, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+    computation->value = 2.0;
+    ASSERT_EQUAL_TOL(2.0, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testCaching();
+        testUpdateContextStateAfterMove();
+        testLoadCheckpoint();
+        testExternalForceNotCached();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,182 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/ForceValidator.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create a box of charged particles with bonds between pairs of them.  The bonds are in force group 0,
+ * the direct space nonbonded interactions in group 1, and reciprocal space in group 2.
+ */
+void createSystem(System& system, vector<Vec3>& positions, double ewaldTolerance) {
+    const int numParticles = 200;
+    const double boxSize = 2.5;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setEwaldErrorTolerance(ewaldTolerance);
+    nonbonded->setForceGroup(1);
+    nonbonded->setReciprocalSpaceForceGroup(2);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    positions.clear();
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 1.0 : -1.0, 0.3, 0.5);
+        positions.push_back(Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt)));
+        if (i%2 == 1) {
+            bonds->addBond(i-1, i, 0.2, 1000.0);
+            nonbonded->addException(i-1, i, 0.0, 1.0, 0.0);
+            positions[i] = positions[i-1]+Vec3(0.15, 0.0, 0.0);
+        }
+    }
+}
+
+void testSameSystem() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions, 5e-4);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    ForceValidator validator;
+    validator.setNumRepetitions(2);
+    const vector<ForceValidator::GroupResult>& results = validator.validate(context);
+
+    // Both calculations are done with the Reference platform, so they should agree exactly.
+
+    ASSERT_EQUAL(4, results.size());
+    ASSERT_EQUAL(results.size(), validator.getResults().size());
+    for (int i = 0; i < results.size(); i++) {
+        ASSERT_EQUAL(i-1, results[i].group);
+        ASSERT(results[i].rmsError < 1e-10);
+        ASSERT(results[i].maxError < 1e-10);
+        ASSERT_EQUAL_TOL(results[i].referenceEnergy, results[i].energy, 1e-10);
+        ASSERT(results[i].time > 0.0);
+        ASSERT(results[i].referenceTime > 0.0);
+    }
+    State state = context.getState(State::Energy, false, 1<<1);
+    ASSERT_EQUAL_TOL(state.getPotentialEnergy(), results[2].energy, 1e-10);
+    ASSERT(validator.getReport().find("All") != string::npos);
+
+    // Timing can be disabled.
+
+    validator.setNumRepetitions(0);
+    validator.validate(context);
+    ASSERT_EQUAL(0.0, validator.getResults()[0].time);
+    ASSERT_EQUAL(0.0, validator.getResults()[0].referenceTime);
+}
+
+void testReferenceSystem() {
+    // Compare PME with a loose error tolerance to a more accurate calculation.  The total force should
+    // reflect the difference in accuracy, while the bonds are unaffected.
+
+    System system, looseSystem, referenceSystem;
+    vector<Vec3> positions;
+    createSystem(system, positions, 5e-4);
+    createSystem(looseSystem, positions, 1e-2);
+    createSystem(referenceSystem, positions, 1e-6);
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    Context context(system, integrator1, Platform::getPlatformByName("Reference"));
+    Context looseContext(looseSystem, integrator2, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    looseContext.setPositions(positions);
+    ForceValidator validator;
+    validator.setNumRepetitions(1);
+    vector<ForceValidator::GroupResult> results = validator.validate(context, referenceSystem);
+    vector<ForceValidator::GroupResult> looseResults = validator.validate(looseContext, referenceSystem);
+    ASSERT(results[0].rmsError > 0.0);
+    ASSERT(results[0].rmsError < 1e-2);
+    ASSERT(results[0].maxError >= results[0].rmsError);
+    ASSERT(looseResults[0].rmsError > results[0].rmsError);
+    ASSERT(results[1].rmsError < 1e-10);
+    ASSERT(looseResults[1].rmsError < 1e-10);
+}
+
+void testErrors() {
+    System system, otherSystem;
+    vector<Vec3> positions;
+    createSystem(system, positions, 5e-4);
+    otherSystem.addParticle(1.0);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    ForceValidator validator;
+    bool threwException = false;
+    try {
+        validator.validate(context, otherSystem);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    threwException = false;
+    try {
+        validator.setNumRepetitions(-1);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testSameSystem();
+        testReferenceSystem();
+        testErrors();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
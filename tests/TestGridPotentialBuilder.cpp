@@ -0,0 +1,198 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/GridPotentialBuilder.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numFrozen = 40;
+const int numMobile = 4;
+
+/**
+ * Build a System with frozen particles around the edges of a box and mobile particles near its center.
+ */
+void createSystem(System& system, NonbondedForce* nonbonded, vector<Vec3>& positions) {
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    system.addForce(nonbonded);
+    for (int i = 0; i < numFrozen; i++) {
+        system.addParticle(0.0);
+        nonbonded->addParticle(0.5*genrand_real2(sfmt)-0.25, 0.25+0.1*genrand_real2(sfmt), 0.5+0.5*genrand_real2(sfmt));
+
+        // Place the particle on the surface of a cube, at least 0.4 nm from the center.
+
+        Vec3 pos(2*genrand_real2(sfmt)-1, 2*genrand_real2(sfmt)-1, 2*genrand_real2(sfmt)-1);
+        pos[i%3] = (pos[i%3] < 0 ? -1 : 1);
+        positions.push_back(pos*0.8);
+    }
+    double mobileSigma[] = {0.3, 0.35, 0.3, 0.32};
+    double mobileCharge[] = {0.4, -0.3, 0.2, 0.0};
+    for (int i = 0; i < numMobile; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(mobileCharge[i], mobileSigma[i], 0.6+0.1*i);
+        positions.push_back(Vec3(0.1*i-0.15, 0.05*i, 0.1-0.08*i));
+    }
+}
+
+/**
+ * Compare the grid potential to the interaction computed by the NonbondedForce.  With a cutoff, the force has
+ * a kink at the cutoff distance that the spline smooths out, so forces can only be compared approximately.
+ */
+void testInteraction(NonbondedForce::NonbondedMethod method, bool useSwitch, double forceTol) {
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(0.9);
+    nonbonded->setUseSwitchingFunction(useSwitch);
+    nonbonded->setSwitchingDistance(0.7);
+    vector<Vec3> positions;
+    createSystem(system, nonbonded, positions);
+
+    // Compute the interaction between the frozen and mobile particles as the difference between the full System
+    // and one where exceptions remove every interaction between the two groups.
+
+    vector<int> frozen, mobile;
+    for (int i = 0; i < numFrozen; i++)
+        frozen.push_back(i);
+    for (int i = 0; i < numMobile; i++)
+        mobile.push_back(numFrozen+i);
+    VerletIntegrator integrator1(0.001);
+    Context context1(system, integrator1, Platform::getPlatformByName("Reference"));
+    context1.setPositions(positions);
+    State state1 = context1.getState(State::Energy | State::Forces);
+    double mobileEnergy;
+    vector<Vec3> mobileForces;
+    {
+        System system2;
+        NonbondedForce* copy = new NonbondedForce(*nonbonded);
+        for (int i = 0; i < system.getNumParticles(); i++)
+            system2.addParticle(system.getParticleMass(i));
+        for (int i = 0; i < numFrozen; i++)
+            for (int j = 0; j < numMobile; j++)
+                copy->addException(i, numFrozen+j, 0.0, 1.0, 0.0);
+        system2.addForce(copy);
+        VerletIntegrator integrator2(0.001);
+        Context context2(system2, integrator2, Platform::getPlatformByName("Reference"));
+        context2.setPositions(positions);
+        State state2 = context2.getState(State::Energy | State::Forces);
+        mobileEnergy = state2.getPotentialEnergy();
+        mobileForces = state2.getForces();
+    }
+    double expectedEnergy = state1.getPotentialEnergy()-mobileEnergy;
+
+    // Create a System containing only the mobile particles, with the grid potential.
+
+    GridPotentialBuilder builder(system, frozen);
+    builder.setGridSpacing(0.02);
+    System mobileSystem;
+    for (int i = 0; i < numMobile; i++)
+        mobileSystem.addParticle(1.0);
+    mobileSystem.addForce(builder.createForce(positions, Vec3(-0.4, -0.4, -0.4), Vec3(0.4, 0.4, 0.4), mobile));
+    vector<Vec3> mobilePositions(positions.begin()+numFrozen, positions.end());
+    VerletIntegrator integrator3(0.001);
+    Context context3(mobileSystem, integrator3, Platform::getPlatformByName("Reference"));
+    context3.setPositions(mobilePositions);
+    State state3 = context3.getState(State::Energy | State::Forces);
+    ASSERT_EQUAL_TOL(expectedEnergy, state3.getPotentialEnergy(), 1e-4);
+    for (int i = 0; i < numMobile; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[numFrozen+i]-mobileForces[numFrozen+i], state3.getForces()[i], forceTol);
+}
+
+void testErrors() {
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    createSystem(system, nonbonded, positions);
+    vector<int> frozen(1, 0);
+    GridPotentialBuilder builder(system, frozen);
+
+    // A particle cannot be both frozen and mobile.
+
+    vector<int> mobile(1, 0);
+    bool threwException = false;
+    try {
+        delete builder.createForce(positions, Vec3(-1, -1, -1), Vec3(1, 1, 1), mobile);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // Exceptions between frozen and mobile particles are not allowed.
+
+    nonbonded->addException(0, numFrozen, 0.0, 1.0, 0.0);
+    mobile[0] = numFrozen;
+    threwException = false;
+    try {
+        delete builder.createForce(positions, Vec3(-1, -1, -1), Vec3(1, 1, 1), mobile);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // Periodic nonbonded methods are not supported.
+
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    threwException = false;
+    try {
+        GridPotentialBuilder builder2(system, frozen);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main() {
+    try {
+        testInteraction(NonbondedForce::NoCutoff, false, 1e-3);
+        testInteraction(NonbondedForce::CutoffNonPeriodic, true, 2e-2);
+        testErrors();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,290 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/MTSLangevinIntegrator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VirtualSite.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Build the same algorithm as a CustomIntegrator to compare against.
+ */
+void addSubsteps(CustomIntegrator& integrator, int parentSubsteps, const vector<pair<int, int> >& groups, int level) {
+    int group = groups[level].first;
+    int substeps = groups[level].second;
+    stringstream kick, drift, correct;
+    kick << "v+0.5*(dt/" << substeps << ")*f" << group << "/m";
+    drift << "x+(dt/" << (2*substeps) << ")*v";
+    correct << "v+(x-x1)/(dt/" << substeps << ")";
+    for (int i = 0; i < substeps/parentSubsteps; i++) {
+        integrator.addComputePerDof("v", kick.str());
+        if (level == groups.size()-1) {
+            integrator.addComputePerDof("x", drift.str());
+            integrator.addComputePerDof("v", "a*v + b*sqrt(kT/m)*gaussian");
+            integrator.addComputePerDof("x", drift.str());
+            integrator.addComputePerDof("x1", "x");
+            integrator.addConstrainPositions();
+            integrator.addComputePerDof("v", correct.str());
+            integrator.addConstrainVelocities();
+        }
+        else
+            addSubsteps(integrator, substeps, groups, level+1);
+        integrator.addComputePerDof("v", kick.str());
+    }
+}
+
+System* createChains(vector<Vec3>& positions) {
+    // Chains of particles with stiff bonds in group 0, softer bonds in group 1, and a weak
+    // external force in group 2.  One bond in each chain is constrained.
+
+    System* system = new System();
+    HarmonicBondForce* stiff = new HarmonicBondForce();
+    HarmonicBondForce* soft = new HarmonicBondForce();
+    CustomExternalForce* external = new CustomExternalForce("0.5*(x^2+y^2+z^2)");
+    soft->setForceGroup(1);
+    external->setForceGroup(2);
+    system->addForce(stiff);
+    system->addForce(soft);
+    system->addForce(external);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            int index = system->addParticle(j == 0 ? 0.0 : 1.0+j);
+            positions.push_back(Vec3(0.11*j, 0.5*i, 0.02*(j%2)));
+            external->addParticle(index);
+            if (j > 1)
+                stiff->addBond(index-1, index, 0.1, 5000.0);
+            if (j > 2)
+                soft->addBond(index-2, index, 0.2, 100.0);
+        }
+        system->addConstraint(4*i+1, 4*i+2, 0.1);
+    }
+    system->setVirtualSite(0, new TwoParticleAverageSite(1, 2, 0.5, 0.5));
+    for (int i = 1; i < 4; i++)
+        system->setVirtualSite(4*i, new TwoParticleAverageSite(4*i+1, 4*i+2, 0.5, 0.5));
+    return system;
+}
+
+void testCompareToCustomIntegrator() {
+    // At zero temperature the trajectory is deterministic, so it should match a CustomIntegrator
+    // implementing the same algorithm.
+
+    vector<Vec3> positions;
+    System* system = createChains(positions);
+    vector<pair<int, int> > groups;
+    groups.push_back(make_pair(0, 4));
+    groups.push_back(make_pair(2, 1));
+    groups.push_back(make_pair(1, 2));
+    const double dt = 0.004, friction = 5.0;
+    MTSLangevinIntegrator integrator(0.0, friction, dt, groups);
+    CustomIntegrator custom(dt);
+    custom.addGlobalVariable("a", exp(-friction*dt/4));
+    custom.addGlobalVariable("b", sqrt(1-exp(-2*friction*dt/4)));
+    custom.addGlobalVariable("kT", 0.0);
+    custom.addPerDofVariable("x1", 0);
+    custom.addUpdateContextState();
+    addSubsteps(custom, 1, integrator.getGroups(), 0);
+    custom.addConstrainVelocities();
+    ASSERT_EQUAL(2, integrator.getGroups()[0].first);
+    ASSERT_EQUAL(1, integrator.getGroups()[1].first);
+    ASSERT_EQUAL(0, integrator.getGroups()[2].first);
+    Context context1(*system, integrator, platform);
+    Context context2(*system, custom, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context1.applyConstraints(1e-6);
+    context2.applyConstraints(1e-6);
+    for (int i = 0; i < 10; i++) {
+        integrator.step(5);
+        custom.step(5);
+        State state1 = context1.getState(State::Positions | State::Velocities);
+        State state2 = context2.getState(State::Positions | State::Velocities);
+        ASSERT_EQUAL_TOL(state2.getTime(), state1.getTime(), 1e-6);
+        for (int j = 0; j < system->getNumParticles(); j++) {
+            ASSERT_EQUAL_VEC(state2.getPositions()[j], state1.getPositions()[j], 1e-4);
+            ASSERT_EQUAL_VEC(state2.getVelocities()[j], state1.getVelocities()[j], 1e-3);
+        }
+    }
+    delete system;
+}
+
+void testFriction() {
+    // A free particle should lose velocity at the rate set by the friction, regardless of
+    // the number of substeps.
+
+    System system;
+    system.addParticle(12.0);
+    const double friction = 1.0, dt = 0.004;
+    const int numSteps = 125;
+    for (int substeps = 1; substeps < 5; substeps++) {
+        vector<pair<int, int> > groups(1, make_pair(0, substeps));
+        MTSLangevinIntegrator integrator(0.0, friction, dt, groups);
+        Context context(system, integrator, platform);
+        context.setPositions(vector<Vec3>(1));
+        context.setVelocities(vector<Vec3>(1, Vec3(1, 0, 0)));
+        integrator.step(numSteps);
+        State state = context.getState(State::Velocities);
+        ASSERT_EQUAL_VEC(Vec3(exp(-friction*dt*numSteps), 0, 0), state.getVelocities()[0], 1e-5);
+        ASSERT_EQUAL_TOL(dt*numSteps, state.getTime(), 1e-6);
+    }
+}
+
+void testTemperature() {
+    const int numParticles = 8;
+    const double temp = 100.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(5, 0, 0), Vec3(0, 5, 0), Vec3(0, 0, 5));
+    vector<pair<int, int> > groups;
+    groups.push_back(make_pair(0, 1));
+    groups.push_back(make_pair(1, 2));
+    MTSLangevinIntegrator integrator(temp, 3.0, 0.01, groups);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setForceGroup(1);
+    for (int i = 0; i < numParticles; ++i) {
+        system.addParticle(2.0);
+        nonbonded->addParticle((i%2 == 0 ? 1.0 : -1.0), 1.0, 5.0);
+    }
+    for (int i = 0; i < numParticles; i += 2)
+        bonds->addBond(i, i+1, 4.0, 10.0);
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        positions[i] = Vec3((i%2 == 0 ? 2 : -2), (i%4 < 2 ? 2 : -2), (i < 4 ? 2 : -2));
+    context.setPositions(positions);
+    
+    // Let it equilibrate.
+    
+    integrator.step(2000);
+    
+    // Now run it for a while and see if the temperature is correct.
+    
+    double ke = 0.0;
+    int steps = 5000;
+    for (int i = 0; i < steps; ++i) {
+        State state = context.getState(State::Energy);
+        ke += state.getKineticEnergy();
+        integrator.step(1);
+    }
+    ke /= steps;
+    double expected = 0.5*numParticles*3*BOLTZ*temp;
+    ASSERT_USUALLY_EQUAL_TOL(expected, ke, 6/std::sqrt((double) steps));
+}
+
+void testConstraints() {
+    vector<Vec3> positions;
+    System* system = createChains(positions);
+    vector<pair<int, int> > groups;
+    groups.push_back(make_pair(0, 4));
+    groups.push_back(make_pair(1, 2));
+    groups.push_back(make_pair(2, 1));
+    MTSLangevinIntegrator integrator(300.0, 2.0, 0.004, groups);
+    integrator.setConstraintTolerance(1e-5);
+    Context context(*system, integrator, platform);
+    context.setPositions(positions);
+    context.applyConstraints(1e-5);
+    context.setVelocitiesToTemperature(300.0);
+
+    // Simulate it and see whether the constraints remain satisfied.
+
+    for (int i = 0; i < 200; ++i) {
+        integrator.step(1);
+        State state = context.getState(State::Positions | State::Velocities);
+        for (int j = 0; j < system->getNumConstraints(); ++j) {
+            int particle1, particle2;
+            double distance;
+            system->getConstraintParameters(j, particle1, particle2, distance);
+            Vec3 delta = state.getPositions()[particle1]-state.getPositions()[particle2];
+            Vec3 dv = state.getVelocities()[particle1]-state.getVelocities()[particle2];
+            ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-4);
+            ASSERT_EQUAL_TOL(0.0, delta.dot(dv), 1e-3);
+        }
+    }
+    delete system;
+}
+
+void testInvalidGroups() {
+    vector<pair<int, int> > groups;
+    groups.push_back(make_pair(0, 3));
+    groups.push_back(make_pair(1, 2));
+    bool threwException = false;
+    try {
+        MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, groups);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    groups.clear();
+    threwException = false;
+    try {
+        MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, groups);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testCompareToCustomIntegrator();
+        testFriction();
+        testTemperature();
+        testConstraints();
+        testInvalidGroups();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
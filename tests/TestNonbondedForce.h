@@ -987,6 +987,77 @@ void testDirectAndReciprocal() {
     ASSERT_EQUAL_TOL(e3, e4, 1e-5);
 }
 
+void testEnergyOnly(NonbondedForce::NonbondedMethod method) {
+    // Computing only the energy should give the same result as computing forces and energy together.
+
+    const int numMolecules = 300;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* force = new NonbondedForce();
+    system.addForce(force);
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(1.0);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        force->addParticle(0.5, 0.2, 0.5);
+        force->addParticle(-0.5, 0.3, 0.8);
+        force->addException(2*i, 2*i+1, 0.0, 1.0, 0.0);
+        Vec3 pos = boxSize*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double expected = context.getState(State::Forces | State::Energy).getPotentialEnergy();
+    vector<double> energies = context.computeEnergies(vector<vector<Vec3> >(1, positions));
+    ASSERT_EQUAL_TOL(expected, energies[0], 1e-5);
+}
+
+void testExceptionLookup() {
+    // Check that duplicate exceptions are detected no matter how many there are or how they were modified.
+
+    const int numParticles = 2000;
+    NonbondedForce force;
+    for (int i = 0; i < numParticles; i++)
+        force.addParticle(0.0, 1.0, 0.0);
+    for (int i = 0; i < numParticles; i++)
+        for (int j = i+1; j < numParticles && j < i+5; j++)
+            ASSERT_EQUAL(force.getNumExceptions(), force.addException(j, i, 0.0, 1.0, 0.0));
+    for (int i = 0; i < force.getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        force.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        ASSERT_EQUAL(i, force.addException(p2, p1, 1.0, 0.5, 2.0, true));
+        ASSERT_EQUAL(i, force.addException(p1, p2, 1.0, 0.5, 2.0, true));
+        bool threw = false;
+        try {
+            force.addException(p2, p1, 0.0, 1.0, 0.0);
+        }
+        catch (const OpenMMException& ex) {
+            threw = true;
+        }
+        ASSERT(threw);
+    }
+
+    // Move some exceptions to different pairs.  The old pairs become free and the new ones are taken.
+
+    int numExceptions = force.getNumExceptions();
+    for (int i = 0; i < numExceptions; i += 7) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        force.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        force.setExceptionParameters(i, p1, p1+100, chargeProd, sigma, epsilon);
+        ASSERT_EQUAL(i, force.addException(p1+100, p1, 0.0, 1.0, 0.0, true));
+        ASSERT_EQUAL(force.getNumExceptions(), force.addException(p1, p2, 0.0, 1.0, 0.0));
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -1009,6 +1080,10 @@ int main(int argc, char* argv[]) {
         testParameterOffsets();
         testEwaldExceptions();
         testDirectAndReciprocal();
+        testEnergyOnly(NonbondedForce::CutoffPeriodic);
+        testEnergyOnly(NonbondedForce::PME);
+        testEnergyOnly(NonbondedForce::LJPME);
+        testExceptionLookup();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <limits>
 #include <map>
+#include <sstream>
 
 using namespace Lepton;
 using namespace OpenMM;
@@ -283,6 +284,126 @@ void testCustomFunction(const string& expression, const string& equivalent) {
     verifySameValue(deriv3, deriv4, 2.0, -3.0);
 }
 
+/**
+ * Verify that an expression with multiple outputs gives the same values as compiling each one separately.
+ */
+
+void testMultipleOutputs() {
+    ParsedExpression energy = Parser::parse("r^2*sin(r)+exp(-r*y)+y");
+    vector<ParsedExpression> expressions;
+    expressions.push_back(energy);
+    expressions.push_back(energy.differentiate("r"));
+    expressions.push_back(energy.differentiate("y"));
+    expressions.push_back(Parser::parse("y"));
+    CompiledExpression compiled(expressions);
+    ASSERT_EQUAL(4, compiled.getNumOutputs());
+    map<string, double> variables;
+    variables["r"] = 1.3;
+    variables["y"] = 0.7;
+    compiled.getVariableReference("r") = variables["r"];
+    compiled.getVariableReference("y") = variables["y"];
+    ASSERT_EQUAL_TOL(energy.evaluate(variables), compiled.evaluate(), 1e-10);
+    for (int i = 0; i < (int) expressions.size(); i++)
+        ASSERT_EQUAL_TOL(expressions[i].evaluate(variables), compiled.getOutput(i), 1e-10);
+
+    // Copying it should preserve the outputs.
+
+    CompiledExpression compiled2 = compiled;
+    compiled2.getVariableReference("r") = variables["r"];
+    compiled2.getVariableReference("y") = variables["y"];
+    compiled2.evaluate();
+    for (int i = 0; i < (int) expressions.size(); i++)
+        ASSERT_EQUAL_TOL(expressions[i].evaluate(variables), compiled2.getOutput(i), 1e-10);
+
+    // Try the same thing with a CompiledVectorExpression.
+
+    for (int width : CompiledVectorExpression::getAllowedWidths()) {
+        CompiledVectorExpression vector(expressions, width);
+        ASSERT_EQUAL(4, vector.getNumOutputs());
+        float* r = vector.getVariablePointer("r");
+        float* y = vector.getVariablePointer("y");
+        for (int j = 0; j < width; j++) {
+            r[j] = 1.0+0.1*j;
+            y[j] = 0.5-0.1*j;
+        }
+        vector.evaluate();
+        for (int j = 0; j < width; j++) {
+            variables["r"] = r[j];
+            variables["y"] = y[j];
+            for (int i = 0; i < (int) expressions.size(); i++)
+                ASSERT_EQUAL_TOL(expressions[i].evaluate(variables), vector.getOutput(i)[j], 1e-5);
+        }
+    }
+}
+
+/**
+ * Verify that a CompiledVectorExpression evaluates exp() accurately over its full range.
+ */
+
+void testVectorExp() {
+    ParsedExpression parsed = Parser::parse("exp(x)");
+    for (int width : CompiledVectorExpression::getAllowedWidths()) {
+        CompiledVectorExpression vector = parsed.createCompiledVectorExpression(width);
+        float* x = vector.getVariablePointer("x");
+        for (int base = -1000; base < 1000; base += width) {
+            for (int j = 0; j < width; j++)
+                x[j] = 0.1f*(base+j);
+            const float* result = vector.evaluate();
+            for (int j = 0; j < width; j++) {
+                if (x[j] > 89.0f) {
+                    ASSERT(result[j] == numeric_limits<float>::infinity());
+                }
+                else if (x[j] < -88.0f) {
+                    ASSERT(result[j] >= 0.0f && result[j] < 2*numeric_limits<float>::min());
+                }
+                else if (x[j] < 88.0f) {
+                    ASSERT_EQUAL_TOL(exp((double) x[j]), result[j], 1e-6);
+                }
+            }
+        }
+        x[0] = numeric_limits<float>::infinity();
+        x[1] = -numeric_limits<float>::infinity();
+        x[2] = numeric_limits<float>::quiet_NaN();
+        x[3] = 0.0f;
+        const float* result = vector.evaluate();
+        ASSERT(result[0] == numeric_limits<float>::infinity());
+        ASSERT_EQUAL(0.0f, result[1]);
+        ASSERT(result[2] != result[2]);
+        ASSERT_EQUAL(1.0f, result[3]);
+    }
+}
+
+/**
+ * Verify that a large expression with many subexpressions and repeated terms can be
+ * optimized and differentiated.
+ */
+
+void testLargeExpression() {
+    const int numTerms = 2000;
+    stringstream expression;
+    expression << "0";
+    for (int i = 0; i < numTerms; i++)
+        expression << "+t" << i;
+    for (int i = 0; i < numTerms; i++)
+        expression << "; t" << i << "=" << (i%7+1) << "*sin(" << 0.001*(i%50) << "*x+y)";
+    ParsedExpression parsed = Parser::parse(expression.str());
+    map<string, double> variables;
+    variables["x"] = 1.5;
+    variables["y"] = -0.3;
+    double expected = 0.0, expectedDeriv = 0.0;
+    for (int i = 0; i < numTerms; i++) {
+        expected += (i%7+1)*sin(0.001*(i%50)*1.5-0.3);
+        expectedDeriv += (i%7+1)*0.001*(i%50)*cos(0.001*(i%50)*1.5-0.3);
+    }
+    ASSERT_EQUAL_TOL(expected, parsed.evaluate(variables), 1e-10);
+    ASSERT_EQUAL_TOL(expected, parsed.optimize().evaluate(variables), 1e-10);
+    ASSERT_EQUAL_TOL(expectedDeriv, parsed.differentiate("x").optimize().evaluate(variables), 1e-10);
+    CompiledExpression compiled = parsed.createCompiledExpression();
+    compiled.getVariableReference("x") = 1.5;
+    compiled.getVariableReference("y") = -0.3;
+    ASSERT_EQUAL_TOL(expected, compiled.evaluate(), 1e-10);
+}
+
 int main() {
     try {
         verifyEvaluation("5", 5.0);
@@ -370,6 +491,9 @@ int main() {
         verifyDerivative("select(x, x^2, 3*x)", "select(x, 2*x, 3)");
         testCustomFunction("custom(x, y)/2", "x*y");
         testCustomFunction("custom(x^2, 1)+custom(2, y-1)", "2*x^2+4*(y-1)");
+        testMultipleOutputs();
+        testVectorExp();
+        testLargeExpression();
         cout << Parser::parse("x*x").optimize() << endl;
         cout << Parser::parse("x*(x*x)").optimize() << endl;
         cout << Parser::parse("(x*x)*x").optimize() << endl;
@@ -0,0 +1,170 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/ParticleActivator.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create a System containing a number of four atom molecules, each with bonds, angles, a torsion,
+ * and exceptions.
+ */
+void createSystem(System& system, vector<Vec3>& positions, int numMolecules) {
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    PeriodicTorsionForce* torsions = new PeriodicTorsionForce();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffNonPeriodic);
+    nonbonded->setCutoffDistance(2.0);
+    system.addForce(bonds);
+    system.addForce(angles);
+    system.addForce(torsions);
+    system.addForce(nonbonded);
+    for (int i = 0; i < numMolecules; i++) {
+        int first = 4*i;
+        for (int j = 0; j < 4; j++) {
+            system.addParticle(1.0);
+            nonbonded->addParticle(j%2 == 0 ? 0.4 : -0.4, 0.3, 0.5);
+            positions.push_back(Vec3(0.8*i+0.1*j, 0.13*(j%2), 0.07*j*j));
+        }
+        for (int j = 0; j < 3; j++)
+            bonds->addBond(first+j, first+j+1, 0.12, 1000.0);
+        for (int j = 0; j < 2; j++)
+            angles->addAngle(first+j, first+j+1, first+j+2, 2.0, 100.0);
+        torsions->addTorsion(first, first+1, first+2, first+3, 2, 0.5, 10.0);
+        vector<pair<int, int> > molBonds;
+        for (int j = 0; j < 3; j++)
+            molBonds.push_back(make_pair(first+j, first+j+1));
+        nonbonded->createExceptionsFromBonds(molBonds, 0.5, 0.5);
+    }
+}
+
+double getEnergy(Context& context) {
+    return context.getState(State::Energy).getPotentialEnergy();
+}
+
+void testActivation() {
+    // Create a System with three molecules, and one with only the first two.
+
+    System system, smallSystem;
+    vector<Vec3> positions, smallPositions;
+    createSystem(system, positions, 3);
+    createSystem(smallSystem, smallPositions, 2);
+    Platform& platform = Platform::getPlatformByName("Reference");
+    VerletIntegrator integrator(0.001), smallIntegrator(0.001);
+    Context context(system, integrator, platform);
+    Context smallContext(smallSystem, smallIntegrator, platform);
+    context.setPositions(positions);
+    smallContext.setPositions(smallPositions);
+    double fullEnergy = getEnergy(context);
+    double smallEnergy = getEnergy(smallContext);
+
+    // Deactivating the last molecule should make the energy and forces match the smaller System.
+
+    ParticleActivator activator(system);
+    vector<int> lastMolecule = {8, 9, 10, 11};
+    for (int i = 0; i < 12; i++)
+        ASSERT(activator.isParticleActive(i));
+    activator.setParticlesActive(context, lastMolecule, false);
+    for (int i = 0; i < 12; i++)
+        ASSERT_EQUAL(i < 8, activator.isParticleActive(i));
+    ASSERT_EQUAL_TOL(smallEnergy, getEnergy(context), 1e-6);
+    State state = context.getState(State::Forces);
+    State smallState = smallContext.getState(State::Forces);
+    for (int i = 0; i < 8; i++)
+        ASSERT_EQUAL_VEC(smallState.getForces()[i], state.getForces()[i], 1e-6);
+    for (int i = 8; i < 12; i++)
+        ASSERT_EQUAL_VEC(Vec3(), state.getForces()[i], 1e-6);
+
+    // Reactivating it should restore the original energy.
+
+    activator.setParticlesActive(context, lastMolecule, true);
+    ASSERT_EQUAL_TOL(fullEnergy, getEnergy(context), 1e-6);
+
+    // Deactivating a single atom should remove its terms but leave the rest of the molecule.
+
+    activator.setParticleActive(context, 11, false);
+    ASSERT(getEnergy(context) != fullEnergy);
+    activator.setParticleActive(context, 11, true);
+    ASSERT_EQUAL_TOL(fullEnergy, getEnergy(context), 1e-6);
+}
+
+void testErrors() {
+    System system, otherSystem;
+    vector<Vec3> positions, otherPositions;
+    createSystem(system, positions, 2);
+    createSystem(otherSystem, otherPositions, 2);
+    VerletIntegrator integrator(0.001);
+    Context otherContext(otherSystem, integrator, Platform::getPlatformByName("Reference"));
+    ParticleActivator activator(system);
+    bool threwException = false;
+    try {
+        activator.setParticleActive(otherContext, 0, false);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    threwException = false;
+    try {
+        activator.isParticleActive(8);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testActivation();
+        testErrors();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testProfiling() {
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setName("Electrostatics");
+    system.addForce(nonbonded);
+    vector<Vec3> positions;
+    for (int i = 0; i < 20; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.2 : -0.2, 0.3, 0.5);
+        positions.push_back(Vec3(0.4*(i%5), 0.4*(i/5), 0));
+        if (i%2 == 1)
+            bonds->addBond(i-1, i, 0.4, 100.0);
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+
+    // Nothing should be recorded until profiling is enabled.
+
+    ASSERT(!context.getProfilingEnabled());
+    integrator.step(5);
+    ASSERT(context.getProfile().empty());
+
+    // Every Force should be listed under its name, along with the platform's own work.
+
+    context.setProfilingEnabled(true);
+    ASSERT(context.getProfilingEnabled());
+    integrator.step(5);
+    context.getState(State::Energy);
+    map<string, double> profile = context.getProfile();
+    ASSERT_EQUAL(4, profile.size());
+    ASSERT(profile.find("HarmonicBondForce") != profile.end());
+    ASSERT(profile.find("Electrostatics") != profile.end());
+    ASSERT(profile.find("Begin Computation") != profile.end());
+    ASSERT(profile.find("Finish Computation") != profile.end());
+    for (auto& entry : profile)
+        ASSERT(entry.second >= 0.0);
+
+    // Times should accumulate until the profile is reset, and stop when profiling is disabled.
+
+    integrator.step(5);
+    ASSERT(context.getProfile()["Electrostatics"] >= profile["Electrostatics"]);
+    context.resetProfile();
+    ASSERT(context.getProfile().empty());
+    context.setProfilingEnabled(false);
+    integrator.step(5);
+    ASSERT(context.getProfile().empty());
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testProfiling();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -258,6 +258,61 @@ void testPeriodic3DSpline() {
     }
 }
 
+void testHermite3DSpline() {
+    const int xsize = 8;
+    const int ysize = 9;
+    const int zsize = 10;
+    vector<double> x(xsize);
+    vector<double> y(ysize);
+    vector<double> z(zsize);
+    vector<double> f(xsize*ysize*zsize);
+    for (int i = 0; i < xsize; i++)
+        x[i] = 0.2*i+0.02*sin(0.4*double(i));
+    for (int i = 0; i < ysize; i++)
+        y[i] = 0.2*i+0.02*sin(0.45*double(i));
+    for (int i = 0; i < zsize; i++)
+        z[i] = 0.2*i+0.02*sin(0.5*double(i));
+    for (int i = 0; i < xsize; i++)
+        for (int j = 0; j < ysize; j++)
+            for (int k = 0; k < zsize; k++)
+                f[i+j*xsize+k*xsize*ysize] = sin(3*x[i])*cos(2*y[j])*(1+z[k]*z[k]);
+
+    // The Hermite form should give exactly the same spline as the coefficients.
+
+    for (bool periodic : {false, true}) {
+        if (periodic) {
+            // Make the first and last points along each axis identical.
+
+            for (int i = 0; i < xsize; i++)
+                for (int j = 0; j < ysize; j++)
+                    for (int k = 0; k < zsize; k++)
+                        f[i+j*xsize+k*xsize*ysize] = f[i%(xsize-1)+(j%(ysize-1))*xsize+(k%(zsize-1))*xsize*ysize];
+        }
+        vector<vector<double> > c;
+        vector<double> d;
+        SplineFitter::create3DSpline(x, y, z, f, periodic, c);
+        SplineFitter::create3DHermiteSpline(x, y, z, f, periodic, d);
+        ASSERT_EQUAL(8*f.size(), d.size());
+        for (int i = 0; i < 12; i++) {
+            for (int j = 0; j < 12; j++) {
+                for (int k = 0; k < 12; k++) {
+                    double s = min(x[0]+i*(x[xsize-1]-x[0])/11.0, x[xsize-1]);
+                    double t = min(y[0]+j*(y[ysize-1]-y[0])/11.0, y[ysize-1]);
+                    double u = min(z[0]+k*(z[zsize-1]-z[0])/11.0, z[zsize-1]);
+                    double expected = SplineFitter::evaluate3DSpline(x, y, z, f, c, s, t, u);
+                    ASSERT_EQUAL_TOL(expected, SplineFitter::evaluate3DHermiteSpline(x, y, z, d, s, t, u), 1e-8);
+                    double dx1, dy1, dz1, dx2, dy2, dz2;
+                    SplineFitter::evaluate3DSplineDerivatives(x, y, z, f, c, s, t, u, dx1, dy1, dz1);
+                    SplineFitter::evaluate3DHermiteSplineDerivatives(x, y, z, d, s, t, u, dx2, dy2, dz2);
+                    ASSERT_EQUAL_TOL(dx1, dx2, 1e-8);
+                    ASSERT_EQUAL_TOL(dy1, dy2, 1e-8);
+                    ASSERT_EQUAL_TOL(dz1, dz2, 1e-8);
+                }
+            }
+        }
+    }
+}
+
 int main() {
     try {
         testNaturalSpline();
@@ -266,6 +321,7 @@ int main() {
         testPeriodic2DSpline();
         test3DSpline();
         testPeriodic3DSpline();
+        testHermite3DSpline();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
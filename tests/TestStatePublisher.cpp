@@ -0,0 +1,253 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/StatePublisher.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 50;
+const double boxSize = 3.0;
+
+void createSystem(System& system, vector<Vec3>& positions) {
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    positions.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+}
+
+string getTestName() {
+    // Include the process ID so tests running at the same time don't interfere.
+
+    stringstream name;
+    name << "/TestStatePublisher_" << getpid();
+    return name.str();
+}
+
+void testPublish() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    StatePublisher publisher(context, getTestName(), 5, 3);
+    publisher.setIncludeEnergy(true);
+    StateSubscriber subscriber(getTestName());
+    ASSERT_EQUAL(numParticles, subscriber.getNumParticles());
+    ASSERT_EQUAL(3, subscriber.getNumSlots());
+    ASSERT_EQUAL(0, subscriber.getNumFrames());
+    StateSubscriber::Frame frame;
+    ASSERT(!subscriber.readLatestFrame(frame));
+
+    // Publish four frames.  The first one should have been overwritten.
+
+    publisher.step(20);
+    ASSERT_EQUAL(4, publisher.getNumFrames());
+    ASSERT_EQUAL(4, subscriber.getNumFrames());
+    ASSERT(!subscriber.readFrame(0, frame));
+    ASSERT(!subscriber.readFrame(4, frame));
+    for (int i = 1; i < 4; i++) {
+        ASSERT(subscriber.readFrame(i, frame));
+        ASSERT_EQUAL(i, frame.index);
+        ASSERT_EQUAL(5*(i+1), frame.step);
+        ASSERT_EQUAL_TOL(0.005*(i+1), frame.time, 1e-10);
+        ASSERT_EQUAL_VEC(Vec3(boxSize, 0, 0), frame.box[0], 0);
+        ASSERT_EQUAL_VEC(Vec3(0, boxSize, 0), frame.box[1], 0);
+        ASSERT_EQUAL_VEC(Vec3(0, 0, boxSize), frame.box[2], 0);
+    }
+
+    // The latest frame should match the current state exactly.
+
+    State state = context.getState(State::Positions | State::Energy);
+    ASSERT(subscriber.readLatestFrame(frame));
+    ASSERT_EQUAL(3, frame.index);
+    ASSERT_EQUAL(state.getPotentialEnergy(), frame.potentialEnergy);
+    ASSERT_EQUAL(state.getKineticEnergy(), frame.kineticEnergy);
+    ASSERT_EQUAL(numParticles, frame.positions.size());
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state.getPositions()[i], frame.positions[i], 0);
+
+    // Without energies, they should be reported as NaN.
+
+    publisher.setIncludeEnergy(false);
+    publisher.publishFrame();
+    ASSERT(subscriber.readLatestFrame(frame));
+    ASSERT_EQUAL(4, frame.index);
+    ASSERT_EQUAL(20, frame.step);
+    ASSERT(frame.potentialEnergy != frame.potentialEnergy);
+    ASSERT(frame.kineticEnergy != frame.kineticEnergy);
+}
+
+void testOtherProcess() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    string name = getTestName();
+    StatePublisher publisher(context, name, 2);
+    publisher.step(10);
+    vector<Vec3> expected = context.getState(State::Positions).getPositions();
+
+    // Read the latest frame from a child process, and report whether it matched through the exit code.
+
+    pid_t child = fork();
+    if (child == 0) {
+        bool matches = false;
+        try {
+            StateSubscriber subscriber(name);
+            StateSubscriber::Frame frame;
+            matches = (subscriber.readLatestFrame(frame) && frame.step == 10);
+            for (int i = 0; i < numParticles; i++)
+                if (frame.positions[i][0] != expected[i][0] || frame.positions[i][1] != expected[i][1] || frame.positions[i][2] != expected[i][2])
+                    matches = false;
+        }
+        catch (...) {
+        }
+        _exit(matches ? 0 : 1);
+    }
+    int status;
+    ASSERT(waitpid(child, &status, 0) == child);
+    ASSERT(WIFEXITED(status));
+    ASSERT_EQUAL(0, WEXITSTATUS(status));
+}
+
+void testMissingObject() {
+    bool threwException = false;
+    try {
+        StateSubscriber subscriber(getTestName()+"_missing");
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testReplaceExisting() {
+    // Leave behind an object of the wrong size, as if an earlier run had crashed.
+
+    string name = getTestName();
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    ASSERT(fd != -1);
+    ASSERT(ftruncate(fd, 100) == 0);
+    close(fd);
+
+    // The publisher should replace it with a new object.
+
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    StatePublisher publisher(context, name, 2);
+    publisher.step(4);
+    StateSubscriber subscriber(name);
+    ASSERT_EQUAL(numParticles, subscriber.getNumParticles());
+    StateSubscriber::Frame frame;
+    ASSERT(subscriber.readLatestFrame(frame));
+    ASSERT_EQUAL(4, frame.step);
+}
+
+void testAbandonedWrite() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    string name = getTestName();
+    StatePublisher publisher(context, name, 2, 1);
+    publisher.publishFrame();
+
+    // Mark the only slot as being written, as if the publisher had been killed while writing it.
+    // Reading should fail instead of waiting forever.
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT(fd != -1);
+    char* memory = (char*) mmap(NULL, 128, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ASSERT(memory != MAP_FAILED);
+    (*(long long*) (memory+64))++;
+    StateSubscriber subscriber(name);
+    StateSubscriber::Frame frame;
+    ASSERT(!subscriber.readFrame(0, frame));
+    ASSERT(!subscriber.readLatestFrame(frame));
+    munmap(memory, 128);
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+#ifndef _WIN32
+        testPublish();
+        testOtherProcess();
+        testMissingObject();
+        testReplaceExisting();
+        testAbandonedWrite();
+#endif
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
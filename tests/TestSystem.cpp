@@ -31,6 +31,7 @@
 
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/HarmonicAngleForce.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/HarmonicBondForce.h"
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
@@ -111,9 +112,64 @@ void testCreateSystem() {
     }
 }
 
+void testRepartitionHydrogenMass() {
+    // A methyl group bonded to a deuterated amine, with a massless virtual site.
+
+    System system;
+    system.addParticle(12.0);
+    system.addParticle(1.008);
+    system.addParticle(1.008);
+    system.addParticle(1.008);
+    system.addParticle(14.0);
+    system.addParticle(2.014);
+    system.addParticle(0.0);
+    vector<pair<int, int> > bonds;
+    bonds.push_back(make_pair(0, 1));
+    bonds.push_back(make_pair(2, 0));
+    bonds.push_back(make_pair(0, 3));
+    bonds.push_back(make_pair(0, 4));
+    bonds.push_back(make_pair(4, 5));
+    bonds.push_back(make_pair(5, 6));
+    bonds.push_back(make_pair(1, 2));
+    system.repartitionHydrogenMass(3.0, bonds);
+    ASSERT_EQUAL_TOL(12.0-3*(3.0-1.008), system.getParticleMass(0), 1e-10);
+    for (int i = 1; i < 4; i++)
+        ASSERT_EQUAL_TOL(3.0, system.getParticleMass(i), 1e-10);
+    ASSERT_EQUAL_TOL(14.0-(3.0-2.014), system.getParticleMass(4), 1e-10);
+    ASSERT_EQUAL_TOL(3.0, system.getParticleMass(5), 1e-10);
+    ASSERT_EQUAL(0.0, system.getParticleMass(6));
+
+    // Hydrogens that have already been repartitioned are no longer recognized, so doing
+    // it again has no effect.
+
+    system.repartitionHydrogenMass(4.0, bonds);
+    ASSERT_EQUAL_TOL(3.0, system.getParticleMass(1), 1e-10);
+
+    // Asking for more mass than the heavy atom has should fail without changing anything.
+
+    System system2;
+    system2.addParticle(3.0);
+    system2.addParticle(1.0);
+    system2.addParticle(1.0);
+    bonds.clear();
+    bonds.push_back(make_pair(0, 1));
+    bonds.push_back(make_pair(0, 2));
+    bool threwException = false;
+    try {
+        system2.repartitionHydrogenMass(2.5, bonds);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ASSERT_EQUAL(3.0, system2.getParticleMass(0));
+    ASSERT_EQUAL(1.0, system2.getParticleMass(1));
+}
+
 int main() {
     try {
         testCreateSystem();
+        testRepartitionHydrogenMass();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,176 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/TelemetryCallback.h"
+#include "openmm/VerletIntegrator.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+class RecordingCallback : public TelemetryCallback {
+public:
+    void report(Context& context, const Sample& sample) {
+        samples.push_back(sample);
+    }
+    vector<Sample> samples;
+};
+
+System* createSystem(vector<Vec3>& positions) {
+    System* system = new System();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system->addForce(bonds);
+    positions.clear();
+    for (int i = 0; i < 10; i++) {
+        system->addParticle(1.0);
+        positions.push_back(Vec3(0.3*i, 0, 0));
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.3, 100.0);
+    }
+    return system;
+}
+
+void testReports() {
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    VerletIntegrator integrator(0.002);
+    Context context(*system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    RecordingCallback callback;
+    ASSERT(context.getTelemetryCallback() == NULL);
+    context.setTelemetryCallback(&callback, 10);
+    ASSERT(context.getTelemetryCallback() == &callback);
+    ASSERT_EQUAL(10, context.getTelemetryInterval());
+
+    // A report is delivered when the step after every tenth one begins.
+
+    integrator.step(35);
+    ASSERT_EQUAL(3, callback.samples.size());
+    for (int i = 0; i < 3; i++) {
+        const TelemetryCallback::Sample& sample = callback.samples[i];
+        ASSERT_EQUAL(10*(i+1), sample.stepCount);
+        ASSERT_EQUAL(10, sample.steps);
+        ASSERT_EQUAL_TOL(0.002*10*(i+1), sample.simulationTime, 1e-10);
+        ASSERT(sample.intervalTime >= 0.0);
+        ASSERT(sample.elapsedTime >= sample.intervalTime);
+        ASSERT(sample.maxStepTime >= 0.0);
+        ASSERT(sample.maxStepTime <= sample.intervalTime);
+        ASSERT(sample.nsPerDay >= 0.0);
+        ASSERT(sample.profile == NULL);
+    }
+
+    // When profiling is enabled, the profile should be included.
+
+    context.setProfilingEnabled(true);
+    integrator.step(10);
+    ASSERT_EQUAL(4, callback.samples.size());
+    ASSERT(callback.samples[3].profile != NULL);
+
+    // Resetting the step count should start a new interval.
+
+    context.setStepCount(0);
+    integrator.step(12);
+    ASSERT_EQUAL(5, callback.samples.size());
+    ASSERT_EQUAL(10, callback.samples[4].stepCount);
+    ASSERT_EQUAL(10, callback.samples[4].steps);
+
+    // Removing the callback should stop the reports.
+
+    context.setTelemetryCallback(NULL, 0);
+    ASSERT(context.getTelemetryCallback() == NULL);
+    integrator.step(30);
+    ASSERT_EQUAL(5, callback.samples.size());
+    delete system;
+}
+
+void testCustomIntegrator() {
+    // A CustomIntegrator reports when it updates the context state, even if it does that more
+    // than once per step.
+
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    CustomIntegrator integrator(0.002);
+    integrator.addUpdateContextState();
+    integrator.addComputePerDof("v", "v+dt*f/m");
+    integrator.addUpdateContextState();
+    integrator.addComputePerDof("x", "x+dt*v");
+    Context context(*system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    RecordingCallback callback;
+    context.setTelemetryCallback(&callback, 5);
+    integrator.step(21);
+    ASSERT_EQUAL(4, callback.samples.size());
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQUAL(5*(i+1), callback.samples[i].stepCount);
+        ASSERT_EQUAL(5, callback.samples[i].steps);
+    }
+    delete system;
+}
+
+void testInvalidInterval() {
+    vector<Vec3> positions;
+    System* system = createSystem(positions);
+    VerletIntegrator integrator(0.002);
+    Context context(*system, integrator, Platform::getPlatformByName("Reference"));
+    RecordingCallback callback;
+    bool threwException = false;
+    try {
+        context.setTelemetryCallback(&callback, 0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    delete system;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testReports();
+        testCustomIntegrator();
+        testInvalidInterval();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
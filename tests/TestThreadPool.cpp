@@ -0,0 +1,142 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ThreadPool.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Run a task with many synchronization points, checking that every thread sees the
+ * results written by all the others in the previous phase.
+ */
+void testSyncThreads(int numThreads, int spinCount) {
+    const int numPhases = 200;
+    ThreadPool threads(numThreads);
+    threads.setSpinCount(spinCount);
+    ASSERT_EQUAL(spinCount, threads.getSpinCount());
+    vector<int> values(numThreads, 0);
+    atomic<int> errors(0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        for (int phase = 1; phase <= numPhases; phase++) {
+            values[threadIndex] = phase;
+            threads.syncThreads();
+            for (int i = 0; i < numThreads; i++)
+                if (values[i] != phase)
+                    errors++;
+            threads.syncThreads();
+        }
+    });
+    for (int phase = 0; phase < 2*numPhases; phase++) {
+        threads.waitForThreads();
+        threads.resumeThreads();
+    }
+    threads.waitForThreads();
+    ASSERT_EQUAL(0, errors);
+}
+
+/**
+ * Execute many short tasks in a row, as happens when a kernel is called every time step.
+ */
+void testRepeatedExecute(int numThreads, int spinCount) {
+    const int numTasks = 1000;
+    ThreadPool threads(numThreads);
+    threads.setSpinCount(spinCount);
+    vector<int> counts(numThreads, 0);
+    for (int i = 0; i < numTasks; i++) {
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            counts[threadIndex]++;
+        });
+        threads.waitForThreads();
+    }
+    for (int i = 0; i < numThreads; i++)
+        ASSERT_EQUAL(numTasks, counts[i]);
+}
+
+/**
+ * Have several threads use a shared pool at the same time, each running tasks with
+ * synchronization points.  Every task should see only its own data.
+ */
+void testSharedPool(int numThreads) {
+    const int numCallers = 4;
+    const int numTasks = 200;
+    ThreadPool threads(numThreads);
+    threads.setShared(true);
+    ASSERT(threads.getShared());
+    vector<atomic<int> > errors(numCallers);
+    vector<thread> callers;
+    for (int caller = 0; caller < numCallers; caller++) {
+        errors[caller] = 0;
+        callers.push_back(thread([&, caller] () {
+            vector<int> values(numThreads);
+            for (int task = 0; task < numTasks; task++) {
+                threads.execute([&] (ThreadPool& threads, int threadIndex) {
+                    values[threadIndex] = caller*numTasks+task;
+                    threads.syncThreads();
+                    for (int i = 0; i < numThreads; i++)
+                        if (values[i] != caller*numTasks+task)
+                            errors[caller]++;
+                });
+                threads.waitForThreads();
+                threads.resumeThreads();
+                threads.waitForThreads();
+            }
+        }));
+    }
+    for (auto& t : callers)
+        t.join();
+    for (int caller = 0; caller < numCallers; caller++)
+        ASSERT_EQUAL(0, errors[caller]);
+}
+
+int main() {
+    try {
+        for (int spinCount : {0, 100}) {
+            for (int numThreads : {1, 3, 8}) {
+                testSyncThreads(numThreads, spinCount);
+                testRepeatedExecute(numThreads, spinCount);
+            }
+        }
+        for (int numThreads : {1, 3})
+            testSharedPool(numThreads);
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
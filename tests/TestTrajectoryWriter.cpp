@@ -0,0 +1,217 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/TrajectoryWriter.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include "xdrfile/xdrfile.h"
+#include "xdrfile/xdrfile_xtc.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 50;
+const double boxSize = 3.0;
+
+void createSystem(System& system, vector<Vec3>& positions) {
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    positions.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+}
+
+template <class T>
+T readValue(istream& in) {
+    T value;
+    in.read((char*) &value, sizeof(T));
+    return value;
+}
+
+void testDCD() {
+    const string filename = "TestTrajectoryWriter.dcd";
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    {
+        TrajectoryWriter writer(context, filename, TrajectoryWriter::DCD, 5);
+        writer.step(23);
+        ASSERT_EQUAL(4, writer.getNumFrames());
+    }
+    {
+        // Append another frame.
+
+        TrajectoryWriter writer(context, filename, TrajectoryWriter::DCD, 5, true);
+        ASSERT_EQUAL(4, writer.getNumFrames());
+        writer.step(2);
+        ASSERT_EQUAL(5, writer.getNumFrames());
+    }
+    State state = context.getState(State::Positions);
+
+    // Check the header.
+
+    ifstream in(filename.c_str(), ios::binary);
+    ASSERT_EQUAL(84, readValue<int>(in));
+    char cord[4];
+    in.read(cord, 4);
+    ASSERT(string(cord, 4) == "CORD");
+    ASSERT_EQUAL(5, readValue<int>(in));
+    ASSERT_EQUAL(0, readValue<int>(in));
+    ASSERT_EQUAL(5, readValue<int>(in));
+    ASSERT_EQUAL(25, readValue<int>(in));
+    in.seekg(44);
+    ASSERT_EQUAL_TOL(0.001/0.04888821, readValue<float>(in), 1e-6);
+    ASSERT_EQUAL(1, readValue<int>(in));
+    in.seekg(268);
+    ASSERT_EQUAL(numParticles, readValue<int>(in));
+    ASSERT_EQUAL(4, readValue<int>(in));
+
+    // Check the last frame, which should match the state we recorded.
+
+    const int frameSize = 56+3*(8+4*numParticles);
+    ASSERT_EQUAL(276+5*frameSize, (int) in.seekg(0, ios::end).tellg());
+    in.seekg(276+4*frameSize);
+    ASSERT_EQUAL(48, readValue<int>(in));
+    double cell[6];
+    in.read((char*) cell, sizeof(cell));
+    ASSERT_EQUAL_TOL(10*boxSize, cell[0], 1e-6);
+    ASSERT_EQUAL_TOL(0.0, cell[1], 1e-6);
+    ASSERT_EQUAL_TOL(10*boxSize, cell[2], 1e-6);
+    ASSERT_EQUAL_TOL(10*boxSize, cell[5], 1e-6);
+    ASSERT_EQUAL(48, readValue<int>(in));
+    for (int axis = 0; axis < 3; axis++) {
+        ASSERT_EQUAL(4*numParticles, readValue<int>(in));
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_TOL(10*state.getPositions()[i][axis], readValue<float>(in), 1e-5);
+        ASSERT_EQUAL(4*numParticles, readValue<int>(in));
+    }
+    in.close();
+    remove(filename.c_str());
+}
+
+void testXTC() {
+    const string filename = "TestTrajectoryWriter.xtc";
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    vector<State> states;
+    {
+        TrajectoryWriter writer(context, filename, TrajectoryWriter::XTC, 4);
+        for (int i = 0; i < 3; i++) {
+            writer.step(4);
+            states.push_back(context.getState(State::Positions));
+        }
+        writer.flush();
+        ASSERT_EQUAL(3, writer.getNumFrames());
+    }
+    {
+        TrajectoryWriter writer(context, filename, TrajectoryWriter::XTC, 4, true);
+        ASSERT_EQUAL(3, writer.getNumFrames());
+        writer.writeFrame();
+        states.push_back(context.getState(State::Positions));
+    }
+
+    // Read the frames back and compare them to the states.
+
+    int fileParticles;
+    ASSERT_EQUAL(exdrOK, read_xtc_natoms(const_cast<char*>(filename.c_str()), &fileParticles));
+    ASSERT_EQUAL(numParticles, fileParticles);
+    XDRFILE* xd = xdrfile_open(filename.c_str(), "r");
+    vector<float> coords(3*numParticles);
+    int step;
+    float time, precision;
+    matrix box;
+    for (int frame = 0; frame < (int) states.size(); frame++) {
+        ASSERT_EQUAL(exdrOK, read_xtc(xd, numParticles, &step, &time, box, (rvec*) coords.data(), &precision));
+        ASSERT_EQUAL(states[frame].getStepCount(), step);
+        ASSERT_EQUAL_TOL(states[frame].getTime(), time, 1e-5);
+        ASSERT_EQUAL_TOL(boxSize, box[0][0], 1e-6);
+        ASSERT_EQUAL_TOL(0.0, box[0][1], 1e-6);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(states[frame].getPositions()[i], Vec3(coords[3*i], coords[3*i+1], coords[3*i+2]), 1e-3);
+    }
+    ASSERT(read_xtc(xd, numParticles, &step, &time, box, (rvec*) coords.data(), &precision) != exdrOK);
+    xdrfile_close(xd);
+
+    // Appending with the wrong number of particles should fail.
+
+    System system2;
+    system2.addParticle(1.0);
+    VerletIntegrator integrator2(0.001);
+    Context context2(system2, integrator2, Platform::getPlatformByName("Reference"));
+    bool threwException = false;
+    try {
+        TrajectoryWriter writer(context2, filename, TrajectoryWriter::XTC, 4, true);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    remove(filename.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        testDCD();
+        testXTC();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -36,6 +36,8 @@
 #include "openmm/NonbondedForce.h"
 #include "openmm/System.h"
 #include "openmm/VariableVerletIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/ForceImpl.h"
 #include "SimTKOpenMMRealType.h"
 #include "sfmt/SFMT.h"
 #include <iostream>
@@ -46,6 +48,47 @@ using namespace std;
 
 const double TOL = 1e-5;
 
+/**
+ * A Force that records the time and step count every time the Context state is updated before a step.
+ */
+class TimeRecordingForce : public Force {
+public:
+    mutable vector<double> times;
+    mutable vector<long long> steps;
+protected:
+    ForceImpl* createImpl() const;
+};
+
+class TimeRecordingForceImpl : public ForceImpl {
+public:
+    TimeRecordingForceImpl(const TimeRecordingForce& owner) : owner(owner) {
+    }
+    void initialize(ContextImpl& context) {
+    }
+    const Force& getOwner() const {
+        return owner;
+    }
+    void updateContextState(ContextImpl& context, bool& forcesInvalid) {
+        owner.times.push_back(context.getTime());
+        owner.steps.push_back(context.getStepCount());
+    }
+    double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
+        return 0.0;
+    }
+    map<string, double> getDefaultParameters() {
+        return map<string, double>();
+    }
+    vector<string> getKernelNames() {
+        return vector<string>();
+    }
+private:
+    const TimeRecordingForce& owner;
+};
+
+ForceImpl* TimeRecordingForce::createImpl() const {
+    return new TimeRecordingForceImpl(*this);
+}
+
 void testSingleBond() {
     System system;
     system.addParticle(2.0);
@@ -363,6 +406,82 @@ void testForceGroups() {
     ASSERT(pos[2] == 0);
 }
 
+void testStepCountAndTime() {
+    System system;
+    system.addParticle(2.0);
+    system.addParticle(2.0);
+    VariableVerletIntegrator integrator(1e-5);
+    HarmonicBondForce* forceField = new HarmonicBondForce();
+    forceField->addBond(0, 1, 1.5, 1);
+    system.addForce(forceField);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(2);
+    positions[0] = Vec3(-1, 0, 0);
+    positions[1] = Vec3(1, 0, 0);
+    context.setPositions(positions);
+
+    // step() should take exactly the requested number of steps.
+
+    integrator.step(250);
+    ASSERT_EQUAL(250, context.getStepCount());
+    double time = context.getTime();
+    ASSERT(time > 0);
+
+    // stepTo() should stop exactly at the requested time, and can be called repeatedly.
+
+    for (int i = 1; i <= 5; i++) {
+        long long steps = context.getStepCount();
+        integrator.stepTo(time+0.1*i);
+        ASSERT_EQUAL(time+0.1*i, context.getTime());
+        ASSERT(context.getStepCount() > steps);
+    }
+
+    // Limit the step size and check that the time advances by the correct amount.
+
+    double maxStep = 0.5*integrator.getStepSize();
+    integrator.setMaximumStepSize(maxStep);
+    time = context.getTime();
+    long long steps = context.getStepCount();
+    integrator.step(100);
+    ASSERT_EQUAL(steps+100, context.getStepCount());
+    ASSERT(context.getTime() > time);
+    ASSERT(context.getTime() <= time+100*maxStep*1.000001);
+    ASSERT(integrator.getStepSize() <= maxStep*1.000001);
+}
+
+void testTimeDependentForce() {
+    System system;
+    system.addParticle(2.0);
+    system.addParticle(2.0);
+    VariableVerletIntegrator integrator(1e-5);
+    HarmonicBondForce* forceField = new HarmonicBondForce();
+    forceField->addBond(0, 1, 1.5, 1);
+    system.addForce(forceField);
+    TimeRecordingForce* recorder = new TimeRecordingForce();
+    system.addForce(recorder);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(2);
+    positions[0] = Vec3(-1, 0, 0);
+    positions[1] = Vec3(1, 0, 0);
+    context.setPositions(positions);
+
+    // Forces must see the current time and step count before every step, and no steps should be
+    // taken once the target time is reached.
+
+    integrator.step(50);
+    double targetTime = context.getTime()+0.2;
+    integrator.stepTo(targetTime);
+    ASSERT_EQUAL_TOL(targetTime, context.getTime(), 1e-10);
+    int numCalls = recorder->times.size();
+    ASSERT_EQUAL(context.getStepCount(), numCalls);
+    for (int i = 0; i < numCalls; i++) {
+        ASSERT_EQUAL(i, recorder->steps[i]);
+        ASSERT(recorder->times[i] < targetTime);
+        if (i > 0)
+            ASSERT(recorder->times[i] > recorder->times[i-1]);
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -375,6 +494,8 @@ int main(int argc, char* argv[]) {
         testArgonBox();
         testInitialTemperature();
         testForceGroups();
+        testStepCountAndTime();
+        testTimeDependentForce();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -326,6 +326,59 @@ void testForceGroups() {
     ASSERT(pos[2] == 0);
 }
 
+void testStepAsync() {
+    const int numParticles = 10;
+    const int numReplicas = 3;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+0.1*i);
+        positions[i] = Vec3(0.11*i, 0.02*(i%3), 0);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.1, 1000.0);
+    }
+
+    // Step several Contexts at once and compare them to stepping one synchronously.
+
+    VerletIntegrator referenceIntegrator(0.001);
+    Context referenceContext(system, referenceIntegrator, platform);
+    referenceContext.setPositions(positions);
+    referenceIntegrator.step(100);
+    State referenceState = referenceContext.getState(State::Positions | State::Velocities);
+    vector<VerletIntegrator*> integrators;
+    vector<Context*> contexts;
+    vector<future<void> > futures;
+    for (int i = 0; i < numReplicas; i++) {
+        integrators.push_back(new VerletIntegrator(0.001));
+        contexts.push_back(new Context(system, *integrators[i], platform));
+        contexts[i]->setPositions(positions);
+    }
+
+    // Take the steps in several rounds, so threads get reused.
+
+    for (int round = 0; round < 4; round++) {
+        futures.clear();
+        for (int i = 0; i < numReplicas; i++)
+            futures.push_back(integrators[i]->stepAsync(25));
+        for (int i = 0; i < numReplicas; i++)
+            futures[i].get();
+    }
+    for (int i = 0; i < numReplicas; i++) {
+        State state = contexts[i]->getState(State::Positions | State::Velocities);
+        ASSERT_EQUAL_TOL(referenceState.getTime(), state.getTime(), 1e-10);
+        for (int j = 0; j < numParticles; j++) {
+            ASSERT_EQUAL_VEC(referenceState.getPositions()[j], state.getPositions()[j], TOL);
+            ASSERT_EQUAL_VEC(referenceState.getVelocities()[j], state.getVelocities()[j], TOL);
+        }
+    }
+    for (int i = 0; i < numReplicas; i++) {
+        delete contexts[i];
+        delete integrators[i];
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -339,6 +392,7 @@ int main(int argc, char* argv[]) {
         testConstrainedChain(1500);
         testInitialTemperature();
         testForceGroups();
+        testStepAsync();
         runPlatformTests();
     }
     catch(const exception& e) {
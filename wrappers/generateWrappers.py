@@ -65,10 +65,21 @@ class WrapperGenerator:
     """This is the parent class of generators for various API wrapper files.  It defines functions common to all of them."""
     
     def __init__(self, inputDirname, output):
-        self.skipClasses = ['OpenMM::Vec3', 'OpenMM::XmlSerializer', 'OpenMM::Kernel', 'OpenMM::KernelImpl', 'OpenMM::KernelFactory', 'OpenMM::ContextImpl', 'OpenMM::SerializationNode', 'OpenMM::SerializationProxy']
+        self.skipClasses = ['OpenMM::Vec3', 'OpenMM::Autotuner', 'OpenMM::ForceValidator', 'OpenMM::GridPotentialBuilder', 'OpenMM::ParticleActivator', 'OpenMM::ExternalForce', 'OpenMM::ExternalForce::Computation', 'OpenMM::ExternalForce::ComputeData', 'OpenMM::TelemetryCallback', 'OpenMM::CheckpointCompressor', 'OpenMM::XmlSerializer', 'OpenMM::Kernel', 'OpenMM::KernelImpl', 'OpenMM::KernelFactory', 'OpenMM::ContextImpl', 'OpenMM::SerializationNode', 'OpenMM::SerializationProxy']
         self.skipMethods = ['State OpenMM::Context::getState',
                             'void OpenMM::Context::createCheckpoint',
                             'void OpenMM::Context::loadCheckpoint',
+                            'void OpenMM::Context::getPositionArray',
+                            'void OpenMM::Context::setPositionArray',
+                            'void OpenMM::Context::getVelocityArray',
+                            'void OpenMM::Context::setVelocityArray',
+                            'void OpenMM::Context::getForceArray',
+                            'std::map<std::string, double> OpenMM::Context::getProfile',
+                            'std::map<std::string, double> OpenMM::Context::getNeighborListStatistics',
+                            'std::map<std::string, double> OpenMM::Platform::getMemoryUsage',
+                            'std::map<std::string, double> OpenMM::Platform::estimateMemoryUsage',
+                            'void OpenMM::Context::setTelemetryCallback',
+                            'TelemetryCallback * OpenMM::Context::getTelemetryCallback',
                             'const std::vector<std::vector<int> >& OpenMM::Context::getMolecules',
                             'static std::vector<std::string> OpenMM::Platform::getPluginLoadFailures',
                             'static std::vector<std::string> OpenMM::Platform::loadPluginsFromDirectory',
@@ -76,6 +87,8 @@ class WrapperGenerator:
                             'Vec3 OpenMM::LocalCoordinatesSite::getXWeights',
                             'Vec3 OpenMM::LocalCoordinatesSite::getYWeights',
                             'std::vector<double> OpenMM::NoseHooverChain::getYoshidaSuzukiWeights',
+                            'std::vector<double> OpenMM::Context::computeEnergiesByGroup',
+                            'std::future<void> OpenMM::Integrator::stepAsync',
                             'const std::vector<int>& OpenMM::NoseHooverIntegrator::getAllThermostatedIndividualParticles',
                             'const std::vector<std::tuple<int, int, double> >& OpenMM::NoseHooverIntegrator::getAllThermostatedPairs',
                             'virtual void OpenMM::NoseHooverIntegrator::stateChanged',
@@ -429,6 +442,11 @@ extern OPENMM_EXPORT void %(name)s_insert(%(name)s* set, %(type)s value);""" % v
    Unlike the C++ versions, the return value is allocated on the heap, and you must delete it yourself. */
 extern OPENMM_EXPORT OpenMM_State* OpenMM_Context_getState(const OpenMM_Context* target, int types, int enforcePeriodicBox);
 extern OPENMM_EXPORT OpenMM_State* OpenMM_Context_getState_2(const OpenMM_Context* target, int types, int enforcePeriodicBox, int groups);
+extern OPENMM_EXPORT void OpenMM_Context_getPositionArray(const OpenMM_Context* target, double* positions);
+extern OPENMM_EXPORT void OpenMM_Context_setPositionArray(OpenMM_Context* target, const double* positions);
+extern OPENMM_EXPORT void OpenMM_Context_getVelocityArray(const OpenMM_Context* target, double* velocities);
+extern OPENMM_EXPORT void OpenMM_Context_setVelocityArray(OpenMM_Context* target, const double* velocities);
+extern OPENMM_EXPORT void OpenMM_Context_getForceArray(const OpenMM_Context* target, double* forces, int groups);
 extern OPENMM_EXPORT OpenMM_StringArray* OpenMM_Platform_loadPluginsFromDirectory(const char* directory);
 extern OPENMM_EXPORT OpenMM_StringArray* OpenMM_Platform_getPluginLoadFailures();
 extern OPENMM_EXPORT char* OpenMM_XmlSerializer_serializeSystem(const OpenMM_System* system);
@@ -845,6 +863,21 @@ OPENMM_EXPORT OpenMM_State* OpenMM_Context_getState_2(const OpenMM_Context* targ
     State result = reinterpret_cast<const Context*>(target)->getState(types, enforcePeriodicBox, groups);
     return reinterpret_cast<OpenMM_State*>(new State(result));
 }
+OPENMM_EXPORT void OpenMM_Context_getPositionArray(const OpenMM_Context* target, double* positions) {
+    reinterpret_cast<const Context*>(target)->getPositionArray(positions);
+}
+OPENMM_EXPORT void OpenMM_Context_setPositionArray(OpenMM_Context* target, const double* positions) {
+    reinterpret_cast<Context*>(target)->setPositionArray(positions);
+}
+OPENMM_EXPORT void OpenMM_Context_getVelocityArray(const OpenMM_Context* target, double* velocities) {
+    reinterpret_cast<const Context*>(target)->getVelocityArray(velocities);
+}
+OPENMM_EXPORT void OpenMM_Context_setVelocityArray(OpenMM_Context* target, const double* velocities) {
+    reinterpret_cast<Context*>(target)->setVelocityArray(velocities);
+}
+OPENMM_EXPORT void OpenMM_Context_getForceArray(const OpenMM_Context* target, double* forces, int groups) {
+    reinterpret_cast<const Context*>(target)->getForceArray(forces, groups);
+}
 OPENMM_EXPORT OpenMM_StringArray* OpenMM_Platform_loadPluginsFromDirectory(const char* directory) {
     vector<string> result = Platform::loadPluginsFromDirectory(string(directory));
     return reinterpret_cast<OpenMM_StringArray*>(new vector<string>(result));
@@ -1379,6 +1412,32 @@ MODULE OpenMM
             integer*4 groups
             type(OpenMM_State) result
         end subroutine
+        subroutine OpenMM_Context_getPositionArray(target, positions)
+            use OpenMM_Types; implicit none
+            type (OpenMM_Context) target
+            real*8 positions(3,*)
+        end subroutine
+        subroutine OpenMM_Context_setPositionArray(target, positions)
+            use OpenMM_Types; implicit none
+            type (OpenMM_Context) target
+            real*8 positions(3,*)
+        end subroutine
+        subroutine OpenMM_Context_getVelocityArray(target, velocities)
+            use OpenMM_Types; implicit none
+            type (OpenMM_Context) target
+            real*8 velocities(3,*)
+        end subroutine
+        subroutine OpenMM_Context_setVelocityArray(target, velocities)
+            use OpenMM_Types; implicit none
+            type (OpenMM_Context) target
+            real*8 velocities(3,*)
+        end subroutine
+        subroutine OpenMM_Context_getForceArray(target, forces, groups)
+            use OpenMM_Types; implicit none
+            type (OpenMM_Context) target
+            real*8 forces(3,*)
+            integer*4 groups
+        end subroutine
         subroutine OpenMM_Platform_loadPluginsFromDirectory(directory, result)
             use OpenMM_Types; implicit none
             character(*) directory
@@ -2067,6 +2126,36 @@ OPENMM_EXPORT void openmm_context_getstate_2_(const OpenMM_Context*& target, int
 OPENMM_EXPORT void OPENMM_CONTEXT_GETSTATE_2(const OpenMM_Context*& target, int const& types, int const& enforcePeriodicBox, int const& groups, OpenMM_State*& result) {
     result = OpenMM_Context_getState_2(target, types, enforcePeriodicBox, groups);
 }
+OPENMM_EXPORT void openmm_context_getpositionarray_(const OpenMM_Context*& target, double* positions) {
+    OpenMM_Context_getPositionArray(target, positions);
+}
+OPENMM_EXPORT void OPENMM_CONTEXT_GETPOSITIONARRAY(const OpenMM_Context*& target, double* positions) {
+    OpenMM_Context_getPositionArray(target, positions);
+}
+OPENMM_EXPORT void openmm_context_setpositionarray_(OpenMM_Context*& target, const double* positions) {
+    OpenMM_Context_setPositionArray(target, positions);
+}
+OPENMM_EXPORT void OPENMM_CONTEXT_SETPOSITIONARRAY(OpenMM_Context*& target, const double* positions) {
+    OpenMM_Context_setPositionArray(target, positions);
+}
+OPENMM_EXPORT void openmm_context_getvelocityarray_(const OpenMM_Context*& target, double* velocities) {
+    OpenMM_Context_getVelocityArray(target, velocities);
+}
+OPENMM_EXPORT void OPENMM_CONTEXT_GETVELOCITYARRAY(const OpenMM_Context*& target, double* velocities) {
+    OpenMM_Context_getVelocityArray(target, velocities);
+}
+OPENMM_EXPORT void openmm_context_setvelocityarray_(OpenMM_Context*& target, const double* velocities) {
+    OpenMM_Context_setVelocityArray(target, velocities);
+}
+OPENMM_EXPORT void OPENMM_CONTEXT_SETVELOCITYARRAY(OpenMM_Context*& target, const double* velocities) {
+    OpenMM_Context_setVelocityArray(target, velocities);
+}
+OPENMM_EXPORT void openmm_context_getforcearray_(const OpenMM_Context*& target, double* forces, int const& groups) {
+    OpenMM_Context_getForceArray(target, forces, groups);
+}
+OPENMM_EXPORT void OPENMM_CONTEXT_GETFORCEARRAY(const OpenMM_Context*& target, double* forces, int const& groups) {
+    OpenMM_Context_getForceArray(target, forces, groups);
+}
 OPENMM_EXPORT void openmm_platform_loadpluginsfromdirectory_(const char* directory, OpenMM_StringArray*& result, int length) {
     result = OpenMM_Platform_loadPluginsFromDirectory(makeString(directory, length).c_str());
 }
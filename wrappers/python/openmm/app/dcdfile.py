@@ -32,12 +32,12 @@ from __future__ import absolute_import
 __author__ = "Peter Eastman"
 __version__ = "1.0"
 
-import array
+import numpy as np
 import os
 import time
 import struct
 import math
-from openmm.unit import picoseconds, nanometers, is_quantity, norm
+from openmm.unit import picoseconds, nanometers, is_quantity
 from openmm import Vec3
 from openmm.app.internal.unitcell import computeLengthsAndAngles
 
@@ -111,7 +111,8 @@ class DCDFile(object):
         Parameters
         ----------
         positions : list
-            The list of atomic positions to write
+            The list of atomic positions to write.  This may also be a numpy array of shape (number of atoms, 3),
+            which is much faster to write for large systems.
         unitCellDimensions : Vec3=None
             The dimensions of the crystallographic unit cell.
         periodicBoxVectors : tuple of Vec3=None
@@ -121,9 +122,10 @@ class DCDFile(object):
             raise ValueError('The number of positions must match the number of atoms')
         if is_quantity(positions):
             positions = positions.value_in_unit(nanometers)
-        if any(math.isnan(norm(pos)) for pos in positions):
+        positions = np.asarray(positions, dtype=np.float64).reshape((-1, 3))
+        if np.isnan(positions).any():
             raise ValueError('Particle position is NaN.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan')
-        if any(math.isinf(norm(pos)) for pos in positions):
+        if np.isinf(positions).any():
             raise ValueError('Particle position is infinite.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan')
         file = self._file
 
@@ -165,10 +167,10 @@ class DCDFile(object):
             angle3 = math.sin(math.pi/2-alpha)
             file.write(struct.pack('<i6di', 48, a_length, angle1, b_length, angle2, angle3, c_length, 48))
         length = struct.pack('<i', 4*len(positions))
+        coords = (10*positions).astype('<f4').T
         for i in range(3):
             file.write(length)
-            data = array.array('f', (10*x[i] for x in positions))
-            data.tofile(file)
+            file.write(coords[i].tobytes())
             file.write(length)
         try:
             file.flush()
@@ -1388,6 +1388,12 @@ class ForceField(object):
         """Return a list of which template matches each residue in the topology, and assign atom types."""
         templateForResidue = [None]*topology.getNumResidues()
         unmatchedResidues = []
+
+        # Residues whose atoms and bonds are identical always match the same template in the same way, so
+        # remember the matches that have been found.  This is only safe when there are no custom template
+        # matchers, since they may look at anything.
+
+        matchCache = ({} if len(self._templateMatchers) == 0 else None)
         for chain in topology.chains():
             for res in chain.residues():
                 if res in residueTemplates:
@@ -1396,6 +1402,14 @@ class ForceField(object):
                     matches = compiled.matchResidueToTemplate(res, template, data.bondedToAtom, ignoreExternalBonds, ignoreExtraParticles)
                     if matches is None:
                         raise Exception('User-supplied template %s does not match the residue %d (%s)' % (tname, res.index+1, res.name))
+                elif matchCache is not None:
+                    key = _createResidueMatchKey(res, data.bondedToAtom, ignoreExternalBonds)
+                    if key in matchCache:
+                        [template, matches] = matchCache[key]
+                    else:
+                        [template, matches] = self._getResidueTemplateMatches(res, data.bondedToAtom, ignoreExternalBonds=ignoreExternalBonds, ignoreExtraParticles=ignoreExtraParticles)
+                        if matches is not None:
+                            matchCache[key] = [template, matches]
                 else:
                     # Attempt to match one of the existing templates.
                     [template, matches] = self._getResidueTemplateMatches(res, data.bondedToAtom, ignoreExternalBonds=ignoreExternalBonds, ignoreExtraParticles=ignoreExtraParticles)
@@ -1542,6 +1556,22 @@ def _countResidueAtoms(elements):
     return counts
 
 
+def _createResidueMatchKey(res, bondedToAtom, ignoreExternalBonds):
+    """Create a key for a residue, such that residues with equal keys are guaranteed to match templates in the
+    same way.  It records the name and element of every atom, the bonds between them, and the number of external
+    bonds each one has."""
+    atoms = list(res.atoms())
+    localIndex = {}
+    for i, atom in enumerate(atoms):
+        localIndex[atom.index] = i
+    key = []
+    for atom in atoms:
+        bonds = tuple(localIndex[x] for x in bondedToAtom[atom.index] if x in localIndex)
+        externalBonds = 0 if ignoreExternalBonds else len(bondedToAtom[atom.index])-len(bonds)
+        key.append((atom.name, atom.element, bonds, externalBonds))
+    return tuple(key)
+
+
 def _createResidueSignature(elements):
     """Create a signature for a residue based on the elements of the atoms it contains."""
     counts = _countResidueAtoms(elements)
@@ -5209,6 +5239,9 @@ class AmoebaMultipoleGenerator(object):
         if ('mutualInducedTargetEpsilon' in args):
             force.setMutualInducedTargetEpsilon(float(args['mutualInducedTargetEpsilon']))
 
+        if ('mutualInducedUpdateInterval' in args):
+            force.setMutualInducedUpdateInterval(int(args['mutualInducedUpdateInterval']))
+
         # add particles to force
         # throw error if particle type not available
 
@@ -5803,6 +5836,9 @@ class AmoebaGeneralizedKirkwoodGenerator(object):
             else:
                force.setIncludeCavityTerm(   int(self.includeCavityTerm))
 
+            if ('bornRadiusUpdateInterval' in args):
+                force.setBornRadiusUpdateInterval(int(args['bornRadiusUpdateInterval']))
+
         else:
             force = existing[0]
 
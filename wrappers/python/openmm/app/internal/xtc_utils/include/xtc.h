@@ -25,8 +25,20 @@ Contributors: Stefan Doerr, Raul P. Pelaez
 */
 #ifndef XTC
 #define XTC
-#include "xdrfile.h"
+#include "xdrfile/xdrfile.h"
 #include<string>
+#include<vector>
+#include<cstdint>
+// Get the byte offset of each frame in a trajectory file.  This only reads the frame
+// headers, so it is much faster than decoding the file.  If the file has a sidecar index
+// (see xtc_write_index()), only frames added since it was last updated are scanned, and
+// the index is brought up to date.
+std::vector<int64_t> xtc_frame_offsets(std::string filename);
+
+// Create a sidecar index (filename + ".idx") recording the offset of every frame.  Once
+// it exists, it is used and kept up to date by all the other functions.
+void xtc_write_index(std::string filename);
+
 // Get the number of frames in a trajectory file
 int xtc_nframes(std::string filename);
 
@@ -37,10 +49,15 @@ int xtc_natoms(std::string filename);
 // the data. Each array must be allocated with the correct size.
 void xtc_read(std::string filename, float* coords_arr, float* box_arr, float* time_arr, int* step_arr, int natoms, int nframes);
 
+// Reads a selected set of frames from an xtc file.  frames contains nframes frame indices,
+// and the arrays are filled in the same layout as xtc_read().
+void xtc_read_frames(std::string filename, float* coords_arr, float* box_arr, float* time_arr, int* step_arr, int natoms, const int* frames, int nframes);
+
 // Appends a trajectory to a file.
 void xtc_write(std::string filename, int natoms, int nframes, int* step, float* timex, float* pos, float* box);
 
 // Rewrites a trajectory file with a new timestep and starting step number.
-// Useful when the step number is larger than 2^32.
+// Useful when the step number is larger than 2^32.  Only the frame headers are
+// modified.  filename_out may be the same as filename_in to update the file in place.
 void xtc_rewrite_with_new_timestep(std::string filename_in, std::string filename_out, int first_step, int interval, float dt);
 #endif
@@ -24,7 +24,13 @@ SOFTWARE.
 Contributors: Stefan Doerr, Raul P. Pelaez
 */
 #include "xtc.h"
-#include "xdrfile_xtc.h"
+#include "xdrfile/xdrfile_xtc.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <thread>
 #include <vector>
 #include <string>
 #include <stdexcept>
@@ -42,6 +48,32 @@ static size_t Zf(size_t yidx, size_t nframes) {
     return yidx + nframes;
 }
 
+// 64 bit file positioning, so trajectories larger than 2 GB can be indexed
+static int seek_file(FILE* fp, int64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(fp, offset, whence);
+#else
+    return fseeko(fp, (off_t) offset, whence);
+#endif
+}
+
+static int64_t tell_file(FILE* fp) {
+#ifdef _WIN32
+    return _ftelli64(fp);
+#else
+    return (int64_t) ftello(fp);
+#endif
+}
+
+// Read a big endian (XDR) integer
+static bool read_xdr_int(FILE* fp, int& value) {
+    unsigned char b[4];
+    if (fread(b, 1, 4, fp) != 4)
+        return false;
+    value = (int) (((unsigned int) b[0] << 24) | ((unsigned int) b[1] << 16) | ((unsigned int) b[2] << 8) | b[3]);
+    return true;
+}
+
 // Helper struct to manage the XDRFILE pointer
 struct XDRFILE_RAII {
     XDRFILE* xd;
@@ -51,6 +83,12 @@ struct XDRFILE_RAII {
         }
     }
 
+    explicit XDRFILE_RAII(XDRFILE* xd) : xd(xd) {
+        if (!xd) {
+            throw std::runtime_error("xtc file: Could not open temporary file");
+        }
+    }
+
     ~XDRFILE_RAII() {
         if (xd)
             xdrfile_close(xd);
@@ -61,6 +99,42 @@ struct XDRFILE_RAII {
     }
 };
 
+// Get the number of threads to use for processing a set of frames
+static int num_frame_threads(int nframes) {
+    int threads = std::max(1, (int) std::thread::hardware_concurrency());
+    return std::max(1, std::min(threads, nframes));
+}
+
+// Process a set of frames in parallel.  Frames are divided into numThreads contiguous
+// blocks, and func(block, start, end) is called for each one.  Any exception thrown by a
+// block is rethrown once all of them have finished.
+template <class F>
+static void for_each_frame_block(int nframes, int numThreads, F func) {
+    if (numThreads == 1) {
+        func(0, 0, nframes);
+        return;
+    }
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(numThreads);
+    for (int t = 0; t < numThreads; t++) {
+        int start = (int) ((int64_t) nframes * t / numThreads);
+        int end = (int) ((int64_t) nframes * (t + 1) / numThreads);
+        threads.emplace_back([&func, &errors, t, start, end]() {
+            try {
+                func(t, start, end);
+            }
+            catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
 int xtc_natoms(std::string filename) {
     int natoms = 0;
     if (exdrOK != read_xtc_natoms(const_cast<char*>(filename.c_str()), &natoms)) {
@@ -81,7 +155,8 @@ struct XTCFrame {
 
     // Read the next frame from the XTC file and store it in this object
     int readNextFrame(XDRFILE* xd) {
-        float in_prec;
+        // Frames with very few atoms are stored uncompressed and do not record a precision.
+        float in_prec = prec;
         auto* p_ptr = reinterpret_cast<rvec*>(positions.data());
         int status = read_xtc(xd, natoms, &step, &time, box, p_ptr, &in_prec);
         if (status == exdrOK && prec != in_prec) {
@@ -104,45 +179,194 @@ struct XTCFrame {
     }
 };
 
+// Scan the frame headers starting from a given offset, appending the offset of every
+// complete frame.  Returns the offset just past the last complete frame.
+static int64_t scan_frame_offsets(FILE* fp, int64_t offset, int64_t fileSize, std::vector<int64_t>& offsets) {
+    if (seek_file(fp, offset, SEEK_SET) != 0)
+        return offset;
+    int magic;
+    while (read_xdr_int(fp, magic)) {
+        // Each frame has a header (magic number, atom count, step, time), the box, and the
+        // atom count again.  Small frames are followed by uncompressed coordinates, larger
+        // ones by the compression parameters and a length prefixed block of bytes.
+
+        int natoms, lsize, nbytes;
+        if (magic != 1995 || !read_xdr_int(fp, natoms) || seek_file(fp, 8 + 36, SEEK_CUR) != 0 || !read_xdr_int(fp, lsize)) {
+            throw std::runtime_error("xtc_read(): XTC file is corrupt\n");
+        }
+        int64_t frameSize = 56;
+        if (lsize <= 9)
+            frameSize += 12 * (int64_t) lsize;
+        else {
+            if (seek_file(fp, 32, SEEK_CUR) != 0 || !read_xdr_int(fp, nbytes) || nbytes < 0) {
+                throw std::runtime_error("xtc_read(): XTC file is corrupt\n");
+            }
+            frameSize += 36 + (nbytes + 3) / 4 * 4;
+        }
+        if (offset + frameSize > fileSize)
+            break; // The last frame is incomplete.
+        offsets.push_back(offset);
+        offset += frameSize;
+        if (seek_file(fp, offset, SEEK_SET) != 0)
+            break;
+    }
+    return offset;
+}
+
+// Check whether a frame starts at the given offset
+static bool is_frame_start(FILE* fp, int64_t offset) {
+    int magic;
+    return (seek_file(fp, offset, SEEK_SET) == 0 && read_xdr_int(fp, magic) && magic == 1995);
+}
+
+// The sidecar index stores a magic string, the offset just past the last indexed frame,
+// the number of frames, and their offsets, all as native 64 bit integers.
+static const char INDEX_MAGIC[8] = {'X', 'T', 'C', 'I', 'D', 'X', '0', '1'};
+
+static std::string index_filename(const std::string& filename) {
+    return filename + ".idx";
+}
+
+static bool load_index(const std::string& filename, std::vector<int64_t>& offsets, int64_t& end) {
+    FILE* fp = fopen(index_filename(filename).c_str(), "rb");
+    if (!fp)
+        return false;
+    char magic[8];
+    int64_t count;
+    bool valid = (fread(magic, 1, 8, fp) == 8 && std::equal(magic, magic + 8, INDEX_MAGIC) &&
+                  fread(&end, sizeof(int64_t), 1, fp) == 1 && fread(&count, sizeof(int64_t), 1, fp) == 1 && count >= 0);
+    if (valid) {
+        offsets.resize(count);
+        valid = (count == 0 || fread(offsets.data(), sizeof(int64_t), count, fp) == (size_t) count);
+    }
+    fclose(fp);
+    if (!valid)
+        offsets.clear();
+    return valid;
+}
+
+static void save_index(const std::string& filename, const std::vector<int64_t>& offsets, int64_t end) {
+    FILE* fp = fopen(index_filename(filename).c_str(), "wb");
+    if (!fp) {
+        throw std::runtime_error("xtc file: Could not write index file");
+    }
+    int64_t count = offsets.size();
+    bool ok = (fwrite(INDEX_MAGIC, 1, 8, fp) == 8 && fwrite(&end, sizeof(int64_t), 1, fp) == 1 && fwrite(&count, sizeof(int64_t), 1, fp) == 1);
+    ok = ok && (count == 0 || fwrite(offsets.data(), sizeof(int64_t), count, fp) == (size_t) count);
+    if (fclose(fp) != 0 || !ok) {
+        throw std::runtime_error("xtc file: Could not write index file");
+    }
+}
+
+// Build the list of frame offsets.  If there is a sidecar index that is consistent with the
+// file, only frames that were appended since it was written need to be scanned, and the
+// index is updated to include them.
+static std::vector<int64_t> get_frame_offsets(const std::string& filename, bool createIndex) {
+    FILE* fp = fopen(filename.c_str(), "rb");
+    if (!fp) {
+        throw std::runtime_error("xtc file: Could not open file");
+    }
+    std::vector<int64_t> offsets;
+    seek_file(fp, 0, SEEK_END);
+    int64_t fileSize = tell_file(fp);
+    int64_t indexEnd = 0;
+    bool hasIndex = load_index(filename, offsets, indexEnd);
+    if (hasIndex) {
+        bool valid = (indexEnd <= fileSize);
+        valid = valid && (offsets.empty() || (offsets[0] == 0 && is_frame_start(fp, offsets.back())));
+        valid = valid && (indexEnd == fileSize || is_frame_start(fp, indexEnd));
+        if (!valid) {
+            offsets.clear();
+            indexEnd = 0;
+        }
+    }
+    size_t indexedFrames = offsets.size();
+    int64_t end;
+    try {
+        end = scan_frame_offsets(fp, indexEnd, fileSize, offsets);
+    }
+    catch (...) {
+        fclose(fp);
+        throw;
+    }
+    fclose(fp);
+    if (createIndex || (hasIndex && (offsets.size() != indexedFrames || end != indexEnd)))
+        save_index(filename, offsets, end);
+    return offsets;
+}
+
+std::vector<int64_t> xtc_frame_offsets(std::string filename) {
+    return get_frame_offsets(filename, false);
+}
+
+void xtc_write_index(std::string filename) {
+    get_frame_offsets(filename, true);
+}
+
 int xtc_nframes(std::string filename) {
-    int nframes = 0;
     int natoms = xtc_natoms(filename);
     if (!natoms) {
         throw std::runtime_error("xtc_read(): natoms is 0\n");
     }
-    XDRFILE_RAII xd(filename, "r");
-    XTCFrame frame(natoms);
-    while (exdrOK == frame.readNextFrame(xd)) {
-        nframes++;
-    }
-    return nframes;
+    return (int) xtc_frame_offsets(filename).size();
+}
+
+// Decode the frames at a list of offsets into frame-major arrays, dividing them between threads.
+static void read_frames_at(const std::string& filename, const std::vector<int64_t>& offsets, float* coords_arr, float* box_arr, float* time_arr, int* step_arr, int natoms, int nframes) {
+    int count = std::min(nframes, (int) offsets.size());
+    for_each_frame_block(count, num_frame_threads(count), [&](int block, int start, int end) {
+        if (start == end)
+            return;
+        XDRFILE_RAII xd(filename, "r");
+        XTCFrame frame(natoms);
+        for (int fidx = start; fidx < end; fidx++) {
+            // Only seek when the frames are not consecutive, so sequential reads keep the stdio buffer.
+
+            if ((fidx == start || offsets[fidx] != tell_file(xd.xd->fp)) && seek_file(xd.xd->fp, offsets[fidx], SEEK_SET) != 0) {
+                throw std::runtime_error("xtc_read(): could not seek to frame\n");
+            }
+            if (frame.readNextFrame(xd) != exdrOK) {
+                throw std::runtime_error("xtc_read(): could not read frame\n");
+            }
+            time_arr[fidx] = frame.time;
+            step_arr[fidx] = frame.step;
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    box_arr[fidx + (3 * i + j) * nframes] = frame.box[i][j];
+                }
+            }
+            for (int aidx = 0; aidx < natoms; aidx++) {
+                size_t xidx = Xf(aidx, fidx, nframes);
+                size_t yidx = Yf(xidx, nframes);
+                size_t zidx = Zf(yidx, nframes);
+                coords_arr[xidx] = frame.positions[3 * aidx + 0];
+                coords_arr[yidx] = frame.positions[3 * aidx + 1];
+                coords_arr[zidx] = frame.positions[3 * aidx + 2];
+            }
+        }
+    });
 }
 
 void xtc_read(std::string filename, float* coords_arr, float* box_arr, float* time_arr, int* step_arr, int natoms, int nframes) {
     if (natoms == 0) {
         throw std::runtime_error("xtc_read(): natoms is 0\n");
     }
-    XDRFILE_RAII xd(filename, "r");
-    int fidx = 0;
-    XTCFrame frame(natoms);
-    while (exdrOK == frame.readNextFrame(xd)) {
-        time_arr[fidx] = frame.time;
-        step_arr[fidx] = frame.step;
-        for (int i = 0; i < 3; i++) {
-            for (int j = 0; j < 3; j++) {
-                box_arr[fidx + (3 * i + j) * nframes] = frame.box[i][j];
-            }
-        }
-        for (int aidx = 0; aidx < natoms; aidx++) {
-            int xidx = Xf(aidx, fidx, nframes);
-            int yidx = Yf(xidx, nframes);
-            int zidx = Zf(yidx, nframes);
-            coords_arr[xidx] = frame.positions[3 * aidx + 0];
-            coords_arr[yidx] = frame.positions[3 * aidx + 1];
-            coords_arr[zidx] = frame.positions[3 * aidx + 2];
+    read_frames_at(filename, xtc_frame_offsets(filename), coords_arr, box_arr, time_arr, step_arr, natoms, nframes);
+}
+
+void xtc_read_frames(std::string filename, float* coords_arr, float* box_arr, float* time_arr, int* step_arr, int natoms, const int* frames, int nframes) {
+    if (natoms == 0) {
+        throw std::runtime_error("xtc_read(): natoms is 0\n");
+    }
+    std::vector<int64_t> allOffsets = xtc_frame_offsets(filename);
+    std::vector<int64_t> offsets(nframes);
+    for (int i = 0; i < nframes; i++) {
+        if (frames[i] < 0 || frames[i] >= (int) allOffsets.size()) {
+            throw std::runtime_error("xtc_read(): frame index out of range\n");
         }
-        fidx++;
+        offsets[i] = allOffsets[frames[i]];
     }
+    read_frames_at(filename, offsets, coords_arr, box_arr, time_arr, step_arr, natoms, nframes);
 }
 
 static void box_from_array(matrix& matrix_box, float* box, int frame, int nframes) {
@@ -153,38 +377,124 @@ static void box_from_array(matrix& matrix_box, float* box, int frame, int nframe
     }
 }
 
+// Fill in an XTCFrame with the data for one frame of the input arrays
+static void frame_from_arrays(XTCFrame& frame, int f, int natoms, int nframes, int* step, float* timex, float* pos, float* box) {
+    box_from_array(frame.box, box, f, nframes);
+    for (int i = 0; i < natoms; i++) {
+        size_t xidx = Xf(i, f, nframes);
+        size_t yidx = Yf(xidx, nframes);
+        size_t zidx = Zf(yidx, nframes);
+        frame.positions[3 * i + 0] = pos[xidx];
+        frame.positions[3 * i + 1] = pos[yidx];
+        frame.positions[3 * i + 2] = pos[zidx];
+    }
+    frame.step = step[f];
+    frame.time = timex[f];
+}
+
 void xtc_write(std::string filename, int natoms, int nframes, int* step, float* timex, float* pos, float* box) {
-    XDRFILE_RAII xd(filename, "a");
-    XTCFrame frame(natoms);
-    for (int f = 0; f < nframes; f++) {
-        box_from_array(frame.box, box, f, nframes);
-        for (int i = 0; i < natoms; i++) {
-            int xidx = Xf(i, f, nframes);
-            int yidx = Yf(xidx, nframes);
-            int zidx = Zf(yidx, nframes);
-            frame.positions[3 * i + 0] = pos[xidx];
-            frame.positions[3 * i + 1] = pos[yidx];
-            frame.positions[3 * i + 2] = pos[zidx];
+    int numThreads = num_frame_threads(nframes);
+    if (numThreads == 1) {
+        XDRFILE_RAII xd(filename, "a");
+        XTCFrame frame(natoms);
+        for (int f = 0; f < nframes; f++) {
+            frame_from_arrays(frame, f, natoms, nframes, step, timex, pos, box);
+            frame.appendFrameToFile(xd);
         }
-        frame.step = step[f];
-        frame.time = timex[f];
-        frame.appendFrameToFile(xd);
+    }
+    else {
+        // Compress blocks of frames in parallel into temporary files, then append them to the
+        // output in order.
+
+        std::vector<std::unique_ptr<XDRFILE_RAII> > blocks(numThreads);
+        for_each_frame_block(nframes, numThreads, [&](int block, int start, int end) {
+            blocks[block].reset(new XDRFILE_RAII(xdrfile_tmpfile()));
+            XTCFrame frame(natoms);
+            for (int f = start; f < end; f++) {
+                frame_from_arrays(frame, f, natoms, nframes, step, timex, pos, box);
+                frame.appendFrameToFile(*blocks[block]);
+            }
+        });
+        FILE* out = fopen(filename.c_str(), "ab");
+        if (!out) {
+            throw std::runtime_error("xtc file: Could not open file");
+        }
+        std::vector<char> buffer(1 << 20);
+        bool ok = true;
+        for (auto& block : blocks) {
+            FILE* in = block->xd->fp;
+            ok = ok && fflush(in) == 0 && seek_file(in, 0, SEEK_SET) == 0;
+            size_t n;
+            while (ok && (n = fread(buffer.data(), 1, buffer.size(), in)) > 0)
+                ok = (fwrite(buffer.data(), 1, n, out) == n);
+        }
+        if (fclose(out) != 0 || !ok) {
+            throw std::runtime_error("xtc_write(): could not write frame\n");
+        }
+    }
+
+    // If the file has an index, add the new frames to it.
+
+    FILE* index = fopen(index_filename(filename).c_str(), "rb");
+    if (index) {
+        fclose(index);
+        xtc_frame_offsets(filename);
     }
 }
 
+// Write a big endian (XDR) integer or float at a position in a file
+static bool write_xdr_int(FILE* fp, int64_t offset, unsigned int value) {
+    unsigned char b[4] = {(unsigned char) (value >> 24), (unsigned char) (value >> 16), (unsigned char) (value >> 8), (unsigned char) value};
+    return (seek_file(fp, offset, SEEK_SET) == 0 && fwrite(b, 1, 4, fp) == 4);
+}
+
 void xtc_rewrite_with_new_timestep(std::string filename_in, std::string filename_out, int first_step, int interval, float dt) {
     int natoms = xtc_natoms(filename_in);
     if (natoms == 0) {
         throw std::runtime_error("xtc_read(): natoms is 0\n");
     }
-    XDRFILE_RAII xd_in(filename_in, "r");
-    XDRFILE_RAII xd_out(filename_out, "a");
-    XTCFrame frame(natoms);
-    int i = 0;
-    while (exdrOK == frame.readNextFrame(xd_in)) {
-        frame.step = first_step + i * interval;
-        frame.time = frame.step * dt;
-        frame.appendFrameToFile(xd_out);
-        i++;
+
+    // The step and time are fixed size fields in each frame header, so the frames do not
+    // need to be decompressed.  Copy the data to the output file (unless the file is being
+    // modified in place), then overwrite the headers.
+
+    std::vector<int64_t> offsets = xtc_frame_offsets(filename_in);
+    int64_t start = 0;
+    if (filename_in != filename_out) {
+        FILE* in = fopen(filename_in.c_str(), "rb");
+        FILE* out = fopen(filename_out.c_str(), "ab");
+        if (!in || !out) {
+            if (in)
+                fclose(in);
+            if (out)
+                fclose(out);
+            throw std::runtime_error("xtc file: Could not open file");
+        }
+        seek_file(out, 0, SEEK_END);
+        start = tell_file(out);
+        std::vector<char> buffer(1 << 20);
+        bool ok = true;
+        size_t n;
+        while (ok && (n = fread(buffer.data(), 1, buffer.size(), in)) > 0)
+            ok = (fwrite(buffer.data(), 1, n, out) == n);
+        fclose(in);
+        if (fclose(out) != 0 || !ok) {
+            throw std::runtime_error("xtc_write(): could not write frame\n");
+        }
+    }
+    FILE* out = fopen(filename_out.c_str(), "r+b");
+    if (!out) {
+        throw std::runtime_error("xtc file: Could not open file");
+    }
+    bool ok = true;
+    for (size_t i = 0; i < offsets.size() && ok; i++) {
+        int step = first_step + (int) i * interval;
+        float time = step * dt;
+        unsigned int timeBits;
+        memcpy(&timeBits, &time, sizeof(float));
+        ok = write_xdr_int(out, start + offsets[i] + 8, (unsigned int) step) && write_xdr_int(out, start + offsets[i] + 12, timeBits);
+    }
+    if (fclose(out) != 0 || !ok) {
+        throw std::runtime_error("xtc_write(): could not write frame\n");
     }
 }
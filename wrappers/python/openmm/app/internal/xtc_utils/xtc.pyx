@@ -94,6 +94,61 @@ def read_xtc(string filename):
     )
     return np.asarray(coords), np.asarray(box), np.asarray(time), np.asarray(step)
 
+def read_xtc_frames(string filename, frames):
+    """
+    Reads a selected set of frames from a xtc file.  Frames are located with an index of their
+    offsets, so this does not need to decode the frames that are not requested.
+
+    Parameters
+    ----------
+    filename: string
+        The filename of the xtc file. You need to pass the string with filename.encode("UTF-8") to this function
+    frames: list of int
+        The indices of the frames to read
+    Returns
+    -------
+    coords: np.ndarray
+        The coordinates of the atoms in the selected frames. Shape: (n_atoms, 3, len(frames))
+    box: np.ndarray
+        The box vectors of the selected frames. Shape: (3, 3, len(frames))
+    time: np.ndarray
+        The time of each selected frame. Shape: (len(frames),)
+    step: np.ndarray
+        The step of each selected frame. Shape: (len(frames),)
+    """
+    cdef int natoms = get_xtc_natoms(filename)
+    cdef int[::1] indices = np.ascontiguousarray(frames, dtype=np.int32)
+    cdef int nframes = indices.shape[0]
+
+    cdef FLOAT32_t[:, :, ::1] coords = np.zeros((natoms, 3, nframes), dtype=np.float32)
+    cdef FLOAT32_t[:, :, ::1] box = np.zeros((3, 3, nframes), dtype=np.float32)
+    cdef FLOAT32_t[::1] time = np.zeros(nframes, dtype=np.float32)
+    cdef int[::1] step = np.zeros(nframes, dtype=np.int32)
+    if nframes > 0:
+        xtclib.xtc_read_frames(
+            filename,
+            &coords[0, 0, 0],
+            &box[0, 0, 0],
+            &time[0],
+            &step[0],
+            natoms,
+            &indices[0],
+            nframes,
+        )
+    return np.asarray(coords), np.asarray(box), np.asarray(time), np.asarray(step)
+
+def xtc_write_index(string filename):
+    """
+    Create a sidecar index (the filename with ".idx" appended) recording the offset of every frame
+    in a xtc file.  Once it exists, it is kept up to date when frames are appended, and it allows
+    the frame count and individual frames to be found without scanning the whole file.
+    Parameters
+    ----------
+    filename: string
+        The filename of the xtc file. You need to pass the string with filename.encode("UTF-8") to this function
+    """
+    xtclib.xtc_write_index(filename)
+
 def xtc_write_frame(string filename, float[:, :] coords, float[:, :] box, float time, int step):
     """
     Appends a single frame to a xtc file (if the file does not exist it is created by this function).
@@ -126,7 +181,8 @@ def xtc_write_frame(string filename, float[:, :] coords, float[:, :] box, float
 def xtc_rewrite_with_new_timestep(string filename_in, string filename_out,
 				  int first_step, int interval, float dt):
     """
-    Rewrites a trajectory file with a new timestep and starting step number.
+    Rewrites a trajectory file with a new timestep and starting step number.  Only the frame
+    headers are modified, and filename_out may be the same as filename_in to update the file in place.
     Parameters
     ----------
     filename_in: string
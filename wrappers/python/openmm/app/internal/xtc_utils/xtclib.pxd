@@ -26,6 +26,8 @@ cdef extern from "include/xtc.h":
     cdef int xtc_nframes(string filename) except +
     cdef int xtc_natoms(string filename) except +
     cdef void xtc_read(string filename, float *coords_arr, float *box_arr, float *time_arr, int *step_arr, int natoms, int nframes) except +
+    cdef void xtc_read_frames(string filename, float *coords_arr, float *box_arr, float *time_arr, int *step_arr, int natoms, const int *frames, int nframes) except +
+    cdef void xtc_write_index(string filename) except +
     cdef void xtc_write(string filename, int natoms, int nframes, int *step, float *timex, float *pos, float *box) except +
     cdef void xtc_rewrite_with_new_timestep(string filename_in, string filename_out,
 				  int first_step, int interval, float dt) except +
@@ -560,14 +560,14 @@ class Modeller(object):
             center = [(max((pos[i] for pos in positions))+min((pos[i] for pos in positions)))/2 for i in range(3)]
             center = Vec3(center[0], center[1], center[2])
         numBoxes = [int(ceil(box[i]/pdbBoxSize[i])) for i in range(3)]
+        oxygenIndex = [[atom.index for atom in residue.atoms() if atom.element == elem.oxygen][0] for residue in pdbResidues]
         addedWaters = []
         for boxx in range(numBoxes[0]):
             for boxy in range(numBoxes[1]):
                 for boxz in range(numBoxes[2]):
                     offset = Vec3(boxx*pdbBoxSize[0], boxy*pdbBoxSize[1], boxz*pdbBoxSize[2])
                     for residue in pdbResidues:
-                        oxygen = [atom for atom in residue.atoms() if atom.element == elem.oxygen][0]
-                        atomPos = pdbPositions[oxygen.index]+offset
+                        atomPos = pdbPositions[oxygenIndex[residue.index]]+offset
                         if not any((atomPos[i] > box[i] for i in range(3))):
                             # This molecule is inside the box, so see how close to it is to the solute.
 
@@ -623,8 +623,7 @@ class Modeller(object):
         for index, pos in addedWaters:
             newResidue = newTopology.addResidue(residue.name, newChain)
             residue = pdbResidues[index]
-            oxygen = [atom for atom in residue.atoms() if atom.element == elem.oxygen][0]
-            oPos = pdbPositions[oxygen.index]
+            oPos = pdbPositions[oxygenIndex[index]]
             molAtoms = []
             for atom in residue.atoms():
                 molAtoms.append(newTopology.addAtom(atom.name, atom.element, newResidue))
@@ -1608,6 +1607,7 @@ class _CellList(object):
         self.cellSize = tuple((vectors[i][i]/self.numCells[i] for i in range(3)))
         self.vectors = vectors
         self.periodic = periodic
+        self.triclinic = any(vectors[i][j] != 0 for i in range(3) for j in range(3) if i != j)
         invBox = Vec3(1.0/vectors[0][0], 1.0/vectors[1][1], 1.0/vectors[2][2])
         for i in range(len(self.positions)):
             pos = self.positions[i]
@@ -1632,6 +1632,24 @@ class _CellList(object):
 
     def neighbors(self, pos):
         offsets = (-1, 0, 1)
+        if not (self.periodic and self.triclinic):
+            # Wrapping a point into the box only shifts it by whole box widths along each axis, so the neighboring
+            # cells can be found by offsetting the indices of the cell containing it.  Visit each cell once, even
+            # if there are fewer than three cells along an axis.
+
+            cell = self.cellForPosition(pos)
+            visited = set()
+            for i in offsets:
+                for j in offsets:
+                    for k in offsets:
+                        neighbor = ((cell[0]+i)%self.numCells[0], (cell[1]+j)%self.numCells[1], (cell[2]+k)%self.numCells[2])
+                        if neighbor in visited:
+                            continue
+                        visited.add(neighbor)
+                        if neighbor in self.cells:
+                            for atom in self.cells[neighbor]:
+                                yield atom
+            return
         for i in offsets:
             for j in offsets:
                 for k in offsets:
@@ -176,7 +176,7 @@ class SimulatedTempering(object):
                 steps2 = st.reportInterval - simulation.currentStep%st.reportInterval
                 steps = min(steps1, steps2)
                 isUpdateAttempt = (steps1 == steps)
-                return (steps, False, isUpdateAttempt, False, isUpdateAttempt)
+                return (steps, False, False, False, isUpdateAttempt)
 
             def report(self, simulation, state):
                 st = self.st
@@ -219,13 +219,15 @@ class SimulatedTempering(object):
         for j in range(len(probability)):
             if r < probability[j]:
                 if j != self.currentTemperature:
-                    # Rescale the velocities.
+                    # Rescale the velocities.  Most attempts do not change the temperature, so the velocities
+                    # are only retrieved once a change has been accepted.
                     
                     scale = math.sqrt(self.temperatures[j]/self.temperatures[self.currentTemperature])
+                    velocityState = self.simulation.context.getState(getVelocities=True)
                     if have_numpy:
-                        velocities = scale*state.getVelocities(asNumpy=True).value_in_unit(unit.nanometers/unit.picoseconds)
+                        velocities = scale*velocityState.getVelocities(asNumpy=True).value_in_unit(unit.nanometers/unit.picoseconds)
                     else:
-                        velocities = [v*scale for v in state.getVelocities().value_in_unit(unit.nanometers/unit.picoseconds)]
+                        velocities = [v*scale for v in velocityState.getVelocities().value_in_unit(unit.nanometers/unit.picoseconds)]
                     self.simulation.context.setVelocities(velocities)
 
                     # Select this temperature.
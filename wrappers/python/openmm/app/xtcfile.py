@@ -14,8 +14,6 @@ import os
 from openmm import Vec3
 from openmm.unit import nanometers, femtoseconds, is_quantity, norm
 import math
-import tempfile
-import shutil
 
 
 class XTCFile(object):
@@ -112,16 +110,13 @@ class XTCFile(object):
             self._firstStep //= self._interval
             self._dt *= self._interval
             self._interval = 1
-            with tempfile.TemporaryDirectory() as temp:
-                fname = os.path.join(temp, "temp.xtc")
-                xtc_rewrite_with_new_timestep(
-                    self._filename.encode("utf-8"),
-                    fname.encode("utf-8"),
-                    self._firstStep,
-                    self._interval,
-                    self._dt,
-                )
-                shutil.copyfile(fname, self._filename)
+            xtc_rewrite_with_new_timestep(
+                self._filename.encode("utf-8"),
+                self._filename.encode("utf-8"),
+                self._firstStep,
+                self._interval,
+                self._dt,
+            )
         boxVectors = self._topology.getPeriodicBoxVectors()
         if boxVectors is not None:
             if periodicBoxVectors is not None:
@@ -229,21 +229,21 @@ def buildKeywordDictionary(major_version_num=MAJOR_VERSION_NUM,
     setupKeywords["ext_modules"] = [Extension(**extensionArgs)]
     setupKeywords["ext_modules"] += cythonize('openmm/app/internal/*.pyx')
 
-    setupKeywords["ext_modules"] +=cythonize(Extension(
-        "openmm.app.internal.xtc_utils",
-        sources=[
-            "openmm/app/internal/xtc_utils/src/xdrfile_xtc.cpp",
-            "openmm/app/internal/xtc_utils/src/xdrfile.cpp",
-            "openmm/app/internal/xtc_utils/src/xtc.cpp",
-            "openmm/app/internal/xtc_utils/xtc.pyx",
-        ],
-        include_dirs=include_dirs +[
-            "openmm/app/internal/xtc_utils/include",
-            "openmm/app/internal/xtc_utils/",
-            numpy.get_include(),
-        ],
-        language="c++",
-    ))
+    # The XTC compression code is part of the OpenMM library, so link to it rather than compiling it again.
+
+    xtcArgs = {"name": "openmm.app.internal.xtc_utils",
+               "sources": ["openmm/app/internal/xtc_utils/src/xtc.cpp",
+                           "openmm/app/internal/xtc_utils/xtc.pyx"],
+               "include_dirs": include_dirs+["openmm/app/internal/xtc_utils/include",
+                                             "openmm/app/internal/xtc_utils/"],
+               "library_dirs": library_dirs,
+               "libraries": libraries[:1],
+               "extra_compile_args": extra_compile_args,
+               "extra_link_args": extra_link_args,
+               "language": "c++"}
+    if platform.system() != "Windows":
+        xtcArgs["runtime_library_dirs"] = library_dirs
+    setupKeywords["ext_modules"] += cythonize(Extension(**xtcArgs))
 
     outputString = ''
     firstTab     = 40
@@ -19,6 +19,15 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('StateBuilder',),
                 ('Vec3',),
                 ('OpenMMException',),
+                ('CheckpointCompressor',),
+                ('Autotuner',),
+                ('ForceValidator',),
+                ('GridPotentialBuilder',),
+                ('ParticleActivator',),
+                ('ExternalForce',),
+                ('Computation',),
+                ('ComputeData',),
+                ('TelemetryCallback',),
                 ('AngleInfo',),
                 ('ApplyAndersenThermostatKernel',),
                 ('ApplyConstraintsKernel',),
@@ -86,6 +95,14 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('Context',  'getIntegrator'),
                 ('Context',  'createCheckpoint'),
                 ('Context',  'loadCheckpoint'),
+                ('Context',  'setTelemetryCallback'),
+                ('Context',  'getTelemetryCallback'),
+                ('Context',  'getPositionArray'),
+                ('Context',  'setPositionArray'),
+                ('Context',  'getVelocityArray'),
+                ('Context',  'setVelocityArray'),
+                ('Context',  'getForceArray'),
+                ('Integrator',  'stepAsync'),
                 ('CudaPlatform',),
                 ('Force',    'Force'),
                 ('ParticleParameterInfo',),
@@ -102,6 +119,8 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('IntegrateDrudeSCFStepKernel',),
                 ('XmlSerializer',  'serialize'),
                 ('XmlSerializer',  'deserialize'),
+                ('SerializationNode',  'getIntArrays'),
+                ('SerializationNode',  'getDoubleArrays'),
                 ('LocalCoordinatesSite',  'getOriginWeights', 0),
                 ('LocalCoordinatesSite',  'getXWeights', 0),
                 ('LocalCoordinatesSite',  'getYWeights', 0),
@@ -112,6 +131,7 @@ SKIP_METHODS = [('State', 'getPositions'),
 # The build script assumes method args that are non-const references are
 # used to output values. This list gives excpetions to this rule.
 NO_OUTPUT_ARGS = [('LocalEnergyMinimizer', 'minimize', 'context'),
+                  ('FIREMinimizer', 'minimize', 'context'),
                   ('Platform', 'setPropertyValue', 'context'),
                   ('AmoebaTorsionTorsionForce', 'setTorsionTorsionGrid', 'grid'),
                   ('AmoebaVdwForce', 'setParticleExclusions', 'exclusions'),
@@ -238,6 +258,8 @@ UNITS = {
 ("SerializationNode", "getIntProperty") : (None, ()),
 ("SerializationNode", "getLongProperty") : (None, ()),
 ("SerializationNode", "getDoubleProperty") : (None, ()),
+("SerializationNode", "getIntArray") : (None, ()),
+("SerializationNode", "getDoubleArray") : (None, ()),
 ("SerializationProxy", "getProxy") : (None, ()),
 ("SerializationProxy", "getTypeName") : (None, ()),
 
@@ -324,6 +346,8 @@ UNITS = {
 ("Context", "getParameter") : (None, ()),
 ("Context", "getParameters") : (None, ()),
 ("Context", "getMolecules") : (None, ()),
+("Context", "getNeighborListStatistics") : (None, ()),
+("Context", "getProfile") : (None, ()),
 ("Context", "getState") : (None, (None, None, None)),
 ("Context", "setPeriodicBoxVectors") : (None, ("unit.nanometer", "unit.nanometer", "unit.nanometer")),
 ("Context", "setPositions") : (None, ("unit.nanometer",)),
@@ -437,6 +461,8 @@ UNITS = {
 ("GayBerneForce", "getParticleParameters") : (None, ("unit.nanometer", "unit.kilojoule_per_mole", None, None, "unit.nanometer", "unit.nanometer", "unit.nanometer", None, None, None)),
 ("GayBerneForce", "setParticleParameters") : (None, (None, "unit.nanometer", "unit.kilojoule_per_mole", None, None, "unit.nanometer", "unit.nanometer", "unit.nanometer", None, None, None)),
 ("Platform", "getDefaultPluginsDirectory") : (None, ()),
+("Platform", "estimateMemoryUsage") : (None, ()),
+("Platform", "getMemoryUsage") : (None, ()),
 ("Platform", "getPropertyDefaultValue") : (None, ()),
 ("Platform", "getPropertyNames") : (None, ()),
 ("Platform", "getPropertyValue") : (None, ()),
@@ -453,6 +479,7 @@ UNITS = {
 ("State", "getParameters") : (None, ()),
 ("State", "getEnergyParameterDerivatives") : (None, ()),
 ("System", "addParticle") : (None, ("unit.amu",)),
+("System", "repartitionHydrogenMass") : (None, ("unit.amu", None)),
 ("System", "addConstraint") : (None, (None, None, "unit.nanometer")),
 ("System", "getConstraintParameters") : (None, (None, None, "unit.nanometer")),
 ("System", "setConstraintParameters") : (None, (None, None, None, "unit.nanometer")),
@@ -468,6 +495,7 @@ UNITS = {
 ("BrownianIntegrator", "BrownianIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond")),
 ("LangevinIntegrator", "LangevinIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond")),
 ("LangevinMiddleIntegrator", "LangevinMiddleIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond")),
+("MTSLangevinIntegrator", "MTSLangevinIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond", None)),
 ("VariableLangevinIntegrator", "VariableLangevinIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", None)),
 ("VerletIntegrator", "VerletIntegrator") : (None, ("unit.picosecond",)),
 ("DrudeIntegrator", "getDrudeTemperature") : ("unit.kelvin", ()),
@@ -507,4 +535,5 @@ UNITS = {
 ("DrudeNoseHooverIntegrator", "getMaxDrudeDistance") : ("unit.nanometer", ()),
 ("DrudeNoseHooverIntegrator", "setMaxDrudeDistance") : (None, ("unit.nanometer",)),
 ("LocalEnergyMinimizer", "minimize") : (None, (None, "unit.kilojoules_per_mole/unit.nanometer", None)),
+("FIREMinimizer", "minimize") : (None, (None, "unit.kilojoules_per_mole/unit.nanometer", None, "unit.nanometer")),
 }
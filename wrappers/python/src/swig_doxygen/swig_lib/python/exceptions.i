@@ -52,6 +52,20 @@
     PyEval_RestoreThread(_savePythonThreadState);
 }
 
+%exception OpenMM::FIREMinimizer::minimize {
+    PyThreadState* _savePythonThreadState = PyEval_SaveThread();
+    try {
+        $action
+    } catch (std::exception &e) {
+        PyEval_RestoreThread(_savePythonThreadState);
+        PyObject* mm = PyImport_AddModule("openmm");
+        PyObject* openmm_exception = PyObject_GetAttrString(mm, "OpenMMException");
+        PyErr_SetString(openmm_exception, const_cast<char*>(e.what()));
+        return NULL;
+    }
+    PyEval_RestoreThread(_savePythonThreadState);
+}
+
 %exception OpenMM::Context::setVelocitiesToTemperature {
     PyThreadState* _savePythonThreadState = PyEval_SaveThread();
     try {
@@ -12,7 +12,7 @@
     def getState(self, getPositions=False, getVelocities=False,
                  getForces=False, getEnergy=False, getParameters=False,
                  getParameterDerivatives=False, getIntegratorParameters=False,
-                 enforcePeriodicBox=False, groups=-1):
+                 enforcePeriodicBox=False, groups=-1, particles=None):
         """Get a State object recording the current state information stored in this context.
 
         Parameters
@@ -41,6 +41,11 @@
             forces and energies. The default value includes all groups. groups
             can also be passed as an unsigned integer interpreted as a bitmask,
             in which case group i will be included if (groups&(1<<i)) != 0.
+        particles : list=None
+            if specified, positions, velocities, and forces are only stored
+            for these particles, in the order they are listed.  This is much
+            faster than retrieving all particles when only a small subset is
+            needed.
         """
         try:
             # is the input integer-like?
@@ -69,7 +74,10 @@
             types += State.ParameterDerivatives
         if getIntegratorParameters:
             types += State.IntegratorParameters
-        state = _openmm.Context_getState(self, types, enforcePeriodicBox, groups_mask)
+        if particles is None:
+            state = _openmm.Context_getState(self, types, enforcePeriodicBox, groups_mask)
+        else:
+            state = _openmm.Context_getState(self, types, [int(i) for i in particles], enforcePeriodicBox, groups_mask)
         return state
 
   %}
@@ -8,7 +8,7 @@ from openmm import app
 from random import random
 import openmm as mm
 import numpy as np
-from openmm.app.internal.xtc_utils import read_xtc
+from openmm.app.internal.xtc_utils import read_xtc, read_xtc_frames, xtc_write_index, get_xtc_nframes
 
 class TestXtcFile(unittest.TestCase):
     def test_xtc_triclinic(self):
@@ -194,6 +194,33 @@ class TestXtcFile(unittest.TestCase):
             del simulation
             del xtc
 
+    def testRandomAccess(self):
+        """Test reading selected frames, with and without a sidecar index."""
+        with tempfile.TemporaryDirectory() as temp:
+            fname = os.path.join(temp, 'traj.xtc')
+            pdbfile = app.PDBFile("systems/alanine-dipeptide-implicit.pdb")
+            natom = len(list(pdbfile.topology.atoms()))
+            xtc = app.XTCFile(fname, pdbfile.topology, 0.001)
+            for i in range(10):
+                xtc.writeModel([mm.Vec3(random(), random(), random()) for j in range(natom)] * unit.nanometers)
+            coords, box, time, step = read_xtc(fname.encode("utf-8"))
+            frames = [7, 2, 9]
+            for useIndex in (False, True):
+                if useIndex:
+                    xtc_write_index(fname.encode("utf-8"))
+                    self.assertTrue(os.path.isfile(fname+".idx"))
+                coords2, box2, time2, step2 = read_xtc_frames(fname.encode("utf-8"), frames)
+                self.assertTrue(np.array_equal(coords[:, :, frames], coords2))
+                self.assertTrue(np.array_equal(step[frames], step2))
+                self.assertTrue(np.array_equal(time[frames], time2))
+
+            # Appending frames should update the index.
+
+            xtc.writeModel([mm.Vec3(random(), random(), random()) for j in range(natom)] * unit.nanometers)
+            self.assertEqual(11, get_xtc_nframes(fname.encode("utf-8")))
+            coords, box, time, step = read_xtc_frames(fname.encode("utf-8"), [10])
+            self.assertEqual(11, step[0])
+
 
 if __name__ == "__main__":
     unittest.main()